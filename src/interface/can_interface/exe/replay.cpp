@@ -0,0 +1,32 @@
+/*
+ * Package:   can_interface
+ * Filename:  replay.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// Play a log recorded by can_interface's log_path parameter back onto a
+// bus, usually a vcan one, with its original timing or faster
+
+#include <iostream>
+#include <string>
+
+#include "can_interface/CanBus.hpp"
+#include "can_interface/CanLog.hpp"
+
+int main(int argc, char ** argv) {
+  if(argc < 3) {
+    std::cout << "USAGE: ros2 run can_interface replay <log> <interface> [speed]" << std::endl
+	      << "  speed 1 (the default) is real time, 0 is as fast as the bus allows" << std::endl;
+    return 1;
+  }
+  double speed = argc > 3 ? std::stod(argv[3]) : 1.0;
+
+  navigator::can_interface::CanLogReader log(argv[1]);
+  navigator::can_interface::CanBus bus(argv[2]);
+  std::size_t sent = navigator::can_interface::replay_log(log, bus, speed, 0, log.size());
+  std::cout << "Replayed " << sent << " frames" << std::endl;
+  return 0;
+}
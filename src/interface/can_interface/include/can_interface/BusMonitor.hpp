@@ -0,0 +1,132 @@
+/*
+ * Package:   can_interface
+ * Filename:  BusMonitor.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// How busy a bus is and how regularly each identifier on it arrives,
+// from the frames and kernel timestamps of the batch receive path.
+// Frames are recorded as they are read and summarized once a period,
+// each summary covering the frames since the last. Recording and
+// summarizing can go on from different threads.
+
+#pragma once
+
+#include <array> // Error counters
+#include <chrono> // Stamps and periods
+#include <cstddef>
+#include <cstdint>
+#include <linux/can.h> // struct can_frame, struct canfd_frame
+#include <map> // Identifiers, kept in order
+#include <mutex> // Between the receive thread and the executor
+#include <vector>
+
+#include "CanBus.hpp" // ReceiveTimestamp
+#include "CanFrame.hpp" // identifier_t
+#include "nova_trace/LatencyHistogram.hpp" // Jitter
+
+namespace navigator {
+  namespace can_interface {
+    // One bit of an error frame's identifier each, in order from
+    // CAN_ERR_TX_TIMEOUT to CAN_ERR_RESTARTED
+    constexpr std::size_t ERROR_CLASSES = 9;
+    extern const std::array<const char *, ERROR_CLASSES> ERROR_CLASS_NAMES;
+
+    struct IdentifierSummary {
+      CanFrame::identifier_t identifier; // As in CanFrame, extended above 0x7FF
+      uint64_t frames;
+      double rate_hz;
+      std::chrono::nanoseconds expected_period; // Zero if none was given
+      // How far intervals between frames were from the expected period,
+      // or from the mean interval so far without one, in microseconds,
+      // the quantiles as the top of their LatencyHistogram bucket
+      uint64_t jitter_p50_us;
+      uint64_t jitter_p99_us;
+      uint64_t jitter_max_us;
+      uint64_t late; // Intervals over the tolerance, with an expected period
+      // With an expected period, nothing for longer than the tolerance
+      // when the summary was made
+      bool missing;
+    };
+
+    struct BusSummary {
+      double seconds; // Since the last summary
+      uint64_t frames; // Received, error frames aside
+      uint64_t sent_frames;
+      // Of the time the frames, sent and received, took on the bus.
+      // Stuff bits aren't counted, so this is low by up to a fifth.
+      double load_percent;
+      uint64_t error_frames;
+      std::array<uint64_t, ERROR_CLASSES> errors; // Frames with each class bit
+      // In order, those received since the last summary and those expected
+      std::vector<IdentifierSummary> identifiers;
+    };
+
+    class BusMonitor final {
+    public:
+      // Bit rates in bits per second, the data rate for FD frames that
+      // switch to it. An interval over period_tolerance times an
+      // identifier's expected period is late.
+      BusMonitor(uint32_t bit_rate, uint32_t data_bit_rate, double period_tolerance,
+		 std::chrono::system_clock::time_point start = std::chrono::system_clock::now());
+
+      void expect_period(CanFrame::identifier_t identifier, std::chrono::nanoseconds period);
+
+      // Frames as the bus read them. Error frames, with CAN_ERR_FLAG in
+      // their identifiers, only count toward the error classes.
+      void record(const struct can_frame * frames, const ReceiveTimestamp * stamps,
+		  std::size_t count);
+      // A frame from an FD read, classic unless CANFD_FDF is in its flags
+      void record(const struct canfd_frame & frame, const ReceiveTimestamp & stamp);
+      // Frames written to the bus, which a socket isn't given back, so
+      // they only count toward the load
+      void record_sent(const struct can_frame * frames, std::size_t count);
+      void record_sent(const struct canfd_frame & frame);
+
+      // Everything since the last summary up to now, on the kernel's clock
+      BusSummary summarize(std::chrono::system_clock::time_point now);
+
+      // How long a frame takes to send, stuff bits aside
+      std::chrono::nanoseconds bus_time(const struct can_frame & frame) const;
+      std::chrono::nanoseconds bus_time(const struct canfd_frame & frame) const;
+
+    private:
+      struct Identifier {
+	std::chrono::nanoseconds expected_period {0};
+
+	// Since the last summary
+	uint64_t frames = 0;
+	uint64_t late = 0;
+	trace::LatencyHistogram jitter;
+
+	// Since the start
+	bool seen = false;
+	bool hardware_stamped = false; // Whether last_stamp is the adapter's
+	std::chrono::nanoseconds last_stamp {0};
+	std::chrono::system_clock::time_point last_kernel_stamp;
+	std::chrono::nanoseconds interval_total {0};
+	int64_t intervals = 0;
+      };
+
+      void record_frame(CanFrame::identifier_t identifier, const ReceiveTimestamp & stamp);
+      void record_error(canid_t can_id);
+
+      uint32_t bit_rate;
+      uint32_t data_bit_rate;
+      double period_tolerance;
+
+      std::mutex mutex; // Everything below
+      std::chrono::system_clock::time_point start;
+      std::chrono::system_clock::time_point window_start;
+      std::map<CanFrame::identifier_t, Identifier> identifiers;
+      uint64_t frames = 0;
+      uint64_t sent_frames = 0;
+      std::chrono::nanoseconds busy {0};
+      uint64_t error_frames = 0;
+      std::array<uint64_t, ERROR_CLASSES> errors {};
+    };
+  }
+}
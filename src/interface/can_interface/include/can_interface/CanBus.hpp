@@ -11,13 +11,27 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <sys/socket.h> // struct mmsghdr
+#include <time.h> // struct timespec
+#include <vector>
 
+#include "CanFdFrame.hpp" // The same for CAN FD
 #include "CanFrame.hpp" // Our object-oriented CAN frame representation
 
 namespace navigator {
   namespace can_interface {
+    // When a frame was received, by the kernel and, if it stamps frames,
+    // the adapter
+    struct ReceiveTimestamp {
+      std::chrono::system_clock::time_point kernel;
+      std::chrono::nanoseconds hardware {0}; // On the adapter's clock, zero if it has none
+    };
+
     class CanBus final {
     public:
       CanBus(); // Initialize without opening
@@ -27,13 +41,67 @@ namespace navigator {
       // Methods required to implement CanBus
       bool is_frame_ready(); // Whether a frame is ready
       std::unique_ptr<CanFrame> read_frame(); // Read a frame from the bus
+      // Block until a frame is ready or the timeout passes
+      bool wait_for_frame(std::chrono::milliseconds timeout);
+      // Read up to max_frames frames that are ready into frames, and their
+      // timestamps into stamps unless it is null, without blocking or
+      // allocating. Returns how many were read. Batches are capped at
+      // BATCH_CAPACITY frames.
+      std::size_t read_frames(struct can_frame * frames, ReceiveTimestamp * stamps,
+			      std::size_t max_frames);
+      // The same for a bus with FD frames enabled. Classic frames come
+      // back in the same array, told apart by CANFD_FDF in their flags
+      // being clear.
+      std::size_t read_fd_frames(struct canfd_frame * frames, ReceiveTimestamp * stamps,
+				 std::size_t max_frames);
       void write_frame(const CanFrame & frame); // Write a frame to the bus
+      void write_fd_frame(const CanFdFrame & frame); // Needs FD frames enabled
+      // Write count frames in one call, up to BATCH_CAPACITY at a time.
+      // Returns how many the kernel took, which is fewer, possibly none,
+      // when its transmit queue is full.
+      std::size_t write_frames(const struct can_frame * frames, std::size_t count);
+      // The same for FD frames. Frames without CANFD_FDF set go out as
+      // classic frames.
+      std::size_t write_fd_frames(const struct canfd_frame * frames, std::size_t count);
+      // Receive and send CAN FD frames as well as classic ones. Throws if
+      // the interface can't.
+      void enable_fd_frames();
+      // Have the kernel drop every frame that matches none of the
+      // filters, so it is never woken for or copied. An empty list
+      // receives nothing.
+      void set_filters(const std::vector<struct can_filter> & filters);
+      void clear_filters(); // Receive every frame again
+      // Receive the error frames of the classes in mask, CAN_ERR_MASK for
+      // all of them, alongside the rest. They have CAN_ERR_FLAG set in
+      // their identifiers. Filters don't apply to them.
+      void set_error_mask(can_err_mask_t mask);
+      // The fewest filters matching exactly the identifiers first to last.
+      // As in CanFrame, identifiers above 0x7FF are extended.
+      static std::vector<struct can_filter> range_filters(CanFrame::identifier_t first,
+							  CanFrame::identifier_t last);
       void open(const std::string & interface_name); // Open an interface
       void close(); // Close the open interface
       bool is_open(); // Whether or not the bus is open
+      // The bus's socket, for waiting on several buses at once, e.g. with
+      // epoll. Reads and writes should still go through the bus.
+      int get_file_descriptor() const;
+
+      static constexpr std::size_t BATCH_CAPACITY = 64;
     private:
+      std::size_t receive_batch(char * frames, std::size_t frame_size, ReceiveTimestamp * stamps,
+				std::size_t max_frames);
+      std::size_t send_batch(const char * frames, std::size_t frame_size, std::size_t count);
+
       int raw_socket;
       std::string interface_name;
+
+      // Room for SO_TIMESTAMPING's three timestamps on each frame
+      static constexpr std::size_t CONTROL_SIZE = CMSG_SPACE(3 * sizeof(struct timespec));
+
+      // Scratch for recvmmsg() and sendmmsg(), kept so batches don't allocate
+      std::array<struct mmsghdr, BATCH_CAPACITY> batch_headers;
+      std::array<struct iovec, BATCH_CAPACITY> batch_buffers;
+      std::array<std::array<char, CONTROL_SIZE>, BATCH_CAPACITY> batch_control;
     };
   }
 }
@@ -0,0 +1,57 @@
+/*
+ * Package:   can_interface
+ * Filename:  CanFdFrame.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// A CAN FD frame, with up to 64 bytes of payload, in the spirit of
+// CanFrame. The payload is stored inline, so frames never allocate.
+
+#pragma once
+
+#include <array> // Payload
+#include <cstddef> // std::size_t
+#include <cstdint> // Fixed-width integers
+#include <linux/can.h> // struct canfd_frame
+
+#include "CanFrame.hpp" // identifier_t
+
+namespace navigator {
+  namespace can_interface {
+    class CanFdFrame final {
+    public:
+      static constexpr std::size_t MAX_LENGTH = CANFD_MAX_DLEN;
+      typedef CanFrame::identifier_t identifier_t;
+      typedef std::array<uint8_t, MAX_LENGTH> data_t;
+
+      // The first length bytes of data are the payload. CAN FD only
+      // carries some lengths above 8, so the payload is padded with
+      // zeros up to the next one when it goes on the bus.
+      CanFdFrame(identifier_t identifier, const uint8_t * data, uint8_t length,
+		 bool bit_rate_switch = true);
+
+      // Construct from a system-provided frame
+      CanFdFrame(const struct canfd_frame & frame_struct);
+
+      identifier_t get_identifier() const;
+      const data_t & get_data() const;
+      uint8_t get_length() const;
+      bool get_bit_rate_switch() const; // Whether the payload is sent at the faster rate
+
+      // Fill in the struct provided by the system
+      void to_system_frame(struct canfd_frame & system_frame) const;
+
+      // The smallest length CAN FD can carry that fits length bytes
+      static uint8_t padded_length(uint8_t length);
+
+    private:
+      identifier_t identifier;
+      uint8_t length;
+      bool bit_rate_switch;
+      data_t data;
+    };
+  }
+}
@@ -38,6 +38,9 @@ namespace navigator {
       // Convert this to the struct provided by the system
       std::unique_ptr<can_frame> to_system_frame() const;
 
+      // The same, filled in place rather than on the heap
+      void to_system_frame(struct can_frame & system_frame) const;
+
     private:
       identifier_t identifier;
       data_t data;
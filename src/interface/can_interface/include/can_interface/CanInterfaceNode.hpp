@@ -9,31 +9,124 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "rclcpp/rclcpp.hpp"
 
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "nova_msgs/msg/can_fd_frame.hpp"
 #include "nova_msgs/msg/can_frame.hpp"
+#include "nova_trace/LatencyHistogram.hpp"
+#include "BusMonitor.hpp"
 #include "CanBus.hpp"
+#include "CanLog.hpp"
 
 namespace navigator {
 namespace can_interface {
 
 class CanInterfaceNode : public rclcpp::Node {
 public:
-  CanInterfaceNode(const std::string & interface_name);
+  CanInterfaceNode(const std::string & interface_name,
+		   const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+  // For component containers, with the interfaces from the
+  // interface_names parameter, or the one from interface_name
+  explicit CanInterfaceNode(const rclcpp::NodeOptions & options);
   virtual ~CanInterfaceNode();
 
 private:
-  void send_frame(const nova_msgs::msg::CanFrame::SharedPtr msg);
+  // Frames with identifiers from first to last
+  struct IdRange {
+    CanFrame::identifier_t first;
+    CanFrame::identifier_t last;
+    bool contains(CanFrame::identifier_t identifier) const {
+      return identifier >= first && identifier <= last;
+    }
+  };
+
+  // One interface and everything that reads from or writes to it
+  struct Bus {
+    std::string name;
+    std::unique_ptr<CanBus> can_bus;
+
+    // Batch buffers, used by whichever of the thread or timer is receiving
+    std::array<struct can_frame, CanBus::BATCH_CAPACITY> received_frames;
+    std::array<ReceiveTimestamp, CanBus::BATCH_CAPACITY> received_stamps;
+    std::array<struct canfd_frame, CanBus::BATCH_CAPACITY> received_fd_frames; // With fd_frames
+    bool fd_frames = false;
+
+    // Every frame received, if the log_path parameter is set
+    std::unique_ptr<CanLogWriter> log;
+
+    // Load, timing and errors, unless monitor_period is 0
+    std::unique_ptr<BusMonitor> monitor;
+    double max_load_percent = 0; // 0 for no limit
+
+    rclcpp::Publisher<nova_msgs::msg::CanFrame>::SharedPtr incoming_message_publisher;
+
+    // Frames in a range, for consumers that only want those
+    struct FilteredTopic {
+      IdRange ids;
+      rclcpp::Publisher<nova_msgs::msg::CanFrame>::SharedPtr publisher;
+    };
+    std::vector<FilteredTopic> filtered_topics;
+    rclcpp::Subscription<nova_msgs::msg::CanFrame>::SharedPtr outgoing_message_subscription;
+
+    // Only with the fd_frames parameter set
+    rclcpp::Publisher<nova_msgs::msg::CanFdFrame>::SharedPtr incoming_fd_message_publisher;
+    rclcpp::Subscription<nova_msgs::msg::CanFdFrame>::SharedPtr outgoing_fd_message_subscription;
+
+    // Classic frames in bridged_ids are written straight to each of the
+    // bridge_to buses, from the receive path and without going through
+    // ROS. bridged_frames collects each batch's.
+    std::vector<IdRange> bridged_ids;
+    std::vector<Bus *> bridge_to;
+    std::array<struct can_frame, CanBus::BATCH_CAPACITY> bridged_frames;
+  };
+
+  // Sets up a bus and its topics. With several buses, the topics are in a
+  // namespace named after the interface and its parameters are under its
+  // name, e.g. can1.filtered_ids.
+  void add_bus(const std::string & interface_name, bool multiple_buses);
+  void add_bridges(Bus & bus, bool multiple_buses);
+
+  void send_frame(Bus & bus, const nova_msgs::msg::CanFrame::SharedPtr msg);
+  void send_fd_frame(Bus & bus, const nova_msgs::msg::CanFdFrame::SharedPtr msg);
   void check_incoming_messages();
-  void receive_frame();
+  void receive_loop();
+  // Reads every bus that has frames waiting, after up to timeout for one
+  // to. Returns whether any did.
+  bool receive_ready(std::chrono::milliseconds timeout);
+  void receive_frames(Bus & bus);
+  void bridge_frames(Bus & bus, std::size_t n_frames);
+  void report_latency();
+  void report_bus_monitors();
+
+
+  std::vector<std::unique_ptr<Bus>> buses;
+  // Every bus's socket, so one thread or timer waits on all of them
+  int epoll_socket = -1;
+  rclcpp::TimerBase::SharedPtr incoming_message_timer; // Only in timer mode
+
+  // In thread mode, blocks on the sockets and publishes frames as they arrive
+  std::thread receive_thread;
+  std::atomic<bool> receiving {false};
 
+  // Bus-to-publish latency of every frame, logged periodically
+  trace::LatencyHistogram latency;
+  std::string receive_mode;
+  rclcpp::TimerBase::SharedPtr latency_report_timer;
 
-  std::unique_ptr<navigator::can_interface::CanBus> can_bus;
-  rclcpp::TimerBase::SharedPtr incoming_message_timer;
-  rclcpp::Publisher<nova_msgs::msg::CanFrame>::SharedPtr incoming_message_publisher;
-  rclcpp::Subscription<nova_msgs::msg::CanFrame>::SharedPtr outgoing_message_subscription;
+  // Each bus's BusMonitor summary, on /diagnostics every monitor_period
+  double monitor_period;
+  double monitor_period_tolerance;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_publisher;
+  rclcpp::TimerBase::SharedPtr monitor_timer;
 };
 
 }
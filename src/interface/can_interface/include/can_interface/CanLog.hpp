@@ -0,0 +1,97 @@
+/*
+ * Package:   can_interface
+ * Filename:  CanLog.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// A binary log of raw CAN frames, written straight from the receive
+// path into a memory-mapped file, and a reader to replay it.
+//
+// The file is a header followed by chunks. Each chunk is an index
+// block (how many frames it holds and the first and last timestamps)
+// followed by up to CHUNK_FRAMES fixed-size frame records, so a reader
+// can skip to a time by hopping from index to index. A log cut off by
+// a crash is readable up to the last frame written.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <linux/can.h> // struct can_frame
+#include <string>
+#include <vector>
+
+#include "CanBus.hpp" // ReceiveTimestamp
+
+namespace navigator {
+  namespace can_interface {
+    struct CanLogRecord {
+      int64_t timestamp_ns; // Kernel receive time, nanoseconds since the epoch
+      int64_t hardware_ns; // Adapter's timestamp, zero if it has none
+      uint32_t can_id; // With the kernel's flags, as in struct can_frame
+      uint8_t can_dlc;
+      uint8_t reserved[3];
+      uint8_t data[8];
+
+      void to_system_frame(struct can_frame & frame) const;
+    };
+    static_assert(sizeof(CanLogRecord) == 32, "CanLogRecord is written to disk as is");
+
+    class CanLogWriter final {
+    public:
+      static constexpr uint32_t CHUNK_FRAMES = 4096;
+
+      CanLogWriter(const std::string & path); // Creates or truncates
+      ~CanLogWriter(); // Closes
+
+      // Append frames, stamped as they were received. A null stamps
+      // stamps them all now.
+      void append(const struct can_frame * frames, const ReceiveTimestamp * stamps,
+		  std::size_t count);
+      uint64_t frame_count() const;
+      void close(); // Trim the file to what was written and unmap it
+
+    private:
+      void start_chunk(int64_t timestamp_ns);
+      void reserve(std::size_t bytes);
+
+      int file;
+      std::string path;
+      char * map = nullptr;
+      std::size_t mapped = 0; // Bytes of the file mapped
+      std::size_t used = 0; // Bytes written
+      std::size_t chunk = 0; // Offset of the current chunk's index block
+      uint64_t frames = 0;
+    };
+
+    class CanLogReader final {
+    public:
+      CanLogReader(const std::string & path);
+      ~CanLogReader();
+      CanLogReader(const CanLogReader &) = delete;
+      CanLogReader & operator=(const CanLogReader &) = delete;
+
+      std::size_t size() const; // Frames in the log
+      const CanLogRecord & operator[](std::size_t index) const;
+      // The first frame received at or after timestamp_ns, or size()
+      std::size_t seek(int64_t timestamp_ns) const;
+
+    private:
+      const char * map = nullptr;
+      std::size_t mapped = 0;
+      std::vector<std::size_t> chunks; // Offset of each chunk's first record
+      std::size_t frames = 0;
+    };
+
+    // Write frames first to last - 1 of a log to the bus. With speed 1
+    // they go out with the gaps they arrived with, with speed 2 twice
+    // as fast and so on. Speed 0 sends them as fast as the bus takes
+    // them. Returns how many were sent.
+    std::size_t replay_log(const CanLogReader & log, CanBus & bus, double speed,
+			   std::size_t first, std::size_t last);
+  }
+}
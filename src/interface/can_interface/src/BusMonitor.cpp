@@ -0,0 +1,171 @@
+/*
+ * Package:   can_interface
+ * Filename:  BusMonitor.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm> // std::min
+#include <cstring> // memcpy()
+#include <stdexcept> // Bad bit rates
+
+#include "can_interface/BusMonitor.hpp"
+
+using namespace navigator::can_interface;
+
+const std::array<const char *, ERROR_CLASSES> navigator::can_interface::ERROR_CLASS_NAMES = {
+  "tx_timeout", "lost_arbitration", "controller", "protocol", "transceiver",
+  "no_ack", "bus_off", "bus_error", "restarted"
+};
+
+namespace {
+  std::chrono::nanoseconds bit_time(uint64_t bits, uint32_t bit_rate) {
+    return std::chrono::nanoseconds((bits * 1000000000 + bit_rate / 2) / bit_rate);
+  }
+}
+
+BusMonitor::BusMonitor(uint32_t bit_rate, uint32_t data_bit_rate, double period_tolerance,
+		       std::chrono::system_clock::time_point start)
+  : bit_rate(bit_rate), data_bit_rate(data_bit_rate), period_tolerance(period_tolerance),
+    start(start), window_start(start) {
+  if(bit_rate == 0 || data_bit_rate == 0) {
+    throw std::invalid_argument("Bus bit rates must be positive");
+  }
+}
+
+void BusMonitor::expect_period(CanFrame::identifier_t identifier, std::chrono::nanoseconds period) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->identifiers[identifier].expected_period = period;
+}
+
+void BusMonitor::record(const struct can_frame * frames, const ReceiveTimestamp * stamps,
+			std::size_t count) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  for(std::size_t i = 0; i < count; i++) {
+    if(frames[i].can_id & CAN_ERR_FLAG) {
+      this->record_error(frames[i].can_id);
+      continue;
+    }
+    this->busy += this->bus_time(frames[i]);
+    this->record_frame(frames[i].can_id & CAN_EFF_MASK, stamps[i]);
+  }
+}
+
+void BusMonitor::record(const struct canfd_frame & frame, const ReceiveTimestamp & stamp) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if(frame.can_id & CAN_ERR_FLAG) {
+    this->record_error(frame.can_id);
+    return;
+  }
+  this->busy += this->bus_time(frame);
+  this->record_frame(frame.can_id & CAN_EFF_MASK, stamp);
+}
+
+void BusMonitor::record_sent(const struct can_frame * frames, std::size_t count) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  for(std::size_t i = 0; i < count; i++) {
+    this->busy += this->bus_time(frames[i]);
+  }
+  this->sent_frames += count;
+}
+
+void BusMonitor::record_sent(const struct canfd_frame & frame) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->busy += this->bus_time(frame);
+  this->sent_frames++;
+}
+
+// Intervals are taken on the adapter's clock when it stamps frames, as
+// that leaves out the time the kernel took to get to them
+void BusMonitor::record_frame(CanFrame::identifier_t identifier, const ReceiveTimestamp & stamp) {
+  this->frames++;
+  Identifier & id = this->identifiers[identifier];
+  id.frames++;
+
+  bool hardware_stamped = stamp.hardware.count() != 0;
+  std::chrono::nanoseconds time = hardware_stamped ? stamp.hardware : stamp.kernel.time_since_epoch();
+  if(id.seen && hardware_stamped == id.hardware_stamped) {
+    std::chrono::nanoseconds interval = time - id.last_stamp;
+    id.interval_total += interval;
+    id.intervals++;
+    if(id.expected_period.count() > 0) {
+      id.jitter.record(std::chrono::abs(interval - id.expected_period));
+      if(interval > this->period_tolerance * id.expected_period) id.late++;
+    } else {
+      id.jitter.record(std::chrono::abs(interval - id.interval_total / id.intervals));
+    }
+  }
+  id.seen = true;
+  id.hardware_stamped = hardware_stamped;
+  id.last_stamp = time;
+  id.last_kernel_stamp = stamp.kernel;
+}
+
+void BusMonitor::record_error(canid_t can_id) {
+  this->error_frames++;
+  for(std::size_t b = 0; b < ERROR_CLASSES; b++) {
+    if(can_id & (canid_t(1) << b)) this->errors[b]++;
+  }
+}
+
+BusSummary BusMonitor::summarize(std::chrono::system_clock::time_point now) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  BusSummary summary;
+  summary.seconds = std::chrono::duration<double>(now - this->window_start).count();
+  double seconds = summary.seconds > 0 ? summary.seconds : 0;
+  summary.frames = this->frames;
+  summary.sent_frames = this->sent_frames;
+  summary.load_percent = seconds ? 100 * std::chrono::duration<double>(this->busy).count() / seconds : 0;
+  summary.error_frames = this->error_frames;
+  summary.errors = this->errors;
+
+  for(auto & [identifier, id] : this->identifiers) {
+    bool expected = id.expected_period.count() > 0;
+    if(id.frames == 0 && !expected) continue;
+    auto silent = now - (id.seen ? id.last_kernel_stamp : this->start);
+    const trace::LatencyHistogram::Snapshot jitter = id.jitter.snapshot();
+    summary.identifiers.push_back
+      ({ identifier, id.frames, seconds ? id.frames / seconds : 0, id.expected_period,
+	 jitter.quantile_us(0.5), jitter.quantile_us(0.99), jitter.max_ns / 1000, id.late,
+	 expected && silent > this->period_tolerance * id.expected_period });
+    id.frames = 0;
+    id.late = 0;
+    id.jitter.reset();
+  }
+
+  this->window_start = now;
+  this->frames = 0;
+  this->sent_frames = 0;
+  this->busy = std::chrono::nanoseconds(0);
+  this->error_frames = 0;
+  this->errors = {};
+  return summary;
+}
+
+// Start of frame to the end of the interframe space is 47 bits and the
+// data with a standard identifier, and 67 and the data with an extended
+// one. Remote requests carry no data whatever their length.
+std::chrono::nanoseconds BusMonitor::bus_time(const struct can_frame & frame) const {
+  uint64_t bits = (frame.can_id & CAN_EFF_FLAG) ? 67 : 47;
+  if(!(frame.can_id & CAN_RTR_FLAG)) bits += 8 * std::min<uint64_t>(frame.can_dlc, CAN_MAX_DLEN);
+  return bit_time(bits, this->bit_rate);
+}
+
+// FD frames are sent at the nominal rate up to the bit rate switch (17
+// bits, or 36 with an extended identifier) and from the CRC delimiter on
+// (13 bits). Between, the status, length, data, stuff count and CRC go at
+// the data rate if the frame switches to it.
+std::chrono::nanoseconds BusMonitor::bus_time(const struct canfd_frame & frame) const {
+  if(!(frame.flags & CANFD_FDF)) {
+    struct can_frame classic;
+    memcpy(&classic, &frame, sizeof(classic));
+    return this->bus_time(classic);
+  }
+  uint64_t length = std::min<uint64_t>(frame.len, CANFD_MAX_DLEN);
+  uint64_t nominal_bits = ((frame.can_id & CAN_EFF_FLAG) ? 36 : 17) + 13;
+  uint64_t data_bits = 1 + 4 + 8 * length + 4 + (length > 16 ? 21 : 17);
+  return bit_time(nominal_bits, this->bit_rate) +
+    bit_time(data_bits, (frame.flags & CANFD_BRS) ? this->data_bit_rate : this->bit_rate);
+}
@@ -7,19 +7,26 @@
  * License:   MIT License
  */
 
+#include <algorithm> // std::min, std::max
 #include <cstring> // strcpy()
 #include <linux/can.h> // CAN communication
+#include <linux/can/raw.h> // CAN_RAW_FILTER, CAN_RAW_FD_FRAMES, CAN_RAW_ERR_FILTER
+#include <linux/net_tstamp.h> // SO_TIMESTAMPING flags
 #include <net/if.h> // Also for CAN communication
+#include <poll.h> // Blocking until a frame arrives
 #include <string> // Because we are not barbarians
 #include <stdexcept> // Runtime errors
 #include <sys/ioctl.h> // More OS-level CAN bus stuff
 #include <sys/select.h> // Allows checking whether messages are ready
 #include <sys/socket.h> // To open the socket we need
+#include <time.h> // struct timespec, for receive timestamps
 #include <unistd.h> // Socket I/O
+#include <vector> // Filter lists
 
 #include <iostream> // Temporary, used for debugging
 
 #include "can_interface/CanBus.hpp" // Obviously, we need the class header
+#include "can_interface/CanFdFrame.hpp" // Object-oriented, but bigger
 #include "can_interface/CanFrame.hpp" // Object-oriented
 
 using namespace navigator::can_interface;
@@ -75,6 +82,78 @@ void CanBus::open(const std::string & interface_name) {
 			       interface_name + ": errno is " + std::to_string(errno));
     }
   }
+
+  // Have the kernel, and the adapter if it can, stamp each frame as it
+  // arrives, so latency can be measured from then rather than from when
+  // we got round to reading it. Older kernels only have SO_TIMESTAMPNS.
+  int timestamping = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+    SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+  if(setsockopt(this->raw_socket, SOL_SOCKET, SO_TIMESTAMPING, &timestamping,
+		sizeof(timestamping)) != 0) {
+    int enable = 1;
+    setsockopt(this->raw_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+  }
+}
+
+void CanBus::enable_fd_frames() {
+  int enable = 1;
+  if(setsockopt(this->raw_socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) != 0) {
+    throw std::runtime_error("Interface " + this->interface_name +
+			     " does not support CAN FD: errno is " + std::to_string(errno));
+  }
+}
+
+void CanBus::set_filters(const std::vector<struct can_filter> & filters) {
+  if(setsockopt(this->raw_socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
+		filters.size() * sizeof(struct can_filter)) != 0) {
+    throw std::runtime_error("Error while setting filters on interface " +
+			     this->interface_name + ": errno is " + std::to_string(errno));
+  }
+}
+
+void CanBus::clear_filters() {
+  // A zero mask matches everything, which is the socket's default
+  this->set_filters({ { 0, 0 } });
+}
+
+void CanBus::set_error_mask(can_err_mask_t mask) {
+  if(setsockopt(this->raw_socket, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &mask, sizeof(mask)) != 0) {
+    throw std::runtime_error("Error while setting the error mask on interface " +
+			     this->interface_name + ": errno is " + std::to_string(errno));
+  }
+}
+
+// Split first to last into aligned power-of-two blocks, each of which
+// is one identifier and mask. The extended flag is in every mask, so
+// standard and extended frames with the same number don't match each
+// other.
+static void add_range_filters(std::vector<struct can_filter> & filters,
+			      canid_t first, canid_t last, canid_t identifier_mask,
+			      canid_t flags) {
+  while(first <= last) {
+    canid_t size = 1;
+    while((first & (2 * size - 1)) == 0 && 2 * size - 1 <= last - first) {
+      size *= 2;
+    }
+    filters.push_back({ first | flags, (identifier_mask & ~(size - 1)) | CAN_EFF_FLAG });
+    first += size;
+  }
+}
+
+std::vector<struct can_filter> CanBus::range_filters(CanFrame::identifier_t first,
+						     CanFrame::identifier_t last) {
+  std::vector<struct can_filter> filters;
+  last = std::min<CanFrame::identifier_t>(last, CAN_EFF_MASK);
+  if(first > last) return filters;
+  if(first <= CAN_SFF_MASK) {
+    add_range_filters(filters, first, std::min<CanFrame::identifier_t>(last, CAN_SFF_MASK),
+		      CAN_SFF_MASK, 0);
+  }
+  if(last > CAN_SFF_MASK) {
+    add_range_filters(filters, std::max<CanFrame::identifier_t>(first, CAN_SFF_MASK + 1), last,
+		      CAN_EFF_MASK, CAN_EFF_FLAG);
+  }
+  return filters;
 }
 
 void CanBus::close() {
@@ -88,6 +167,10 @@ bool CanBus::is_open() {
   return this->raw_socket > 0;
 }
 
+int CanBus::get_file_descriptor() const {
+  return this->raw_socket;
+}
+
 // If the socket was open, close it
 CanBus::~CanBus() {
   if(this->is_open()) {
@@ -124,7 +207,9 @@ std::unique_ptr<CanFrame> CanBus::read_frame() {
 }
 
 void CanBus::write_frame(const CanFrame & frame) {
-  int n_bytes = write(this->raw_socket, &(*frame.to_system_frame()), sizeof(struct can_frame));
+  struct can_frame system_frame;
+  frame.to_system_frame(system_frame);
+  int n_bytes = write(this->raw_socket, &system_frame, sizeof(struct can_frame));
   if(n_bytes < 1) {
     switch(errno) {
     default:
@@ -134,3 +219,145 @@ void CanBus::write_frame(const CanFrame & frame) {
   }
   return;
 }
+
+bool CanBus::wait_for_frame(std::chrono::milliseconds timeout) {
+  struct pollfd socket_poll { this->raw_socket, POLLIN, 0 };
+  int poll_result = poll(&socket_poll, 1, (int) timeout.count());
+  if(poll_result < 0) {
+    if(errno == EINTR) return false; // Interrupted by a signal, just try again later
+    throw std::runtime_error("Error from poll() on interface " + this->interface_name +
+			     ": errno is " + std::to_string(errno));
+  }
+  return poll_result != 0; // Zero indicates timeout / not ready
+}
+
+namespace {
+  std::chrono::nanoseconds to_duration(const struct timespec & stamp) {
+    return std::chrono::seconds(stamp.tv_sec) + std::chrono::nanoseconds(stamp.tv_nsec);
+  }
+}
+
+std::size_t CanBus::read_frames(struct can_frame * frames, ReceiveTimestamp * stamps,
+				std::size_t max_frames) {
+  return this->receive_batch(reinterpret_cast<char *>(frames), sizeof(struct can_frame),
+			     stamps, max_frames);
+}
+
+std::size_t CanBus::read_fd_frames(struct canfd_frame * frames, ReceiveTimestamp * stamps,
+				   std::size_t max_frames) {
+  std::size_t n_frames = this->receive_batch(reinterpret_cast<char *>(frames),
+					     sizeof(struct canfd_frame), stamps, max_frames);
+  // Classic frames come in the first CAN_MTU bytes of the struct, which
+  // line up with a classic frame's. Only the length read tells them
+  // apart, so record it in the flags.
+  for(std::size_t i = 0; i < n_frames; i++) {
+    if(this->batch_headers[i].msg_len == CANFD_MTU) {
+      frames[i].flags |= CANFD_FDF;
+    } else {
+      frames[i].flags = 0;
+    }
+  }
+  return n_frames;
+}
+
+// One recvmmsg() call takes every frame that's waiting, up to max_frames,
+// straight into the caller's array along with its timestamps
+std::size_t CanBus::receive_batch(char * frames, std::size_t frame_size,
+				  ReceiveTimestamp * stamps, std::size_t max_frames) {
+  max_frames = std::min(max_frames, BATCH_CAPACITY);
+  for(std::size_t i = 0; i < max_frames; i++) {
+    this->batch_buffers[i] = { frames + i * frame_size, frame_size };
+    this->batch_headers[i] = {};
+    this->batch_headers[i].msg_hdr.msg_iov = &this->batch_buffers[i];
+    this->batch_headers[i].msg_hdr.msg_iovlen = 1;
+    this->batch_headers[i].msg_hdr.msg_control = this->batch_control[i].data();
+    this->batch_headers[i].msg_hdr.msg_controllen = CONTROL_SIZE;
+  }
+
+  int n_frames = recvmmsg(this->raw_socket, this->batch_headers.data(), max_frames,
+			  MSG_DONTWAIT, NULL);
+  if(n_frames < 0) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK) return 0; // Nothing was ready
+    throw std::runtime_error("Error while reading CAN frames on interface " +
+			     this->interface_name + ": errno is " + std::to_string(errno));
+  }
+
+  for(int i = 0; i < n_frames; i++) {
+    struct msghdr & header = this->batch_headers[i].msg_hdr;
+    if(this->batch_headers[i].msg_len < CAN_MTU) {
+      throw std::runtime_error("Read a partial CAN frame on interface " + this->interface_name);
+    }
+    if(stamps == NULL) continue;
+
+    // Frames the kernel didn't stamp count as received now
+    stamps[i] = { std::chrono::system_clock::now(), std::chrono::nanoseconds(0) };
+    for(struct cmsghdr * message = CMSG_FIRSTHDR(&header); message != NULL;
+	message = CMSG_NXTHDR(&header, message)) {
+      if(message->cmsg_level != SOL_SOCKET) continue;
+      struct timespec stamp[3]; // Software, deprecated, raw hardware
+      if(message->cmsg_type == SCM_TIMESTAMPING) {
+	memcpy(stamp, CMSG_DATA(message), sizeof(stamp));
+	if(stamp[0].tv_sec != 0 || stamp[0].tv_nsec != 0) {
+	  stamps[i].kernel = std::chrono::system_clock::time_point
+	    (std::chrono::duration_cast<std::chrono::system_clock::duration>(to_duration(stamp[0])));
+	}
+	stamps[i].hardware = to_duration(stamp[2]);
+      } else if(message->cmsg_type == SCM_TIMESTAMPNS) {
+	memcpy(stamp, CMSG_DATA(message), sizeof(stamp[0]));
+	stamps[i].kernel = std::chrono::system_clock::time_point
+	  (std::chrono::duration_cast<std::chrono::system_clock::duration>(to_duration(stamp[0])));
+      }
+    }
+  }
+  return n_frames;
+}
+
+std::size_t CanBus::write_frames(const struct can_frame * frames, std::size_t count) {
+  return this->send_batch(reinterpret_cast<const char *>(frames), sizeof(struct can_frame),
+			  count);
+}
+
+std::size_t CanBus::write_fd_frames(const struct canfd_frame * frames, std::size_t count) {
+  return this->send_batch(reinterpret_cast<const char *>(frames), sizeof(struct canfd_frame),
+			  count);
+}
+
+void CanBus::write_fd_frame(const CanFdFrame & frame) {
+  struct canfd_frame system_frame;
+  frame.to_system_frame(system_frame);
+  if(write(this->raw_socket, &system_frame, CANFD_MTU) != (ssize_t) CANFD_MTU) {
+    throw std::runtime_error("Failed to deliver CAN FD frame on interface " +
+			     this->interface_name + ": errno is " + std::to_string(errno));
+  }
+}
+
+std::size_t CanBus::send_batch(const char * frames, std::size_t frame_size, std::size_t count) {
+  std::size_t written = 0;
+  while(written < count) {
+    std::size_t batch = std::min(count - written, BATCH_CAPACITY);
+    for(std::size_t i = 0; i < batch; i++) {
+      const char * frame = frames + (written + i) * frame_size;
+      // FD frames only go out as FD if they are marked as such
+      std::size_t length = frame_size;
+      if(frame_size == CANFD_MTU &&
+	 !(reinterpret_cast<const struct canfd_frame *>(frame)->flags & CANFD_FDF)) {
+	length = CAN_MTU;
+      }
+      // sendmmsg() doesn't write through the buffers, whatever their type says
+      this->batch_buffers[i] = { const_cast<char *>(frame), length };
+      this->batch_headers[i] = {};
+      this->batch_headers[i].msg_hdr.msg_iov = &this->batch_buffers[i];
+      this->batch_headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int n_sent = sendmmsg(this->raw_socket, this->batch_headers.data(), batch, 0);
+    if(n_sent < 0) {
+      if(errno == EAGAIN || errno == ENOBUFS) break; // The rest didn't fit
+      throw std::runtime_error("Failed to deliver CAN frames on interface " +
+			       this->interface_name + ": errno is " + std::to_string(errno));
+    }
+    written += n_sent;
+    if((std::size_t) n_sent < batch) break; // The kernel's queue is full
+  }
+  return written;
+}
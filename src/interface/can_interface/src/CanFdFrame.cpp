@@ -0,0 +1,69 @@
+/*
+ * Package:   can_interface
+ * Filename:  CanFdFrame.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// Class to represent a CAN FD frame
+
+#include <algorithm> // std::copy, std::min
+#include <linux/can.h>
+
+#include "can_interface/CanFdFrame.hpp"
+
+using namespace navigator::can_interface;
+
+CanFdFrame::CanFdFrame(identifier_t identifier, const uint8_t * data, uint8_t length,
+		       bool bit_rate_switch) {
+  this->identifier = identifier;
+  this->length = std::min<uint8_t>(length, MAX_LENGTH);
+  this->bit_rate_switch = bit_rate_switch;
+  this->data = {};
+  std::copy(data, data + this->length, this->data.begin());
+}
+
+CanFdFrame::CanFdFrame(const struct canfd_frame & frame_struct) {
+  this->identifier = (identifier_t) frame_struct.can_id;
+  this->length = std::min<uint8_t>(frame_struct.len, MAX_LENGTH);
+  this->bit_rate_switch = frame_struct.flags & CANFD_BRS;
+  this->data = {};
+  std::copy(frame_struct.data, frame_struct.data + this->length, this->data.begin());
+}
+
+CanFdFrame::identifier_t CanFdFrame::get_identifier() const {
+  return this->identifier;
+}
+
+const CanFdFrame::data_t & CanFdFrame::get_data() const {
+  return this->data;
+}
+
+uint8_t CanFdFrame::get_length() const {
+  return this->length;
+}
+
+bool CanFdFrame::get_bit_rate_switch() const {
+  return this->bit_rate_switch;
+}
+
+void CanFdFrame::to_system_frame(struct canfd_frame & system_frame) const {
+  system_frame = {};
+  system_frame.can_id = this->identifier;
+  if(this->identifier > CAN_SFF_MASK) system_frame.can_id |= CAN_EFF_FLAG;
+  system_frame.len = padded_length(this->length);
+  system_frame.flags = CANFD_FDF;
+  if(this->bit_rate_switch) system_frame.flags |= CANFD_BRS;
+  std::copy(this->data.begin(), this->data.begin() + this->length, system_frame.data);
+}
+
+uint8_t CanFdFrame::padded_length(uint8_t length) {
+  static constexpr uint8_t lengths[] = { 8, 12, 16, 20, 24, 32, 48, 64 };
+  if(length <= 8) return length;
+  for(uint8_t padded : lengths) {
+    if(length <= padded) return padded;
+  }
+  return MAX_LENGTH;
+}
@@ -37,9 +37,14 @@ CanFrame::data_t CanFrame::get_data() const {
 
 std::unique_ptr<struct can_frame> CanFrame::to_system_frame() const {
   auto system_frame = std::make_unique<struct can_frame>();
-  system_frame->can_id = this->identifier;
-  if(this->identifier > 0x7FF) system_frame->can_id |= CAN_EFF_FLAG;
-  (*(CanFrame::data_t *) system_frame->data) = this->data;
-  system_frame->can_dlc = 8;
+  this->to_system_frame(*system_frame);
   return system_frame;
 }
+
+void CanFrame::to_system_frame(struct can_frame & system_frame) const {
+  system_frame = {};
+  system_frame.can_id = this->identifier;
+  if(this->identifier > 0x7FF) system_frame.can_id |= CAN_EFF_FLAG;
+  (*(CanFrame::data_t *) system_frame.data) = this->data;
+  system_frame.can_dlc = 8;
+}
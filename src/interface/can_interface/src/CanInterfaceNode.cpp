@@ -7,62 +7,543 @@
  * License:   MIT License
  */
 
+#include <algorithm> // std::copy, std::min
 #include <chrono> // Time literals
+#include <cstring> // memcpy()
 #include <functional> // Callbacks
+#include <iomanip> // Diagnostic values
 #include <iostream> // I/O in main()
+#include <linux/can/error.h> // CAN_ERR_MASK
+#include <sstream> // Topic names
+#include <stdexcept> // Parameter errors
 #include <string> // Because we are not barbarians
+#include <sys/epoll.h> // Waiting on every bus at once
+#include <unistd.h> // close()
+#include <vector> // Filter lists
 
 #include "rclcpp/rclcpp.hpp" // ROS node
 
+#include "diagnostic_msgs/msg/diagnostic_array.hpp" // Bus monitor summaries
+#include "diagnostic_msgs/msg/diagnostic_status.hpp"
+#include "diagnostic_msgs/msg/key_value.hpp"
+#include "nova_msgs/msg/can_fd_frame.hpp" // CAN FD frame messages
 #include "nova_msgs/msg/can_frame.hpp" // CAN frame messages
+#include "nova_trace/Trace.hpp" // Spans and counters
+#include "can_interface/BusMonitor.hpp" // Load and timing
 #include "can_interface/CanBus.hpp" // CAN interface
+#include "can_interface/CanLog.hpp" // Raw frame logging
 
 #include "can_interface/CanInterfaceNode.hpp" // Header for this class
 
 using namespace std::chrono_literals;
+using diagnostic_msgs::msg::DiagnosticStatus;
+using diagnostic_msgs::msg::KeyValue;
+using navigator::can_interface::BusMonitor;
+using navigator::can_interface::BusSummary;
+using navigator::can_interface::CanFrame;
 using navigator::can_interface::CanInterfaceNode;
 using std::placeholders::_1;
 
-const auto receive_frequency = 15ms;
+const auto receive_frequency = 15ms; // Polling period in timer mode
+const auto receive_wait = 100ms; // Longest the receive thread blocks before checking for shutdown
+const auto latency_report_period = 10s;
 
-CanInterfaceNode::CanInterfaceNode(const std::string & interface_name)
-  : Node("can_interface") {
+// can_interface_incoming_can_frames_292 for one identifier, or
+// can_interface_incoming_can_frames_200_2ff for a range, in hex
+static std::string filtered_topic_name(CanFrame::identifier_t first,
+				       CanFrame::identifier_t last) {
+  std::ostringstream name;
+  name << "can_interface_incoming_can_frames_" << std::hex << first;
+  if(last != first) name << "_" << last;
+  return name.str();
+}
+
+// The bus's name for a parameter or topic, in a namespace named after the
+// interface when the node has several
+static std::string bus_name(const std::string & interface_name, const std::string & name,
+			    char separator, bool multiple_buses) {
+  return multiple_buses ? interface_name + separator + name : name;
+}
 
-  this->can_bus = std::make_unique<navigator::can_interface::CanBus>(interface_name);
+static KeyValue key_value(const std::string & key, const std::string & value) {
+  KeyValue pair;
+  pair.key = key;
+  pair.value = value;
+  return pair;
+}
+
+static KeyValue key_value(const std::string & key, double value) {
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(1) << value;
+  return key_value(key, text.str());
+}
 
-  // Set up the timer
-  this->incoming_message_timer = this->create_wall_timer
-    (receive_frequency, bind(& CanInterfaceNode::check_incoming_messages, this));
+CanInterfaceNode::CanInterfaceNode(const rclcpp::NodeOptions & options)
+  : CanInterfaceNode("", options) {}
+
+CanInterfaceNode::CanInterfaceNode(const std::string & interface_name,
+				   const rclcpp::NodeOptions & options)
+  : Node("can_interface", options) {
+
+  // One process can serve every bus on the vehicle: interface_names
+  // opens each of them, all waited on together by one thread or timer
+  std::vector<std::string> interface_names = this->declare_parameter<std::vector<std::string>>
+    ("interface_names", std::vector<std::string>());
+  if(!interface_name.empty()) {
+    interface_names = { interface_name };
+  } else if(interface_names.empty()) {
+    interface_names = { this->declare_parameter<std::string>("interface_name", "can0") };
+  }
+  for(std::size_t i = 0; i < interface_names.size(); i++) {
+    if(std::count(interface_names.begin(), interface_names.begin() + i, interface_names[i]) != 0) {
+      throw std::invalid_argument("interface_names lists " + interface_names[i] + " twice");
+    }
+  }
+
+  // "thread" publishes each frame as soon as it arrives. "timer" polls
+  // the sockets every receive_frequency, as this node used to.
+  this->receive_mode = this->declare_parameter<std::string>("receive_mode", "thread");
+  if(this->receive_mode != "thread" && this->receive_mode != "timer") {
+    throw std::invalid_argument("receive_mode must be \"thread\" or \"timer\", not \"" +
+				this->receive_mode + "\"");
+  }
+
+  // Every monitor_period seconds, each bus's load, frame rates and
+  // timing and error frames go out on /diagnostics. 0 turns it off.
+  this->monitor_period = this->declare_parameter<double>("monitor_period", 1.0);
+  if(this->monitor_period < 0) {
+    throw std::invalid_argument("monitor_period must not be negative");
+  }
+  // Frames further apart than this many times their expected period are late
+  this->monitor_period_tolerance = this->declare_parameter<double>("monitor_period_tolerance", 1.5);
+
+  const bool multiple_buses = interface_names.size() > 1;
+  for(const std::string & name : interface_names) {
+    this->add_bus(name, multiple_buses);
+  }
+  for(std::unique_ptr<Bus> & bus : this->buses) {
+    this->add_bridges(*bus, multiple_buses);
+  }
+
+  // If nobody needs a bus's full stream, the kernel only has to hand us
+  // the frames that some topic or bridge wants
+  for(std::unique_ptr<Bus> & bus : this->buses) {
+    if(bus->incoming_message_publisher) continue;
+    std::vector<struct can_filter> filters;
+    std::vector<IdRange> wanted = bus->bridged_ids;
+    for(const Bus::FilteredTopic & topic : bus->filtered_topics) {
+      wanted.push_back(topic.ids);
+    }
+    for(const IdRange & ids : wanted) {
+      auto range_filters = CanBus::range_filters(ids.first, ids.last);
+      filters.insert(filters.end(), range_filters.begin(), range_filters.end());
+    }
+    bus->can_bus->set_filters(filters);
+  }
+
+  this->epoll_socket = epoll_create1(EPOLL_CLOEXEC);
+  if(this->epoll_socket < 0) {
+    throw std::runtime_error("Error from epoll_create1(): errno is " + std::to_string(errno));
+  }
+  for(std::unique_ptr<Bus> & bus : this->buses) {
+    struct epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.ptr = bus.get();
+    if(epoll_ctl(this->epoll_socket, EPOLL_CTL_ADD, bus->can_bus->get_file_descriptor(), &event) != 0) {
+      ::close(this->epoll_socket);
+      throw std::runtime_error("Error from epoll_ctl() on interface " + bus->name +
+			       ": errno is " + std::to_string(errno));
+    }
+  }
+
+  if(this->receive_mode == "thread") {
+    this->receiving = true;
+    this->receive_thread = std::thread(& CanInterfaceNode::receive_loop, this);
+  } else {
+    // Set up the timer. Timers follow the node's clock, which is the
+    // system clock unless use_sim_time is set.
+    this->incoming_message_timer = rclcpp::create_timer
+      (this, this->get_clock(), rclcpp::Duration(receive_frequency),
+       bind(& CanInterfaceNode::check_incoming_messages, this));
+  }
+
+  this->latency_report_timer = rclcpp::create_timer
+    (this, this->get_clock(), rclcpp::Duration(latency_report_period),
+     bind(& CanInterfaceNode::report_latency, this));
+
+  if(this->monitor_period > 0) {
+    this->diagnostics_publisher = this->create_publisher<diagnostic_msgs::msg::DiagnosticArray>
+      ("/diagnostics", 10);
+    this->monitor_timer = rclcpp::create_timer
+      (this, this->get_clock(),
+       rclcpp::Duration(std::chrono::duration_cast<std::chrono::nanoseconds>
+			(std::chrono::duration<double>(this->monitor_period))),
+       bind(& CanInterfaceNode::report_bus_monitors, this));
+  }
+}
+
+void CanInterfaceNode::add_bus(const std::string & interface_name, bool multiple_buses) {
+  auto parameter = [&](const std::string & name) {
+    return bus_name(interface_name, name, '.', multiple_buses);
+  };
+  auto topic = [&](const std::string & name) {
+    return bus_name(interface_name, name, '/', multiple_buses);
+  };
+
+  this->buses.push_back(std::make_unique<Bus>());
+  Bus & bus = *this->buses.back();
+  bus.name = interface_name;
+  bus.can_bus = std::make_unique<navigator::can_interface::CanBus>(interface_name);
+
+  // With fd_frames, FD frames are published and sent on their own
+  // topics. Classic frames go on the usual ones either way.
+  bus.fd_frames = this->declare_parameter<bool>(parameter("fd_frames"), false);
+  if(bus.fd_frames) {
+    bus.can_bus->enable_fd_frames();
+    bus.incoming_fd_message_publisher = this->create_publisher<nova_msgs::msg::CanFdFrame>
+      (topic("can_interface_incoming_can_fd_frames"), 64);
+    bus.outgoing_fd_message_subscription =
+      this->create_subscription<nova_msgs::msg::CanFdFrame>
+      (topic("can_interface_outgoing_can_fd_frames"), 64,
+       bind(& CanInterfaceNode::send_fd_frame, this, std::ref(bus), _1));
+  }
+
+  // Raw frames go to the log as they are read, before any filtering or
+  // publishing, so it can be replayed later with the replay executable
+  std::string log_path = this->declare_parameter<std::string>(parameter("log_path"), "");
+  if(!log_path.empty()) {
+    bus.log = std::make_unique<navigator::can_interface::CanLogWriter>(log_path);
+  }
+
+  // The monitor needs the bit rates for the load, which a socket can't
+  // tell us, and each periodic frame's period in milliseconds to say
+  // when one is late. It sees error frames too.
+  if(this->monitor_period > 0) {
+    int64_t bit_rate = this->declare_parameter<int64_t>(parameter("bit_rate"), 500000);
+    int64_t data_bit_rate = this->declare_parameter<int64_t>(parameter("data_bit_rate"), 2000000);
+    if(bit_rate <= 0 || data_bit_rate <= 0) {
+      throw std::invalid_argument(parameter("bit_rate") + " and " + parameter("data_bit_rate") +
+				  " must be positive");
+    }
+    bus.monitor = std::make_unique<BusMonitor>(bit_rate, data_bit_rate, this->monitor_period_tolerance);
+    bus.max_load_percent = this->declare_parameter<double>(parameter("max_load_percent"), 0.0);
+    auto expected_periods = this->declare_parameter<std::vector<int64_t>>
+      (parameter("expected_periods_ms"), std::vector<int64_t>());
+    if(expected_periods.size() % 2 != 0) {
+      throw std::invalid_argument(parameter("expected_periods_ms") +
+				  " must hold pairs of identifiers and periods");
+    }
+    for(std::size_t i = 0; i < expected_periods.size(); i += 2) {
+      bus.monitor->expect_period((CanFrame::identifier_t) expected_periods[i],
+				 std::chrono::milliseconds(expected_periods[i + 1]));
+    }
+    bus.can_bus->set_error_mask(CAN_ERR_MASK);
+  }
 
   // Set up the publisher. Buffer up to 64 since the CAN bus could get fairly busy
-  this->incoming_message_publisher = this->create_publisher<nova_msgs::msg::CanFrame>
-    ("can_interface_incoming_can_frames", 64);
+  bus.incoming_message_publisher = this->create_publisher<nova_msgs::msg::CanFrame>
+    (topic("can_interface_incoming_can_frames"), 64);
+
+  // Each identifier in filtered_ids, and each pair of identifiers in
+  // filtered_id_ranges, gets its own topic, so consumers of one message
+  // aren't sent every other frame on the bus
+  auto filtered_ids = this->declare_parameter<std::vector<int64_t>>
+    (parameter("filtered_ids"), std::vector<int64_t>());
+  auto filtered_id_ranges = this->declare_parameter<std::vector<int64_t>>
+    (parameter("filtered_id_ranges"), std::vector<int64_t>());
+  if(filtered_id_ranges.size() % 2 != 0) {
+    throw std::invalid_argument(parameter("filtered_id_ranges") +
+				" must hold pairs of first and last identifiers");
+  }
+  for(int64_t id : filtered_ids) {
+    bus.filtered_topics.push_back({ { (CanFrame::identifier_t) id,
+				      (CanFrame::identifier_t) id }, nullptr });
+  }
+  for(std::size_t i = 0; i < filtered_id_ranges.size(); i += 2) {
+    bus.filtered_topics.push_back({ { (CanFrame::identifier_t) filtered_id_ranges[i],
+				      (CanFrame::identifier_t) filtered_id_ranges[i + 1] }, nullptr });
+  }
+  for(Bus::FilteredTopic & filtered_topic : bus.filtered_topics) {
+    filtered_topic.publisher = this->create_publisher<nova_msgs::msg::CanFrame>
+      (topic(filtered_topic_name(filtered_topic.ids.first, filtered_topic.ids.last)), 64);
+  }
+
+  if(!this->declare_parameter<bool>(parameter("publish_all_frames"), true)) {
+    bus.incoming_message_publisher.reset();
+  }
 
   // Subscribe to outgoing CAN messages
-  this->outgoing_message_subscription =
+  bus.outgoing_message_subscription =
     this->create_subscription<nova_msgs::msg::CanFrame>
-    ("can_interface_outgoing_can_frames", 64,
-     bind(& CanInterfaceNode::send_frame, this, _1));
+    (topic("can_interface_outgoing_can_frames"), 64,
+     bind(& CanInterfaceNode::send_frame, this, std::ref(bus), _1));
+}
+
+// Bridges go from one of the node's buses to others, so there are none
+// with a single bus
+void CanInterfaceNode::add_bridges(Bus & bus, bool multiple_buses) {
+  if(!multiple_buses) return;
+
+  auto bridge_to = this->declare_parameter<std::vector<std::string>>
+    (bus.name + ".bridge_to", std::vector<std::string>());
+  auto bridged_ids = this->declare_parameter<std::vector<int64_t>>
+    (bus.name + ".bridged_ids", std::vector<int64_t>());
+  auto bridged_id_ranges = this->declare_parameter<std::vector<int64_t>>
+    (bus.name + ".bridged_id_ranges", std::vector<int64_t>());
+  if(bridged_id_ranges.size() % 2 != 0) {
+    throw std::invalid_argument(bus.name + ".bridged_id_ranges must hold pairs of first and last identifiers");
+  }
+  if(bridge_to.empty()) return;
+
+  for(const std::string & name : bridge_to) {
+    auto destination = std::find_if(this->buses.begin(), this->buses.end(),
+				    [&](const std::unique_ptr<Bus> & other) { return other->name == name; });
+    if(destination == this->buses.end() || destination->get() == &bus) {
+      throw std::invalid_argument(bus.name + ".bridge_to names " + name +
+				  ", which is not another of interface_names");
+    }
+    bus.bridge_to.push_back(destination->get());
+  }
+  for(int64_t id : bridged_ids) {
+    bus.bridged_ids.push_back({ (CanFrame::identifier_t) id, (CanFrame::identifier_t) id });
+  }
+  for(std::size_t i = 0; i < bridged_id_ranges.size(); i += 2) {
+    bus.bridged_ids.push_back({ (CanFrame::identifier_t) bridged_id_ranges[i],
+				(CanFrame::identifier_t) bridged_id_ranges[i + 1] });
+  }
 }
 
 CanInterfaceNode::~CanInterfaceNode() {
+  this->receiving = false;
+  if(this->receive_thread.joinable()) {
+    this->receive_thread.join();
+  }
+  if(this->epoll_socket >= 0) {
+    ::close(this->epoll_socket);
+  }
+}
+
+// CAN frames have no header, so there are no flows to follow here
 
+void CanInterfaceNode::send_frame(Bus & bus, const nova_msgs::msg::CanFrame::SharedPtr msg) {
+  NOVA_TRACE_SPAN("can_interface.send_frame");
+  navigator::can_interface::CanFrame frame(msg->identifier, msg->data);
+  bus.can_bus->write_frame(frame);
+  if(bus.monitor) {
+    struct can_frame sent;
+    frame.to_system_frame(sent);
+    bus.monitor->record_sent(&sent, 1);
+  }
 }
 
-void CanInterfaceNode::send_frame(const nova_msgs::msg::CanFrame::SharedPtr msg) {
-  this->can_bus->write_frame(navigator::can_interface::CanFrame(msg->identifier, msg->data));
+void CanInterfaceNode::send_fd_frame(Bus & bus, const nova_msgs::msg::CanFdFrame::SharedPtr msg) {
+  NOVA_TRACE_SPAN("can_interface.send_fd_frame");
+  navigator::can_interface::CanFdFrame frame(msg->identifier, msg->data.data(), msg->length,
+					    msg->bit_rate_switch);
+  bus.can_bus->write_fd_frame(frame);
+  if(bus.monitor) {
+    struct canfd_frame sent;
+    frame.to_system_frame(sent);
+    bus.monitor->record_sent(sent);
+  }
 }
 
 void CanInterfaceNode::check_incoming_messages() {
-  while(this->can_bus->is_frame_ready()) {
-    this->receive_frame();
+  while(this->receive_ready(0ms)) {}
+}
+
+void CanInterfaceNode::receive_loop() {
+  while(this->receiving) {
+    this->receive_ready(receive_wait);
   }
 }
 
-void CanInterfaceNode::receive_frame() {
-  std::unique_ptr<navigator::can_interface::CanFrame> frame = this->can_bus->read_frame();
-  nova_msgs::msg::CanFrame message;
-  message.identifier = frame->get_identifier();
-  message.data = frame->get_data();
-  this->incoming_message_publisher->publish(message);
+bool CanInterfaceNode::receive_ready(std::chrono::milliseconds timeout) {
+  // Buses beyond these that are ready are read on the next call
+  std::array<struct epoll_event, 16> events;
+  int n_ready = epoll_wait(this->epoll_socket, events.data(), (int) events.size(),
+			   (int) timeout.count());
+  if(n_ready < 0) {
+    if(errno == EINTR) return false; // Interrupted by a signal, just try again later
+    throw std::runtime_error("Error from epoll_wait(): errno is " + std::to_string(errno));
+  }
+  for(int i = 0; i < n_ready; i++) {
+    this->receive_frames(*static_cast<Bus *>(events[i].data.ptr));
+  }
+  return n_ready != 0;
 }
+
+void CanInterfaceNode::receive_frames(Bus & bus) {
+  NOVA_TRACE_SPAN("can_interface.receive_frames");
+  std::size_t n_frames;
+  if(bus.fd_frames) {
+    std::size_t n_read = bus.can_bus->read_fd_frames
+      (bus.received_fd_frames.data(), bus.received_stamps.data(),
+       bus.received_fd_frames.size());
+    navigator::trace::counter("can_interface.frames_per_read", double(n_read));
+
+    // Publish the FD frames, and move the classic ones down into
+    // received_frames for the usual path below
+    n_frames = 0;
+    for(std::size_t i = 0; i < n_read; i++) {
+      const struct canfd_frame & received = bus.received_fd_frames[i];
+      if(received.flags & CANFD_FDF) {
+	nova_msgs::msg::CanFdFrame message;
+	message.identifier = received.can_id;
+	message.length = std::min<uint8_t>(received.len, CANFD_MAX_DLEN);
+	message.bit_rate_switch = received.flags & CANFD_BRS;
+	std::copy(received.data, received.data + message.length, message.data.begin());
+	bus.incoming_fd_message_publisher->publish(message);
+	if(bus.monitor) bus.monitor->record(received, bus.received_stamps[i]);
+	this->latency.record(std::chrono::system_clock::now() - bus.received_stamps[i].kernel);
+      } else {
+	memcpy(&bus.received_frames[n_frames], &received, sizeof(struct can_frame));
+	bus.received_stamps[n_frames] = bus.received_stamps[i];
+	n_frames++;
+      }
+    }
+  } else {
+    n_frames = bus.can_bus->read_frames
+      (bus.received_frames.data(), bus.received_stamps.data(), bus.received_frames.size());
+    navigator::trace::counter("can_interface.frames_per_read", double(n_frames));
+  }
+  if(bus.monitor) {
+    bus.monitor->record(bus.received_frames.data(), bus.received_stamps.data(), n_frames);
+    // Error frames are only for the monitor, not for topics, bridges or the log
+    std::size_t n_kept = 0;
+    for(std::size_t i = 0; i < n_frames; i++) {
+      if(bus.received_frames[i].can_id & CAN_ERR_FLAG) continue;
+      bus.received_frames[n_kept] = bus.received_frames[i];
+      bus.received_stamps[n_kept] = bus.received_stamps[i];
+      n_kept++;
+    }
+    n_frames = n_kept;
+  }
+  // Bridged frames go out first, as nothing else here holds them up
+  this->bridge_frames(bus, n_frames);
+  if(bus.log) {
+    NOVA_TRACE_SPAN("can_interface.log");
+    bus.log->append(bus.received_frames.data(), bus.received_stamps.data(), n_frames);
+  }
+  for(std::size_t i = 0; i < n_frames; i++) {
+    navigator::can_interface::CanFrame frame(bus.received_frames[i]);
+    nova_msgs::msg::CanFrame message;
+    message.identifier = frame.get_identifier();
+    message.data = frame.get_data();
+    if(bus.incoming_message_publisher) {
+      bus.incoming_message_publisher->publish(message);
+    }
+    CanFrame::identifier_t identifier = frame.get_identifier() & CAN_EFF_MASK;
+    for(const Bus::FilteredTopic & topic : bus.filtered_topics) {
+      if(topic.ids.contains(identifier)) {
+	topic.publisher->publish(message);
+      }
+    }
+    this->latency.record(std::chrono::system_clock::now() - bus.received_stamps[i].kernel);
+  }
+}
+
+// Every bus is read and bridged from the one thread or timer, which is
+// what keeps each CanBus's batch scratch to one user at a time
+void CanInterfaceNode::bridge_frames(Bus & bus, std::size_t n_frames) {
+  if(bus.bridge_to.empty()) return;
+  std::size_t n_bridged = 0;
+  for(std::size_t i = 0; i < n_frames; i++) {
+    CanFrame::identifier_t identifier = bus.received_frames[i].can_id & CAN_EFF_MASK;
+    for(const IdRange & ids : bus.bridged_ids) {
+      if(ids.contains(identifier)) {
+	bus.bridged_frames[n_bridged++] = bus.received_frames[i];
+	break;
+      }
+    }
+  }
+  if(n_bridged == 0) return;
+
+  NOVA_TRACE_SPAN("can_interface.bridge_frames");
+  for(Bus * destination : bus.bridge_to) {
+    // A full transmit queue drops the rest rather than holding up reads
+    std::size_t n_written = destination->can_bus->write_frames(bus.bridged_frames.data(), n_bridged);
+    if(n_written < n_bridged) {
+      navigator::trace::counter("can_interface.bridge_dropped", double(n_bridged - n_written));
+    }
+    if(destination->monitor) destination->monitor->record_sent(bus.bridged_frames.data(), n_written);
+  }
+}
+
+void CanInterfaceNode::report_latency() {
+  if(this->latency.count() == 0) return;
+  RCLCPP_INFO(this->get_logger(), "Receive latency (%s mode): %s",
+	      this->receive_mode.c_str(), this->latency.snapshot().summary().c_str());
+}
+
+// One status per bus, a warning while it is over its load limit, has
+// error frames, or has a periodic frame late or missing
+void CanInterfaceNode::report_bus_monitors() {
+  auto now = std::chrono::system_clock::now();
+  diagnostic_msgs::msg::DiagnosticArray message;
+  message.header.stamp = this->now();
+  for(std::unique_ptr<Bus> & bus : this->buses) {
+    BusSummary summary = bus->monitor->summarize(now);
+    DiagnosticStatus status;
+    status.name = std::string(this->get_name()) + ": " + bus->name;
+    status.hardware_id = bus->name;
+    std::vector<std::string> problems;
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+
+    double seconds = summary.seconds > 0 ? summary.seconds : 1;
+    status.values.push_back(key_value("frames_per_second", summary.frames / seconds));
+    status.values.push_back(key_value("sent_frames_per_second", summary.sent_frames / seconds));
+    status.values.push_back(key_value("load_percent", summary.load_percent));
+    status.values.push_back(key_value("error_frames", double(summary.error_frames)));
+    if(bus->max_load_percent > 0 && summary.load_percent > bus->max_load_percent) {
+      text.str("");
+      text << "load " << summary.load_percent << "% over " << bus->max_load_percent << "%";
+      problems.push_back(text.str());
+    }
+    if(summary.error_frames != 0) {
+      problems.push_back(std::to_string(summary.error_frames) + " error frames");
+      for(std::size_t b = 0; b < summary.errors.size(); b++) {
+	if(summary.errors[b] == 0) continue;
+	status.values.push_back(key_value(std::string("errors ") + navigator::can_interface::ERROR_CLASS_NAMES[b],
+					  double(summary.errors[b])));
+      }
+    }
+
+    // One value per identifier: 0x292 = "100.0 Hz, jitter p50 < 16 us,
+    // p99 < 128 us, max 90 us, every 10 ms, 2 late"
+    for(const auto & id : summary.identifiers) {
+      std::ostringstream name;
+      name << "0x" << std::hex << id.identifier;
+      text.str("");
+      text << id.rate_hz << " Hz, jitter p50 < " << id.jitter_p50_us << " us, p99 < "
+	   << id.jitter_p99_us << " us, max " << id.jitter_max_us << " us";
+      if(id.expected_period.count() > 0) {
+	text << ", every " << std::chrono::duration<double, std::milli>(id.expected_period).count()
+	     << " ms, " << id.late << " late";
+      }
+      if(id.missing) text << ", missing";
+      status.values.push_back(key_value(name.str(), text.str()));
+      if(id.missing) {
+	problems.push_back(name.str() + " missing");
+      } else if(id.late != 0) {
+	problems.push_back(name.str() + " late " + std::to_string(id.late) + " times");
+      }
+    }
+
+    if(problems.empty()) {
+      status.level = DiagnosticStatus::OK;
+      status.message = "OK";
+    } else {
+      status.level = DiagnosticStatus::WARN;
+      for(std::size_t i = 0; i < problems.size(); i++) {
+	status.message += (i ? "; " : "") + problems[i];
+      }
+    }
+    message.status.push_back(status);
+  }
+  this->diagnostics_publisher->publish(message);
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(navigator::can_interface::CanInterfaceNode)
@@ -0,0 +1,254 @@
+/*
+ * Package:   can_interface
+ * Filename:  CanLog.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm> // std::min, std::max
+#include <cerrno> // errno
+#include <chrono> // Replay timing
+#include <cstring> // memcpy()
+#include <fcntl.h> // open()
+#include <stdexcept> // Runtime errors
+#include <string> // Because we are not barbarians
+#include <sys/mman.h> // mmap()
+#include <sys/stat.h> // fstat()
+#include <thread> // sleep_until()
+#include <unistd.h> // ftruncate()
+
+#include "can_interface/CanBus.hpp" // Replay target
+#include "can_interface/CanLog.hpp" // Header for this file
+
+using namespace navigator::can_interface;
+
+namespace {
+  constexpr char LOG_MAGIC[8] = { 'N', 'O', 'V', 'A', 'C', 'A', 'N', 'L' };
+  constexpr uint32_t LOG_VERSION = 1;
+  constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+
+  struct LogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t chunk_frames;
+    uint64_t reserved[2];
+  };
+
+  struct ChunkIndex {
+    uint32_t magic;
+    uint32_t frame_count;
+    int64_t first_timestamp_ns;
+    int64_t last_timestamp_ns;
+    uint64_t reserved;
+  };
+
+  constexpr std::size_t CHUNK_SIZE =
+    sizeof(ChunkIndex) + CanLogWriter::CHUNK_FRAMES * sizeof(CanLogRecord);
+
+  // The file grows this many chunks at a time, about 32MB
+  constexpr std::size_t GROWTH = 256 * CHUNK_SIZE;
+
+  std::runtime_error log_error(const std::string & what, const std::string & path) {
+    return std::runtime_error(what + " " + path + ": errno is " + std::to_string(errno));
+  }
+}
+
+void CanLogRecord::to_system_frame(struct can_frame & frame) const {
+  frame = {};
+  frame.can_id = this->can_id;
+  frame.can_dlc = this->can_dlc;
+  memcpy(frame.data, this->data, sizeof(frame.data));
+}
+
+CanLogWriter::CanLogWriter(const std::string & path) {
+  this->path = path;
+  this->file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(this->file < 0) throw log_error("Could not create CAN log", path);
+
+  this->reserve(sizeof(LogHeader));
+  LogHeader header {};
+  memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+  header.version = LOG_VERSION;
+  header.chunk_frames = CHUNK_FRAMES;
+  memcpy(this->map, &header, sizeof(header));
+  this->used = sizeof(LogHeader);
+}
+
+CanLogWriter::~CanLogWriter() {
+  this->close();
+}
+
+// Make sure at least bytes more can be written, growing the file and
+// remapping it if they can't
+void CanLogWriter::reserve(std::size_t bytes) {
+  if(this->used + bytes <= this->mapped) return;
+  std::size_t size = this->mapped + std::max(bytes, GROWTH);
+  if(ftruncate(this->file, size) != 0) throw log_error("Could not grow CAN log", this->path);
+  void * map = this->map == nullptr ?
+    mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->file, 0) :
+    mremap(this->map, this->mapped, size, MREMAP_MAYMOVE);
+  if(map == MAP_FAILED) throw log_error("Could not map CAN log", this->path);
+  this->map = static_cast<char *>(map);
+  this->mapped = size;
+}
+
+void CanLogWriter::start_chunk(int64_t timestamp_ns) {
+  this->reserve(CHUNK_SIZE);
+  this->chunk = this->used;
+  ChunkIndex index {};
+  index.magic = CHUNK_MAGIC;
+  index.first_timestamp_ns = timestamp_ns;
+  index.last_timestamp_ns = timestamp_ns;
+  memcpy(this->map + this->chunk, &index, sizeof(index));
+  this->used += sizeof(ChunkIndex);
+}
+
+void CanLogWriter::append(const struct can_frame * frames, const ReceiveTimestamp * stamps,
+			  std::size_t count) {
+  int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>
+    (std::chrono::system_clock::now().time_since_epoch()).count();
+  for(std::size_t i = 0; i < count; i++) {
+    CanLogRecord record {};
+    record.timestamp_ns = stamps == nullptr ? now :
+      std::chrono::duration_cast<std::chrono::nanoseconds>
+      (stamps[i].kernel.time_since_epoch()).count();
+    record.hardware_ns = stamps == nullptr ? 0 : stamps[i].hardware.count();
+    record.can_id = frames[i].can_id;
+    record.can_dlc = frames[i].can_dlc;
+    memcpy(record.data, frames[i].data, sizeof(record.data));
+
+    if(this->frames % CHUNK_FRAMES == 0) this->start_chunk(record.timestamp_ns);
+    memcpy(this->map + this->used, &record, sizeof(record));
+    this->used += sizeof(record);
+
+    // The count goes in after the record, so a reader never sees a
+    // frame that isn't all there
+    ChunkIndex * index = reinterpret_cast<ChunkIndex *>(this->map + this->chunk);
+    index->last_timestamp_ns = record.timestamp_ns;
+    index->frame_count++;
+    this->frames++;
+  }
+}
+
+uint64_t CanLogWriter::frame_count() const {
+  return this->frames;
+}
+
+void CanLogWriter::close() {
+  if(this->file < 0) return;
+  if(this->map != nullptr) munmap(this->map, this->mapped);
+  this->map = nullptr;
+  ftruncate(this->file, this->used); // Nothing to do about a failure here
+  ::close(this->file);
+  this->file = -1;
+}
+
+CanLogReader::CanLogReader(const std::string & path) {
+  int file = open(path.c_str(), O_RDONLY);
+  if(file < 0) throw log_error("Could not open CAN log", path);
+  struct stat status;
+  if(fstat(file, &status) != 0) {
+    ::close(file);
+    throw log_error("Could not read CAN log", path);
+  }
+  this->mapped = status.st_size;
+  if(this->mapped < sizeof(LogHeader)) {
+    ::close(file);
+    throw std::runtime_error("CAN log " + path + " is too short to have a header");
+  }
+  void * map = mmap(NULL, this->mapped, PROT_READ, MAP_SHARED, file, 0);
+  ::close(file); // The mapping keeps the file open
+  if(map == MAP_FAILED) throw log_error("Could not map CAN log", path);
+  this->map = static_cast<const char *>(map);
+
+  LogHeader header;
+  memcpy(&header, this->map, sizeof(header));
+  if(memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 || header.version != LOG_VERSION ||
+     header.chunk_frames != CanLogWriter::CHUNK_FRAMES) {
+    munmap(const_cast<char *>(this->map), this->mapped);
+    throw std::runtime_error(path + " is not a CAN log this version can read");
+  }
+
+  // Walk the index blocks. Only the last chunk may be partly full, and
+  // anything after a missing or empty index is unwritten space.
+  std::size_t offset = sizeof(LogHeader);
+  while(offset + sizeof(ChunkIndex) <= this->mapped) {
+    ChunkIndex index;
+    memcpy(&index, this->map + offset, sizeof(index));
+    if(index.magic != CHUNK_MAGIC || index.frame_count == 0) break;
+    std::size_t records = std::min<std::size_t>
+      (index.frame_count, (this->mapped - offset - sizeof(ChunkIndex)) / sizeof(CanLogRecord));
+    this->chunks.push_back(offset + sizeof(ChunkIndex));
+    this->frames += records;
+    if(records < CanLogWriter::CHUNK_FRAMES) break;
+    offset += CHUNK_SIZE;
+  }
+}
+
+CanLogReader::~CanLogReader() {
+  munmap(const_cast<char *>(this->map), this->mapped);
+}
+
+std::size_t CanLogReader::size() const {
+  return this->frames;
+}
+
+const CanLogRecord & CanLogReader::operator[](std::size_t index) const {
+  std::size_t offset = this->chunks[index / CanLogWriter::CHUNK_FRAMES] +
+    (index % CanLogWriter::CHUNK_FRAMES) * sizeof(CanLogRecord);
+  return *reinterpret_cast<const CanLogRecord *>(this->map + offset);
+}
+
+std::size_t CanLogReader::seek(int64_t timestamp_ns) const {
+  // Frames are in the order they arrived, so their stamps only go up
+  std::size_t low = 0;
+  std::size_t high = this->frames;
+  while(low < high) {
+    std::size_t middle = low + (high - low) / 2;
+    if((*this)[middle].timestamp_ns < timestamp_ns) low = middle + 1;
+    else high = middle;
+  }
+  return low;
+}
+
+std::size_t navigator::can_interface::replay_log(const CanLogReader & log, CanBus & bus,
+						 double speed, std::size_t first,
+						 std::size_t last) {
+  last = std::min(last, log.size());
+  if(first >= last) return 0;
+
+  struct can_frame batch[CanBus::BATCH_CAPACITY];
+  std::size_t batched = 0;
+  std::size_t sent = 0;
+  auto send_batch = [&]() {
+    std::size_t done = 0;
+    while(done < batched) {
+      std::size_t written = bus.write_frames(batch + done, batched - done);
+      // A full transmit queue drains at the bus's rate, so wait a little
+      if(written == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+      done += written;
+    }
+    sent += batched;
+    batched = 0;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  int64_t first_timestamp = log[first].timestamp_ns;
+  for(std::size_t i = first; i < last; i++) {
+    const CanLogRecord & record = log[i];
+    if(speed > 0) {
+      auto due = start + std::chrono::nanoseconds
+	((int64_t) ((record.timestamp_ns - first_timestamp) / speed));
+      if(due > std::chrono::steady_clock::now()) {
+	send_batch(); // Frames that were due together go out together
+	std::this_thread::sleep_until(due);
+      }
+    }
+    record.to_system_frame(batch[batched++]);
+    if(batched == CanBus::BATCH_CAPACITY) send_batch();
+  }
+  send_batch();
+  return sent;
+}
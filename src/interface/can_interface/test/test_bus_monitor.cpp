@@ -0,0 +1,156 @@
+/*
+ * Package:   can_interface
+ * Filename:  test_bus_monitor.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// Test the BusMonitor class, which needs no CAN bus.
+
+#include <chrono> // Stamps and periods
+#include <gtest/gtest.h> // Testing framework
+#include <linux/can.h> // struct can_frame
+#include <linux/can/error.h> // Error classes
+
+#include "can_interface/BusMonitor.hpp" // The class we are testing
+
+using namespace navigator::can_interface;
+using namespace std::chrono_literals;
+
+static const auto start = std::chrono::system_clock::time_point(1000s);
+
+static struct can_frame frame(canid_t can_id, uint8_t length) {
+  struct can_frame frame {};
+  frame.can_id = can_id;
+  frame.can_dlc = length;
+  return frame;
+}
+
+static ReceiveTimestamp stamp(std::chrono::nanoseconds after_start) {
+  return { start + std::chrono::duration_cast<std::chrono::system_clock::duration>(after_start),
+	   std::chrono::nanoseconds(0) };
+}
+
+// At 500 kbit/s each bit is 2 us
+TEST(TestBusMonitor, test_bus_time) {
+  BusMonitor monitor(500000, 2000000, 1.5, start);
+  ASSERT_EQ(monitor.bus_time(frame(0x123, 8)), 222us); // 47 + 64 bits
+  ASSERT_EQ(monitor.bus_time(frame(0x123 | CAN_EFF_FLAG, 0)), 134us); // 67 bits
+  ASSERT_EQ(monitor.bus_time(frame(0x123 | CAN_RTR_FLAG, 8)), 94us); // No data
+
+  // 30 bits at 2 us and 542 at 0.5 us, or all 572 at 2 us without the switch
+  struct canfd_frame fd_frame {};
+  fd_frame.can_id = 0x123;
+  fd_frame.len = 64;
+  fd_frame.flags = CANFD_FDF | CANFD_BRS;
+  ASSERT_EQ(monitor.bus_time(fd_frame), 331us);
+  fd_frame.flags = CANFD_FDF;
+  ASSERT_EQ(monitor.bus_time(fd_frame), 1144us);
+}
+
+TEST(TestBusMonitor, test_rates_and_load) {
+  BusMonitor monitor(500000, 2000000, 1.5, start);
+  // 0x100 every 10 ms and 0x200 every 100 ms, for a second
+  for(int i = 0; i < 100; i++) {
+    struct can_frame received = frame(0x100, 8);
+    ReceiveTimestamp received_stamp = stamp(i * 10ms);
+    monitor.record(&received, &received_stamp, 1);
+    if(i % 10 == 0) {
+      received = frame(0x200, 8);
+      monitor.record(&received, &received_stamp, 1);
+    }
+  }
+  struct can_frame sent[2] = { frame(0x300, 8), frame(0x300, 8) };
+  monitor.record_sent(sent, 2);
+
+  BusSummary summary = monitor.summarize(start + 1s);
+  ASSERT_DOUBLE_EQ(summary.seconds, 1.0);
+  ASSERT_EQ(summary.frames, 110u);
+  ASSERT_EQ(summary.sent_frames, 2u);
+  ASSERT_NEAR(summary.load_percent, 112 * 222e-6 * 100, 1e-9);
+  ASSERT_EQ(summary.error_frames, 0u);
+  ASSERT_EQ(summary.identifiers.size(), 2u);
+  ASSERT_EQ(summary.identifiers[0].identifier, 0x100u);
+  ASSERT_DOUBLE_EQ(summary.identifiers[0].rate_hz, 100.0);
+  ASSERT_EQ(summary.identifiers[0].jitter_max_us, 0u); // Perfectly regular
+  ASSERT_EQ(summary.identifiers[1].identifier, 0x200u);
+  ASSERT_DOUBLE_EQ(summary.identifiers[1].rate_hz, 10.0);
+
+  // The next summary starts from nothing, and leaves out quiet identifiers
+  summary = monitor.summarize(start + 2s);
+  ASSERT_EQ(summary.frames, 0u);
+  ASSERT_EQ(summary.load_percent, 0.0);
+  ASSERT_TRUE(summary.identifiers.empty());
+}
+
+TEST(TestBusMonitor, test_jitter_and_late_frames) {
+  BusMonitor monitor(500000, 2000000, 1.5, start);
+  monitor.expect_period(0x100, 10ms);
+  // On time, 300 us late, 300 us early, then 20 ms late
+  for(auto time : { 0us, 10000us, 20300us, 30000us, 60000us }) {
+    struct can_frame received = frame(0x100, 8);
+    ReceiveTimestamp received_stamp = stamp(time);
+    monitor.record(&received, &received_stamp, 1);
+  }
+  BusSummary summary = monitor.summarize(start + 65ms);
+  ASSERT_EQ(summary.identifiers.size(), 1u);
+  const IdentifierSummary & id = summary.identifiers[0];
+  ASSERT_EQ(id.frames, 5u);
+  ASSERT_EQ(id.expected_period, 10ms);
+  ASSERT_EQ(id.late, 1u);
+  ASSERT_EQ(id.jitter_max_us, 20000u);
+  ASSERT_EQ(id.jitter_p50_us, 320u); // Two of four off by 300 us
+  ASSERT_FALSE(id.missing);
+
+  // Nothing since, so overdue by the next summary
+  summary = monitor.summarize(start + 100ms);
+  ASSERT_EQ(summary.identifiers.size(), 1u);
+  ASSERT_EQ(summary.identifiers[0].frames, 0u);
+  ASSERT_TRUE(summary.identifiers[0].missing);
+}
+
+// An expected identifier that never turns up is missing too
+TEST(TestBusMonitor, test_never_seen) {
+  BusMonitor monitor(500000, 2000000, 1.5, start);
+  monitor.expect_period(0x100, 10ms);
+  BusSummary summary = monitor.summarize(start + 10ms);
+  ASSERT_FALSE(summary.identifiers[0].missing);
+  summary = monitor.summarize(start + 20ms);
+  ASSERT_TRUE(summary.identifiers[0].missing);
+}
+
+// The adapter's clock is used for intervals when it stamps frames
+TEST(TestBusMonitor, test_hardware_stamps) {
+  BusMonitor monitor(500000, 2000000, 1.5, start);
+  for(int i = 0; i < 3; i++) {
+    struct can_frame received = frame(0x100, 8);
+    // The kernel got to the second frame late, but it came in on time
+    ReceiveTimestamp received_stamp = stamp(i * 10ms + (i == 1 ? 5ms : 0ms));
+    received_stamp.hardware = 7s + i * 10ms;
+    monitor.record(&received, &received_stamp, 1);
+  }
+  BusSummary summary = monitor.summarize(start + 30ms);
+  ASSERT_EQ(summary.identifiers[0].jitter_max_us, 0u);
+}
+
+TEST(TestBusMonitor, test_error_frames) {
+  BusMonitor monitor(500000, 2000000, 1.5, start);
+  struct can_frame received[2] = {
+    frame(CAN_ERR_FLAG | CAN_ERR_ACK | CAN_ERR_BUSERROR, CAN_ERR_DLC),
+    frame(CAN_ERR_FLAG | CAN_ERR_BUSOFF, CAN_ERR_DLC)
+  };
+  ReceiveTimestamp received_stamps[2] = { stamp(0ms), stamp(1ms) };
+  monitor.record(received, received_stamps, 2);
+
+  BusSummary summary = monitor.summarize(start + 1s);
+  ASSERT_EQ(summary.frames, 0u);
+  ASSERT_EQ(summary.load_percent, 0.0);
+  ASSERT_TRUE(summary.identifiers.empty());
+  ASSERT_EQ(summary.error_frames, 2u);
+  ASSERT_EQ(summary.errors[5], 1u); // no_ack
+  ASSERT_EQ(summary.errors[6], 1u); // bus_off
+  ASSERT_EQ(summary.errors[7], 1u); // bus_error
+  ASSERT_STREQ(ERROR_CLASS_NAMES[6], "bus_off");
+}
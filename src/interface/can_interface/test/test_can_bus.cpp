@@ -12,9 +12,11 @@
 // operational on your system.
 
 #include <gtest/gtest.h> // Testing framework
+#include <chrono> // Timeouts
 #include <memory> // std::unique_ptr
 
 #include "can_interface/CanBus.hpp" // The class we are testing, obviously
+#include "can_interface/CanFdFrame.hpp" // Likewise, for FD
 #include "can_interface/CanFrame.hpp" // Needed to interact with CanBus
 
 using namespace navigator::can_interface;
@@ -52,3 +54,91 @@ TEST(TestCanBus, test_communication) {
   ASSERT_EQ(received_frame_2->get_identifier(), 0x293u);
   ASSERT_EQ(received_frame_2->get_data(), 0x1234567890123457u);
 }
+
+// Frames that arrive together should be read together, in order
+TEST(TestCanBus, test_batched_receive) {
+  CanBus bus1("vcan0");
+  CanBus bus2("vcan0");
+  ASSERT_FALSE(bus2.wait_for_frame(std::chrono::milliseconds(0)));
+
+  struct can_frame outgoing[2];
+  CanFrame(0x292, 0x1234567890123456u).to_system_frame(outgoing[0]);
+  CanFrame(0x293, 0x1234567890123457u).to_system_frame(outgoing[1]);
+  ASSERT_EQ(bus1.write_frames(outgoing, 2), 2u);
+
+  ASSERT_TRUE(bus2.wait_for_frame(std::chrono::milliseconds(100)));
+  struct can_frame incoming[8];
+  ReceiveTimestamp stamps[8];
+  ASSERT_EQ(bus2.read_frames(incoming, stamps, 8), 2u);
+  ASSERT_EQ(CanFrame(incoming[0]).get_identifier(), 0x292u);
+  ASSERT_EQ(CanFrame(incoming[1]).get_identifier(), 0x293u);
+  ASSERT_EQ(CanFrame(incoming[1]).get_data(), 0x1234567890123457u);
+  ASSERT_LE(stamps[0].kernel, stamps[1].kernel);
+  ASSERT_LE(stamps[1].kernel, std::chrono::system_clock::now());
+  ASSERT_EQ(bus2.read_frames(incoming, NULL, 8), 0u);
+}
+
+// Ranges should become the fewest aligned identifier and mask pairs
+TEST(TestCanBus, test_range_filters) {
+  auto single = CanBus::range_filters(0x292, 0x292);
+  ASSERT_EQ(single.size(), 1u);
+  ASSERT_EQ(single[0].can_id, 0x292u);
+  ASSERT_EQ(single[0].can_mask, CAN_SFF_MASK | CAN_EFF_FLAG);
+
+  auto block = CanBus::range_filters(0x200, 0x2FF);
+  ASSERT_EQ(block.size(), 1u);
+  ASSERT_EQ(block[0].can_id, 0x200u);
+  ASSERT_EQ(block[0].can_mask, 0x700u | CAN_EFF_FLAG);
+
+  // 0x7FE-0x7FF are standard, 0x800-0x801 extended
+  auto straddling = CanBus::range_filters(0x7FE, 0x801);
+  ASSERT_EQ(straddling.size(), 2u);
+  ASSERT_EQ(straddling[0].can_id, 0x7FEu);
+  ASSERT_EQ(straddling[1].can_id, 0x800u | CAN_EFF_FLAG);
+  ASSERT_EQ(straddling[1].can_mask, (CAN_EFF_MASK & ~1u) | CAN_EFF_FLAG);
+
+  ASSERT_EQ(CanBus::range_filters(0x123, 0x122).size(), 0u);
+}
+
+// A filtered bus should only see the frames it asked for
+TEST(TestCanBus, test_kernel_filters) {
+  CanBus bus1("vcan0");
+  CanBus bus2("vcan0");
+  bus2.set_filters(CanBus::range_filters(0x292, 0x293));
+  bus1.write_frame(CanFrame(0x291, 1));
+  bus1.write_frame(CanFrame(0x292, 2));
+  bus1.write_frame(CanFrame(0x293, 3));
+  bus1.write_frame(CanFrame(0x294, 4));
+  struct can_frame incoming[8];
+  ASSERT_TRUE(bus2.wait_for_frame(std::chrono::milliseconds(100)));
+  ASSERT_EQ(bus2.read_frames(incoming, NULL, 8), 2u);
+  ASSERT_EQ(CanFrame(incoming[0]).get_data(), 2u);
+  ASSERT_EQ(CanFrame(incoming[1]).get_data(), 3u);
+
+  bus2.clear_filters();
+  bus1.write_frame(CanFrame(0x294, 4));
+  ASSERT_TRUE(bus2.wait_for_frame(std::chrono::milliseconds(100)));
+  ASSERT_EQ(bus2.read_frames(incoming, NULL, 8), 1u);
+}
+
+// FD and classic frames should share a bus, and come out of
+// read_fd_frames() told apart by their flags. Needs vcan0's MTU at 72.
+TEST(TestCanBus, test_fd_frames) {
+  CanBus bus1("vcan0");
+  CanBus bus2("vcan0");
+  bus1.enable_fd_frames();
+  bus2.enable_fd_frames();
+  uint8_t payload[64];
+  for(int i = 0; i < 64; i++) payload[i] = i;
+  bus1.write_fd_frame(CanFdFrame(0x300, payload, 64));
+  bus1.write_frame(CanFrame(0x301, 0x1234));
+
+  struct canfd_frame incoming[8];
+  ASSERT_TRUE(bus2.wait_for_frame(std::chrono::milliseconds(100)));
+  ASSERT_EQ(bus2.read_fd_frames(incoming, NULL, 8), 2u);
+  ASSERT_TRUE(incoming[0].flags & CANFD_FDF);
+  ASSERT_EQ(CanFdFrame(incoming[0]).get_length(), 64u);
+  ASSERT_EQ(CanFdFrame(incoming[0]).get_data()[63], 63u);
+  ASSERT_FALSE(incoming[1].flags & CANFD_FDF);
+  ASSERT_EQ(CanFrame(*(struct can_frame *) &incoming[1]).get_data(), 0x1234u);
+}
@@ -0,0 +1,53 @@
+/*
+ * Package:   can_interface
+ * Filename:  test_can_fd_frame.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// Test the CanFdFrame class
+
+#include <gtest/gtest.h> // Testing framework
+#include <linux/can.h> // struct canfd_frame
+
+#include "can_interface/CanFdFrame.hpp"
+
+using namespace navigator::can_interface;
+
+TEST(TestCanFdFrame, test_padded_lengths) {
+  ASSERT_EQ(CanFdFrame::padded_length(0), 0);
+  ASSERT_EQ(CanFdFrame::padded_length(8), 8);
+  ASSERT_EQ(CanFdFrame::padded_length(9), 12);
+  ASSERT_EQ(CanFdFrame::padded_length(33), 48);
+  ASSERT_EQ(CanFdFrame::padded_length(64), 64);
+}
+
+// Lengths CAN FD can't carry should be padded with zeros on the bus
+TEST(TestCanFdFrame, convert_to_system_frame) {
+  uint8_t payload[40];
+  for(int i = 0; i < 40; i++) payload[i] = i + 1;
+  CanFdFrame my_frame(0x292, payload, 40);
+  struct canfd_frame system_frame;
+  my_frame.to_system_frame(system_frame);
+  ASSERT_EQ(system_frame.can_id, 0x292u);
+  ASSERT_EQ(system_frame.len, 48u);
+  ASSERT_EQ(system_frame.flags, CANFD_FDF | CANFD_BRS);
+  ASSERT_EQ(system_frame.data[0], 1u);
+  ASSERT_EQ(system_frame.data[39], 40u);
+  ASSERT_EQ(system_frame.data[40], 0u);
+}
+
+TEST(TestCanFdFrame, convert_from_system_frame) {
+  struct canfd_frame system_frame = {};
+  system_frame.can_id = 0x12345 | CAN_EFF_FLAG;
+  system_frame.len = 64;
+  system_frame.flags = CANFD_FDF;
+  system_frame.data[63] = 0xAB;
+  CanFdFrame my_frame(system_frame);
+  ASSERT_EQ(my_frame.get_identifier(), 0x12345u | CAN_EFF_FLAG);
+  ASSERT_EQ(my_frame.get_length(), 64u);
+  ASSERT_FALSE(my_frame.get_bit_rate_switch());
+  ASSERT_EQ(my_frame.get_data()[63], 0xABu);
+}
@@ -42,3 +42,13 @@ TEST(TestCanFrame, convert_to_system_frame) {
   ASSERT_EQ(*((CanFrame::data_t*) system_frame->data), (CanFrame::data_t) 0x0102030405060708);
   ASSERT_EQ(system_frame->can_dlc, 8);
 }
+
+// Test converting in place, without the heap
+TEST(TestCanFrame, convert_to_system_frame_in_place) {
+  CanFrame my_frame(0x12345, 0x1234567890123456);
+  struct can_frame system_frame;
+  my_frame.to_system_frame(system_frame);
+  ASSERT_EQ(system_frame.can_id, 0x12345u | CAN_EFF_FLAG);
+  ASSERT_EQ(system_frame.can_dlc, 8u);
+  ASSERT_EQ(*((uint64_t *) system_frame.data), 0x1234567890123456u);
+}
@@ -14,6 +14,9 @@
 #include <gtest/gtest.h> // Testing framework
 #include "rclcpp/rclcpp.hpp"
 #include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
 
 #include "voltron_test_utils/TestPublisher.hpp"
 #include "voltron_test_utils/TestSubscriber.hpp"
@@ -74,3 +77,29 @@ TEST_F(TestCanInterfaceNode, test_outgoing_frame) {
   ASSERT_EQ(received_message->get_identifier(), 0x123u);
   ASSERT_EQ(received_message->get_data(), 0x12345678u);
 }
+
+// Needs a second bus, vcan1, as well
+TEST(TestCanInterfaceNodeBuses, test_bridged_frame) {
+  rclcpp::init(0, nullptr);
+  {
+    rclcpp::NodeOptions options;
+    options.parameter_overrides({
+	{ "interface_names", std::vector<std::string>{ "vcan0", "vcan1" } },
+	{ "vcan0.bridge_to", std::vector<std::string>{ "vcan1" } },
+	{ "vcan0.bridged_ids", std::vector<int64_t>{ 0x292 } } });
+    auto interface_node = std::make_shared<CanInterfaceNode>(options);
+    CanBus source("vcan0");
+    CanBus destination("vcan1");
+
+    source.write_frame(CanFrame(0x123, 0x1));
+    source.write_frame(CanFrame(0x292, 0x12345678));
+    // Bridged frames don't wait for the node to be spun
+    ASSERT_TRUE(destination.wait_for_frame(std::chrono::milliseconds(100)));
+    std::unique_ptr<CanFrame> bridged = destination.read_frame();
+    ASSERT_EQ(bridged->get_identifier(), 0x292u);
+    ASSERT_EQ(bridged->get_data(), 0x12345678u);
+    // Only the bridged identifier crosses over
+    ASSERT_FALSE(destination.wait_for_frame(std::chrono::milliseconds(20)));
+  }
+  rclcpp::shutdown();
+}
@@ -0,0 +1,113 @@
+/*
+ * Package:   can_interface
+ * Filename:  test_can_log.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// Test writing, reading and replaying CAN logs. The replay test needs
+// a CAN bus named vcan0, like the CanBus tests.
+
+#include <chrono> // Timestamps
+#include <cstdio> // std::remove
+#include <gtest/gtest.h> // Testing framework
+#include <vector>
+
+#include "can_interface/CanBus.hpp"
+#include "can_interface/CanFrame.hpp"
+#include "can_interface/CanLog.hpp" // The classes we are testing
+
+using namespace navigator::can_interface;
+
+const char * log_path = "test_can_log.bin";
+
+// Frame i has identifier i % 0x800, data i and a stamp i microseconds
+// after the epoch
+static void write_test_frames(CanLogWriter & log, std::size_t first, std::size_t count) {
+  std::vector<struct can_frame> frames(count);
+  std::vector<ReceiveTimestamp> stamps(count);
+  for(std::size_t i = 0; i < count; i++) {
+    CanFrame(((first + i) % 0x800), first + i).to_system_frame(frames[i]);
+    stamps[i].kernel = std::chrono::system_clock::time_point
+      (std::chrono::microseconds(first + i));
+  }
+  log.append(frames.data(), stamps.data(), count);
+}
+
+// Enough frames to spill over several index blocks
+TEST(TestCanLog, test_round_trip) {
+  const std::size_t count = 3 * CanLogWriter::CHUNK_FRAMES + 17;
+  {
+    CanLogWriter log(log_path);
+    write_test_frames(log, 0, 1000);
+    write_test_frames(log, 1000, count - 1000);
+    ASSERT_EQ(log.frame_count(), count);
+  }
+
+  CanLogReader log(log_path);
+  ASSERT_EQ(log.size(), count);
+  for(std::size_t i = 0; i < count; i++) {
+    struct can_frame frame;
+    log[i].to_system_frame(frame);
+    ASSERT_EQ(CanFrame(frame).get_identifier(), i % 0x800);
+    ASSERT_EQ(CanFrame(frame).get_data(), i);
+    ASSERT_EQ(log[i].timestamp_ns, (int64_t) i * 1000);
+  }
+
+  ASSERT_EQ(log.seek(0), 0u);
+  ASSERT_EQ(log.seek(5000 * 1000), 5000u);
+  ASSERT_EQ(log.seek(5000 * 1000 + 1), 5001u);
+  ASSERT_EQ(log.seek(1000000000), count);
+  std::remove(log_path);
+}
+
+// A log still being written, or never closed, should read up to the
+// last frame in it
+TEST(TestCanLog, test_reads_unclosed_log) {
+  CanLogWriter writer(log_path);
+  write_test_frames(writer, 0, CanLogWriter::CHUNK_FRAMES + 5);
+  CanLogReader log(log_path);
+  ASSERT_EQ(log.size(), CanLogWriter::CHUNK_FRAMES + 5);
+  writer.close();
+  std::remove(log_path);
+}
+
+TEST(TestCanLog, test_rejects_other_files) {
+  { CanLogWriter log(log_path); }
+  FILE * file = fopen(log_path, "r+");
+  fputs("not a log", file);
+  fclose(file);
+  ASSERT_THROW(CanLogReader log(log_path), std::runtime_error);
+  std::remove(log_path);
+}
+
+// Frames replayed at speed should keep their order and roughly their
+// spacing
+TEST(TestCanLog, test_replay) {
+  {
+    CanLogWriter log(log_path);
+    write_test_frames(log, 0, 4);
+    std::vector<struct can_frame> frames(1);
+    std::vector<ReceiveTimestamp> stamps(1);
+    CanFrame(0x123, 0xAB).to_system_frame(frames[0]);
+    stamps[0].kernel = std::chrono::system_clock::time_point(std::chrono::milliseconds(40));
+    log.append(frames.data(), stamps.data(), 1);
+  }
+  CanLogReader log(log_path);
+  CanBus sender("vcan0");
+  CanBus receiver("vcan0");
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(replay_log(log, sender, 2.0, 0, log.size()), 5u);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_GE(elapsed, std::chrono::milliseconds(19)); // 40ms at double speed
+  ASSERT_LT(elapsed, std::chrono::milliseconds(200));
+
+  struct can_frame incoming[8];
+  ASSERT_EQ(receiver.read_frames(incoming, NULL, 8), 5u);
+  ASSERT_EQ(CanFrame(incoming[4]).get_identifier(), 0x123u);
+  ASSERT_EQ(CanFrame(incoming[4]).get_data(), 0xABu);
+  std::remove(log_path);
+}
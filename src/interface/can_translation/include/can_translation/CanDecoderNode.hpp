@@ -0,0 +1,50 @@
+/*
+ * Package:   can_translation
+ * Filename:  include/can_translation/CanDecoderNode.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+// Decodes every signal in a table from one subscription to the bus, as
+// a single node in place of a FloatReporterNode per signal
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "std_msgs/msg/float32.hpp"
+
+#include "can_translation/signal_definition.hpp"
+#include "nova_msgs/msg/can_frame.hpp"
+
+namespace navigator {
+namespace can_translation {
+
+class CanDecoderNode : public rclcpp::Node {
+public:
+  CanDecoderNode(); // Reads the table named by the signal_table parameter
+  CanDecoderNode(std::vector<signal_definition> signals);
+  virtual ~CanDecoderNode();
+
+private:
+  void process_frame(const nova_msgs::msg::CanFrame::SharedPtr msg);
+  void init();
+
+  struct decoded_signal {
+    signal_definition definition;
+    rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr publisher;
+  };
+  std::vector<decoded_signal> signals;
+
+  // The signals in each message, so a frame only costs one lookup
+  std::unordered_map<can_id_t, std::vector<std::size_t>> signals_by_id;
+
+  rclcpp::Subscription<nova_msgs::msg::CanFrame>::SharedPtr can_subscription;
+};
+
+}
+}
@@ -9,11 +9,15 @@
 
 #pragma once
 
+#include <optional>
+
 #include "rclcpp/rclcpp.hpp"
 #include "std_msgs/msg/float32.hpp"
 
 #include "can_translation/float_reporter_params.hpp"
+#include "can_translation/publish_policy.hpp"
 #include "nova_msgs/msg/can_frame.hpp"
+#include "nova_msgs/msg/signal_batch.hpp"
 
 namespace navigator {
 namespace can_translation {
@@ -21,17 +25,30 @@ namespace can_translation {
 class FloatReporterNode : public rclcpp::Node {
 public:
   FloatReporterNode();
-  FloatReporterNode(float_reporter_params params);
+  FloatReporterNode(float_reporter_params params, publish_policy policy = {});
   virtual ~FloatReporterNode();
 
 private:
   void process_frame(const nova_msgs::msg::CanFrame::SharedPtr msg);
+  void flush();
+  void publish_latest();
   void init();
 
+  // In batch mode only batch_publisher is created, on
+  // can_translation_result_batch_topic
   rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr result_publisher;
+  rclcpp::Publisher<nova_msgs::msg::SignalBatch>::SharedPtr batch_publisher;
   rclcpp::Subscription<nova_msgs::msg::CanFrame>::SharedPtr can_subscription;
+  rclcpp::TimerBase::SharedPtr flush_timer;
 
   float_reporter_params params;
+  publish_policy policy;
+  std::optional<SignalThrottle> throttle;
+
+  // input_min to input_max mapped onto output_min to output_max, as
+  // one multiply-add
+  double scale;
+  double offset;
 };
 
 }
@@ -0,0 +1,92 @@
+/*
+ * Package:   can_translation
+ * Filename:  include/can_translation/Signal.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+// Pulling fields out of CAN data. Signal does it for a field fixed at
+// compile time, with the shift and mask folded into constants, and
+// the free functions do the same thing for fields only known at run
+// time. Bit numbering follows signal_definition.hpp.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "can_translation/types.hpp"
+
+namespace navigator {
+namespace can_translation {
+
+// The low length_bits bits, for any length from 0 to 64
+constexpr can_data_t field_mask(unsigned length_bits) {
+  return length_bits >= 64 ? ~can_data_t(0) : (can_data_t(1) << length_bits) - 1;
+}
+
+// How far to shift a field down to bring it to bit 0. Big-endian
+// fields are shifted out of the byte-swapped data, where they are
+// contiguous.
+constexpr unsigned field_shift(unsigned start_bit, unsigned length_bits, bool big_endian) {
+  return big_endian ? 64 - ((start_bit / 8) * 8 + (7 - start_bit % 8)) - length_bits : start_bit;
+}
+
+// The field's raw, unsigned bits
+constexpr can_data_t extract_field(can_data_t data, unsigned start_bit,
+				   unsigned length_bits, bool big_endian) {
+  if(big_endian) data = __builtin_bswap64(data);
+  return (data >> field_shift(start_bit, length_bits, big_endian)) & field_mask(length_bits);
+}
+
+// A field's raw bits as a number, sign-extended if it is signed
+constexpr double field_value(can_data_t raw, unsigned length_bits, bool is_signed) {
+  if(!is_signed) return (double) raw;
+  can_data_t sign_bit = can_data_t(1) << (length_bits - 1);
+  return (double) (int64_t) ((raw ^ sign_bit) - sign_bit);
+}
+
+template <unsigned StartBit, unsigned LengthBits, double Scale = 1.0, double Offset = 0.0,
+	  bool BigEndian = false, bool Signed = false>
+struct Signal {
+  static_assert(LengthBits >= 1 && LengthBits <= 64, "Signals are 1 to 64 bits long");
+  static_assert(StartBit < 64 &&
+		(BigEndian ? (StartBit / 8) * 8 + (7 - StartBit % 8) : StartBit) + LengthBits <= 64,
+		"Signal runs off the end of the frame");
+
+  static constexpr can_data_t mask = field_mask(LengthBits);
+  static constexpr unsigned shift = field_shift(StartBit, LengthBits, BigEndian);
+
+  static constexpr can_data_t raw(can_data_t data) {
+    return extract_field(data, StartBit, LengthBits, BigEndian);
+  }
+
+  static constexpr double decode(can_data_t data) {
+    return field_value(raw(data), LengthBits, Signed) * Scale + Offset;
+  }
+};
+
+// Eight bytes of a CAN FD payload from byte on, packed the way a
+// classic frame's data is. A Signal numbered from that byte decodes
+// straight out of it, so FD payloads need no copying or allocation
+// either. Bytes past the payload's length read as zero.
+inline can_data_t fd_window(const uint8_t * data, std::size_t length, std::size_t byte) {
+  can_data_t window = 0;
+  if(byte < length) memcpy(&window, data + byte, std::min<std::size_t>(8, length - byte));
+  return window;
+}
+
+// Decode every signal in a message in one go, e.g.
+//   auto [speed, angle] = decode_signals<Speed, Angle>(frame.data);
+template <typename... Signals>
+constexpr std::array<double, sizeof...(Signals)> decode_signals(can_data_t data) {
+  return { Signals::decode(data)... };
+}
+
+}
+}
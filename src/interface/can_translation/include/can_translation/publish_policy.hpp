@@ -0,0 +1,94 @@
+/*
+ * Package:   can_translation
+ * Filename:  include/can_translation/publish_policy.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+// Deciding when a decoded signal is worth publishing. Most signals
+// arrive far faster than anything downstream needs them, and barely
+// change from one frame to the next, so a reporter can publish:
+//
+//   every_frame  every value, as it arrives (the default)
+//   on_change    only values that moved more than the deadband from
+//                the last one published, plus the latest value once
+//                per period if a period is set and nothing was sent
+//   max_rate     the latest value once per period, if one arrived
+//   batch        every (stamp, value) pair, as one array per period
+//
+// The throttle only keeps the books. The node calls sample() for each
+// value and flush() from a timer running at the period, and publishes
+// whenever either returns true. Stamps are in nanoseconds on whatever
+// clock the node uses.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace navigator {
+namespace can_translation {
+
+enum class publish_mode { every_frame, on_change, max_rate, batch };
+
+struct publish_policy {
+  publish_mode mode = publish_mode::every_frame;
+  double deadband = 0.0; // on_change only, in output units
+  double period = 0.0; // Seconds; required by max_rate and batch
+};
+
+// "every_frame", "on_change", "max_rate" or "batch". Throws
+// std::invalid_argument for anything else.
+publish_mode parse_publish_mode(const std::string & name);
+
+// Throws std::invalid_argument if the policy can't be followed, e.g.
+// batching without a period
+void validate_publish_policy(const publish_policy & policy);
+
+struct stamped_value {
+  int64_t stamp;
+  double value;
+};
+
+class SignalThrottle {
+public:
+  explicit SignalThrottle(const publish_policy & policy);
+
+  // A value arrived. Returns true if it should be published right
+  // away. In max_rate and batch mode it is held for flush() instead,
+  // and this is always false.
+  bool sample(int64_t stamp, double value);
+
+  // The period elapsed. Returns true if there is something to publish:
+  // the latest value in on_change and max_rate, or the queued batch,
+  // which the caller then takes.
+  bool flush(int64_t stamp);
+
+  // Whether the node needs to call flush() on a timer
+  bool needs_timer() const;
+
+  double latest() const { return this->latest_value; }
+  std::vector<stamped_value> take_batch();
+
+private:
+  void mark_published(int64_t stamp);
+
+  publish_policy policy;
+  int64_t period_ns;
+
+  bool have_value = false;
+  bool pending = false; // latest_value hasn't been published yet
+  double latest_value = 0.0;
+
+  bool have_published = false;
+  int64_t last_publish_stamp = 0;
+  double last_published_value = 0.0;
+
+  std::vector<stamped_value> batch;
+};
+
+}
+}
@@ -0,0 +1,50 @@
+/*
+ * Package:   can_translation
+ * Filename:  include/can_translation/signal_definition.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "can_translation/types.hpp"
+
+namespace navigator {
+namespace can_translation {
+
+// One signal packed into a CAN message, described the way a DBC file
+// describes it. Bits are numbered byte * 8 + bit, with bit 0 the least
+// significant bit of byte 0. For little-endian (Intel) signals the
+// start bit is the signal's least significant bit, for big-endian
+// (Motorola) signals it is the most significant.
+struct signal_definition {
+  std::string name; // Also the topic the signal is published on
+  can_id_t message_id;
+  uint8_t start_bit;
+  uint8_t length_bits;
+  bool big_endian;
+  bool is_signed;
+  double scale;
+  double offset;
+};
+
+// Pull the signal out of a frame's data and scale it
+double decode_signal(const signal_definition & signal, can_data_t data);
+
+// Read a table of signals, one per line:
+//
+//   # name               id     start length order  sign     scale offset
+//   real_steering_angle  0x292  0     16     little unsigned 0.1   -3276.8
+//
+// Everything after a # is ignored. This is the same information as a
+// DBC file's SG_ lines, so a table can be generated from one.
+std::vector<signal_definition> load_signal_table(const std::string & path);
+
+}
+}
@@ -0,0 +1,64 @@
+/*
+ * Package:   can_translation
+ * Filename:  src/CanDecoderNode.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "std_msgs/msg/float32.hpp"
+
+#include "nova_msgs/msg/can_frame.hpp"
+#include "can_translation/CanDecoderNode.hpp"
+
+using namespace navigator::can_translation;
+
+CanDecoderNode::CanDecoderNode() : rclcpp::Node("can_decoder") {
+  this->declare_parameter("signal_table");
+  for(signal_definition & definition :
+	load_signal_table(this->get_parameter("signal_table").as_string())) {
+    this->signals.push_back({ std::move(definition), nullptr });
+  }
+  this->init();
+}
+
+CanDecoderNode::CanDecoderNode(std::vector<signal_definition> signals)
+  : rclcpp::Node("can_decoder") {
+  for(signal_definition & definition : signals) {
+    this->signals.push_back({ std::move(definition), nullptr });
+  }
+  this->init();
+}
+
+CanDecoderNode::~CanDecoderNode() {}
+
+// Called every time a can frame arrives on the bus
+void CanDecoderNode::process_frame(const nova_msgs::msg::CanFrame::SharedPtr incoming_frame) {
+  auto found = this->signals_by_id.find(incoming_frame->identifier);
+  if(found == this->signals_by_id.end()) return; // Nothing we decode
+
+  for(std::size_t index : found->second) {
+    const decoded_signal & signal = this->signals[index];
+    auto message = std_msgs::msg::Float32();
+    message.data = (float) decode_signal(signal.definition, incoming_frame->data);
+    signal.publisher->publish(message);
+  }
+}
+
+void CanDecoderNode::init() {
+  for(std::size_t i = 0; i < this->signals.size(); i++) {
+    decoded_signal & signal = this->signals[i];
+    signal.publisher = this->create_publisher<std_msgs::msg::Float32>
+      (signal.definition.name, 8);
+    this->signals_by_id[signal.definition.message_id].push_back(i);
+  }
+  this->can_subscription = this->create_subscription<nova_msgs::msg::CanFrame>
+    ("can_translation_incoming_can_frames", 8,
+     std::bind(& CanDecoderNode::process_frame, this, std::placeholders::_1));
+}
@@ -7,6 +7,7 @@
  * License:   MIT License
  */
 
+#include <chrono>
 #include <string>
 #include <stdexcept>
 
@@ -14,7 +15,9 @@
 #include "std_msgs/msg/float32.hpp"
 
 #include "nova_msgs/msg/can_frame.hpp"
+#include "nova_msgs/msg/signal_batch.hpp"
 #include "can_translation/FloatReporterNode.hpp"
+#include "can_translation/Signal.hpp"
 
 using namespace navigator::can_translation;
 
@@ -33,12 +36,18 @@ FloatReporterNode::FloatReporterNode() : rclcpp::Node("float_reporter") {
   this->params.field_start_bit = this->get_parameter("field_start_bit").as_int();
   this->declare_parameter("field_length_bits");
   this->params.field_length_bits = this->get_parameter("field_length_bits").as_int();
+  // How often to publish; see publish_policy.hpp
+  this->policy.mode = parse_publish_mode
+    (this->declare_parameter<std::string>("publish_mode", "every_frame"));
+  this->policy.deadband = this->declare_parameter<double>("publish_deadband", 0.0);
+  this->policy.period = this->declare_parameter<double>("publish_period", 0.0);
   this->init();
 }
 
-FloatReporterNode::FloatReporterNode(float_reporter_params params)
+FloatReporterNode::FloatReporterNode(float_reporter_params params, publish_policy policy)
   : rclcpp::Node("float_reporter") {
   this->params = params;
+  this->policy = policy;
   this->init();
 }
 
@@ -49,28 +58,58 @@ void FloatReporterNode::process_frame(const nova_msgs::msg::CanFrame::SharedPtr
   if(incoming_frame->identifier != this->params.message_id) return; // Skip frames not meant for us
 
   // Isolate the field we're interested in
-  can_data_t data_int = incoming_frame->data;
+  can_data_t data_int = extract_field(incoming_frame->data, this->params.field_start_bit,
+				      this->params.field_length_bits, false);
 
-  data_int = data_int >> this->params.field_start_bit;
-  if(this->params.field_length_bits < 64) {
-    data_int = data_int & ((1 << this->params.field_length_bits) - 1);
-  }
+  // Do the calculation with double precision to handle large numbers
+  double data = (double) data_int * this->scale + this->offset;
+
+  if(this->throttle->sample(this->now().nanoseconds(), data)) this->publish_latest();
+}
 
-  double data = (double) data_int; // Do the calculation with double precision to handle large numbers
-  data = data - this->params.input_min; // Scaled from 0 to 1
-  data = data / (this->params.input_max - this->params.input_min);
-  data = data * (this->params.output_max - this->params.output_min); // Then rescale between output_min and output_max
-  data = data + this->params.output_min;
+// Called once per publish period, for every mode but every_frame
+void FloatReporterNode::flush() {
+  if(!this->throttle->flush(this->now().nanoseconds())) return;
+  if(!this->batch_publisher) {
+    this->publish_latest();
+    return;
+  }
 
+  auto message = nova_msgs::msg::SignalBatch();
+  for(const stamped_value & sample : this->throttle->take_batch()) {
+    message.stamps.push_back(rclcpp::Time(sample.stamp, this->get_clock()->get_clock_type()));
+    message.values.push_back((float) sample.value);
+  }
+  this->batch_publisher->publish(message);
+}
 
+void FloatReporterNode::publish_latest() {
   auto message = std_msgs::msg::Float32(); // Send the message
-  message.data = (float) data;
+  message.data = (float) this->throttle->latest();
   this->result_publisher->publish(message);
 }
 
 void FloatReporterNode::init() {
-  this->result_publisher = this->create_publisher<std_msgs::msg::Float32>
-    ("can_translation_result_topic", 8);
+  this->scale = (this->params.output_max - this->params.output_min) /
+    ((double) this->params.input_max - (double) this->params.input_min);
+  this->offset = this->params.output_min - this->params.input_min * this->scale;
+
+  this->throttle.emplace(this->policy); // Throws on a bad policy
+
+  if(this->policy.mode == publish_mode::batch) {
+    this->batch_publisher = this->create_publisher<nova_msgs::msg::SignalBatch>
+      ("can_translation_result_batch_topic", 8);
+  } else {
+    this->result_publisher = this->create_publisher<std_msgs::msg::Float32>
+      ("can_translation_result_topic", 8);
+  }
+  if(this->throttle->needs_timer()) {
+    this->flush_timer = this->create_wall_timer
+      (std::chrono::duration_cast<std::chrono::nanoseconds>
+       (std::chrono::duration<double>(this->policy.period)),
+       std::bind(& FloatReporterNode::flush, this));
+  }
+
   this->can_subscription = this->create_subscription<nova_msgs::msg::CanFrame>
     ("can_translation_incoming_can_frames", 8,
      std::bind(& FloatReporterNode::process_frame, this, std::placeholders::_1));
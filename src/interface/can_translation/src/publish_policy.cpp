@@ -0,0 +1,119 @@
+/*
+ * Package:   can_translation
+ * Filename:  src/publish_policy.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#include <cmath> // std::abs, std::llround
+#include <stdexcept>
+#include <string>
+#include <utility> // std::swap
+#include <vector>
+
+#include "can_translation/publish_policy.hpp"
+
+using namespace navigator::can_translation;
+
+publish_mode navigator::can_translation::parse_publish_mode(const std::string & name) {
+  if(name == "every_frame") return publish_mode::every_frame;
+  if(name == "on_change") return publish_mode::on_change;
+  if(name == "max_rate") return publish_mode::max_rate;
+  if(name == "batch") return publish_mode::batch;
+  throw std::invalid_argument("Unknown publish mode: " + name);
+}
+
+void navigator::can_translation::validate_publish_policy(const publish_policy & policy) {
+  if(!(policy.deadband >= 0.0)) {
+    throw std::invalid_argument("Publish deadband must not be negative");
+  }
+  if(!(policy.period >= 0.0)) {
+    throw std::invalid_argument("Publish period must not be negative");
+  }
+  if((policy.mode == publish_mode::max_rate || policy.mode == publish_mode::batch)
+     && policy.period <= 0.0) {
+    throw std::invalid_argument("max_rate and batch publishing need a period");
+  }
+}
+
+SignalThrottle::SignalThrottle(const publish_policy & policy)
+  : policy(policy), period_ns(std::llround(policy.period * 1e9)) {
+  validate_publish_policy(policy);
+}
+
+bool SignalThrottle::needs_timer() const {
+  return this->policy.mode != publish_mode::every_frame && this->period_ns > 0;
+}
+
+bool SignalThrottle::sample(int64_t stamp, double value) {
+  this->have_value = true;
+  this->latest_value = value;
+
+  switch(this->policy.mode) {
+  case publish_mode::every_frame:
+    this->mark_published(stamp);
+    return true;
+
+  case publish_mode::on_change:
+    // Compare against the last value sent rather than the last one
+    // received, so that a slow drift still gets through once it adds
+    // up to more than the deadband
+    if(this->have_published &&
+       std::abs(value - this->last_published_value) <= this->policy.deadband) {
+      return false;
+    }
+    this->mark_published(stamp);
+    return true;
+
+  case publish_mode::max_rate:
+    // Held for the next flush(), which keeps the rate at one value per
+    // period however the frames and the timer line up
+    this->pending = true;
+    return false;
+
+  case publish_mode::batch:
+    this->batch.push_back(stamped_value { stamp, value });
+    return false;
+  }
+  return false;
+}
+
+bool SignalThrottle::flush(int64_t stamp) {
+  switch(this->policy.mode) {
+  case publish_mode::every_frame:
+    return false;
+
+  case publish_mode::on_change:
+    // Keepalive, so that late subscribers and watchdogs still hear
+    // about a signal that holds steady
+    if(this->period_ns <= 0 || !this->have_value) return false;
+    if(this->have_published && stamp - this->last_publish_stamp < this->period_ns) return false;
+    this->mark_published(stamp);
+    return true;
+
+  case publish_mode::max_rate:
+    if(!this->pending) return false;
+    this->mark_published(stamp);
+    return true;
+
+  case publish_mode::batch:
+    return !this->batch.empty();
+  }
+  return false;
+}
+
+std::vector<stamped_value> SignalThrottle::take_batch() {
+  std::vector<stamped_value> result;
+  result.reserve(this->batch.capacity());
+  std::swap(result, this->batch);
+  return result;
+}
+
+void SignalThrottle::mark_published(int64_t stamp) {
+  this->pending = false;
+  this->have_published = true;
+  this->last_publish_stamp = stamp;
+  this->last_published_value = this->latest_value;
+}
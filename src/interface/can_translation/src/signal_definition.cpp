@@ -0,0 +1,62 @@
+/*
+ * Package:   can_translation
+ * Filename:  src/signal_definition.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "can_translation/Signal.hpp"
+#include "can_translation/signal_definition.hpp"
+
+using namespace navigator::can_translation;
+
+double navigator::can_translation::decode_signal(const signal_definition & signal,
+						 can_data_t data) {
+  can_data_t raw = extract_field(data, signal.start_bit, signal.length_bits, signal.big_endian);
+  return field_value(raw, signal.length_bits, signal.is_signed) * signal.scale + signal.offset;
+}
+
+std::vector<signal_definition> navigator::can_translation::load_signal_table
+(const std::string & path) {
+  std::ifstream file(path);
+  if(!file) throw std::runtime_error("Could not open signal table " + path);
+
+  std::vector<signal_definition> signals;
+  std::string line;
+  for(int line_number = 1; std::getline(file, line); line_number++) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::string name, id, order, sign;
+    int start_bit, length_bits;
+    double scale, offset;
+    if(!(fields >> name)) continue; // Blank or comment
+
+    auto error = [&](const std::string & what) {
+      return std::runtime_error(path + ":" + std::to_string(line_number) + ": " + what);
+    };
+    if(!(fields >> id >> start_bit >> length_bits >> order >> sign >> scale >> offset)) {
+      throw error("expected name, id, start bit, length, byte order, sign, scale and offset");
+    }
+    if(order != "little" && order != "big") throw error("byte order must be little or big");
+    if(sign != "signed" && sign != "unsigned") throw error("sign must be signed or unsigned");
+    if(start_bit < 0 || start_bit > 63 || length_bits < 1 || length_bits > 64) {
+      throw error("signal does not fit in 64 bits");
+    }
+    bool big_endian = order == "big";
+    int first_bit = big_endian ? (start_bit / 8) * 8 + (7 - start_bit % 8) : start_bit;
+    if(first_bit + length_bits > 64) throw error("signal runs off the end of the frame");
+
+    signals.push_back(signal_definition {
+	name, (can_id_t) std::stoul(id, nullptr, 0), (uint8_t) start_bit,
+	(uint8_t) length_bits, big_endian, sign == "signed", scale, offset });
+  }
+  return signals;
+}
@@ -0,0 +1,129 @@
+/*
+ * Package:   can_translation
+ * Filename:  test/test_can_decoder.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#include <cstdio> // std::remove
+#include <fstream> // Writing a table to load
+#include <gtest/gtest.h> // Testing framework
+#include <memory> // std::make_shared
+#include <stdexcept>
+
+#include "rclcpp/rclcpp.hpp" // To control the node
+#include "std_msgs/msg/float32.hpp"
+
+#include "nova_msgs/msg/can_frame.hpp" // CAN messages
+#include "voltron_test_utils/TestSubscriber.hpp"
+#include "voltron_test_utils/TestPublisher.hpp"
+
+#include "can_translation/CanDecoderNode.hpp"
+#include "can_translation/signal_definition.hpp"
+
+using namespace Voltron::TestUtils;
+using namespace navigator::can_translation;
+
+// Little-endian signals are read up from their least significant bit
+TEST(TestDecodeSignal, test_little_endian) {
+  signal_definition signal { "a", 0x1, 8, 16, false, false, 1, 0 };
+  ASSERT_DOUBLE_EQ(decode_signal(signal, 0x0000000000ABCD12), 0xABCD);
+  signal.scale = 0.5;
+  signal.offset = -10;
+  ASSERT_DOUBLE_EQ(decode_signal(signal, 0x0000000000000A00), 5 - 10);
+}
+
+// Big-endian signals start at their most significant bit. Bit 7 is the
+// top of byte 0, so a 16-bit signal there is bytes 0 and 1 in order.
+TEST(TestDecodeSignal, test_big_endian) {
+  signal_definition signal { "a", 0x1, 7, 16, true, false, 1, 0 };
+  ASSERT_DOUBLE_EQ(decode_signal(signal, 0x000000000000CDAB), 0xABCD);
+  signal.start_bit = 3; // Low nibble of byte 0, then the top of byte 1
+  signal.length_bits = 8;
+  ASSERT_DOUBLE_EQ(decode_signal(signal, 0x0000000000005A0B), 0xB5);
+}
+
+TEST(TestDecodeSignal, test_signed) {
+  signal_definition signal { "a", 0x1, 0, 12, false, true, 1, 0 };
+  ASSERT_DOUBLE_EQ(decode_signal(signal, 0x0000000000000FFF), -1);
+  ASSERT_DOUBLE_EQ(decode_signal(signal, 0x00000000000007FF), 2047);
+  signal.length_bits = 64;
+  ASSERT_DOUBLE_EQ(decode_signal(signal, 0xFFFFFFFFFFFFFFFE), -2);
+}
+
+TEST(TestSignalTable, test_loads) {
+  const char * path = "test_signal_table.txt";
+  {
+    std::ofstream table(path);
+    table << "# name id start length order sign scale offset\n"
+	  << "\n"
+	  << "speed 0x123 0 16 little unsigned 0.01 0 # km/h\n"
+	  << "angle 0x292 7 16 big signed 0.1 -5\n";
+  }
+  auto signals = load_signal_table(path);
+  ASSERT_EQ(signals.size(), 2u);
+  ASSERT_EQ(signals[0].name, "speed");
+  ASSERT_EQ(signals[0].message_id, 0x123u);
+  ASSERT_FALSE(signals[0].big_endian);
+  ASSERT_DOUBLE_EQ(signals[0].scale, 0.01);
+  ASSERT_EQ(signals[1].start_bit, 7);
+  ASSERT_TRUE(signals[1].big_endian);
+  ASSERT_TRUE(signals[1].is_signed);
+  ASSERT_DOUBLE_EQ(signals[1].offset, -5);
+
+  {
+    std::ofstream table(path);
+    table << "speed 0x123 60 16 little unsigned 1 0\n";
+  }
+  ASSERT_THROW(load_signal_table(path), std::runtime_error);
+  std::remove(path);
+}
+
+class TestCanDecoder : public ::testing::Test {
+protected:
+  void SetUp() override {
+    rclcpp::init(0, nullptr);
+    speed_subscription = std::make_unique<TestSubscriber<
+      std_msgs::msg::Float32>>("speed");
+    angle_subscription = std::make_unique<TestSubscriber<
+      std_msgs::msg::Float32>>("angle");
+    can_publisher = std::make_unique<TestPublisher<
+      nova_msgs::msg::CanFrame>>("can_translation_incoming_can_frames");
+  }
+
+  void TearDown() override {
+    rclcpp::shutdown();
+  }
+
+  std::unique_ptr<TestSubscriber<std_msgs::msg::Float32>> speed_subscription;
+  std::unique_ptr<TestSubscriber<std_msgs::msg::Float32>> angle_subscription;
+  std::unique_ptr<TestPublisher<nova_msgs::msg::CanFrame>> can_publisher;
+};
+
+// Both signals in one message should come out of one frame, and
+// frames for other messages should be ignored
+TEST_F(TestCanDecoder, test_decodes_each_signal) {
+  auto decoder = std::make_shared<CanDecoderNode>(std::vector<signal_definition> {
+      { "speed", 0x123, 0, 16, false, false, 0.5, 0 },
+      { "angle", 0x123, 16, 8, false, true, 1, 0 } });
+
+  auto other = nova_msgs::msg::CanFrame();
+  other.identifier = 0x124;
+  other.data = 0x0000000000FF0064;
+  can_publisher->send_message(other);
+  rclcpp::spin_some(decoder);
+  ASSERT_FALSE(speed_subscription->has_message_ready());
+  ASSERT_FALSE(angle_subscription->has_message_ready());
+
+  auto frame = nova_msgs::msg::CanFrame();
+  frame.identifier = 0x123;
+  frame.data = 0x0000000000FF0064;
+  can_publisher->send_message(frame);
+  rclcpp::spin_some(decoder);
+  ASSERT_TRUE(speed_subscription->has_message_ready());
+  ASSERT_TRUE(angle_subscription->has_message_ready());
+  EXPECT_FLOAT_EQ(speed_subscription->get_message()->data, 50);
+  EXPECT_FLOAT_EQ(angle_subscription->get_message()->data, -1);
+}
@@ -227,3 +227,29 @@ TEST_F(TestFloatReporter, test_handles_max_data) {
   ASSERT_TRUE(angle_subscription->has_message_ready());
   EXPECT_FLOAT_EQ(angle_subscription->get_message()->data, 1);
 }
+
+// Test that on_change publishing drops values inside the deadband
+TEST_F(TestFloatReporter, test_on_change_skips_repeats) {
+  auto my_reporter = std::make_shared<FloatReporterNode>(
+    float_reporter_params { 0, 65535, 0, 65535, 0x001, 0, 16, },
+    publish_policy { publish_mode::on_change, 5.0, 0.0 });
+  auto message_to_send = nova_msgs::msg::CanFrame();
+  message_to_send.identifier = 0x001;
+
+  message_to_send.data = 0x0000000000004E20; // 20000
+  can_publisher->send_message(message_to_send);
+  rclcpp::spin_some(my_reporter);
+  ASSERT_TRUE(angle_subscription->has_message_ready());
+  EXPECT_FLOAT_EQ(angle_subscription->get_message()->data, 20000);
+
+  message_to_send.data = 0x0000000000004E23; // 20003, inside the deadband
+  can_publisher->send_message(message_to_send);
+  rclcpp::spin_some(my_reporter);
+  ASSERT_FALSE(angle_subscription->has_message_ready());
+
+  message_to_send.data = 0x0000000000004E2A; // 20010
+  can_publisher->send_message(message_to_send);
+  rclcpp::spin_some(my_reporter);
+  ASSERT_TRUE(angle_subscription->has_message_ready());
+  EXPECT_FLOAT_EQ(angle_subscription->get_message()->data, 20010);
+}
@@ -0,0 +1,112 @@
+/*
+ * Package:   can_translation
+ * Filename:  test/test_publish_policy.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#include <gtest/gtest.h> // Testing framework
+#include <stdexcept>
+
+#include "can_translation/publish_policy.hpp"
+
+using namespace navigator::can_translation;
+
+constexpr int64_t ms = 1000000; // Stamps are in nanoseconds
+
+TEST(PublishPolicy, test_parses_modes) {
+  EXPECT_EQ(parse_publish_mode("every_frame"), publish_mode::every_frame);
+  EXPECT_EQ(parse_publish_mode("on_change"), publish_mode::on_change);
+  EXPECT_EQ(parse_publish_mode("max_rate"), publish_mode::max_rate);
+  EXPECT_EQ(parse_publish_mode("batch"), publish_mode::batch);
+  EXPECT_THROW(parse_publish_mode("sometimes"), std::invalid_argument);
+}
+
+TEST(PublishPolicy, test_rejects_missing_period) {
+  EXPECT_THROW(SignalThrottle(publish_policy { publish_mode::max_rate, 0.0, 0.0 }),
+	       std::invalid_argument);
+  EXPECT_THROW(SignalThrottle(publish_policy { publish_mode::batch, 0.0, 0.0 }),
+	       std::invalid_argument);
+  EXPECT_THROW(SignalThrottle(publish_policy { publish_mode::on_change, -1.0, 0.0 }),
+	       std::invalid_argument);
+  EXPECT_NO_THROW(SignalThrottle(publish_policy { publish_mode::on_change, 0.5, 0.0 }));
+}
+
+TEST(PublishPolicy, test_every_frame_publishes_everything) {
+  SignalThrottle throttle(publish_policy {});
+  EXPECT_FALSE(throttle.needs_timer());
+  for(int i = 0; i < 5; i++) {
+    EXPECT_TRUE(throttle.sample(i * ms, 1.0));
+    EXPECT_DOUBLE_EQ(throttle.latest(), 1.0);
+  }
+  EXPECT_FALSE(throttle.flush(10 * ms));
+}
+
+TEST(PublishPolicy, test_on_change_applies_deadband) {
+  SignalThrottle throttle(publish_policy { publish_mode::on_change, 0.5, 0.0 });
+  EXPECT_FALSE(throttle.needs_timer());
+  EXPECT_TRUE(throttle.sample(0, 1.0)); // The first value always goes out
+  EXPECT_FALSE(throttle.sample(1 * ms, 1.0));
+  EXPECT_FALSE(throttle.sample(2 * ms, 1.3));
+  EXPECT_FALSE(throttle.sample(3 * ms, 1.5));
+  // Measured from the last value published, so drift adds up
+  EXPECT_TRUE(throttle.sample(4 * ms, 1.6));
+  EXPECT_DOUBLE_EQ(throttle.latest(), 1.6);
+  EXPECT_FALSE(throttle.sample(5 * ms, 1.2));
+  EXPECT_TRUE(throttle.sample(6 * ms, 0.9));
+}
+
+TEST(PublishPolicy, test_on_change_without_deadband_skips_repeats) {
+  SignalThrottle throttle(publish_policy { publish_mode::on_change, 0.0, 0.0 });
+  EXPECT_TRUE(throttle.sample(0, 2.0));
+  EXPECT_FALSE(throttle.sample(1 * ms, 2.0));
+  EXPECT_TRUE(throttle.sample(2 * ms, 2.001));
+}
+
+TEST(PublishPolicy, test_on_change_keepalive) {
+  SignalThrottle throttle(publish_policy { publish_mode::on_change, 0.5, 0.1 });
+  EXPECT_TRUE(throttle.needs_timer());
+  EXPECT_FALSE(throttle.flush(0)); // Nothing to repeat yet
+  EXPECT_TRUE(throttle.sample(0, 1.0));
+  EXPECT_FALSE(throttle.flush(50 * ms)); // Published recently enough
+  EXPECT_FALSE(throttle.sample(60 * ms, 1.1));
+  EXPECT_TRUE(throttle.flush(100 * ms));
+  EXPECT_DOUBLE_EQ(throttle.latest(), 1.1);
+  // The keepalive moves the reference value too
+  EXPECT_FALSE(throttle.sample(110 * ms, 1.5));
+  EXPECT_TRUE(throttle.sample(120 * ms, 1.7));
+}
+
+TEST(PublishPolicy, test_max_rate_keeps_latest) {
+  SignalThrottle throttle(publish_policy { publish_mode::max_rate, 0.0, 0.1 });
+  EXPECT_TRUE(throttle.needs_timer());
+  EXPECT_FALSE(throttle.flush(0)); // Nothing arrived
+  for(int i = 0; i < 10; i++) EXPECT_FALSE(throttle.sample(i * ms, i));
+  EXPECT_TRUE(throttle.flush(100 * ms));
+  EXPECT_DOUBLE_EQ(throttle.latest(), 9);
+  EXPECT_FALSE(throttle.flush(200 * ms)); // Not repeated
+  EXPECT_FALSE(throttle.sample(210 * ms, 3));
+  EXPECT_TRUE(throttle.flush(300 * ms));
+  EXPECT_DOUBLE_EQ(throttle.latest(), 3);
+}
+
+TEST(PublishPolicy, test_batches_every_sample) {
+  SignalThrottle throttle(publish_policy { publish_mode::batch, 0.0, 0.1 });
+  EXPECT_TRUE(throttle.needs_timer());
+  EXPECT_FALSE(throttle.flush(0));
+  for(int i = 0; i < 10; i++) EXPECT_FALSE(throttle.sample(i * ms, i * 0.5));
+  ASSERT_TRUE(throttle.flush(100 * ms));
+
+  auto batch = throttle.take_batch();
+  ASSERT_EQ(batch.size(), 10u);
+  for(int i = 0; i < 10; i++) {
+    EXPECT_EQ(batch[i].stamp, i * ms);
+    EXPECT_DOUBLE_EQ(batch[i].value, i * 0.5);
+  }
+  EXPECT_FALSE(throttle.flush(200 * ms)); // Taken, so nothing left
+  EXPECT_FALSE(throttle.sample(210 * ms, 7.0));
+  ASSERT_TRUE(throttle.flush(300 * ms));
+  EXPECT_EQ(throttle.take_batch().size(), 1u);
+}
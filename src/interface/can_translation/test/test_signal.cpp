@@ -0,0 +1,112 @@
+/*
+ * Package:   can_translation
+ * Filename:  test/test_signal.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#include <gtest/gtest.h> // Testing framework
+#include <utility> // std::integer_sequence
+
+#include "can_translation/Signal.hpp"
+
+using namespace navigator::can_translation;
+
+const can_data_t test_pattern = 0xF0E1D2C3B4A59687;
+
+// The slow, obvious way: walk the field one bit at a time, following
+// the DBC numbering for each byte order
+static can_data_t reference_field(can_data_t data, unsigned start_bit,
+				  unsigned length_bits, bool big_endian) {
+  can_data_t result = 0;
+  unsigned bit = start_bit;
+  for(unsigned i = 0; i < length_bits; i++) {
+    can_data_t value = (data >> bit) & 1;
+    if(big_endian) {
+      // Most significant bit first, running down each byte then on to
+      // the top of the next
+      result = (result << 1) | value;
+      bit = (bit % 8 == 0) ? bit + 15 : bit - 1;
+    } else {
+      result |= value << i;
+      bit++;
+    }
+  }
+  return result;
+}
+
+// Little-endian fields ending on bit 63, and big-endian fields starting
+// on bit 7, are the longest that fit for each length
+template <unsigned Length>
+static void check_length() {
+  EXPECT_EQ((Signal<64 - Length, Length>::raw(test_pattern)),
+	    reference_field(test_pattern, 64 - Length, Length, false))
+    << "little-endian, " << Length << " bits";
+  EXPECT_EQ((Signal<7, Length, 1.0, 0.0, true>::raw(test_pattern)),
+	    reference_field(test_pattern, 7, Length, true))
+    << "big-endian, " << Length << " bits";
+}
+
+template <unsigned... Lengths>
+static void check_all_lengths(std::integer_sequence<unsigned, Lengths...>) {
+  (check_length<Lengths + 1>(), ...);
+}
+
+TEST(TestSignal, test_compile_time_all_lengths) {
+  check_all_lengths(std::make_integer_sequence<unsigned, 64>());
+}
+
+TEST(TestSignal, test_run_time_all_lengths_and_starts) {
+  for(unsigned length = 1; length <= 64; length++) {
+    for(unsigned start = 0; start + length <= 64; start++) {
+      EXPECT_EQ(extract_field(test_pattern, start, length, false),
+		reference_field(test_pattern, start, length, false))
+	<< "little-endian, start " << start << ", " << length << " bits";
+    }
+    for(unsigned start = 0; start < 64; start++) {
+      if((start / 8) * 8 + (7 - start % 8) + length > 64) continue;
+      EXPECT_EQ(extract_field(test_pattern, start, length, true),
+		reference_field(test_pattern, start, length, true))
+	<< "big-endian, start " << start << ", " << length << " bits";
+    }
+  }
+}
+
+// Fields of 32 bits and more used to overflow an int mask
+TEST(TestSignal, test_wide_masks) {
+  EXPECT_EQ(field_mask(31), 0x7FFFFFFFu);
+  EXPECT_EQ(field_mask(32), 0xFFFFFFFFu);
+  EXPECT_EQ(field_mask(33), 0x1FFFFFFFFu);
+  EXPECT_EQ(field_mask(64), ~can_data_t(0));
+  EXPECT_EQ((Signal<0, 32>::raw(test_pattern)), 0xB4A59687u);
+  EXPECT_EQ((Signal<16, 48>::raw(test_pattern)), 0xF0E1D2C3B4A5u);
+}
+
+TEST(TestSignal, test_scaling_and_sign) {
+  static_assert(Signal<0, 8, 0.5, -1.0>::decode(0x10) == 7.0);
+  static_assert(Signal<0, 8, 1.0, 0.0, false, true>::decode(0xFF) == -1.0);
+  static_assert(Signal<0, 64, 1.0, 0.0, false, true>::decode(~can_data_t(0)) == -1.0);
+  EXPECT_DOUBLE_EQ((Signal<8, 12, 0.1, 0.0, false, true>::decode(0x0000000000080000)), -204.8);
+  EXPECT_DOUBLE_EQ(field_value(0x7FF, 12, true), 2047);
+}
+
+TEST(TestSignal, test_decode_signals) {
+  using Low = Signal<0, 16>;
+  using High = Signal<48, 16, 2.0>;
+  auto [low, high] = decode_signals<Low, High>(test_pattern);
+  EXPECT_DOUBLE_EQ(low, 0x9687);
+  EXPECT_DOUBLE_EQ(high, 2.0 * 0xF0E1);
+}
+
+TEST(TestSignal, test_fd_window) {
+  uint8_t payload[64] = {};
+  payload[40] = 0x34;
+  payload[41] = 0x12;
+  payload[63] = 0xFF;
+  EXPECT_EQ((Signal<0, 16>::raw(fd_window(payload, 64, 40))), 0x1234u);
+  EXPECT_EQ(fd_window(payload, 64, 60), 0xFF000000u);
+  EXPECT_EQ(fd_window(payload, 62, 60), 0u); // Past the payload
+  EXPECT_EQ(fd_window(payload, 64, 64), 0u);
+}
@@ -5,9 +5,10 @@ from launch.actions import IncludeLaunchDescription
 from launch import LaunchDescription
 from launch.actions import DeclareLaunchArgument
 from launch.actions import ExecuteProcess
-from launch.conditions import IfCondition
+from launch.conditions import IfCondition, UnlessCondition
 from launch.substitutions import LaunchConfiguration
-from launch_ros.actions import Node
+from launch_ros.actions import ComposableNodeContainer, Node
+from launch_ros.descriptions import ComposableNode
 
 from ament_index_python import get_package_share_directory
 
@@ -103,15 +104,29 @@ def generate_launch_description():
         executable='map_management_node'
     )
 
+    map_matching = Node(
+        package='map_management',
+        executable='map_matching_node'
+    )
+
     rviz = Node(
         package='rviz2',
         executable='rviz2',
         arguments=['-d' + '/navigator/data/mcl.rviz']
     )
 
+    # Run the ground segmentation and static grid in one process, passing
+    # /lidar/filtered between them intra-process instead of through DDS.
+    use_perception_container = DeclareLaunchArgument(
+        'use_perception_container',
+        default_value='false',
+        description='Load the occupancy nodes into one component container'
+    )
+
     ground_seg = Node(
         package='occupancy_cpp',
-        executable='ground_segmentation_exe'
+        executable='ground_segmentation_exe',
+        condition=UnlessCondition(LaunchConfiguration('use_perception_container'))
     )
 
     image_segmentation = Node(
@@ -126,7 +141,30 @@ def generate_launch_description():
 
     static_grid = Node(
         package='occupancy_cpp',
-        executable='static_grid_exe'
+        executable='static_grid_exe',
+        condition=UnlessCondition(LaunchConfiguration('use_perception_container'))
+    )
+
+    perception_container = ComposableNodeContainer(
+        name='perception_container',
+        namespace='',
+        package='rclcpp_components',
+        executable='component_container',
+        composable_node_descriptions=[
+            ComposableNode(
+                package='occupancy_cpp',
+                plugin='navigator::perception::GroundSegmentationNode',
+                name='ground_segmentation_node',
+                extra_arguments=[{'use_intra_process_comms': True}]
+            ),
+            ComposableNode(
+                package='occupancy_cpp',
+                plugin='navigator::perception::StaticOccupancyNode',
+                name='static_occupancy_node',
+                extra_arguments=[{'use_intra_process_comms': True}]
+            ),
+        ],
+        condition=IfCondition(LaunchConfiguration('use_perception_container'))
     )
 
     grid_summation = Node(
@@ -171,6 +209,8 @@ def generate_launch_description():
     )
 
     return LaunchDescription([
+        use_perception_container,
+
         # CONTROL
         # carla_controller,
 
@@ -200,6 +240,7 @@ def generate_launch_description():
         lidar_processor,
         ground_seg,
         static_grid,
+        perception_container,
         # prednet_inference,
 
         # PLANNING
@@ -214,5 +255,6 @@ def generate_launch_description():
 
         # STATE ESTIMATION
         map_manager,
+        map_matching,
         # gnss_processor,
     ])
@@ -10,11 +10,14 @@
 #pragma once
 
 #include <chrono> // Time literals
+#include <memory>
 #include <string>
 
 #include "rclcpp/rclcpp.hpp"
 #include "nova_msgs/msg/can_frame.hpp" // CAN messages
 #include "std_msgs/msg/float32.hpp" // UInt8 messages
+#include "control_loop/ControlLoop.hpp" // Fixed-rate sending
+#include "control_loop/Mailbox.hpp" // Latest power, shared with the loop
 
 typedef uint32_t can_id_t;
 typedef uint64_t can_data_t;
@@ -38,17 +41,22 @@ constexpr can_id_t epas_control_can_identifier = 0x296;
 
 class ControllerNode : public rclcpp::Node {
 public:
-  ControllerNode();
+  explicit ControllerNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
   virtual ~ControllerNode();
 
 private:
   void send_control_message();
   void update_power(const std_msgs::msg::Float32::SharedPtr message);
 
-  uint8_t power = 255/2;
+  void report_loop_statistics();
+
+  navigator::control_loop::Mailbox<uint8_t> power {255/2};
   rclcpp::Publisher<nova_msgs::msg::CanFrame>::SharedPtr can_publisher;
   rclcpp::Subscription<std_msgs::msg::Float32>::SharedPtr power_subscription;
-  rclcpp::TimerBase::SharedPtr control_timer;
+  rclcpp::TimerBase::SharedPtr statistics_timer;
+
+  // Declared last so it stops before the publisher goes away
+  std::unique_ptr<navigator::control_loop::ControlLoop> control_loop;
 };
 }
 }
@@ -9,28 +9,41 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 
 #include "rclcpp/rclcpp.hpp"
 #include "std_msgs/msg/float32.hpp"
 
+#include "can_translation/publish_policy.hpp"
 #include "nova_msgs/msg/can_frame.hpp"
+#include "nova_msgs/msg/signal_batch.hpp"
 
 namespace Voltron {
 namespace EpasSteering {
 
 class ReporterNode : public rclcpp::Node {
 public:
-  ReporterNode();
-  ReporterNode(float epas_min, float epas_max);
+  explicit ReporterNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+  ReporterNode(float epas_min, float epas_max,
+    navigator::can_translation::publish_policy policy = {});
   virtual ~ReporterNode();
 
 private:
   void initialize();
   void process_frame(const nova_msgs::msg::CanFrame::SharedPtr msg);
+  void flush();
+  void publish_latest();
 
+  // In batch mode only batch_publisher is created, on
+  // epas_translator_real_steering_angle_batch
   rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr angle_publisher;
+  rclcpp::Publisher<nova_msgs::msg::SignalBatch>::SharedPtr batch_publisher;
   rclcpp::Subscription<nova_msgs::msg::CanFrame>::SharedPtr can_subscription;
+  rclcpp::TimerBase::SharedPtr flush_timer;
+
+  navigator::can_translation::publish_policy policy;
+  std::optional<navigator::can_translation::SignalThrottle> throttle;
 
   float epas_min;
   float epas_max;
@@ -0,0 +1,86 @@
+from os import environ
+
+from launch import LaunchDescription
+from launch_ros.actions import ComposableNodeContainer
+from launch_ros.descriptions import ComposableNode
+
+# The whole steering loop in one process: CAN feedback from
+# can_interface, the EPAS reporter, the PID controller and the EPAS
+# controller, back out to can_interface. Every hop is an intra-process
+# handoff instead of a DDS round trip. The topics are the same as when
+# these run separately, so anything outside the container can still
+# watch them.
+
+intra_process = [{'use_intra_process_comms': True}]
+
+def generate_launch_description():
+    can_interface = ComposableNode(
+        package='can_interface',
+        plugin='navigator::can_interface::CanInterfaceNode',
+        name='can_interface',
+        parameters=[{
+            'interface_name': environ["can_interface_name"],
+            # The reporter only needs the EPAS's second message
+            'filtered_ids': [0x292]
+        }],
+        extra_arguments=intra_process
+    )
+
+    reporter = ComposableNode(
+        package='epas_translator',
+        plugin='Voltron::EpasSteering::ReporterNode',
+        name='steering_reporter',
+        parameters=[("/opt/param/"+environ["reporter_param_name"])],
+        remappings=[
+            ("epas_translator_incoming_can_frames", "can_interface_incoming_can_frames_292"),
+            ("epas_translator_real_steering_angle", "real_steering_angle")
+        ],
+        extra_arguments=intra_process
+    )
+
+    pid = ComposableNode(
+        package='pid_controller',
+        plugin='Voltron::PidController::PidControllerNode',
+        name='pid_controller',
+        parameters=[("/opt/param/"+environ["pid_param_name"])],
+        remappings=[
+            ("target", environ["steering_target_topic_name"]),
+            ("measurement", "real_steering_angle"),
+            ("output", "steering_power")
+        ],
+        extra_arguments=intra_process
+    )
+
+    controller = ComposableNode(
+        package='epas_translator',
+        plugin='Voltron::EpasSteering::ControllerNode',
+        name='steering_controller',
+        remappings=[
+            ("epas_translator_steering_power", "steering_power"),
+            ("epas_translator_outgoing_can_frames", "can_interface_outgoing_can_frames")
+        ],
+        extra_arguments=intra_process
+    )
+
+    # What each of the above sends and takes, for spotting a saturated
+    # bus or a stage that falls behind
+    transport_stats = ComposableNode(
+        package='transport_stats',
+        plugin='navigator::transport_stats::TransportStatsNode',
+        name='steering_transport_stats'
+    )
+
+    # Multi-threaded, so a slow callback in one stage doesn't hold up the
+    # others. The receive and control threads run on their own anyway.
+    container = ComposableNodeContainer(
+        name='steering_container',
+        namespace='',
+        package='rclcpp_components',
+        executable='component_container_mt',
+        composable_node_descriptions=[can_interface, reporter, pid, controller,
+                                      transport_stats]
+    )
+
+    return LaunchDescription([
+        container
+    ])
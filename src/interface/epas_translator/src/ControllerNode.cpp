@@ -21,23 +21,33 @@ using namespace Voltron::EpasSteering;
 
 can_id_t can_message_3_identifier = 0x296;
 
-ControllerNode::ControllerNode() : Node("steering_controller") {
+ControllerNode::ControllerNode(const rclcpp::NodeOptions & options)
+  : Node("steering_controller", options) {
   this->can_publisher = this->create_publisher<nova_msgs::msg::CanFrame>
     ("epas_translator_outgoing_can_frames", 8);
   this->power_subscription = this->create_subscription<std_msgs::msg::Float32>
     ("epas_translator_steering_power", 8, bind(& ControllerNode::update_power, this, std::placeholders::_1));
-  this->control_timer = this->create_wall_timer(control_message_frequency,
-    bind(& ControllerNode::send_control_message, this));
+
+  // Frames go out from a real-time thread rather than an executor
+  // timer, so the EPAS sees a steady rate however busy this process is
+  this->control_loop = std::make_unique<navigator::control_loop::ControlLoop>
+    (control_message_frequency, [this](std::chrono::nanoseconds) { this->send_control_message(); });
+  this->control_loop->start();
+  this->statistics_timer = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(10s),
+    bind(& ControllerNode::report_loop_statistics, this));
 }
 
-ControllerNode::~ControllerNode() {}
+ControllerNode::~ControllerNode() {
+  this->control_loop->stop();
+}
 
 void ControllerNode::send_control_message() {
   auto message = nova_msgs::msg::CanFrame();
   message.identifier = can_message_3_identifier;
-  message.data = (255 - this->power);
+  uint8_t power = this->power.get();
+  message.data = (255 - power);
   message.data <<= 8;
-  message.data += this->power;
+  message.data += power;
   message.data <<= 8;
   message.data += steering_map;
   this->can_publisher->publish(message);
@@ -47,5 +57,14 @@ void ControllerNode::update_power(const std_msgs::msg::Float32::SharedPtr messag
   float f_power = (message->data * 128) + 127;
   if(f_power < 0) f_power = 0;
   if(f_power > 255) f_power = 255;
-  this->power = (uint8_t) f_power;
+  this->power.put((uint8_t) f_power);
 }
+
+void ControllerNode::report_loop_statistics() {
+  RCLCPP_INFO(this->get_logger(), "Control loop (%s): %s",
+	      this->control_loop->is_real_time() ? "SCHED_FIFO" : "not real-time",
+	      this->control_loop->statistics().summary().c_str());
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(Voltron::EpasSteering::ControllerNode)
@@ -7,6 +7,7 @@
  * License:   MIT License
  */
 
+#include <chrono>
 #include <string>
 #include <stdexcept>
 
@@ -14,10 +15,12 @@
 #include "std_msgs/msg/float32.hpp"
 
 #include "nova_msgs/msg/can_frame.hpp"
+#include "nova_msgs/msg/signal_batch.hpp"
 
 #include "epas_translator/ReporterNode.hpp"
 
 using namespace Voltron::EpasSteering;
+using namespace navigator::can_translation;
 
 typedef uint16_t can_id_t;
 typedef uint64_t can_data_t;
@@ -31,7 +34,8 @@ constexpr can_data_t angle_mask = 0xFF << (8 * angle_bit_shift);
 // Maximum angle we can steer to on either side, in radians
 const float steering_angle_max = 0.58294;
 
-ReporterNode::ReporterNode() : rclcpp::Node("steering_reporter") {
+ReporterNode::ReporterNode(const rclcpp::NodeOptions & options)
+  : rclcpp::Node("steering_reporter", options) {
   this->declare_parameter("is_calibrated");
   if(! this->get_parameter("is_calibrated").as_bool()) {
     throw std::runtime_error("EPAS ECU stops not calibrated!");
@@ -42,14 +46,21 @@ ReporterNode::ReporterNode() : rclcpp::Node("steering_reporter") {
   this->epas_min = this->get_parameter("epas_min").as_double();
   this->epas_max = this->get_parameter("epas_max").as_double();
 
+  // How often to publish; see can_translation/publish_policy.hpp
+  this->policy.mode = parse_publish_mode
+    (this->declare_parameter<std::string>("publish_mode", "every_frame"));
+  this->policy.deadband = this->declare_parameter<double>("publish_deadband", 0.0);
+  this->policy.period = this->declare_parameter<double>("publish_period", 0.0);
+
   this->initialize();
 }
 
-ReporterNode::ReporterNode(float epas_min, float epas_max)
+ReporterNode::ReporterNode(float epas_min, float epas_max, publish_policy policy)
   : rclcpp::Node("steering_reporter") {
 
   this->epas_min = epas_min;
   this->epas_max = epas_max;
+  this->policy = policy;
   this->initialize();
 }
 
@@ -63,15 +74,55 @@ void ReporterNode::process_frame(const nova_msgs::msg::CanFrame::SharedPtr incom
     (this->epas_max - this->epas_min); // Value from 0 to 1
   current_angle = (current_angle * 2) - 1; // Value from -1 to 1
 
+  // Angle in radians
+  if(this->throttle->sample(this->now().nanoseconds(), current_angle * steering_angle_max)) {
+    this->publish_latest();
+  }
+}
+
+// Called once per publish period, for every mode but every_frame
+void ReporterNode::flush() {
+  if(! this->throttle->flush(this->now().nanoseconds())) return;
+  if(! this->batch_publisher) {
+    this->publish_latest();
+    return;
+  }
+
+  auto message = nova_msgs::msg::SignalBatch();
+  for(const stamped_value & sample : this->throttle->take_batch()) {
+    message.stamps.push_back(rclcpp::Time(sample.stamp, this->get_clock()->get_clock_type()));
+    message.values.push_back((float) sample.value);
+  }
+  this->batch_publisher->publish(message);
+}
+
+void ReporterNode::publish_latest() {
   auto message = std_msgs::msg::Float32();
-  message.data = current_angle * steering_angle_max; // Angle in radians
+  message.data = (float) this->throttle->latest();
   this->angle_publisher->publish(message);
 }
 
 void ReporterNode::initialize() {
-  this->angle_publisher = this->create_publisher<std_msgs::msg::Float32>
-    ("epas_translator_real_steering_angle", 8);
+  this->throttle.emplace(this->policy); // Throws on a bad policy
+
+  if(this->policy.mode == publish_mode::batch) {
+    this->batch_publisher = this->create_publisher<nova_msgs::msg::SignalBatch>
+      ("epas_translator_real_steering_angle_batch", 8);
+  } else {
+    this->angle_publisher = this->create_publisher<std_msgs::msg::Float32>
+      ("epas_translator_real_steering_angle", 8);
+  }
+  if(this->throttle->needs_timer()) {
+    this->flush_timer = this->create_wall_timer
+      (std::chrono::duration_cast<std::chrono::nanoseconds>
+       (std::chrono::duration<double>(this->policy.period)),
+       std::bind(& ReporterNode::flush, this));
+  }
+
   this->can_subscription = this->create_subscription<nova_msgs::msg::CanFrame>
     ("epas_translator_incoming_can_frames", 8,
      std::bind(& ReporterNode::process_frame, this, std::placeholders::_1));
 }
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(Voltron::EpasSteering::ReporterNode)
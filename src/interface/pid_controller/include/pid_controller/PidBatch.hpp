@@ -0,0 +1,123 @@
+/*
+ * Package:   pid_controller
+ * Filename:  PidBatch.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// Many ScheduledPid controllers sharing one limit and filter
+// configuration but each with its own gains, stored as one array per
+// field so a step over all of them is a tight loop. Meant for tuning
+// offline: replay a recorded log against thousands of candidate gain
+// sets at once and keep the best. Memory is allocated once, up front.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "pid_controller/ScheduledPid.hpp"
+
+namespace Voltron {
+namespace PidController {
+
+template <typename T, std::size_t Points>
+class PidBatch {
+public:
+  // Every controller starts with config's gains
+  PidBatch(std::size_t count, const ScheduledPidConfig<T, Points> & config)
+    : config(config), count(count), KP(Points * count), KI(Points * count), KD(Points * count),
+      integral(count), derivative(count), last_error(count), last_output(count) {
+    for(std::size_t i = 0; i < count; i++) this->set_gains(i, config.gains);
+  }
+
+  std::size_t size() const { return this->count; }
+
+  void set_gains(std::size_t controller, const std::array<PidGains<T>, Points> & gains) {
+    for(std::size_t point = 0; point < Points; point++) {
+      this->KP[point * this->count + controller] = gains[point].KP;
+      this->KI[point * this->count + controller] = gains[point].KI;
+      this->KD[point * this->count + controller] = gains[point].KD;
+    }
+  }
+
+  // Step every controller towards the same target, each from its own
+  // measurement, writing each one's output
+  void step(T target, T speed, T time_delta, const T * measurements, T * outputs) {
+    time_delta = std::min(time_delta, this->config.time_delta_cap);
+    if(!(time_delta > 0)) {
+      std::copy(this->last_output.begin(), this->last_output.end(), outputs);
+      return;
+    }
+
+    // The whole batch is at the same speed, so look it up once
+    auto at = this->config.position(speed);
+    std::size_t low = at.index * this->count;
+    std::size_t high = (at.weight == 0 ? at.index : at.index + 1) * this->count;
+    T weight = at.weight;
+
+    for(std::size_t i = 0; i < this->count; i++) {
+      PidGains<T> gains {
+	this->KP[low + i] + (this->KP[high + i] - this->KP[low + i]) * weight,
+	this->KI[low + i] + (this->KI[high + i] - this->KI[low + i]) * weight,
+	this->KD[low + i] + (this->KD[high + i] - this->KD[low + i]) * weight };
+      PidState<T> state { this->integral[i], this->derivative[i],
+			  this->last_error[i], this->last_output[i] };
+      outputs[i] = pid_step(this->config, gains, state, this->first_step,
+			    target - measurements[i], time_delta);
+      this->integral[i] = state.integral;
+      this->derivative[i] = state.derivative;
+      this->last_error[i] = state.last_error;
+      this->last_output[i] = state.last_output;
+    }
+    this->first_step = false;
+  }
+
+  // Replay a log of steps of targets, speeds and time deltas through
+  // every controller. plant(outputs, measurements, time_delta) moves
+  // each controller's plant on by one step given its output and writes
+  // where it ends up. Each controller's summed squared tracking error
+  // is added to its entry in costs.
+  template <typename Plant>
+  void simulate(const T * targets, const T * speeds, const T * time_deltas, std::size_t steps,
+		T * measurements, T * outputs, Plant && plant, T * costs) {
+    for(std::size_t t = 0; t < steps; t++) {
+      this->step(targets[t], speeds[t], time_deltas[t], measurements, outputs);
+      plant(static_cast<const T *>(outputs), measurements, time_deltas[t]);
+      for(std::size_t i = 0; i < this->count; i++) {
+	T error = targets[t] - measurements[i];
+	costs[i] += error * error;
+      }
+    }
+  }
+
+  void reset() {
+    std::fill(this->integral.begin(), this->integral.end(), T(0));
+    std::fill(this->derivative.begin(), this->derivative.end(), T(0));
+    std::fill(this->last_error.begin(), this->last_error.end(), T(0));
+    std::fill(this->last_output.begin(), this->last_output.end(), T(0));
+    this->first_step = true;
+  }
+
+private:
+  ScheduledPidConfig<T, Points> config;
+  std::size_t count;
+
+  // Gains at schedule point p for controller i are at p * count + i
+  std::vector<T> KP;
+  std::vector<T> KI;
+  std::vector<T> KD;
+
+  std::vector<T> integral;
+  std::vector<T> derivative;
+  std::vector<T> last_error;
+  std::vector<T> last_output;
+  bool first_step = true;
+};
+
+}
+}
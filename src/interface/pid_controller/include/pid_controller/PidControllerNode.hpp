@@ -15,6 +15,8 @@
 #include "rclcpp/rclcpp.hpp"
 #include "std_msgs/msg/float32.hpp"
 
+#include "control_loop/ControlLoop.hpp"
+#include "control_loop/Mailbox.hpp"
 #include "pid_controller/PidController.hpp"
 
 using namespace std::chrono_literals;
@@ -24,25 +26,31 @@ namespace PidController {
 
 class PidControllerNode : public rclcpp::Node {
 public:
-  PidControllerNode();
+  explicit PidControllerNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
   virtual ~PidControllerNode();
 
 private:
   void update_target(const std_msgs::msg::Float32::SharedPtr command);
   void update_measurement(const std_msgs::msg::Float32::SharedPtr measurement);
-  void recalculate_output();
+  void recalculate_output(std::chrono::nanoseconds time_delta);
+  void report_loop_statistics();
 
+  // Only touched by the control loop
   std::unique_ptr<PidController> controller;
 
-  typedef std::chrono::steady_clock clock_t;
-  clock_t clock;
-  clock_t::time_point last_update_time;
+  // Latest values from the subscriptions, sampled once a cycle
+  navigator::control_loop::Mailbox<float> target;
+  navigator::control_loop::Mailbox<float> measurement;
 
   rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr steering_control_publisher;
   rclcpp::Subscription<std_msgs::msg::Float32>::
     SharedPtr command_subscription;
   rclcpp::Subscription<std_msgs::msg::Float32>::
     SharedPtr measurement_subscription;
+  rclcpp::TimerBase::SharedPtr statistics_timer;
+
+  // Declared last so it stops before the publisher goes away
+  std::unique_ptr<navigator::control_loop::ControlLoop> control_loop;
 };
 }
 }
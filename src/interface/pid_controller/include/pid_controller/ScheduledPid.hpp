@@ -0,0 +1,149 @@
+/*
+ * Package:   pid_controller
+ * Filename:  ScheduledPid.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// A PID controller whose gains are interpolated from a table indexed
+// by vehicle speed, with a low-passed derivative, conditional
+// integration to stop windup and limits on the output and its rate of
+// change. The configuration is a literal type, so a tuned controller
+// can be a constexpr, and nothing here allocates.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+
+namespace Voltron {
+namespace PidController {
+
+template <typename T>
+struct PidGains {
+  T KP;
+  T KI;
+  T KD;
+};
+
+template <typename T, std::size_t Points>
+struct ScheduledPidConfig {
+  static_assert(Points >= 1, "The gain schedule needs at least one point");
+
+  // Ascending speeds and the gains to use at each. Between points the
+  // gains are interpolated, beyond the ends they are held.
+  std::array<T, Points> speeds {};
+  std::array<PidGains<T>, Points> gains {};
+
+  // Time constant of the derivative's low-pass filter, zero for none
+  T derivative_time_constant = 0;
+
+  T output_min = -std::numeric_limits<T>::infinity();
+  T output_max = std::numeric_limits<T>::infinity();
+  T output_rate_limit = std::numeric_limits<T>::infinity(); // Per second
+
+  // Longer steps are treated as this long, as in PidController
+  T time_delta_cap = std::numeric_limits<T>::infinity();
+
+  // Where speed falls in the schedule: the point below it and how far
+  // it is towards the next one, from 0 to 1
+  struct schedule_position {
+    std::size_t index;
+    T weight;
+  };
+
+  constexpr schedule_position position(T speed) const {
+    if(Points == 1 || !(speed > this->speeds[0])) return { 0, 0 };
+    for(std::size_t i = 1; i < Points; i++) {
+      if(speed < this->speeds[i]) {
+	return { i - 1, (speed - this->speeds[i - 1]) / (this->speeds[i] - this->speeds[i - 1]) };
+      }
+    }
+    return { Points - 1, 0 };
+  }
+
+  constexpr PidGains<T> gains_at(T speed) const {
+    schedule_position at = this->position(speed);
+    const PidGains<T> & low = this->gains[at.index];
+    if(at.weight == 0) return low;
+    const PidGains<T> & high = this->gains[at.index + 1];
+    return { low.KP + (high.KP - low.KP) * at.weight,
+	     low.KI + (high.KI - low.KI) * at.weight,
+	     low.KD + (high.KD - low.KD) * at.weight };
+  }
+};
+
+// Everything a controller remembers between steps
+template <typename T>
+struct PidState {
+  T integral = 0;
+  T derivative = 0; // Filtered
+  T last_error = 0;
+  T last_output = 0;
+};
+
+// One step of one controller. Written without early returns, so the
+// batch loop over many controllers stays vectorisable.
+template <typename T, std::size_t Points>
+constexpr T pid_step(const ScheduledPidConfig<T, Points> & config, const PidGains<T> & gains,
+		     PidState<T> & state, bool first_step, T error, T time_delta) {
+  T raw_derivative = first_step ? T(0) : (error - state.last_error) / time_delta;
+  T alpha = time_delta / (config.derivative_time_constant + time_delta);
+  state.derivative += alpha * (raw_derivative - state.derivative);
+
+  T proportional = gains.KP * error;
+  T damping = gains.KD * state.derivative;
+
+  // Only integrate when it wouldn't drive the output further into a
+  // limit it is already against
+  T integral = state.integral + error * time_delta;
+  T unlimited = proportional + gains.KI * integral + damping;
+  bool winding_up = (unlimited > config.output_max && error > 0) ||
+    (unlimited < config.output_min && error < 0);
+  state.integral = winding_up ? state.integral : integral;
+
+  T output = proportional + gains.KI * state.integral + damping;
+  output = std::clamp(output, config.output_min, config.output_max);
+  T max_change = first_step ? std::numeric_limits<T>::infinity() :
+    config.output_rate_limit * time_delta;
+  output = std::clamp(output, state.last_output - max_change, state.last_output + max_change);
+
+  state.last_error = error;
+  state.last_output = output;
+  return output;
+}
+
+template <typename T, std::size_t Points>
+class ScheduledPid {
+public:
+  constexpr ScheduledPid(const ScheduledPidConfig<T, Points> & config) : config(config) {}
+
+  // The output for this step. time_delta is in seconds since the last.
+  constexpr T compute(T target, T measurement, T speed, T time_delta) {
+    time_delta = std::min(time_delta, this->config.time_delta_cap);
+    if(!(time_delta > 0)) return this->state.last_output;
+    T output = pid_step(this->config, this->config.gains_at(speed), this->state,
+			this->first_step, target - measurement, time_delta);
+    this->first_step = false;
+    return output;
+  }
+
+  constexpr void reset() {
+    this->state = PidState<T>();
+    this->first_step = true;
+  }
+
+  constexpr const ScheduledPidConfig<T, Points> & get_config() const { return this->config; }
+
+private:
+  ScheduledPidConfig<T, Points> config;
+  PidState<T> state;
+  bool first_step = true;
+};
+
+}
+}
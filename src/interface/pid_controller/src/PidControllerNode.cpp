@@ -13,13 +13,15 @@
 
 #include <memory>
 #include <utility>
-#include <time.h>
+#include <chrono>
+#include <functional>
 
 using namespace Voltron::PidController;
 
 const float max_steering_angle_radians = 0.35;
 
-PidControllerNode::PidControllerNode() : rclcpp::Node("pid_controller") {
+PidControllerNode::PidControllerNode(const rclcpp::NodeOptions & options)
+  : rclcpp::Node("pid_controller", options) {
   this->declare_parameter("KP");
   this->declare_parameter("KI");
   this->declare_parameter("KD");
@@ -38,30 +40,39 @@ PidControllerNode::PidControllerNode() : rclcpp::Node("pid_controller") {
   this->measurement_subscription = this->create_subscription
     <std_msgs::msg::Float32>("measurement", 8,
     std::bind(& PidControllerNode::update_measurement, this, std::placeholders::_1));
-  this->last_update_time = this->clock.now();
+
+  // The output is computed at a fixed rate from the latest target and
+  // measurement, rather than whenever either arrives
+  double control_period_seconds = this->declare_parameter<double>("control_period_seconds", 0.02);
+  this->control_loop = std::make_unique<navigator::control_loop::ControlLoop>
+    (std::chrono::duration_cast<std::chrono::nanoseconds>
+     (std::chrono::duration<double>(control_period_seconds)),
+     std::bind(& PidControllerNode::recalculate_output, this, std::placeholders::_1));
+  this->control_loop->start();
+  this->statistics_timer = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(10s),
+    std::bind(& PidControllerNode::report_loop_statistics, this));
 }
 
-PidControllerNode::~PidControllerNode() {}
+PidControllerNode::~PidControllerNode() {
+  this->control_loop->stop();
+}
 
 void PidControllerNode::update_target(
   const std_msgs::msg::Float32::SharedPtr command) {
   float target = command->data;
   if(target > max_steering_angle_radians) target = max_steering_angle_radians;
   if(target < (-1 * max_steering_angle_radians)) target = (-1 * max_steering_angle_radians);
-  this->controller->set_target(target);
-  this->recalculate_output();
+  this->target.put(target);
 }
 
 void PidControllerNode::update_measurement(
   const std_msgs::msg::Float32::SharedPtr measurement) {
-  this->controller->set_measurement(measurement->data);
-  this->recalculate_output();
+  this->measurement.put(measurement->data);
 }
 
-void PidControllerNode::recalculate_output() {
-  clock_t::time_point now = this->clock.now();
-  clock_t::duration time_delta = now - this->last_update_time;
-  this->last_update_time = now;
+void PidControllerNode::recalculate_output(std::chrono::nanoseconds time_delta) {
+  this->controller->set_target(this->target.get());
+  this->controller->set_measurement(this->measurement.get());
   float time_delta_seconds = std::chrono::duration_cast<std::chrono::duration<float>>(time_delta)
     .count(); // Convert to seconds float
   float steering_power = this->controller->compute(time_delta_seconds);
@@ -69,3 +80,12 @@ void PidControllerNode::recalculate_output() {
   message.data = steering_power;
   this->steering_control_publisher->publish(message);
 }
+
+void PidControllerNode::report_loop_statistics() {
+  RCLCPP_INFO(this->get_logger(), "Control loop (%s): %s",
+	      this->control_loop->is_real_time() ? "SCHED_FIFO" : "not real-time",
+	      this->control_loop->statistics().summary().c_str());
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(Voltron::PidController::PidControllerNode)
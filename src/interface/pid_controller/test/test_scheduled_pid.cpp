@@ -0,0 +1,124 @@
+/*
+ * Package:   pid_controller
+ * Filename:  test_scheduled_pid.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm> // std::min_element
+#include <gtest/gtest.h> // Testing framework
+#include <vector>
+
+#include "pid_controller/PidBatch.hpp"
+#include "pid_controller/ScheduledPid.hpp"
+
+using namespace Voltron::PidController;
+
+// Softer gains at speed, as a steering controller would want
+constexpr ScheduledPidConfig<float, 2> steering_config {
+  { 0.0f, 20.0f },
+  { PidGains<float> { 2.0f, 0.5f, 0.1f }, PidGains<float> { 1.0f, 0.1f, 0.0f } },
+  0.0f, -1.0f, 1.0f
+};
+
+TEST(TestScheduledPid, test_schedule_interpolates) {
+  static_assert(steering_config.gains_at(10.0f).KP == 1.5f);
+  static_assert(steering_config.gains_at(-5.0f).KP == 2.0f);
+  static_assert(steering_config.gains_at(30.0f).KI == 0.1f);
+  EXPECT_FLOAT_EQ(steering_config.gains_at(5.0f).KI, 0.4f);
+}
+
+TEST(TestScheduledPid, test_proportional) {
+  ScheduledPidConfig<double, 1> config { { 0 }, { PidGains<double> { 0.5, 0, 0 } } };
+  ScheduledPid<double, 1> pid(config);
+  EXPECT_DOUBLE_EQ(pid.compute(1.0, 0.0, 0.0, 0.01), 0.5);
+  EXPECT_DOUBLE_EQ(pid.compute(1.0, 0.5, 0.0, 0.01), 0.25);
+  EXPECT_DOUBLE_EQ(pid.compute(1.0, 0.5, 0.0, 0.0), 0.25); // No time, no change
+}
+
+// Held against its limit, the integral shouldn't keep growing, so the
+// output comes off the limit as soon as the error changes sign
+TEST(TestScheduledPid, test_anti_windup) {
+  ScheduledPidConfig<double, 1> config { { 0 }, { PidGains<double> { 0, 1, 0 } } };
+  config.output_max = 1;
+  ScheduledPid<double, 1> pid(config);
+  for(int i = 0; i < 1000; i++) pid.compute(1.0, 0.0, 0.0, 0.1);
+  EXPECT_DOUBLE_EQ(pid.compute(1.0, 0.0, 0.0, 0.1), 1.0);
+  EXPECT_LT(pid.compute(0.0, 1.0, 0.0, 0.1), 1.0);
+}
+
+TEST(TestScheduledPid, test_rate_limit) {
+  ScheduledPidConfig<double, 1> config { { 0 }, { PidGains<double> { 1, 0, 0 } } };
+  config.output_rate_limit = 2; // Per second
+  ScheduledPid<double, 1> pid(config);
+  EXPECT_DOUBLE_EQ(pid.compute(0.0, 0.0, 0.0, 0.1), 0.0);
+  EXPECT_DOUBLE_EQ(pid.compute(1.0, 0.0, 0.0, 0.1), 0.2);
+  EXPECT_DOUBLE_EQ(pid.compute(1.0, 0.0, 0.0, 0.1), 0.4);
+}
+
+// A step in the error kicks an unfiltered derivative straight away,
+// but a filtered one only part of the way
+TEST(TestScheduledPid, test_derivative_filter) {
+  ScheduledPidConfig<double, 1> config { { 0 }, { PidGains<double> { 0, 0, 1 } } };
+  ScheduledPid<double, 1> unfiltered(config);
+  config.derivative_time_constant = 0.9;
+  ScheduledPid<double, 1> filtered(config);
+  unfiltered.compute(0.0, 0.0, 0.0, 0.1);
+  filtered.compute(0.0, 0.0, 0.0, 0.1);
+  EXPECT_DOUBLE_EQ(unfiltered.compute(1.0, 0.0, 0.0, 0.1), 10.0);
+  EXPECT_DOUBLE_EQ(filtered.compute(1.0, 0.0, 0.0, 0.1), 1.0);
+}
+
+// Each controller in a batch should do exactly what it would alone
+TEST(TestPidBatch, test_matches_single) {
+  PidBatch<float, 2> batch(3, steering_config);
+  auto softer = steering_config;
+  softer.gains[0].KP = 0.5f;
+  batch.set_gains(1, softer.gains);
+  ScheduledPid<float, 2> first(steering_config);
+  ScheduledPid<float, 2> second(softer);
+
+  float measurements[3] = { 0.1f, 0.2f, -0.3f };
+  float outputs[3];
+  for(int t = 0; t < 50; t++) {
+    float target = t < 25 ? 0.5f : -0.2f;
+    float expected_first = first.compute(target, measurements[0], 8.0f, 0.02f);
+    float expected_second = second.compute(target, measurements[1], 8.0f, 0.02f);
+    batch.step(target, 8.0f, 0.02f, measurements, outputs);
+    ASSERT_FLOAT_EQ(outputs[0], expected_first);
+    ASSERT_FLOAT_EQ(outputs[1], expected_second);
+    for(float & measurement : measurements) measurement *= 0.9f;
+  }
+}
+
+// Replaying a log against a sweep of gains should find the one that
+// tracks a simple first-order plant best
+TEST(TestPidBatch, test_simulate_tunes) {
+  const std::size_t candidates = 2000;
+  ScheduledPidConfig<float, 1> config { { 0 }, { PidGains<float> { 0, 0, 0 } } };
+  config.output_min = -10;
+  config.output_max = 10;
+  PidBatch<float, 1> batch(candidates, config);
+  for(std::size_t i = 0; i < candidates; i++) {
+    batch.set_gains(i, { PidGains<float> { 0.01f * i, 0, 0 } });
+  }
+
+  const std::size_t steps = 500;
+  std::vector<float> targets(steps), speeds(steps, 0), deltas(steps, 0.01f);
+  for(std::size_t t = 0; t < steps; t++) targets[t] = (t / 100) % 2 ? 1.0f : -1.0f;
+
+  std::vector<float> measurements(candidates, 0), outputs(candidates), costs(candidates, 0);
+  // The plant moves towards the output with a 0.2 s time constant
+  auto plant = [&](const float * out, float * measured, float dt) {
+    for(std::size_t i = 0; i < candidates; i++) measured[i] += (out[i] - measured[i]) * dt / 0.2f;
+  };
+  batch.simulate(targets.data(), speeds.data(), deltas.data(), steps,
+		 measurements.data(), outputs.data(), plant, costs.data());
+
+  std::size_t best = std::min_element(costs.begin(), costs.end()) - costs.begin();
+  EXPECT_GT(best, 0u);
+  EXPECT_LT(costs[best], costs[0]);
+  EXPECT_LT(costs[best], costs[100]);
+}
@@ -1,5 +1,8 @@
 #include "utility.hpp"
 #include "lio_sam/msg/cloud_info.hpp"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
 // #include <math.h> // Trig for ring numbers. WSH
 
 struct VelodynePointXYZIRT
@@ -42,11 +45,169 @@ using PointXYZIRT = VelodynePointXYZIRT;
 
 const int queueLength = 2000; // !!! This is big
 
+// Seconds between the deskew transforms worked out once per scan. A point
+// takes the nearest one, at most half a slice from its own time. 0 works
+// out every point's transform exactly instead.
+const double deskewSliceTime = 1e-4;
+
+// Whether organised clouds go straight into the range image, a cell per
+// point, rather than being projected like any other cloud
+const bool useOrganisedLayout = true;
+
+// Rings we make up for a ringless VLP-16
+const int ringlessRingCount = 16;
+
+// atan2(y, x) to within 1e-6 rad, without a branch or a libm call so
+// that a loop of them vectorises
+inline float fastAtan2(float y, float x)
+{
+    const float ax = std::fabs(x);
+    const float ay = std::fabs(y);
+    const float mx = std::max(ax, ay);
+    const float mn = std::min(ax, ay);
+    const float a = mx > 0.0f ? mn / mx : 0.0f;
+    const float s = a * a;
+    // atan(a) for a in [0, 1], an odd polynomial
+    float r = (((((-0.0040540580f * s + 0.0218612288f) * s - 0.0559098861f) * s + 0.0964200441f) * s - 0.1390853351f) * s + 0.1994653599f) * s - 0.3332985605f;
+    r = r * s * a + a;
+    r = ay > ax ? 1.57079637f - r : r;
+    r = x < 0.0f ? 3.14159274f - r : r;
+    return y < 0.0f ? -r : r;
+}
+
+// Stamped messages from one callback, oldest first, that another thread
+// can read without ever blocking the one writing. The writer fills the slot
+// after the newest and then publishes it, overwriting the oldest once the
+// ring is full. A reader copies the messages it wants, then checks the
+// writer hasn't come round to those slots meanwhile, and drops any it has.
+// Stamps must not go backwards.
+template <typename T>
+class StampedRing
+{
+public:
+    explicit StampedRing(std::size_t capacity) : slots(capacity) {}
+
+    // From the writer's thread only
+    void push(double stamp, const T &msg)
+    {
+        const uint64_t index = written.load(std::memory_order_relaxed);
+        Slot &slot = slots[index % slots.size()];
+        slot.stamp.store(stamp, std::memory_order_relaxed);
+        slot.msg = msg;
+        written.store(index + 1, std::memory_order_release);
+    }
+
+    // Copies into out every message stamped from from on, up to and
+    // including the first one stamped after to. Found by binary search,
+    // so the messages before from cost nothing.
+    void snapshot(double from, double to, std::vector<T> &out) const
+    {
+        out.clear();
+        const uint64_t end = written.load(std::memory_order_acquire);
+        uint64_t begin = end > slots.size() ? end - slots.size() : 0;
+
+        uint64_t lo = begin, hi = end;
+        while (lo < hi)
+        {
+            const uint64_t mid = lo + (hi - lo) / 2;
+            if (slots[mid % slots.size()].stamp.load(std::memory_order_relaxed) < from)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        begin = lo;
+
+        uint64_t last = begin;
+        for (; last < end; ++last)
+        {
+            const Slot &slot = slots[last % slots.size()];
+            out.push_back(slot.msg);
+            if (slot.stamp.load(std::memory_order_relaxed) > to)
+            {
+                ++last;
+                break;
+            }
+        }
+
+        // The writer may have reused the oldest slots while they were read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t writtenNow = written.load(std::memory_order_relaxed);
+        if (writtenNow + 1 > begin + slots.size())
+        {
+            const uint64_t overwritten = std::min<uint64_t>(writtenNow + 1 - slots.size() - begin, last - begin);
+            out.erase(out.begin(), out.begin() + overwritten);
+        }
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<double> stamp{0.0};
+        T msg;
+    };
+
+    std::vector<Slot> slots;
+    std::atomic<uint64_t> written{0}; // Messages pushed so far
+};
+
+// A range image and the point behind each cell, allocated once and kept
+// between scans. Each cell carries the generation it was last set in, so
+// clearing the image is an increment rather than a pass over every cell.
+// Different rows can be set from different threads at once.
+class RangeImage
+{
+public:
+    void resize(int rowCount, int colCount)
+    {
+        rows = rowCount;
+        cols = colCount;
+        ranges.assign(rows * cols, FLT_MAX);
+        points.resize(rows * cols);
+        generations.assign(rows * cols, 0);
+        generation = 1;
+        rowSetCounts.assign(rows, 0);
+    }
+
+    void clear()
+    {
+        std::fill(rowSetCounts.begin(), rowSetCounts.end(), 0);
+        if (++generation == 0) // Wrapped, so old cells could look current
+        {
+            std::fill(generations.begin(), generations.end(), 0);
+            generation = 1;
+        }
+    }
+
+    bool isSet(int row, int col) const { return generations[row * cols + col] == generation; }
+
+    void set(int row, int col, float range, const PointType &point)
+    {
+        const int index = row * cols + col;
+        ranges[index] = range;
+        points[index] = point;
+        generations[index] = generation;
+        ++rowSetCounts[row];
+    }
+
+    float range(int row, int col) const { return ranges[row * cols + col]; }
+    const PointType &point(int row, int col) const { return points[row * cols + col]; }
+
+    // Cells set since the last clear
+    int size() const { return std::accumulate(rowSetCounts.begin(), rowSetCounts.end(), 0); }
+
+private:
+    int rows = 0;
+    int cols = 0;
+    std::vector<float> ranges;
+    std::vector<PointType, Eigen::aligned_allocator<PointType>> points;
+    std::vector<uint32_t> generations;
+    uint32_t generation = 1;
+    std::vector<int> rowSetCounts; // Kept per row so rows can be set in parallel
+};
+
 class ImageProjection : public ParamServer
 {
 private:
-    std::mutex imuLock;
-    std::mutex odoLock;
 
     rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr subLaserCloud;
     rclcpp::CallbackGroup::SharedPtr callbackGroupLidar;
@@ -57,11 +218,13 @@ private:
 
     rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr subImu;
     rclcpp::CallbackGroup::SharedPtr callbackGroupImu;
-    std::deque<sensor_msgs::msg::Imu> imuQueue;
+    StampedRing<sensor_msgs::msg::Imu> imuQueue{queueLength};
+    std::vector<sensor_msgs::msg::Imu> imuWindow; // The part of imuQueue this scan needs
 
     rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr subOdom;
     rclcpp::CallbackGroup::SharedPtr callbackGroupOdom;
-    std::deque<nav_msgs::msg::Odometry> odomQueue;
+    StampedRing<nav_msgs::msg::Odometry> odomQueue{queueLength};
+    std::vector<nav_msgs::msg::Odometry> odomWindow; // The part of odomQueue this scan needs
 
     std::deque<sensor_msgs::msg::PointCloud2> cloudQueue;
     sensor_msgs::msg::PointCloud2 currentCloudMsg;
@@ -75,14 +238,51 @@ private:
     bool firstPointFlag;
     Eigen::Affine3f transStartInverse;
 
+    // Transforms to the first deskewed point, one every deskewSliceTime
+    // from deskewTableStart (relative to the scan)
+    std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f>> deskewTable;
+    double deskewTableStart;
+
     pcl::PointCloud<PointXYZIRT>::Ptr laserCloudIn;
     pcl::PointCloud<OusterPointXYZIRT>::Ptr tmpOusterCloudIn;
     pcl::PointCloud<RinglessVelodynePointXYZIT>::Ptr inputCloud;
-    pcl::PointCloud<PointType>::Ptr fullCloud;
     pcl::PointCloud<PointType>::Ptr extractedCloud;
 
     int deskewFlag;
-    cv::Mat rangeMat;
+    RangeImage rangeImage;
+
+    // Range, ring and column of each point of laserCloudIn, worked out in
+    // one pass before projecting
+    std::vector<float> pointRange;
+    std::vector<int> pointRing;
+    std::vector<int> pointColumn;
+
+    // Threads projecting rows of the range image at once. 1 projects the
+    // points serially in cloud order.
+    int projectionThreads;
+
+    // Indices of the points projected into each row, in cloud order, with
+    // row r's from rowStarts[r] up to rowStarts[r + 1], and where the next
+    // point of each row goes while they are sorted
+    std::vector<int> rowPoints;
+    std::vector<int> rowStarts;
+    std::vector<int> rowFill;
+
+    // Where an organised cloud keeps each ring and firing: the point for
+    // ring r and column c, counted from the first firing, is at
+    // r * ringStride + c * columnStride. No columns when the cloud isn't
+    // organised, or not in a way that fits the range image.
+    struct OrganisedLayout
+    {
+        int columns = 0;
+        int ringStride = 0;
+        int columnStride = 0;
+    };
+    OrganisedLayout organisedLayout;
+
+    // The ringless ring boundaries, as z|z| / (x^2 + y^2) at the pitch where
+    // each ring starts, so a point's ring is a count of comparisons
+    float ringThresholds[ringlessRingCount];
 
     bool odomDeskewFlag;
     float odomIncreX;
@@ -97,6 +297,9 @@ private:
 public:
     ImageProjection(const rclcpp::NodeOptions &options) : ParamServer("lio_sam_imageProjection", options), deskewFlag(0)
     {
+        declare_parameter("projectionThreads", 1);
+        get_parameter("projectionThreads", projectionThreads);
+
         callbackGroupLidar = create_callback_group(
             rclcpp::CallbackGroupType::MutuallyExclusive);
         callbackGroupImu = create_callback_group(
@@ -140,16 +343,21 @@ public:
         laserCloudIn.reset(new pcl::PointCloud<PointXYZIRT>());
         tmpOusterCloudIn.reset(new pcl::PointCloud<OusterPointXYZIRT>());
         inputCloud.reset(new pcl::PointCloud<RinglessVelodynePointXYZIT>());
-        fullCloud.reset(new pcl::PointCloud<PointType>());
         extractedCloud.reset(new pcl::PointCloud<PointType>());
+        extractedCloud->reserve(N_SCAN * Horizon_SCAN);
 
-        fullCloud->points.resize(N_SCAN * Horizon_SCAN);
+        rangeImage.resize(N_SCAN, Horizon_SCAN);
+        rowStarts.resize(N_SCAN + 1);
+        rowFill.resize(N_SCAN);
 
-        cloudInfo.start_ring_index.assign(N_SCAN, 0);
-        cloudInfo.end_ring_index.assign(N_SCAN, 0);
-
-        cloudInfo.point_col_ind.assign(N_SCAN * Horizon_SCAN, 0);
-        cloudInfo.point_range.assign(N_SCAN * Horizon_SCAN, 0);
+        // Ring r covers pitches that round to r once mapped from
+        // [-fov_below_middle_deg, fov_deg - fov_below_middle_deg] onto [0, 16]
+        for (int r = 0; r < ringlessRingCount; r++)
+        {
+            const double pitch_deg = (r - 0.5) * fov_deg / ringlessRingCount - fov_below_middle_deg;
+            const double slope = std::tan(pitch_deg * M_PI / 180.0);
+            ringThresholds[r] = slope * std::fabs(slope);
+        }
 
         resetParameters();
     }
@@ -158,12 +366,13 @@ public:
     {
         laserCloudIn->clear();
         extractedCloud->clear();
-        // reset range matrix for range image projection
-        rangeMat = cv::Mat(N_SCAN, Horizon_SCAN, CV_32F, cv::Scalar::all(FLT_MAX));
+        // reset range image for projection, keeping its memory
+        rangeImage.clear();
 
         imuPointerCur = 0;
         firstPointFlag = true;
         odomDeskewFlag = false;
+        deskewTable.clear();
 
         for (int i = 0; i < queueLength; ++i)
         {
@@ -211,7 +420,6 @@ public:
         //     thisImu.linear_acceleration.z = MAX_ACCEL*-1;
         // }
 
-        std::lock_guard<std::mutex> lock1(imuLock); // ???
         // int imuSmoothSize = 5;
         // if (imuQueue.size() > imuSmoothSize) { // Perform moving average with window size=5
         //     sensor_msgs::msg::Imu smoothImu;
@@ -240,7 +448,7 @@ public:
         // else {
         //     imuQueue.push_back(thisImu);
         // }
-        imuQueue.push_back(thisImu);
+        imuQueue.push(stamp2Sec(thisImu.header.stamp), thisImu);
 
         // debug IMU data
         // cout << std::setprecision(6);
@@ -262,8 +470,7 @@ public:
 
     void odometryHandler(const nav_msgs::msg::Odometry::SharedPtr odometryMsg)
     {
-        std::lock_guard<std::mutex> lock2(odoLock);
-        odomQueue.push_back(*odometryMsg); // Add
+        odomQueue.push(stamp2Sec(odometryMsg->header.stamp), *odometryMsg); // Add
     }
 
     void cloudHandler(const sensor_msgs::msg::PointCloud2::SharedPtr laserCloudMsg)
@@ -332,9 +539,6 @@ public:
 
             for (size_t i = 0; i < inputCloud->size(); i++)
             {
-                int ring_count = 16;
-                // RCLCPP_INFO(get_logger(),"D");
-
                 auto &src = inputCloud->points[i];
                 auto &dst = laserCloudIn->points[i];
 
@@ -345,22 +549,16 @@ public:
 
                 dst.time = src.timestamp;
                 // Fake a ring value
-                // Ring value is from 0 to 15, with 0 being lowest and 15 being highest
-
-                // Find pitch of point relative to sensor height, = atan(x/sqrt(x^2+y^2))
-                double pitch_degrees = atan2(src.z, sqrt(pow(src.x, 2) + pow(src.y, 2))) * 180 / 3.14159265;
-                // Find pitch of point from bottom of FOV
-                double pitch_from_bottom = pitch_degrees + fov_below_middle_deg;
-                // RCLCPP_DEBUG_STREAM(get_logger(), "Center ("<<point.x<<","<<point.y<<","<<point.z<<") is "<<pitch_degrees<<"; "<<pitch_from_bottom);
-                // Map this from [0,FOV]->[0,15]
-                int ring_number = round((pitch_from_bottom / fov_deg) * 16); // This will always round DOWN.
-                // int ring_number = floor(pitch_from_bottom * (ring_count) / fov_deg);
-                // RCLCPP_INFO_STREAM(get_logger(), "("<<src.x<<","<<src.y<<","<<src.z<<")-> atan("<<src.z<<"/"<<sqrt(pow(src.x,2)+pow(src.y,2))<<"+bot="<<pitch_from_bottom<<" "<<ring_number);
-                if (ring_number >= (ring_count - 1))
-                {
-                    // RCLCPP_ERROR_STREAM(get_logger(), "Ring number "<<ring_number<<" is above "<<(ring_count-1)<<". Rounding down.");
-                    ring_number = 15;
-                }
+                // Ring value is from 0 to 15, with 0 being lowest and 15 being highest.
+                // The pitch atan2(z, sqrt(x^2+y^2)) is at or above a ring's
+                // start exactly when z|z| >= (x^2+y^2) times its threshold,
+                // so counting those needs no trig. Points below the FOV
+                // come out as -1, which wraps past N_SCAN and is skipped.
+                const float planar2 = src.x * src.x + src.y * src.y;
+                const float height2 = src.z * std::fabs(src.z);
+                int ring_number = -1;
+                for (int r = 0; r < ringlessRingCount; r++)
+                    ring_number += height2 >= planar2 * ringThresholds[r];
 
                 dst.ring = ring_number;
             }
@@ -384,8 +582,11 @@ public:
         timeScanCur = stamp2Sec(cloudHeader.stamp);
         timeScanEnd = timeScanCur + laserCloudIn->points.back().time;
 
-        // check dense flag
-        if (laserCloudIn->is_dense == false)
+        organisedLayout = findOrganisedLayout();
+
+        // check dense flag. Organised clouds keep NaN points for missing
+        // returns, which their projection leaves out.
+        if (laserCloudIn->is_dense == false && organisedLayout.columns == 0)
         {
             RCLCPP_ERROR(get_logger(), "Point cloud is not in dense format, please remove NaN points first!");
             rclcpp::shutdown();
@@ -430,11 +631,10 @@ public:
         return true;
     }
 
+    // Reads the IMU and odometry queues without locking, so their
+    // callbacks never wait on a scan
     bool deskewInfo()
     {
-        std::lock_guard<std::mutex> lock1(imuLock);
-        std::lock_guard<std::mutex> lock2(odoLock);
-
         // make sure IMU data available for the scan
         // if (imuQueue.empty() ||
         //     stamp2Sec(imuQueue.front().header.stamp) > timeScanCur ||
@@ -455,22 +655,17 @@ public:
     {
         cloudInfo.imu_available = false;
 
-        while (!imuQueue.empty())
-        {
-            if (stamp2Sec(imuQueue.front().header.stamp) < timeScanCur - 0.01) // ???
-                imuQueue.pop_front();
-            else
-                break;
-        }
+        // Readings from just before the scan to just after it
+        imuQueue.snapshot(timeScanCur - 0.01, timeScanEnd + 0.01, imuWindow);
 
-        if (imuQueue.empty())
+        if (imuWindow.empty())
             return;
 
         imuPointerCur = 0;
 
-        for (int i = 0; i < (int)imuQueue.size(); ++i) // These are the bracketed measurements from paper's Fig. 1
+        for (int i = 0; i < (int)imuWindow.size(); ++i) // These are the bracketed measurements from paper's Fig. 1
         {
-            sensor_msgs::msg::Imu thisImuMsg = imuQueue[i];
+            sensor_msgs::msg::Imu &thisImuMsg = imuWindow[i];
             double currentImuTime = stamp2Sec(thisImuMsg.header.stamp);
 
             // get roll, pitch, and yaw estimation for this scan
@@ -518,26 +713,21 @@ public:
     {
         cloudInfo.odom_available = false;
 
-        while (!odomQueue.empty())
-        {
-            if (stamp2Sec(odomQueue.front().header.stamp) < timeScanCur - 0.01)
-                odomQueue.pop_front();
-            else
-                break;
-        }
+        // From just before the scan to the first message after it
+        odomQueue.snapshot(timeScanCur - 0.01, timeScanEnd, odomWindow);
 
-        if (odomQueue.empty())
+        if (odomWindow.empty())
             return;
 
-        if (stamp2Sec(odomQueue.front().header.stamp) > timeScanCur)
+        if (stamp2Sec(odomWindow.front().header.stamp) > timeScanCur)
             return;
 
         // get start odometry at the beinning of the scan
         nav_msgs::msg::Odometry startOdomMsg;
 
-        for (int i = 0; i < (int)odomQueue.size(); ++i)
+        for (int i = 0; i < (int)odomWindow.size(); ++i)
         {
-            startOdomMsg = odomQueue[i];
+            startOdomMsg = odomWindow[i];
 
             if (stamp2Sec(startOdomMsg.header.stamp) < timeScanCur)
                 continue;
@@ -564,14 +754,14 @@ public:
         // get end odometry at the end of the scan
         odomDeskewFlag = false;
 
-        if (stamp2Sec(odomQueue.back().header.stamp) < timeScanEnd)
+        if (stamp2Sec(odomWindow.back().header.stamp) < timeScanEnd)
             return;
 
         nav_msgs::msg::Odometry endOdomMsg;
 
-        for (int i = 0; i < (int)odomQueue.size(); ++i)
+        for (int i = 0; i < (int)odomWindow.size(); ++i)
         {
-            endOdomMsg = odomQueue[i];
+            endOdomMsg = odomWindow[i];
 
             if (stamp2Sec(endOdomMsg.header.stamp) < timeScanEnd)
                 continue;
@@ -645,28 +835,56 @@ public:
         // *posZCur = ratio * odomIncreZ;
     }
 
-    PointType deskewPoint(PointType *point, double relTime)
+    // The sensor's pose relTime into the scan
+    Eigen::Affine3f findTransform(double relTime)
     {
-        if (deskewFlag == -1 || cloudInfo.imu_available == false)
-            return *point;
-
-        double pointTime = timeScanCur + relTime;
-
         float rotXCur, rotYCur, rotZCur;
-        findRotation(pointTime, &rotXCur, &rotYCur, &rotZCur);
+        findRotation(timeScanCur + relTime, &rotXCur, &rotYCur, &rotZCur);
 
         float posXCur, posYCur, posZCur;
         findPosition(relTime, &posXCur, &posYCur, &posZCur);
 
+        return pcl::getTransformation(posXCur, posYCur, posZCur, rotXCur, rotYCur, rotZCur);
+    }
+
+    // Fills deskewTable from the first point's time to the last, so
+    // deskewPoint doesn't have to search the IMU or build a transform
+    void buildDeskewTable()
+    {
+        deskewTableStart = laserCloudIn->points.front().time;
+        const double span = laserCloudIn->points.back().time - deskewTableStart;
+        if (!(span >= 0.0 && span < 1.0)) // Times we can't trust, so keep to exact transforms
+            return;
+
+        const int slices = std::ceil(span / deskewSliceTime) + 1;
+        deskewTable.resize(slices);
+        for (int i = 0; i < slices; ++i)
+            deskewTable[i] = transStartInverse * findTransform(deskewTableStart + i * deskewSliceTime);
+    }
+
+    PointType deskewPoint(PointType *point, double relTime)
+    {
+        if (deskewFlag == -1 || cloudInfo.imu_available == false)
+            return *point;
+
         if (firstPointFlag == true)
         {
-            transStartInverse = (pcl::getTransformation(posXCur, posYCur, posZCur, rotXCur, rotYCur, rotZCur)).inverse();
+            transStartInverse = findTransform(relTime).inverse();
             firstPointFlag = false;
+            if (deskewSliceTime > 0)
+                buildDeskewTable();
         }
 
         // transform points to start
-        Eigen::Affine3f transFinal = pcl::getTransformation(posXCur, posYCur, posZCur, rotXCur, rotYCur, rotZCur);
-        Eigen::Affine3f transBt = transStartInverse * transFinal;
+        Eigen::Affine3f transBt;
+        if (deskewTable.empty())
+            transBt = transStartInverse * findTransform(relTime);
+        else
+        {
+            int slice = std::round((relTime - deskewTableStart) / deskewSliceTime);
+            slice = std::min(std::max(slice, 0), (int)deskewTable.size() - 1);
+            transBt = deskewTable[slice];
+        }
 
         PointType newPoint;
         newPoint.x = transBt(0, 0) * point->x + transBt(0, 1) * point->y + transBt(0, 2) * point->z + transBt(0, 3);
@@ -677,53 +895,202 @@ public:
         return newPoint;
     }
 
-    void projectPointCloud()
+    // Fills pointRange, pointRing and pointColumn for every point. Nothing
+    // here depends on another point, so the loop vectorises.
+    void indexPoints()
     {
-        int cloudSize = laserCloudIn->points.size();
-        // range image projection
+        const int cloudSize = laserCloudIn->points.size();
+        pointRange.resize(cloudSize);
+        pointRing.resize(cloudSize);
+        pointColumn.resize(cloudSize);
+
+        // Column 0 points straight back, and columns count anticlockwise seen
+        // from above, so straight ahead is Horizon_SCAN / 2
+        const float columnsPerRad = Horizon_SCAN / (2.0 * M_PI);
         for (int i = 0; i < cloudSize; ++i)
         {
-            PointType thisPoint;
-            thisPoint.x = laserCloudIn->points[i].x;
-            thisPoint.y = laserCloudIn->points[i].y;
-            thisPoint.z = laserCloudIn->points[i].z;
-            thisPoint.intensity = laserCloudIn->points[i].intensity;
-
-            float range = pointDistance(thisPoint);
-            if (range < lidarMinRange || range > lidarMaxRange)
-                continue;
+            const PointXYZIRT &point = laserCloudIn->points[i];
+            pointRange[i] = std::sqrt(point.x * point.x + point.y * point.y + point.z * point.z);
+            pointRing[i] = point.ring;
+
+            const float horizonAngle = fastAtan2(point.x, point.y);
+            int columnIdn = -std::round((horizonAngle - float(M_PI / 2)) * columnsPerRad) + Horizon_SCAN / 2;
+            columnIdn -= columnIdn >= Horizon_SCAN ? Horizon_SCAN : 0;
+            pointColumn[i] = columnIdn;
+        }
+    }
 
-            int rowIdn = laserCloudIn->points[i].ring;
-            if (rowIdn < 0 || rowIdn >= N_SCAN)
-                continue;
+    // Whether point i lands in the range image at all
+    bool inImage(int i) const
+    {
+        float range = pointRange[i];
+        if (range < lidarMinRange || range > lidarMaxRange)
+            return false;
 
-            if (rowIdn % downsampleRate != 0)
-                continue;
+        int rowIdn = pointRing[i];
+        if (rowIdn < 0 || rowIdn >= N_SCAN)
+            return false;
 
-            float horizonAngle = atan2(thisPoint.x, thisPoint.y) * 180 / M_PI;
+        if (rowIdn % downsampleRate != 0)
+            return false;
 
-            static float ang_res_x = 360.0 / float(Horizon_SCAN);
-            int columnIdn = -round((horizonAngle - 90.0) / ang_res_x) + Horizon_SCAN / 2;
-            if (columnIdn >= Horizon_SCAN)
-                columnIdn -= Horizon_SCAN;
+        int columnIdn = pointColumn[i];
+        if (columnIdn < 0 || columnIdn >= Horizon_SCAN)
+            return false;
 
-            if (columnIdn < 0 || columnIdn >= Horizon_SCAN)
-                continue;
+        return true;
+    }
 
-            if (rangeMat.at<float>(rowIdn, columnIdn) != FLT_MAX)
-                continue;
+    // Puts point i, which must be in the image, in its cell unless an
+    // earlier point got there first
+    void projectPoint(int i)
+    {
+        int rowIdn = pointRing[i];
+        int columnIdn = pointColumn[i];
+        if (rangeImage.isSet(rowIdn, columnIdn))
+            return;
+
+        PointType thisPoint;
+        thisPoint.x = laserCloudIn->points[i].x;
+        thisPoint.y = laserCloudIn->points[i].y;
+        thisPoint.z = laserCloudIn->points[i].z;
+        thisPoint.intensity = laserCloudIn->points[i].intensity;
 
-            thisPoint = deskewPoint(&thisPoint, laserCloudIn->points[i].time);
+        thisPoint = deskewPoint(&thisPoint, laserCloudIn->points[i].time);
 
-            rangeMat.at<float>(rowIdn, columnIdn) = range;
+        rangeImage.set(rowIdn, columnIdn, pointRange[i], thisPoint);
+    }
+
+    // The Velodyne driver's organised clouds have a row per firing and a
+    // column per ring, and Ouster's a row per ring and a column per firing.
+    // Either fits so long as it has all N_SCAN rings and no more firings
+    // than the image has columns.
+    OrganisedLayout findOrganisedLayout() const
+    {
+        OrganisedLayout layout;
+        if (!useOrganisedLayout || sensor != SensorType::VELODYNE || laserCloudIn->height <= 1)
+            return layout;
+
+        const int width = laserCloudIn->width;
+        const int height = laserCloudIn->height;
+        if (width == N_SCAN && height <= Horizon_SCAN)
+            layout = {height, 1, width};
+        else if (height == N_SCAN && width <= Horizon_SCAN)
+            layout = {width, width, 1};
+        return layout;
+    }
+
+    // Puts the organised cloud's point for ring and column in that cell,
+    // unless it is out of range. NaN points are never in range.
+    bool projectOrganisedPoint(int ring, int column)
+    {
+        const PointXYZIRT &point = laserCloudIn->points[ring * organisedLayout.ringStride + column * organisedLayout.columnStride];
+        float range = std::sqrt(point.x * point.x + point.y * point.y + point.z * point.z);
+        if (!(range >= lidarMinRange && range <= lidarMaxRange))
+            return false;
+
+        PointType thisPoint;
+        thisPoint.x = point.x;
+        thisPoint.y = point.y;
+        thisPoint.z = point.z;
+        thisPoint.intensity = point.intensity;
 
-            int index = columnIdn + rowIdn * Horizon_SCAN;
-            fullCloud->points[index] = thisPoint;
+        thisPoint = deskewPoint(&thisPoint, point.time);
+
+        rangeImage.set(ring, column, range, thisPoint);
+        return true;
+    }
+
+    // An organised cloud already has a cell for every point, so there is no
+    // column to work out and nothing to sort into rows. Its columns are
+    // firings in the order the sensor made them rather than angles from
+    // straight back, which is all feature extraction needs of them.
+    void projectOrganisedCloud()
+    {
+        // Deskewing is relative to the first point projected, which should
+        // be from the earliest firing, so that one goes first on its own
+        const int columns = organisedLayout.columns;
+        bool projected = false;
+        for (int column = 0; column < columns && !projected; ++column)
+            for (int ring = 0; ring < N_SCAN && !projected; ring += downsampleRate)
+                projected = projectOrganisedPoint(ring, column);
+        if (!projected)
+            return;
+
+        // Then row by row, as for any other cloud
+#pragma omp parallel for num_threads(projectionThreads) schedule(dynamic)
+        for (int ring = 0; ring < N_SCAN; ring += downsampleRate)
+            for (int column = 0; column < columns; ++column)
+                if (!rangeImage.isSet(ring, column))
+                    projectOrganisedPoint(ring, column);
+    }
+
+    void projectPointCloud()
+    {
+        if (organisedLayout.columns > 0)
+        {
+            projectOrganisedCloud();
+            return;
+        }
+
+        indexPoints();
+
+        int cloudSize = laserCloudIn->points.size();
+        if (projectionThreads <= 1)
+        {
+            // range image projection
+            for (int i = 0; i < cloudSize; ++i)
+                if (inImage(i))
+                    projectPoint(i);
+            return;
+        }
+
+        // Group the points by row with a counting sort, which keeps cloud
+        // order within each row, so every cell still takes the first
+        // return that reaches it
+        std::fill(rowStarts.begin(), rowStarts.end(), 0);
+        int firstPoint = -1;
+        for (int i = 0; i < cloudSize; ++i)
+        {
+            if (!inImage(i))
+                continue;
+            if (firstPoint < 0)
+                firstPoint = i;
+            ++rowStarts[pointRing[i] + 1];
         }
+        if (firstPoint < 0)
+            return;
+        std::partial_sum(rowStarts.begin(), rowStarts.end(), rowStarts.begin());
+
+        rowPoints.resize(rowStarts[N_SCAN]);
+        std::copy(rowStarts.begin(), rowStarts.end() - 1, rowFill.begin());
+        for (int i = 0; i < cloudSize; ++i)
+            if (inImage(i))
+                rowPoints[rowFill[pointRing[i]]++] = i;
+
+        // Deskewing is relative to the first point projected, and sets up
+        // its table there, so that one goes first on its own. It is first in
+        // its row too, so its row comes out no different.
+        projectPoint(firstPoint);
+
+        // Rows share nothing, and after the first point deskewPoint only reads
+#pragma omp parallel for num_threads(projectionThreads) schedule(dynamic)
+        for (int row = 0; row < N_SCAN; ++row)
+            for (int k = rowStarts[row]; k < rowStarts[row + 1]; ++k)
+                projectPoint(rowPoints[k]);
     }
 
     void cloudExtraction()
     {
+        // Sized once, so extraction writes the points in place. cloudInfo's
+        // arrays went out with the last scan, so they are sized here to just
+        // the points kept.
+        extractedCloud->resize(rangeImage.size());
+        cloudInfo.start_ring_index.resize(N_SCAN);
+        cloudInfo.end_ring_index.resize(N_SCAN);
+        cloudInfo.point_col_ind.resize(rangeImage.size());
+        cloudInfo.point_range.resize(rangeImage.size());
+
         int count = 0;
         // extract segmented cloud for lidar odometry
         for (int i = 0; i < N_SCAN; ++i)
@@ -731,14 +1098,14 @@ public:
             cloudInfo.start_ring_index[i] = count - 1 + 5;
             for (int j = 0; j < Horizon_SCAN; ++j)
             {
-                if (rangeMat.at<float>(i, j) != FLT_MAX)
+                if (rangeImage.isSet(i, j))
                 {
                     // mark the points' column index for marking occlusion later
                     cloudInfo.point_col_ind[count] = j;
                     // save range info
-                    cloudInfo.point_range[count] = rangeMat.at<float>(i, j);
+                    cloudInfo.point_range[count] = rangeImage.range(i, j);
                     // save extracted cloud
-                    extractedCloud->push_back(fullCloud->points[j + i * Horizon_SCAN]);
+                    extractedCloud->points[count] = rangeImage.point(i, j);
                     // size of extracted cloud
                     ++count;
                 }
@@ -751,7 +1118,9 @@ public:
     {
         cloudInfo.header = cloudHeader;
         cloudInfo.cloud_deskewed = publishCloud(pubExtractedCloud, extractedCloud, cloudHeader.stamp, lidarFrame);
-        pubLaserCloudInfo->publish(cloudInfo);
+        // Handed over whole, so a subscriber in the same process gets it
+        // without a copy
+        pubLaserCloudInfo->publish(std::make_unique<lio_sam::msg::CloudInfo>(std::move(cloudInfo)));
     }
 };
 
@@ -773,3 +1142,6 @@ int main(int argc, char **argv)
     rclcpp::shutdown();
     return 0;
 }
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(ImageProjection)
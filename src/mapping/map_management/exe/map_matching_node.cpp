@@ -0,0 +1,20 @@
+/*
+ * Package:   map_management
+ * Filename:  map_matching_node.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include <memory> // std::make_shared
+#include "rclcpp/rclcpp.hpp"
+#include "map_management/MapMatchingNode.hpp"
+
+int main(int argc, char **argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<navigator::planning::MapMatchingNode>());
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * Package:   map_management
+ * Filename:  DistanceTransform.hpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ *
+ * Exact Euclidean distance transforms over row-major grids
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace navigator
+{
+    namespace planning
+    {
+        // Value of cells that are not sites, before the transform.
+        constexpr float DT_FAR = 1e20f;
+
+        /**
+         * @brief Label the cells a line segment passes through as sites.
+         *
+         * Coordinates are in cells, with cell (c, r) centered at (c, r). The
+         * segment is clipped to the grid, so parts of it may lie outside.
+         *
+         * @param sites Row-major labels, -1 for cells that are not sites
+         * @param label Written to every cell the segment passes through
+         */
+        void markSegment(std::vector<int> &sites, int width, int height,
+                         float c0, float r0, float c1, float r1, int label);
+
+        /**
+         * @brief Squared Euclidean distance transform, in place.
+         *
+         * On input, sites are 0 and every other cell is DT_FAR. On output,
+         * each cell holds its squared distance, in cells, to the nearest
+         * site. Uses Felzenszwalb and Huttenlocher's lower envelope of
+         * parabolas, one pass over the columns and one over the rows, so it
+         * is linear in the number of cells.
+         *
+         * @param nearest If given, filled with the index of each cell's
+         * nearest site, or -1 if there are no sites.
+         */
+        void squaredDistanceTransform(std::vector<float> &grid, int width, int height,
+                                      std::vector<int> *nearest = nullptr);
+    }
+}
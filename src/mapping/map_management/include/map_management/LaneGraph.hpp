@@ -0,0 +1,83 @@
+/*
+ * Package:   map_management
+ * Filename:  LaneGraph.hpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ *
+ * Lane connectivity as a compact adjacency array over integer lane IDs
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Lane.h"
+#include "RoutingGraph.h"
+
+namespace navigator
+{
+    namespace planning
+    {
+        /**
+         * @brief Undirected lane adjacency in CSR form, built once from
+         * odr::RoutingGraph.
+         *
+         * Each lane in the graph gets a dense integer ID. The neighbours of
+         * lane i (its predecessors, then its successors, in the routing
+         * graph's order) are neighbours_[offsets_[i]] to
+         * neighbours_[offsets_[i + 1]]. Searches run over these arrays with
+         * a preallocated visited bitset, so no LaneKey is hashed after the
+         * endpoints have been looked up.
+         */
+        class LaneGraph
+        {
+        public:
+            constexpr static int32_t NO_LANE = -1;
+
+            LaneGraph() = default;
+            explicit LaneGraph(const odr::RoutingGraph &graph);
+
+            std::size_t size() const { return keys_.size(); }
+
+            // ID of a lane, or NO_LANE if it has no connections.
+            int32_t id(const odr::LaneKey &key) const;
+            const odr::LaneKey &key(int32_t id) const { return keys_[id]; }
+
+            const int32_t *neighboursBegin(int32_t id) const { return neighbours_.data() + offsets_[id]; }
+            const int32_t *neighboursEnd(int32_t id) const { return neighbours_.data() + offsets_[id + 1]; }
+
+            /**
+             * @brief Breadth-first search from one lane to another, ignoring
+             * edge direction.
+             *
+             * @param parents Filled with each visited lane's BFS parent
+             * (NO_LANE for `from`). Only entries of visited lanes are set.
+             * @return Whether `to` was reached
+             */
+            bool search(int32_t from, int32_t to, std::vector<int32_t> &parents);
+
+            // Whether lane `id` was visited by the last search().
+            bool visited(int32_t id) const { return visited_[id >> 6] >> (id & 63) & 1; }
+
+        private:
+            friend class MapCache;
+
+            // Size the search scratch for size() lanes.
+            void reserveScratch();
+
+            std::vector<odr::LaneKey> keys_;
+            std::unordered_map<odr::LaneKey, int32_t> ids_;
+
+            std::vector<uint32_t> offsets_{0}; // size() + 1
+            std::vector<int32_t> neighbours_;
+
+            // Search scratch, sized once.
+            std::vector<uint64_t> visited_;
+            std::vector<int32_t> queue_;
+        };
+    }
+}
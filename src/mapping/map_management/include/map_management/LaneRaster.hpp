@@ -0,0 +1,122 @@
+/*
+ * Package:   map_management
+ * Filename:  LaneRaster.hpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ *
+ * The lane polygons of a whole map, rasterized once into tiles
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "map_management/LaneTable.hpp"
+
+namespace navigator
+{
+    namespace planning
+    {
+        /**
+         * @brief Rasterization of every lane polygon of a map, so that
+         * "which lane is this point in?" is a memory lookup rather than an
+         * R-tree query followed by point-in-polygon tests.
+         *
+         * The map's bounding box is split into square tiles of TILE_SIZE
+         * cells. Only tiles that some lane touches are allocated. Each cell
+         * stores flags (drivable, in a junction) and the index of the lane
+         * covering it, preferring driving lanes where lanes overlap.
+         *
+         * Polygons are filled by scanline: a cell belongs to a lane if its
+         * center is inside the lane's ring.
+         */
+        class LaneRaster
+        {
+        public:
+            constexpr static int TILE_SIZE = 64;
+
+            // Cell flags
+            constexpr static uint8_t DRIVABLE = 1;
+            constexpr static uint8_t JUNCTION = 2;
+
+            constexpr static int32_t NO_LANE = -1;
+
+            LaneRaster() = default;
+
+            /**
+             * @param lanes Lanes and their polygons. Lane indices refer to
+             * this table.
+             * @param res Side length of a cell, in meters
+             */
+            LaneRaster(const LaneTable &lanes, float res);
+
+            bool empty() const { return tiles_.empty(); }
+            float resolution() const { return res_; }
+            std::size_t tileCount() const { return tiles_.size(); }
+
+            /**
+             * @brief Flags of the cell containing map point (x, y); 0 off the map.
+             */
+            uint8_t flagsAt(float x, float y) const
+            {
+                const Tile *tile;
+                std::size_t i;
+                return locate(x, y, tile, i) ? tile->flags[i] : 0;
+            }
+
+            /**
+             * @brief Index of the lane containing map point (x, y), or NO_LANE.
+             */
+            int32_t laneAt(float x, float y) const
+            {
+                const Tile *tile;
+                std::size_t i;
+                return locate(x, y, tile, i) ? tile->lanes[i] : NO_LANE;
+            }
+
+        private:
+            struct Tile
+            {
+                std::vector<uint8_t> flags;  // TILE_SIZE * TILE_SIZE, row-major
+                std::vector<int32_t> lanes;
+            };
+
+            // Find the tile and in-tile index of a map point.
+            bool locate(float x, float y, const Tile *&tile, std::size_t &i) const
+            {
+                const float fc = (x - origin_x_) * inv_res_;
+                const float fr = (y - origin_y_) * inv_res_;
+                if (!(fc >= 0.0f && fr >= 0.0f && fc < float(cols_) && fr < float(rows_)))
+                    return false;
+
+                const int c = int(fc), r = int(fr);
+                const int32_t t = tile_index_[std::size_t(r / TILE_SIZE) * tiles_x_ + c / TILE_SIZE];
+                if (t < 0)
+                    return false;
+
+                tile = &tiles_[t];
+                i = std::size_t(r % TILE_SIZE) * TILE_SIZE + c % TILE_SIZE;
+                return true;
+            }
+
+            // The tile holding cell (c, r), allocated if needed.
+            Tile &tileFor(int c, int r);
+
+            float res_ = 1.0f;
+            float inv_res_ = 1.0f;
+            float origin_x_ = 0.0f; // Map position of the corner of cell (0, 0)
+            float origin_y_ = 0.0f;
+            int cols_ = 0; // Cells
+            int rows_ = 0;
+            int tiles_x_ = 0;
+            int tiles_y_ = 0;
+
+            // Index into tiles_ of every tile position, -1 where unallocated.
+            std::vector<int32_t> tile_index_;
+            std::vector<Tile> tiles_;
+        };
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ * Package:   map_management
+ * Filename:  LaneTable.hpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ *
+ * A compact, read-only copy of the lane polygons of a map
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "OpenDriveMap.h"
+#include "Lane.h"
+
+namespace navigator
+{
+    namespace planning
+    {
+        /**
+         * @brief The lane polygons of a map as a struct of arrays.
+         *
+         * odr::LanePair holds a whole odr::Lane (splines, road marks,
+         * strings), which is far more than per-cell lookups need. This table
+         * keeps only what they do: the lane's key, an interned type id, a
+         * junction flag, the ring's vertices and the centerline, all
+         * contiguous. Lane k here is lane k of the vector it was built from,
+         * so R-tree values index it directly.
+         */
+        class LaneTable
+        {
+        public:
+            // Type id of "driving" lanes. Other types get ids in order of
+            // first appearance.
+            constexpr static uint8_t DRIVING = 0;
+            constexpr static int32_t NO_LANE = -1;
+
+            LaneTable() = default;
+
+            /**
+             * @param map The map the lanes belong to, for junctions and centerlines
+             * @param lane_polys Lanes and their polygons
+             */
+            LaneTable(const odr::OpenDriveMap &map, const std::vector<odr::LanePair> &lane_polys);
+
+            std::size_t size() const { return type_.size(); }
+            bool empty() const { return type_.empty(); }
+
+            const odr::LaneKey &key(std::size_t k) const { return keys_[k]; }
+            // Index of a lane, or NO_LANE if it isn't in the table.
+            int32_t index(const odr::LaneKey &key) const;
+
+            uint8_t type(std::size_t k) const { return type_[k]; }
+            const std::string &typeName(uint8_t type) const { return type_names_[type]; }
+            bool isDriving(std::size_t k) const { return type_[k] == DRIVING; }
+            // Whether lane k is a driving lane on a junction road.
+            bool inJunction(std::size_t k) const { return in_junction_[k]; }
+
+            // The ring of lane k, as returned by get_lane_polygons().
+            const odr::point *vertices(std::size_t k) const { return vertices_.data() + ring_start_[k]; }
+            std::size_t vertexCount(std::size_t k) const { return ring_start_[k + 1] - ring_start_[k]; }
+
+            // Midpoints of lane k's inner and outer borders, sampled at 1 m.
+            const odr::point *centerline(std::size_t k) const { return centerline_points_.data() + centerline_start_[k]; }
+            std::size_t centerlineCount(std::size_t k) const { return centerline_start_[k + 1] - centerline_start_[k]; }
+
+            // Arc length of each centerline point from the lane's first one,
+            // which is 0. Non-decreasing.
+            const float *centerlineS(std::size_t k) const { return centerline_s_.data() + centerline_start_[k]; }
+            float centerlineLength(std::size_t k) const;
+
+            /**
+             * @brief The centerline segment holding arc length s, by binary
+             * search. Segment i runs from point i to point i + 1. s is
+             * clamped to the lane.
+             */
+            std::size_t centerlineSegment(std::size_t k, float s) const;
+
+            // The centerline point at arc length s, clamped to the lane.
+            odr::point centerlinePoint(std::size_t k, float s) const;
+
+            /**
+             * @brief Append the centerline from arc length s_from to s_to to
+             * `out`, with interpolated end points. If s_from > s_to, the
+             * points run backwards along the lane.
+             */
+            void centerlineSlice(std::size_t k, float s_from, float s_to, std::vector<odr::point> &out) const;
+
+            /**
+             * @brief Whether (x, y) is inside lane k's ring, by the even-odd rule.
+             */
+            bool contains(std::size_t k, double x, double y) const;
+
+        private:
+            friend class MapCache;
+
+            // Fill centerline_s_ from centerline_points_.
+            void measureCenterlines();
+
+            std::vector<odr::LaneKey> keys_;
+            std::unordered_map<odr::LaneKey, int32_t> index_;
+            std::vector<uint8_t> type_;
+            std::vector<uint8_t> in_junction_;
+            std::vector<uint32_t> ring_start_{0}; // size() + 1 offsets into vertices_
+            std::vector<odr::point> vertices_;
+            std::vector<uint32_t> centerline_start_{0}; // size() + 1 offsets into centerline_points_
+            std::vector<odr::point> centerline_points_;
+            std::vector<float> centerline_s_; // Parallel to centerline_points_
+
+            std::vector<std::string> type_names_{"driving"};
+        };
+    }
+}
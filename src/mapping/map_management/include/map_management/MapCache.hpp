@@ -0,0 +1,81 @@
+/*
+ * Package:   map_management
+ * Filename:  MapCache.hpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ *
+ * An on-disk cache of the lane data derived from an OpenDRIVE map
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "OpenDriveMap.h"
+
+#include "map_management/LaneGraph.hpp"
+#include "map_management/LaneTable.hpp"
+#include "map_management/SignalTable.hpp"
+
+namespace navigator
+{
+    namespace planning
+    {
+        /**
+         * @brief Lane tables, lane graphs, R-tree envelopes and signal
+         * tables, saved per map.
+         *
+         * Parsing a map and sampling its lanes takes seconds. Reading the
+         * results back takes milliseconds. Files are named by a hash of the
+         * OpenDRIVE string, so an edited map misses rather than loading
+         * stale data. Each file is a header and a section table followed by
+         * flat, 8-byte-aligned arrays. Files are read through mmap, so
+         * processes loading the same map share its pages.
+         *
+         * Files use the host's byte order and are only meant to be read on
+         * the machine that wrote them.
+         */
+        class MapCache
+        {
+        public:
+            /**
+             * @param dir Directory holding the cache files, created on the
+             * first write
+             */
+            explicit MapCache(std::string dir) : dir_(std::move(dir)) {}
+
+            // 64-bit FNV-1a of an OpenDRIVE string.
+            static uint64_t hash(const std::string &opendrive);
+
+            std::string path(uint64_t hash) const;
+
+            /**
+             * @brief Load the cache file for a map, if there is a valid one.
+             *
+             * The outputs are only written on success.
+             *
+             * @param envelopes Each lane's bounding box, with its table index
+             * @return Whether the file existed, matched `hash` and was well formed
+             */
+            bool read(uint64_t hash, LaneTable &table, LaneGraph &graph,
+                      std::vector<odr::value> &envelopes, SignalTable &signals) const;
+
+            /**
+             * @brief Save a map's lane data. The file is written under a
+             * temporary name and renamed into place, so readers never see
+             * part of one.
+             *
+             * @return Whether the file was written
+             */
+            bool write(uint64_t hash, const LaneTable &table, const LaneGraph &graph,
+                       const std::vector<odr::value> &envelopes, const SignalTable &signals) const;
+
+        private:
+            std::string dir_;
+        };
+    }
+}
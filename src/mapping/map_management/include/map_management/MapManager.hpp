@@ -10,6 +10,10 @@
 #pragma once
 
 #include <chrono> // Time literals
+#include <fstream>
+#include <future>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
@@ -43,13 +47,26 @@
 #include "geometry_msgs/msg/polygon_stamped.hpp"
 #include "geometry_msgs/msg/pose_stamped.hpp"
 #include "geometry_msgs/msg/transform_stamped.hpp"
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
 #include "nav_msgs/msg/map_meta_data.hpp"
 #include "nav_msgs/msg/occupancy_grid.hpp"
 #include "nav_msgs/msg/path.hpp"
 #include "rosgraph_msgs/msg/clock.hpp"
+#include "std_msgs/msg/bool.hpp"
 #include "std_msgs/msg/float32.hpp"
 
+#include "map_management/DistanceTransform.hpp"
+#include "map_management/LaneGraph.hpp"
+#include "map_management/MapCache.hpp"
+#include "map_management/LaneRaster.hpp"
+#include "map_management/LaneTable.hpp"
 #include "map_management/RouteManager.hpp"
+#include "map_management/SharedGrids.hpp"
+#include "map_management/SignalTable.hpp"
+
+#include "latency_tracker/StageRecorder.hpp"
+#include "nova_trace/StageProfiler.hpp"
+#include "worker_pool/WorkerPool.hpp"
 
 using namespace std::chrono_literals;
 using namespace nav_msgs::msg;
@@ -58,6 +75,7 @@ namespace bgi = boost::geometry::index;
 
 using carla_msgs::msg::CarlaRoute;
 using carla_msgs::msg::CarlaWorldInfo;
+using diagnostic_msgs::msg::DiagnosticArray;
 using PointMsg = geometry_msgs::msg::Point;
 using geometry_msgs::msg::Point32;
 using geometry_msgs::msg::PolygonStamped;
@@ -74,65 +92,213 @@ namespace navigator
         {
         public:
             // Constructor
-            MapManagementNode();
+            explicit MapManagementNode(const rclcpp::NodeOptions &options = rclcpp::NodeOptions());
+
+            // One set of grids around the vehicle, with its own extent,
+            // resolution and rate. Distances are meters from the vehicle.
+            struct GridProfile
+            {
+                std::string name;
+                int top_dist;
+                int bottom_dist;
+                int side_dist;
+                float res;
+                std::chrono::milliseconds period;
+                bool publishes_goal; // Only the first profile's grids pick the goal
+                int first_stage;     // Of its GRID_STAGE_COUNT profiler stages
+
+                rclcpp::Publisher<OccupancyGrid>::SharedPtr drivable_pub;
+                rclcpp::Publisher<OccupancyGrid>::SharedPtr junction_pub;
+                rclcpp::Publisher<OccupancyGrid>::SharedPtr route_dist_pub;
+                rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr runtime_pub;
+                rclcpp::TimerBase::SharedPtr timer;
+
+                // Runs of publishGrids(), recorded against the drivable grid
+                std::unique_ptr<latency_tracker::StageRecorder> latency_recorder;
+
+                // The same grids in shared memory, if shared_grids is set
+                std::unique_ptr<SharedGridWriter> shared;
+
+                // What was last published and where, for grid_motion_gating
+                struct LastGrids
+                {
+                    bool valid = false;
+                    double x = 0.0;
+                    double y = 0.0;
+                    double heading = 0.0;
+                    uint64_t route_version = 0;
+                    bool has_drivable = false;
+                    bool has_junction = false;
+                    bool has_route = false;
+                    OccupancyGrid drivable;
+                    OccupancyGrid junction;
+                    OccupancyGrid route_dist;
+                    PoseStamped goal;
+                } last;
+            };
 
             // Functions
-            void publishGrids(int top, int bottom, int side, float res);
+            void publishGrids(GridProfile &profile);
 
         private:
+            // Timed stages of publishGrids() and publishRefinedRoute()
+            enum GridStage
+            {
+                GRID_TREE_QUERY,
+                GRID_TREE_BUILD,
+                GRID_ROUTE_TRANSFORM,
+                GRID_CELLS,
+                GRID_PUBLISH,
+                GRID_TOTAL,
+                GRID_STAGE_COUNT
+            };
+            enum RouteStage
+            {
+                ROUTE_ROI,
+                ROUTE_LANES,
+                ROUTE_RESOLVE,
+                ROUTE_PUBLISH,
+                ROUTE_TOTAL
+            };
+
             // Parameters
             // TODO: Convert to ros params
-            std::chrono::milliseconds GRID_PUBLISH_FREQUENCY = 200ms;
             std::chrono::milliseconds ROUTE_PUBLISH_FREQUENCY = 240ms;
-            std::chrono::milliseconds TRAFFIC_LIGHT_PUBLISH_FREQUENCY = 5000ms;
-            const int GRID_RANGE = 30;
+            // Only nearby traffic lights are published, from the signal
+            // table's tree, so this can be frequent.
+            std::chrono::milliseconds TRAFFIC_LIGHT_PUBLISH_FREQUENCY = 200ms;
+            // Traffic lights this close to the vehicle (meters) are
+            // candidates, and those this close to the upcoming route, or
+            // with no route, at a junction, are published.
+            const double TRAFFIC_LIGHT_RANGE = 80.0;
+            const double TRAFFIC_LIGHT_ROUTE_MARGIN = 10.0;
+            std::chrono::milliseconds MAP_LOAD_POLL_PERIOD = 100ms;
             const float GRID_RES = 0.4;
+            // The local R-tree covers this much more than the search region,
+            // and is rebuilt once the vehicle has moved this far (meters).
+            const double LOCAL_TREE_MARGIN = 20.0;
+            // Rows per task when filling the grids in parallel
+            const int GRID_TILE_ROWS = 8;
+            // Route distances at or beyond this (meters) all map to 100
+            const float ROUTE_DIST_SATURATION = 21.0 / 8.0;
 
             void clockCb(Clock::SharedPtr msg);
             TransformStamped getVehicleTf();
-            void drivableAreaGridPubTimerCb();
+            void declareGridProfiles();
+            void recordStage(int stage, std::chrono::steady_clock::time_point start,
+                             std::chrono::steady_clock::time_point end);
+            void writeTimingRows(double x, double y, std::size_t lanes);
+            void publishDiagnostics();
             void updateRouteWaypoints(Path::SharedPtr msg);
             void publishRefinedRoute();
+            void publishTrafficLights();
             void worldInfoCb(CarlaWorldInfo::SharedPtr msg);
-            std::map<odr::LaneKey, bool> getJunctionMap(std::vector<odr::LanePair> lane_polys);
+            void mapLoadTimerCb();
 
-            LineString getLaneCenterline(odr::LaneKey key);
-            std::vector<LineString> getCenterlinesFromKeys(std::vector<odr::LaneKey> keys, odr::RoutingGraph graph);
+            // A map and everything derived from it, built off the executor
+            // thread by loadMap() and adopted by adoptMap().
+            struct LoadedMap
+            {
+                std::string name;
+                bgi::rtree<odr::value, bgi::rstar<16, 4>> tree;
+                LaneGraph lane_graph;
+                LaneTable lane_table;
+                LaneRaster lane_raster;
+                SignalTable signal_table;
+                double seconds = 0.0;
+                bool from_cache = false;
+                bool cache_write_failed = false;
+            };
+            static std::unique_ptr<LoadedMap> loadMap(CarlaWorldInfo::SharedPtr msg, bool rasterize, float res,
+                                                      const std::string &cache_dir);
+            void adoptMap(std::unique_ptr<LoadedMap> loaded);
+
+            const std::vector<odr::LaneKey> &getLanePath(const odr::LaneKey &from, const odr::LaneKey &to);
+            std::vector<int32_t> getRouteLanes(const std::vector<odr::LaneKey> &keys);
 
-            rclcpp::Publisher<OccupancyGrid>::SharedPtr drivable_grid_pub_;
-            rclcpp::Publisher<OccupancyGrid>::SharedPtr junction_grid_pub_;
-            rclcpp::Publisher<OccupancyGrid>::SharedPtr route_dist_grid_pub_;
             rclcpp::Publisher<Path>::SharedPtr route_path_pub_;
             rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr route_progress_pub_;
+            rclcpp::Publisher<std_msgs::msg::Bool>::SharedPtr map_ready_pub_;
+            rclcpp::Publisher<DiagnosticArray>::SharedPtr diagnostics_pub_;
             rclcpp::Publisher<PolygonStamped>::SharedPtr traffic_light_points_pub_;
             rclcpp::Publisher<PoseStamped>::SharedPtr goal_pose_pub_;
             rclcpp::Subscription<Clock>::SharedPtr clock_sub;
             rclcpp::Subscription<Path>::SharedPtr rough_path_sub_;
             rclcpp::Subscription<CarlaWorldInfo>::SharedPtr world_info_sub;
 
-            rclcpp::TimerBase::SharedPtr drivable_area_grid_pub_timer_;
-            rclcpp::TimerBase::SharedPtr route_distance_grid_pub_timer_;
             rclcpp::TimerBase::SharedPtr traffic_light_pub_timer_;
             rclcpp::TimerBase::SharedPtr route_timer_;
+            rclcpp::TimerBase::SharedPtr map_load_timer_;
+            rclcpp::TimerBase::SharedPtr diagnostics_timer_;
 
             std::shared_ptr<tf2_ros::TransformListener> tf_listener_{nullptr};
             std::unique_ptr<tf2_ros::Buffer> tf_buffer_;
 
             Clock::SharedPtr clock_;
-            odr::OpenDriveMap *map_ = nullptr;
-            std::vector<odr::LanePair> lane_polys_;
+            bool map_ready_ = false;
+            std::future<std::unique_ptr<LoadedMap>> map_loading_;
+            bool background_map_load_;
+            // Where loaded maps are cached, or empty for no cache
+            std::string map_cache_dir_;
+            // Everything the node needs of each lane, indexed like the R-tree values
+            LaneTable lane_table_;
             std::vector<odr::Lane> lanes_in_route_;
-            std::map<odr::LaneKey, bool> road_in_junction_map_;
+            LaneGraph lane_graph_; // Built once, when the map loads
+            std::vector<int32_t> lane_path_parents_; // Scratch for LaneGraph::search()
             Path smoothed_route_msg_;
             LineString rough_route_;
             Path rough_route_msg_;
             bg::model::linestring<odr::point> route_linestring_;
             bg::model::linestring<odr::point> local_route_linestring_;
+            uint64_t local_route_version_ = 0; // Bumped when local_route_linestring_ changes
+
+            // Route resolution, reused between publishRefinedRoute() calls.
+            // Lane paths depend only on the map; route_ls_
+            // is the reoriented route for the ROI's lanes, route_keys_.
+            std::unordered_map<odr::LaneKey, std::unordered_map<odr::LaneKey, std::vector<odr::LaneKey>>> lane_path_cache_;
+            std::vector<odr::LaneKey> route_keys_;
+            LineString route_ls_;
             bgi::rtree<odr::value, bgi::rstar<16, 4>> map_wide_tree_;
-            bgi::rtree<odr::value, bgi::rstar<16, 4>> rough_route_tree_;
+
+            // The lanes around local_tree_center_, bulk-loaded from
+            // map_wide_tree_ and kept until the vehicle leaves the hysteresis
+            // box. Only used when the lane raster is not.
+            bgi::rtree<odr::value, bgi::rstar<16, 4>> local_tree_;
+            odr::point local_tree_center_;
+            double local_tree_reach_ = 0.0; // Half-width of the tree's region
+            bool local_tree_valid_ = false;
+
+            // The lane polygons rasterized at GRID_RES when the map is
+            // loaded. publishGrids() samples it instead of querying the
+            // R-tree, unless rasterize_lane_map is false.
+            bool use_lane_raster_;
+            LaneRaster lane_raster_;
+
+            // Every signal and road object, for publishTrafficLights()
+            SignalTable signal_table_;
+            std::vector<uint32_t> nearby_signals_; // Scratch for its queries
+
+            // Built once by declareGridProfiles(); timers refer to entries.
+            std::vector<GridProfile> grid_profiles_;
+            bool grid_motion_gating_;
+            bool shared_grids_;
+            double grid_regen_distance_;
+            double grid_regen_heading_;
+            std::unique_ptr<worker_pool::WorkerPool> grid_pool_;
+
+            // Per-stage latency, published on /diagnostics every second and,
+            // if "timing_csv" is set, written there for every call.
+            std::unique_ptr<trace::StageProfiler> profiler_;
+            std::vector<trace::LatencyHistogram::Snapshot> last_snapshots_;
+            int route_first_stage_;
+            std::unique_ptr<std::ofstream> timing_csv_;
+            std::vector<std::pair<int, double>> pending_timings_; // Stage, ms
+            std::unique_ptr<latency_tracker::StageRecorder> route_latency_recorder_;
+            uint64_t timing_call_ = 0;
+            bool use_route_distance_transform_;
             PolygonStamped traffic_light_points;
 
-            RouteManager rm;
+            RouteManager rm; // rough_route_, indexed for projecting ego onto it
         };
     }
 }
\ No newline at end of file
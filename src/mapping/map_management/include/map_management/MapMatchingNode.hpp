@@ -0,0 +1,76 @@
+/*
+ * Package:   map_management
+ * Filename:  MapMatchingNode.hpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ *
+ * Lane-level map matching as a service
+ */
+
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "LaneMatcher.h"
+#include "OpenDriveMap.h"
+
+#include "carla_msgs/msg/carla_world_info.hpp"
+#include "nova_msgs/srv/match_lanes.hpp"
+
+namespace navigator
+{
+    namespace planning
+    {
+        /**
+         * @brief Answers "which lane is this pose in?" for state estimation
+         * and planning, on /map_management/match_lanes.
+         *
+         * Each request is a batch of poses, so that a particle filter can
+         * score every particle against the map in one call. Poses are
+         * matched by odr::LaneMatcher, built in the background once the map
+         * arrives on /carla/world_info. Until then, every pose is unmatched.
+         */
+        class MapMatchingNode : public rclcpp::Node
+        {
+        public:
+            explicit MapMatchingNode(const rclcpp::NodeOptions &options = rclcpp::NodeOptions());
+
+        private:
+            // A parsed map and its matcher, which refers to it. The map is
+            // parsed in place, so it keeps the message it was parsed from.
+            struct LoadedMap
+            {
+                carla_msgs::msg::CarlaWorldInfo::SharedPtr world_info;
+                std::unique_ptr<odr::OpenDriveMap> map;
+                std::unique_ptr<odr::LaneMatcher> matcher;
+                double seconds = 0.0;
+            };
+            static std::unique_ptr<LoadedMap> loadMap(carla_msgs::msg::CarlaWorldInfo::SharedPtr msg, bool drivable_only,
+                                                      double cell_size);
+
+            void worldInfoCb(carla_msgs::msg::CarlaWorldInfo::SharedPtr msg);
+            void mapLoadTimerCb();
+            void matchLanes(const std::shared_ptr<nova_msgs::srv::MatchLanes::Request> request,
+                            std::shared_ptr<nova_msgs::srv::MatchLanes::Response> response);
+
+            const std::chrono::milliseconds MAP_LOAD_POLL_PERIOD{100};
+
+            bool drivable_only_;
+            double cell_size_;
+
+            rclcpp::Subscription<carla_msgs::msg::CarlaWorldInfo>::SharedPtr world_info_sub_;
+            rclcpp::Service<nova_msgs::srv::MatchLanes>::SharedPtr match_lanes_srv_;
+            rclcpp::TimerBase::SharedPtr map_load_timer_;
+
+            std::future<std::unique_ptr<LoadedMap>> map_loading_;
+            std::unique_ptr<LoadedMap> loaded_;
+        };
+    }
+}
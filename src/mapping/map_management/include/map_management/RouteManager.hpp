@@ -35,13 +35,84 @@ namespace navigator
         typedef bg::model::point<float, 2, bg::cs::cartesian> BoostPoint;
         typedef boost::geometry::model::linestring<BoostPoint> LineString;
 
+        typedef bg::model::segment<BoostPoint> Segment;
+
+        /**
+         * @brief A route as an arc-length-indexed polyline, with the vehicle's
+         * place on it.
+         *
+         * Each route point has its distance along the route, so points and
+         * slices at a given arc length are found by binary search. Segments
+         * are also kept in an R-tree. project() first searches a few segments
+         * ahead of the last projection (the cursor), so following the route
+         * costs amortised O(1). It only falls back to the R-tree, O(log n),
+         * when the vehicle is no longer near that stretch.
+         */
         class RouteManager
         {
         public:
+            // Where a point lies on the route
+            struct Projection
+            {
+                float s = 0.0f;          // Arc length along the route (meters)
+                std::size_t segment = 0; // From point segment to point segment + 1
+                BoostPoint point;        // The closest route point
+                float distance = 0.0f;   // From the projected point (meters)
+            };
+
             // Constructor
             RouteManager();
 
-            LineString getRoute(const LineString rough, const BoostPoint pos);
+            /**
+             * @brief Replace the route and reset the cursor to its start.
+             */
+            void setRoute(const LineString &route);
+
+            bool empty() const { return route_.empty(); }
+            const LineString &route() const { return route_; }
+            float length() const { return s_.empty() ? 0.0f : s_.back(); }
+
+            /**
+             * @brief Project a position onto the route and move the cursor there.
+             */
+            Projection project(const BoostPoint &pos);
+
+            const Projection &cursor() const { return cursor_; }
+
+            // Fraction of the route behind the cursor, in [0, 1].
+            float progress() const;
+
+            // The route point at arc length s, clamped to the route.
+            BoostPoint pointAt(float s) const;
+
+            // The route from arc length s_from to s_to, with interpolated ends.
+            LineString slice(float s_from, float s_to) const;
+
+            // The next `distance` meters of route past the cursor.
+            LineString lookahead(float distance) const { return slice(cursor_.s, cursor_.s + distance); }
+
+            /**
+             * @brief Returns the rest of the route, given our position.
+             *
+             * @param rough A rough route. Replaces the current one if it differs.
+             * @param pos Our current position
+             * @return The route from the projection of pos to its end
+             */
+            LineString getRoute(const LineString &rough, const BoostPoint &pos);
+
+        private:
+            // Segments searched past the cursor before falling back to the R-tree
+            const std::size_t CURSOR_WINDOW = 16;
+            // A cursor match farther than this from the vehicle is not trusted (meters)
+            const float CURSOR_TOLERANCE = 5.0;
+
+            std::size_t segmentAt(float s) const;
+            Projection projectOnto(const BoostPoint &pos, std::size_t segment) const;
+
+            LineString route_;
+            std::vector<float> s_; // Arc length of each route point
+            bgi::rtree<std::pair<Segment, unsigned>, bgi::rstar<16, 4>> segment_tree_;
+            Projection cursor_;
         };
     }
-}
\ No newline at end of file
+}
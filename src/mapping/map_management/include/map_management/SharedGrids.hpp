@@ -0,0 +1,153 @@
+/*
+ * Package:   map_management
+ * Filename:  SharedGrids.hpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ *
+ * The map grids in POSIX shared memory, for consumers on the same host
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace navigator
+{
+    namespace planning
+    {
+        /**
+         * Layout of a shared grid segment, in host byte order:
+         *
+         *   SharedGridHeader
+         *   tiles_x * tiles_y tiles, row-major, each tile_bytes long:
+         *     SharedTileHeader
+         *     layer_count layers of tile_size * tile_size int8 cells,
+         *     row-major. Cells past the grid's edge are -1.
+         *
+         * Layers are SharedGridLayer. Cell (col, row) of the grid is cell
+         * (col % tile_size, row % tile_size) of tile (col / tile_size,
+         * row / tile_size). Values are those of the matching OccupancyGrid.
+         *
+         * Every tile, and the header's frame fields, are guarded by a
+         * seqlock. A reader reads seq, copies, and reads seq again. The copy
+         * is good if both reads matched and were even.
+         */
+        enum SharedGridLayer : uint32_t
+        {
+            SHARED_DRIVABLE,
+            SHARED_JUNCTION,
+            SHARED_ROUTE_DISTANCE,
+            SHARED_LAYER_COUNT
+        };
+
+        struct SharedGridHeader
+        {
+            char magic[8]; // "NAVGRID1"
+            uint32_t version;
+            uint32_t layer_count;
+            uint32_t width; // Cells
+            uint32_t height;
+            uint32_t tile_size; // Cells per tile side
+            uint32_t tiles_x;
+            uint32_t tiles_y;
+            uint32_t tile_bytes;
+            float resolution; // Meters per cell
+            float origin_x;   // Of cell (0, 0) in base_link (meters)
+            float origin_y;
+            std::atomic<uint32_t> seq; // Guards frame and stamp_ns
+            uint64_t frame;            // Count of frames written
+            int64_t stamp_ns;          // Stamp of the latest frame
+        };
+
+        struct SharedTileHeader
+        {
+            std::atomic<uint32_t> seq;
+            uint32_t padding;
+            uint64_t frame; // Frame in which the tile last changed
+        };
+
+        /**
+         * @brief Writes grids into a shared memory segment, one tile at a time.
+         *
+         * Tiles whose cells didn't change are skipped, so readers polling a
+         * tile's frame only copy what changed. The segment is removed when
+         * the writer is destroyed. Readers that still have it mapped keep
+         * their view.
+         */
+        class SharedGridWriter
+        {
+        public:
+            /**
+             * @param name Segment name, e.g. "/navigator_grids_local"
+             * @throws std::runtime_error if the segment can't be created
+             */
+            SharedGridWriter(const std::string &name, uint32_t width, uint32_t height, float resolution,
+                             float origin_x, float origin_y, uint32_t tile_size = 32);
+            ~SharedGridWriter();
+
+            SharedGridWriter(const SharedGridWriter &) = delete;
+            SharedGridWriter &operator=(const SharedGridWriter &) = delete;
+
+            uint32_t width() const { return header_->width; }
+            uint32_t height() const { return header_->height; }
+
+            /**
+             * @brief Publish a frame.
+             *
+             * @param layers SHARED_LAYER_COUNT row-major grids of width() *
+             * height() cells. A null layer is left as it was.
+             */
+            void write(const int8_t *const layers[SHARED_LAYER_COUNT], int64_t stamp_ns);
+
+            // Restamp the last frame without changing any cell.
+            void touch(int64_t stamp_ns);
+
+        private:
+            void beginFrame(int64_t stamp_ns);
+
+            std::string name_;
+            std::size_t size_;
+            SharedGridHeader *header_;
+            char *tiles_;
+        };
+
+        /**
+         * @brief Reads tiles from a segment made by SharedGridWriter.
+         */
+        class SharedGridReader
+        {
+        public:
+            // @throws std::runtime_error if the segment is missing or malformed
+            explicit SharedGridReader(const std::string &name);
+            ~SharedGridReader();
+
+            SharedGridReader(const SharedGridReader &) = delete;
+            SharedGridReader &operator=(const SharedGridReader &) = delete;
+
+            const SharedGridHeader &header() const { return *header_; }
+
+            /**
+             * @brief Copy one layer of a tile.
+             *
+             * @param out tile_size * tile_size cells
+             * @param frame Set to the frame in which the tile last changed
+             * @return False if a write was in progress. Retry later.
+             */
+            bool readTile(uint32_t tile_x, uint32_t tile_y, SharedGridLayer layer, int8_t *out, uint64_t &frame) const;
+
+            /**
+             * @return False if a write was in progress. Retry later.
+             */
+            bool readFrame(uint64_t &frame, int64_t &stamp_ns) const;
+
+        private:
+            std::size_t size_;
+            const SharedGridHeader *header_;
+            const char *tiles_;
+        };
+    }
+}
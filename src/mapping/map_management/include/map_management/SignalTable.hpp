@@ -0,0 +1,79 @@
+/*
+ * Package:   map_management
+ * Filename:  SignalTable.hpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ *
+ * The signals and road objects of a map, indexed by position
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/geometry/index/rtree.hpp>
+
+#include "OpenDriveMap.h"
+
+namespace navigator
+{
+    namespace planning
+    {
+        /**
+         * @brief Where every signal and road object of a map stands, with
+         * a packed R-tree for range queries around the vehicle.
+         *
+         * Built once when the map loads, so that finding the traffic lights
+         * ahead costs a tree query rather than a walk over every road. Each
+         * entry keeps its position on the road surface, its flags and an
+         * interned OpenDRIVE type.
+         */
+        class SignalTable
+        {
+        public:
+            // Entry flags
+            constexpr static uint8_t SIGNAL = 1;        // A <signal>, rather than an <object>
+            constexpr static uint8_t TRAFFIC_LIGHT = 2; // A dynamic signal, or of type 1000001
+            constexpr static uint8_t AT_JUNCTION = 4;   // See JUNCTION_APPROACH
+
+            // Signals on a junction's roads, or this close (meters, along s)
+            // to the end of a road that leads into a junction, are at it.
+            constexpr static double JUNCTION_APPROACH = 30.0;
+
+            SignalTable() = default;
+            explicit SignalTable(const odr::OpenDriveMap &map);
+
+            std::size_t size() const { return flags_.size(); }
+            bool empty() const { return flags_.empty(); }
+
+            const odr::point &position(std::size_t k) const { return points_[k]; }
+            float z(std::size_t k) const { return z_[k]; }
+            uint8_t flags(std::size_t k) const { return flags_[k]; }
+            const std::string &type(std::size_t k) const { return type_names_[type_[k]]; }
+
+            /**
+             * @brief Append the entries within `radius` of (x, y) that have
+             * every flag in `flags` to `out`, in no particular order.
+             */
+            void query(double x, double y, double radius, uint8_t flags, std::vector<uint32_t> &out) const;
+
+        private:
+            friend class MapCache;
+
+            // Bulk-load tree_ from points_.
+            void buildTree();
+
+            std::vector<odr::point> points_;
+            std::vector<float> z_;
+            std::vector<uint8_t> flags_;
+            std::vector<uint16_t> type_;
+            std::vector<std::string> type_names_;
+            bgi::rtree<std::pair<odr::point, uint32_t>, bgi::rstar<16, 4>> tree_;
+        };
+    }
+}
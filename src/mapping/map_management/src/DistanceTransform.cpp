@@ -0,0 +1,142 @@
+/*
+ * Package:   map_management
+ * Filename:  DistanceTransform.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "map_management/DistanceTransform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace navigator::planning;
+
+namespace
+{
+    /**
+     * One-dimensional squared distance transform of the n samples
+     * f[0], f[stride], ... written to d[0..n), with the sample each value
+     * came from in from[0..n). v and z are scratch space of n and n + 1
+     * elements.
+     */
+    void transformLine(const float *f, int n, int stride, float *d, int *from, int *v, float *z)
+    {
+        const float inf = std::numeric_limits<float>::infinity();
+        auto value = [&](int q)
+        { return f[q * stride] + float(q) * float(q); };
+
+        // Lower envelope of the parabolas rooted at each sample.
+        int k = 0;
+        v[0] = 0;
+        z[0] = -inf;
+        z[1] = inf;
+        for (int q = 1; q < n; q++)
+        {
+            float s = (value(q) - value(v[k])) / (2.0f * (q - v[k]));
+            while (s <= z[k])
+            {
+                k--;
+                s = (value(q) - value(v[k])) / (2.0f * (q - v[k]));
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = inf;
+        }
+
+        // Read the envelope back at every sample.
+        k = 0;
+        for (int q = 0; q < n; q++)
+        {
+            while (z[k + 1] < q)
+                k++;
+            const float dq = float(q - v[k]);
+            d[q] = dq * dq + f[v[k] * stride];
+            from[q] = v[k];
+        }
+    }
+}
+
+void navigator::planning::markSegment(std::vector<int> &sites, int width, int height,
+                                      float c0, float r0, float c1, float r1, int label)
+{
+    // Clip to the grid's extent (Liang-Barsky).
+    const float dc = c1 - c0, dr = r1 - r0;
+    float t0 = 0.0f, t1 = 1.0f;
+    const float p[4] = {-dc, dc, -dr, dr};
+    const float q[4] = {c0 + 0.5f, width - 0.5f - c0, r0 + 0.5f, height - 0.5f - r0};
+    for (int e = 0; e < 4; e++)
+    {
+        if (p[e] == 0.0f)
+        {
+            if (q[e] < 0.0f)
+                return;
+            continue;
+        }
+        const float t = q[e] / p[e];
+        if (p[e] < 0.0f)
+            t0 = std::max(t0, t);
+        else
+            t1 = std::min(t1, t);
+    }
+    if (t0 > t1)
+        return;
+
+    // Sample at most half a cell apart, so no crossed cell is skipped
+    // (bar corner clips, which the transform absorbs).
+    const float length = std::hypot(dc, dr) * (t1 - t0);
+    const int steps = int(std::ceil(2.0f * length)) + 1;
+    for (int s = 0; s <= steps; s++)
+    {
+        const float t = t0 + (t1 - t0) * s / steps;
+        const int c = std::clamp(int(std::lround(c0 + t * dc)), 0, width - 1);
+        const int r = std::clamp(int(std::lround(r0 + t * dr)), 0, height - 1);
+        sites[std::size_t(r) * width + c] = label;
+    }
+}
+
+void navigator::planning::squaredDistanceTransform(std::vector<float> &grid, int width, int height,
+                                                   std::vector<int> *nearest)
+{
+    const int n = std::max(width, height);
+    std::vector<float> d(n), z(n + 1);
+    std::vector<int> v(n), from(n);
+
+    // Columns, then rows. The column pass leaves each cell's nearest site
+    // row in best_row; the row pass picks the best column.
+    std::vector<int> best_row(nearest != nullptr ? grid.size() : 0);
+    for (int c = 0; c < width; c++)
+    {
+        transformLine(&grid[c], height, width, d.data(), from.data(), v.data(), z.data());
+        for (int r = 0; r < height; r++)
+        {
+            grid[std::size_t(r) * width + c] = d[r];
+            if (nearest != nullptr)
+                best_row[std::size_t(r) * width + c] = from[r];
+        }
+    }
+
+    if (nearest != nullptr)
+        nearest->resize(grid.size());
+    for (int r = 0; r < height; r++)
+    {
+        float *row = &grid[std::size_t(r) * width];
+        transformLine(row, width, 1, d.data(), from.data(), v.data(), z.data());
+        std::copy(d.begin(), d.begin() + width, row);
+
+        if (nearest != nullptr)
+        {
+            for (int c = 0; c < width; c++)
+            {
+                const int site_c = from[c];
+                const int site_r = best_row[std::size_t(r) * width + site_c];
+                (*nearest)[std::size_t(r) * width + c] =
+                    row[c] < 0.5f * DT_FAR ? site_r * width + site_c : -1;
+            }
+        }
+    }
+}
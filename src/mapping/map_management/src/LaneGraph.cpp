@@ -0,0 +1,85 @@
+/*
+ * Package:   map_management
+ * Filename:  LaneGraph.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "map_management/LaneGraph.hpp"
+
+#include <algorithm>
+
+using namespace navigator::planning;
+
+LaneGraph::LaneGraph(const odr::RoutingGraph &graph)
+{
+    auto add_lane = [this](const odr::LaneKey &key)
+    {
+        if (ids_.emplace(key, int32_t(keys_.size())).second)
+            keys_.push_back(key);
+    };
+
+    for (const odr::RoutingGraphEdge &edge : graph.edges)
+    {
+        add_lane(edge.from);
+        add_lane(edge.to);
+    }
+
+    offsets_.reserve(keys_.size() + 1);
+    neighbours_.reserve(2 * graph.edges.size());
+    for (const odr::LaneKey &key : keys_)
+    {
+        for (const odr::LaneKey &n : graph.get_lane_predecessors(key))
+            neighbours_.push_back(ids_.at(n));
+        for (const odr::LaneKey &n : graph.get_lane_successors(key))
+            neighbours_.push_back(ids_.at(n));
+        offsets_.push_back(uint32_t(neighbours_.size()));
+    }
+
+    reserveScratch();
+}
+
+void LaneGraph::reserveScratch()
+{
+    visited_.assign((keys_.size() + 63) / 64, 0);
+    queue_.reserve(keys_.size());
+}
+
+int32_t LaneGraph::id(const odr::LaneKey &key) const
+{
+    auto found = ids_.find(key);
+    return found == ids_.end() ? NO_LANE : found->second;
+}
+
+bool LaneGraph::search(int32_t from, int32_t to, std::vector<int32_t> &parents)
+{
+    std::fill(visited_.begin(), visited_.end(), 0);
+    parents.resize(keys_.size());
+
+    // queue_ never holds a lane twice, so it can't outgrow its reservation.
+    queue_.clear();
+    queue_.push_back(from);
+    visited_[from >> 6] |= uint64_t(1) << (from & 63);
+    parents[from] = NO_LANE;
+
+    for (std::size_t head = 0; head < queue_.size(); head++)
+    {
+        const int32_t v = queue_[head];
+        if (v == to)
+            return true;
+
+        for (const int32_t *w = neighboursBegin(v); w != neighboursEnd(v); w++)
+        {
+            uint64_t &word = visited_[*w >> 6];
+            const uint64_t bit = uint64_t(1) << (*w & 63);
+            if (word & bit)
+                continue;
+            word |= bit;
+            parents[*w] = v;
+            queue_.push_back(*w);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,127 @@
+/*
+ * Package:   map_management
+ * Filename:  LaneRaster.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "map_management/LaneRaster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace navigator::planning;
+
+LaneRaster::LaneRaster(const LaneTable &lanes, float res)
+    : res_(res), inv_res_(1.0f / res)
+{
+    if (lanes.empty())
+        return;
+
+    // Bounding box of the whole map.
+    float min_x = std::numeric_limits<float>::max(), min_y = min_x;
+    float max_x = std::numeric_limits<float>::lowest(), max_y = max_x;
+    for (std::size_t k = 0; k < lanes.size(); k++)
+    {
+        const odr::point *ring = lanes.vertices(k);
+        for (std::size_t v = 0; v < lanes.vertexCount(k); v++)
+        {
+            min_x = std::min(min_x, ring[v].get<0>());
+            min_y = std::min(min_y, ring[v].get<1>());
+            max_x = std::max(max_x, ring[v].get<0>());
+            max_y = std::max(max_y, ring[v].get<1>());
+        }
+    }
+    if (min_x > max_x)
+        return; // No points at all
+
+    origin_x_ = std::floor(min_x * inv_res_) * res_;
+    origin_y_ = std::floor(min_y * inv_res_) * res_;
+    cols_ = int((max_x - origin_x_) * inv_res_) + 1;
+    rows_ = int((max_y - origin_y_) * inv_res_) + 1;
+    tiles_x_ = (cols_ + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y_ = (rows_ + TILE_SIZE - 1) / TILE_SIZE;
+    tile_index_.assign(std::size_t(tiles_x_) * tiles_y_, -1);
+
+    std::vector<float> crossings;
+    for (std::size_t k = 0; k < lanes.size(); k++)
+    {
+        const odr::point *ring = lanes.vertices(k);
+        const std::size_t n = lanes.vertexCount(k);
+        if (n < 3)
+            continue;
+
+        const bool driving = lanes.isDriving(k);
+        const bool in_junction = lanes.inJunction(k);
+
+        float ring_min_y = std::numeric_limits<float>::max(), ring_max_y = std::numeric_limits<float>::lowest();
+        for (std::size_t v = 0; v < n; v++)
+        {
+            ring_min_y = std::min(ring_min_y, ring[v].get<1>());
+            ring_max_y = std::max(ring_max_y, ring[v].get<1>());
+        }
+
+        // Rows whose center lies within the ring's vertical extent.
+        const int r_begin = std::max(0, int(std::ceil((ring_min_y - origin_y_) * inv_res_ - 0.5f)));
+        const int r_end = std::min(rows_ - 1, int(std::floor((ring_max_y - origin_y_) * inv_res_ - 0.5f)));
+
+        for (int r = r_begin; r <= r_end; r++)
+        {
+            const float y = origin_y_ + (r + 0.5f) * res_;
+
+            // Where the ring's edges cross this row. Each edge counts on the
+            // half-open interval [lower y, upper y), so vertices shared by
+            // two edges are not counted twice.
+            crossings.clear();
+            for (std::size_t e = 0; e < n; e++)
+            {
+                const odr::point &a = ring[e];
+                const odr::point &b = ring[(e + 1) % n];
+                const float ay = a.get<1>(), by = b.get<1>();
+                if ((ay <= y) == (by <= y))
+                    continue;
+                const float t = (y - ay) / (by - ay);
+                crossings.push_back(a.get<0>() + t * (b.get<0>() - a.get<0>()));
+            }
+            std::sort(crossings.begin(), crossings.end());
+
+            // Fill the cells whose centers lie between pairs of crossings.
+            for (std::size_t p = 0; p + 1 < crossings.size(); p += 2)
+            {
+                const int c_begin = std::max(0, int(std::ceil((crossings[p] - origin_x_) * inv_res_ - 0.5f)));
+                const int c_end = std::min(cols_ - 1, int(std::floor((crossings[p + 1] - origin_x_) * inv_res_ - 0.5f)));
+
+                for (int c = c_begin; c <= c_end; c++)
+                {
+                    Tile &tile = tileFor(c, r);
+                    const std::size_t i = std::size_t(r % TILE_SIZE) * TILE_SIZE + c % TILE_SIZE;
+
+                    // Driving lanes take precedence over other overlapping lanes.
+                    if (tile.lanes[i] == NO_LANE || (driving && !(tile.flags[i] & DRIVABLE)))
+                        tile.lanes[i] = int32_t(k);
+                    if (driving)
+                        tile.flags[i] |= DRIVABLE;
+                    if (in_junction)
+                        tile.flags[i] |= JUNCTION;
+                }
+            }
+        }
+    }
+}
+
+LaneRaster::Tile &LaneRaster::tileFor(int c, int r)
+{
+    int32_t &t = tile_index_[std::size_t(r / TILE_SIZE) * tiles_x_ + c / TILE_SIZE];
+    if (t < 0)
+    {
+        t = int32_t(tiles_.size());
+        Tile tile;
+        tile.flags.assign(TILE_SIZE * TILE_SIZE, 0);
+        tile.lanes.assign(TILE_SIZE * TILE_SIZE, NO_LANE);
+        tiles_.push_back(std::move(tile));
+    }
+    return tiles_[t];
+}
@@ -0,0 +1,159 @@
+/*
+ * Package:   map_management
+ * Filename:  LaneTable.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "map_management/LaneTable.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace navigator::planning;
+
+LaneTable::LaneTable(const odr::OpenDriveMap &map, const std::vector<odr::LanePair> &lane_polys)
+{
+    keys_.reserve(lane_polys.size());
+    index_.reserve(lane_polys.size());
+    type_.reserve(lane_polys.size());
+    in_junction_.reserve(lane_polys.size());
+    ring_start_.reserve(lane_polys.size() + 1);
+    centerline_start_.reserve(lane_polys.size() + 1);
+
+    for (const odr::LanePair &pair : lane_polys)
+    {
+        const odr::Lane &lane = pair.first;
+        const odr::Road &road = map.road(lane.key.road_index);
+
+        index_.emplace(lane.key, int32_t(keys_.size()));
+        keys_.push_back(lane.key);
+
+        auto name = std::find(type_names_.begin(), type_names_.end(), lane.type);
+        if (name == type_names_.end())
+            name = type_names_.insert(type_names_.end(), lane.type);
+        type_.push_back(uint8_t(name - type_names_.begin()));
+
+        in_junction_.push_back(road.junction != "-1" && lane.type == "driving");
+
+        vertices_.insert(vertices_.end(), pair.second.begin(), pair.second.end());
+        ring_start_.push_back(uint32_t(vertices_.size()));
+
+        const odr::Line3D outer_border = road.get_lane_border_line(lane, 1.0, true);
+        const odr::Line3D inner_border = road.get_lane_border_line(lane, 1.0, false);
+        for (std::size_t i = 0; i < outer_border.size(); i++)
+        {
+            const odr::Vec3D &outer_pt = outer_border[i];
+            const odr::Vec3D &inner_pt = inner_border[i];
+            centerline_points_.emplace_back((outer_pt[0] + inner_pt[0]) / 2, (outer_pt[1] + inner_pt[1]) / 2);
+        }
+        centerline_start_.push_back(uint32_t(centerline_points_.size()));
+    }
+
+    measureCenterlines();
+}
+
+void LaneTable::measureCenterlines()
+{
+    centerline_s_.resize(centerline_points_.size());
+    for (std::size_t k = 0; k < size(); k++)
+    {
+        const odr::point *points = centerline(k);
+        float *s = centerline_s_.data() + centerline_start_[k];
+        for (std::size_t i = 0; i < centerlineCount(k); i++)
+        {
+            if (i == 0)
+            {
+                s[i] = 0.0f;
+                continue;
+            }
+            const float dx = points[i].get<0>() - points[i - 1].get<0>();
+            const float dy = points[i].get<1>() - points[i - 1].get<1>();
+            s[i] = s[i - 1] + std::hypot(dx, dy);
+        }
+    }
+}
+
+float LaneTable::centerlineLength(std::size_t k) const
+{
+    const std::size_t n = centerlineCount(k);
+    return n == 0 ? 0.0f : centerlineS(k)[n - 1];
+}
+
+std::size_t LaneTable::centerlineSegment(std::size_t k, float s) const
+{
+    const std::size_t n = centerlineCount(k);
+    if (n < 2)
+        return 0;
+    const float *begin = centerlineS(k);
+    const std::size_t after = std::upper_bound(begin, begin + n, s) - begin;
+    return std::clamp<std::size_t>(after, 1, n - 1) - 1;
+}
+
+odr::point LaneTable::centerlinePoint(std::size_t k, float s) const
+{
+    const odr::point *points = centerline(k);
+    if (centerlineCount(k) < 2)
+        return points[0];
+
+    const std::size_t i = centerlineSegment(k, s);
+    const float s0 = centerlineS(k)[i];
+    const float s1 = centerlineS(k)[i + 1];
+    const float t = s1 > s0 ? std::clamp((s - s0) / (s1 - s0), 0.0f, 1.0f) : 0.0f;
+    return odr::point(points[i].get<0>() + t * (points[i + 1].get<0>() - points[i].get<0>()),
+                      points[i].get<1>() + t * (points[i + 1].get<1>() - points[i].get<1>()));
+}
+
+void LaneTable::centerlineSlice(std::size_t k, float s_from, float s_to, std::vector<odr::point> &out) const
+{
+    const std::size_t n = centerlineCount(k);
+    if (n == 0)
+        return;
+
+    const float length = centerlineLength(k);
+    const float lo = std::clamp(std::min(s_from, s_to), 0.0f, length);
+    const float hi = std::clamp(std::max(s_from, s_to), 0.0f, length);
+
+    // Points strictly between the ends are copied as they are.
+    const float *s = centerlineS(k);
+    const std::size_t first = std::upper_bound(s, s + n, lo) - s;
+    const std::size_t last = std::max(first, std::size_t(std::lower_bound(s, s + n, hi) - s));
+    const odr::point *points = centerline(k);
+
+    const std::size_t start = out.size();
+    out.push_back(centerlinePoint(k, lo));
+    out.insert(out.end(), points + first, points + last);
+    if (hi > lo)
+        out.push_back(centerlinePoint(k, hi));
+    if (s_from > s_to)
+        std::reverse(out.begin() + start, out.end());
+}
+
+int32_t LaneTable::index(const odr::LaneKey &key) const
+{
+    auto found = index_.find(key);
+    return found == index_.end() ? NO_LANE : found->second;
+}
+
+bool LaneTable::contains(std::size_t k, double x, double y) const
+{
+    const odr::point *ring = vertices(k);
+    const std::size_t n = vertexCount(k);
+
+    // The closing edge is degenerate for closed rings, and skipped below.
+    bool inside = false;
+    for (std::size_t e = 0; e < n; e++)
+    {
+        const odr::point &a = ring[e];
+        const odr::point &b = ring[(e + 1) % n];
+        const double ax = a.get<0>(), ay = a.get<1>();
+        const double bx = b.get<0>(), by = b.get<1>();
+        if ((ay <= y) == (by <= y))
+            continue;
+        if (x < ax + (y - ay) / (by - ay) * (bx - ax))
+            inside = !inside;
+    }
+    return inside;
+}
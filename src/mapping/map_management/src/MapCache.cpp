@@ -0,0 +1,478 @@
+/*
+ * Package:   map_management
+ * Filename:  MapCache.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "map_management/MapCache.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace navigator::planning;
+
+namespace
+{
+    constexpr char MAGIC[8] = {'N', 'A', 'V', 'M', 'A', 'P', 'C', '1'};
+    // Bump whenever the layout below or the data it holds changes.
+    constexpr uint32_t VERSION = 3;
+
+    enum Section : uint32_t
+    {
+        LANES,             // LaneRecord per lane
+        STRINGS,           // Road IDs, type names and signal types, unterminated
+        TYPE_NAMES,        // StringRef per type id
+        RING_STARTS,       // uint32_t per lane, plus one
+        VERTICES,          // float x, y
+        CENTERLINE_STARTS, // uint32_t per lane, plus one
+        CENTERLINE_POINTS, // float x, y
+        ENVELOPES,         // EnvelopeRecord per lane
+        GRAPH_LANES,       // int32_t lane index per graph node
+        GRAPH_OFFSETS,     // uint32_t per graph node, plus one
+        GRAPH_NEIGHBOURS,  // int32_t graph node
+        SIGNALS,           // SignalRecord per signal or object
+        SIGNAL_TYPES,      // StringRef per signal type id
+        SECTION_COUNT
+    };
+
+    struct SectionEntry
+    {
+        uint64_t offset;
+        uint64_t bytes;
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t section_count;
+        uint64_t hash;
+        SectionEntry sections[SECTION_COUNT];
+    };
+
+    struct StringRef
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct LaneRecord
+    {
+        double lanesection_s0;
+        StringRef road_id;
+        int32_t lane_id;
+        uint8_t type;
+        uint8_t in_junction;
+        uint8_t padding[2];
+        uint32_t road_index; // The key's, so loaded keys hash like the map's
+        uint32_t lanesection_index;
+    };
+    static_assert(sizeof(LaneRecord) == 32, "LaneRecord must have no implicit padding");
+
+    struct EnvelopeRecord
+    {
+        float min_x, min_y, max_x, max_y;
+        uint32_t lane;
+    };
+
+    struct SignalRecord
+    {
+        float x, y, z;
+        uint16_t type;
+        uint8_t flags;
+        uint8_t padding;
+    };
+    static_assert(sizeof(SignalRecord) == 16, "SignalRecord must have no implicit padding");
+
+    constexpr uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+    /**
+     * Sections of a file being written, each built up as raw bytes.
+     */
+    class SectionWriter
+    {
+    public:
+        template <typename T>
+        void put(Section s, const T &value)
+        {
+            const char *bytes = reinterpret_cast<const char *>(&value);
+            data_[s].insert(data_[s].end(), bytes, bytes + sizeof(T));
+        }
+
+        void putPoints(Section s, const odr::point *points, std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                const float xy[2] = {points[i].get<0>(), points[i].get<1>()};
+                put(s, xy);
+            }
+        }
+
+        StringRef putString(const std::string &str)
+        {
+            StringRef ref{uint32_t(data_[STRINGS].size()), uint32_t(str.size())};
+            data_[STRINGS].insert(data_[STRINGS].end(), str.begin(), str.end());
+            return ref;
+        }
+
+        bool save(const std::string &path, uint64_t hash) const
+        {
+            Header header{};
+            std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.section_count = SECTION_COUNT;
+            header.hash = hash;
+
+            uint64_t offset = align8(sizeof(Header));
+            for (uint32_t s = 0; s < SECTION_COUNT; s++)
+            {
+                header.sections[s] = {offset, data_[s].size()};
+                offset = align8(offset + data_[s].size());
+            }
+
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            const char zeros[8] = {};
+            out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+            out.write(zeros, align8(sizeof(Header)) - sizeof(Header));
+            for (uint32_t s = 0; s < SECTION_COUNT; s++)
+            {
+                out.write(data_[s].data(), data_[s].size());
+                out.write(zeros, align8(data_[s].size()) - data_[s].size());
+            }
+            return bool(out.flush());
+        }
+
+    private:
+        std::array<std::vector<char>, SECTION_COUNT> data_;
+    };
+
+    /**
+     * A mapped cache file, with bounds-checked access to its sections.
+     */
+    class SectionReader
+    {
+    public:
+        SectionReader(const char *data, std::size_t size) : data_(data), size_(size) {}
+
+        bool open(uint64_t hash)
+        {
+            if (size_ < sizeof(Header))
+                return false;
+            std::memcpy(&header_, data_, sizeof(Header));
+            if (std::memcmp(header_.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+                header_.version != VERSION || header_.section_count != SECTION_COUNT ||
+                header_.hash != hash)
+                return false;
+
+            for (const SectionEntry &section : header_.sections)
+            {
+                if (section.offset % 8 != 0 || section.offset > size_ || section.bytes > size_ - section.offset)
+                    return false;
+            }
+            return true;
+        }
+
+        // Offsets are 8-byte aligned within a page-aligned mapping, so
+        // every element type here is suitably aligned.
+        template <typename T>
+        bool get(Section s, const T *&items, std::size_t &count) const
+        {
+            const SectionEntry &section = header_.sections[s];
+            if (section.bytes % sizeof(T) != 0)
+                return false;
+            items = reinterpret_cast<const T *>(data_ + section.offset);
+            count = section.bytes / sizeof(T);
+            return true;
+        }
+
+    private:
+        const char *data_;
+        std::size_t size_;
+        Header header_;
+    };
+
+    /**
+     * Whether `starts` holds n + 1 non-decreasing offsets ending at `total`.
+     */
+    bool validStarts(const uint32_t *starts, std::size_t count, std::size_t n, std::size_t total)
+    {
+        if (count != n + 1 || starts[0] != 0 || starts[n] != total)
+            return false;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            if (starts[i] > starts[i + 1])
+                return false;
+        }
+        return true;
+    }
+
+    void readPoints(const float *xy, std::size_t count, std::vector<odr::point> &points)
+    {
+        points.reserve(count);
+        for (std::size_t i = 0; i < count; i++)
+            points.emplace_back(xy[2 * i], xy[2 * i + 1]);
+    }
+}
+
+uint64_t MapCache::hash(const std::string &opendrive)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : opendrive)
+    {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::string MapCache::path(uint64_t hash) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 ".bin", hash);
+    return (std::filesystem::path(dir_) / name).string();
+}
+
+bool MapCache::write(uint64_t hash, const LaneTable &table, const LaneGraph &graph,
+                     const std::vector<odr::value> &envelopes, const SignalTable &signals) const
+{
+    SectionWriter writer;
+
+    for (std::size_t k = 0; k < table.size(); k++)
+    {
+        const odr::LaneKey &key = table.key(k);
+        LaneRecord record{};
+        record.lanesection_s0 = key.lanesection_s0;
+        record.road_id = writer.putString(key.road_id);
+        record.lane_id = key.lane_id;
+        record.road_index = key.road_index;
+        record.lanesection_index = key.lanesection_index;
+        record.type = table.type(k);
+        record.in_junction = table.inJunction(k);
+        writer.put(LANES, record);
+    }
+    for (const std::string &name : table.type_names_)
+        writer.put(TYPE_NAMES, writer.putString(name));
+
+    for (uint32_t start : table.ring_start_)
+        writer.put(RING_STARTS, start);
+    writer.putPoints(VERTICES, table.vertices_.data(), table.vertices_.size());
+    for (uint32_t start : table.centerline_start_)
+        writer.put(CENTERLINE_STARTS, start);
+    writer.putPoints(CENTERLINE_POINTS, table.centerline_points_.data(), table.centerline_points_.size());
+
+    for (const odr::value &envelope : envelopes)
+    {
+        const odr::point &min = envelope.first.min_corner();
+        const odr::point &max = envelope.first.max_corner();
+        writer.put(ENVELOPES, EnvelopeRecord{min.get<0>(), min.get<1>(), max.get<0>(), max.get<1>(), envelope.second});
+    }
+
+    // Graph nodes are stored as table indices, so their keys needn't be.
+    for (const odr::LaneKey &key : graph.keys_)
+    {
+        const int32_t k = table.index(key);
+        if (k == LaneTable::NO_LANE)
+            return false;
+        writer.put(GRAPH_LANES, k);
+    }
+    for (uint32_t offset : graph.offsets_)
+        writer.put(GRAPH_OFFSETS, offset);
+    for (int32_t neighbour : graph.neighbours_)
+        writer.put(GRAPH_NEIGHBOURS, neighbour);
+
+    for (std::size_t k = 0; k < signals.size(); k++)
+    {
+        const odr::point &pt = signals.position(k);
+        writer.put(SIGNALS, SignalRecord{pt.get<0>(), pt.get<1>(), signals.z(k), signals.type_[k], signals.flags(k), 0});
+    }
+    for (const std::string &name : signals.type_names_)
+        writer.put(SIGNAL_TYPES, writer.putString(name));
+
+    std::error_code error;
+    std::filesystem::create_directories(dir_, error);
+    if (error)
+        return false;
+
+    const std::string final_path = path(hash);
+    const std::string temp_path = final_path + ".tmp" + std::to_string(getpid());
+    if (!writer.save(temp_path, hash) || std::rename(temp_path.c_str(), final_path.c_str()) != 0)
+    {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MapCache::read(uint64_t hash, LaneTable &table, LaneGraph &graph,
+                    std::vector<odr::value> &envelopes, SignalTable &signals) const
+{
+    const int fd = ::open(path(hash).c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < off_t(sizeof(Header)))
+    {
+        ::close(fd);
+        return false;
+    }
+    const std::size_t size = std::size_t(st.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    // Parse into locals, so a bad file leaves the outputs untouched.
+    LaneTable new_table;
+    LaneGraph new_graph;
+    std::vector<odr::value> new_envelopes;
+    SignalTable new_signals;
+    bool ok = [&]
+    {
+        SectionReader reader(static_cast<const char *>(mapping), size);
+        if (!reader.open(hash))
+            return false;
+
+        const LaneRecord *lanes;
+        const char *strings;
+        const StringRef *type_names, *signal_types;
+        const SignalRecord *signal_records;
+        const uint32_t *ring_starts, *centerline_starts, *graph_offsets;
+        const float *vertices, *centerline_points;
+        const EnvelopeRecord *envelope_records;
+        const int32_t *graph_lanes, *graph_neighbours;
+        std::size_t n, string_bytes, type_count, ring_start_count, vertex_floats,
+            centerline_start_count, centerline_floats, envelope_count,
+            graph_n, graph_offset_count, neighbour_count, signal_count, signal_type_count;
+        if (!reader.get(LANES, lanes, n) ||
+            !reader.get(STRINGS, strings, string_bytes) ||
+            !reader.get(TYPE_NAMES, type_names, type_count) ||
+            !reader.get(RING_STARTS, ring_starts, ring_start_count) ||
+            !reader.get(VERTICES, vertices, vertex_floats) ||
+            !reader.get(CENTERLINE_STARTS, centerline_starts, centerline_start_count) ||
+            !reader.get(CENTERLINE_POINTS, centerline_points, centerline_floats) ||
+            !reader.get(ENVELOPES, envelope_records, envelope_count) ||
+            !reader.get(GRAPH_LANES, graph_lanes, graph_n) ||
+            !reader.get(GRAPH_OFFSETS, graph_offsets, graph_offset_count) ||
+            !reader.get(GRAPH_NEIGHBOURS, graph_neighbours, neighbour_count) ||
+            !reader.get(SIGNALS, signal_records, signal_count) ||
+            !reader.get(SIGNAL_TYPES, signal_types, signal_type_count))
+            return false;
+
+        if (vertex_floats % 2 != 0 || centerline_floats % 2 != 0 ||
+            type_count == 0 || type_count > 256 || envelope_count != n ||
+            !validStarts(ring_starts, ring_start_count, n, vertex_floats / 2) ||
+            !validStarts(centerline_starts, centerline_start_count, n, centerline_floats / 2) ||
+            !validStarts(graph_offsets, graph_offset_count, graph_n, neighbour_count))
+            return false;
+
+        auto get_string = [&](const StringRef &ref, std::string &str)
+        {
+            if (ref.offset > string_bytes || ref.length > string_bytes - ref.offset)
+                return false;
+            str.assign(strings + ref.offset, ref.length);
+            return true;
+        };
+
+        new_table.type_names_.resize(type_count);
+        for (std::size_t t = 0; t < type_count; t++)
+        {
+            if (!get_string(type_names[t], new_table.type_names_[t]))
+                return false;
+        }
+
+        new_table.keys_.reserve(n);
+        new_table.index_.reserve(n);
+        new_table.type_.reserve(n);
+        new_table.in_junction_.reserve(n);
+        std::string road_id;
+        for (std::size_t k = 0; k < n; k++)
+        {
+            const LaneRecord &record = lanes[k];
+            if (record.type >= type_count || !get_string(record.road_id, road_id))
+                return false;
+            new_table.keys_.emplace_back(road_id, record.lanesection_s0, record.lane_id);
+            new_table.keys_.back().road_index = record.road_index;
+            new_table.keys_.back().lanesection_index = record.lanesection_index;
+            new_table.index_.emplace(new_table.keys_.back(), int32_t(k));
+            new_table.type_.push_back(record.type);
+            new_table.in_junction_.push_back(record.in_junction);
+        }
+        new_table.ring_start_.assign(ring_starts, ring_starts + ring_start_count);
+        readPoints(vertices, vertex_floats / 2, new_table.vertices_);
+        new_table.centerline_start_.assign(centerline_starts, centerline_starts + centerline_start_count);
+        readPoints(centerline_points, centerline_floats / 2, new_table.centerline_points_);
+        new_table.measureCenterlines();
+
+        new_envelopes.reserve(n);
+        for (std::size_t k = 0; k < n; k++)
+        {
+            const EnvelopeRecord &e = envelope_records[k];
+            if (e.lane >= n)
+                return false;
+            new_envelopes.emplace_back(odr::box(odr::point(e.min_x, e.min_y), odr::point(e.max_x, e.max_y)), e.lane);
+        }
+
+        new_graph.keys_.reserve(graph_n);
+        new_graph.ids_.reserve(graph_n);
+        for (std::size_t i = 0; i < graph_n; i++)
+        {
+            if (graph_lanes[i] < 0 || std::size_t(graph_lanes[i]) >= n)
+                return false;
+            new_graph.keys_.push_back(new_table.keys_[graph_lanes[i]]);
+            new_graph.ids_.emplace(new_graph.keys_.back(), int32_t(i));
+        }
+        for (std::size_t i = 0; i < neighbour_count; i++)
+        {
+            if (graph_neighbours[i] < 0 || std::size_t(graph_neighbours[i]) >= graph_n)
+                return false;
+        }
+        new_graph.offsets_.assign(graph_offsets, graph_offsets + graph_offset_count);
+        new_graph.neighbours_.assign(graph_neighbours, graph_neighbours + neighbour_count);
+        new_graph.reserveScratch();
+
+        new_signals.type_names_.resize(signal_type_count);
+        for (std::size_t t = 0; t < signal_type_count; t++)
+        {
+            if (!get_string(signal_types[t], new_signals.type_names_[t]))
+                return false;
+        }
+        new_signals.points_.reserve(signal_count);
+        new_signals.z_.reserve(signal_count);
+        new_signals.flags_.reserve(signal_count);
+        new_signals.type_.reserve(signal_count);
+        for (std::size_t k = 0; k < signal_count; k++)
+        {
+            const SignalRecord &record = signal_records[k];
+            if (record.type >= signal_type_count)
+                return false;
+            new_signals.points_.emplace_back(record.x, record.y);
+            new_signals.z_.push_back(record.z);
+            new_signals.flags_.push_back(record.flags);
+            new_signals.type_.push_back(record.type);
+        }
+        new_signals.buildTree();
+        return true;
+    }();
+    munmap(mapping, size);
+
+    if (ok)
+    {
+        table = std::move(new_table);
+        graph = std::move(new_graph);
+        envelopes = std::move(new_envelopes);
+        signals = std::move(new_signals);
+    }
+    return ok;
+}
@@ -10,12 +10,16 @@
 #include "rclcpp/rclcpp.hpp"
 
 #include "map_management/MapManager.hpp"
+#include "nova_trace/Trace.hpp"
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <limits>
 #include <list>
 
 #include <fstream>
+#include <iomanip>
 
 using namespace navigator::planning;
 
@@ -26,59 +30,316 @@ struct RoiIndices
     int end = -1;
 };
 
-MapManagementNode::MapManagementNode() : Node("map_management_node")
+MapManagementNode::MapManagementNode(const rclcpp::NodeOptions &options) : Node("map_management_node", options)
 {
-    // Publishers and subscribers
-    drivable_grid_pub_ = this->create_publisher<OccupancyGrid>("/grid/drivable", 10);
-    junction_grid_pub_ = this->create_publisher<OccupancyGrid>("/grid/junction", 10);
-    route_dist_grid_pub_ = this->create_publisher<OccupancyGrid>("/grid/route_distance", 10);
+    // Publishers and subscribers. Grid publishers belong to grid profiles,
+    // see declareGridProfiles().
     route_path_pub_ = this->create_publisher<Path>("/planning/smooth_route", 10);
+    route_latency_recorder_ = std::make_unique<latency_tracker::StageRecorder>(*this, "map_management.route", route_path_pub_->get_topic_name());
     traffic_light_points_pub_ = this->create_publisher<PolygonStamped>("/traffic_light_points", 10);
     goal_pose_pub_ = this->create_publisher<PoseStamped>("/planning/goal_pose", 1);
     route_progress_pub_ = this->create_publisher<std_msgs::msg::Float32>("/route_progress", 1);
+    // Latched, so late subscribers still learn that the map is ready.
+    // Intra-process publishing does not support that.
+    rclcpp::PublisherOptions map_ready_options;
+    map_ready_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Disable;
+    map_ready_pub_ = this->create_publisher<std_msgs::msg::Bool>("/map_management/map_ready", rclcpp::QoS(1).transient_local(),
+                                                                 map_ready_options);
 
     clock_sub = this->create_subscription<Clock>("/clock", 10, bind(&MapManagementNode::clockCb, this, std::placeholders::_1));
     rough_path_sub_ = this->create_subscription<Path>("/planning/rough_route", 10, bind(&MapManagementNode::updateRouteWaypoints, this, std::placeholders::_1));
     world_info_sub = this->create_subscription<CarlaWorldInfo>("/carla/world_info", 10, bind(&MapManagementNode::worldInfoCb, this, std::placeholders::_1));
 
-    drivable_area_grid_pub_timer_ = this->create_wall_timer(GRID_PUBLISH_FREQUENCY, bind(&MapManagementNode::drivableAreaGridPubTimerCb, this));
-    route_timer_ = this->create_wall_timer(ROUTE_PUBLISH_FREQUENCY, bind(&MapManagementNode::publishRefinedRoute, this));
+    // Timers that produce output run on the node's clock, so with
+    // use_sim_time they follow the simulator and stop when it pauses.
+    route_timer_ = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(ROUTE_PUBLISH_FREQUENCY), bind(&MapManagementNode::publishRefinedRoute, this));
+    traffic_light_pub_timer_ = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(TRAFFIC_LIGHT_PUBLISH_FREQUENCY), bind(&MapManagementNode::publishTrafficLights, this));
+
+    // Rasterize the lane map once on load, rather than testing every grid
+    // cell against the lane polygons on every publish.
+    use_lane_raster_ = this->declare_parameter<bool>("rasterize_lane_map", true);
+
+    // Find each cell's nearest route segment with a distance transform,
+    // rather than measuring every cell against the whole route.
+    use_route_distance_transform_ = this->declare_parameter<bool>("route_distance_transform", true);
+
+    // Threads filling the grids in publishGrids(), including the timer's
+    // own thread. 1 fills them serially.
+    int grid_threads = this->declare_parameter<int>("grid_threads", 1);
+    grid_pool_ = std::make_unique<worker_pool::WorkerPool>(std::max(1, grid_threads));
+
+    // Rebuild a profile's grids only once the vehicle has moved this far
+    // (meters) or turned this much (radians) since they were last built,
+    // or the route has changed. Otherwise republish them.
+    grid_motion_gating_ = this->declare_parameter<bool>("grid_motion_gating", false);
+    grid_regen_distance_ = this->declare_parameter<double>("grid_regen_distance", 0.5);
+    grid_regen_heading_ = this->declare_parameter<double>("grid_regen_heading", 0.05);
+
+    // Also write every profile's grids to the shared memory segment
+    // /navigator_grids_<name>, laid out as in SharedGrids.hpp, for
+    // consumers on this host. All three layers are then always filled.
+    shared_grids_ = this->declare_parameter<bool>("shared_grids", false);
+
+    declareGridProfiles();
+
+    // Stage latencies: GRID_STAGE_COUNT stages per grid profile, then the
+    // route's. Summaries go to /diagnostics every second, and each run is a
+    // nova_trace span. If timing_csv is set, every timed call also appends
+    // one row per stage there.
+    std::vector<std::string> stage_names;
+    for (const GridProfile &profile : grid_profiles_)
+    {
+        for (const char *stage : {"tree_query", "tree_build", "route_transform", "cells", "publish", "total"})
+            stage_names.push_back("grid_" + profile.name + "_" + stage);
+    }
+    route_first_stage_ = int(stage_names.size());
+    for (const char *stage : {"roi", "lanes", "resolve", "publish", "total"})
+        stage_names.push_back(std::string("route_") + stage);
+    profiler_ = std::make_unique<trace::StageProfiler>(std::move(stage_names), "map_management");
+    last_snapshots_.resize(profiler_->stage_count());
+
+    std::string timing_csv = this->declare_parameter<std::string>("timing_csv", "");
+    if (!timing_csv.empty())
+    {
+        timing_csv_ = std::make_unique<std::ofstream>(timing_csv);
+        if (*timing_csv_)
+            *timing_csv_ << "call,stamp,stage,ms,x,y,lanes\n";
+        else
+        {
+            RCLCPP_ERROR(this->get_logger(), "Could not open %s for timings", timing_csv.c_str());
+            timing_csv_.reset();
+        }
+    }
+
+    diagnostics_pub_ = this->create_publisher<DiagnosticArray>("/diagnostics", 10);
+    diagnostics_timer_ = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(1s), bind(&MapManagementNode::publishDiagnostics, this));
+
+    // Directory of cached lane data, keyed by a hash of the map, so that
+    // restarts skip parsing the OpenDRIVE string. Empty disables the cache.
+    map_cache_dir_ = this->declare_parameter<std::string>("map_cache_dir", "/tmp/navigator_map_cache");
+
+    // Load maps off the executor thread. Turned off, worldInfoCb() blocks
+    // until the map is loaded, so that replays don't depend on how long
+    // the load took.
+    background_map_load_ = this->declare_parameter<bool>("background_map_load", true);
 
     tf_buffer_ = std::make_unique<tf2_ros::Buffer>(this->get_clock());
-    tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
+    // Turned off, /tf is handled by the node's own executor rather than
+    // the listener's thread, e.g. for deterministic replay
+    if (this->declare_parameter<bool>("dedicated_tf_thread", true))
+        tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
+    else
+    {
+        // Nor does intra-process communication support the latched /tf_static
+        rclcpp::SubscriptionOptions tf_options;
+        tf_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Disable;
+        tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_, this, false, tf2_ros::DynamicListenerQoS(),
+                                                                    tf2_ros::StaticListenerQoS(), tf_options);
+    }
+
+    std_msgs::msg::Bool ready_msg;
+    ready_msg.data = false;
+    map_ready_pub_->publish(ready_msg);
+}
+
+/**
+ * @brief Read the grid profiles from parameters and start a timer for each.
+ *
+ * grid_profiles lists the profiles by name. Each has the parameters
+ * grid.<name>.top_dist, bottom_dist, side_dist (meters), res (meters per
+ * cell) and period_ms. The first profile publishes on /grid/drivable,
+ * /grid/junction and /grid/route_distance, and also picks the goal pose.
+ * Other profiles publish on /grid/<name>/drivable and so on.
+ * With shared_grids, each profile also gets a SharedGridWriter.
+ */
+void MapManagementNode::declareGridProfiles()
+{
+    std::vector<std::string> names = this->declare_parameter<std::vector<std::string>>(
+        "grid_profiles", std::vector<std::string>{"local", "long_range"});
+
+    grid_profiles_.reserve(names.size());
+    for (const std::string &name : names)
+    {
+        // Defaults: "local" is the planner's grid, "long_range" a coarse
+        // look further ahead. Other profile names start from "local".
+        const bool long_range = name == "long_range";
+
+        GridProfile profile;
+        profile.name = name;
+        const std::string param = "grid." + name + ".";
+        profile.top_dist = this->declare_parameter<int>(param + "top_dist", long_range ? 120 : 40);
+        profile.bottom_dist = this->declare_parameter<int>(param + "bottom_dist", long_range ? 40 : 20);
+        profile.side_dist = this->declare_parameter<int>(param + "side_dist", long_range ? 80 : 30);
+        profile.res = static_cast<float>(this->declare_parameter<double>(param + "res", long_range ? 1.6 : GRID_RES));
+        profile.period = std::chrono::milliseconds(this->declare_parameter<int>(param + "period_ms", long_range ? 1000 : 200));
+        if (profile.res <= 0.0f || profile.period <= 0ms)
+        {
+            RCLCPP_ERROR(this->get_logger(), "Grid profile %s needs a positive res and period_ms. Skipping it.", name.c_str());
+            continue;
+        }
+
+        const bool first = grid_profiles_.empty();
+        const std::string grid_prefix = first ? "/grid" : "/grid/" + name;
+        profile.publishes_goal = first;
+        profile.first_stage = int(grid_profiles_.size()) * GRID_STAGE_COUNT;
+        profile.drivable_pub = this->create_publisher<OccupancyGrid>(grid_prefix + "/drivable", 10);
+        profile.junction_pub = this->create_publisher<OccupancyGrid>(grid_prefix + "/junction", 10);
+        profile.route_dist_pub = this->create_publisher<OccupancyGrid>(grid_prefix + "/route_distance", 10);
+        profile.runtime_pub = this->create_publisher<std_msgs::msg::Float32>(
+            first ? "/map_management/publish_grids_ms" : "/map_management/" + name + "/publish_grids_ms", 1);
+        profile.latency_recorder = std::make_unique<latency_tracker::StageRecorder>(
+            *this, first ? "map_management.grids" : "map_management.grids." + name, profile.drivable_pub->get_topic_name());
+
+        if (shared_grids_)
+        {
+            // Same dimensions and origin as publishGrids() gives the grids
+            const float x_range = float(profile.top_dist + profile.bottom_dist);
+            const float y_range = float(2 * profile.side_dist);
+            const uint32_t width = static_cast<uint32_t>(std::floor(x_range / profile.res + 1e-3f)) + 1;
+            const uint32_t height = static_cast<uint32_t>(std::floor(y_range / profile.res + 1e-3f)) + 1;
+            try
+            {
+                profile.shared = std::make_unique<SharedGridWriter>("/navigator_grids_" + name, width, height, profile.res,
+                                                                    -float(profile.bottom_dist), -float(profile.side_dist));
+            }
+            catch (const std::runtime_error &e)
+            {
+                RCLCPP_ERROR(this->get_logger(), "%s. Grid profile %s will only publish topics.", e.what(), name.c_str());
+            }
+        }
+        grid_profiles_.push_back(std::move(profile));
+    }
+
+    // grid_profiles_ no longer changes size, so timers can hold indices.
+    for (std::size_t k = 0; k < grid_profiles_.size(); k++)
+    {
+        grid_profiles_[k].timer = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(grid_profiles_[k].period), [this, k]()
+                                                       { publishGrids(grid_profiles_[k]); });
+    }
+}
+
+/**
+ * @brief Record one run of a stage, and keep it for the call's CSV rows.
+ */
+void MapManagementNode::recordStage(int stage, std::chrono::steady_clock::time_point start,
+                                    std::chrono::steady_clock::time_point end)
+{
+    profiler_->record(stage, start, end);
+    if (timing_csv_)
+        pending_timings_.emplace_back(stage, std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+/**
+ * @brief Append the stages recorded since the last call to the timing CSV,
+ * one row each, tagged with where the vehicle was and how many lanes were
+ * near it.
+ */
+void MapManagementNode::writeTimingRows(double x, double y, std::size_t lanes)
+{
+    if (!timing_csv_)
+        return;
+
+    const double stamp = rclcpp::Time(clock_ != nullptr ? clock_->clock : builtin_interfaces::msg::Time(this->now())).seconds();
+    for (const auto &[stage, ms] : pending_timings_)
+    {
+        *timing_csv_ << timing_call_ << ',' << std::fixed << std::setprecision(3) << stamp << ','
+                     << profiler_->stage_name(stage) << ',' << ms << ',' << x << ',' << y << ',' << lanes << '\n';
+    }
+    pending_timings_.clear();
+    timing_call_++;
+}
+
+/**
+ * @brief Publishes the latency of each stage over the last second, plus the
+ * worst case since startup, as one DiagnosticStatus per stage.
+ */
+void MapManagementNode::publishDiagnostics()
+{
+    DiagnosticArray msg;
+    msg.header.stamp = clock_ != nullptr ? clock_->clock : builtin_interfaces::msg::Time(this->now());
+
+    auto value = [](const std::string &key, double v)
+    {
+        diagnostic_msgs::msg::KeyValue kv;
+        kv.key = key;
+        kv.value = std::to_string(v);
+        return kv;
+    };
+
+    for (int stage = 0; stage < profiler_->stage_count(); stage++)
+    {
+        trace::LatencyHistogram::Snapshot now = profiler_->histogram(stage).snapshot();
+        trace::LatencyHistogram::Snapshot window = now - last_snapshots_[stage];
+        last_snapshots_[stage] = now;
+
+        diagnostic_msgs::msg::DiagnosticStatus status;
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+        status.name = std::string(this->get_name()) + ": " + profiler_->stage_name(stage);
+        status.values.push_back(value("count", double(window.count)));
+        status.values.push_back(value("mean_ms", window.mean_ms()));
+        status.values.push_back(value("p50_ms", window.quantile_ms(0.5)));
+        status.values.push_back(value("p90_ms", window.quantile_ms(0.9)));
+        status.values.push_back(value("p99_ms", window.quantile_ms(0.99)));
+        status.values.push_back(value("max_ms_since_start", window.max_ms()));
+        msg.status.push_back(status);
+    }
+
+    diagnostics_pub_->publish(msg);
 }
 
 /**
  * @brief Returns an OccupancyGrid for lanes of type 'driving'
  *
+ * With the lane raster (the default), each cell (i,j) is rotated into the map
+ * frame and looked up in the raster built by worldInfoCb(). Otherwise:
+ *
  * General steps:
- * 1. Query the map-wide R-tree to find all lanes within range (https://www.boost.org/doc/libs/1_72_0/libs/geometry/doc/html/geometry/spatial_indexes/introduction.html)
- * 2. Create a second, local R-tree and insert all nearby lanes, which were found from (1)
+ * 1. If the vehicle has left the local R-tree's hysteresis box, query the map-wide R-tree to find all lanes within range (https://www.boost.org/doc/libs/1_72_0/libs/geometry/doc/html/geometry/spatial_indexes/introduction.html)
+ * 2. Bulk-load a second, local R-tree with the nearby lanes found from (1). It is kept between calls until the vehicle leaves its box.
  * 3. For each row j and column i, query the local R-tree to see if that cell (i,j) is within a lane's bounding box
  *  a.If yes, find out if it is within the actual lane, not just its bounding box. R-trees only calculate for bounding boxes.
  *      i. If yes again, the cell is truly occupied. Append '100' ("occupied") to OccupancyGrid. Otherwise '0'.
  * 4. Set OccupancyGrid metadata and return.
  *
- * @param center Center of the grid
- * @param top_dist Distance from car to top edge
- * @param bottom_dist Distance from car to bottom edge
- * @param side_dist Distance from car to left and right edges
- * @param res Side length of grid cells (meters)
- * @return OccupancyGrid
+ * Unless route_distance_transform is false, each cell's route distance is
+ * measured to the segment found by a distance transform of the local route.
+ *
+ * Cells are addressed by integer row and column. Rows are filled in tiles of
+ * GRID_TILE_ROWS, spread over grid_threads threads.
+ *
+ * With grid_motion_gating, the last grids are republished instead until the
+ * vehicle has moved grid_regen_distance or turned grid_regen_heading.
+ *
+ * Only layers with subscribers are filled and published. Route distances
+ * are only measured on drivable cells, and the goal is picked from route
+ * distances, so each of those also fills the layers it depends on.
+ *
+ * @param profile Extent and resolution of the grids, their publishers and
+ * the last grids published
  */
-void MapManagementNode::publishGrids(int top_dist, int bottom_dist, int side_dist, float res)
+void MapManagementNode::publishGrids(GridProfile &profile)
 {
-    if (this->map_ == nullptr)
-    {
-        RCLCPP_INFO_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
-                             "Map not yet loaded. Drivable area grid is unavailable.");
-        return;
-    }
+    const bool drivable_wanted = profile.drivable_pub->get_subscription_count() > 0;
+    const bool junction_wanted = profile.junction_pub->get_subscription_count() > 0;
+    const bool route_wanted = profile.route_dist_pub->get_subscription_count() > 0;
+    const bool goal_wanted = profile.publishes_goal && goal_pose_pub_->get_subscription_count() > 0;
 
-    // printf("Publish grids... ");
+    const bool shared = profile.shared != nullptr;
+
+    const bool fill_route = route_wanted || goal_wanted || shared;
+    const bool fill_drivable = drivable_wanted || fill_route;
+    const bool fill_junction = junction_wanted || shared;
+    if (!fill_drivable && !fill_junction)
+        return;
 
     // Used to calculate function runtime
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    latency_tracker::StageRecorder::Run latency_run = profile.latency_recorder->start();
+
+    const int top_dist = profile.top_dist;
+    const int bottom_dist = profile.bottom_dist;
+    const int side_dist = profile.side_dist;
+    const float res = profile.res;
 
     OccupancyGrid drivable_area_grid;
     OccupancyGrid junction_grid;
@@ -95,35 +356,45 @@ void MapManagementNode::publishGrids(int top_dist, int bottom_dist, int side_dis
 
     // std::printf("[%f, %f], [%f, %f], %f\n", x_min, x_max, y_min, y_max, res);
 
-    if (this->map_wide_tree_.size() == 0)
-        this->map_wide_tree_ = this->map_->generate_mesh_tree();
+    // Integer cell counts, so the grid's dimensions don't depend on how
+    // float steps of res happen to round. The small epsilon keeps the far
+    // edge when the range is a whole number of cells.
+    const int width = static_cast<int>(std::floor((x_max - x_min) / res + 1e-3f)) + 1;
+    const int height = static_cast<int>(std::floor((y_max - y_min) / res + 1e-3f)) + 1;
+    const std::size_t cell_count = std::size_t(width) * height;
+
+    builtin_interfaces::msg::Time stamp = clock_ != nullptr ? clock_->clock : builtin_interfaces::msg::Time(this->now());
+    grid_info.width = width;
+    grid_info.height = height;
+    grid_info.map_load_time = stamp;
+    grid_info.resolution = res;
+    grid_info.origin.position.x = x_min;
+    grid_info.origin.position.y = y_min;
+
+    if (!map_ready_)
+    {
+        RCLCPP_INFO_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                             "Map not yet loaded. Publishing unknown grids.");
+
+        // -1 is "unknown" in an OccupancyGrid
+        OccupancyGrid unknown_grid;
+        unknown_grid.header.frame_id = "base_link";
+        unknown_grid.header.stamp = stamp;
+        unknown_grid.info = grid_info;
+        unknown_grid.data.assign(cell_count, -1);
+        if (drivable_wanted)
+            profile.drivable_pub->publish(unknown_grid);
+        if (junction_wanted)
+            profile.junction_pub->publish(unknown_grid);
+        if (route_wanted)
+            profile.route_dist_pub->publish(unknown_grid);
+        return;
+    }
 
     // Get the search region
     TransformStamped vehicle_tf = getVehicleTf();
+    latency_run.input("/tf", vehicle_tf.header.stamp);
     auto vehicle_pos = vehicle_tf.transform.translation;
-    double range_plus = top_dist * 1.4; // This is a little leeway to account for map->base_link rotation
-    odr::point bounding_box_min = odr::point(vehicle_pos.x - range_plus, vehicle_pos.y - range_plus);
-    odr::point bounding_box_max = odr::point(vehicle_pos.x + range_plus, vehicle_pos.y + range_plus);
-    odr::box search_region(bounding_box_min, bounding_box_max);
-
-    // Find all lanes within the search region
-    std::vector<odr::value> lane_shapes_in_range;
-    map_wide_tree_.query(bgi::intersects(search_region), std::back_inserter(lane_shapes_in_range));
-
-    // std::printf("There are %i shapes in range.\n", lane_shapes_in_range.size());
-
-    int idx = 0;
-
-    bgi::rtree<odr::value, bgi::rstar<16, 4>> local_tree;
-
-    for (unsigned i = 0; i < lane_shapes_in_range.size(); ++i)
-        local_tree.insert(lane_shapes_in_range.at(i));
-
-    int area = 0;
-    int height = 0;
-
-    BoostPoint goal_pt;
-    bool goal_is_set = false;
     auto q = vehicle_tf.transform.rotation;
     float h;
 
@@ -135,124 +406,338 @@ void MapManagementNode::publishGrids(int top_dist, int bottom_dist, int side_dis
     if (h > M_PI)
         h -= 2 * M_PI;
 
-    for (float j = y_min; j <= y_max; j += res)
+    if (grid_motion_gating_)
     {
-        for (float i = x_min; i <= x_max; i += res)
+        // Stamp the grids with the transform they were built from, so that
+        // they line up with TF lookups at their stamp.
+        if (vehicle_tf.header.stamp.sec != 0 || vehicle_tf.header.stamp.nanosec != 0)
+            stamp = vehicle_tf.header.stamp;
+
+        // Until the vehicle has moved or turned far enough, or the route
+        // or the wanted layers change, republish the last grids.
+        const bool still = profile.last.valid &&
+                           profile.last.route_version == local_route_version_ &&
+                           (!fill_drivable || profile.last.has_drivable) &&
+                           (!fill_junction || profile.last.has_junction) &&
+                           (!fill_route || profile.last.has_route) &&
+                           std::hypot(vehicle_pos.x - profile.last.x, vehicle_pos.y - profile.last.y) < grid_regen_distance_ &&
+                           std::abs(std::remainder(h - profile.last.heading, 2 * M_PI)) < grid_regen_heading_;
+        if (still)
         {
+            GridProfile::LastGrids &last = profile.last;
+            last.drivable.header.stamp = last.junction.header.stamp = last.route_dist.header.stamp = stamp;
+            last.drivable.info.map_load_time = last.junction.info.map_load_time = last.route_dist.info.map_load_time = stamp;
+            last.goal.header.stamp = stamp;
+            navigator::trace::flow("map_management.grids", navigator::trace::flow_id(stamp));
+            if (drivable_wanted)
+                profile.drivable_pub->publish(last.drivable);
+            if (junction_wanted)
+                profile.junction_pub->publish(last.junction);
+            if (route_wanted)
+                profile.route_dist_pub->publish(last.route_dist);
+            if (goal_wanted)
+                goal_pose_pub_->publish(last.goal);
+            if (shared)
+                profile.shared->touch(rclcpp::Time(stamp).nanoseconds());
+            latency_run.finish(stamp);
+
+            recordStage(profile.first_stage + GRID_TOTAL, begin, std::chrono::steady_clock::now());
+            writeTimingRows(vehicle_pos.x, vehicle_pos.y, local_tree_.size());
+            return;
+        }
+        grid_info.map_load_time = stamp;
+    }
 
-            i = static_cast<float>(i);
-            j = static_cast<float>(j);
-            bool cell_is_drivable = false;
-            bool cell_is_in_junction = false;
+    // This is a little leeway to account for map->base_link rotation
+    double range_plus = std::max({top_dist, bottom_dist, side_dist}) * 1.4;
 
-            // Transform this query into the map frame
-            // First rotate, then translate. 2D rotation eq:
-            // x' = xcos(h) - ysin(h)
-            // y' = ycos(h) + xsin(h)
+    const bool use_raster = use_lane_raster_ && !lane_raster_.empty();
 
-            // if (h < 0)
-            //     h += 2 * M_PI;
-            float i_in_map = i * cos(h) - j * sin(h) + vehicle_pos.x;
-            float j_in_map = j * cos(h) + i * sin(h) + vehicle_pos.y;
+    if (!use_raster)
+    {
+        // Rebuild the local tree only once the vehicle is more than
+        // LOCAL_TREE_MARGIN from where it was last built, or a profile
+        // needs a larger region. Until then, the tree's region (the largest
+        // search region plus the margin) still covers the current search
+        // region (range_plus around the vehicle).
+        double reach = std::max(range_plus, local_tree_reach_ - LOCAL_TREE_MARGIN) + LOCAL_TREE_MARGIN;
+        bool moved = !local_tree_valid_ || reach > local_tree_reach_ ||
+                     std::abs(vehicle_pos.x - local_tree_center_.get<0>()) > LOCAL_TREE_MARGIN ||
+                     std::abs(vehicle_pos.y - local_tree_center_.get<1>()) > LOCAL_TREE_MARGIN;
+        if (moved)
+        {
+            odr::box tree_region(odr::point(vehicle_pos.x - reach, vehicle_pos.y - reach),
+                                 odr::point(vehicle_pos.x + reach, vehicle_pos.y + reach));
+
+            // Find all lanes within the tree's region
+            auto query_start = std::chrono::steady_clock::now();
+            std::vector<odr::value> lane_shapes_in_range;
+            map_wide_tree_.query(bgi::intersects(tree_region), std::back_inserter(lane_shapes_in_range));
+            auto build_start = std::chrono::steady_clock::now();
+            recordStage(profile.first_stage + GRID_TREE_QUERY, query_start, build_start);
+
+            // The range constructor bulk-loads the tree (packing), which is
+            // much faster than inserting one value at a time and gives a
+            // better tree.
+            local_tree_ = bgi::rtree<odr::value, bgi::rstar<16, 4>>(lane_shapes_in_range);
+            recordStage(profile.first_stage + GRID_TREE_BUILD, build_start, std::chrono::steady_clock::now());
+            local_tree_center_ = odr::point(vehicle_pos.x, vehicle_pos.y);
+            local_tree_reach_ = reach;
+            local_tree_valid_ = true;
+        }
+    }
 
-            odr::point p(i_in_map, j_in_map);
+    BoostPoint goal_pt;
+
+    const float cos_h = cos(h);
+    const float sin_h = sin(h);
+
+    if (fill_drivable)
+        drivable_grid_data.resize(cell_count);
+    if (fill_junction)
+        junction_grid_data.resize(cell_count);
+    if (fill_route)
+        route_dist_grid_data.resize(cell_count);
+
+    // Nearest route segment of each cell, from a distance transform of the
+    // route rasterized into the grid. The exact distance to that segment
+    // (and its neighbours, where segments meet) is then one computation per
+    // cell instead of one per route segment. The transform's domain is
+    // padded so that route segments just outside the grid are still found
+    // by cells within ROUTE_DIST_SATURATION of them.
+    const bool use_route_transform = fill_route && use_route_distance_transform_ && local_route_linestring_.size() > 1;
+    const int pad = static_cast<int>(std::ceil(ROUTE_DIST_SATURATION / res)) + 1;
+    const int padded_width = width + 2 * pad;
+    std::vector<float> route_dist_sq;
+    std::vector<int> route_segment;
+    std::vector<int> nearest_route_cell;
+    if (use_route_transform)
+    {
+        auto transform_start = std::chrono::steady_clock::now();
+        const int padded_height = height + 2 * pad;
+        route_segment.assign(std::size_t(padded_width) * padded_height, -1);
+
+        // Map frame to padded cell coordinates: the inverse of the rotation
+        // and translation below.
+        auto to_cell = [&](const odr::point &pt, float &c, float &r)
+        {
+            float dx = pt.get<0>() - vehicle_pos.x;
+            float dy = pt.get<1>() - vehicle_pos.y;
+            c = (dx * cos_h + dy * sin_h - x_min) / res + pad;
+            r = (dy * cos_h - dx * sin_h - y_min) / res + pad;
+        };
 
-            std::vector<odr::value> local_tree_query_results;
-            local_tree.query(bgi::contains(p), std::back_inserter(local_tree_query_results));
+        for (std::size_t v = 0; v + 1 < local_route_linestring_.size(); v++)
+        {
+            float c0, r0, c1, r1;
+            to_cell(local_route_linestring_[v], c0, r0);
+            to_cell(local_route_linestring_[v + 1], c1, r1);
+            markSegment(route_segment, padded_width, padded_height, c0, r0, c1, r1, int(v));
+        }
 
-            if (local_tree_query_results.size() > 0)
+        route_dist_sq.resize(route_segment.size());
+        for (std::size_t c = 0; c < route_segment.size(); c++)
+            route_dist_sq[c] = route_segment[c] < 0 ? DT_FAR : 0.0f;
+        squaredDistanceTransform(route_dist_sq, padded_width, padded_height, &nearest_route_cell);
+        recordStage(profile.first_stage + GRID_ROUTE_TRANSFORM, transform_start, std::chrono::steady_clock::now());
+    }
+
+    // Distance from map point p, at grid cell (row, col), to the local route.
+    auto route_distance = [&](const odr::point &p, int row, int col) -> float
+    {
+        if (!use_route_transform)
+            return bg::distance(local_route_linestring_, p);
+
+        const std::size_t cell = std::size_t(row + pad) * padded_width + col + pad;
+
+        // A site cell's center is within half a diagonal of its segment, so
+        // cells this far from every site are saturated.
+        if (std::sqrt(route_dist_sq[cell]) * res >= ROUTE_DIST_SATURATION + res)
+            return ROUTE_DIST_SATURATION;
+
+        const int segment = route_segment[nearest_route_cell[cell]];
+        const int last = static_cast<int>(local_route_linestring_.size()) - 2;
+        float dist = std::numeric_limits<float>::max();
+        for (int k = std::max(0, segment - 1); k <= std::min(last, segment + 1); k++)
+        {
+            bg::model::referring_segment<const odr::point> seg(local_route_linestring_[k], local_route_linestring_[k + 1]);
+            dist = std::min(dist, static_cast<float>(bg::distance(p, seg)));
+        }
+        return dist;
+    };
+
+    // Rows are split into tiles of GRID_TILE_ROWS. Each tile writes only its
+    // own cells, and records its first goal candidate in scan order.
+    const int tile_count = (height + GRID_TILE_ROWS - 1) / GRID_TILE_ROWS;
+    std::vector<int> tile_goal_cell(tile_count, -1);
+
+    auto fill_tile = [&](int tile)
+    {
+        std::vector<odr::value> local_tree_query_results;
+        const int row_end = std::min(height, (tile + 1) * GRID_TILE_ROWS);
+
+        for (int row = tile * GRID_TILE_ROWS; row < row_end; row++)
+        {
+            const float j = y_min + row * res;
+            for (int col = 0; col < width; col++)
             {
-                for (auto pair : local_tree_query_results)
+                const float i = x_min + col * res;
+                const std::size_t cell = std::size_t(row) * width + col;
+                bool cell_is_drivable = false;
+                bool cell_is_in_junction = false;
+
+                // Transform this query into the map frame
+                // First rotate, then translate. 2D rotation eq:
+                // x' = xcos(h) - ysin(h)
+                // y' = ycos(h) + xsin(h)
+                float i_in_map = i * cos_h - j * sin_h + vehicle_pos.x;
+                float j_in_map = j * cos_h + i * sin_h + vehicle_pos.y;
+
+                odr::point p(i_in_map, j_in_map);
+
+                if (use_raster)
                 {
-                    // auto pair = local_tree_query_results.front();
-                    odr::ring ring = this->lane_polys_.at(pair.second).second;
-                    odr::Lane lane = this->lane_polys_.at(pair.second).first;
-                    // odr::Road road = this->map_->id_to_road.at(lane.key.road_id);
-                    bool point_is_within_shape = bg::within(p, ring);
-                    if (point_is_within_shape)
-                    {
+                    const uint8_t flags = lane_raster_.flagsAt(i_in_map, j_in_map);
+                    cell_is_drivable = flags & LaneRaster::DRIVABLE;
+                    cell_is_in_junction = flags & LaneRaster::JUNCTION;
+                }
+                else
+                {
+                    local_tree_query_results.clear();
+                    local_tree_.query(bgi::contains(p), std::back_inserter(local_tree_query_results));
 
-                        cell_is_in_junction = this->road_in_junction_map_[lane.key];
-                        if (lane.type == "driving")
+                    for (const odr::value &candidate : local_tree_query_results)
+                    {
+                        const unsigned k = candidate.second;
+                        bool point_is_within_shape = lane_table_.contains(k, i_in_map, j_in_map);
+                        if (point_is_within_shape)
                         {
-                            cell_is_drivable = true;
-                            break;
+                            cell_is_in_junction = lane_table_.inJunction(k);
+                            if (lane_table_.isDriving(k))
+                            {
+                                cell_is_drivable = true;
+                                break;
+                            }
                         }
                     }
                 }
-            }
 
-            drivable_grid_data.push_back(cell_is_drivable ? 0 : 100);
-            junction_grid_data.push_back(cell_is_in_junction ? 100 : 0);
+                if (fill_drivable)
+                    drivable_grid_data[cell] = cell_is_drivable ? 0 : 100;
+                if (fill_junction)
+                    junction_grid_data[cell] = cell_is_in_junction ? 100 : 0;
 
-            // Get closest route point
-            if (local_route_linestring_.size() > 0 && cell_is_drivable && i > 0)
-            {
-                int dist = static_cast<int>(bg::distance(local_route_linestring_, p) * 8);
-
-                if (dist < 1.0 && !goal_is_set && abs(i) + abs(j) > 30)
+                // Get closest route point
+                if (!fill_route)
+                    continue;
+                if (local_route_linestring_.size() > 0 && cell_is_drivable && i > 0)
                 {
-                    goal_is_set = true;
-                    goal_pt = BoostPoint(i, j);
-                }
+                    int dist = static_cast<int>(route_distance(p, row, col) * 8);
 
-                // Distances > 10 are set to 100
-                if (dist > 20)
-                    dist = 100;
-                else
-                    dist *= 5;
+                    if (dist < 1.0 && tile_goal_cell[tile] < 0 && abs(i) + abs(j) > 30)
+                        tile_goal_cell[tile] = int(cell);
 
-                route_dist_grid_data.push_back(dist);
-            }
-            else
-            {
-                route_dist_grid_data.push_back(100);
+                    // Distances > 10 are set to 100
+                    if (dist > 20)
+                        dist = 100;
+                    else
+                        dist *= 5;
+
+                    route_dist_grid_data[cell] = dist;
+                }
+                else
+                {
+                    route_dist_grid_data[cell] = 100;
+                }
             }
+        }
+    };
+
+    auto cells_start = std::chrono::steady_clock::now();
+    grid_pool_->run(tile_count, fill_tile);
 
-            area += 1;
+    // The goal is the first candidate in scan order, as with a serial fill.
+    for (int cell : tile_goal_cell)
+    {
+        if (cell >= 0)
+        {
+            goal_pt = BoostPoint(x_min + (cell % width) * res, y_min + (cell / width) * res);
+            break;
         }
-        height += 1;
     }
 
-    auto clock = this->clock_->clock;
-    drivable_area_grid.data = drivable_grid_data;
+    auto publish_start = std::chrono::steady_clock::now();
+    recordStage(profile.first_stage + GRID_CELLS, cells_start, publish_start);
+
+    if (shared)
+    {
+        const int8_t *layers[SHARED_LAYER_COUNT] = {};
+        layers[SHARED_DRIVABLE] = drivable_grid_data.data();
+        layers[SHARED_JUNCTION] = junction_grid_data.data();
+        layers[SHARED_ROUTE_DISTANCE] = route_dist_grid_data.data();
+        profile.shared->write(layers, rclcpp::Time(stamp).nanoseconds());
+    }
+
+    drivable_area_grid.data = std::move(drivable_grid_data);
     drivable_area_grid.header.frame_id = "base_link";
-    drivable_area_grid.header.stamp = clock;
+    drivable_area_grid.header.stamp = stamp;
+    navigator::trace::flow("map_management.grids", navigator::trace::flow_id(stamp));
 
-    junction_grid.data = junction_grid_data;
+    junction_grid.data = std::move(junction_grid_data);
     junction_grid.header.frame_id = "base_link";
-    junction_grid.header.stamp = clock;
+    junction_grid.header.stamp = stamp;
 
-    route_dist_grid.data = route_dist_grid_data;
+    route_dist_grid.data = std::move(route_dist_grid_data);
     route_dist_grid.header.frame_id = "base_link";
-    route_dist_grid.header.stamp = clock;
-
-    grid_info.width = area / height;
-    grid_info.height = height;
-    grid_info.map_load_time = clock;
-    grid_info.resolution = res;
-    grid_info.origin.position.x = x_min;
-    grid_info.origin.position.y = y_min;
+    route_dist_grid.header.stamp = stamp;
 
     // Set the grids' metadata
     drivable_area_grid.info = grid_info;
     junction_grid.info = grid_info;
     route_dist_grid.info = grid_info;
 
-    // Output function runtime
-    drivable_grid_pub_->publish(drivable_area_grid);
-    junction_grid_pub_->publish(junction_grid);
-    route_dist_grid_pub_->publish(route_dist_grid); // Route distance grid
+    if (drivable_wanted)
+        profile.drivable_pub->publish(drivable_area_grid);
+    if (junction_wanted)
+        profile.junction_pub->publish(junction_grid);
+    if (route_wanted)
+        profile.route_dist_pub->publish(route_dist_grid); // Route distance grid
 
     PoseStamped goal_pose;
     goal_pose.pose.position.x = goal_pt.get<0>();
     goal_pose.pose.position.y = goal_pt.get<1>();
     goal_pose.header.frame_id = "base_link";
-    goal_pose.header.stamp = clock_->clock;
-    goal_pose_pub_->publish(goal_pose);
+    goal_pose.header.stamp = stamp;
+    if (goal_wanted)
+        goal_pose_pub_->publish(goal_pose);
+    latency_run.finish(stamp);
 
-    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    // std::cout << "publishGrids(): " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]" << std::endl;
+    if (grid_motion_gating_)
+    {
+        GridProfile::LastGrids &last = profile.last;
+        last.valid = true;
+        last.x = vehicle_pos.x;
+        last.y = vehicle_pos.y;
+        last.heading = h;
+        last.route_version = local_route_version_;
+        last.has_drivable = fill_drivable;
+        last.has_junction = fill_junction;
+        last.has_route = fill_route;
+        last.drivable = std::move(drivable_area_grid);
+        last.junction = std::move(junction_grid);
+        last.route_dist = std::move(route_dist_grid);
+        last.goal = goal_pose;
+    }
+
+    // Output function runtime
+    auto end = std::chrono::steady_clock::now();
+    recordStage(profile.first_stage + GRID_PUBLISH, publish_start, end);
+    recordStage(profile.first_stage + GRID_TOTAL, begin, end);
+    writeTimingRows(vehicle_pos.x, vehicle_pos.y, local_tree_.size());
+
+    std_msgs::msg::Float32 runtime_msg;
+    runtime_msg.data = std::chrono::duration<float, std::milli>(end - begin).count();
+    profile.runtime_pub->publish(runtime_msg);
 }
 
 /**
@@ -289,13 +774,42 @@ TransformStamped MapManagementNode::getVehicleTf()
 }
 
 /**
- * @brief Gets the drivable area OccupancyGrid and publishes it.
- *
+ * @brief Publish the traffic lights that matter to the vehicle: those near
+ * it that are also near the upcoming route, or, with no route yet, at a
+ * junction.
  */
-void MapManagementNode::drivableAreaGridPubTimerCb()
+void MapManagementNode::publishTrafficLights()
 {
-    // std::printf("Publishing grids\n");
-    publishGrids(40, 20, 30, 0.4);
+    if (!map_ready_ || signal_table_.empty())
+        return;
+    const TransformStamped ego_tf = getVehicleTf();
+    if (ego_tf.header.frame_id.empty())
+        return; // No transform yet
+
+    const double x = ego_tf.transform.translation.x;
+    const double y = ego_tf.transform.translation.y;
+    nearby_signals_.clear();
+    signal_table_.query(x, y, TRAFFIC_LIGHT_RANGE, SignalTable::TRAFFIC_LIGHT, nearby_signals_);
+    std::sort(nearby_signals_.begin(), nearby_signals_.end()); // A stable order between calls
+
+    const bool has_route = local_route_linestring_.size() > 1;
+    traffic_light_points.header.frame_id = "map";
+    traffic_light_points.header.stamp = clock_ != nullptr ? clock_->clock : builtin_interfaces::msg::Time(this->now());
+    traffic_light_points.polygon.points.clear();
+    for (uint32_t k : nearby_signals_)
+    {
+        const odr::point &pt = signal_table_.position(k);
+        const bool relevant = has_route ? bg::distance(local_route_linestring_, pt) <= TRAFFIC_LIGHT_ROUTE_MARGIN
+                                        : (signal_table_.flags(k) & SignalTable::AT_JUNCTION) != 0;
+        if (!relevant)
+            continue;
+        Point32 point;
+        point.x = pt.get<0>();
+        point.y = pt.get<1>();
+        point.z = signal_table_.z(k);
+        traffic_light_points.polygon.points.push_back(point);
+    }
+    traffic_light_points_pub_->publish(traffic_light_points);
 }
 
 // CPP code for printing shortest path between
@@ -312,156 +826,42 @@ void add_edge(vector<int> adj[], int src, int dest)
 }
 
 /**
- * @brief Simple breadth-first search using libOpenDRIVE's inbuilt routing graph.
- * Undirected! See https://en.wikipedia.org/wiki/Breadth-first_search#Pseudocode
+ * @brief Join the centerlines of consecutive lanes into one route.
  *
- * @param source
- * @param dest
- * @param graph
- * @return std::unordered_map<odr::LaneKey, odr::LaneKey>
+ * Lanes whose start is far from the previous lane's end are taken
+ * backwards. Each centerline is sliced from the lane table, not copied out
+ * first.
  */
-std::unordered_map<odr::LaneKey, odr::LaneKey> bfs(odr::LaneKey source, odr::LaneKey dest, odr::RoutingGraph graph)
-{
-    std::unordered_set<odr::LaneKey> visited_lanes;
-    std::unordered_map<odr::LaneKey, odr::LaneKey> parents;
-    visited_lanes.insert(source);
-    std::vector<odr::LaneKey> route;
-    std::queue<odr::LaneKey> queue;
-
-    queue.push(source);
-    while (!queue.empty())
-    {
-        odr::LaneKey v = queue.front();
-        queue.pop();
-
-        if (v.to_string() == dest.to_string())
-        {
-            return parents;
-        }
-
-        for (auto w : graph.get_lane_predecessors(v))
-        {
-            if (visited_lanes.find(w) == visited_lanes.end())
-            {
-                visited_lanes.insert(w);
-                parents.insert(std::make_pair(w, v));
-                queue.push(w);
-            }
-        }
-        for (auto w : graph.get_lane_successors(v))
-        {
-            if (visited_lanes.find(w) == visited_lanes.end())
-            {
-                visited_lanes.insert(w);
-                parents.insert(std::make_pair(w, v));
-                queue.push(w);
-            }
-        }
-    }
-    // RCLCPP_ERROR(get_logger(), "Destination not found");
-    return parents;
-}
-
-LineString getSmoothSection(LineString full_route, BoostPoint ego, int &start_idx, int &end_idx)
+LineString getReorientedRoute(const LaneTable &lanes, const std::vector<int32_t> &route_lanes)
 {
+    const float MAX_ENDPOINT_GAP = 2.0; // meters
 
-    // Get closest waypoint in full_route
-    float closest_dist = 999.9;
-    int closest_idx = -1;
-
-    for (int i = 0; i < full_route.size(); i++)
-    {
-        auto wp = full_route[i];
-        float dist_to_ego = bg::distance(ego, wp);
-        if (dist_to_ego < closest_dist)
-        {
-            closest_dist = dist_to_ego;
-            closest_idx = i;
-        }
-    }
-
-    end_idx = closest_idx < 1 ? closest_idx : closest_idx - 1;
-
-    LineString rough_section;
-    start_idx = closest_idx + 1;
-    float edge_distance = closest_dist;
-
-    // Find the "edge" waypoint
-    // That's the divider between the smooth and rough route sections
-    // It should be > 40m from the ego
-    while (edge_distance < 40.0)
-    {
-        auto wp = full_route[start_idx];
-        edge_distance = bg::distance(ego, wp);
-        start_idx++;
-    }
-
-    return rough_section;
-}
-
-LineString MapManagementNode::getLaneCenterline(odr::LaneKey key)
-{
-    LineString centerline;
-
-    odr::Road road = map_->id_to_road.at(key.road_id);
-    odr::LaneSection lsec = road.s_to_lanesection.at(key.lanesection_s0);
-    odr::Lane lane = lsec.id_to_lane.at(key.lane_id);
-
-    odr::Line3D outer_border = road.get_lane_border_line(lane, 1.0, true);
-    odr::Line3D inner_border = road.get_lane_border_line(lane, 1.0, false);
-
-    for (int i = 0; i < outer_border.size(); i++)
-    {
-        odr::Vec3D outer_pt = outer_border[i];
-        odr::Vec3D inner_pt = inner_border[i];
-        BoostPoint center_pt((outer_pt[0] + inner_pt[0]) / 2, (outer_pt[1] + inner_pt[1]) / 2);
-        bg::append(centerline, center_pt);
-    }
-
-    return centerline;
-}
-
-LineString getReorientedRoute(std::vector<LineString> centerlines)
-{
     LineString result;
-
-    auto iter = centerlines.begin();
-    while (iter != centerlines.end() - 1)
+    bool forward = true;
+    for (std::size_t n = 0; n < route_lanes.size(); n++)
     {
+        const int32_t k = route_lanes[n];
+        if (lanes.centerlineCount(k) == 0)
+            continue;
+
         // Get end of this segment and the beginning of the next one
         // Check the distance between them.
         // If distance is small, the orientation is correct. Continue.
         // If distance is large, reverse order of next segment
+        forward = true;
+        if (!result.empty())
+            forward = bg::distance(result.back(), lanes.centerline(k)[0]) <= MAX_ENDPOINT_GAP;
 
-        const float MAX_ENDPOINT_GAP = 2.0; // meters
-
-        auto current_end = iter->back();
-        auto next_begin = (iter + 1)->front();
-        float dist = bg::distance(current_end, next_begin);
-
-        // std::printf("Distance was %f. ", dist);
-
-        if (dist > MAX_ENDPOINT_GAP)
-        {
-            bg::reverse(*(iter + 1));
-        }
-
-        next_begin = (iter + 1)->front();
-        // dist = bg::distance(current_end, next_begin);
-        // std::printf("Distance is now %f.\n", dist);
-
-        bg::append(result, *iter);
-
-        iter++;
+        const float length = lanes.centerlineLength(k);
+        lanes.centerlineSlice(k, forward ? 0.0f : length, forward ? length : 0.0f, result);
     }
-    bg::append(result, centerlines.back());
 
     return result;
 }
 
 void MapManagementNode::updateRouteWaypoints(Path::SharedPtr msg)
 {
-    if (rough_route_tree_.size() > 0 && rough_route_tree_.size() == msg->poses.size())
+    if (rough_route_.size() > 0 && rough_route_.size() == msg->poses.size())
     {
         // It looks like we've already processed a route and the new route as the same size.
         // If the new route's size and the current tree's size are the same,
@@ -469,9 +869,6 @@ void MapManagementNode::updateRouteWaypoints(Path::SharedPtr msg)
         return;
     }
 
-    // Let's build an RTree to efficiently represent the new waypoints.
-
-    rough_route_tree_.clear();
     rough_route_.clear();
 
     for (unsigned i = 0; i < msg->poses.size(); ++i)
@@ -479,22 +876,27 @@ void MapManagementNode::updateRouteWaypoints(Path::SharedPtr msg)
         PoseStamped wp_pose = msg->poses[i];
 
         BoostPoint wp(wp_pose.pose.position.x, wp_pose.pose.position.y);
-        rough_route_tree_.insert(std::make_pair(bg::return_envelope<odr::box>(wp), i));
         bg::append(rough_route_, wp);
     }
 
-    RCLCPP_INFO(get_logger(), "%i waypoints added to tree", rough_route_tree_.size());
-}
-
-RoiIndices getWaypointsInROI(LineString waypoints, bgi::rtree<odr::value, bgi::rstar<16, 4>> tree, BoostPoint ego_pos)
-{
-    std::vector<odr::value> returned_values;
-    // Query our tree. "1" means get the single nearest waypoint
-    tree.query(bgi::nearest(ego_pos, 1), std::back_inserter(returned_values));
-    int nearest_idx = returned_values.front().second;
+    // Index the waypoints by arc length and segment, for projecting the
+    // vehicle onto them.
+    rm.setRoute(rough_route_);
 
+    // Routes are resolved from scratch for new waypoints.
+    route_keys_.clear();
 
+    RCLCPP_INFO(get_logger(), "%zu waypoints added to the route", rough_route_.size());
+}
 
+/**
+ * @brief The waypoints within 40 m of ego on either side of the waypoint
+ * nearest to it.
+ *
+ * @param nearest_idx Index of the waypoint nearest to ego
+ */
+RoiIndices getWaypointsInROI(const LineString &waypoints, int nearest_idx, BoostPoint ego_pos)
+{
     // Go backward in rough route until either
     // a) We hit the route's start or
     // b) we're >40m from ego
@@ -533,7 +935,7 @@ RoiIndices getWaypointsInROI(LineString waypoints, bgi::rtree<odr::value, bgi::r
     return result;
 }
 
-std::vector<odr::LaneKey> getLaneKeysFromIndices(RoiIndices indices, LineString waypoints, bgi::rtree<odr::value, bgi::rstar<16, 4>> lane_tree, std::vector<odr::LanePair> lane_polys)
+std::vector<odr::LaneKey> getLaneKeysFromIndices(RoiIndices indices, const LineString &waypoints, const bgi::rtree<odr::value, bgi::rstar<16, 4>> &lane_tree, const LaneTable &lanes)
 {
     LineString waypoints_within_roi;
     // bg::simplify(waypoints, simplified_wps, 5.0);
@@ -559,17 +961,63 @@ std::vector<odr::LaneKey> getLaneKeysFromIndices(RoiIndices indices, LineString
 
     // Move through our tree search results, extracting the lane key and
     // adding it to our result list.
-    for (auto result : query_results)
+    for (const odr::value &result : query_results)
     {
-        odr::LanePair result_pair = lane_polys[result.second];
-        lane_keys.push_back(result_pair.first.key);
+        lane_keys.push_back(lanes.key(result.second));
         // std::printf("%s\n", result_pair.first.key.to_string().c_str());
     }
 
     return lane_keys;
 }
 
-std::vector<LineString> MapManagementNode::getCenterlinesFromKeys(std::vector<odr::LaneKey> keys, odr::RoutingGraph graph)
+/**
+ * @brief The lanes leading from one lane to another, found by BFS over the
+ * lane graph (undirected). Results are cached per (from, to) pair, so a lane pair is
+ * only searched the first time it appears in the ROI.
+ *
+ * @return The lanes from `to` back to (but not including) `from`
+ */
+const std::vector<odr::LaneKey> &MapManagementNode::getLanePath(const odr::LaneKey &from, const odr::LaneKey &to)
+{
+    auto &paths_from = lane_path_cache_[from];
+    auto cached = paths_from.find(to);
+    if (cached != paths_from.end())
+        return cached->second;
+
+    std::vector<odr::LaneKey> &complete_segment = paths_from[to];
+    complete_segment.push_back(to);
+
+    const int32_t from_id = lane_graph_.id(from);
+    const int32_t to_id = lane_graph_.id(to);
+    if (from_id == LaneGraph::NO_LANE || to_id == LaneGraph::NO_LANE || from_id == to_id ||
+        !lane_graph_.search(from_id, to_id, lane_path_parents_))
+    {
+        // RCLCPP_ERROR(get_logger(), "BFS could not locate route parent. Returning.");
+        return complete_segment;
+    }
+
+    // Work our way back from destination to source in the tree search,
+    // producing a continuous LaneKey route. As before, a destination
+    // adjacent to the source keeps the source in its segment.
+    int32_t parent = lane_path_parents_[to_id];
+    while (true)
+    {
+        complete_segment.push_back(lane_graph_.key(parent));
+        if (parent == from_id)
+            break;
+        parent = lane_path_parents_[parent];
+        if (parent == from_id)
+            break;
+    }
+
+    return complete_segment;
+}
+
+/**
+ * @brief The lane table indices of the lanes along the given keys, with the
+ * gaps between them filled in from the lane graph.
+ */
+std::vector<int32_t> MapManagementNode::getRouteLanes(const std::vector<odr::LaneKey> &keys)
 {
 
     // Move from first to second-to-last key.
@@ -581,33 +1029,13 @@ std::vector<LineString> MapManagementNode::getCenterlinesFromKeys(std::vector<od
     // Loop starts at last key and works to the first key
     for (auto iter = keys.end() - 1; iter != keys.begin(); iter--)
     {
-        std::vector<odr::LaneKey> complete_segment; // keys, but with gaps in lanes filled.
-        odr::LaneKey from = *iter;
-        odr::LaneKey to = *(iter - 1);
+        const odr::LaneKey &from = *iter;
+        const odr::LaneKey &to = *(iter - 1);
         // std::printf("(%s)=>(%s)\n", from.to_string().c_str(), to.to_string().c_str());
         if (from.to_string() == to.to_string()) // Keys have the same lane
             continue;
-        auto adjacency_pairs = bfs(from, to, graph);
-        // std::printf("BFS returned %i pairs\n", adjacency_pairs.size());
-
-        complete_segment.push_back(to);
-
-        // Work our way back from destination to source in the tree search,
-        // producing a continuous LaneKey route.
-        try
-        {
-            odr::LaneKey parent = adjacency_pairs.at(to);
-            do
-            {
-                complete_segment.push_back(parent);
-                parent = adjacency_pairs.at(parent);
-            } while (parent.to_string() != from.to_string());
-        }
-        catch (...)
-        {
-            // RCLCPP_ERROR(get_logger(), "BFS could not locate route parent. Returning.");
-        }
 
+        const std::vector<odr::LaneKey> &complete_segment = getLanePath(from, to);
         complete_keys.insert(complete_keys.begin(), complete_segment.begin(), complete_segment.end());
     }
 
@@ -615,16 +1043,16 @@ std::vector<LineString> MapManagementNode::getCenterlinesFromKeys(std::vector<od
     complete_keys.push_back(keys.back());
 
     // We now have a continuous LaneKey sequence that connects all provided Keys.
-    std::vector<LineString> centerlines;
-    for (auto key : complete_keys)
+    std::vector<int32_t> route_lanes;
+    route_lanes.reserve(complete_keys.size());
+    for (const odr::LaneKey &key : complete_keys)
     {
-        // std::printf("%s\n", key.to_string().c_str());
-
-        LineString centerline = getLaneCenterline(key);
-        centerlines.push_back(centerline);
+        const int32_t k = lane_table_.index(key);
+        if (k != LaneTable::NO_LANE)
+            route_lanes.push_back(k);
     }
 
-    return centerlines;
+    return route_lanes;
 }
 
 /**
@@ -640,37 +1068,72 @@ std::vector<LineString> MapManagementNode::getCenterlinesFromKeys(std::vector<od
  */
 void MapManagementNode::publishRefinedRoute()
 {
-    if (rough_route_tree_.empty() || map_wide_tree_.empty())
+    if (rm.empty() || map_wide_tree_.empty())
         return;
 
+    auto begin = std::chrono::steady_clock::now();
+
     // Get waypoint closest to ego
     auto ego_tf = getVehicleTf();
+    latency_tracker::StageRecorder::Run latency_run = route_latency_recorder_->start();
+    latency_run.input("/tf", ego_tf.header.stamp);
     BoostPoint ego_pos(ego_tf.transform.translation.x, ego_tf.transform.translation.y);
 
+    // Project ego onto the route. The nearest waypoint is at one end of the
+    // projection's segment.
+    const RouteManager::Projection ego_on_route = rm.project(ego_pos);
+    std::size_t nearest_idx = ego_on_route.segment;
+    if (nearest_idx + 1 < rough_route_.size() &&
+        bg::distance(ego_pos, rough_route_[nearest_idx + 1]) < bg::distance(ego_pos, rough_route_[nearest_idx]))
+        nearest_idx++;
+
     // Get indices of waypoint ROI
-    RoiIndices waypoint_roi = getWaypointsInROI(rough_route_, rough_route_tree_, ego_pos);
+    RoiIndices waypoint_roi = getWaypointsInROI(rough_route_, int(nearest_idx), ego_pos);
 
-    // Let's take a moment to publish our route progress using this info
-    float route_progress = static_cast<float>(waypoint_roi.center) / rough_route_.size();
+    // Let's take a moment to publish our route progress (by distance along it)
     std_msgs::msg::Float32 progress_msg;
-    progress_msg.data = route_progress;
+    progress_msg.data = rm.progress();
     route_progress_pub_->publish(progress_msg);
 
     // Get LaneKeys
-    std::vector<odr::LaneKey> keys = getLaneKeysFromIndices(waypoint_roi, rough_route_, map_wide_tree_, lane_polys_);
-
-    // Get centerlines
-    auto centerlines = getCenterlinesFromKeys(keys, map_->get_routing_graph());
+    auto lanes_start = std::chrono::steady_clock::now();
+    recordStage(route_first_stage_ + ROUTE_ROI, begin, lanes_start);
+    std::vector<odr::LaneKey> keys = getLaneKeysFromIndices(waypoint_roi, rough_route_, map_wide_tree_, lane_table_);
+    auto resolve_start = std::chrono::steady_clock::now();
+    recordStage(route_first_stage_ + ROUTE_LANES, lanes_start, resolve_start);
+    if (keys.empty())
+    {
+        pending_timings_.clear();
+        return;
+    }
+    const std::size_t lane_count = keys.size();
 
-    // Orient them so that their ends and beginnings properly match
-    LineString route_ls = getReorientedRoute(centerlines);
-    bg::simplify(route_ls, local_route_linestring_, 1.0);
+    // The route only changes when the lanes under the ROI do. Until then,
+    // reuse the last result.
+    bool keys_changed = keys.size() != route_keys_.size() ||
+                        !std::equal(keys.begin(), keys.end(), route_keys_.begin(), std::equal_to<odr::LaneKey>());
+    if (keys_changed)
+    {
+        // Get the lanes, gaps included
+        std::vector<int32_t> route_lanes = getRouteLanes(keys);
+
+        // Join their centerlines so that their ends and beginnings properly match
+        route_ls_ = getReorientedRoute(lane_table_, route_lanes);
+        bg::simplify(route_ls_, local_route_linestring_, 1.0);
+        local_route_version_++;
+        route_keys_ = std::move(keys);
+    }
+    const LineString &route_ls = route_ls_;
+    auto publish_start = std::chrono::steady_clock::now();
+    if (keys_changed)
+        recordStage(route_first_stage_ + ROUTE_RESOLVE, resolve_start, publish_start);
 
     // Convert to ROS message
     Path result;
     result.header.frame_id = "map";
     result.header.stamp = clock_->clock;
-    for (auto pt : route_ls)
+    navigator::trace::flow("map_management.route", navigator::trace::flow_id(result.header.stamp));
+    for (const auto &pt : route_ls)
     {
         PoseStamped pose;
         pose.pose.position.x = pt.get<0>();
@@ -681,45 +1144,124 @@ void MapManagementNode::publishRefinedRoute()
     }
 
     route_path_pub_->publish(result);
+    latency_run.finish(result.header.stamp);
+
+    auto end = std::chrono::steady_clock::now();
+    recordStage(route_first_stage_ + ROUTE_PUBLISH, publish_start, end);
+    recordStage(route_first_stage_ + ROUTE_TOTAL, begin, end);
+    writeTimingRows(ego_pos.get<0>(), ego_pos.get<1>(), lane_count);
 }
 
-std::map<odr::LaneKey, bool> MapManagementNode::getJunctionMap(std::vector<odr::LanePair> lane_polys)
+/**
+ * @brief Parse a map and build everything derived from it.
+ *
+ * Runs on a background thread, so it touches no node state.
+ */
+std::unique_ptr<MapManagementNode::LoadedMap> MapManagementNode::loadMap(CarlaWorldInfo::SharedPtr msg, bool rasterize, float res,
+                                                                        const std::string &cache_dir)
 {
-    std::map<odr::LaneKey, bool> map;
-    for (auto pair : lane_polys)
+    NOVA_TRACE_SPAN("map_management.load_map");
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    auto loaded = std::make_unique<LoadedMap>();
+    loaded->name = msg->map_name;
+
+    const MapCache cache(cache_dir);
+    const uint64_t hash = MapCache::hash(msg->opendrive);
+    std::vector<odr::value> envelopes;
+    loaded->from_cache = !cache_dir.empty() && cache.read(hash, loaded->lane_table, loaded->lane_graph, envelopes, loaded->signal_table);
+
+    if (!loaded->from_cache)
     {
-        odr::Lane lane = pair.first;
-        odr::Road road = this->map_->id_to_road.at(lane.key.road_id);
-        if (road.junction != "-1" && lane.type == "driving")
-            map[lane.key] = true;
-        else
-            map[lane.key] = false;
+        // Ask libopendrive to parse the map string in place, rather than
+        // copy it twice. The message is this callback's own, and nothing
+        // reads opendrive after the hash above.
+        odr::OpenDriveMap map(odr::InPlaceBuffer{&msg->opendrive[0], msg->opendrive.size()});
+        // Get lane polygons as pairs (Lane object, ring polygon)
+        const std::vector<odr::LanePair> &lane_polys = map.get_lane_polygons(1.0, false);
+
+        // Values index lane_polys, as with OpenDriveMap::generate_mesh_tree().
+        envelopes.reserve(lane_polys.size());
+        for (unsigned i = 0; i < lane_polys.size(); i++)
+            envelopes.emplace_back(bg::return_envelope<odr::box>(lane_polys[i].second), i);
+
+        loaded->lane_graph = LaneGraph(map.get_routing_graph());
+        loaded->lane_table = LaneTable(map, lane_polys);
+        loaded->signal_table = SignalTable(map);
+        if (!cache_dir.empty())
+            loaded->cache_write_failed = !cache.write(hash, loaded->lane_table, loaded->lane_graph, envelopes, loaded->signal_table);
     }
 
-    return map;
+    // Bulk-load (pack) the map-wide tree from the lanes' bounding boxes.
+    loaded->tree = bgi::rtree<odr::value, bgi::rstar<16, 4>>(envelopes);
+    if (rasterize)
+        loaded->lane_raster = LaneRaster(loaded->lane_table, res);
+
+    loaded->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return loaded;
 }
 
 /**
- * @brief When map data is received from a CarlaWorldInfo message, load and process it
+ * @brief When map data is received from a CarlaWorldInfo message, start
+ * loading it in the background, or load it now if background_map_load is
+ * off
  *
  * @param msg The incoming CarlaWorldInfo message
  */
 void MapManagementNode::worldInfoCb(CarlaWorldInfo::SharedPtr msg)
 {
-    if (this->map_ != nullptr)
-        return; // Our map is already loaded. No need to continue.
+    if (map_ready_ || map_loading_.valid())
+        return; // Our map is already loaded or loading. No need to continue.
     if (msg->opendrive == "")
     {
         RCLCPP_INFO(this->get_logger(), "Received empty map string from world_info topic. Waiting for real data.");
         return;
     }
 
-    // Ask libopendrive to parse the map string
-    this->map_ = new odr::OpenDriveMap(msg->opendrive, true);
-    // Get lane polygons as pairs (Lane object, ring polygon)
-    this->lane_polys_ = map_->get_lane_polygons(1.0, false);
+    if (!background_map_load_)
+    {
+        RCLCPP_INFO(this->get_logger(), "Loading %s", msg->map_name.c_str());
+        adoptMap(loadMap(msg, use_lane_raster_, GRID_RES, map_cache_dir_));
+        return;
+    }
 
-    this->road_in_junction_map_ = this->getJunctionMap(this->lane_polys_);
+    RCLCPP_INFO(this->get_logger(), "Loading %s in the background", msg->map_name.c_str());
+    map_loading_ = std::async(std::launch::async, &MapManagementNode::loadMap, msg, use_lane_raster_, GRID_RES, map_cache_dir_);
+    map_load_timer_ = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(MAP_LOAD_POLL_PERIOD), bind(&MapManagementNode::mapLoadTimerCb, this));
+}
 
-    RCLCPP_INFO(this->get_logger(), "Loaded %s", msg->map_name.c_str());
-}
\ No newline at end of file
+/**
+ * @brief Once the background load has finished, adopt its results on the
+ * executor thread.
+ */
+void MapManagementNode::mapLoadTimerCb()
+{
+    if (map_loading_.wait_for(0s) != std::future_status::ready)
+        return;
+    map_load_timer_->cancel();
+    adoptMap(map_loading_.get());
+}
+
+/**
+ * @brief Take over a loaded map and announce that it is ready.
+ */
+void MapManagementNode::adoptMap(std::unique_ptr<LoadedMap> loaded)
+{
+    this->map_ready_ = true;
+    this->map_wide_tree_ = std::move(loaded->tree);
+    this->lane_graph_ = std::move(loaded->lane_graph);
+    this->lane_table_ = std::move(loaded->lane_table);
+    this->lane_raster_ = std::move(loaded->lane_raster);
+    this->signal_table_ = std::move(loaded->signal_table);
+
+    if (use_lane_raster_)
+        RCLCPP_INFO(this->get_logger(), "Rasterized %zu lanes into %zu tiles",
+                    lane_table_.size(), lane_raster_.tileCount());
+    if (loaded->cache_write_failed)
+        RCLCPP_WARN(this->get_logger(), "Could not write the map cache to %s", map_cache_dir_.c_str());
+    RCLCPP_INFO(this->get_logger(), "Loaded %s%s in %.1f s", loaded->name.c_str(),
+                loaded->from_cache ? " from the map cache" : "", loaded->seconds);
+
+    std_msgs::msg::Bool ready_msg;
+    ready_msg.data = true;
+    map_ready_pub_->publish(ready_msg);
+}
@@ -0,0 +1,117 @@
+/*
+ * Package:   map_management
+ * Filename:  MapMatchingNode.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "map_management/MapMatchingNode.hpp"
+#include "nova_trace/Trace.hpp"
+
+#include <chrono>
+#include <vector>
+
+using namespace navigator::planning;
+using carla_msgs::msg::CarlaWorldInfo;
+using nova_msgs::srv::MatchLanes;
+
+MapMatchingNode::MapMatchingNode(const rclcpp::NodeOptions &options) : Node("map_matching_node", options)
+{
+    // Whether only "driving" lanes are matched. Off, so that poses on
+    // shoulders and sidewalks still learn where they are.
+    drivable_only_ = this->declare_parameter<bool>("drivable_only", false);
+    // Side of the matcher's hash cells, in meters. Smaller cells test
+    // fewer lane pieces per query but take more memory.
+    cell_size_ = this->declare_parameter<double>("cell_size", 4.0);
+
+    world_info_sub_ = this->create_subscription<CarlaWorldInfo>("/carla/world_info", 10, bind(&MapMatchingNode::worldInfoCb, this, std::placeholders::_1));
+    match_lanes_srv_ = this->create_service<MatchLanes>("/map_management/match_lanes", bind(&MapMatchingNode::matchLanes, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+/**
+ * @brief Parse a map and build its matcher.
+ *
+ * Runs on a background thread, so it touches no node state.
+ */
+std::unique_ptr<MapMatchingNode::LoadedMap> MapMatchingNode::loadMap(CarlaWorldInfo::SharedPtr msg, bool drivable_only, double cell_size)
+{
+    NOVA_TRACE_SPAN("map_matching.load_map");
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    auto loaded = std::make_unique<LoadedMap>();
+    loaded->world_info = msg;
+    loaded->map = std::make_unique<odr::OpenDriveMap>(odr::InPlaceBuffer{&msg->opendrive[0], msg->opendrive.size()});
+    loaded->matcher = std::make_unique<odr::LaneMatcher>(*loaded->map, drivable_only, cell_size);
+    loaded->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return loaded;
+}
+
+/**
+ * @brief Start loading the first non-empty map received.
+ */
+void MapMatchingNode::worldInfoCb(CarlaWorldInfo::SharedPtr msg)
+{
+    if (loaded_ || map_loading_.valid() || msg->opendrive == "")
+        return;
+
+    // The map is parsed in place, which the message, this callback's own,
+    // is free for
+    RCLCPP_INFO(this->get_logger(), "Loading %s in the background", msg->map_name.c_str());
+    map_loading_ = std::async(std::launch::async, &MapMatchingNode::loadMap, msg, drivable_only_, cell_size_);
+    map_load_timer_ = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(MAP_LOAD_POLL_PERIOD), bind(&MapMatchingNode::mapLoadTimerCb, this));
+}
+
+void MapMatchingNode::mapLoadTimerCb()
+{
+    if (map_loading_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+    map_load_timer_->cancel();
+    loaded_ = map_loading_.get();
+    RCLCPP_INFO(this->get_logger(), "Loaded %s in %.1f s: %zu lanes in %zu pieces", loaded_->world_info->map_name.c_str(),
+                loaded_->seconds, loaded_->matcher->lane_count(), loaded_->matcher->size());
+}
+
+/**
+ * @brief Match every pose of the request to its lane.
+ */
+void MapMatchingNode::matchLanes(const std::shared_ptr<MatchLanes::Request> request, std::shared_ptr<MatchLanes::Response> response)
+{
+    const std::size_t count = request->x.size();
+    if (request->y.size() != count || request->heading.size() != count)
+    {
+        RCLCPP_WARN(this->get_logger(), "Ignoring a match_lanes request with %zu x, %zu y and %zu headings",
+                    count, request->y.size(), request->heading.size());
+        return;
+    }
+
+    std::vector<odr::LanePose> poses(count);
+    for (std::size_t i = 0; i < count; i++)
+        poses[i] = {request->x[i], request->y[i], request->heading[i]};
+    std::vector<odr::LaneMatch> matches(count);
+    if (loaded_)
+        loaded_->matcher->match(poses.data(), count, matches.data());
+    else
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000, "No map yet. Every pose is unmatched.");
+
+    response->matched.resize(count);
+    response->road_id.resize(count);
+    response->lanesection_s0.resize(count);
+    response->lane_id.resize(count);
+    response->s.resize(count);
+    response->t.resize(count);
+    response->heading_error.resize(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const odr::LaneMatch &match = matches[i];
+        response->matched[i] = match.matched;
+        response->road_id[i] = match.key.road_id;
+        response->lanesection_s0[i] = match.key.lanesection_s0;
+        response->lane_id[i] = match.key.lane_id;
+        response->s[i] = match.s;
+        response->t[i] = match.t;
+        response->heading_error[i] = match.heading_error;
+    }
+}
@@ -1,19 +1,153 @@
+/*
+ * Package:   map_management
+ * Filename:  RouteManager.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
 #include "map_management/RouteManager.hpp"
 
+#include <algorithm>
+
 using namespace navigator::planning;
 
 RouteManager::RouteManager()
 {
 }
 
-/**
- * @brief Returns a refined route given current position and the rough route
- *
- * @param rough A rough route, with a minimum of two waypoints
- * @param pos Our current position
- * @return A refined path, with smooth and rough sections, and with the route behind us removed.
- */
-LineString RouteManager::getRoute(const LineString rough, const BoostPoint pos)
+void RouteManager::setRoute(const LineString &route)
+{
+    route_ = route;
+    // A single point is a route of one zero-length segment.
+    if (route_.size() == 1)
+        route_.push_back(route_.front());
+
+    s_.resize(route_.size());
+    std::vector<std::pair<Segment, unsigned>> segments;
+    segments.reserve(route_.size());
+    for (std::size_t i = 0; i < route_.size(); i++)
+    {
+        s_[i] = i == 0 ? 0.0f : s_[i - 1] + float(bg::distance(route_[i - 1], route_[i]));
+        if (i + 1 < route_.size())
+            segments.emplace_back(Segment(route_[i], route_[i + 1]), unsigned(i));
+    }
+
+    // The range constructor bulk-loads (packs) the tree.
+    segment_tree_ = bgi::rtree<std::pair<Segment, unsigned>, bgi::rstar<16, 4>>(segments);
+    cursor_ = Projection();
+    if (!route_.empty())
+        cursor_.point = route_.front();
+}
+
+std::size_t RouteManager::segmentAt(float s) const
+{
+    const std::size_t after = std::upper_bound(s_.begin(), s_.end(), s) - s_.begin();
+    return std::clamp<std::size_t>(after, 1, s_.size() - 1) - 1;
+}
+
+RouteManager::Projection RouteManager::projectOnto(const BoostPoint &pos, std::size_t segment) const
+{
+    const BoostPoint &a = route_[segment];
+    const BoostPoint &b = route_[segment + 1];
+    const float dx = b.get<0>() - a.get<0>();
+    const float dy = b.get<1>() - a.get<1>();
+    const float length_sq = dx * dx + dy * dy;
+
+    float t = 0.0f;
+    if (length_sq > 0.0f)
+        t = std::clamp(((pos.get<0>() - a.get<0>()) * dx + (pos.get<1>() - a.get<1>()) * dy) / length_sq, 0.0f, 1.0f);
+
+    Projection p;
+    p.segment = segment;
+    p.point = BoostPoint(a.get<0>() + t * dx, a.get<1>() + t * dy);
+    p.s = s_[segment] + t * (s_[segment + 1] - s_[segment]);
+    p.distance = float(bg::distance(pos, p.point));
+    return p;
+}
+
+RouteManager::Projection RouteManager::project(const BoostPoint &pos)
+{
+    if (route_.empty())
+        return cursor_;
+
+    // Follow the route from just behind the cursor.
+    const std::size_t last = route_.size() - 2;
+    const std::size_t from = cursor_.segment < 2 ? 0 : cursor_.segment - 2;
+    const std::size_t to = std::min(last, cursor_.segment + CURSOR_WINDOW);
+    Projection best = projectOnto(pos, from);
+    for (std::size_t i = from + 1; i <= to; i++)
+    {
+        Projection p = projectOnto(pos, i);
+        if (p.distance < best.distance)
+            best = p;
+    }
+
+    // Off that stretch (a jump, or a fresh start): find the nearest segment.
+    if (best.distance > CURSOR_TOLERANCE)
+    {
+        std::vector<std::pair<Segment, unsigned>> nearest;
+        segment_tree_.query(bgi::nearest(pos, 1), std::back_inserter(nearest));
+        if (!nearest.empty())
+        {
+            Projection p = projectOnto(pos, nearest.front().second);
+            if (p.distance < best.distance)
+                best = p;
+        }
+    }
+
+    cursor_ = best;
+    return cursor_;
+}
+
+float RouteManager::progress() const
+{
+    return length() > 0.0f ? cursor_.s / length() : 0.0f;
+}
+
+BoostPoint RouteManager::pointAt(float s) const
 {
-    std::printf("Rough route has %i waypoints\n", rough.size());
-}
\ No newline at end of file
+    if (route_.empty())
+        return BoostPoint(0.0f, 0.0f);
+
+    const std::size_t i = segmentAt(s);
+    const float span = s_[i + 1] - s_[i];
+    const float t = span > 0.0f ? std::clamp((s - s_[i]) / span, 0.0f, 1.0f) : 0.0f;
+    const BoostPoint &a = route_[i];
+    const BoostPoint &b = route_[i + 1];
+    return BoostPoint(a.get<0>() + t * (b.get<0>() - a.get<0>()), a.get<1>() + t * (b.get<1>() - a.get<1>()));
+}
+
+LineString RouteManager::slice(float s_from, float s_to) const
+{
+    LineString result;
+    if (route_.empty())
+        return result;
+
+    s_from = std::clamp(s_from, 0.0f, length());
+    s_to = std::clamp(s_to, s_from, length());
+
+    // Points strictly between the ends are copied as they are.
+    const std::size_t first = std::upper_bound(s_.begin(), s_.end(), s_from) - s_.begin();
+    const std::size_t last = std::max(first, std::size_t(std::lower_bound(s_.begin(), s_.end(), s_to) - s_.begin()));
+
+    result.push_back(pointAt(s_from));
+    result.insert(result.end(), route_.begin() + first, route_.begin() + last);
+    if (s_to > s_from)
+        result.push_back(pointAt(s_to));
+    return result;
+}
+
+LineString RouteManager::getRoute(const LineString &rough, const BoostPoint &pos)
+{
+    const bool same = rough.size() == route_.size() &&
+                      std::equal(rough.begin(), rough.end(), route_.begin(),
+                                 [](const BoostPoint &a, const BoostPoint &b)
+                                 { return bg::equals(a, b); });
+    if (!same)
+        setRoute(rough);
+
+    project(pos);
+    return slice(cursor_.s, length());
+}
@@ -0,0 +1,219 @@
+/*
+ * Package:   map_management
+ * Filename:  SharedGrids.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "map_management/SharedGrids.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace navigator::planning;
+
+namespace
+{
+    constexpr char MAGIC[8] = {'N', 'A', 'V', 'G', 'R', 'I', 'D', '1'};
+    constexpr uint32_t VERSION = 1;
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "seqlocks in shared memory need lock-free atomics");
+
+    // Tiles start on cache lines, so writers of neighbouring tiles don't
+    // share one.
+    constexpr std::size_t align64(std::size_t n) { return (n + 63) & ~std::size_t(63); }
+
+    void *mapSegment(int fd, std::size_t size, int prot)
+    {
+        void *mapping = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+        ::close(fd);
+        return mapping == MAP_FAILED ? nullptr : mapping;
+    }
+}
+
+SharedGridWriter::SharedGridWriter(const std::string &name, uint32_t width, uint32_t height, float resolution,
+                                   float origin_x, float origin_y, uint32_t tile_size)
+    : name_(name)
+{
+    const uint32_t tiles_x = (width + tile_size - 1) / tile_size;
+    const uint32_t tiles_y = (height + tile_size - 1) / tile_size;
+    const std::size_t tile_bytes = align64(sizeof(SharedTileHeader) + std::size_t(SHARED_LAYER_COUNT) * tile_size * tile_size);
+    size_ = align64(sizeof(SharedGridHeader)) + tile_bytes * tiles_x * tiles_y;
+
+    const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0 || ftruncate(fd, 0) != 0 || ftruncate(fd, off_t(size_)) != 0)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        throw std::runtime_error("Could not create shared memory segment " + name);
+    }
+    void *mapping = mapSegment(fd, size_, PROT_READ | PROT_WRITE);
+    if (mapping == nullptr)
+    {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Could not map shared memory segment " + name);
+    }
+
+    // ftruncate zero-filled the segment, so seq and frame start at 0.
+    header_ = static_cast<SharedGridHeader *>(mapping);
+    tiles_ = static_cast<char *>(mapping) + align64(sizeof(SharedGridHeader));
+    header_->version = VERSION;
+    header_->layer_count = SHARED_LAYER_COUNT;
+    header_->width = width;
+    header_->height = height;
+    header_->tile_size = tile_size;
+    header_->tiles_x = tiles_x;
+    header_->tiles_y = tiles_y;
+    header_->tile_bytes = uint32_t(tile_bytes);
+    header_->resolution = resolution;
+    header_->origin_x = origin_x;
+    header_->origin_y = origin_y;
+
+    // Cells past the grid's edge, and every cell until the first frame,
+    // are unknown.
+    for (uint32_t t = 0; t < tiles_x * tiles_y; t++)
+        std::memset(tiles_ + t * tile_bytes + sizeof(SharedTileHeader), -1, tile_bytes - sizeof(SharedTileHeader));
+
+    // Written last, so a reader that sees the magic sees the rest.
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+}
+
+SharedGridWriter::~SharedGridWriter()
+{
+    munmap(header_, size_);
+    shm_unlink(name_.c_str());
+}
+
+void SharedGridWriter::beginFrame(int64_t stamp_ns)
+{
+    header_->seq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->frame++;
+    header_->stamp_ns = stamp_ns;
+    header_->seq.fetch_add(1, std::memory_order_release);
+}
+
+void SharedGridWriter::touch(int64_t stamp_ns)
+{
+    beginFrame(stamp_ns);
+}
+
+void SharedGridWriter::write(const int8_t *const layers[SHARED_LAYER_COUNT], int64_t stamp_ns)
+{
+    beginFrame(stamp_ns);
+
+    const uint32_t n = header_->tile_size;
+    const std::size_t layer_cells = std::size_t(n) * n;
+    for (uint32_t ty = 0; ty < header_->tiles_y; ty++)
+    {
+        for (uint32_t tx = 0; tx < header_->tiles_x; tx++)
+        {
+            char *tile = tiles_ + (std::size_t(ty) * header_->tiles_x + tx) * header_->tile_bytes;
+            auto *tile_header = reinterpret_cast<SharedTileHeader *>(tile);
+            int8_t *cells = reinterpret_cast<int8_t *>(tile + sizeof(SharedTileHeader));
+
+            const uint32_t col0 = tx * n, row0 = ty * n;
+            const uint32_t cols = std::min(n, header_->width - col0);
+            const uint32_t rows = std::min(n, header_->height - row0);
+
+            // Only tiles that changed are rewritten.
+            bool changed = false;
+            for (uint32_t layer = 0; layer < SHARED_LAYER_COUNT && !changed; layer++)
+            {
+                if (layers[layer] == nullptr)
+                    continue;
+                for (uint32_t r = 0; r < rows && !changed; r++)
+                {
+                    const int8_t *src = layers[layer] + std::size_t(row0 + r) * header_->width + col0;
+                    changed = std::memcmp(cells + layer * layer_cells + r * n, src, cols) != 0;
+                }
+            }
+            if (!changed)
+                continue;
+
+            tile_header->seq.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (uint32_t layer = 0; layer < SHARED_LAYER_COUNT; layer++)
+            {
+                if (layers[layer] == nullptr)
+                    continue;
+                for (uint32_t r = 0; r < rows; r++)
+                {
+                    const int8_t *src = layers[layer] + std::size_t(row0 + r) * header_->width + col0;
+                    std::memcpy(cells + layer * layer_cells + r * n, src, cols);
+                }
+            }
+            tile_header->frame = header_->frame;
+            tile_header->seq.fetch_add(1, std::memory_order_release);
+        }
+    }
+}
+
+SharedGridReader::SharedGridReader(const std::string &name)
+{
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(SharedGridHeader))
+    {
+        if (fd >= 0)
+            ::close(fd);
+        throw std::runtime_error("No shared grid segment " + name);
+    }
+    size_ = std::size_t(st.st_size);
+    void *mapping = mapSegment(fd, size_, PROT_READ);
+    if (mapping == nullptr)
+        throw std::runtime_error("Could not map shared grid segment " + name);
+
+    header_ = static_cast<const SharedGridHeader *>(mapping);
+    tiles_ = static_cast<const char *>(mapping) + align64(sizeof(SharedGridHeader));
+
+    const bool valid = std::memcmp(header_->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                       header_->version == VERSION && header_->layer_count == SHARED_LAYER_COUNT &&
+                       align64(sizeof(SharedGridHeader)) + std::size_t(header_->tile_bytes) * header_->tiles_x * header_->tiles_y <= size_;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid)
+    {
+        munmap(const_cast<SharedGridHeader *>(header_), size_);
+        throw std::runtime_error("Malformed shared grid segment " + name);
+    }
+}
+
+SharedGridReader::~SharedGridReader()
+{
+    munmap(const_cast<SharedGridHeader *>(header_), size_);
+}
+
+bool SharedGridReader::readTile(uint32_t tile_x, uint32_t tile_y, SharedGridLayer layer, int8_t *out, uint64_t &frame) const
+{
+    const std::size_t layer_cells = std::size_t(header_->tile_size) * header_->tile_size;
+    const char *tile = tiles_ + (std::size_t(tile_y) * header_->tiles_x + tile_x) * header_->tile_bytes;
+    const auto *tile_header = reinterpret_cast<const SharedTileHeader *>(tile);
+
+    const uint32_t before = tile_header->seq.load(std::memory_order_acquire);
+    if (before & 1)
+        return false;
+    std::memcpy(out, tile + sizeof(SharedTileHeader) + layer * layer_cells, layer_cells);
+    frame = tile_header->frame;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return tile_header->seq.load(std::memory_order_relaxed) == before;
+}
+
+bool SharedGridReader::readFrame(uint64_t &frame, int64_t &stamp_ns) const
+{
+    const uint32_t before = header_->seq.load(std::memory_order_acquire);
+    if (before & 1)
+        return false;
+    frame = header_->frame;
+    stamp_ns = header_->stamp_ns;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header_->seq.load(std::memory_order_relaxed) == before;
+}
@@ -0,0 +1,76 @@
+/*
+ * Package:   map_management
+ * Filename:  SignalTable.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "map_management/SignalTable.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace navigator::planning;
+
+namespace
+{
+    bool atJunction(const odr::Road &road, double s)
+    {
+        return road.junction != "-1" ||
+               (road.successor.type == odr::RoadLink::Type_Junction && road.length - s <= SignalTable::JUNCTION_APPROACH) ||
+               (road.predecessor.type == odr::RoadLink::Type_Junction && s <= SignalTable::JUNCTION_APPROACH);
+    }
+}
+
+SignalTable::SignalTable(const odr::OpenDriveMap &map)
+{
+    auto add = [&](const odr::Road &road, double s, double t, double z0, uint8_t flags, const std::string &type)
+    {
+        const odr::Vec3D xyz = road.get_surface_pt(s, t);
+        points_.emplace_back(xyz[0], xyz[1]);
+        z_.push_back(float(xyz[2] + z0));
+        flags_.push_back(flags | (atJunction(road, s) ? AT_JUNCTION : 0));
+
+        auto name = std::find(type_names_.begin(), type_names_.end(), type);
+        if (name == type_names_.end())
+            name = type_names_.insert(type_names_.end(), type);
+        type_.push_back(uint16_t(name - type_names_.begin()));
+    };
+
+    for (const odr::Road &road : map.roads())
+    {
+        for (const odr::RoadObject &object : road.road_objects())
+            add(road, object.s0, object.t0, object.z0, 0, object.type);
+        for (const odr::RoadSignal &signal : road.signals())
+        {
+            const bool traffic_light = signal.dynamic || signal.type == "1000001";
+            add(road, signal.s, signal.t, signal.z0, SIGNAL | (traffic_light ? TRAFFIC_LIGHT : 0), signal.type);
+        }
+    }
+    buildTree();
+}
+
+void SignalTable::buildTree()
+{
+    std::vector<std::pair<odr::point, uint32_t>> values;
+    values.reserve(points_.size());
+    for (uint32_t k = 0; k < points_.size(); k++)
+        values.emplace_back(points_[k], k);
+    tree_ = bgi::rtree<std::pair<odr::point, uint32_t>, bgi::rstar<16, 4>>(values);
+}
+
+void SignalTable::query(double x, double y, double radius, uint8_t flags, std::vector<uint32_t> &out) const
+{
+    const odr::box region(odr::point(float(x - radius), float(y - radius)), odr::point(float(x + radius), float(y + radius)));
+    const double radius2 = radius * radius;
+    auto wanted = [&](const std::pair<odr::point, uint32_t> &value)
+    {
+        const double dx = value.first.get<0>() - x;
+        const double dy = value.first.get<1>() - y;
+        return (flags_[value.second] & flags) == flags && dx * dx + dy * dy <= radius2;
+    };
+    for (auto it = tree_.qbegin(bgi::intersects(region) && bgi::satisfies(wanted)); it != tree_.qend(); ++it)
+        out.push_back(it->second);
+}
@@ -0,0 +1,168 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  dst_kernel_bench.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Micro-benchmark comparing the fused DST kernel with the original
+// three-pass update, and with its fixed-point version.
+// Usage: dst_kernel_bench [grid_size] [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "occupancy_cpp/DstKernel.hpp"
+
+using namespace navigator::perception;
+
+namespace
+{
+  struct Planes
+  {
+    std::vector<float> meas_occ, meas_free, occ, free, prob;
+
+    explicit Planes(std::size_t n) : meas_occ(n), meas_free(n), occ(n), free(n), prob(n) {}
+  };
+
+  struct FixedPlanes
+  {
+    std::vector<uint16_t> meas_occ, meas_free, occ, free, prob;
+
+    explicit FixedPlanes(const Planes &p)
+        : meas_occ(convert(p.meas_occ)), meas_free(convert(p.meas_free)), occ(convert(p.occ)),
+          free(convert(p.free)), prob(convert(p.prob)) {}
+
+    static std::vector<uint16_t> convert(const std::vector<float> &plane)
+    {
+      std::vector<uint16_t> fixed(plane.size());
+      std::transform(plane.begin(), plane.end(), fixed.begin(), dst::toMass<uint16_t>);
+      return fixed;
+    }
+  };
+
+  // Fill planes with valid masses (occ + free <= 1), similar to a real frame.
+  void randomize(Planes &p, unsigned int seed)
+  {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::uniform_int_distribution<int> kind(0, 2);
+
+    for (std::size_t i = 0; i < p.occ.size(); i++)
+    {
+      float a = dist(gen);
+      p.occ[i] = a;
+      p.free[i] = (1.0f - a) * dist(gen);
+
+      switch (kind(gen))
+      {
+      case 0: // occupied
+        p.meas_occ[i] = 0.95f;
+        p.meas_free[i] = 0.0f;
+        break;
+      case 1: // free
+        p.meas_occ[i] = 0.0f;
+        p.meas_free[i] = 0.95f;
+        break;
+      default: // unknown
+        p.meas_occ[i] = 0.0f;
+        p.meas_free[i] = 0.0f;
+      }
+    }
+  }
+
+  template <typename F>
+  double timeNs(int iterations, F &&f)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+      f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const std::size_t grid_size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 128;
+  const int iterations = argc > 2 ? std::atoi(argv[2]) : 2000;
+  const std::size_t n = grid_size * grid_size;
+  const float decay_factor = 0.9f;
+
+  Planes three_pass(n);
+  randomize(three_pass, 42);
+  Planes fused = three_pass;
+  Planes scalar = three_pass;
+  FixedPlanes fixed(three_pass);
+  std::vector<float> occ_pred(n), free_pred(n);
+
+  // Validate a single step before timing.
+  dst::threePassUpdate(three_pass.meas_occ.data(), three_pass.meas_free.data(), three_pass.occ.data(),
+                       three_pass.free.data(), three_pass.prob.data(), occ_pred.data(), free_pred.data(), n, decay_factor);
+  dst::fusedUpdate(fused.meas_occ.data(), fused.meas_free.data(), fused.occ.data(),
+                   fused.free.data(), fused.prob.data(), n, decay_factor);
+  dst::fusedUpdate(fixed.meas_occ.data(), fixed.meas_free.data(), fixed.occ.data(),
+                   fixed.free.data(), fixed.prob.data(), n, decay_factor);
+
+  float max_diff = 0.0f;
+  float max_fixed_diff = 0.0f;
+  for (std::size_t i = 0; i < n; i++)
+  {
+    max_diff = std::max(max_diff, std::abs(three_pass.occ[i] - fused.occ[i]));
+    max_diff = std::max(max_diff, std::abs(three_pass.free[i] - fused.free[i]));
+    max_diff = std::max(max_diff, std::abs(three_pass.prob[i] - fused.prob[i]));
+    max_fixed_diff = std::max(max_fixed_diff, std::abs(three_pass.occ[i] - dst::massValue(fixed.occ[i])));
+    max_fixed_diff = std::max(max_fixed_diff, std::abs(three_pass.free[i] - dst::massValue(fixed.free[i])));
+    max_fixed_diff = std::max(max_fixed_diff, std::abs(three_pass.prob[i] - dst::massValue(fixed.prob[i])));
+  }
+
+  // Every timed frame starts from the same prior so the masses never decay
+  // into denormals, which would make the numbers meaningless.
+  const Planes prior = fused;
+  auto reset = [&](Planes &p)
+  {
+    std::copy(prior.occ.begin(), prior.occ.end(), p.occ.begin());
+    std::copy(prior.free.begin(), prior.free.end(), p.free.begin());
+  };
+  const FixedPlanes fixed_prior = fixed;
+  auto resetFixed = [&](FixedPlanes &p)
+  {
+    std::copy(fixed_prior.occ.begin(), fixed_prior.occ.end(), p.occ.begin());
+    std::copy(fixed_prior.free.begin(), fixed_prior.free.end(), p.free.begin());
+  };
+
+  double t_three = timeNs(iterations, [&]()
+                          { reset(three_pass);
+                            dst::threePassUpdate(three_pass.meas_occ.data(), three_pass.meas_free.data(), three_pass.occ.data(),
+                                                 three_pass.free.data(), three_pass.prob.data(), occ_pred.data(), free_pred.data(),
+                                                 n, decay_factor); });
+  double t_scalar = timeNs(iterations, [&]()
+                           { reset(scalar);
+                             dst::fusedUpdateScalar(scalar.meas_occ.data(), scalar.meas_free.data(), scalar.occ.data(),
+                                                    scalar.free.data(), scalar.prob.data(), n, decay_factor); });
+  double t_fused = timeNs(iterations, [&]()
+                          { reset(fused);
+                            dst::fusedUpdate(fused.meas_occ.data(), fused.meas_free.data(), fused.occ.data(),
+                                             fused.free.data(), fused.prob.data(), n, decay_factor); });
+  double t_fixed = timeNs(iterations, [&]()
+                          { resetFixed(fixed);
+                            dst::fusedUpdate(fixed.meas_occ.data(), fixed.meas_free.data(), fixed.occ.data(),
+                                             fixed.free.data(), fixed.prob.data(), n, decay_factor); });
+
+  std::printf("grid: %zux%zu, iterations: %d, backend: %s\n", grid_size, grid_size, iterations, dst::fusedUpdateBackend());
+  std::printf("(each frame includes copying the prior into place)\n");
+  std::printf("three-pass:     %10.1f ns/frame\n", t_three);
+  std::printf("fused (scalar): %10.1f ns/frame (%.2fx)\n", t_scalar, t_three / t_scalar);
+  std::printf("fused:          %10.1f ns/frame (%.2fx)\n", t_fused, t_three / t_fused);
+  std::printf("fused (16-bit): %10.1f ns/frame (%.2fx)\n", t_fixed, t_three / t_fixed);
+  std::printf("max abs difference after one step: %g (16-bit: %g)\n", max_diff, max_fixed_diff);
+
+  return max_diff < 1e-5f && max_fixed_diff < 1e-3f ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  occupancy_bench.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Replays clouds through the ground segmentation and static occupancy
+// pipeline as plain library calls, with no ROS graph, and reports per-stage
+// latency, throughput and peak memory.
+//
+// Usage: occupancy_bench [pcd_directory] [repeats] [max_frame_p99_ms]
+//
+// The directory should hold clouds recorded from /lidar/fused, e.g. with
+// `ros2 run pcl_ros pointcloud_to_pcd --ros-args -r input:=/lidar/fused`.
+// Without one (or with ""), a synthetic scene is used. If max_frame_p99_ms
+// is given, the exit status is 1 when the p99 frame time exceeds it, so the
+// run can gate performance regressions.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+#include "pcl_conversions/pcl_conversions.h"
+
+#include "occupancy_cpp/MrfGroundSegmenter.hpp"
+#include "occupancy_cpp/MultiResolutionGrid.hpp"
+#include "occupancy_cpp/PointCloud2View.hpp"
+#include "occupancy_cpp/RayCaster.hpp"
+#include "nova_trace/StageProfiler.hpp"
+
+using namespace navigator::perception;
+using sensor_msgs::msg::PointCloud2;
+using sensor_msgs::msg::PointField;
+
+namespace
+{
+  // Same configuration as StaticOccupancyNode's defaults.
+  constexpr int GRID_SIZE = 128;
+  constexpr float RES = 1. / 3.;
+  constexpr float MEAS_MASS = 0.95;
+  constexpr float DECAY_FACTOR = 0.9;
+
+  enum Stage
+  {
+    STAGE_SEGMENT,
+    STAGE_FILTER,
+    STAGE_CREATE_GRID,
+    STAGE_MASS_UPDATE,
+    STAGE_FRAME,
+  };
+
+  // A PointCloud2 with FLOAT32 x, y, z and intensity, like /lidar/fused.
+  PointCloud2 makeCloud(const std::vector<std::array<float, 4>> &points)
+  {
+    PointCloud2 msg;
+    msg.height = 1;
+    msg.width = uint32_t(points.size());
+    msg.point_step = 16;
+    msg.row_step = msg.point_step * msg.width;
+    msg.is_dense = true;
+
+    const char *names[] = {"x", "y", "z", "intensity"};
+    for (int i = 0; i < 4; i++)
+    {
+      PointField field;
+      field.name = names[i];
+      field.offset = 4 * i;
+      field.datatype = PointField::FLOAT32;
+      field.count = 1;
+      msg.fields.push_back(field);
+    }
+
+    msg.data.resize(msg.row_step);
+    for (std::size_t i = 0; i < points.size(); i++)
+      std::memcpy(&msg.data[i * msg.point_step], points[i].data(), 16);
+    return msg;
+  }
+
+  std::vector<PointCloud2> loadFrames(const char *directory)
+  {
+    std::vector<PointCloud2> frames;
+
+    if (directory != nullptr)
+    {
+      std::vector<std::filesystem::path> paths;
+      for (const auto &entry : std::filesystem::directory_iterator(directory))
+        if (entry.path().extension() == ".pcd")
+          paths.push_back(entry.path());
+      std::sort(paths.begin(), paths.end());
+
+      for (const auto &path : paths)
+      {
+        pcl::PointCloud<pcl::PointXYZI> cloud;
+        if (pcl::io::loadPCDFile(path.string(), cloud) != 0)
+          continue;
+        PointCloud2 msg;
+        pcl::toROSMsg(cloud, msg);
+        frames.push_back(std::move(msg));
+      }
+      return frames;
+    }
+
+    // Synthetic scene: 64 scan lines over a gently sloped ground, with a
+    // ring of walls and some clutter. The sensor moves forwards by one
+    // meter per frame.
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> noise(-0.03f, 0.03f);
+    std::uniform_real_distribution<float> clutter(0.0f, 1.0f);
+    constexpr int LINES = 64, AZIMUTHS = 2000;
+
+    for (int f = 0; f < 20; f++)
+    {
+      std::vector<std::array<float, 4>> points;
+      points.reserve(LINES * AZIMUTHS);
+      for (int line = 0; line < LINES; line++)
+      {
+        const float elevation = -0.45f + 0.5f * line / LINES;
+        for (int a = 0; a < AZIMUTHS; a++)
+        {
+          const float azimuth = 2.0f * float(M_PI) * a / AZIMUTHS;
+          const float c = std::cos(azimuth), s = std::sin(azimuth);
+
+          // Range where the beam meets the ground 1.8 m below, capped at the
+          // walls or at a random obstacle.
+          float range = elevation < 0.0f ? 1.8f / -std::tan(elevation) : 80.0f;
+          const float wall = 25.0f + 8.0f * std::sin(3.0f * azimuth + 0.1f * f);
+          range = std::min(range, wall);
+          if (clutter(gen) < 0.05f)
+            range = std::min(range, 4.0f + 30.0f * clutter(gen));
+          if (range >= 80.0f)
+            continue;
+
+          const float z = range * std::tan(elevation);
+          points.push_back({range * c, range * s, z + noise(gen), 1.0f});
+        }
+      }
+      frames.push_back(makeCloud(points));
+    }
+    return frames;
+  }
+
+  long peakRssKb()
+  {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // Kilobytes on Linux
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const char *directory = argc > 1 && argv[1][0] != '\0' ? argv[1] : nullptr;
+  const int repeats = argc > 2 ? std::atoi(argv[2]) : 10;
+  const double max_frame_p99_ms = argc > 3 ? std::atof(argv[3]) : 0.0;
+
+  const std::vector<PointCloud2> frames = loadFrames(directory);
+  if (frames.empty())
+  {
+    std::fprintf(stderr, "No .pcd files found in %s\n", directory);
+    return 1;
+  }
+
+  std::size_t points_per_pass = 0;
+  for (const auto &frame : frames)
+    points_per_pass += std::size_t(frame.width) * frame.height;
+
+  MrfGroundSegmenter segmenter;
+  MultiResolutionGrid grid(1, GRID_SIZE, RES);
+  RayCaster caster(GRID_SIZE, 1.0f, 10, MEAS_MASS);
+  navigator::trace::StageProfiler profiler({"ground_segmentation", "filter", "create_grid", "mass_update", "frame"},
+                         "occupancy_bench");
+
+  std::vector<int> obstacle_indices;
+  PointCloud2 filtered;
+  std::vector<RayCaster::Cell> hits;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeats; r++)
+  {
+    for (const PointCloud2 &msg : frames)
+    {
+      navigator::trace::ScopedStageTimer frame_timer(profiler, STAGE_FRAME);
+
+      {
+        navigator::trace::ScopedStageTimer timer(profiler, STAGE_SEGMENT);
+        segmenter.segment(PointCloud2View(msg), obstacle_indices);
+      }
+
+      {
+        navigator::trace::ScopedStageTimer timer(profiler, STAGE_FILTER);
+        selectPoints(msg, obstacle_indices, filtered);
+      }
+
+      {
+        // Same projection as StaticOccupancyNode::add_points_to_the_DST().
+        navigator::trace::ScopedStageTimer timer(profiler, STAGE_CREATE_GRID);
+        PointCloud2View cloud(filtered);
+        DstGrid &level = grid.level(0);
+        const int half = level.half();
+
+        hits.clear();
+        for (std::size_t i = 0; i < cloud.size(); i++)
+        {
+          if (cloud.z(i) * (-1) > 0.5)
+            continue;
+          int x = (int)(cloud.x(i) / RES);
+          int y = (int)(cloud.y(i) / RES);
+          if (x < -half || y < -half || x >= half || y >= half)
+            continue;
+          hits.push_back(RayCaster::Cell{int16_t(x), int16_t(y)});
+        }
+        caster.cast(level, hits);
+      }
+
+      {
+        navigator::trace::ScopedStageTimer timer(profiler, STAGE_MASS_UPDATE);
+        grid.update(DECAY_FACTOR);
+        grid.clearMeasurement();
+      }
+    }
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const std::size_t frame_count = frames.size() * std::size_t(repeats);
+  std::printf("%zu frames (%zu clouds x %d repeats), %.0f points per cloud\n", frame_count, frames.size(), repeats,
+              double(points_per_pass) / frames.size());
+  std::printf("%-20s  %8s  %8s  %8s  %8s\n", "stage", "mean_ms", "p50_ms", "p99_ms", "max_ms");
+  for (int stage = 0; stage < profiler.stage_count(); stage++)
+  {
+    navigator::trace::LatencyHistogram::Snapshot s = profiler.histogram(stage).snapshot();
+    std::printf("%-20s  %8.3f  %8.3f  %8.3f  %8.3f\n", profiler.stage_name(stage).c_str(), s.mean_ms(),
+                s.quantile_ms(0.5), s.quantile_ms(0.99), s.max_ms());
+  }
+  std::printf("throughput: %.1f frames/s, %.2f Mpoints/s\n", frame_count / seconds,
+              points_per_pass * double(repeats) / seconds * 1e-6);
+  std::printf("peak RSS: %.1f MB\n", peakRssKb() / 1024.0);
+
+  const double frame_p99 = profiler.histogram(STAGE_FRAME).snapshot().quantile_ms(0.99);
+  if (max_frame_p99_ms > 0.0 && frame_p99 > max_frame_p99_ms)
+  {
+    std::fprintf(stderr, "p99 frame time %.3f ms exceeds the %.3f ms budget\n", frame_p99, max_frame_p99_ms);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  ray_casting_bench.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Measures how sector-parallel ray casting scales with thread count.
+//
+// Usage: ray_casting_bench [pcd_directory] [max_threads] [repeats]
+//
+// The directory should hold clouds recorded from /lidar/filtered, e.g. with
+// `ros2 run pcl_ros pointcloud_to_pcd --ros-args -r input:=/lidar/filtered`.
+// Without one (or with ""), a synthetic cloud is used. Every thread count is checked
+// against the single-threaded output.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+
+#include "occupancy_cpp/DstGrid.hpp"
+#include "occupancy_cpp/RayCaster.hpp"
+
+using namespace navigator::perception;
+
+namespace
+{
+  constexpr int GRID_SIZE = 128;
+  constexpr float RES = 1. / 3.;
+  constexpr float MEAS_MASS = 0.95;
+
+  // Same projection as StaticOccupancyNode::add_points_to_the_DST().
+  std::vector<RayCaster::Cell> toHits(const pcl::PointCloud<pcl::PointXYZI> &cloud)
+  {
+    const int half = GRID_SIZE / 2;
+    std::vector<RayCaster::Cell> hits;
+
+    for (const auto &p : cloud.points)
+    {
+      int x = (int)(p.x / RES);
+      int y = (int)(p.y / RES);
+      if (p.z < -0.5 || x < -half || y < -half || x >= half || y >= half)
+        continue;
+      hits.push_back(RayCaster::Cell{int16_t(x), int16_t(y)});
+    }
+    return hits;
+  }
+
+  std::vector<std::vector<RayCaster::Cell>> loadFrames(const char *directory)
+  {
+    std::vector<std::vector<RayCaster::Cell>> frames;
+
+    if (directory != nullptr)
+    {
+      std::vector<std::filesystem::path> paths;
+      for (const auto &entry : std::filesystem::directory_iterator(directory))
+        if (entry.path().extension() == ".pcd")
+          paths.push_back(entry.path());
+      std::sort(paths.begin(), paths.end());
+
+      for (const auto &path : paths)
+      {
+        pcl::PointCloud<pcl::PointXYZI> cloud;
+        if (pcl::io::loadPCDFile(path.string(), cloud) == 0)
+          frames.push_back(toHits(cloud));
+      }
+      return frames;
+    }
+
+    // Synthetic scene: a ring of walls with gaps, plus scattered clutter.
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> angle(0.0f, 2.0f * M_PI);
+    std::uniform_real_distribution<float> range(3.0f, 30.0f);
+    for (int f = 0; f < 20; f++)
+    {
+      pcl::PointCloud<pcl::PointXYZI> cloud;
+      for (int i = 0; i < 20000; i++)
+      {
+        float a = angle(gen);
+        float r = (i % 3 == 0) ? range(gen) : 15.0f + 5.0f * std::sin(3 * a);
+        if (std::fmod(a, 0.8f) < 0.1f)
+          continue;
+        cloud.push_back(pcl::PointXYZI(r * std::cos(a), r * std::sin(a), 0.0f, 0.0f));
+      }
+      frames.push_back(toHits(cloud));
+    }
+    return frames;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const char *directory = argc > 1 && argv[1][0] != '\0' ? argv[1] : nullptr;
+  const int max_threads = argc > 2 ? std::atoi(argv[2]) : 8;
+  const int repeats = argc > 3 ? std::atoi(argv[3]) : 20;
+
+  auto frames = loadFrames(directory);
+  if (frames.empty())
+  {
+    std::fprintf(stderr, "No .pcd files found in %s\n", directory);
+    return 1;
+  }
+
+  DstGrid grid(GRID_SIZE, RES);
+  RayCaster caster(GRID_SIZE, 1.0f, 10, MEAS_MASS);
+
+  // Reference output for every frame, single-threaded.
+  std::vector<std::vector<Mass>> reference;
+  for (const auto &hits : frames)
+  {
+    grid.clearMeasurement();
+    caster.cast(grid, hits);
+    std::vector<Mass> planes(grid.measOcc(), grid.measOcc() + grid.cells());
+    planes.insert(planes.end(), grid.measFree(), grid.measFree() + grid.cells());
+    reference.push_back(std::move(planes));
+  }
+
+  std::printf("%zu frames, %d repeats\n", frames.size(), repeats);
+  std::printf("threads  ms/frame  speedup  identical\n");
+
+  double single = 0.0;
+  for (int threads = 1; threads <= max_threads; threads++)
+  {
+    navigator::worker_pool::WorkerPool pool(threads);
+    bool identical = true;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+    {
+      for (std::size_t f = 0; f < frames.size(); f++)
+      {
+        grid.clearMeasurement();
+        caster.cast(grid, frames[f], &pool);
+
+        if (r == 0)
+        {
+          const auto &ref = reference[f];
+          identical &= std::equal(grid.measOcc(), grid.measOcc() + grid.cells(), ref.begin()) &&
+                       std::equal(grid.measFree(), grid.measFree() + grid.cells(), ref.begin() + grid.cells());
+        }
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count() / (repeats * frames.size());
+    if (threads == 1)
+      single = ms;
+    std::printf("%7d  %8.3f  %6.2fx  %s\n", threads, ms, single / ms, identical ? "yes" : "NO");
+    if (!identical)
+      return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  AllocationCounter.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief Number of heap allocations (global operator new calls) made by
+     * the calling thread so far, or 0 if nothing in the process counts them.
+     *
+     * The counting is done by resource_monitor's
+     * libresource_monitor_allocations.so, loaded with LD_PRELOAD, which
+     * replaces the global operator new with a thin wrapper around malloc that
+     * bumps a thread-local counter, so the cost is a single increment. Take
+     * the difference across a block of code to check that it does not
+     * allocate.
+     */
+    std::size_t threadAllocationCount();
+
+    /**
+     * @brief Counts the allocations made on this thread while in scope.
+     */
+    class AllocationScope
+    {
+    public:
+      AllocationScope() : start_(threadAllocationCount()) {}
+
+      std::size_t count() const { return threadAllocationCount() - start_; }
+
+    private:
+      std::size_t start_;
+    };
+  }
+}
@@ -0,0 +1,94 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  CellIndex.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief Point indices bucketed by grid cell, in one flat array.
+     *
+     * build() is a counting sort: one pass finds each point's cell and counts
+     * points per cell, a prefix sum turns the counts into offsets, and a
+     * second pass scatters the point indices into place. Within a cell,
+     * indices stay in ascending order. The buffers are reused by later
+     * builds, so a steady stream of clouds does not allocate.
+     */
+    class CellIndex
+    {
+    public:
+      /**
+       * @param cells Number of cells
+       * @param points Number of points
+       * @param cell_of Returns the cell of point i, or -1 to leave it out
+       */
+      template <typename F>
+      void build(std::size_t cells, std::size_t points, F &&cell_of)
+      {
+        offsets_.assign(cells + 1, 0);
+        point_cells_.resize(points);
+
+        for (std::size_t i = 0; i < points; i++)
+        {
+          int32_t cell = cell_of(i);
+          point_cells_[i] = cell;
+          if (cell >= 0)
+            offsets_[cell + 1]++;
+        }
+
+        for (std::size_t c = 0; c < cells; c++)
+          offsets_[c + 1] += offsets_[c];
+
+        // Fill each cell from the back, walking the points in reverse so they
+        // end up ascending. This leaves offsets_[c + 1] at the start of cell c.
+        indices_.resize(offsets_[cells]);
+        for (std::size_t i = points; i-- > 0;)
+        {
+          if (point_cells_[i] >= 0)
+            indices_[--offsets_[point_cells_[i] + 1]] = int(i);
+        }
+        for (std::size_t c = 0; c < cells; c++)
+          offsets_[c] = offsets_[c + 1];
+        offsets_[cells] = uint32_t(indices_.size());
+      }
+
+      std::size_t cells() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+
+      /**
+       * @brief Indices of the points in a cell.
+       */
+      std::span<const int> operator[](std::size_t cell) const
+      {
+        return std::span<const int>(indices_.data() + offsets_[cell], offsets_[cell + 1] - offsets_[cell]);
+      }
+
+      bool empty(std::size_t cell) const { return offsets_[cell] == offsets_[cell + 1]; }
+
+      /**
+       * @brief Cell of a point in the last build, or -1 if it was left out.
+       */
+      int32_t cellOf(std::size_t point) const { return point_cells_[point]; }
+      std::size_t points() const { return point_cells_.size(); }
+
+    private:
+      // Cell c owns indices_[offsets_[c]] up to indices_[offsets_[c + 1]].
+      std::vector<uint32_t> offsets_;
+      std::vector<int> indices_;
+      // Scratch: the cell of every point of the last build.
+      std::vector<int32_t> point_cells_;
+    };
+  }
+}
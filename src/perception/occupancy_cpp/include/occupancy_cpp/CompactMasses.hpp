@@ -0,0 +1,132 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  CompactMasses.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "nova_msgs/msg/compact_masses.hpp"
+#include "nova_msgs/msg/masses.hpp"
+
+#include "occupancy_cpp/DstGrid.hpp"
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief Quantize a mass in [0, 1] to the 8-bit fixed point used by
+     * CompactMasses.
+     */
+    inline uint8_t quantizeMass(float mass)
+    {
+      float scaled = mass * 255.0f + 0.5f;
+      return scaled <= 0.0f ? 0 : scaled >= 255.0f ? 255 : uint8_t(scaled);
+    }
+
+    inline float dequantizeMass(uint8_t value) { return value * (1.0f / 255.0f); }
+
+    /**
+     * @brief Turns successive DST grids into a stream of CompactMasses
+     * messages: a keyframe with every tile every `keyframe_interval`
+     * messages, and only the changed tiles in between.
+     *
+     * A tile counts as changed when any of its quantized cells differs from
+     * what was last sent, so sub-quantum noise never costs bandwidth.
+     */
+    class CompactMassesEncoder
+    {
+    public:
+      CompactMassesEncoder(int tile_size, int keyframe_interval);
+
+      /**
+       * @brief Fill everything but the header of `msg` from `grid`. The
+       * message's buffers are reused between calls.
+       */
+      void encode(const DstGrid &grid, nova_msgs::msg::CompactMasses &msg);
+
+      /**
+       * @brief Make the next message a keyframe, e.g. for a late subscriber.
+       */
+      void forceKeyframe() { since_keyframe_ = -1; }
+
+    private:
+      int tile_size_;
+      int keyframe_interval_;
+      int since_keyframe_ = -1; // Messages since the last keyframe; -1 forces one
+      uint32_t sequence_ = 0;
+      int size_ = 0;
+
+      // Quantized masses of this frame and of the last message, x-major.
+      std::vector<uint8_t> occ_, free_;
+      std::vector<uint8_t> sent_occ_, sent_free_;
+    };
+
+    /**
+     * @brief Rebuilds the full grid from a CompactMasses stream. Meant for
+     * consumers of /grid/masses/compact.
+     */
+    class CompactMassesDecoder
+    {
+    public:
+      /**
+       * @brief Apply a keyframe or delta.
+       *
+       * @return Whether the grid is complete and current afterwards. Deltas
+       * that arrive before the first keyframe or after a lost message are
+       * ignored until the next keyframe.
+       */
+      bool apply(const nova_msgs::msg::CompactMasses &msg);
+
+      bool valid() const { return valid_; }
+      int width() const { return width_; }
+      int height() const { return height_; }
+
+      // Cell (r, c) lives at r * width() + c.
+      const std::vector<uint8_t> &occ() const { return occ_; }
+      const std::vector<uint8_t> &free() const { return free_; }
+
+      float occ(int r, int c) const { return dequantizeMass(occ_[std::size_t(r) * width_ + c]); }
+      float free(int r, int c) const { return dequantizeMass(free_[std::size_t(r) * width_ + c]); }
+
+      /**
+       * @brief Expand the current grid into a float Masses message.
+       */
+      void toMasses(nova_msgs::msg::Masses &out) const;
+
+    private:
+      bool valid_ = false;
+      uint32_t last_sequence_ = 0;
+      int width_ = 0;
+      int height_ = 0;
+      std::vector<uint8_t> occ_, free_;
+    };
+
+    /**
+     * @brief Call `f(r_begin, r_end, c_begin, c_end)` with the bounds of tile
+     * `tile` of a `width` by `height` grid split into tiles of `tile_size`.
+     * Returns false if there is no such tile.
+     */
+    template <typename F>
+    bool withTileBounds(int width, int height, int tile_size, uint32_t tile, F &&f)
+    {
+      const int tiles_per_row = (width + tile_size - 1) / tile_size;
+      const int tile_rows = (height + tile_size - 1) / tile_size;
+      if (tile >= uint32_t(tiles_per_row) * uint32_t(tile_rows))
+        return false;
+
+      const int r_begin = int(tile / tiles_per_row) * tile_size;
+      const int c_begin = int(tile % tiles_per_row) * tile_size;
+      f(r_begin, std::min(r_begin + tile_size, height), c_begin, std::min(c_begin + tile_size, width));
+      return true;
+    }
+  }
+}
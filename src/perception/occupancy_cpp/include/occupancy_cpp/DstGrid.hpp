@@ -0,0 +1,184 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  DstGrid.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include "occupancy_cpp/DstKernel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <type_traits>
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief Storage type of the masses and probabilities in a DstGrid:
+     * 16-bit fixed point (see dst::FIXED_ONE) when occupancy_cpp is built
+     * with OCCUPANCY_FIXED_POINT_MASSES, float otherwise. Read cells with
+     * dst::massValue() and write them with dst::toMass<Mass>().
+     */
+#ifdef OCCUPANCY_FIXED_POINT_MASSES
+    using Mass = uint16_t;
+#else
+    using Mass = float;
+#endif
+
+    /**
+     * @brief Square DST grid with runtime dimensions.
+     *
+     * All planes live in a single heap allocation, one plane after another
+     * (structure of arrays). Each plane starts on a cache line boundary so the
+     * vector kernels can stream through it. Cells are stored as [x][y], i.e.
+     * index = x * size + y, with the ego vehicle at (center, center).
+     *
+     * The planes are toroidal: scroll() moves the grid with the vehicle by
+     * changing an origin offset rather than copying cells, so index() wraps
+     * around the plane edges. All planes share the same offset, which keeps
+     * cell-wise kernels such as update() oblivious to it.
+     */
+    class DstGrid
+    {
+    public:
+      // Alignment of every plane, in bytes.
+      constexpr static std::size_t ALIGNMENT = 64;
+
+      /**
+       * @param size Cells per side. Must be even and at least 2.
+       * @param resolution Cell size, in meters
+       */
+      DstGrid(int size, float resolution);
+
+      DstGrid(const DstGrid &) = delete;
+      DstGrid &operator=(const DstGrid &) = delete;
+      DstGrid(DstGrid &&) = default;
+      DstGrid &operator=(DstGrid &&) = default;
+
+      int size() const { return size_; }
+      int half() const { return size_ / 2; }
+      int center() const { return size_ / 2; }
+      float resolution() const { return resolution_; }
+      std::size_t cells() const { return cells_; }
+
+      // Storage row and column of cell (0, 0), as used by index().
+      int offsetX() const { return offset_x_; }
+      int offsetY() const { return offset_y_; }
+
+      /**
+       * @brief Bumped whenever scroll() or reset() changes the masses, so
+       * that copies of them can tell when they are stale.
+       * Writes through the plane accessors and update() do not count.
+       */
+      uint64_t revision() const { return revision_; }
+
+      std::size_t index(int x, int y) const
+      {
+        return std::size_t(wrap(x + offset_x_)) * size_ + wrap(y + offset_y_);
+      }
+
+      // Planes, each `cells()` long.
+      Mass *measOcc() { return plane(0); }
+      Mass *measFree() { return plane(1); }
+      Mass *occ() { return plane(2); }
+      Mass *free() { return plane(3); }
+      Mass *prob() { return plane(4); }
+      const Mass *measOcc() const { return plane(0); }
+      const Mass *measFree() const { return plane(1); }
+      const Mass *occ() const { return plane(2); }
+      const Mass *free() const { return plane(3); }
+      const Mass *prob() const { return plane(4); }
+
+      // Cell accessors by grid index.
+      Mass &measOcc(int x, int y) { return measOcc()[index(x, y)]; }
+      Mass &measFree(int x, int y) { return measFree()[index(x, y)]; }
+      Mass &occ(int x, int y) { return occ()[index(x, y)]; }
+      Mass &free(int x, int y) { return free()[index(x, y)]; }
+      Mass &prob(int x, int y) { return prob()[index(x, y)]; }
+
+      /**
+       * @brief Reset the measurement planes.
+       */
+      void clearMeasurement();
+
+      /**
+       * @brief Reset every plane, including the accumulated masses.
+       */
+      void reset();
+
+      /**
+       * @brief Run dst::fusedUpdate() over the whole grid.
+       */
+      void update(float decay_factor);
+
+      /**
+       * @brief Move the grid by whole cells, e.g. to follow the vehicle.
+       *
+       * After the call, cell (x, y) holds what was stored at (x + dx, y + dy).
+       * Only the rows and columns that scroll into view are cleared. The
+       * measurement planes move too, so scroll before casting a frame's
+       * measurement, not between casting and update().
+       */
+      void scroll(int dx, int dy);
+
+    private:
+      constexpr static int PLANE_COUNT = 5;
+
+      struct FreeDeleter
+      {
+        void operator()(Mass *p) const { std::free(p); }
+      };
+
+      // Wrap a value in [0, 2 * size) back into [0, size).
+      int wrap(int v) const { return v >= size_ ? v - size_ : v; }
+
+      // Clear every plane over a block of cells given in wrapped (storage)
+      // rows and columns.
+      void clearStorageBlock(int row_begin, int row_end, int col_begin, int col_end);
+
+      Mass *plane(int i) { return data_.get() + i * stride_; }
+      const Mass *plane(int i) const { return data_.get() + i * stride_; }
+
+      int size_;
+      float resolution_;
+      std::size_t cells_;
+      std::size_t stride_; // Cells between the starts of two planes
+      int offset_x_ = 0;   // Storage row of logical x = 0, in [0, size)
+      int offset_y_ = 0;   // Storage column of logical y = 0, in [0, size)
+      uint64_t revision_ = 0;
+      std::unique_ptr<Mass[], FreeDeleter> data_;
+    };
+
+    /**
+     * @brief Call `f` with the grid size as a compile-time constant
+     * (std::integral_constant<int, N>) for the common power-of-two sizes, or
+     * as a plain int otherwise. Loops written against the argument then get
+     * compile-time bounds on the fast path.
+     */
+    template <typename F>
+    decltype(auto) dispatchGridSize(int size, F &&f)
+    {
+      switch (size)
+      {
+      case 64:
+        return f(std::integral_constant<int, 64>{});
+      case 128:
+        return f(std::integral_constant<int, 128>{});
+      case 256:
+        return f(std::integral_constant<int, 256>{});
+      case 512:
+        return f(std::integral_constant<int, 512>{});
+      default:
+        return f(size);
+      }
+    }
+  }
+}
@@ -0,0 +1,106 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  DstKernel.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace navigator
+{
+  namespace perception
+  {
+    namespace dst
+    {
+      /**
+       * @brief Fixed-point masses: 0 to 65535 for 0 to 1. The probabilities
+       * only need about three digits, and half the bytes of a float halves
+       * the planes the update streams through every frame.
+       */
+      constexpr float FIXED_ONE = 65535.0f;
+
+      inline float massValue(float m) { return m; }
+      inline float massValue(uint16_t m) { return m * (1.0f / FIXED_ONE); }
+
+      /**
+       * @brief Store a value in [0, 1] as a mass of type T. Fixed-point masses
+       * round to nearest and saturate, so rounding error can't wrap a mass
+       * around.
+       */
+      template <typename T>
+      T toMass(float v);
+
+      template <>
+      inline float toMass<float>(float v) { return v; }
+
+      template <>
+      inline uint16_t toMass<uint16_t>(float v)
+      {
+        return uint16_t(std::min(std::max(v * FIXED_ONE + 0.5f, 0.0f), FIXED_ONE));
+      }
+
+      /**
+       * @brief Fused DST prediction + combination + probability kernel.
+       *
+       * Each plane holds `n` contiguous cells. `occ` and `free` hold the
+       * previous posterior on entry and the updated posterior on exit, so no
+       * separate "previous" or "predicted" planes are needed. `prob` receives
+       * the pignistic occupancy probability of every cell.
+       *
+       * Uses AVX2 (selected at runtime) or NEON when available and falls
+       * back to a scalar loop otherwise.
+       */
+      void fusedUpdate(const float *meas_occ, const float *meas_free,
+                       float *occ, float *free, float *prob,
+                       std::size_t n, float decay_factor);
+
+      /**
+       * @brief Scalar-only version of fusedUpdate(). Useful as a reference
+       * and on targets without a vector unit.
+       */
+      void fusedUpdateScalar(const float *meas_occ, const float *meas_free,
+                             float *occ, float *free, float *prob,
+                             std::size_t n, float decay_factor);
+
+      /**
+       * @brief fusedUpdate() on fixed-point masses (see FIXED_ONE). The decay
+       * is done in saturating 16-bit integer arithmetic, 16 cells (AVX2) or 8
+       * (NEON) to a vector. The combination divides by its normalization, for
+       * which there is no integer vector instruction, so it widens to float
+       * and saturates back on the way out. It matches fusedUpdateScalar()
+       * bit for bit as long as DstKernel.cpp is built without FMA
+       * contraction, as CMakeLists.txt builds it.
+       */
+      void fusedUpdate(const uint16_t *meas_occ, const uint16_t *meas_free,
+                       uint16_t *occ, uint16_t *free, uint16_t *prob,
+                       std::size_t n, float decay_factor);
+
+      void fusedUpdateScalar(const uint16_t *meas_occ, const uint16_t *meas_free,
+                             uint16_t *occ, uint16_t *free, uint16_t *prob,
+                             std::size_t n, float decay_factor);
+
+      /**
+       * @brief The original three-pass update (prediction, combination,
+       * probabilities), kept for benchmarking and validation.
+       *
+       * @param occ_pred, free_pred Scratch planes of `n` cells
+       */
+      void threePassUpdate(const float *meas_occ, const float *meas_free,
+                           float *occ, float *free, float *prob,
+                           float *occ_pred, float *free_pred,
+                           std::size_t n, float decay_factor);
+
+      /**
+       * @brief Name of the vector path picked by fusedUpdate() on this machine.
+       */
+      const char *fusedUpdateBackend();
+    }
+  }
+}
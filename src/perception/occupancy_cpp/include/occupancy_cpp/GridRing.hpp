@@ -0,0 +1,95 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  GridRing.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief Call `f(dx, dy)` for every cell on the perimeter of the square
+     * ring at Chebyshev distance `i` from the center, without allocating.
+     *
+     * Cells come in the order the MRF ground segmentation has always used:
+     * the dx = -i side then the dx = i side, walking k from -i to i. Each
+     * (±i, k) cell is paired with its mirror (k, ±i), and the pair is visited
+     * in (dx, dy) order. Every perimeter cell is visited exactly once; ring 0
+     * is just the center.
+     */
+    inline int ringCellCount(int i) { return i == 0 ? 1 : 8 * i; }
+
+    /**
+     * @brief The `p`th cell of ring `i` in forEachRingCell() order, for
+     * 0 <= p < ringCellCount(i). Lets a ring be split into index ranges.
+     */
+    inline void ringCell(int i, int p, int &dx, int &dy)
+    {
+      if (i == 0)
+      {
+        dx = dy = 0;
+        return;
+      }
+
+      // Each side has 4i cells: its two corners, and 2i - 1 mirrored pairs.
+      const int side = p < 4 * i ? -i : i;
+      const int q = p % (4 * i);
+      if (q == 0 || q == 4 * i - 1)
+      {
+        dx = side;
+        dy = q == 0 ? -i : i;
+        return;
+      }
+
+      const int k = -i + 1 + (q - 1) / 2;
+      const bool second = (q - 1) % 2 == 1;
+      // Within a pair, (side, k) comes first exactly when side < k.
+      if ((side < k) != second)
+      {
+        dx = side;
+        dy = k;
+      }
+      else
+      {
+        dx = k;
+        dy = side;
+      }
+    }
+
+    template <typename F>
+    void forEachRingCell(int i, F &&f)
+    {
+      if (i == 0)
+      {
+        f(0, 0);
+        return;
+      }
+
+      for (int side : {-i, i})
+      {
+        for (int k = -i; k <= i; k++)
+        {
+          // The corners belong to the rows; only inner cells have a mirror.
+          if (k == -i || k == i)
+            f(side, k);
+          else if (side < k)
+          {
+            f(side, k);
+            f(k, side);
+          }
+          else
+          {
+            f(k, side);
+            f(side, k);
+          }
+        }
+      }
+    }
+  }
+}
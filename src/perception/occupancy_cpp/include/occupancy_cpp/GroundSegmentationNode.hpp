@@ -11,6 +11,9 @@
 
 
 // Message definitions
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "nova_msgs/msg/ground_map.hpp"
+#include "nova_msgs/msg/point_indices.hpp"
 #include "rosgraph_msgs/msg/clock.hpp"
 #include "sensor_msgs/msg/point_cloud2.hpp"
 
@@ -28,9 +31,21 @@
 #include <pcl/filters/passthrough.h>
 
 #include "rclcpp/rclcpp.hpp"
+#include "tf2_ros/buffer.h"
+#include "tf2_ros/transform_listener.h"
+
+#include "cloud_transport/Publisher.hpp"
+#include "latency_tracker/StageRecorder.hpp"
+
+#include "occupancy_cpp/MrfGroundSegmenter.hpp"
+#include "occupancy_cpp/PointCloud2View.hpp"
+#include "occupancy_cpp/VoxelDownsampler.hpp"
 
 using namespace std::chrono_literals;
 
+using diagnostic_msgs::msg::DiagnosticArray;
+using nova_msgs::msg::GroundMap;
+using nova_msgs::msg::PointIndices;
 using rosgraph_msgs::msg::Clock;
 using sensor_msgs::msg::PointCloud2;
 
@@ -42,28 +57,84 @@ namespace navigator
     class GroundSegmentationNode : public rclcpp::Node
     {
     public:
-      GroundSegmentationNode();
+      explicit GroundSegmentationNode(const rclcpp::NodeOptions &options = rclcpp::NodeOptions());
       virtual ~GroundSegmentationNode();
 
     private:
 
+      // What each cloud is turned into; see ground_output_mode in the constructor.
+      enum OutputMode
+      {
+        OUTPUT_FILTERED,
+        OUTPUT_INDICES,
+        OUTPUT_LABELED,
+      };
+      OutputMode output_mode;
+
       // Publishers
-      rclcpp::Publisher<PointCloud2>::SharedPtr filtered_lidar_pub;
+      std::unique_ptr<cloud_transport::Publisher> filtered_lidar_pub;
+      rclcpp::Publisher<PointIndices>::SharedPtr obstacle_indices_pub;
+      std::unique_ptr<cloud_transport::Publisher> labeled_lidar_pub;
+      rclcpp::Publisher<DiagnosticArray>::SharedPtr diagnostics_pub;
+      rclcpp::Publisher<GroundMap>::SharedPtr ground_map_pub;
+
+      // Reports each cloud's processing to the latency tracker
+      std::unique_ptr<latency_tracker::StageRecorder> latency_recorder;
 
       // Subscribers
       rclcpp::Subscription<Clock>::SharedPtr clock_sub;
       rclcpp::Subscription<PointCloud2>::SharedPtr raw_lidar_sub;
 
       // Callbacks
-      void pointCloudCb(PointCloud2::SharedPtr msg);
+      void pointCloudCb(PointCloud2::ConstSharedPtr msg);
+      rcl_interfaces::msg::SetParametersResult onSetParameters(const std::vector<rclcpp::Parameter> &parameters);
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr parameter_callback;
+
+      void publishDiagnostics();
 
       // Timers
+      rclcpp::TimerBase::SharedPtr diagnostics_timer;
       // rclcpp::TimerBase::SharedPtr map_marker_timer;
 
       Clock clock;
 
-      pcl::PointCloud<pcl::PointXYZI> removeGround(pcl::PointCloud<pcl::PointXYZI> raw_cloud);
-      
+      // Indices of the non-ground points of the current cloud.
+      std::vector<int> obstacle_indices;
+
+      // Per-point labels of the current cloud, OUTPUT_LABELED only.
+      std::vector<uint8_t> labels;
+
+      // Optional voxel downsampling ahead of the segmentation (null when
+      // voxel_leaf_size is 0): the indices of the kept points, and the
+      // downsampled cloud, reused between clouds.
+      std::unique_ptr<VoxelDownsampler> downsampler;
+      std::vector<uint32_t> kept_indices;
+      PointCloud2 downsampled_msg;
+
+      // The segmenter's ground heights and cells, published on /grid/ground
+      // if publish_ground_map is set. Kept between clouds so its arrays are
+      // only allocated once.
+      void publishGroundMap(const std_msgs::msg::Header &header);
+      GroundMap ground_map_msg;
+
+      // Points in and out of the downsampling since the last diagnostics.
+      std::size_t clouds_seen = 0;
+      std::size_t points_in = 0;
+      std::size_t points_out = 0;
+
+      // Segments the clouds; see MrfGroundSegmenter.
+      std::unique_ptr<MrfGroundSegmenter> segmenter;
+
+      // Vehicle motion for the segmenter's warm start, from the
+      // map->base_link transform.
+      bool vehicleMotion(MrfGroundSegmenter::Motion &motion);
+      std::unique_ptr<tf2_ros::Buffer> tf_buffer;
+      std::shared_ptr<tf2_ros::TransformListener> tf_listener{nullptr};
+      std::string map_frame;
+      bool has_previous_pose = false;
+      double prev_vehicle_x;
+      double prev_vehicle_y;
+      double prev_vehicle_yaw;
     };
 
   }
@@ -0,0 +1,201 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  MrfGroundSegmenter.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "occupancy_cpp/CellIndex.hpp"
+#include "occupancy_cpp/PointCloud2View.hpp"
+#include "worker_pool/WorkerPool.hpp"
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief Markov Random Field ground segmentation.
+     * https://ieeexplore.ieee.org/document/9410344
+     *
+     * Points are binned into a square grid around the sensor. The ground
+     * height estimate hG is then propagated outwards ring by ring, starting
+     * at the sensor: a cell is ground if its points are flat enough and not
+     * too far above the highest ground among its neighbours on the inner
+     * ring.
+     *
+     * Each ring only reads the ring inside it, so the cells of one ring are
+     * independent. With more than one thread, large rings are split into
+     * contiguous ranges that are segmented in parallel, and the obstacles
+     * found in each range are appended in range order. The output is exactly
+     * the serial output.
+     *
+     * Optionally, the ground found in one scan seeds the next. Given the
+     * sensor's motion between the scans, each cell looks up the previous
+     * estimate at the same place on the ground, and where that was ground it
+     * is used as the cell's reference height instead of the inner-ring
+     * neighbours. A full recompute every few scans keeps errors from
+     * accumulating.
+     */
+    class MrfGroundSegmenter
+    {
+    public:
+      struct Settings
+      {
+        float lidar_height = 0.0;
+        float range = 80.0;
+        float s = 0.55;         // Max height step between neighbouring ground cells, in meters
+        float res = 0.4;        // Grid cell size, in meters
+        float max_height = 2.5; // Exclude points above this height, in meters
+
+        // Warm-start each scan from the previous one; see segment(). Every
+        // full_recompute_interval-th scan ignores the previous estimate.
+        bool warm_start = false;
+        int full_recompute_interval = 10;
+      };
+
+      /**
+       * @brief Motion of the sensor since the previous scan: the pose of the
+       * current sensor frame in the previous one, on the ground plane.
+       */
+      struct Motion
+      {
+        float dx = 0.0f; // Meters
+        float dy = 0.0f; // Meters
+        float dyaw = 0.0f; // Radians, counter-clockwise
+      };
+
+      /**
+       * @param threads Threads to segment with, including the caller
+       * @throws std::invalid_argument if the settings are invalid
+       */
+      explicit MrfGroundSegmenter(const Settings &settings, int threads = 1);
+      MrfGroundSegmenter() : MrfGroundSegmenter(Settings()) {}
+
+      const Settings &settings() const { return settings_; }
+
+      /**
+       * @brief Change the settings. The grid buffers and ring tables are
+       * rebuilt only if the range or resolution changed.
+       *
+       * @throws std::invalid_argument if the settings are invalid, in which
+       * case the current ones are kept
+       */
+      void setSettings(const Settings &settings);
+
+      // Cells per side of the grid, and the index of its center row/column.
+      int gridSize() const { return grid_size_; }
+      int gridCenter() const { return center_; }
+
+      /**
+       * @brief Segment a cloud.
+       *
+       * @param obstacle_indices Filled with the indices of the non-ground
+       * points, ring by ring from the center
+       */
+      void segment(const PointCloud2View &cloud, std::vector<int> &obstacle_indices);
+
+      /**
+       * @brief Segment a cloud, warm-starting from the previous scan if
+       * Settings::warm_start is set. Without a motion estimate, use the
+       * overload above, which always does a full recompute.
+       */
+      void segment(const PointCloud2View &cloud, std::vector<int> &obstacle_indices, const Motion &motion);
+
+      enum Label : uint8_t
+      {
+        DROPPED = 0, // Out of range or too high; in neither output
+        GROUND = 1,
+        OBSTACLE = 2,
+      };
+
+      /**
+       * @brief Label every point of the last segmented cloud. Points are
+       * OBSTACLE exactly when segment() listed them.
+       */
+      void labelPoints(std::vector<uint8_t> &labels) const;
+
+      /**
+       * @brief The ground of the last segmented cloud, cell by cell, with
+       * cell = x * gridSize() + y and the sensor at gridCenter().
+       *
+       * @param heights The ground height estimate hG, in the cloud's frame.
+       * Cells that are not ground carry the height of the ground around them.
+       * @param cells GROUND or OBSTACLE for cells with points, DROPPED for
+       * the rest
+       *
+       * Both are resized to the grid, so buffers kept between scans are only
+       * allocated once, and left empty before the first scan.
+       */
+      void groundMap(std::vector<float> &heights, std::vector<uint8_t> &cells) const;
+
+    private:
+      std::size_t cell(int x, int y) const { return std::size_t(x) * grid_size_ + y; }
+
+      // Rebuild everything that depends on the grid layout.
+      void buildTables();
+
+      // Bin the cloud into the grid in one linear pass.
+      void binPoints(const PointCloud2View &cloud);
+
+      // Fill prior_hG_ from the previous scan, moved by `motion`.
+      void warpPrevious(const Motion &motion);
+
+      void segmentImpl(const PointCloud2View &cloud, std::vector<int> &obstacle_indices, const Motion *motion);
+
+      // Segment cells [begin, end) of ring i, in forEachRingCell() order.
+      void segmentRing(int i, int begin, int end, std::vector<int> &obstacle_indices);
+
+      Settings settings_;
+      int grid_size_ = 0;
+      int center_ = 0;
+
+      // Ring tables. Ring i owns entries [ring_offsets_[i], ring_offsets_[i + 1])
+      // of ring_cells_, in forEachRingCell() order. Every ring cell has three
+      // inner-ring neighbours in inner_neighbours_, repeated where it has
+      // fewer, so the max over them needs no branches.
+      std::vector<uint32_t> ring_offsets_;
+      std::vector<uint32_t> ring_cells_;
+      std::vector<std::array<uint32_t, 3>> inner_neighbours_;
+
+      // Per-scan state, kept between scans so the buffers are only allocated
+      // once: the point indices in each grid cell; each cell's point count
+      // and z extent (structure of arrays, so the ring propagation only
+      // touches dense floats); and the ground height estimate hG and the
+      // segmentation (1 = ground) of each cell. All are flat, with
+      // cell = x * grid_size + y.
+      CellIndex grid_;
+      std::vector<float> cell_min_z_;
+      std::vector<float> cell_max_z_;
+      std::vector<uint32_t> cell_count_;
+      std::vector<float> hG_;
+      std::vector<int> gridSeg_;
+
+      // Warm start: the previous scan's hG and segmentation (swapped out of
+      // hG_ and gridSeg_ at the start of a scan), and this scan's reference
+      // height from them (NaN where the previous scan had no ground).
+      // has_previous_ says whether hG_ and gridSeg_ hold a finished scan in
+      // the current layout, and use_prior_ whether prior_hG_ is valid for
+      // this scan.
+      std::vector<float> prev_hG_;
+      std::vector<int> prev_seg_;
+      std::vector<float> prior_hG_;
+      bool has_previous_ = false;
+      bool use_prior_ = false;
+      int scans_since_full_ = 0;
+
+      // Parallel mode: the pool, and the obstacles found in each range of the
+      // current ring.
+      std::unique_ptr<worker_pool::WorkerPool> pool_;
+      std::vector<std::vector<int>> range_obstacles_;
+    };
+  }
+}
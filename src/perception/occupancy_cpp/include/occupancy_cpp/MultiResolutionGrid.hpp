@@ -0,0 +1,113 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  MultiResolutionGrid.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "occupancy_cpp/DstGrid.hpp"
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief A pyramid of DST grids centered on the ego vehicle, each level
+     * twice as coarse as the one before it.
+     *
+     * Every level has the same number of cells, so level k covers 2^k times
+     * the range of level 0 at 2^k times its cell size. With four 64-cell
+     * levels at 0.33 m, the grid reaches 85 m in every direction for the
+     * memory of a single 128-cell grid. One level is just a DstGrid.
+     *
+     * Every level is filled and updated with the same DST rules. After each
+     * update, the part of a level that a finer level also covers is replaced
+     * by the average of the finer cells (the quadtree parent of four
+     * children), so evidence is the same at every level wherever they
+     * overlap. Averaging keeps the masses valid, and since the probability is
+     * linear in the masses, the parent's probability is the children's mean.
+     *
+     * The levels are scrolled together: level k moves by whole level-k cells
+     * whenever the vehicle has crossed one, so the cell boundaries of a level
+     * always line up with those of the finer levels.
+     */
+    class MultiResolutionGrid
+    {
+    public:
+      /**
+       * @param levels Number of levels, at least 1
+       * @param level_size Cells per side of every level. Must be a multiple
+       * of 4 when there is more than one level.
+       * @param resolution Cell size of the finest level, in meters
+       */
+      MultiResolutionGrid(int levels, int level_size, float resolution);
+
+      int levelCount() const { return int(levels_.size()); }
+      DstGrid &level(int k) { return levels_[k]; }
+      const DstGrid &level(int k) const { return levels_[k]; }
+
+      // The finest level.
+      DstGrid &finest() { return levels_.front(); }
+      const DstGrid &finest() const { return levels_.front(); }
+
+      /**
+       * @brief Distance from the ego vehicle to the edge of the coarsest
+       * level, in meters.
+       */
+      float range() const;
+
+      /**
+       * @brief Reset the measurement planes of every level.
+       */
+      void clearMeasurement();
+
+      /**
+       * @brief Update every level, then refresh each level from the finer one
+       * where they overlap.
+       */
+      void update(float decay_factor);
+
+      /**
+       * @brief Follow the vehicle by (dx, dy) meters in the grid frame.
+       * Motion smaller than a cell is carried over to the next call.
+       */
+      void scroll(double dx, double dy);
+
+      /**
+       * @brief Masses and probability at a point, from the finest level that
+       * contains it. Points out of range read as unknown.
+       *
+       * @param x Meters from the ego vehicle
+       * @param y Meters from the ego vehicle
+       */
+      struct Sample
+      {
+        float occ;
+        float free;
+        float prob;
+      };
+      Sample sample(float x, float y) const;
+
+    private:
+      // Replace the cells of level k that level k - 1 covers with the mean of
+      // their four children.
+      void poolFrom(int k);
+
+      std::vector<DstGrid> levels_;
+
+      // Total scroll of level 0 in its own cells, and the level-0 motion not
+      // yet worth a cell, in meters.
+      int64_t shift_x_ = 0;
+      int64_t shift_y_ = 0;
+      double residual_x_ = 0.0;
+      double residual_y_ = 0.0;
+    };
+  }
+}
@@ -0,0 +1,242 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  PointCloud2View.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sensor_msgs/msg/point_cloud2.hpp"
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief Read-only, strided view over the points of a PointCloud2.
+     *
+     * Field offsets are looked up once, when the view is created. Points are
+     * then read in place from the message buffer, so unlike pcl::fromROSMsg
+     * nothing is copied or repacked. x, y and z must be FLOAT32; intensity is
+     * optional and may be any numeric type. Organized clouds are treated as
+     * one flat list of width * height points.
+     *
+     * The view does not own the message, which must outlive it.
+     */
+    class PointCloud2View
+    {
+    public:
+      struct Point
+      {
+        float x;
+        float y;
+        float z;
+        float intensity;
+      };
+
+      /**
+       * @throws std::invalid_argument if the cloud has no FLOAT32 x/y/z
+       * fields or is big-endian
+       */
+      explicit PointCloud2View(const sensor_msgs::msg::PointCloud2 &msg)
+          : data_(msg.data.data()), step_(msg.point_step),
+            count_(std::size_t(msg.width) * msg.height)
+      {
+        using sensor_msgs::msg::PointField;
+
+        if (msg.is_bigendian)
+          throw std::invalid_argument("Big-endian point clouds are not supported");
+        if (msg.height > 1 && msg.row_step != msg.width * msg.point_step)
+          throw std::invalid_argument("Point clouds with padded rows are not supported");
+
+        bool has_x = false, has_y = false, has_z = false;
+        for (const PointField &field : msg.fields)
+        {
+          if (field.name == "x" || field.name == "y" || field.name == "z")
+          {
+            if (field.datatype != PointField::FLOAT32)
+              throw std::invalid_argument("Point field '" + field.name + "' must be FLOAT32");
+            if (field.name == "x")
+              x_offset_ = field.offset, has_x = true;
+            else if (field.name == "y")
+              y_offset_ = field.offset, has_y = true;
+            else
+              z_offset_ = field.offset, has_z = true;
+          }
+          else if (field.name == "intensity")
+          {
+            intensity_offset_ = field.offset;
+            intensity_type_ = field.datatype;
+          }
+          else if (field.name == "label" && field.datatype == PointField::UINT8)
+          {
+            label_offset_ = field.offset;
+            has_label_ = true;
+          }
+        }
+
+        if (!(has_x && has_y && has_z))
+          throw std::invalid_argument("Point cloud is missing an x, y or z field");
+
+        // Guard against clouds whose buffer is shorter than advertised.
+        if (step_ == 0 || msg.data.size() < count_ * step_)
+          count_ = step_ == 0 ? 0 : msg.data.size() / step_;
+      }
+
+      std::size_t size() const { return count_; }
+      bool empty() const { return count_ == 0; }
+
+      float x(std::size_t i) const { return load<float>(i, x_offset_); }
+      float y(std::size_t i) const { return load<float>(i, y_offset_); }
+      float z(std::size_t i) const { return load<float>(i, z_offset_); }
+
+      float intensity(std::size_t i) const
+      {
+        using sensor_msgs::msg::PointField;
+
+        switch (intensity_type_)
+        {
+        case PointField::FLOAT32:
+          return load<float>(i, intensity_offset_);
+        case PointField::FLOAT64:
+          return float(load<double>(i, intensity_offset_));
+        case PointField::UINT8:
+          return load<uint8_t>(i, intensity_offset_);
+        case PointField::UINT16:
+          return load<uint16_t>(i, intensity_offset_);
+        case PointField::UINT32:
+          return float(load<uint32_t>(i, intensity_offset_));
+        case PointField::INT8:
+          return load<int8_t>(i, intensity_offset_);
+        case PointField::INT16:
+          return load<int16_t>(i, intensity_offset_);
+        case PointField::INT32:
+          return float(load<int32_t>(i, intensity_offset_));
+        default: // No intensity field
+          return 0.0f;
+        }
+      }
+
+      /**
+       * @brief Whether the cloud has a UINT8 "label" field, as added by
+       * appendLabelField().
+       */
+      bool hasLabel() const { return has_label_; }
+      uint8_t label(std::size_t i) const { return load<uint8_t>(i, label_offset_); }
+
+      Point operator[](std::size_t i) const
+      {
+        return Point{x(i), y(i), z(i), intensity(i)};
+      }
+
+      /**
+       * @brief Raw bytes of a point, `pointStep()` long.
+       */
+      const uint8_t *raw(std::size_t i) const { return data_ + i * step_; }
+      uint32_t pointStep() const { return step_; }
+
+    private:
+      template <typename T>
+      T load(std::size_t i, uint32_t offset) const
+      {
+        // memcpy keeps unaligned fields well defined and compiles to a plain load.
+        T value;
+        std::memcpy(&value, data_ + i * step_ + offset, sizeof(T));
+        return value;
+      }
+
+      const uint8_t *data_;
+      uint32_t step_;
+      std::size_t count_;
+      uint32_t x_offset_ = 0;
+      uint32_t y_offset_ = 0;
+      uint32_t z_offset_ = 0;
+      uint32_t intensity_offset_ = 0;
+      uint8_t intensity_type_ = 0;
+      uint32_t label_offset_ = 0;
+      bool has_label_ = false;
+    };
+
+    /**
+     * @brief Fill `out` with the selected points of `in`, copying each point's
+     * bytes as-is. The fields and layout of `in` are kept, so no conversion
+     * happens. `out.data` keeps its capacity between calls.
+     */
+    template <typename Index>
+    void selectPoints(const sensor_msgs::msg::PointCloud2 &in, const std::vector<Index> &indices,
+                      sensor_msgs::msg::PointCloud2 &out)
+    {
+      const uint32_t step = in.point_step;
+
+      out.header = in.header;
+      out.fields = in.fields;
+      out.is_bigendian = in.is_bigendian;
+      out.point_step = step;
+      out.height = 1;
+      out.width = uint32_t(indices.size());
+      out.row_step = step * out.width;
+      out.is_dense = in.is_dense;
+
+      out.data.resize(std::size_t(step) * indices.size());
+      uint8_t *dst = out.data.data();
+      const uint8_t *src = in.data.data();
+      for (Index i : indices)
+      {
+        std::memcpy(dst, src + std::size_t(i) * step, step);
+        dst += step;
+      }
+    }
+
+    /**
+     * @brief Fill `out` with every point of `in` plus a UINT8 "label" field
+     * holding `labels[i]`. The label goes after the existing fields, and the
+     * point step is rounded up to keep points 4-byte aligned. `in` must be
+     * dense (no padded rows) and `labels` one per point.
+     */
+    inline void appendLabelField(const sensor_msgs::msg::PointCloud2 &in, const std::vector<uint8_t> &labels,
+                                 sensor_msgs::msg::PointCloud2 &out)
+    {
+      using sensor_msgs::msg::PointField;
+
+      const uint32_t in_step = in.point_step;
+      const uint32_t label_offset = in_step;
+      const uint32_t step = (in_step + 1 + 3) / 4 * 4;
+      const std::size_t count = labels.size();
+
+      out.header = in.header;
+      out.fields = in.fields;
+      PointField label;
+      label.name = "label";
+      label.offset = label_offset;
+      label.datatype = PointField::UINT8;
+      label.count = 1;
+      out.fields.push_back(label);
+      out.is_bigendian = in.is_bigendian;
+      out.point_step = step;
+      out.height = 1;
+      out.width = uint32_t(count);
+      out.row_step = step * out.width;
+      out.is_dense = in.is_dense;
+
+      out.data.resize(std::size_t(step) * count);
+      uint8_t *dst = out.data.data();
+      const uint8_t *src = in.data.data();
+      for (std::size_t i = 0; i < count; i++)
+      {
+        std::memcpy(dst, src + i * in_step, in_step);
+        std::memset(dst + in_step, 0, step - in_step);
+        dst[label_offset] = labels[i];
+        dst += step;
+      }
+    }
+  }
+}
@@ -0,0 +1,161 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  RayCaster.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "occupancy_cpp/DstGrid.hpp"
+#include "worker_pool/WorkerPool.hpp"
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief Fills the measurement planes of a DstGrid by ray casting from the
+     * ego vehicle.
+     *
+     * Everything that needs trigonometry is computed once per grid
+     * configuration: the angular bin of every cell, and for every bin a set of
+     * Bresenham cell sequences from the center to the grid edge. Per frame,
+     * hits are traced with integer Bresenham, and the bins that no hit covered
+     * are filled with free space by walking the table.
+     *
+     * A frame is cast in two phases. First every hit is marked occupied. Then
+     * free space is traced, stopping at any occupied cell and never writing to
+     * one. Because the second phase only ever writes the same value to cells
+     * that are not occupied, the result does not depend on the order rays are
+     * traced in. That is what lets the sweep be split into angular sectors
+     * that run in parallel: cells on a sector boundary touched by rays from
+     * both sides end up identical to the serial result.
+     *
+     * Several sensors can be cast into the same frame, each from its own
+     * origin (see Source). All of their hits are marked before any free space
+     * is traced, so the same argument makes the result independent of the
+     * order of the sensors too.
+     *
+     * Coordinates are cell offsets from the grid center, in [-half, half).
+     */
+    class RayCaster
+    {
+    public:
+      /**
+       * @param grid_size Cells per side of the grids this caster is used with
+       * @param bin_deg Width of an angular bin, in degrees
+       * @param rays_per_bin Free-space rays traced through each uncovered bin
+       * @param meas_mass Mass assigned to measured occupied and free cells
+       */
+      RayCaster(int grid_size, float bin_deg, int rays_per_bin, float meas_mass);
+
+      int gridSize() const { return grid_size_; }
+      int binCount() const { return bin_count_; }
+
+      /**
+       * @brief Angular bin of a cell, counter-clockwise from +x.
+       */
+      int binOf(int x, int y) const { return cell_bins_[cellIndex(x, y)]; }
+
+      struct Cell
+      {
+        int16_t x;
+        int16_t y;
+      };
+
+      /**
+       * @brief Cast one frame into the (cleared) measurement planes.
+       *
+       * @param hits Cells containing at least one return
+       * @param pool If given and larger than one thread, angular sectors are
+       * traced in parallel. The output is identical either way.
+       */
+      void cast(DstGrid &grid, const std::vector<Cell> &hits, worker_pool::WorkerPool *pool = nullptr);
+
+      /**
+       * @brief One sensor's hits, and the cell it sees them from.
+       */
+      struct Source
+      {
+        Cell origin;
+        const std::vector<Cell> *hits;
+      };
+
+      /**
+       * @brief Cast one frame from several sensors into the (cleared)
+       * measurement planes. Free space is traced from each source's origin
+       * towards its own hits and through the bins, around that origin, that
+       * none of them covered. A source whose origin is outside the grid only
+       * marks its hits. One source at (0, 0) casts exactly like the overload
+       * above.
+       */
+      void cast(DstGrid &grid, const std::vector<Source> &sources, worker_pool::WorkerPool *pool = nullptr);
+
+    private:
+      std::size_t cellIndex(int x, int y) const
+      {
+        return std::size_t(x + half_) * grid_size_ + (y + half_);
+      }
+
+      bool inGrid(int x, int y) const
+      {
+        return x >= -half_ && y >= -half_ && x < half_ && y < half_;
+      }
+
+      // Angular bin of a cell seen from origin. Offsets beyond the table, for
+      // origins away from the center, are binned directly.
+      int binFrom(Cell origin, Cell cell) const;
+
+      // Phase 1: mark hits occupied.
+      void markHits(DstGrid &grid, const std::vector<Cell> &hits) const;
+
+      // Phase 2 for one origin: bucket the hits by bin around it, then trace
+      // free space, sector by sector.
+      void traceFrom(DstGrid &grid, Cell origin, const std::vector<Cell> &hits, worker_pool::WorkerPool *pool);
+
+      // Trace bins [bin_begin, bin_end): the hits that fall in them, then the
+      // free-space rays of the ones left uncovered.
+      void traceSector(DstGrid &grid, Cell origin, int bin_begin, int bin_end) const;
+
+      // Walk a precomputed ray, marking free cells until an occupied one.
+      void walkRay(DstGrid &grid, const Cell *begin, const Cell *end) const;
+
+      // Trace ray r from an origin other than the center, out of the grid or
+      // to an occupied cell. The precomputed cells only reach half a grid
+      // from the center, so the ray is traced anew, twice as far.
+      void traceRay(DstGrid &grid, Cell origin, int r) const;
+
+      int grid_size_;
+      int half_;
+      int bin_count_;
+      float bin_deg_;
+      int rays_per_bin_;
+      Mass meas_mass_; // In the grids' storage type
+
+      // Angular bin of every cell, indexed by cellIndex().
+      std::vector<uint16_t> cell_bins_;
+
+      // All rays back to back. Ray r covers ray_cells_[ray_offsets_[r]] up to
+      // ray_cells_[ray_offsets_[r + 1]], and bin b owns rays
+      // [b * rays_per_bin, (b + 1) * rays_per_bin).
+      std::vector<Cell> ray_cells_;
+      std::vector<uint32_t> ray_offsets_;
+      // Where each ray leaves the grid, as traced from the center.
+      std::vector<Cell> ray_ends_;
+
+      // Per-frame scratch, kept between frames to avoid reallocating.
+      // Bins hit by at least one point this frame.
+      std::vector<uint8_t> covered_;
+      // This frame's hits sorted by bin; bin b owns
+      // sorted_hits_[bin_hit_offsets_[b]] up to sorted_hits_[bin_hit_offsets_[b + 1]].
+      std::vector<Cell> sorted_hits_;
+      std::vector<uint32_t> bin_hit_offsets_;
+    };
+  }
+}
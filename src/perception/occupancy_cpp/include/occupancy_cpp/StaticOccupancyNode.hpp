@@ -10,14 +10,25 @@
 #pragma once
 
 // Message definitions
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
 #include "nav_msgs/msg/occupancy_grid.hpp"
 #include "rosgraph_msgs/msg/clock.hpp"
+#include "nova_msgs/msg/compact_masses.hpp"
 #include "nova_msgs/msg/masses.hpp"
 #include "sensor_msgs/msg/point_cloud2.hpp"
 
+#include "occupancy_cpp/AllocationCounter.hpp"
+#include "occupancy_cpp/CompactMasses.hpp"
+#include "occupancy_cpp/DstGrid.hpp"
+#include "occupancy_cpp/MrfGroundSegmenter.hpp"
+#include "occupancy_cpp/MultiResolutionGrid.hpp"
+#include "occupancy_cpp/PointCloud2View.hpp"
+#include "occupancy_cpp/RayCaster.hpp"
+
 #include <algorithm>
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -29,10 +40,18 @@
 #include <pcl/filters/passthrough.h>
 
 #include "rclcpp/rclcpp.hpp"
+#include "tf2_ros/buffer.h"
+#include "tf2_ros/transform_listener.h"
+
+#include "latency_tracker/StageRecorder.hpp"
+#include "nova_trace/StageProfiler.hpp"
+#include "nova_trace/Trace.hpp"
 
 using namespace std::chrono_literals;
 
+using diagnostic_msgs::msg::DiagnosticArray;
 using nav_msgs::msg::OccupancyGrid;
+using nova_msgs::msg::CompactMasses;
 using nova_msgs::msg::Masses;
 using rosgraph_msgs::msg::Clock;
 using sensor_msgs::msg::PointCloud2;
@@ -45,13 +64,15 @@ namespace navigator
     class StaticOccupancyNode : public rclcpp::Node
     {
     public:
-      StaticOccupancyNode();
+      explicit StaticOccupancyNode(const rclcpp::NodeOptions &options = rclcpp::NodeOptions());
       virtual ~StaticOccupancyNode();
 
     private:
       // Publishers
       rclcpp::Publisher<OccupancyGrid>::SharedPtr occupancy_grid_pub;
       rclcpp::Publisher<Masses>::SharedPtr masses_pub;
+      rclcpp::Publisher<CompactMasses>::SharedPtr compact_masses_pub;
+      rclcpp::Publisher<DiagnosticArray>::SharedPtr diagnostics_pub;
 
       // Subscribers
       rclcpp::Subscription<Clock>::SharedPtr clock_sub;
@@ -61,38 +82,59 @@ namespace navigator
 
       // Timers
       // rclcpp::TimerBase::SharedPtr map_marker_timer;
+      rclcpp::TimerBase::SharedPtr diagnostics_timer;
 
       Clock clock;
 
-      void createOccupancyGrid(pcl::PointCloud<pcl::PointXYZI> &cloud);
-
-      bool initialization_phase = true;
-      float vehicle_x;
-      float vehicle_y;
-      float prev_vehicle_x;
-      float prev_vehicle_y;
-      float change_x;
-      float change_y;
-      float x_new_low;
-      float x_new_high;
-      float y_new_low;
-      float y_new_high;
-      float x_old_low;
-      float x_old_high;
-      float y_old_low;
-      float y_old_high;
+      void createOccupancyGrid(const PointCloud2View &cloud);
+
+      // A cloud's sensor in base_link: its points are rotated by r (row
+      // major) and moved by t.
+      struct SensorPose
+      {
+        float r[9];
+        float t[3];
+      };
+
+      // Multi-source input, when "occupancy_input_topics" lists several
+      // sensors' clouds. Each topic's newest cloud waits for the next fusion,
+      // every "fusion_period_ms". A fusion moves each cloud, through TF, to
+      // where base_link was when the newest of them was taken, casts it from
+      // its sensor's origin into the one measurement grid, and runs the DST
+      // update once for all of them.
+      struct Source
+      {
+        std::string topic;
+        rclcpp::Subscription<PointCloud2>::SharedPtr sub;
+        PointCloud2::ConstSharedPtr pending;
+        // Set for the clouds taken by the current fusion
+        std::optional<PointCloud2View> view;
+        SensorPose pose;
+        std::vector<std::vector<RayCaster::Cell>> hits; // By level
+      };
+      std::vector<Source> sources;
+      std::vector<std::vector<RayCaster::Source>> level_sources; // By level, rebuilt every fusion
+      rclcpp::TimerBase::SharedPtr fusion_timer;
+
+      void sourceCloudCb(std::size_t source, PointCloud2::ConstSharedPtr msg);
+      void fuseSources();
+      // The pose of a cloud's sensor at its stamp, in base_link at time.
+      // False if TF doesn't know where the sensor is.
+      bool lookupSensorPose(const PointCloud2 &cloud, const rclcpp::Time &time, SensorPose &pose);
+
+      // Ego-motion compensation. The grid is scrolled by whole cells as the
+      // vehicle moves, using the map->base_link transform.
+      std::unique_ptr<tf2_ros::Buffer> tf_buffer;
+      std::shared_ptr<tf2_ros::TransformListener> tf_listener{nullptr};
+      bool scroll_with_vehicle;
+      std::string map_frame;
+      bool has_previous_pose = false;
+      double prev_vehicle_x;
+      double prev_vehicle_y;
 
       // There are only two events: 0 = Occupied and 1 = Free.
       const static int event_num = 2;
 
-      // Grid size.
-      const static int GRID_SIZE = 128;
-
-      const int HALF_SIZE = GRID_SIZE / 2;
-
-      // Resolution.
-      constexpr static float res = 1. / 3.;
-
       // Measurement mass.
       constexpr static float meas_mass = 0.95;
 
@@ -105,52 +147,79 @@ namespace navigator
       constexpr static float prev_vehicle_pos_x = 0;
       constexpr static float prev_vehicle_pos_y = 0;
 
-      // Masses masses_msg;
-
-      // Array with the DST data.
-      float meas_grids[event_num][GRID_SIZE][GRID_SIZE];
-
-      // "Freeness" measurement.
-      float measured_free[GRID_SIZE][GRID_SIZE] = {{0}};
-
-      // Occupancy measurement.
-      float measured_occ[GRID_SIZE][GRID_SIZE] = {{0}};
-      float previous_free[GRID_SIZE][GRID_SIZE] = {{0}};
-      float previous_occ[GRID_SIZE][GRID_SIZE] = {{0}};
-      float updated_freeP[GRID_SIZE][GRID_SIZE] = {{0}};
-      float updated_occP[GRID_SIZE][GRID_SIZE] = {{0}};
-      float updated_free[GRID_SIZE][GRID_SIZE] = {{0}};
-      float updated_occ[GRID_SIZE][GRID_SIZE] = {{0}};
-
-      // Masses measurement (probability distribution)
-      float probabilities[GRID_SIZE][GRID_SIZE] = {{0}};
-      float probabilities_plot[GRID_SIZE][GRID_SIZE] = {{0}};
-
-      bool angles[360];
-      bool first;
+      // Measurement, posterior masses and probabilities. The grid size and
+      // resolution are set by the "grid_size" and "grid_resolution" parameters.
+      // The posterior also serves as the prior for the next frame, since
+      // DstGrid::update() works in place. With "grid_levels" > 1, coarser
+      // levels extend the range (see MultiResolutionGrid); with one level this
+      // is a single DstGrid. Builds with OCCUPANCY_FIXED_POINT_MASSES keep
+      // the masses in 16 bits instead of floats (see DstGrid::Mass).
+      std::unique_ptr<MultiResolutionGrid> grid;
+
+      // Precomputed rays, shared by all levels since they have the same size,
+      // and the cells hit by the current cloud in each level.
+      std::unique_ptr<RayCaster> ray_caster;
+      std::vector<std::vector<RayCaster::Cell>> hits;
+
+      // Size and resolution of the published grid when there are several
+      // levels, which are resampled into it.
+      int output_size;
+      float output_resolution;
+
+      // Workers for sector-parallel ray casting, if enabled.
+      std::unique_ptr<worker_pool::WorkerPool> ray_pool;
+
+      // Set when the masses are published as 8-bit tile deltas instead of floats.
+      std::unique_ptr<CompactMassesEncoder> compact_encoder;
+
+      // Outgoing messages. Their buffers are sized once in the constructor and
+      // rewritten in place every frame, so steady-state frames do not touch
+      // the heap.
+      OccupancyGrid occupancy_msg;
+      Masses masses_msg;
+      CompactMasses compact_msg;
+
+      // Frames processed, and heap allocations made on the processing path
+      // after the first frame. Should stay at zero.
+      std::size_t frame_count = 0;
+      std::size_t steady_state_allocations = 0;
+
+      // Per-stage latency, published on /diagnostics every second and, if
+      // "trace_file" is set, written there with the rest of the process's
+      // nova_trace events as a Chrome trace on shutdown.
+      enum Stage
+      {
+        STAGE_CREATE_GRID,
+        STAGE_UPDATE_PREVIOUS,
+        STAGE_MASS_UPDATE,
+        STAGE_PUBLISH,
+        STAGE_FRAME,
+      };
+      std::unique_ptr<trace::StageProfiler> profiler;
+      std::vector<trace::LatencyHistogram::Snapshot> last_snapshots;
+      std::string trace_file;
+
+      // Reports each frame from cloud to published grid to the latency
+      // tracker. The grids carry the sim clock rather than the cloud's stamp.
+      std::unique_ptr<latency_tracker::StageRecorder> latency_recorder;
 
       // void timer_cb(const ros::TimerEvent &);
 
       void transform_listener();
-      void pointCloudCb(const PointCloud2::SharedPtr msg);
-      void create_DST_grid(pcl::PointCloud<pcl::PointXYZI> &cloud);
-      void ray_tracing_approximation_x_increment(int x2, int y2, int flip_x, int flip_y, bool inclusive);
-      void ray_tracing_approximation_y_increment(int x2, int y2, int flip_x, int flip_y, bool inclusive);
-      int find_nearest(int num, float value, float min, float max, float res);
+      void pointCloudCb(PointCloud2::ConstSharedPtr msg);
+      // Everything after casting a frame's measurement grid: scroll,
+      // update, publish and clear.
+      void finishFrame(std::size_t frame_allocations, navigator::trace::Span &frame_span,
+                       latency_tracker::StageRecorder::Run &latency_run);
       void update_previous();
       void mass_update();
-      void update_of();
-      void get_mass();
-      void plotting();
-      std::vector<std::vector<float>> getGridCellProbabilities();
+      void fillMessages();
+      void fillResampledMessages();
       void publishOccupancyGrid();
+      void publishDiagnostics();
       void clear();
-      void fill(std::vector<int> flip);
-      void ray_tracing_horizontal(int y);
-      void ray_tracing_horizontal_n(int y);
-      void ray_tracing_vertical(int x);
-      void ray_tracing_vertical_n(int x);
-      void add_points_to_the_DST(pcl::PointCloud<pcl::PointXYZI> &cloud);
+      void add_points_to_the_DST(const PointCloud2View &cloud, const SensorPose *pose,
+                                 std::vector<std::vector<RayCaster::Cell>> &level_hits);
       void add_free_spaces_to_the_DST();
       void addEgoMask();
     };
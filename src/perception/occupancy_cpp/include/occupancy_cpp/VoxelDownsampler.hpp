@@ -0,0 +1,75 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  VoxelDownsampler.hpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "occupancy_cpp/PointCloud2View.hpp"
+
+namespace navigator
+{
+  namespace perception
+  {
+    /**
+     * @brief Voxel-grid downsampling that keeps the first point of every
+     * occupied voxel.
+     *
+     * Voxels are found through an open-addressing hash table of voxel keys.
+     * Entries are stamped with the frame they were written in, so the table
+     * is reused between frames without being cleared, and it only grows
+     * when a cloud has more points than it was sized for. Kept points are
+     * original points rather than centroids, so their bytes can be copied
+     * as-is with selectPoints().
+     *
+     * Voxel coordinates wrap every 2^18 voxels per axis, i.e. ±13 km at a
+     * 0.1 m leaf, which is far beyond any lidar's range.
+     */
+    class VoxelDownsampler
+    {
+    public:
+      /**
+       * @param leaf_size Voxel edge length, in meters
+       * @throws std::invalid_argument if the leaf size is not positive
+       */
+      explicit VoxelDownsampler(float leaf_size);
+
+      float leafSize() const { return leaf_size_; }
+
+      /**
+       * @throws std::invalid_argument if the leaf size is not positive
+       */
+      void setLeafSize(float leaf_size);
+
+      /**
+       * @brief Downsample a cloud.
+       *
+       * @param kept Filled with the ascending indices of the kept points.
+       * Points with a non-finite (or absurdly large) coordinate are dropped.
+       */
+      void downsample(const PointCloud2View &cloud, std::vector<uint32_t> &kept);
+
+    private:
+      // Make room for `points` distinct voxels at a load factor of at most 1/2.
+      void reserve(std::size_t points);
+
+      float leaf_size_;
+      float inv_leaf_size_;
+
+      // The hash table. Each slot packs a voxel key with the stamp of the
+      // frame that wrote it, so a probe is one 8-byte load and the table
+      // stays as small as possible; it is in use this frame if its stamp is
+      // stamp_.
+      std::vector<uint64_t> slots_;
+      uint64_t stamp_ = 0;
+      std::size_t mask_ = 0;
+    };
+  }
+}
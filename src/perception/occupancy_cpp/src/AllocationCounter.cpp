@@ -0,0 +1,18 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  AllocationCounter.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "occupancy_cpp/AllocationCounter.hpp"
+
+// Weak, so that it is null unless a library in the process defines it
+extern "C" std::size_t navigator_thread_allocation_count() __attribute__((weak));
+
+std::size_t navigator::perception::threadAllocationCount()
+{
+  return navigator_thread_allocation_count ? navigator_thread_allocation_count() : 0;
+}
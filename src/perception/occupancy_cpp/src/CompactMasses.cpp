@@ -0,0 +1,158 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  CompactMasses.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "occupancy_cpp/CompactMasses.hpp"
+
+#include <stdexcept>
+
+using namespace navigator::perception;
+
+CompactMassesEncoder::CompactMassesEncoder(int tile_size, int keyframe_interval)
+    : tile_size_(tile_size), keyframe_interval_(keyframe_interval)
+{
+  if (tile_size < 1 || tile_size > 0xFFFF)
+    throw std::invalid_argument("Compact masses tile size must be in [1, 65535]");
+  if (keyframe_interval < 1)
+    throw std::invalid_argument("Compact masses keyframe interval must be at least 1");
+}
+
+void CompactMassesEncoder::encode(const DstGrid &grid, nova_msgs::msg::CompactMasses &msg)
+{
+  const int size = grid.size();
+  const std::size_t cells = grid.cells();
+
+  if (size != size_)
+  {
+    size_ = size;
+    occ_.assign(cells, 0);
+    free_.assign(cells, 0);
+    sent_occ_.assign(cells, 0);
+    sent_free_.assign(cells, 0);
+    since_keyframe_ = -1;
+  }
+
+  // Quantize in logical (x-major) order, undoing any grid scrolling.
+  for (int x = 0; x < size; x++)
+  {
+    for (int y = 0; y < size; y++)
+    {
+      std::size_t i = grid.index(x, y);
+      occ_[std::size_t(x) * size + y] = quantizeMass(dst::massValue(grid.occ()[i]));
+      free_[std::size_t(x) * size + y] = quantizeMass(dst::massValue(grid.free()[i]));
+    }
+  }
+
+  const bool keyframe = since_keyframe_ < 0 || since_keyframe_ + 1 >= keyframe_interval_;
+  since_keyframe_ = keyframe ? 0 : since_keyframe_ + 1;
+
+  msg.sequence = sequence_++;
+  msg.keyframe = keyframe;
+  msg.width = size;
+  msg.height = size;
+  msg.tile_size = uint16_t(tile_size_);
+  msg.tiles.clear();
+  msg.occ.clear();
+  msg.free.clear();
+
+  const int tiles_per_row = (size + tile_size_ - 1) / tile_size_;
+  const uint32_t tile_count = uint32_t(tiles_per_row) * tiles_per_row;
+
+  for (uint32_t tile = 0; tile < tile_count; tile++)
+  {
+    withTileBounds(size, size, tile_size_, tile, [&](int r_begin, int r_end, int c_begin, int c_end)
+                   {
+      bool changed = keyframe;
+      for (int r = r_begin; r < r_end && !changed; r++)
+      {
+        std::size_t row = std::size_t(r) * size;
+        changed = !std::equal(occ_.begin() + row + c_begin, occ_.begin() + row + c_end, sent_occ_.begin() + row + c_begin) ||
+                  !std::equal(free_.begin() + row + c_begin, free_.begin() + row + c_end, sent_free_.begin() + row + c_begin);
+      }
+      if (!changed)
+        return;
+
+      msg.tiles.push_back(tile);
+      for (int r = r_begin; r < r_end; r++)
+      {
+        std::size_t row = std::size_t(r) * size;
+        msg.occ.insert(msg.occ.end(), occ_.begin() + row + c_begin, occ_.begin() + row + c_end);
+        msg.free.insert(msg.free.end(), free_.begin() + row + c_begin, free_.begin() + row + c_end);
+      } });
+  }
+
+  std::swap(occ_, sent_occ_);
+  std::swap(free_, sent_free_);
+}
+
+bool CompactMassesDecoder::apply(const nova_msgs::msg::CompactMasses &msg)
+{
+  if (msg.keyframe)
+  {
+    width_ = msg.width;
+    height_ = msg.height;
+    occ_.assign(std::size_t(width_) * height_, 0);
+    free_.assign(std::size_t(width_) * height_, 0);
+    valid_ = true;
+  }
+  else if (!valid_ || msg.sequence != last_sequence_ + 1 || msg.width != width_ || msg.height != height_)
+  {
+    // Lost a message or joined mid-stream: wait for the next keyframe.
+    valid_ = false;
+    return false;
+  }
+  last_sequence_ = msg.sequence;
+
+  if (msg.tile_size == 0)
+  {
+    valid_ = false;
+    return false;
+  }
+
+  std::size_t offset = 0;
+  bool truncated = false;
+  for (uint32_t tile : msg.tiles)
+  {
+    bool ok = withTileBounds(width_, height_, msg.tile_size, tile, [&](int r_begin, int r_end, int c_begin, int c_end)
+                             {
+      const std::size_t span = std::size_t(c_end - c_begin);
+      if (offset + span * (r_end - r_begin) > std::min(msg.occ.size(), msg.free.size()))
+      {
+        truncated = true;
+        return;
+      }
+      for (int r = r_begin; r < r_end; r++)
+      {
+        std::size_t row = std::size_t(r) * width_;
+        std::copy(msg.occ.begin() + offset, msg.occ.begin() + offset + span, occ_.begin() + row + c_begin);
+        std::copy(msg.free.begin() + offset, msg.free.begin() + offset + span, free_.begin() + row + c_begin);
+        offset += span;
+      } });
+
+    if (!ok || truncated)
+    {
+      valid_ = false;
+      return false;
+    }
+  }
+
+  return valid_;
+}
+
+void CompactMassesDecoder::toMasses(nova_msgs::msg::Masses &out) const
+{
+  out.width = width_;
+  out.height = height_;
+  out.occ.resize(occ_.size());
+  out.free.resize(free_.size());
+  for (std::size_t i = 0; i < occ_.size(); i++)
+  {
+    out.occ[i] = dequantizeMass(occ_[i]);
+    out.free[i] = dequantizeMass(free_[i]);
+  }
+}
@@ -0,0 +1,120 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  DstGrid.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "occupancy_cpp/DstGrid.hpp"
+#include "occupancy_cpp/DstKernel.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+using namespace navigator::perception;
+
+DstGrid::DstGrid(int size, float resolution)
+    : size_(size), resolution_(resolution), cells_(std::size_t(size) * size)
+{
+  if (size < 2 || size % 2 != 0)
+    throw std::invalid_argument("DST grid size must be even and at least 2, got " + std::to_string(size));
+  if (!(resolution > 0.0f))
+    throw std::invalid_argument("DST grid resolution must be positive");
+
+  // Round each plane up to a whole number of cache lines.
+  constexpr std::size_t cells_per_line = ALIGNMENT / sizeof(Mass);
+  stride_ = (cells_ + cells_per_line - 1) / cells_per_line * cells_per_line;
+
+  void *memory = std::aligned_alloc(ALIGNMENT, stride_ * PLANE_COUNT * sizeof(Mass));
+  if (memory == nullptr)
+    throw std::bad_alloc();
+  data_.reset(static_cast<Mass *>(memory));
+
+  reset();
+}
+
+void DstGrid::clearMeasurement()
+{
+  Mass *occ_plane = measOcc();
+  Mass *free_plane = measFree();
+  dispatchGridSize(size_, [&](auto n)
+                   {
+                     const std::size_t count = std::size_t(n) * n;
+                     std::fill(occ_plane, occ_plane + count, Mass(0));
+                     std::fill(free_plane, free_plane + count, Mass(0)); });
+}
+
+void DstGrid::reset()
+{
+  std::fill(data_.get(), data_.get() + stride_ * PLANE_COUNT, Mass(0));
+  offset_x_ = 0;
+  offset_y_ = 0;
+  revision_++;
+}
+
+void DstGrid::update(float decay_factor)
+{
+  dst::fusedUpdate(measOcc(), measFree(), occ(), free(), prob(), cells_, decay_factor);
+}
+
+void DstGrid::scroll(int dx, int dy)
+{
+  if (dx == 0 && dy == 0)
+    return;
+
+  // Anything beyond a full grid width leaves nothing to keep.
+  if (std::abs(dx) >= size_ || std::abs(dy) >= size_)
+  {
+    reset();
+    return;
+  }
+
+  revision_++;
+  offset_x_ = ((offset_x_ + dx) % size_ + size_) % size_;
+  offset_y_ = ((offset_y_ + dy) % size_ + size_) % size_;
+
+  // Logical rows [size - dx, size) (dx > 0) or [0, -dx) (dx < 0) are new,
+  // and likewise for columns. Clear them in storage coordinates, splitting
+  // any range that wraps around the plane edge.
+  auto clearRows = [&](int first, int count)
+  {
+    int begin = wrap(first + offset_x_);
+    int end = begin + count;
+    clearStorageBlock(begin, std::min(end, size_), 0, size_);
+    if (end > size_)
+      clearStorageBlock(0, end - size_, 0, size_);
+  };
+  auto clearCols = [&](int first, int count)
+  {
+    int begin = wrap(first + offset_y_);
+    int end = begin + count;
+    clearStorageBlock(0, size_, begin, std::min(end, size_));
+    if (end > size_)
+      clearStorageBlock(0, size_, 0, end - size_);
+  };
+
+  if (dx > 0)
+    clearRows(size_ - dx, dx);
+  else if (dx < 0)
+    clearRows(0, -dx);
+
+  if (dy > 0)
+    clearCols(size_ - dy, dy);
+  else if (dy < 0)
+    clearCols(0, -dy);
+}
+
+void DstGrid::clearStorageBlock(int row_begin, int row_end, int col_begin, int col_end)
+{
+  for (int p = 0; p < PLANE_COUNT; p++)
+  {
+    Mass *base = plane(p);
+    for (int r = row_begin; r < row_end; r++)
+      std::fill(base + std::size_t(r) * size_ + col_begin, base + std::size_t(r) * size_ + col_end, Mass(0));
+  }
+}
@@ -0,0 +1,415 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  DstKernel.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "occupancy_cpp/DstKernel.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DST_HAVE_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DST_HAVE_NEON 1
+#endif
+
+using namespace navigator::perception;
+
+namespace
+{
+  /**
+   * @brief Combine a predicted cell with its measurement (Dempster's rule)
+   * and compute its probability. Shared by every path so that they agree on
+   * the math.
+   */
+  inline void combineCell(float occ_pred, float free_pred, float m_occ, float m_free,
+                          float &occ, float &free, float &prob)
+  {
+    float unknown_pred = 1.0f - free_pred - occ_pred;
+    float measured_cell_unknown = 1.0f - m_free - m_occ;
+    float k_value = free_pred * m_occ + occ_pred * m_free;
+    float norm = 1.0f - k_value;
+
+    occ = (occ_pred * measured_cell_unknown + unknown_pred * m_occ + occ_pred * m_occ) / norm;
+    free = (free_pred * measured_cell_unknown + unknown_pred * m_free + free_pred * m_free) / norm;
+
+    // Probability.
+    prob = 0.5f * occ + 0.5f * (1.0f - free);
+  }
+
+  /**
+   * @brief Update a single cell. Shared by the scalar path and the vector
+   * loop tails so all paths agree on the math.
+   */
+  inline void updateCell(float m_occ, float m_free, float &occ, float &free, float &prob, float decay_factor)
+  {
+    // Prediction: decay the previous masses.
+    float occ_pred = std::min(decay_factor * occ, 1.0f - free);
+    float free_pred = std::min(decay_factor * free, 1.0f - occ);
+
+    combineCell(occ_pred, free_pred, m_occ, m_free, occ, free, prob);
+  }
+
+  /**
+   * @brief The decay factor as a 0.16 fixed-point multiplier, so that the
+   * decayed mass is (mass * decay) >> 16, as _mm256_mulhi_epu16 computes it.
+   */
+  inline uint32_t fixedDecay(float decay_factor)
+  {
+    return uint32_t(std::min(std::max(decay_factor * 65536.0f + 0.5f, 0.0f), 65535.0f));
+  }
+
+  inline void updateCell(uint16_t m_occ, uint16_t m_free, uint16_t &occ, uint16_t &free, uint16_t &prob,
+                         uint32_t decay)
+  {
+    // Prediction, saturating like the vector paths.
+    uint16_t occ_pred = std::min<uint16_t>((occ * decay) >> 16, uint16_t(65535 - free));
+    uint16_t free_pred = std::min<uint16_t>((free * decay) >> 16, uint16_t(65535 - occ));
+
+    float occ_new, free_new, prob_new;
+    combineCell(dst::massValue(occ_pred), dst::massValue(free_pred), dst::massValue(m_occ), dst::massValue(m_free),
+                occ_new, free_new, prob_new);
+    occ = dst::toMass<uint16_t>(occ_new);
+    free = dst::toMass<uint16_t>(free_new);
+    prob = dst::toMass<uint16_t>(prob_new);
+  }
+
+#ifdef DST_HAVE_X86
+  __attribute__((target("avx2"))) void fusedUpdateAvx2(const float *meas_occ, const float *meas_free,
+                                                       float *occ, float *free, float *prob,
+                                                       std::size_t n, float decay_factor)
+  {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 decay = _mm256_set1_ps(decay_factor);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      __m256 o = _mm256_loadu_ps(occ + i);
+      __m256 f = _mm256_loadu_ps(free + i);
+      __m256 mo = _mm256_loadu_ps(meas_occ + i);
+      __m256 mf = _mm256_loadu_ps(meas_free + i);
+
+      __m256 op = _mm256_min_ps(_mm256_mul_ps(decay, o), _mm256_sub_ps(one, f));
+      __m256 fp = _mm256_min_ps(_mm256_mul_ps(decay, f), _mm256_sub_ps(one, o));
+
+      __m256 up = _mm256_sub_ps(_mm256_sub_ps(one, fp), op);
+      __m256 mu = _mm256_sub_ps(_mm256_sub_ps(one, mf), mo);
+      __m256 k = _mm256_add_ps(_mm256_mul_ps(fp, mo), _mm256_mul_ps(op, mf));
+      __m256 norm = _mm256_sub_ps(one, k);
+
+      __m256 o_new = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(op, mu), _mm256_mul_ps(up, mo)), _mm256_mul_ps(op, mo));
+      __m256 f_new = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fp, mu), _mm256_mul_ps(up, mf)), _mm256_mul_ps(fp, mf));
+      o_new = _mm256_div_ps(o_new, norm);
+      f_new = _mm256_div_ps(f_new, norm);
+
+      __m256 p = _mm256_add_ps(_mm256_mul_ps(half, o_new), _mm256_mul_ps(half, _mm256_sub_ps(one, f_new)));
+
+      _mm256_storeu_ps(occ + i, o_new);
+      _mm256_storeu_ps(free + i, f_new);
+      _mm256_storeu_ps(prob + i, p);
+    }
+
+    for (; i < n; i++)
+      updateCell(meas_occ[i], meas_free[i], occ[i], free[i], prob[i], decay_factor);
+  }
+
+  // Fixed-point masses to float and back, 8 at a time. The way back
+  // rounds to nearest but leaves saturating to the pack.
+  __attribute__((target("avx2"))) inline __m256 widenFixedAvx2(__m128i v)
+  {
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v)), _mm256_set1_ps(1.0f / dst::FIXED_ONE));
+  }
+
+  __attribute__((target("avx2"))) inline __m256i narrowFixedAvx2(__m256 v)
+  {
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, _mm256_set1_ps(dst::FIXED_ONE)), _mm256_set1_ps(0.5f)));
+  }
+
+  /**
+   * @brief combineCell() on 8 fixed-point cells, widened to float. Returns
+   * the new occupied and free masses and the probability as 32-bit integers
+   * for the caller to pack, which saturates them.
+   */
+  __attribute__((target("avx2"))) inline void combineFixedAvx2(__m128i op16, __m128i fp16, __m128i mo16, __m128i mf16,
+                                                              __m256i &o_out, __m256i &f_out, __m256i &p_out)
+  {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    __m256 op = widenFixedAvx2(op16);
+    __m256 fp = widenFixedAvx2(fp16);
+    __m256 mo = widenFixedAvx2(mo16);
+    __m256 mf = widenFixedAvx2(mf16);
+
+    __m256 up = _mm256_sub_ps(_mm256_sub_ps(one, fp), op);
+    __m256 mu = _mm256_sub_ps(_mm256_sub_ps(one, mf), mo);
+    __m256 k = _mm256_add_ps(_mm256_mul_ps(fp, mo), _mm256_mul_ps(op, mf));
+    __m256 norm = _mm256_sub_ps(one, k);
+
+    __m256 o_new = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(op, mu), _mm256_mul_ps(up, mo)), _mm256_mul_ps(op, mo));
+    __m256 f_new = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fp, mu), _mm256_mul_ps(up, mf)), _mm256_mul_ps(fp, mf));
+    o_new = _mm256_div_ps(o_new, norm);
+    f_new = _mm256_div_ps(f_new, norm);
+
+    __m256 p = _mm256_add_ps(_mm256_mul_ps(half, o_new), _mm256_mul_ps(half, _mm256_sub_ps(one, f_new)));
+
+    o_out = narrowFixedAvx2(o_new);
+    f_out = narrowFixedAvx2(f_new);
+    p_out = narrowFixedAvx2(p);
+  }
+
+  // Pack two sets of 8 32-bit values into 16 saturated 16-bit ones, in order.
+  __attribute__((target("avx2"))) inline __m256i packFixedAvx2(__m256i lo, __m256i hi)
+  {
+    return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+  }
+
+  __attribute__((target("avx2"))) void fusedUpdateFixedAvx2(const uint16_t *meas_occ, const uint16_t *meas_free,
+                                                            uint16_t *occ, uint16_t *free, uint16_t *prob,
+                                                            std::size_t n, uint32_t decay)
+  {
+    const __m256i one = _mm256_set1_epi16(-1);
+    const __m256i decay16 = _mm256_set1_epi16(int16_t(decay));
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      __m256i o = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(occ + i));
+      __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(free + i));
+      __m256i mo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(meas_occ + i));
+      __m256i mf = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(meas_free + i));
+
+      __m256i op = _mm256_min_epu16(_mm256_mulhi_epu16(o, decay16), _mm256_subs_epu16(one, f));
+      __m256i fp = _mm256_min_epu16(_mm256_mulhi_epu16(f, decay16), _mm256_subs_epu16(one, o));
+
+      __m256i o_lo, f_lo, p_lo, o_hi, f_hi, p_hi;
+      combineFixedAvx2(_mm256_castsi256_si128(op), _mm256_castsi256_si128(fp), _mm256_castsi256_si128(mo),
+                       _mm256_castsi256_si128(mf), o_lo, f_lo, p_lo);
+      combineFixedAvx2(_mm256_extracti128_si256(op, 1), _mm256_extracti128_si256(fp, 1),
+                       _mm256_extracti128_si256(mo, 1), _mm256_extracti128_si256(mf, 1), o_hi, f_hi, p_hi);
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(occ + i), packFixedAvx2(o_lo, o_hi));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(free + i), packFixedAvx2(f_lo, f_hi));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(prob + i), packFixedAvx2(p_lo, p_hi));
+    }
+
+    for (; i < n; i++)
+      updateCell(meas_occ[i], meas_free[i], occ[i], free[i], prob[i], decay);
+  }
+
+  bool cpuHasAvx2()
+  {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+  }
+#endif
+
+#ifdef DST_HAVE_NEON
+  void fusedUpdateNeon(const float *meas_occ, const float *meas_free,
+                       float *occ, float *free, float *prob,
+                       std::size_t n, float decay_factor)
+  {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t decay = vdupq_n_f32(decay_factor);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      float32x4_t o = vld1q_f32(occ + i);
+      float32x4_t f = vld1q_f32(free + i);
+      float32x4_t mo = vld1q_f32(meas_occ + i);
+      float32x4_t mf = vld1q_f32(meas_free + i);
+
+      float32x4_t op = vminq_f32(vmulq_f32(decay, o), vsubq_f32(one, f));
+      float32x4_t fp = vminq_f32(vmulq_f32(decay, f), vsubq_f32(one, o));
+
+      float32x4_t up = vsubq_f32(vsubq_f32(one, fp), op);
+      float32x4_t mu = vsubq_f32(vsubq_f32(one, mf), mo);
+      float32x4_t k = vaddq_f32(vmulq_f32(fp, mo), vmulq_f32(op, mf));
+      float32x4_t norm = vsubq_f32(one, k);
+
+      float32x4_t o_new = vaddq_f32(vaddq_f32(vmulq_f32(op, mu), vmulq_f32(up, mo)), vmulq_f32(op, mo));
+      float32x4_t f_new = vaddq_f32(vaddq_f32(vmulq_f32(fp, mu), vmulq_f32(up, mf)), vmulq_f32(fp, mf));
+      o_new = vdivq_f32(o_new, norm);
+      f_new = vdivq_f32(f_new, norm);
+
+      float32x4_t p = vaddq_f32(vmulq_f32(half, o_new), vmulq_f32(half, vsubq_f32(one, f_new)));
+
+      vst1q_f32(occ + i, o_new);
+      vst1q_f32(free + i, f_new);
+      vst1q_f32(prob + i, p);
+    }
+
+    for (; i < n; i++)
+      updateCell(meas_occ[i], meas_free[i], occ[i], free[i], prob[i], decay_factor);
+  }
+  // (a * b) >> 16, lane by lane.
+  inline uint16x8_t mulhiNeon(uint16x8_t a, uint16x8_t b)
+  {
+    return vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(a), vget_low_u16(b)), 16),
+                        vshrn_n_u32(vmull_u16(vget_high_u16(a), vget_high_u16(b)), 16));
+  }
+
+  void fusedUpdateFixedNeon(const uint16_t *meas_occ, const uint16_t *meas_free,
+                            uint16_t *occ, uint16_t *free, uint16_t *prob,
+                            std::size_t n, uint32_t decay)
+  {
+    const uint16x8_t one16 = vdupq_n_u16(65535);
+    const uint16x8_t decay16 = vdupq_n_u16(uint16_t(decay));
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t to_float = vdupq_n_f32(1.0f / dst::FIXED_ONE);
+    const float32x4_t to_fixed = vdupq_n_f32(dst::FIXED_ONE);
+
+    auto widen = [&](uint16x4_t v)
+    { return vmulq_f32(vcvtq_f32_u32(vmovl_u16(v)), to_float); };
+    // The conversion saturates negative values to 0, and vqmovn_u32 large
+    // ones to 65535.
+    auto narrow = [&](float32x4_t v)
+    { return vcvtq_u32_f32(vaddq_f32(vmulq_f32(v, to_fixed), half)); };
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      uint16x8_t o = vld1q_u16(occ + i);
+      uint16x8_t f = vld1q_u16(free + i);
+      uint16x8_t mo = vld1q_u16(meas_occ + i);
+      uint16x8_t mf = vld1q_u16(meas_free + i);
+
+      uint16x8_t op16 = vminq_u16(mulhiNeon(o, decay16), vqsubq_u16(one16, f));
+      uint16x8_t fp16 = vminq_u16(mulhiNeon(f, decay16), vqsubq_u16(one16, o));
+
+      uint32x4_t o_out[2], f_out[2], p_out[2];
+      for (int h = 0; h < 2; h++)
+      {
+        float32x4_t op = widen(h ? vget_high_u16(op16) : vget_low_u16(op16));
+        float32x4_t fp = widen(h ? vget_high_u16(fp16) : vget_low_u16(fp16));
+        float32x4_t m_o = widen(h ? vget_high_u16(mo) : vget_low_u16(mo));
+        float32x4_t m_f = widen(h ? vget_high_u16(mf) : vget_low_u16(mf));
+
+        float32x4_t up = vsubq_f32(vsubq_f32(one, fp), op);
+        float32x4_t mu = vsubq_f32(vsubq_f32(one, m_f), m_o);
+        float32x4_t k = vaddq_f32(vmulq_f32(fp, m_o), vmulq_f32(op, m_f));
+        float32x4_t norm = vsubq_f32(one, k);
+
+        float32x4_t o_new = vaddq_f32(vaddq_f32(vmulq_f32(op, mu), vmulq_f32(up, m_o)), vmulq_f32(op, m_o));
+        float32x4_t f_new = vaddq_f32(vaddq_f32(vmulq_f32(fp, mu), vmulq_f32(up, m_f)), vmulq_f32(fp, m_f));
+        o_new = vdivq_f32(o_new, norm);
+        f_new = vdivq_f32(f_new, norm);
+
+        float32x4_t p = vaddq_f32(vmulq_f32(half, o_new), vmulq_f32(half, vsubq_f32(one, f_new)));
+
+        o_out[h] = narrow(o_new);
+        f_out[h] = narrow(f_new);
+        p_out[h] = narrow(p);
+      }
+
+      vst1q_u16(occ + i, vcombine_u16(vqmovn_u32(o_out[0]), vqmovn_u32(o_out[1])));
+      vst1q_u16(free + i, vcombine_u16(vqmovn_u32(f_out[0]), vqmovn_u32(f_out[1])));
+      vst1q_u16(prob + i, vcombine_u16(vqmovn_u32(p_out[0]), vqmovn_u32(p_out[1])));
+    }
+
+    for (; i < n; i++)
+      updateCell(meas_occ[i], meas_free[i], occ[i], free[i], prob[i], decay);
+  }
+#endif
+}
+
+void dst::fusedUpdateScalar(const float *meas_occ, const float *meas_free,
+                            float *occ, float *free, float *prob,
+                            std::size_t n, float decay_factor)
+{
+  for (std::size_t i = 0; i < n; i++)
+    updateCell(meas_occ[i], meas_free[i], occ[i], free[i], prob[i], decay_factor);
+}
+
+void dst::fusedUpdate(const float *meas_occ, const float *meas_free,
+                      float *occ, float *free, float *prob,
+                      std::size_t n, float decay_factor)
+{
+#if defined(DST_HAVE_X86)
+  if (cpuHasAvx2())
+  {
+    fusedUpdateAvx2(meas_occ, meas_free, occ, free, prob, n, decay_factor);
+    return;
+  }
+#elif defined(DST_HAVE_NEON)
+  fusedUpdateNeon(meas_occ, meas_free, occ, free, prob, n, decay_factor);
+  return;
+#endif
+  fusedUpdateScalar(meas_occ, meas_free, occ, free, prob, n, decay_factor);
+}
+
+void dst::fusedUpdateScalar(const uint16_t *meas_occ, const uint16_t *meas_free,
+                            uint16_t *occ, uint16_t *free, uint16_t *prob,
+                            std::size_t n, float decay_factor)
+{
+  const uint32_t decay = fixedDecay(decay_factor);
+  for (std::size_t i = 0; i < n; i++)
+    updateCell(meas_occ[i], meas_free[i], occ[i], free[i], prob[i], decay);
+}
+
+void dst::fusedUpdate(const uint16_t *meas_occ, const uint16_t *meas_free,
+                      uint16_t *occ, uint16_t *free, uint16_t *prob,
+                      std::size_t n, float decay_factor)
+{
+#if defined(DST_HAVE_X86)
+  if (cpuHasAvx2())
+  {
+    fusedUpdateFixedAvx2(meas_occ, meas_free, occ, free, prob, n, fixedDecay(decay_factor));
+    return;
+  }
+#elif defined(DST_HAVE_NEON)
+  fusedUpdateFixedNeon(meas_occ, meas_free, occ, free, prob, n, fixedDecay(decay_factor));
+  return;
+#endif
+  fusedUpdateScalar(meas_occ, meas_free, occ, free, prob, n, decay_factor);
+}
+
+const char *dst::fusedUpdateBackend()
+{
+#if defined(DST_HAVE_X86)
+  if (cpuHasAvx2())
+    return "avx2";
+#elif defined(DST_HAVE_NEON)
+  return "neon";
+#endif
+  return "scalar";
+}
+
+void dst::threePassUpdate(const float *meas_occ, const float *meas_free,
+                          float *occ, float *free, float *prob,
+                          float *occ_pred, float *free_pred,
+                          std::size_t n, float decay_factor)
+{
+  // Pass 1: prediction.
+  for (std::size_t i = 0; i < n; i++)
+  {
+    occ_pred[i] = std::min(decay_factor * occ[i], 1.0f - free[i]);
+    free_pred[i] = std::min(decay_factor * free[i], 1.0f - occ[i]);
+  }
+
+  // Pass 2: combination.
+  for (std::size_t i = 0; i < n; i++)
+  {
+    float unknown_pred = 1.0f - free_pred[i] - occ_pred[i];
+    float measured_cell_unknown = 1.0f - meas_free[i] - meas_occ[i];
+    float k_value = free_pred[i] * meas_occ[i] + occ_pred[i] * meas_free[i];
+
+    occ[i] = (occ_pred[i] * measured_cell_unknown + unknown_pred * meas_occ[i] + occ_pred[i] * meas_occ[i]) / (1.0f - k_value);
+    free[i] = (free_pred[i] * measured_cell_unknown + unknown_pred * meas_free[i] + free_pred[i] * meas_free[i]) / (1.0f - k_value);
+  }
+
+  // Pass 3: probabilities.
+  for (std::size_t i = 0; i < n; i++)
+    prob[i] = 0.5f * occ[i] + 0.5f * (1.0f - free[i]);
+}
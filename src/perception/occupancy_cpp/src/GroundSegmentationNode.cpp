@@ -9,11 +9,57 @@
 
 #include "occupancy_cpp/GroundSegmentationNode.hpp"
 
+#include <cmath>
+#include <optional>
+
+#include "nova_trace/Trace.hpp"
+
 using namespace navigator::perception;
 using namespace std::chrono_literals;
 
-GroundSegmentationNode::GroundSegmentationNode() : Node("ground_segmentation_node")
+GroundSegmentationNode::GroundSegmentationNode(const rclcpp::NodeOptions &options)
+    : Node("ground_segmentation_node", options)
 {
+  //------Parameters-------//
+  // All but the thread count can be changed at runtime; see onSetParameters().
+  MrfGroundSegmenter::Settings settings;
+  settings.lidar_height = this->declare_parameter<double>("lidar_height", settings.lidar_height);
+  settings.range = this->declare_parameter<double>("ground_range", settings.range);
+  settings.s = this->declare_parameter<double>("ground_max_step", settings.s);
+  settings.res = this->declare_parameter<double>("ground_resolution", settings.res);
+  settings.max_height = this->declare_parameter<double>("ground_max_height", settings.max_height);
+  settings.warm_start = this->declare_parameter<bool>("ground_warm_start", settings.warm_start);
+  settings.full_recompute_interval =
+      this->declare_parameter<int>("ground_full_recompute_interval", settings.full_recompute_interval);
+  map_frame = this->declare_parameter<std::string>("map_frame", "map");
+
+  // Keep only the first point of each voxel of this size, in meters; 0
+  // disables the downsampling. Can be changed at runtime.
+  double leaf_size = this->declare_parameter<double>("voxel_leaf_size", 0.0);
+  if (leaf_size > 0.0)
+    downsampler = std::make_unique<VoxelDownsampler>(float(leaf_size));
+
+  // Segment large rings on several threads. The output does not change.
+  int threads = this->declare_parameter<int>("ground_segmentation_threads", 1);
+  segmenter = std::make_unique<MrfGroundSegmenter>(settings, threads);
+
+  tf_buffer = std::make_unique<tf2_ros::Buffer>(this->get_clock());
+  // Turned off, /tf is handled by the node's own executor rather than the
+  // listener's thread, e.g. for deterministic replay
+  if (this->declare_parameter<bool>("dedicated_tf_thread", true))
+    tf_listener = std::make_shared<tf2_ros::TransformListener>(*tf_buffer);
+  else
+  {
+    // Intra-process communication does not support the latched /tf_static
+    rclcpp::SubscriptionOptions tf_options;
+    tf_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Disable;
+    tf_listener = std::make_shared<tf2_ros::TransformListener>(*tf_buffer, this, false, tf2_ros::DynamicListenerQoS(),
+                                                               tf2_ros::StaticListenerQoS(), tf_options);
+  }
+
+  parameter_callback = this->add_on_set_parameters_callback(
+      std::bind(&GroundSegmentationNode::onSetParameters, this, std::placeholders::_1));
+
   // Subscribe to and use CARLA's clock
   clock_sub = this->create_subscription<Clock>(
       "/clock", 10,
@@ -24,7 +70,44 @@ GroundSegmentationNode::GroundSegmentationNode() : Node("ground_segmentation_nod
       "/lidar/fused", 10,
       std::bind(&GroundSegmentationNode::pointCloudCb, this, std::placeholders::_1));
 
-  filtered_lidar_pub = this->create_publisher<PointCloud2>("/lidar/filtered", 10);
+  // "filtered" publishes the non-ground points as a new cloud on
+  // /lidar/filtered. "indices" only publishes their indices into the
+  // /lidar/fused cloud, on /lidar/obstacle_indices, so no points are copied.
+  // "labeled" republishes the whole cloud on /lidar/labeled with a "label"
+  // field (see MrfGroundSegmenter::Label). Both clouds are also published
+  // compressed, on <topic>/compressed, while anything subscribes to that.
+  std::string mode = this->declare_parameter<std::string>("ground_output_mode", "filtered");
+  if (mode == "indices")
+  {
+    output_mode = OUTPUT_INDICES;
+    obstacle_indices_pub = this->create_publisher<PointIndices>("/lidar/obstacle_indices", 10);
+  }
+  else if (mode == "labeled")
+  {
+    output_mode = OUTPUT_LABELED;
+    labeled_lidar_pub = std::make_unique<cloud_transport::Publisher>(*this, "/lidar/labeled", rclcpp::QoS(10));
+  }
+  else
+  {
+    if (mode != "filtered")
+      RCLCPP_WARN(this->get_logger(), "Unknown ground_output_mode '%s', using 'filtered'", mode.c_str());
+    output_mode = OUTPUT_FILTERED;
+    filtered_lidar_pub = std::make_unique<cloud_transport::Publisher>(*this, "/lidar/filtered", rclcpp::QoS(10));
+  }
+  const char *output_topic = output_mode == OUTPUT_INDICES   ? obstacle_indices_pub->get_topic_name()
+                             : output_mode == OUTPUT_LABELED ? labeled_lidar_pub->get_topic_name()
+                                                             : filtered_lidar_pub->get_topic_name();
+  latency_recorder = std::make_unique<latency_tracker::StageRecorder>(*this, "ground_segmentation", output_topic);
+
+  // The ground heights and cells the segmentation works out anyway, for
+  // nodes that would otherwise estimate the ground again. Only filled in
+  // while something subscribes.
+  if (this->declare_parameter<bool>("publish_ground_map", false))
+    ground_map_pub = this->create_publisher<GroundMap>("/grid/ground", 10);
+
+  diagnostics_pub = this->create_publisher<DiagnosticArray>("/diagnostics", 10);
+  diagnostics_timer = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(1s),
+                                           std::bind(&GroundSegmentationNode::publishDiagnostics, this));
 }
 
 /**
@@ -32,187 +115,268 @@ GroundSegmentationNode::GroundSegmentationNode() : Node("ground_segmentation_nod
  *
  * @param raw_cloud The unfiltered LiDAR point cloud
  */
-void GroundSegmentationNode::pointCloudCb(PointCloud2::SharedPtr msg)
+void GroundSegmentationNode::pointCloudCb(PointCloud2::ConstSharedPtr msg)
 {
-  PointCloud2 filtered_msg;
+  // Read the points in place rather than converting to PCL format.
+  std::optional<PointCloud2View> raw_cloud;
+  try
+  {
+    raw_cloud.emplace(*msg);
+  }
+  catch (const std::invalid_argument &ex)
+  {
+    RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                         "Dropping point cloud: %s", ex.what());
+    return;
+  }
 
-  pcl::PointCloud<pcl::PointXYZI> raw_cloud;
-  pcl::fromROSMsg(*msg, raw_cloud); // Convert the incoming message to PCL format
+  // Outputs keep the cloud's header, so its flow continues in the
+  // occupancy node.
+  NOVA_TRACE_SPAN("ground_segmentation.point_cloud", navigator::trace::flow_id(msg->header.stamp));
+  latency_tracker::StageRecorder::Run latency_run = latency_recorder->start();
+  latency_run.input(raw_lidar_sub->get_topic_name(), msg->header.stamp);
+
+  const std::size_t source_size = raw_cloud->size();
+  clouds_seen++;
+  points_in += source_size;
+
+  // Everything below works on `cloud`, which is the downsampled cloud if
+  // downsampling is on. Indices into it are mapped back through
+  // kept_indices where they are published as indices.
+  const PointCloud2 *cloud_msg = msg.get();
+  std::optional<PointCloud2View> downsampled;
+  const PointCloud2View *cloud = &*raw_cloud;
+  if (downsampler)
+  {
+    NOVA_TRACE_SPAN("ground_segmentation.downsample");
+    downsampler->downsample(*raw_cloud, kept_indices);
+    selectPoints(*msg, kept_indices, downsampled_msg);
+    cloud_msg = &downsampled_msg;
+    cloud = &downsampled.emplace(downsampled_msg);
+  }
+  points_out += cloud->size();
 
-  pcl::PointCloud<pcl::PointXYZI> filtered_cloud = removeGround(raw_cloud);
+  navigator::trace::counter("ground_segmentation.points", double(cloud->size()));
 
-  pcl::toROSMsg(filtered_cloud, filtered_msg);
+  {
+    NOVA_TRACE_SPAN("ground_segmentation.segment");
+    MrfGroundSegmenter::Motion motion;
+    if (segmenter->settings().warm_start && vehicleMotion(motion))
+      segmenter->segment(*cloud, obstacle_indices, motion);
+    else
+      segmenter->segment(*cloud, obstacle_indices);
+  }
 
-  filtered_msg.header = msg->header;
+  if (ground_map_pub && ground_map_pub->get_subscription_count() > 0)
+  {
+    NOVA_TRACE_SPAN("ground_segmentation.ground_map");
+    publishGroundMap(msg->header);
+  }
 
-  filtered_lidar_pub->publish(filtered_msg);
+  switch (output_mode)
+  {
+  // Outputs are published as unique_ptrs so that, with intra-process
+  // communication, subscribers in the same container get them without a copy.
+  case OUTPUT_INDICES:
+  {
+    auto indices_msg = std::make_unique<PointIndices>();
+    indices_msg->header = msg->header;
+    indices_msg->source_size = uint32_t(source_size);
+    if (downsampler)
+    {
+      indices_msg->indices.resize(obstacle_indices.size());
+      for (std::size_t k = 0; k < obstacle_indices.size(); k++)
+        indices_msg->indices[k] = kept_indices[obstacle_indices[k]];
+    }
+    else
+      indices_msg->indices.assign(obstacle_indices.begin(), obstacle_indices.end());
+    obstacle_indices_pub->publish(std::move(indices_msg));
+    break;
+  }
+  case OUTPUT_LABELED:
+  {
+    auto labeled_msg = std::make_unique<PointCloud2>();
+    segmenter->labelPoints(labels);
+    appendLabelField(*cloud_msg, labels, *labeled_msg);
+    labeled_lidar_pub->publish(std::move(labeled_msg));
+    break;
+  }
+  case OUTPUT_FILTERED:
+  {
+    // Copy the non-ground points' bytes straight into the output, keeping the
+    // input's fields.
+    auto filtered_msg = std::make_unique<PointCloud2>();
+    selectPoints(*cloud_msg, obstacle_indices, *filtered_msg);
+    filtered_lidar_pub->publish(std::move(filtered_msg));
+    break;
+  }
+  }
+  // Every output keeps the cloud's header
+  latency_run.finish(msg->header.stamp);
 }
 
 /**
- * @brief Remove ground points using Markov Random Field method
- * https://ieeexplore.ieee.org/document/9410344
- *
- * @param raw_cloud
- * @return pcl::PointCloud<pcl::PointXYZI>
+ * @brief Publishes the ground of the cloud just segmented on /grid/ground.
+ * The grid is centered on the sensor, so its origin, the corner of cell
+ * (0, 0), is half a cell past gridCenter() cells from it.
  */
-pcl::PointCloud<pcl::PointXYZI> GroundSegmentationNode::removeGround(pcl::PointCloud<pcl::PointXYZI> raw_cloud)
+void GroundSegmentationNode::publishGroundMap(const std_msgs::msg::Header &header)
 {
-  float lidar_height = 0.0; // TODO: Make ROS parameter
-  float range = 80.0;
-  float s = 0.55;         // ?
-  float res = 0.4;        // Grid cell size, in meters
-  float max_height = 2.5; // Exclude points above this height, in meters
-
-  pcl::PointCloud<pcl::PointXYZI> filtered_pcd;
-
-  size_t grid_size = int(2 * ceil((range) / res) + 1);
-  std::vector<int> grid[grid_size][grid_size];
-
-  int center_x = int(ceil(range / res));
-  int center_y = int(ceil(range / res));
+  const float res = float(segmenter->settings().res);
+  ground_map_msg.header = header;
+  ground_map_msg.resolution = res;
+  ground_map_msg.size = uint32_t(segmenter->gridSize());
+  ground_map_msg.origin.position.x = -(segmenter->gridCenter() + 0.5) * res;
+  ground_map_msg.origin.position.y = ground_map_msg.origin.position.x;
+  static_assert(GroundMap::UNOBSERVED == MrfGroundSegmenter::DROPPED && GroundMap::GROUND == MrfGroundSegmenter::GROUND &&
+                    GroundMap::OBSTACLE == MrfGroundSegmenter::OBSTACLE,
+                "GroundMap's cells are the segmenter's labels");
+  segmenter->groundMap(ground_map_msg.elevation, ground_map_msg.cells);
+  ground_map_pub->publish(ground_map_msg);
+}
 
-  // Populate the grid with indices of points that fit into a particular cell.
-  for (int i = 0; i < raw_cloud.size(); i++)
+/**
+ * @brief Finds how far the vehicle moved since the last call, in the
+ * previous base_link frame.
+ *
+ * @return false if the motion is unknown (no tf yet, or this is the first
+ * call), in which case the scan is segmented from scratch
+ */
+bool GroundSegmentationNode::vehicleMotion(MrfGroundSegmenter::Motion &motion)
+{
+  geometry_msgs::msg::TransformStamped t;
+  try
   {
-    pcl::PointXYZI point = raw_cloud.at(i);
-
-    // If the point is within range, add the point's index to the respective cell
-    if ((abs(point.x) <= range) && (abs(point.y) <= range) && (point.z <= max_height))
-      grid[int(center_x + round(point.x / res))][int(center_y + round(point.y / res))].push_back(i);
+    t = tf_buffer->lookupTransform(map_frame, "base_link", tf2::TimePointZero);
+  }
+  catch (const tf2::TransformException &ex)
+  {
+    RCLCPP_INFO_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                         "Could not get base_link->%s tf: %s. Ground segmentation will not warm-start.",
+                         map_frame.c_str(), ex.what());
+    has_previous_pose = false;
+    return false;
   }
 
-  // Initialize the hG array.
-  float hG[grid_size][grid_size];
+  const double x = t.transform.translation.x;
+  const double y = t.transform.translation.y;
+  const auto &q = t.transform.rotation;
+  const double yaw = std::atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z));
 
-  // Initialize the grid segmentation (ground cells have a value of 1).
-  int gridSeg[grid_size][grid_size];
-  std::fill(gridSeg[0], gridSeg[0] + grid_size * grid_size, 0);
+  const bool known = has_previous_pose;
+  if (known)
+  {
+    // Displacement in the map frame, rotated into the previous base_link frame.
+    const double dx_map = x - prev_vehicle_x;
+    const double dy_map = y - prev_vehicle_y;
+    motion.dx = float(std::cos(prev_vehicle_yaw) * dx_map + std::sin(prev_vehicle_yaw) * dy_map);
+    motion.dy = float(-std::sin(prev_vehicle_yaw) * dx_map + std::cos(prev_vehicle_yaw) * dy_map);
+    motion.dyaw = float(std::remainder(yaw - prev_vehicle_yaw, 2.0 * M_PI));
+  }
 
-  // Initialize the center coordinate of the 2D grid to ground according to the height of the
-  // LiDAR position on the vehicle.
-  hG[center_x][center_y] = -1 * lidar_height;
-  gridSeg[center_x][center_y] = 1;
+  prev_vehicle_x = x;
+  prev_vehicle_y = y;
+  prev_vehicle_yaw = yaw;
+  has_previous_pose = true;
+  return known;
+}
 
-  // Allocate space for two elements in the vector.
-  std::vector<int> outerIndex;
-  outerIndex.resize(2);
+/**
+ * @brief Applies changes to the segmentation parameters. The segmenter only
+ * rebuilds its grid and ring tables if the range or resolution changed.
+ */
+rcl_interfaces::msg::SetParametersResult GroundSegmentationNode::onSetParameters(
+    const std::vector<rclcpp::Parameter> &parameters)
+{
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
 
-  // Move radially outwards and perform the MRF segmentation.
-  for (int i = 1; i < int(ceil(range / res)) + 1; i++)
+  MrfGroundSegmenter::Settings settings = segmenter->settings();
+  for (const rclcpp::Parameter &parameter : parameters)
   {
-
-    // Generate the indices at the ith circle level from the center of the grid.
-    outerIndex[0] = -1 * i;
-    outerIndex[1] = i;
-
-    for (int index : outerIndex)
+    const std::string &name = parameter.get_name();
+    if (name == "lidar_height")
+      settings.lidar_height = parameter.as_double();
+    else if (name == "ground_range")
+      settings.range = parameter.as_double();
+    else if (name == "ground_max_step")
+      settings.s = parameter.as_double();
+    else if (name == "ground_resolution")
+      settings.res = parameter.as_double();
+    else if (name == "ground_max_height")
+      settings.max_height = parameter.as_double();
+    else if (name == "ground_warm_start")
+      settings.warm_start = parameter.as_bool();
+    else if (name == "ground_full_recompute_interval")
+      settings.full_recompute_interval = int(parameter.as_int());
+    else if (name == "voxel_leaf_size")
+    {
+      const double leaf_size = parameter.as_double();
+      if (leaf_size <= 0.0)
+        downsampler.reset();
+      else if (downsampler)
+        downsampler->setLeafSize(float(leaf_size));
+      else
+        downsampler = std::make_unique<VoxelDownsampler>(float(leaf_size));
+    }
+    else if (name == "ground_segmentation_threads")
     {
-      for (int k = -1 * i; k < (i + 1); k++)
-      {
-
-        // Index is the outer index (perimeter of circle) and k is possible inner indices
-        // in between the edges.
-        std::set<std::pair<int,int>> currentCircle;
-        currentCircle.insert(std::pair<int, int>(center_x + index, center_y + k));
-
-        // Add the mirror image of cells to the circle if not on the top or bottom row of the circle.
-        if (!((k == -1 * i) || (k == i)))
-        {
-          currentCircle.insert(std::pair<int, int>(center_x + k, center_y + index));
-        }
-
-        // Go through the one or two stored cells right now.
-        for (std::pair<int, int> const &indexPair : currentCircle)
-        {
-
-          int x = indexPair.first;
-          int y = indexPair.second;
-
-          // Compute the minimum and maximum z coordinates of each grid cell.
-
-          // Initialize H to a very small value.
-          float H = -std::numeric_limits<float>::infinity();
-          // Initialize h to a very large value.
-          float h = std::numeric_limits<float>::infinity();
-
-          if (!grid[x][y].empty())
-          {
-
-            const std::vector<int> pcIndices = grid[x][y];
-
-            for (int j = 0; j < pcIndices.size(); j++)
-            {
-              H = std::max(raw_cloud.at(pcIndices[j]).z, H);
-              h = std::min(raw_cloud.at(pcIndices[j]).z, h);
-            }
-          }
-
-          // Pay attention to what happens when there are no points in a grid cell? Will it work?
-
-          // Compute hHatG: find max hG of neighbors.
-          float hHatG = -std::numeric_limits<float>::infinity();
-
-          // Get the inner circle neighbors of the current cell.
-
-          // The inner circle is one level down from the current circle.
-          int innerCircleIndex = i - 1;
-
-          // Center the grid at (0, 0).
-          int xRelativeIndex = x - center_x;
-          int yRelativeIndex = y - center_y;
-
-          // Loop through possible neighbor indices.
-          for (int m = -1; m < 2; m++)
-          {
-            for (int n = -1; n < 2; n++)
-            {
-
-              int xRelativeNew = abs(xRelativeIndex + m);
-              int yRelativeNew = abs(yRelativeIndex + n);
-
-              // Ensure index is actually on the inner circle.
-              if (((xRelativeNew == innerCircleIndex) && (yRelativeNew <= innerCircleIndex)) || ((yRelativeNew == innerCircleIndex) && (xRelativeNew <= innerCircleIndex)))
-              {
-
-                // Compute the new hHatG.
-                float hGTemp = hG[x + m][y + n];
-                hHatG = std::max(hGTemp, hHatG);
-              }
-            }
-          }
-
-          // Update hG of current cell.
-          if ((H != -std::numeric_limits<float>::infinity()) && (h != std::numeric_limits<float>::infinity()) &&
-              ((H - h) < s) && ((H - hHatG) < s))
-          {
-            gridSeg[x][y] = 1;
-            hG[x][y] = H;
-          }
-          else
-          {
-            hG[x][y] = hHatG;
-
-            // Add the cell's LiDAR points to the segmented (not ground) point cloud.
-            if (!grid[x][y].empty())
-            {
-
-              const std::vector<int> pcIndices = grid[x][y];
-
-              for (int j = 0; j < grid[x][y].size(); j++)
-              {
-                filtered_pcd.push_back(raw_cloud.at(pcIndices[j]));
-              }
-            }
-          }
-        }
-      }
+      result.successful = false;
+      result.reason = "ground_segmentation_threads can only be set at startup";
+      return result;
     }
   }
 
-  return filtered_pcd;
+  try
+  {
+    segmenter->setSettings(settings);
+  }
+  catch (const std::invalid_argument &ex)
+  {
+    result.successful = false;
+    result.reason = ex.what();
+  }
+
+  return result;
+}
+
+/**
+ * @brief Publishes the downsampling statistics since the last call on
+ * /diagnostics: clouds seen, and the mean points per cloud in and out.
+ */
+void GroundSegmentationNode::publishDiagnostics()
+{
+  DiagnosticArray msg;
+  msg.header.stamp = this->clock.clock;
+
+  auto value = [](const std::string &key, double v)
+  {
+    diagnostic_msgs::msg::KeyValue kv;
+    kv.key = key;
+    kv.value = std::to_string(v);
+    return kv;
+  };
+
+  const double clouds = double(std::max<std::size_t>(clouds_seen, 1));
+
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.name = std::string(this->get_name()) + ": downsampling";
+  status.values.push_back(value("clouds", double(clouds_seen)));
+  status.values.push_back(value("points_in", points_in / clouds));
+  status.values.push_back(value("points_out", points_out / clouds));
+  status.values.push_back(value("leaf_size", downsampler ? downsampler->leafSize() : 0.0));
+  msg.status.push_back(status);
+
+  clouds_seen = points_in = points_out = 0;
+
+  diagnostics_pub->publish(msg);
 }
 
 GroundSegmentationNode::~GroundSegmentationNode()
 {
   // Do nothing for now.
-}
\ No newline at end of file
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(navigator::perception::GroundSegmentationNode)
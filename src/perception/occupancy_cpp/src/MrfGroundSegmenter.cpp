@@ -0,0 +1,317 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  MrfGroundSegmenter.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "occupancy_cpp/MrfGroundSegmenter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+#include "occupancy_cpp/GridRing.hpp"
+
+using namespace navigator::perception;
+
+namespace
+{
+  // Rings smaller than this are not worth handing to the pool.
+  constexpr int MIN_CELLS_PER_RANGE = 128;
+
+  // Added before truncating previous-scan cell coordinates to round them.
+  // Larger than any grid, and small enough to keep sub-cell precision.
+  constexpr float ROUND_BIAS = 16384.5f;
+}
+
+MrfGroundSegmenter::MrfGroundSegmenter(const Settings &settings, int threads)
+{
+  setSettings(settings);
+
+  if (threads > 1)
+    pool_ = std::make_unique<worker_pool::WorkerPool>(threads);
+}
+
+void MrfGroundSegmenter::setSettings(const Settings &settings)
+{
+  if (!(settings.res > 0.0f) || !(settings.range > 0.0f))
+    throw std::invalid_argument("Ground segmentation range and resolution must be positive");
+  if (std::ceil(settings.range / settings.res) > 4096.0f)
+    throw std::invalid_argument("Ground segmentation grid is too large; increase the resolution");
+  if (settings.full_recompute_interval < 1)
+    throw std::invalid_argument("Ground segmentation full recompute interval must be at least 1");
+
+  const bool layout_changed = grid_size_ == 0 || settings.range != settings_.range || settings.res != settings_.res;
+  settings_ = settings;
+  if (layout_changed)
+    buildTables();
+}
+
+/**
+ * @brief Precomputes the grid layout: the cells of every ring in
+ * processing order, and the inner-ring neighbours of each one.
+ */
+void MrfGroundSegmenter::buildTables()
+{
+  center_ = int(std::ceil(settings_.range / settings_.res));
+  grid_size_ = 2 * center_ + 1;
+  const std::size_t cells = std::size_t(grid_size_) * grid_size_;
+
+  ring_offsets_.assign(1, 0);
+  ring_cells_.clear();
+  inner_neighbours_.clear();
+  ring_cells_.reserve(cells);
+  inner_neighbours_.reserve(cells);
+
+  for (int i = 0; i < center_ + 1; i++)
+  {
+    forEachRingCell(i, [&](int dx, int dy)
+                    {
+      ring_cells_.push_back(uint32_t(cell(center_ + dx, center_ + dy)));
+
+      // Neighbours on the inner circle, one level down from the current one.
+      std::array<uint32_t, 3> neighbours{};
+      int count = 0;
+      for (int m = -1; m < 2; m++)
+      {
+        for (int n = -1; n < 2; n++)
+        {
+          int xRelativeNew = std::abs(dx + m);
+          int yRelativeNew = std::abs(dy + n);
+          if (i > 0 && std::max(xRelativeNew, yRelativeNew) == i - 1)
+            neighbours[count++] = uint32_t(cell(center_ + dx + m, center_ + dy + n));
+        }
+      }
+      for (int k = count; k < 3; k++)
+        neighbours[k] = neighbours[0];
+      inner_neighbours_.push_back(neighbours); });
+
+    ring_offsets_.push_back(uint32_t(ring_cells_.size()));
+  }
+
+  // The per-scan buffers are sized on the next scan. The previous scan no
+  // longer matches the layout.
+  has_previous_ = false;
+}
+
+/**
+ * @brief Bins the cloud into the grid in one linear pass: the indices of the
+ * points in each cell, and each cell's point count and min/max z.
+ *
+ * This stage is bound by memory bandwidth, while the ring propagation is
+ * bound by its dependencies. Keeping them apart lets each be measured and
+ * tuned on its own.
+ */
+void MrfGroundSegmenter::binPoints(const PointCloud2View &cloud)
+{
+  const float range = settings_.range;
+  const float res = settings_.res;
+  const float max_height = settings_.max_height;
+  const int center = center_;
+  const std::size_t cells = std::size_t(grid_size_) * grid_size_;
+
+  // Empty cells keep an inverted extent, so they read as having no height.
+  cell_min_z_.assign(cells, std::numeric_limits<float>::infinity());
+  cell_max_z_.assign(cells, -std::numeric_limits<float>::infinity());
+  cell_count_.assign(cells, 0);
+
+  // Bucket the indices of the points that fit into each cell.
+  grid_.build(cells, cloud.size(), [&](std::size_t i) -> int32_t
+              {
+    PointCloud2View::Point point = cloud[i];
+
+    // If the point is within range, add the point's index to the respective cell
+    if (!((std::abs(point.x) <= range) && (std::abs(point.y) <= range) && (point.z <= max_height)))
+      return -1;
+
+    const std::size_t c = cell(int(center + round(point.x / res)), int(center + round(point.y / res)));
+    cell_min_z_[c] = std::min(point.z, cell_min_z_[c]);
+    cell_max_z_[c] = std::max(point.z, cell_max_z_[c]);
+    cell_count_[c]++;
+    return int32_t(c); });
+}
+
+/**
+ * @brief Moves the previous scan's ground estimate into the current grid.
+ * Each cell takes the estimate of the previous cell nearest to its center,
+ * where that cell was ground.
+ */
+void MrfGroundSegmenter::warpPrevious(const Motion &motion)
+{
+  const std::size_t cells = std::size_t(grid_size_) * grid_size_;
+  const int size = grid_size_;
+  const float center = float(center_);
+
+  prior_hG_.resize(cells);
+
+  // A current cell (i, j) lies at previous cell coordinates
+  // R(dyaw) * (i - center, j - center) + d / res + center, which is affine in
+  // i and j, so it can be stepped without any trigonometry.
+  const float c = std::cos(motion.dyaw);
+  const float s = std::sin(motion.dyaw);
+  const float ox = motion.dx / settings_.res + center - (c * center - s * center);
+  const float oy = motion.dy / settings_.res + center - (s * center + c * center);
+
+  for (int i = 0; i < size; i++)
+  {
+    float px = ox + c * float(i);
+    float py = oy + s * float(i);
+    float *prior = prior_hG_.data() + std::size_t(i) * size;
+
+    for (int j = 0; j < size; j++, px -= s, py += c)
+    {
+      // Round to nearest; the bias keeps the truncation a floor inside the
+      // grid and just outside it.
+      const int pi = int(px + ROUND_BIAS) - int(ROUND_BIAS - 0.5f);
+      const int pj = int(py + ROUND_BIAS) - int(ROUND_BIAS - 0.5f);
+      float value = std::numeric_limits<float>::quiet_NaN();
+      if (pi >= 0 && pj >= 0 && pi < size && pj < size)
+      {
+        const std::size_t p = cell(pi, pj);
+        if (prev_seg_[p])
+          value = prev_hG_[p];
+      }
+      prior[j] = value;
+    }
+  }
+}
+
+void MrfGroundSegmenter::segment(const PointCloud2View &cloud, std::vector<int> &obstacle_indices)
+{
+  segmentImpl(cloud, obstacle_indices, nullptr);
+}
+
+void MrfGroundSegmenter::segment(const PointCloud2View &cloud, std::vector<int> &obstacle_indices,
+                                 const Motion &motion)
+{
+  segmentImpl(cloud, obstacle_indices, &motion);
+}
+
+void MrfGroundSegmenter::segmentImpl(const PointCloud2View &cloud, std::vector<int> &obstacle_indices,
+                                     const Motion *motion)
+{
+  obstacle_indices.clear();
+
+  binPoints(cloud);
+
+  const std::size_t cells = std::size_t(grid_size_) * grid_size_;
+  const int center = center_;
+
+  // Warm-start from the previous scan, unless this scan is due a full
+  // recompute.
+  use_prior_ = settings_.warm_start && motion && has_previous_ &&
+               scans_since_full_ + 1 < settings_.full_recompute_interval;
+  if (use_prior_)
+  {
+    // The last scan's result becomes the previous estimate.
+    prev_hG_.swap(hG_);
+    prev_seg_.swap(gridSeg_);
+    warpPrevious(*motion);
+    scans_since_full_++;
+  }
+  else
+    scans_since_full_ = 0;
+
+  // Initialize the hG array. Every cell is written before it is read.
+  hG_.resize(cells);
+
+  // Initialize the grid segmentation (ground cells have a value of 1).
+  gridSeg_.assign(cells, 0);
+
+  // Initialize the center coordinate of the 2D grid to ground according to the height of the
+  // LiDAR position on the vehicle.
+  hG_[cell(center, center)] = -1 * settings_.lidar_height;
+  gridSeg_[cell(center, center)] = 1;
+
+  const int threads = pool_ ? pool_->size() : 1;
+
+  // Move radially outwards and perform the MRF segmentation.
+  for (int i = 1; i < center + 1; i++)
+  {
+    const int ring_cells = int(ring_offsets_[i + 1] - ring_offsets_[i]);
+    const int ranges = std::min(threads * 2, ring_cells / MIN_CELLS_PER_RANGE);
+
+    if (!pool_ || ranges <= 1)
+    {
+      segmentRing(i, 0, ring_cells, obstacle_indices);
+      continue;
+    }
+
+    if (int(range_obstacles_.size()) < ranges)
+      range_obstacles_.resize(ranges);
+
+    pool_->run(ranges, [&](int r)
+               {
+      range_obstacles_[r].clear();
+      segmentRing(i, r * ring_cells / ranges, (r + 1) * ring_cells / ranges, range_obstacles_[r]); });
+
+    for (int r = 0; r < ranges; r++)
+      obstacle_indices.insert(obstacle_indices.end(), range_obstacles_[r].begin(), range_obstacles_[r].end());
+  }
+
+  // hG_ and gridSeg_ can now seed the next scan.
+  has_previous_ = true;
+}
+
+void MrfGroundSegmenter::labelPoints(std::vector<uint8_t> &labels) const
+{
+  labels.resize(grid_.points());
+  for (std::size_t i = 0; i < labels.size(); i++)
+  {
+    const int32_t c = grid_.cellOf(i);
+    labels[i] = c < 0 ? DROPPED : gridSeg_[c] ? GROUND : OBSTACLE;
+  }
+}
+
+void MrfGroundSegmenter::groundMap(std::vector<float> &heights, std::vector<uint8_t> &cells) const
+{
+  heights.assign(hG_.begin(), hG_.end());
+  cells.resize(hG_.size());
+  for (std::size_t c = 0; c < cells.size(); c++)
+    cells[c] = gridSeg_[c] ? GROUND : cell_count_[c] > 0 ? OBSTACLE : DROPPED;
+}
+
+void MrfGroundSegmenter::segmentRing(int i, int begin, int end, std::vector<int> &obstacle_indices)
+{
+  const float s = settings_.s;
+  const uint32_t first = ring_offsets_[i];
+  const float *prior = use_prior_ ? prior_hG_.data() : nullptr;
+
+  for (uint32_t p = first + begin; p < first + end; p++)
+  {
+    const uint32_t c = ring_cells_[p];
+
+    // The maximum and minimum z coordinates of the grid cell, from binPoints().
+    const float H = cell_max_z_[c];
+    const float h = cell_min_z_[c];
+
+    // Compute hHatG: the max hG of the neighbors on the inner circle, or,
+    // when warm-starting, the previous scan's ground height here if it had one.
+    // Both are computed so the choice compiles to a select rather than a
+    // branch, which would mispredict along every ground/obstacle boundary.
+    const std::array<uint32_t, 3> &neighbours = inner_neighbours_[p];
+    float hHatG = std::max(hG_[neighbours[0]], std::max(hG_[neighbours[1]], hG_[neighbours[2]]));
+    if (prior)
+      hHatG = std::isnan(prior[c]) ? hHatG : prior[c];
+
+    // Update hG of current cell.
+    if ((cell_count_[c] > 0) && ((H - h) < s) && ((H - hHatG) < s))
+    {
+      gridSeg_[c] = 1;
+      hG_[c] = H;
+    }
+    else
+    {
+      hG_[c] = hHatG;
+
+      // Add the cell's LiDAR points to the segmented (not ground) point cloud.
+      const std::span<const int> pcIndices = grid_[c];
+      obstacle_indices.insert(obstacle_indices.end(), pcIndices.begin(), pcIndices.end());
+    }
+  }
+}
@@ -0,0 +1,144 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  MultiResolutionGrid.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "occupancy_cpp/MultiResolutionGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace navigator::perception;
+
+namespace
+{
+  // Position of level `k`'s origin in its own cells, given level 0's.
+  int64_t levelShift(int64_t shift, int k)
+  {
+    // Floor division by 2^k, also for negative shifts.
+    return shift >> k;
+  }
+}
+
+MultiResolutionGrid::MultiResolutionGrid(int levels, int level_size, float resolution)
+{
+  if (levels < 1 || levels > 16)
+    throw std::invalid_argument("A multi-resolution grid needs between 1 and 16 levels");
+  if (levels > 1 && level_size % 4 != 0)
+    throw std::invalid_argument("Multi-resolution grid levels must be a multiple of 4 cells wide");
+
+  levels_.reserve(levels);
+  for (int k = 0; k < levels; k++)
+    levels_.emplace_back(level_size, resolution * float(1 << k));
+}
+
+float MultiResolutionGrid::range() const
+{
+  const DstGrid &coarsest = levels_.back();
+  return coarsest.half() * coarsest.resolution();
+}
+
+void MultiResolutionGrid::clearMeasurement()
+{
+  for (DstGrid &level : levels_)
+    level.clearMeasurement();
+}
+
+void MultiResolutionGrid::update(float decay_factor)
+{
+  for (DstGrid &level : levels_)
+    level.update(decay_factor);
+
+  for (int k = 1; k < levelCount(); k++)
+    poolFrom(k);
+}
+
+void MultiResolutionGrid::scroll(double dx, double dy)
+{
+  const double res = finest().resolution();
+  residual_x_ += dx;
+  residual_y_ += dy;
+  const int64_t step_x = int64_t(residual_x_ / res);
+  const int64_t step_y = int64_t(residual_y_ / res);
+  residual_x_ -= step_x * res;
+  residual_y_ -= step_y * res;
+
+  if (step_x == 0 && step_y == 0)
+    return;
+
+  for (int k = 0; k < levelCount(); k++)
+  {
+    const int64_t sx = levelShift(shift_x_ + step_x, k) - levelShift(shift_x_, k);
+    const int64_t sy = levelShift(shift_y_ + step_y, k) - levelShift(shift_y_, k);
+    // DstGrid::scroll() resets the level for anything beyond its width.
+    const int64_t limit = levels_[k].size();
+    levels_[k].scroll(int(std::clamp(sx, -limit, limit)), int(std::clamp(sy, -limit, limit)));
+  }
+
+  shift_x_ += step_x;
+  shift_y_ += step_y;
+}
+
+void MultiResolutionGrid::poolFrom(int k)
+{
+  const DstGrid &fine = levels_[k - 1];
+  DstGrid &coarse = levels_[k];
+  const int n = coarse.size();
+  const int half = coarse.half();
+
+  // Coarse cell X covers fine cells x0 and x0 + 1, with x0 = 2X - half - d.
+  // d is 1 when level k - 1 sits half a coarse cell off level k, which
+  // happens whenever it has scrolled by an odd number of its own cells.
+  const int dx = int(levelShift(shift_x_, k - 1) - 2 * levelShift(shift_x_, k));
+  const int dy = int(levelShift(shift_y_, k - 1) - 2 * levelShift(shift_y_, k));
+
+  for (int X = n / 4; X < 3 * n / 4 + 1; X++)
+  {
+    const int x0 = 2 * X - half - dx;
+    if (x0 < 0 || x0 + 1 >= n)
+      continue;
+
+    for (int Y = n / 4; Y < 3 * n / 4 + 1; Y++)
+    {
+      const int y0 = 2 * Y - half - dy;
+      if (y0 < 0 || y0 + 1 >= n)
+        continue;
+
+      const std::size_t a = fine.index(x0, y0), b = fine.index(x0 + 1, y0);
+      const std::size_t c = fine.index(x0, y0 + 1), d = fine.index(x0 + 1, y0 + 1);
+      const std::size_t i = coarse.index(X, Y);
+
+      const Mass *occ = fine.occ();
+      const Mass *free = fine.free();
+      const float o = 0.25f * (dst::massValue(occ[a]) + dst::massValue(occ[b]) +
+                               dst::massValue(occ[c]) + dst::massValue(occ[d]));
+      const float f = 0.25f * (dst::massValue(free[a]) + dst::massValue(free[b]) +
+                               dst::massValue(free[c]) + dst::massValue(free[d]));
+      coarse.occ()[i] = dst::toMass<Mass>(o);
+      coarse.free()[i] = dst::toMass<Mass>(f);
+      coarse.prob()[i] = dst::toMass<Mass>(0.5f * o + 0.5f * (1.0f - f));
+    }
+  }
+}
+
+MultiResolutionGrid::Sample MultiResolutionGrid::sample(float x, float y) const
+{
+  for (const DstGrid &level : levels_)
+  {
+    const float res = level.resolution();
+    const int cx = int(std::floor(x / res)) + level.center();
+    const int cy = int(std::floor(y / res)) + level.center();
+    if (cx < 0 || cy < 0 || cx >= level.size() || cy >= level.size())
+      continue;
+
+    const std::size_t i = level.index(cx, cy);
+    return Sample{dst::massValue(level.occ()[i]), dst::massValue(level.free()[i]), dst::massValue(level.prob()[i])};
+  }
+
+  return Sample{0.0f, 0.0f, 0.5f};
+}
@@ -0,0 +1,272 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  RayCaster.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "occupancy_cpp/RayCaster.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+using namespace navigator::perception;
+
+namespace
+{
+  /**
+   * @brief Visit the cells of a Bresenham line from (0, 0) towards (x2, y2),
+   * excluding (x2, y2) itself. Stops early if `visit` returns false.
+   */
+  template <typename F>
+  void bresenham(int x2, int y2, F &&visit)
+  {
+    const int dx = std::abs(x2);
+    const int dy = -std::abs(y2);
+    const int sx = x2 > 0 ? 1 : -1;
+    const int sy = y2 > 0 ? 1 : -1;
+    int err = dx + dy;
+
+    for (int x = 0, y = 0; !(x == x2 && y == y2);)
+    {
+      if (!visit(x, y))
+        return;
+
+      int e2 = 2 * err;
+      if (e2 >= dy)
+      {
+        err += dy;
+        x += sx;
+      }
+      if (e2 <= dx)
+      {
+        err += dx;
+        y += sy;
+      }
+    }
+  }
+}
+
+RayCaster::RayCaster(int grid_size, float bin_deg, int rays_per_bin, float meas_mass)
+    : grid_size_(grid_size), half_(grid_size / 2), bin_deg_(bin_deg), rays_per_bin_(rays_per_bin),
+      meas_mass_(dst::toMass<Mass>(meas_mass))
+{
+  if (!(bin_deg > 0.0f) || bin_deg > 360.0f)
+    throw std::invalid_argument("Angular bin width must be in (0, 360] degrees");
+  if (rays_per_bin < 1)
+    throw std::invalid_argument("At least one ray per angular bin is required");
+
+  bin_count_ = int(std::ceil(360.0f / bin_deg));
+  if (bin_count_ > std::numeric_limits<uint16_t>::max())
+    throw std::invalid_argument("Angular bins are too narrow");
+
+  // Bin of every cell.
+  cell_bins_.resize(std::size_t(grid_size_) * grid_size_);
+  for (int x = -half_; x < half_; x++)
+  {
+    for (int y = -half_; y < half_; y++)
+    {
+      double angle = std::atan2(double(y), double(x)) * 180.0 / M_PI;
+      if (angle < 0.0)
+        angle += 360.0;
+      cell_bins_[cellIndex(x, y)] = uint16_t(std::min(int(angle / bin_deg), bin_count_ - 1));
+    }
+  }
+
+  // Rays from the center to the edge of the grid.
+  const int ray_count = bin_count_ * rays_per_bin_;
+  ray_offsets_.reserve(ray_count + 1);
+  ray_offsets_.push_back(0);
+  ray_ends_.reserve(ray_count);
+
+  for (int r = 0; r < ray_count; r++)
+  {
+    double angle = (r + 0.5) * bin_deg / rays_per_bin_ * M_PI / 180.0;
+    double c = std::cos(angle);
+    double s = std::sin(angle);
+    double scale = half_ / std::max(std::abs(c), std::abs(s));
+    int x2 = int(std::lround(c * scale));
+    int y2 = int(std::lround(s * scale));
+    ray_ends_.push_back(Cell{int16_t(x2), int16_t(y2)});
+
+    bresenham(x2, y2, [&](int x, int y)
+              {
+                if (x < -half_ || y < -half_ || x >= half_ || y >= half_)
+                  return false;
+                ray_cells_.push_back(Cell{int16_t(x), int16_t(y)});
+                return true; });
+
+    ray_offsets_.push_back(uint32_t(ray_cells_.size()));
+  }
+
+  covered_.assign(bin_count_, 0);
+  bin_hit_offsets_.assign(bin_count_ + 1, 0);
+}
+
+void RayCaster::cast(DstGrid &grid, const std::vector<Cell> &hits, worker_pool::WorkerPool *pool)
+{
+  markHits(grid, hits);
+  traceFrom(grid, Cell{0, 0}, hits, pool);
+}
+
+void RayCaster::cast(DstGrid &grid, const std::vector<Source> &sources, worker_pool::WorkerPool *pool)
+{
+  // Every source's hits are occupied before any source traces free space, so
+  // no ray runs through another sensor's return.
+  for (const Source &source : sources)
+    markHits(grid, *source.hits);
+
+  for (const Source &source : sources)
+  {
+    if (inGrid(source.origin.x, source.origin.y))
+      traceFrom(grid, source.origin, *source.hits, pool);
+  }
+}
+
+int RayCaster::binFrom(Cell origin, Cell cell) const
+{
+  const int dx = cell.x - origin.x;
+  const int dy = cell.y - origin.y;
+  if (inGrid(dx, dy))
+    return binOf(dx, dy);
+
+  double angle = std::atan2(double(dy), double(dx)) * 180.0 / M_PI;
+  if (angle < 0.0)
+    angle += 360.0;
+  return std::min(int(angle / bin_deg_), bin_count_ - 1);
+}
+
+void RayCaster::markHits(DstGrid &grid, const std::vector<Cell> &hits) const
+{
+  const int c = grid.center();
+  Mass *occ = grid.measOcc();
+  Mass *free = grid.measFree();
+
+  for (const Cell &hit : hits)
+  {
+    std::size_t i = grid.index(hit.x + c, hit.y + c);
+    occ[i] = meas_mass_;
+    free[i] = Mass(0);
+  }
+}
+
+void RayCaster::traceFrom(DstGrid &grid, Cell origin, const std::vector<Cell> &hits, worker_pool::WorkerPool *pool)
+{
+  // Bucket the hits by bin (counting sort).
+  std::fill(covered_.begin(), covered_.end(), 0);
+  std::fill(bin_hit_offsets_.begin(), bin_hit_offsets_.end(), 0);
+
+  for (const Cell &hit : hits)
+  {
+    int bin = binFrom(origin, hit);
+    covered_[bin] = 1;
+    bin_hit_offsets_[bin + 1]++;
+  }
+
+  for (int b = 0; b < bin_count_; b++)
+    bin_hit_offsets_[b + 1] += bin_hit_offsets_[b];
+
+  sorted_hits_.resize(hits.size());
+  for (const Cell &hit : hits)
+  {
+    // Fill each bin from the back, leaving bin_hit_offsets_[b + 1] at the
+    // start of bin b.
+    uint32_t &end = bin_hit_offsets_[binFrom(origin, hit) + 1];
+    sorted_hits_[--end] = hit;
+  }
+  for (int b = 0; b < bin_count_; b++)
+    bin_hit_offsets_[b] = bin_hit_offsets_[b + 1];
+  bin_hit_offsets_[bin_count_] = uint32_t(hits.size());
+
+  const int threads = pool ? pool->size() : 1;
+  if (threads <= 1)
+  {
+    traceSector(grid, origin, 0, bin_count_);
+    return;
+  }
+
+  // Several sectors per thread keep the load balanced when the returns are
+  // concentrated in a few directions.
+  const int sectors = std::min(bin_count_, threads * 4);
+  pool->run(sectors, [&](int s)
+            { traceSector(grid, origin, s * bin_count_ / sectors, (s + 1) * bin_count_ / sectors); });
+}
+
+void RayCaster::traceSector(DstGrid &grid, Cell origin, int bin_begin, int bin_end) const
+{
+  const int c = grid.center();
+  const Mass *occ = grid.measOcc();
+  Mass *free = grid.measFree();
+  const bool centered = origin.x == 0 && origin.y == 0;
+
+  for (int b = bin_begin; b < bin_end; b++)
+  {
+    if (!covered_[b])
+    {
+      for (int r = b * rays_per_bin_; r < (b + 1) * rays_per_bin_; r++)
+      {
+        if (centered)
+          walkRay(grid, ray_cells_.data() + ray_offsets_[r], ray_cells_.data() + ray_offsets_[r + 1]);
+        else
+          traceRay(grid, origin, r);
+      }
+      continue;
+    }
+
+    for (uint32_t h = bin_hit_offsets_[b]; h < bin_hit_offsets_[b + 1]; h++)
+    {
+      const Cell &hit = sorted_hits_[h];
+      // Both ends are in the grid, so every cell between them is too.
+      bresenham(hit.x - origin.x, hit.y - origin.y, [&](int rx, int ry)
+                {
+                  // Stop at cells that are occupied.
+                  std::size_t i = grid.index(rx + origin.x + c, ry + origin.y + c);
+                  if (occ[i] == meas_mass_)
+                    return false;
+                  // Other sectors may write the same value to this cell.
+                  std::atomic_ref<Mass>(free[i]).store(meas_mass_, std::memory_order_relaxed);
+                  return true; });
+    }
+  }
+}
+
+void RayCaster::traceRay(DstGrid &grid, Cell origin, int r) const
+{
+  const int c = grid.center();
+  const Mass *occ = grid.measOcc();
+  Mass *free = grid.measFree();
+  const Cell &end = ray_ends_[r];
+
+  bresenham(2 * end.x, 2 * end.y, [&](int rx, int ry)
+            {
+              const int x = rx + origin.x;
+              const int y = ry + origin.y;
+              if (!inGrid(x, y))
+                return false;
+              std::size_t i = grid.index(x + c, y + c);
+              if (occ[i] == meas_mass_)
+                return false;
+              std::atomic_ref<Mass>(free[i]).store(meas_mass_, std::memory_order_relaxed);
+              return true; });
+}
+
+void RayCaster::walkRay(DstGrid &grid, const Cell *begin, const Cell *end) const
+{
+  const int c = grid.center();
+  const Mass *occ = grid.measOcc();
+  Mass *free = grid.measFree();
+
+  for (const Cell *cell = begin; cell != end; cell++)
+  {
+    std::size_t i = grid.index(cell->x + c, cell->y + c);
+    if (occ[i] == meas_mass_)
+      return;
+    std::atomic_ref<Mass>(free[i]).store(meas_mass_, std::memory_order_relaxed);
+  }
+}
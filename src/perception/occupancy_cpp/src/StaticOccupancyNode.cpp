@@ -9,16 +9,108 @@
 
 #include "occupancy_cpp/StaticOccupancyNode.hpp"
 
+#include <optional>
+
+#include "nova_trace/Trace.hpp"
+
 using namespace navigator::perception;
 using namespace std::chrono_literals;
 
+namespace
+{
+  void setRotation(const geometry_msgs::msg::Quaternion &q, float *r)
+  {
+    const double x = q.x, y = q.y, z = q.z, w = q.w;
+    r[0] = float(1 - 2 * (y * y + z * z));
+    r[1] = float(2 * (x * y - w * z));
+    r[2] = float(2 * (x * z + w * y));
+    r[3] = float(2 * (x * y + w * z));
+    r[4] = float(1 - 2 * (x * x + z * z));
+    r[5] = float(2 * (y * z - w * x));
+    r[6] = float(2 * (x * z - w * y));
+    r[7] = float(2 * (y * z + w * x));
+    r[8] = float(1 - 2 * (x * x + y * y));
+  }
+}
+
 /**
  * @brief Constructor for static occupancy node
  * Subscribers: CARLA clock, Ground Segmented Pointcloud
- * Publishers: Static Occupancy Grid, Masses Grid
+ * Publishers: Static Occupancy Grid, Masses Grid (full or compact)
  */
-StaticOccupancyNode::StaticOccupancyNode() : Node("static_occupancy_node")
+StaticOccupancyNode::StaticOccupancyNode(const rclcpp::NodeOptions &options)
+    : Node("static_occupancy_node", options)
 {
+  //------Parameters-------//
+  // Grid dimensions. Larger grids give more range at highway speeds, smaller
+  // ones are cheaper when the car is moving slowly.
+  int grid_size = this->declare_parameter<int>("grid_size", 128);
+  float grid_resolution = this->declare_parameter<double>("grid_resolution", 1. / 3.);
+
+  // Coarser levels, each doubling the cell size and range of the one before.
+  // With several levels, the published grid is resampled from all of them.
+  int grid_levels = this->declare_parameter<int>("grid_levels", 1);
+  grid = std::make_unique<MultiResolutionGrid>(grid_levels, grid_size, grid_resolution);
+  hits.resize(grid_levels);
+  output_size = this->declare_parameter<int>("output_grid_size", 256);
+  output_resolution = this->declare_parameter<double>("output_grid_resolution", 2. / 3.);
+  if (grid_levels == 1)
+  {
+    output_size = grid_size;
+    output_resolution = grid_resolution;
+  }
+
+  // Free space is traced through every angular bin that no point hit.
+  float angular_bin_deg = this->declare_parameter<double>("angular_bin_deg", 1.0);
+  int rays_per_bin = this->declare_parameter<int>("rays_per_bin", 10);
+  ray_caster = std::make_unique<RayCaster>(grid_size, angular_bin_deg, rays_per_bin, meas_mass);
+
+  // Trace angular sectors in parallel. 1 casts everything on the callback thread.
+  int ray_casting_threads = this->declare_parameter<int>("ray_casting_threads", 1);
+  if (ray_casting_threads > 1)
+    ray_pool = std::make_unique<worker_pool::WorkerPool>(ray_casting_threads);
+
+  // Scroll the grid with the vehicle so old evidence stays put in the world
+  // instead of smearing along with the car.
+  scroll_with_vehicle = this->declare_parameter<bool>("scroll_with_vehicle", true);
+  map_frame = this->declare_parameter<std::string>("map_frame", "map");
+
+  // Publish the masses as 8-bit tiles, sending only the tiles that changed
+  // between keyframes. Cuts /grid/masses bandwidth by 4x or more.
+  bool compact_output = this->declare_parameter<bool>("compact_output", false);
+  int compact_tile_size = this->declare_parameter<int>("compact_tile_size", 16);
+  int compact_keyframe_interval = this->declare_parameter<int>("compact_keyframe_interval", 20);
+  if (compact_output && grid_levels > 1)
+    RCLCPP_WARN(this->get_logger(), "compact_output only supports a single grid level; publishing full masses.");
+  else if (compact_output)
+    compact_encoder = std::make_unique<CompactMassesEncoder>(compact_tile_size, compact_keyframe_interval);
+
+  // Stage timings. A trace file turns on nova_trace for the whole process,
+  // keeping trace_capacity events per thread.
+  trace_file = this->declare_parameter<std::string>("trace_file", "");
+  int trace_capacity = this->declare_parameter<int>("trace_capacity", 20000);
+  if (!trace_file.empty())
+    navigator::trace::enable(std::max(trace_capacity, 1));
+  profiler = std::make_unique<trace::StageProfiler>(
+      std::vector<std::string>{"create_occupancy_grid", "update_previous", "mass_update",
+                               "publish_occupancy_grid", "frame"},
+      "static_occupancy");
+  last_snapshots.resize(profiler->stage_count());
+
+  tf_buffer = std::make_unique<tf2_ros::Buffer>(this->get_clock());
+  // Turned off, /tf is handled by the node's own executor rather than the
+  // listener's thread, e.g. for deterministic replay
+  if (this->declare_parameter<bool>("dedicated_tf_thread", true))
+    tf_listener = std::make_shared<tf2_ros::TransformListener>(*tf_buffer);
+  else
+  {
+    // Intra-process communication does not support the latched /tf_static
+    rclcpp::SubscriptionOptions tf_options;
+    tf_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Disable;
+    tf_listener = std::make_shared<tf2_ros::TransformListener>(*tf_buffer, this, false, tf2_ros::DynamicListenerQoS(),
+                                                               tf2_ros::StaticListenerQoS(), tf_options);
+  }
+
   //------Subscribers-------//
   // Subscribe to and use CARLA's clock
   clock_sub = this->create_subscription<Clock>(
@@ -26,48 +118,313 @@ StaticOccupancyNode::StaticOccupancyNode() : Node("static_occupancy_node")
       [this](Clock::SharedPtr msg)
       { this->clock = *msg; });
 
-  pcd_sub = this->create_subscription<PointCloud2>(
-      "/lidar/filtered",
-      10,
-      std::bind(&StaticOccupancyNode::pointCloudCb, this, std::placeholders::_1));
+  // Either /lidar/filtered, or /lidar/labeled when the ground segmentation
+  // runs with ground_output_mode "labeled"; ground points are skipped then.
+  std::string input_topic = this->declare_parameter<std::string>("occupancy_input_topic", "/lidar/filtered");
+  // Several sensors' clouds, fused here rather than upstream (see Source).
+  // Each is ray cast from its own frame's origin, so they needn't be in
+  // base_link. Replaces occupancy_input_topic when set.
+  std::vector<std::string> input_topics = this->declare_parameter<std::vector<std::string>>(
+      "occupancy_input_topics", std::vector<std::string>{});
+  int fusion_period_ms = this->declare_parameter<int>("fusion_period_ms", 100);
+  if (input_topics.empty())
+  {
+    pcd_sub = this->create_subscription<PointCloud2>(
+        input_topic,
+        10,
+        std::bind(&StaticOccupancyNode::pointCloudCb, this, std::placeholders::_1));
+  }
+  else
+  {
+    sources.resize(input_topics.size());
+    level_sources.resize(grid_levels);
+    for (auto &level : level_sources)
+      level.reserve(sources.size());
+    for (std::size_t i = 0; i < sources.size(); i++)
+    {
+      sources[i].topic = input_topics[i];
+      sources[i].hits.resize(grid_levels);
+      sources[i].sub = this->create_subscription<PointCloud2>(
+          input_topics[i], 10,
+          [this, i](PointCloud2::ConstSharedPtr msg)
+          { this->sourceCloudCb(i, msg); });
+    }
+    fusion_timer = rclcpp::create_timer(this, this->get_clock(),
+                                        rclcpp::Duration(std::chrono::milliseconds(std::max(fusion_period_ms, 1))),
+                                        std::bind(&StaticOccupancyNode::fuseSources, this));
+  }
+
+  //----Messages-------//
+  const std::size_t cells = std::size_t(output_size) * output_size;
+  occupancy_msg.header.frame_id = "base_link"; // TODO: Make sure the frame is the correct one.
+  occupancy_msg.info.resolution = output_resolution;
+  occupancy_msg.info.width = output_size;
+  occupancy_msg.info.height = output_size;
+  occupancy_msg.info.origin.position.z = 0.2;
+  occupancy_msg.info.origin.position.x = -(output_size / 2) * output_resolution;
+  occupancy_msg.info.origin.position.y = -(output_size / 2) * output_resolution;
+  occupancy_msg.data.resize(cells);
+
+  if (!compact_encoder)
+  {
+    masses_msg.width = output_size;
+    masses_msg.height = output_size;
+    masses_msg.occ.resize(cells);
+    masses_msg.free.resize(cells);
+  }
 
   //----Publishers-------//
   occupancy_grid_pub = this->create_publisher<OccupancyGrid>("/grid/occupancy/current", 10);
-  masses_pub = this->create_publisher<Masses>("/grid/masses", 10);
+  if (compact_encoder)
+    compact_masses_pub = this->create_publisher<CompactMasses>("/grid/masses/compact", 10);
+  else
+    masses_pub = this->create_publisher<Masses>("/grid/masses", 10);
+  diagnostics_pub = this->create_publisher<DiagnosticArray>("/diagnostics", 10);
+  latency_recorder = std::make_unique<latency_tracker::StageRecorder>(*this, "static_occupancy",
+                                                                      occupancy_grid_pub->get_topic_name());
+
+  //----Timers-------//
+  diagnostics_timer = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(1s),
+                                           std::bind(&StaticOccupancyNode::publishDiagnostics, this));
 }
 
 StaticOccupancyNode::~StaticOccupancyNode()
 {
-  // nothing here
+  if (trace_file.empty())
+    return;
+
+  if (!navigator::trace::write_chrome_trace(trace_file))
+    RCLCPP_ERROR(this->get_logger(), "Could not write the stage trace to %s", trace_file.c_str());
 }
 
 /**
  * @brief Each time that raw LiDAR pcl is received:
- * 1. Convert to pcl::PointCloud<pcl::PointXYZI> (x, y, z, intensity), keep in mind this reverses rows and columns?
- * 2. Fills and ray traces static occupancy grid
+ * 1. Moves the previous grid with the vehicle
+ * 2. Wraps the message in a view that reads x, y, z in place (no copy), and
+ *    fills and ray traces the measurement grid from it
  *
  * @param msg The LiDAR point cloud previously ground segmented
  */
-void StaticOccupancyNode::pointCloudCb(PointCloud2::SharedPtr msg)
+void StaticOccupancyNode::pointCloudCb(PointCloud2::ConstSharedPtr msg)
+{
+  std::optional<PointCloud2View> view;
+  try
+  {
+    view.emplace(*msg);
+  }
+  catch (const std::invalid_argument &ex)
+  {
+    RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                         "Dropping point cloud: %s", ex.what());
+    return;
+  }
+  const PointCloud2View &cloud = *view;
+
+  // Carries the flows of the cloud and of the grids made from it, which are
+  // stamped with the sim clock instead.
+  navigator::trace::Span frame_span("static_occupancy.point_cloud", navigator::trace::flow_id(msg->header.stamp));
+  navigator::trace::counter("static_occupancy.points", double(msg->width) * msg->height);
+  latency_tracker::StageRecorder::Run latency_run = latency_recorder->start();
+  latency_run.input(pcd_sub->get_topic_name(), msg->header.stamp);
+  trace::ScopedStageTimer frame_timer(*profiler, STAGE_FRAME);
+
+  // 1. Move the previous grid with the vehicle. The measurement planes
+  // scroll with it, so this comes before the cast.
+  {
+    trace::ScopedStageTimer timer(*profiler, STAGE_UPDATE_PREVIOUS);
+    update_previous();
+  }
+
+  // Everything but the tf lookup and the publish itself, which belong to ROS.
+  AllocationScope allocations;
+
+  // 2. Convert new measurement into a DST grid.
+  {
+    trace::ScopedStageTimer timer(*profiler, STAGE_CREATE_GRID);
+    createOccupancyGrid(cloud);
+  }
+  finishFrame(allocations.count(), frame_span, latency_run);
+}
+
+/**
+ * @brief The rest of a frame, once the previous grid has been moved with the
+ * vehicle and the measurement cast:
+ * 3. Combines the previous grid with the measurement
+ * 4-5. Publishes the grids
+ * 6. Clears the measurement for the next frame
+ */
+void StaticOccupancyNode::finishFrame(std::size_t frame_allocations, navigator::trace::Span &frame_span,
+                                      latency_tracker::StageRecorder::Run &latency_run)
 {
-  // Converts the PCL ros message using pcl_conversions.
-  pcl::PointCloud<pcl::PointXYZI> cloud;
-  pcl::fromROSMsg(*msg, cloud);
+  AllocationScope update_allocations;
 
-  // 1. Convert new measurement into a DST grid.
-  createOccupancyGrid(cloud);
+  // 3. Add decayed region (previous grid) to the updated grid and compute probabilities
+  {
+    trace::ScopedStageTimer timer(*profiler, STAGE_MASS_UPDATE);
+    mass_update();
+  }
 
-  // 2. Updates previous grid with updated grid values (important in cases of variable grid size)
-  update_previous();
+  {
+    trace::ScopedStageTimer timer(*profiler, STAGE_PUBLISH);
 
-  // 3. Add decayed region (previous grid) to the updated grid
-  mass_update();
+    // 4. Write the static occupancy grid and mass grid into the outgoing messages
+    fillMessages();
+    frame_span.flow(navigator::trace::flow_id(occupancy_msg.header.stamp));
+    frame_allocations += update_allocations.count();
 
-  // 4. Publish static occupancy grid and mass grid
-  publishOccupancyGrid();
+    // 5. Publish them
+    publishOccupancyGrid();
+  }
+  latency_run.finish(occupancy_msg.header.stamp);
 
-  // 5. Clear current measured grid
+  // 6. Clear current measured grid
   clear();
+
+  // The first frame sizes the scratch buffers; after that, a frame should
+  // only allocate when a cloud has more hits than any before it.
+  if (frame_count++ > 0 && frame_allocations > 0)
+  {
+    steady_state_allocations += frame_allocations;
+    RCLCPP_DEBUG(this->get_logger(), "Frame %zu made %zu heap allocations (%zu since the first frame)",
+                 frame_count, frame_allocations, steady_state_allocations);
+  }
+}
+
+/**
+ * @brief Keeps a source's newest cloud for the next fusion. A sensor that
+ * sends more than one cloud a period only has its newest cast.
+ */
+void StaticOccupancyNode::sourceCloudCb(std::size_t source, PointCloud2::ConstSharedPtr msg)
+{
+  sources[source].pending = std::move(msg);
+}
+
+/**
+ * @brief Where a cloud's sensor was when the cloud was taken, relative to
+ * base_link at `time`, so that the vehicle's motion between the two is
+ * compensated. Without a fixed frame to go through (no map_frame tf, or the
+ * stamps are outside the tf buffer), falls back to the latest mounting of the
+ * sensor on the vehicle.
+ */
+bool StaticOccupancyNode::lookupSensorPose(const PointCloud2 &cloud, const rclcpp::Time &time, SensorPose &pose)
+{
+  geometry_msgs::msg::TransformStamped t;
+  try
+  {
+    t = tf_buffer->lookupTransform("base_link", time, cloud.header.frame_id, rclcpp::Time(cloud.header.stamp),
+                                   map_frame);
+  }
+  catch (const tf2::TransformException &)
+  {
+    try
+    {
+      t = tf_buffer->lookupTransform("base_link", cloud.header.frame_id, tf2::TimePointZero);
+    }
+    catch (const tf2::TransformException &ex)
+    {
+      RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                           "Dropping a cloud in %s, which has no tf to base_link: %s",
+                           cloud.header.frame_id.c_str(), ex.what());
+      return false;
+    }
+  }
+
+  setRotation(t.transform.rotation, pose.r);
+  pose.t[0] = float(t.transform.translation.x);
+  pose.t[1] = float(t.transform.translation.y);
+  pose.t[2] = float(t.transform.translation.z);
+  return true;
+}
+
+/**
+ * @brief Casts every source's pending cloud into the measurement grid, each
+ * from its own sensor's origin, then runs the rest of a frame once for all
+ * of them. Periods without a new cloud are skipped, as in single-source
+ * mode.
+ */
+void StaticOccupancyNode::fuseSources()
+{
+  // The clouds are brought to the newest one's time, so none is
+  // extrapolated past what tf has seen.
+  const PointCloud2 *newest = nullptr;
+  for (const Source &source : sources)
+  {
+    if (source.pending &&
+        (!newest || rclcpp::Time(source.pending->header.stamp) > rclcpp::Time(newest->header.stamp)))
+      newest = source.pending.get();
+  }
+  if (!newest)
+    return;
+  const rclcpp::Time fusion_time(newest->header.stamp);
+
+  navigator::trace::Span frame_span("static_occupancy.fuse_sources", navigator::trace::flow_id(newest->header.stamp));
+  latency_tracker::StageRecorder::Run latency_run = latency_recorder->start();
+  trace::ScopedStageTimer frame_timer(*profiler, STAGE_FRAME);
+
+  double points = 0;
+  for (Source &source : sources)
+  {
+    source.view.reset();
+    if (!source.pending)
+      continue;
+    latency_run.input(source.topic, source.pending->header.stamp);
+
+    try
+    {
+      source.view.emplace(*source.pending);
+    }
+    catch (const std::invalid_argument &ex)
+    {
+      RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                           "Dropping point cloud from %s: %s", source.topic.c_str(), ex.what());
+      continue;
+    }
+    if (!lookupSensorPose(*source.pending, fusion_time, source.pose))
+      source.view.reset();
+    else
+      points += double(source.pending->width) * source.pending->height;
+  }
+  navigator::trace::counter("static_occupancy.points", points);
+
+  // 1. Move the previous grid with the vehicle
+  {
+    trace::ScopedStageTimer timer(*profiler, STAGE_UPDATE_PREVIOUS);
+    update_previous();
+  }
+
+  // Everything but the tf lookups and the publish itself, which belong to ROS.
+  AllocationScope allocations;
+
+  // 2. Cast every cloud into the measurement grid.
+  {
+    trace::ScopedStageTimer timer(*profiler, STAGE_CREATE_GRID);
+    for (auto &level : level_sources)
+      level.clear();
+
+    for (Source &source : sources)
+    {
+      if (!source.view)
+        continue;
+      add_points_to_the_DST(*source.view, &source.pose, source.hits);
+      for (int k = 0; k < grid->levelCount(); k++)
+      {
+        const float res = grid->level(k).resolution();
+        const RayCaster::Cell origin{int16_t(int(source.pose.t[0] / res)), int16_t(int(source.pose.t[1] / res))};
+        level_sources[k].push_back(RayCaster::Source{origin, &source.hits[k]});
+      }
+    }
+
+    for (int k = 0; k < grid->levelCount(); k++)
+      ray_caster->cast(grid->level(k), level_sources[k], ray_pool.get());
+  }
+
+  for (Source &source : sources)
+  {
+    source.view.reset();
+    source.pending.reset();
+  }
+
+  finishFrame(allocations.count(), frame_span, latency_run);
 }
 
 /**
@@ -77,14 +434,13 @@ void StaticOccupancyNode::pointCloudCb(PointCloud2::SharedPtr msg)
  * 3. Adds occupied space representing the vehicle
  *
  * @param cloud
- * @return pcl::PointCloud<pcl::PointXYZI>
  */
-void StaticOccupancyNode::createOccupancyGrid(pcl::PointCloud<pcl::PointXYZI> &cloud)
+void StaticOccupancyNode::createOccupancyGrid(const PointCloud2View &cloud)
 {
-  // 1. Ray traces towards occupied spaces
-  add_points_to_the_DST(cloud);
+  // 1. Finds the cells hit by the cloud (occupied spaces)
+  add_points_to_the_DST(cloud, nullptr, hits);
 
-  // 2. Ray traces rest of grid to fill with empty space
+  // 2. Ray traces towards the hits and through the rest of the grid to fill it with empty space
   add_free_spaces_to_the_DST();
 
   // 3. Add an ego vehicle mask to the grid.
@@ -92,24 +448,38 @@ void StaticOccupancyNode::createOccupancyGrid(pcl::PointCloud<pcl::PointXYZI> &c
 }
 
 /**
- * @brief Fills and adds points to the DST grid
+ * @brief Collects the grid cells hit by the point cloud
  * It projects the pcl points onto the 2D occupancy grid.
  *
- * @param grid
+ * @param pose If given, the points are moved by it into base_link first
+ * @param level_hits The cells hit in each level
  */
-void StaticOccupancyNode::add_points_to_the_DST(pcl::PointCloud<pcl::PointXYZI> &cloud)
+void StaticOccupancyNode::add_points_to_the_DST(const PointCloud2View &cloud, const SensorPose *pose,
+                                                std::vector<std::vector<RayCaster::Cell>> &level_hits)
 {
+  for (auto &cells : level_hits)
+    cells.clear();
+
   // std::printf("Adding %i points to the DST.\n\n", cloud.size());
+  // Labeled clouds carry the ground too; only their obstacles are hits.
+  const bool labeled = cloud.hasLabel();
+
   for (size_t i = 0; i < cloud.size(); i++)
   {
+    if (labeled && cloud.label(i) != MrfGroundSegmenter::OBSTACLE)
+      continue;
 
-    // Dimensions for X & Y [-64 -> 64 (HALF_SiZE)]
-
-    // Record occupancy value for the corresponding point in the pcl, nearest index
-    int x = (int)(cloud[i].x / res);
-    int y = (int)(cloud[i].y / res);
-
-    float z = cloud[i].z;
+    float px = cloud.x(i);
+    float py = cloud.y(i);
+    float z = cloud.z(i);
+    if (pose)
+    {
+      const float *r = pose->r;
+      const float x = px, y = py, sz = z;
+      px = r[0] * x + r[1] * y + r[2] * sz + pose->t[0];
+      py = r[3] * x + r[4] * y + r[5] * sz + pose->t[1];
+      z = r[6] * x + r[7] * y + r[8] * sz + pose->t[2];
+    }
 
     // Ignores points above a certain height
     if (z * (-1) > 0.5)
@@ -118,190 +488,39 @@ void StaticOccupancyNode::add_points_to_the_DST(pcl::PointCloud<pcl::PointXYZI>
       continue;
     }
 
-    if (x < (-1 * HALF_SIZE) || y < (-1 * HALF_SIZE) || x >= HALF_SIZE || y >= HALF_SIZE)
+    for (int k = 0; k < grid->levelCount(); k++)
     {
-      // std::printf("Point was outside grid boundaries, skipping.\n");
-      continue;
-    }
-
-    int angle;
+      const DstGrid &level = grid->level(k);
+      const int half = level.half();
+      const float res = level.resolution();
 
-    // Angles vector contians which angles from 0 deg to 360 deg have been represented.
-    // It is used to identify free spaces for angles not covered by PC or out of range points.
-    if (cloud[i].y > 0 && cloud[i].x < 0)
-    {
-      angle = 180 - (int)(atan(std::abs(cloud[i].y) / std::abs(cloud[i].x)) * 180.0 / M_PI);
-    }
-    else if (cloud[i].y < 0 && cloud[i].x < 0)
-    {
-      angle = 180 + (int)(atan(std::abs(cloud[i].y) / std::abs(cloud[i].x)) * 180.0 / M_PI);
-    }
-    else if (cloud[i].y < 0 && cloud[i].x > 0)
-    {
-      angle = 360 - (int)(atan(std::abs(cloud[i].y) / std::abs(cloud[i].x)) * 180.0 / M_PI);
-    }
-    else
-    {
-      angle = (int)(atan(std::abs(cloud[i].y) / std::abs(cloud[i].x)) * 180.0 / M_PI);
-    }
+      // Dimensions for X & Y [-half -> half]
 
-    angles[angle] = true;
+      // Record occupancy value for the corresponding point in the pcl, nearest index
+      int x = (int)(px / res);
+      int y = (int)(py / res);
 
-    float slope = (float)(y) / (x);
+      if (x < (-1 * half) || y < (-1 * half) || x >= half || y >= half)
+      {
+        // std::printf("Point was outside grid boundaries, skipping.\n");
+        continue;
+      }
 
-    // ray tracing from origin to point, identifies free space using Bresenhaum's line algo
-    if (slope > 0 && slope <= 1 && x > 0)
-    {
-      ray_tracing_approximation_y_increment(x, y, 1, 1, false);
-    }
-    else if (slope > 1 && x > 0)
-    {
-      ray_tracing_approximation_x_increment(x, y, 1, 1, false);
-    }
-    else if (slope < 0 && slope >= -1 && x > 0)
-    {
-      ray_tracing_approximation_y_increment(x, (-1) * y, 1, -1, false);
-    }
-    else if (slope < -1 && x > 0)
-    {
-      ray_tracing_approximation_x_increment(x, (-1) * y, 1, -1, false);
-    }
-    else if (slope > 1 && x < 0)
-    {
-      ray_tracing_approximation_x_increment((-1) * x, (-1) * y, -1, -1, false);
-    }
-    else if (slope > 0 && slope <= 1 && x < 0)
-    {
-      ray_tracing_approximation_y_increment((-1) * x, (-1) * y, -1, -1, false);
-    }
-    else if (slope < 0 && slope >= -1 && x < 0)
-    {
-      ray_tracing_approximation_y_increment((-1) * x, y, -1, 1, false);
-    }
-    else if (slope < -1 && x < 0)
-    {
-      ray_tracing_approximation_x_increment((-1) * x, y, -1, 1, false);
+      level_hits[k].push_back(RayCaster::Cell{int16_t(x), int16_t(y)});
     }
   }
 }
 
 /**
- * Adds unoccupied spaces to DST using ray tracing
+ * Ray traces free space towards every hit and through every angular bin that
+ * no point fell into, then marks the hits occupied. The rays are precomputed,
+ * and with ray_casting_threads > 1 the sweep is split into sectors that are
+ * traced in parallel (see RayCaster). Each level is cast separately.
  */
 void StaticOccupancyNode::add_free_spaces_to_the_DST()
 {
-  float i = 0.0;
-  float angle = 0.0f;
-
-  // fills free spaces, not efficient?
-  for (unsigned int i = 0; i < 3600; i++)
-  {
-    angle = (i * 0.1f);
-
-    if (angles[(int)(angle)] == false)
-    {
-      int x, y;
-      if (angle > 0.0f && angle <= 45.0f)
-      {
-        x = 64;
-        y = (int)(tan(angle * M_PI / 180.0f) * x);
-      }
-      else if (angle > 45.0f && angle < 90.0f)
-      {
-        y = 64;
-        x = (int)(y / tan(angle * M_PI / 180.0f));
-      }
-      else if (angle > 90.0f && angle <= 135.0f)
-      {
-        y = 64;
-        x = (int)(y / tan((angle - 180.0f) * M_PI / 180.0f));
-      }
-      else if (angle > 135.0f && angle < 180.0f)
-      {
-        x = -64;
-        y = (int)(tan((angle - 180.0) * M_PI / 180.0f) * x);
-      }
-      else if (angle > 180.0f && angle <= 225.0f)
-      {
-        x = -64;
-        y = (int)(tan((angle - 180.0f) * M_PI / 180.0f) * x);
-      }
-      else if (angle > 225.0f && angle < 270.0f)
-      {
-        y = -64;
-        x = (int)(y / tan((angle - 180.0f) * M_PI / 180.0f));
-      }
-      else if (angle > 270.0f && angle <= 315.0f)
-      {
-        y = -64;
-        x = (int)(y / tan((angle - 360.0f) * M_PI / 180.0f));
-      }
-      else if (angle > 315.0f && angle < 360.0f)
-      {
-        x = 64;
-        y = (int)(tan((angle - 360.0f) * M_PI / 180.0f) * x);
-      }
-      else if (angle == 0.0f || angle == 360.0f)
-      {
-        ray_tracing_horizontal(64);
-        continue;
-      }
-      else if (angle == 90.0f)
-      {
-        ray_tracing_vertical(64);
-        continue;
-      }
-      else if (angle == 180.0f)
-      {
-        ray_tracing_horizontal_n(-64);
-        continue;
-      }
-      else if (angle == 270.0f)
-      {
-        ray_tracing_vertical_n(-64);
-        continue;
-      }
-
-      if (x >= -64 && y >= -64 && x <= 64 && y <= 64)
-      {
-        float slope = (float)(y) / (x);
-
-        if (slope > 0 && slope <= 1 && x > 0)
-        {
-          ray_tracing_approximation_y_increment(x, y, 1, 1, true);
-        }
-        else if (slope > 1 && x > 0)
-        {
-          ray_tracing_approximation_x_increment(x, y, 1, 1, true);
-        }
-        else if (slope < 0 && slope >= -1 && x > 0)
-        {
-          ray_tracing_approximation_y_increment(x, (-1) * y, 1, -1, true);
-        }
-        else if (slope < -1 && x > 0)
-        {
-          ray_tracing_approximation_x_increment(x, (-1) * y, 1, -1, true);
-        }
-        else if (slope > 1 && x < 0)
-        {
-          ray_tracing_approximation_x_increment((-1) * x, (-1) * y, -1, -1, true);
-        }
-        else if (slope > 0 && slope <= 1 && x < 0)
-        {
-          ray_tracing_approximation_y_increment((-1) * x, (-1) * y, -1, -1, true);
-        }
-        else if (slope < 0 && slope >= -1 && x < 0)
-        {
-          ray_tracing_approximation_y_increment((-1) * x, y, -1, 1, true);
-        }
-        else if (slope < -1 && x < 0)
-        {
-          ray_tracing_approximation_x_increment((-1) * x, y, -1, 1, true);
-        }
-      }
-    }
-    angles[(int)(angle)] = false;
-  }
+  for (int k = 0; k < grid->levelCount(); k++)
+    ray_caster->cast(grid->level(k), hits[k], ray_pool.get());
 }
 
 /**
@@ -310,374 +529,214 @@ void StaticOccupancyNode::add_free_spaces_to_the_DST()
  */
 void StaticOccupancyNode::addEgoMask()
 {
+  DstGrid &finest = grid->finest();
+  const int c = finest.center();
+
   // Vehicle shape.
-  for (unsigned int i = 60; i < 68; i++)
+  for (int i = c - 4; i < c + 4; i++)
   {
-    for (unsigned int j = 62; j < 67; j++)
+    for (int j = c - 2; j < c + 3; j++)
     {
-      measured_occ[i][j] = 1.0;
-      measured_free[i][j] = 0.0;
+      finest.measOcc(i, j) = dst::toMass<Mass>(1.0f);
+      finest.measFree(i, j) = Mass(0);
     }
   }
 }
 
 //-------------HELPERS----------------------------//
-void StaticOccupancyNode::publishOccupancyGrid()
+/**
+ * @brief Writes the grid into the preallocated outgoing messages.
+ *
+ * Cells are written by index into buffers sized in the constructor, so this
+ * does not allocate.
+ */
+void StaticOccupancyNode::fillMessages()
 {
+  occupancy_msg.header.stamp = this->clock.clock;
 
-  //--Occupancy Grid--//
-  OccupancyGrid msg;
-
-  msg.header.stamp = this->clock.clock;
-  msg.header.frame_id = "base_link"; // TODO: Make sure the frame is the correct one.
-  msg.info.resolution = res;
-  msg.info.width = GRID_SIZE;
-  msg.info.height = GRID_SIZE;
-  msg.info.origin.position.z = 0.2;
-  msg.info.origin.position.x = -64.0 * (1. / 3.);
-  msg.info.origin.position.y = -64.0 * (1. / 3.);
-  //-----------------//
-
-  //--Masses--//
-  Masses masses_msg;
-  masses_msg.occ.clear();
-  masses_msg.free.clear();
-  masses_msg.width = GRID_SIZE;
-  masses_msg.height = GRID_SIZE;
-  //----------//
-
-  auto probabilities = getGridCellProbabilities();
-
-  for (int i = 0; i < GRID_SIZE; i++)
+  if (grid->levelCount() > 1)
   {
-    for (int j = 0; j < GRID_SIZE; j++)
-    {
-      msg.data.push_back(100 * probabilities.at(j).at(i));
-      masses_msg.occ.push_back(updated_occ[i][j]);
-      masses_msg.free.push_back(updated_free[i][j]);
-    }
+    fillResampledMessages();
+    return;
   }
-  occupancy_grid_pub->publish(msg);
-  masses_pub->publish(masses_msg);
-}
 
-void StaticOccupancyNode::update_previous()
-{
-  for (unsigned int i = 0; i < GRID_SIZE; i++)
+  const DstGrid &g = grid->finest();
+  int8_t *data = occupancy_msg.data.data();
+
+  if (compact_encoder)
   {
-    for (unsigned int j = 0; j < GRID_SIZE; j++)
-    {
-      previous_free[i][j] = updated_free[i][j];
-      previous_occ[i][j] = updated_occ[i][j];
-    }
+    dispatchGridSize(g.size(), [&](auto n)
+                     {
+      for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+          data[i * n + j] = int8_t(100 * dst::massValue(g.prob()[g.index(j, i)])); });
+
+    compact_msg.header = occupancy_msg.header;
+    compact_encoder->encode(g, compact_msg);
+    return;
   }
 
-  //--------CODE FOR VARIABLE INPUT GRID SIZE BELOW----------//
-
-  // float xstart = -1;
-  // float ystart = -1;
-  // float xend = -1;
-  // float yend = -1;
-
-  // change_x = 0.0; // TODO: Remove or fix the "change" variables.
-  // change_y = 0.0;
-
-  // x_new_low = change_x - 64 * res;
-  // x_new_high = change_x + 64 * res;
-  // y_new_low = change_y - 64 * res;
-  // y_new_high = change_y + 64 * res;
-
-  // if (initialization_phase == false)
-  // {
-
-  //   if ((x_new_low >= x_old_low) && (x_old_high >= x_new_low))
-  //   {
-  //     xstart = x_new_low;
-  //     xend = x_old_high;    }
-
-  //   if ((y_new_low >= y_old_low) && (y_old_high >= y_new_low))
-  //   {
-  //     ystart = y_new_low;
-  //     yend = y_old_high;    }
-
-  //   if ((x_new_low < x_old_low) && (x_new_high >= x_old_low))
-  //   {
-  //     xstart = x_old_low;
-  //     xend = x_new_high;    }
-
-  //   if ((y_new_low < y_old_low) && (y_new_high >= y_old_low))
-  //   {
-  //     ystart = y_old_low;
-  //     yend = y_new_high;    }
-
-  //   if ((xstart != -1) && (ystart != -1))
-  //   {
-
-  //     /**
-  //      * NL = New Low, OH = Old High
-  //      */
-  //     //x
-  //     int index_xNL = find_nearest(GRID_SIZE, xstart, x_new_low, x_new_high, res);
-  //     int index_xNH = find_nearest(GRID_SIZE, xend, x_new_low, x_new_high, res);
-  //     int index_xOL = find_nearest(GRID_SIZE, xstart, x_old_low, x_old_high, res);
-  //     int index_xOH = find_nearest(GRID_SIZE, xend, x_old_low, x_old_high, res);
-  //     //y
-  //     int index_yNL = find_nearest(GRID_SIZE, ystart, y_new_low, y_new_high, res);
-  //     int index_yNH = find_nearest(GRID_SIZE, yend, y_new_low, y_new_high, res);
-  //     int index_yOL = find_nearest(GRID_SIZE, ystart, y_old_low, y_old_high, res);
-  //     int index_yOH = find_nearest(GRID_SIZE, yend, y_old_low, y_old_high, res);
-
-  //     printf("index_xNL: %i, index_xNH: %i, index_xOL: %i, index_xOH: %i\n\n", index_xNL, index_xNH, index_xOL, index_xOH);
-
-  //     for (unsigned int i = 0; i < index_xOH - index_xOL + 1; i++)
-  //     {
-  //       for (unsigned int j = 0; j < index_yOH - index_yOL + 1; j++)
-  //       {
-  //         previous_free[index_xNL + i][index_yNL + j] = updated_free[index_xOL + i][index_yOL + j];
-  //         previous_occ[index_xNL + i][index_yNL + j] = updated_occ[index_xOL + i][index_yOL + j];
-  //       }
-  //     }
-  //   }
-  // }
-
-  // initialization_phase = false;
-  // x_old_low = x_new_low;
-  // x_old_high = x_new_high;
-  // y_old_low = y_new_low;
-  // y_old_high = y_new_high;
-
-  //----------END OF CODE------------//
+  float *occ = masses_msg.occ.data();
+  float *free = masses_msg.free.data();
+  dispatchGridSize(g.size(), [&](auto n)
+                   {
+    for (int i = 0; i < n; i++)
+    {
+      for (int j = 0; j < n; j++)
+      {
+        data[i * n + j] = int8_t(100 * dst::massValue(g.prob()[g.index(j, i)]));
+        occ[i * n + j] = dst::massValue(g.occ()[g.index(i, j)]);
+        free[i * n + j] = dst::massValue(g.free()[g.index(i, j)]);
+      }
+    } });
 }
 
 /**
- * @brief: Updates current grids with previous grid values plus a decay
+ * @brief Resamples the grid levels into the outgoing messages, reading each
+ * output cell from the finest level that covers it. Only the published cells
+ * are computed, so the output can be as fine or large as needed.
  */
-void StaticOccupancyNode::mass_update()
+void StaticOccupancyNode::fillResampledMessages()
 {
-  for (unsigned int i = 0; i < GRID_SIZE; i++)
+  const int n = output_size;
+  const float res = output_resolution;
+  int8_t *data = occupancy_msg.data.data();
+  float *occ = masses_msg.occ.data();
+  float *free = masses_msg.free.data();
+
+  for (int i = 0; i < n; i++)
   {
-    for (unsigned int j = 0; j < GRID_SIZE; j++)
+    const float a = (i - n / 2 + 0.5f) * res;
+    for (int j = 0; j < n; j++)
     {
-      updated_occP[i][j] = std::min(decay_factor * previous_occ[i][j], 1.0f - previous_free[i][j]);
-      updated_freeP[i][j] = std::min(decay_factor * previous_free[i][j], 1.0f - previous_occ[i][j]);
+      const float b = (j - n / 2 + 0.5f) * res;
+      // The occupancy grid is row-major in y, the masses in x.
+      data[i * n + j] = int8_t(100 * grid->sample(b, a).prob);
+      MultiResolutionGrid::Sample cell = grid->sample(a, b);
+      occ[i * n + j] = cell.occ;
+      free[i * n + j] = cell.free;
     }
   }
-  // Combine measurement and prediction to form posterior occupied and free masses.
-  update_of();
 }
 
-// updates probabilities using a bayes filter. Takes into account measured probabilities and predicted probability values.
-void StaticOccupancyNode::update_of()
+void StaticOccupancyNode::publishOccupancyGrid()
 {
-  for (unsigned int i = 0; i < GRID_SIZE; i++)
-  {
-    for (unsigned int j = 0; j < GRID_SIZE; j++)
-    {
-      // probability of cell being unknown
-      float unknown_pred = 1.0 - updated_freeP[i][j] - updated_occP[i][j];
-
-      // probabilityy of measured cell being unknown
-      float measured_cell_unknown = 1.0 - measured_free[i][j] - measured_occ[i][j];
-
-      // normalizing factor, ensures probabilities for occupancy/free add up to 1
-      float k_value = updated_freeP[i][j] * measured_occ[i][j] + updated_occP[i][j] * measured_free[i][j];
+  occupancy_grid_pub->publish(occupancy_msg);
 
-      updated_occ[i][j] = (updated_occP[i][j] * measured_cell_unknown + unknown_pred * measured_occ[i][j] + updated_occP[i][j] * measured_occ[i][j]) / (1.0f - k_value);
-      updated_free[i][j] = (updated_freeP[i][j] * measured_cell_unknown + unknown_pred * measured_free[i][j] + updated_freeP[i][j] * measured_free[i][j]) / (1.0f - k_value);
-    }
-  }
+  if (compact_encoder)
+    compact_masses_pub->publish(compact_msg);
+  else
+    masses_pub->publish(masses_msg);
 }
 
 /**
- * @brief Gets the average of the updated occupancy and updated free values and adds to a cell_probabilities
- *
- * @return Returns a vector of grid cell probabilities used to fill the OccupancyGrid message
+ * @brief Publishes the latency of each stage over the last second, plus the
+ * worst case since startup, as one DiagnosticStatus per stage.
  */
-std::vector<std::vector<float>> StaticOccupancyNode::getGridCellProbabilities()
+void StaticOccupancyNode::publishDiagnostics()
 {
-  std::vector<std::vector<float>> cell_probabilities;
-  for (unsigned int i = 0; i < GRID_SIZE; i++)
-  {
-    std::vector<float> row;
-    for (unsigned int j = 0; j < GRID_SIZE; j++)
-    {
-      float probability = (0.5 * updated_occ[i][j] + 0.5 * (1.0 - updated_free[i][j]));
-      row.push_back(probability);
-    }
-    cell_probabilities.push_back(row);
-  }
-
-  return cell_probabilities;
-}
-
-int StaticOccupancyNode::find_nearest(int num, float value, float min, float max, float res)
-{
-  int index = std::floor(num * (value - min + res / 2.) / (max - min + res));
-  return index;
-}
-//------------------------------------------------//
-
-//-------------RAY TRACING HELPERS----------------//
-void StaticOccupancyNode::ray_tracing_approximation_y_increment(int x2, int y2, int flip_x, int flip_y, bool inclusive)
-{
-  int x1 = 0, y1 = 0;
+  DiagnosticArray msg;
+  msg.header.stamp = this->clock.clock;
 
-  int slope = 2 * (y2 - y1);
-  int slope_error = slope - (x2 - x1);
-  int x_sample, y_sample;
-  for (int x = x1, y = y1; x < x2; x++)
+  auto value = [](const std::string &key, double v)
   {
-    // checks if the point is occupied
-    if (measured_occ[flip_x * x + 64][flip_y * y + 64] == meas_mass)
-    {
-      break;
-    }
-
-    measured_free[flip_x * x + 64][flip_y * y + 64] = meas_mass;
-
-    slope_error += slope;
-    if (slope_error >= 0)
-    {
-      y += 1;
-      slope_error -= 2 * (x2 - x1);
-    }
-  }
+    diagnostic_msgs::msg::KeyValue kv;
+    kv.key = key;
+    kv.value = std::to_string(v);
+    return kv;
+  };
 
-  // if the point ray-traced to is occupied
-  if (inclusive == false)
+  for (int stage = 0; stage < profiler->stage_count(); stage++)
   {
-    int x_coordinate = flip_x * x2 + 64;
-    int y_coordinate = flip_y * y2 + 64;
-    measured_occ[x_coordinate][y_coordinate] = meas_mass;
-    measured_free[x_coordinate][y_coordinate] = 0.0;
+    trace::LatencyHistogram::Snapshot now = profiler->histogram(stage).snapshot();
+    trace::LatencyHistogram::Snapshot window = now - last_snapshots[stage];
+    last_snapshots[stage] = now;
+
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.name = std::string(this->get_name()) + ": " + profiler->stage_name(stage);
+    status.values.push_back(value("count", double(window.count)));
+    status.values.push_back(value("mean_ms", window.mean_ms()));
+    status.values.push_back(value("p50_ms", window.quantile_ms(0.5)));
+    status.values.push_back(value("p90_ms", window.quantile_ms(0.9)));
+    status.values.push_back(value("p99_ms", window.quantile_ms(0.99)));
+    status.values.push_back(value("max_ms_since_start", window.max_ms()));
+    msg.status.push_back(status);
   }
+
+  diagnostics_pub->publish(msg);
 }
 
-void StaticOccupancyNode::ray_tracing_approximation_x_increment(int x2, int y2, int flip_x, int flip_y, bool inclusive)
+/**
+ * @brief Moves the previous masses with the vehicle.
+ *
+ * The posterior masses are updated in place and double as the prior, so
+ * nothing is copied here. Instead, the vehicle's displacement since the last
+ * frame is rotated into base_link and the grid is scrolled by whole cells,
+ * which only clears the newly exposed rows and columns. Sub-cell motion is
+ * carried over to the next frame. Rotation is not compensated.
+ */
+void StaticOccupancyNode::update_previous()
 {
-  int x1 = 0, y1 = 0;
+  if (!scroll_with_vehicle)
+    return;
 
-  int slope = 2 * (x2 - x1);
-  int slope_error = slope - (y2 - y1);
-  int x_sample, y_sample;
-  for (int x = x1, y = y1; y < y2; y++)
+  geometry_msgs::msg::TransformStamped t;
+  try
   {
-    // checks if the point is occupied
-    if (measured_occ[flip_x * x + 64][flip_y * y + 64] == meas_mass)
-    {
-      break;
-    }
-
-    measured_free[flip_x * x + 64][flip_y * y + 64] = meas_mass;
-
-    slope_error += slope;
-    if (slope_error >= 0)
-    {
-      x += 1;
-      slope_error -= 2 * (y2 - y1);
-    }
+    t = tf_buffer->lookupTransform(map_frame, "base_link", tf2::TimePointZero);
   }
-
-  // if the point ray-traced to is occupied
-  if (inclusive == false)
+  catch (const tf2::TransformException &ex)
   {
-    int x_coordinate = flip_x * x2 + 64;
-    int y_coordinate = flip_y * y2 + 64;
-    measured_occ[x_coordinate][y_coordinate] = meas_mass;
-    measured_free[x_coordinate][y_coordinate] = 0.0;
+    RCLCPP_INFO_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                         "Could not get base_link->%s tf: %s. The grid will not follow the vehicle.",
+                         map_frame.c_str(), ex.what());
+    return;
   }
-}
 
-// VERTICLE +
-void StaticOccupancyNode::ray_tracing_vertical(int x2)
-{
-  int x1 = 0;
-  int y1 = 0;
-  x2 = x2 - 1;
+  const double x = t.transform.translation.x;
+  const double y = t.transform.translation.y;
 
-  for (int x = x1; x <= x2; x++)
+  if (!has_previous_pose)
   {
-    // checks if the point is occupied
-    if (measured_occ[64][x + 64] == meas_mass)
-    {
-      printf("BROKE! VERTICAL + \n\n");
-      break;
-    }
-
-    measured_free[x + 64][64] = meas_mass;
+    prev_vehicle_x = x;
+    prev_vehicle_y = y;
+    has_previous_pose = true;
+    return;
   }
 
-  measured_free[x2 + 64][64] = 0.0;
-}
+  // Yaw of base_link in the map frame.
+  const auto &q = t.transform.rotation;
+  const double yaw = std::atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z));
 
-// VERTICLE -
-void StaticOccupancyNode::ray_tracing_vertical_n(int x1)
-{
-  int x2 = 0;
-  int y2 = 0;
-  x1 = x1 + 1;
+  // Displacement in the map frame, rotated into the current base_link frame.
+  const double dx_map = x - prev_vehicle_x;
+  const double dy_map = y - prev_vehicle_y;
+  prev_vehicle_x = x;
+  prev_vehicle_y = y;
 
-  for (int x = x1; x <= x2; x++)
-  {
-    if (measured_occ[64][x + 64] == meas_mass)
-    {
-      printf("BROKE! VERTICAL - \n\n");
-      break;
-    }
-
-    measured_free[x + 64][64] = meas_mass;
-  }
-
-  measured_free[x2 + 64][64] = 0.0;
+  grid->scroll(std::cos(yaw) * dx_map + std::sin(yaw) * dy_map,
+               -std::sin(yaw) * dx_map + std::cos(yaw) * dy_map);
 }
 
-// HORIZONTAL +
-void StaticOccupancyNode::ray_tracing_horizontal(int y2)
+/**
+ * @brief: Updates current grids with previous grid values plus a decay, then
+ * combines them with the measurement and computes cell probabilities.
+ *
+ * Prediction, combination and probability conversion are fused into a single
+ * vectorized pass over the grid (see DstKernel.hpp).
+ */
+void StaticOccupancyNode::mass_update()
 {
-  int x1 = 0;
-  int y1 = 0;
-  y2 = y2 - 1;
-
-  for (int y = y1; y <= y2; y++)
-  {
-    if (measured_occ[64][y + 64] == meas_mass)
-    {
-      printf("BROKE! HORIZONTAL + \n\n");
-      break;
-    }
-    measured_free[64][y + 64] = meas_mass;
-  }
+  grid->update(decay_factor);
 }
 
-// HORIZONTAL -
-void StaticOccupancyNode::ray_tracing_horizontal_n(int y1)
-{
-  int x1 = 0;
-  int y2 = 0;
-  y1 = y1 + 1;
-
-  for (int y = y1; y <= y2; y++)
-  {
-    if (
-        measured_occ[64][y + 64] == meas_mass)
-    {
-      printf("BROKE! HORIZONTAL - \n\n");
-      break;
-    }
-    measured_free[64][y + 64] = meas_mass;
-  }
-
-  measured_free[64][y2 + 64] = 0.0;
-}
+//------------------------------------------------//
 
 void StaticOccupancyNode::clear()
 {
-  for (unsigned int i = 0; i < GRID_SIZE; i++)
-  {
-    for (unsigned int j = 0; j < GRID_SIZE; j++)
-    {
-      measured_occ[i][j] = 0.0;
-      measured_free[i][j] = 0.0;
-    }
-  }
+  grid->clearMeasurement();
 }
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(navigator::perception::StaticOccupancyNode)
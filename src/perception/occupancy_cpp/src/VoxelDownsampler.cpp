@@ -0,0 +1,118 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  VoxelDownsampler.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+#include "occupancy_cpp/VoxelDownsampler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+using namespace navigator::perception;
+
+namespace
+{
+  constexpr int KEY_BITS = 18;
+  constexpr uint64_t KEY_MASK = (uint64_t(1) << KEY_BITS) - 1;
+
+  // Slots hold the key in the low 54 bits and the stamp above it.
+  constexpr int STAMP_SHIFT = 3 * KEY_BITS;
+  constexpr uint64_t STAMP_LIMIT = uint64_t(1) << (64 - STAMP_SHIFT);
+
+  // Points farther than this many voxels out are dropped.
+  constexpr float MAX_VOXEL = 1e9f;
+
+  // Pack the voxel coordinates into one key, 18 bits per axis.
+  uint64_t voxelKey(int64_t x, int64_t y, int64_t z)
+  {
+    return (uint64_t(x) & KEY_MASK) | (uint64_t(y) & KEY_MASK) << KEY_BITS |
+           (uint64_t(z) & KEY_MASK) << (2 * KEY_BITS);
+  }
+
+  // std::floor is a library call without SSE4.1; truncate and correct instead.
+  int64_t floorToInt(float v)
+  {
+    const int64_t t = int64_t(v);
+    return t - (v < float(t));
+  }
+
+  // Fibonacci hashing spreads the structured keys over the table.
+  std::size_t hashKey(uint64_t key)
+  {
+    key ^= key >> 29;
+    return std::size_t((key * 0x9e3779b97f4a7c15ull) >> 20);
+  }
+}
+
+VoxelDownsampler::VoxelDownsampler(float leaf_size)
+{
+  setLeafSize(leaf_size);
+}
+
+void VoxelDownsampler::setLeafSize(float leaf_size)
+{
+  if (!(leaf_size > 0.0f))
+    throw std::invalid_argument("Voxel leaf size must be positive");
+
+  leaf_size_ = leaf_size;
+  inv_leaf_size_ = 1.0f / leaf_size;
+}
+
+void VoxelDownsampler::reserve(std::size_t points)
+{
+  const std::size_t slots = std::bit_ceil(std::max<std::size_t>(2 * points, 1024));
+  if (slots <= slots_.size())
+    return;
+
+  slots_.assign(slots, 0);
+  stamp_ = 0;
+  mask_ = slots - 1;
+}
+
+void VoxelDownsampler::downsample(const PointCloud2View &cloud, std::vector<uint32_t> &kept)
+{
+  kept.clear();
+  reserve(cloud.size());
+
+  // A new stamp invalidates every slot. Clear the stamps only when it wraps.
+  if (++stamp_ == STAMP_LIMIT)
+  {
+    std::fill(slots_.begin(), slots_.end(), 0);
+    stamp_ = 1;
+  }
+  const uint64_t stamp = stamp_ << STAMP_SHIFT;
+
+  for (std::size_t i = 0; i < cloud.size(); i++)
+  {
+    const float x = cloud.x(i) * inv_leaf_size_;
+    const float y = cloud.y(i) * inv_leaf_size_;
+    const float z = cloud.z(i) * inv_leaf_size_;
+    // Also drops NaN and infinite points, and keeps the casts below defined.
+    if (!(std::abs(x) < MAX_VOXEL && std::abs(y) < MAX_VOXEL && std::abs(z) < MAX_VOXEL))
+      continue;
+
+    const uint64_t key = voxelKey(floorToInt(x), floorToInt(y), floorToInt(z));
+
+    // Linear probing. The load factor is at most 1/2, so an empty slot is
+    // always found.
+    const uint64_t entry = stamp | key;
+    for (std::size_t s = hashKey(key) & mask_;; s = (s + 1) & mask_)
+    {
+      uint64_t &slot = slots_[s];
+      if (slot == entry)
+        break;
+      if ((slot >> STAMP_SHIFT) != stamp_)
+      {
+        slot = entry;
+        kept.push_back(uint32_t(i));
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,101 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  test_dst_grid.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Test that scrolling the DST grid with the vehicle keeps the world still.
+
+#include <gtest/gtest.h> // Testing framework
+
+#include "occupancy_cpp/DstGrid.hpp"
+
+using namespace navigator::perception;
+
+namespace
+{
+  constexpr float MEAS_MASS = 0.95;
+  constexpr float DECAY_FACTOR = 0.9;
+
+  // One frame as the node runs it: scroll, cast, update, clear. The
+  // obstacle is at (world_x, world_y) cells and the vehicle at vehicle_x.
+  void frame(DstGrid &grid, int dx, int vehicle_x, int world_x, int world_y)
+  {
+    grid.scroll(dx, 0);
+    const int x = grid.center() + world_x - vehicle_x;
+    const int y = grid.center() + world_y;
+    grid.measOcc(x, y) = dst::toMass<Mass>(MEAS_MASS);
+    grid.measFree(x - 1, y) = dst::toMass<Mass>(MEAS_MASS);
+    grid.update(DECAY_FACTOR);
+    grid.clearMeasurement();
+  }
+}
+
+TEST(DstGrid, StaticObstacleStaysPutWhileScrolling)
+{
+  DstGrid still(64, 1.0f);
+  DstGrid moving(64, 1.0f);
+  for (int f = 0; f < 8; f++)
+  {
+    frame(still, 0, 0, 10, 5);
+    frame(moving, f ? 1 : 0, f, 10, 5);
+  }
+
+  // The moving grid saw the obstacle in the same world cell every frame, so
+  // it believes in it as much as a grid that stood still
+  const int x = moving.center() + 10 - 7;
+  const int y = moving.center() + 5;
+  const float expected = dst::massValue(still.occ(still.center() + 10, y));
+  EXPECT_GT(expected, MEAS_MASS);
+  EXPECT_NEAR(dst::massValue(moving.occ(x, y)), expected, 1e-3f);
+  EXPECT_NEAR(dst::massValue(moving.free(x - 1, y)), dst::massValue(still.free(still.center() + 9, y)), 1e-3f);
+
+  // And left no trail behind it
+  EXPECT_EQ(dst::massValue(moving.occ(x + 1, y)), 0.0f);
+  EXPECT_EQ(dst::massValue(moving.occ(x - 1, y)), 0.0f);
+}
+
+TEST(DstGrid, ScrollClearsEveryPlaneInNewCells)
+{
+  DstGrid grid(8, 1.0f);
+  for (int x = 0; x < grid.size(); x++)
+    for (int y = 0; y < grid.size(); y++)
+    {
+      grid.measOcc(x, y) = dst::toMass<Mass>(MEAS_MASS);
+      grid.measFree(x, y) = dst::toMass<Mass>(0.5f);
+      grid.occ(x, y) = dst::toMass<Mass>(0.5f);
+    }
+
+  grid.scroll(2, -1);
+  for (int x = 0; x < grid.size(); x++)
+    for (int y = 0; y < grid.size(); y++)
+    {
+      // Rows 6 and 7 and column 0 came into view
+      const bool fresh = x >= 6 || y == 0;
+      EXPECT_EQ(dst::massValue(grid.measOcc(x, y)) == 0.0f, fresh) << x << ", " << y;
+      EXPECT_EQ(dst::massValue(grid.measFree(x, y)) == 0.0f, fresh) << x << ", " << y;
+      EXPECT_EQ(dst::massValue(grid.occ(x, y)) == 0.0f, fresh) << x << ", " << y;
+    }
+}
+
+TEST(DstGrid, RevisionChangesOnScrollAndReset)
+{
+  DstGrid grid(8, 1.0f);
+  const uint64_t initial = grid.revision();
+
+  grid.update(DECAY_FACTOR);
+  grid.scroll(0, 0);
+  EXPECT_EQ(grid.revision(), initial);
+
+  grid.scroll(1, -2);
+  EXPECT_GT(grid.revision(), initial);
+  EXPECT_EQ(grid.offsetX(), 1);
+  EXPECT_EQ(grid.offsetY(), 6);
+
+  const uint64_t scrolled = grid.revision();
+  grid.reset();
+  EXPECT_GT(grid.revision(), scrolled);
+}
@@ -0,0 +1,100 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  test_dst_kernel.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Test the fixed-point DST update against the float one.
+
+#include <gtest/gtest.h> // Testing framework
+#include <algorithm>
+#include <cmath>         // std::abs
+#include <random>        // std::mt19937
+#include <vector>
+
+#include "occupancy_cpp/DstKernel.hpp"
+
+using namespace navigator::perception;
+
+namespace
+{
+  constexpr float MEAS_MASS = 0.95;
+  constexpr float DECAY_FACTOR = 0.9;
+
+  // A measurement like the ray caster's: occupied, free or unknown cells.
+  void randomMeasurement(std::mt19937 &rng, std::vector<float> &occ, std::vector<float> &free)
+  {
+    std::uniform_int_distribution<int> kind(0, 2);
+    for (std::size_t i = 0; i < occ.size(); i++)
+    {
+      int k = kind(rng);
+      occ[i] = k == 0 ? MEAS_MASS : 0.0f;
+      free[i] = k == 1 ? MEAS_MASS : 0.0f;
+    }
+  }
+
+  std::vector<uint16_t> toFixed(const std::vector<float> &plane)
+  {
+    std::vector<uint16_t> fixed(plane.size());
+    std::transform(plane.begin(), plane.end(), fixed.begin(), dst::toMass<uint16_t>);
+    return fixed;
+  }
+}
+
+TEST(DstKernel, FixedMassesRoundAndSaturate)
+{
+  EXPECT_EQ(dst::toMass<uint16_t>(0.0f), 0);
+  EXPECT_EQ(dst::toMass<uint16_t>(1.0f), 65535);
+  EXPECT_EQ(dst::toMass<uint16_t>(-0.25f), 0);
+  EXPECT_EQ(dst::toMass<uint16_t>(1.25f), 65535);
+  EXPECT_NEAR(dst::massValue(dst::toMass<uint16_t>(MEAS_MASS)), MEAS_MASS, 1e-5f);
+}
+
+TEST(DstKernel, FixedVectorPathMatchesScalar)
+{
+  // Not a multiple of the vector width, so the tail is covered too
+  const std::size_t n = 16 * 40 + 7;
+  std::mt19937 rng(3);
+  std::vector<float> meas_occ(n), meas_free(n);
+
+  std::vector<uint16_t> occ(n, 0), free(n, 0), prob(n, 0);
+  std::vector<uint16_t> ref_occ(n, 0), ref_free(n, 0), ref_prob(n, 0);
+  for (int frame = 0; frame < 10; frame++)
+  {
+    randomMeasurement(rng, meas_occ, meas_free);
+    std::vector<uint16_t> mo = toFixed(meas_occ), mf = toFixed(meas_free);
+    dst::fusedUpdate(mo.data(), mf.data(), occ.data(), free.data(), prob.data(), n, DECAY_FACTOR);
+    dst::fusedUpdateScalar(mo.data(), mf.data(), ref_occ.data(), ref_free.data(), ref_prob.data(), n, DECAY_FACTOR);
+    ASSERT_EQ(occ, ref_occ) << "frame " << frame << ", backend " << dst::fusedUpdateBackend();
+    ASSERT_EQ(free, ref_free) << "frame " << frame;
+    ASSERT_EQ(prob, ref_prob) << "frame " << frame;
+  }
+}
+
+TEST(DstKernel, FixedMassesTrackFloat)
+{
+  const std::size_t n = 128 * 128;
+  std::mt19937 rng(7);
+  std::vector<float> meas_occ(n), meas_free(n);
+
+  std::vector<float> occ(n, 0.0f), free(n, 0.0f), prob(n, 0.0f);
+  std::vector<uint16_t> fixed_occ(n, 0), fixed_free(n, 0), fixed_prob(n, 0);
+  // Enough frames for the error of the decay to build up where it will
+  for (int frame = 0; frame < 50; frame++)
+  {
+    randomMeasurement(rng, meas_occ, meas_free);
+    std::vector<uint16_t> mo = toFixed(meas_occ), mf = toFixed(meas_free);
+    dst::fusedUpdate(meas_occ.data(), meas_free.data(), occ.data(), free.data(), prob.data(), n, DECAY_FACTOR);
+    dst::fusedUpdate(mo.data(), mf.data(), fixed_occ.data(), fixed_free.data(), fixed_prob.data(), n, DECAY_FACTOR);
+  }
+
+  for (std::size_t i = 0; i < n; i++)
+  {
+    ASSERT_NEAR(occ[i], dst::massValue(fixed_occ[i]), 1e-3f) << "at cell " << i;
+    ASSERT_NEAR(free[i], dst::massValue(fixed_free[i]), 1e-3f) << "at cell " << i;
+    ASSERT_NEAR(prob[i], dst::massValue(fixed_prob[i]), 1e-3f) << "at cell " << i;
+  }
+}
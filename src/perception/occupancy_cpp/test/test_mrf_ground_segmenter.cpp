@@ -0,0 +1,337 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  test_mrf_ground_segmenter.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Test the MRF ground segmentation (isolated from the ROS node).
+
+#include <gtest/gtest.h> // Testing framework
+#include <algorithm>     // std::find
+#include <cmath>         // std::cos
+#include <cstring>       // std::memcpy
+#include <random>        // std::mt19937
+#include <vector>
+
+#include "occupancy_cpp/MrfGroundSegmenter.hpp"
+
+using namespace navigator::perception;
+using sensor_msgs::msg::PointCloud2;
+using sensor_msgs::msg::PointField;
+
+namespace
+{
+  // A sloped, slightly noisy ground plane with obstacles of random heights
+  // scattered over it, some points out of range.
+  PointCloud2 makeScene(int points, unsigned seed)
+  {
+    PointCloud2 msg;
+    msg.height = 1;
+    msg.width = points;
+    msg.point_step = 16;
+    msg.row_step = msg.point_step * points;
+
+    const char *names[] = {"x", "y", "z", "intensity"};
+    for (int i = 0; i < 4; i++)
+    {
+      PointField field;
+      field.name = names[i];
+      field.offset = 4 * i;
+      field.datatype = PointField::FLOAT32;
+      field.count = 1;
+      msg.fields.push_back(field);
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-90.0f, 90.0f);
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+    std::uniform_real_distribution<float> height(0.0f, 3.0f);
+
+    msg.data.resize(msg.row_step);
+    for (int i = 0; i < points; i++)
+    {
+      float p[4];
+      p[0] = position(rng);
+      p[1] = position(rng);
+      const float ground = -1.8f + 0.01f * p[0];
+      p[2] = rng() % 5 == 0 ? ground + height(rng) : ground + noise(rng);
+      p[3] = 1.0f;
+      std::memcpy(&msg.data[i * msg.point_step], p, sizeof(p));
+    }
+
+    return msg;
+  }
+}
+
+// The parallel mode must reproduce the serial output exactly, order included.
+TEST(TestMrfGroundSegmenter, parallel_matches_serial)
+{
+  MrfGroundSegmenter serial;
+  MrfGroundSegmenter parallel(MrfGroundSegmenter::Settings(), 4);
+
+  for (unsigned seed = 1; seed <= 4; seed++)
+  {
+    PointCloud2 msg = makeScene(80000, seed);
+    PointCloud2View cloud(msg);
+
+    std::vector<int> expected, actual;
+    serial.segment(cloud, expected);
+    parallel.segment(cloud, actual);
+
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(expected, actual) << "seed " << seed;
+  }
+}
+
+// Reusing a segmenter must not leak state from one scan into the next.
+TEST(TestMrfGroundSegmenter, repeated_scans_are_independent)
+{
+  MrfGroundSegmenter segmenter(MrfGroundSegmenter::Settings(), 3);
+  PointCloud2 first = makeScene(50000, 7);
+  PointCloud2 second = makeScene(20000, 8);
+
+  std::vector<int> before, between, after;
+  segmenter.segment(PointCloud2View(first), before);
+  segmenter.segment(PointCloud2View(second), between);
+  segmenter.segment(PointCloud2View(first), after);
+
+  ASSERT_EQ(before, after);
+}
+
+TEST(TestMrfGroundSegmenter, flat_ground_is_removed)
+{
+  MrfGroundSegmenter segmenter;
+  PointCloud2 msg = makeScene(0, 1);
+
+  // A flat grid of ground points at the sensor's height, plus one pole.
+  std::vector<float> points;
+  for (float x = -20.0f; x <= 20.0f; x += 0.2f)
+    for (float y = -20.0f; y <= 20.0f; y += 0.2f)
+      points.insert(points.end(), {x, y, 0.0f, 1.0f});
+  const int pole_begin = int(points.size() / 4);
+  for (float z = 0.0f; z < 2.0f; z += 0.1f)
+    points.insert(points.end(), {10.0f, 10.0f, z, 1.0f});
+
+  msg.width = uint32_t(points.size() / 4);
+  msg.row_step = msg.point_step * msg.width;
+  msg.data.resize(points.size() * sizeof(float));
+  std::memcpy(msg.data.data(), points.data(), msg.data.size());
+
+  std::vector<int> obstacles;
+  segmenter.segment(PointCloud2View(msg), obstacles);
+
+  // Only the pole's cell is an obstacle; it holds the pole and the ground
+  // points around its base.
+  for (int i = pole_begin; i < int(msg.width); i++)
+    ASSERT_NE(std::find(obstacles.begin(), obstacles.end(), i), obstacles.end());
+  ASSERT_LT(obstacles.size(), 40u);
+}
+
+// The ground map keeps the heights and classes the segmentation found.
+TEST(TestMrfGroundSegmenter, ground_map_follows_the_ground)
+{
+  MrfGroundSegmenter segmenter;
+  std::vector<float> heights;
+  std::vector<uint8_t> cells;
+  segmenter.groundMap(heights, cells);
+  EXPECT_TRUE(heights.empty());
+  EXPECT_TRUE(cells.empty());
+
+  // A plane rising along x, and a pole on it.
+  PointCloud2 msg = makeScene(0, 1);
+  std::vector<float> points;
+  for (float x = -20.0f; x <= 20.0f; x += 0.2f)
+    for (float y = -20.0f; y <= 20.0f; y += 0.2f)
+      points.insert(points.end(), {x, y, 0.01f * x, 1.0f});
+  for (float z = 0.1f; z < 2.0f; z += 0.1f)
+    points.insert(points.end(), {10.0f, 10.0f, 0.1f + z, 1.0f});
+  msg.width = uint32_t(points.size() / 4);
+  msg.row_step = msg.point_step * msg.width;
+  msg.data.resize(points.size() * sizeof(float));
+  std::memcpy(msg.data.data(), points.data(), msg.data.size());
+
+  std::vector<int> obstacles;
+  segmenter.segment(PointCloud2View(msg), obstacles);
+  segmenter.groundMap(heights, cells);
+  const std::size_t n = std::size_t(segmenter.gridSize());
+  ASSERT_EQ(heights.size(), n * n);
+  ASSERT_EQ(cells.size(), n * n);
+
+  const int c = segmenter.gridCenter();
+  const float res = segmenter.settings().res;
+  auto at = [&](float x, float y)
+  { return std::size_t(c + std::lround(x / res)) * n + std::size_t(c + std::lround(y / res)); };
+
+  EXPECT_EQ(cells[at(-15.0f, 3.0f)], MrfGroundSegmenter::GROUND);
+  EXPECT_NEAR(heights[at(-15.0f, 3.0f)], -0.15f, 0.01f);
+  EXPECT_EQ(cells[at(10.0f, 10.0f)], MrfGroundSegmenter::OBSTACLE);
+  EXPECT_NEAR(heights[at(10.0f, 10.0f)], 0.1f, 0.02f);
+  // Beyond the points, the ground is carried out from the last of it.
+  EXPECT_EQ(cells[at(40.0f, 0.0f)], MrfGroundSegmenter::DROPPED);
+  EXPECT_NEAR(heights[at(40.0f, 0.0f)], 0.2f, 0.01f);
+}
+
+// Changing the layout at runtime must give the same result as starting with it.
+TEST(TestMrfGroundSegmenter, settings_can_change_between_scans)
+{
+  MrfGroundSegmenter::Settings coarse;
+  coarse.res = 0.8f;
+  coarse.range = 60.0f;
+
+  MrfGroundSegmenter reconfigured;
+  MrfGroundSegmenter fresh(coarse);
+  ASSERT_EQ(reconfigured.gridSize(), 401);
+
+  PointCloud2 msg = makeScene(30000, 3);
+  std::vector<int> warmup, expected, actual;
+  reconfigured.segment(PointCloud2View(msg), warmup);
+
+  reconfigured.setSettings(coarse);
+  ASSERT_EQ(reconfigured.gridSize(), 151);
+
+  reconfigured.segment(PointCloud2View(msg), actual);
+  fresh.segment(PointCloud2View(msg), expected);
+  ASSERT_EQ(expected, actual);
+
+  // Invalid settings are rejected and leave the current ones in place.
+  MrfGroundSegmenter::Settings invalid = coarse;
+  invalid.res = 0.0f;
+  ASSERT_THROW(reconfigured.setSettings(invalid), std::invalid_argument);
+  ASSERT_EQ(reconfigured.gridSize(), 151);
+}
+
+// Labels must agree with segment(), and a labeled cloud must read back the
+// same labels through PointCloud2View.
+TEST(TestMrfGroundSegmenter, labels_match_obstacle_indices)
+{
+  MrfGroundSegmenter segmenter;
+  PointCloud2 msg = makeScene(50000, 11);
+  PointCloud2View cloud(msg);
+
+  std::vector<int> obstacles;
+  segmenter.segment(cloud, obstacles);
+
+  std::vector<uint8_t> labels;
+  segmenter.labelPoints(labels);
+  ASSERT_EQ(labels.size(), cloud.size());
+
+  std::vector<uint8_t> is_obstacle(cloud.size(), 0);
+  for (int i : obstacles)
+    is_obstacle[i] = 1;
+
+  int ground = 0;
+  for (std::size_t i = 0; i < labels.size(); i++)
+  {
+    EXPECT_EQ(labels[i] == MrfGroundSegmenter::OBSTACLE, bool(is_obstacle[i])) << "point " << i;
+    ground += labels[i] == MrfGroundSegmenter::GROUND;
+  }
+  EXPECT_GT(ground, 0);
+
+  PointCloud2 labeled;
+  appendLabelField(msg, labels, labeled);
+  EXPECT_EQ(labeled.point_step % 4, 0u);
+
+  PointCloud2View labeled_cloud(labeled);
+  ASSERT_TRUE(labeled_cloud.hasLabel());
+  ASSERT_EQ(labeled_cloud.size(), cloud.size());
+  for (std::size_t i = 0; i < labels.size(); i += 97)
+  {
+    EXPECT_EQ(labeled_cloud.label(i), labels[i]);
+    EXPECT_EQ(labeled_cloud.x(i), cloud.x(i));
+    EXPECT_EQ(labeled_cloud.z(i), cloud.z(i));
+  }
+}
+
+namespace
+{
+  // The scene as seen by a sensor that moved by `motion` (the pose of the new
+  // sensor frame in the old one).
+  PointCloud2 moveScene(const PointCloud2 &msg, const MrfGroundSegmenter::Motion &motion)
+  {
+    PointCloud2 moved = msg;
+    const float c = std::cos(motion.dyaw), s = std::sin(motion.dyaw);
+    for (std::size_t i = 0; i < std::size_t(msg.width); i++)
+    {
+      float p[2];
+      std::memcpy(p, &msg.data[i * msg.point_step], sizeof(p));
+      const float x = p[0] - motion.dx, y = p[1] - motion.dy;
+      p[0] = c * x + s * y;
+      p[1] = -s * x + c * y;
+      std::memcpy(&moved.data[i * msg.point_step], p, sizeof(p));
+    }
+    return moved;
+  }
+}
+
+// Seeding a scan with an identical, unmoved one must not change the result.
+TEST(TestMrfGroundSegmenter, warm_start_on_static_scene_matches_full)
+{
+  MrfGroundSegmenter::Settings settings;
+  settings.warm_start = true;
+  MrfGroundSegmenter warm(settings);
+  MrfGroundSegmenter full;
+
+  PointCloud2 msg = makeScene(60000, 21);
+  PointCloud2View cloud(msg);
+
+  std::vector<int> expected, actual;
+  full.segment(cloud, expected);
+  for (int scan = 0; scan < 3; scan++)
+  {
+    warm.segment(cloud, actual, MrfGroundSegmenter::Motion());
+    EXPECT_EQ(actual, expected) << "scan " << scan;
+  }
+}
+
+// While moving, the warm-started labels should stay close to a full
+// recompute, and every full_recompute_interval-th scan must match it exactly.
+TEST(TestMrfGroundSegmenter, warm_start_follows_motion)
+{
+  MrfGroundSegmenter::Settings settings;
+  settings.warm_start = true;
+  settings.full_recompute_interval = 3;
+  MrfGroundSegmenter warm(settings);
+  MrfGroundSegmenter full;
+
+  const PointCloud2 scene = makeScene(60000, 22);
+  MrfGroundSegmenter::Motion step;
+  step.dx = 1.3f;
+  step.dy = -0.4f;
+  step.dyaw = 0.03f;
+
+  MrfGroundSegmenter::Motion pose;
+  std::vector<int> warm_obstacles, full_obstacles;
+  std::vector<uint8_t> warm_labels, full_labels;
+  for (int scan = 0; scan < 6; scan++)
+  {
+    // Accumulate the pose of the sensor in the scene frame.
+    const float c = std::cos(pose.dyaw), s = std::sin(pose.dyaw);
+    if (scan > 0)
+    {
+      pose.dx += c * step.dx - s * step.dy;
+      pose.dy += s * step.dx + c * step.dy;
+      pose.dyaw += step.dyaw;
+    }
+    PointCloud2 msg = moveScene(scene, pose);
+    PointCloud2View cloud(msg);
+
+    warm.segment(cloud, warm_obstacles, step);
+    full.segment(cloud, full_obstacles);
+
+    if (scan % 3 == 0)
+    {
+      EXPECT_EQ(warm_obstacles, full_obstacles) << "scan " << scan;
+      continue;
+    }
+
+    warm.labelPoints(warm_labels);
+    full.labelPoints(full_labels);
+    std::size_t same = 0;
+    for (std::size_t i = 0; i < warm_labels.size(); i++)
+      same += warm_labels[i] == full_labels[i];
+    EXPECT_GT(double(same) / warm_labels.size(), 0.97) << "scan " << scan;
+  }
+}
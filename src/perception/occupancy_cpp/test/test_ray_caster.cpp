@@ -0,0 +1,140 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  test_ray_caster.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Test casting several sensors, each from its own origin, into one frame.
+
+#include <gtest/gtest.h> // Testing framework
+#include <random>        // std::mt19937
+#include <vector>
+
+#include "occupancy_cpp/RayCaster.hpp"
+
+using namespace navigator::perception;
+
+namespace
+{
+  constexpr int GRID_SIZE = 64;
+  constexpr float RES = 1. / 3.;
+  constexpr float MEAS_MASS = 0.95;
+
+  // Hits scattered over the grid, leaving some bins uncovered.
+  std::vector<RayCaster::Cell> makeHits(unsigned seed, int count)
+  {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> cell(-GRID_SIZE / 2, GRID_SIZE / 2 - 1);
+    std::vector<RayCaster::Cell> hits;
+    for (int i = 0; i < count; i++)
+      hits.push_back(RayCaster::Cell{int16_t(cell(rng)), int16_t(cell(rng) / 2)});
+    return hits;
+  }
+
+  void expectSameMeasurement(const DstGrid &a, const DstGrid &b)
+  {
+    for (std::size_t i = 0; i < a.cells(); i++)
+    {
+      ASSERT_EQ(a.measOcc()[i], b.measOcc()[i]) << "at cell " << i;
+      ASSERT_EQ(a.measFree()[i], b.measFree()[i]) << "at cell " << i;
+    }
+  }
+
+  // MEAS_MASS as the grid stores it, quantized with fixed-point masses.
+  float storedMass()
+  {
+    return dst::massValue(dst::toMass<Mass>(MEAS_MASS));
+  }
+
+  float measFree(DstGrid &grid, int x, int y)
+  {
+    return dst::massValue(grid.measFree(x + grid.center(), y + grid.center()));
+  }
+
+  float measOcc(DstGrid &grid, int x, int y)
+  {
+    return dst::massValue(grid.measOcc(x + grid.center(), y + grid.center()));
+  }
+}
+
+TEST(RayCaster, CenteredSourceCastsLikeHits)
+{
+  RayCaster rays(GRID_SIZE, 1.0f, 10, MEAS_MASS);
+  const std::vector<RayCaster::Cell> hits = makeHits(1, 200);
+
+  DstGrid single(GRID_SIZE, RES);
+  rays.cast(single, hits);
+  DstGrid sources(GRID_SIZE, RES);
+  rays.cast(sources, {RayCaster::Source{{0, 0}, &hits}});
+
+  expectSameMeasurement(single, sources);
+}
+
+TEST(RayCaster, SourcesSeeFromTheirOrigins)
+{
+  RayCaster rays(GRID_SIZE, 1.0f, 10, MEAS_MASS);
+  DstGrid grid(GRID_SIZE, RES);
+  const std::vector<RayCaster::Cell> hits = {{20, 0}};
+  rays.cast(grid, {RayCaster::Source{{10, 0}, &hits}});
+
+  EXPECT_FLOAT_EQ(measOcc(grid, 20, 0), storedMass());
+  for (int x = 10; x < 20; x++)
+    EXPECT_FLOAT_EQ(measFree(grid, x, 0), storedMass()) << "at x " << x;
+  // Past the hit is unseen, and behind the sensor is free out to the edge,
+  // across the center.
+  EXPECT_FLOAT_EQ(measFree(grid, 25, 0), 0.0f);
+  EXPECT_FLOAT_EQ(measFree(grid, 0, 0), storedMass());
+  EXPECT_FLOAT_EQ(measFree(grid, -GRID_SIZE / 2, 0), storedMass());
+}
+
+TEST(RayCaster, SourcesDontSeeThroughEachOthersHits)
+{
+  RayCaster rays(GRID_SIZE, 1.0f, 10, MEAS_MASS);
+  const std::vector<RayCaster::Cell> front = {{5, 0}};
+  const std::vector<RayCaster::Cell> back = {{-20, 0}};
+  const RayCaster::Source a{{-4, 0}, &front};
+  const RayCaster::Source b{{4, 0}, &back};
+
+  DstGrid ab(GRID_SIZE, RES);
+  rays.cast(ab, {a, b});
+  DstGrid ba(GRID_SIZE, RES);
+  rays.cast(ba, {b, a});
+  expectSameMeasurement(ab, ba);
+
+  // b's ray to its hit would cross a's, which stays occupied.
+  EXPECT_FLOAT_EQ(measOcc(ab, 5, 0), storedMass());
+  EXPECT_FLOAT_EQ(measFree(ab, 5, 0), 0.0f);
+}
+
+TEST(RayCaster, ParallelSourcesMatchSerial)
+{
+  RayCaster serial_rays(GRID_SIZE, 1.0f, 10, MEAS_MASS);
+  RayCaster parallel_rays(GRID_SIZE, 1.0f, 10, MEAS_MASS);
+  navigator::worker_pool::WorkerPool pool(4);
+  const std::vector<RayCaster::Cell> left = makeHits(2, 150);
+  const std::vector<RayCaster::Cell> right = makeHits(3, 150);
+  const std::vector<RayCaster::Source> sources = {{{3, 6}, &left}, {{3, -6}, &right}};
+
+  DstGrid serial(GRID_SIZE, RES);
+  serial_rays.cast(serial, sources);
+  DstGrid parallel(GRID_SIZE, RES);
+  parallel_rays.cast(parallel, sources, &pool);
+  expectSameMeasurement(serial, parallel);
+}
+
+TEST(RayCaster, OutsideSourcesOnlyMarkHits)
+{
+  RayCaster rays(GRID_SIZE, 1.0f, 10, MEAS_MASS);
+  DstGrid grid(GRID_SIZE, RES);
+  const std::vector<RayCaster::Cell> hits = {{3, 3}};
+  rays.cast(grid, {RayCaster::Source{{int16_t(GRID_SIZE), 0}, &hits}});
+
+  EXPECT_FLOAT_EQ(measOcc(grid, 3, 3), storedMass());
+  std::size_t freed = 0;
+  for (std::size_t i = 0; i < grid.cells(); i++)
+    freed += grid.measFree()[i] != Mass(0);
+  EXPECT_EQ(freed, 0u);
+}
@@ -0,0 +1,114 @@
+/*
+ * Package:   occupancy_cpp
+ * Filename:  test_voxel_downsampler.cpp
+ * Author:    Will Heitman, Daniel Vayman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Test the voxel downsampling (isolated from the ROS node).
+
+#include <gtest/gtest.h> // Testing framework
+#include <array>
+#include <cmath>         // std::floor
+#include <cstring>       // std::memcpy
+#include <limits>        // std::numeric_limits
+#include <random>        // std::mt19937
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "occupancy_cpp/VoxelDownsampler.hpp"
+
+using namespace navigator::perception;
+using sensor_msgs::msg::PointCloud2;
+using sensor_msgs::msg::PointField;
+
+namespace
+{
+  PointCloud2 makeCloud(const std::vector<std::array<float, 3>> &points)
+  {
+    PointCloud2 msg;
+    msg.height = 1;
+    msg.width = uint32_t(points.size());
+    msg.point_step = 12;
+    msg.row_step = msg.point_step * msg.width;
+
+    const char *names[] = {"x", "y", "z"};
+    for (int i = 0; i < 3; i++)
+    {
+      PointField field;
+      field.name = names[i];
+      field.offset = 4 * i;
+      field.datatype = PointField::FLOAT32;
+      field.count = 1;
+      msg.fields.push_back(field);
+    }
+
+    msg.data.resize(msg.row_step);
+    for (std::size_t i = 0; i < points.size(); i++)
+      std::memcpy(&msg.data[i * msg.point_step], points[i].data(), 12);
+    return msg;
+  }
+
+  std::vector<std::array<float, 3>> randomPoints(int count, float extent, unsigned seed)
+  {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-extent, extent);
+    std::vector<std::array<float, 3>> points(count);
+    for (auto &p : points)
+      p = {position(rng), position(rng), position(rng) * 0.1f};
+    return points;
+  }
+}
+
+// Exactly one point per occupied voxel is kept: the first one.
+TEST(TestVoxelDownsampler, keeps_first_point_of_each_voxel)
+{
+  const float leaf = 0.5f;
+  VoxelDownsampler downsampler(leaf);
+
+  // Reuse the table across clouds of different sizes.
+  for (unsigned seed = 1; seed <= 3; seed++)
+  {
+    auto points = randomPoints(20000 * seed, 20.0f, seed);
+    PointCloud2 msg = makeCloud(points);
+
+    std::vector<uint32_t> kept;
+    downsampler.downsample(PointCloud2View(msg), kept);
+
+    std::set<std::tuple<int, int, int>> seen;
+    std::vector<uint32_t> expected;
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+      auto voxel = std::make_tuple(int(std::floor(points[i][0] / leaf)), int(std::floor(points[i][1] / leaf)),
+                                   int(std::floor(points[i][2] / leaf)));
+      if (seen.insert(voxel).second)
+        expected.push_back(uint32_t(i));
+    }
+
+    EXPECT_EQ(kept, expected) << "seed " << seed;
+  }
+}
+
+TEST(TestVoxelDownsampler, drops_non_finite_points)
+{
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float inf = std::numeric_limits<float>::infinity();
+  PointCloud2 msg = makeCloud({{0.1f, 0.1f, 0.1f}, {nan, 0.0f, 0.0f}, {0.0f, inf, 0.0f}, {0.2f, 0.2f, 0.2f}, {5.0f, 0.0f, 0.0f}});
+
+  VoxelDownsampler downsampler(1.0f);
+  std::vector<uint32_t> kept;
+  downsampler.downsample(PointCloud2View(msg), kept);
+
+  EXPECT_EQ(kept, (std::vector<uint32_t>{0, 4}));
+}
+
+TEST(TestVoxelDownsampler, rejects_bad_leaf_size)
+{
+  EXPECT_THROW(VoxelDownsampler(0.0f), std::invalid_argument);
+  VoxelDownsampler downsampler(0.2f);
+  EXPECT_THROW(downsampler.setLeafSize(-1.0f), std::invalid_argument);
+  EXPECT_FLOAT_EQ(downsampler.leafSize(), 0.2f);
+}
@@ -0,0 +1,124 @@
+// Replays recorded cost maps through the planner, without ROS, and reports
+// how long each plan took, how large the tree grew and what the path cost.
+// Run r plans with seed + r, and the path checksum covers every plan, so
+// two builds can be compared by it. Record maps by setting rrt_node's record_path parameter.
+// Warm started, each map but a run's first starts from the last one's tree,
+// moved by the vehicle's motion as recorded. Maps recorded without one, as
+// after a tf dropout, start from scratch.
+// Usage: rrt_bench <recording> [runs] [seed] [rrt|rrt_star] [batch] [threads] [time_budget_ms] [max_iterations] [warm_start] [footprint_radius] [clearance_weight]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <vector>
+
+#include "rrt/CostGrid.hpp"
+#include "rrt/CostMapRecording.hpp"
+#include "rrt/RRTPlanner.hpp"
+
+struct Recorded{
+	CostGrid costs;
+	int goalX;
+	int goalY;
+	std::optional< RRTPlanner::Motion > motion; // Since the map before
+};
+
+static void printStat(const char *name, std::vector< double > &values, const char *unit){
+	if(values.empty()){
+		return;
+	}
+	std::sort(values.begin(), values.end());
+	double sum = 0;
+	for(double value : values){
+		sum += value;
+	}
+	std::printf("%-10s mean %9.2f %s  p50 %9.2f %s  p90 %9.2f %s  p99 %9.2f %s  max %9.2f %s\n", name, sum / values.size(), unit,
+		values[values.size() / 2], unit, values[values.size() * 9 / 10], unit, values[values.size() * 99 / 100], unit, values.back(), unit);
+}
+
+int main(int argc, char **argv){
+	if(argc < 2){
+		std::printf("Usage: %s <recording> [runs] [seed] [rrt|rrt_star] [batch] [threads] [time_budget_ms] [max_iterations] [warm_start] [footprint_radius] [clearance_weight]\n", argv[0]);
+		return 1;
+	}
+	const int runs = argc > 2 ? std::atoi(argv[2]) : 10;
+
+	RRTPlanner::Options options;
+	options.seed = argc > 3 ? std::atoi(argv[3]) : 1;
+	options.rrtStar = argc > 4 && std::strcmp(argv[4], "rrt_star") == 0;
+	options.expansionBatch = argc > 5 ? std::atoi(argv[5]) : 1;
+	options.expansionThreads = argc > 6 ? std::atoi(argv[6]) : 1;
+	options.timeBudgetMs = argc > 7 ? std::atof(argv[7]) : 0;
+	options.maxIterations = argc > 8 ? std::atoi(argv[8]) : 1000;
+	options.warmStart = argc > 9 && std::atoi(argv[9]) != 0;
+	options.footprintRadius = argc > 10 ? std::atof(argv[10]) : 0;
+	options.clearanceWeight = argc > 11 ? std::atof(argv[11]) : 0;
+
+	std::ifstream in(argv[1]);
+	if(!in){
+		std::printf("could not open %s\n", argv[1]);
+		return 1;
+	}
+	std::vector< Recorded > maps;
+	Recorded map;
+	while(readCostMap(in, map.costs, map.goalX, map.goalY, map.motion)){
+		maps.push_back(map);
+	}
+	if(!in.eof()){
+		std::printf("map %zu of %s is malformed\n", maps.size() + 1, argv[1]);
+		return 1;
+	}
+	if(maps.empty()){
+		std::printf("no maps in %s\n", argv[1]);
+		return 1;
+	}
+	std::printf("%zu maps of %d x %d x %d, %d runs each, %s%s, seed %d, batch %d, threads %d\n", maps.size(), maps[0].costs.layers(),
+		maps[0].costs.rows(), maps[0].costs.cols(), runs, options.rrtStar ? "rrt_star" : "rrt", options.warmStart ? " warm started" : "",
+		options.seed, options.expansionBatch, options.expansionThreads);
+
+	// One planner for the whole run, as in the node, so its buffers are
+	// warm after the first plan
+	RRTPlanner planner(options);
+	std::vector< double > latencies, nodes, iterations, pathCosts;
+	int goalsReached = 0;
+	unsigned long long checksum = 1469598103934665603ULL; // FNV-1a over every path
+	for(int run = 0; run < runs; run++){
+		// Each run grows different trees, but the same ones every time
+		if(options.seed >= 0){
+			planner.setSeed(options.seed + run);
+		}
+		for(std::size_t index = 0; index < maps.size(); index++){
+			const Recorded &recorded = maps[index];
+			const auto start = std::chrono::steady_clock::now();
+			const std::vector< TreeNode > &path = index > 0 && recorded.motion
+				? planner.plan(recorded.costs, recorded.goalX, recorded.goalY, *recorded.motion)
+				: planner.plan(recorded.costs, recorded.goalX, recorded.goalY);
+			latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+			nodes.push_back(planner.getTree().size());
+			iterations.push_back(planner.getIterations());
+			goalsReached += planner.reachedGoal();
+			if(!path.empty()){
+				pathCosts.push_back(path.back().pathCost);
+			}
+			for(const TreeNode &node : path){
+				for(int value : {node.x, node.y, node.index}){
+					checksum = (checksum ^ (unsigned int)value) * 1099511628211ULL;
+				}
+			}
+			checksum = (checksum ^ 0xff) * 1099511628211ULL;
+		}
+	}
+
+	std::printf("%d of %zu plans reached the goal\n", goalsReached, latencies.size());
+	printStat("latency", latencies, "ms");
+	printStat("nodes", nodes, "");
+	printStat("iterations", iterations, "");
+	printStat("path cost", pathCosts, "");
+	std::printf("path checksum %016llx\n", checksum);
+	return 0;
+}
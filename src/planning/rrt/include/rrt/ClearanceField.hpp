@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "rrt/CostGrid.hpp"
+
+namespace navigator{
+	namespace worker_pool{
+		class WorkerPool;
+	}
+}
+
+// How far every cell of a cost map is from the nearest obstacle, a cell
+// whose occupancy is over 0.5, in the same time layer: the Euclidean
+// distance between cell centres, in cells. Computed once per cost map, so
+// that checking a vehicle footprint against the map is a single lookup
+// rather than a scan of the cells around it. Laid out like CostGrid, with
+// the padding column one past every row's end reading 0, as if occupied.
+class ClearanceField{
+	public:
+		// Occupancy over this is an obstacle
+		static constexpr float OCCUPIED_ABOVE = 0.5f;
+
+		// Recomputes the field for costs, one layer per task of pool.
+		// Reuses the storage of the last map when it's large enough.
+		void compute(const CostGrid &costs, navigator::worker_pool::WorkerPool &pool);
+
+		// Unchecked, but col may be cols(), which reads 0. A layer without
+		// obstacles reads more than its rows and columns together.
+		float at(int layer, int row, int col) const{
+			return values[((std::size_t)layer * rowCount + row) * stride + col];
+		}
+
+	private:
+		// The squared distance transform of one layer
+		void computeLayer(const CostGrid &costs, int layer);
+
+		// Felzenszwalb and Huttenlocher's transform of the squared distances
+		// in f, count long, into d, with v and z as the lower envelope's
+		// parabolas and the boundaries between them
+		struct Scratch{
+			std::vector< float > f;
+			std::vector< float > d;
+			std::vector< int > v;
+			std::vector< float > z;
+		};
+		static void transform(Scratch &scratch, int count);
+
+		int layerCount = 0;
+		int rowCount = 0;
+		int colCount = 0;
+		int stride = 1;
+		std::vector< float > values; // Squared until compute() finishes a layer
+		std::vector< Scratch > scratch; // One per layer, so layers can run at once
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// A cost map's occupancy values in one contiguous [layer][row][col] array,
+// so the planner's lookups are a multiply-add rather than three levels of
+// vectors. One column past the end of every row reads as OCCUPIED: the
+// steering search may look one cell past a row's end, and this way it
+// simply never picks that cell.
+class CostGrid{
+	public:
+		static constexpr float OCCUPIED = 1.0f;
+
+		// Every cell OCCUPIED until written. Reuses the storage of the last
+		// map when it's large enough.
+		void reset(int layers, int rows, int cols);
+
+		int layers() const { return layerCount; }
+		int rows() const { return rowCount; }
+		int cols() const { return colCount; }
+
+		bool contains(int layer, int row, int col) const{
+			return layer >= 0 && layer < layerCount && row >= 0 && row < rowCount && col >= 0 && col < colCount;
+		}
+		// Unchecked, but col may be cols(), which reads OCCUPIED
+		float at(int layer, int row, int col) const{
+			return values[((std::size_t)layer * rowCount + row) * stride + col];
+		}
+		// The cols() cells of a row, to fill it
+		float *row(int layer, int row){
+			return values.data() + ((std::size_t)layer * rowCount + row) * stride;
+		}
+		const float *row(int layer, int row) const{
+			return values.data() + ((std::size_t)layer * rowCount + row) * stride;
+		}
+
+	private:
+		int layerCount = 0;
+		int rowCount = 0;
+		int colCount = 0;
+		int stride = 1; // colCount plus the padding column
+		std::vector< float > values;
+};
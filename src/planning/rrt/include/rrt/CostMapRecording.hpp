@@ -0,0 +1,21 @@
+#pragma once
+
+#include <istream>
+#include <optional>
+#include <ostream>
+#include "rrt/CostGrid.hpp"
+#include "rrt/RRTPlanner.hpp"
+
+// Cost maps and goals as the planner saw them, in a plain text format that
+// rrt_bench replays. Each map is a line "costmap <layers> <rows> <cols>
+// <goal x> <goal y>", then every row of every layer, layer by layer, as a
+// line of cols values. A map the vehicle's motion since the last one is
+// known for is preceded by a line "motion <xx> <xy> <x0> <yx> <yy> <y0>
+// <layers>", as in RRTPlanner::Motion. Values are written exactly, so a
+// replayed map plans the same as the original.
+void writeCostMap(std::ostream &out, const CostGrid &costs, int goalX, int goalY, const RRTPlanner::Motion *motion);
+
+// Reads the next map of a recording, and its motion if it has one. False
+// at the end of the recording, or if the map is malformed, which leaves in
+// failed but not at eof.
+bool readCostMap(std::istream &in, CostGrid &costs, int &goalX, int &goalY, std::optional< RRTPlanner::Motion > &motion);
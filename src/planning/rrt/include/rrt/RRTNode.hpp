@@ -13,6 +13,7 @@
 #include <random>
 #include<cmath>
 #include <limits>
+#include <fstream>
 
 // libOpenDRIVE stuff
 #include "OpenDriveMap.h"
@@ -21,6 +22,10 @@
 #include "Geometries/Line.h"
 #include "RefLine.h"
 #include "opendrive_utils/OpenDriveUtils.hpp"
+#include "rrt/CostGrid.hpp"
+#include "rrt/RRTPlanner.hpp"
+#include "latency_tracker/StageRecorder.hpp"
+#include "grid_tensor/GridTensor.hpp"
 
 // Message headers
 #include <geometry_msgs/msg/point.hpp>
@@ -31,46 +36,47 @@
 #include <std_msgs/msg/header.hpp>
 #include <nav_msgs/msg/path.hpp>
 #include <builtin_interfaces/msg/time.hpp>
-#include <nova_msgs/msg/egma.hpp>
+#include <nova_msgs/msg/grid_tensor.hpp>
 #include <nova_msgs/msg/goal_position.hpp>
 #include <nova_msgs/msg/rrt_path.hpp>
 
-class TreeNode{
-    public:
-        int x;
-        int y;
-        int index;
-        bool goal;
-        std::vector< TreeNode > children;
-        TreeNode (){
-
-        }
-        TreeNode(int x, int y, int index) : x(x), y(y), index(index), goal(false) {}
-};
-
+#include "tf2_ros/buffer.h"
+#include "tf2_ros/transform_listener.h"
 
 class RRTNode : public rclcpp::Node {
 	public:
 		RRTNode();
-		void findPath(nova_msgs::msg::Egma::SharedPtr map);
+		void findPath(nova_msgs::msg::GridTensor::SharedPtr map);
 
 	private:
+		// Where a cost map's grid lies in the map frame: cell (0, 0)'s corner,
+		// and which way its x axis, along a row, points
+		struct GridPose{
+			double x;
+			double y;
+			double yaw;
+		};
+
+		bool vehicleMotion(const nova_msgs::msg::GridTensor &map, RRTPlanner::Motion &motion);
 
 		//class variables
-		TreeNode *closest;
-		TreeNode currentPosition;
-		TreeNode goal;
+		CostGrid costs; // The cost map of the current cycle
+		std::unique_ptr< RRTPlanner > planner;
+		std::ofstream recording; // Every cost map and goal, for rrt_bench, if record_path is set
+		std::unique_ptr< navigator::latency_tracker::StageRecorder > latencyRecorder;
 		
+		std::unique_ptr< tf2_ros::Buffer > tfBuffer;
+		std::shared_ptr< tf2_ros::TransformListener > tfListener;
+		std::string mapFrame;
+		bool warmStart;
+		// The last cost map's grid and layer times, for the motion to the next
+		bool hasLastGrid = false;
+		GridPose lastGrid;
+		float lastResolution;
+		std::vector< builtin_interfaces::msg::Time > lastStamps;
+
 		float maxDistanceToExplore = 3;
-		float currentMinCostForSingleNode;
 		float maxVelocity = 20;
-		float tempPathCost;
-		
-		int iteration;
-		int totalLeaves;
-
-		std::pair<int,int> randomPoint;
-        std::vector< TreeNode > finalRRTPath;
 
 		//messages
 		//nova_msgs::msg::RrtPath path;
@@ -83,14 +89,8 @@ class RRTNode : public rclcpp::Node {
 		//rclcpp::Publisher<nova_msgs::msg::RrtPath>::SharedPtr rrt_path_pub;
 		rclcpp::Publisher<nav_msgs::msg::Path>::SharedPtr rrt_path_publisher;
 		rclcpp::Subscription<nova_msgs::msg::GoalPosition>::SharedPtr goal_position_sub;
-		rclcpp::Subscription<nova_msgs::msg::Egma>::SharedPtr cost_map_sub;
+		rclcpp::Subscription<nova_msgs::msg::GridTensor>::SharedPtr cost_map_sub;
 		
-		//methods to be called from find_path
-		void createPaths(nova_msgs::msg::Egma::SharedPtr map);
-		void addNewRRTNode(nova_msgs::msg::Egma::SharedPtr map);
-		void findClosestState(TreeNode *head);
-		void findRandomPair(int gridSize_x, int gridSize_y);
-		void bestPath(TreeNode *head, float total, std::vector< TreeNode > tempPath, nova_msgs::msg::Egma::SharedPtr map);
 
 	
 };
\ No newline at end of file
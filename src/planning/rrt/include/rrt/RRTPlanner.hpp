@@ -0,0 +1,153 @@
+#pragma once
+
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "rrt/ClearanceField.hpp"
+#include "rrt/CostGrid.hpp"
+#include "rrt/TreeNodeIndex.hpp"
+#include "worker_pool/WorkerPool.hpp"
+
+// A node of the RRT. Nodes live in one flat pool and link to each other by
+// position in it, so handles stay valid as the pool grows. Children are a
+// list through firstChild and nextSibling, in the order they were added.
+class TreeNode{
+    public:
+        static constexpr int NO_NODE = TreeNodeIndex::NO_NODE;
+
+        int x;
+        int y;
+        int index;
+        bool goal;
+        float pathCost = 0; // Cost along the edges from the root to this node
+        int parent = NO_NODE;
+        int firstChild = NO_NODE;
+        int lastChild = NO_NODE;
+        int nextSibling = NO_NODE;
+        TreeNode (){
+
+        }
+        TreeNode(int x, int y, int index, int parent) : x(x), y(y), index(index), goal(false), parent(parent) {}
+};
+
+// The RRT itself, on a cost map of occupancy layers, with nothing of ROS.
+// Each layer is a step further ahead in time, and the tree steps a layer
+// per node. With a seed of its own, the same map and goal always plan the
+// same path, whatever the thread count.
+class RRTPlanner{
+	public:
+		struct Options{
+			// RRT* rewires the tree as it grows and, once a path reaches the
+			// goal, keeps sampling near it until time or iterations run out.
+			// Plain RRT stops at the first path to the goal.
+			bool rrtStar = false;
+			double timeBudgetMs = 0; // Wall-clock cap on growing the tree, 0 for none
+			int maxIterations = 1000;
+			int seed = -1; // Negative draws a new one from the clock each plan
+			int expansionBatch = 1; // Samples steered at once, then added in order
+			int expansionThreads = 1;
+			float maxDistanceToExplore = 3;
+			// Nodes and the edges between them keep further than this from
+			// every obstacle, in cells, so 0 only keeps them off occupied
+			// cells
+			float footprintRadius = 0;
+			// Each cell of path costs its occupancy, plus this divided by
+			// its clearance, so paths keep away from obstacles where they
+			// can
+			float clearanceWeight = 0;
+			// Given the vehicle's motion since the last plan, starts from the
+			// last plan's tree, moved into the new map and re-rooted at the
+			// current position. Old nodes that land in the layer after the
+			// root's hang off the new root, those of layers now past are
+			// dropped, and so is every node the new map makes unreachable,
+			// with its subtree. A path that's still free is hence found again
+			// without searching. Plans given no motion start from scratch.
+			bool warmStart = false;
+		};
+
+		// How the vehicle moved between the last plan's map and this one's:
+		// cell (x, y) of the last map is at (xx * x + xy * y + x0, yx * x +
+		// yy * y + y0) of this one, in cells, and its layer k is layer
+		// k - layers. The default is a vehicle that stood still between maps
+		// of the same times.
+		struct Motion{
+			float xx = 1, xy = 0, x0 = 0;
+			float yx = 0, yy = 1, y0 = 0;
+			int layers = 0;
+		};
+
+		explicit RRTPlanner(const Options &options);
+
+		// Grows a tree over costs from the current position, cell (10, 4) of
+		// the first layer, towards (goalX, goalY), and returns the best path
+		// found, the root first
+		const std::vector< TreeNode > &plan(const CostGrid &costs, int goalX, int goalY);
+		// The same, but with warmStart, starts from the last plan's tree
+		// moved by motion. A map older than the last (negative layers)
+		// starts from scratch.
+		const std::vector< TreeNode > &plan(const CostGrid &costs, int goalX, int goalY, const Motion &motion);
+		// For the plans after
+		void setSeed(int seed) { options.seed = seed; }
+
+		// Of the last plan
+		const std::vector< TreeNode > &getTree() const { return tree; }
+		const std::vector< TreeNode > &getPath() const { return finalRRTPath; }
+		int getIterations() const { return iteration; }
+		bool reachedGoal() const { return !goalNodes.empty(); }
+
+	private:
+		Options options;
+
+		// Every node of the current tree, the root (current position) first.
+		// Cleared each plan but never shrunk, so after the first plan growing
+		// the tree doesn't allocate.
+		std::vector< TreeNode > tree;
+		TreeNodeIndex treeIndex; // Of tree, by position
+		const CostGrid *costs = nullptr; // The cost map of the current plan
+		ClearanceField clearance; // Of costs
+		int closest;
+		TreeNode goal;
+
+		// A node to add to the tree under closest, as a sample steered it, or
+		// nothing if layer is -1
+		struct Candidate{
+			int closest;
+			int x;
+			int y;
+			int layer;
+		};
+		std::unique_ptr< navigator::worker_pool::WorkerPool > expansionPool;
+		std::vector< std::mt19937 > generators; // One per sample of a batch
+		std::vector< Candidate > candidates;
+		
+		int iteration = 0;
+		bool goalReached; // A node was added at the goal
+		std::vector< int > goalNodes; // Nodes at the goal, the root first if it's one
+		std::vector< int > nearby; // Scratch for index queries
+		std::vector< TreeNode > spareTree; // What a warm start keeps, swapped in
+		std::vector< int > keptAs; // Position in spareTree of each node, or NO_NODE
+
+		std::vector< TreeNode > finalRRTPath;
+
+		void createPaths();
+		void steerNewRRTNode(std::mt19937 &generator, Candidate &candidate) const;
+		void addNewRRTNode(const Candidate &candidate);
+		int findClosestState(const std::pair<int,int> &randomPoint) const;
+		std::pair<int,int> findRandomPair(std::mt19937 &generator, int gridSize_x, int gridSize_y) const;
+		std::pair<int,int> findInformedPair(std::mt19937 &generator, int gridSize_x, int gridSize_y) const;
+		void insertRRTStarNode(int x, int y, int layer);
+		bool canReach(const TreeNode &from, int x, int y) const;
+		bool isFree(int layer, int x, int y) const;
+		bool edgeIsFree(const TreeNode &from, int x, int y, int layer) const;
+		float edgeCost(const TreeNode &from, int x, int y, int layer) const;
+		const std::vector< TreeNode > &planImpl(const CostGrid &costs, int goalX, int goalY, const Motion *motion);
+		void keepFreeSubtrees(const Motion &motion, float rootCost);
+		void linkChild(int parent, int child);
+		void unlinkChild(int parent, int child);
+		void reparent(int node, int parent, float pathCost);
+		float pathLength(int node) const;
+		int bestGoal() const;
+		int bestPath() const;
+};
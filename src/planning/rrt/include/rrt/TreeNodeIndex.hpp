@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+// Buckets the RRT's nodes by position, so the node nearest a sample can be
+// found without visiting the whole tree. Nodes are only ever added, and
+// reset() empties the index for the next planning cycle without freeing
+// its buckets.
+class TreeNodeIndex{
+	public:
+		static constexpr int NO_NODE = -1;
+
+		// Covers cells [0, width) x [0, height). Positions outside are
+		// clamped into the edge buckets.
+		void reset(int width, int height);
+		void insert(int node, int x, int y);
+
+		// The node nearest (x, y) by squared distance among those with an x
+		// of at least x, or NO_NODE if there is none. Of equally near nodes,
+		// the first inserted wins. The squared distance goes in distance2.
+		int nearest(int x, int y, float *distance2) const;
+
+		// Appends every node in [xMin, xMax] x [yMin, yMax] to nodes, in no
+		// particular order.
+		void within(int xMin, int xMax, int yMin, int yMax, std::vector< int > &nodes) const;
+
+	private:
+		static constexpr int BUCKET_SIZE = 4; // Cells per bucket side
+
+		struct Entry{
+			int node;
+			int x;
+			int y;
+		};
+
+		int bucketOf(int cell, int bucketCount) const;
+
+		int bucketsX = 0;
+		int bucketsY = 0;
+		int maxX = 0; // Largest x inserted, valid once there's a node
+		bool empty = true;
+		std::vector< std::vector< Entry > > buckets; // By bucket x, then y
+};
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "rrt/ClearanceField.hpp"
+#include "worker_pool/WorkerPool.hpp"
+
+void ClearanceField::compute(const CostGrid &costs, navigator::worker_pool::WorkerPool &pool){
+	this->layerCount = costs.layers();
+	this->rowCount = costs.rows();
+	this->colCount = costs.cols();
+	this->stride = this->colCount + 1;
+	this->values.resize((std::size_t)this->layerCount * this->rowCount * this->stride);
+	if(this->scratch.size() < (std::size_t)this->layerCount){
+		this->scratch.resize(this->layerCount);
+	}
+	pool.run(this->layerCount, [&](int layer){
+		computeLayer(costs, layer);
+	});
+}
+
+void ClearanceField::transform(Scratch &scratch, int count){
+	const float *f = scratch.f.data();
+	float *d = scratch.d.data();
+	int *v = scratch.v.data();
+	float *z = scratch.z.data();
+	const float infinity = std::numeric_limits<float>::infinity();
+
+	// Only parabolas rooted at finite values make up the envelope; with
+	// none at all, everything stays infinitely far
+	int k = -1;
+	for(int q = 0; q < count; q++){
+		if(f[q] == infinity){
+			continue;
+		}
+		float s = -infinity;
+		while(k >= 0){
+			s = ((f[q] + (float)q * q) - (f[v[k]] + (float)v[k] * v[k])) / (2.0f * (q - v[k]));
+			if(s > z[k]){
+				break;
+			}
+			k--;
+		}
+		k++;
+		v[k] = q;
+		z[k] = k == 0 ? -infinity : s;
+		z[k+1] = infinity;
+	}
+	if(k < 0){
+		std::fill(d, d + count, infinity);
+		return;
+	}
+	k = 0;
+	for(int q = 0; q < count; q++){
+		while(z[k+1] < q){
+			k++;
+		}
+		d[q] = (float)(q - v[k]) * (q - v[k]) + f[v[k]];
+	}
+}
+
+void ClearanceField::computeLayer(const CostGrid &costs, int layer){
+	Scratch &scratch = this->scratch[layer];
+	const int longest = std::max(this->rowCount, this->colCount);
+	scratch.f.resize(longest);
+	scratch.d.resize(longest);
+	scratch.v.resize(longest);
+	scratch.z.resize(longest + 1);
+	const float infinity = std::numeric_limits<float>::infinity();
+	float *layerValues = this->values.data() + (std::size_t)layer * this->rowCount * this->stride;
+
+	// Along each row, then along each column of the result
+	for(int i = 0; i < this->rowCount; i++){
+		const float *occupancy = costs.row(layer, i);
+		for(int j = 0; j < this->colCount; j++){
+			scratch.f[j] = occupancy[j] > OCCUPIED_ABOVE ? 0.0f : infinity;
+		}
+		transform(scratch, this->colCount);
+		std::copy(scratch.d.begin(), scratch.d.begin() + this->colCount, layerValues + (std::size_t)i * this->stride);
+	}
+	// Beyond any distance within the layer, for layers without obstacles
+	const float far = (float)(this->rowCount + this->colCount + 1);
+	for(int j = 0; j < this->colCount; j++){
+		for(int i = 0; i < this->rowCount; i++){
+			scratch.f[i] = layerValues[(std::size_t)i * this->stride + j];
+		}
+		transform(scratch, this->rowCount);
+		for(int i = 0; i < this->rowCount; i++){
+			const float distance2 = scratch.d[i];
+			layerValues[(std::size_t)i * this->stride + j] = distance2 == infinity ? far : std::sqrt(distance2);
+		}
+	}
+	for(int i = 0; i < this->rowCount; i++){
+		layerValues[(std::size_t)i * this->stride + this->colCount] = 0.0f;
+	}
+}
@@ -0,0 +1,9 @@
+#include "rrt/CostGrid.hpp"
+
+void CostGrid::reset(int layers, int rows, int cols){
+	this->layerCount = layers;
+	this->rowCount = rows;
+	this->colCount = cols;
+	this->stride = cols + 1;
+	this->values.assign((std::size_t)layers * rows * this->stride, OCCUPIED);
+}
@@ -0,0 +1,59 @@
+#include <limits>
+#include <string>
+#include "rrt/CostMapRecording.hpp"
+
+void writeCostMap(std::ostream &out, const CostGrid &costs, int goalX, int goalY, const RRTPlanner::Motion *motion){
+	const std::streamsize precision = out.precision(std::numeric_limits<float>::max_digits10);
+	if(motion != nullptr){
+		out << "motion " << motion->xx << ' ' << motion->xy << ' ' << motion->x0 << ' ' << motion->yx << ' ' << motion->yy << ' '
+			<< motion->y0 << ' ' << motion->layers << '\n';
+	}
+	out << "costmap " << costs.layers() << ' ' << costs.rows() << ' ' << costs.cols() << ' ' << goalX << ' ' << goalY << '\n';
+	for(int k = 0; k < costs.layers(); k++){
+		for(int i = 0; i < costs.rows(); i++){
+			const float *row = costs.row(k, i);
+			for(int j = 0; j < costs.cols(); j++){
+				out << (j == 0 ? "" : " ") << row[j];
+			}
+			out << '\n';
+		}
+	}
+	out.precision(precision);
+}
+
+bool readCostMap(std::istream &in, CostGrid &costs, int &goalX, int &goalY, std::optional< RRTPlanner::Motion > &motion){
+	std::string tag;
+	int layers, rows, cols;
+	if(!(in >> tag)){
+		return false;
+	}
+	motion.reset();
+	if(tag == "motion"){
+		RRTPlanner::Motion moved;
+		if(!(in >> moved.xx >> moved.xy >> moved.x0 >> moved.yx >> moved.yy >> moved.y0 >> moved.layers >> tag)){
+			in.clear(in.rdstate() & ~std::ios::eofbit); // A motion with no map after it is malformed too
+			in.setstate(std::ios::failbit);
+			return false;
+		}
+		motion = moved;
+	}
+	if(tag != "costmap" || !(in >> layers >> rows >> cols >> goalX >> goalY) || layers < 0 || rows < 0 || cols < 0){
+		in.setstate(std::ios::failbit);
+		return false;
+	}
+
+	costs.reset(layers, rows, cols);
+	for(int k = 0; k < layers; k++){
+		for(int i = 0; i < rows; i++){
+			float *row = costs.row(k, i);
+			for(int j = 0; j < cols; j++){
+				if(!(in >> row[j])){
+					in.clear(in.rdstate() & ~std::ios::eofbit); // A cut-off map is malformed, not the end
+					in.setstate(std::ios::failbit);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
@@ -14,7 +14,11 @@
 #include <random>
 #include<cmath>
 #include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include "nova_trace/Trace.hpp"
 #include "rrt/RRTNode.hpp"
+#include "rrt/CostMapRecording.hpp"
 
 using geometry_msgs::msg::Point;
 using geometry_msgs::msg::Quaternion;
@@ -24,9 +28,8 @@ using geometry_msgs::msg::Vector3;
 using std_msgs::msg::Header;
 using nav_msgs::msg::Path;
 using builtin_interfaces::msg::Time;
-using nova_msgs::msg::Egma;
-using nova_msgs::msg::EvidentialGrid;
-using nova_msgs::msg::EvidentialGridOccupancy;
+using nova_msgs::msg::GridTensor;
+using navigator::grid_tensor::GridTensorView;
 using nova_msgs::msg::GoalPosition;
 using nova_msgs::msg::RrtPath;
 using std::placeholders::_1;
@@ -35,9 +38,35 @@ using std::placeholders::_1;
 
 RRTNode::RRTNode() : Node("rrt_node") {
 
-	this->goal.x = (-1);
-	this->goal.y = (-1);
-	this->goal.index = (-1);
+	RRTPlanner::Options options;
+	options.rrtStar = this->declare_parameter<bool>("rrt_star", false);
+	options.timeBudgetMs = this->declare_parameter<double>("time_budget_ms", 0.0);
+	options.maxIterations = this->declare_parameter<int>("max_iterations", 1000);
+	// A negative seed draws a new one from the clock each planning cycle
+	options.seed = this->declare_parameter<int>("seed", -1);
+	options.expansionBatch = this->declare_parameter<int>("expansion_batch", 1);
+	options.expansionThreads = this->declare_parameter<int>("expansion_threads", 1);
+	// Moves the last tree by the vehicle's motion between cost maps, from
+	// the map frame to the cost maps' as tf has it
+	options.warmStart = this->declare_parameter<bool>("warm_start", false);
+	this->warmStart = options.warmStart;
+	this->mapFrame = this->declare_parameter<std::string>("map_frame", "map");
+	options.maxDistanceToExplore = this->maxDistanceToExplore;
+	// In cells of the cost map
+	options.footprintRadius = this->declare_parameter<double>("footprint_radius", 0.0);
+	options.clearanceWeight = this->declare_parameter<double>("clearance_weight", 0.0);
+	this->planner = std::make_unique<RRTPlanner>(options);
+
+	const std::string recordPath = this->declare_parameter<std::string>("record_path", "");
+	if(!recordPath.empty()){
+		this->recording.open(recordPath);
+		if(!this->recording){
+			RCLCPP_ERROR(this->get_logger(), "could not open %s to record cost maps", recordPath.c_str());
+		}
+	}
+
+	this->tfBuffer = std::make_unique<tf2_ros::Buffer>(this->get_clock());
+	this->tfListener = std::make_shared<tf2_ros::TransformListener>(*this->tfBuffer);
 
 	//this->fakeCostMapPub = this->create_publisher<Egma>("/planning/cost_map", 10);
 	//this->fakeGoalPup = this->create_publisher<GoalPosition>("/planning/goal_position", 10);
@@ -45,7 +74,8 @@ RRTNode::RRTNode() : Node("rrt_node") {
 
 	//this->rrt_path_pub = this->create_publisher<RrtPath>("/planning/rrt_path_temp", 10);
 	this->rrt_path_publisher = this->create_publisher<Path>("/planning/rrt_path", 10);
-  	this->cost_map_sub = this->create_subscription<Egma>("/planning/cost_map", 5, std::bind(&RRTNode::findPath, this, _1));
+  	this->cost_map_sub = this->create_subscription<GridTensor>("/planning/cost_map", 5, std::bind(&RRTNode::findPath, this, _1));
+	this->latencyRecorder = std::make_unique<navigator::latency_tracker::StageRecorder>(*this, "rrt", this->rrt_path_publisher->get_topic_name());
 	/*this->goal_position_sub = this->create_subscription<GoalPosition>("/planning/goal_position", 1, [this](GoalPosition::SharedPtr msg) {
 		this->goal.x = (int)msg->goal_point.x;
 		this->goal.y = (int)msg->goal_point.y;
@@ -91,154 +121,129 @@ RRTNode::RRTNode() : Node("rrt_node") {
 	
 }
 
-void RRTNode::findRandomPair(int gridSize_x, int gridSize_y){
-	int i = rand() % gridSize_x;
-	int j = rand() % gridSize_y;
-	this->randomPoint = std::make_pair(i,j);
-	return;
-}
-
-void RRTNode::findClosestState(TreeNode *head){
-	if(head == nullptr){
-		return;
-	}
-	
-	float temp_min = pow(head->x - this->randomPoint.first,2) + pow(head->y - this->randomPoint.second,2);
-	
-	if(temp_min < this->currentMinCostForSingleNode && head->x>=randomPoint.first){
-		this->currentMinCostForSingleNode = temp_min;
-		this->closest = head;
-	}
-
-	for(int i=0; i<(int)head->children.size();i++){
-		findClosestState(&head->children[i]);
+// The map's layers in a CostGrid, a row at a time
+static void copyCostMap(const GridTensorView &map, CostGrid &costs){
+	costs.reset((int)map.layers(), (int)map.rows(), (int)map.cols());
+	for(uint32_t k = 0; k < map.layers(); k++){
+		for(uint32_t i = 0; i < map.rows(); i++){
+			map.copy_row(k, i, costs.row((int)k, (int)i));
+		}
 	}
-
-	return;
 }
 
-void RRTNode::addNewRRTNode(Egma::SharedPtr map){
-	std::pair<int,int> best(this->currentPosition.x, this->currentPosition.y);
-
-	findRandomPair(map->egma[0].grid.size(), map->egma[0].grid[0].occupancy_value.size());
-	//RCLCPP_WARN(this->get_logger(), "random point: x: %i, y: %i", this->randomPoint.first, this->randomPoint.second);
-
-	this->currentMinCostForSingleNode = std::numeric_limits<float>::max();
-	findClosestState(&this->currentPosition);
-	//RCLCPP_WARN(this->get_logger(), "closest state: x: %i, y: %i index: %i", this->closest->x, this->closest->y, this->closest->index);
-	//RCLCPP_WARN(this->get_logger(), "closest state address:  %p", (void*)&closest);
-
-	float nodeMinOccupancyValue = 1;
-	int k = this->closest->index+1;
+static double yawOf(const Quaternion &q){
+	return std::atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z));
+}
 
-	if(k >= (int)map->egma.size()){
-		return;
+// Finds how the vehicle moved since the last cost map, as where the last
+// map's cells and layers are in this one's. False if that's unknown (no tf
+// yet, or this is the first map), in which case the plan starts from
+// scratch.
+bool RRTNode::vehicleMotion(const GridTensor &map, RRTPlanner::Motion &motion){
+	GridPose grid;
+	try{
+		// The map's frame, as of the map's time, is usually base_link
+		const geometry_msgs::msg::TransformStamped t = this->tfBuffer->lookupTransform(this->mapFrame, map.header.frame_id,
+			tf2_ros::fromRclcpp(rclcpp::Time(map.header.stamp)));
+		const double frameYaw = yawOf(t.transform.rotation);
+		const double originYaw = yawOf(map.origin.orientation);
+		grid.x = t.transform.translation.x + std::cos(frameYaw) * map.origin.position.x - std::sin(frameYaw) * map.origin.position.y;
+		grid.y = t.transform.translation.y + std::sin(frameYaw) * map.origin.position.x + std::cos(frameYaw) * map.origin.position.y;
+		grid.yaw = frameYaw + originYaw;
+	}catch(const tf2::TransformException &ex){
+		RCLCPP_INFO_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+			"Could not get %s->%s tf: %s. The RRT will not warm-start.", map.header.frame_id.c_str(), this->mapFrame.c_str(), ex.what());
+		this->hasLastGrid = false;
+		return false;
 	}
 
-	int column = this->closest->y-this->maxDistanceToExplore;
-	if(column < 0){
-		column = 0;
-	}
-	
-	for (int i=this->closest->x; i>=(this->closest->x-this->maxDistanceToExplore) && i>=0; i--){
-		for(int j=column; j<(this->closest->y+this->maxDistanceToExplore) && j<= (int)map->egma[k].grid[i].occupancy_value.size(); j++){
-			if (map->egma[k].grid[i].occupancy_value[j] <= 0.5){
-				if(map->egma[k].grid[i].occupancy_value[j] <= nodeMinOccupancyValue){
-					if((pow((this->randomPoint.first - i),2) + pow((this->randomPoint.second- j),2)) < (pow((this->randomPoint.first - best.first),2) + pow((this->randomPoint.second - best.second),2))){
-						best = std::make_pair(i,j);
-						nodeMinOccupancyValue = map->egma[k].grid[i].occupancy_value[j];
-					}
+	const bool known = this->hasLastGrid && !this->lastStamps.empty() && !map.stamps.empty() && map.resolution > 0;
+	if(known){
+		// Cell (x, y) is row x, column y, centred at ((y + 0.5) * resolution,
+		// (x + 0.5) * resolution) of its grid. Through the map frame into
+		// this grid, and back into cells:
+		const GridPose &last = this->lastGrid;
+		auto moved = [&](double x, double y){
+			const double px = (y + 0.5) * this->lastResolution;
+			const double py = (x + 0.5) * this->lastResolution;
+			const double dx = last.x + std::cos(last.yaw) * px - std::sin(last.yaw) * py - grid.x;
+			const double dy = last.y + std::sin(last.yaw) * px + std::cos(last.yaw) * py - grid.y;
+			const double qx = std::cos(grid.yaw) * dx + std::sin(grid.yaw) * dy;
+			const double qy = -std::sin(grid.yaw) * dx + std::cos(grid.yaw) * dy;
+			return std::make_pair(qy / map.resolution - 0.5, qx / map.resolution - 0.5);
+		};
+		const std::pair<double,double> origin = moved(0, 0);
+		const std::pair<double,double> alongX = moved(1, 0);
+		const std::pair<double,double> alongY = moved(0, 1);
+		motion.x0 = (float)origin.first;
+		motion.y0 = (float)origin.second;
+		motion.xx = (float)(alongX.first - origin.first);
+		motion.yx = (float)(alongX.second - origin.second);
+		motion.xy = (float)(alongY.first - origin.first);
+		motion.yy = (float)(alongY.second - origin.second);
+
+		// This map's first layer is the last map's layer nearest it in time
+		const rclcpp::Time first(map.stamps[0]);
+		double nearest = std::numeric_limits<double>::infinity();
+		motion.layers = -1;
+		if(first >= rclcpp::Time(this->lastStamps[0])){
+			for(int k = 0; k < (int)this->lastStamps.size(); k++){
+				const double apart = std::abs((first - rclcpp::Time(this->lastStamps[k])).seconds());
+				if(apart < nearest){
+					nearest = apart;
+					motion.layers = k;
 				}
 			}
 		}
 	}
 
-	if(best.first == this->closest->x && best.second == this->closest->y){
-		return;
-	}
-	//RCLCPP_WARN(this->get_logger(), "best state: x: %i, y: %i", best.first, best.second);
-
-	TreeNode toAppend(best.first,best.second,k);
-	if(toAppend.x == this->goal.x && toAppend.y == this->goal.y){
-		this->iteration = 1000;
-		toAppend.goal= true;
-	}
-	this->closest->children.push_back(toAppend);
-	//RCLCPP_WARN(this->get_logger(), "children size: %i", (int)this->closest->children.size());
-	//RCLCPP_WARN(this->get_logger(), "child: x: %i y: %i \n", this->closest->children[0].x, (int)this->closest->children[0].y);
-
-	return;
-}
-
-void RRTNode::createPaths(Egma::SharedPtr map){
-	srand( static_cast<unsigned int>(time(nullptr))) ;
-	
-	while(this->iteration < 1000){
-		addNewRRTNode(map);
-		iteration++;
-	}
-	
-	return;
+	this->lastGrid = grid;
+	this->lastResolution = map.resolution;
+	this->lastStamps = map.stamps;
+	this->hasLastGrid = true;
+	return known;
 }
 
-void RRTNode::bestPath(TreeNode *head, float total, std::vector< TreeNode > path, Egma::SharedPtr map){
-	if(head == nullptr){
-		if(total< this->tempPathCost){
-			this->finalRRTPath = path;
-			this->tempPathCost = total;
-		}
-		return;
-	}
-	
-	std::vector<TreeNode> tempPath(path.begin(), path.end());
-	tempPath.push_back(*head);
+void RRTNode::findPath(GridTensor::SharedPtr map){
+	/*while(this->goal.x == (-1)){
+		RCLCPP_WARN(this->get_logger(), "in while: ");
+	}*/
 
-	if(head->x ==this->goal.x && head->y ==this->goal.y){
-		this->finalRRTPath = tempPath;
-		this->tempPathCost=-1;
+	NOVA_TRACE_SPAN("rrt.find_path", navigator::trace::flow_id(map->header.stamp));
+	std::unique_ptr< GridTensorView > view;
+	try{
+		view = std::make_unique< GridTensorView >(*map);
+	}catch(const std::invalid_argument &error){
+		RCLCPP_WARN(this->get_logger(), "dropping a cost map: %s", error.what());
 		return;
 	}
-
-	total+=map->egma[head->index].grid[head->x].occupancy_value[head->y];
-
-	for(int i =0; i< (int)head->children.size();i++){
-		bestPath(&head->children[i], total, tempPath, map);
+	navigator::latency_tracker::StageRecorder::Run latencyRun = this->latencyRecorder->start();
+	latencyRun.input(this->cost_map_sub->get_topic_name(), map->header.stamp);
+	const int goalX = map->goal_point.x;
+	const int goalY = map->goal_point.y;
+	{
+		NOVA_TRACE_SPAN("rrt.copy_cost_map");
+		copyCostMap(*view, this->costs);
 	}
-	if(head->children.size() ==0){
-		bestPath(nullptr, total, tempPath, map);
+	RRTPlanner::Motion motion;
+	const bool moved = (this->warmStart || this->recording.is_open()) && vehicleMotion(*map, motion);
+	if(this->recording.is_open()){
+		writeCostMap(this->recording, this->costs, goalX, goalY, moved ? &motion : nullptr);
+		this->recording.flush();
 	}
 
-	return;
-} 
-
-void RRTNode::findPath(Egma::SharedPtr map){
-	/*while(this->goal.x == (-1)){
-		RCLCPP_WARN(this->get_logger(), "in while: ");
-	}*/
-
-	this->goal.x = map->goal_point.x;
-	this->goal.y = map->goal_point.y;
-	this->goal.index = (-1);
-
-	this->currentPosition = TreeNode(10,4, 0);
-	this->closest = &currentPosition;
-
-	this->currentMinCostForSingleNode = std::numeric_limits<float>::max();
-	this->tempPathCost = std::numeric_limits<float>::max();
-
-	this->iteration = 0;
-	this->totalLeaves = 1;
-
-	createPaths(map);
-	std::vector<TreeNode> tempVec;
-	bestPath(&this->currentPosition, 0, tempVec, map);
+	const std::vector< TreeNode > &finalRRTPath = moved
+		? this->planner->plan(this->costs, goalX, goalY, motion)
+		: this->planner->plan(this->costs, goalX, goalY);
 
 	//RrtPath msg;
 	Path tempMsg;
-	//RCLCPP_WARN(this->get_logger(), "size of path: %i", (int)this->finalRRTPath.size());
+	//RCLCPP_WARN(this->get_logger(), "size of path: %i", (int)finalRRTPath.size());
 	tempMsg.header.frame_id = "map";
+	// The path is as old as the cost map it was planned on
+	tempMsg.header.stamp = map->header.stamp;
 
-	for(int i=0; i< (int)this->finalRRTPath.size(); i++){
+	for(int i=0; i< (int)finalRRTPath.size(); i++){
 		Point pathPt;
 		PoseStamped tempPose;
 		tempPose.header.frame_id = "map";
@@ -249,11 +254,9 @@ void RRTNode::findPath(Egma::SharedPtr map){
 		tempPose.pose.position = pathPt;
 		//RCLCPP_WARN(this->get_logger(), "point: %.i with x: %.6f y: %.6f z: ", i, path_pt.x, path_pt.y, path_pt.z);
 
-		//msg.stamps.push_back(map->egma[finalRRTPath[i].index].header.stamp);
-		tempPose.header.stamp = map->egma[finalRRTPath[i].index].header.stamp;
-		//RCLCPP_WARN(this->get_logger(), "stamp: %i", map->egma[finalRRTPath[i].index].header.stamp.sec);
+		tempPose.header.stamp = view->stamp(finalRRTPath[i].index);
 
-		if(i < (int)this->finalRRTPath.size() -1){
+		if(i < (int)finalRRTPath.size() -1){
 			float changeX = finalRRTPath[i].x - finalRRTPath[i+1].x;
 			float changeY = finalRRTPath[i].y - finalRRTPath[i+1].y;
 			float theta = atan(changeX/changeY);
@@ -268,6 +271,7 @@ void RRTNode::findPath(Egma::SharedPtr map){
 
 	//this->rrt_path_pub->publish(msg);
 	this->rrt_path_publisher->publish(tempMsg);
+	latencyRun.finish(tempMsg.header.stamp);
 
 	//this->goal.x = (-1);
 	//this->goal.y = (-1);
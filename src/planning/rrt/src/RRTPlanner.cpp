@@ -0,0 +1,544 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <limits>
+#include "nova_trace/Trace.hpp"
+#include "rrt/RRTPlanner.hpp"
+
+RRTPlanner::RRTPlanner(const Options &options) : options(options) {
+	this->options.expansionBatch = std::max(1, this->options.expansionBatch);
+	this->expansionPool = std::make_unique<navigator::worker_pool::WorkerPool>(std::max(1, this->options.expansionThreads));
+
+	this->goal.x = (-1);
+	this->goal.y = (-1);
+	this->goal.index = (-1);
+
+	// The tree never grows past the root and one node per iteration, on top
+	// of the nodes a warm start kept
+	const int maxNodes = (this->options.warmStart ? 2 : 1) * this->options.maxIterations + 1;
+	this->tree.reserve(maxNodes);
+	if(this->options.warmStart){
+		this->spareTree.reserve(maxNodes);
+	}
+}
+
+std::pair<int,int> RRTPlanner::findRandomPair(std::mt19937 &generator, int gridSize_x, int gridSize_y) const{
+	int i = std::uniform_int_distribution<int>(0, gridSize_x - 1)(generator);
+	int j = std::uniform_int_distribution<int>(0, gridSize_y - 1)(generator);
+	return std::make_pair(i,j);
+}
+
+// A sample from where a path shorter than the best one to the goal could
+// pass: the ellipse with the root and goal as foci and that path's length
+// as its major axis. Falls back to sampling the whole grid when the
+// ellipse is degenerate or the samples keep missing it.
+std::pair<int,int> RRTPlanner::findInformedPair(std::mt19937 &generator, int gridSize_x, int gridSize_y) const{
+	const TreeNode &root = this->tree[0];
+	const float bestLength = pathLength(bestGoal());
+	const float directLength = std::hypot(this->goal.x - root.x, this->goal.y - root.y);
+	if(!(bestLength > directLength)){
+		return findRandomPair(generator, gridSize_x, gridSize_y);
+	}
+
+	const float centerX = 0.5f * (root.x + this->goal.x);
+	const float centerY = 0.5f * (root.y + this->goal.y);
+	const float semiMajor = 0.5f * bestLength;
+	const int xMin = std::max(0, (int)std::floor(centerX - semiMajor));
+	const int xMax = std::min(gridSize_x - 1, (int)std::ceil(centerX + semiMajor));
+	const int yMin = std::max(0, (int)std::floor(centerY - semiMajor));
+	const int yMax = std::min(gridSize_y - 1, (int)std::ceil(centerY + semiMajor));
+
+	for(int attempt = 0; attempt < 16 && xMin <= xMax && yMin <= yMax; attempt++){
+		const int i = std::uniform_int_distribution<int>(xMin, xMax)(generator);
+		const int j = std::uniform_int_distribution<int>(yMin, yMax)(generator);
+		if(std::hypot(i - root.x, j - root.y) + std::hypot(i - this->goal.x, j - this->goal.y) <= bestLength){
+			return std::make_pair(i,j);
+		}
+	}
+	return findRandomPair(generator, gridSize_x, gridSize_y);
+}
+
+// Whether the search in steerNewRRTNode() could step from a node to (x, y)
+bool RRTPlanner::canReach(const TreeNode &from, int x, int y) const{
+	int column = from.y-this->options.maxDistanceToExplore;
+	if(column < 0){
+		column = 0;
+	}
+	return x <= from.x && x >= (from.x-this->options.maxDistanceToExplore) && x >= 0 && y >= column && y < (from.y+this->options.maxDistanceToExplore);
+}
+
+// The nearest node at or past the sample's x. If there is none, the closest
+// node stays where the last commit left it.
+int RRTPlanner::findClosestState(const std::pair<int,int> &randomPoint) const{
+	float distance2;
+	const int nearest = this->treeIndex.nearest(randomPoint.first, randomPoint.second, &distance2);
+	return nearest != TreeNode::NO_NODE ? nearest : this->closest;
+}
+
+// Samples a point and steers the closest node towards it, without touching
+// the tree, so several can run at once. Leaves candidate.layer at -1 if
+// there is nothing to add.
+void RRTPlanner::steerNewRRTNode(std::mt19937 &generator, Candidate &candidate) const{
+	std::pair<int,int> best(this->tree[0].x, this->tree[0].y);
+	candidate.layer = -1;
+
+	std::pair<int,int> randomPoint;
+	if(this->options.rrtStar && !this->goalNodes.empty()){
+		randomPoint = findInformedPair(generator, this->costs->rows(), this->costs->cols());
+	}else{
+		randomPoint = findRandomPair(generator, this->costs->rows(), this->costs->cols());
+	}
+
+	candidate.closest = findClosestState(randomPoint);
+
+	const TreeNode &closestNode = this->tree[candidate.closest];
+	const float footprintRadius = this->options.footprintRadius;
+	float nodeMinOccupancyValue = 1;
+	int k = closestNode.index+1;
+
+	if(k >= this->costs->layers()){
+		return;
+	}
+
+	int column = closestNode.y-this->options.maxDistanceToExplore;
+	if(column < 0){
+		column = 0;
+	}
+	// The search may run one past a row's end, onto the grid's padding
+	// column, which has no clearance and so is never chosen
+	const int firstRow = std::min(closestNode.x, this->costs->rows()-1);
+	const int lastRow = std::max((int)std::ceil(closestNode.x-this->options.maxDistanceToExplore), 0);
+	const int columnEnd = std::min((int)std::ceil(closestNode.y+this->options.maxDistanceToExplore), this->costs->cols()+1);
+	
+	for (int i=firstRow; i>=lastRow; i--){
+		for(int j=column; j<columnEnd; j++){
+			if (this->clearance.at(k, i, j) > footprintRadius){
+				const float occupancy = this->costs->at(k, i, j);
+				if(occupancy <= nodeMinOccupancyValue){
+					if((pow((randomPoint.first - i),2) + pow((randomPoint.second- j),2)) < (pow((randomPoint.first - best.first),2) + pow((randomPoint.second - best.second),2))
+						&& edgeIsFree(closestNode, i, j, k)){
+						best = std::make_pair(i,j);
+						nodeMinOccupancyValue = occupancy;
+					}
+				}
+			}
+		}
+	}
+
+	if(best.first == closestNode.x && best.second == closestNode.y){
+		return;
+	}
+	// With no free cell in reach, best is still the root's cell, which
+	// RRT* doesn't jump back to
+	if(this->options.rrtStar && !canReach(closestNode, best.first, best.second)){
+		return;
+	}
+
+	candidate.x = best.first;
+	candidate.y = best.second;
+	candidate.layer = k;
+	return;
+}
+
+// Adds a steered candidate to the tree
+void RRTPlanner::addNewRRTNode(const Candidate &candidate){
+	this->closest = candidate.closest;
+	if(candidate.layer < 0){
+		return;
+	}
+
+	if(this->options.rrtStar){
+		insertRRTStarNode(candidate.x, candidate.y, candidate.layer);
+		return;
+	}
+
+	TreeNode toAppend(candidate.x,candidate.y,candidate.layer,this->closest);
+	const int appended = (int)this->tree.size();
+	toAppend.pathCost = this->tree[this->closest].pathCost + edgeCost(this->tree[this->closest], toAppend.x, toAppend.y, toAppend.index);
+	if(toAppend.x == this->goal.x && toAppend.y == this->goal.y){
+		this->goalReached = true;
+		toAppend.goal= true;
+		this->goalNodes.push_back(appended);
+	}
+	this->tree.push_back(toAppend);
+	this->treeIndex.insert(appended, toAppend.x, toAppend.y);
+	linkChild(this->closest, appended);
+
+	return;
+}
+
+// Adds (x, y) in layer under the cheapest node of the layer before that can
+// reach it, then hands it any node of the layer after that it reaches more
+// cheaply. A cell already in the tree at that layer isn't added again, but
+// gets the same parent choice and rewiring.
+void RRTPlanner::insertRRTStarNode(int x, int y, int layer){
+	const int reach = (int)std::ceil(this->options.maxDistanceToExplore);
+
+	// Steering checked the edge from closest
+	int parent = this->closest;
+	float pathCost = this->tree[parent].pathCost + edgeCost(this->tree[parent], x, y, layer);
+	int node = TreeNode::NO_NODE;
+	this->nearby.clear();
+	this->treeIndex.within(x, x + reach, y - reach, y + reach, this->nearby);
+	for(int candidate : this->nearby){
+		const TreeNode &other = this->tree[candidate];
+		if(other.index == layer && other.x == x && other.y == y){
+			if(node == TreeNode::NO_NODE || candidate < node){
+				node = candidate;
+			}
+		}else if(other.index == layer-1 && canReach(other, x, y) && other.pathCost < pathCost){
+			const float viaOther = other.pathCost + edgeCost(other, x, y, layer);
+			if(viaOther < pathCost && edgeIsFree(other, x, y, layer)){
+				parent = candidate;
+				pathCost = viaOther;
+			}
+		}
+	}
+
+	if(node == TreeNode::NO_NODE){
+		TreeNode toAppend(x,y,layer,parent);
+		node = (int)this->tree.size();
+		toAppend.pathCost = pathCost;
+		if(toAppend.x == this->goal.x && toAppend.y == this->goal.y){
+			this->goalReached = true;
+			toAppend.goal= true;
+			this->goalNodes.push_back(node);
+		}
+		this->tree.push_back(toAppend);
+		this->treeIndex.insert(node, x, y);
+		linkChild(parent, node);
+	}else if(pathCost < this->tree[node].pathCost){
+		reparent(node, parent, pathCost);
+	}
+
+	if(layer+1 >= this->costs->layers()){
+		return;
+	}
+	this->nearby.clear();
+	this->treeIndex.within(x - reach, x, y - reach, y + reach, this->nearby);
+	for(int candidate : this->nearby){
+		const TreeNode &other = this->tree[candidate];
+		if(other.index != layer+1 || other.parent == node || !canReach(this->tree[node], other.x, other.y)){
+			continue;
+		}
+		const float viaNode = this->tree[node].pathCost + edgeCost(this->tree[node], other.x, other.y, layer+1);
+		if(viaNode < other.pathCost && edgeIsFree(this->tree[node], other.x, other.y, layer+1)){
+			reparent(candidate, node, viaNode);
+		}
+	}
+
+	return;
+}
+
+void RRTPlanner::linkChild(int parent, int child){
+	TreeNode &node = this->tree[parent];
+	if(node.lastChild == TreeNode::NO_NODE){
+		node.firstChild = child;
+	}else{
+		this->tree[node.lastChild].nextSibling = child;
+	}
+	node.lastChild = child;
+	this->tree[child].parent = parent;
+	this->tree[child].nextSibling = TreeNode::NO_NODE;
+}
+
+void RRTPlanner::unlinkChild(int parent, int child){
+	TreeNode &node = this->tree[parent];
+	int previous = TreeNode::NO_NODE;
+	for(int current = node.firstChild; current != child; current = this->tree[current].nextSibling){
+		previous = current;
+	}
+	const int next = this->tree[child].nextSibling;
+	if(previous == TreeNode::NO_NODE){
+		node.firstChild = next;
+	}else{
+		this->tree[previous].nextSibling = next;
+	}
+	if(node.lastChild == child){
+		node.lastChild = previous;
+	}
+	this->tree[child].nextSibling = TreeNode::NO_NODE;
+}
+
+// Moves node, with its subtree, under parent, where it costs pathCost. The
+// subtree's costs shift with it.
+void RRTPlanner::reparent(int node, int parent, float pathCost){
+	unlinkChild(this->tree[node].parent, node);
+	linkChild(parent, node);
+
+	const float delta = pathCost - this->tree[node].pathCost;
+	int current = node;
+	while(true){
+		this->tree[current].pathCost += delta;
+		if(this->tree[current].firstChild != TreeNode::NO_NODE){
+			current = this->tree[current].firstChild;
+			continue;
+		}
+		while(current != node && this->tree[current].nextSibling == TreeNode::NO_NODE){
+			current = this->tree[current].parent;
+		}
+		if(current == node){
+			break;
+		}
+		current = this->tree[current].nextSibling;
+	}
+}
+
+// Length in cells of the path from the root to node
+float RRTPlanner::pathLength(int node) const{
+	float length = 0;
+	for(int parent = this->tree[node].parent; parent != TreeNode::NO_NODE; node = parent, parent = this->tree[node].parent){
+		length += std::hypot(this->tree[node].x - this->tree[parent].x, this->tree[node].y - this->tree[parent].y);
+	}
+	return length;
+}
+
+// The cheapest node at the goal, the first of equally cheap ones, or NO_NODE
+int RRTPlanner::bestGoal() const{
+	int best = TreeNode::NO_NODE;
+	for(int node : this->goalNodes){
+		if(best == TreeNode::NO_NODE || this->tree[node].pathCost < this->tree[best].pathCost){
+			best = node;
+		}
+	}
+	return best;
+}
+
+// Grows the tree in rounds of expansionBatch samples. Each sample of a
+// round is steered against the tree as the round found it, on a worker of
+// its own and with its own generator, then the round's candidates are
+// added in order. The tree hence depends on the seed and batch size, not on
+// the thread count.
+void RRTPlanner::createPaths(){
+	const unsigned int seed = this->options.seed >= 0 ? (unsigned int)this->options.seed : static_cast<unsigned int>(time(nullptr));
+	this->generators.resize(this->options.expansionBatch);
+	this->candidates.resize(this->options.expansionBatch);
+	for(int slot = 0; slot < this->options.expansionBatch; slot++){
+		std::seed_seq slotSeed{seed, (unsigned int)slot};
+		this->generators[slot].seed(slotSeed);
+	}
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(this->options.timeBudgetMs);
+	while(this->iteration < this->options.maxIterations && (this->options.rrtStar || !this->goalReached)){
+		if(this->options.timeBudgetMs > 0 && std::chrono::steady_clock::now() >= deadline){
+			break;
+		}
+		const int batch = std::min(this->options.expansionBatch, this->options.maxIterations - this->iteration);
+		this->expansionPool->run(batch, [&](int slot){
+			steerNewRRTNode(this->generators[slot], this->candidates[slot]);
+		});
+		for(int slot = 0; slot < batch && (this->options.rrtStar || !this->goalReached); slot++){
+			addNewRRTNode(this->candidates[slot]);
+			iteration++;
+		}
+	}
+	
+	return;
+}
+
+// The end of the path to publish: the cheapest node at the goal if the
+// tree reached it, else the leaf with the least path cost, the first
+// in depth-first order of equally cheap ones. Walks the tree through its
+// links, without recursing.
+int RRTPlanner::bestPath() const{
+	if(!this->goalNodes.empty()){
+		return bestGoal();
+	}
+
+	int best = TreeNode::NO_NODE;
+	float bestCost = std::numeric_limits<float>::max();
+	int node = 0;
+	while(node != TreeNode::NO_NODE){
+		const TreeNode &current = this->tree[node];
+		if(current.firstChild != TreeNode::NO_NODE){
+			node = current.firstChild;
+			continue;
+		}
+		if(current.pathCost < bestCost){
+			best = node;
+			bestCost = current.pathCost;
+		}
+		// Up to the nearest ancestor with a sibling still to visit
+		while(node != TreeNode::NO_NODE && this->tree[node].nextSibling == TreeNode::NO_NODE){
+			node = this->tree[node].parent;
+		}
+		if(node != TreeNode::NO_NODE){
+			node = this->tree[node].nextSibling;
+		}
+	}
+
+	return best;
+}
+
+// Whether a node could still be added at (x, y) of layer
+bool RRTPlanner::isFree(int layer, int x, int y) const{
+	return this->costs->contains(layer, x, y) && this->clearance.at(layer, x, y) > this->options.footprintRadius;
+}
+
+// Whether the footprint stays clear of obstacles in layer all the way from
+// a node of the layer before to (x, y). Steps along the edge by as much as
+// the clearance at each cell allows, less half a cell for rounding to it,
+// so an edge in the open is one or two lookups. The node's own cell was
+// checked as it was added, or is where the vehicle is, so the walk starts
+// a cell away from it.
+bool RRTPlanner::edgeIsFree(const TreeNode &from, int x, int y, int layer) const{
+	const float length = std::hypot(x - from.x, y - from.y);
+	float travelled = std::min(1.0f, length);
+	while(true){
+		const float t = length > 0 ? std::min(travelled / length, 1.0f) : 1.0f;
+		const int i = (int)std::lround(from.x + t * (x - from.x));
+		const int j = (int)std::lround(from.y + t * (y - from.y));
+		const float clearance = this->costs->contains(layer, i, j) ? this->clearance.at(layer, i, j) : 0.0f;
+		if(clearance <= this->options.footprintRadius){
+			return false;
+		}
+		if(t >= 1.0f){
+			return true;
+		}
+		travelled += std::max(0.5f, clearance - this->options.footprintRadius - 0.5f);
+	}
+}
+
+// The cost of the edge from a node of the layer before to (x, y) of layer:
+// the cells along it, about one per cell of length, each weighted by the
+// length it stands for. An edge costs at least its end cell, as staying in
+// a cell for a layer does.
+float RRTPlanner::edgeCost(const TreeNode &from, int x, int y, int layer) const{
+	const float length = std::hypot(x - from.x, y - from.y);
+	const int steps = std::max(1, (int)std::ceil(length));
+	float cost = 0;
+	for(int step = 1; step <= steps; step++){
+		const float t = (float)step / steps;
+		const int i = (int)std::lround(from.x + t * (x - from.x));
+		const int j = (int)std::lround(from.y + t * (y - from.y));
+		cost += this->costs->at(layer, i, j);
+		if(this->options.clearanceWeight > 0){
+			cost += this->options.clearanceWeight / std::max(this->clearance.at(layer, i, j), 0.5f);
+		}
+	}
+	return cost * std::max(length, 1.0f) / steps;
+}
+
+// Replaces the tree with what of it is still valid on the current cost
+// map once moved by motion: a new root at the current position, under it
+// every moved node now of the layer after the root's, and under those
+// every node whose parent is kept. A node is kept on a free cell within
+// steering reach of its parent and with a free edge from it, with costs
+// summed again on the new map. Nodes of layers now past are dropped but
+// their children still considered. Nodes keep their preorder, so a cap on
+// how many are kept drops whole subtrees.
+void RRTPlanner::keepFreeSubtrees(const Motion &motion, float rootCost){
+	const int maxKept = std::max(1, this->options.maxIterations);
+	this->spareTree.clear();
+	this->keptAs.assign(this->tree.size(), TreeNode::NO_NODE);
+	this->spareTree.emplace_back(10,4, 0, TreeNode::NO_NODE);
+	this->spareTree[0].pathCost = rootCost;
+
+	int node = 0;
+	while(node != TreeNode::NO_NODE){
+		const TreeNode &current = this->tree[node];
+		const int layer = current.index - motion.layers;
+		bool descend = layer < 1;
+		if(!descend && (int)this->spareTree.size() < maxKept && layer < this->costs->layers()){
+			const int parent = layer == 1 ? 0 : this->keptAs[current.parent];
+			const int x = (int)std::lround(motion.xx * current.x + motion.xy * current.y + motion.x0);
+			const int y = (int)std::lround(motion.yx * current.x + motion.yy * current.y + motion.y0);
+			if(parent != TreeNode::NO_NODE && isFree(layer, x, y) && canReach(this->spareTree[parent], x, y)
+				&& edgeIsFree(this->spareTree[parent], x, y, layer)){
+				TreeNode kept(x, y, layer, parent);
+				kept.pathCost = this->spareTree[parent].pathCost + edgeCost(this->spareTree[parent], x, y, layer);
+				this->keptAs[node] = (int)this->spareTree.size();
+				this->spareTree.push_back(kept);
+				descend = true;
+			}
+		}
+		if(descend && current.firstChild != TreeNode::NO_NODE){
+			node = current.firstChild;
+			continue;
+		}
+		// Past a dropped node's subtree, or up to the nearest ancestor with
+		// a sibling still to visit
+		while(node != TreeNode::NO_NODE && this->tree[node].nextSibling == TreeNode::NO_NODE){
+			node = this->tree[node].parent;
+		}
+		if(node != TreeNode::NO_NODE){
+			node = this->tree[node].nextSibling;
+		}
+	}
+
+	std::swap(this->tree, this->spareTree);
+	for(int child = 1; child < (int)this->tree.size(); child++){
+		linkChild(this->tree[child].parent, child);
+	}
+}
+
+const std::vector< TreeNode > &RRTPlanner::plan(const CostGrid &costs, int goalX, int goalY){
+	return planImpl(costs, goalX, goalY, nullptr);
+}
+
+const std::vector< TreeNode > &RRTPlanner::plan(const CostGrid &costs, int goalX, int goalY, const Motion &motion){
+	return planImpl(costs, goalX, goalY, &motion);
+}
+
+const std::vector< TreeNode > &RRTPlanner::planImpl(const CostGrid &costs, int goalX, int goalY, const Motion *motion){
+	this->costs = &costs;
+	{
+		NOVA_TRACE_SPAN("rrt.clearance_field");
+		this->clearance.compute(costs, *this->expansionPool);
+	}
+	this->goal.x = goalX;
+	this->goal.y = goalY;
+	this->goal.index = (-1);
+
+	const float rootCost = costs.contains(0, 10, 4) ? costs.at(0, 10, 4) : CostGrid::OCCUPIED;
+	if(this->options.warmStart && motion != nullptr && motion->layers >= 0 && !this->tree.empty()){
+		NOVA_TRACE_SPAN("rrt.keep_free_subtrees");
+		keepFreeSubtrees(*motion, rootCost);
+	}else{
+		this->tree.clear();
+		this->tree.emplace_back(10,4, 0, TreeNode::NO_NODE);
+		this->tree[0].pathCost = rootCost;
+	}
+	this->closest = 0;
+
+	this->goalNodes.clear();
+	this->goalReached = false;
+	for(int node = 0; node < (int)this->tree.size(); node++){
+		TreeNode &current = this->tree[node];
+		const bool atGoal = current.x == this->goal.x && current.y == this->goal.y;
+		if(atGoal){
+			this->goalNodes.push_back(node);
+		}
+		// The root at the goal doesn't end a plain RRT's search
+		current.goal = atGoal && node != 0;
+		this->goalReached = this->goalReached || current.goal;
+	}
+
+	// Nodes are grid cells, and a column may run onto the padding one past
+	// the last; the root is placed on its own
+	const TreeNode &root = this->tree[0];
+	const int gridWidth = costs.rows();
+	const int gridHeight = gridWidth == 0 ? 0 : costs.cols() + 1;
+	this->treeIndex.reset(std::max(gridWidth, root.x + 1), std::max(gridHeight, root.y + 1));
+	for(int node = 0; node < (int)this->tree.size(); node++){
+		this->treeIndex.insert(node, this->tree[node].x, this->tree[node].y);
+	}
+
+	this->iteration = 0;
+
+	{
+		NOVA_TRACE_SPAN("rrt.create_paths");
+		createPaths();
+	}
+	navigator::trace::counter("rrt.tree_nodes", (double)this->tree.size());
+
+	this->finalRRTPath.clear();
+	for(int node = bestPath(); node != TreeNode::NO_NODE; node = this->tree[node].parent){
+		this->finalRRTPath.push_back(this->tree[node]);
+	}
+	std::reverse(this->finalRRTPath.begin(), this->finalRRTPath.end());
+
+	this->costs = nullptr;
+	return this->finalRRTPath;
+}
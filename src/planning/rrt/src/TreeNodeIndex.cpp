@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <limits>
+#include "rrt/TreeNodeIndex.hpp"
+
+void TreeNodeIndex::reset(int width, int height){
+	this->bucketsX = std::max(1, (width + BUCKET_SIZE - 1) / BUCKET_SIZE);
+	this->bucketsY = std::max(1, (height + BUCKET_SIZE - 1) / BUCKET_SIZE);
+	if((int)this->buckets.size() < this->bucketsX * this->bucketsY){
+		this->buckets.resize(this->bucketsX * this->bucketsY);
+	}
+	for(std::vector< Entry > &bucket : this->buckets){
+		bucket.clear();
+	}
+	this->empty = true;
+}
+
+int TreeNodeIndex::bucketOf(int cell, int bucketCount) const{
+	return std::min(std::max(cell / BUCKET_SIZE, 0), bucketCount - 1);
+}
+
+void TreeNodeIndex::insert(int node, int x, int y){
+	const int bx = bucketOf(x, this->bucketsX);
+	const int by = bucketOf(y, this->bucketsY);
+	this->buckets[bx * this->bucketsY + by].push_back(Entry{node, x, y});
+	this->maxX = this->empty ? x : std::max(this->maxX, x);
+	this->empty = false;
+}
+
+int TreeNodeIndex::nearest(int x, int y, float *distance2) const{
+	// Else every bucket would be searched to find nothing
+	if(this->empty || x > this->maxX){
+		return NO_NODE;
+	}
+
+	const int bx0 = bucketOf(x, this->bucketsX);
+	const int by0 = bucketOf(y, this->bucketsY);
+
+	int best = NO_NODE;
+	long long bestDistance2 = std::numeric_limits<long long>::max();
+	auto visit = [&](int bx, int by){
+		// Every cell of a bucket left of x fails the filter
+		if((bx + 1) * BUCKET_SIZE - 1 < x && bx != this->bucketsX - 1){
+			return;
+		}
+		for(const Entry &entry : this->buckets[bx * this->bucketsY + by]){
+			if(entry.x < x){
+				continue;
+			}
+			const long long dx = entry.x - x;
+			const long long dy = entry.y - y;
+			const long long d2 = dx * dx + dy * dy;
+			if(d2 < bestDistance2 || (d2 == bestDistance2 && entry.node < best)){
+				bestDistance2 = d2;
+				best = entry.node;
+			}
+		}
+	};
+
+	const int maxRing = std::max(this->bucketsX, this->bucketsY);
+	for(int ring = 0; ring <= maxRing; ring++){
+		// Cells in ring r buckets out are at least (r - 1) * BUCKET_SIZE + 1
+		// cells away along one axis. Clamping only moves a position further
+		// out, so this holds for positions outside the cells too.
+		if(best != NO_NODE && ring > 0){
+			const long long reach = (long long)(ring - 1) * BUCKET_SIZE + 1;
+			if(reach * reach > bestDistance2){
+				break;
+			}
+		}
+		const int bxStart = std::max(bx0 - ring, 0);
+		const int bxEnd = std::min(bx0 + ring, this->bucketsX - 1);
+		for(int bx = bxStart; bx <= bxEnd; bx++){
+			if(bx == bx0 - ring || bx == bx0 + ring){
+				// A full column of the ring
+				for(int by = std::max(by0 - ring, 0); by <= std::min(by0 + ring, this->bucketsY - 1); by++){
+					visit(bx, by);
+				}
+			}else{
+				if(by0 - ring >= 0){
+					visit(bx, by0 - ring);
+				}
+				if(ring > 0 && by0 + ring < this->bucketsY){
+					visit(bx, by0 + ring);
+				}
+			}
+		}
+	}
+
+	if(best != NO_NODE && distance2 != nullptr){
+		*distance2 = (float)bestDistance2;
+	}
+	return best;
+}
+
+void TreeNodeIndex::within(int xMin, int xMax, int yMin, int yMax, std::vector< int > &nodes) const{
+	if(xMin > xMax || yMin > yMax){
+		return;
+	}
+	const int bxEnd = bucketOf(xMax, this->bucketsX);
+	const int byEnd = bucketOf(yMax, this->bucketsY);
+	for(int bx = bucketOf(xMin, this->bucketsX); bx <= bxEnd; bx++){
+		for(int by = bucketOf(yMin, this->bucketsY); by <= byEnd; by++){
+			for(const Entry &entry : this->buckets[bx * this->bucketsY + by]){
+				if(entry.x >= xMin && entry.x <= xMax && entry.y >= yMin && entry.y <= yMax){
+					nodes.push_back(entry.node);
+				}
+			}
+		}
+	}
+}
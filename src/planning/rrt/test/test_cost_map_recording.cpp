@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <optional>
+#include <sstream>
+
+#include "rrt/CostGrid.hpp"
+#include "rrt/CostMapRecording.hpp"
+#include "rrt/RRTPlanner.hpp"
+
+TEST(CostMapRecording, ReplaysMapsAndMotionsExactly){
+	CostGrid costs;
+	costs.reset(2, 3, 4);
+	for(int k = 0; k < 2; k++){
+		for(int i = 0; i < 3; i++){
+			for(int j = 0; j < 4; j++){
+				costs.row(k, i)[j] = 0.1f * (k + i) + 0.01f * j;
+			}
+		}
+	}
+	RRTPlanner::Motion motion;
+	motion.xx = 0.8f;
+	motion.xy = -0.6f;
+	motion.x0 = 1.25f;
+	motion.yx = 0.6f;
+	motion.yy = 0.8f;
+	motion.y0 = -0.1f;
+	motion.layers = 2;
+
+	std::stringstream recording;
+	writeCostMap(recording, costs, 1, 2, nullptr);
+	writeCostMap(recording, costs, 0, 3, &motion);
+
+	CostGrid replayed;
+	int goalX, goalY;
+	std::optional< RRTPlanner::Motion > replayedMotion;
+	ASSERT_TRUE(readCostMap(recording, replayed, goalX, goalY, replayedMotion));
+	EXPECT_EQ(goalX, 1);
+	EXPECT_EQ(goalY, 2);
+	EXPECT_FALSE(replayedMotion);
+	ASSERT_TRUE(readCostMap(recording, replayed, goalX, goalY, replayedMotion));
+	EXPECT_EQ(goalX, 0);
+	EXPECT_EQ(goalY, 3);
+	ASSERT_TRUE(replayedMotion);
+	EXPECT_EQ(replayedMotion->xx, motion.xx);
+	EXPECT_EQ(replayedMotion->xy, motion.xy);
+	EXPECT_EQ(replayedMotion->x0, motion.x0);
+	EXPECT_EQ(replayedMotion->yx, motion.yx);
+	EXPECT_EQ(replayedMotion->yy, motion.yy);
+	EXPECT_EQ(replayedMotion->y0, motion.y0);
+	EXPECT_EQ(replayedMotion->layers, motion.layers);
+	ASSERT_EQ(replayed.layers(), 2);
+	ASSERT_EQ(replayed.rows(), 3);
+	ASSERT_EQ(replayed.cols(), 4);
+	for(int k = 0; k < 2; k++){
+		for(int i = 0; i < 3; i++){
+			for(int j = 0; j < 4; j++){
+				EXPECT_EQ(replayed.at(k, i, j), costs.at(k, i, j));
+			}
+		}
+	}
+
+	EXPECT_FALSE(readCostMap(recording, replayed, goalX, goalY, replayedMotion));
+	EXPECT_TRUE(recording.eof());
+}
+
+TEST(CostMapRecording, RejectsAMotionWithNoMap){
+	std::stringstream recording("motion 1 0 0 0 1 0 0\n");
+	CostGrid costs;
+	int goalX, goalY;
+	std::optional< RRTPlanner::Motion > motion;
+	EXPECT_FALSE(readCostMap(recording, costs, goalX, goalY, motion));
+	EXPECT_FALSE(recording.eof());
+}
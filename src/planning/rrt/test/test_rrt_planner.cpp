@@ -0,0 +1,313 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "rrt/CostGrid.hpp"
+#include "rrt/RRTPlanner.hpp"
+
+namespace {
+
+// Layers of rows x cols cells at the same occupancy everywhere
+CostGrid uniformGrid(int layers, int rows, int cols, float occupancy){
+	CostGrid costs;
+	costs.reset(layers, rows, cols);
+	for(int k = 0; k < layers; k++){
+		for(int i = 0; i < rows; i++){
+			float *row = costs.row(k, i);
+			for(int j = 0; j < cols; j++){
+				row[j] = occupancy;
+			}
+		}
+	}
+	return costs;
+}
+
+// Occupies row of every layer, but for columns [gapBegin, gapEnd)
+void addWall(CostGrid &costs, int row, int gapBegin, int gapEnd){
+	for(int k = 0; k < costs.layers(); k++){
+		float *cells = costs.row(k, row);
+		for(int j = 0; j < costs.cols(); j++){
+			cells[j] = j >= gapBegin && j < gapEnd ? 0.0f : CostGrid::OCCUPIED;
+		}
+	}
+}
+
+RRTPlanner::Options seeded(bool rrtStar){
+	RRTPlanner::Options options;
+	options.rrtStar = rrtStar;
+	options.seed = 1;
+	return options;
+}
+
+// Whether every node steps a layer on from its parent, and the child lists
+// hold exactly the nodes that name each node their parent
+void expectWellFormed(const std::vector< TreeNode > &tree){
+	ASSERT_FALSE(tree.empty());
+	EXPECT_EQ(tree[0].parent, TreeNode::NO_NODE);
+	EXPECT_EQ(tree[0].index, 0);
+	std::vector< int > children(tree.size(), 0);
+	for(int node = 1; node < (int)tree.size(); node++){
+		const TreeNode &parent = tree[tree[node].parent];
+		EXPECT_EQ(tree[node].index, parent.index + 1) << "node " << node;
+		EXPECT_GE(tree[node].pathCost, parent.pathCost);
+		children[tree[node].parent]++;
+	}
+	for(int node = 0; node < (int)tree.size(); node++){
+		int linked = 0;
+		for(int child = tree[node].firstChild; child != TreeNode::NO_NODE; child = tree[child].nextSibling){
+			EXPECT_EQ(tree[child].parent, node);
+			linked++;
+		}
+		EXPECT_EQ(linked, children[node]) << "node " << node;
+	}
+}
+
+bool samePath(const std::vector< TreeNode > &a, const std::vector< TreeNode > &b){
+	if(a.size() != b.size()){
+		return false;
+	}
+	for(std::size_t node = 0; node < a.size(); node++){
+		if(a[node].x != b[node].x || a[node].y != b[node].y || a[node].index != b[node].index){
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+
+TEST(RRTPlanner, ReachesTheGoalInFreeSpace){
+	const CostGrid costs = uniformGrid(8, 12, 9, 0.0f);
+	RRTPlanner planner(seeded(false));
+	const std::vector< TreeNode > path = planner.plan(costs, 0, 4);
+
+	ASSERT_TRUE(planner.reachedGoal());
+	ASSERT_GE(path.size(), 2u);
+	EXPECT_EQ(path.front().x, 10);
+	EXPECT_EQ(path.front().y, 4);
+	EXPECT_EQ(path.front().index, 0);
+	EXPECT_EQ(path.back().x, 0);
+	EXPECT_EQ(path.back().y, 4);
+	EXPECT_TRUE(path.back().goal);
+	for(std::size_t node = 1; node < path.size(); node++){
+		EXPECT_EQ(path[node].index, path[node - 1].index + 1);
+	}
+	expectWellFormed(planner.getTree());
+}
+
+TEST(RRTPlanner, LeavesAGoalOutOfReachUnreached){
+	// Ten rows ahead in three layers is more than a node per layer steps
+	const CostGrid costs = uniformGrid(3, 12, 9, 0.0f);
+	RRTPlanner planner(seeded(false));
+	const std::vector< TreeNode > path = planner.plan(costs, 0, 4);
+
+	EXPECT_FALSE(planner.reachedGoal());
+	EXPECT_EQ(planner.getIterations(), RRTPlanner::Options().maxIterations);
+	ASSERT_FALSE(path.empty());
+	EXPECT_EQ(path.front().index, 0);
+	EXPECT_LE(path.back().index, 2);
+}
+
+TEST(RRTPlanner, KeepsOffObstacles){
+	CostGrid costs = uniformGrid(10, 12, 9, 0.0f);
+	addWall(costs, 5, 6, 8);
+	RRTPlanner planner(seeded(false));
+	planner.plan(costs, 0, 4);
+
+	ASSERT_TRUE(planner.reachedGoal());
+	for(const TreeNode &node : planner.getTree()){
+		if(node.index > 0){
+			EXPECT_LT(costs.at(node.index, node.x, node.y), CostGrid::OCCUPIED) << node.x << ", " << node.y;
+		}
+	}
+}
+
+TEST(RRTPlanner, DoesNotCrossAClosedWall){
+	CostGrid costs = uniformGrid(10, 12, 9, 0.0f);
+	addWall(costs, 5, 0, 0);
+	RRTPlanner planner(seeded(false));
+	const std::vector< TreeNode > path = planner.plan(costs, 0, 4);
+
+	EXPECT_FALSE(planner.reachedGoal());
+	for(const TreeNode &node : planner.getTree()){
+		EXPECT_GT(node.x, 5);
+	}
+	EXPECT_GT(path.back().x, 5);
+}
+
+TEST(RRTPlanner, KeepsTheFootprintClear){
+	CostGrid costs = uniformGrid(10, 12, 12, 0.0f);
+	addWall(costs, 5, 3, 9);
+	RRTPlanner::Options options = seeded(false);
+	options.footprintRadius = 1.5f;
+	RRTPlanner planner(options);
+	planner.plan(costs, 0, 6);
+
+	ASSERT_TRUE(planner.reachedGoal());
+	for(const TreeNode &node : planner.getTree()){
+		if(node.index == 0){
+			continue;
+		}
+		for(int i = 0; i < costs.rows(); i++){
+			for(int j = 0; j < costs.cols(); j++){
+				if(costs.at(node.index, i, j) > 0.5f){
+					EXPECT_GT(std::hypot(node.x - i, node.y - j), options.footprintRadius);
+				}
+			}
+		}
+	}
+}
+
+TEST(RRTPlanner, RRTStarOnlyImprovesWithMoreIterations){
+	// Cheapest down the middle columns, so there is something to improve
+	CostGrid costs = uniformGrid(10, 12, 9, 0.0f);
+	for(int k = 0; k < costs.layers(); k++){
+		for(int i = 0; i < costs.rows(); i++){
+			float *row = costs.row(k, i);
+			for(int j = 0; j < costs.cols(); j++){
+				row[j] = 0.08f * std::abs(j - 4);
+			}
+		}
+	}
+
+	RRTPlanner::Options options = seeded(true);
+	options.maxIterations = 100;
+	RRTPlanner shortRun(options);
+	const std::vector< TreeNode > shortPath = shortRun.plan(costs, 0, 4);
+	options.maxIterations = 2000;
+	RRTPlanner longRun(options);
+	const std::vector< TreeNode > longPath = longRun.plan(costs, 0, 4);
+
+	ASSERT_TRUE(shortRun.reachedGoal());
+	ASSERT_TRUE(longRun.reachedGoal());
+	// RRT* keeps sampling past the first path to the goal
+	EXPECT_EQ(longRun.getIterations(), 2000);
+	EXPECT_LE(longPath.back().pathCost, shortPath.back().pathCost);
+	expectWellFormed(longRun.getTree());
+	// Unlike plain RRT's, no RRT* node jumps back to the root's cell
+	const std::vector< TreeNode > &tree = longRun.getTree();
+	for(std::size_t node = 1; node < tree.size(); node++){
+		const TreeNode &parent = tree[tree[node].parent];
+		EXPECT_LE(tree[node].x, parent.x);
+		EXPECT_GE(tree[node].x, parent.x - options.maxDistanceToExplore);
+		EXPECT_GE(tree[node].y, parent.y - options.maxDistanceToExplore);
+		EXPECT_LT(tree[node].y, parent.y + options.maxDistanceToExplore);
+	}
+}
+
+TEST(RRTPlanner, PlansTheSameWhateverTheThreadCount){
+	CostGrid costs = uniformGrid(10, 12, 9, 0.0f);
+	addWall(costs, 5, 6, 8);
+	RRTPlanner::Options options = seeded(true);
+	options.expansionBatch = 4;
+	RRTPlanner serial(options);
+	const std::vector< TreeNode > serialPath = serial.plan(costs, 0, 4);
+	options.expansionThreads = 4;
+	RRTPlanner parallel(options);
+	const std::vector< TreeNode > parallelPath = parallel.plan(costs, 0, 4);
+
+	EXPECT_TRUE(samePath(serialPath, parallelPath));
+	EXPECT_EQ(serial.getTree().size(), parallel.getTree().size());
+}
+
+TEST(RRTPlanner, StartsEachPlanFromANewTreeInTheSamePool){
+	CostGrid costs = uniformGrid(10, 12, 9, 0.0f);
+	addWall(costs, 5, 6, 8);
+	RRTPlanner planner(seeded(true));
+	const std::vector< TreeNode > first = planner.plan(costs, 0, 4);
+	const TreeNode *pool = planner.getTree().data();
+	planner.plan(uniformGrid(10, 12, 9, 0.0f), 0, 1);
+	const std::vector< TreeNode > again = planner.plan(costs, 0, 4);
+
+	// The pool was reserved up front, so replanning doesn't allocate
+	EXPECT_EQ(planner.getTree().data(), pool);
+	EXPECT_TRUE(samePath(first, again));
+	RRTPlanner fresh(seeded(true));
+	EXPECT_TRUE(samePath(fresh.plan(costs, 0, 4), again));
+}
+
+TEST(RRTPlanner, WarmStartFindsAStillFreePathAgain){
+	const CostGrid costs = uniformGrid(8, 12, 9, 0.0f);
+	RRTPlanner::Options options = seeded(false);
+	options.warmStart = true;
+	RRTPlanner planner(options);
+	const std::vector< TreeNode > first = planner.plan(costs, 0, 4);
+	ASSERT_TRUE(planner.reachedGoal());
+	const std::vector< TreeNode > again = planner.plan(costs, 0, 4, RRTPlanner::Motion());
+
+	EXPECT_TRUE(planner.reachedGoal());
+	EXPECT_EQ(planner.getIterations(), 0);
+	EXPECT_TRUE(samePath(first, again));
+	expectWellFormed(planner.getTree());
+}
+
+TEST(RRTPlanner, WarmStartNeedsTheOptionAndAMotion){
+	const CostGrid costs = uniformGrid(8, 12, 9, 0.0f);
+	RRTPlanner cold(seeded(false));
+	cold.plan(costs, 0, 4);
+	cold.plan(costs, 0, 4, RRTPlanner::Motion());
+	EXPECT_GT(cold.getIterations(), 0);
+
+	RRTPlanner::Options options = seeded(false);
+	options.warmStart = true;
+	RRTPlanner warm(options);
+	warm.plan(costs, 0, 4);
+	warm.plan(costs, 0, 4);
+	EXPECT_GT(warm.getIterations(), 0);
+	// Nor from a map older than the last
+	RRTPlanner::Motion older;
+	older.layers = -1;
+	warm.plan(costs, 0, 4, older);
+	EXPECT_GT(warm.getIterations(), 0);
+}
+
+TEST(RRTPlanner, WarmStartReRootsTheTreeWhereTheVehicleMoved){
+	const CostGrid costs = uniformGrid(8, 12, 9, 0.0f);
+	RRTPlanner::Options options = seeded(false);
+	options.warmStart = true;
+	RRTPlanner planner(options);
+	const std::vector< TreeNode > first = planner.plan(costs, 0, 4);
+	ASSERT_TRUE(planner.reachedGoal());
+	ASSERT_GE(first.size(), 3u);
+	// The vehicle drove the path's first edge, a layer on, so the world
+	// shifts back by it
+	RRTPlanner::Motion motion;
+	motion.x0 = (float)(first[0].x - first[1].x);
+	motion.y0 = (float)(first[0].y - first[1].y);
+	motion.layers = 1;
+	const int goalX = (int)motion.x0;
+	const int goalY = 4 + (int)motion.y0;
+	const std::vector< TreeNode > again = planner.plan(costs, goalX, goalY, motion);
+
+	EXPECT_TRUE(planner.reachedGoal());
+	EXPECT_EQ(planner.getIterations(), 0);
+	ASSERT_FALSE(again.empty());
+	EXPECT_EQ(again.front().x, 10);
+	EXPECT_EQ(again.front().y, 4);
+	EXPECT_EQ(again.back().x, goalX);
+	EXPECT_EQ(again.back().y, goalY);
+	EXPECT_LT(again.back().index, first.back().index);
+	expectWellFormed(planner.getTree());
+}
+
+TEST(RRTPlanner, WarmStartDropsWhatTheNewMapBlocks){
+	RRTPlanner::Options options = seeded(false);
+	options.warmStart = true;
+	RRTPlanner planner(options);
+	planner.plan(uniformGrid(10, 12, 9, 0.0f), 0, 4);
+	CostGrid costs = uniformGrid(10, 12, 9, 0.0f);
+	addWall(costs, 5, 6, 8);
+	RRTPlanner::Motion motion;
+	motion.x0 = 1; // Driven a row on, in a layer
+	motion.layers = 1;
+	planner.plan(costs, 0, 4, motion);
+
+	ASSERT_TRUE(planner.reachedGoal());
+	for(const TreeNode &node : planner.getTree()){
+		if(node.index > 0){
+			EXPECT_LT(costs.at(node.index, node.x, node.y), CostGrid::OCCUPIED) << node.x << ", " << node.y;
+		}
+	}
+	expectWellFormed(planner.getTree());
+}
@@ -0,0 +1,20 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  republish.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <memory> // std::make_shared
+#include "rclcpp/rclcpp.hpp"
+#include "cloud_transport/RepublishNode.hpp"
+
+int main(int argc, char **argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<navigator::cloud_transport::RepublishNode>());
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  CloudCodec.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Compression of PointCloud2s into CompressedPointCloud messages.
+//
+// x, y and z (FLOAT32 fields of those names) are rounded to multiples
+// of the precision, and each is stored as the difference from the same
+// coordinate of the previous point, zigzag and varint coded; neighbours
+// in a scan are close, so most take a byte or two. Non-finite
+// coordinates survive as NaN. The other bytes of each point are kept
+// exactly, in one plane per byte offset, so that e.g. the high bytes of
+// every intensity sit together. The message's data is the payload size
+// (uint32, little endian) followed by the zlib stream of the payload:
+//
+//   uint32 x_size, y_size, z_size, rest_size
+//   x_size bytes of x deltas, then y's and z's
+//   rest_size bytes of the other bytes, plane by plane
+//
+// With a precision of 0, or without float x, y and z in the host's byte
+// order, nothing is quantized and every byte of a point is in the rest.
+
+#pragma once
+
+#include "nova_msgs/msg/compressed_point_cloud.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+
+namespace navigator {
+namespace cloud_transport {
+
+struct CompressionSettings {
+  float precision = 0.001f; // Meters. 0 keeps x, y and z exactly.
+  int level = 1; // zlib's, from 0 (store) to 9 (smallest)
+};
+
+// Throws std::invalid_argument if the cloud's data is shorter than its
+// dimensions say
+void compress(const sensor_msgs::msg::PointCloud2 & cloud, const CompressionSettings & settings,
+	      nova_msgs::msg::CompressedPointCloud & compressed);
+
+// Throws std::runtime_error if the message is corrupt
+void decompress(const nova_msgs::msg::CompressedPointCloud & compressed,
+		sensor_msgs::msg::PointCloud2 & cloud);
+
+}
+}
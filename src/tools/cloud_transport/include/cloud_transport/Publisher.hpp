@@ -0,0 +1,59 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  Publisher.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Publishes a point cloud topic on every transport, like
+// image_transport's publisher: raw on the base topic, and compressed
+// (a CompressedPointCloud) on <base topic>/compressed. Clouds are only
+// compressed while something subscribes to the compressed topic, so
+// local consumers of the raw topic, which can take it zero-copy, pay
+// nothing for remote ones. The node's cloud_transport.precision
+// (meters, default 0.001) and cloud_transport.level (zlib's, default 1)
+// parameters set the compression.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "nova_msgs/msg/compressed_point_cloud.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+
+#include "cloud_transport/CloudCodec.hpp"
+
+namespace navigator {
+namespace cloud_transport {
+
+// Declares the node's compression parameters if they aren't yet, and
+// returns their values
+CompressionSettings declare_compression_settings(rclcpp::Node & node);
+
+class Publisher {
+public:
+  Publisher(rclcpp::Node & node, const std::string & base_topic, const rclcpp::QoS & qos);
+
+  void publish(const sensor_msgs::msg::PointCloud2 & cloud) const;
+  void publish(std::unique_ptr<sensor_msgs::msg::PointCloud2> cloud) const;
+
+  // Of the raw topic
+  const char * get_topic_name() const;
+  // On every transport
+  std::size_t get_subscription_count() const;
+
+private:
+  void publish_compressed(const sensor_msgs::msg::PointCloud2 & cloud) const;
+
+  CompressionSettings settings;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr raw_publisher;
+  rclcpp::Publisher<nova_msgs::msg::CompressedPointCloud>::SharedPtr compressed_publisher;
+};
+
+}
+}
@@ -0,0 +1,46 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  RepublishNode.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Republishes a point cloud topic from one transport on another, like
+// image_transport's republish. Its main use is compressing clouds from
+// publishers that don't use a cloud_transport Publisher, such as the
+// Python lidar fusion node, for the machines that record or view
+// them; and decompressing them again on those machines.
+
+#pragma once
+
+#include <memory>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "nova_msgs/msg/compressed_point_cloud.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+
+#include "cloud_transport/CloudCodec.hpp"
+#include "cloud_transport/Subscriber.hpp"
+
+namespace navigator {
+namespace cloud_transport {
+
+class RepublishNode : public rclcpp::Node {
+public:
+  explicit RepublishNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+private:
+  void cloud_cb(sensor_msgs::msg::PointCloud2::ConstSharedPtr cloud);
+
+  CompressionSettings settings;
+  std::unique_ptr<Subscriber> subscriber;
+  // Only the one for the output transport is created
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr raw_publisher;
+  rclcpp::Publisher<nova_msgs::msg::CompressedPointCloud>::SharedPtr compressed_publisher;
+};
+
+}
+}
@@ -0,0 +1,44 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  Subscriber.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Subscribes to a point cloud topic published by a cloud_transport
+// Publisher, over the given transport, and hands the callback plain
+// PointCloud2s either way. "raw" subscribes to the base topic itself;
+// "compressed" to <base topic>/compressed, decompressing each message.
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "nova_msgs/msg/compressed_point_cloud.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+
+namespace navigator {
+namespace cloud_transport {
+
+class Subscriber {
+public:
+  using Callback = std::function<void(sensor_msgs::msg::PointCloud2::ConstSharedPtr)>;
+
+  // Throws std::invalid_argument for an unknown transport
+  Subscriber(rclcpp::Node & node, const std::string & base_topic, const std::string & transport,
+	     const rclcpp::QoS & qos, Callback callback);
+
+  // Of the topic subscribed to
+  const char * get_topic_name() const;
+
+private:
+  rclcpp::SubscriptionBase::SharedPtr subscription;
+};
+
+}
+}
@@ -0,0 +1,250 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  CloudCodec.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm> // std::min, std::max
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <zlib.h>
+
+#include "cloud_transport/CloudCodec.hpp"
+
+using nova_msgs::msg::CompressedPointCloud;
+using sensor_msgs::msg::PointCloud2;
+using sensor_msgs::msg::PointField;
+
+namespace {
+
+// Stands in for NaN, infinities and coordinates out of range
+constexpr int32_t NOT_FINITE = std::numeric_limits<int32_t>::min();
+
+constexpr bool host_is_bigendian() {
+  return __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__;
+}
+
+// Offsets of x, y and z in a point, if they can be quantized
+bool find_coordinates(const std::vector<PointField> & fields, bool is_bigendian, uint32_t point_step,
+		      std::array<uint32_t, 3> & offsets) {
+  if(is_bigendian != host_is_bigendian()) return false;
+  const char * names[3] = {"x", "y", "z"};
+  for(int axis = 0; axis < 3; axis++) {
+    auto field = std::find_if(fields.begin(), fields.end(),
+			      [&](const PointField & field) { return field.name == names[axis]; });
+    if(field == fields.end() || field->datatype != PointField::FLOAT32 || field->count != 1 ||
+       uint64_t(field->offset) + 4 > point_step) {
+      return false;
+    }
+    offsets[axis] = field->offset;
+  }
+  // Overlapping coordinates would be written over each other
+  for(int a = 0; a < 3; a++) {
+    for(int b = a + 1; b < 3; b++) {
+      if(offsets[a] + 4 > offsets[b] && offsets[b] + 4 > offsets[a]) return false;
+    }
+  }
+  return true;
+}
+
+// The bytes of a point that are kept exactly, in order
+std::vector<uint32_t> kept_offsets(bool quantized, const std::array<uint32_t, 3> & offsets, uint32_t point_step) {
+  std::vector<uint32_t> kept;
+  for(uint32_t offset = 0; offset < point_step; offset++) {
+    if(quantized && std::any_of(offsets.begin(), offsets.end(), [offset](uint32_t start) {
+	  return offset >= start && offset < start + 4;
+	})) {
+      continue;
+    }
+    kept.push_back(offset);
+  }
+  return kept;
+}
+
+void put_u32(std::vector<uint8_t> & out, uint32_t value) {
+  for(int i = 0; i < 4; i++) out.push_back(uint8_t(value >> (8 * i)));
+}
+
+uint32_t get_u32(const uint8_t * in) {
+  return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 | uint32_t(in[3]) << 24;
+}
+
+void put_delta(std::vector<uint8_t> & out, int32_t value, int32_t previous) {
+  // Wrapping, so that the decoder gets value back even if the difference
+  // overflows
+  const uint32_t delta = uint32_t(value) - uint32_t(previous);
+  uint32_t zigzag = (delta << 1) ^ uint32_t(-int32_t(delta >> 31));
+  while(zigzag >= 0x80) {
+    out.push_back(uint8_t(zigzag | 0x80));
+    zigzag >>= 7;
+  }
+  out.push_back(uint8_t(zigzag));
+}
+
+int32_t get_delta(const uint8_t *& in, const uint8_t * end, int32_t previous) {
+  uint32_t zigzag = 0;
+  for(int shift = 0; ; shift += 7) {
+    if(in == end || shift > 28) throw std::runtime_error("Corrupt coordinates in a compressed point cloud");
+    const uint8_t byte = * in++;
+    zigzag |= uint32_t(byte & 0x7f) << shift;
+    if(! (byte & 0x80)) break;
+  }
+  const uint32_t delta = (zigzag >> 1) ^ uint32_t(-int32_t(zigzag & 1));
+  return int32_t(uint32_t(previous) + delta);
+}
+
+int32_t quantize(float value, double scale) {
+  const double scaled = std::round(double(value) * scale);
+  // The sentinel itself is out of range too
+  if(! std::isfinite(scaled) || scaled <= double(NOT_FINITE) || scaled > double(std::numeric_limits<int32_t>::max())) {
+    return NOT_FINITE;
+  }
+  return int32_t(scaled);
+}
+
+}
+
+void navigator::cloud_transport::compress(const PointCloud2 & cloud, const CompressionSettings & settings,
+					  CompressedPointCloud & compressed) {
+  const uint64_t row_bytes = uint64_t(cloud.width) * cloud.point_step;
+  if(cloud.row_step < row_bytes || uint64_t(cloud.row_step) * cloud.height > cloud.data.size()) {
+    throw std::invalid_argument("The point cloud's data is shorter than its dimensions");
+  }
+  const std::size_t point_count = std::size_t(cloud.width) * cloud.height;
+
+  std::array<uint32_t, 3> offsets;
+  const bool quantized = settings.precision > 0 &&
+    find_coordinates(cloud.fields, cloud.is_bigendian, cloud.point_step, offsets);
+  const double scale = quantized ? 1.0 / settings.precision : 0.0;
+
+  const std::vector<uint32_t> rest_offsets = kept_offsets(quantized, offsets, cloud.point_step);
+
+  std::array<std::vector<uint8_t>, 3> coordinates;
+  if(quantized) {
+    std::array<int32_t, 3> previous = {0, 0, 0};
+    for(auto & stream : coordinates) stream.reserve(point_count * 2);
+    for(uint32_t row = 0; row < cloud.height; row++) {
+      const uint8_t * point = cloud.data.data() + std::size_t(row) * cloud.row_step;
+      for(uint32_t column = 0; column < cloud.width; column++, point += cloud.point_step) {
+	for(int axis = 0; axis < 3; axis++) {
+	  float value;
+	  std::memcpy(& value, point + offsets[axis], sizeof(value));
+	  const int32_t q = quantize(value, scale);
+	  put_delta(coordinates[axis], q, previous[axis]);
+	  previous[axis] = q;
+	}
+      }
+    }
+  }
+
+  std::vector<uint8_t> payload;
+  payload.reserve(20 + coordinates[0].size() + coordinates[1].size() + coordinates[2].size() +
+		  rest_offsets.size() * point_count);
+  put_u32(payload, uint32_t(coordinates[0].size()));
+  put_u32(payload, uint32_t(coordinates[1].size()));
+  put_u32(payload, uint32_t(coordinates[2].size()));
+  put_u32(payload, uint32_t(rest_offsets.size() * point_count));
+  for(const auto & stream : coordinates) payload.insert(payload.end(), stream.begin(), stream.end());
+  for(uint32_t offset : rest_offsets) {
+    for(uint32_t row = 0; row < cloud.height; row++) {
+      const uint8_t * byte = cloud.data.data() + std::size_t(row) * cloud.row_step + offset;
+      for(uint32_t column = 0; column < cloud.width; column++, byte += cloud.point_step) {
+	payload.push_back(* byte);
+      }
+    }
+  }
+
+  compressed.header = cloud.header;
+  compressed.height = cloud.height;
+  compressed.width = cloud.width;
+  compressed.fields = cloud.fields;
+  compressed.is_bigendian = cloud.is_bigendian;
+  compressed.point_step = cloud.point_step;
+  compressed.is_dense = cloud.is_dense;
+  compressed.precision = quantized ? settings.precision : 0.0f;
+
+  uLongf compressed_size = compressBound(uLong(payload.size()));
+  compressed.data.resize(4 + compressed_size);
+  compressed.data[0] = uint8_t(payload.size());
+  compressed.data[1] = uint8_t(payload.size() >> 8);
+  compressed.data[2] = uint8_t(payload.size() >> 16);
+  compressed.data[3] = uint8_t(payload.size() >> 24);
+  const int status = compress2(compressed.data.data() + 4, & compressed_size, payload.data(), uLong(payload.size()),
+			       std::min(std::max(settings.level, 0), 9));
+  if(status != Z_OK) throw std::runtime_error("zlib could not compress a point cloud");
+  compressed.data.resize(4 + compressed_size);
+}
+
+void navigator::cloud_transport::decompress(const CompressedPointCloud & compressed, PointCloud2 & cloud) {
+  if(compressed.data.size() < 4) throw std::runtime_error("Truncated compressed point cloud");
+  const std::size_t point_count = std::size_t(compressed.width) * compressed.height;
+  const uint64_t payload_size = get_u32(compressed.data.data());
+  // Deflate can't shrink anything more than about 1000 times, so larger
+  // sizes are corrupt rather than worth allocating
+  if(payload_size < 16 || payload_size > (compressed.data.size() - 4) * 1100 + 64) {
+    throw std::runtime_error("Corrupt compressed point cloud");
+  }
+  std::vector<uint8_t> payload(payload_size);
+  uLongf unpacked_size = uLongf(payload_size);
+  if(uncompress(payload.data(), & unpacked_size, compressed.data.data() + 4, uLong(compressed.data.size() - 4)) != Z_OK ||
+     unpacked_size != payload_size) {
+    throw std::runtime_error("Corrupt compressed point cloud");
+  }
+  const uint64_t sizes[4] = {get_u32(& payload[0]), get_u32(& payload[4]), get_u32(& payload[8]), get_u32(& payload[12])};
+  if(16 + sizes[0] + sizes[1] + sizes[2] + sizes[3] != payload_size) {
+    throw std::runtime_error("Corrupt compressed point cloud");
+  }
+
+  std::array<uint32_t, 3> offsets;
+  const bool quantized = compressed.precision > 0;
+  if(quantized && ! find_coordinates(compressed.fields, compressed.is_bigendian, compressed.point_step, offsets)) {
+    throw std::runtime_error("A quantized point cloud without float x, y and z");
+  }
+  const std::vector<uint32_t> rest_offsets = kept_offsets(quantized, offsets, compressed.point_step);
+  // Every point takes at least a byte per coordinate, so this also bounds
+  // the allocation below
+  if(sizes[3] != rest_offsets.size() * point_count || (quantized && point_count > sizes[0])) {
+    throw std::runtime_error("Corrupt compressed point cloud");
+  }
+
+  cloud.header = compressed.header;
+  cloud.height = compressed.height;
+  cloud.width = compressed.width;
+  cloud.fields = compressed.fields;
+  cloud.is_bigendian = compressed.is_bigendian;
+  cloud.point_step = compressed.point_step;
+  cloud.row_step = compressed.width * compressed.point_step;
+  cloud.is_dense = compressed.is_dense;
+  cloud.data.resize(point_count * compressed.point_step);
+
+  const uint8_t * stream = payload.data() + 16;
+  if(quantized) {
+    const double precision = compressed.precision;
+    for(int axis = 0; axis < 3; axis++) {
+      const uint8_t * end = stream + sizes[axis];
+      int32_t previous = 0;
+      uint8_t * point = cloud.data.data() + offsets[axis];
+      for(std::size_t k = 0; k < point_count; k++, point += compressed.point_step) {
+	previous = get_delta(stream, end, previous);
+	const float value = previous == NOT_FINITE ? std::numeric_limits<float>::quiet_NaN() : float(previous * precision);
+	std::memcpy(point, & value, sizeof(value));
+      }
+      if(stream != end) throw std::runtime_error("Corrupt coordinates in a compressed point cloud");
+    }
+  } else if(sizes[0] || sizes[1] || sizes[2]) {
+    throw std::runtime_error("Corrupt compressed point cloud");
+  }
+  for(uint32_t offset : rest_offsets) {
+    uint8_t * byte = cloud.data.data() + offset;
+    for(std::size_t k = 0; k < point_count; k++, byte += compressed.point_step) * byte = * stream++;
+  }
+}
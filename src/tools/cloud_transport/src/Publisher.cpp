@@ -0,0 +1,67 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  Publisher.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "cloud_transport/Publisher.hpp"
+
+using navigator::cloud_transport::CompressionSettings;
+using navigator::cloud_transport::Publisher;
+using nova_msgs::msg::CompressedPointCloud;
+using sensor_msgs::msg::PointCloud2;
+
+CompressionSettings navigator::cloud_transport::declare_compression_settings(rclcpp::Node & node) {
+  // Several publishers in one node share the parameters
+  CompressionSettings settings;
+  if(! node.has_parameter("cloud_transport.precision")) {
+    node.declare_parameter<double>("cloud_transport.precision", settings.precision);
+  }
+  if(! node.has_parameter("cloud_transport.level")) {
+    node.declare_parameter<int>("cloud_transport.level", settings.level);
+  }
+  settings.precision = float(node.get_parameter("cloud_transport.precision").as_double());
+  settings.level = int(node.get_parameter("cloud_transport.level").as_int());
+  return settings;
+}
+
+Publisher::Publisher(rclcpp::Node & node, const std::string & base_topic, const rclcpp::QoS & qos)
+  : settings(declare_compression_settings(node)) {
+  this->raw_publisher = node.create_publisher<PointCloud2>(base_topic, qos);
+  this->compressed_publisher = node.create_publisher<CompressedPointCloud>(base_topic + "/compressed", qos);
+}
+
+void Publisher::publish(const PointCloud2 & cloud) const {
+  this->publish_compressed(cloud);
+  this->raw_publisher->publish(cloud);
+}
+
+void Publisher::publish(std::unique_ptr<PointCloud2> cloud) const {
+  // Compressed first, while the cloud is still ours
+  this->publish_compressed(* cloud);
+  this->raw_publisher->publish(std::move(cloud));
+}
+
+void Publisher::publish_compressed(const PointCloud2 & cloud) const {
+  if(this->compressed_publisher->get_subscription_count() == 0) return;
+  auto compressed = std::make_unique<CompressedPointCloud>();
+  compress(cloud, this->settings, * compressed);
+  this->compressed_publisher->publish(std::move(compressed));
+}
+
+const char * Publisher::get_topic_name() const {
+  return this->raw_publisher->get_topic_name();
+}
+
+std::size_t Publisher::get_subscription_count() const {
+  return this->raw_publisher->get_subscription_count() + this->compressed_publisher->get_subscription_count();
+}
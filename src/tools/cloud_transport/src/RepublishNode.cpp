@@ -0,0 +1,66 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  RepublishNode.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "cloud_transport/Publisher.hpp"
+#include "cloud_transport/RepublishNode.hpp"
+
+using navigator::cloud_transport::RepublishNode;
+using nova_msgs::msg::CompressedPointCloud;
+using sensor_msgs::msg::PointCloud2;
+
+RepublishNode::RepublishNode(const rclcpp::NodeOptions & options)
+  : Node("cloud_republish", options), settings(declare_compression_settings(* this)) {
+  const std::string input_topic = this->declare_parameter<std::string>("input_topic", "/lidar/fused");
+  const std::string input_transport = this->declare_parameter<std::string>("input_transport", "raw");
+  // The same base topic by default, so "compressed" adds <input>/compressed
+  const std::string output_topic = this->declare_parameter<std::string>("output_topic", input_topic);
+  const std::string output_transport = this->declare_parameter<std::string>("output_transport", "compressed");
+  if(input_topic == output_topic && input_transport == output_transport) {
+    throw std::invalid_argument("Republishing " + input_topic + " onto itself");
+  }
+
+  const rclcpp::QoS qos = rclcpp::SensorDataQoS();
+  if(output_transport == "raw") {
+    this->raw_publisher = this->create_publisher<PointCloud2>(output_topic, qos);
+  } else if(output_transport == "compressed") {
+    this->compressed_publisher = this->create_publisher<CompressedPointCloud>(output_topic + "/compressed", qos);
+  } else {
+    throw std::invalid_argument("Unknown point cloud transport " + output_transport);
+  }
+  this->subscriber = std::make_unique<Subscriber>
+    (* this, input_topic, input_transport, qos,
+     std::bind(& RepublishNode::cloud_cb, this, std::placeholders::_1));
+}
+
+void RepublishNode::cloud_cb(PointCloud2::ConstSharedPtr cloud) {
+  if(this->raw_publisher) {
+    this->raw_publisher->publish(* cloud);
+    return;
+  }
+  if(this->compressed_publisher->get_subscription_count() == 0) return;
+  auto compressed = std::make_unique<CompressedPointCloud>();
+  try {
+    compress(* cloud, this->settings, * compressed);
+  } catch(const std::invalid_argument & error) {
+    RCLCPP_WARN(this->get_logger(), "Dropping a point cloud: %s", error.what());
+    return;
+  }
+  this->compressed_publisher->publish(std::move(compressed));
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(navigator::cloud_transport::RepublishNode)
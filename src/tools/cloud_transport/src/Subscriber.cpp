@@ -0,0 +1,49 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  Subscriber.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "cloud_transport/CloudCodec.hpp"
+#include "cloud_transport/Subscriber.hpp"
+
+using navigator::cloud_transport::Subscriber;
+using nova_msgs::msg::CompressedPointCloud;
+using sensor_msgs::msg::PointCloud2;
+
+Subscriber::Subscriber(rclcpp::Node & node, const std::string & base_topic, const std::string & transport,
+		       const rclcpp::QoS & qos, Callback callback) {
+  if(transport == "raw") {
+    this->subscription = node.create_subscription<PointCloud2>(base_topic, qos, std::move(callback));
+  } else if(transport == "compressed") {
+    rclcpp::Logger logger = node.get_logger();
+    this->subscription = node.create_subscription<CompressedPointCloud>
+      (base_topic + "/compressed", qos,
+       [callback = std::move(callback), logger](CompressedPointCloud::ConstSharedPtr message) {
+	auto cloud = std::make_shared<PointCloud2>();
+	try {
+	  decompress(* message, * cloud);
+	} catch(const std::runtime_error & error) {
+	  RCLCPP_WARN(logger, "Dropping a point cloud: %s", error.what());
+	  return;
+	}
+	callback(cloud);
+      });
+  } else {
+    throw std::invalid_argument("Unknown point cloud transport " + transport);
+  }
+}
+
+const char * Subscriber::get_topic_name() const {
+  return this->subscription->get_topic_name();
+}
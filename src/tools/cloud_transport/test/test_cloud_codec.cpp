@@ -0,0 +1,198 @@
+/*
+ * Package:   cloud_transport
+ * Filename:  test_cloud_codec.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "cloud_transport/CloudCodec.hpp"
+
+using namespace navigator::cloud_transport;
+using nova_msgs::msg::CompressedPointCloud;
+using sensor_msgs::msg::PointCloud2;
+using sensor_msgs::msg::PointField;
+
+namespace {
+
+PointField field(const std::string & name, uint32_t offset, uint8_t datatype) {
+  PointField field;
+  field.name = name;
+  field.offset = offset;
+  field.datatype = datatype;
+  field.count = 1;
+  return field;
+}
+
+// x, y, z, intensity as FLOAT32s and a UINT16 ring: 18 bytes, padded to
+// 20, and row_step bytes per row
+PointCloud2 make_cloud(uint32_t width, uint32_t height, uint32_t row_step = 0) {
+  PointCloud2 cloud;
+  cloud.header.frame_id = "base_link";
+  cloud.header.stamp.sec = 12;
+  cloud.header.stamp.nanosec = 345;
+  cloud.width = width;
+  cloud.height = height;
+  cloud.fields = {field("x", 0, PointField::FLOAT32), field("y", 4, PointField::FLOAT32),
+		  field("z", 8, PointField::FLOAT32), field("intensity", 12, PointField::FLOAT32),
+		  field("ring", 16, PointField::UINT16)};
+  cloud.is_bigendian = __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__;
+  cloud.point_step = 20;
+  cloud.row_step = row_step ? row_step : width * cloud.point_step;
+  cloud.is_dense = true;
+  cloud.data.assign(std::size_t(cloud.row_step) * height, 0xab);
+  // A lidar-like ring sweep
+  for(uint32_t row = 0; row < height; row++) {
+    for(uint32_t column = 0; column < width; column++) {
+      uint8_t * point = cloud.data.data() + std::size_t(row) * cloud.row_step + column * cloud.point_step;
+      const float angle = column * 6.2831853f / width;
+      const float range = 10.0f + row + 0.3f * std::sin(angle * 7);
+      const float values[4] = {range * std::cos(angle), range * std::sin(angle), -1.5f + row * 0.1f,
+			       float(column % 97)};
+      const uint16_t ring = uint16_t(row);
+      std::memcpy(point, values, sizeof(values));
+      std::memcpy(point + 16, & ring, sizeof(ring));
+    }
+  }
+  return cloud;
+}
+
+float get_float(const PointCloud2 & cloud, std::size_t point, uint32_t offset) {
+  float value;
+  std::memcpy(& value, cloud.data.data() + point * cloud.point_step + offset, sizeof(value));
+  return value;
+}
+
+PointCloud2 round_trip(const PointCloud2 & cloud, const CompressionSettings & settings) {
+  CompressedPointCloud compressed;
+  compress(cloud, settings, compressed);
+  PointCloud2 result;
+  decompress(compressed, result);
+  return result;
+}
+
+}
+
+TEST(CloudCodec, CoordinatesAreWithinHalfThePrecision) {
+  const PointCloud2 cloud = make_cloud(500, 4);
+  CompressionSettings settings;
+  settings.precision = 0.01f;
+  const PointCloud2 result = round_trip(cloud, settings);
+
+  ASSERT_EQ(result.data.size(), cloud.data.size());
+  EXPECT_EQ(result.header.frame_id, "base_link");
+  EXPECT_EQ(result.header.stamp.sec, 12);
+  EXPECT_EQ(result.header.stamp.nanosec, 345u);
+  EXPECT_EQ(result.width, 500u);
+  EXPECT_EQ(result.height, 4u);
+  EXPECT_EQ(result.fields.size(), 5u);
+  for(std::size_t point = 0; point < 2000; point++) {
+    for(uint32_t offset : {0u, 4u, 8u}) {
+      EXPECT_NEAR(get_float(result, point, offset), get_float(cloud, point, offset), 0.005 + 1e-5);
+    }
+  }
+}
+
+TEST(CloudCodec, KeepsOtherBytesExactly) {
+  const PointCloud2 cloud = make_cloud(300, 2);
+  const PointCloud2 result = round_trip(cloud, CompressionSettings());
+  for(std::size_t point = 0; point < 600; point++) {
+    // Intensity, ring and padding
+    EXPECT_EQ(std::memcmp(result.data.data() + point * 20 + 12, cloud.data.data() + point * 20 + 12, 8), 0);
+  }
+}
+
+TEST(CloudCodec, KeepsNonFiniteCoordinatesNaN) {
+  PointCloud2 cloud = make_cloud(10, 1);
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float infinity = std::numeric_limits<float>::infinity();
+  const float huge = 1e30f;
+  std::memcpy(cloud.data.data() + 3 * 20, & nan, 4);
+  std::memcpy(cloud.data.data() + 4 * 20 + 4, & infinity, 4);
+  std::memcpy(cloud.data.data() + 5 * 20 + 8, & huge, 4);
+  const PointCloud2 result = round_trip(cloud, CompressionSettings());
+  EXPECT_TRUE(std::isnan(get_float(result, 3, 0)));
+  EXPECT_TRUE(std::isnan(get_float(result, 4, 4)));
+  EXPECT_TRUE(std::isnan(get_float(result, 5, 8)));
+  // The neighbours are unaffected
+  EXPECT_NEAR(get_float(result, 6, 0), get_float(cloud, 6, 0), 0.0006);
+}
+
+TEST(CloudCodec, ZeroPrecisionIsLossless) {
+  const PointCloud2 cloud = make_cloud(200, 3);
+  CompressionSettings settings;
+  settings.precision = 0;
+  CompressedPointCloud compressed;
+  compress(cloud, settings, compressed);
+  EXPECT_EQ(compressed.precision, 0.0f);
+  PointCloud2 result;
+  decompress(compressed, result);
+  EXPECT_EQ(result.data, cloud.data);
+}
+
+TEST(CloudCodec, CloudsWithoutFloatCoordinatesAreLossless) {
+  PointCloud2 cloud = make_cloud(50, 1);
+  cloud.fields[1].datatype = PointField::FLOAT64;
+  cloud.fields[1].offset = 4;
+  const PointCloud2 result = round_trip(cloud, CompressionSettings());
+  EXPECT_EQ(result.data, cloud.data);
+}
+
+TEST(CloudCodec, DropsRowPadding) {
+  // 8 bytes of padding after each row
+  const PointCloud2 cloud = make_cloud(40, 3, 40 * 20 + 8);
+  CompressionSettings settings;
+  settings.precision = 0;
+  const PointCloud2 result = round_trip(cloud, settings);
+  EXPECT_EQ(result.row_step, 40u * 20);
+  ASSERT_EQ(result.data.size(), 3u * 40 * 20);
+  for(uint32_t row = 0; row < 3; row++) {
+    EXPECT_EQ(std::memcmp(result.data.data() + row * 800, cloud.data.data() + row * cloud.row_step, 800), 0);
+  }
+}
+
+TEST(CloudCodec, ShrinksLidarClouds) {
+  const PointCloud2 cloud = make_cloud(2000, 16);
+  CompressedPointCloud compressed;
+  compress(cloud, CompressionSettings(), compressed);
+  EXPECT_LT(compressed.data.size(), cloud.data.size() / 3);
+}
+
+TEST(CloudCodec, EmptyClouds) {
+  const PointCloud2 result = round_trip(make_cloud(0, 0), CompressionSettings());
+  EXPECT_TRUE(result.data.empty());
+}
+
+TEST(CloudCodec, RejectsShortClouds) {
+  PointCloud2 cloud = make_cloud(10, 2);
+  cloud.data.resize(cloud.data.size() - 1);
+  CompressedPointCloud compressed;
+  EXPECT_THROW(compress(cloud, CompressionSettings(), compressed), std::invalid_argument);
+}
+
+TEST(CloudCodec, RejectsCorruptData) {
+  CompressedPointCloud compressed;
+  compress(make_cloud(100, 2), CompressionSettings(), compressed);
+  PointCloud2 result;
+
+  CompressedPointCloud truncated = compressed;
+  truncated.data.resize(truncated.data.size() / 2);
+  EXPECT_THROW(decompress(truncated, result), std::runtime_error);
+
+  CompressedPointCloud resized = compressed;
+  resized.width = 1000000;
+  EXPECT_THROW(decompress(resized, result), std::runtime_error);
+
+  CompressedPointCloud scrambled = compressed;
+  for(std::size_t i = 4; i < scrambled.data.size(); i += 3) scrambled.data[i] ^= 0x5a;
+  EXPECT_THROW(decompress(scrambled, result), std::runtime_error);
+}
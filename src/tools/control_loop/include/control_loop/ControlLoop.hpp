@@ -0,0 +1,77 @@
+/*
+ * Package:   control_loop
+ * Filename:  ControlLoop.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// Runs a control step at a fixed rate on its own thread, so the rate
+// doesn't depend on when messages arrive or how busy the executor is.
+// Each cycle sleeps until an absolute deadline on the monotonic clock,
+// so lateness in one cycle doesn't push back the ones after it. The
+// thread runs under SCHED_FIFO when the process is allowed to.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace navigator {
+  namespace control_loop {
+    struct LoopStatistics {
+      uint64_t cycles = 0;
+      uint64_t overruns = 0; // Cycles whose step ran past the next deadline
+      std::chrono::nanoseconds mean_jitter {0}; // How late each cycle woke
+      std::chrono::nanoseconds max_jitter {0};
+      std::chrono::nanoseconds max_step {0}; // Longest a step took
+
+      // One line for the logs
+      std::string summary() const;
+    };
+
+    class ControlLoop final {
+    public:
+      // Called once a cycle with the time since the last cycle started
+      typedef std::function<void(std::chrono::nanoseconds)> step_t;
+
+      // Priority is for SCHED_FIFO, from 1 to 99
+      ControlLoop(std::chrono::nanoseconds period, step_t step, int priority = 80);
+      ~ControlLoop(); // Stops the loop
+
+      void start();
+      void stop();
+
+      // Whether the thread got SCHED_FIFO. Without CAP_SYS_NICE or an
+      // rtprio limit it runs under the normal scheduler instead.
+      bool is_real_time() const;
+
+      LoopStatistics statistics() const;
+
+    private:
+      void run();
+      void record(std::chrono::nanoseconds jitter, std::chrono::nanoseconds step_time,
+		  bool overrun);
+
+      std::chrono::nanoseconds period;
+      step_t step;
+      int priority;
+
+      std::thread thread;
+      std::atomic<bool> running {false};
+      std::atomic<bool> real_time {false};
+
+      // Written by the loop, read by whoever reports them
+      std::atomic<uint64_t> cycles {0};
+      std::atomic<uint64_t> overruns {0};
+      std::atomic<int64_t> total_jitter_ns {0};
+      std::atomic<int64_t> max_jitter_ns {0};
+      std::atomic<int64_t> max_step_ns {0};
+    };
+  }
+}
@@ -0,0 +1,34 @@
+/*
+ * Package:   control_loop
+ * Filename:  Mailbox.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+// The latest value of something, written by a subscription callback
+// and read by a control loop without either ever waiting on the
+// other. Only small values the hardware can swap atomically fit.
+
+#pragma once
+
+#include <atomic>
+
+namespace navigator {
+  namespace control_loop {
+    template <typename T>
+    class Mailbox final {
+      static_assert(std::atomic<T>::is_always_lock_free,
+		    "Mailbox values must be lock-free atomics");
+    public:
+      Mailbox(T initial = T()) : value(initial) {}
+
+      void put(T new_value) { this->value.store(new_value, std::memory_order_release); }
+      T get() const { return this->value.load(std::memory_order_acquire); }
+
+    private:
+      std::atomic<T> value;
+    };
+  }
+}
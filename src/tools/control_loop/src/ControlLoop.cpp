@@ -0,0 +1,127 @@
+/*
+ * Package:   control_loop
+ * Filename:  ControlLoop.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+#include <chrono> // Durations
+#include <cerrno> // EINTR
+#include <cstdint> // Fixed-width integers
+#include <pthread.h> // Thread scheduling
+#include <sched.h> // SCHED_FIFO
+#include <sstream> // Summaries
+#include <string>
+#include <time.h> // clock_nanosleep()
+
+#include "control_loop/ControlLoop.hpp"
+
+using namespace navigator::control_loop;
+using std::chrono::nanoseconds;
+
+static int64_t to_ns(const struct timespec & time) {
+  return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static struct timespec from_ns(int64_t ns) {
+  return { (time_t) (ns / 1000000000), (long) (ns % 1000000000) };
+}
+
+static int64_t now_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return to_ns(now);
+}
+
+static void update_max(std::atomic<int64_t> & max, int64_t value) {
+  int64_t current = max.load(std::memory_order_relaxed);
+  while(value > current &&
+	!max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+std::string LoopStatistics::summary() const {
+  std::ostringstream summary;
+  summary << this->cycles << " cycles, " << this->overruns << " overruns, jitter mean "
+	  << this->mean_jitter.count() / 1000 << "us max "
+	  << this->max_jitter.count() / 1000 << "us, longest step "
+	  << this->max_step.count() / 1000 << "us";
+  return summary.str();
+}
+
+ControlLoop::ControlLoop(nanoseconds period, step_t step, int priority)
+  : period(period), step(step), priority(priority) {}
+
+ControlLoop::~ControlLoop() {
+  this->stop();
+}
+
+void ControlLoop::start() {
+  if(this->running) return;
+  this->running = true;
+  this->thread = std::thread(& ControlLoop::run, this);
+}
+
+void ControlLoop::stop() {
+  this->running = false;
+  if(this->thread.joinable()) {
+    this->thread.join();
+  }
+}
+
+bool ControlLoop::is_real_time() const {
+  return this->real_time;
+}
+
+LoopStatistics ControlLoop::statistics() const {
+  LoopStatistics statistics;
+  statistics.cycles = this->cycles.load(std::memory_order_relaxed);
+  statistics.overruns = this->overruns.load(std::memory_order_relaxed);
+  if(statistics.cycles > 0) {
+    statistics.mean_jitter = nanoseconds
+      (this->total_jitter_ns.load(std::memory_order_relaxed) / (int64_t) statistics.cycles);
+  }
+  statistics.max_jitter = nanoseconds(this->max_jitter_ns.load(std::memory_order_relaxed));
+  statistics.max_step = nanoseconds(this->max_step_ns.load(std::memory_order_relaxed));
+  return statistics;
+}
+
+void ControlLoop::record(nanoseconds jitter, nanoseconds step_time, bool overrun) {
+  this->cycles.fetch_add(1, std::memory_order_relaxed);
+  if(overrun) this->overruns.fetch_add(1, std::memory_order_relaxed);
+  this->total_jitter_ns.fetch_add(jitter.count(), std::memory_order_relaxed);
+  update_max(this->max_jitter_ns, jitter.count());
+  update_max(this->max_step_ns, step_time.count());
+}
+
+void ControlLoop::run() {
+  // Failing here just means running at normal priority, e.g. in tests
+  // or on a machine without real-time permissions
+  struct sched_param parameters {};
+  parameters.sched_priority = this->priority;
+  this->real_time = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0;
+
+  const int64_t period_ns = this->period.count();
+  int64_t deadline = now_ns();
+  int64_t last_start = deadline;
+  while(this->running) {
+    deadline += period_ns;
+    struct timespec wake = from_ns(deadline);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR) {}
+
+    int64_t start = now_ns();
+    this->step(nanoseconds(start - last_start));
+    last_start = start;
+    int64_t end = now_ns();
+
+    bool overrun = end > deadline + period_ns;
+    this->record(nanoseconds(start - deadline), nanoseconds(end - start), overrun);
+
+    // After an overrun, skip the deadlines already missed rather than
+    // running a burst of late cycles to catch up
+    if(overrun) {
+      deadline += ((end - deadline) / period_ns) * period_ns;
+    }
+  }
+}
@@ -0,0 +1,74 @@
+/*
+ * Package:   control_loop
+ * Filename:  test_control_loop.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2022, Nova UTD
+ * License:   MIT License
+ */
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h> // Testing framework
+#include <thread>
+
+#include "control_loop/ControlLoop.hpp"
+#include "control_loop/Mailbox.hpp"
+
+using namespace navigator::control_loop;
+using namespace std::chrono_literals;
+
+TEST(TestMailbox, test_holds_latest) {
+  Mailbox<float> mailbox(1.5);
+  ASSERT_EQ(mailbox.get(), 1.5);
+  mailbox.put(2.5);
+  mailbox.put(3.5);
+  ASSERT_EQ(mailbox.get(), 3.5);
+}
+
+// The loop should tick at its period, with steps told how long it has
+// been since the last one. Timing is loose, since tests don't get a
+// real-time scheduler.
+TEST(TestControlLoop, test_runs_at_rate) {
+  std::atomic<int> steps {0};
+  std::atomic<int64_t> longest_delta {0};
+  ControlLoop loop(5ms, [&](std::chrono::nanoseconds delta) {
+    steps++;
+    if(steps > 1 && delta.count() > longest_delta) longest_delta = delta.count();
+  });
+  auto started = std::chrono::steady_clock::now();
+  loop.start();
+  std::this_thread::sleep_for(200ms);
+  loop.stop();
+  auto elapsed = std::chrono::steady_clock::now() - started;
+
+  // Never more than one step per period, even if we overslept
+  int ran = steps;
+  ASSERT_GE(ran, 20);
+  ASSERT_LE(ran, elapsed / 5ms + 1);
+  ASSERT_EQ(loop.statistics().cycles, (uint64_t) ran);
+  ASSERT_EQ(loop.statistics().overruns, 0u);
+  ASSERT_LT(longest_delta, std::chrono::nanoseconds(50ms).count());
+
+  std::this_thread::sleep_for(20ms);
+  ASSERT_EQ(steps, ran); // Stopped means stopped
+}
+
+// A step longer than the period should count as an overrun, and the
+// loop should drop the cycles it missed instead of bursting
+TEST(TestControlLoop, test_overruns) {
+  std::atomic<int> steps {0};
+  ControlLoop loop(5ms, [&](std::chrono::nanoseconds) {
+    steps++;
+    std::this_thread::sleep_for(12ms);
+  });
+  loop.start();
+  std::this_thread::sleep_for(120ms);
+  loop.stop();
+
+  LoopStatistics statistics = loop.statistics();
+  ASSERT_GT(statistics.overruns, 0u);
+  ASSERT_LE(steps, 11);
+  ASSERT_GE(statistics.max_step, 12ms);
+  ASSERT_FALSE(statistics.summary().empty());
+}
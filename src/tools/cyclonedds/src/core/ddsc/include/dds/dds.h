@@ -1220,6 +1220,37 @@ dds_get_topic_filter_and_arg (
   dds_topic_filter_arg_fn *fn,
   void **arg);
 
+/** Topic filter function operating on the serialized representation */
+typedef bool (*dds_topic_serdata_filter_fn) (const struct ddsi_serdata * serdata, void * arg);
+
+/**
+ * @brief Sets a filter on a topic that is evaluated on the serialized
+ * representation of the samples, before they are converted to samples. Readers
+ * of the topic only store samples that the filter accepts. If the topic also
+ * has a filter set using dds_set_topic_filter_and_arg, a sample must pass both,
+ * and this one is evaluated first.
+ *
+ * The restrictions of dds_set_topic_filter_and_arg apply: create a topic
+ * entity specific to the reader you want to filter, set the filter, and only
+ * then create the reader.
+ *
+ * @param[in]  topic   The topic on which the content filter is set.
+ * @param[in]  filter  The filter function, or NULL to remove it.
+ * @param[in]  arg     Argument for the filter function.
+ *
+ * @returns A dds_return_t indicating success or failure.
+ *
+ * @retval DDS_RETCODE_OK  Filter set successfully
+ * @retval DDS_RETCODE_BAD_PARAMETER  The topic handle is invalid
+ * @retval DDS_RETCODE_ILLEGAL_OPERATION  The handle is not a topic
+ */
+DDS_EXPORT dds_return_t
+dds_set_topic_serdata_filter (
+  dds_entity_t topic,
+  dds_topic_serdata_filter_fn filter,
+  void *arg);
+#define DDS_HAS_TOPIC_SERDATA_FILTER 1
+
 /**
  * @brief Creates a new instance of a DDS subscriber
  *
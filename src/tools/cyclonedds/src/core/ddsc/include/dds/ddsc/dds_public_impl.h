@@ -174,7 +174,18 @@ enum dds_stream_opcode {
          e  = (unsigned 16 bits) offset to first instruction for case, from start of insn
               instruction sequence must end in RTS, at which point executes continues
               at the next field's instruction as specified by the union */
-  DDS_OP_JEQ = 0x03 << 24
+  DDS_OP_JEQ = 0x03 << 24,
+  /* block of primitive fields with the same layout in memory and in CDR (internal: only
+     present in the op streams derived when creating a topic, never in a descriptor)
+     [BLK,   a, f, 0] [offset] [size] [n]
+       where
+         a      = largest element size in the block, to which it must be aligned
+         f      = element size of the first field, to which the stream gets aligned
+         offset = offset of the block in memory
+         size   = size of the block in bytes
+         n      = number of words of the instructions for the individual fields that
+                  follow, which are executed instead if the stream offset is misaligned */
+  DDS_OP_BLK = 0x04 << 24
 };
 
 enum dds_stream_typecode {
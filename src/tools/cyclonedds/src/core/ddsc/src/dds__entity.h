@@ -105,7 +105,10 @@ union dds_status_union {
     const bool invoke = (listener->on_##name_ != 0) && enabled; \
     union dds_status_union lst; \
     update_##name_ (&e->m_##name_##_status, invoke ? &lst.name_ : NULL, data); \
-    if (invoke) { \
+    if (invoke && dds_listener_dispatch_async (&e->m_entity)) { \
+      dds_entity_status_reset (&e->m_entity, (status_mask_t) (1u << DDS_##NAME_##_STATUS_ID)); \
+      dds_listener_dispatch_enqueue (&e->m_entity, DDS_##NAME_##_STATUS_ID, &lst); \
+    } else if (invoke) { \
       dds_entity_status_reset (&e->m_entity, (status_mask_t) (1u << DDS_##NAME_##_STATUS_ID)); \
       e->m_entity.m_cb_pending_count++; \
       e->m_entity.m_cb_count++; \
@@ -137,6 +140,8 @@ dds_entity_pin (
   dds_entity_t hdl,
   dds_entity **eptr);
 
+DDS_EXPORT dds_return_t dds_entity_pin_with_origin (dds_entity_t hdl, bool from_user, dds_entity **eptr);
+
 DDS_EXPORT dds_return_t dds_entity_pin_for_delete (dds_entity_t hdl, bool explicit, dds_entity **eptr);
 
 DDS_EXPORT void dds_entity_unpin (
@@ -167,6 +167,16 @@ dds_handle_pin(
         dds_handle_t hdl,
         struct dds_handle_link **entity);
 
+/*
+ * Same as dds_handle_pin, but for internal use (from_user = false) it also
+ * allows pinning a handle of which the creation hasn't been completed yet.
+ */
+DDS_EXPORT int32_t
+dds_handle_pin_with_origin(
+        dds_handle_t hdl,
+        bool from_user,
+        struct dds_handle_link **entity);
+
 DDS_EXPORT int32_t
 dds_handle_pin_and_ref(
         dds_handle_t hdl,
@@ -0,0 +1,66 @@
+/*
+ * Copyright(c) 2020 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#ifndef _DDS_LISTENER_DISPATCH_H_
+#define _DDS_LISTENER_DISPATCH_H_
+
+#include "dds__types.h"
+#include "dds__entity.h"
+#include "dds__statistics.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* Asynchronous listener dispatch: if Listeners/Async is enabled, the domain has
+   a thread pool and listener invocations are queued on the entity rather than
+   made on the thread that raised the event.  Each entity has at most one
+   thread invoking its queued listeners at any one time, so the invocations
+   for an entity remain serialized and retain the order of the events.
+
+   Queued invocations count in m_cb_pending_count, so that everything that
+   waits for listeners to complete before changing the entity (deleting it,
+   setting the listener or status mask) also waits for the queued ones. */
+
+inline bool dds_listener_dispatch_async (const dds_entity *e) {
+  return e->m_domain->listener_pool != NULL;
+}
+
+void dds_listener_dispatch_init (dds_entity *e) ddsrt_nonnull_all;
+
+dds_return_t dds_listener_dispatch_start (struct dds_domain *dom) ddsrt_nonnull_all;
+void dds_listener_dispatch_stop (struct dds_domain *dom) ddsrt_nonnull_all;
+
+/* Queues an invocation of the listener for status_id, lst is the status
+   argument (ignored for DATA_AVAILABLE and DATA_ON_READERS, which also get
+   merged with one already queued); requires m_observers_lock */
+void dds_listener_dispatch_enqueue (dds_entity *e, enum dds_status_id status_id, const union dds_status_union *lst) ddsrt_nonnull ((1));
+
+/* Waits until m_cb_pending_count is 0, invoking queued listeners on the calling
+   thread if "help" is set and no other thread is doing so; requires
+   m_observers_lock.  The help must not be given when holding m_mutex, as
+   listeners are free to operate on the entity. */
+void dds_listener_dispatch_wait_locked (dds_entity *e, bool help) ddsrt_nonnull_all;
+
+/* Adds the listener dispatch statistics to stat, starting at index first: 4 entries,
+   matching DDS_LISTENER_DISPATCH_STATISTICS_KV */
+void dds_listener_dispatch_get_stats (const dds_entity *e, struct dds_statistics *stat, size_t first) ddsrt_nonnull_all;
+
+#define DDS_LISTENER_DISPATCH_STATISTICS_KV                 \
+  { "listener_dispatched", DDS_STAT_KIND_UINT64 },          \
+  { "listener_queue_max", DDS_STAT_KIND_UINT32 },           \
+  { "listener_latency_total", DDS_STAT_KIND_UINT64 },       \
+  { "listener_latency_max", DDS_STAT_KIND_UINT64 }
+
+#if defined (__cplusplus)
+}
+#endif
+#endif /* _DDS_LISTENER_DISPATCH_H_ */
@@ -22,9 +22,14 @@ struct ddsi_sertopic;
 struct ddsi_domaingv;
 struct dds_rhc_default;
 struct rhc_sample;
+struct dds_readcond;
 
 DDS_EXPORT struct dds_rhc *dds_rhc_default_new_xchecks (dds_reader *reader, struct ddsi_domaingv *gv, const struct ddsi_sertopic *topic, bool xchecks);
 DDS_EXPORT struct dds_rhc *dds_rhc_default_new (struct dds_reader *reader, const struct ddsi_sertopic *topic);
+
+/* Inverted state masks as used in read conditions, shared with the other RHC implementations */
+uint32_t dds_rhc_qmask_from_dcpsquery (uint32_t sample_states, uint32_t view_states, uint32_t instance_states);
+uint32_t dds_rhc_qmask_from_mask_n_cond (uint32_t mask, struct dds_readcond *cond);
 #ifdef DDSI_INCLUDE_LIFESPAN
 DDS_EXPORT ddsrt_mtime_t dds_rhc_default_sample_expired_cb(void *hc, ddsrt_mtime_t tnow);
 #endif
@@ -0,0 +1,35 @@
+/*
+ * Copyright(c) 2020 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#ifndef _DDS_RHC_LATEST_H_
+#define _DDS_RHC_LATEST_H_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+struct dds_rhc;
+struct dds_reader;
+struct ddsi_sertopic;
+
+/* Reader history cache for keyless topics with KEEP_LAST 1 history, holding just
+   the latest sample.  Taking it doesn't need a lock, so executor threads taking
+   data don't contend with the receive thread storing the next sample.
+
+   Whether it can be used depends on the topic and the reader QoS, it must be
+   decided before creating the reader. */
+DDS_EXPORT bool dds_rhc_latest_supported (const struct dds_reader *reader, const struct ddsi_sertopic *topic);
+DDS_EXPORT struct dds_rhc *dds_rhc_latest_new (struct dds_reader *reader, const struct ddsi_sertopic *topic);
+
+#if defined (__cplusplus)
+}
+#endif
+#endif
@@ -16,6 +16,8 @@
 
 #include "dds/dds.h"
 #include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/thread_pool.h"
 #include "dds/ddsi/q_rtps.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 #include "dds/ddsrt/avl.h"
@@ -57,6 +59,14 @@ typedef ddsrt_atomic_uint32_t status_and_enabled_t;
 typedef bool (*dds_querycondition_filter_with_ctx_fn) (const void * sample, const void *ctx);
 
 
+/* Statistics on asynchronous listener dispatch */
+struct dds_listener_dispatch_stats {
+  ddsrt_atomic_uint64_t dispatched;    /* number of listener invocations */
+  ddsrt_atomic_uint32_t queue_max;     /* maximum number of queued invocations */
+  ddsrt_atomic_uint64_t latency_total; /* sum of times from queueing to invocation (ns) */
+  ddsrt_atomic_uint64_t latency_max;   /* maximum time from queueing to invocation (ns) */
+};
+
 /* The listener struct. */
 
 struct dds_listener {
@@ -96,6 +106,7 @@ struct dds_listener {
 
 struct dds_domain;
 struct dds_entity;
+struct dds_listener_job;
 
 typedef struct dds_entity_deriver {
   /* Pending close can be used to terminate (blocking) actions on a entity before actually deleting it. */
@@ -157,6 +168,16 @@ typedef struct dds_entity {
   uint32_t m_cb_count;              /* [m_observers_lock] */
   uint32_t m_cb_pending_count;      /* [m_observers_lock] */
   dds_entity_observer *m_observers; /* [m_observers_lock] */
+
+  /* Listener invocations queued for the domain's listener thread pool (only
+     if asynchronous listener dispatch is enabled), see dds_listener_dispatch.c */
+  struct dds_listener_job *m_cb_jobs;      /* [m_observers_lock] FIFO of queued invocations */
+  struct dds_listener_job *m_cb_jobs_tail; /* [m_observers_lock] */
+  uint32_t m_cb_jobs_count;                /* [m_observers_lock] */
+  uint32_t m_cb_jobs_coalesced;            /* [m_observers_lock] status ids for which an invocation is queued, but only for those merged */
+  bool m_cb_draining;                      /* [m_observers_lock] some thread is invoking queued listeners */
+  bool m_cb_drain_submitted;               /* [m_observers_lock] drain task submitted to the thread pool */
+  struct dds_listener_dispatch_stats m_cb_stats; /* updated with m_observers_lock held, read without */
 } dds_entity;
 
 extern const ddsrt_avl_treedef_t dds_topictree_def;
@@ -237,6 +258,7 @@ typedef struct dds_domain {
   struct local_orphan_writer *builtintopic_writer_subscriptions;
 
   struct ddsi_builtin_topic_interface btif;
+  ddsrt_thread_pool listener_pool; /* non-null iff Listeners/Async is enabled */
   struct ddsi_domaingv gv;
 } dds_domain;
 
@@ -313,6 +335,8 @@ typedef struct dds_topic {
 
   dds_topic_filter_arg_fn filter_fn;
   void *filter_ctx;
+  dds_topic_serdata_filter_fn serdata_filter_fn;
+  void *serdata_filter_ctx;
 
   /* Status metrics */
 
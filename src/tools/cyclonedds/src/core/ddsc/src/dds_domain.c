@@ -20,6 +20,7 @@
 #include "dds__builtin.h"
 #include "dds__whc_builtintopic.h"
 #include "dds__entity.h"
+#include "dds__listener_dispatch.h"
 #include "dds/ddsi/ddsi_iid.h"
 #include "dds/ddsi/ddsi_tkmap.h"
 #include "dds/ddsi/ddsi_serdata.h"
@@ -145,6 +146,13 @@ static dds_entity_t dds_domain_init (dds_domain *domain, dds_domainid_t domain_i
   (void) snprintf (domain->gv.default_local_plist_pp.entity_name, len, "%s<%u>", progname, (unsigned) ddsrt_getpid ());
   domain->gv.default_local_plist_pp.present |= PP_ENTITY_NAME;
 
+  if (dds_listener_dispatch_start (domain) != DDS_RETCODE_OK)
+  {
+    DDS_ILOG (DDS_LC_CONFIG, domain->m_id, "Failed to create the listener thread pool\n");
+    domh = DDS_RETCODE_OUT_OF_RESOURCES;
+    goto fail_listener_dispatch_start;
+  }
+
   if (rtps_start (&domain->gv) < 0)
   {
     DDS_ILOG (DDS_LC_CONFIG, domain->m_id, "Failed to start RTPS\n");
@@ -158,6 +166,8 @@ static dds_entity_t dds_domain_init (dds_domain *domain, dds_domainid_t domain_i
   return domh;
 
 fail_rtps_start:
+  dds_listener_dispatch_stop (domain);
+fail_listener_dispatch_start:
   dds__builtin_fini (domain);
   if (domain->gv.config.liveliness_monitoring && dds_global.threadmon_count == 1)
     ddsi_threadmon_stop (dds_global.threadmon);
@@ -262,6 +272,7 @@ dds_entity_t dds_create_domain (const dds_domainid_t domain, const char *config)
 static dds_return_t dds_domain_free (dds_entity *vdomain)
 {
   struct dds_domain *domain = (struct dds_domain *) vdomain;
+  dds_listener_dispatch_stop (domain);
   rtps_stop (&domain->gv);
   dds__builtin_fini (domain);
 
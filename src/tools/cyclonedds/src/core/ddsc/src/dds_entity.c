@@ -19,6 +19,7 @@
 #include "dds__writer.h"
 #include "dds__reader.h"
 #include "dds__listener.h"
+#include "dds__listener_dispatch.h"
 #include "dds__qos.h"
 #include "dds__topic.h"
 #include "dds/version.h"
@@ -210,6 +211,7 @@ dds_entity_t dds_entity_init (dds_entity *e, dds_entity *parent, dds_entity_kind
   e->m_cb_count = 0;
   e->m_cb_pending_count = 0;
   e->m_observers = NULL;
+  dds_listener_dispatch_init (e);
 
   /* TODO: CHAM-96: Implement dynamic enabling of entity. */
   e->m_flags |= DDS_ENTITY_ENABLED;
@@ -369,6 +371,7 @@ dds_return_t dds_delete (dds_entity_t entity)
 
 void dds_entity_final_deinit_before_free (dds_entity *e)
 {
+  assert (e->m_cb_jobs == NULL);
   dds_delete_qos (e->m_qos);
   ddsrt_cond_destroy (&e->m_cond);
   ddsrt_cond_destroy (&e->m_observers_cond);
@@ -438,8 +441,7 @@ static dds_return_t really_delete_pinned_closed_locked (struct dds_entity *e, en
   /* wait for all listeners to complete - FIXME: rely on pincount instead?
      that would require all listeners to pin the entity instead, but it
      would prevent them from doing much. */
-  while (e->m_cb_pending_count > 0)
-    ddsrt_cond_wait (&e->m_observers_cond, &e->m_observers_lock);
+  dds_listener_dispatch_wait_locked (e, true);
   ddsrt_mutex_unlock (&e->m_observers_lock);
 
   /* Wait for all other threads to unpin the entity */
@@ -990,8 +992,7 @@ static void pushdown_listener (dds_entity *e)
       ddsrt_mutex_unlock (&e->m_mutex);
 
       ddsrt_mutex_lock (&c->m_observers_lock);
-      while (c->m_cb_pending_count > 0)
-        ddsrt_cond_wait (&c->m_observers_cond, &c->m_observers_lock);
+      dds_listener_dispatch_wait_locked (c, true);
 
       ddsrt_mutex_lock (&e->m_observers_lock);
       dds_override_inherited_listener (&c->m_listener, &e->m_listener);
@@ -1018,8 +1019,7 @@ dds_return_t dds_set_listener (dds_entity_t entity, const dds_listener_t *listen
     return rc;
 
   ddsrt_mutex_lock (&e->m_observers_lock);
-  while (e->m_cb_pending_count > 0)
-    ddsrt_cond_wait (&e->m_observers_cond, &e->m_observers_lock);
+  dds_listener_dispatch_wait_locked (e, true);
 
   /* new listener is constructed by combining "listener" with the ancestral listeners;
      the new set of listeners is then pushed down into the descendant entities, overriding
@@ -1136,8 +1136,7 @@ dds_return_t dds_set_status_mask (dds_entity_t entity, uint32_t mask)
   {
     assert (entity_has_status (e));
     ddsrt_mutex_lock (&e->m_observers_lock);
-    while (e->m_cb_pending_count > 0)
-      ddsrt_cond_wait (&e->m_observers_cond, &e->m_observers_lock);
+    dds_listener_dispatch_wait_locked (e, false);
 
     uint32_t old, new;
     do {
@@ -1266,6 +1265,19 @@ dds_return_t dds_entity_pin (dds_entity_t hdl, dds_entity **eptr)
   }
 }
 
+dds_return_t dds_entity_pin_with_origin (dds_entity_t hdl, bool from_user, dds_entity **eptr)
+{
+  dds_return_t hres;
+  struct dds_handle_link *hdllink;
+  if ((hres = dds_handle_pin_with_origin (hdl, from_user, &hdllink)) < 0)
+    return hres;
+  else
+  {
+    *eptr = dds_entity_from_handle_link (hdllink);
+    return DDS_RETCODE_OK;
+  }
+}
+
 dds_return_t dds_entity_pin_for_delete (dds_entity_t hdl, bool explicit, dds_entity **eptr)
 {
   dds_return_t hres;
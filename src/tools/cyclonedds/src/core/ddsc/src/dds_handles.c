@@ -210,7 +210,7 @@ int32_t dds_handle_delete (struct dds_handle_link *link)
   return DDS_RETCODE_OK;
 }
 
-static int32_t dds_handle_pin_int (dds_handle_t hdl, uint32_t delta, struct dds_handle_link **link)
+static int32_t dds_handle_pin_int (dds_handle_t hdl, uint32_t delta, bool from_user, struct dds_handle_link **link)
 {
   struct dds_handle_link dummy = { .hdl = hdl };
   int32_t rc;
@@ -237,7 +237,7 @@ static int32_t dds_handle_pin_int (dds_handle_t hdl, uint32_t delta, struct dds_
     rc = DDS_RETCODE_OK;
     do {
       cf = ddsrt_atomic_ld32 (&(*link)->cnt_flags);
-      if (cf & (HDL_FLAG_CLOSING | HDL_FLAG_PENDING))
+      if (cf & (HDL_FLAG_CLOSING | (from_user ? HDL_FLAG_PENDING : 0)))
       {
         rc = DDS_RETCODE_BAD_PARAMETER;
         break;
@@ -250,7 +250,12 @@ static int32_t dds_handle_pin_int (dds_handle_t hdl, uint32_t delta, struct dds_
 
 int32_t dds_handle_pin (dds_handle_t hdl, struct dds_handle_link **link)
 {
-  return dds_handle_pin_int (hdl, 1u, link);
+  return dds_handle_pin_int (hdl, 1u, true, link);
+}
+
+int32_t dds_handle_pin_with_origin (dds_handle_t hdl, bool from_user, struct dds_handle_link **link)
+{
+  return dds_handle_pin_int (hdl, 1u, from_user, link);
 }
 
 int32_t dds_handle_pin_for_delete (dds_handle_t hdl, bool explicit, struct dds_handle_link **link)
@@ -418,7 +423,7 @@ bool dds_handle_drop_childref_and_pin (struct dds_handle_link *link, bool may_de
 
 int32_t dds_handle_pin_and_ref (dds_handle_t hdl, struct dds_handle_link **link)
 {
-  return dds_handle_pin_int (hdl, HDL_REFCOUNT_UNIT + 1u, link);
+  return dds_handle_pin_int (hdl, HDL_REFCOUNT_UNIT + 1u, true, link);
 }
 
 void dds_handle_repin (struct dds_handle_link *link)
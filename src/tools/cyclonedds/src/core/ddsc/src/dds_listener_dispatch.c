@@ -0,0 +1,271 @@
+/*
+ * Copyright(c) 2020 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <assert.h>
+#include <stdint.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/time.h"
+#include "dds/ddsrt/thread_pool.h"
+#include "dds__listener_dispatch.h"
+
+extern inline bool dds_listener_dispatch_async (const dds_entity *e);
+
+/* Invocations of DATA_AVAILABLE and DATA_ON_READERS listeners carry no
+   information other than that there may be data, and so an event for which
+   one is still queued requires no additional invocation */
+#define COALESCED_STATUSES ((1u << DDS_DATA_AVAILABLE_STATUS_ID) | (1u << DDS_DATA_ON_READERS_STATUS_ID))
+
+struct dds_listener_job {
+  struct dds_listener_job *next;
+  enum dds_status_id status_id;
+  ddsrt_mtime_t tqueued;
+  union dds_status_union lst;
+};
+
+void dds_listener_dispatch_init (dds_entity *e)
+{
+  e->m_cb_jobs = NULL;
+  e->m_cb_jobs_tail = NULL;
+  e->m_cb_jobs_count = 0;
+  e->m_cb_jobs_coalesced = 0;
+  e->m_cb_draining = false;
+  e->m_cb_drain_submitted = false;
+  ddsrt_atomic_st64 (&e->m_cb_stats.dispatched, 0);
+  ddsrt_atomic_st32 (&e->m_cb_stats.queue_max, 0);
+  ddsrt_atomic_st64 (&e->m_cb_stats.latency_total, 0);
+  ddsrt_atomic_st64 (&e->m_cb_stats.latency_max, 0);
+}
+
+dds_return_t dds_listener_dispatch_start (struct dds_domain *dom)
+{
+  const struct config *config = &dom->gv.config;
+  dom->listener_pool = NULL;
+  if (!config->listener_async)
+    return DDS_RETCODE_OK;
+  /* Only one task is ever queued per entity, the actual invocations are queued
+     on the entities, so there is no point in limiting the pool's queue */
+  const uint32_t nthreads = (config->listener_threads > 0) ? config->listener_threads : 1;
+  if ((dom->listener_pool = ddsrt_thread_pool_new (1, nthreads, 0, NULL)) == NULL)
+    return DDS_RETCODE_OUT_OF_RESOURCES;
+  return DDS_RETCODE_OK;
+}
+
+void dds_listener_dispatch_stop (struct dds_domain *dom)
+{
+  /* All entities have been deleted by now and so have all queued invocations,
+     what remains at most are drain tasks for the deleted entities */
+  ddsrt_thread_pool_free (dom->listener_pool);
+  dom->listener_pool = NULL;
+}
+
+static void invoke_data_on_readers (dds_entity *rd, const struct dds_listener *lst)
+{
+  /* Same as the synchronous case in dds_reader_data_available_cb, the
+     subscriber's listener invocations are serialized on the subscriber */
+  dds_entity * const sub = rd->m_parent;
+  ddsrt_mutex_lock (&sub->m_observers_lock);
+  const uint32_t data_on_rds_enabled = (ddsrt_atomic_ld32 (&sub->m_status.m_status_and_mask) & (DDS_DATA_ON_READERS_STATUS << SAM_ENABLED_SHIFT));
+  if (data_on_rds_enabled)
+  {
+    sub->m_cb_pending_count++;
+    while (sub->m_cb_count > 0)
+      ddsrt_cond_wait (&sub->m_observers_cond, &sub->m_observers_lock);
+    sub->m_cb_count++;
+    ddsrt_mutex_unlock (&sub->m_observers_lock);
+
+    lst->on_data_on_readers (sub->m_hdllink.hdl, lst->on_data_on_readers_arg);
+
+    ddsrt_mutex_lock (&sub->m_observers_lock);
+    sub->m_cb_count--;
+    sub->m_cb_pending_count--;
+    ddsrt_cond_broadcast (&sub->m_observers_cond);
+  }
+  ddsrt_mutex_unlock (&sub->m_observers_lock);
+}
+
+static void invoke (dds_entity *e, const struct dds_listener_job *job)
+{
+  /* The listener can't change while invocations are pending, so accessing it
+     without holding m_observers_lock is fine */
+  struct dds_listener const * const lst = &e->m_listener;
+  const dds_entity_t hdl = e->m_hdllink.hdl;
+  switch (job->status_id)
+  {
+    case DDS_INCONSISTENT_TOPIC_STATUS_ID:
+      lst->on_inconsistent_topic (hdl, job->lst.inconsistent_topic, lst->on_inconsistent_topic_arg);
+      break;
+    case DDS_OFFERED_DEADLINE_MISSED_STATUS_ID:
+      lst->on_offered_deadline_missed (hdl, job->lst.offered_deadline_missed, lst->on_offered_deadline_missed_arg);
+      break;
+    case DDS_REQUESTED_DEADLINE_MISSED_STATUS_ID:
+      lst->on_requested_deadline_missed (hdl, job->lst.requested_deadline_missed, lst->on_requested_deadline_missed_arg);
+      break;
+    case DDS_OFFERED_INCOMPATIBLE_QOS_STATUS_ID:
+      lst->on_offered_incompatible_qos (hdl, job->lst.offered_incompatible_qos, lst->on_offered_incompatible_qos_arg);
+      break;
+    case DDS_REQUESTED_INCOMPATIBLE_QOS_STATUS_ID:
+      lst->on_requested_incompatible_qos (hdl, job->lst.requested_incompatible_qos, lst->on_requested_incompatible_qos_arg);
+      break;
+    case DDS_SAMPLE_LOST_STATUS_ID:
+      lst->on_sample_lost (hdl, job->lst.sample_lost, lst->on_sample_lost_arg);
+      break;
+    case DDS_SAMPLE_REJECTED_STATUS_ID:
+      lst->on_sample_rejected (hdl, job->lst.sample_rejected, lst->on_sample_rejected_arg);
+      break;
+    case DDS_DATA_ON_READERS_STATUS_ID:
+      invoke_data_on_readers (e, lst);
+      break;
+    case DDS_DATA_AVAILABLE_STATUS_ID:
+      lst->on_data_available (hdl, lst->on_data_available_arg);
+      break;
+    case DDS_LIVELINESS_LOST_STATUS_ID:
+      lst->on_liveliness_lost (hdl, job->lst.liveliness_lost, lst->on_liveliness_lost_arg);
+      break;
+    case DDS_LIVELINESS_CHANGED_STATUS_ID:
+      lst->on_liveliness_changed (hdl, job->lst.liveliness_changed, lst->on_liveliness_changed_arg);
+      break;
+    case DDS_PUBLICATION_MATCHED_STATUS_ID:
+      lst->on_publication_matched (hdl, job->lst.publication_matched, lst->on_publication_matched_arg);
+      break;
+    case DDS_SUBSCRIPTION_MATCHED_STATUS_ID:
+      lst->on_subscription_matched (hdl, job->lst.subscription_matched, lst->on_subscription_matched_arg);
+      break;
+  }
+}
+
+static void update_latency_stats (dds_entity *e, const struct dds_listener_job *job)
+{
+  const int64_t dt = ddsrt_time_monotonic ().v - job->tqueued.v;
+  const uint64_t lat = (dt > 0) ? (uint64_t) dt : 0;
+  /* single writer (m_observers_lock is held), so no need for anything fancy */
+  ddsrt_atomic_st64 (&e->m_cb_stats.dispatched, ddsrt_atomic_ld64 (&e->m_cb_stats.dispatched) + 1);
+  ddsrt_atomic_st64 (&e->m_cb_stats.latency_total, ddsrt_atomic_ld64 (&e->m_cb_stats.latency_total) + lat);
+  if (lat > ddsrt_atomic_ld64 (&e->m_cb_stats.latency_max))
+    ddsrt_atomic_st64 (&e->m_cb_stats.latency_max, lat);
+}
+
+static void drain_locked (dds_entity *e)
+{
+  struct dds_listener_job *job;
+  assert (!e->m_cb_draining);
+  e->m_cb_draining = true;
+  while ((job = e->m_cb_jobs) != NULL)
+  {
+    if ((e->m_cb_jobs = job->next) == NULL)
+      e->m_cb_jobs_tail = NULL;
+    e->m_cb_jobs_count--;
+    e->m_cb_jobs_coalesced &= ~(1u << job->status_id);
+
+    /* Deleting the entity or changing the status mask disables the invocations
+       that have been queued, data on readers is triggered by the reader's
+       data available status */
+    const enum dds_status_id enabled_id = (job->status_id == DDS_DATA_ON_READERS_STATUS_ID) ? DDS_DATA_AVAILABLE_STATUS_ID : job->status_id;
+    const bool enabled = (ddsrt_atomic_ld32 (&e->m_status.m_status_and_mask) & ((1u << enabled_id) << SAM_ENABLED_SHIFT)) != 0;
+    if (enabled)
+    {
+      update_latency_stats (e, job);
+      e->m_cb_count++;
+      ddsrt_mutex_unlock (&e->m_observers_lock);
+      invoke (e, job);
+      ddsrt_mutex_lock (&e->m_observers_lock);
+      e->m_cb_count--;
+    }
+    ddsrt_free (job);
+    e->m_cb_pending_count--;
+    ddsrt_cond_broadcast (&e->m_observers_cond);
+  }
+  e->m_cb_draining = false;
+}
+
+static void drain_task (void *varg)
+{
+  /* The entity may have been deleted since this task got submitted: in that
+     case the deleting thread has taken care of the queued invocations.  Events
+     can occur while the entity is still being created, hence the pin with
+     from_user = false */
+  const dds_entity_t hdl = (dds_entity_t) (intptr_t) varg;
+  dds_entity *e;
+  if (dds_entity_pin_with_origin (hdl, false, &e) != DDS_RETCODE_OK)
+    return;
+  ddsrt_mutex_lock (&e->m_observers_lock);
+  e->m_cb_drain_submitted = false;
+  if (!e->m_cb_draining)
+    drain_locked (e);
+  ddsrt_mutex_unlock (&e->m_observers_lock);
+  dds_entity_unpin (e);
+}
+
+void dds_listener_dispatch_enqueue (dds_entity *e, enum dds_status_id status_id, const union dds_status_union *lst)
+{
+  struct dds_domain * const dom = e->m_domain;
+  assert (dom->listener_pool != NULL);
+  if (e->m_cb_jobs_coalesced & (1u << status_id))
+    return;
+
+  /* Flow control: a full queue means listeners can't keep up with the events,
+     stall the source of the events until there is room again */
+  const uint32_t qmax = dom->gv.config.listener_queue_max;
+  while (qmax > 0 && e->m_cb_jobs_count >= qmax)
+  {
+    if (!e->m_cb_draining)
+      drain_locked (e);
+    else
+      ddsrt_cond_wait (&e->m_observers_cond, &e->m_observers_lock);
+  }
+
+  struct dds_listener_job *job = ddsrt_malloc (sizeof (*job));
+  job->next = NULL;
+  job->status_id = status_id;
+  job->tqueued = ddsrt_time_monotonic ();
+  if (lst && !((1u << status_id) & COALESCED_STATUSES))
+    job->lst = *lst;
+  if (e->m_cb_jobs)
+    e->m_cb_jobs_tail->next = job;
+  else
+    e->m_cb_jobs = job;
+  e->m_cb_jobs_tail = job;
+  e->m_cb_jobs_coalesced |= (1u << status_id) & COALESCED_STATUSES;
+  if (++e->m_cb_jobs_count > ddsrt_atomic_ld32 (&e->m_cb_stats.queue_max))
+    ddsrt_atomic_st32 (&e->m_cb_stats.queue_max, e->m_cb_jobs_count);
+  e->m_cb_pending_count++;
+
+  /* A thread that is currently draining the queue will pick up this one, too,
+     as will an already submitted task */
+  if (!e->m_cb_draining && !e->m_cb_drain_submitted)
+  {
+    if (ddsrt_thread_pool_submit (dom->listener_pool, drain_task, (void *) (intptr_t) e->m_hdllink.hdl) == DDS_RETCODE_OK)
+      e->m_cb_drain_submitted = true;
+    else
+      drain_locked (e);
+  }
+}
+
+void dds_listener_dispatch_wait_locked (dds_entity *e, bool help)
+{
+  while (e->m_cb_pending_count > 0)
+  {
+    /* A drain task may still be queued with all pool threads busy (perhaps
+       even with this very thread), so don't rely on it */
+    if (help && e->m_cb_jobs != NULL && !e->m_cb_draining)
+      drain_locked (e);
+    else
+      ddsrt_cond_wait (&e->m_observers_cond, &e->m_observers_lock);
+  }
+}
+
+void dds_listener_dispatch_get_stats (const dds_entity *e, struct dds_statistics *stat, size_t first)
+{
+  stat->kv[first + 0].u.u64 = ddsrt_atomic_ld64 (&e->m_cb_stats.dispatched);
+  stat->kv[first + 1].u.u32 = ddsrt_atomic_ld32 (&e->m_cb_stats.queue_max);
+  stat->kv[first + 2].u.u64 = ddsrt_atomic_ld64 (&e->m_cb_stats.latency_total);
+  stat->kv[first + 3].u.u64 = ddsrt_atomic_ld64 (&e->m_cb_stats.latency_max);
+}
@@ -21,6 +21,7 @@
 #include "dds__init.h"
 #include "dds/ddsc/dds_rhc.h"
 #include "dds__rhc_default.h"
+#include "dds__rhc_latest.h"
 #include "dds__topic.h"
 #include "dds__get_status.h"
 #include "dds__qos.h"
@@ -29,6 +30,7 @@
 #include "dds/ddsi/ddsi_domaingv.h"
 #include "dds__builtin.h"
 #include "dds__statistics.h"
+#include "dds__listener_dispatch.h"
 #include "dds/ddsi/ddsi_sertopic.h"
 #include "dds/ddsi/ddsi_entity_index.h"
 #include "dds/ddsi/ddsi_security_omg.h"
@@ -121,6 +123,25 @@ void dds_reader_data_available_cb (struct dds_reader *rd)
     return;
 
   ddsrt_mutex_lock (&rd->m_entity.m_observers_lock);
+  if (dds_listener_dispatch_async (&rd->m_entity))
+  {
+    struct dds_listener const * const lst = &rd->m_entity.m_listener;
+    if (lst->on_data_on_readers)
+      dds_listener_dispatch_enqueue (&rd->m_entity, DDS_DATA_ON_READERS_STATUS_ID, NULL);
+    else if (lst->on_data_available)
+      dds_listener_dispatch_enqueue (&rd->m_entity, DDS_DATA_AVAILABLE_STATUS_ID, NULL);
+    else
+    {
+      dds_entity * const sub = rd->m_entity.m_parent;
+      dds_entity_status_set (&rd->m_entity, DDS_DATA_AVAILABLE_STATUS);
+      ddsrt_mutex_lock (&sub->m_observers_lock);
+      dds_entity_status_set (sub, DDS_DATA_ON_READERS_STATUS);
+      ddsrt_mutex_unlock (&sub->m_observers_lock);
+    }
+    ddsrt_mutex_unlock (&rd->m_entity.m_observers_lock);
+    return;
+  }
+
   rd->m_entity.m_cb_pending_count++;
 
   /* FIXME: why wait if no listener is set? */
@@ -331,7 +352,8 @@ void dds_reader_status_cb (void *ventity, const status_cb_data_t *data)
      are stable */
   /* FIXME: why do this if no listener is set? */
   ddsrt_mutex_lock (&rd->m_entity.m_observers_lock);
-  while (rd->m_entity.m_cb_count > 0)
+  /* (asynchronously dispatched listeners get a copy of the status) */
+  while (rd->m_entity.m_cb_count > 0 && !dds_listener_dispatch_async (&rd->m_entity))
     ddsrt_cond_wait (&rd->m_entity.m_observers_cond, &rd->m_entity.m_observers_lock);
 
   const enum dds_status_id status_id = (enum dds_status_id) data->raw_status_id;
@@ -371,7 +393,8 @@ void dds_reader_status_cb (void *ventity, const status_cb_data_t *data)
 }
 
 static const struct dds_stat_keyvalue_descriptor dds_reader_statistics_kv[] = {
-  { "discarded_bytes", DDS_STAT_KIND_UINT64 }
+  { "discarded_bytes", DDS_STAT_KIND_UINT64 },
+  DDS_LISTENER_DISPATCH_STATISTICS_KV
 };
 
 static const struct dds_stat_descriptor dds_reader_statistics_desc = {
@@ -389,6 +412,7 @@ static void dds_reader_refresh_statistics (const struct dds_entity *entity, stru
   const struct dds_reader *rd = (const struct dds_reader *) entity;
   if (rd->m_rd)
     ddsi_get_reader_stats (rd->m_rd, &stat->kv[0].u.u64);
+  dds_listener_dispatch_get_stats (entity, stat, 1);
 }
 
 const struct dds_entity_deriver dds_entity_deriver_reader = {
@@ -524,7 +548,12 @@ static dds_entity_t dds_create_reader_int (dds_entity_t participant_or_subscribe
   const dds_entity_t reader = dds_entity_init (&rd->m_entity, &sub->m_entity, DDS_KIND_READER, false, rqos, listener, DDS_READER_STATUS_MASK);
   rd->m_sample_rejected_status.last_reason = DDS_NOT_REJECTED;
   rd->m_topic = tp;
-  rd->m_rhc = rhc ? rhc : dds_rhc_default_new (rd, tp->m_stopic);
+  if (rhc)
+    rd->m_rhc = rhc;
+  else if (dds_rhc_latest_supported (rd, tp->m_stopic))
+    rd->m_rhc = dds_rhc_latest_new (rd, tp->m_stopic);
+  else
+    rd->m_rhc = dds_rhc_default_new (rd, tp->m_stopic);
   if (dds_rhc_associate (rd->m_rhc, rd, tp->m_stopic, rd->m_entity.m_domain->gv.m_tkmap) < 0)
   {
     /* FIXME: see also create_querycond, need to be able to undo entity_init */
@@ -324,6 +324,8 @@ struct dds_rhc_default {
   const struct ddsi_sertopic *topic; /* topic description */
   uint32_t history_depth;            /* depth, 1 for KEEP_LAST_1, 2**32-1 for KEEP_ALL */
 
+  struct rhc_instance *keyless_inst; /* the (only) instance of a keyless topic, or NULL */
+
   ddsrt_mutex_t lock;
   dds_readcond * conds;              /* List of associated read conditions */
   uint32_t nconds;                   /* Number of associated read conditions */
@@ -946,7 +948,9 @@ static bool content_filter_accepts (const dds_reader *reader, const struct ddsi_
   if (reader)
   {
     const struct dds_topic *tp = reader->m_topic;
-    if (tp->filter_fn)
+    if (tp->serdata_filter_fn)
+      ret = (tp->serdata_filter_fn) (sample, tp->serdata_filter_ctx);
+    if (ret && tp->filter_fn)
     {
       char *tmp = ddsi_sertopic_alloc_sample (tp->m_stopic);
       ddsi_serdata_to_sample (sample, tmp, NULL, NULL);
@@ -1029,6 +1033,8 @@ static void drop_instance_noupdate_no_writers (struct dds_rhc_default *__restric
   ret = ddsrt_hh_remove (rhc->instances, inst);
   assert (ret);
   (void) ret;
+  if (rhc->keyless_inst == inst)
+    rhc->keyless_inst = NULL;
 
   free_empty_instance (inst, rhc);
   *instptr = NULL;
@@ -1413,6 +1419,8 @@ static rhc_store_result_t rhc_store_new_instance (struct rhc_instance **out_inst
   ret = ddsrt_hh_add (rhc->instances, inst);
   assert (ret);
   (void) ret;
+  if (rhc->topic->topickind_no_key)
+    rhc->keyless_inst = inst;
   rhc->n_instances++;
   rhc->n_new++;
 
@@ -1538,7 +1546,12 @@ static bool dds_rhc_default_store (struct ddsi_rhc * __restrict rhc_common, cons
 
   ddsrt_mutex_lock (&rhc->lock);
 
-  inst = ddsrt_hh_lookup (rhc->instances, &dummy_instance);
+  /* A keyless topic has a single instance, so skip the hash table if it is the one; it
+     need not be if samples arrive via different sertopics for the same topic */
+  if (rhc->keyless_inst && rhc->keyless_inst->iid == tk->m_iid)
+    inst = rhc->keyless_inst;
+  else
+    inst = ddsrt_hh_lookup (rhc->instances, &dummy_instance);
   if (inst == NULL)
   {
     /* New instance for this reader.  If no data content -- not (also)
@@ -1794,7 +1807,7 @@ static uint32_t qmask_of_inst (const struct rhc_instance *inst)
   return qm;
 }
 
-static uint32_t qmask_from_dcpsquery (uint32_t sample_states, uint32_t view_states, uint32_t instance_states)
+uint32_t dds_rhc_qmask_from_dcpsquery (uint32_t sample_states, uint32_t view_states, uint32_t instance_states)
 {
   uint32_t qminv = 0;
 
@@ -1840,7 +1853,7 @@ static uint32_t qmask_from_dcpsquery (uint32_t sample_states, uint32_t view_stat
   return qminv;
 }
 
-static uint32_t qmask_from_mask_n_cond (uint32_t mask, dds_readcond* cond)
+uint32_t dds_rhc_qmask_from_mask_n_cond (uint32_t mask, dds_readcond *cond)
 {
     uint32_t qminv;
     if (mask == NO_STATE_MASK_SET) {
@@ -1849,11 +1862,11 @@ static uint32_t qmask_from_mask_n_cond (uint32_t mask, dds_readcond* cond)
             qminv = cond->m_qminv;
         } else {
             /* No mask set and no condition: read all. */
-            qminv = qmask_from_dcpsquery(DDS_ANY_SAMPLE_STATE, DDS_ANY_VIEW_STATE, DDS_ANY_INSTANCE_STATE);
+            qminv = dds_rhc_qmask_from_dcpsquery(DDS_ANY_SAMPLE_STATE, DDS_ANY_VIEW_STATE, DDS_ANY_INSTANCE_STATE);
         }
     } else {
         /* Merge given mask with the condition mask when needed. */
-        qminv = qmask_from_dcpsquery(mask & DDS_ANY_SAMPLE_STATE, mask & DDS_ANY_VIEW_STATE, mask & DDS_ANY_INSTANCE_STATE);
+        qminv = dds_rhc_qmask_from_dcpsquery(mask & DDS_ANY_SAMPLE_STATE, mask & DDS_ANY_VIEW_STATE, mask & DDS_ANY_INSTANCE_STATE);
         if (cond != NULL) {
             qminv &= cond->m_qminv;
         }
@@ -2322,7 +2335,7 @@ static bool dds_rhc_default_add_readcondition (struct dds_rhc *rhc_common, dds_r
   assert (ddsrt_atomic_ld32 (&cond->m_entity.m_status.m_trigger) == 0);
   assert (cond->m_query.m_qcmask == 0);
 
-  cond->m_qminv = qmask_from_dcpsquery (cond->m_sample_states, cond->m_view_states, cond->m_instance_states);
+  cond->m_qminv = dds_rhc_qmask_from_dcpsquery (cond->m_sample_states, cond->m_view_states, cond->m_instance_states);
 
   ddsrt_mutex_lock (&rhc->lock);
 
@@ -2652,28 +2665,28 @@ static bool update_conditions_locked (struct dds_rhc_default *rhc, bool called_f
 static int32_t dds_rhc_default_read (struct dds_rhc *rhc_common, bool lock, void **values, dds_sample_info_t *info_seq, uint32_t max_samples, uint32_t mask, dds_instance_handle_t handle, dds_readcond *cond)
 {
   struct dds_rhc_default * const rhc = (struct dds_rhc_default *) rhc_common;
-  uint32_t qminv = qmask_from_mask_n_cond (mask, cond);
+  uint32_t qminv = dds_rhc_qmask_from_mask_n_cond (mask, cond);
   return dds_rhc_read_w_qminv (rhc, lock, values, info_seq, max_samples, qminv, handle, cond);
 }
 
 static int32_t dds_rhc_default_take (struct dds_rhc *rhc_common, bool lock, void **values, dds_sample_info_t *info_seq, uint32_t max_samples, uint32_t mask, dds_instance_handle_t handle, dds_readcond *cond)
 {
   struct dds_rhc_default * const rhc = (struct dds_rhc_default *) rhc_common;
-  uint32_t qminv = qmask_from_mask_n_cond(mask, cond);
+  uint32_t qminv = dds_rhc_qmask_from_mask_n_cond(mask, cond);
   return dds_rhc_take_w_qminv (rhc, lock, values, info_seq, max_samples, qminv, handle, cond);
 }
 
 static int32_t dds_rhc_default_readcdr (struct dds_rhc *rhc_common, bool lock, struct ddsi_serdata ** values, dds_sample_info_t *info_seq, uint32_t max_samples, uint32_t sample_states, uint32_t view_states, uint32_t instance_states, dds_instance_handle_t handle)
 {
   struct dds_rhc_default * const rhc = (struct dds_rhc_default *) rhc_common;
-  uint32_t qminv = qmask_from_dcpsquery (sample_states, view_states, instance_states);
+  uint32_t qminv = dds_rhc_qmask_from_dcpsquery (sample_states, view_states, instance_states);
   return dds_rhc_readcdr_w_qminv (rhc, lock, values, info_seq, max_samples, qminv, handle, NULL);
 }
 
 static int32_t dds_rhc_default_takecdr (struct dds_rhc *rhc_common, bool lock, struct ddsi_serdata ** values, dds_sample_info_t *info_seq, uint32_t max_samples, uint32_t sample_states, uint32_t view_states, uint32_t instance_states, dds_instance_handle_t handle)
 {
   struct dds_rhc_default * const rhc = (struct dds_rhc_default *) rhc_common;
-  uint32_t qminv = qmask_from_dcpsquery (sample_states, view_states, instance_states);
+  uint32_t qminv = dds_rhc_qmask_from_dcpsquery (sample_states, view_states, instance_states);
   return dds_rhc_takecdr_w_qminv (rhc, lock, values, info_seq, max_samples, qminv, handle, NULL);
 }
 
@@ -0,0 +1,1178 @@
+/*
+ * Copyright(c) 2020 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <assert.h>
+#include <string.h>
+#include <limits.h>
+
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/hopscotch.h"
+
+#include "dds__entity.h"
+#include "dds__reader.h"
+#include "dds/ddsc/dds_rhc.h"
+#include "dds__rhc_default.h"
+#include "dds__rhc_latest.h"
+#include "dds/ddsi/ddsi_tkmap.h"
+#include "dds/ddsi/ddsi_rhc.h"
+#include "dds/ddsi/ddsi_xqos.h"
+#include "dds/ddsi/q_config.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/ddsi/q_entity.h" /* status_cb_data_t */
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_sertopic.h"
+
+/* KEEP_LAST 1 HISTORY OF A KEYLESS TOPIC
+   ======================================
+
+   A keyless topic has a single instance, and with a history depth of 1 the
+   reader history is just its latest sample plus the instance state, small
+   enough for all the state that take modifies to fit in one 64-bit word:
+   the flags below in the low half and a version number in the high half.
+
+   Everything else the sample info needs (the sample pointer, the writer,
+   the generation counts, ...) is in "info", of which there are two copies:
+   version V uses info[V % 2].  Only the store side (store, unregister_wr
+   and adding a query condition, serialised by "store_lock") writes them, by
+   filling in info[(V+1) % 2] and then publishing version V+1 with a CAS on
+   the state word.  The next time it writes info[V % 2] again is after it
+   published V+1, so anyone who loaded version V, copied the info and then
+   successfully CAS'd the state word (still at version V) has a consistent
+   copy: it is a seqlock, with the CAS doing the validation.
+
+   The sample pointed to by the info holds a reference owned by the RHC if
+   (and only if) LATEST_VALID is set.  Whoever clears it -- a store replacing
+   the sample, or a take -- becomes the owner of that reference, which is
+   what makes a lock-free take possible: it doesn't touch the sample until
+   its CAS succeeded.
+
+   A non-destructive read needs a reference of its own while the RHC keeps
+   one, and a concurrent take could free the sample between the read's CAS
+   and its increment of the reference count, so reads first set LATEST_PIN,
+   which blocks takes until the read is done.  Reads hold "store_lock" (as
+   does lock_samples/read/take with lock=false), so takes that find the
+   sample pinned wait on that lock instead of spinning.  Reads are rare for
+   the readers that this is intended for.
+
+   Instance states follow dds_rhc_default, including the invalid samples
+   for state changes without data.  Instances are dropped when they contain
+   no samples and have no registered writers, i.e., LATEST_EXISTS cleared,
+   and all state reset.  The registrations are only accessed by the store
+   side and live outside the state word.
+
+   Read and query conditions attached to the reader have their trigger
+   values recomputed from the current state word after every change, with
+   "cond_lock" held.  Doing this after every change and always from the
+   latest state means the last one to do so always leaves the correct
+   values; the lock only guards against a recomputation based on an older
+   state overwriting a newer result.
+
+   The QoS settings that dds_rhc_default would have to check on every sample
+   (ownership, destination order, deadline, resource limits) are required to
+   be trivial for this RHC to be selected.  Lifespan is applied lazily: an
+   expired sample is dropped when a read or take comes across it. */
+
+#define LATEST_VALID      0x001u /* valid sample present, info.sample holds a ref */
+#define LATEST_VREAD      0x002u /* valid sample has been read */
+#define LATEST_INV        0x004u /* invalid sample present */
+#define LATEST_INVREAD    0x008u /* invalid sample has been read */
+#define LATEST_NEW        0x010u /* view state NEW */
+#define LATEST_DISPOSED   0x020u /* instance state NOT_ALIVE_DISPOSED */
+#define LATEST_NOWRITERS  0x040u /* no registered writers */
+#define LATEST_EXISTS     0x080u /* instance exists */
+#define LATEST_PIN        0x100u /* read in progress, take must wait */
+
+#define MAX_FAST_TRIGGERS 32
+
+#define TRACE(...) DDS_CLOG (DDS_LC_RHC, &rhc->gv->logconfig, __VA_ARGS__)
+
+struct rhc_latest_info {
+  struct ddsi_serdata *sample;       /* latest valid sample, meaningful iff LATEST_VALID */
+  uint64_t wr_iid;                   /* writer of the valid sample */
+  uint32_t disposed_gen;             /* disposed generation count of the valid sample */
+  uint32_t no_writers_gen;           /* no-writers generation count of the valid sample */
+  dds_querycond_mask_t conds;        /* query conditions matching the valid sample */
+#ifdef DDSI_INCLUDE_LIFESPAN
+  ddsrt_mtime_t t_expire;            /* expiry time of the valid sample */
+#endif
+  uint64_t inst_wr_iid;              /* most recent writer, for the invalid sample */
+  ddsrt_wctime_t inst_tstamp;        /* time stamp of the last update, for the invalid sample */
+  uint32_t inst_disposed_gen;        /* instance generation counts */
+  uint32_t inst_no_writers_gen;
+};
+
+struct rhc_latest_reg {
+  uint64_t wr_iid;
+};
+
+struct dds_rhc_latest {
+  struct dds_rhc common;
+  ddsrt_atomic_uint64_t state;       /* version << 32 | flags */
+  struct rhc_latest_info info[2];    /* info of version V is info[V % 2] */
+
+  /* Only touched by the store side */
+  ddsrt_mutex_t store_lock;
+  struct ddsi_tkmap_instance *tk;    /* set on the first sample, ref'd until the RHC is freed */
+  struct ddsrt_hh *registrations;    /* registered writers */
+  uint32_t wrcount;                  /* number of registered writers */
+  uint64_t wr_iid;                   /* last writer, registered if wr_iid_islive */
+  bool wr_iid_islive;
+  bool autodispose;                  /* if an auto-disposing writer registered */
+  void *qcond_eval_samplebuf;        /* sample for evaluating query conditions */
+
+  /* Conditions, changes require store_lock and cond_lock */
+  ddsrt_mutex_t cond_lock;
+  ddsrt_atomic_uint32_t nconds;
+  uint32_t nqconds;
+  dds_readcond *conds;
+  ddsrt_atomic_uint32_t inv_conds;   /* query conditions matching the invalid sample */
+
+  dds_reader *reader;
+  struct ddsi_tkmap *tkmap;
+  struct ddsi_domaingv *gv;
+  const struct ddsi_sertopic *topic;
+};
+
+static uint32_t flags_of (uint64_t s)
+{
+  return (uint32_t) s;
+}
+
+static uint32_t version_of (uint64_t s)
+{
+  return (uint32_t) (s >> 32);
+}
+
+static uint64_t make_state (uint32_t version, uint32_t flags)
+{
+  return ((uint64_t) version << 32) | flags;
+}
+
+static bool is_empty (uint32_t f)
+{
+  return (f & (LATEST_VALID | LATEST_INV)) == 0;
+}
+
+static uint32_t drop_if_unused (uint32_t f)
+{
+  /* Instances without samples and writers go */
+  return (is_empty (f) && (f & LATEST_NOWRITERS)) ? 0 : f;
+}
+
+static uint32_t qmask_of_inst (uint32_t f)
+{
+  uint32_t qm = (f & LATEST_NEW) ? DDS_NEW_VIEW_STATE : DDS_NOT_NEW_VIEW_STATE;
+  if (f & LATEST_DISPOSED)
+    qm |= DDS_NOT_ALIVE_DISPOSED_INSTANCE_STATE;
+  else if (f & LATEST_NOWRITERS)
+    qm |= DDS_NOT_ALIVE_NO_WRITERS_INSTANCE_STATE;
+  else
+    qm |= DDS_ALIVE_INSTANCE_STATE;
+  return qm;
+}
+
+static uint32_t qmask_of_sample (uint32_t f)
+{
+  return (f & LATEST_VREAD) ? DDS_READ_SAMPLE_STATE : DDS_NOT_READ_SAMPLE_STATE;
+}
+
+static uint32_t qmask_of_invsample (uint32_t f)
+{
+  return (f & LATEST_INVREAD) ? DDS_READ_SAMPLE_STATE : DDS_NOT_READ_SAMPLE_STATE;
+}
+
+static uint32_t reg_hash (const void *va)
+{
+  const struct rhc_latest_reg *a = va;
+  return (uint32_t) (((a->wr_iid >> 32) ^ a->wr_iid) * UINT64_C (16292676669999574021) >> 32);
+}
+
+static int reg_eq (const void *va, const void *vb)
+{
+  const struct rhc_latest_reg *a = va;
+  const struct rhc_latest_reg *b = vb;
+  return a->wr_iid == b->wr_iid;
+}
+
+static void reg_free (void *vnode, void *varg)
+{
+  (void) varg;
+  ddsrt_free (vnode);
+}
+
+static bool is_registered_locked (const struct dds_rhc_latest *rhc, uint64_t wr_iid)
+{
+  if (rhc->wr_iid_islive && rhc->wr_iid == wr_iid)
+    return true;
+  else if (rhc->wrcount == 0)
+    return false;
+  else
+  {
+    struct rhc_latest_reg template = { .wr_iid = wr_iid };
+    return ddsrt_hh_lookup (rhc->registrations, &template) != NULL;
+  }
+}
+
+static bool content_filter_accepts (const dds_reader *reader, const struct ddsi_serdata *sample)
+{
+  bool ret = true;
+  const struct dds_topic *tp = reader->m_topic;
+  if (tp->serdata_filter_fn)
+    ret = (tp->serdata_filter_fn) (sample, tp->serdata_filter_ctx);
+  if (ret && tp->filter_fn)
+  {
+    char *tmp = ddsi_sertopic_alloc_sample (tp->m_stopic);
+    ddsi_serdata_to_sample (sample, tmp, NULL, NULL);
+    ret = (tp->filter_fn) (tmp, tp->filter_ctx);
+    ddsi_sertopic_free_sample (tp->m_stopic, tmp, DDS_FREE_ALL);
+  }
+  return ret;
+}
+
+static void clean_invsample (const struct ddsi_sertopic *topic, void *sample)
+{
+  /* Keyless, so an invalid sample has no content at all */
+  ddsi_sertopic_free_sample (topic, sample, DDS_FREE_CONTENTS);
+  ddsi_sertopic_zero_sample (topic, sample);
+}
+
+static bool eval_predicate_sample (const struct dds_rhc_latest *rhc, const struct ddsi_serdata *sample, bool (*pred) (const void *sample))
+{
+  ddsi_serdata_to_sample (sample, rhc->qcond_eval_samplebuf, NULL, NULL);
+  return pred (rhc->qcond_eval_samplebuf);
+}
+
+static bool eval_predicate_invsample (const struct dds_rhc_latest *rhc, bool (*pred) (const void *sample))
+{
+  clean_invsample (rhc->topic, rhc->qcond_eval_samplebuf);
+  return pred (rhc->qcond_eval_samplebuf);
+}
+
+/*************************
+ ******  CONDITIONS  ******
+ *************************/
+
+static uint32_t cond_trigger (const dds_readcond *c, uint32_t f, dds_querycond_mask_t sample_conds, dds_querycond_mask_t inv_conds)
+{
+  /* Read conditions count matching instances, query conditions matching samples */
+  const dds_querycond_mask_t qcmask = c->m_query.m_qcmask;
+  uint32_t n = 0;
+  if (is_empty (f) || (qmask_of_inst (f) & c->m_qminv) != 0)
+    return 0;
+  if ((f & LATEST_VALID) && (qmask_of_sample (f) & c->m_qminv) == 0 && (qcmask == 0 || (sample_conds & qcmask)))
+    n++;
+  if ((f & LATEST_INV) && (qmask_of_invsample (f) & c->m_qminv) == 0 && (qcmask == 0 || (inv_conds & qcmask)))
+    n++;
+  return (qcmask == 0 && n > 0) ? 1 : n;
+}
+
+static uint64_t load_state_and_conds (struct dds_rhc_latest *rhc, dds_querycond_mask_t *sample_conds)
+{
+  uint64_t s, s1;
+  do {
+    s = ddsrt_atomic_ld64 (&rhc->state);
+    ddsrt_atomic_fence_acq ();
+    *sample_conds = rhc->info[version_of (s) & 1].conds;
+    ddsrt_atomic_fence_ldld ();
+    s1 = ddsrt_atomic_ld64 (&rhc->state);
+  } while (version_of (s1) != version_of (s));
+  return s;
+}
+
+static void update_conditions_locked (struct dds_rhc_latest *rhc, dds_entity *triggers[], size_t *ntriggers)
+{
+  dds_querycond_mask_t sample_conds;
+  const uint32_t f = flags_of (load_state_and_conds (rhc, &sample_conds));
+  const dds_querycond_mask_t inv_conds = ddsrt_atomic_ld32 (&rhc->inv_conds);
+  for (dds_readcond *c = rhc->conds; c != NULL; c = c->m_next)
+  {
+    const uint32_t trig = cond_trigger (c, f, sample_conds, inv_conds);
+    const uint32_t old = ddsrt_atomic_ld32 (&c->m_entity.m_status.m_trigger);
+    if (trig != old)
+    {
+      ddsrt_atomic_st32 (&c->m_entity.m_status.m_trigger, trig);
+      if (old == 0)
+      {
+        if (*ntriggers < MAX_FAST_TRIGGERS)
+          triggers[(*ntriggers)++] = &c->m_entity;
+        else
+          dds_entity_status_signal (&c->m_entity, DDS_DATA_AVAILABLE_STATUS);
+      }
+    }
+  }
+}
+
+static void update_conditions (struct dds_rhc_latest *rhc)
+{
+  /* Called after the CAS publishing a change, which is a full barrier, pairing with
+     the fence in add_readcondition: either this sees the new condition, or
+     add_readcondition sees the state this is updating the conditions for */
+  if (ddsrt_atomic_ld32 (&rhc->nconds) == 0)
+    return;
+  dds_entity *triggers[MAX_FAST_TRIGGERS];
+  size_t ntriggers = 0;
+  ddsrt_mutex_lock (&rhc->cond_lock);
+  update_conditions_locked (rhc, triggers, &ntriggers);
+  ddsrt_mutex_unlock (&rhc->cond_lock);
+  for (size_t i = 0; i < ntriggers; i++)
+    dds_entity_status_signal (triggers[i], 0);
+}
+
+/*************************
+ ******    STORE    ******
+ *************************/
+
+struct latest_op {
+  const struct ddsi_writer_info *wrinfo;
+  struct ddsi_serdata *sample;       /* ref'd, NULL if no data */
+  ddsrt_wctime_t tstamp;
+  bool is_dispose;
+  bool is_unregister;
+  bool filtered;
+  dds_querycond_mask_t conds;        /* query conditions matching sample */
+};
+
+/* Copy of the registrations of the instance, updated while computing a transition
+   and committed once the new state is published */
+struct latest_regs {
+  uint32_t wrcount;
+  bool registered;                   /* whether op->wrinfo->iid is registered */
+  uint64_t wr_iid;
+  bool wr_iid_islive;
+  bool autodispose;
+};
+
+static void set_invsample (uint32_t *f, bool *nda)
+{
+  if (!(*f & LATEST_INV) || (*f & LATEST_INVREAD))
+    *f = (*f | LATEST_INV) & ~LATEST_INVREAD;
+  *nda = true;
+}
+
+static void set_sample (uint32_t *f, struct rhc_latest_info *info, const struct latest_op *op, bool *nda)
+{
+  /* Replaces a valid sample if present and drops the invalid sample */
+  info->sample = op->sample;
+  info->wr_iid = op->wrinfo->iid;
+  info->disposed_gen = info->inst_disposed_gen;
+  info->no_writers_gen = info->inst_no_writers_gen;
+  info->conds = op->conds;
+#ifdef DDSI_INCLUDE_LIFESPAN
+  info->t_expire = op->wrinfo->lifespan_exp;
+#endif
+  *f = (*f | LATEST_VALID) & ~(LATEST_VREAD | LATEST_INV | LATEST_INVREAD);
+  *nda = true;
+}
+
+static void do_register (uint32_t *f, struct rhc_latest_info *info, struct latest_regs *rg, const struct ddsi_writer_info *wrinfo, bool sample_accepted, bool *nda)
+{
+  if (rg->wr_iid_islive && rg->wr_iid == wrinfo->iid)
+    return;
+  if (rg->wrcount == 0)
+  {
+    /* see dds_rhc_register: re-registering after a rejected sample must not make the
+       writer "live", or it would affect the acceptance of its next sample */
+    rg->wr_iid = wrinfo->iid;
+    rg->wr_iid_islive = sample_accepted;
+    rg->wrcount = 1;
+    rg->registered = true;
+    rg->autodispose = wrinfo->auto_dispose;
+    info->inst_no_writers_gen++;
+    *f &= ~LATEST_NOWRITERS;
+    *nda = true;
+  }
+  else
+  {
+    if (!rg->registered)
+    {
+      rg->registered = true;
+      rg->wrcount++;
+      if (wrinfo->auto_dispose)
+        rg->autodispose = true;
+    }
+    if (sample_accepted)
+    {
+      rg->wr_iid = wrinfo->iid;
+      rg->wr_iid_islive = true;
+    }
+  }
+}
+
+static void do_unregister (uint32_t *f, struct rhc_latest_info *info, struct latest_regs *rg, const struct ddsi_writer_info *wrinfo, ddsrt_wctime_t tstamp, bool *nda)
+{
+  if (!rg->registered)
+    return;
+  rg->registered = false;
+  if (wrinfo->auto_dispose)
+    rg->autodispose = true;
+  if (--rg->wrcount > 0)
+  {
+    if (rg->wr_iid_islive && rg->wr_iid == wrinfo->iid)
+      rg->wr_iid_islive = false;
+    return;
+  }
+
+  *f |= LATEST_NOWRITERS;
+  rg->wr_iid_islive = false;
+  if (!is_empty (*f))
+  {
+    /* Content remains until taken; add an invalid sample to signal the state change
+       if the application already read the latest sample */
+    if (!(*f & LATEST_DISPOSED))
+    {
+      if (!(*f & LATEST_VALID) || (*f & LATEST_VREAD))
+      {
+        set_invsample (f, nda);
+        info->inst_tstamp = tstamp;
+      }
+      if (rg->autodispose)
+        *f |= LATEST_DISPOSED;
+      *nda = true;
+    }
+  }
+  else if (!(*f & LATEST_DISPOSED))
+  {
+    set_invsample (f, nda);
+    info->inst_tstamp = tstamp;
+    if (rg->autodispose)
+      *f |= LATEST_DISPOSED;
+  }
+}
+
+/* Computes the state after applying op to flags f, info and registrations, returns
+   false if op is to be ignored; mirrors dds_rhc_default_store */
+static bool latest_transition (uint32_t *f, struct rhc_latest_info *info, struct latest_regs *rg, const struct latest_op *op, bool *stored, bool *nda, bool *lost)
+{
+  const bool has_data = (op->sample != NULL);
+
+  if (!(*f & LATEST_EXISTS))
+  {
+    /* never instantiate on filtered data or a pure unregister */
+    if (op->filtered || (!has_data && !op->is_dispose))
+      return false;
+    *f = LATEST_EXISTS | LATEST_NEW;
+    info->inst_disposed_gen = 0;
+    info->inst_no_writers_gen = 0;
+    rg->wrcount = 1;
+    rg->registered = true;
+    rg->wr_iid = op->wrinfo->iid;
+    rg->wr_iid_islive = true;
+    rg->autodispose = op->wrinfo->auto_dispose;
+    if (op->is_dispose)
+      *f |= LATEST_DISPOSED;
+    if (has_data)
+    {
+      set_sample (f, info, op, nda);
+      *stored = true;
+    }
+    else
+    {
+      set_invsample (f, nda);
+    }
+  }
+  else if (op->filtered)
+  {
+    /* Rejected data (and disposes) still register the writer */
+    bool reg_nda = false;
+    do_register (f, info, rg, op->wrinfo, false, &reg_nda);
+    if (reg_nda && (!(*f & LATEST_VALID) || (*f & LATEST_VREAD)))
+      set_invsample (f, nda);
+    *nda = *nda || reg_nda;
+    *lost = true;
+  }
+  else if (has_data || op->is_dispose)
+  {
+    const bool not_alive = rg->wrcount == 0 || (*f & LATEST_DISPOSED);
+    const bool old_isdisposed = (*f & LATEST_DISPOSED) != 0;
+    do_register (f, info, rg, op->wrinfo, true, nda);
+    if (has_data && not_alive)
+    {
+      *f |= LATEST_NEW;
+      *nda = true;
+    }
+    if (has_data && (*f & LATEST_DISPOSED))
+    {
+      info->inst_disposed_gen++;
+      if (!op->is_dispose)
+        *f &= ~LATEST_DISPOSED;
+      *nda = true;
+    }
+    if (op->is_dispose && !(*f & LATEST_DISPOSED))
+    {
+      *f |= LATEST_DISPOSED;
+      *nda = true;
+    }
+    if (has_data)
+    {
+      set_sample (f, info, op, nda);
+      *stored = true;
+    }
+    if ((*f & LATEST_DISPOSED) && !old_isdisposed && (!(*f & LATEST_VALID) || (*f & LATEST_VREAD)))
+      set_invsample (f, nda);
+    info->inst_tstamp = op->tstamp;
+    rg->wr_iid = op->wrinfo->iid;
+    rg->wr_iid_islive = true;
+  }
+
+  if (op->is_unregister)
+    do_unregister (f, info, rg, op->wrinfo, op->tstamp, nda);
+
+  info->inst_wr_iid = rg->wr_iid;
+  *f = drop_if_unused (*f);
+  return true;
+}
+
+static bool latest_apply_locked (struct dds_rhc_latest *rhc, const struct latest_op *op, bool *nda, bool *lost)
+{
+  const uint64_t wr_iid = op->wrinfo->iid;
+  const bool registered = is_registered_locked (rhc, wr_iid);
+  struct ddsi_serdata *replaced = NULL;
+  struct latest_regs rg;
+  bool stored;
+  uint64_t s;
+
+  for (;;)
+  {
+    s = ddsrt_atomic_ld64 (&rhc->state);
+    assert (!(s & LATEST_PIN));
+    const uint32_t v = version_of (s);
+    struct rhc_latest_info * const nxt = &rhc->info[(v + 1) & 1];
+    uint32_t f = flags_of (s);
+    *nxt = rhc->info[v & 1];
+    /* A take may have dropped the instance, but only if it had no writers left,
+       and then the registrations are empty already */
+    rg.wrcount = rhc->wrcount;
+    rg.registered = registered;
+    rg.wr_iid = rhc->wr_iid;
+    rg.wr_iid_islive = rhc->wr_iid_islive;
+    rg.autodispose = rhc->autodispose;
+    stored = *nda = *lost = false;
+    if (!latest_transition (&f, nxt, &rg, op, &stored, nda, lost))
+      return false;
+    if (ddsrt_atomic_cas64 (&rhc->state, s, make_state (v + 1, f)))
+      break;
+  }
+
+  /* The new state is published, and with it the ownership of the old sample if it was replaced */
+  if (stored && (s & LATEST_VALID))
+    replaced = rhc->info[version_of (s) & 1].sample;
+
+  if (rg.registered != registered)
+  {
+    struct rhc_latest_reg template = { .wr_iid = wr_iid };
+    if (rg.registered)
+    {
+      struct rhc_latest_reg *reg = ddsrt_malloc (sizeof (*reg));
+      reg->wr_iid = wr_iid;
+      (void) ddsrt_hh_add (rhc->registrations, reg);
+    }
+    else
+    {
+      struct rhc_latest_reg *reg = ddsrt_hh_lookup (rhc->registrations, &template);
+      assert (reg != NULL);
+      (void) ddsrt_hh_remove (rhc->registrations, reg);
+      ddsrt_free (reg);
+    }
+  }
+  rhc->wrcount = rg.wrcount;
+  rhc->wr_iid = rg.wr_iid;
+  rhc->wr_iid_islive = rg.wr_iid_islive;
+  rhc->autodispose = (rg.wrcount > 0) ? rg.autodispose : false;
+
+  if (replaced)
+    ddsi_serdata_unref (replaced);
+  return stored;
+}
+
+static bool dds_rhc_latest_store (struct ddsi_rhc * __restrict rhc_common, const struct ddsi_writer_info * __restrict wrinfo, struct ddsi_serdata * __restrict sample, struct ddsi_tkmap_instance * __restrict tk)
+{
+  struct dds_rhc_latest * const __restrict rhc = (struct dds_rhc_latest * __restrict) rhc_common;
+  const uint32_t statusinfo = sample->statusinfo;
+  const bool has_data = (sample->kind == SDK_DATA);
+  struct latest_op op;
+  bool nda, lost;
+
+  TRACE ("rhc_latest_store %"PRIx64",%"PRIx64" si %x has_data %d:", tk->m_iid, wrinfo->iid, statusinfo, has_data);
+  if (!has_data && statusinfo == 0)
+  {
+    /* explicit register, done implicitly */
+    TRACE (" ignore explicit register\n");
+    return true;
+  }
+
+  op.wrinfo = wrinfo;
+  op.sample = has_data ? ddsi_serdata_ref (sample) : NULL;
+  op.tstamp = sample->timestamp;
+  op.is_dispose = (statusinfo & NN_STATUSINFO_DISPOSE) != 0;
+  op.is_unregister = (statusinfo & NN_STATUSINFO_UNREGISTER) != 0;
+  op.conds = 0;
+
+  ddsrt_mutex_lock (&rhc->store_lock);
+  if (rhc->tk == NULL)
+  {
+    /* Keyless, so it is the same instance for all sertopics of the topic */
+    ddsi_tkmap_instance_ref (tk);
+    rhc->tk = tk;
+  }
+  op.filtered = has_data && !content_filter_accepts (rhc->reader, sample);
+  if (has_data && !op.filtered && rhc->nqconds != 0)
+  {
+    for (dds_readcond *rc = rhc->conds; rc != NULL; rc = rc->m_next)
+      if (rc->m_query.m_filter != 0 && eval_predicate_sample (rhc, sample, rc->m_query.m_filter))
+        op.conds |= rc->m_query.m_qcmask;
+  }
+  const bool stored = latest_apply_locked (rhc, &op, &nda, &lost);
+  ddsrt_mutex_unlock (&rhc->store_lock);
+  TRACE (" stored %d nda %d\n", stored, nda);
+
+  if (op.sample && !stored)
+    ddsi_serdata_unref (op.sample);
+  update_conditions (rhc);
+  if (nda)
+    dds_reader_data_available_cb (rhc->reader);
+  if (lost)
+  {
+    status_cb_data_t cb_data;
+    cb_data.raw_status_id = (int) DDS_SAMPLE_LOST_STATUS_ID;
+    cb_data.extra = 0;
+    cb_data.handle = 0;
+    cb_data.add = true;
+    dds_reader_status_cb (&rhc->reader->m_entity, &cb_data);
+  }
+  return true;
+}
+
+static void dds_rhc_latest_unregister_wr (struct ddsi_rhc * __restrict rhc_common, const struct ddsi_writer_info * __restrict wrinfo)
+{
+  struct dds_rhc_latest * const __restrict rhc = (struct dds_rhc_latest * __restrict) rhc_common;
+  bool nda = false, lost;
+  ddsrt_mutex_lock (&rhc->store_lock);
+  TRACE ("rhc_latest_unregister_wr %"PRIx64",%d\n", wrinfo->iid, wrinfo->auto_dispose);
+  if (is_registered_locked (rhc, wrinfo->iid))
+  {
+    struct latest_op op;
+    op.wrinfo = wrinfo;
+    op.sample = NULL;
+    op.tstamp = rhc->info[version_of (ddsrt_atomic_ld64 (&rhc->state)) & 1].inst_tstamp;
+    op.is_dispose = false;
+    op.is_unregister = true;
+    op.filtered = false;
+    op.conds = 0;
+    (void) latest_apply_locked (rhc, &op, &nda, &lost);
+  }
+  ddsrt_mutex_unlock (&rhc->store_lock);
+  update_conditions (rhc);
+  if (nda)
+    dds_reader_data_available_cb (rhc->reader);
+}
+
+static void dds_rhc_latest_relinquish_ownership (struct ddsi_rhc * __restrict rhc_common, const uint64_t wr_iid)
+{
+  /* Ownership is always shared, so this only affects the cached writer */
+  struct dds_rhc_latest * const __restrict rhc = (struct dds_rhc_latest * __restrict) rhc_common;
+  ddsrt_mutex_lock (&rhc->store_lock);
+  if (rhc->wr_iid_islive && rhc->wr_iid == wr_iid && rhc->wrcount > 1)
+    rhc->wr_iid_islive = false;
+  ddsrt_mutex_unlock (&rhc->store_lock);
+}
+
+static void dds_rhc_latest_set_qos (struct ddsi_rhc *rhc_common, const dds_qos_t *qos)
+{
+  /* The QoS that matter can't be changed once the reader exists, and samples are
+     never rejected, so reliability doesn't matter either */
+  (void) rhc_common; (void) qos;
+}
+
+static void dds_rhc_latest_free (struct ddsi_rhc *rhc_common)
+{
+  struct dds_rhc_latest *rhc = (struct dds_rhc_latest *) rhc_common;
+  const uint64_t s = ddsrt_atomic_ld64 (&rhc->state);
+  assert (rhc->conds == NULL);
+  if (s & LATEST_VALID)
+    ddsi_serdata_unref (rhc->info[version_of (s) & 1].sample);
+  if (rhc->tk)
+    ddsi_tkmap_instance_unref (rhc->tkmap, rhc->tk);
+  ddsrt_hh_enum (rhc->registrations, reg_free, NULL);
+  ddsrt_hh_free (rhc->registrations);
+  if (rhc->qcond_eval_samplebuf != NULL)
+    ddsi_sertopic_free_sample (rhc->topic, rhc->qcond_eval_samplebuf, DDS_FREE_ALL);
+  ddsrt_mutex_destroy (&rhc->cond_lock);
+  ddsrt_mutex_destroy (&rhc->store_lock);
+  ddsrt_free (rhc);
+}
+
+/*************************
+ ******  READ/TAKE  ******
+ *************************/
+
+static bool sample_expired (const struct rhc_latest_info *info)
+{
+#ifdef DDSI_INCLUDE_LIFESPAN
+  return info->t_expire.v != DDS_NEVER && info->t_expire.v <= ddsrt_time_monotonic ().v;
+#else
+  (void) info;
+  return false;
+#endif
+}
+
+static bool sample_matches (uint32_t f, const struct rhc_latest_info *info, uint32_t qminv, dds_querycond_mask_t qcmask)
+{
+  return (f & LATEST_VALID) && (qmask_of_sample (f) & qminv) == 0 && (qcmask == 0 || (info->conds & qcmask));
+}
+
+static bool invsample_matches (const struct dds_rhc_latest *rhc, uint32_t f, uint32_t qminv, dds_querycond_mask_t qcmask)
+{
+  return (f & LATEST_INV) && (qmask_of_invsample (f) & qminv) == 0 && (qcmask == 0 || (ddsrt_atomic_ld32 (&rhc->inv_conds) & qcmask));
+}
+
+static void set_sample_info (dds_sample_info_t *si, const struct dds_rhc_latest *rhc, uint32_t f, const struct rhc_latest_info *info)
+{
+  si->sample_state = (f & LATEST_VREAD) ? DDS_SST_READ : DDS_SST_NOT_READ;
+  si->view_state = (f & LATEST_NEW) ? DDS_VST_NEW : DDS_VST_OLD;
+  si->instance_state = (f & LATEST_DISPOSED) ? DDS_IST_NOT_ALIVE_DISPOSED : (f & LATEST_NOWRITERS) ? DDS_IST_NOT_ALIVE_NO_WRITERS : DDS_IST_ALIVE;
+  si->instance_handle = rhc->tk->m_iid;
+  si->publication_handle = info->wr_iid;
+  si->disposed_generation_count = info->disposed_gen;
+  si->no_writers_generation_count = info->no_writers_gen;
+  si->sample_rank = 0;
+  si->generation_rank = 0;
+  si->absolute_generation_rank = (info->inst_disposed_gen + info->inst_no_writers_gen) - (info->disposed_gen + info->no_writers_gen);
+  si->valid_data = true;
+  si->source_timestamp = info->sample->timestamp.v;
+}
+
+static void set_sample_info_invsample (dds_sample_info_t *si, const struct dds_rhc_latest *rhc, uint32_t f, const struct rhc_latest_info *info)
+{
+  si->sample_state = (f & LATEST_INVREAD) ? DDS_SST_READ : DDS_SST_NOT_READ;
+  si->view_state = (f & LATEST_NEW) ? DDS_VST_NEW : DDS_VST_OLD;
+  si->instance_state = (f & LATEST_DISPOSED) ? DDS_IST_NOT_ALIVE_DISPOSED : (f & LATEST_NOWRITERS) ? DDS_IST_NOT_ALIVE_NO_WRITERS : DDS_IST_ALIVE;
+  si->instance_handle = rhc->tk->m_iid;
+  si->publication_handle = info->inst_wr_iid;
+  si->disposed_generation_count = info->inst_disposed_gen;
+  si->no_writers_generation_count = info->inst_no_writers_gen;
+  si->sample_rank = 0;
+  si->generation_rank = 0;
+  si->absolute_generation_rank = 0;
+  si->valid_data = false;
+  si->source_timestamp = info->inst_tstamp.v;
+}
+
+static void patch_generations (dds_sample_info_t *si, int32_t n)
+{
+  /* at most a valid sample followed by an invalid one */
+  if (n == 2)
+  {
+    si[0].sample_rank = 1;
+    si[0].generation_rank =
+      (si[1].disposed_generation_count + si[1].no_writers_generation_count) -
+      (si[0].disposed_generation_count + si[0].no_writers_generation_count);
+  }
+}
+
+static bool handle_matches (const struct dds_rhc_latest *rhc, uint32_t f, dds_instance_handle_t handle)
+{
+  return handle == 0 || ((f & LATEST_EXISTS) && rhc->tk->m_iid == handle);
+}
+
+static void to_sample (const struct dds_rhc_latest *rhc, bool cdr, struct ddsi_serdata *d, void **value, bool take)
+{
+  (void) rhc;
+  if (cdr)
+    *value = take ? d : ddsi_serdata_ref (d);
+  else
+  {
+    ddsi_serdata_to_sample (d, *value, NULL, NULL);
+    if (take)
+      ddsi_serdata_unref (d);
+  }
+}
+
+static void to_invsample (const struct dds_rhc_latest *rhc, bool cdr, void **value)
+{
+  if (cdr)
+    *value = ddsi_serdata_ref (rhc->tk->m_sample);
+  else
+    clean_invsample (rhc->topic, *value);
+}
+
+static int32_t take_w_qminv (struct dds_rhc_latest *rhc, bool lock, void **values, dds_sample_info_t *info_seq, int32_t max_samples, uint32_t qminv, dds_instance_handle_t handle, dds_querycond_mask_t qcmask, bool cdr)
+{
+  struct rhc_latest_info info;
+  bool take_valid, take_inv, expired;
+  uint64_t s;
+  uint32_t f;
+  int32_t n = 0;
+  assert (max_samples > 0);
+
+  for (;;)
+  {
+    take_valid = take_inv = expired = false;
+    s = ddsrt_atomic_ld64 (&rhc->state);
+    if (s & LATEST_PIN)
+    {
+      /* A read is referencing the sample and holds the lock while it does */
+      assert (lock);
+      ddsrt_mutex_lock (&rhc->store_lock);
+      ddsrt_mutex_unlock (&rhc->store_lock);
+      continue;
+    }
+    ddsrt_atomic_fence_acq ();
+    f = flags_of (s);
+    if (!handle_matches (rhc, f, handle))
+    {
+      n = DDS_RETCODE_PRECONDITION_NOT_MET;
+      goto done;
+    }
+    if (is_empty (f) || (qmask_of_inst (f) & qminv) != 0)
+      goto done;
+    info = rhc->info[version_of (s) & 1];
+    expired = (f & LATEST_VALID) && sample_expired (&info);
+    take_valid = !expired && sample_matches (f, &info, qminv, qcmask);
+    take_inv = (max_samples - take_valid > 0) && invsample_matches (rhc, f, qminv, qcmask);
+    if (!take_valid && !take_inv && !expired)
+    {
+      /* nothing to take, unless that conclusion is based on a torn copy */
+      ddsrt_atomic_fence_ldld ();
+      if (version_of (ddsrt_atomic_ld64 (&rhc->state)) == version_of (s))
+        goto done;
+      continue;
+    }
+    uint32_t fnew = f;
+    if (take_valid || expired)
+      fnew &= ~(LATEST_VALID | LATEST_VREAD);
+    if (take_inv)
+      fnew &= ~(LATEST_INV | LATEST_INVREAD);
+    if (take_valid || take_inv)
+      fnew &= ~LATEST_NEW;
+    fnew = drop_if_unused (fnew);
+    if (ddsrt_atomic_cas64 (&rhc->state, s, make_state (version_of (s), fnew)))
+      break;
+  }
+
+  /* The CAS succeeded while the copy of the info was current, so it is consistent,
+     and if LATEST_VALID was cleared, the reference to sample is ours */
+  if (take_valid)
+  {
+    set_sample_info (info_seq + n, rhc, f, &info);
+    to_sample (rhc, cdr, info.sample, values + n, true);
+    n++;
+  }
+  else if (expired)
+  {
+    ddsi_serdata_unref (info.sample);
+  }
+  if (take_inv)
+  {
+    set_sample_info_invsample (info_seq + n, rhc, f, &info);
+    to_invsample (rhc, cdr, values + n);
+    n++;
+  }
+  patch_generations (info_seq, n);
+
+done:
+  // See dds_rhc_default: read/take with lock=false are preceded by lock_samples
+  if (!lock)
+    ddsrt_mutex_unlock (&rhc->store_lock);
+  if (n > 0 || expired)
+    update_conditions (rhc);
+  return n;
+}
+
+static int32_t read_w_qminv (struct dds_rhc_latest *rhc, bool lock, void **values, dds_sample_info_t *info_seq, int32_t max_samples, uint32_t qminv, dds_instance_handle_t handle, dds_querycond_mask_t qcmask, bool cdr)
+{
+  const struct rhc_latest_info *info;
+  bool read_valid, read_inv;
+  uint64_t s;
+  uint32_t f;
+  int32_t n = 0;
+  assert (max_samples > 0);
+
+  if (lock)
+    ddsrt_mutex_lock (&rhc->store_lock);
+  for (;;)
+  {
+    /* With store_lock held the info is stable and only the flags can change */
+    s = ddsrt_atomic_ld64 (&rhc->state);
+    f = flags_of (s);
+    assert (!(f & LATEST_PIN));
+    if (!handle_matches (rhc, f, handle))
+    {
+      n = DDS_RETCODE_PRECONDITION_NOT_MET;
+      goto done;
+    }
+    if (is_empty (f) || (qmask_of_inst (f) & qminv) != 0)
+      goto done;
+    info = &rhc->info[version_of (s) & 1];
+    read_valid = sample_matches (f, info, qminv, qcmask) && !sample_expired (info);
+    read_inv = (max_samples - read_valid > 0) && invsample_matches (rhc, f, qminv, qcmask);
+    if (!read_valid && !read_inv)
+      goto done;
+    if (ddsrt_atomic_cas64 (&rhc->state, s, s | LATEST_PIN))
+      break;
+  }
+
+  if (read_valid)
+  {
+    set_sample_info (info_seq + n, rhc, f, info);
+    to_sample (rhc, cdr, info->sample, values + n, false);
+    n++;
+  }
+  if (read_inv)
+  {
+    set_sample_info_invsample (info_seq + n, rhc, f, info);
+    to_invsample (rhc, cdr, values + n);
+    n++;
+  }
+  patch_generations (info_seq, n);
+
+  {
+    /* Nobody else changes the state while it is pinned */
+    uint32_t fnew = (f | (read_valid ? LATEST_VREAD : 0) | (read_inv ? LATEST_INVREAD : 0)) & ~LATEST_NEW;
+    const int ok = ddsrt_atomic_cas64 (&rhc->state, s | LATEST_PIN, make_state (version_of (s), fnew));
+    assert (ok);
+    (void) ok;
+  }
+
+done:
+  ddsrt_mutex_unlock (&rhc->store_lock);
+  if (n > 0)
+    update_conditions (rhc);
+  return n;
+}
+
+static dds_querycond_mask_t qcmask_of_cond (const dds_readcond *cond)
+{
+  return (cond && cond->m_query.m_filter) ? cond->m_query.m_qcmask : 0;
+}
+
+static int32_t dds_rhc_latest_read (struct dds_rhc *rhc_common, bool lock, void **values, dds_sample_info_t *info_seq, uint32_t max_samples, uint32_t mask, dds_instance_handle_t handle, dds_readcond *cond)
+{
+  struct dds_rhc_latest * const rhc = (struct dds_rhc_latest *) rhc_common;
+  assert (max_samples <= INT32_MAX);
+  return read_w_qminv (rhc, lock, values, info_seq, (int32_t) max_samples, dds_rhc_qmask_from_mask_n_cond (mask, cond), handle, qcmask_of_cond (cond), false);
+}
+
+static int32_t dds_rhc_latest_take (struct dds_rhc *rhc_common, bool lock, void **values, dds_sample_info_t *info_seq, uint32_t max_samples, uint32_t mask, dds_instance_handle_t handle, dds_readcond *cond)
+{
+  struct dds_rhc_latest * const rhc = (struct dds_rhc_latest *) rhc_common;
+  assert (max_samples <= INT32_MAX);
+  return take_w_qminv (rhc, lock, values, info_seq, (int32_t) max_samples, dds_rhc_qmask_from_mask_n_cond (mask, cond), handle, qcmask_of_cond (cond), false);
+}
+
+static int32_t dds_rhc_latest_readcdr (struct dds_rhc *rhc_common, bool lock, struct ddsi_serdata **values, dds_sample_info_t *info_seq, uint32_t max_samples, uint32_t sample_states, uint32_t view_states, uint32_t instance_states, dds_instance_handle_t handle)
+{
+  struct dds_rhc_latest * const rhc = (struct dds_rhc_latest *) rhc_common;
+  DDSRT_STATIC_ASSERT (sizeof (void *) == sizeof (struct ddsi_serdata *));
+  assert (max_samples <= INT32_MAX);
+  return read_w_qminv (rhc, lock, (void **) values, info_seq, (int32_t) max_samples, dds_rhc_qmask_from_dcpsquery (sample_states, view_states, instance_states), handle, 0, true);
+}
+
+static int32_t dds_rhc_latest_takecdr (struct dds_rhc *rhc_common, bool lock, struct ddsi_serdata **values, dds_sample_info_t *info_seq, uint32_t max_samples, uint32_t sample_states, uint32_t view_states, uint32_t instance_states, dds_instance_handle_t handle)
+{
+  struct dds_rhc_latest * const rhc = (struct dds_rhc_latest *) rhc_common;
+  DDSRT_STATIC_ASSERT (sizeof (void *) == sizeof (struct ddsi_serdata *));
+  assert (max_samples <= INT32_MAX);
+  return take_w_qminv (rhc, lock, (void **) values, info_seq, (int32_t) max_samples, dds_rhc_qmask_from_dcpsquery (sample_states, view_states, instance_states), handle, 0, true);
+}
+
+static uint32_t dds_rhc_latest_lock_samples (struct dds_rhc *rhc_common)
+{
+  struct dds_rhc_latest * const rhc = (struct dds_rhc_latest *) rhc_common;
+  ddsrt_mutex_lock (&rhc->store_lock);
+  const uint32_t f = flags_of (ddsrt_atomic_ld64 (&rhc->state));
+  const uint32_t no = ((f & LATEST_VALID) ? 1u : 0u) + ((f & LATEST_INV) ? 1u : 0u);
+  if (no == 0)
+    ddsrt_mutex_unlock (&rhc->store_lock);
+  return no;
+}
+
+/*************************
+ ******   WAITSET   ******
+ *************************/
+
+static bool dds_rhc_latest_add_readcondition (struct dds_rhc *rhc_common, dds_readcond *cond)
+{
+  struct dds_rhc_latest * const rhc = (struct dds_rhc_latest *) rhc_common;
+  assert ((dds_entity_kind (&cond->m_entity) == DDS_KIND_COND_READ && cond->m_query.m_filter == 0) ||
+          (dds_entity_kind (&cond->m_entity) == DDS_KIND_COND_QUERY && cond->m_query.m_filter != 0));
+  assert (ddsrt_atomic_ld32 (&cond->m_entity.m_status.m_trigger) == 0);
+  assert (cond->m_query.m_qcmask == 0);
+
+  cond->m_qminv = dds_rhc_qmask_from_dcpsquery (cond->m_sample_states, cond->m_view_states, cond->m_instance_states);
+
+  ddsrt_mutex_lock (&rhc->store_lock);
+  ddsrt_mutex_lock (&rhc->cond_lock);
+  if (cond->m_query.m_filter != 0)
+  {
+    dds_querycond_mask_t avail_qcmask = ~(dds_querycond_mask_t)0;
+    for (dds_readcond *rc = rhc->conds; rc != NULL; rc = rc->m_next)
+      avail_qcmask &= ~rc->m_query.m_qcmask;
+    if (avail_qcmask == 0)
+    {
+      ddsrt_mutex_unlock (&rhc->cond_lock);
+      ddsrt_mutex_unlock (&rhc->store_lock);
+      return false;
+    }
+    const dds_querycond_mask_t qcmask = avail_qcmask & (~avail_qcmask + 1);
+    cond->m_query.m_qcmask = qcmask;
+    if (rhc->nqconds++ == 0)
+    {
+      assert (rhc->qcond_eval_samplebuf == NULL);
+      rhc->qcond_eval_samplebuf = ddsi_sertopic_alloc_sample (rhc->topic);
+    }
+
+    if (eval_predicate_invsample (rhc, cond->m_query.m_filter))
+      ddsrt_atomic_or32 (&rhc->inv_conds, qcmask);
+    else
+      ddsrt_atomic_and32 (&rhc->inv_conds, ~qcmask);
+
+    /* Evaluate it on the current sample, pinning it so a take can't free it, and
+       publish the result as a new version of the info */
+    uint64_t s;
+    do {
+      s = ddsrt_atomic_ld64 (&rhc->state);
+    } while ((s & LATEST_VALID) && !ddsrt_atomic_cas64 (&rhc->state, s, s | LATEST_PIN));
+    if (s & LATEST_VALID)
+    {
+      const uint32_t v = version_of (s);
+      struct rhc_latest_info * const nxt = &rhc->info[(v + 1) & 1];
+      *nxt = rhc->info[v & 1];
+      if (eval_predicate_sample (rhc, nxt->sample, cond->m_query.m_filter))
+        nxt->conds |= qcmask;
+      else
+        nxt->conds &= ~qcmask;
+      const int ok = ddsrt_atomic_cas64 (&rhc->state, s | LATEST_PIN, make_state (v + 1, flags_of (s)));
+      assert (ok);
+      (void) ok;
+    }
+  }
+
+  cond->m_next = rhc->conds;
+  rhc->conds = cond;
+  ddsrt_atomic_inc32 (&rhc->nconds);
+  ddsrt_atomic_fence ();
+
+  dds_querycond_mask_t sample_conds;
+  const uint32_t f = flags_of (load_state_and_conds (rhc, &sample_conds));
+  const uint32_t trigger = cond_trigger (cond, f, sample_conds, ddsrt_atomic_ld32 (&rhc->inv_conds));
+  if (trigger)
+  {
+    ddsrt_atomic_st32 (&cond->m_entity.m_status.m_trigger, trigger);
+    dds_entity_status_signal (&cond->m_entity, DDS_DATA_AVAILABLE_STATUS);
+  }
+  TRACE ("add_readcondition(%p, %"PRIx32", %"PRIx32", %"PRIx32") => %p qminv %"PRIx32"\n",
+    (void *) rhc, cond->m_sample_states, cond->m_view_states,
+    cond->m_instance_states, (void *) cond, cond->m_qminv);
+  ddsrt_mutex_unlock (&rhc->cond_lock);
+  ddsrt_mutex_unlock (&rhc->store_lock);
+  return true;
+}
+
+static void dds_rhc_latest_remove_readcondition (struct dds_rhc *rhc_common, dds_readcond *cond)
+{
+  struct dds_rhc_latest * const rhc = (struct dds_rhc_latest *) rhc_common;
+  dds_readcond **ptr;
+  ddsrt_mutex_lock (&rhc->store_lock);
+  ddsrt_mutex_lock (&rhc->cond_lock);
+  ptr = &rhc->conds;
+  while (*ptr != cond)
+    ptr = &(*ptr)->m_next;
+  *ptr = (*ptr)->m_next;
+  ddsrt_atomic_dec32 (&rhc->nconds);
+  if (cond->m_query.m_filter)
+  {
+    ddsrt_atomic_and32 (&rhc->inv_conds, ~cond->m_query.m_qcmask);
+    cond->m_query.m_qcmask = 0;
+    if (--rhc->nqconds == 0)
+    {
+      assert (rhc->qcond_eval_samplebuf != NULL);
+      ddsi_sertopic_free_sample (rhc->topic, rhc->qcond_eval_samplebuf, DDS_FREE_ALL);
+      rhc->qcond_eval_samplebuf = NULL;
+    }
+  }
+  ddsrt_mutex_unlock (&rhc->cond_lock);
+  ddsrt_mutex_unlock (&rhc->store_lock);
+}
+
+static dds_return_t dds_rhc_latest_associate (struct dds_rhc *rhc, dds_reader *reader, const struct ddsi_sertopic *topic, struct ddsi_tkmap *tkmap)
+{
+  (void) rhc; (void) reader; (void) topic; (void) tkmap;
+  return DDS_RETCODE_OK;
+}
+
+static const struct dds_rhc_ops dds_rhc_latest_ops = {
+  .rhc_ops = {
+    .store = dds_rhc_latest_store,
+    .unregister_wr = dds_rhc_latest_unregister_wr,
+    .relinquish_ownership = dds_rhc_latest_relinquish_ownership,
+    .set_qos = dds_rhc_latest_set_qos,
+    .free = dds_rhc_latest_free
+  },
+  .read = dds_rhc_latest_read,
+  .take = dds_rhc_latest_take,
+  .readcdr = dds_rhc_latest_readcdr,
+  .takecdr = dds_rhc_latest_takecdr,
+  .add_readcondition = dds_rhc_latest_add_readcondition,
+  .remove_readcondition = dds_rhc_latest_remove_readcondition,
+  .lock_samples = dds_rhc_latest_lock_samples,
+  .associate = dds_rhc_latest_associate
+};
+
+static bool length_allows_one (int32_t limit)
+{
+  return limit == DDS_LENGTH_UNLIMITED || limit >= 1;
+}
+
+bool dds_rhc_latest_supported (const struct dds_reader *reader, const struct ddsi_sertopic *topic)
+{
+#if DDSRT_HAVE_ATOMIC64
+  const dds_qos_t *qos = reader->m_entity.m_qos;
+  const struct ddsi_domaingv *gv = &reader->m_entity.m_domain->gv;
+  if (!topic->topickind_no_key || (gv->config.enabled_xchecks & DDS_XCHECK_RHC))
+    return false;
+  if (qos->history.kind != DDS_HISTORY_KEEP_LAST || qos->history.depth != 1)
+    return false;
+  if (qos->ownership.kind != DDS_OWNERSHIP_SHARED || qos->destination_order.kind != DDS_DESTINATIONORDER_BY_RECEPTION_TIMESTAMP)
+    return false;
+  if (!length_allows_one (qos->resource_limits.max_samples) ||
+      !length_allows_one (qos->resource_limits.max_instances) ||
+      !length_allows_one (qos->resource_limits.max_samples_per_instance))
+    return false;
+#ifdef DDSI_INCLUDE_DEADLINE_MISSED
+  if (qos->deadline.deadline != DDS_INFINITY)
+    return false;
+#endif
+  return true;
+#else
+  (void) reader; (void) topic;
+  return false;
+#endif
+}
+
+struct dds_rhc *dds_rhc_latest_new (dds_reader *reader, const struct ddsi_sertopic *topic)
+{
+  struct dds_rhc_latest *rhc = ddsrt_malloc (sizeof (*rhc));
+  memset (rhc, 0, sizeof (*rhc));
+  rhc->common.common.ops = &dds_rhc_latest_ops;
+  ddsrt_atomic_st64 (&rhc->state, make_state (0, 0));
+  ddsrt_mutex_init (&rhc->store_lock);
+  ddsrt_mutex_init (&rhc->cond_lock);
+  rhc->registrations = ddsrt_hh_new (1, reg_hash, reg_eq);
+  ddsrt_atomic_st32 (&rhc->nconds, 0);
+  ddsrt_atomic_st32 (&rhc->inv_conds, 0);
+  rhc->topic = topic;
+  rhc->reader = reader;
+  rhc->gv = &reader->m_entity.m_domain->gv;
+  rhc->tkmap = rhc->gv->m_tkmap;
+  return &rhc->common;
+}
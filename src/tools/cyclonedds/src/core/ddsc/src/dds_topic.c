@@ -426,10 +426,13 @@ dds_entity_t dds_create_topic (dds_entity_t participant, const dds_topic_descrip
   st->type.m_ops = ddsrt_memdup (desc->m_ops, st->type.m_nops * sizeof (*st->type.m_ops));
 
   /* Check if topic cannot be optimised (memcpy marshal) */
-  if (!(st->type.m_flagset & DDS_TOPIC_NO_OPTIMIZE)) {
+  if (!(st->type.m_flagset & DDS_TOPIC_NO_OPTIMIZE))
     st->opt_size = dds_stream_check_optimize (&st->type);
-    DDS_CTRACE (&ppent->m_domain->gv.logconfig, "Marshalling for type: %s is %soptimised\n", desc->m_typename, st->opt_size ? "" : "not ");
-  }
+  /* Otherwise, fuse runs of primitives in the marshalling meta data */
+  if (st->opt_size == 0)
+    st->opt_ops = dds_stream_fuse_ops (&st->type);
+  DDS_CTRACE (&ppent->m_domain->gv.logconfig, "Marshalling for type: %s is %s\n", desc->m_typename,
+              st->opt_size ? "optimised" : st->opt_ops ? "partially optimised" : "not optimised");
 
   ddsi_plist_init_empty (&plist);
   /* Set Topic meta data (for SEDP publication) */
@@ -513,6 +516,18 @@ dds_return_t dds_set_topic_filter_and_arg (dds_entity_t topic, dds_topic_filter_
   return DDS_RETCODE_OK;
 }
 
+dds_return_t dds_set_topic_serdata_filter (dds_entity_t topic, dds_topic_serdata_filter_fn filter, void *arg)
+{
+  dds_topic *t;
+  dds_return_t rc;
+  if ((rc = dds_topic_lock (topic, &t)) != DDS_RETCODE_OK)
+    return rc;
+  t->serdata_filter_fn = filter;
+  t->serdata_filter_ctx = arg;
+  dds_topic_unlock (t);
+  return DDS_RETCODE_OK;
+}
+
 static bool topic_filter_no_arg_wrapper (const void *sample, void *arg)
 {
   dds_topic_filter_fn f = (dds_topic_filter_fn) arg;
@@ -29,15 +29,12 @@
 #include "dds/ddsi/q_config.h"
 #include "dds/ddsi/ddsi_tkmap.h"
 #include "dds/ddsi/q_rtps.h"
-#include "dds/ddsi/q_freelist.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 #include "dds/ddsi/q_entity.h"
 #include "dds__whc.h"
 #include "dds__entity.h"
 #include "dds__writer.h"
 
-#define USE_EHH 0
-
 
 struct whc_node {
   struct whc_node *next_seq; /* next in this interval */
@@ -58,6 +55,27 @@ struct whc_node {
   struct ddsi_serdata *serdata;
 };
 
+/* Nodes are allocated in chunks of WHC_CHUNK_SIZE consecutive sequence numbers, the
+   node for S at S % WHC_CHUNK_SIZE in the chunk starting at S - S % WHC_CHUNK_SIZE.
+   Sequence numbers only increase, so a writer allocates a chunk and adds it to the
+   hash table once every WHC_CHUNK_SIZE samples instead of for every sample, and
+   dropping acknowledged samples clears bits rather than removing them one by one.
+
+   A chunk is freed once none of its nodes are in the WHC or waiting on a deferred
+   free list.  One empty chunk is kept for reuse, so there are no allocations at all
+   while the readers keep up. */
+#define WHC_CHUNK_BITS 5
+#define WHC_CHUNK_SIZE (1u << WHC_CHUNK_BITS)
+
+struct whc_chunk {
+  seqno_t base; /* first sequence number, must be first for lookups */
+  uint32_t present; /* bit i set iff nodes[i] is in the WHC */
+  uint32_t live; /* number of nodes in the WHC or on a deferred free list */
+  struct whc_node nodes[WHC_CHUNK_SIZE];
+};
+
+DDSRT_STATIC_ASSERT (WHC_CHUNK_SIZE <= 32);
+
 struct whc_intvnode {
   ddsrt_avl_node_t avlnode;
   seqno_t min;
@@ -77,13 +95,6 @@ struct whc_idxnode {
   struct whc_node *hist[];
 };
 
-#if USE_EHH
-struct whc_seq_entry {
-  seqno_t seq;
-  struct whc_node *whcn;
-};
-#endif
-
 struct whc_writer_info {
   dds_writer * writer; /* can be NULL, eg in case of whc for built-in writers */
   unsigned is_transient_local: 1;
@@ -108,11 +119,9 @@ struct whc_impl {
   seqno_t max_drop_seq; /* samples in whc with seq <= max_drop_seq => transient-local */
   struct whc_intvnode *open_intv; /* interval where next sample will go (usually) */
   struct whc_node *maxseq_node; /* NULL if empty; if not in open_intv, open_intv is empty */
-#if USE_EHH
-  struct ddsrt_ehh *seq_hash;
-#else
-  struct ddsrt_hh *seq_hash;
-#endif
+  struct ddsrt_hh *chunk_hash;
+  struct whc_chunk *last_chunk; /* chunk of maxseq_node, unless freed already */
+  struct whc_chunk *spare_chunk; /* empty one for reuse, or NULL */
   struct ddsrt_hh *idx_hash;
   ddsrt_avl_tree_t seq;
 #ifdef DDSI_INCLUDE_LIFESPAN
@@ -144,10 +153,9 @@ DDSRT_STATIC_ASSERT (sizeof (struct whc_sample_iter_impl) <= sizeof (struct whc_
  */
 
 static struct whc_node *whc_findseq (const struct whc_impl *whc, seqno_t seq);
-static void insert_whcn_in_hash (struct whc_impl *whc, struct whc_node *whcn);
 static void whc_delete_one (struct whc_impl *whc, struct whc_node *whcn);
 static int compare_seq (const void *va, const void *vb);
-static void free_deferred_free_list (struct whc_node *deferred_free_list);
+static void free_deferred_free_list (struct whc_impl *whc, struct whc_node *deferred_free_list, bool locked);
 static void get_state_locked (const struct whc_impl *whc, struct whc_state *st);
 
 static uint32_t whc_default_remove_acked_messages_full (struct whc_impl *whc, seqno_t max_drop_seq, struct whc_node **deferred_free_list);
@@ -184,52 +192,23 @@ static const struct whc_ops whc_ops = {
 
 #define TRACE(...) DDS_CLOG (DDS_LC_WHC, &whc->gv->logconfig, __VA_ARGS__)
 
-/* Number of instantiated WHCs and a global freelist for WHC nodes that gets
- initialized lazily and cleaned up automatically when the last WHC is freed.
- Protected by dds_global.m_mutex.
-
- sizeof (whc_node) on 64-bit machines ~ 100 bytes, so this is ~1MB
- 8k entries seems to be roughly the amount needed for minimum samples,
- maximum message size and a short round-trip time */
-#define MAX_FREELIST_SIZE 8192
-static uint32_t whc_count;
-static struct nn_freelist whc_node_freelist;
-
-#if USE_EHH
-static uint32_t whc_seq_entry_hash (const void *vn)
-{
-  const struct whc_seq_entry *n = vn;
-  /* we hash the lower 32 bits, on the assumption that with 4 billion
-   samples in between there won't be significant correlation */
-  const uint64_t c = UINT64_C (16292676669999574021);
-  const uint32_t x = (uint32_t) n->seq;
-  return (uint32_t) ((x * c) >> 32);
-}
-
-static int whc_seq_entry_eq (const void *va, const void *vb)
+static uint32_t whc_chunk_hash (const void *vn)
 {
-  const struct whc_seq_entry *a = va;
-  const struct whc_seq_entry *b = vb;
-  return a->seq == b->seq;
-}
-#else
-static uint32_t whc_node_hash (const void *vn)
-{
-  const struct whc_node *n = vn;
-  /* we hash the lower 32 bits, on the assumption that with 4 billion
-   samples in between there won't be significant correlation */
+  /* key is base, the first field */
+  const seqno_t *base = vn;
+  /* we hash the lower 32 bits of the chunk number, on the assumption that
+   with 4 billion chunks in between there won't be significant correlation */
   const uint64_t c = UINT64_C (16292676669999574021);
-  const uint32_t x = (uint32_t) n->seq;
+  const uint32_t x = (uint32_t) (*base >> WHC_CHUNK_BITS);
   return (uint32_t) ((x * c) >> 32);
 }
 
-static int whc_node_eq (const void *va, const void *vb)
+static int whc_chunk_eq (const void *va, const void *vb)
 {
-  const struct whc_node *a = va;
-  const struct whc_node *b = vb;
-  return a->seq == b->seq;
+  const seqno_t *a = va;
+  const seqno_t *b = vb;
+  return *a == *b;
 }
-#endif
 
 static uint32_t whc_idxnode_hash_key (const void *vn)
 {
@@ -315,45 +294,113 @@ static void check_whc (const struct whc_impl *whc)
 #endif
 }
 
-static void insert_whcn_in_hash (struct whc_impl *whc, struct whc_node *whcn)
+static seqno_t chunk_base (seqno_t seq)
 {
-  /* precondition: whcn is not in hash */
-#if USE_EHH
-  struct whc_seq_entry e = { .seq = whcn->seq, .whcn = whcn };
-  if (!ddsrt_ehh_add (whc->seq_hash, &e))
-    assert (0);
-#else
-  if (!ddsrt_hh_add (whc->seq_hash, whcn))
-    assert (0);
-#endif
+  return seq & ~(seqno_t) (WHC_CHUNK_SIZE - 1);
 }
 
-static void remove_whcn_from_hash (struct whc_impl *whc, struct whc_node *whcn)
+static uint32_t chunk_index (seqno_t seq)
 {
-  /* precondition: whcn is in hash */
-#if USE_EHH
-  struct whc_seq_entry e = { .seq = whcn->seq };
-  if (!ddsrt_ehh_remove (whc->seq_hash, &e))
-    assert (0);
-#else
-  if (!ddsrt_hh_remove (whc->seq_hash, whcn))
-    assert (0);
-#endif
+  return (uint32_t) seq & (WHC_CHUNK_SIZE - 1);
+}
+
+static struct whc_chunk *chunk_of_node (struct whc_node *whcn)
+{
+  return (struct whc_chunk *) ((char *) (whcn - chunk_index (whcn->seq)) - offsetof (struct whc_chunk, nodes));
+}
+
+static struct whc_chunk *whc_findchunk (const struct whc_impl *whc, seqno_t base)
+{
+  if (whc->last_chunk && whc->last_chunk->base == base)
+    return whc->last_chunk;
+  return ddsrt_hh_lookup (whc->chunk_hash, &base);
+}
+
+static struct whc_node *whc_alloc_node (struct whc_impl *whc, seqno_t seq)
+{
+  /* precondition: seq > any sequence number in whc */
+  const seqno_t base = chunk_base (seq);
+  const uint32_t idx = chunk_index (seq);
+  struct whc_chunk *c = whc->last_chunk;
+  if (c == NULL || c->base != base)
+  {
+    /* either a new range, or the chunk has been emptied and freed already */
+    assert (ddsrt_hh_lookup (whc->chunk_hash, &base) == NULL);
+    if ((c = whc->spare_chunk) != NULL)
+      whc->spare_chunk = NULL;
+    else
+      c = ddsrt_malloc (sizeof (*c));
+    c->base = base;
+    c->present = 0;
+    c->live = 0;
+    if (!ddsrt_hh_add (whc->chunk_hash, c))
+      assert (0);
+    whc->last_chunk = c;
+  }
+  assert (!(c->present & (1u << idx)));
+  c->present |= 1u << idx;
+  c->live++;
+  return &c->nodes[idx];
+}
+
+static void remove_whcn_from_chunk (struct whc_impl *whc, struct whc_node *whcn)
+{
+  /* precondition: whcn is in whc; the node itself remains allocated until released */
+  struct whc_chunk * const c = chunk_of_node (whcn);
+  (void) whc;
+  assert (c->present & (1u << chunk_index (whcn->seq)));
+  c->present &= ~(1u << chunk_index (whcn->seq));
+}
+
+static void remove_range_from_chunks (struct whc_impl *whc, seqno_t min, seqno_t max)
+{
+  /* precondition: all of [min,max] is in whc */
+  for (seqno_t base = chunk_base (min); base <= max; base += WHC_CHUNK_SIZE)
+  {
+    struct whc_chunk * const c = whc_findchunk (whc, base);
+    const uint32_t lo = (min > base) ? chunk_index (min) : 0;
+    const uint32_t hi = (max - base >= WHC_CHUNK_SIZE - 1) ? WHC_CHUNK_SIZE - 1 : chunk_index (max);
+    const uint32_t mask = ((hi == 31) ? UINT32_MAX : ((1u << (hi + 1)) - 1)) & ~((1u << lo) - 1);
+    assert (c != NULL);
+    assert ((c->present & mask) == mask);
+    c->present &= ~mask;
+  }
+}
+
+static void release_whc_nodes (struct whc_impl *whc, struct whc_node *list)
+{
+  /* precondition: whc locked, nodes in list no longer in whc & contents freed */
+  while (list)
+  {
+    struct whc_chunk * const c = chunk_of_node (list);
+    uint32_t n = 0;
+    /* lists nearly always consist of runs of consecutive sequence numbers */
+    do {
+      n++;
+      list = list->next_seq;
+    } while (list && chunk_of_node (list) == c);
+    assert (c->live >= n);
+    if ((c->live -= n) == 0)
+    {
+      assert (c->present == 0);
+      if (!ddsrt_hh_remove (whc->chunk_hash, c))
+        assert (0);
+      if (c == whc->last_chunk)
+        whc->last_chunk = NULL;
+      if (whc->spare_chunk == NULL)
+        whc->spare_chunk = c;
+      else
+        ddsrt_free (c);
+    }
+  }
 }
 
 static struct whc_node *whc_findseq (const struct whc_impl *whc, seqno_t seq)
 {
-#if USE_EHH
-  struct whc_seq_entry e = { .seq = seq }, *r;
-  if ((r = ddsrt_ehh_lookup (whc->seq_hash, &e)) != NULL)
-    return r->whcn;
-  else
+  const struct whc_chunk *c = whc_findchunk (whc, chunk_base (seq));
+  if (c == NULL || !(c->present & (1u << chunk_index (seq))))
     return NULL;
-#else
-  struct whc_node template;
-  template.seq = seq;
-  return ddsrt_hh_lookup (whc->seq_hash, &template);
-#endif
+  return (struct whc_node *) &c->nodes[chunk_index (seq)];
 }
 
 static struct whc_node *whc_findkey (const struct whc_impl *whc, const struct ddsi_serdata *serdata_key)
@@ -464,11 +511,9 @@ struct whc *whc_new (struct ddsi_domaingv *gv, const struct whc_writer_info *wri
   whc->sample_overhead = sample_overhead;
   whc->fragment_size = gv->config.fragment_size;
   whc->idx_hash = ddsrt_hh_new (1, whc_idxnode_hash_key, whc_idxnode_eq_key);
-#if USE_EHH
-  whc->seq_hash = ddsrt_ehh_new (sizeof (struct whc_seq_entry), 32, whc_seq_entry_hash, whc_seq_entry_eq);
-#else
-  whc->seq_hash = ddsrt_hh_new (1, whc_node_hash, whc_node_eq);
-#endif
+  whc->chunk_hash = ddsrt_hh_new (1, whc_chunk_hash, whc_chunk_eq);
+  whc->last_chunk = NULL;
+  whc->spare_chunk = NULL;
 
 #ifdef DDSI_INCLUDE_LIFESPAN
   lifespan_init (gv, &whc->lifespan, offsetof(struct whc_impl, lifespan), offsetof(struct whc_node, lifespan), whc_sample_expired_cb);
@@ -488,11 +533,6 @@ struct whc *whc_new (struct ddsi_domaingv *gv, const struct whc_writer_info *wri
   whc->open_intv = intv;
   whc->maxseq_node = NULL;
 
-  ddsrt_mutex_lock (&dds_global.m_mutex);
-  if (whc_count++ == 0)
-    nn_freelist_init (&whc_node_freelist, MAX_FREELIST_SIZE, offsetof (struct whc_node, next_seq));
-  ddsrt_mutex_unlock (&dds_global.m_mutex);
-
   check_whc (whc);
   return (struct whc *)whc;
 }
@@ -541,22 +581,19 @@ void whc_default_free (struct whc *whc_generic)
       whcn = whcn->prev_seq;
       DDSRT_WARNING_MSVC_ON (6001);
       free_whc_node_contents (tmp);
-      ddsrt_free (tmp);
     }
   }
 
   ddsrt_avl_free (&whc_seq_treedef, &whc->seq, ddsrt_free);
 
-  ddsrt_mutex_lock (&dds_global.m_mutex);
-  if (--whc_count == 0)
-    nn_freelist_fini (&whc_node_freelist, ddsrt_free);
-  ddsrt_mutex_unlock (&dds_global.m_mutex);
-
-#if USE_EHH
-  ddsrt_ehh_free (whc->seq_hash);
-#else
-  ddsrt_hh_free (whc->seq_hash);
-#endif
+  {
+    struct ddsrt_hh_iter it;
+    struct whc_chunk *c;
+    for (c = ddsrt_hh_iter_first (whc->chunk_hash, &it); c != NULL; c = ddsrt_hh_iter_next (&it))
+      ddsrt_free (c);
+    ddsrt_hh_free (whc->chunk_hash);
+    ddsrt_free (whc->spare_chunk);
+  }
   ddsrt_mutex_destroy (&whc->lock);
   ddsrt_free (whc);
 }
@@ -748,7 +785,7 @@ static uint32_t whc_default_downgrade_to_volatile (struct whc *whc_generic, stru
   old_max_drop_seq = whc->max_drop_seq;
   whc->max_drop_seq = 0;
   cnt = whc_default_remove_acked_messages_full (whc, old_max_drop_seq, &deferred_free_list);
-  whc_default_free_deferred_free_list (whc_generic, deferred_free_list);
+  free_deferred_free_list (whc, deferred_free_list, true);
   assert (whc->max_drop_seq == old_max_drop_seq);
   get_state_locked (whc, st);
   ddsrt_mutex_unlock (&whc->lock);
@@ -791,10 +828,10 @@ static void whc_delete_one_intv (struct whc_impl *whc, struct whc_intvnode **p_i
   lifespan_unregister_sample_locked (&whc->lifespan, &whcn->lifespan);
 #endif
 
-  /* Take it out of seqhash; deleting it from the list ordered on
+  /* Take it out of its chunk; deleting it from the list ordered on
    sequence numbers is left to the caller (it has to be done unconditionally,
    but remove_acked_messages defers it until the end or a skipped node). */
-  remove_whcn_from_hash (whc, whcn);
+  remove_whcn_from_chunk (whc, whcn);
 
   /* We may have introduced a hole & have to split the interval
    node, or we may have nibbled of the first one, or even the
@@ -876,36 +913,32 @@ static void whc_delete_one (struct whc_impl *whc, struct whc_node *whcn)
   if (whcn_tmp->next_seq)
     whcn_tmp->next_seq->prev_seq = whcn_tmp->prev_seq;
   whcn_tmp->next_seq = NULL;
-  free_deferred_free_list (whcn_tmp);
+  free_deferred_free_list (whc, whcn_tmp, true);
   whc->seq_size--;
 }
 
-static void free_deferred_free_list (struct whc_node *deferred_free_list)
+static void free_deferred_free_list (struct whc_impl *whc, struct whc_node *deferred_free_list, bool locked)
 {
   if (deferred_free_list)
   {
-    struct whc_node *cur, *last;
-    uint32_t n = 0;
-    for (cur = deferred_free_list, last = NULL; cur; last = cur, cur = cur->next_seq)
+    /* freeing the contents is what's expensive, so only that is done without holding the lock */
+    for (struct whc_node *cur = deferred_free_list; cur; cur = cur->next_seq)
     {
-      n++;
       if (!cur->borrowed)
         free_whc_node_contents (cur);
     }
-    cur = nn_freelist_pushmany (&whc_node_freelist, deferred_free_list, last, n);
-    while (cur)
-    {
-      struct whc_node *tmp = cur;
-      cur = cur->next_seq;
-      ddsrt_free (tmp);
-    }
+    if (!locked)
+      ddsrt_mutex_lock (&whc->lock);
+    release_whc_nodes (whc, deferred_free_list);
+    if (!locked)
+      ddsrt_mutex_unlock (&whc->lock);
   }
 }
 
 static void whc_default_free_deferred_free_list (struct whc *whc_generic, struct whc_node *deferred_free_list)
 {
-  (void) whc_generic;
-  free_deferred_free_list (deferred_free_list);
+  struct whc_impl * const whc = (struct whc_impl *)whc_generic;
+  free_deferred_free_list (whc, deferred_free_list, false);
 }
 
 static uint32_t whc_default_remove_acked_messages_noidx (struct whc_impl *whc, seqno_t max_drop_seq, struct whc_node **deferred_free_list)
@@ -972,14 +1005,16 @@ static uint32_t whc_default_remove_acked_messages_noidx (struct whc_impl *whc, s
 
   assert (whcn->total_bytes - (*deferred_free_list)->total_bytes + (*deferred_free_list)->size <= whc->unacked_bytes);
   whc->unacked_bytes -= (size_t) (whcn->total_bytes - (*deferred_free_list)->total_bytes + (*deferred_free_list)->size);
+  remove_range_from_chunks (whc, (*deferred_free_list)->seq, whcn->seq);
+#if defined DDSI_INCLUDE_LIFESPAN || !defined NDEBUG
   for (whcn = *deferred_free_list; whcn; whcn = whcn->next_seq)
   {
 #ifdef DDSI_INCLUDE_LIFESPAN
     lifespan_unregister_sample_locked (&whc->lifespan, &whcn->lifespan);
 #endif
-    remove_whcn_from_hash (whc, whcn);
     assert (whcn->unacked);
   }
+#endif
 
   assert (ndropped <= whc->seq_size);
   whc->seq_size -= ndropped;
@@ -1167,8 +1202,7 @@ static struct whc_node *whc_default_insert_seq (struct whc_impl *whc, seqno_t ma
   DDSRT_UNUSED_ARG (exp);
 #endif
 
-  if ((newn = nn_freelist_pop (&whc_node_freelist)) == NULL)
-    newn = ddsrt_malloc (sizeof (*newn));
+  newn = whc_alloc_node (whc, seq);
   newn->seq = seq;
   newn->plist = plist;
   newn->unacked = (seq > max_drop_seq);
@@ -1194,8 +1228,6 @@ static struct whc_node *whc_default_insert_seq (struct whc_impl *whc, seqno_t ma
   newn->lifespan.t_expire = exp;
 #endif
 
-  insert_whcn_in_hash (whc, newn);
-
   if (whc->open_intv->first == NULL)
   {
     /* open_intv is empty => reset open_intv */
@@ -93,8 +93,9 @@ struct local_sourceinfo {
   ddsrt_mtime_t timeout;
 };
 
-static struct ddsi_serdata *local_make_sample (struct ddsi_tkmap_instance **tk, struct ddsi_domaingv *gv, struct ddsi_sertopic const * const topic, void *vsourceinfo)
+static struct ddsi_serdata *local_make_sample (struct ddsi_tkmap_instance **tk, struct ddsi_domaingv *gv, struct reader *rd, void *vsourceinfo)
 {
+  struct ddsi_sertopic const * const topic = rd->topic;
   struct local_sourceinfo *si = vsourceinfo;
   struct ddsi_serdata *d = ddsi_serdata_ref_as_topic (topic, si->src_payload);
   if (d == NULL)
@@ -103,7 +104,7 @@ static struct ddsi_serdata *local_make_sample (struct ddsi_tkmap_instance **tk,
     return NULL;
   }
   if (topic != si->src_topic)
-    *tk = ddsi_tkmap_lookup_instance_ref (gv->m_tkmap, d);
+    *tk = ddsi_tkmap_lookup_instance_ref_cached (gv->m_tkmap, &rd->keyless_tk, d);
   else
   {
     // if the topic is the same, we can avoid the lookup
@@ -181,7 +182,7 @@ dds_return_t dds_write_impl (dds_writer *wr, const void * data, dds_time_t tstam
                    ((action & DDS_WR_UNREGISTER_BIT) ? NN_STATUSINFO_UNREGISTER : 0));
   d->timestamp.v = tstamp;
   ddsi_serdata_ref (d);
-  tk = ddsi_tkmap_lookup_instance_ref (wr->m_entity.m_domain->gv.m_tkmap, d);
+  tk = ddsi_tkmap_lookup_instance_ref_cached (wr->m_entity.m_domain->gv.m_tkmap, &ddsi_wr->keyless_tk, d);
   w_rc = write_sample_gc (ts1, wr->m_xp, ddsi_wr, d, tk);
 
   if (w_rc >= 0) {
@@ -213,7 +214,7 @@ dds_return_t dds_writecdr_impl_lowlevel (struct writer *ddsi_wr, struct nn_xpack
 
   thread_state_awake (ts1, ddsi_wr->e.gv);
   ddsi_serdata_ref (d);
-  tk = ddsi_tkmap_lookup_instance_ref (ddsi_wr->e.gv->m_tkmap, d);
+  tk = ddsi_tkmap_lookup_instance_ref_cached (ddsi_wr->e.gv->m_tkmap, &ddsi_wr->keyless_tk, d);
   w_rc = write_sample_gc (ts1, xp, ddsi_wr, d, tk);
   if (w_rc >= 0) {
     /* Flush out write unless configured to batch */
@@ -31,6 +31,7 @@
 #include "dds/ddsi/ddsi_tkmap.h"
 #include "dds__whc.h"
 #include "dds__statistics.h"
+#include "dds__listener_dispatch.h"
 #include "dds/ddsi/ddsi_statistics.h"
 
 DECL_ENTITY_LOCK_UNLOCK (extern inline, dds_writer)
@@ -130,7 +131,8 @@ void dds_writer_status_cb (void *entity, const struct status_cb_data *data)
 
   /* FIXME: why wait if no listener is set? */
   ddsrt_mutex_lock (&wr->m_entity.m_observers_lock);
-  while (wr->m_entity.m_cb_count > 0)
+  /* (asynchronously dispatched listeners get a copy of the status) */
+  while (wr->m_entity.m_cb_count > 0 && !dds_listener_dispatch_async (&wr->m_entity))
     ddsrt_cond_wait (&wr->m_entity.m_observers_cond, &wr->m_entity.m_observers_lock);
 
   const enum dds_status_id status_id = (enum dds_status_id) data->raw_status_id;
@@ -254,7 +256,13 @@ static const struct dds_stat_keyvalue_descriptor dds_writer_statistics_kv[] = {
   { "rexmit_bytes", DDS_STAT_KIND_UINT64 },
   { "throttle_count", DDS_STAT_KIND_UINT32 },
   { "time_throttle", DDS_STAT_KIND_UINT64 },
-  { "time_rexmit", DDS_STAT_KIND_UINT64 }
+  { "time_rexmit", DDS_STAT_KIND_UINT64 },
+  { "write_samples", DDS_STAT_KIND_UINT64 },
+  { "write_bytes", DDS_STAT_KIND_UINT64 },
+  { "rexmit_count", DDS_STAT_KIND_UINT32 },
+  { "nacks_received", DDS_STAT_KIND_UINT32 },
+  { "whc_unacked_bytes", DDS_STAT_KIND_UINT64 },
+  DDS_LISTENER_DISPATCH_STATISTICS_KV
 };
 
 static const struct dds_stat_descriptor dds_writer_statistics_desc = {
@@ -271,7 +279,11 @@ static void dds_writer_refresh_statistics (const struct dds_entity *entity, stru
 {
   const struct dds_writer *wr = (const struct dds_writer *) entity;
   if (wr->m_wr)
+  {
     ddsi_get_writer_stats (wr->m_wr, &stat->kv[0].u.u64, &stat->kv[1].u.u32, &stat->kv[2].u.u64, &stat->kv[3].u.u64);
+    ddsi_get_writer_traffic_stats (wr->m_wr, &stat->kv[4].u.u64, &stat->kv[5].u.u64, &stat->kv[6].u.u32, &stat->kv[7].u.u32, &stat->kv[8].u.u64);
+  }
+  dds_listener_dispatch_get_stats (entity, stat, 9);
 }
 
 const struct dds_entity_deriver dds_entity_deriver_writer = {
@@ -28,6 +28,7 @@
 #include <stdlib.h>
 
 #include "dds/dds.h"
+#include "dds/ddsi/ddsi_serdata.h"
 #include "dds/ddsrt/misc.h"
 #include "dds/ddsrt/attributes.h"
 
@@ -329,6 +330,58 @@ CU_Test (ddsc_filter, compat)
   dds_delete (dp);
 }
 
+static bool serdata_filter_long1_eq (const struct ddsi_serdata *serdata, void *arg)
+{
+  // long_1 is the first member, right after the 4-byte encoding header, in the writer's
+  // byte order, which is the native one here
+  int32_t long_1;
+  ddsi_serdata_to_ser (serdata, 4, sizeof (long_1), &long_1);
+  return (uintptr_t) long_1 == (uintptr_t) arg;
+}
+
+CU_Test (ddsc_filter, serdata)
+{
+  dds_entity_t dp, tp, rd, wr;
+  dds_return_t ret;
+  char topicname[100];
+  create_unique_topic_name ("ddsc_filter", topicname, sizeof (topicname));
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  dp = dds_create_participant (0, NULL, NULL);
+  CU_ASSERT_FATAL (dp > 0);
+  tp = dds_create_topic (dp, &Space_Type1_desc, topicname, qos, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  // both filters must accept a sample for it to be stored
+  ret = dds_set_topic_serdata_filter (tp, serdata_filter_long1_eq, (void *) 1);
+  CU_ASSERT_FATAL (ret == 0);
+  ret = dds_set_topic_filter_and_arg (tp, filter_long2_eq, (void *) 2);
+  CU_ASSERT_FATAL (ret == 0);
+  rd = dds_create_reader (dp, tp, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  wr = dds_create_writer (dp, tp, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+
+  ret = dds_write (wr, &(Space_Type1){0,2,0});
+  CU_ASSERT_FATAL (ret == 0);
+  ret = dds_write (wr, &(Space_Type1){1,0,0});
+  CU_ASSERT_FATAL (ret == 0);
+  ret = dds_write (wr, &(Space_Type1){1,2,3});
+  CU_ASSERT_FATAL (ret == 0);
+
+  struct exp exp = {
+    .n = 1, .xs = (const Space_Type1[]) {
+      {1,2,3}
+    },
+  };
+  checkdata (rd, &exp, "rd");
+
+  ret = dds_set_topic_serdata_filter (rd, serdata_filter_long1_eq, NULL);
+  CU_ASSERT_FATAL (ret == DDS_RETCODE_ILLEGAL_OPERATION);
+  dds_delete (dp);
+}
+
 CU_Test (ddsc_filter, get)
 {
   dds_entity_t dp, tp;
@@ -48,6 +48,7 @@ void dds_stream_free_sample (void *data, const uint32_t * ops);
 
 uint32_t dds_stream_countops (const uint32_t * __restrict ops);
 size_t dds_stream_check_optimize (const struct ddsi_sertopic_default_desc * __restrict desc);
+uint32_t *dds_stream_fuse_ops (const struct ddsi_sertopic_default_desc * __restrict desc);
 void dds_istream_from_serdata_default (dds_istream_t * __restrict s, const struct ddsi_serdata_default * __restrict d);
 void dds_ostream_from_serdata_default (dds_ostream_t * __restrict s, struct ddsi_serdata_default * __restrict d);
 void dds_ostream_add_to_serdata_default (dds_ostream_t * __restrict s, struct ddsi_serdata_default ** __restrict d);
@@ -83,6 +84,8 @@ size_t dds_stream_print_sample (dds_istream_t * __restrict is, const struct ddsi
 #define DDS_OP_JUMP(o)    ((int16_t) ((o) & DDS_OP_JMP_MASK))
 #define DDS_OP_ADR_JMP(o) ((o) >> 16)
 #define DDS_JEQ_TYPE(o)   ((enum dds_stream_typecode) (((o) & DDS_JEQ_TYPE_MASK) >> 16))
+#define DDS_OP_BLK_ALIGN(o)       (((o) & DDS_OP_TYPE_MASK) >> 16)
+#define DDS_OP_BLK_FIRST_ALIGN(o) (((o) & DDS_OP_SUBTYPE_MASK) >> 8)
 
 #if defined (__cplusplus)
 }
@@ -537,6 +537,37 @@ static struct cfgelem ignoredpartitions_cfgelems[] = {
   END_MARKER
 };
 
+static struct cfgelem unicastpartitions_cfgattrs[] = {
+  STRING("DCPSPartitionTopic", NULL, 1, NULL,
+    MEMBEROF(config_unicastpartition_listelem, DCPSPartitionTopic),
+    FUNCTIONS(0, uf_string, ff_free, pf_string),
+    DESCRIPTION(
+      "<p>This attribute specifies a partition and a topic expression, "
+      "separated by a single '.', that are used to determine if the data of "
+      "a given partition and topic is to be sent using unicast only. The "
+      "expressions may use the usual wildcards '*' and '?'. Cyclone DDS will "
+      "consider a wildcard DCPS partition to match an expression if there "
+      "exists a string that satisfies both expressions.</p>"
+    )),
+  END_MARKER
+};
+
+static struct cfgelem unicastpartitions_cfgelems[] = {
+  STRING("UnicastPartition", unicastpartitions_cfgattrs, INT_MAX, 0,
+    MEMBER(unicastPartitions),
+    FUNCTIONS(if_unicast_partition, 0, 0, 0),
+    DESCRIPTION(
+      "<p>This element can be used to force writers for certain "
+      "combinations of DCPS partition and topic to send their data to the "
+      "unicast addresses of the matching readers only, even when multicast "
+      "would reach all of them with fewer packets. This is intended for "
+      "high-volume data that would otherwise also arrive at every other "
+      "node that has joined the multicast group. A writer is unicast-only "
+      "if any of its DCPS partitions matches.</p>"
+    )),
+  END_MARKER
+};
+
 static struct cfgelem partitionmappings_cfgattrs[] = {
   STRING("NetworkPartition", NULL, 1, NULL,
     MEMBEROF(config_partitionmapping_listelem, networkPartition),
@@ -589,6 +620,13 @@ static struct cfgelem partitioning_cfgelems[] = {
       "<p>The IgnoredPartitions element specifies DCPS partition/topic "
       "combinations that are not distributed over the network.</p>"
     )),
+  GROUP("UnicastPartitions", unicastpartitions_cfgelems, NULL, 1,
+    NOMEMBER,
+    NOFUNCTIONS,
+    DESCRIPTION(
+      "<p>The UnicastPartitions element specifies DCPS partition/topic "
+      "combinations for which data is never sent to a multicast address.</p>"
+    )),
   GROUP("PartitionMappings", partitionmappings_cfgelems, NULL, 1,
     NOMEMBER,
     NOFUNCTIONS,
@@ -733,6 +771,15 @@ static struct cfgelem thread_properties_cfgattrs[] = {
 };
 
 static struct cfgelem thread_properties_cfgelems[] = {
+  STRING("Affinity", NULL, 1, "default",
+    MEMBEROF(config_thread_properties_listelem, affinity),
+    FUNCTIONS(0, uf_thread_affinity, ff_free, pf_thread_affinity),
+    DESCRIPTION(
+      "<p>This element specifies the CPUs the thread may run on, as a comma-"
+      "separated list of CPU numbers and ranges of them, e.g. <i>2,3,6-7</i>. "
+      "The default value <i>default</i> leaves it to the operating system. "
+      "It is only supported on Linux and Windows.</p>"
+    )),
   GROUP("Scheduling", thread_properties_sched_cfgelems, NULL, 1,
     NOMEMBER,
     NOFUNCTIONS,
@@ -754,7 +801,15 @@ static struct cfgelem threads_cfgelems[] = {
   GROUP("Thread", thread_properties_cfgelems, thread_properties_cfgattrs, INT_MAX,
     MEMBER(thread_properties),
     FUNCTIONS(if_thread_properties, 0, 0, 0),
-    DESCRIPTION("<p>This element is used to set thread properties.</p>")),
+    DESCRIPTION(
+      "<p>This element is used to set thread properties.</p>\n"
+      "<p>The priority and the CPU affinity of a thread can also be set with "
+      "the environment variables CYCLONEDDS_THREAD_<i>NAME</i>_PRIORITY and "
+      "CYCLONEDDS_THREAD_<i>NAME</i>_AFFINITY, where <i>NAME</i> is the thread "
+      "name in upper case with all characters other than letters and digits "
+      "replaced by underscores, e.g. CYCLONEDDS_THREAD_DQ_BUILTINS_AFFINITY. "
+      "These override the configuration, and setting a priority this way "
+      "selects the realtime scheduling class.</p>")),
   END_MARKER
 };
 
@@ -889,6 +944,36 @@ static struct cfgelem internal_burstsize_cfgelems[] = {
   END_MARKER
 };
 
+static struct cfgelem internal_fragmentpacing_cfgelems[] = {
+  STRING("Bandwidth", NULL, 1, "inf",
+    MEMBER(fragment_pacing_bandwidth),
+    FUNCTIONS(0, uf_bandwidth, 0, pf_bandwidth),
+    DESCRIPTION(
+      "<p>This element specifies the rate at which each writer with a "
+      "transport priority below PriorityThreshold may transmit the fragments "
+      "of new large samples. Bursts of up to BucketSize bytes go out at "
+      "once, after that the writer waits before sending the next fragment. "
+      "Retransmits are not delayed, but do count towards the rate. The "
+      "default value \"inf\" disables pacing.</p>"),
+    UNIT("bandwidth")),
+  STRING("BucketSize", NULL, 1, "64 kB",
+    MEMBER(fragment_pacing_bucket_size),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element specifies the size of the token bucket used for "
+      "pacing fragments, that is, the amount of data a paced writer may "
+      "send in a single burst.</p>"),
+    UNIT("memsize")),
+  INT("PriorityThreshold", NULL, 1, "1",
+    MEMBER(fragment_pacing_priority_threshold),
+    FUNCTIONS(0, uf_int, 0, pf_int),
+    DESCRIPTION(
+      "<p>This element specifies the transport priority from which writers "
+      "are exempt from pacing, so that control topics with a high transport "
+      "priority can get through while bulk data is paced.</p>")),
+  END_MARKER
+};
+
 static struct cfgelem control_topic_cfgattrs[] = {
   BOOL(DEPRECATED("Enable"), NULL, 1, "false",
     MEMBER(enable_control_topic),
@@ -1023,6 +1108,18 @@ static struct cfgelem internal_cfgelems[] = {
       "<p>This element sets the maximum size in samples of a secondary "
       "re-order administration. The secondary re-order administration is per "
       "reader in need of historical data.</p>")),
+  STRING("DefragContiguousThreshold", NULL, 1, "0 B",
+    MEMBER(defrag_contiguous_threshold),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element sets the size from which fragmented samples are "
+      "reassembled in a buffer of their own rather than in the receive "
+      "buffers. The buffer is allocated when the first fragment arrives and "
+      "each fragment is copied into place as it arrives, so that large "
+      "samples don't tie up the receive buffers, and a serdata that supports "
+      "it can keep the buffer instead of copying the sample. The default of "
+      "0 disables it.</p>"),
+    UNIT("memsize")),
   INT("DefragUnreliableMaxSamples", NULL, 1, "4",
     MEMBER(defrag_unreliable_maxsamples),
     FUNCTIONS(0, uf_uint, 0, pf_uint),
@@ -1238,6 +1335,18 @@ static struct cfgelem internal_cfgelems[] = {
       "scheduled exactly, whereas a value of 10ms would mean that events are "
       "rounded up to the nearest 10 milliseconds.</p>"),
     UNIT("duration")),
+  STRING("TimerWheelTick", NULL, 1, "0 ms",
+    MEMBER(timer_wheel_tick),
+    FUNCTIONS(0, uf_duration_us_1s, 0, pf_duration),
+    DESCRIPTION(
+      "<p>This element sets the tick of the hierarchical timer wheel that "
+      "holds the scheduled events, such as heartbeats, acknowledgements and "
+      "retransmits, making scheduling and cancelling them take constant "
+      "time instead of time logarithmic in the number of pending events. "
+      "Events are then handled at the first multiple of the tick at or "
+      "after their time, i.e., up to one tick late. The default of 0 keeps "
+      "them in a heap and handles them exactly on time.</p>"),
+    UNIT("duration")),
 #ifdef DDSI_INCLUDE_BANDWIDTH_LIMITING
   STRING("AuxiliaryBandwidthLimit", NULL, 1, "inf",
     MEMBER(auxiliary_bandwidth_limit),
@@ -1394,6 +1503,19 @@ static struct cfgelem internal_cfgelems[] = {
     "transport (e.g., UDP) and ManySocketsMode not set to single (the "
     "default).</p>"),
     VALUES("false","true","default")),
+  INT("UnicastReceiveShards", NULL, 1, "1",
+    MEMBER(unicast_recv_shards),
+    FUNCTIONS(0, uf_recv_shards, 0, pf_int),
+    DESCRIPTION(
+      "<p>This element sets the number of receive threads that share the "
+      "data unicast port when multiple receive threads are used and "
+      "ManySocketsMode is set to single. Each thread has its own socket bound "
+      "to the port with SO_REUSEPORT, and the kernel hashes the packets of "
+      "each sender to one of them, so that the load of many remote writers is "
+      "spread over as many cores. Packets from one sender all go to the same "
+      "thread. This is only supported for UDP on Linux, elsewhere the value is "
+      "ignored. The maximum is 8.</p>"),
+    RANGE("1;8")),
   GROUP("ControlTopic", control_topic_cfgelems, control_topic_cfgattrs, 1,
     NOMEMBER,
     NOFUNCTIONS,
@@ -1413,6 +1535,10 @@ static struct cfgelem internal_cfgelems[] = {
     NOMEMBER,
     NOFUNCTIONS,
     DESCRIPTION("<p>Setting for controlling the size of transmit bursts.</p>")),
+  GROUP("FragmentPacing", internal_fragmentpacing_cfgelems, NULL, 1,
+    NOMEMBER,
+    NOFUNCTIONS,
+    DESCRIPTION("<p>Settings for pacing the transmission of large samples.</p>")),
   LIST("EnableExpensiveChecks", NULL, 1, "",
     MEMBER(enabled_xchecks),
     FUNCTIONS(0, uf_xcheck, 0, pf_xcheck),
@@ -1438,6 +1564,34 @@ static struct cfgelem sizing_cfgelems[] = {
       "than Sizing/ReceiveBufferChunkSize, and the value used is taken as the "
       "configured value and the actual minimum workable size.</p>"),
     UNIT("memsize")),
+  STRING("ReceiveBufferMaxSize", NULL, 1, "0 B",
+    MEMBER(rbuf_max_size),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element sets the size up to which receive buffers may grow "
+      "when they fill up quickly, i.e., when data arrives at a high rate or "
+      "in large messages. A receive buffer that fills up within 50ms is "
+      "replaced by one twice its size, one that takes more than a second by "
+      "one half its size, but never smaller than Sizing/ReceiveBufferSize. "
+      "Empty receive buffers of the current size are kept for reuse. The "
+      "default of 0 keeps the size fixed at Sizing/ReceiveBufferSize.</p>"),
+    UNIT("memsize")),
+  ENUM("ReceiveBufferHugePages", NULL, 1, "none",
+    MEMBER(rbuf_hugepages),
+    FUNCTIONS(0, uf_rbuf_hugepages, 0, pf_rbuf_hugepages),
+    DESCRIPTION(
+      "<p>This element controls whether receive buffers are backed by huge "
+      "pages, reducing TLB misses when receiving large volumes of data. "
+      "Valid values are:</p>\n"
+      "<ul><li><i>none</i>: ordinary heap allocations;</li>\n"
+      "<li><i>transparent</i>: 2MB-aligned allocations that are advised to "
+      "use transparent huge pages;</li>\n"
+      "<li><i>hugetlb</i>: explicitly reserved huge pages, falling back to "
+      "<i>transparent</i> if none are available.</li></ul>\n"
+      "<p>Sizes are rounded up to a multiple of 2MB for the latter two. Huge "
+      "pages are only supported on Linux; elsewhere a warning is given and "
+      "<i>none</i> is used.</p>"),
+    VALUES("none","transparent","hugetlb")),
   STRING("ReceiveBufferChunkSize", NULL, 1, "128 KiB",
     MEMBER(rmsg_chunk_size),
     FUNCTIONS(0, uf_memsize, 0, pf_memsize),
@@ -1522,6 +1676,26 @@ static struct cfgelem tcp_cfgelems[] = {
       "multiple DDSI messages being sent in the same TCP request. Setting "
       "this option typically optimises latency over throughput.</p>"
     )),
+  STRING("CoalesceDelay", NULL, 1, "0 s",
+    MEMBER(tcp_coalesce_delay),
+    FUNCTIONS(0, uf_duration_us_1s, 0, pf_duration),
+    DESCRIPTION(
+      "<p>This element specifies how long DDSI messages to the same peer "
+      "may be held back so that they can be sent to the socket in a single "
+      "write operation (and, with SSL, in a single TLS record). A value of "
+      "0 disables this. When enabled, TCP_NODELAY is always set as the "
+      "batching is done by Cyclone DDS itself.</p>\n"
+      "<p>See also TCP/CoalesceSize.</p>"),
+    UNIT("duration")),
+  STRING("CoalesceSize", NULL, 1, "16 kB",
+    MEMBER(tcp_coalesce_size),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element specifies the maximum number of bytes held back per "
+      "connection when TCP/CoalesceDelay is non-zero. A message that does "
+      "not fit causes the held back messages to be sent, together with that "
+      "message, immediately.</p>"),
+    UNIT("memsize")),
   INT("Port", NULL, 1, "-1",
     MEMBER(tcp_port),
     FUNCTIONS(0, uf_dyn_port, 0, pf_int),
@@ -1631,6 +1805,39 @@ static struct cfgelem tp_cfgelems[] = {
   END_MARKER
 };
 
+static struct cfgelem listener_cfgelems[] = {
+  BOOL("Async", NULL, 1, "false",
+    MEMBER(listener_async),
+    FUNCTIONS(0, uf_boolean, 0, pf_boolean),
+    DESCRIPTION(
+      "<p>This element enables invoking listeners on a pool of dedicated "
+      "threads rather than on the thread that detected the event (typically "
+      "a DDSI receive or delivery thread), so that a slow listener does not "
+      "delay the processing of unrelated data. The listeners of a single "
+      "entity are still invoked one at a time and in the order in which the "
+      "events occurred, and consecutive DATA_AVAILABLE events that have not "
+      "yet been dispatched are merged into a single invocation.</p>"
+    )),
+  INT("Threads", NULL, 1, "2",
+    MEMBER(listener_threads),
+    FUNCTIONS(0, uf_natint, 0, pf_int),
+    DESCRIPTION(
+      "<p>This element specifies the maximum number of threads used for "
+      "invoking listeners if Async is enabled.</p>"
+    )),
+  INT("QueueMax", NULL, 1, "256",
+    MEMBER(listener_queue_max),
+    FUNCTIONS(0, uf_natint, 0, pf_int),
+    DESCRIPTION(
+      "<p>This element specifies the maximum number of listener invocations "
+      "that may be queued for a single entity. Once the limit is reached, "
+      "the thread raising the event invokes the queued listeners itself "
+      "(or waits for them to complete), providing flow control to the "
+      "source of the events.</p>"
+    )),
+  END_MARKER
+};
+
 static struct cfgelem discovery_peer_cfgattrs[] = {
   STRING("Address", NULL, 1, NULL,
     MEMBEROF(config_peer_listelem, peer),
@@ -1753,6 +1960,36 @@ static struct cfgelem discovery_cfgelems[] = {
       "<p>This element specifies the interval between spontaneous "
       "transmissions of participant discovery packets.</p>"),
     UNIT("duration")),
+  INT("SPDPInitialBurst", NULL, 1, "0",
+    MEMBER(spdp_initial_burst),
+    FUNCTIONS(0, uf_natint, 0, pf_int),
+    DESCRIPTION(
+      "<p>This element specifies the number of additional participant "
+      "discovery packets sent shortly after creating a participant, before "
+      "reverting to Discovery/SPDPInterval. The first of these follows the "
+      "initial one after Discovery/SPDPInitialBurstInterval, each next one "
+      "after twice the preceding interval. When many processes start "
+      "simultaneously, this reduces the time it takes for them to discover "
+      "each other if some of the initial packets are lost.</p>"
+    )),
+  STRING("SPDPInitialBurstInterval", NULL, 1, "100 ms",
+    MEMBER(spdp_initial_burst_interval),
+    FUNCTIONS(0, uf_duration_ms_1s, 0, pf_duration),
+    DESCRIPTION(
+      "<p>This element specifies the interval between the first two "
+      "participant discovery packets of the burst configured with "
+      "Discovery/SPDPInitialBurst.</p>"),
+    UNIT("duration")),
+  STRING("SEDPBatchDelay", NULL, 1, "0 ms",
+    MEMBER(sedp_batch_delay),
+    FUNCTIONS(0, uf_duration_us_1s, 0, pf_duration),
+    DESCRIPTION(
+      "<p>This element specifies for how long endpoint discovery data may "
+      "be held back to combine it with that of other endpoints into fewer "
+      "packets. Creating many readers and writers in quick succession, as "
+      "happens when starting a process with many nodes, otherwise sends a "
+      "packet for each of them. A value of 0 sends them immediately.</p>"),
+    UNIT("duration")),
   STRING("DefaultMulticastAddress", NULL, 1, "auto",
     MEMBER(defaultMulticastAddressString),
     FUNCTIONS(0, uf_networkAddress, 0, pf_networkAddress),
@@ -1864,8 +2101,56 @@ static struct cfgelem tracing_cfgelems[] = {
       "fictitious, in particular the destination address of received packets. "
       "The TTL may be used to distinguish between sent and received packets: "
       "it is 255 for sent packets and 128 for received ones. Currently IPv4 "
-      "only.</p>"
-    )),
+      "only.</p>\n"
+      "<p>If Tracing/PacketCaptureRingSize is non-zero, packets are kept in "
+      "memory instead and this is the name of the files the captured packets "
+      "get written to on request, with a sequence number inserted before the "
+      "extension.</p>"
+    )),
+  STRING("PacketCaptureSnapLength", NULL, 1, "0 B",
+    MEMBER(pcap_snaplen),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element specifies the number of bytes of each RTPS message "
+      "that are captured, the remainder is dropped from the capture. The RTPS "
+      "header and the submessage headers are at the start of a message, so a "
+      "small value still allows following the protocol while greatly "
+      "reducing the cost of capturing. The default of 0 means entire messages "
+      "are captured when writing to a file directly, and the first 128 bytes "
+      "when capturing into a ring buffer.</p>"),
+    UNIT("memsize")),
+  STRING("PacketCaptureRingSize", NULL, 1, "0 B",
+    MEMBER(pcap_ring_size),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element specifies the size of an in-memory ring buffer in "
+      "which the most recent packets are captured, for use as a flight "
+      "recorder. Adding a packet to it only involves a copy of the captured "
+      "part without any locking or I/O. The packets still in it that are "
+      "not older than Tracing/PacketCaptureRingDuration are written to "
+      "Tracing/PacketCaptureFile on request: by each connection to the debug "
+      "monitor port (Internal/MonitorPort) or, on POSIX systems, "
+      "by sending the signal set with Tracing/PacketCaptureDumpSignal to the "
+      "process. The default of 0 disables the ring buffer.</p>"),
+    UNIT("memsize")),
+  STRING("PacketCaptureRingDuration", NULL, 1, "10 s",
+    MEMBER(pcap_ring_duration),
+    FUNCTIONS(0, uf_duration_inf, 0, pf_duration),
+    DESCRIPTION(
+      "<p>This element specifies how far back in time the packets written "
+      "from the packet capture ring buffer go, the oldest ones are skipped. "
+      "How far back the ring buffer goes in practice depends on its size and "
+      "the traffic.</p>"),
+    UNIT("duration_inf")),
+  INT("PacketCaptureDumpSignal", NULL, 1, "0",
+    MEMBER(pcap_dump_signal),
+    FUNCTIONS(0, uf_natint, 0, pf_int),
+    DESCRIPTION(
+      "<p>This element specifies the number of a signal that causes the "
+      "contents of the packet capture ring buffer to be written to a file, "
+      "e.g., 12 for SIGUSR2 on Linux. It is checked once per second. The "
+      "default of 0 means no signal handler is installed. This is only "
+      "supported on POSIX systems.</p>")),
   END_MARKER
 };
 
@@ -1983,6 +2268,13 @@ static struct cfgelem domain_cfgelems[] = {
       "related to using a thread pool to send DDSI messages to multiple "
       "unicast addresses (TCP or UDP).</p>"
     )),
+  GROUP("Listeners", listener_cfgelems, NULL, 1,
+    NOMEMBER,
+    NOFUNCTIONS,
+    DESCRIPTION(
+      "<p>The Listeners element allows specifying how listeners are "
+      "invoked.</p>"
+    )),
 #ifdef DDSI_INCLUDE_SSL
   GROUP("SSL", ssl_cfgelems, NULL, 1,
     NOMEMBER,
@@ -19,9 +19,10 @@ static const struct cfgunit cfgunits[] = {
       "<i>X</i>b/s, <i>X</i>bps for bits/s or <i>X</i>B/s, <i>X</i>Bps for "
       "bytes/s; where <i>X</i> is an optional prefix: k for 10<sup>3</sup>, "
       "Ki for 2<sup>10</sup>, M for 10<sup>6</sup>, Mi for 2<sup>20</sup>, "
-      "G for 10<sup>9</sup>, Gi for 2<sup>30</sup>.</p>"),
+      "G for 10<sup>9</sup>, Gi for 2<sup>30</sup>. The keyword 'inf' "
+      "means no limit.</p>"),
     PATTERN(
-      "0|(\\d+(\\.\\d*)?([Ee][\\-+]?\\d+)?|\\.\\d+([Ee][\\-+]?\\d+)?) *([kMG]i?)?[Bb][p/]s")),
+      "inf|0|(\\d+(\\.\\d*)?([Ee][\\-+]?\\d+)?|\\.\\d+([Ee][\\-+]?\\d+)?) *([kMG]i?)?[Bb][p/]s")),
   UNIT("duration",
     DESCRIPTION(
       "<p>The unit must be specified explicitly. Recognised units: ns, us, ms, "
@@ -34,7 +34,9 @@ struct entity_common;
 struct ddsi_writer_info;
 struct local_reader_ary;
 
-typedef struct ddsi_serdata * (*deliver_locally_makesample_t) (struct ddsi_tkmap_instance **tk, struct ddsi_domaingv *gv, struct ddsi_sertopic const * const topic, void *vsourceinfo);
+/* Makes a sample for rd->topic, which may be shared by subsequent readers with the
+   same topic; rd is there for its keyless_tk cache */
+typedef struct ddsi_serdata * (*deliver_locally_makesample_t) (struct ddsi_tkmap_instance **tk, struct ddsi_domaingv *gv, struct reader *rd, void *vsourceinfo);
 typedef struct reader * (*deliver_locally_first_reader_t) (struct entity_index *entity_index, struct entity_common *source_entity, ddsrt_avl_iter_t *it);
 typedef struct reader * (*deliver_locally_next_reader_t) (struct entity_index *entity_index, ddsrt_avl_iter_t *it);
 
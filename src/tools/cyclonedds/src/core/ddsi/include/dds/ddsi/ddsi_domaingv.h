@@ -45,6 +45,7 @@ struct ddsi_tran_listener;
 struct ddsi_tran_factory;
 struct ddsrt_thread_pool_s;
 struct debug_monitor;
+struct pcap_ring;
 struct ddsi_tkmap;
 struct dds_security_context;
 struct dds_security_match_index;
@@ -79,6 +80,7 @@ struct recv_thread_arg {
     } single;
     struct {
       os_sockWaitset ws;
+      struct ddsi_tran_conn *conn; /* the only connection handled, if not NULL */
     } many;
   } u;
 };
@@ -122,6 +124,10 @@ struct ddsi_domaingv {
   struct ddsi_tran_conn * data_conn_mc;
   struct ddsi_tran_conn * disc_conn_uc;
   struct ddsi_tran_conn * data_conn_uc;
+  /* Additional sockets sharing the port of data_conn_uc, each with its own
+     receive thread (Internal/UnicastReceiveShards) */
+  uint32_t n_data_conn_uc_shards;
+  struct ddsi_tran_conn * data_conn_uc_shards[MAX_UNICAST_RECV_SHARDS - 1];
 
   /* Connection used for all output (for connectionless transports), this
      used to simply be data_conn_uc, but:
@@ -227,7 +233,7 @@ struct ddsi_domaingv {
      trigger socket.) Receive buffer pool is per receive thread,
      it is only a global variable because it needs to be freed way later
      than the receive thread itself terminates */
-#define MAX_RECV_THREADS 3
+#define MAX_RECV_THREADS (2 + MAX_UNICAST_RECV_SHARDS)
   uint32_t n_recv_threads;
   struct recv_thread {
     const char *name;
@@ -315,10 +321,21 @@ struct ddsi_domaingv {
   int sendq_stop;
   struct thread_state1 *sendq_ts;
 
+  /* Packet collecting SEDP data for Discovery/SEDPBatchDelay, flushed by
+     sedp_batch_xevent; NULL if batching is disabled or stopped */
+  ddsrt_mutex_t sedp_batch_lock;
+  struct nn_xpack *sedp_batch_xp;
+  struct xevent *sedp_batch_xevent;
+
   /* File for dumping captured packets, NULL if disabled */
   FILE *pcap_fp;
   ddsrt_mutex_t pcap_lock;
 
+  /* Ring buffer of captured packets instead of pcap_fp, NULL if disabled, and
+     the event checking for requests to dump it by signal */
+  struct pcap_ring *pcap_ring;
+  struct xevent *pcap_dump_xevent;
+
   struct ddsi_builtin_topic_interface *builtin_topic_interface;
 
   struct nn_group_membership *mship;
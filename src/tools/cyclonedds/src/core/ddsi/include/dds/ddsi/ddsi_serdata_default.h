@@ -118,6 +118,7 @@ struct ddsi_sertopic_default {
   struct serdatapool *serpool;
   struct ddsi_sertopic_default_desc type;
   size_t opt_size;
+  uint32_t *opt_ops; /* type.m_ops with runs of primitives fused into blocks, or NULL */
 };
 
 struct ddsi_plist_sample {
@@ -22,6 +22,7 @@ struct reader;
 struct writer;
 
 void ddsi_get_writer_stats (struct writer *wr, uint64_t * __restrict rexmit_bytes, uint32_t * __restrict throttle_count, uint64_t * __restrict time_throttled, uint64_t * __restrict time_retransmit);
+void ddsi_get_writer_traffic_stats (struct writer *wr, uint64_t * __restrict samples, uint64_t * __restrict bytes, uint32_t * __restrict rexmit_count, uint32_t * __restrict nacks_received, uint64_t * __restrict whc_unacked_bytes);
 void ddsi_get_reader_stats (struct reader *rd, uint64_t * __restrict discarded_bytes);
 
 #if defined (__cplusplus)
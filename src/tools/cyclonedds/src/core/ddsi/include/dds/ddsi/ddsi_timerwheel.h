@@ -0,0 +1,81 @@
+/*
+ * Copyright(c) 2020 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#ifndef DDSI_TIMERWHEEL_H
+#define DDSI_TIMERWHEEL_H
+
+#include <stdint.h>
+
+#include "dds/export.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* Hierarchical timer wheel: a priority queue of nodes keyed on a time in nanoseconds
+   (an int64_t in the containing object), like ddsrt_fibheap, but with constant-time
+   insert and delete at the cost of a resolution of one tick.
+
+   A node with key t becomes due at the first multiple of the tick that is >= t, so it
+   is returned by ddsi_timerwheel_extract_due at most one tick late, and the nodes that
+   become due together are returned in no particular order.  Negative keys are always
+   due.
+
+   The wheel has DDSI_TIMERWHEEL_LEVELS levels of DDSI_TIMERWHEEL_SLOTS slots, each
+   slot of level L covering SLOTS^L ticks, enough to cover all positive keys.  Nodes
+   in slots of higher levels are moved down as the wheel advances. */
+
+#define DDSI_TIMERWHEEL_BITS 6
+#define DDSI_TIMERWHEEL_SLOTS (1 << DDSI_TIMERWHEEL_BITS)
+#define DDSI_TIMERWHEEL_LEVELS 11
+
+typedef struct ddsi_timerwheel_node {
+  struct ddsi_timerwheel_node *next, **pprev;
+  int16_t level; /* -1 if due */
+  uint16_t slot;
+} ddsi_timerwheel_node_t;
+
+typedef struct ddsi_timerwheel_def {
+  uintptr_t offset; /* offset of the node in the containing object */
+  uintptr_t keyoffset; /* offset of the int64_t key in the containing object */
+} ddsi_timerwheel_def_t;
+
+typedef struct ddsi_timerwheel {
+  int64_t tick; /* in ns */
+  int64_t cur; /* nodes due at ticks <= cur are on the due list */
+  ddsi_timerwheel_node_t *due;
+  uint64_t occupied[DDSI_TIMERWHEEL_LEVELS];
+  ddsi_timerwheel_node_t *slots[DDSI_TIMERWHEEL_LEVELS][DDSI_TIMERWHEEL_SLOTS];
+} ddsi_timerwheel_t;
+
+#define DDSI_TIMERWHEELDEF_INITIALIZER(offset, keyoffset) { (offset), (keyoffset) }
+
+DDS_EXPORT void ddsi_timerwheel_init (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw, int64_t tick, int64_t tnow);
+DDS_EXPORT void ddsi_timerwheel_insert (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw, void *vnode);
+DDS_EXPORT void ddsi_timerwheel_delete (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw, void *vnode);
+
+/* Time at which the next node is due, INT64_MIN if some already are and INT64_MAX if
+   the wheel is empty.  For nodes in higher levels this is a lower bound, so waking up
+   at it may find nothing due yet. */
+DDS_EXPORT int64_t ddsi_timerwheel_next (const ddsi_timerwheel_def_t *twdef, const ddsi_timerwheel_t *tw);
+
+/* Advances the wheel to tnow and removes and returns a node that is due by then, or
+   NULL if there is none.  tnow must not decrease between calls. */
+DDS_EXPORT void *ddsi_timerwheel_extract_due (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw, int64_t tnow);
+
+/* Removes and returns any node, for emptying the wheel */
+DDS_EXPORT void *ddsi_timerwheel_extract_any (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSI_TIMERWHEEL_H */
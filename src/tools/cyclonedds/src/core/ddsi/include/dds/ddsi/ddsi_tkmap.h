@@ -40,6 +40,13 @@ DDS_EXPORT struct ddsi_tkmap_instance * ddsi_tkmap_find_by_id (struct ddsi_tkmap
 DDS_EXPORT struct ddsi_tkmap_instance * ddsi_tkmap_lookup_instance_ref (struct ddsi_tkmap *map, struct ddsi_serdata * sd);
 DDS_EXPORT void ddsi_tkmap_instance_unref (struct ddsi_tkmap *map, struct ddsi_tkmap_instance *tk);
 
+/* All samples of a keyless topic map to the same instance, so a reader or writer of
+   such a topic can remember it in "cache" and skip the hash table on all but the first
+   lookup.  The cache holds a reference until ddsi_tkmap_cache_fini.  For topics with
+   a key this is simply ddsi_tkmap_lookup_instance_ref. */
+DDS_EXPORT struct ddsi_tkmap_instance *ddsi_tkmap_lookup_instance_ref_cached (struct ddsi_tkmap *map, ddsrt_atomic_voidp_t *cache, struct ddsi_serdata *sd);
+DDS_EXPORT void ddsi_tkmap_cache_fini (struct ddsi_tkmap *map, ddsrt_atomic_voidp_t *cache);
+
 #if defined (__cplusplus)
 }
 #endif
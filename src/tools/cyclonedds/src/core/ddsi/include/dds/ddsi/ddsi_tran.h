@@ -48,10 +48,21 @@ typedef struct ddsi_tran_listener * ddsi_tran_listener_t;
 typedef struct ddsi_tran_factory * ddsi_tran_factory_t;
 typedef struct ddsi_tran_qos ddsi_tran_qos_t;
 
+/* Receive buffer for reading a batch of datagrams: buf and len are set by the
+   caller, size and srcloc by the transport */
+struct ddsi_tran_rbuf {
+  unsigned char *buf;
+  size_t len;
+  size_t size;
+  nn_locator_t srcloc;
+};
+
 /* Function pointer types */
 
 typedef ssize_t (*ddsi_tran_read_fn_t) (ddsi_tran_conn_t, unsigned char *, size_t, bool, nn_locator_t *);
+typedef int (*ddsi_tran_read_batch_fn_t) (ddsi_tran_conn_t, struct ddsi_tran_rbuf *, int);
 typedef ssize_t (*ddsi_tran_write_fn_t) (ddsi_tran_conn_t, const nn_locator_t *, size_t, const ddsrt_iovec_t *, uint32_t);
+typedef size_t (*ddsi_tran_write_multi_fn_t) (ddsi_tran_conn_t, size_t, const nn_locator_t *, size_t, const ddsrt_iovec_t *, uint32_t);
 typedef int (*ddsi_tran_locator_fn_t) (ddsi_tran_factory_t, ddsi_tran_base_t, nn_locator_t *);
 typedef bool (*ddsi_tran_supports_fn_t) (const struct ddsi_tran_factory *, int32_t);
 typedef ddsrt_socket_t (*ddsi_tran_handle_fn_t) (ddsi_tran_base_t);
@@ -117,7 +128,9 @@ struct ddsi_tran_conn
   /* Functions */
 
   ddsi_tran_read_fn_t m_read_fn;
+  ddsi_tran_read_batch_fn_t m_read_batch_fn; /* optional, connectionless only */
   ddsi_tran_write_fn_t m_write_fn;
+  ddsi_tran_write_multi_fn_t m_write_multi_fn; /* optional, connectionless only */
   ddsi_tran_peer_locator_fn_t m_peer_locator_fn;
   ddsi_tran_disable_multiplexing_fn_t m_disable_multiplexing_fn;
   ddsi_tran_locator_fn_t m_locator_fn;
@@ -201,6 +214,7 @@ struct ddsi_tran_qos
 {
   enum ddsi_tran_qos_purpose m_purpose;
   int m_diffserv;
+  bool m_reuse_port; /* RECV_UC: share the port with other sockets, spreading the packets over them */
 };
 
 void ddsi_tran_factories_fini (struct ddsi_domaingv *gv);
@@ -254,6 +268,23 @@ inline ssize_t ddsi_conn_write (ddsi_tran_conn_t conn, const nn_locator_t *dst,
 inline ssize_t ddsi_conn_read (ddsi_tran_conn_t conn, unsigned char * buf, size_t len, bool allow_spurious, nn_locator_t *srcloc) {
   return conn->m_closed ? -1 : conn->m_read_fn (conn, buf, len, allow_spurious, srcloc);
 }
+inline bool ddsi_conn_supports_write_multi (const struct ddsi_tran_conn *conn) {
+  return conn->m_write_multi_fn != 0;
+}
+/* Writes the same message to ndst destinations, with as few system calls as
+   the transport can manage; returns the number of destinations it was sent to */
+inline size_t ddsi_conn_write_multi (ddsi_tran_conn_t conn, size_t ndst, const nn_locator_t *dst, size_t niov, const ddsrt_iovec_t *iov, uint32_t flags) {
+  return conn->m_closed ? 0 : conn->m_write_multi_fn (conn, ndst, dst, niov, iov, flags);
+}
+inline bool ddsi_conn_supports_read_batch (const struct ddsi_tran_conn *conn) {
+  return conn->m_read_batch_fn != 0;
+}
+/* Waits for at least one datagram, then returns as many of those already
+   waiting as fit in bufs: the number of datagrams read, 0 for a spurious
+   wakeup, or -1 on error */
+inline int ddsi_conn_read_batch (ddsi_tran_conn_t conn, struct ddsi_tran_rbuf *bufs, int nbufs) {
+  return conn->m_closed ? -1 : conn->m_read_batch_fn (conn, bufs, nbufs);
+}
 bool ddsi_conn_peer_locator (ddsi_tran_conn_t conn, nn_locator_t * loc);
 void ddsi_conn_disable_multiplexing (ddsi_tran_conn_t conn);
 void ddsi_conn_add_ref (ddsi_tran_conn_t conn);
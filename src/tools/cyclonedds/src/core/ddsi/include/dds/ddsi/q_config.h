@@ -72,6 +72,11 @@ struct config_ignoredpartition_listelem {
   char *DCPSPartitionTopic;
 };
 
+struct config_unicastpartition_listelem {
+  struct config_unicastpartition_listelem *next;
+  char *DCPSPartitionTopic;
+};
+
 struct config_partitionmapping_listelem {
   struct config_partitionmapping_listelem *next;
   char *networkPartition;
@@ -120,6 +125,7 @@ struct config_thread_properties_listelem {
   ddsrt_sched_t sched_class;
   struct config_maybe_int32 sched_priority;
   struct config_maybe_uint32 stack_size;
+  char *affinity; /* CPU list as in the configuration, NULL for the default */
 };
 
 struct config_peer_listelem
@@ -161,6 +167,12 @@ enum many_sockets_mode {
   MSM_MANY_UNICAST
 };
 
+enum rbuf_hugepages {
+  RBUF_HUGEPAGES_NONE,
+  RBUF_HUGEPAGES_TRANSPARENT,
+  RBUF_HUGEPAGES_HUGETLB
+};
+
 #ifdef DDSI_INCLUDE_SECURITY
 typedef struct plugin_library_properties_type{
   char *library_path;
@@ -208,6 +220,9 @@ struct ssl_min_version {
 #define DDS_XCHECK_WHC 1u
 #define DDS_XCHECK_RHC 2u
 
+#define MAX_UNICAST_RECV_SHARDS 8
+#define MAX_THREAD_AFFINITY_CPUS 1024
+
 struct config
 {
   int valid;
@@ -215,6 +230,10 @@ struct config
   uint32_t enabled_xchecks;
   char *servicename;
   char *pcap_file;
+  uint32_t pcap_snaplen;
+  uint32_t pcap_ring_size;
+  int64_t pcap_ring_duration;
+  int pcap_dump_signal;
 
   char *networkAddressString;
   char **networkRecvAddressStrings;
@@ -240,6 +259,9 @@ struct config
   char *defaultMulticastAddressString;
   char *assumeMulticastCapable;
   int64_t spdp_interval;
+  int spdp_initial_burst;
+  int64_t spdp_initial_burst_interval;
+  int64_t sedp_batch_delay;
   int64_t spdp_response_delay_max;
   int64_t lease_duration;
   int64_t const_hb_intv_sched;
@@ -256,6 +278,7 @@ struct config
   int xpack_send_async;
   enum boolean_default multiple_recv_threads;
   unsigned recv_thread_stop_maxretries;
+  int unicast_recv_shards;
 
   unsigned primary_reorder_maxsamples;
   unsigned secondary_reorder_maxsamples;
@@ -267,6 +290,9 @@ struct config
   uint32_t max_rexmit_msg_size;
   uint32_t init_transmit_extra_pct;
   uint32_t max_rexmit_burst_size;
+  uint32_t fragment_pacing_bandwidth;
+  uint32_t fragment_pacing_bucket_size;
+  int fragment_pacing_priority_threshold;
 
   int publish_uc_locators; /* Publish discovery unicast locators */
   int enable_uc_locators; /* If false, don't even try to create a unicast socket */
@@ -276,6 +302,8 @@ struct config
   int tcp_port;
   int64_t tcp_read_timeout;
   int64_t tcp_write_timeout;
+  int64_t tcp_coalesce_delay;
+  uint32_t tcp_coalesce_size;
   int tcp_use_peeraddr_for_unicast;
 
 #ifdef DDSI_INCLUDE_SSL
@@ -296,6 +324,11 @@ struct config
   uint32_t tp_threads;
   uint32_t tp_max_threads;
 
+  /* Listener dispatch configuration */
+  int listener_async;
+  uint32_t listener_threads;
+  uint32_t listener_queue_max;
+
 #ifdef DDSI_INCLUDE_NETWORK_CHANNELS
   struct config_channel_listelem *channels;
   struct config_channel_listelem *max_channel; /* channel with highest prio; always computed */
@@ -304,6 +337,7 @@ struct config
   struct config_networkpartition_listelem *networkPartitions;
   unsigned nof_networkPartitions;
   struct config_ignoredpartition_listelem *ignoredPartitions;
+  struct config_unicastpartition_listelem *unicastPartitions;
   struct config_partitionmapping_listelem *partitionMappings;
 #endif /* DDSI_INCLUDE_NETWORK_PARTITIONS */
   struct config_peer_listelem *peers;
@@ -314,6 +348,8 @@ struct config
   int xmit_lossiness;           /**<< fraction of packets to drop on xmit, in units of 1e-3 */
   uint32_t rmsg_chunk_size;          /**<< size of a chunk in the receive buffer */
   uint32_t rbuf_size;                /* << size of a single receiver buffer */
+  uint32_t rbuf_max_size;            /* << upper bound for adapting rbuf_size, 0 if fixed */
+  enum rbuf_hugepages rbuf_hugepages;
   enum besmode besmode;
   int meas_hb_to_ack_latency;
   int unicast_response_to_spdp_messages;
@@ -330,6 +366,7 @@ struct config
 
   unsigned defrag_unreliable_maxsamples;
   unsigned defrag_reliable_maxsamples;
+  uint32_t defrag_contiguous_threshold;
   unsigned accelerate_rexmit_block_size;
   int64_t responsiveness_timeout;
   uint32_t max_participants;
@@ -341,6 +378,7 @@ struct config
   int64_t nack_delay;
   int64_t preemptive_ack_delay;
   int64_t schedule_time_rounding;
+  int64_t timer_wheel_tick;
   int64_t auto_resched_nack_delay;
   int64_t ds_grace_period;
 #ifdef DDSI_INCLUDE_BANDWIDTH_LIMITING
@@ -384,10 +422,16 @@ void config_print_cfgst (struct cfgst *cfgst, const struct ddsrt_log_cfg *logcfg
 void config_free_source_info (struct cfgst *cfgst);
 void config_fini (struct cfgst *cfgst);
 
+/* Parses a list of CPUs like "2,3,5-7" into the distinct CPU numbers, in increasing
+   order, storing them in cpus if non-NULL (which then has room for
+   MAX_THREAD_AFFINITY_CPUS); returns their number, or -1 if str is malformed */
+int config_parse_cpu_list (const char *str, uint32_t *cpus);
+
 #ifdef DDSI_INCLUDE_NETWORK_PARTITIONS
 struct config_partitionmapping_listelem *find_partitionmapping (const struct config *cfg, const char *partition, const char *topic);
 struct config_networkpartition_listelem *find_networkpartition_by_id (const struct config *cfg, uint32_t id);
 int is_ignored_partition (const struct config *cfg, const char *partition, const char *topic);
+int is_unicast_partition (const struct config *cfg, const char *partition, const char *topic);
 #endif
 #ifdef DDSI_INCLUDE_NETWORK_CHANNELS
 struct config_channel_listelem *find_channel (const struct config *cfg, nn_transport_priority_qospolicy_t transport_priority);
@@ -24,6 +24,7 @@ struct reader;
 struct nn_rsample_info;
 struct nn_rdata;
 struct ddsi_plist;
+struct ddsi_domaingv;
 
 struct participant_builtin_topic_data_locators {
   struct nn_locators_one def_uni_loc_one, def_multi_loc_one, meta_uni_loc_one, meta_multi_loc_one;
@@ -39,6 +40,12 @@ int sedp_write_reader (struct reader *rd);
 int sedp_dispose_unregister_writer (struct writer *wr);
 int sedp_dispose_unregister_reader (struct reader *rd);
 
+/* Batching of SEDP writes (Discovery/SEDPBatchDelay): stop sends out whatever is
+   pending and makes subsequent writes go out immediately, fini also stops */
+void sedp_batch_init (struct ddsi_domaingv *gv);
+void sedp_batch_stop (struct ddsi_domaingv *gv);
+void sedp_batch_fini (struct ddsi_domaingv *gv);
+
 int builtins_dqueue_handler (const struct nn_rsample_info *sampleinfo, const struct nn_rdata *fragchain, const ddsi_guid_t *rdguid, void *qarg);
 
 #if defined (__cplusplus)
@@ -310,6 +310,7 @@ struct writer
 #endif
   uint32_t alive_vclock; /* virtual clock counting transitions between alive/not-alive */
   const struct ddsi_sertopic * topic; /* topic */
+  ddsrt_atomic_voidp_t keyless_tk; /* instance of a keyless topic, see ddsi_tkmap_lookup_instance_ref_cached */
   struct addrset *as; /* set of addresses to publish to */
   struct addrset *as_group; /* alternate case, used for SPDP, when using Cloud with multiple bootstrap locators */
   struct xevent *heartbeat_xevent; /* timed event for "periodically" publishing heartbeats when unack'd data present, NULL <=> unreliable */
@@ -321,12 +322,16 @@ struct writer
   ddsrt_etime_t t_whc_high_upd; /* time "whc_high" was last updated for controlled ramp-up of throughput */
   uint32_t init_burst_size_limit; /* derived from reader's receive_buffer_size */
   uint32_t rexmit_burst_size_limit; /* derived from reader's receive_buffer_size */
+  uint32_t pacing_rate; /* bytes/s for pacing fragments of large samples, 0 = not paced */
+  int64_t pacing_tokens; /* bytes that may be sent without waiting, negative after exceeding the rate */
+  ddsrt_mtime_t pacing_tupdate; /* time pacing_tokens was last updated */
   uint32_t num_readers; /* total number of matching PROXY readers */
   uint32_t num_reliable_readers; /* number of matching reliable PROXY readers */
   ddsrt_avl_tree_t readers; /* all matching PROXY readers, see struct wr_prd_match */
   ddsrt_avl_tree_t local_readers; /* all matching LOCAL readers, see struct wr_rd_match */
 #ifdef DDSI_INCLUDE_NETWORK_PARTITIONS
   uint32_t partition_id;
+  unsigned unicast_only: 1; /* iff 1, partition/topic matches a UnicastPartition: never send to multicast */
 #endif
   uint32_t num_acks_received; /* cum received ACKNACKs with no request for retransmission */
   uint32_t num_nacks_received; /* cum received ACKNACKs that did request retransmission */
@@ -335,6 +340,7 @@ struct writer
   uint32_t rexmit_count; /* cum samples retransmitted (counting events; 1 sample can be counted many times) */
   uint32_t rexmit_lost_count; /* cum samples lost but retransmit requested (also counting events) */
   uint64_t rexmit_bytes; /* cum bytes queued for retransmit */
+  uint64_t write_bytes; /* cum serialized bytes of the samples written */
   uint64_t time_throttled; /* cum time in throttled state */
   uint64_t time_retransmit; /* cum time in retransmitting state */
   struct xeventq *evq; /* timed event queue to be used by this writer */
@@ -375,6 +381,7 @@ struct reader
   struct addrset *as;
 #endif
   const struct ddsi_sertopic * topic; /* topic */
+  ddsrt_atomic_voidp_t keyless_tk; /* instance of a keyless topic, see ddsi_tkmap_lookup_instance_ref_cached */
   uint32_t num_writers; /* total number of matching PROXY writers */
   ddsrt_avl_tree_t writers; /* all matching PROXY writers, see struct rd_pwr_match */
   ddsrt_avl_tree_t local_writers; /* all matching LOCAL writers, see struct rd_wr_match */
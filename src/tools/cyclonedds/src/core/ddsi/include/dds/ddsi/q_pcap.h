@@ -20,9 +20,19 @@ extern "C" {
 #endif
 
 struct msghdr;
+struct pcap_ring;
 
 FILE * new_pcap_file (struct ddsi_domaingv *gv, const char *name);
 
+struct pcap_ring *new_pcap_ring (struct ddsi_domaingv *gv);
+void free_pcap_ring (struct pcap_ring *ring);
+void start_pcap_dump_signal (struct ddsi_domaingv *gv);
+void stop_pcap_dump_signal (struct ddsi_domaingv *gv);
+
+/* Writes the contents of the ring buffer to a new file, the name of which is
+   returned in NAME; returns the number of packets written or -1 on failure */
+int dump_pcap_ring (struct ddsi_domaingv *gv, char *name, size_t size);
+
 void write_pcap_received (struct ddsi_domaingv *gv, ddsrt_wctime_t tstamp, const struct sockaddr_storage *src, const struct sockaddr_storage *dst, unsigned char *buf, size_t sz);
 void write_pcap_sent (struct ddsi_domaingv *gv, ddsrt_wctime_t tstamp, const struct sockaddr_storage *src,
   const ddsrt_msghdr_t *hdr, size_t sz);
@@ -204,9 +204,25 @@ typedef int32_t nn_reorder_result_t;
 
 typedef void (*nn_dqueue_callback_t) (void *arg);
 
-struct nn_rbufpool *nn_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_t rbuf_size, uint32_t max_rmsg_size);
+struct nn_rbufpool_stats {
+  uint32_t rbuf_size;     /* size of new receive buffers */
+  uint32_t min_rbuf_size;
+  uint32_t max_rbuf_size;
+  uint32_t max_msg_size;  /* largest message received */
+  uint32_t live;          /* receive buffers in use, including the current one */
+  uint32_t cached;        /* empty receive buffers kept for reuse */
+  uint64_t allocs;        /* receive buffers allocated */
+  uint64_t reuses;        /* ... taken from the cache instead */
+  uint64_t frees;
+  uint64_t failures;      /* failures to get a new one, each dropping data */
+  uint64_t grows;         /* increases of rbuf_size */
+  uint64_t shrinks;
+};
+
+struct nn_rbufpool *nn_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_t rbuf_size, uint32_t max_rmsg_size, uint32_t max_rbuf_size, enum rbuf_hugepages hugepages);
 void nn_rbufpool_setowner (struct nn_rbufpool *rbp, ddsrt_thread_t tid);
 void nn_rbufpool_free (struct nn_rbufpool *rbp);
+void nn_rbufpool_get_stats (struct nn_rbufpool *rbp, struct nn_rbufpool_stats *stats);
 
 struct nn_rmsg *nn_rmsg_new (struct nn_rbufpool *rbufpool);
 void nn_rmsg_setsize (struct nn_rmsg *rmsg, uint32_t size);
@@ -219,7 +235,19 @@ struct nn_rdata *nn_rdata_newgap (struct nn_rmsg *rmsg);
 void nn_fragchain_adjust_refcount (struct nn_rdata *frag, int adjust);
 void nn_fragchain_unref (struct nn_rdata *frag);
 
-struct nn_defrag *nn_defrag_new (const struct ddsrt_log_cfg *logcfg, enum nn_defrag_drop_mode drop_mode, uint32_t max_samples);
+/* A sample of at least Internal/DefragContiguousThreshold bytes that was
+   reassembled from fragments arrives as one rdata in an rmsg of its own,
+   with the payload zero-padded to a multiple of 4 bytes, followed only by
+   an empty one.  For those,
+   nn_fragchain_ref_contiguous returns the payload and adds a reference to
+   rmsg that keeps it valid until nn_rmsg_unref_contiguous, so that a
+   serdata can hold on to it instead of copying it; for other fragchains
+   it returns NULL. */
+#define NN_RADMIN_HAS_CONTIGUOUS_FRAGCHAIN 1
+DDS_EXPORT const void *nn_fragchain_ref_contiguous (const struct nn_rdata *fragchain, struct nn_rmsg **rmsg);
+DDS_EXPORT void nn_rmsg_unref_contiguous (struct nn_rmsg *rmsg);
+
+struct nn_defrag *nn_defrag_new (const struct ddsrt_log_cfg *logcfg, enum nn_defrag_drop_mode drop_mode, uint32_t max_samples, uint32_t contiguous_threshold);
 void nn_defrag_free (struct nn_defrag *defrag);
 struct nn_rsample *nn_defrag_rsample (struct nn_defrag *defrag, struct nn_rdata *rdata, const struct nn_rsample_info *sampleinfo);
 void nn_defrag_notegap (struct nn_defrag *defrag, seqno_t min, seqno_t maxp1);
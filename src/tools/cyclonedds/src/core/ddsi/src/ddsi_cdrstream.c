@@ -256,6 +256,215 @@ size_t dds_stream_check_optimize (const struct ddsi_sertopic_default_desc * __re
   return dds_stream_check_optimize1 (desc);
 }
 
+struct fuse_ops {
+  uint32_t *ops;
+  uint32_t n, size;
+  uint32_t nblocks;
+  bool failed;
+  /* run of primitive fields that are contiguous in memory: position of the BLK
+     instruction reserved for it, number of fields and range of memory covered */
+  uint32_t run_pos, run_nfields;
+  uint32_t run_offset, run_end;
+  uint32_t run_align, run_first_align;
+};
+
+static void fuse_ops_append (struct fuse_ops * __restrict f, const uint32_t * __restrict ops, uint32_t n)
+{
+  if (f->n + n > f->size)
+  {
+    f->size = 2 * (f->n + n);
+    f->ops = ddsrt_realloc (f->ops, f->size * sizeof (*f->ops));
+  }
+  if (ops)
+    memcpy (f->ops + f->n, ops, n * sizeof (*f->ops));
+  f->n += n;
+}
+
+static void fuse_ops_flush_run (struct fuse_ops * __restrict f)
+{
+  if (f->run_nfields == 0)
+    return;
+  const uint32_t nwords = f->n - (f->run_pos + 4);
+  if (f->run_nfields == 1)
+  {
+    /* nothing to be gained for a single field: drop the BLK instruction */
+    memmove (f->ops + f->run_pos, f->ops + f->run_pos + 4, nwords * sizeof (*f->ops));
+    f->n -= 4;
+  }
+  else
+  {
+    f->ops[f->run_pos] = DDS_OP_BLK | (f->run_align << 16) | (f->run_first_align << 8);
+    f->ops[f->run_pos + 1] = f->run_offset;
+    f->ops[f->run_pos + 2] = f->run_end - f->run_offset;
+    f->ops[f->run_pos + 3] = nwords;
+    f->nblocks++;
+  }
+  f->run_nfields = 0;
+}
+
+static void fuse_ops_prim (struct fuse_ops * __restrict f, const uint32_t * __restrict ops, uint32_t nwords, uint32_t elem_size, uint32_t size)
+{
+  /* a field can only be added to the run if the CDR representation has no padding
+     in front of it, i.e., if it directly follows the previous one and is naturally
+     aligned in memory */
+  const uint32_t offset = ops[1];
+  const bool aligned = (offset % elem_size) == 0;
+  if (f->run_nfields > 0 && (offset != f->run_end || !aligned))
+    fuse_ops_flush_run (f);
+  if (!aligned)
+  {
+    fuse_ops_append (f, ops, nwords);
+    return;
+  }
+  if (f->run_nfields == 0)
+  {
+    f->run_pos = f->n;
+    fuse_ops_append (f, NULL, 4);
+    f->run_offset = offset;
+    f->run_align = f->run_first_align = elem_size;
+  }
+  fuse_ops_append (f, ops, nwords);
+  f->run_nfields++;
+  f->run_end = offset + size;
+  if (elem_size > f->run_align)
+    f->run_align = elem_size;
+}
+
+static void fuse_ops1 (struct fuse_ops * __restrict f, const uint32_t * __restrict ops, bool inlined);
+
+static const uint32_t *fuse_ops_nested (struct fuse_ops * __restrict f, const uint32_t * __restrict ops, uint32_t insn_size)
+{
+  /* copy of the instruction immediately followed by the fused element instructions */
+  const uint32_t jmp = DDS_OP_ADR_JMP (ops[3]);
+  fuse_ops_flush_run (f);
+  const uint32_t pos = f->n;
+  fuse_ops_append (f, ops, insn_size);
+  fuse_ops1 (f, ops + DDS_OP_ADR_JSR (ops[3]), false);
+  const uint32_t next = f->n - pos;
+  if (next > DDS_OP_JMP_MASK)
+    f->failed = true;
+  else
+    f->ops[pos + 3] = (next << 16) | insn_size;
+  return ops + (jmp ? jmp : insn_size);
+}
+
+static const uint32_t *fuse_ops_seq (struct fuse_ops * __restrict f, const uint32_t * __restrict ops, uint32_t insn)
+{
+  switch (DDS_OP_SUBTYPE (insn))
+  {
+    case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY: case DDS_OP_VAL_STR:
+      fuse_ops_flush_run (f);
+      fuse_ops_append (f, ops, 2);
+      return ops + 2;
+    case DDS_OP_VAL_BST:
+      fuse_ops_flush_run (f);
+      fuse_ops_append (f, ops, 3);
+      return ops + 3;
+    case DDS_OP_VAL_SEQ: case DDS_OP_VAL_ARR: case DDS_OP_VAL_UNI: case DDS_OP_VAL_STU:
+      return fuse_ops_nested (f, ops, 4);
+  }
+  return NULL;
+}
+
+static const uint32_t *fuse_ops_arr (struct fuse_ops * __restrict f, const uint32_t * __restrict ops, uint32_t insn)
+{
+  const enum dds_stream_typecode subtype = DDS_OP_SUBTYPE (insn);
+  switch (subtype)
+  {
+    case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+      fuse_ops_prim (f, ops, 3, get_type_size (subtype), ops[2] * get_type_size (subtype));
+      return ops + 3;
+    case DDS_OP_VAL_STR:
+      fuse_ops_flush_run (f);
+      fuse_ops_append (f, ops, 3);
+      return ops + 3;
+    case DDS_OP_VAL_BST:
+      fuse_ops_flush_run (f);
+      fuse_ops_append (f, ops, 5);
+      return ops + 5;
+    case DDS_OP_VAL_SEQ: case DDS_OP_VAL_ARR: case DDS_OP_VAL_UNI: case DDS_OP_VAL_STU:
+      return fuse_ops_nested (f, ops, 5);
+  }
+  return NULL;
+}
+
+static void fuse_ops1 (struct fuse_ops * __restrict f, const uint32_t * __restrict ops, bool inlined)
+{
+  uint32_t insn;
+  while (!f->failed && (insn = *ops) != DDS_OP_RTS)
+  {
+    switch (DDS_OP (insn))
+    {
+      case DDS_OP_ADR: {
+        const enum dds_stream_typecode type = DDS_OP_TYPE (insn);
+        switch (type)
+        {
+          case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+            fuse_ops_prim (f, ops, 2, get_type_size (type), get_type_size (type));
+            ops += 2;
+            break;
+          case DDS_OP_VAL_STR:
+            fuse_ops_flush_run (f);
+            fuse_ops_append (f, ops, 2);
+            ops += 2;
+            break;
+          case DDS_OP_VAL_BST:
+            fuse_ops_flush_run (f);
+            fuse_ops_append (f, ops, 3);
+            ops += 3;
+            break;
+          case DDS_OP_VAL_SEQ: ops = fuse_ops_seq (f, ops, insn); break;
+          case DDS_OP_VAL_ARR: ops = fuse_ops_arr (f, ops, insn); break;
+          case DDS_OP_VAL_UNI: f->failed = true; break;
+          case DDS_OP_VAL_STU: abort (); break;
+        }
+        break;
+      }
+      case DDS_OP_JSR: {
+        /* a subroutine works on the same data, so it can be inlined, and that way
+           fields can be fused across it */
+        if (DDS_OP_JUMP (insn) <= 0)
+          f->failed = true;
+        else
+          fuse_ops1 (f, ops + DDS_OP_JUMP (insn), true);
+        ops++;
+        break;
+      }
+      case DDS_OP_RTS: case DDS_OP_JEQ: case DDS_OP_BLK: {
+        abort ();
+        break;
+      }
+    }
+  }
+  if (!inlined)
+  {
+    const uint32_t rts = DDS_OP_RTS;
+    fuse_ops_flush_run (f);
+    fuse_ops_append (f, &rts, 1);
+  }
+}
+
+/* Derives from the marshalling meta data of a type an equivalent op stream for
+   (de)serializing samples in which each run of primitive fields that has the
+   same layout in memory and in CDR is preceded by a BLK instruction, so that it
+   can be copied in one go.  Returns NULL if there are no such runs or the type
+   contains a union.  The result is only meaningful to dds_stream_write and
+   dds_stream_read, everything else continues to use the original. */
+uint32_t *dds_stream_fuse_ops (const struct ddsi_sertopic_default_desc * __restrict desc)
+{
+  struct fuse_ops f;
+  memset (&f, 0, sizeof (f));
+  if (desc->m_flagset & DDS_TOPIC_CONTAINS_UNION)
+    return NULL;
+  fuse_ops1 (&f, desc->m_ops, false);
+  if (f.failed || f.nblocks == 0)
+  {
+    ddsrt_free (f.ops);
+    return NULL;
+  }
+  return f.ops;
+}
+
 static void dds_stream_countops1 (const uint32_t * __restrict ops, const uint32_t **ops_end);
 
 static const uint32_t *dds_stream_countops_seq (const uint32_t * __restrict ops, uint32_t insn, const uint32_t **ops_end)
@@ -369,7 +578,7 @@ static void dds_stream_countops1 (const uint32_t * __restrict ops, const uint32_
         ops++;
         break;
       }
-      case DDS_OP_RTS: case DDS_OP_JEQ: {
+      case DDS_OP_RTS: case DDS_OP_JEQ: case DDS_OP_BLK: {
         abort ();
         break;
       }
@@ -665,6 +874,21 @@ static void dds_stream_write (dds_ostream_t * __restrict os, const char * __rest
         ops++;
         break;
       }
+      case DDS_OP_BLK: {
+        const uint32_t size = ops[2];
+        dds_cdr_alignto_clear_and_resize (os, DDS_OP_BLK_FIRST_ALIGN (insn), size);
+        if (((os->m_index - ops[1]) & (DDS_OP_BLK_ALIGN (insn) - 1)) == 0)
+        {
+          memcpy (os->m_buffer + os->m_index, data + ops[1], size);
+          os->m_index += size;
+          ops += 4 + ops[3];
+        }
+        else
+        {
+          ops += 4;
+        }
+        break;
+      }
       case DDS_OP_RTS: case DDS_OP_JEQ: {
         abort ();
         break;
@@ -855,6 +1079,20 @@ static void dds_stream_read (dds_istream_t * __restrict is, char * __restrict da
         ops++;
         break;
       }
+      case DDS_OP_BLK: {
+        dds_cdr_alignto (is, DDS_OP_BLK_FIRST_ALIGN (insn));
+        if (((is->m_index - ops[1]) & (DDS_OP_BLK_ALIGN (insn) - 1)) == 0)
+        {
+          memcpy (data + ops[1], is->m_buffer + is->m_index, ops[2]);
+          is->m_index += ops[2];
+          ops += 4 + ops[3];
+        }
+        else
+        {
+          ops += 4;
+        }
+        break;
+      }
       case DDS_OP_RTS: case DDS_OP_JEQ: {
         abort ();
         break;
@@ -1161,7 +1399,7 @@ static bool stream_normalize (char * __restrict data, uint32_t * __restrict off,
         ops++;
         break;
       }
-      case DDS_OP_RTS: case DDS_OP_JEQ: {
+      case DDS_OP_RTS: case DDS_OP_JEQ: case DDS_OP_BLK: {
         abort ();
         break;
       }
@@ -1428,7 +1666,7 @@ void dds_stream_read_sample (dds_istream_t * __restrict is, void * __restrict da
       dds_stream_free_sample (data, desc->m_ops);
       memset (data, 0, desc->m_size);
     }
-    dds_stream_read (is, data, desc->m_ops);
+    dds_stream_read (is, data, topic->opt_ops ? topic->opt_ops : desc->m_ops);
   }
 }
 
@@ -1438,7 +1676,7 @@ void dds_stream_write_sample (dds_ostream_t * __restrict os, const void * __rest
   if (topic->opt_size && desc->m_align && (os->m_index % desc->m_align) == 0)
     dds_os_put_bytes (os, data, desc->m_size);
   else
-    dds_stream_write (os, data, desc->m_ops);
+    dds_stream_write (os, data, topic->opt_ops ? topic->opt_ops : desc->m_ops);
 }
 
 void dds_stream_read_key (dds_istream_t * __restrict is, char * __restrict sample, const struct ddsi_sertopic_default * __restrict topic)
@@ -1827,7 +2065,7 @@ static void dds_stream_extract_key_from_data1 (dds_istream_t * __restrict is, dd
         ops++;
         break;
       }
-      case DDS_OP_RTS: case DDS_OP_JEQ: {
+      case DDS_OP_RTS: case DDS_OP_JEQ: case DDS_OP_BLK: {
         abort ();
         break;
       }
@@ -1883,7 +2121,7 @@ static void dds_stream_extract_keyBE_from_data1 (dds_istream_t * __restrict is,
         ops++;
         break;
       }
-      case DDS_OP_RTS: case DDS_OP_JEQ: {
+      case DDS_OP_RTS: case DDS_OP_JEQ: case DDS_OP_BLK: {
         abort ();
         break;
       }
@@ -2217,7 +2455,7 @@ static bool dds_stream_print_sample1 (char * __restrict *buf, size_t * __restric
         ops++;
         break;
       }
-      case DDS_OP_RTS: case DDS_OP_JEQ: {
+      case DDS_OP_RTS: case DDS_OP_JEQ: case DDS_OP_BLK: {
         abort ();
         break;
       }
@@ -141,7 +141,7 @@ dds_return_t deliver_locally_one (struct ddsi_domaingv *gv, struct entity_common
 
   struct ddsi_serdata *payload;
   struct ddsi_tkmap_instance *tk;
-  if ((payload = ops->makesample (&tk, gv, rd->topic, vsourceinfo)) != NULL)
+  if ((payload = ops->makesample (&tk, gv, rd, vsourceinfo)) != NULL)
   {
     EETRACE (source_entity, " =>"PGUIDFMT"\n", PGUID (*rdguid));
     /* FIXME: why look up rd,pwr again? Their states remains valid while the thread stays
@@ -191,7 +191,7 @@ static dds_return_t deliver_locally_slowpath (struct ddsi_domaingv *gv, struct e
     struct ddsi_tkmap_instance *tk;
     if (!topic_sample_cache_lookup (&payload, &tk, &tsc, rd->topic))
     {
-      payload = ops->makesample (&tk, gv, rd->topic, vsourceinfo);
+      payload = ops->makesample (&tk, gv, rd, vsourceinfo);
       topic_sample_cache_store (&tsc, rd->topic, payload, tk);
     }
     /* check payload to allow for deserialisation failures */
@@ -218,7 +218,7 @@ static dds_return_t deliver_locally_fastpath (struct ddsi_domaingv *gv, struct e
     struct ddsi_sertopic const * const topic = rdary[i]->topic;
     struct ddsi_serdata *payload;
     struct ddsi_tkmap_instance *tk;
-    if ((payload = ops->makesample (&tk, gv, topic, vsourceinfo)) == NULL)
+    if ((payload = ops->makesample (&tk, gv, rdary[i], vsourceinfo)) == NULL)
     {
       /* malformed payload: skip all readers with the same topic */
       while (rdary[++i] && rdary[i]->topic == topic)
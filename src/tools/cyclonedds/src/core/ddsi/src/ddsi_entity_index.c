@@ -15,6 +15,8 @@
 
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/misc.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/threads.h"
 
 #include "dds/ddsrt/hopscotch.h"
 #include "dds/ddsrt/avl.h"
@@ -39,6 +41,28 @@ static const uint64_t unihashconsts[] = {
   UINT64_C (16728792139623414127)
 };
 
+/* Small direct-mapped per-thread cache of successful GUID lookups, primarily for the
+   receive threads, which typically look up the same few writers/readers/proxies for
+   every submessage. An entry is only valid as long as no entity has been removed
+   from any entity index since it was filled: the removal count is incremented after
+   removing the entity from the hash table and before it can be freed, so if it is
+   unchanged, the entity is still there (or in the process of being removed, in which
+   case it can't be freed while the thread remains awake).  Removals are rare enough
+   that one counter for the whole process suffices, and it also prevents a stale hit
+   on a new index that happens to be allocated at the same address. */
+struct guid_cache_entry {
+  ddsi_guid_t guid;
+  const struct entity_index *ei;
+  struct entity_common *e;
+  uint32_t removals;
+};
+
+#define GUID_CACHE_BITS 6
+#define GUID_CACHE_SIZE (1u << GUID_CACHE_BITS)
+
+static ddsrt_atomic_uint32_t entidx_removals = DDSRT_ATOMIC_UINT32_INIT (1);
+static ddsrt_thread_local struct guid_cache_entry guid_cache[GUID_CACHE_SIZE];
+
 static int all_entities_compare (const void *va, const void *vb);
 static const ddsrt_avl_treedef_t all_entities_treedef =
   DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct entity_common, all_entities_avlnode), 0, all_entities_compare, 0);
@@ -58,6 +82,14 @@ static uint32_t hash_entity_guid_wrapper (const void *c)
   return hash_entity_guid (c);
 }
 
+static uint32_t guid_cache_index (const ddsi_guid_t *guid)
+{
+  /* The first two words of the prefix are mostly the same for all entities in a process,
+     the last one differs between participants, the entity id between its entities (with
+     the kind in the low-order bits); a single multiply mixes that well enough */
+  return ((guid->prefix.u[2] ^ guid->entityid.u) * UINT32_C (2654435761)) >> (32 - GUID_CACHE_BITS);
+}
+
 static int entity_guid_eq (const struct entity_common *a, const struct entity_common *b)
 {
   return
@@ -222,6 +254,7 @@ void entity_index_free (struct entity_index *entidx)
   ddsrt_mutex_destroy (&entidx->all_entities_lock);
   ddsrt_chh_free (entidx->guid_hash);
   entidx->guid_hash = NULL;
+  ddsrt_atomic_inc32 (&entidx_removals);
   ddsrt_free (entidx);
 }
 
@@ -257,15 +290,32 @@ static void entity_index_remove (struct entity_index *ei, struct entity_common *
   x = ddsrt_chh_remove (ei->guid_hash, e);
   (void)x;
   assert (x);
+  /* invalidates cached lookups, must follow the removal */
+  ddsrt_atomic_fence_rel ();
+  ddsrt_atomic_inc32 (&entidx_removals);
 }
 
 void *entidx_lookup_guid_untyped (const struct entity_index *ei, const struct ddsi_guid *guid)
 {
   /* FIXME: could (now) require guid to be first in entity_common; entity_common already is first in entity */
-  struct entity_common e;
-  e.guid = *guid;
+  struct entity_common e, *res;
   assert (thread_is_awake ());
-  return ddsrt_chh_lookup (ei->guid_hash, &e);
+  const uint32_t removals = ddsrt_atomic_ld32 (&entidx_removals);
+  ddsrt_atomic_fence_acq ();
+  struct guid_cache_entry * const ce = &guid_cache[guid_cache_index (guid)];
+  if (ce->removals == removals && ce->ei == ei &&
+      ce->guid.entityid.u == guid->entityid.u && ce->guid.prefix.u[2] == guid->prefix.u[2] &&
+      ce->guid.prefix.u[1] == guid->prefix.u[1] && ce->guid.prefix.u[0] == guid->prefix.u[0])
+    return ce->e;
+  e.guid = *guid;
+  if ((res = ddsrt_chh_lookup (ei->guid_hash, &e)) != NULL)
+  {
+    ce->guid = *guid;
+    ce->ei = ei;
+    ce->e = res;
+    ce->removals = removals;
+  }
+  return res;
 }
 
 static void *entidx_lookup_guid_int (const struct entity_index *ei, const struct ddsi_guid *guid, enum entity_kind kind)
@@ -16,6 +16,7 @@
 #include "dds/ddsi/ddsi_statistics.h"
 #include "dds/ddsi/q_entity.h"
 #include "dds/ddsi/q_radmin.h"
+#include "dds/ddsi/q_whc.h"
 
 void ddsi_get_writer_stats (struct writer *wr, uint64_t * __restrict rexmit_bytes, uint32_t * __restrict throttle_count, uint64_t * __restrict time_throttled, uint64_t * __restrict time_retransmit)
 {
@@ -27,6 +28,19 @@ void ddsi_get_writer_stats (struct writer *wr, uint64_t * __restrict rexmit_byte
   ddsrt_mutex_unlock (&wr->e.lock);
 }
 
+void ddsi_get_writer_traffic_stats (struct writer *wr, uint64_t * __restrict samples, uint64_t * __restrict bytes, uint32_t * __restrict rexmit_count, uint32_t * __restrict nacks_received, uint64_t * __restrict whc_unacked_bytes)
+{
+  struct whc_state whcst;
+  ddsrt_mutex_lock (&wr->e.lock);
+  *samples = (uint64_t) wr->seq;
+  *bytes = wr->write_bytes;
+  *rexmit_count = wr->rexmit_count;
+  *nacks_received = wr->num_nacks_received;
+  whc_get_state (wr->whc, &whcst);
+  *whc_unacked_bytes = whcst.unacked_bytes;
+  ddsrt_mutex_unlock (&wr->e.lock);
+}
+
 void ddsi_get_reader_stats (struct reader *rd, uint64_t * __restrict discarded_bytes)
 {
   struct rd_pwr_match *m;
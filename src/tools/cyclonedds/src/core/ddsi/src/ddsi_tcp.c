@@ -24,6 +24,7 @@
 #include "dds/ddsi/q_config.h"
 #include "dds/ddsi/q_log.h"
 #include "dds/ddsi/q_entity.h"
+#include "dds/ddsi/q_thread.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 #include "dds/ddsi/ddsi_ssl.h"
 
@@ -38,6 +39,11 @@
   is not removed from cache but simply flagged as failed (may be subsequently
   replaced). Similarly server side sockets are not closed as are also used in socket
   wait set that manages their lifecycle.
+
+  If TCP/CoalesceDelay is set, small messages are appended to m_wbuf instead of
+  being written immediately, and the connection is queued (holding a reference)
+  on the factory's flush queue. The flush thread writes out the buffer once the
+  delay has expired, unless a write that doesn't fit has done so already.
 */
 
 union addr {
@@ -57,6 +63,11 @@ typedef struct ddsi_tcp_conn {
 #ifdef DDSI_INCLUDE_SSL
   SSL * m_ssl;
 #endif
+  char *m_wbuf;
+  size_t m_wbuf_len;
+  bool m_flush_queued;
+  ddsrt_mtime_t m_flush_tsched;
+  struct ddsi_tcp_conn *m_flush_next;
 } *ddsi_tcp_conn_t;
 
 typedef struct ddsi_tcp_listener {
@@ -75,6 +86,11 @@ struct ddsi_tran_factory_tcp {
 #ifdef DDSI_INCLUDE_SSL
   struct ddsi_ssl_plugins ddsi_tcp_ssl_plugin;
 #endif
+  ddsrt_mutex_t flush_lock;
+  ddsrt_cond_t flush_cond;
+  struct ddsi_tcp_conn *flush_first, *flush_last;
+  bool flush_stop;
+  struct thread_state1 *flush_ts;
 };
 
 static int ddsi_tcp_cmp_conn (const struct ddsi_tcp_conn *c1, const struct ddsi_tcp_conn *c2)
@@ -107,6 +123,7 @@ static const ddsrt_avl_treedef_t ddsi_tcp_treedef = DDSRT_AVL_TREEDEF_INITIALIZE
 );
 
 static ddsi_tcp_conn_t ddsi_tcp_new_conn (struct ddsi_tran_factory_tcp *fact, ddsrt_socket_t, bool, struct sockaddr *);
+static void ddsi_tcp_conn_delete (ddsi_tcp_conn_t conn);
 
 static char *sockaddr_to_string_with_port (struct ddsi_tran_factory_tcp *fact, char *dst, size_t sizeof_dst, const struct sockaddr *src)
 {
@@ -225,7 +242,7 @@ static dds_return_t ddsi_tcp_sock_new (struct ddsi_tran_factory_tcp * const fact
   }
 #endif
 #ifdef TCP_NODELAY
-  if (gv->config.tcp_nodelay && (rc = ddsrt_setsockopt (*sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one))) != DDS_RETCODE_OK)
+  if ((gv->config.tcp_nodelay || gv->config.tcp_coalesce_delay > 0) && (rc = ddsrt_setsockopt (*sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one))) != DDS_RETCODE_OK)
   {
     GVERROR ("ddsi_tcp_sock_new: failed to set NODELAY: %s\n", dds_strretcode (rc));
     goto fail_w_socket;
@@ -592,66 +609,33 @@ static void set_msghdr_iov (ddsrt_msghdr_t *mhdr, ddsrt_iovec_t *iov, size_t iov
   mhdr->msg_iovlen = (ddsrt_msg_iovlen_t)iovlen;
 }
 
-static ssize_t ddsi_tcp_conn_write (ddsi_tran_conn_t base, const nn_locator_t *dst, size_t niov, const ddsrt_iovec_t *iov, uint32_t flags)
+static void ddsi_tcp_set_cork (ddsi_tcp_conn_t conn, bool cork)
 {
-  struct ddsi_tran_factory_tcp * const fact = (struct ddsi_tran_factory_tcp *) base->m_factory;
+#ifdef TCP_CORK
+  /* With TCP_NODELAY set, each piece of a write that can't be done in one go would
+     otherwise be sent as a separate segment */
+  const int val = cork;
+  (void) ddsrt_setsockopt (conn->m_sock, IPPROTO_TCP, TCP_CORK, &val, sizeof (val));
+#else
+  (void) conn;
+  (void) cork;
+#endif
+}
+
+static ssize_t ddsi_tcp_conn_send_locked (ddsi_tcp_conn_t conn, size_t niov, const ddsrt_iovec_t *iov, size_t len)
+{
+  struct ddsi_tran_factory_tcp * const fact = (struct ddsi_tran_factory_tcp *) conn->m_base.m_factory;
   struct ddsi_domaingv const * const gv = fact->fact.gv;
 #ifdef DDSI_INCLUDE_SSL
   char msgbuf[4096]; /* stack buffer for merging smallish writes without requiring allocations */
   ddsrt_iovec_t iovec; /* iovec used for msgbuf */
 #endif
   ssize_t ret = -1;
-  size_t len;
-  ddsi_tcp_conn_t conn;
   int piecewise;
-  bool connect = false;
+  bool cork = false;
   ddsrt_msghdr_t msg;
-  union {
-    struct sockaddr_storage x;
-    union addr a;
-  } dstaddr;
-  assert(niov <= INT_MAX);
-  ddsi_ipaddr_from_loc(&dstaddr.x, dst);
-  memset(&msg, 0, sizeof(msg));
+  memset (&msg, 0, sizeof (msg));
   set_msghdr_iov (&msg, (ddsrt_iovec_t *) iov, niov);
-  msg.msg_name = &dstaddr;
-  msg.msg_namelen = ddsrt_sockaddr_get_size(&dstaddr.a.a);
-#if DDSRT_MSGHDR_FLAGS
-  msg.msg_flags = (int) flags;
-#endif
-  len = iovlen_sum (niov, iov);
-  (void) base;
-
-  conn = ddsi_tcp_cache_find (fact, &msg);
-  if (conn == NULL)
-  {
-    return -1;
-  }
-
-  ddsrt_mutex_lock (&conn->m_mutex);
-
-  /* If not connected attempt to conect */
-
-  if (conn->m_sock == DDSRT_INVALID_SOCKET)
-  {
-    assert (!conn->m_base.m_server);
-    ddsi_tcp_conn_connect (conn, &msg);
-    if (conn->m_sock == DDSRT_INVALID_SOCKET)
-    {
-      ddsrt_mutex_unlock (&conn->m_mutex);
-      return -1;
-    }
-    connect = true;
-  }
-
-  /* Check if filtering out message from existing connections */
-
-  if (!connect && ((flags & DDSI_TRAN_ON_CONNECT) != 0))
-  {
-    GVLOG (DDS_LC_TCP, "tcp write: sock %"PRIdSOCK" message filtered\n", conn->m_sock);
-    ddsrt_mutex_unlock (&conn->m_mutex);
-    return (ssize_t) len;
-  }
 
 #ifdef DDSI_INCLUDE_SSL
   if (gv->config.ssl_enable)
@@ -677,6 +661,8 @@ static ssize_t ddsi_tcp_conn_write (ddsi_tran_conn_t base, const nn_locator_t *d
     }
     piecewise = 1;
     ret = 0;
+    /* more than a single maximum-size TLS record */
+    cork = (len > 16384);
   }
   else
 #endif
@@ -686,8 +672,6 @@ static ssize_t ddsi_tcp_conn_write (ddsi_tran_conn_t base, const nn_locator_t *d
 #ifdef MSG_NOSIGNAL
     sendflags |= MSG_NOSIGNAL;
 #endif
-    msg.msg_name = NULL;
-    msg.msg_namelen = 0;
     do
     {
       rc = ddsrt_sendmsg (conn->m_sock, &msg, sendflags, &ret);
@@ -724,6 +708,7 @@ static ssize_t ddsi_tcp_conn_write (ddsi_tran_conn_t base, const nn_locator_t *d
       }
       piecewise = (ret > 0 && (size_t) ret < len);
     }
+    cork = piecewise && (msg.msg_iovlen > 1);
   }
 
   if (piecewise)
@@ -737,6 +722,8 @@ static ssize_t ddsi_tcp_conn_write (ddsi_tran_conn_t base, const nn_locator_t *d
     }
 #endif
 
+    if (cork)
+      ddsi_tcp_set_cork (conn, true);
     assert (msg.msg_iov[i].iov_len > 0);
     while (ret >= (ssize_t) msg.msg_iov[i].iov_len)
     {
@@ -748,6 +735,11 @@ static ssize_t ddsi_tcp_conn_write (ddsi_tran_conn_t base, const nn_locator_t *d
     {
       ret = ddsi_tcp_block_write (wr, conn, msg.msg_iov[i].iov_base, msg.msg_iov[i].iov_len);
     }
+    if (cork)
+      ddsi_tcp_set_cork (conn, false);
+    /* block_write returns the size of the last piece */
+    if (ret > 0)
+      ret = (ssize_t) len;
   }
 
 #ifdef DDSI_INCLUDE_SSL
@@ -758,6 +750,183 @@ static ssize_t ddsi_tcp_conn_write (ddsi_tran_conn_t base, const nn_locator_t *d
   }
 #endif
 
+  return ret;
+}
+
+static void ddsi_tcp_conn_unref (ddsi_tcp_conn_t conn)
+{
+  /* the flush queue's reference is not the one that determines whether the connection is open */
+  if (ddsrt_atomic_dec32_ov (&conn->m_base.m_count) == 1)
+    ddsi_tcp_conn_delete (conn);
+}
+
+static void ddsi_tcp_flush_enqueue (struct ddsi_tran_factory_tcp *fact, ddsi_tcp_conn_t conn)
+{
+  /* conn->m_mutex must be held; the queue holds a reference until the flush thread is done with it */
+  ddsrt_atomic_inc32 (&conn->m_base.m_count);
+  conn->m_flush_queued = true;
+  conn->m_flush_tsched = ddsrt_mtime_add_duration (ddsrt_time_monotonic (), fact->fact.gv->config.tcp_coalesce_delay);
+  conn->m_flush_next = NULL;
+  ddsrt_mutex_lock (&fact->flush_lock);
+  if (fact->flush_first == NULL)
+  {
+    /* deadlines are all the same distance in the future, so only an empty queue needs a wakeup */
+    fact->flush_first = conn;
+    ddsrt_cond_broadcast (&fact->flush_cond);
+  }
+  else
+  {
+    fact->flush_last->m_flush_next = conn;
+  }
+  fact->flush_last = conn;
+  ddsrt_mutex_unlock (&fact->flush_lock);
+}
+
+static ssize_t ddsi_tcp_conn_coalesce_locked (ddsi_tcp_conn_t conn, size_t niov, const ddsrt_iovec_t *iov, size_t len)
+{
+  struct ddsi_tran_factory_tcp * const fact = (struct ddsi_tran_factory_tcp *) conn->m_base.m_factory;
+  const size_t bufsize = fact->fact.gv->config.tcp_coalesce_size;
+  if (conn->m_wbuf_len + len <= bufsize)
+  {
+    if (conn->m_wbuf == NULL)
+      conn->m_wbuf = ddsrt_malloc (bufsize);
+    for (size_t i = 0; i < niov; i++)
+    {
+      memcpy (conn->m_wbuf + conn->m_wbuf_len, iov[i].iov_base, iov[i].iov_len);
+      conn->m_wbuf_len += iov[i].iov_len;
+    }
+    if (!conn->m_flush_queued)
+      ddsi_tcp_flush_enqueue (fact, conn);
+    return (ssize_t) len;
+  }
+  else if (conn->m_wbuf_len == 0)
+  {
+    return ddsi_tcp_conn_send_locked (conn, niov, iov, len);
+  }
+  else
+  {
+    /* Doesn't fit: the messages held back go out first, but in the same write; the
+       flush thread will find an empty buffer and ignore the connection */
+    ddsrt_iovec_t iovbuf[16], *iovs;
+    const size_t n = conn->m_wbuf_len;
+    ssize_t ret;
+    iovs = (niov < sizeof (iovbuf) / sizeof (iovbuf[0])) ? iovbuf : ddsrt_malloc ((niov + 1) * sizeof (*iovs));
+    iovs[0].iov_base = conn->m_wbuf;
+    iovs[0].iov_len = (ddsrt_iov_len_t) n;
+    memcpy (iovs + 1, iov, niov * sizeof (*iov));
+    conn->m_wbuf_len = 0;
+    ret = ddsi_tcp_conn_send_locked (conn, niov + 1, iovs, n + len);
+    if (iovs != iovbuf)
+      ddsrt_free (iovs);
+    return (ret == -1) ? -1 : (ssize_t) len;
+  }
+}
+
+static uint32_t ddsi_tcp_flush_thread (struct ddsi_tran_factory_tcp *fact)
+{
+  ddsrt_mutex_lock (&fact->flush_lock);
+  while (!fact->flush_stop || fact->flush_first)
+  {
+    ddsi_tcp_conn_t conn = fact->flush_first;
+    if (conn == NULL)
+    {
+      ddsrt_cond_wait (&fact->flush_cond, &fact->flush_lock);
+      continue;
+    }
+    const ddsrt_mtime_t tnow = ddsrt_time_monotonic ();
+    if (!fact->flush_stop && conn->m_flush_tsched.v > tnow.v)
+    {
+      (void) ddsrt_cond_waitfor (&fact->flush_cond, &fact->flush_lock, conn->m_flush_tsched.v - tnow.v);
+      continue;
+    }
+    if ((fact->flush_first = conn->m_flush_next) == NULL)
+      fact->flush_last = NULL;
+    ddsrt_mutex_unlock (&fact->flush_lock);
+
+    ssize_t ret = 0;
+    ddsrt_mutex_lock (&conn->m_mutex);
+    conn->m_flush_queued = false;
+    if (conn->m_wbuf_len > 0 && conn->m_sock != DDSRT_INVALID_SOCKET && !conn->m_base.m_closed)
+    {
+      ddsrt_iovec_t iov;
+      iov.iov_base = conn->m_wbuf;
+      iov.iov_len = (ddsrt_iov_len_t) conn->m_wbuf_len;
+      ret = ddsi_tcp_conn_send_locked (conn, 1, &iov, conn->m_wbuf_len);
+    }
+    conn->m_wbuf_len = 0;
+    ddsrt_mutex_unlock (&conn->m_mutex);
+    if (ret == -1)
+    {
+      ddsi_tcp_cache_remove (conn);
+    }
+    ddsi_tcp_conn_unref (conn);
+    ddsrt_mutex_lock (&fact->flush_lock);
+  }
+  ddsrt_mutex_unlock (&fact->flush_lock);
+  return 0;
+}
+
+static ssize_t ddsi_tcp_conn_write (ddsi_tran_conn_t base, const nn_locator_t *dst, size_t niov, const ddsrt_iovec_t *iov, uint32_t flags)
+{
+  struct ddsi_tran_factory_tcp * const fact = (struct ddsi_tran_factory_tcp *) base->m_factory;
+  struct ddsi_domaingv const * const gv = fact->fact.gv;
+  ssize_t ret = -1;
+  size_t len;
+  ddsi_tcp_conn_t conn;
+  bool connect = false;
+  ddsrt_msghdr_t msg;
+  union {
+    struct sockaddr_storage x;
+    union addr a;
+  } dstaddr;
+  assert(niov <= INT_MAX);
+  ddsi_ipaddr_from_loc(&dstaddr.x, dst);
+  memset(&msg, 0, sizeof(msg));
+  set_msghdr_iov (&msg, (ddsrt_iovec_t *) iov, niov);
+  msg.msg_name = &dstaddr;
+  msg.msg_namelen = ddsrt_sockaddr_get_size(&dstaddr.a.a);
+#if DDSRT_MSGHDR_FLAGS
+  msg.msg_flags = (int) flags;
+#endif
+  len = iovlen_sum (niov, iov);
+  (void) base;
+
+  conn = ddsi_tcp_cache_find (fact, &msg);
+  if (conn == NULL)
+  {
+    return -1;
+  }
+
+  ddsrt_mutex_lock (&conn->m_mutex);
+
+  /* If not connected attempt to conect */
+
+  if (conn->m_sock == DDSRT_INVALID_SOCKET)
+  {
+    assert (!conn->m_base.m_server);
+    ddsi_tcp_conn_connect (conn, &msg);
+    if (conn->m_sock == DDSRT_INVALID_SOCKET)
+    {
+      ddsrt_mutex_unlock (&conn->m_mutex);
+      return -1;
+    }
+    connect = true;
+  }
+
+  /* Check if filtering out message from existing connections */
+
+  if (!connect && ((flags & DDSI_TRAN_ON_CONNECT) != 0))
+  {
+    GVLOG (DDS_LC_TCP, "tcp write: sock %"PRIdSOCK" message filtered\n", conn->m_sock);
+    ddsrt_mutex_unlock (&conn->m_mutex);
+    return (ssize_t) len;
+  }
+
+  if (gv->config.tcp_coalesce_delay > 0)
+    ret = ddsi_tcp_conn_coalesce_locked (conn, niov, iov, len);
+  else
+    ret = ddsi_tcp_conn_send_locked (conn, niov, iov, len);
+
   ddsrt_mutex_unlock (&conn->m_mutex);
 
   if (ret == -1)
@@ -1003,6 +1172,7 @@ static void ddsi_tcp_conn_delete (ddsi_tcp_conn_t conn)
     ddsi_tcp_sock_free (gv, conn->m_sock, "connection");
   }
   ddsrt_mutex_destroy (&conn->m_mutex);
+  ddsrt_free (conn->m_wbuf);
   ddsrt_free (conn);
 }
 
@@ -1102,6 +1272,18 @@ static void ddsi_tcp_release_factory (struct ddsi_tran_factory *fact_cmn)
 {
   struct ddsi_tran_factory_tcp * const fact = (struct ddsi_tran_factory_tcp *) fact_cmn;
   struct ddsi_domaingv const * const gv = fact->fact.gv;
+  if (fact->flush_ts)
+  {
+    /* the flush thread writes whatever is still pending before it stops */
+    ddsrt_mutex_lock (&fact->flush_lock);
+    fact->flush_stop = true;
+    ddsrt_cond_broadcast (&fact->flush_cond);
+    ddsrt_mutex_unlock (&fact->flush_lock);
+    join_thread (fact->flush_ts);
+  }
+  assert (fact->flush_first == NULL);
+  ddsrt_cond_destroy (&fact->flush_cond);
+  ddsrt_mutex_destroy (&fact->flush_lock);
   ddsrt_avl_free (&ddsi_tcp_treedef, &fact->ddsi_tcp_cache_g, ddsi_tcp_node_free);
   ddsrt_mutex_destroy (&fact->ddsi_tcp_cache_lock_g);
 #ifdef DDSI_INCLUDE_SSL
@@ -1155,6 +1337,8 @@ int ddsi_tcp_init (struct ddsi_domaingv *gv)
   struct ddsi_tran_factory_tcp *fact = ddsrt_malloc (sizeof (*fact));
 
   memset (fact, 0, sizeof (*fact));
+  ddsrt_mutex_init (&fact->flush_lock);
+  ddsrt_cond_init (&fact->flush_cond);
   fact->fact.gv = gv;
   fact->fact.m_kind = NN_LOCATOR_KIND_TCPv4;
   fact->fact.m_typename = "tcp";
@@ -1204,6 +1388,15 @@ int ddsi_tcp_init (struct ddsi_domaingv *gv)
   ddsrt_avl_init (&ddsi_tcp_treedef, &fact->ddsi_tcp_cache_g);
   ddsrt_mutex_init (&fact->ddsi_tcp_cache_lock_g);
 
+  if (gv->config.tcp_coalesce_delay > 0)
+  {
+    if (create_thread (&fact->flush_ts, gv, "tcp_flush", (uint32_t (*) (void *)) ddsi_tcp_flush_thread, fact) != DDS_RETCODE_OK)
+    {
+      GVERROR ("Failed to create TCP flush thread\n");
+      return -1;
+    }
+  }
+
   GVLOG (DDS_LC_CONFIG, "tcp initialized\n");
   return 0;
 }
@@ -0,0 +1,208 @@
+/*
+ * Copyright(c) 2020 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "dds/ddsi/ddsi_timerwheel.h"
+
+/* Invariant: a node in level L has a due tick D > cur that agrees with cur in all bits
+   above level L, but not in the bits of level L itself (unless L = 0), so that its slot
+   is beyond the slot of cur in that level.  The first occupied slot of the lowest
+   occupied level therefore holds the earliest nodes, and advancing cur to the start
+   of that slot, then redistributing its nodes over the lower levels, maintains it. */
+
+static ddsi_timerwheel_node_t *node_of (const ddsi_timerwheel_def_t *twdef, const void *vnode)
+{
+  return (ddsi_timerwheel_node_t *) ((char *) vnode + twdef->offset);
+}
+
+static void *object_of (const ddsi_timerwheel_def_t *twdef, const ddsi_timerwheel_node_t *node)
+{
+  return (char *) node - twdef->offset;
+}
+
+static int64_t due_tick (const ddsi_timerwheel_def_t *twdef, const ddsi_timerwheel_t *tw, const ddsi_timerwheel_node_t *node)
+{
+  int64_t key;
+  memcpy (&key, (const char *) object_of (twdef, node) + twdef->keyoffset, sizeof (key));
+  if (key < 0)
+    return INT64_MIN;
+  return key / tw->tick + ((key % tw->tick) != 0);
+}
+
+static unsigned first_slot (uint64_t occupied)
+{
+  assert (occupied != 0);
+#if defined __GNUC__
+  return (unsigned) __builtin_ctzll (occupied);
+#else
+  unsigned s = 0;
+  while (!(occupied & 1))
+  {
+    occupied >>= 1;
+    s++;
+  }
+  return s;
+#endif
+}
+
+static int lowest_occupied_level (const ddsi_timerwheel_t *tw)
+{
+  for (int l = 0; l < DDSI_TIMERWHEEL_LEVELS; l++)
+    if (tw->occupied[l])
+      return l;
+  return -1;
+}
+
+static int64_t slot_start (int64_t cur, int level, unsigned slot)
+{
+  const unsigned shift = DDSI_TIMERWHEEL_BITS * (unsigned) level;
+  const unsigned hishift = shift + DDSI_TIMERWHEEL_BITS;
+  const uint64_t hi = (hishift >= 64) ? 0 : ((uint64_t) cur >> hishift) << hishift;
+  return (int64_t) (hi | ((uint64_t) slot << shift));
+}
+
+static void push (ddsi_timerwheel_node_t **head, ddsi_timerwheel_node_t *node)
+{
+  node->next = *head;
+  if (*head)
+    (*head)->pprev = &node->next;
+  node->pprev = head;
+  *head = node;
+}
+
+static void place (ddsi_timerwheel_t *tw, ddsi_timerwheel_node_t *node, int64_t d)
+{
+  if (d <= tw->cur)
+  {
+    node->level = -1;
+    node->slot = 0;
+    push (&tw->due, node);
+    return;
+  }
+
+  const uint64_t ud = (uint64_t) d, ucur = (uint64_t) tw->cur;
+  int l;
+  for (l = 0; l < DDSI_TIMERWHEEL_LEVELS - 1; l++)
+  {
+    const unsigned hishift = DDSI_TIMERWHEEL_BITS * (unsigned) (l + 1);
+    if ((ud >> hishift) == (ucur >> hishift))
+      break;
+  }
+  const unsigned slot = (unsigned) (ud >> (DDSI_TIMERWHEEL_BITS * (unsigned) l)) & (DDSI_TIMERWHEEL_SLOTS - 1);
+  node->level = (int16_t) l;
+  node->slot = (uint16_t) slot;
+  push (&tw->slots[l][slot], node);
+  tw->occupied[l] |= (uint64_t) 1 << slot;
+}
+
+static void unlink_node (ddsi_timerwheel_t *tw, ddsi_timerwheel_node_t *node)
+{
+  *node->pprev = node->next;
+  if (node->next)
+    node->next->pprev = node->pprev;
+  if (node->level >= 0 && tw->slots[node->level][node->slot] == NULL)
+    tw->occupied[node->level] &= ~((uint64_t) 1 << node->slot);
+}
+
+static void advance (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw, int64_t n)
+{
+  while (tw->cur < n)
+  {
+    const int l = lowest_occupied_level (tw);
+    if (l < 0)
+    {
+      tw->cur = n;
+      break;
+    }
+    const unsigned s = first_slot (tw->occupied[l]);
+    const int64_t start = slot_start (tw->cur, l, s);
+    assert (start > tw->cur);
+    if (start > n)
+    {
+      /* nothing in between, so cur agrees with all nodes in the same bits as before */
+      tw->cur = n;
+      break;
+    }
+    tw->cur = start;
+    ddsi_timerwheel_node_t *list = tw->slots[l][s];
+    tw->slots[l][s] = NULL;
+    tw->occupied[l] &= ~((uint64_t) 1 << s);
+    while (list)
+    {
+      ddsi_timerwheel_node_t *node = list;
+      list = node->next;
+      place (tw, node, due_tick (twdef, tw, node));
+    }
+  }
+}
+
+void ddsi_timerwheel_init (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw, int64_t tick, int64_t tnow)
+{
+  (void) twdef;
+  assert (tick > 0 && tnow >= 0);
+  memset (tw, 0, sizeof (*tw));
+  tw->tick = tick;
+  tw->cur = tnow / tick;
+  tw->due = NULL;
+}
+
+void ddsi_timerwheel_insert (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw, void *vnode)
+{
+  ddsi_timerwheel_node_t *node = node_of (twdef, vnode);
+  place (tw, node, due_tick (twdef, tw, node));
+}
+
+void ddsi_timerwheel_delete (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw, void *vnode)
+{
+  unlink_node (tw, node_of (twdef, vnode));
+}
+
+int64_t ddsi_timerwheel_next (const ddsi_timerwheel_def_t *twdef, const ddsi_timerwheel_t *tw)
+{
+  (void) twdef;
+  if (tw->due)
+    return INT64_MIN;
+  const int l = lowest_occupied_level (tw);
+  if (l < 0)
+    return INT64_MAX;
+  const int64_t start = slot_start (tw->cur, l, first_slot (tw->occupied[l]));
+  return (start > INT64_MAX / tw->tick) ? INT64_MAX : start * tw->tick;
+}
+
+void *ddsi_timerwheel_extract_due (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw, int64_t tnow)
+{
+  if (tw->due == NULL)
+  {
+    advance (twdef, tw, tnow / tw->tick);
+    if (tw->due == NULL)
+      return NULL;
+  }
+  ddsi_timerwheel_node_t *node = tw->due;
+  unlink_node (tw, node);
+  return object_of (twdef, node);
+}
+
+void *ddsi_timerwheel_extract_any (const ddsi_timerwheel_def_t *twdef, ddsi_timerwheel_t *tw)
+{
+  ddsi_timerwheel_node_t *node = tw->due;
+  if (node == NULL)
+  {
+    const int l = lowest_occupied_level (tw);
+    if (l < 0)
+      return NULL;
+    node = tw->slots[l][first_slot (tw->occupied[l])];
+  }
+  unlink_node (tw, node);
+  return object_of (twdef, node);
+}
@@ -211,6 +211,36 @@ void ddsi_tkmap_instance_ref (struct ddsi_tkmap_instance *tk)
   ddsrt_atomic_inc32 (&tk->m_refc);
 }
 
+struct ddsi_tkmap_instance *ddsi_tkmap_lookup_instance_ref_cached (struct ddsi_tkmap *map, ddsrt_atomic_voidp_t *cache, struct ddsi_serdata *sd)
+{
+  struct ddsi_tkmap_instance *tk;
+  if (!sd->topic->topickind_no_key)
+    return ddsi_tkmap_find (map, sd, true);
+  if ((tk = ddsrt_atomic_ldvoidp (cache)) != NULL)
+  {
+    /* the cache's reference keeps it alive, so no need for the REFC_DELETE dance */
+    ddsi_tkmap_instance_ref (tk);
+    return tk;
+  }
+  if ((tk = ddsi_tkmap_find (map, sd, true)) == NULL)
+    return NULL;
+  /* one reference for the cache, unless another thread beat us to it */
+  ddsi_tkmap_instance_ref (tk);
+  if (!ddsrt_atomic_casvoidp (cache, NULL, tk))
+    ddsi_tkmap_instance_unref (map, tk);
+  return tk;
+}
+
+void ddsi_tkmap_cache_fini (struct ddsi_tkmap *map, ddsrt_atomic_voidp_t *cache)
+{
+  struct ddsi_tkmap_instance *tk;
+  if ((tk = ddsrt_atomic_ldvoidp (cache)) != NULL)
+  {
+    ddsrt_atomic_stvoidp (cache, NULL);
+    ddsi_tkmap_instance_unref (map, tk);
+  }
+}
+
 void ddsi_tkmap_instance_unref (struct ddsi_tkmap *map, struct ddsi_tkmap_instance *tk)
 {
   uint32_t old, new;
@@ -9,7 +9,11 @@
  *
  * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
  */
+#if defined __linux__
+#define _GNU_SOURCE /* for recvmmsg, sendmmsg */
+#endif
 #include <assert.h>
+#include <errno.h>
 #include <string.h>
 #include "dds/ddsrt/atomics.h"
 #include "dds/ddsrt/heap.h"
@@ -27,6 +31,14 @@
 #include "dds/ddsi/q_pcap.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 
+#if defined __linux__ && !LWIP_SOCKET
+#define DDSI_UDP_HAVE_MMSG 1
+#define DDSI_UDP_READ_BATCH_MAX 64
+#define DDSI_UDP_WRITE_MULTI_MAX 64
+#else
+#define DDSI_UDP_HAVE_MMSG 0
+#endif
+
 union addr {
   struct sockaddr_storage x;
   struct sockaddr a;
@@ -43,6 +55,7 @@ typedef struct ddsi_udp_conn {
   WSAEVENT m_sockEvent;
 #endif
   int m_diffserv;
+  union addr m_sockname; /* for packet capture */
 } *ddsi_udp_conn_t;
 
 typedef struct ddsi_udp_tran_factory {
@@ -58,6 +71,23 @@ static void addr_to_loc (const struct ddsi_tran_factory *tran, nn_locator_t *dst
   ddsi_ipaddr_to_loc (tran, dst, &src->a, (src->a.sa_family == AF_INET) ? NN_LOCATOR_KIND_UDPv4 : NN_LOCATOR_KIND_UDPv6);
 }
 
+static void received_datagram (ddsi_udp_conn_t conn, const union addr *src, const unsigned char *buf, size_t size, size_t len, bool trunc_flag)
+{
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  if (gv->pcap_fp || gv->pcap_ring)
+    write_pcap_received (gv, ddsrt_time_wallclock (), &src->x, &conn->m_sockname.x, (unsigned char *) buf, size);
+
+  /* Check for udp packet truncation */
+  if (size > len || trunc_flag)
+  {
+    char addrbuf[DDSI_LOCSTRLEN];
+    nn_locator_t tmp;
+    addr_to_loc (conn->m_base.m_factory, &tmp, src);
+    ddsi_locator_to_string (addrbuf, sizeof (addrbuf), &tmp);
+    GVWARNING ("%s => %d truncated to %d\n", addrbuf, (int) size, (int) len);
+  }
+}
+
 static ssize_t ddsi_udp_conn_read (ddsi_tran_conn_t conn_cmn, unsigned char * buf, size_t len, bool allow_spurious, nn_locator_t *srcloc)
 {
   ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
@@ -93,30 +123,12 @@ static ssize_t ddsi_udp_conn_read (ddsi_tran_conn_t conn_cmn, unsigned char * bu
   {
     if (srcloc)
       addr_to_loc (conn->m_base.m_factory, srcloc, &src);
-
-    if (gv->pcap_fp)
-    {
-      union addr dest;
-      socklen_t dest_len = sizeof (dest);
-      if (ddsrt_getsockname (conn->m_sock, &dest.a, &dest_len) != DDS_RETCODE_OK)
-        memset (&dest, 0, sizeof (dest));
-      write_pcap_received (gv, ddsrt_time_wallclock (), &src.x, &dest.x, buf, (size_t) ret);
-    }
-
-    /* Check for udp packet truncation */
 #if DDSRT_MSGHDR_FLAGS
     const bool trunc_flag = (msghdr.msg_flags & MSG_TRUNC) != 0;
 #else
     const bool trunc_flag = false;
 #endif
-    if ((size_t) ret > len || trunc_flag)
-    {
-      char addrbuf[DDSI_LOCSTRLEN];
-      nn_locator_t tmp;
-      addr_to_loc (conn->m_base.m_factory, &tmp, &src);
-      ddsi_locator_to_string (addrbuf, sizeof (addrbuf), &tmp);
-      GVWARNING ("%s => %d truncated to %d\n", addrbuf, (int) ret, (int) len);
-    }
+    received_datagram (conn, &src, buf, (size_t) ret, len, trunc_flag);
   }
   else if (rc != DDS_RETCODE_BAD_PARAMETER && rc != DDS_RETCODE_NO_CONNECTION)
   {
@@ -126,6 +138,67 @@ static ssize_t ddsi_udp_conn_read (ddsi_tran_conn_t conn_cmn, unsigned char * bu
   return ret;
 }
 
+#if DDSI_UDP_HAVE_MMSG
+static int ddsi_udp_conn_read_batch (ddsi_tran_conn_t conn_cmn, struct ddsi_tran_rbuf *bufs, int nbufs)
+{
+  ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  struct mmsghdr msgs[DDSI_UDP_READ_BATCH_MAX];
+  struct iovec iovs[DDSI_UDP_READ_BATCH_MAX];
+  union addr srcs[DDSI_UDP_READ_BATCH_MAX];
+  int n;
+
+  if (nbufs > DDSI_UDP_READ_BATCH_MAX)
+    nbufs = DDSI_UDP_READ_BATCH_MAX;
+  memset (msgs, 0, (size_t) nbufs * sizeof (*msgs));
+  for (int i = 0; i < nbufs; i++)
+  {
+    iovs[i].iov_base = bufs[i].buf;
+    iovs[i].iov_len = bufs[i].len;
+    msgs[i].msg_hdr.msg_name = &srcs[i].x;
+    msgs[i].msg_hdr.msg_namelen = (socklen_t) sizeof (srcs[i]);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  /* block for the first datagram, then take only those already queued */
+  do {
+    n = recvmmsg (conn->m_sock, msgs, (unsigned) nbufs, MSG_WAITFORONE, NULL);
+  } while (n < 0 && errno == EINTR);
+
+  if (n < 0)
+  {
+    /* same as for a single read: a closed socket or an ICMP port unreachable
+       is no reason for complaining */
+    if (errno == EBADF || errno == EFAULT || errno == EINVAL || errno == ENOTSOCK || errno == ECONNREFUSED)
+      return 0;
+    GVERROR ("UDP recvmmsg sock %d: errno %d\n", (int) conn->m_sock, errno);
+    return -1;
+  }
+
+  int m = 0;
+  for (int i = 0; i < n; i++)
+  {
+    /* unlike recvmsg, recvmmsg may return empty datagrams, skip those */
+    if (msgs[i].msg_len == 0)
+      continue;
+    const size_t size = msgs[i].msg_len;
+    received_datagram (conn, &srcs[i], bufs[i].buf, size, bufs[i].len, (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0);
+    addr_to_loc (conn->m_base.m_factory, &bufs[m].srcloc, &srcs[i]);
+    bufs[m].size = size;
+    if (m != i)
+    {
+      /* keep the datagrams at the front, swapping buffers so all remain in use */
+      unsigned char *tmp = bufs[m].buf;
+      bufs[m].buf = bufs[i].buf;
+      bufs[i].buf = tmp;
+    }
+    m++;
+  }
+  return m;
+}
+#endif
+
 static void set_msghdr_iov (ddsrt_msghdr_t *mhdr, const ddsrt_iovec_t *iov, size_t iovlen)
 {
   mhdr->msg_iov = (ddsrt_iovec_t *) iov;
@@ -173,14 +246,8 @@ static ssize_t ddsi_udp_conn_write (ddsi_tran_conn_t conn_cmn, const nn_locator_
     }
 #endif
   } while (rc == DDS_RETCODE_INTERRUPTED || rc == DDS_RETCODE_TRY_AGAIN || (rc == DDS_RETCODE_NOT_ALLOWED && retry-- > 0));
-  if (ret > 0 && gv->pcap_fp)
-  {
-    union addr sa;
-    socklen_t alen = sizeof (sa);
-    if (ddsrt_getsockname (conn->m_sock, &sa.a, &alen) != DDS_RETCODE_OK)
-      memset(&sa, 0, sizeof(sa));
-    write_pcap_sent (gv, ddsrt_time_wallclock (), &sa.x, &msg, (size_t) ret);
-  }
+  if (ret > 0 && (gv->pcap_fp || gv->pcap_ring))
+    write_pcap_sent (gv, ddsrt_time_wallclock (), &conn->m_sockname.x, &msg, (size_t) ret);
   else if (rc != DDS_RETCODE_OK && rc != DDS_RETCODE_NOT_ALLOWED && rc != DDS_RETCODE_NO_CONNECTION)
   {
     char locbuf[DDSI_LOCSTRLEN];
@@ -189,6 +256,63 @@ static ssize_t ddsi_udp_conn_write (ddsi_tran_conn_t conn_cmn, const nn_locator_
   return (rc == DDS_RETCODE_OK) ? ret : -1;
 }
 
+#if DDSI_UDP_HAVE_MMSG
+static size_t ddsi_udp_conn_write_multi (ddsi_tran_conn_t conn_cmn, size_t ndst, const nn_locator_t *dst, size_t niov, const ddsrt_iovec_t *iov, uint32_t flags)
+{
+  ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  struct mmsghdr msgs[DDSI_UDP_WRITE_MULTI_MAX];
+  union addr dstaddrs[DDSI_UDP_WRITE_MULTI_MAX];
+  int sendflags = 0;
+  size_t nsent = 0;
+  assert (niov <= INT_MAX);
+#if MSG_NOSIGNAL
+  sendflags |= MSG_NOSIGNAL;
+#endif
+  (void) flags;
+
+  while (ndst > 0)
+  {
+    const size_t n = (ndst < DDSI_UDP_WRITE_MULTI_MAX) ? ndst : DDSI_UDP_WRITE_MULTI_MAX;
+    memset (msgs, 0, n * sizeof (*msgs));
+    for (size_t i = 0; i < n; i++)
+    {
+      ddsi_ipaddr_from_loc (&dstaddrs[i].x, &dst[i]);
+      set_msghdr_iov (&msgs[i].msg_hdr, iov, niov);
+      msgs[i].msg_hdr.msg_name = &dstaddrs[i].x;
+      msgs[i].msg_hdr.msg_namelen = (socklen_t) ddsrt_sockaddr_get_size (&dstaddrs[i].a);
+    }
+
+    size_t done = 0;
+    while (done < n)
+    {
+      const int ret = sendmmsg (conn->m_sock, msgs + done, (unsigned) (n - done), sendflags);
+      if (ret > 0)
+      {
+        if (gv->pcap_fp || gv->pcap_ring)
+        {
+          for (size_t i = done; i < done + (size_t) ret; i++)
+            write_pcap_sent (gv, ddsrt_time_wallclock (), &conn->m_sockname.x, &msgs[i].msg_hdr, msgs[i].msg_len);
+        }
+        done += (size_t) ret;
+        nsent += (size_t) ret;
+      }
+      else
+      {
+        /* the first remaining one failed: leave retrying and reporting it to
+           the single write, then carry on with the others */
+        if (ddsi_udp_conn_write (conn_cmn, &dst[done], niov, iov, flags) > 0)
+          nsent++;
+        done++;
+      }
+    }
+    dst += n;
+    ndst -= n;
+  }
+  return nsent;
+}
+#endif
+
 static void ddsi_udp_disable_multiplexing (ddsi_tran_conn_t conn_cmn)
 {
 #if defined _WIN32 && !defined WINCE
@@ -512,6 +636,23 @@ static dds_return_t ddsi_udp_create_conn (ddsi_tran_conn_t *conn_out, ddsi_tran_
     }
   }
 
+  if (qos->m_reuse_port)
+  {
+    /* Only Linux spreads unicast packets over the sockets sharing a port,
+       elsewhere the last one bound gets them all */
+    assert (qos->m_purpose == DDSI_TRAN_QOS_RECV_UC);
+#if defined __linux__ && defined SO_REUSEPORT
+    if ((rc = ddsrt_setsockopt (sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof (one))) != DDS_RETCODE_OK)
+    {
+      GVERROR ("ddsi_udp_create_conn: failed to enable port reuse: %s\n", dds_strretcode (rc));
+      goto fail_w_socket;
+    }
+#else
+    GVERROR ("ddsi_udp_create_conn: port reuse is not supported\n");
+    goto fail_w_socket;
+#endif
+  }
+
   if ((rc = set_rcvbuf (gv, sock, &gv->config.socket_min_rcvbuf_size)) < 0)
     goto fail_w_socket;
   if (rc > 0) {
@@ -566,6 +707,13 @@ static dds_return_t ddsi_udp_create_conn (ddsi_tran_conn_t *conn_out, ddsi_tran_
 
   conn->m_sock = sock;
   conn->m_diffserv = qos->m_diffserv;
+  {
+    /* the local address doesn't change once bound, so no need to look it up for every
+       captured packet */
+    socklen_t alen = sizeof (conn->m_sockname);
+    if (ddsrt_getsockname (sock, &conn->m_sockname.a, &alen) != DDS_RETCODE_OK)
+      memset (&conn->m_sockname, 0, sizeof (conn->m_sockname));
+  }
 #if defined _WIN32 && !defined WINCE
   conn->m_sockEvent = WSACreateEvent ();
   WSAEventSelect (conn->m_sock, conn->m_sockEvent, FD_WRITE);
@@ -578,6 +726,10 @@ static dds_return_t ddsi_udp_create_conn (ddsi_tran_conn_t *conn_out, ddsi_tran_
   conn->m_base.m_base.m_handle_fn = ddsi_udp_conn_handle;
 
   conn->m_base.m_read_fn = ddsi_udp_conn_read;
+#if DDSI_UDP_HAVE_MMSG
+  conn->m_base.m_read_batch_fn = ddsi_udp_conn_read_batch;
+  conn->m_base.m_write_multi_fn = ddsi_udp_conn_write_multi;
+#endif
   conn->m_base.m_write_fn = ddsi_udp_conn_write;
   conn->m_base.m_disable_multiplexing_fn = ddsi_udp_disable_multiplexing;
   conn->m_base.m_locator_fn = ddsi_udp_conn_locator;
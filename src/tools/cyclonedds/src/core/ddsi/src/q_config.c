@@ -161,6 +161,7 @@ DUPF(uint32);
 #endif
 DU(natint);
 DU(natint_255);
+DU(recv_shards);
 DUPF(participantIndex);
 DU(dyn_port);
 DUPF(memsize);
@@ -177,12 +178,12 @@ DUPF(retransmit_merging);
 DUPF(sched_class);
 DUPF(maybe_memsize);
 DUPF(maybe_int32);
-#ifdef DDSI_INCLUDE_BANDWIDTH_LIMITING
+DUPF(thread_affinity);
 DUPF(bandwidth);
-#endif
 DUPF(domainId);
 DUPF(transport_selector);
 DUPF(many_sockets_mode);
+DUPF(rbuf_hugepages);
 DU(deaf_mute);
 #ifdef DDSI_INCLUDE_SSL
 DUPF(min_tls_version);
@@ -203,6 +204,7 @@ DI(if_channel);
 #ifdef DDSI_INCLUDE_NETWORK_PARTITIONS
 DI(if_network_partition);
 DI(if_ignored_partition);
+DI(if_unicast_partition);
 DI(if_partition_mapping);
 #endif
 DI(if_peer);
@@ -318,7 +320,6 @@ static const struct unit unittab_memsize[] = {
   { NULL, 0 }
 };
 
-#ifdef DDSI_INCLUDE_BANDWIDTH_LIMITING
 static const struct unit unittab_bandwidth_bps[] = {
   { "b/s", 1 },{ "bps", 1 },
   { "Kib/s", 1024 },{ "Kibps", 1024 },
@@ -347,7 +348,6 @@ static const struct unit unittab_bandwidth_Bps[] = {
   { "GB/s", 1000000000 },{ "GBps", 1000000000 },
   { NULL, 0 }
 };
-#endif
 
 static void free_configured_elements (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem);
 static void free_configured_element (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem);
@@ -681,7 +681,16 @@ static int if_network_partition (struct cfgst *cfgst, void *parent, struct cfgel
 static int if_ignored_partition (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem)
 {
   struct config_ignoredpartition_listelem *new = if_common (cfgst, parent, cfgelem, sizeof(*new));
-  if (if_common (cfgst, parent, cfgelem, sizeof (struct config_ignoredpartition_listelem)) == NULL)
+  if (new == NULL)
+    return -1;
+  new->DCPSPartitionTopic = NULL;
+  return 0;
+}
+
+static int if_unicast_partition (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem)
+{
+  struct config_unicastpartition_listelem *new = if_common (cfgst, parent, cfgelem, sizeof(*new));
+  if (new == NULL)
     return -1;
   new->DCPSPartitionTopic = NULL;
   return 0;
@@ -936,6 +945,10 @@ static const enum many_sockets_mode en_many_sockets_mode_ms[] = {
   MSM_SINGLE_UNICAST, MSM_NO_UNICAST, MSM_MANY_UNICAST, MSM_SINGLE_UNICAST, MSM_MANY_UNICAST, 0 };
 GENERIC_ENUM (many_sockets_mode)
 
+static const char *en_rbuf_hugepages_vs[] = { "none", "transparent", "hugetlb", NULL };
+static const enum rbuf_hugepages en_rbuf_hugepages_ms[] = { RBUF_HUGEPAGES_NONE, RBUF_HUGEPAGES_TRANSPARENT, RBUF_HUGEPAGES_HUGETLB, 0 };
+GENERIC_ENUM (rbuf_hugepages)
+
 static const char *en_standards_conformance_vs[] = { "pedantic", "strict", "lax", NULL };
 static const enum nn_standards_conformance en_standards_conformance_ms[] = { NN_SC_PEDANTIC, NN_SC_STRICT, NN_SC_LAX, 0 };
 GENERIC_ENUM_CTYPE (standards_conformance, enum nn_standards_conformance)
@@ -1046,19 +1059,17 @@ static void pf_string (struct cfgst *cfgst, void *parent, struct cfgelem const *
   cfg_logelem (cfgst, sources, "%s", *p ? *p : "(null)");
 }
 
-#ifdef DDSI_INCLUDE_BANDWIDTH_LIMITING
 static enum update_result uf_bandwidth (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, UNUSED_ARG (int first), const char *value)
 {
   int64_t bandwidth_bps = 0;
   if (strncmp (value, "inf", 3) == 0) {
     /* special case: inf needs no unit */
     uint32_t * const elem = cfg_address (cfgst, parent, cfgelem);
-    if (strspn (value + 3, " ") != strlen (value + 3) &&
-        lo.up_multiplier (cfgst, unittab_bandwidth_bps, value, 3, 1, 8, 1) == 0)
-      return URES_ERROR;
+    if (strspn (value + 3, " ") != strlen (value + 3))
+      return cfg_error (cfgst, "%s: invalid value", value);
     *elem = 0;
     return URES_SUCCESS;
-  } else if (uf_natint64_unit (cfgst, &bandwidth_bps, value, unittab_bandwidth_bps, 8, INT64_MAX) != URES_SUCCESS) {
+  } else if (uf_natint64_unit (cfgst, &bandwidth_bps, value, unittab_bandwidth_bps, 8, 0, INT64_MAX) != URES_SUCCESS) {
     return URES_ERROR;
   } else if (bandwidth_bps / 8 > INT_MAX) {
     return cfg_error (cfgst, "%s: value out of range", value);
@@ -1077,7 +1088,6 @@ static void pf_bandwidth(struct cfgst *cfgst, void *parent, struct cfgelem const
   else
     pf_int64_unit (cfgst, *elem, sources, unittab_bandwidth_Bps, "B/s");
 }
-#endif
 
 static enum update_result uf_memsize (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, UNUSED_ARG (int first), const char *value)
 {
@@ -1286,6 +1296,68 @@ static void pf_maybe_int32 (struct cfgst *cfgst, void *parent, struct cfgelem co
     cfg_logelem (cfgst, sources, "%d", p->value);
 }
 
+int config_parse_cpu_list (const char *str, uint32_t *cpus)
+{
+  uint64_t set[MAX_THREAD_AFFINITY_CPUS / 64];
+  const char *p = str;
+  memset (set, 0, sizeof (set));
+  while (1)
+  {
+    unsigned long lo, hi;
+    char *end;
+    if (!isdigit ((unsigned char) *p))
+      return -1;
+    lo = hi = strtoul (p, &end, 10);
+    p = end;
+    if (*p == '-')
+    {
+      if (!isdigit ((unsigned char) *++p))
+        return -1;
+      hi = strtoul (p, &end, 10);
+      p = end;
+    }
+    if (lo > hi || hi >= MAX_THREAD_AFFINITY_CPUS)
+      return -1;
+    for (unsigned long i = lo; i <= hi; i++)
+      set[i / 64] |= (uint64_t) 1 << (i % 64);
+    if (*p == 0)
+      break;
+    else if (*p++ != ',')
+      return -1;
+  }
+  int n = 0;
+  for (uint32_t i = 0; i < MAX_THREAD_AFFINITY_CPUS; i++)
+  {
+    if (set[i / 64] & ((uint64_t) 1 << (i % 64)))
+    {
+      if (cpus)
+        cpus[n] = i;
+      n++;
+    }
+  }
+  return n;
+}
+
+static enum update_result uf_thread_affinity (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, UNUSED_ARG (int first), const char *value)
+{
+  char ** const elem = cfg_address (cfgst, parent, cfgelem);
+  if (ddsrt_strcasecmp (value, "default") == 0) {
+    *elem = NULL;
+    return URES_SUCCESS;
+  } else if (config_parse_cpu_list (value, NULL) > 0) {
+    *elem = ddsrt_strdup (value);
+    return URES_SUCCESS;
+  } else {
+    return cfg_error (cfgst, "'%s': neither 'default' nor a list of CPU numbers below %d\n", value, MAX_THREAD_AFFINITY_CPUS);
+  }
+}
+
+static void pf_thread_affinity (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, uint32_t sources)
+{
+  char ** const p = cfg_address (cfgst, parent, cfgelem);
+  cfg_logelem (cfgst, sources, "%s", *p ? *p : "default");
+}
+
 static enum update_result uf_maybe_memsize (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, UNUSED_ARG (int first), const char *value)
 {
   struct config_maybe_uint32 * const elem = cfg_address (cfgst, parent, cfgelem);
@@ -1357,6 +1429,11 @@ static enum update_result uf_natint_255(struct cfgst *cfgst, void *parent, struc
   return uf_int_min_max(cfgst, parent, cfgelem, first, value, 0, 255);
 }
 
+static enum update_result uf_recv_shards(struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, int first, const char *value)
+{
+  return uf_int_min_max(cfgst, parent, cfgelem, first, value, 1, MAX_UNICAST_RECV_SHARDS);
+}
+
 static enum update_result uf_uint (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, UNUSED_ARG (int first), const char *value)
 {
   uint32_t * const elem = cfg_address (cfgst, parent, cfgelem);
@@ -2414,6 +2491,17 @@ int is_ignored_partition (const struct config *cfg, const char *partition, const
   ddsrt_free (pt);
   return ip != NULL;
 }
+
+int is_unicast_partition (const struct config *cfg, const char *partition, const char *topic)
+{
+  char *pt = get_partition_search_pattern (partition, topic);
+  struct config_unicastpartition_listelem *up;
+  for (up = cfg->unicastPartitions; up; up = up->next)
+    if (WildcardOverlap(pt, up->DCPSPartitionTopic))
+      break;
+  ddsrt_free (pt);
+  return up != NULL;
+}
 #endif /* DDSI_INCLUDE_NETWORK_PARTITIONS */
 
 #ifdef DDSI_INCLUDE_NETWORK_CHANNELS
@@ -318,12 +318,18 @@ void get_participant_builtin_topic_data (const struct participant *pp, ddsi_plis
 #endif
 }
 
-static int write_and_fini_plist (struct writer *wr, ddsi_plist_t *ps, bool alive)
+static struct ddsi_serdata *serdata_from_plist_and_fini (struct writer *wr, ddsi_plist_t *ps, bool alive)
 {
   struct ddsi_serdata *serdata = ddsi_serdata_from_sample (wr->topic, alive ? SDK_DATA : SDK_KEY, ps);
   ddsi_plist_fini (ps);
   serdata->statusinfo = alive ? 0 : (NN_STATUSINFO_DISPOSE | NN_STATUSINFO_UNREGISTER);
   serdata->timestamp = ddsrt_time_wallclock ();
+  return serdata;
+}
+
+static int write_and_fini_plist (struct writer *wr, ddsi_plist_t *ps, bool alive)
+{
+  struct ddsi_serdata *serdata = serdata_from_plist_and_fini (wr, ps, alive);
   return write_sample_nogc_notk (lookup_thread_state (), NULL, wr, serdata);
 }
 
@@ -885,6 +891,83 @@ static void add_locator_to_ps (const nn_locator_t *loc, void *varg)
  ***
  *****************************************************************************/
 
+static void sedp_batch_flush (struct xevent *xev, void *varg, ddsrt_mtime_t tnow)
+{
+  struct ddsi_domaingv * const gv = varg;
+  (void) xev;
+  (void) tnow;
+  ddsrt_mutex_lock (&gv->sedp_batch_lock);
+  if (gv->sedp_batch_xp)
+    nn_xpack_send (gv->sedp_batch_xp, true);
+  ddsrt_mutex_unlock (&gv->sedp_batch_lock);
+}
+
+void sedp_batch_init (struct ddsi_domaingv *gv)
+{
+  ddsrt_mutex_init (&gv->sedp_batch_lock);
+  if (gv->config.sedp_batch_delay <= 0)
+  {
+    gv->sedp_batch_xp = NULL;
+    gv->sedp_batch_xevent = NULL;
+  }
+  else
+  {
+    gv->sedp_batch_xp = nn_xpack_new (gv->xmit_conn, 0, gv->config.xpack_send_async);
+    gv->sedp_batch_xevent = qxev_callback (gv->xevents, DDSRT_MTIME_NEVER, sedp_batch_flush, gv);
+  }
+}
+
+void sedp_batch_stop (struct ddsi_domaingv *gv)
+{
+  struct xevent *xev;
+  ddsrt_mutex_lock (&gv->sedp_batch_lock);
+  if (gv->sedp_batch_xp)
+  {
+    /* sending updates the writers' administration */
+    struct thread_state1 * const ts1 = lookup_thread_state ();
+    thread_state_awake (ts1, gv);
+    nn_xpack_send (gv->sedp_batch_xp, true);
+    nn_xpack_free (gv->sedp_batch_xp);
+    gv->sedp_batch_xp = NULL;
+    thread_state_asleep (ts1);
+  }
+  xev = gv->sedp_batch_xevent;
+  gv->sedp_batch_xevent = NULL;
+  ddsrt_mutex_unlock (&gv->sedp_batch_lock);
+  /* the callback may be waiting for the lock, so it can only be deleted now */
+  if (xev)
+    delete_xevent_callback (xev);
+}
+
+void sedp_batch_fini (struct ddsi_domaingv *gv)
+{
+  sedp_batch_stop (gv);
+  ddsrt_mutex_destroy (&gv->sedp_batch_lock);
+}
+
+static int sedp_write_and_fini_plist (struct writer *wr, ddsi_plist_t *ps, bool alive)
+{
+  /* Endpoints tend to get created in bursts, and sending the discovery data of
+     each of them in a separate packet costs the receivers far more than handling
+     a few larger ones, so collect them in a packet for a little while */
+  struct ddsi_domaingv * const gv = wr->e.gv;
+  if (gv->config.sedp_batch_delay <= 0)
+    return write_and_fini_plist (wr, ps, alive);
+
+  struct ddsi_serdata *serdata = serdata_from_plist_and_fini (wr, ps, alive);
+  int ret;
+  ddsrt_mutex_lock (&gv->sedp_batch_lock);
+  if (gv->sedp_batch_xp == NULL)
+    ret = write_sample_nogc_notk (lookup_thread_state (), NULL, wr, serdata);
+  else
+  {
+    ret = write_sample_nogc_notk (lookup_thread_state (), gv->sedp_batch_xp, wr, serdata);
+    (void) resched_xevent_if_earlier (gv->sedp_batch_xevent, ddsrt_mtime_add_duration (ddsrt_time_monotonic (), gv->config.sedp_batch_delay));
+  }
+  ddsrt_mutex_unlock (&gv->sedp_batch_lock);
+  return ret;
+}
+
 static int sedp_write_endpoint
 (
    struct writer *wr, int alive, const ddsi_guid_t *epguid,
@@ -971,7 +1054,7 @@ static int sedp_write_endpoint
 
   if (xqos)
     ddsi_xqos_mergein_missing (&ps.qos, xqos, qosdiff);
-  return write_and_fini_plist (wr, &ps, alive);
+  return sedp_write_and_fini_plist (wr, &ps, alive);
 }
 
 static struct writer *get_sedp_writer (const struct participant *pp, unsigned entityid)
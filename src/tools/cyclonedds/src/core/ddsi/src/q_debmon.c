@@ -33,6 +33,7 @@
 #include "dds/ddsi/q_protocol.h" /* NN_ENTITYID_... */
 #include "dds/ddsi/q_unused.h"
 #include "dds/ddsi/q_debmon.h"
+#include "dds/ddsi/q_pcap.h"
 #include "dds/ddsi/ddsi_serdata.h"
 #include "dds/ddsi/ddsi_tran.h"
 #include "dds/ddsi/ddsi_tcp.h"
@@ -299,6 +300,33 @@ static int print_proxy_participants (struct thread_state1 * const ts1, struct dd
   return x;
 }
 
+static int print_rbufpools (struct ddsi_domaingv *gv, ddsi_tran_conn_t conn)
+{
+  int x = 0;
+  for (uint32_t i = 0; i < gv->n_recv_threads; i++)
+  {
+    struct nn_rbufpool_stats st;
+    nn_rbufpool_get_stats (gv->recv_threads[i].arg.rbpool, &st);
+    x += cpf (conn, "rbufpool %s size %"PRIu32" [%"PRIu32",%"PRIu32"] max-msg %"PRIu32" live %"PRIu32" cached %"PRIu32"\n",
+              gv->recv_threads[i].name, st.rbuf_size, st.min_rbuf_size, st.max_rbuf_size, st.max_msg_size, st.live, st.cached);
+    x += cpf (conn, "    #alloc %"PRIu64" #reuse %"PRIu64" #free %"PRIu64" #fail %"PRIu64" #grow %"PRIu64" #shrink %"PRIu64"\n",
+              st.allocs, st.reuses, st.frees, st.failures, st.grows, st.shrinks);
+  }
+  return x;
+}
+
+static int dump_pcap (struct ddsi_domaingv *gv, ddsi_tran_conn_t conn)
+{
+  char name[256];
+  int n;
+  if (gv->pcap_ring == NULL)
+    return 0;
+  if ((n = dump_pcap_ring (gv, name, sizeof (name))) < 0)
+    return cpf (conn, "pcap: failed to write %s\n", name);
+  else
+    return cpf (conn, "pcap: %d packets written to %s\n", n, name);
+}
+
 static void debmon_handle_connection (struct debug_monitor *dm, ddsi_tran_conn_t conn)
 {
   struct thread_state1 * const ts1 = lookup_thread_state ();
@@ -307,6 +335,10 @@ static void debmon_handle_connection (struct debug_monitor *dm, ddsi_tran_conn_t
   r += print_participants (ts1, dm->gv, conn);
   if (r == 0)
     r += print_proxy_participants (ts1, dm->gv, conn);
+  if (r == 0)
+    r += print_rbufpools (dm->gv, conn);
+  if (r == 0)
+    r += dump_pcap (dm->gv, conn);
 
   /* Note: can only add plugins (at the tail) */
   ddsrt_mutex_lock (&dm->lock);
@@ -1473,7 +1473,12 @@ static struct addrset *rebuild_make_all_addrs (int *nreaders, struct writer *wr,
     (*nreaders)++;
     if (prd->receive_buffer_size < *min_receive_buffer_size)
       *min_receive_buffer_size = prd->receive_buffer_size;
-    copy_addrset_into_addrset(wr->e.gv, all_addrs, prd->c.as);
+#ifdef DDSI_INCLUDE_NETWORK_PARTITIONS
+    if (wr->unicast_only)
+      copy_addrset_into_addrset_uc(wr->e.gv, all_addrs, prd->c.as);
+    else
+#endif
+      copy_addrset_into_addrset(wr->e.gv, all_addrs, prd->c.as);
   }
   if (addrset_empty(all_addrs) || *nreaders == 0)
   {
@@ -1538,6 +1543,14 @@ static void rebuild_make_covered(int8_t **covered, const struct writer *wr, int
     if ((prd = entidx_lookup_proxy_reader_guid (gh, &m->prd_guid)) == NULL)
       continue;
     ass[0] = prd->c.as;
+#ifdef DDSI_INCLUDE_NETWORK_PARTITIONS
+    /* multicast addresses were left out of the combined set */
+    if (wr->unicast_only)
+    {
+      ass[0] = new_addrset ();
+      copy_addrset_into_addrset_uc (wr->e.gv, ass[0], prd->c.as);
+    }
+#endif
 #ifdef DDSI_INCLUDE_SSM
     if (prd->favours_ssm && wr->supports_ssm)
       ass[1] = wr->ssm_as;
@@ -1565,6 +1578,10 @@ static void rebuild_make_covered(int8_t **covered, const struct writer *wr, int
         cov[rdidx * nlocs + lidx] = x;
       }
     }
+#ifdef DDSI_INCLUDE_NETWORK_PARTITIONS
+    if (wr->unicast_only)
+      unref_addrset (ass[0]);
+#endif
     rdidx++;
   }
   ddsrt_free(flarg.locs);
@@ -3354,6 +3371,19 @@ static uint32_t get_partitionid_from_mapping (const struct ddsrt_log_cfg *logcfg
     return pm->partition->partitionId;
   }
 }
+
+static bool writer_is_unicast_only (const struct config *config, const dds_qos_t *xqos)
+{
+  /* like the network partition, any matching DCPS partition determines it */
+  if (config->unicastPartitions == NULL)
+    return false;
+  if (xqos->partition.n == 0)
+    return is_unicast_partition (config, "", xqos->topic_name);
+  for (uint32_t i = 0; i < xqos->partition.n; i++)
+    if (is_unicast_partition (config, xqos->partition.strs[i], xqos->topic_name))
+      return true;
+  return false;
+}
 #endif /* DDSI_INCLUDE_NETWORK_PARTITIONS */
 
 static void augment_wr_prd_match (void *vnode, const void *vleft, const void *vright)
@@ -3637,6 +3667,7 @@ static void new_writer_guid_common_init (struct writer *wr, const struct ddsi_se
   wr->rexmit_count = 0;
   wr->rexmit_lost_count = 0;
   wr->rexmit_bytes = 0;
+  wr->write_bytes = 0;
   wr->time_throttled = 0;
   wr->time_retransmit = 0;
   wr->force_md5_keyhash = 0;
@@ -3678,10 +3709,18 @@ static void new_writer_guid_common_init (struct writer *wr, const struct ddsi_se
             (wr->e.guid.entityid.u == NN_ENTITYID_P2P_BUILTIN_PARTICIPANT_STATELESS_MESSAGE_WRITER));
   }
   wr->handle_as_transient_local = (wr->xqos->durability.kind == DDS_DURABILITY_TRANSIENT_LOCAL);
+  if (!is_builtin_entityid (wr->e.guid.entityid, NN_VENDORID_ECLIPSE) &&
+      wr->xqos->transport_priority.value < wr->e.gv->config.fragment_pacing_priority_threshold)
+    wr->pacing_rate = wr->e.gv->config.fragment_pacing_bandwidth;
+  else
+    wr->pacing_rate = 0;
+  wr->pacing_tokens = (int64_t) wr->e.gv->config.fragment_pacing_bucket_size;
+  wr->pacing_tupdate = ddsrt_time_monotonic ();
   wr->include_keyhash =
     wr->e.gv->config.generate_keyhash &&
     ((wr->e.guid.entityid.u & NN_ENTITYID_KIND_MASK) == NN_ENTITYID_KIND_WRITER_WITH_KEY);
   wr->topic = ddsi_sertopic_ref (topic);
+  ddsrt_atomic_stvoidp (&wr->keyless_tk, NULL);
   wr->as = new_addrset ();
   wr->as_group = NULL;
 
@@ -3693,6 +3732,9 @@ static void new_writer_guid_common_init (struct writer *wr, const struct ddsi_se
   wr->partition_id = 0;
   for (uint32_t i = 0; i < wr->xqos->partition.n && wr->partition_id == 0; i++)
     wr->partition_id = get_partitionid_from_mapping (&wr->e.gv->logconfig, &wr->e.gv->config, wr->xqos->partition.strs[i], wr->xqos->topic_name);
+  wr->unicast_only = writer_is_unicast_only (&wr->e.gv->config, wr->xqos);
+  if (wr->unicast_only)
+    ELOGDISC (wr, "writer "PGUIDFMT": unicast only\n", PGUID (wr->e.guid));
 #endif /* DDSI_INCLUDE_NETWORK_PARTITIONS */
 
 #ifdef DDSI_INCLUDE_SSM
@@ -3702,7 +3744,7 @@ static void new_writer_guid_common_init (struct writer *wr, const struct ddsi_se
      to advertise. */
   wr->supports_ssm = 0;
   wr->ssm_as = NULL;
-  if (wr->e.gv->config.allowMulticast & AMC_SSM)
+  if ((wr->e.gv->config.allowMulticast & AMC_SSM) && !wr->unicast_only)
   {
     nn_locator_t loc;
     int have_loc = 0;
@@ -3981,6 +4023,7 @@ static void gc_delete_writer (struct gcreq *gcreq)
   local_reader_ary_fini (&wr->rdary);
   ddsrt_cond_destroy (&wr->throttle_cond);
 
+  ddsi_tkmap_cache_fini (wr->e.gv->m_tkmap, &wr->keyless_tk);
   ddsi_sertopic_unref ((struct ddsi_sertopic *) wr->topic);
   endpoint_common_fini (&wr->e, &wr->c);
   ddsrt_free (wr);
@@ -4337,6 +4380,7 @@ static dds_return_t new_reader_guid
   rd->handle_as_transient_local = (rd->xqos->durability.kind == DDS_DURABILITY_TRANSIENT_LOCAL) ||
                                   (rd->e.guid.entityid.u == NN_ENTITYID_P2P_BUILTIN_PARTICIPANT_VOLATILE_SECURE_READER);
   rd->topic = ddsi_sertopic_ref (topic);
+  ddsrt_atomic_stvoidp (&rd->keyless_tk, NULL);
   rd->ddsi2direct_cb = 0;
   rd->ddsi2direct_cbarg = 0;
   rd->init_acknack_count = 1;
@@ -4500,6 +4544,7 @@ static void gc_delete_reader (struct gcreq *gcreq)
   {
     (rd->status_cb) (rd->status_cb_entity, NULL);
   }
+  ddsi_tkmap_cache_fini (rd->e.gv->m_tkmap, &rd->keyless_tk);
   ddsi_sertopic_unref ((struct ddsi_sertopic *) rd->topic);
 
   ddsi_xqos_fini (rd->xqos);
@@ -5546,11 +5591,11 @@ int new_proxy_writer (struct ddsi_domaingv *gv, const struct ddsi_guid *ppguid,
 
   if (isreliable)
   {
-    pwr->defrag = nn_defrag_new (&gv->logconfig, NN_DEFRAG_DROP_LATEST, gv->config.defrag_reliable_maxsamples);
+    pwr->defrag = nn_defrag_new (&gv->logconfig, NN_DEFRAG_DROP_LATEST, gv->config.defrag_reliable_maxsamples, gv->config.defrag_contiguous_threshold);
   }
   else
   {
-    pwr->defrag = nn_defrag_new (&gv->logconfig, NN_DEFRAG_DROP_OLDEST, gv->config.defrag_unreliable_maxsamples);
+    pwr->defrag = nn_defrag_new (&gv->logconfig, NN_DEFRAG_DROP_OLDEST, gv->config.defrag_unreliable_maxsamples, gv->config.defrag_contiguous_threshold);
   }
   reorder_mode = get_proxy_writer_reorder_mode(pwr->e.guid.entityid, isreliable);
   pwr->reorder = nn_reorder_new (&gv->logconfig, reorder_mode, gv->config.primary_reorder_maxsamples, gv->config.late_ack_mode);
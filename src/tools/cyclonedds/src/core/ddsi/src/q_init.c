@@ -77,6 +77,23 @@ static void add_peer_addresses (const struct ddsi_domaingv *gv, struct addrset *
   }
 }
 
+static bool use_multiple_receive_threads (const struct config *cfg);
+
+static uint32_t unicast_recv_shards (const struct ddsi_domaingv *gv)
+{
+  /* Sharing the data unicast port only works if there is a single one and
+     dedicated receive threads are used, and only Linux's SO_REUSEPORT spreads
+     the incoming packets over the sockets */
+#if defined __linux__
+  if ((gv->m_factory->m_kind == NN_LOCATOR_KIND_UDPv4 || gv->m_factory->m_kind == NN_LOCATOR_KIND_UDPv6) &&
+      gv->config.many_sockets_mode == MSM_SINGLE_UNICAST && use_multiple_receive_threads (&gv->config))
+    return (uint32_t) gv->config.unicast_recv_shards;
+#else
+  (void) gv;
+#endif
+  return 1;
+}
+
 enum make_uc_sockets_ret {
   MUSRET_SUCCESS,       /* unicast socket(s) created */
   MUSRET_INVALID_PORTS, /* specified port numbers are invalid */
@@ -110,18 +127,35 @@ static enum make_uc_sockets_ret make_uc_sockets (struct ddsi_domaingv *gv, uint3
   if (rc != DDS_RETCODE_OK)
     goto fail_disc;
 
-  if (*pdata == 0 || *pdata == *pdisc)
+  /* The discovery socket never shares its port, so that a port in use by
+     another process is still detected when selecting a participant index */
+  const uint32_t nshards = (*pdata != 0 && *pdata == *pdisc) ? 1 : unicast_recv_shards (gv);
+  if (nshards == 1 && (*pdata == 0 || *pdata == *pdisc))
     gv->data_conn_uc = gv->disc_conn_uc;
   else
   {
-    rc = ddsi_factory_create_conn (&gv->data_conn_uc, gv->m_factory, *pdata, &qos);
+    const ddsi_tran_qos_t data_qos = { .m_purpose = DDSI_TRAN_QOS_RECV_UC, .m_diffserv = 0, .m_reuse_port = (nshards > 1) };
+    rc = ddsi_factory_create_conn (&gv->data_conn_uc, gv->m_factory, *pdata, &data_qos);
     if (rc != DDS_RETCODE_OK)
       goto fail_data;
+    /* with a kernel-allocated port, the others must bind the one it gave */
+    const uint32_t port = ddsi_conn_port (gv->data_conn_uc);
+    for (gv->n_data_conn_uc_shards = 0; gv->n_data_conn_uc_shards < nshards - 1; gv->n_data_conn_uc_shards++)
+    {
+      rc = ddsi_factory_create_conn (&gv->data_conn_uc_shards[gv->n_data_conn_uc_shards], gv->m_factory, port, &data_qos);
+      if (rc != DDS_RETCODE_OK)
+        goto fail_shards;
+    }
   }
   ddsi_conn_locator (gv->disc_conn_uc, &gv->loc_meta_uc);
   ddsi_conn_locator (gv->data_conn_uc, &gv->loc_default_uc);
   return MUSRET_SUCCESS;
 
+fail_shards:
+  while (gv->n_data_conn_uc_shards > 0)
+    ddsi_conn_free (gv->data_conn_uc_shards[--gv->n_data_conn_uc_shards]);
+  ddsi_conn_free (gv->data_conn_uc);
+  gv->data_conn_uc = NULL;
 fail_data:
   ddsi_conn_free (gv->disc_conn_uc);
   gv->disc_conn_uc = NULL;
@@ -911,6 +945,8 @@ static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
   gv->n_recv_threads = 1;
   gv->recv_threads[0].name = "recv";
   gv->recv_threads[0].arg.mode = RTM_MANY;
+  gv->recv_threads[0].arg.u.many.ws = NULL;
+  gv->recv_threads[0].arg.u.many.conn = NULL;
   if (gv->m_factory->m_connless && gv->config.many_sockets_mode != MSM_NO_UNICAST && multi_recv_thr)
   {
     if (ddsi_is_mcaddr (gv, &gv->loc_default_mc) && !ddsi_is_ssm_mcaddr (gv, &gv->loc_default_mc) && (gv->config.allowMulticast & AMC_ASM))
@@ -923,7 +959,7 @@ static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
       ddsi_conn_disable_multiplexing (gv->data_conn_mc);
       gv->n_recv_threads++;
     }
-    if (gv->config.many_sockets_mode == MSM_SINGLE_UNICAST)
+    if (gv->config.many_sockets_mode == MSM_SINGLE_UNICAST && gv->n_data_conn_uc_shards == 0)
     {
       /* No per-participant sockets => handle data unicasts on a separate thread as well */
       gv->recv_threads[gv->n_recv_threads].name = "recvUC";
@@ -933,6 +969,25 @@ static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
       ddsi_conn_disable_multiplexing (gv->data_conn_uc);
       gv->n_recv_threads++;
     }
+    else if (gv->config.many_sockets_mode == MSM_SINGLE_UNICAST)
+    {
+      /* Data unicasts spread over sockets sharing the port: a packet sent to
+         the port to stop a thread may well end up at another one, so these
+         threads wait on a waitset of their own that can be triggered */
+      static const char *shard_names[MAX_UNICAST_RECV_SHARDS] = {
+        "recvUC", "recvUC1", "recvUC2", "recvUC3", "recvUC4", "recvUC5", "recvUC6", "recvUC7"
+      };
+      for (uint32_t i = 0; i <= gv->n_data_conn_uc_shards; i++)
+      {
+        struct ddsi_tran_conn * const conn = (i == 0) ? gv->data_conn_uc : gv->data_conn_uc_shards[i - 1];
+        gv->recv_threads[gv->n_recv_threads].name = shard_names[i];
+        gv->recv_threads[gv->n_recv_threads].arg.mode = RTM_MANY;
+        gv->recv_threads[gv->n_recv_threads].arg.u.many.ws = NULL;
+        gv->recv_threads[gv->n_recv_threads].arg.u.many.conn = conn;
+        ddsi_conn_disable_multiplexing (conn);
+        gv->n_recv_threads++;
+      }
+    }
   }
   assert (gv->n_recv_threads <= MAX_RECV_THREADS);
 
@@ -942,7 +997,7 @@ static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
     /* We create the rbufpool for the receive thread, and so we'll
        become the initial owner thread. The receive thread will change
        it before it does anything with it. */
-    if ((gv->recv_threads[i].arg.rbpool = nn_rbufpool_new (&gv->logconfig, gv->config.rbuf_size, gv->config.rmsg_chunk_size)) == NULL)
+    if ((gv->recv_threads[i].arg.rbpool = nn_rbufpool_new (&gv->logconfig, gv->config.rbuf_size, gv->config.rmsg_chunk_size, gv->config.rbuf_max_size, gv->config.rbuf_hugepages)) == NULL)
     {
       GVERROR ("rtps_init: can't allocate receive buffer pool for thread %s\n", gv->recv_threads[i].name);
       goto fail;
@@ -1024,6 +1079,9 @@ static void free_conns (struct ddsi_domaingv *gv)
         cs[j] = NULL;
     ddsi_conn_free (cs[i]);
   }
+  for (uint32_t i = 0; i < gv->n_data_conn_uc_shards; i++)
+    ddsi_conn_free (gv->data_conn_uc_shards[i]);
+  gv->n_data_conn_uc_shards = 0;
 }
 
 int rtps_init (struct ddsi_domaingv *gv)
@@ -1039,6 +1097,7 @@ int rtps_init (struct ddsi_domaingv *gv)
 
   gv->disc_conn_uc = NULL;
   gv->data_conn_uc = NULL;
+  gv->n_data_conn_uc_shards = 0;
   gv->disc_conn_mc = NULL;
   gv->data_conn_mc = NULL;
   gv->xmit_conn = NULL;
@@ -1268,7 +1327,7 @@ int rtps_init (struct ddsi_domaingv *gv)
 
   ddsrt_mutex_init (&gv->lock);
   ddsrt_mutex_init (&gv->spdp_lock);
-  gv->spdp_defrag = nn_defrag_new (&gv->logconfig, NN_DEFRAG_DROP_OLDEST, gv->config.defrag_unreliable_maxsamples);
+  gv->spdp_defrag = nn_defrag_new (&gv->logconfig, NN_DEFRAG_DROP_OLDEST, gv->config.defrag_unreliable_maxsamples, 0);
   gv->spdp_reorder = nn_reorder_new (&gv->logconfig, NN_REORDER_MODE_ALWAYS_DELIVER, gv->config.primary_reorder_maxsamples, false);
 
   gv->m_tkmap = ddsi_tkmap_new (gv);
@@ -1333,7 +1392,14 @@ int rtps_init (struct ddsi_domaingv *gv)
   }
   GVLOG (DDS_LC_CONFIG, "rtps_init: domainid %"PRIu32" participantid %d\n", gv->config.domainId, gv->config.participantIndex);
 
-  if (gv->config.pcap_file && *gv->config.pcap_file)
+  gv->pcap_ring = NULL;
+  gv->pcap_dump_xevent = NULL;
+  if (gv->config.pcap_ring_size > 0)
+  {
+    gv->pcap_fp = NULL;
+    gv->pcap_ring = new_pcap_ring (gv);
+  }
+  else if (gv->config.pcap_file && *gv->config.pcap_file)
   {
     gv->pcap_fp = new_pcap_file (gv, gv->config.pcap_file);
     if (gv->pcap_fp)
@@ -1489,6 +1555,8 @@ int rtps_init (struct ddsi_domaingv *gv)
 #endif
   );
 
+  sedp_batch_init (gv);
+
 #ifdef DDSI_INCLUDE_SECURITY
   q_omg_security_init(gv);
 #endif
@@ -1556,6 +1624,8 @@ err_mc_conn:
   free_conns (gv);
   if (gv->pcap_fp)
     ddsrt_mutex_destroy (&gv->pcap_lock);
+  if (gv->pcap_ring)
+    free_pcap_ring (gv->pcap_ring);
   free_group_membership (gv->mship);
 err_unicast_sockets:
   ddsi_tkmap_free (gv->m_tkmap);
@@ -1669,6 +1739,7 @@ int rtps_start (struct ddsi_domaingv *gv)
       return -1;
     }
   }
+  start_pcap_dump_signal (gv);
   if (gv->config.monitor_port >= 0)
   {
     if ((gv->debmon = new_debug_monitor (gv, gv->config.monitor_port)) == NULL)
@@ -1710,6 +1781,10 @@ void rtps_stop (struct ddsi_domaingv *gv)
     free_debug_monitor (gv->debmon);
     gv->debmon = NULL;
   }
+  stop_pcap_dump_signal (gv);
+
+  /* Push out discovery data that is still waiting to be batched with more */
+  sedp_batch_stop (gv);
 
   /* Stop all I/O */
   rtps_term_prep (gv);
@@ -1859,6 +1934,7 @@ void rtps_fini (struct ddsi_domaingv *gv)
   q_omg_security_deinit (gv->security_context);
 #endif
 
+  sedp_batch_fini (gv);
   xeventq_free (gv->xevents);
 
   if (gv->config.xpack_send_async)
@@ -1895,6 +1971,8 @@ void rtps_fini (struct ddsi_domaingv *gv)
     ddsrt_mutex_destroy (&gv->pcap_lock);
     fclose (gv->pcap_fp);
   }
+  if (gv->pcap_ring)
+    free_pcap_ring (gv->pcap_ring);
 
 #ifdef DDSI_INCLUDE_NETWORK_PARTITIONS
   for (struct config_networkpartition_listelem *np = gv->config.networkPartitions; np; np = np->next)
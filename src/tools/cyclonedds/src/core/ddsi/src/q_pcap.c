@@ -10,15 +10,28 @@
  * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
  */
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 #include "dds/ddsrt/endian.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/cdtors.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/string.h"
 #include "dds/ddsi/q_log.h"
 #include "dds/ddsi/q_config.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 #include "dds/ddsi/q_bswap.h"
+#include "dds/ddsi/q_xevent.h"
 #include "dds/ddsi/q_pcap.h"
 
+#if (defined __linux || defined __APPLE__) && !DDSRT_WITH_FREERTOS
+#define PCAP_HAVE_DUMP_SIGNAL 1
+#include <signal.h>
+#else
+#define PCAP_HAVE_DUMP_SIGNAL 0
+#endif
+
 /* pcap format info taken from http://wiki.wireshark.org/Development/LibpcapFileFormat */
 
 #define LINKTYPE_RAW 101 /* Raw IP; the packet begins with an IPv4 or IPv6 header, with the "version" field of the header indicating whether it's an IPv4 or IPv6 header. */
@@ -76,24 +89,65 @@ static const ipv4_hdr_t ipv4_hdr_template = {
 #define IPV4_HDR_SIZE 20
 #define UDP_HDR_SIZE 8
 
-FILE *new_pcap_file (struct ddsi_domaingv *gv, const char *name)
+/* Number of bytes of each message kept in the ring buffer if the snap length is
+   left at its default: enough for the RTPS header and typically for several of
+   the submessage headers */
+#define PCAP_RING_DEFAULT_SNAPLEN 128
+
+/* Packets in the ring buffer are stored in fixed-size slots, where the slot is
+   determined by the sequence number of the packet.  Writers claim a sequence
+   number with an atomic increment, mark the slot as being written, copy the
+   packet and then store its sequence number in the slot.  A dump only uses the
+   data in a slot if it found the expected sequence number both before and after
+   copying it, so anything overwritten while dumping is skipped.  (In theory two
+   writers could write into the same slot at the same time if one of them is
+   delayed for as long as it takes to capture the entire ring, that is not
+   protected against.) */
+struct pcap_ring_slot {
+  ddsrt_atomic_uint64_t seq; /* 0: being written */
+  ddsrt_wctime_t tstamp;
+  uint32_t srcip, dstip;
+  uint16_t srcport, dstport;
+  unsigned char ttl;
+  uint32_t orig_len;
+  uint32_t incl_len;
+  unsigned char data[];
+};
+
+struct pcap_ring {
+  ddsrt_atomic_uint64_t seq; /* of most recently added packet */
+  uint32_t nslots;
+  size_t slot_size;
+  char *slots;
+  ddsrt_mutex_t dump_lock;
+  uint32_t ndumps;
+  uint32_t dump_requests; /* number of signals handled */
+};
+
+static uint32_t pcap_snaplen (const struct ddsi_domaingv *gv)
+{
+  const uint32_t max = 65535 - IPV4_HDR_SIZE - UDP_HDR_SIZE;
+  uint32_t n = gv->config.pcap_snaplen;
+  if (n == 0)
+    n = (gv->config.pcap_ring_size > 0) ? PCAP_RING_DEFAULT_SNAPLEN : max;
+  return (n < max) ? n : max;
+}
+
+static FILE *open_pcap_file (struct ddsi_domaingv *gv, const char *name)
 {
   DDSRT_WARNING_MSVC_OFF(4996);
   FILE *fp;
   pcap_hdr_t hdr;
 
   if ((fp = fopen (name, "wb")) == NULL)
-  {
-    GVWARNING ("packet capture disabled: file %s could not be opened for writing\n", name);
     return NULL;
-  }
 
   hdr.magic_number = 0xa1b2c3d4;
   hdr.version_major = 2;
   hdr.version_minor = 4;
   hdr.thiszone = 0;
   hdr.sigfigs = 0;
-  hdr.snaplen = 65535;
+  hdr.snaplen = pcap_snaplen (gv) + IPV4_HDR_SIZE + UDP_HDR_SIZE;
   hdr.network = LINKTYPE_RAW;
   (void) fwrite (&hdr, sizeof (hdr), 1, fp);
 
@@ -101,6 +155,14 @@ FILE *new_pcap_file (struct ddsi_domaingv *gv, const char *name)
   DDSRT_WARNING_MSVC_ON(4996);
 }
 
+FILE *new_pcap_file (struct ddsi_domaingv *gv, const char *name)
+{
+  FILE *fp;
+  if ((fp = open_pcap_file (gv, name)) == NULL)
+    GVWARNING ("packet capture disabled: file %s could not be opened for writing\n", name);
+  return fp;
+}
+
 static void write_data (FILE *fp, const ddsrt_msghdr_t *msghdr, size_t sz)
 {
   size_t i, n = 0;
@@ -114,6 +176,19 @@ static void write_data (FILE *fp, const ddsrt_msghdr_t *msghdr, size_t sz)
   assert (n == sz);
 }
 
+static void copy_data (unsigned char *dst, const ddsrt_msghdr_t *msghdr, size_t sz)
+{
+  size_t i, n = 0;
+  for (i = 0; i < (size_t) msghdr->msg_iovlen && n < sz; i++)
+  {
+    size_t m1 = msghdr->msg_iov[i].iov_len;
+    size_t m = (n + m1 <= sz) ? m1 : sz - n;
+    memcpy (dst + n, msghdr->msg_iov[i].iov_base, m);
+    n += m;
+  }
+  assert (n == sz);
+}
+
 static uint16_t calc_ipv4_checksum (const uint16_t *x)
 {
   uint32_t s = 0;
@@ -126,36 +201,84 @@ static uint16_t calc_ipv4_checksum (const uint16_t *x)
   return (uint16_t) ~s;
 }
 
+static void write_headers (FILE *fp, ddsrt_wctime_t tstamp, uint32_t srcip, uint16_t srcport, uint32_t dstip, uint16_t dstport, unsigned char ttl, size_t sz, size_t incl_sz)
+{
+  pcaprec_hdr_t pcap_hdr;
+  union {
+    ipv4_hdr_t ipv4_hdr;
+    uint16_t x[10];
+  } u;
+  udp_hdr_t udp_hdr;
+  size_t sz_ud = sz + UDP_HDR_SIZE;
+  size_t sz_iud = sz_ud + IPV4_HDR_SIZE;
+  ddsrt_wctime_to_sec_usec (&pcap_hdr.ts_sec, &pcap_hdr.ts_usec, tstamp);
+  pcap_hdr.orig_len = (uint32_t) sz_iud;
+  pcap_hdr.incl_len = (uint32_t) (incl_sz + UDP_HDR_SIZE + IPV4_HDR_SIZE);
+  (void) fwrite (&pcap_hdr, sizeof (pcap_hdr), 1, fp);
+  u.ipv4_hdr = ipv4_hdr_template;
+  u.ipv4_hdr.totallength = ddsrt_toBE2u ((unsigned short) sz_iud);
+  u.ipv4_hdr.ttl = ttl;
+  u.ipv4_hdr.srcip = srcip;
+  u.ipv4_hdr.dstip = dstip;
+  u.ipv4_hdr.checksum = calc_ipv4_checksum (u.x);
+  (void) fwrite (&u.ipv4_hdr, sizeof (u.ipv4_hdr), 1, fp);
+  udp_hdr.srcport = srcport;
+  udp_hdr.dstport = dstport;
+  udp_hdr.length = ddsrt_toBE2u ((unsigned short) sz_ud);
+  udp_hdr.checksum = 0; /* don't have to compute a checksum for UDPv4 */
+  (void) fwrite (&udp_hdr, sizeof (udp_hdr), 1, fp);
+}
+
+static struct pcap_ring_slot *ring_slot (const struct pcap_ring *ring, uint64_t seq)
+{
+  return (struct pcap_ring_slot *) (ring->slots + (size_t) (seq % ring->nslots) * ring->slot_size);
+}
+
+static struct pcap_ring_slot *ring_claim_slot (struct pcap_ring *ring, uint64_t *seq)
+{
+  *seq = ddsrt_atomic_inc64_nv (&ring->seq);
+  struct pcap_ring_slot * const slot = ring_slot (ring, *seq);
+  ddsrt_atomic_st64 (&slot->seq, 0);
+  ddsrt_atomic_fence_stst ();
+  return slot;
+}
+
+static void ring_publish_slot (struct pcap_ring_slot *slot, uint64_t seq)
+{
+  ddsrt_atomic_fence_rel ();
+  ddsrt_atomic_st64 (&slot->seq, seq);
+}
+
 void write_pcap_received (struct ddsi_domaingv *gv, ddsrt_wctime_t tstamp, const struct sockaddr_storage *src, const struct sockaddr_storage *dst, unsigned char *buf, size_t sz)
 {
   if (gv->config.transport_selector == TRANS_UDP)
   {
-    pcaprec_hdr_t pcap_hdr;
-    union {
-      ipv4_hdr_t ipv4_hdr;
-      uint16_t x[10];
-    } u;
-    udp_hdr_t udp_hdr;
-    size_t sz_ud = sz + UDP_HDR_SIZE;
-    size_t sz_iud = sz_ud + IPV4_HDR_SIZE;
-    ddsrt_mutex_lock (&gv->pcap_lock);
-    ddsrt_wctime_to_sec_usec (&pcap_hdr.ts_sec, &pcap_hdr.ts_usec, tstamp);
-    pcap_hdr.incl_len = pcap_hdr.orig_len = (uint32_t) sz_iud;
-    (void) fwrite (&pcap_hdr, sizeof (pcap_hdr), 1, gv->pcap_fp);
-    u.ipv4_hdr = ipv4_hdr_template;
-    u.ipv4_hdr.totallength = ddsrt_toBE2u ((unsigned short) sz_iud);
-    u.ipv4_hdr.ttl = 128;
-    u.ipv4_hdr.srcip = ((struct sockaddr_in*) src)->sin_addr.s_addr;
-    u.ipv4_hdr.dstip = ((struct sockaddr_in*) dst)->sin_addr.s_addr;
-    u.ipv4_hdr.checksum = calc_ipv4_checksum (u.x);
-    (void) fwrite (&u.ipv4_hdr, sizeof (u.ipv4_hdr), 1, gv->pcap_fp);
-    udp_hdr.srcport = ((struct sockaddr_in*) src)->sin_port;
-    udp_hdr.dstport = ((struct sockaddr_in*) dst)->sin_port;
-    udp_hdr.length = ddsrt_toBE2u ((unsigned short) sz_ud);
-    udp_hdr.checksum = 0; /* don't have to compute a checksum for UDPv4 */
-    (void) fwrite (&udp_hdr, sizeof (udp_hdr), 1, gv->pcap_fp);
-    (void) fwrite (buf, sz, 1, gv->pcap_fp);
-    ddsrt_mutex_unlock (&gv->pcap_lock);
+    const struct sockaddr_in *src4 = (const struct sockaddr_in *) src;
+    const struct sockaddr_in *dst4 = (const struct sockaddr_in *) dst;
+    const uint32_t snaplen = pcap_snaplen (gv);
+    const size_t incl_sz = (sz < snaplen) ? sz : snaplen;
+    if (gv->pcap_ring)
+    {
+      uint64_t seq;
+      struct pcap_ring_slot * const slot = ring_claim_slot (gv->pcap_ring, &seq);
+      slot->tstamp = tstamp;
+      slot->srcip = src4->sin_addr.s_addr;
+      slot->srcport = src4->sin_port;
+      slot->dstip = dst4->sin_addr.s_addr;
+      slot->dstport = dst4->sin_port;
+      slot->ttl = 128;
+      slot->orig_len = (uint32_t) sz;
+      slot->incl_len = (uint32_t) incl_sz;
+      memcpy (slot->data, buf, incl_sz);
+      ring_publish_slot (slot, seq);
+    }
+    else
+    {
+      ddsrt_mutex_lock (&gv->pcap_lock);
+      write_headers (gv->pcap_fp, tstamp, src4->sin_addr.s_addr, src4->sin_port, dst4->sin_addr.s_addr, dst4->sin_port, 128, sz, incl_sz);
+      (void) fwrite (buf, incl_sz, 1, gv->pcap_fp);
+      ddsrt_mutex_unlock (&gv->pcap_lock);
+    }
   }
 }
 
@@ -163,31 +286,221 @@ void write_pcap_sent (struct ddsi_domaingv *gv, ddsrt_wctime_t tstamp, const str
 {
   if (gv->config.transport_selector == TRANS_UDP)
   {
-    pcaprec_hdr_t pcap_hdr;
-    union {
-      ipv4_hdr_t ipv4_hdr;
-      uint16_t x[10];
-    } u;
-    udp_hdr_t udp_hdr;
-    size_t sz_ud = sz + UDP_HDR_SIZE;
-    size_t sz_iud = sz_ud + IPV4_HDR_SIZE;
-    ddsrt_mutex_lock (&gv->pcap_lock);
-    ddsrt_wctime_to_sec_usec (&pcap_hdr.ts_sec, &pcap_hdr.ts_usec, tstamp);
-    pcap_hdr.incl_len = pcap_hdr.orig_len = (uint32_t) sz_iud;
-    (void) fwrite (&pcap_hdr, sizeof (pcap_hdr), 1, gv->pcap_fp);
-    u.ipv4_hdr = ipv4_hdr_template;
-    u.ipv4_hdr.totallength = ddsrt_toBE2u ((unsigned short) sz_iud);
-    u.ipv4_hdr.ttl = 255;
-    u.ipv4_hdr.srcip = ((struct sockaddr_in*) src)->sin_addr.s_addr;
-    u.ipv4_hdr.dstip = ((struct sockaddr_in*) hdr->msg_name)->sin_addr.s_addr;
-    u.ipv4_hdr.checksum = calc_ipv4_checksum (u.x);
-    (void) fwrite (&u.ipv4_hdr, sizeof (u.ipv4_hdr), 1, gv->pcap_fp);
-    udp_hdr.srcport = ((struct sockaddr_in*) src)->sin_port;
-    udp_hdr.dstport = ((struct sockaddr_in*) hdr->msg_name)->sin_port;
-    udp_hdr.length = ddsrt_toBE2u ((unsigned short) sz_ud);
-    udp_hdr.checksum = 0; /* don't have to compute a checksum for UDPv4 */
-    (void) fwrite (&udp_hdr, sizeof (udp_hdr), 1, gv->pcap_fp);
-    write_data (gv->pcap_fp, hdr, sz);
-    ddsrt_mutex_unlock (&gv->pcap_lock);
+    const struct sockaddr_in *src4 = (const struct sockaddr_in *) src;
+    const struct sockaddr_in *dst4 = (const struct sockaddr_in *) hdr->msg_name;
+    const uint32_t snaplen = pcap_snaplen (gv);
+    const size_t incl_sz = (sz < snaplen) ? sz : snaplen;
+    if (gv->pcap_ring)
+    {
+      uint64_t seq;
+      struct pcap_ring_slot * const slot = ring_claim_slot (gv->pcap_ring, &seq);
+      slot->tstamp = tstamp;
+      slot->srcip = src4->sin_addr.s_addr;
+      slot->srcport = src4->sin_port;
+      slot->dstip = dst4->sin_addr.s_addr;
+      slot->dstport = dst4->sin_port;
+      slot->ttl = 255;
+      slot->orig_len = (uint32_t) sz;
+      slot->incl_len = (uint32_t) incl_sz;
+      copy_data (slot->data, hdr, incl_sz);
+      ring_publish_slot (slot, seq);
+    }
+    else
+    {
+      ddsrt_mutex_lock (&gv->pcap_lock);
+      write_headers (gv->pcap_fp, tstamp, src4->sin_addr.s_addr, src4->sin_port, dst4->sin_addr.s_addr, dst4->sin_port, 255, sz, incl_sz);
+      write_data (gv->pcap_fp, hdr, incl_sz);
+      ddsrt_mutex_unlock (&gv->pcap_lock);
+    }
+  }
+}
+
+#if PCAP_HAVE_DUMP_SIGNAL
+/* The signal handler is shared by all domains in the process, each of which
+   compares the request counter with what it has handled once per second */
+static ddsrt_atomic_uint32_t pcap_dump_requests = DDSRT_ATOMIC_UINT32_INIT (0);
+static uint32_t pcap_signal_refc;
+static int pcap_signal;
+static struct sigaction pcap_signal_oldact;
+
+static void pcap_dump_signal_handler (int sig)
+{
+  (void) sig;
+  ddsrt_atomic_inc32 (&pcap_dump_requests);
+}
+
+static bool install_dump_signal_handler (struct ddsi_domaingv *gv, int sig)
+{
+  bool ok = true;
+  ddsrt_mutex_t * const lock = ddsrt_get_singleton_mutex ();
+  ddsrt_mutex_lock (lock);
+  if (pcap_signal_refc > 0 && pcap_signal != sig)
+  {
+    GVWARNING ("packet capture: signal %d already used for triggering dumps, ignoring signal %d\n", pcap_signal, sig);
+    ok = false;
+  }
+  else if (pcap_signal_refc == 0)
+  {
+    struct sigaction act;
+    memset (&act, 0, sizeof (act));
+    act.sa_handler = pcap_dump_signal_handler;
+    sigemptyset (&act.sa_mask);
+    act.sa_flags = SA_RESTART;
+    if (sigaction (sig, &act, &pcap_signal_oldact) != 0)
+    {
+      GVWARNING ("packet capture: can't install handler for signal %d\n", sig);
+      ok = false;
+    }
+    else
+    {
+      pcap_signal = sig;
+    }
+  }
+  if (ok)
+    pcap_signal_refc++;
+  ddsrt_mutex_unlock (lock);
+  return ok;
+}
+
+static void remove_dump_signal_handler (void)
+{
+  ddsrt_mutex_t * const lock = ddsrt_get_singleton_mutex ();
+  ddsrt_mutex_lock (lock);
+  assert (pcap_signal_refc > 0);
+  if (--pcap_signal_refc == 0)
+    (void) sigaction (pcap_signal, &pcap_signal_oldact, NULL);
+  ddsrt_mutex_unlock (lock);
+}
+
+static void pcap_dump_signal_check (struct xevent *xev, void *varg, ddsrt_mtime_t tnow)
+{
+  struct ddsi_domaingv * const gv = varg;
+  const uint32_t reqs = ddsrt_atomic_ld32 (&pcap_dump_requests);
+  if (reqs != gv->pcap_ring->dump_requests)
+  {
+    char name[256];
+    gv->pcap_ring->dump_requests = reqs;
+    (void) dump_pcap_ring (gv, name, sizeof (name));
+  }
+  resched_xevent_if_earlier (xev, ddsrt_mtime_add_duration (tnow, DDS_SECS (1)));
+}
+#endif
+
+struct pcap_ring *new_pcap_ring (struct ddsi_domaingv *gv)
+{
+  struct pcap_ring *ring;
+  const size_t slot_size = (offsetof (struct pcap_ring_slot, data) + pcap_snaplen (gv) + 7) & ~(size_t) 7;
+  const size_t nslots = gv->config.pcap_ring_size / slot_size;
+  if (gv->config.pcap_file == NULL || *gv->config.pcap_file == 0)
+  {
+    GVWARNING ("packet capture ring buffer disabled: no file specified for dumping it\n");
+    return NULL;
+  }
+  if (nslots < 2)
+  {
+    GVWARNING ("packet capture ring buffer disabled: %"PRIu32" bytes is too small for a snap length of %"PRIu32"\n",
+               gv->config.pcap_ring_size, pcap_snaplen (gv));
+    return NULL;
+  }
+  ring = ddsrt_malloc (sizeof (*ring));
+  ddsrt_atomic_st64 (&ring->seq, 0);
+  ring->nslots = (uint32_t) nslots;
+  ring->slot_size = slot_size;
+  ring->slots = ddsrt_malloc (nslots * slot_size);
+  for (size_t i = 0; i < nslots; i++)
+    ddsrt_atomic_st64 (&ring_slot (ring, i)->seq, 0);
+  ddsrt_mutex_init (&ring->dump_lock);
+  ring->ndumps = 0;
+  ring->dump_requests = 0;
+  GVLOG (DDS_LC_CONFIG, "packet capture: ring buffer of %"PRIu32" packets\n", ring->nslots);
+  return ring;
+}
+
+void free_pcap_ring (struct pcap_ring *ring)
+{
+  ddsrt_mutex_destroy (&ring->dump_lock);
+  ddsrt_free (ring->slots);
+  ddsrt_free (ring);
+}
+
+void start_pcap_dump_signal (struct ddsi_domaingv *gv)
+{
+  if (gv->pcap_ring == NULL || gv->config.pcap_dump_signal <= 0)
+    return;
+#if PCAP_HAVE_DUMP_SIGNAL
+  if (install_dump_signal_handler (gv, gv->config.pcap_dump_signal))
+  {
+    gv->pcap_ring->dump_requests = ddsrt_atomic_ld32 (&pcap_dump_requests);
+    gv->pcap_dump_xevent = qxev_callback (gv->xevents, ddsrt_mtime_add_duration (ddsrt_time_monotonic (), DDS_SECS (1)), pcap_dump_signal_check, gv);
+  }
+#else
+  GVWARNING ("packet capture: dumping on a signal is not supported on this platform\n");
+#endif
+}
+
+void stop_pcap_dump_signal (struct ddsi_domaingv *gv)
+{
+#if PCAP_HAVE_DUMP_SIGNAL
+  if (gv->pcap_dump_xevent)
+  {
+    delete_xevent_callback (gv->pcap_dump_xevent);
+    gv->pcap_dump_xevent = NULL;
+    remove_dump_signal_handler ();
+  }
+#else
+  (void) gv;
+#endif
+}
+
+static void dump_file_name (char *name, size_t size, const char *base, uint32_t n)
+{
+  /* insert the sequence number before the extension, if there is one */
+  const char *sep = strrchr (base, '/');
+  const char *ext = strrchr ((sep == NULL) ? base : sep, '.');
+  if (ext == NULL || ext == base || ext == sep + 1)
+    (void) snprintf (name, size, "%s-%"PRIu32, base, n);
+  else
+    (void) snprintf (name, size, "%.*s-%"PRIu32"%s", (int) (ext - base), base, n, ext);
+}
+
+int dump_pcap_ring (struct ddsi_domaingv *gv, char *name, size_t size)
+{
+  struct pcap_ring * const ring = gv->pcap_ring;
+  struct pcap_ring_slot *copy;
+  FILE *fp;
+  int n = 0;
+  assert (ring != NULL && size > 0);
+
+  ddsrt_mutex_lock (&ring->dump_lock);
+  dump_file_name (name, size, gv->config.pcap_file, ++ring->ndumps);
+  if ((fp = open_pcap_file (gv, name)) == NULL)
+  {
+    GVWARNING ("packet capture: file %s could not be opened for writing\n", name);
+    ddsrt_mutex_unlock (&ring->dump_lock);
+    return -1;
+  }
+
+  const uint64_t last = ddsrt_atomic_ld64 (&ring->seq);
+  const uint64_t first = (last > ring->nslots) ? last - ring->nslots + 1 : 1;
+  const ddsrt_wctime_t tmin = (gv->config.pcap_ring_duration == DDS_INFINITY) ? (ddsrt_wctime_t) { 0 } : ddsrt_wctime_add_duration (ddsrt_time_wallclock (), -gv->config.pcap_ring_duration);
+  copy = ddsrt_malloc (ring->slot_size);
+  for (uint64_t seq = first; seq <= last; seq++)
+  {
+    const struct pcap_ring_slot *slot = ring_slot (ring, seq);
+    if (ddsrt_atomic_ld64 (&slot->seq) != seq)
+      continue;
+    ddsrt_atomic_fence_acq ();
+    memcpy (copy, slot, ring->slot_size);
+    ddsrt_atomic_fence_ldld ();
+    if (ddsrt_atomic_ld64 (&slot->seq) != seq || copy->tstamp.v < tmin.v)
+      continue;
+    write_headers (fp, copy->tstamp, copy->srcip, copy->srcport, copy->dstip, copy->dstport, copy->ttl, copy->orig_len, copy->incl_len);
+    (void) fwrite (copy->data, copy->incl_len, 1, fp);
+    n++;
   }
+  ddsrt_free (copy);
+  fclose (fp);
+  GVLOG (DDS_LC_INFO, "packet capture: %d packets written to %s\n", n, name);
+  ddsrt_mutex_unlock (&ring->dump_lock);
+  return n;
 }
@@ -13,7 +13,11 @@
 #include <stddef.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
+#if defined __linux__
+#include <sys/mman.h>
+#endif
 
 #if HAVE_VALGRIND && ! defined (NDEBUG)
 #include <memcheck.h>
@@ -27,6 +31,7 @@
 #include "dds/ddsrt/sync.h"
 #include "dds/ddsrt/string.h"
 #include "dds/ddsrt/log.h"
+#include "dds/ddsrt/time.h"
 
 #include "dds/ddsrt/avl.h"
 #include "dds/ddsi/q_protocol.h"
@@ -267,6 +272,8 @@
 
 /* RBUFPOOL ------------------------------------------------------------ */
 
+#define NN_RBUFPOOL_MAX_CACHED 2
+
 struct nn_rbufpool {
   /* An rbuf pool is owned by a receive thread, and that thread is the
      only allocating rmsgs from the rbufs in the pool. Any thread may
@@ -274,8 +281,15 @@ struct nn_rbufpool {
 
      Currently, we only have maintain a current rbuf, which gets
      replaced when allocating a new one from it fails. Any rbufs that
-     are released are freed completely if different from the current
-     one.
+     are released are kept for reuse if they have the current size
+     and there is room in the cache, else freed completely.
+
+     The size of new rbufs adapts to the rate at which they fill up:
+     when the current one was filled in less than RBUF_GROW_FILLTIME,
+     the next one is twice as large (up to max_rbuf_size); when it
+     took more than RBUF_SHRINK_FILLTIME, half as large (down to
+     min_rbuf_size).  Failing to allocate one resets it to the
+     minimum.  Changing the size flushes the cache.
 
      Could trivially be done lockless, except that it requires
      compare-and-swap, and we don't have that. But it hardly ever
@@ -283,7 +297,16 @@ struct nn_rbufpool {
   ddsrt_mutex_t lock;
   struct nn_rbuf *current;
   uint32_t rbuf_size;
+  uint32_t min_rbuf_size;
+  uint32_t max_rbuf_size;
   uint32_t max_rmsg_size;
+  enum rbuf_hugepages hugepages;
+  ddsrt_mtime_t tcurrent; /* time at which current became current */
+  bool freeing;
+  uint32_t ncached;
+  struct nn_rbuf *cached[NN_RBUFPOOL_MAX_CACHED];
+  ddsrt_atomic_uint32_t max_msg_size;
+  struct nn_rbufpool_stats stats; /* protected by lock */
   const struct ddsrt_log_cfg *logcfg;
   bool trace;
 #ifndef NDEBUG
@@ -295,6 +318,8 @@ struct nn_rbufpool {
 
 static struct nn_rbuf *nn_rbuf_alloc_new (struct nn_rbufpool *rbp);
 static void nn_rbuf_release (struct nn_rbuf *rbuf);
+static void nn_rbuf_free (struct nn_rbuf *rbuf);
+static void defrag_contig_free (struct nn_rmsg *rmsg);
 
 #define TRACE_CFG(obj, logcfg, ...) ((obj)->trace ? (void) DDS_CLOG (DDS_LC_RADMIN, (logcfg), __VA_ARGS__) : (void) 0)
 #define TRACE(obj, ...)             TRACE_CFG ((obj), (obj)->logcfg, __VA_ARGS__)
@@ -336,7 +361,7 @@ static uint32_t max_rmsg_size_w_hdr (uint32_t max_rmsg_size)
     + max_rmsg_size;
 }
 
-struct nn_rbufpool *nn_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_t rbuf_size, uint32_t max_rmsg_size)
+struct nn_rbufpool *nn_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_t rbuf_size, uint32_t max_rmsg_size, uint32_t max_rbuf_size, enum rbuf_hugepages hugepages)
 {
   struct nn_rbufpool *rbp;
 
@@ -348,6 +373,15 @@ struct nn_rbufpool *nn_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_
      rbuf_size is too small */
   if (rbuf_size < max_rmsg_size_w_hdr (max_rmsg_size))
     rbuf_size = max_rmsg_size_w_hdr (max_rmsg_size);
+  if (max_rbuf_size < rbuf_size)
+    max_rbuf_size = rbuf_size;
+#if !defined __linux__
+  if (hugepages != RBUF_HUGEPAGES_NONE)
+  {
+    DDS_CWARNING (logcfg, "nn_rbufpool_new: huge pages not supported on this platform, ignoring Sizing/ReceiveBufferHugePages\n");
+    hugepages = RBUF_HUGEPAGES_NONE;
+  }
+#endif
 
   if ((rbp = ddsrt_malloc (sizeof (*rbp))) == NULL)
     goto fail_rbp;
@@ -358,7 +392,14 @@ struct nn_rbufpool *nn_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_
   ddsrt_mutex_init (&rbp->lock);
 
   rbp->rbuf_size = rbuf_size;
+  rbp->min_rbuf_size = rbuf_size;
+  rbp->max_rbuf_size = max_rbuf_size;
   rbp->max_rmsg_size = max_rmsg_size;
+  rbp->hugepages = hugepages;
+  rbp->freeing = false;
+  rbp->ncached = 0;
+  ddsrt_atomic_st32 (&rbp->max_msg_size, 0);
+  memset (&rbp->stats, 0, sizeof (rbp->stats));
   rbp->logcfg = logcfg;
   rbp->trace = (logcfg->c.mask & DDS_LC_RADMIN) != 0;
 
@@ -368,6 +409,7 @@ struct nn_rbufpool *nn_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_
 
   if ((rbp->current = nn_rbuf_alloc_new (rbp)) == NULL)
     goto fail_rbuf;
+  rbp->tcurrent = ddsrt_time_monotonic ();
   return rbp;
 
  fail_rbuf:
@@ -396,7 +438,12 @@ void nn_rbufpool_free (struct nn_rbufpool *rbp)
      reference counts are all 0, as they should be. */
   ASSERT_RBUFPOOL_OWNER (rbp);
 #endif
+  ddsrt_mutex_lock (&rbp->lock);
+  rbp->freeing = true;
+  ddsrt_mutex_unlock (&rbp->lock);
   nn_rbuf_release (rbp->current);
+  for (uint32_t i = 0; i < rbp->ncached; i++)
+    nn_rbuf_free (rbp->cached[i]);
 #if USE_VALGRIND
   VALGRIND_DESTROY_MEMPOOL (rbp);
 #endif
@@ -404,12 +451,26 @@ void nn_rbufpool_free (struct nn_rbufpool *rbp)
   ddsrt_free (rbp);
 }
 
+void nn_rbufpool_get_stats (struct nn_rbufpool *rbp, struct nn_rbufpool_stats *stats)
+{
+  ddsrt_mutex_lock (&rbp->lock);
+  *stats = rbp->stats;
+  stats->rbuf_size = rbp->rbuf_size;
+  stats->min_rbuf_size = rbp->min_rbuf_size;
+  stats->max_rbuf_size = rbp->max_rbuf_size;
+  stats->max_msg_size = ddsrt_atomic_ld32 (&rbp->max_msg_size);
+  stats->cached = rbp->ncached;
+  ddsrt_mutex_unlock (&rbp->lock);
+}
+
 /* RBUF ---------------------------------------------------------------- */
 
 struct nn_rbuf {
   ddsrt_atomic_uint32_t n_live_rmsg_chunks;
   uint32_t size;
+  uint32_t nominal_size; /* rbufpool::rbuf_size at allocation, <= size */
   uint32_t max_rmsg_size;
+  enum rbuf_hugepages backing;
   struct nn_rbufpool *rbufpool;
   bool trace;
 
@@ -430,20 +491,109 @@ struct nn_rbuf {
   unsigned char raw[];
 };
 
+#define RBUF_HUGEPAGE_SIZE ((size_t) 2 << 20)
+#define RBUF_GROW_FILLTIME DDS_MSECS (50)
+#define RBUF_SHRINK_FILLTIME DDS_SECS (1)
+
+static struct nn_rbuf *nn_rbuf_alloc_backing (struct nn_rbufpool *rbp)
+{
+  /* Huge page backed rbufs are rounded up to a multiple of the huge
+     page size, the extra space simply becomes part of the rbuf */
+  size_t asize = sizeof (struct nn_rbuf) + rbp->rbuf_size;
+  struct nn_rbuf *rb;
+#if defined __linux__
+  if (rbp->hugepages != RBUF_HUGEPAGES_NONE)
+  {
+    void *ptr;
+    asize = (asize + RBUF_HUGEPAGE_SIZE - 1) & ~(RBUF_HUGEPAGE_SIZE - 1);
+    if (asize - sizeof (struct nn_rbuf) > UINT32_MAX)
+      return NULL;
+#ifdef MAP_HUGETLB
+    if (rbp->hugepages == RBUF_HUGEPAGES_HUGETLB)
+    {
+      if ((ptr = mmap (NULL, asize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0)) != MAP_FAILED)
+      {
+        rb = ptr;
+        rb->backing = RBUF_HUGEPAGES_HUGETLB;
+        rb->size = (uint32_t) (asize - sizeof (struct nn_rbuf));
+        return rb;
+      }
+      DDS_CWARNING (rbp->logcfg, "nn_rbuf_alloc_new: no huge pages available, falling back to transparent huge pages\n");
+    }
+#else
+    if (rbp->hugepages == RBUF_HUGEPAGES_HUGETLB)
+      DDS_CWARNING (rbp->logcfg, "nn_rbuf_alloc_new: MAP_HUGETLB not supported, falling back to transparent huge pages\n");
+#endif
+    rbp->hugepages = RBUF_HUGEPAGES_TRANSPARENT;
+    if (posix_memalign (&ptr, RBUF_HUGEPAGE_SIZE, asize) != 0)
+      return NULL;
+#ifdef MADV_HUGEPAGE
+    (void) madvise (ptr, asize, MADV_HUGEPAGE);
+#endif
+    rb = ptr;
+    rb->backing = RBUF_HUGEPAGES_TRANSPARENT;
+    rb->size = (uint32_t) (asize - sizeof (struct nn_rbuf));
+    return rb;
+  }
+#endif
+  if ((rb = ddsrt_malloc_s (asize)) == NULL)
+    return NULL;
+  rb->backing = RBUF_HUGEPAGES_NONE;
+  rb->size = rbp->rbuf_size;
+  return rb;
+}
+
+static void nn_rbuf_free (struct nn_rbuf *rbuf)
+{
+  switch (rbuf->backing)
+  {
+    case RBUF_HUGEPAGES_NONE:
+      ddsrt_free (rbuf);
+      break;
+#if defined __linux__
+    case RBUF_HUGEPAGES_TRANSPARENT:
+      free (rbuf);
+      break;
+    case RBUF_HUGEPAGES_HUGETLB:
+      (void) munmap (rbuf, sizeof (struct nn_rbuf) + rbuf->size);
+      break;
+#else
+    default:
+      assert (0);
+#endif
+  }
+}
+
 static struct nn_rbuf *nn_rbuf_alloc_new (struct nn_rbufpool *rbp)
 {
   struct nn_rbuf *rb;
   ASSERT_RBUFPOOL_OWNER (rbp);
 
-  if ((rb = ddsrt_malloc (sizeof (struct nn_rbuf) + rbp->rbuf_size)) == NULL)
-    return NULL;
+  ddsrt_mutex_lock (&rbp->lock);
+  if (rbp->ncached > 0)
+  {
+    rb = rbp->cached[--rbp->ncached];
+    rbp->stats.reuses++;
+    rbp->stats.live++;
+    ddsrt_mutex_unlock (&rbp->lock);
+  }
+  else
+  {
+    ddsrt_mutex_unlock (&rbp->lock);
+    if ((rb = nn_rbuf_alloc_backing (rbp)) == NULL)
+      return NULL;
+    rb->nominal_size = rbp->rbuf_size;
+    ddsrt_mutex_lock (&rbp->lock);
+    rbp->stats.allocs++;
+    rbp->stats.live++;
+    ddsrt_mutex_unlock (&rbp->lock);
+  }
 #if USE_VALGRIND
-  VALGRIND_MAKE_MEM_NOACCESS (rb->raw, rbp->rbuf_size);
+  VALGRIND_MAKE_MEM_NOACCESS (rb->raw, rb->size);
 #endif
 
   rb->rbufpool = rbp;
   ddsrt_atomic_st32 (&rb->n_live_rmsg_chunks, 1);
-  rb->size = rbp->rbuf_size;
   rb->max_rmsg_size = rbp->max_rmsg_size;
   rb->freeptr = rb->raw;
   rb->trace = rbp->trace;
@@ -451,18 +601,63 @@ static struct nn_rbuf *nn_rbuf_alloc_new (struct nn_rbufpool *rbp)
   return rb;
 }
 
+static void nn_rbufpool_resize (struct nn_rbufpool *rbp, uint32_t rbuf_size)
+{
+  struct nn_rbuf *flush[NN_RBUFPOOL_MAX_CACHED];
+  uint32_t nflush;
+  ASSERT_RBUFPOOL_OWNER (rbp);
+  RBPTRACE ("rbufpool_resize(%p, %"PRIu32" => %"PRIu32")\n", (void *) rbp, rbp->rbuf_size, rbuf_size);
+  ddsrt_mutex_lock (&rbp->lock);
+  if (rbuf_size > rbp->rbuf_size)
+    rbp->stats.grows++;
+  else
+    rbp->stats.shrinks++;
+  rbp->rbuf_size = rbuf_size;
+  nflush = rbp->ncached;
+  memcpy (flush, rbp->cached, nflush * sizeof (*flush));
+  rbp->ncached = 0;
+  rbp->stats.frees += nflush;
+  ddsrt_mutex_unlock (&rbp->lock);
+  for (uint32_t i = 0; i < nflush; i++)
+    nn_rbuf_free (flush[i]);
+}
+
 static struct nn_rbuf *nn_rbuf_new (struct nn_rbufpool *rbp)
 {
-  struct nn_rbuf *rb;
+  struct nn_rbuf *rb, *old;
   assert (rbp->current);
   ASSERT_RBUFPOOL_OWNER (rbp);
-  if ((rb = nn_rbuf_alloc_new (rbp)) != NULL)
+
+  const ddsrt_mtime_t tnow = ddsrt_time_monotonic ();
+  if (rbp->max_rbuf_size > rbp->min_rbuf_size)
+  {
+    const int64_t filltime = tnow.v - rbp->tcurrent.v;
+    if (filltime < RBUF_GROW_FILLTIME && rbp->rbuf_size < rbp->max_rbuf_size)
+      nn_rbufpool_resize (rbp, (rbp->rbuf_size > rbp->max_rbuf_size / 2) ? rbp->max_rbuf_size : 2 * rbp->rbuf_size);
+    else if (filltime > RBUF_SHRINK_FILLTIME && rbp->rbuf_size > rbp->min_rbuf_size)
+      nn_rbufpool_resize (rbp, (rbp->rbuf_size / 2 < rbp->min_rbuf_size) ? rbp->min_rbuf_size : rbp->rbuf_size / 2);
+  }
+
+  if ((rb = nn_rbuf_alloc_new (rbp)) == NULL && rbp->rbuf_size > rbp->min_rbuf_size)
+  {
+    /* fall back to the smallest workable size rather than dropping data */
+    nn_rbufpool_resize (rbp, rbp->min_rbuf_size);
+    rb = nn_rbuf_alloc_new (rbp);
+  }
+  if (rb == NULL)
   {
     ddsrt_mutex_lock (&rbp->lock);
-    nn_rbuf_release (rbp->current);
-    rbp->current = rb;
+    rbp->stats.failures++;
     ddsrt_mutex_unlock (&rbp->lock);
+    return NULL;
   }
+
+  ddsrt_mutex_lock (&rbp->lock);
+  old = rbp->current;
+  rbp->current = rb;
+  ddsrt_mutex_unlock (&rbp->lock);
+  rbp->tcurrent = tnow;
+  nn_rbuf_release (old);
   return rb;
 }
 
@@ -472,8 +667,19 @@ static void nn_rbuf_release (struct nn_rbuf *rbuf)
   RBPTRACE ("rbuf_release(%p) pool %p current %p\n", (void *) rbuf, (void *) rbp, (void *) rbp->current);
   if (ddsrt_atomic_dec32_ov (&rbuf->n_live_rmsg_chunks) == 1)
   {
+    ddsrt_mutex_lock (&rbp->lock);
+    rbp->stats.live--;
+    if (!rbp->freeing && rbuf->nominal_size == rbp->rbuf_size && rbp->ncached < NN_RBUFPOOL_MAX_CACHED)
+    {
+      RBPTRACE ("rbuf_release(%p) cache\n", (void *) rbuf);
+      rbp->cached[rbp->ncached++] = rbuf;
+      ddsrt_mutex_unlock (&rbp->lock);
+      return;
+    }
+    rbp->stats.frees++;
+    ddsrt_mutex_unlock (&rbp->lock);
     RBPTRACE ("rbuf_release(%p) free\n", (void *) rbuf);
-    ddsrt_free (rbuf);
+    nn_rbuf_free (rbuf);
   }
 }
 
@@ -564,6 +770,11 @@ void nn_rmsg_setsize (struct nn_rmsg *rmsg, uint32_t size)
   assert (size8P <= rmsg->chunk.rbuf->max_rmsg_size);
   assert (rmsg->lastchunk == &rmsg->chunk);
   rmsg->chunk.u.size = size8P;
+  {
+    struct nn_rbufpool *rbp = rmsg->chunk.rbuf->rbufpool;
+    if (size > ddsrt_atomic_ld32 (&rbp->max_msg_size))
+      ddsrt_atomic_st32 (&rbp->max_msg_size, size);
+  }
 #if USE_VALGRIND
   VALGRIND_MEMPOOL_CHANGE (rmsg->chunk.rbuf->rbufpool, rmsg, rmsg, offsetof (struct nn_rmsg, chunk.u.payload) + rmsg->chunk.size);
 #endif
@@ -581,6 +792,12 @@ void nn_rmsg_free (struct nn_rmsg *rmsg)
   struct nn_rmsg_chunk *c;
   RMSGTRACE ("rmsg_free(%p)\n", (void *) rmsg);
   assert (ddsrt_atomic_ld32 (&rmsg->refcount) == 0);
+  if (rmsg->chunk.rbuf == NULL)
+  {
+    /* sample reassembled by the defragmenter into an rmsg of its own */
+    defrag_contig_free (rmsg);
+    return;
+  }
   c = &rmsg->chunk;
   while (c)
   {
@@ -824,6 +1041,26 @@ static void nn_rdata_unref (struct nn_rdata *rdata)
    fragmented message will have at least one interval allocated to it
    and thus have sufficient space for the chain node.
 
+   Samples of at least contiguous_threshold bytes are instead
+   reassembled in a buffer of their own, allocated when the first
+   fragment to arrive shows the size of the sample: an rmsg without an
+   rbuf, preceded by an nn_defrag_contig that provides the memory for
+   the rsample and everything that comes with it.  Each fragment is
+   copied to its offset in the sample when it arrives, so the receive
+   buffers are not held up by samples that take many packets, and the
+   interval tree only keeps track of what has been received (its
+   intervals, allocated on the heap, have empty fragment chains).
+   The complete sample is an rdata covering all of it, stored behind a
+   copy of the submessage header and inline QoS of the first fragment,
+   as an unfragmented sample would be, so that a serdata can take a
+   reference to the buffer rather than copying it (see
+   nn_fragchain_ref_contiguous).
+
+   The space for that header is reserved when allocating the buffer:
+   that of the first fragment if it is the first to arrive, else
+   DEFRAG_CONTIG_HDRSPACE, which ought to be plenty.  If it turns out
+   not to be, the sample is dropped.
+
    FIXME: These AVL trees are overkill.  Either switch to parent-less
    red-black trees (they have better performance anyway and only need
    a single bit of state) or to splay trees (must have a parent
@@ -845,6 +1082,7 @@ struct nn_rsample {
       ddsrt_avl_tree_t fragtree;
       struct nn_defrag_iv *lastfrag;
       struct nn_rsample_info *sampleinfo;
+      struct nn_defrag_contig *contig; /* non-NULL if reassembled contiguously */
       seqno_t seq;
     } defrag;
     struct nn_rsample_reorder {
@@ -856,11 +1094,25 @@ struct nn_rsample {
   } u;
 };
 
+#define DEFRAG_CONTIG_HDRSPACE 1024u
+
+struct nn_defrag_contig {
+  struct nn_rsample rsample;
+  struct nn_rsample_info sampleinfo;
+  struct receiver_state rst;
+  struct nn_rsample_chain_elem sce;
+  struct nn_rdata rdata;
+  struct nn_rmsg *rmsg;
+  uint32_t hdrspace; /* bytes in the payload of rmsg preceding the sample */
+  bool have_hdr;     /* set once the first fragment has been received */
+};
+
 struct nn_defrag {
   ddsrt_avl_tree_t sampletree;
   struct nn_rsample *max_sample; /* = max(sampletree) */
   uint32_t n_samples;
   uint32_t max_samples;
+  uint32_t contiguous_threshold; /* 0 if disabled */
   enum nn_defrag_drop_mode drop_mode;
   uint64_t discarded_bytes;
   const struct ddsrt_log_cfg *logcfg;
@@ -887,7 +1139,7 @@ static int compare_seqno (const void *va, const void *vb)
   return (a == b) ? 0 : (a < b) ? -1 : 1;
 }
 
-struct nn_defrag *nn_defrag_new (const struct ddsrt_log_cfg *logcfg, enum nn_defrag_drop_mode drop_mode, uint32_t max_samples)
+struct nn_defrag *nn_defrag_new (const struct ddsrt_log_cfg *logcfg, enum nn_defrag_drop_mode drop_mode, uint32_t max_samples, uint32_t contiguous_threshold)
 {
   struct nn_defrag *d;
   assert (max_samples >= 1);
@@ -896,6 +1148,7 @@ struct nn_defrag *nn_defrag_new (const struct ddsrt_log_cfg *logcfg, enum nn_def
   ddsrt_avl_init (&defrag_sampletree_treedef, &d->sampletree);
   d->drop_mode = drop_mode;
   d->max_samples = max_samples;
+  d->contiguous_threshold = contiguous_threshold;
   d->n_samples = 0;
   d->max_sample = NULL;
   d->discarded_bytes = 0;
@@ -925,6 +1178,52 @@ static void nn_fragchain_rmbias (struct nn_rdata *frag)
   nn_fragchain_adjust_refcount (frag, 0);
 }
 
+static uint32_t defrag_contig_admsize (void)
+{
+  return align_rmsg ((uint32_t) sizeof (struct nn_defrag_contig));
+}
+
+static void defrag_contig_free (struct nn_rmsg *rmsg)
+{
+  ddsrt_free ((char *) rmsg - defrag_contig_admsize ());
+}
+
+static unsigned char *defrag_contig_sample (const struct nn_defrag_contig *contig)
+{
+  return NN_RMSG_PAYLOADOFF (contig->rmsg, contig->hdrspace);
+}
+
+static void defrag_contig_set_sampleinfo (struct nn_defrag_contig *contig, const struct nn_rsample_info *sampleinfo)
+{
+  /* the receiver state lives in the rmsg of the fragment, which we don't keep */
+  contig->sampleinfo = *sampleinfo;
+  if (sampleinfo->rst)
+  {
+    contig->rst = *sampleinfo->rst;
+    contig->sampleinfo.rst = &contig->rst;
+  }
+}
+
+static bool defrag_contig_add_first (struct nn_defrag_contig *contig, const struct nn_rdata *rdata, const struct nn_rsample_info *sampleinfo)
+{
+  /* submessage header & inline QoS go immediately in front of the sample, as in the packet */
+  const uint32_t hdrsize = NN_RDATA_PAYLOAD_OFF (rdata) - NN_RDATA_SUBMSG_OFF (rdata);
+  assert (rdata->min == 0 && !contig->have_hdr);
+  if (hdrsize > contig->hdrspace)
+    return false;
+  memcpy (defrag_contig_sample (contig) - hdrsize, NN_RMSG_PAYLOADOFF (rdata->rmsg, NN_RDATA_SUBMSG_OFF (rdata)), hdrsize);
+  contig->rdata.submsg_zoff = (uint16_t) NN_OFF_TO_ZOFF (contig->hdrspace - hdrsize);
+  contig->have_hdr = true;
+  defrag_contig_set_sampleinfo (contig, sampleinfo);
+  return true;
+}
+
+static void defrag_contig_add_fragment (struct nn_defrag_contig *contig, const struct nn_rdata *rdata)
+{
+  assert (rdata->maxp1 <= contig->sampleinfo.size);
+  memcpy (defrag_contig_sample (contig) + rdata->min, NN_RMSG_PAYLOADOFF (rdata->rmsg, NN_RDATA_PAYLOAD_OFF (rdata)), rdata->maxp1 - rdata->min);
+}
+
 static void defrag_rsample_drop (struct nn_defrag *defrag, struct nn_rsample *rsample)
 {
   /* Can't reference rsample after the first fragchain_free, because
@@ -940,6 +1239,13 @@ static void defrag_rsample_drop (struct nn_defrag *defrag, struct nn_rsample *rs
   ddsrt_avl_delete (&defrag_sampletree_treedef, &defrag->sampletree, rsample);
   assert (defrag->n_samples > 0);
   defrag->n_samples--;
+  if (rsample->u.defrag.contig)
+  {
+    /* nothing references the buffer until the sample is complete */
+    ddsrt_avl_free (&rsample_defrag_fragtree_treedef, &rsample->u.defrag.fragtree, ddsrt_free);
+    defrag_contig_free (rsample->u.defrag.contig->rmsg);
+    return;
+  }
   for (iv = ddsrt_avl_iter_first (&rsample_defrag_fragtree_treedef, &rsample->u.defrag.fragtree, &iter); iv; iv = ddsrt_avl_iter_next (&iter))
   {
     if (iv->first)
@@ -995,6 +1301,15 @@ static int defrag_try_merge_with_succ (const struct nn_defrag *defrag, struct nn
       TRACE (defrag, "  succ is lastfrag\n");
       sample->lastfrag = node;
     }
+    if (sample->contig)
+    {
+      /* no chains to merge, and the interval is on the heap */
+      const int beyond_succ = node->maxp1 > succ_maxp1;
+      if (!beyond_succ)
+        node->maxp1 = succ_maxp1;
+      ddsrt_free (succ);
+      return beyond_succ;
+    }
 
     /* If succ's chain contains data beyond the frag we just
        received, append it to node (but do note that this doesn't
@@ -1024,13 +1339,22 @@ static int defrag_try_merge_with_succ (const struct nn_defrag *defrag, struct nn
 static void defrag_rsample_addiv (struct nn_rsample_defrag *sample, struct nn_rdata *rdata, ddsrt_avl_ipath_t *path)
 {
   struct nn_defrag_iv *newiv;
-  if ((newiv = nn_rmsg_alloc (rdata->rmsg, sizeof (*newiv))) == NULL)
-    return;
-  rdata->nextfrag = NULL;
-  newiv->first = newiv->last = rdata;
+  if (sample->contig)
+  {
+    newiv = ddsrt_malloc (sizeof (*newiv));
+    newiv->first = newiv->last = NULL;
+    defrag_contig_add_fragment (sample->contig, rdata);
+  }
+  else
+  {
+    if ((newiv = nn_rmsg_alloc (rdata->rmsg, sizeof (*newiv))) == NULL)
+      return;
+    rdata->nextfrag = NULL;
+    newiv->first = newiv->last = rdata;
+    nn_rdata_addbias (rdata);
+  }
   newiv->min = rdata->min;
   newiv->maxp1 = rdata->maxp1;
-  nn_rdata_addbias (rdata);
   ddsrt_avl_insert_ipath (&rsample_defrag_fragtree_treedef, &sample->fragtree, newiv, path);
   if (sample->lastfrag == NULL || rdata->min > sample->lastfrag->min)
     sample->lastfrag = newiv;
@@ -1040,21 +1364,79 @@ static void rsample_init_common (UNUSED_ARG (struct nn_rsample *rsample), UNUSED
 {
 }
 
-static struct nn_rsample *defrag_rsample_new (struct nn_rdata *rdata, const struct nn_rsample_info *sampleinfo)
+static struct nn_defrag_contig *defrag_contig_new (struct nn_rdata *rdata, const struct nn_rsample_info *sampleinfo)
+{
+  /* Layout: nn_defrag_contig, rmsg, header space, sample padded with 0s to a
+     multiple of 4 bytes (as a serdata would be); NULL if the header space
+     can't be addressed or the memory can't be allocated */
+  const uint32_t hdrspace = (rdata->min == 0) ? align_rmsg (NN_RDATA_PAYLOAD_OFF (rdata) - NN_RDATA_SUBMSG_OFF (rdata)) : DEFRAG_CONTIG_HDRSPACE;
+  const size_t padded_size = (size_t) sampleinfo->size + ((0u - sampleinfo->size) % 4);
+  struct nn_defrag_contig *contig;
+  struct nn_rmsg *rmsg;
+  if (hdrspace >= 65536)
+    return NULL;
+  if ((contig = ddsrt_malloc_s (defrag_contig_admsize () + sizeof (*rmsg) + hdrspace + padded_size)) == NULL)
+    return NULL;
+  rmsg = (struct nn_rmsg *) ((char *) contig + defrag_contig_admsize ());
+  ddsrt_atomic_st32 (&rmsg->refcount, 0);
+  rmsg->lastchunk = &rmsg->chunk;
+  rmsg->trace = false; /* RMSGTRACE requires an rbuf */
+  rmsg->chunk.rbuf = NULL;
+  rmsg->chunk.next = NULL;
+  rmsg->chunk.u.size = hdrspace + (uint32_t) padded_size;
+  contig->rmsg = rmsg;
+  contig->hdrspace = hdrspace;
+  contig->have_hdr = false;
+  memset (defrag_contig_sample (contig) + sampleinfo->size, 0, padded_size - sampleinfo->size);
+  contig->rdata.rmsg = rmsg;
+  contig->rdata.nextfrag = NULL;
+  contig->rdata.min = 0;
+  contig->rdata.maxp1 = sampleinfo->size;
+  contig->rdata.submsg_zoff = 0;
+  contig->rdata.payload_zoff = (uint16_t) NN_OFF_TO_ZOFF (hdrspace);
+#ifndef NDEBUG
+  ddsrt_atomic_st32 (&contig->rdata.refcount_bias_added, 0);
+#endif
+  defrag_contig_set_sampleinfo (contig, sampleinfo);
+  if (rdata->min == 0)
+  {
+    const bool ok = defrag_contig_add_first (contig, rdata, sampleinfo);
+    assert (ok);
+    (void) ok;
+  }
+  return contig;
+}
+
+static struct nn_rsample *defrag_rsample_new (const struct nn_defrag *defrag, struct nn_rdata *rdata, const struct nn_rsample_info *sampleinfo)
 {
   struct nn_rsample *rsample;
   struct nn_rsample_defrag *dfsample;
+  struct nn_defrag_contig *contig = NULL;
   ddsrt_avl_ipath_t ivpath;
 
-  if ((rsample = nn_rmsg_alloc (rdata->rmsg, sizeof (*rsample))) == NULL)
-    return NULL;
-  rsample_init_common (rsample, rdata, sampleinfo);
-  dfsample = &rsample->u.defrag;
+  if (defrag->contiguous_threshold > 0 && sampleinfo->size >= defrag->contiguous_threshold)
+    contig = defrag_contig_new (rdata, sampleinfo);
+  if (contig)
+  {
+    TRACE (defrag, "  contiguous %p\n", (void *) contig);
+    rsample = &contig->rsample;
+    rsample_init_common (rsample, rdata, sampleinfo);
+    dfsample = &rsample->u.defrag;
+    dfsample->sampleinfo = &contig->sampleinfo;
+  }
+  else
+  {
+    if ((rsample = nn_rmsg_alloc (rdata->rmsg, sizeof (*rsample))) == NULL)
+      return NULL;
+    rsample_init_common (rsample, rdata, sampleinfo);
+    dfsample = &rsample->u.defrag;
+    if ((dfsample->sampleinfo = nn_rmsg_alloc (rdata->rmsg, sizeof (*dfsample->sampleinfo))) == NULL)
+      return NULL;
+    *dfsample->sampleinfo = *sampleinfo;
+  }
+  dfsample->contig = contig;
   dfsample->lastfrag = NULL;
   dfsample->seq = sampleinfo->seq;
-  if ((dfsample->sampleinfo = nn_rmsg_alloc (rdata->rmsg, sizeof (*dfsample->sampleinfo))) == NULL)
-    return NULL;
-  *dfsample->sampleinfo = *sampleinfo;
 
   ddsrt_avl_init (&rsample_defrag_fragtree_treedef, &dfsample->fragtree);
 
@@ -1062,7 +1444,9 @@ static struct nn_rsample *defrag_rsample_new (struct nn_rdata *rdata, const stru
   if (rdata->min > 0)
   {
     struct nn_defrag_iv *sentinel;
-    if ((sentinel = nn_rmsg_alloc (rdata->rmsg, sizeof (*sentinel))) == NULL)
+    if (contig)
+      sentinel = ddsrt_malloc (sizeof (*sentinel));
+    else if ((sentinel = nn_rmsg_alloc (rdata->rmsg, sizeof (*sentinel))) == NULL)
       return NULL;
     sentinel->first = sentinel->last = NULL;
     sentinel->min = sentinel->maxp1 = 0;
@@ -1137,7 +1521,7 @@ static int is_complete (const struct nn_rsample_defrag *sample)
   }
 }
 
-static void rsample_convert_defrag_to_reorder (struct nn_rsample *sample)
+static void rsample_convert_defrag_to_reorder (struct nn_rsample *sample, struct nn_rdata *rdata)
 {
   /* Converts an rsample as stored in defrag to one as stored in a
      reorder admin. Have to be careful with the ordering, or at least
@@ -1148,11 +1532,33 @@ static void rsample_convert_defrag_to_reorder (struct nn_rsample *sample)
   struct nn_defrag_iv *iv = ddsrt_avl_root_non_empty (&rsample_defrag_fragtree_treedef, &sample->u.defrag.fragtree);
   struct nn_rdata *fragchain = iv->first;
   struct nn_rsample_info *sampleinfo = sample->u.defrag.sampleinfo;
+  struct nn_defrag_contig *contig = sample->u.defrag.contig;
   struct nn_rsample_chain_elem *sce;
   seqno_t seq = sample->u.defrag.seq;
 
-  /* re-use memory fragment interval node for sample chain */
-  sce = (struct nn_rsample_chain_elem *) ddsrt_avl_root_non_empty (&rsample_defrag_fragtree_treedef, &sample->u.defrag.fragtree);
+  if (contig)
+  {
+    /* the buffer now gets referenced like an rdata leaving the
+       defragmenter; the rdata that completed the sample follows it as
+       an empty fragment, because the sample may yet be duplicated in
+       memory allocated from its rmsg (see nn_reorder_rsample_dup_first) */
+    ddsrt_avl_free (&rsample_defrag_fragtree_treedef, &sample->u.defrag.fragtree, ddsrt_free);
+    fragchain = &contig->rdata;
+    ddsrt_atomic_st32 (&contig->rmsg->refcount, RMSG_REFCOUNT_RDATA_BIAS);
+#ifndef NDEBUG
+    ddsrt_atomic_st32 (&fragchain->refcount_bias_added, 1);
+#endif
+    rdata->min = rdata->maxp1 = fragchain->maxp1;
+    rdata->nextfrag = NULL;
+    nn_rdata_addbias (rdata);
+    fragchain->nextfrag = rdata;
+    sce = &contig->sce;
+  }
+  else
+  {
+    /* re-use memory fragment interval node for sample chain */
+    sce = (struct nn_rsample_chain_elem *) iv;
+  }
   sce->fragchain = fragchain;
   sce->next = NULL;
   sce->sampleinfo = sampleinfo;
@@ -1183,6 +1589,19 @@ static struct nn_rsample *defrag_add_fragment (struct nn_defrag *defrag, struct
 
   TRACE (defrag, "  lastfrag %p [%"PRIu32"..%"PRIu32")\n", (void *) dfsample->lastfrag, dfsample->lastfrag->min, dfsample->lastfrag->maxp1);
 
+  if (dfsample->contig && min == 0 && !dfsample->contig->have_hdr)
+  {
+    if (!defrag_contig_add_first (dfsample->contig, rdata, sampleinfo))
+    {
+      TRACE (defrag, "  first fragment header too large for contiguous sample, dropping it\n");
+      defrag->discarded_bytes += sampleinfo->size;
+      defrag_rsample_drop (defrag, sample);
+      if (sample == defrag->max_sample)
+        defrag->max_sample = ddsrt_avl_find_max (&defrag_sampletree_treedef, &defrag->sampletree);
+      return NULL;
+    }
+  }
+
   /* Interval tree is sorted on min offset; each key is unique:
      otherwise one would be wholly contained in another. */
   if (min >= dfsample->lastfrag->min)
@@ -1218,19 +1637,24 @@ static struct nn_rsample *defrag_add_fragment (struct nn_defrag *defrag, struct
        end); this may close the gap to the successor of predeq; predeq
        need not have a fragment chain yet (it may be the sentinel) */
     TRACE (defrag, "  grow predeq with new\n");
-    nn_rdata_addbias (rdata);
-    rdata->nextfrag = NULL;
-    if (predeq->first)
-      predeq->last->nextfrag = rdata;
+    if (dfsample->contig)
+      defrag_contig_add_fragment (dfsample->contig, rdata);
     else
     {
-      /* 'Tis the sentinel => rewrite the sample info so we
-         eventually always use the sample info contributed by the
-         first fragment */
-      predeq->first = rdata;
-      *dfsample->sampleinfo = *sampleinfo;
+      nn_rdata_addbias (rdata);
+      rdata->nextfrag = NULL;
+      if (predeq->first)
+        predeq->last->nextfrag = rdata;
+      else
+      {
+        /* 'Tis the sentinel => rewrite the sample info so we
+           eventually always use the sample info contributed by the
+           first fragment */
+        predeq->first = rdata;
+        *dfsample->sampleinfo = *sampleinfo;
+      }
+      predeq->last = rdata;
     }
-    predeq->last = rdata;
     predeq->maxp1 = maxp1;
     /* it may now be possible to merge with the successor */
     while (defrag_try_merge_with_succ (defrag, dfsample, predeq))
@@ -1246,9 +1670,14 @@ static struct nn_rsample *defrag_add_fragment (struct nn_defrag *defrag, struct
        predeq so the tree structure doesn't change even though the key
        does change */
     TRACE (defrag, "  extending succ %p [%"PRIu32"..%"PRIu32") at head\n", (void *) succ, succ->min, succ->maxp1);
-    nn_rdata_addbias (rdata);
-    rdata->nextfrag = succ->first;
-    succ->first = rdata;
+    if (dfsample->contig)
+      defrag_contig_add_fragment (dfsample->contig, rdata);
+    else
+    {
+      nn_rdata_addbias (rdata);
+      rdata->nextfrag = succ->first;
+      succ->first = rdata;
+    }
     succ->min = min;
     /* new one may cover all of succ & more, in which case we must
        update the max of succ & see if we can merge it with
@@ -1389,7 +1818,7 @@ struct nn_rsample *nn_defrag_rsample (struct nn_defrag *defrag, struct nn_rdata
     /* FIXME: MERGE THIS ONE WITH THE NEXT */
     TRACE (defrag, "  new max sample\n");
     ddsrt_avl_lookup_ipath (&defrag_sampletree_treedef, &defrag->sampletree, &sampleinfo->seq, &path);
-    if ((sample = defrag_rsample_new (rdata, sampleinfo)) == NULL)
+    if ((sample = defrag_rsample_new (defrag, rdata, sampleinfo)) == NULL)
       return NULL;
     ddsrt_avl_insert_ipath (&defrag_sampletree_treedef, &defrag->sampletree, sample, &path);
     defrag->max_sample = sample;
@@ -1401,7 +1830,7 @@ struct nn_rsample *nn_defrag_rsample (struct nn_defrag *defrag, struct nn_rdata
     /* a new sequence number, but smaller than the maximum */
     TRACE (defrag, "  new sample less than max\n");
     assert (sampleinfo->seq < max_seq);
-    if ((sample = defrag_rsample_new (rdata, sampleinfo)) == NULL)
+    if ((sample = defrag_rsample_new (defrag, rdata, sampleinfo)) == NULL)
       return NULL;
     ddsrt_avl_insert_ipath (&defrag_sampletree_treedef, &defrag->sampletree, sample, &path);
     defrag->n_samples++;
@@ -1429,7 +1858,7 @@ struct nn_rsample *nn_defrag_rsample (struct nn_defrag *defrag, struct nn_rdata
       TRACE (defrag, "  updating max_sample: now %p %"PRId64"\n",
              (void *) defrag->max_sample, defrag->max_sample ? defrag->max_sample->u.defrag.seq : 0);
     }
-    rsample_convert_defrag_to_reorder (result);
+    rsample_convert_defrag_to_reorder (result, rdata);
   }
 
   assert (defrag->max_sample == ddsrt_avl_find_max (&defrag_sampletree_treedef, &defrag->sampletree));
@@ -1705,6 +2134,27 @@ void nn_fragchain_unref (struct nn_rdata *frag)
   }
 }
 
+const void *nn_fragchain_ref_contiguous (const struct nn_rdata *fragchain, struct nn_rmsg **rmsg)
+{
+  /* Only the rmsgs of contiguously reassembled samples: those of the
+     receive buffers would keep an entire rbuf alive.  Any thread with
+     a reference to the fragchain may add one. */
+  if (fragchain->rmsg->chunk.rbuf != NULL)
+    return NULL;
+  assert (fragchain->min == 0);
+  assert (fragchain->nextfrag == NULL || fragchain->nextfrag->min == fragchain->maxp1);
+  assert (ddsrt_atomic_ld32 (&fragchain->rmsg->refcount) > 0);
+  ddsrt_atomic_inc32 (&fragchain->rmsg->refcount);
+  *rmsg = fragchain->rmsg;
+  return NN_RMSG_PAYLOADOFF (fragchain->rmsg, NN_RDATA_PAYLOAD_OFF (fragchain));
+}
+
+void nn_rmsg_unref_contiguous (struct nn_rmsg *rmsg)
+{
+  assert (rmsg->chunk.rbuf == NULL);
+  nn_rmsg_unref (rmsg);
+}
+
 void nn_reorder_free (struct nn_reorder *r)
 {
   struct nn_rsample *iv;
@@ -1936,8 +1936,9 @@ struct remote_sourceinfo {
   ddsrt_wctime_t tstamp;
 };
 
-static struct ddsi_serdata *remote_make_sample (struct ddsi_tkmap_instance **tk, struct ddsi_domaingv *gv, struct ddsi_sertopic const * const topic, void *vsourceinfo)
+static struct ddsi_serdata *remote_make_sample (struct ddsi_tkmap_instance **tk, struct ddsi_domaingv *gv, struct reader *rd, void *vsourceinfo)
 {
+  struct ddsi_sertopic const * const topic = rd->topic;
   /* hopefully the compiler figures out that these are just aliases and doesn't reload them
      unnecessarily from memory */
   const struct remote_sourceinfo * __restrict si = vsourceinfo;
@@ -2025,7 +2026,7 @@ static struct ddsi_serdata *remote_make_sample (struct ddsi_tkmap_instance **tk,
   }
   else
   {
-    if ((*tk = ddsi_tkmap_lookup_instance_ref (gv->m_tkmap, sample)) == NULL)
+    if ((*tk = ddsi_tkmap_lookup_instance_ref_cached (gv->m_tkmap, &rd->keyless_tk, sample)) == NULL)
     {
       ddsi_serdata_unref (sample);
       sample = NULL;
@@ -3174,6 +3175,56 @@ malformed:
   return -1;
 }
 
+/* Interprets the packet of size sz that has been read into rmsg, and commits rmsg */
+static bool handle_packet (struct thread_state1 * const ts1, struct ddsi_domaingv *gv, ddsi_tran_conn_t conn, const ddsi_guid_prefix_t *guidprefix, struct nn_rbufpool *rbpool, struct nn_rmsg *rmsg, ssize_t sz, const nn_locator_t *srcloc)
+{
+  unsigned char * buff = (unsigned char *) NN_RMSG_PAYLOAD (rmsg);
+  Header_t * hdr = (Header_t*) buff;
+
+  if (sz > 0 && !gv->deaf)
+  {
+    nn_rmsg_setsize (rmsg, (uint32_t) sz);
+    assert (thread_is_asleep ());
+
+    if ((size_t)sz < RTPS_MESSAGE_HEADER_SIZE || *(uint32_t *)buff != NN_PROTOCOLID_AS_UINT32)
+    {
+      /* discard packets that are really too small or don't have magic cookie */
+    }
+    else if (hdr->version.major != RTPS_MAJOR || (hdr->version.major == RTPS_MAJOR && hdr->version.minor < RTPS_MINOR_MINIMUM))
+    {
+      if ((hdr->version.major == RTPS_MAJOR && hdr->version.minor < RTPS_MINOR_MINIMUM))
+        GVTRACE ("HDR(%"PRIx32":%"PRIx32":%"PRIx32" vendor %d.%d) len %lu\n, version mismatch: %d.%d\n",
+                 PGUIDPREFIX (hdr->guid_prefix), hdr->vendorid.id[0], hdr->vendorid.id[1], (unsigned long) sz, hdr->version.major, hdr->version.minor);
+      if (NN_PEDANTIC_P (gv->config))
+        malformed_packet_received_nosubmsg (gv, buff, sz, "header", hdr->vendorid);
+    }
+    else
+    {
+      hdr->guid_prefix = nn_ntoh_guid_prefix (hdr->guid_prefix);
+
+      if (gv->logconfig.c.mask & DDS_LC_TRACE)
+      {
+        char addrstr[DDSI_LOCSTRLEN];
+        ddsi_locator_to_string(addrstr, sizeof(addrstr), srcloc);
+        GVTRACE ("HDR(%"PRIx32":%"PRIx32":%"PRIx32" vendor %d.%d) len %lu from %s\n",
+                 PGUIDPREFIX (hdr->guid_prefix), hdr->vendorid.id[0], hdr->vendorid.id[1], (unsigned long) sz, addrstr);
+      }
+      nn_rtps_msg_state_t res = decode_rtps_message (ts1, gv, &rmsg, &hdr, &buff, &sz, rbpool, conn->m_stream);
+      if (res != NN_RTPS_MSG_STATE_ERROR)
+      {
+        handle_submsg_sequence (ts1, gv, conn, srcloc, ddsrt_time_wallclock (), ddsrt_time_elapsed (), &hdr->guid_prefix, guidprefix, buff, (size_t) sz, buff + RTPS_MESSAGE_HEADER_SIZE, rmsg, res == NN_RTPS_MSG_STATE_ENCODED);
+      }
+      else
+      {
+        /* drop message */
+        sz = 1;
+      }
+    }
+  }
+  nn_rmsg_commit (rmsg);
+  return (sz > 0);
+}
+
 static bool do_packet (struct thread_state1 * const ts1, struct ddsi_domaingv *gv, ddsi_tran_conn_t conn, const ddsi_guid_prefix_t *guidprefix, struct nn_rbufpool *rbpool)
 {
   /* UDP max packet size is 64kB */
@@ -3257,48 +3308,54 @@ static bool do_packet (struct thread_state1 * const ts1, struct ddsi_domaingv *g
     sz = ddsi_conn_read (conn, buff, buff_len, true, &srcloc);
   }
 
-  if (sz > 0 && !gv->deaf)
+  return handle_packet (ts1, gv, conn, guidprefix, rbpool, rmsg, sz, &srcloc);
+}
+
+/* Datagrams read in one go by a receive thread, as far as the transport
+   supports it: this saves a system call for each datagram that arrives in a
+   burst, at the cost of copying each of them into its own rmsg, as only one rmsg
+   at a time can be allocated from the receive buffer */
+#define RECV_BATCH_SIZE 16
+
+struct recv_batch {
+  unsigned char *mem;
+  struct ddsi_tran_rbuf bufs[RECV_BATCH_SIZE];
+};
+
+static void recv_batch_init (struct recv_batch *batch, const struct ddsi_domaingv *gv)
+{
+  /* UDP max packet size is 64kB */
+  const size_t maxsz = gv->config.rmsg_chunk_size < 65536 ? gv->config.rmsg_chunk_size : 65536;
+  batch->mem = ddsrt_malloc (RECV_BATCH_SIZE * maxsz);
+  for (int i = 0; i < RECV_BATCH_SIZE; i++)
   {
-    nn_rmsg_setsize (rmsg, (uint32_t) sz);
-    assert (thread_is_asleep ());
+    batch->bufs[i].buf = batch->mem + (size_t) i * maxsz;
+    batch->bufs[i].len = maxsz;
+  }
+}
 
-    if ((size_t)sz < RTPS_MESSAGE_HEADER_SIZE || *(uint32_t *)buff != NN_PROTOCOLID_AS_UINT32)
-    {
-      /* discard packets that are really too small or don't have magic cookie */
-    }
-    else if (hdr->version.major != RTPS_MAJOR || (hdr->version.major == RTPS_MAJOR && hdr->version.minor < RTPS_MINOR_MINIMUM))
-    {
-      if ((hdr->version.major == RTPS_MAJOR && hdr->version.minor < RTPS_MINOR_MINIMUM))
-        GVTRACE ("HDR(%"PRIx32":%"PRIx32":%"PRIx32" vendor %d.%d) len %lu\n, version mismatch: %d.%d\n",
-                 PGUIDPREFIX (hdr->guid_prefix), hdr->vendorid.id[0], hdr->vendorid.id[1], (unsigned long) sz, hdr->version.major, hdr->version.minor);
-      if (NN_PEDANTIC_P (gv->config))
-        malformed_packet_received_nosubmsg (gv, buff, sz, "header", hdr->vendorid);
-    }
-    else
-    {
-      hdr->guid_prefix = nn_ntoh_guid_prefix (hdr->guid_prefix);
+static void recv_batch_fini (struct recv_batch *batch)
+{
+  ddsrt_free (batch->mem);
+}
 
-      if (gv->logconfig.c.mask & DDS_LC_TRACE)
-      {
-        char addrstr[DDSI_LOCSTRLEN];
-        ddsi_locator_to_string(addrstr, sizeof(addrstr), &srcloc);
-        GVTRACE ("HDR(%"PRIx32":%"PRIx32":%"PRIx32" vendor %d.%d) len %lu from %s\n",
-                 PGUIDPREFIX (hdr->guid_prefix), hdr->vendorid.id[0], hdr->vendorid.id[1], (unsigned long) sz, addrstr);
-      }
-      nn_rtps_msg_state_t res = decode_rtps_message (ts1, gv, &rmsg, &hdr, &buff, &sz, rbpool, conn->m_stream);
-      if (res != NN_RTPS_MSG_STATE_ERROR)
-      {
-        handle_submsg_sequence (ts1, gv, conn, &srcloc, ddsrt_time_wallclock (), ddsrt_time_elapsed (), &hdr->guid_prefix, guidprefix, buff, (size_t) sz, buff + RTPS_MESSAGE_HEADER_SIZE, rmsg, res == NN_RTPS_MSG_STATE_ENCODED);
-      }
-      else
-      {
-        /* drop message */
-        sz = 1;
-      }
-    }
+static bool do_packet_batch (struct thread_state1 * const ts1, struct ddsi_domaingv *gv, ddsi_tran_conn_t conn, const ddsi_guid_prefix_t *guidprefix, struct nn_rbufpool *rbpool, struct recv_batch *batch)
+{
+  const int n = ddsi_conn_read_batch (conn, batch->bufs, RECV_BATCH_SIZE);
+  for (int i = 0; i < n; i++)
+  {
+    struct nn_rmsg * rmsg = nn_rmsg_new (rbpool);
+    if (rmsg == NULL)
+      return false;
+    memcpy (NN_RMSG_PAYLOAD (rmsg), batch->bufs[i].buf, batch->bufs[i].size);
+    (void) handle_packet (ts1, gv, conn, guidprefix, rbpool, rmsg, (ssize_t) batch->bufs[i].size, &batch->bufs[i].srcloc);
   }
-  nn_rmsg_commit (rmsg);
-  return (sz > 0);
+  return (n > 0);
+}
+
+static bool use_packet_batch (const struct ddsi_tran_conn *conn)
+{
+  return conn->m_connless && !conn->m_stream && ddsi_conn_supports_read_batch (conn);
 }
 
 struct local_participant_desc
@@ -3452,8 +3509,12 @@ static int recv_thread_waitset_add_conn (os_sockWaitset ws, ddsi_tran_conn_t con
   {
     struct ddsi_domaingv *gv = conn->m_base.gv;
     for (uint32_t i = 0; i < gv->n_recv_threads; i++)
+    {
       if (gv->recv_threads[i].arg.mode == RTM_SINGLE && gv->recv_threads[i].arg.u.single.conn == conn)
         return 0;
+      if (gv->recv_threads[i].arg.mode == RTM_MANY && gv->recv_threads[i].arg.u.many.conn == conn && gv->recv_threads[i].arg.u.many.ws != ws)
+        return 0;
+    }
     return os_sockWaitsetAdd (ws, conn);
   }
 }
@@ -3494,15 +3555,21 @@ uint32_t recv_thread (void *vrecv_thread_arg)
   struct nn_rbufpool *rbpool = recv_thread_arg->rbpool;
   os_sockWaitset waitset = recv_thread_arg->mode == RTM_MANY ? recv_thread_arg->u.many.ws : NULL;
   ddsrt_mtime_t next_thread_cputime = { 0 };
+  struct recv_batch batch;
 
   nn_rbufpool_setowner (rbpool, ddsrt_thread_self ());
+  recv_batch_init (&batch, gv);
   if (waitset == NULL)
   {
     struct ddsi_tran_conn *conn = recv_thread_arg->u.single.conn;
+    const bool batched = use_packet_batch (conn);
     while (ddsrt_atomic_ld32 (&gv->rtps_keepgoing))
     {
       LOG_THREAD_CPUTIME (&gv->logconfig, next_thread_cputime);
-      (void) do_packet (ts1, gv, conn, NULL, rbpool);
+      if (batched)
+        (void) do_packet_batch (ts1, gv, conn, NULL, rbpool, &batch);
+      else
+        (void) do_packet (ts1, gv, conn, NULL, rbpool);
     }
   }
   else
@@ -3511,7 +3578,14 @@ uint32_t recv_thread (void *vrecv_thread_arg)
     unsigned num_fixed = 0, num_fixed_uc = 0;
     os_sockWaitsetCtx ctx;
     local_participant_set_init (&lps, &gv->participant_set_generation);
-    if (gv->m_factory->m_connless)
+    if (recv_thread_arg->u.many.conn)
+    {
+      /* dedicated to one connection, but woken up through the waitset */
+      if (recv_thread_waitset_add_conn (waitset, recv_thread_arg->u.many.conn) < 0)
+        DDS_FATAL("recv_thread: failed to add connection to waitset\n");
+      num_fixed = 1;
+    }
+    else if (gv->m_factory->m_connless)
     {
       int rc;
       if ((rc = recv_thread_waitset_add_conn (waitset, gv->disc_conn_uc)) < 0)
@@ -3533,7 +3607,7 @@ uint32_t recv_thread (void *vrecv_thread_arg)
     {
       int rebuildws = 0;
       LOG_THREAD_CPUTIME (&gv->logconfig, next_thread_cputime);
-      if (gv->config.many_sockets_mode != MSM_MANY_UNICAST)
+      if (gv->config.many_sockets_mode != MSM_MANY_UNICAST || recv_thread_arg->u.many.conn)
       {
         /* no other sockets to check */
       }
@@ -3567,12 +3641,15 @@ uint32_t recv_thread (void *vrecv_thread_arg)
           else
             guid_prefix = &lps.ps[(unsigned)idx - num_fixed].guid_prefix;
           /* Process message and clean out connection if failed or closed */
-          if (!do_packet (ts1, gv, conn, guid_prefix, rbpool) && !conn->m_connless)
+          if (use_packet_batch (conn))
+            (void) do_packet_batch (ts1, gv, conn, guid_prefix, rbpool, &batch);
+          else if (!do_packet (ts1, gv, conn, guid_prefix, rbpool) && !conn->m_connless)
             ddsi_conn_free (conn);
         }
       }
     }
     local_participant_set_fini (&lps);
   }
+  recv_batch_fini (&batch);
   return 0;
 }
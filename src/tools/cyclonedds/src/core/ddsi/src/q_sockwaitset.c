@@ -27,9 +27,12 @@
 #define MODE_KQUEUE 1
 #define MODE_SELECT 2
 #define MODE_WFMEVS 3
+#define MODE_EPOLL 4
 
 #if defined __APPLE__
 #define MODE_SEL MODE_KQUEUE
+#elif defined __linux__ && !LWIP_SOCKET
+#define MODE_SEL MODE_EPOLL
 #elif defined WINCE
 #define MODE_SEL MODE_WFMEVS
 #else
@@ -281,6 +284,293 @@ int os_sockWaitsetNextEvent (os_sockWaitsetCtx ctx, ddsi_tran_conn_t *conn)
   return -1;
 }
 
+#elif MODE_SEL == MODE_EPOLL
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+
+/* Same model as the select-based version: connections are kept in an array,
+   with the trigger pipe at index 0, and the wait reports the index of each
+   connection that is readable.  The difference is that the kernel maintains
+   the set of descriptors, so a wait costs O(ready) rather than O(added).
+
+   Events are level-triggered: a wakeup for a socket results in reading a single
+   datagram (or a small batch), so anything left has to cause another wakeup.
+   Edge-triggered events would lose wakeups for the remainder, and one-shot
+   events would require re-arming every socket after each event.
+
+   The epoll data of each descriptor holds its index in the array and the
+   descriptor itself, so that a stale event (for a connection removed while the
+   events were being handled) can be recognised and skipped. */
+
+typedef struct os_sockWaitsetSet
+{
+  ddsi_tran_conn_t * conns;  /* connections in set */
+  int * fds;                 /* file descriptors in set */
+  unsigned sz;               /* max number of fds in set */
+  unsigned n;                /* actual number of fds in set */
+} os_sockWaitsetSet;
+
+struct os_sockWaitsetCtx
+{
+  os_sockWaitsetSet set;     /* copy of the set at the time of waiting */
+  struct epoll_event *evs;
+  unsigned evs_sz;
+  unsigned nevs;
+  unsigned index;            /* cursor for enumerating */
+};
+
+struct os_sockWaitset
+{
+  int epoll;
+  int pipe[2];                   /* pipe used for triggering */
+  ddsrt_mutex_t mutex;           /* concurrency guard */
+  os_sockWaitsetSet set;         /* set of descriptors handled next */
+  struct os_sockWaitsetCtx ctx;  /* set of descriptors being handled */
+};
+
+static void os_sockWaitsetNewSet (os_sockWaitsetSet * set)
+{
+  set->fds = ddsrt_malloc (WAITSET_DELTA * sizeof (*set->fds));
+  set->conns = ddsrt_malloc (WAITSET_DELTA * sizeof (*set->conns));
+  set->sz = WAITSET_DELTA;
+  set->n = 1;
+}
+
+static void os_sockWaitsetFreeSet (os_sockWaitsetSet * set)
+{
+  ddsrt_free (set->fds);
+  ddsrt_free (set->conns);
+}
+
+static void os_sockWaitsetGrow (os_sockWaitsetSet * set)
+{
+  set->sz += WAITSET_DELTA;
+  set->conns = ddsrt_realloc (set->conns, set->sz * sizeof (*set->conns));
+  set->fds = ddsrt_realloc (set->fds, set->sz * sizeof (*set->fds));
+}
+
+static int epoll_set_entry (int epfd, int op, int fd, unsigned idx)
+{
+  struct epoll_event ev;
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN;
+  ev.data.u64 = ((uint64_t) idx << 32) | (uint32_t) fd;
+  return epoll_ctl (epfd, op, fd, &ev);
+}
+
+static int make_epoll (os_sockWaitset ws)
+{
+  if ((ws->epoll = epoll_create1 (EPOLL_CLOEXEC)) == -1)
+    return -1;
+  if (epoll_set_entry (ws->epoll, EPOLL_CTL_ADD, ws->pipe[0], 0) == -1)
+  {
+    close (ws->epoll);
+    return -1;
+  }
+  return 0;
+}
+
+os_sockWaitset os_sockWaitsetNew (void)
+{
+  os_sockWaitset ws = ddsrt_malloc (sizeof (*ws));
+  if (pipe (ws->pipe) == -1)
+    goto fail_pipe;
+  if (fcntl (ws->pipe[0], F_SETFD, fcntl (ws->pipe[0], F_GETFD) | FD_CLOEXEC) == -1)
+    goto fail_fcntl;
+  if (fcntl (ws->pipe[1], F_SETFD, fcntl (ws->pipe[1], F_GETFD) | FD_CLOEXEC) == -1)
+    goto fail_fcntl;
+  if (make_epoll (ws) == -1)
+    goto fail_epoll;
+  os_sockWaitsetNewSet (&ws->set);
+  ws->set.fds[0] = ws->pipe[0];
+  ws->set.conns[0] = NULL;
+  os_sockWaitsetNewSet (&ws->ctx.set);
+  ws->ctx.set.n = 0;
+  ws->ctx.evs_sz = WAITSET_DELTA;
+  ws->ctx.evs = ddsrt_malloc (ws->ctx.evs_sz * sizeof (*ws->ctx.evs));
+  ws->ctx.nevs = 0;
+  ws->ctx.index = 0;
+  ddsrt_mutex_init (&ws->mutex);
+  return ws;
+
+fail_epoll:
+fail_fcntl:
+  close (ws->pipe[0]);
+  close (ws->pipe[1]);
+fail_pipe:
+  ddsrt_free (ws);
+  return NULL;
+}
+
+void os_sockWaitsetFree (os_sockWaitset ws)
+{
+  close (ws->epoll);
+  close (ws->pipe[0]);
+  close (ws->pipe[1]);
+  os_sockWaitsetFreeSet (&ws->set);
+  os_sockWaitsetFreeSet (&ws->ctx.set);
+  ddsrt_free (ws->ctx.evs);
+  ddsrt_mutex_destroy (&ws->mutex);
+  ddsrt_free (ws);
+}
+
+void os_sockWaitsetTrigger (os_sockWaitset ws)
+{
+  char buf = 0;
+  int n;
+  n = (int) write (ws->pipe[1], &buf, 1);
+  if (n != 1)
+  {
+    DDS_WARNING("os_sockWaitsetTrigger: write failed on trigger pipe, errno = %d\n", errno);
+  }
+}
+
+int os_sockWaitsetAdd (os_sockWaitset ws, ddsi_tran_conn_t conn)
+{
+  const int fd = ddsi_conn_handle (conn);
+  os_sockWaitsetSet * set = &ws->set;
+  unsigned idx;
+  int ret;
+
+  assert (fd >= 0);
+  ddsrt_mutex_lock (&ws->mutex);
+  for (idx = 0; idx < set->n; idx++)
+  {
+    if (set->conns[idx] == conn)
+      break;
+  }
+  if (idx < set->n)
+    ret = 0;
+  else if (epoll_set_entry (ws->epoll, EPOLL_CTL_ADD, fd, set->n) == -1)
+    ret = -1;
+  else
+  {
+    if (set->n == set->sz)
+      os_sockWaitsetGrow (set);
+    set->conns[set->n] = conn;
+    set->fds[set->n] = fd;
+    set->n++;
+    ret = 1;
+  }
+  ddsrt_mutex_unlock (&ws->mutex);
+  return ret;
+}
+
+void os_sockWaitsetPurge (os_sockWaitset ws, unsigned index)
+{
+  /* Sockets may have been closed by the time Purge is called, and their file
+     descriptors reused, so deleting them could affect the wrong socket: start
+     over with a new epoll set containing only the ones that are kept */
+  os_sockWaitsetSet * set = &ws->set;
+
+  ddsrt_mutex_lock (&ws->mutex);
+  if (index + 1 < set->n)
+  {
+    close (ws->epoll);
+    if (make_epoll (ws) == -1)
+      abort (); /* FIXME */
+    for (unsigned i = 1; i <= index; i++)
+    {
+      if (epoll_set_entry (ws->epoll, EPOLL_CTL_ADD, set->fds[i], i) == -1)
+        abort (); /* FIXME */
+    }
+    for (unsigned i = index + 1; i < set->n; i++)
+    {
+      set->conns[i] = NULL;
+      set->fds[i] = -1;
+    }
+    set->n = index + 1;
+  }
+  ddsrt_mutex_unlock (&ws->mutex);
+}
+
+void os_sockWaitsetRemove (os_sockWaitset ws, ddsi_tran_conn_t conn)
+{
+  os_sockWaitsetSet * set = &ws->set;
+
+  ddsrt_mutex_lock (&ws->mutex);
+  for (unsigned i = 1; i < set->n; i++)
+  {
+    if (conn == set->conns[i])
+    {
+      /* the socket is still open, closing it is what follows removing it */
+      (void) epoll_ctl (ws->epoll, EPOLL_CTL_DEL, set->fds[i], NULL);
+      set->n--;
+      if (i != set->n)
+      {
+        set->fds[i] = set->fds[set->n];
+        set->conns[i] = set->conns[set->n];
+        (void) epoll_set_entry (ws->epoll, EPOLL_CTL_MOD, set->fds[i], i);
+      }
+      break;
+    }
+  }
+  ddsrt_mutex_unlock (&ws->mutex);
+}
+
+os_sockWaitsetCtx os_sockWaitsetWait (os_sockWaitset ws)
+{
+  os_sockWaitsetCtx ctx = &ws->ctx;
+  os_sockWaitsetSet * dst = &ctx->set;
+  os_sockWaitsetSet * src = &ws->set;
+  int nevs;
+
+  ddsrt_mutex_lock (&ws->mutex);
+  while (dst->sz < src->sz)
+    os_sockWaitsetGrow (dst);
+  memcpy (dst->conns, src->conns, src->n * sizeof (*dst->conns));
+  memcpy (dst->fds, src->fds, src->n * sizeof (*dst->fds));
+  dst->n = src->n;
+  ddsrt_mutex_unlock (&ws->mutex);
+
+  /* if the array of events is smaller than the number of file descriptors,
+     the kernel returns what fits and the others follow on the next call */
+  if (ctx->evs_sz < dst->sz)
+  {
+    ctx->evs_sz = dst->sz;
+    ctx->evs = ddsrt_realloc (ctx->evs, ctx->evs_sz * sizeof (*ctx->evs));
+  }
+  do {
+    nevs = epoll_wait (ws->epoll, ctx->evs, (int) ctx->evs_sz, -1);
+  } while (nevs == -1 && errno == EINTR);
+  if (nevs == -1)
+  {
+    DDS_WARNING("os_sockWaitsetWait: epoll_wait failed, errno = %d\n", errno);
+    return NULL;
+  }
+  ctx->nevs = (unsigned) nevs;
+  ctx->index = 0;
+  return ctx;
+}
+
+int os_sockWaitsetNextEvent (os_sockWaitsetCtx ctx, ddsi_tran_conn_t * conn)
+{
+  while (ctx->index < ctx->nevs)
+  {
+    const uint64_t data = ctx->evs[ctx->index++].data.u64;
+    const unsigned idx = (unsigned) (data >> 32);
+    const int fd = (int) (uint32_t) data;
+    if (idx == 0)
+    {
+      /* trigger pipe, read & try again */
+      char buf;
+      if (read (fd, &buf, 1) != 1)
+      {
+        DDS_WARNING("os_sockWaitsetNextEvent: read failed on trigger pipe\n");
+      }
+    }
+    else if (idx < ctx->set.n && ctx->set.fds[idx] == fd)
+    {
+      *conn = ctx->set.conns[idx];
+      return (int) (idx - 1);
+    }
+  }
+  return -1;
+}
+
 #elif MODE_SEL == MODE_WFMEVS
 
 struct os_sockWaitsetCtx
@@ -10,13 +10,16 @@
  * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
  */
 #include <assert.h>
+#include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "dds/ddsrt/cdtors.h"
+#include "dds/ddsrt/environ.h"
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/log.h"
 #include "dds/ddsrt/string.h"
+#include "dds/ddsrt/strtol.h"
 #include "dds/ddsrt/sync.h"
 #include "dds/ddsrt/threads.h"
 #include "dds/ddsrt/misc.h"
@@ -276,10 +279,31 @@ static struct thread_state1 *init_thread_state (const char *tname, const struct
   return ts1;
 }
 
+/* Launch files can't easily edit the configuration, so the scheduling priority and the
+   affinity of a thread may also be set with CYCLONEDDS_THREAD_<NAME>_PRIORITY and
+   CYCLONEDDS_THREAD_<NAME>_AFFINITY, where NAME is the thread name in upper case with
+   anything but letters and digits replaced by underscores, e.g. DQ_BUILTINS. These
+   override the configuration, and a priority implies the realtime class. */
+static const char *thread_env_override (const char *name, const char *what)
+{
+  char var[64];
+  size_t pos = ddsrt_strlcpy (var, "CYCLONEDDS_THREAD_", sizeof (var));
+  for (const char *c = name; *c && pos < sizeof (var) - 1; c++)
+    var[pos++] = isalnum ((unsigned char) *c) ? (char) toupper ((unsigned char) *c) : '_';
+  var[pos] = 0;
+  (void) ddsrt_strlcat (var, "_", sizeof (var));
+  if (ddsrt_strlcat (var, what, sizeof (var)) >= sizeof (var))
+    return NULL;
+  const char *value;
+  return (ddsrt_getenv (var, &value) == DDS_RETCODE_OK && *value) ? value : NULL;
+}
+
 static dds_return_t create_thread_int (struct thread_state1 **ts1_out, const struct ddsi_domaingv *gv, struct config_thread_properties_listelem const * const tprops, const char *name, uint32_t (*f) (void *arg), void *arg)
 {
   ddsrt_threadattr_t tattr;
   struct thread_state1 *ts1;
+  uint32_t affinity[MAX_THREAD_AFFINITY_CPUS];
+  const char *affinity_str = NULL, *env;
   ddsrt_mutex_lock (&thread_states.lock);
 
   ts1 = *ts1_out = init_thread_state (name, gv, THREAD_STATE_INIT);
@@ -296,10 +320,37 @@ static dds_return_t create_thread_int (struct thread_state1 **ts1_out, const str
     tattr.schedClass = tprops->sched_class; /* explicit default value in the enum */
     if (!tprops->stack_size.isdefault)
       tattr.stackSize = tprops->stack_size.value;
+    affinity_str = tprops->affinity;
+  }
+  if ((env = thread_env_override (name, "PRIORITY")) != NULL)
+  {
+    long long prio;
+    char *end;
+    if (ddsrt_strtoll (env, &end, 10, &prio) == DDS_RETCODE_OK && *end == 0 && prio >= INT32_MIN && prio <= INT32_MAX)
+    {
+      tattr.schedClass = DDSRT_SCHED_REALTIME;
+      tattr.schedPriority = (int32_t) prio;
+    }
+    else
+    {
+      DDS_WARNING ("create_thread: %s: ignoring priority '%s': not a decimal integer\n", name, env);
+    }
+  }
+  if ((env = thread_env_override (name, "AFFINITY")) != NULL)
+  {
+    if (config_parse_cpu_list (env, NULL) > 0)
+      affinity_str = env;
+    else
+      DDS_WARNING ("create_thread: %s: ignoring affinity '%s': not a list of CPU numbers\n", name, env);
+  }
+  if (affinity_str != NULL)
+  {
+    tattr.affinityCount = (uint32_t) config_parse_cpu_list (affinity_str, affinity);
+    tattr.affinity = affinity;
   }
   if (gv)
   {
-    GVTRACE ("create_thread: %s: class %d priority %"PRId32" stack %"PRIu32"\n", name, (int) tattr.schedClass, tattr.schedPriority, tattr.stackSize);
+    GVTRACE ("create_thread: %s: class %d priority %"PRId32" stack %"PRIu32" affinity %s\n", name, (int) tattr.schedClass, tattr.schedPriority, tattr.stackSize, affinity_str ? affinity_str : "default");
   }
 
   if (ddsrt_thread_create (&ts1->tid, name, &tattr, &create_thread_wrapper, ts1) != DDS_RETCODE_OK)
@@ -770,6 +770,47 @@ static int must_skip_frag (const char *frags_to_skip, unsigned frag)
 }
 #endif
 
+/* Fragments of large samples written by a writer with a pacing rate (see
+   Internal/FragmentPacing) go out at that rate, with a token bucket allowing
+   bursts of the configured size.  New data waits until the bucket is no longer
+   in debt, retransmits are queued and sent by the event thread without waiting
+   but still consume tokens, so a storm of NACKs slows down new data rather than
+   adding to it.  Returns how long to wait, must be called with wr->e.lock held. */
+static int64_t writer_pacing_charge (struct writer *wr, size_t size, bool isnew)
+{
+  const int64_t bucket_size = (int64_t) wr->e.gv->config.fragment_pacing_bucket_size;
+  const ddsrt_mtime_t tnow = ddsrt_time_monotonic ();
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  assert (wr->pacing_rate > 0);
+  /* limiting the interval keeps dt * rate well within range */
+  int64_t dt = tnow.v - wr->pacing_tupdate.v;
+  if (dt > DDS_SECS (4))
+    dt = DDS_SECS (4);
+  if (dt > 0)
+  {
+    wr->pacing_tokens += dt * (int64_t) wr->pacing_rate / DDS_NSECS_IN_SEC;
+    if (wr->pacing_tokens > bucket_size)
+      wr->pacing_tokens = bucket_size;
+    wr->pacing_tupdate = tnow;
+  }
+  wr->pacing_tokens -= (int64_t) size;
+  if (!isnew)
+  {
+    /* don't let retransmits block new data indefinitely */
+    if (wr->pacing_tokens < -bucket_size)
+      wr->pacing_tokens = -bucket_size;
+    return 0;
+  }
+  else if (wr->pacing_tokens >= 0)
+  {
+    return 0;
+  }
+  else
+  {
+    return -wr->pacing_tokens * DDS_NSECS_IN_SEC / (int64_t) wr->pacing_rate;
+  }
+}
+
 static void transmit_sample_lgmsg_unlocks_wr (struct nn_xpack *xp, struct writer *wr, seqno_t seq, const struct ddsi_plist *plist, struct ddsi_serdata *serdata, struct proxy_reader *prd, int isnew, uint32_t nfrags, uint32_t nfrags_lim)
 {
 #if 0
@@ -805,8 +846,15 @@ static void transmit_sample_lgmsg_unlocks_wr (struct nn_xpack *xp, struct writer
       // more fragment messages to come
       create_HeartbeatFrag (wr, seq, i + nf_in_submsg - 1, prd, &hmsg);
     }
+    const int64_t pacing_delay = (fmsg && wr->pacing_rate) ? writer_pacing_charge (wr, nn_xmsg_size (fmsg), isnew) : 0;
     ddsrt_mutex_unlock (&wr->e.lock);
 
+    if (pacing_delay > 0)
+    {
+      /* get the preceding fragments out before waiting */
+      nn_xpack_send (xp, true);
+      dds_sleepfor (pacing_delay);
+    }
     if(fmsg) nn_xpack_addmsg (xp, fmsg, 0);
     if(hmsg) nn_xpack_addmsg (xp, hmsg, 0);
 
@@ -905,6 +953,8 @@ int enqueue_sample_wrlock_held (struct writer *wr, seqno_t seq, const struct dds
       const int force = 0;
       if(fmsg)
       {
+        if (wr->pacing_rate)
+          (void) writer_pacing_charge (wr, nn_xmsg_size (fmsg), false);
         enqueued = qxev_msg_rexmit_wrlock_held (wr->evq, fmsg, force);
       }
       /* Functioning of the system is not dependent on getting the
@@ -1270,6 +1320,7 @@ static int write_sample_eot (struct thread_state1 * const ts1, struct nn_xpack *
   serdata->twrite = tnow;
 
   seq = ++wr->seq;
+  wr->write_bytes += ddsi_serdata_size (serdata);
   if (wr->cs_seq != 0)
   {
     if (plist == NULL)
@@ -18,6 +18,7 @@
 
 #include "dds/ddsrt/avl.h"
 #include "dds/ddsrt/fibheap.h"
+#include "dds/ddsi/ddsi_timerwheel.h"
 
 #include "dds/ddsi/q_log.h"
 #include "dds/ddsi/q_addrset.h"
@@ -65,7 +66,10 @@ enum xeventkind
 
 struct xevent
 {
-  ddsrt_fibheap_node_t heapnode;
+  union {
+    ddsrt_fibheap_node_t heap;
+    ddsi_timerwheel_node_t wheel;
+  } qnode;
   struct xeventq *evq;
   ddsrt_mtime_t tsched;
   enum xeventkind kind;
@@ -81,6 +85,7 @@ struct xevent
       ddsi_guid_t pp_guid;
       ddsi_guid_prefix_t dest_proxypp_guid_prefix; /* only if "directed" */
       int directed; /* if 0, undirected; if > 0, number of directed ones to send in reasonably short succession */
+      int burst; /* if undirected, number of initial burst ones still to send */
     } spdp;
     struct {
       ddsi_guid_t pp_guid;
@@ -141,7 +146,9 @@ struct xevent_nt
 };
 
 struct xeventq {
+  /* timed events are in the timer wheel if there is one, else in the heap */
   ddsrt_fibheap_t xevents;
+  ddsi_timerwheel_t *wheel;
   ddsrt_avl_tree_t msg_xevents;
   struct xevent_nt *non_timed_xmit_list_oldest;
   struct xevent_nt *non_timed_xmit_list_newest; /* undefined if ..._oldest == NULL */
@@ -168,7 +175,8 @@ static void handle_nontimed_xevent (struct xevent_nt *xev, struct nn_xpack *xp);
 
 static const ddsrt_avl_treedef_t msg_xevents_treedef = DDSRT_AVL_TREEDEF_INITIALIZER_INDKEY (offsetof (struct xevent_nt, u.msg_rexmit.msg_avlnode), offsetof (struct xevent_nt, u.msg_rexmit.msg), msg_xevents_cmp, 0);
 
-static const ddsrt_fibheap_def_t evq_xevents_fhdef = DDSRT_FIBHEAPDEF_INITIALIZER(offsetof (struct xevent, heapnode), compare_xevent_tsched);
+static const ddsrt_fibheap_def_t evq_xevents_fhdef = DDSRT_FIBHEAPDEF_INITIALIZER(offsetof (struct xevent, qnode.heap), compare_xevent_tsched);
+static const ddsi_timerwheel_def_t evq_xevents_twdef = DDSI_TIMERWHEELDEF_INITIALIZER(offsetof (struct xevent, qnode.wheel), offsetof (struct xevent, tsched.v));
 
 static int compare_xevent_tsched (const void *va, const void *vb)
 {
@@ -177,6 +185,49 @@ static int compare_xevent_tsched (const void *va, const void *vb)
   return (a->tsched.v == b->tsched.v) ? 0 : (a->tsched.v < b->tsched.v) ? -1 : 1;
 }
 
+static void xevq_insert_timed (struct xeventq *evq, struct xevent *ev)
+{
+  if (evq->wheel)
+    ddsi_timerwheel_insert (&evq_xevents_twdef, evq->wheel, ev);
+  else
+    ddsrt_fibheap_insert (&evq_xevents_fhdef, &evq->xevents, ev);
+}
+
+static void xevq_remove_timed (struct xeventq *evq, struct xevent *ev)
+{
+  if (evq->wheel)
+    ddsi_timerwheel_delete (&evq_xevents_twdef, evq->wheel, ev);
+  else
+    ddsrt_fibheap_delete (&evq_xevents_fhdef, &evq->xevents, ev);
+}
+
+/* to be called after decreasing ev->tsched */
+static void xevq_decrease_timed (struct xeventq *evq, struct xevent *ev)
+{
+  if (evq->wheel)
+  {
+    ddsi_timerwheel_delete (&evq_xevents_twdef, evq->wheel, ev);
+    ddsi_timerwheel_insert (&evq_xevents_twdef, evq->wheel, ev);
+  }
+  else
+  {
+    ddsrt_fibheap_decrease_key (&evq_xevents_fhdef, &evq->xevents, ev);
+  }
+}
+
+static struct xevent *xevq_extract_due (struct xeventq *evq, ddsrt_mtime_t tnow)
+{
+  if (evq->wheel)
+    return ddsi_timerwheel_extract_due (&evq_xevents_twdef, evq->wheel, tnow.v);
+  else
+  {
+    struct xevent *min = ddsrt_fibheap_min (&evq_xevents_fhdef, &evq->xevents);
+    if (min == NULL || min->tsched.v > tnow.v)
+      return NULL;
+    return ddsrt_fibheap_extract_min (&evq_xevents_fhdef, &evq->xevents);
+  }
+}
+
 static void update_rexmit_counts (struct xeventq *evq, struct xevent_nt *ev)
 {
 #if 0
@@ -345,12 +396,12 @@ void delete_xevent (struct xevent *ev)
   if (ev->tsched.v != DDS_NEVER)
   {
     ev->tsched.v = TSCHED_DELETE;
-    ddsrt_fibheap_decrease_key (&evq_xevents_fhdef, &evq->xevents, ev);
+    xevq_decrease_timed (evq, ev);
   }
   else
   {
     ev->tsched.v = TSCHED_DELETE;
-    ddsrt_fibheap_insert (&evq_xevents_fhdef, &evq->xevents, ev);
+    xevq_insert_timed (evq, ev);
   }
   /* TSCHED_DELETE is absolute minimum time, so chances are we need to
      wake up the thread.  The superfluous signal is harmless. */
@@ -369,7 +420,7 @@ void delete_xevent_callback (struct xevent *ev)
     if (ev->tsched.v != DDS_NEVER)
     {
       assert (ev->tsched.v != TSCHED_DELETE);
-      ddsrt_fibheap_delete (&evq_xevents_fhdef, &evq->xevents, ev);
+      xevq_remove_timed (evq, ev);
       ev->tsched.v = DDS_NEVER;
     }
     if (ev->u.callback.executing)
@@ -401,12 +452,12 @@ int resched_xevent_if_earlier (struct xevent *ev, ddsrt_mtime_t tsched)
     if (ev->tsched.v != DDS_NEVER)
     {
       ev->tsched = tsched;
-      ddsrt_fibheap_decrease_key (&evq_xevents_fhdef, &evq->xevents, ev);
+      xevq_decrease_timed (evq, ev);
     }
     else
     {
       ev->tsched = tsched;
-      ddsrt_fibheap_insert (&evq_xevents_fhdef, &evq->xevents, ev);
+      xevq_insert_timed (evq, ev);
     }
     is_resched = 1;
     if (tsched.v < tbefore.v)
@@ -470,6 +521,11 @@ static ddsrt_mtime_t earliest_in_xeventq (struct xeventq *evq)
 {
   struct xevent *min;
   ASSERT_MUTEX_HELD (&evq->lock);
+  if (evq->wheel)
+  {
+    /* may be earlier than the earliest event, but never later */
+    return (ddsrt_mtime_t) { ddsi_timerwheel_next (&evq_xevents_twdef, evq->wheel) };
+  }
   return ((min = ddsrt_fibheap_min (&evq_xevents_fhdef, &evq->xevents)) != NULL) ? min->tsched : DDSRT_MTIME_NEVER;
 }
 
@@ -482,7 +538,7 @@ static void qxev_insert (struct xevent *ev)
   if (ev->tsched.v != DDS_NEVER)
   {
     ddsrt_mtime_t tbefore = earliest_in_xeventq (evq);
-    ddsrt_fibheap_insert (&evq_xevents_fhdef, &evq->xevents, ev);
+    xevq_insert_timed (evq, ev);
     if (ev->tsched.v < tbefore.v)
       ddsrt_cond_broadcast (&evq->cond);
   }
@@ -515,6 +571,13 @@ struct xeventq * xeventq_new
   if (max_queued_rexmit_bytes > 2147483648u)
     max_queued_rexmit_bytes = 2147483648u;
   ddsrt_fibheap_init (&evq_xevents_fhdef, &evq->xevents);
+  if (conn->m_base.gv->config.timer_wheel_tick == 0)
+    evq->wheel = NULL;
+  else
+  {
+    evq->wheel = ddsrt_malloc (sizeof (*evq->wheel));
+    ddsi_timerwheel_init (&evq_xevents_twdef, evq->wheel, conn->m_base.gv->config.timer_wheel_tick, ddsrt_time_monotonic ().v);
+  }
   ddsrt_avl_init (&msg_xevents_treedef, &evq->msg_xevents);
   evq->non_timed_xmit_list_oldest = NULL;
   evq->non_timed_xmit_list_newest = NULL;
@@ -572,6 +635,12 @@ void xeventq_free (struct xeventq *evq)
 {
   struct xevent *ev;
   assert (evq->ts == NULL);
+  if (evq->wheel)
+  {
+    while ((ev = ddsi_timerwheel_extract_any (&evq_xevents_twdef, evq->wheel)) != NULL)
+      free_xevent (evq, ev);
+    ddsrt_free (evq->wheel);
+  }
   while ((ev = ddsrt_fibheap_extract_min (&evq_xevents_fhdef, &evq->xevents)) != NULL)
     free_xevent (evq, ev);
 
@@ -1038,6 +1107,16 @@ static void handle_xevk_spdp (UNUSED_ARG (struct nn_xpack *xp), struct xevent *e
       intv = ldur - DDS_SECS (2);
     if (intv > gv->config.spdp_interval)
       intv = gv->config.spdp_interval;
+    if (ev->u.spdp.burst > 0)
+    {
+      /* initial burst: intervals doubling from spdp_initial_burst_interval until
+         they reach the regular one */
+      const int k = gv->config.spdp_initial_burst - ev->u.spdp.burst--;
+      if (k < 32 && gv->config.spdp_initial_burst_interval < (intv >> k))
+        intv = gv->config.spdp_initial_burst_interval << k;
+      else
+        ev->u.spdp.burst = 0;
+    }
 
     tnext = ddsrt_mtime_add_duration (tnow, intv);
     GVTRACE ("xmit spdp "PGUIDFMT" to %"PRIx32":%"PRIx32":%"PRIx32":%x (resched %gs)\n",
@@ -1201,9 +1280,9 @@ static void handle_xevents (struct thread_state1 * const ts1, struct xeventq *xe
 
   while (xeventsToProcess)
   {
-    while (earliest_in_xeventq(xevq).v <= tnow.v)
+    struct xevent *xev;
+    while ((xev = xevq_extract_due (xevq, tnow)) != NULL)
     {
-      struct xevent *xev = ddsrt_fibheap_extract_min (&evq_xevents_fhdef, &xevq->xevents);
       if (xev->tsched.v == TSCHED_DELETE)
       {
         free_xevent (xevq, xev);
@@ -1446,11 +1525,15 @@ struct xevent *qxev_spdp (struct xeventq *evq, ddsrt_mtime_t tsched, const ddsi_
   ev = qxev_common (evq, tsched, XEVK_SPDP);
   ev->u.spdp.pp_guid = *pp_guid;
   if (dest_proxypp_guid == NULL)
+  {
     ev->u.spdp.directed = 0;
+    ev->u.spdp.burst = evq->gv->config.spdp_initial_burst;
+  }
   else
   {
     ev->u.spdp.dest_proxypp_guid_prefix = dest_proxypp_guid->prefix;
     ev->u.spdp.directed = 4;
+    ev->u.spdp.burst = 0;
   }
   qxev_insert (ev);
   ddsrt_mutex_unlock (&evq->lock);
@@ -1319,6 +1319,63 @@ static void nn_xpack_send1_threaded (const nn_locator_t *loc, void * varg)
   ddsrt_thread_pool_submit (arg->xp->gv->thread_pool, nn_xpack_send1_thread, arg);
 }
 
+/* Sending the same packet to many destinations, as with unicast to each of a
+   writer's readers, costs a system call per destination unless the transport
+   can write to several of them at once. That only works if the packet is the
+   same for all of them, so not when it is encoded per destination nor when
+   packets are dropped at random. */
+#define NN_XPACK_MULTI_DSTS 32
+
+struct nn_xpack_multi {
+  struct nn_xpack *xp;
+  size_t ndst;
+  nn_locator_t dst[NN_XPACK_MULTI_DSTS];
+};
+
+static bool nn_xpack_may_send_multi (const struct nn_xpack *xp)
+{
+  struct ddsi_domaingv const * const gv = xp->gv;
+  if (!ddsi_conn_supports_write_multi (xp->conn) || gv->mute || gv->config.xmit_lossiness > 0)
+    return false;
+#ifdef DDSI_INCLUDE_SECURITY
+  if (xp->sec_info.use_rtps_encoding)
+    return false;
+#endif
+  return true;
+}
+
+static void nn_xpack_send_multi_flush (struct nn_xpack_multi *mx)
+{
+  struct nn_xpack *xp = mx->xp;
+  if (mx->ndst == 0)
+    return;
+  const size_t nsent = ddsi_conn_write_multi (xp->conn, mx->ndst, mx->dst, xp->niov, xp->iov, xp->call_flags);
+  xp->call_flags = 0;
+#ifdef DDSI_INCLUDE_BANDWIDTH_LIMITING
+  if (nsent > 0)
+  {
+    nn_bw_limit_sleep_if_needed (xp->gv, &xp->limiter, (ssize_t) (nsent * xp->msg_len.length));
+  }
+#else
+  (void) nsent;
+#endif
+  mx->ndst = 0;
+}
+
+static void nn_xpack_send_multi_add (const nn_locator_t *loc, void * varg)
+{
+  struct nn_xpack_multi *mx = varg;
+  struct ddsi_domaingv const * const gv = mx->xp->gv;
+  if (gv->logconfig.c.mask & DDS_LC_TRACE)
+  {
+    char buf[DDSI_LOCSTRLEN];
+    GVTRACE (" %s", ddsi_locator_to_string (buf, sizeof(buf), loc));
+  }
+  mx->dst[mx->ndst++] = *loc;
+  if (mx->ndst == NN_XPACK_MULTI_DSTS)
+    nn_xpack_send_multi_flush (mx);
+}
+
 static void nn_xpack_send_real (struct nn_xpack *xp)
 {
   struct ddsi_domaingv const * const gv = xp->gv;
@@ -1357,7 +1414,15 @@ static void nn_xpack_send_real (struct nn_xpack *xp)
     calls = 0;
     if (xp->dstaddr.all.as)
     {
-      if (xp->gv->thread_pool == NULL)
+      if (xp->gv->thread_pool == NULL && nn_xpack_may_send_multi (xp))
+      {
+        struct nn_xpack_multi mx;
+        mx.xp = xp;
+        mx.ndst = 0;
+        calls = addrset_forall_count (xp->dstaddr.all.as, nn_xpack_send_multi_add, &mx);
+        nn_xpack_send_multi_flush (&mx);
+      }
+      else if (xp->gv->thread_pool == NULL)
       {
         calls = addrset_forall_count (xp->dstaddr.all.as, nn_xpack_send1v, xp);
       }
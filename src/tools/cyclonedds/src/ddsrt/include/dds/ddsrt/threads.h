@@ -95,6 +95,10 @@ typedef struct {
   int32_t schedPriority;
   /** Specifies the thread stack size */
   uint32_t stackSize;
+  /** Specifies the number of CPUs in affinity, 0 meaning the thread may run on any CPU */
+  uint32_t affinityCount;
+  /** Specifies the CPUs the thread may run on, only referenced while creating the thread */
+  const uint32_t *affinity;
 } ddsrt_threadattr_t;
 
 /**
@@ -25,17 +25,27 @@ typedef struct ddsi_work_queue_job
 }
 * ddsi_work_queue_job_t;
 
+typedef struct ddsi_work_queue_thread
+{
+    struct ddsi_work_queue_thread * m_next; /* Threads list pointer */
+    ddsrt_thread_t m_tid;                   /* Thread id, for joining */
+}
+* ddsi_work_queue_thread_t;
+
 struct ddsrt_thread_pool_s
 {
     ddsi_work_queue_job_t m_jobs;      /* Job queue */
     ddsi_work_queue_job_t m_jobs_tail; /* Tail of job queue */
     ddsi_work_queue_job_t m_free;      /* Job free list */
+    ddsi_work_queue_thread_t m_tids;   /* All threads ever started */
     uint32_t m_thread_max;            /* Maximum number of threads */
     uint32_t m_thread_min;            /* Minimum number of threads */
     uint32_t m_threads;               /* Current number of threads */
     uint32_t m_waiting;               /* Number of threads waiting for a job */
     uint32_t m_job_count;             /* Number of queued jobs */
     uint32_t m_job_max;               /* Maximum number of jobs to queue */
+    uint32_t m_purge;                 /* Number of idle threads asked to leave */
+    bool m_stop;                      /* Set when the pool is being deleted */
     unsigned short m_count;            /* Counter for thread name */
     ddsrt_threadattr_t m_attr;              /* Thread creation attribute */
     ddsrt_cond_t m_cv;                    /* Thread wait semaphore */
@@ -51,60 +61,77 @@ static uint32_t ddsrt_thread_start_fn (void * arg)
 
     ddsrt_mutex_lock (&pool->m_mutex);
 
-    while (pool->m_jobs != NULL) {
-        /* Wait for job */
-        ddsrt_cond_wait (&pool->m_cv, &pool->m_mutex);
+    while (!pool->m_stop) {
+        if (pool->m_jobs == NULL) {
+            /* Idle threads beyond the minimum leave when the pool is purged */
 
-        /* Check if pool deleted or being purged */
+            if (pool->m_purge > 0) {
+                pool->m_purge--;
+                if (pool->m_threads > pool->m_thread_min)
+                    break;
+            }
 
-        if (pool->m_jobs) {
-            /* Take job from queue head */
+            /* Wait for job */
+            ddsrt_cond_wait (&pool->m_cv, &pool->m_mutex);
+            continue;
+        }
 
-            pool->m_waiting--;
-            job = pool->m_jobs;
-            pool->m_jobs = job->m_next_job;
-            pool->m_job_count--;
+        /* Take job from queue head */
 
-            ddsrt_mutex_unlock (&pool->m_mutex);
+        pool->m_waiting--;
+        job = pool->m_jobs;
+        pool->m_jobs = job->m_next_job;
+        if (pool->m_jobs == NULL) {
+            pool->m_jobs_tail = NULL;
+        }
+        pool->m_job_count--;
 
-            /* Do job */
+        ddsrt_mutex_unlock (&pool->m_mutex);
 
-            (job->m_fn) (job->m_arg);
+        /* Do job */
 
-            /* Put job back on free list */
+        (job->m_fn) (job->m_arg);
 
-            ddsrt_mutex_lock (&pool->m_mutex);
-            pool->m_waiting++;
-            job->m_next_job = pool->m_free;
-            pool->m_free = job;
-        }
-    }
+        /* Put job back on free list */
 
-    if (--pool->m_threads) {
-        /* last to leave triggers thread_pool_free */
-        ddsrt_cond_broadcast (&pool->m_cv);
+        ddsrt_mutex_lock (&pool->m_mutex);
+        pool->m_waiting++;
+        job->m_next_job = pool->m_free;
+        pool->m_free = job;
     }
+
+    pool->m_waiting--;
+    pool->m_threads--;
+    /* thread_pool_free waits for the last one to leave */
+    ddsrt_cond_broadcast (&pool->m_cv);
     ddsrt_mutex_unlock (&pool->m_mutex);
     return 0;
 }
 
+/* Called with pool->m_mutex held, so the new thread is accounted for as
+   waiting before it can possibly look at the job queue. */
 static dds_return_t ddsrt_thread_pool_new_thread (ddsrt_thread_pool pool)
 {
     static unsigned char pools = 0; /* Pool counter - TODO make atomic */
 
     char name [64];
-    ddsrt_thread_t id;
+    ddsi_work_queue_thread_t thr;
     dds_return_t res;
 
     (void) snprintf (name, sizeof (name), "OSPL-%u-%u", pools++, pool->m_count++);
-    res = ddsrt_thread_create (&id, name, &pool->m_attr, &ddsrt_thread_start_fn, pool);
+    thr = ddsrt_malloc (sizeof (*thr));
+    res = ddsrt_thread_create (&thr->m_tid, name, &pool->m_attr, &ddsrt_thread_start_fn, pool);
 
     if (res == DDS_RETCODE_OK)
     {
-        ddsrt_mutex_lock (&pool->m_mutex);
         pool->m_threads++;
         pool->m_waiting++;
-        ddsrt_mutex_unlock (&pool->m_mutex);
+        thr->m_next = pool->m_tids;
+        pool->m_tids = thr;
+    }
+    else
+    {
+        ddsrt_free (thr);
     }
 
     return res;
@@ -142,18 +169,20 @@ ddsrt_thread_pool ddsrt_thread_pool_new (uint32_t threads, uint32_t max_threads,
 
     /* Create initial threads and jobs */
 
+    ddsrt_mutex_lock (&pool->m_mutex);
     while (threads--)
     {
         if (ddsrt_thread_pool_new_thread (pool) != DDS_RETCODE_OK)
         {
+            ddsrt_mutex_unlock (&pool->m_mutex);
             ddsrt_thread_pool_free (pool);
-            pool = NULL;
-            break;
+            return NULL;
         }
         job = ddsrt_malloc (sizeof (*job));
         job->m_next_job = pool->m_free;
         pool->m_free = job;
     }
+    ddsrt_mutex_unlock (&pool->m_mutex);
 
     return pool;
 }
@@ -161,6 +190,7 @@ ddsrt_thread_pool ddsrt_thread_pool_new (uint32_t threads, uint32_t max_threads,
 void ddsrt_thread_pool_free (ddsrt_thread_pool pool)
 {
     ddsi_work_queue_job_t job;
+    ddsi_work_queue_thread_t thr;
 
     if (pool == NULL)
     {
@@ -177,20 +207,28 @@ void ddsrt_thread_pool_free (ddsrt_thread_pool pool)
         pool->m_jobs = job->m_next_job;
         ddsrt_free (job);
     }
+    pool->m_jobs_tail = NULL;
+    pool->m_job_count = 0;
 
     /* Wake all waiting threads */
 
+    pool->m_stop = true;
     ddsrt_cond_broadcast (&pool->m_cv);
 
-    ddsrt_mutex_unlock (&pool->m_mutex);
-
     /* Wait for threads to complete */
 
-    ddsrt_mutex_lock (&pool->m_mutex);
     while (pool->m_threads != 0)
         ddsrt_cond_wait (&pool->m_cv, &pool->m_mutex);
     ddsrt_mutex_unlock (&pool->m_mutex);
 
+    while (pool->m_tids)
+    {
+        thr = pool->m_tids;
+        pool->m_tids = thr->m_next;
+        (void) ddsrt_thread_join (thr->m_tid, NULL);
+        ddsrt_free (thr);
+    }
+
     /* Delete all free jobs from queue */
 
     while (pool->m_free)
@@ -271,15 +309,12 @@ dds_return_t ddsrt_thread_pool_submit (ddsrt_thread_pool pool, void (*fn) (void
 
 void ddsrt_thread_pool_purge (ddsrt_thread_pool pool)
 {
-    uint32_t total;
+    uint32_t idle, excess;
 
     ddsrt_mutex_lock (&pool->m_mutex);
-    total = pool->m_threads;
-    while (pool->m_waiting && (total > pool->m_thread_min))
-    {
-        pool->m_waiting--;
-        total--;
-    }
+    idle = (pool->m_waiting > pool->m_purge) ? pool->m_waiting - pool->m_purge : 0;
+    excess = (pool->m_threads > pool->m_thread_min + pool->m_purge) ? pool->m_threads - pool->m_thread_min - pool->m_purge : 0;
+    pool->m_purge += (idle < excess) ? idle : excess;
     ddsrt_cond_broadcast (&pool->m_cv);
     ddsrt_mutex_unlock (&pool->m_mutex);
 }
@@ -164,6 +164,17 @@ ddsrt_thread_create(
     DDS_WARNING("SetThreadPriority failed with %i\n", GetLastError());
   }
 
+  if (attr->affinityCount > 0) {
+    DWORD_PTR mask = 0;
+    for (uint32_t i = 0; i < attr->affinityCount; i++) {
+      if (attr->affinity[i] < 8 * sizeof(mask))
+        mask |= (DWORD_PTR)1 << attr->affinity[i];
+    }
+    if (mask == 0 || SetThreadAffinityMask(thr.handle, mask) == 0) {
+      DDS_WARNING("SetThreadAffinityMask failed with %i\n", GetLastError());
+    }
+  }
+
   return DDS_RETCODE_OK;
 }
 
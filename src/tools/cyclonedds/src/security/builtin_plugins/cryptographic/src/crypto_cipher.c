@@ -10,6 +10,7 @@
  * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
  */
 #include <assert.h>
+#include <string.h>
 
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/types.h"
@@ -18,60 +19,124 @@
 #include "crypto_utils.h"
 #include "crypto_cipher.h"
 
-bool crypto_cipher_encrypt_data(
+void crypto_cipher_ctx_init(crypto_cipher_ctx *cipher_ctx)
+{
+  ddsrt_mutex_init(&cipher_ctx->lock);
+  cipher_ctx->evp_ctx = NULL;
+  cipher_ctx->key_size = 0;
+  memset(cipher_ctx->key.data, 0, sizeof(cipher_ctx->key.data));
+}
+
+void crypto_cipher_ctx_fini(crypto_cipher_ctx *cipher_ctx)
+{
+  if (cipher_ctx->evp_ctx)
+    EVP_CIPHER_CTX_free(cipher_ctx->evp_ctx);
+  memset(cipher_ctx->key.data, 0, sizeof(cipher_ctx->key.data));
+  ddsrt_mutex_destroy(&cipher_ctx->lock);
+}
+
+/* Returns a context initialized for AES GCM with the key and IV. If cipher_ctx
+   is not NULL, the cached context is used, and if it already holds the same key
+   (the common case) only the IV needs to be set, which saves expanding the key.
+   Otherwise it returns a new context that must be freed by the caller. The
+   EVP interface uses AES-NI (or VAES) and PCLMULQDQ when the CPU supports it. */
+static EVP_CIPHER_CTX *get_cipher_context(
+  crypto_cipher_ctx *cipher_ctx,
   const crypto_session_key_t *session_key,
   uint32_t key_size,
   const unsigned char *iv,
-  const unsigned char *data,
-  uint32_t data_len,
-  const unsigned char *aad,
-  uint32_t aad_len,
-  unsigned char *encrypted,
-  uint32_t *encrypted_len,
-  crypto_hmac_t *tag,
+  int enc,
   DDS_Security_SecurityException *ex)
 {
+  const EVP_CIPHER *cipher;
   EVP_CIPHER_CTX *ctx;
-  int len = 0;
 
-  /* create the cipher context */
-  ctx = EVP_CIPHER_CTX_new();
-  if (!ctx)
+  if (cipher_ctx && cipher_ctx->evp_ctx && cipher_ctx->key_size == key_size &&
+      memcmp(cipher_ctx->key.data, session_key->data, key_size / 8) == 0)
   {
-    DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_CIPHER_CTX_new failed: ");
-    goto fail_ctx_new;
+    if (!EVP_CipherInit_ex(cipher_ctx->evp_ctx, NULL, NULL, NULL, iv, enc))
+    {
+      DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_CipherInit_ex to set iv failed: ");
+      goto fail_cached;
+    }
+    return cipher_ctx->evp_ctx;
   }
 
-  /* initialize the cipher and set to AES GCM */
   if (key_size == 128)
+    cipher = EVP_aes_128_gcm();
+  else if (key_size == 256)
+    cipher = EVP_aes_256_gcm();
+  else
   {
-    if (!EVP_EncryptInit_ex(ctx, EVP_aes_128_gcm(), NULL, NULL, NULL))
-    {
-      DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_EncryptInit_ex to set aes_128_gcm failed: ");
-      goto fail_encrypt;
-    }
+    assert(0);
+    DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_CipherInit_ex invalid key size: %u", key_size);
+    return NULL;
   }
-  else if (key_size == 256)
+
+  if (cipher_ctx && cipher_ctx->evp_ctx)
+    ctx = cipher_ctx->evp_ctx;
+  else if ((ctx = EVP_CIPHER_CTX_new()) == NULL)
   {
-    if (!EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, NULL, NULL))
-    {
-      DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_EncryptInit_ex to set aes_256_gcm failed: ");
-      goto fail_encrypt;
-    }
+    DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_CIPHER_CTX_new failed: ");
+    return NULL;
   }
-  else
+
+  /* initialize the cipher (AES GCM), key and IV */
+  if (!EVP_CipherInit_ex(ctx, cipher, NULL, session_key->data, iv, enc))
   {
-    assert(0);
-    DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_EncryptInit_ex invalid key size: %u", key_size);
-    goto fail_encrypt;
+    DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_CipherInit_ex failed: ");
+    if (cipher_ctx == NULL || ctx != cipher_ctx->evp_ctx)
+    {
+      EVP_CIPHER_CTX_free(ctx);
+      return NULL;
+    }
+    goto fail_cached;
   }
 
-  /* Initialise key and IV */
-  if (!EVP_EncryptInit_ex(ctx, NULL, NULL, session_key->data, iv))
+  if (cipher_ctx)
   {
-    DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_EncryptInit_ex failed: ");
-    goto fail_encrypt;
+    cipher_ctx->evp_ctx = ctx;
+    cipher_ctx->key_size = key_size;
+    memcpy(cipher_ctx->key.data, session_key->data, key_size / 8);
   }
+  return ctx;
+
+fail_cached:
+  /* the state of the context is unknown, so don't use it again */
+  EVP_CIPHER_CTX_free(cipher_ctx->evp_ctx);
+  cipher_ctx->evp_ctx = NULL;
+  return NULL;
+}
+
+static void release_cipher_context(crypto_cipher_ctx *cipher_ctx, EVP_CIPHER_CTX *ctx)
+{
+  if (cipher_ctx == NULL)
+    EVP_CIPHER_CTX_free(ctx);
+  else
+    ddsrt_mutex_unlock(&cipher_ctx->lock);
+}
+
+bool crypto_cipher_encrypt_data(
+  crypto_cipher_ctx *cipher_ctx,
+  const crypto_session_key_t *session_key,
+  uint32_t key_size,
+  const unsigned char *iv,
+  const unsigned char *data,
+  uint32_t data_len,
+  const unsigned char *aad,
+  uint32_t aad_len,
+  unsigned char *encrypted,
+  uint32_t *encrypted_len,
+  crypto_hmac_t *tag,
+  DDS_Security_SecurityException *ex)
+{
+  EVP_CIPHER_CTX *ctx;
+  int len = 0;
+
+  if (cipher_ctx)
+    ddsrt_mutex_lock(&cipher_ctx->lock);
+  if ((ctx = get_cipher_context(cipher_ctx, session_key, key_size, iv, 1, ex)) == NULL)
+    goto fail_ctx;
 
   if (aad)
   {
@@ -135,12 +200,15 @@ bool crypto_cipher_encrypt_data(
     goto fail_encrypt;
   }
 
-  EVP_CIPHER_CTX_free(ctx);
+  release_cipher_context(cipher_ctx, ctx);
   return true;
 
 fail_encrypt:
-  EVP_CIPHER_CTX_free(ctx);
-fail_ctx_new:
+  release_cipher_context(cipher_ctx, ctx);
+  return false;
+fail_ctx:
+  if (cipher_ctx)
+    ddsrt_mutex_unlock(&cipher_ctx->lock);
   return false;
 }
 
@@ -156,47 +224,14 @@ bool crypto_cipher_decrypt_data(
   crypto_hmac_t *tag,
   DDS_Security_SecurityException *ex)
 {
+  crypto_cipher_ctx * const cipher_ctx = session->cipher_ctx;
   EVP_CIPHER_CTX *ctx;
   int len = 0;
 
-  /* create the cipher context */
-  ctx = EVP_CIPHER_CTX_new();
-  if (!ctx)
-  {
-    DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_CIPHER_CTX_new failed: ");
-    goto fail_ctx_new;
-  }
-
-  /* initialize the cipher and set to AES GCM */
-  if (session->key_size == 128)
-  {
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_128_gcm(), NULL, NULL, NULL) != 1)
-    {
-      DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_DecryptInit_ex to set aes_128_gcm failed: ");
-      goto fail_decrypt;
-    }
-  }
-  else if (session->key_size == 256)
-  {
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, NULL, NULL) != 1)
-    {
-      DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_DecryptInit_ex to set aes_256_gcm failed: ");
-      goto fail_decrypt;
-    }
-  }
-  else
-  {
-    assert(0);
-    DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "Internal key_size is not correct: %u", session->key_size);
-    goto fail_decrypt;
-  }
-
-  /* Initialise key and IV */
-  if (EVP_DecryptInit_ex(ctx, NULL, NULL, session->key.data, iv) != 1)
-  {
-    DDS_Security_Exception_set_with_openssl_error(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "EVP_DecryptInit_ex to set aes_256_gcm failed: %s");
-    goto fail_decrypt;
-  }
+  if (cipher_ctx)
+    ddsrt_mutex_lock(&cipher_ctx->lock);
+  if ((ctx = get_cipher_context(cipher_ctx, &session->key, session->key_size, iv, 0, ex)) == NULL)
+    goto fail_ctx;
 
   if (aad)
   {
@@ -248,11 +283,14 @@ bool crypto_cipher_decrypt_data(
     }
   }
 
-  EVP_CIPHER_CTX_free(ctx);
+  release_cipher_context(cipher_ctx, ctx);
   return true;
 
 fail_decrypt:
-  EVP_CIPHER_CTX_free(ctx);
-fail_ctx_new:
+  release_cipher_context(cipher_ctx, ctx);
+  return false;
+fail_ctx:
+  if (cipher_ctx)
+    ddsrt_mutex_unlock(&cipher_ctx->lock);
   return false;
 }
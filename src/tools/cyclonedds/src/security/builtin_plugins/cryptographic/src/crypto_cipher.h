@@ -15,6 +15,26 @@
 #include "dds/ddsrt/types.h"
 #include "crypto_objects.h"
 
+/**
+ * @brief Initializes a cipher context cache
+ *
+ * The cache holds an OpenSSL cipher context together with the key it was
+ * initialized with, so that encoding or decoding a message with the same key
+ * as the previous one only needs to set the initialization vector. A cache
+ * must be used for either encoding or decoding, and it is protected by a lock
+ * so that it can be shared between threads.
+ *
+ * @param[in,out] cipher_ctx    The cache to initialize
+ */
+void crypto_cipher_ctx_init(crypto_cipher_ctx *cipher_ctx);
+
+/**
+ * @brief Frees the resources held by a cipher context cache
+ *
+ * @param[in,out] cipher_ctx    The cache to clean up
+ */
+void crypto_cipher_ctx_fini(crypto_cipher_ctx *cipher_ctx);
+
 /**
  * @brief Encodes the provide data using the provided key
  *
@@ -33,6 +53,7 @@
  * which the common_mac has to be computed. The encryped parameter is not relevant
  * in this case.
  *
+ * @param[in,out] cipher_ctx    Cached cipher context to use, or NULL for a one-off operation
  * @param[in]     session_key   The session key used to encode the provided data
  * @param[in]     key_size      The size of the session key (128 or 256 bit)
  * @param[in]     iv            The init vector used by the encoding
@@ -46,6 +67,7 @@
  * @param[in,out] ex            Security exception (optional)
  */
 bool crypto_cipher_encrypt_data(
+    crypto_cipher_ctx *cipher_ctx,
     const crypto_session_key_t *session_key,
     uint32_t key_size,
     const unsigned char *iv,
@@ -73,7 +95,8 @@ bool crypto_cipher_encrypt_data(
  * data and the encrypted parameter should be NULL and the aad parameter should point to
  * the data for which the common_mac has to be verified.
  *
- * @param[in]     session       Contains the session key and key size used of the decoding
+ * @param[in]     session       Contains the session key and key size used of the decoding, and
+ *                              optionally the cached cipher context to use for it
  * @param[in]     iv            The init vector used by the decoding
  * @param[in]     encrypted     The encoded data
  * @param[in]     encrypted_len The size of the encoded data
@@ -17,6 +17,7 @@
 #include "dds/ddsrt/types.h"
 #include "crypto_objects.h"
 #include "crypto_utils.h"
+#include "crypto_cipher.h"
 
 static int compare_participant_handle(const void *va, const void *vb);
 static int compare_endpoint_relation (const void *va, const void *vb);
@@ -255,6 +256,8 @@ static void master_key_material__free(CryptoObject *obj)
       ddsrt_free (keymat->master_sender_key);
       ddsrt_free (keymat->master_receiver_specific_key);
     }
+    crypto_cipher_ctx_fini (&keymat->decrypt_ctx);
+    ddsrt_mutex_destroy (&keymat->session_cache.lock);
     crypto_object_deinit ((CryptoObject *)keymat);
     memset (keymat, 0, sizeof (*keymat));
     ddsrt_free (keymat);
@@ -266,6 +269,8 @@ master_key_material * crypto_master_key_material_new(DDS_Security_CryptoTransfor
   master_key_material *keymat = ddsrt_calloc (1, sizeof(*keymat));
   crypto_object_init((CryptoObject *)keymat, CRYPTO_OBJECT_KIND_KEY_MATERIAL, master_key_material__free);
   keymat->transformation_kind = transform_kind;
+  ddsrt_mutex_init (&keymat->session_cache.lock);
+  crypto_cipher_ctx_init (&keymat->decrypt_ctx);
   if (CRYPTO_TRANSFORM_HAS_KEYS(transform_kind))
   {
     uint32_t key_bytes = CRYPTO_KEY_SIZE_BYTES(keymat->transformation_kind);
@@ -316,6 +321,7 @@ static void session_key_material__free(CryptoObject *obj)
   {
     CHECK_CRYPTO_OBJECT_KIND(obj, CRYPTO_OBJECT_KIND_SESSION_KEY_MATERIAL);
     CRYPTO_OBJECT_RELEASE(session->master_key_material);
+    crypto_cipher_ctx_fini(&session->encrypt_ctx);
     crypto_object_deinit((CryptoObject *)session);
     memset (session, 0, sizeof (*session));
     ddsrt_free(session);
@@ -334,6 +340,7 @@ session_key_material * crypto_session_key_material_new(master_key_material *mast
   session->max_blocks_per_session = INT64_MAX; /* FIXME: should be a config parameter */
   session->block_counter = session->max_blocks_per_session;
   session->master_key_material = CRYPTO_OBJECT_KEEP(master_key);
+  crypto_cipher_ctx_init(&session->encrypt_ctx);
 
   return session;
 }
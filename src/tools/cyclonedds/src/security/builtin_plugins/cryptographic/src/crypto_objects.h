@@ -13,6 +13,7 @@
 #define CRYPTO_OBJECTS_H
 
 #include <openssl/rand.h>
+#include <openssl/evp.h>
 #include "dds/ddsrt/atomics.h"
 #include "dds/ddsrt/sync.h"
 #include "dds/ddsrt/types.h"
@@ -75,6 +76,30 @@ struct local_datareader_crypto;
 struct remote_datawriter_crypto;
 struct remote_datareader_crypto;
 
+/* Cipher context initialized with the key it was last used with, so that
+   encrypting or decrypting many messages with the same session key only
+   requires setting the IV (see crypto_cipher.h) */
+typedef struct crypto_cipher_ctx
+{
+  ddsrt_mutex_t lock;
+  EVP_CIPHER_CTX *evp_ctx; /* NULL until first used */
+  uint32_t key_size;
+  crypto_session_key_t key;
+} crypto_cipher_ctx;
+
+/* Session key last derived from a remote master key for decoding, which saves
+   deriving it again for every message received in the same session */
+typedef struct remote_session_cache
+{
+  ddsrt_mutex_t lock;
+  bool valid;
+  uint32_t id;
+  DDS_Security_CryptoTransformKind_Enum transformation_kind;
+  unsigned char master_salt[CRYPTO_KEY_SIZE_MAX];
+  unsigned char master_sender_key[CRYPTO_KEY_SIZE_MAX];
+  crypto_session_key_t key;
+} remote_session_cache;
+
 typedef struct master_key_material
 {
   CryptoObject _parent;
@@ -84,6 +109,8 @@ typedef struct master_key_material
   unsigned char *master_sender_key;
   uint32_t receiver_specific_key_id;
   unsigned char *master_receiver_specific_key;
+  remote_session_cache session_cache; /* only used for remote key material */
+  crypto_cipher_ctx decrypt_ctx; /* only used for remote key material */
 } master_key_material;
 
 typedef struct session_key_material
@@ -97,6 +124,7 @@ typedef struct session_key_material
   uint64_t max_blocks_per_session;
   uint64_t init_vector_suffix;
   master_key_material *master_key_material;
+  crypto_cipher_ctx encrypt_ctx;
 } session_key_material;
 
 typedef struct remote_session_info
@@ -104,6 +132,7 @@ typedef struct remote_session_info
   uint32_t key_size;
   uint32_t id;
   crypto_session_key_t key;
+  crypto_cipher_ctx *cipher_ctx; /* cached context for decoding, may be NULL */
 } remote_session_info;
 
 typedef struct key_relation
@@ -283,27 +283,56 @@ read_rtps_header(
 /**
  * Initialize the remote session info which is used
  * to decode a received message. It will calculate the
- * session key from the received crypto_header.
+ * session key from the received crypto_header, unless
+ * it is the same session as that of the previous message
+ * decoded using this key material.
  *
  * @param[in,out] info                The remote session information which is determined by this function
  * @param[in]     header              The received crypto_header
- * @param[in]     master_salt         The master_salt associated with the remote entity
- * @param[in]     master_key          The master_key associated with the remote entity
- * @param[in]     transformation_kind The transformation kind (to determine key and salt size)
+ * @param[in]     key_material        The master key material associated with the remote entity
  * @param[in,out] ex                  Security exception
  */
 static bool
 initialize_remote_session_info(
     remote_session_info *info,
     struct crypto_header *header,
-    const unsigned char *master_salt,
-    const unsigned char *master_key,
-    DDS_Security_CryptoTransformKind_Enum transformation_kind,
+    master_key_material *key_material,
     DDS_Security_SecurityException *ex)
 {
+  remote_session_cache * const cache = &key_material->session_cache;
+  const DDS_Security_CryptoTransformKind_Enum transformation_kind = key_material->transformation_kind;
+  const uint32_t key_bytes = CRYPTO_KEY_SIZE_BYTES(transformation_kind);
   info->key_size = crypto_get_key_size (transformation_kind);
   info->id = CRYPTO_TRANSFORM_ID(header->session_id);
-  return crypto_calculate_session_key(&info->key, info->id, master_salt, master_key, transformation_kind, ex);
+  info->cipher_ctx = &key_material->decrypt_ctx;
+
+  if (!CRYPTO_TRANSFORM_HAS_KEYS(transformation_kind))
+    return crypto_calculate_session_key(&info->key, info->id, key_material->master_salt, key_material->master_sender_key, transformation_kind, ex);
+
+  /* the master key material may be replaced at any time, so a cached session key
+     is only valid if the master key and salt are still the same */
+  ddsrt_mutex_lock (&cache->lock);
+  if (cache->valid && cache->id == info->id && cache->transformation_kind == transformation_kind &&
+      memcmp (cache->master_salt, key_material->master_salt, key_bytes) == 0 &&
+      memcmp (cache->master_sender_key, key_material->master_sender_key, key_bytes) == 0)
+  {
+    info->key = cache->key;
+    ddsrt_mutex_unlock (&cache->lock);
+    return true;
+  }
+  if (!crypto_calculate_session_key(&info->key, info->id, key_material->master_salt, key_material->master_sender_key, transformation_kind, ex))
+  {
+    ddsrt_mutex_unlock (&cache->lock);
+    return false;
+  }
+  cache->valid = true;
+  cache->id = info->id;
+  cache->transformation_kind = transformation_kind;
+  memcpy (cache->master_salt, key_material->master_salt, key_bytes);
+  memcpy (cache->master_sender_key, key_material->master_sender_key, key_bytes);
+  cache->key = info->key;
+  ddsrt_mutex_unlock (&cache->lock);
+  return true;
 }
 
 static bool transform_kind_valid(DDS_Security_CryptoTransformKind_Enum kind)
@@ -852,7 +881,7 @@ encode_serialized_payload(
   if (is_encryption_required(transform_kind))
   {
     contents = (struct crypto_contents *)payload;
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, header->session_id, plain_buffer->_buffer, plain_buffer->_length, NULL, 0, contents->_data, &payload_len, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->encrypt_ctx, &session->key, session->key_size, header->session_id, plain_buffer->_buffer, plain_buffer->_length, NULL, 0, contents->_data, &payload_len, &hmac, ex))
       goto fail_encrypt;
     contents->_length = ddsrt_toBE4u(payload_len);
     payload_len += (uint32_t)sizeof(uint32_t);
@@ -860,7 +889,7 @@ encode_serialized_payload(
   else if (is_authentication_required(transform_kind))
   {
     /* the transformation_kind indicates only indicates authentication the determine HMAC */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, header->session_id, NULL, 0, plain_buffer->_buffer, plain_buffer->_length, NULL, NULL, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->encrypt_ctx, &session->key, session->key_size, header->session_id, NULL, 0, plain_buffer->_buffer, plain_buffer->_length, NULL, NULL, &hmac, ex))
       goto fail_encrypt;
     memcpy(payload, plain_buffer->_buffer, plain_buffer->_length);
     payload_len = plain_buffer->_length;
@@ -923,7 +952,7 @@ add_reader_specific_mac(
     index = ddsrt_fromBE4u(footer->receiver_specific_macs._length);
 
     if (!crypto_calculate_receiver_specific_key(&key, session->id, key_material->master_salt, key_material->master_receiver_specific_key, key_material->transformation_kind, ex) ||
-        !crypto_cipher_encrypt_data(&key, session->key_size, header->session_id, NULL, 0, footer->common_mac.data, CRYPTO_HMAC_SIZE, NULL, NULL, &hmac, ex))
+        !crypto_cipher_encrypt_data(NULL, &key, session->key_size, header->session_id, NULL, 0, footer->common_mac.data, CRYPTO_HMAC_SIZE, NULL, NULL, &hmac, ex))
     {
       result = false;
     }
@@ -1008,7 +1037,7 @@ add_receiver_specific_mac(
 
     if (!crypto_calculate_receiver_specific_key(&key, session->id, pp_key_material->local_P2P_key_material->master_salt,
             pp_key_material->local_P2P_key_material->master_receiver_specific_key, pp_key_material->local_P2P_key_material->transformation_kind, ex) ||
-        !crypto_cipher_encrypt_data(&key, session->key_size, header->session_id, NULL, 0, footer->common_mac.data, CRYPTO_HMAC_SIZE, NULL, NULL, &hmac, ex))
+        !crypto_cipher_encrypt_data(NULL, &key, session->key_size, header->session_id, NULL, 0, footer->common_mac.data, CRYPTO_HMAC_SIZE, NULL, NULL, &hmac, ex))
     {
       result = false;
     }
@@ -1139,7 +1168,7 @@ encode_datawriter_submessage_encrypt (
     contents = encrypted->data;
 
     /* encrypt submessage */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, header->session_id, plain_submsg->_buffer, plain_submsg->_length, NULL, 0, contents, &payload_len, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->encrypt_ctx, &session->key, session->key_size, header->session_id, plain_submsg->_buffer, plain_submsg->_length, NULL, 0, contents, &payload_len, &hmac, ex))
       goto enc_dw_submsg_fail;
 
     /* adjust the length of the body submessage when needed */
@@ -1154,7 +1183,7 @@ encode_datawriter_submessage_encrypt (
   else if (is_authentication_required(transform_kind))
   {
     /* the transformation_kind indicates only indicates authentication the determine HMAC */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, header->session_id, NULL, 0, plain_submsg->_buffer, plain_submsg->_length, NULL, NULL, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->encrypt_ctx, &session->key, session->key_size, header->session_id, NULL, 0, plain_submsg->_buffer, plain_submsg->_length, NULL, NULL, &hmac, ex))
       goto enc_dw_submsg_fail;
 
     /* copy submessage */
@@ -1393,7 +1422,7 @@ encode_datareader_submessage(
     contents = encrypted->data;
 
     /* encrypt submessage */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, header->session_id, plain_submsg->_buffer, plain_submsg->_length, NULL, 0, contents, &payload_len, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->encrypt_ctx, &session->key, session->key_size, header->session_id, plain_submsg->_buffer, plain_submsg->_length, NULL, 0, contents, &payload_len, &hmac, ex))
       goto enc_dr_submsg_fail;
 
     /* adjust the length of the body submessage when needed */
@@ -1408,7 +1437,7 @@ encode_datareader_submessage(
   else if (is_authentication_required(transform_kind))
   {
     /* the transformation_kind indicates only indicates authentication the determine HMAC */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, header->session_id, NULL, 0, plain_submsg->_buffer, plain_submsg->_length, NULL, NULL, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->encrypt_ctx, &session->key, session->key_size, header->session_id, NULL, 0, plain_submsg->_buffer, plain_submsg->_length, NULL, NULL, &hmac, ex))
       goto enc_dr_submsg_fail;
 
     /* copy submessage */
@@ -1502,7 +1531,7 @@ check_reader_specific_mac(
     goto check_failed;
   }
 
-  if (!crypto_cipher_encrypt_data(&key, crypto_get_key_size(keymat->transformation_kind), header->session_id, NULL, 0, footer->common_mac.data, CRYPTO_HMAC_SIZE, NULL, NULL, &hmac, ex))
+  if (!crypto_cipher_encrypt_data(NULL, &key, crypto_get_key_size(keymat->transformation_kind), header->session_id, NULL, 0, footer->common_mac.data, CRYPTO_HMAC_SIZE, NULL, NULL, &hmac, ex))
   {
     DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_INVALID_CRYPTO_RECEIVER_SIGN_CODE, 0,
         "%s: failed to calculate receiver specific hmac", context);
@@ -1679,7 +1708,7 @@ static DDS_Security_boolean encode_rtps_message_encrypt (
 
     /* encrypt message */
     /* FIXME: improve performance by not copying plain_rtps_message to a new buffer (crypto_cipher_encrypt_data should allow encrypting parts of a message) */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, header->session_id, secure_body_plain._buffer, secure_body_plain_size, NULL, 0, contents, &payload_len, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->encrypt_ctx, &session->key, session->key_size, header->session_id, secure_body_plain._buffer, secure_body_plain_size, NULL, 0, contents, &payload_len, &hmac, ex))
       goto enc_rtps_fail_data;
 
     encrypted->length = ddsrt_toBE4u(payload_len);
@@ -1693,7 +1722,7 @@ static DDS_Security_boolean encode_rtps_message_encrypt (
   else if (is_authentication_required(transform_kind))
   {
     /* the transformation_kind indicates only indicates authentication the determine HMAC */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, header->session_id, NULL, 0, secure_body_plain._buffer, secure_body_plain_size, NULL, NULL, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->encrypt_ctx, &session->key, session->key_size, header->session_id, NULL, 0, secure_body_plain._buffer, secure_body_plain_size, NULL, NULL, &hmac, ex))
       goto enc_rtps_fail_data;
 
     /* copy submessage */
@@ -1880,8 +1909,7 @@ decode_rtps_message(dds_security_crypto_transform *instance,
 
   /* calculate the session key */
   decoded_body = DDS_Security_OctetSeq_allocbuf(contents._length);
-  if (!initialize_remote_session_info(&remote_session, &header, remote_key_material->master_salt,
-        remote_key_material->master_sender_key, remote_key_material->transformation_kind, ex))
+  if (!initialize_remote_session_info(&remote_session, &header, remote_key_material, ex))
   {
     DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_INVALID_CRYPTO_ARGUMENT_CODE, 0,
         "decode_rtps_message: " DDS_SECURITY_ERR_INVALID_CRYPTO_ARGUMENT_MESSAGE);
@@ -2096,7 +2124,7 @@ decode_datawriter_submessage(
   }
 
   /* calculate the session key */
-  if (!initialize_remote_session_info(&remote_session, &header, writer_master_key->master_salt, writer_master_key->master_sender_key, writer_master_key->transformation_kind, ex))
+  if (!initialize_remote_session_info(&remote_session, &header, writer_master_key, ex))
     goto fail_decrypt;
 
   if (is_encryption_required(transform_kind))
@@ -2220,7 +2248,7 @@ decode_datareader_submessage(
   }
 
   /* calculate the session key */
-  if (!initialize_remote_session_info(&remote_session, &header, reader_master_key->master_salt, reader_master_key->master_sender_key, reader_master_key->transformation_kind, ex))
+  if (!initialize_remote_session_info(&remote_session, &header, reader_master_key, ex))
     goto fail_decrypt;
 
   if (is_encryption_required(transform_kind))
@@ -2345,7 +2373,7 @@ decode_serialized_payload(
     goto fail_prepare;
 
   /* calculate the session key */
-  if (!initialize_remote_session_info(&remote_session, &header, writer_master_key->master_salt, writer_master_key->master_sender_key, writer_master_key->transformation_kind, ex))
+  if (!initialize_remote_session_info(&remote_session, &header, writer_master_key, ex))
     goto fail_decrypt;
 
   /*
@@ -40,6 +40,7 @@
 
 #include "cputime.h"
 #include "netload.h"
+#include "latency_hist.h"
 
 #if !defined(_WIN32) && !defined(LWIP_SOCKET)
 #include <errno.h>
@@ -234,6 +235,7 @@ struct subthread_arg_pongstat {
   uint32_t cnt;
   uint64_t totcnt;
   uint64_t *raw;
+  struct latency_hist *hist; /* entire run, for "-H" */
 };
 
 /* Pong statistics is stored in n array of npongstat entries
@@ -275,6 +277,48 @@ struct subthread_arg {
   void **mseq;
 };
 
+/* Traffic profile streams (set using "-P"): each stream is published at a
+   fixed rate and with a fixed sample size on a topic of its own, so that a mix
+   of traffic can be emulated with all streams running concurrently.  The
+   subscriber side tracks loss and one-way latency (which depends on the clocks
+   of the machines being synchronized) */
+struct profile_stream {
+  char name[32];
+  uint32_t size; /* payload size including the fixed part of KeyedSeq */
+  double rate;
+  dds_entity_t tp, wr, rd;
+  ddsrt_thread_t tid;
+  struct subthread_arg subarg;
+  struct eseq_admin ea;
+  uint64_t ref_nrecv, ref_nlost; /* stats printer state */
+  ddsrt_mutex_t lock; /* protects lat, lat_tot */
+  struct latency_hist *lat; /* since last print_stats */
+  struct latency_hist *lat_tot; /* entire run, for "-H" */
+};
+
+static uint32_t nprofiles;
+static struct profile_stream *profiles;
+
+/* Predefined profiles, sizes are those of the serialized ROS 2 messages: a
+   PointCloud2 of 57600 points of 16 bytes each, a 128x128 OccupancyGrid, and
+   a CAN frame with a header */
+struct profile_def {
+  const char *name;
+  uint32_t size;
+  double rate;
+};
+
+static const struct profile_def profile_defs[] = {
+  { "pointcloud", 921600, 10 },
+  { "occgrid", 16480, 20 },
+  { "can", 40, 2000 },
+  { NULL, 0, 0 }
+};
+
+/* File name prefix for exporting latency histograms at the end of the run,
+   or NULL */
+static const char *histexport_prefix;
+
 /* Type used for converting GUIDs to strings, used for generating
    the per-participant partition names */
 struct guidstr {
@@ -653,6 +697,49 @@ static uint32_t pubthread (void *varg)
   return 0;
 }
 
+static uint32_t profile_pubthread (void *varg)
+{
+  struct profile_stream * const ps = varg;
+  KeyedSeq data;
+  int result;
+  memset (&data, 0, sizeof (data));
+  void *baggage = make_baggage (&data.baggage, ps->size - 12);
+  const dds_duration_t period = (dds_duration_t) (1e9 / ps->rate + 0.5);
+  dds_time_t tnext = dds_time ();
+  while (!ddsrt_atomic_ld32 (&termflag))
+  {
+    const dds_time_t t_write = dds_time ();
+    if ((result = dds_write_ts (ps->wr, &data, t_write)) != DDS_RETCODE_OK)
+    {
+      printf ("write error (profile %s): %d\n", ps->name, result);
+      fflush (stdout);
+      if (result != DDS_RETCODE_TIMEOUT)
+        exit (2);
+      continue;
+    }
+    dds_write_flush (ps->wr);
+    const dds_time_t t_post_write = dds_time ();
+    ddsrt_mutex_lock (&pubstat_lock);
+    hist_record (pubstat_hist, (uint64_t) (t_post_write - t_write), 1);
+    ddsrt_mutex_unlock (&pubstat_lock);
+    data.seq++;
+
+    /* fixed schedule, but don't try to catch up if we fell behind by more than a period */
+    tnext += period;
+    if (tnext < t_post_write - period)
+      tnext = t_post_write;
+    dds_time_t tnow = t_post_write;
+    while (tnow < tnext && !ddsrt_atomic_ld32 (&termflag))
+    {
+      dds_sleepfor ((tnext - tnow < DDS_MSECS (100)) ? tnext - tnow : DDS_MSECS (100));
+      tnow = dds_time ();
+    }
+  }
+  if (baggage)
+    free (baggage);
+  return 0;
+}
+
 static void init_eseq_admin (struct eseq_admin *ea, unsigned nkeys)
 {
   ddsrt_mutex_init (&ea->lock);
@@ -760,6 +847,7 @@ static bool update_roundtrip (dds_instance_handle_t pubhandle, uint64_t tdelta,
         x->raw[x->cnt] = tdelta;
       x->cnt++;
       x->totcnt++;
+      latency_hist_record (x->hist, tdelta);
       ddsrt_mutex_unlock (&pongstat_lock);
       return allseen;
     }
@@ -772,6 +860,8 @@ static bool update_roundtrip (dds_instance_handle_t pubhandle, uint64_t tdelta,
   x->totcnt = 1;
   x->raw = malloc (PINGPONG_RAWSIZE * sizeof (*x->raw));
   x->raw[0] = tdelta;
+  x->hist = latency_hist_new ();
+  latency_hist_record (x->hist, tdelta);
   npongstat++;
   ddsrt_mutex_unlock (&pongstat_lock);
   return allseen;
@@ -883,6 +973,33 @@ static bool process_data (dds_entity_t rd, struct subthread_arg *arg)
   return (nread_data > 0);
 }
 
+static bool process_profile (struct profile_stream *ps)
+{
+  struct subthread_arg * const arg = &ps->subarg;
+  uint32_t max_samples = arg->max_samples;
+  dds_sample_info_t *iseq = arg->iseq;
+  void **mseq = arg->mseq;
+  int32_t nread;
+  if ((nread = dds_take (arg->rd, mseq, iseq, max_samples, max_samples)) < 0)
+    error2 ("dds_take (profile %s): %d\n", ps->name, (int) nread);
+  const dds_time_t tnow = dds_time ();
+  for (int32_t i = 0; i < nread; i++)
+  {
+    if (iseq[i].valid_data)
+    {
+      const KeyedSeq *d = mseq[i];
+      (void) check_eseq (&ps->ea, d->seq, 0, topic_payload_size (KS, d->baggage._length), iseq[i].publication_handle);
+      /* clocks of different machines need not be perfectly aligned, so negative latencies can occur */
+      const uint64_t lat = (tnow > iseq[i].source_timestamp) ? (uint64_t) (tnow - iseq[i].source_timestamp) : 0;
+      ddsrt_mutex_lock (&ps->lock);
+      latency_hist_record (ps->lat, lat);
+      latency_hist_record (ps->lat_tot, lat);
+      ddsrt_mutex_unlock (&ps->lock);
+    }
+  }
+  return (nread > 0);
+}
+
 static bool process_ping (dds_entity_t rd, struct subthread_arg *arg)
 {
   /* Ping sends back Pongs with the lsb 1; Data sends back Pongs with the lsb 0.  This way, the Pong handler can
@@ -1083,6 +1200,12 @@ static void pong_available_listener (dds_entity_t rd, void *arg)
   process_pong (rd, arg);
 }
 
+static void profile_available_listener (dds_entity_t rd, void *arg)
+{
+  (void) rd;
+  process_profile (arg);
+}
+
 static dds_entity_t create_pong_writer (dds_instance_handle_t pphandle, const struct guidstr *guidstr)
 {
   dds_qos_t *qos;
@@ -1436,6 +1559,41 @@ static bool print_stats (dds_time_t tref, dds_time_t tnow, dds_time_t tprev, str
     }
   }
 
+  for (uint32_t i = 0; i < nprofiles; i++)
+  {
+    struct profile_stream * const ps = &profiles[i];
+    if (ps->rd == 0)
+      continue;
+    uint64_t tot_nrecv = 0, tot_nlost = 0;
+    ddsrt_mutex_lock (&ps->ea.lock);
+    for (uint32_t j = 0; j < ps->ea.nph; j++)
+    {
+      tot_nrecv += ps->ea.stats[j].nrecv;
+      tot_nlost += ps->ea.stats[j].nlost;
+    }
+    ddsrt_mutex_unlock (&ps->ea.lock);
+    const uint64_t nrecv = tot_nrecv - ps->ref_nrecv, nlost = tot_nlost - ps->ref_nlost;
+    ps->ref_nrecv = tot_nrecv;
+    ps->ref_nlost = tot_nlost;
+
+    if (nrecv > 0 || substat_every_second)
+    {
+      const double dt = (double) (tnow - tprev);
+      ddsrt_mutex_lock (&ps->lock);
+      printf ("%s profile %s size %"PRIu32" total %"PRIu64" lost %"PRIu64" delta %"PRIu64" lost %"PRIu64" rate %.2f S/s %.2f Mb/s latency mean %.3fus 50%% %.3fus 90%% %.3fus 99%% %.3fus max %.3fus\n",
+              prefix, ps->name, ps->size, tot_nrecv, tot_nlost, nrecv, nlost,
+              (double) nrecv * 1e9 / dt, (double) nrecv * ps->size * 8 * 1e3 / dt,
+              latency_hist_mean (ps->lat) / 1e3,
+              (double) latency_hist_percentile (ps->lat, 50) / 1e3,
+              (double) latency_hist_percentile (ps->lat, 90) / 1e3,
+              (double) latency_hist_percentile (ps->lat, 99) / 1e3,
+              (double) latency_hist_max (ps->lat) / 1e3);
+      latency_hist_reset (ps->lat);
+      ddsrt_mutex_unlock (&ps->lock);
+      output = true;
+    }
+  }
+
   uint64_t *newraw = malloc (PINGPONG_RAWSIZE * sizeof (*newraw));
   ddsrt_mutex_lock (&pongstat_lock);
   for (uint32_t i = 0; i < npongstat; i++)
@@ -1583,6 +1741,84 @@ static void sigxfsz_handler (int sig __attribute__ ((unused)))
 #endif
 #endif
 
+/* Histogram names end up in file names, so restrict them to a safe set of characters */
+static void sanitize_name (char *name)
+{
+  for (char *p = name; *p; p++)
+    if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '-' || *p == '_' || *p == '.'))
+      *p = '_';
+}
+
+static bool write_hgrm_file (const char *name, const struct latency_hist *h)
+{
+  char fn[1024];
+  FILE *fp;
+  snprintf (fn, sizeof (fn), "%s-%s.hgrm", histexport_prefix, name);
+  if ((fp = fopen (fn, "w")) == NULL)
+  {
+    printf ("[%"PRIdPID"] error: can't open %s for writing\n", ddsrt_getpid (), fn);
+    return false;
+  }
+  latency_hist_write_hgrm (fp, h);
+  fclose (fp);
+  return true;
+}
+
+/* Writes all latency histograms: PREFIX.json containing all of them and a
+   PREFIX-NAME.hgrm file for each.  Must be called after stopping all threads
+   and listeners that update the statistics */
+static bool export_histograms (void)
+{
+  char fn[1024];
+  FILE *fp;
+  bool ok = true;
+  snprintf (fn, sizeof (fn), "%s.json", histexport_prefix);
+  if ((fp = fopen (fn, "w")) == NULL)
+  {
+    printf ("[%"PRIdPID"] error: can't open %s for writing\n", ddsrt_getpid (), fn);
+    return false;
+  }
+  fprintf (fp, "{\"pid\":%"PRIdPID",\"histograms\":[", ddsrt_getpid ());
+  bool first = true;
+  for (uint32_t i = 0; i < nprofiles; i++)
+  {
+    char name[64];
+    if (profiles[i].rd == 0)
+      continue;
+    snprintf (name, sizeof (name), "profile-%s", profiles[i].name);
+    fprintf (fp, "%s\n", first ? "" : ",");
+    latency_hist_write_json (fp, name, "oneway", profiles[i].lat_tot);
+    if (!write_hgrm_file (name, profiles[i].lat_tot))
+      ok = false;
+    first = false;
+  }
+  for (uint32_t i = 0; i < npongstat; i++)
+  {
+    char name[300];
+    struct ppant *pp;
+    ddsrt_mutex_lock (&disc_lock);
+    if ((pp = ddsrt_avl_lookup (&ppants_td, &ppants, &pongstat[i].pphandle)) == NULL)
+      snprintf (name, sizeof (name), "roundtrip-%"PRIx64, pongstat[i].pubhandle);
+    else
+      snprintf (name, sizeof (name), "roundtrip-%s-%"PRIu32, pp->hostname, pp->pid);
+    ddsrt_mutex_unlock (&disc_lock);
+    sanitize_name (name);
+    fprintf (fp, "%s\n", first ? "" : ",");
+    /* like the printed statistics, these are half the roundtrip time */
+    latency_hist_write_json (fp, name, "halfroundtrip", pongstat[i].hist);
+    if (!write_hgrm_file (name, pongstat[i].hist))
+      ok = false;
+    first = false;
+  }
+  fprintf (fp, "\n]}\n");
+  if (fclose (fp) != 0)
+  {
+    printf ("[%"PRIdPID"] error: writing %s failed\n", ddsrt_getpid (), fn);
+    ok = false;
+  }
+  return ok;
+}
+
 /********************
  COMMAND LINE PARSING
  ********************/
@@ -1635,6 +1871,22 @@ OPTIONS:\n\
                       data\n\
   -X                  output extended statistics\n\
   -i ID               use domain ID instead of the default domain\n\
+  -P LIST             traffic profiles to publish in \"pub\" and to\n\
+                      subscribe to in \"sub\", instead of publishing the\n\
+                      data topic; LIST is a comma-separated list of:\n\
+                        pointcloud    921600 bytes at 10Hz (PointCloud2)\n\
+                        occgrid       16480 bytes at 20Hz (OccupancyGrid)\n\
+                        can           40 bytes at 2kHz (CAN frame)\n\
+                        ros           all of the above\n\
+                        NAME:S@R      stream NAME of size S at rate R\n\
+                      each profile uses a topic of its own and all of them\n\
+                      run concurrently; rate, size and burst settings of\n\
+                      \"pub\" are ignored.  They report one-way latency,\n\
+                      which requires synchronized clocks\n\
+  -H PREFIX           at the end, write latency histograms of the profiles\n\
+                      and of the ping/pong roundtrips (half roundtrip time,\n\
+                      per peer) to PREFIX.json and in HdrHistogram format\n\
+                      to PREFIX-NAME.hgrm\n\
 \n\
 MODE... is zero or more of:\n\
   ping [R[Hz]] [size S] [waitset|listener]\n\
@@ -1679,6 +1931,9 @@ EXAMPLES:\n\
   ddsperf -L -TOU -D10 pub sub\n\
     basic throughput test within the process with tiny, keyless samples,\n\
     running for 10s\n\
+  ddsperf -P ros pub & ddsperf -P ros -D60 -H out sub\n\
+    mix of ROS-like traffic, writing the latency histograms to out.json\n\
+    and out-profile-*.hgrm\n\
 ", argv0, argv0, argv0);
   fflush (stdout);
   exit (3);
@@ -1794,6 +2049,67 @@ static bool set_simple_uint32 (int *xoptind, int xargc, char * const xargv[], co
   }
 }
 
+static void add_profile (const char *name, uint32_t size, double rate)
+{
+  if (*name == 0 || strlen (name) >= sizeof (profiles[0].name))
+    error3 ("%s: invalid profile name\n", name);
+  for (const char *p = name; *p; p++)
+    if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_'))
+      error3 ("%s: invalid profile name\n", name);
+  for (uint32_t i = 0; i < nprofiles; i++)
+    if (strcmp (profiles[i].name, name) == 0)
+      error3 ("%s: duplicate profile\n", name);
+  if (size < 12)
+    error3 ("%s: size %"PRIu32" invalid: too small to allow for overhead\n", name, size);
+  if (!(rate > 0 && rate < HUGE_VAL))
+    error3 ("%s: invalid rate\n", name);
+  profiles = realloc (profiles, (nprofiles + 1) * sizeof (*profiles));
+  struct profile_stream * const ps = &profiles[nprofiles++];
+  memset (ps, 0, sizeof (*ps));
+  (void) ddsrt_strlcpy (ps->name, name, sizeof (ps->name));
+  ps->size = size;
+  ps->rate = rate;
+}
+
+static void set_profiles (char *spec)
+{
+  char *tok;
+  while ((tok = ddsrt_strsep (&spec, ",")) != NULL)
+  {
+    char *col, *at;
+    unsigned size;
+    double rate;
+    int pos, mult;
+    if (strcmp (tok, "ros") == 0)
+    {
+      for (size_t i = 0; profile_defs[i].name; i++)
+        add_profile (profile_defs[i].name, profile_defs[i].size, profile_defs[i].rate);
+      continue;
+    }
+    else if ((col = strchr (tok, ':')) == NULL)
+    {
+      size_t i;
+      for (i = 0; profile_defs[i].name; i++)
+        if (strcmp (profile_defs[i].name, tok) == 0)
+          break;
+      if (profile_defs[i].name == NULL)
+        error3 ("-P %s: unknown profile\n", tok);
+      add_profile (profile_defs[i].name, profile_defs[i].size, profile_defs[i].rate);
+      continue;
+    }
+    *col++ = 0;
+    if ((at = strchr (col, '@')) == NULL)
+      error3 ("-P %s: expected NAME:SIZE@RATE\n", tok);
+    *at++ = 0;
+    if (sscanf (col, "%u%n", &size, &pos) != 1 || (mult = lookup_multiplier (size_units, col + pos)) == 0)
+      error3 ("-P %s: invalid size %s\n", tok, col);
+    size *= (unsigned) mult;
+    if (sscanf (at, "%lf%n", &rate, &pos) != 1 || (mult = lookup_multiplier (frequency_units, at + pos)) == 0)
+      error3 ("-P %s: invalid rate %s\n", tok, at);
+    add_profile (tok, size, rate * mult);
+  }
+}
+
 static void set_mode_ping (int *xoptind, int xargc, char * const xargv[])
 {
   ping_intv = 0;
@@ -1943,7 +2259,7 @@ int main (int argc, char *argv[])
 
   argv0 = argv[0];
 
-  while ((opt = getopt (argc, argv, "1cd:D:i:n:k:uLK:T:Q:R:Xh")) != EOF)
+  while ((opt = getopt (argc, argv, "1cd:D:i:n:k:uLK:T:P:H:Q:R:Xh")) != EOF)
   {
     int pos;
     switch (opt)
@@ -2000,6 +2316,8 @@ int main (int argc, char *argv[])
         break;
       }
       case 'X': extended_stats = true; break;
+      case 'P': set_profiles (optarg); break;
+      case 'H': histexport_prefix = optarg; break;
       case 'R': {
         tref = 0;
         if (sscanf (optarg, "%"SCNd64"%n", &tref, &pos) != 1 || optarg[pos] != 0)
@@ -2178,6 +2496,29 @@ int main (int argc, char *argv[])
     error2 ("dds_create_writer(%s) failed: %d\n", tpname_data, (int) wr_data);
   dds_delete_listener (listener);
 
+  /* profile streams use the same QoS as the data, but only get a writer when
+     publishing and a reader when subscribing */
+  for (uint32_t i = 0; i < nprofiles; i++)
+  {
+    struct profile_stream * const ps = &profiles[i];
+    char tpname[64];
+    dds_qos_t *tpqos = dds_create_qos ();
+    snprintf (tpname, sizeof (tpname), "DDSPerf%cProfile%s", reliable ? 'R' : 'U', ps->name);
+    dds_qset_reliability (tpqos, reliable ? DDS_RELIABILITY_RELIABLE : DDS_RELIABILITY_BEST_EFFORT, DDS_SECS (10));
+    if ((ps->tp = dds_create_topic (dp, &KeyedSeq_desc, tpname, tpqos, NULL)) < 0)
+      error2 ("dds_create_topic(%s) failed: %d\n", tpname, (int) ps->tp);
+    dds_delete_qos (tpqos);
+    if (pub_rate > 0 && (ps->wr = dds_create_writer (pub, ps->tp, qos, NULL)) < 0)
+      error2 ("dds_create_writer(%s) failed: %d\n", tpname, (int) ps->wr);
+    if (submode != SM_NONE && (ps->rd = dds_create_reader (sub, ps->tp, qos, NULL)) < 0)
+      error2 ("dds_create_reader(%s) failed: %d\n", tpname, (int) ps->rd);
+    init_eseq_admin (&ps->ea, 1);
+    subthread_arg_init (&ps->subarg, ps->rd, 100);
+    ddsrt_mutex_init (&ps->lock);
+    ps->lat = latency_hist_new ();
+    ps->lat_tot = latency_hist_new ();
+  }
+
   /* We only need a pong reader when sending data with a non-zero probability
      of it being a "ping", or when sending "real" pings.  I.e., if
        rate > 0 && ping_frac > 0) || ping_intv != DDS_NEVER
@@ -2267,8 +2608,15 @@ int main (int argc, char *argv[])
     dds_sleepfor (DDS_MSECS (100));
   }
 
-  if (pub_rate > 0)
+  if (pub_rate > 0 && nprofiles == 0)
     ddsrt_thread_create (&pubtid, "pub", &attr, pubthread, NULL);
+  for (uint32_t i = 0; i < nprofiles; i++)
+  {
+    if (profiles[i].wr)
+      ddsrt_thread_create (&profiles[i].tid, "profile", &attr, profile_pubthread, &profiles[i]);
+    if (profiles[i].rd)
+      set_data_available_listener (profiles[i].rd, profiles[i].name, profile_available_listener, &profiles[i]);
+  }
   if (subthread_func != 0)
     ddsrt_thread_create (&subtid, "sub", &attr, subthread_func, &subarg_data);
   else if (submode == SM_LISTENER)
@@ -2462,8 +2810,11 @@ int main (int argc, char *argv[])
   }
 #endif
 
-  if (pub_rate > 0)
+  if (pub_rate > 0 && nprofiles == 0)
     ddsrt_thread_join (pubtid, NULL);
+  for (uint32_t i = 0; i < nprofiles; i++)
+    if (profiles[i].wr)
+      ddsrt_thread_join (profiles[i].tid, NULL);
   if (subthread_func != 0)
     ddsrt_thread_join (subtid, NULL);
   if (pingpong_waitset)
@@ -2479,6 +2830,9 @@ err_minmatch_wait:
   dds_set_listener (rd_ping, NULL);
   dds_set_listener (rd_pong, NULL);
   dds_set_listener (rd_data, NULL);
+  for (uint32_t i = 0; i < nprofiles; i++)
+    if (profiles[i].rd)
+      dds_set_listener (profiles[i].rd, NULL);
   dds_set_listener (rd_participants, NULL);
   dds_set_listener (rd_subscriptions, NULL);
   dds_set_listener (rd_publications, NULL);
@@ -2505,6 +2859,26 @@ err_minmatch_wait:
     if (eseq_admin.stats[i].nrecv < (uint64_t) min_received)
       received_ok = false;
   }
+  for (uint32_t i = 0; i < nprofiles; i++)
+  {
+    for (uint32_t j = 0; j < profiles[i].ea.nph; j++)
+    {
+      nlost += profiles[i].ea.stats[j].nlost;
+      if (profiles[i].ea.stats[j].nrecv < (uint64_t) min_received)
+        received_ok = false;
+    }
+  }
+  const bool export_ok = (histexport_prefix == NULL) || export_histograms ();
+  for (uint32_t i = 0; i < nprofiles; i++)
+  {
+    struct profile_stream * const ps = &profiles[i];
+    subthread_arg_fini (&ps->subarg);
+    fini_eseq_admin (&ps->ea);
+    ddsrt_mutex_destroy (&ps->lock);
+    latency_hist_free (ps->lat);
+    latency_hist_free (ps->lat_tot);
+  }
+  free (profiles);
   fini_eseq_admin (&eseq_admin);
   subthread_arg_fini (&subarg_data);
   subthread_arg_fini (&subarg_ping);
@@ -2522,10 +2896,11 @@ err_minmatch_wait:
     if (pongstat[i].totcnt < min_roundtrips)
       roundtrips_ok = false;
     free (pongstat[i].raw);
+    latency_hist_free (pongstat[i].hist);
   }
   free (pongstat);
 
-  bool ok = true;
+  bool ok = export_ok;
 
   {
     ddsrt_avl_iter_t it;
@@ -0,0 +1,242 @@
+/*
+ * Copyright(c) 2020 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#define _ISOC99_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <inttypes.h>
+
+#include "latency_hist.h"
+
+/* Values below SUBBUCKETS are counted exactly, after that each power-of-two
+   range [2^k,2^(k+1)) is divided in SUBBUCKETS/2 equal parts.  That is the
+   same layout HdrHistogram uses for 2 significant digits. */
+#define SUBBUCKET_BITS 7
+#define SUBBUCKETS (1u << SUBBUCKET_BITS)
+#define MAX_EXPONENT 32
+#define NBUCKETS (SUBBUCKETS * (MAX_EXPONENT + 2))
+#define MAX_VALUE ((UINT64_C (1) << (MAX_EXPONENT + SUBBUCKET_BITS + 1)) - 1)
+
+struct latency_hist {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t min, max;
+  uint64_t bins[NBUCKETS];
+};
+
+static unsigned msb (uint64_t x)
+{
+  unsigned n = 0;
+  assert (x > 0);
+  for (unsigned s = 32; s > 0; s /= 2)
+  {
+    if (x >> s)
+    {
+      x >>= s;
+      n += s;
+    }
+  }
+  return n;
+}
+
+static size_t bucket_index (uint64_t x)
+{
+  if (x < SUBBUCKETS)
+    return (size_t) x;
+  const unsigned e = msb (x) - SUBBUCKET_BITS;
+  return (size_t) (SUBBUCKETS * e + (x >> e));
+}
+
+static uint64_t bucket_lower (size_t i)
+{
+  if (i < SUBBUCKETS)
+    return i;
+  const unsigned e = (unsigned) (i / SUBBUCKETS) - 1;
+  return (uint64_t) (i - SUBBUCKETS * e) << e;
+}
+
+static uint64_t bucket_upper (size_t i)
+{
+  if (i < SUBBUCKETS)
+    return i;
+  const unsigned e = (unsigned) (i / SUBBUCKETS) - 1;
+  return (((uint64_t) (i - SUBBUCKETS * e) + 1) << e) - 1;
+}
+
+struct latency_hist *latency_hist_new (void)
+{
+  struct latency_hist *h = malloc (sizeof (*h));
+  latency_hist_reset (h);
+  return h;
+}
+
+void latency_hist_free (struct latency_hist *h)
+{
+  free (h);
+}
+
+void latency_hist_reset (struct latency_hist *h)
+{
+  h->count = 0;
+  h->sum = 0;
+  h->min = UINT64_MAX;
+  h->max = 0;
+  memset (h->bins, 0, sizeof (h->bins));
+}
+
+void latency_hist_record (struct latency_hist *h, uint64_t x)
+{
+  if (x > MAX_VALUE)
+    x = MAX_VALUE;
+  if (x < h->min)
+    h->min = x;
+  if (x > h->max)
+    h->max = x;
+  h->count++;
+  h->sum += x;
+  h->bins[bucket_index (x)]++;
+}
+
+uint64_t latency_hist_count (const struct latency_hist *h)
+{
+  return h->count;
+}
+
+uint64_t latency_hist_min (const struct latency_hist *h)
+{
+  return (h->count == 0) ? 0 : h->min;
+}
+
+uint64_t latency_hist_max (const struct latency_hist *h)
+{
+  return h->max;
+}
+
+double latency_hist_mean (const struct latency_hist *h)
+{
+  return (h->count == 0) ? 0.0 : (double) h->sum / (double) h->count;
+}
+
+static uint64_t count_at_percentile (const struct latency_hist *h, double pct)
+{
+  const uint64_t n = (uint64_t) ceil (pct / 100.0 * (double) h->count);
+  return (n == 0) ? 1 : (n > h->count) ? h->count : n;
+}
+
+static uint64_t highest_equivalent (const struct latency_hist *h, size_t i)
+{
+  const uint64_t x = bucket_upper (i);
+  return (x > h->max) ? h->max : x;
+}
+
+uint64_t latency_hist_percentile (const struct latency_hist *h, double pct)
+{
+  if (h->count == 0)
+    return 0;
+  const uint64_t target = count_at_percentile (h, pct);
+  uint64_t cum = 0;
+  for (size_t i = 0; i < NBUCKETS; i++)
+  {
+    if ((cum += h->bins[i]) >= target)
+      return highest_equivalent (h, i);
+  }
+  return h->max;
+}
+
+static double stddev (const struct latency_hist *h)
+{
+  if (h->count == 0)
+    return 0.0;
+  const double mean = latency_hist_mean (h);
+  double sumsq = 0.0;
+  for (size_t i = 0; i < NBUCKETS; i++)
+  {
+    if (h->bins[i])
+    {
+      const double d = (double) (bucket_lower (i) + bucket_upper (i)) / 2.0 - mean;
+      sumsq += d * d * (double) h->bins[i];
+    }
+  }
+  return sqrt (sumsq / (double) h->count);
+}
+
+void latency_hist_write_hgrm (FILE *fp, const struct latency_hist *h)
+{
+  /* Same sequence of percentiles as HdrHistogram's percentile iterator with 5 ticks
+     per half distance: 0, 10, 20, ... 50, 55, ... 75, 77.5, ... */
+  const double scale = 1e3;
+  fprintf (fp, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+  if (h->count > 0)
+  {
+    double pct = 0.0;
+    uint64_t cum = 0;
+    for (size_t i = 0; i < NBUCKETS && cum < h->count; i++)
+    {
+      if (h->bins[i] == 0)
+        continue;
+      cum += h->bins[i];
+      while (cum >= count_at_percentile (h, pct))
+      {
+        fprintf (fp, "%12.3f %2.12f %10"PRIu64" %14.2f\n", (double) highest_equivalent (h, i) / scale, pct / 100.0, cum, 1.0 / (1.0 - pct / 100.0));
+        if (cum == h->count)
+          break;
+        const double half_distance = pow (2.0, floor (log2 (100.0 / (100.0 - pct))) + 1.0);
+        pct += 100.0 / (5.0 * half_distance);
+      }
+    }
+    fprintf (fp, "%12.3f %2.12f %10"PRIu64"\n", (double) h->max / scale, 1.0, h->count);
+  }
+  fprintf (fp, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", latency_hist_mean (h) / scale, stddev (h) / scale);
+  fprintf (fp, "#[Max     = %12.3f, Total count    = %12"PRIu64"]\n", (double) h->max / scale, h->count);
+  fprintf (fp, "#[Buckets = %12u, SubBuckets     = %12u]\n", MAX_EXPONENT + 1, 2 * SUBBUCKETS);
+}
+
+static void write_json_string (FILE *fp, const char *s)
+{
+  fputc ('"', fp);
+  for (; *s; s++)
+  {
+    if (*s == '"' || *s == '\\')
+      fprintf (fp, "\\%c", *s);
+    else if ((unsigned char) *s < 0x20)
+      fprintf (fp, "\\u%04x", (unsigned) *s);
+    else
+      fputc (*s, fp);
+  }
+  fputc ('"', fp);
+}
+
+void latency_hist_write_json (FILE *fp, const char *name, const char *kind, const struct latency_hist *h)
+{
+  static const double pcts[] = { 50, 90, 99, 99.9, 99.99, 100 };
+  fprintf (fp, "{\"name\":");
+  write_json_string (fp, name);
+  fprintf (fp, ",\"kind\":");
+  write_json_string (fp, kind);
+  fprintf (fp, ",\"unit\":\"ns\",\"count\":%"PRIu64",\"min\":%"PRIu64",\"max\":%"PRIu64",\"mean\":%.1f,\"stddev\":%.1f,\"percentiles\":{",
+           h->count, latency_hist_min (h), h->max, latency_hist_mean (h), stddev (h));
+  for (size_t i = 0; i < sizeof (pcts) / sizeof (pcts[0]); i++)
+    fprintf (fp, "%s\"%g\":%"PRIu64, (i == 0) ? "" : ",", pcts[i], latency_hist_percentile (h, pcts[i]));
+  fprintf (fp, "},\"buckets\":[");
+  bool first = true;
+  for (size_t i = 0; i < NBUCKETS; i++)
+  {
+    if (h->bins[i])
+    {
+      fprintf (fp, "%s[%"PRIu64",%"PRIu64",%"PRIu64"]", first ? "" : ",", bucket_lower (i), bucket_upper (i), h->bins[i]);
+      first = false;
+    }
+  }
+  fprintf (fp, "]}");
+}
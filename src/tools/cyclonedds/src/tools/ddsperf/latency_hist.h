@@ -0,0 +1,45 @@
+/*
+ * Copyright(c) 2020 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Log-linear histogram of latencies in ns in the style of HdrHistogram: exact
+   below 128ns, and with a relative error of less than 1% above that, up to
+   about 18 minutes.  Larger values are counted as the maximum. */
+struct latency_hist;
+
+struct latency_hist *latency_hist_new (void);
+void latency_hist_free (struct latency_hist *h);
+void latency_hist_reset (struct latency_hist *h);
+void latency_hist_record (struct latency_hist *h, uint64_t x);
+uint64_t latency_hist_count (const struct latency_hist *h);
+uint64_t latency_hist_min (const struct latency_hist *h);
+uint64_t latency_hist_max (const struct latency_hist *h);
+double latency_hist_mean (const struct latency_hist *h);
+
+/* Value at percentile PCT (0 .. 100): the highest value equivalent to the
+   one in the bucket it falls in, but never more than the maximum */
+uint64_t latency_hist_percentile (const struct latency_hist *h, double pct);
+
+/* Writes the percentile distribution in the text format of HdrHistogram
+   (".hgrm"), with values in us, so the usual plotting tools can be used */
+void latency_hist_write_hgrm (FILE *fp, const struct latency_hist *h);
+
+/* Writes a JSON object describing the histogram, with some percentiles and
+   all non-empty buckets as [lower bound, upper bound, count] triples */
+void latency_hist_write_json (FILE *fp, const char *name, const char *kind, const struct latency_hist *h);
+
+#endif
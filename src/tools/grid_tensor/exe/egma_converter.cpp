@@ -0,0 +1,20 @@
+/*
+ * Package:   grid_tensor
+ * Filename:  egma_converter.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <memory> // std::make_shared
+#include "rclcpp/rclcpp.hpp"
+#include "grid_tensor/EgmaConverterNode.hpp"
+
+int main(int argc, char **argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<navigator::grid_tensor::EgmaConverterNode>());
+  rclcpp::shutdown();
+  return 0;
+}
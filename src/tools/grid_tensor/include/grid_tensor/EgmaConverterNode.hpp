@@ -0,0 +1,39 @@
+/*
+ * Package:   grid_tensor
+ * Filename:  EgmaConverterNode.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Republishes Egmas as GridTensors, so consumers such as RRT can take
+// tensors while producers, such as the Python cost and prediction
+// nodes, still publish Egmas.
+
+#pragma once
+
+#include <cstdint>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "nova_msgs/msg/egma.hpp"
+#include "nova_msgs/msg/grid_tensor.hpp"
+
+namespace navigator {
+namespace grid_tensor {
+
+class EgmaConverterNode : public rclcpp::Node {
+public:
+  explicit EgmaConverterNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+private:
+  void egma_cb(nova_msgs::msg::Egma::ConstSharedPtr egma);
+
+  uint8_t encoding;
+  rclcpp::Subscription<nova_msgs::msg::Egma>::SharedPtr subscription;
+  rclcpp::Publisher<nova_msgs::msg::GridTensor>::SharedPtr publisher;
+};
+
+}
+}
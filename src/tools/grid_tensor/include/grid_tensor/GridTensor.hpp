@@ -0,0 +1,127 @@
+/*
+ * Package:   grid_tensor
+ * Filename:  GridTensor.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Reading and writing nova_msgs/GridTensor cells, and making tensors
+// from Egmas.
+//
+// A tensor's cells are [layer][row][col] in one array, so a layer, or a
+// row of one, is a single block of memory: consumers walk it or copy it
+// out without chasing a vector per layer, and a tensor is serialized as
+// one byte array. UINT8 cells hold value * 255, rounded; FLOAT16 cells
+// are IEEE 754 half precision floats, low byte first.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::memcpy
+
+#include "nova_msgs/msg/egma.hpp"
+#include "nova_msgs/msg/grid_tensor.hpp"
+
+namespace navigator {
+namespace grid_tensor {
+
+// Rounded to nearest, ties to even. Values beyond the largest half,
+// 65504, become infinities, and NaN stays NaN.
+inline uint16_t float_to_half(float value) {
+  uint32_t bits;
+  std::memcpy(& bits, & value, sizeof(bits));
+  const uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+  const uint32_t magnitude = bits & 0x7fffffff;
+  if(magnitude > 0x7f800000) return sign | 0x7e00; // NaN
+  if(magnitude >= 0x477ff000) return sign | 0x7c00; // Rounds past 65504
+  if(magnitude < 0x38800000) {
+    // Below the smallest normal half, 2^-14, a half counts 2^-24s
+    float scaled;
+    std::memcpy(& scaled, & magnitude, sizeof(scaled));
+    scaled *= 16777216.0f; // Exact, and under 1024
+    uint32_t count = uint32_t(scaled);
+    const float rest = scaled - float(count);
+    if(rest > 0.5f || (rest == 0.5f && (count & 1))) count++;
+    return sign | uint16_t(count);
+  }
+  // Rebias the exponent and round the mantissa away; a carry out of the
+  // mantissa moves the exponent up, as it should
+  const uint32_t rounded = magnitude + 0xfff + ((magnitude >> 13) & 1);
+  return sign | uint16_t((rounded - 0x38000000) >> 13);
+}
+
+inline float half_to_float(uint16_t half) {
+  const uint32_t sign = uint32_t(half & 0x8000) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1f;
+  const uint32_t mantissa = half & 0x3ff;
+  if(exponent == 0) {
+    // Zero, or subnormal at mantissa * 2^-24
+    const float magnitude = float(mantissa) * (1.0f / 16777216.0f);
+    return sign ? -magnitude : magnitude;
+  }
+  const uint32_t bits = exponent == 0x1f ? (sign | 0x7f800000 | (mantissa << 13)) // Infinity, NaN
+    : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+  float value;
+  std::memcpy(& value, & bits, sizeof(value));
+  return value;
+}
+
+// Bytes per cell. Throws std::invalid_argument for an unknown encoding.
+std::size_t cell_size(uint8_t encoding);
+
+// Sets the dimensions and encoding, and sizes data, zeroed, and stamps
+// to match. Throws std::invalid_argument for an unknown encoding.
+void reshape(nova_msgs::msg::GridTensor & tensor, uint32_t layers, uint32_t rows, uint32_t cols,
+	     uint8_t encoding);
+
+// Stores cols() values into a row of a reshaped tensor. UINT8 cells
+// clamp to [0, 1], with NaN as 1.
+void set_row(nova_msgs::msg::GridTensor & tensor, uint32_t layer, uint32_t row, const float * values);
+
+// An Egma's layers as one tensor, with its header and goal, the first
+// layer's resolution and origin, and each layer's stamp. Occupancy
+// values from 0 to 100 become 0 to 1, and unknown cells 1. Throws
+// std::invalid_argument if the layers differ in size or one's data
+// doesn't fill it.
+void from_egma(const nova_msgs::msg::Egma & egma, uint8_t encoding, nova_msgs::msg::GridTensor & tensor);
+
+// Reads a tensor's cells as floats. The tensor must outlive the view.
+class GridTensorView {
+public:
+  // Throws std::invalid_argument if the data or stamps don't match the
+  // dimensions, or the encoding is unknown
+  explicit GridTensorView(const nova_msgs::msg::GridTensor & tensor);
+
+  uint32_t layers() const { return this->tensor.layers; }
+  uint32_t rows() const { return this->tensor.rows; }
+  uint32_t cols() const { return this->tensor.cols; }
+  const builtin_interfaces::msg::Time & stamp(uint32_t layer) const { return this->tensor.stamps[layer]; }
+
+  // Unchecked
+  float at(uint32_t layer, uint32_t row, uint32_t col) const {
+    const uint8_t * cell = this->row_data(layer, row) + std::size_t(col) * this->cell_bytes;
+    if(this->tensor.encoding == nova_msgs::msg::GridTensor::ENCODING_UINT8) {
+      return float(cell[0]) * (1.0f / 255.0f);
+    }
+    return half_to_float(uint16_t(cell[0] | (cell[1] << 8)));
+  }
+
+  // The cols() cells of a row into out
+  void copy_row(uint32_t layer, uint32_t row, float * out) const;
+
+  // A row's cells as stored, cols() of cell_size(encoding) bytes
+  const uint8_t * row_data(uint32_t layer, uint32_t row) const {
+    return this->tensor.data.data() +
+      (std::size_t(layer) * this->tensor.rows + row) * this->tensor.cols * this->cell_bytes;
+  }
+
+private:
+  const nova_msgs::msg::GridTensor & tensor;
+  std::size_t cell_bytes;
+};
+
+}
+}
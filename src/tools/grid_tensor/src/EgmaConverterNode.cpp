@@ -0,0 +1,58 @@
+/*
+ * Package:   grid_tensor
+ * Filename:  EgmaConverterNode.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "grid_tensor/EgmaConverterNode.hpp"
+#include "grid_tensor/GridTensor.hpp"
+
+using navigator::grid_tensor::EgmaConverterNode;
+using nova_msgs::msg::Egma;
+using nova_msgs::msg::GridTensor;
+
+EgmaConverterNode::EgmaConverterNode(const rclcpp::NodeOptions & options)
+  : Node("egma_converter", options) {
+  const std::string input_topic = this->declare_parameter<std::string>("input_topic", "/egma/cost");
+  const std::string output_topic = this->declare_parameter<std::string>("output_topic", "/planning/cost_map");
+  // "uint8" takes a byte a cell, as the Egma's grids do; "float16" takes
+  // two, for producers whose costs are finer than 1/255
+  const std::string encoding_name = this->declare_parameter<std::string>("encoding", "uint8");
+  if(encoding_name == "uint8") {
+    this->encoding = GridTensor::ENCODING_UINT8;
+  } else if(encoding_name == "float16") {
+    this->encoding = GridTensor::ENCODING_FLOAT16;
+  } else {
+    throw std::invalid_argument("encoding must be \"uint8\" or \"float16\", not \"" + encoding_name + "\"");
+  }
+
+  this->publisher = this->create_publisher<GridTensor>(output_topic, 5);
+  this->subscription = this->create_subscription<Egma>
+    (input_topic, 5, std::bind(& EgmaConverterNode::egma_cb, this, std::placeholders::_1));
+}
+
+void EgmaConverterNode::egma_cb(Egma::ConstSharedPtr egma) {
+  if(this->publisher->get_subscription_count() == 0) return;
+  auto tensor = std::make_unique<GridTensor>();
+  try {
+    from_egma(* egma, this->encoding, * tensor);
+  } catch(const std::invalid_argument & error) {
+    RCLCPP_WARN(this->get_logger(), "Dropping an Egma: %s", error.what());
+    return;
+  }
+  this->publisher->publish(std::move(tensor));
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(navigator::grid_tensor::EgmaConverterNode)
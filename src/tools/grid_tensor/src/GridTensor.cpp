@@ -0,0 +1,141 @@
+/*
+ * Package:   grid_tensor
+ * Filename:  GridTensor.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <cmath> // std::lround
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "grid_tensor/GridTensor.hpp"
+
+using nova_msgs::msg::Egma;
+using nova_msgs::msg::GridTensor;
+
+namespace {
+
+uint8_t to_uint8(float value) {
+  if(!(value < 1.0f)) return 255; // And NaN
+  if(!(value > 0.0f)) return 0;
+  return uint8_t(std::lround(value * 255.0f));
+}
+
+// Bytes of an encoding's cells from floats
+void encode(uint8_t encoding, const float * values, std::size_t count, uint8_t * out) {
+  if(encoding == GridTensor::ENCODING_UINT8) {
+    for(std::size_t i = 0; i < count; i++) {
+      out[i] = to_uint8(values[i]);
+    }
+  } else {
+    for(std::size_t i = 0; i < count; i++) {
+      const uint16_t half = navigator::grid_tensor::float_to_half(values[i]);
+      out[2 * i] = uint8_t(half & 0xff);
+      out[2 * i + 1] = uint8_t(half >> 8);
+    }
+  }
+}
+
+}
+
+std::size_t navigator::grid_tensor::cell_size(uint8_t encoding) {
+  switch(encoding) {
+  case GridTensor::ENCODING_UINT8:
+    return 1;
+  case GridTensor::ENCODING_FLOAT16:
+    return 2;
+  default:
+    throw std::invalid_argument("Unknown grid tensor encoding " + std::to_string(encoding));
+  }
+}
+
+void navigator::grid_tensor::reshape(GridTensor & tensor, uint32_t layers, uint32_t rows, uint32_t cols,
+				     uint8_t encoding) {
+  const std::size_t bytes = std::size_t(layers) * rows * cols * cell_size(encoding);
+  tensor.layers = layers;
+  tensor.rows = rows;
+  tensor.cols = cols;
+  tensor.encoding = encoding;
+  // assign() rather than resize(), so a reused message is zeroed too
+  tensor.data.assign(bytes, 0);
+  tensor.stamps.resize(layers);
+}
+
+void navigator::grid_tensor::set_row(GridTensor & tensor, uint32_t layer, uint32_t row, const float * values) {
+  const std::size_t bytes = cell_size(tensor.encoding);
+  uint8_t * out = tensor.data.data() + (std::size_t(layer) * tensor.rows + row) * tensor.cols * bytes;
+  encode(tensor.encoding, values, tensor.cols, out);
+}
+
+void navigator::grid_tensor::from_egma(const Egma & egma, uint8_t encoding, GridTensor & tensor) {
+  const uint32_t layers = uint32_t(egma.egma.size());
+  const uint32_t rows = layers == 0 ? 0 : egma.egma[0].info.height;
+  const uint32_t cols = layers == 0 ? 0 : egma.egma[0].info.width;
+  for(uint32_t layer = 0; layer < layers; layer++) {
+    const nav_msgs::msg::OccupancyGrid & grid = egma.egma[layer];
+    if(grid.info.height != rows || grid.info.width != cols) {
+      throw std::invalid_argument("Egma layer " + std::to_string(layer) + " is " +
+				  std::to_string(grid.info.width) + "x" + std::to_string(grid.info.height) +
+				  ", not " + std::to_string(cols) + "x" + std::to_string(rows));
+    }
+    if(grid.data.size() < std::size_t(rows) * cols) {
+      throw std::invalid_argument("Egma layer " + std::to_string(layer) + " has " +
+				  std::to_string(grid.data.size()) + " cells for " +
+				  std::to_string(std::size_t(rows) * cols));
+    }
+  }
+
+  reshape(tensor, layers, rows, cols, encoding);
+  tensor.header = egma.header;
+  tensor.goal_point = egma.goal_point;
+  if(layers != 0) {
+    tensor.resolution = egma.egma[0].info.resolution;
+    tensor.origin = egma.egma[0].info.origin;
+  }
+
+  std::vector<float> values(cols);
+  for(uint32_t layer = 0; layer < layers; layer++) {
+    const nav_msgs::msg::OccupancyGrid & grid = egma.egma[layer];
+    tensor.stamps[layer] = grid.header.stamp;
+    for(uint32_t row = 0; row < rows; row++) {
+      const int8_t * cells = grid.data.data() + std::size_t(row) * cols;
+      for(uint32_t col = 0; col < cols; col++) {
+	const int8_t cell = cells[col];
+	values[col] = cell < 0 || cell > 100 ? 1.0f : float(cell) * 0.01f;
+      }
+      set_row(tensor, layer, row, values.data());
+    }
+  }
+}
+
+navigator::grid_tensor::GridTensorView::GridTensorView(const GridTensor & tensor)
+  : tensor(tensor), cell_bytes(cell_size(tensor.encoding)) {
+  const std::size_t expected = std::size_t(tensor.layers) * tensor.rows * tensor.cols * this->cell_bytes;
+  if(tensor.data.size() != expected) {
+    throw std::invalid_argument("Grid tensor has " + std::to_string(tensor.data.size()) + " bytes for " +
+				std::to_string(expected));
+  }
+  if(tensor.stamps.size() != tensor.layers) {
+    throw std::invalid_argument("Grid tensor has " + std::to_string(tensor.stamps.size()) + " stamps for " +
+				std::to_string(tensor.layers) + " layers");
+  }
+}
+
+void navigator::grid_tensor::GridTensorView::copy_row(uint32_t layer, uint32_t row, float * out) const {
+  const uint8_t * cells = this->row_data(layer, row);
+  const uint32_t cols = this->tensor.cols;
+  if(this->tensor.encoding == GridTensor::ENCODING_UINT8) {
+    for(uint32_t col = 0; col < cols; col++) {
+      out[col] = float(cells[col]) * (1.0f / 255.0f);
+    }
+  } else {
+    for(uint32_t col = 0; col < cols; col++) {
+      out[col] = half_to_float(uint16_t(cells[2 * col] | (cells[2 * col + 1] << 8)));
+    }
+  }
+}
@@ -0,0 +1,154 @@
+/*
+ * Package:   grid_tensor
+ * Filename:  test_grid_tensor.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "grid_tensor/GridTensor.hpp"
+
+using namespace navigator::grid_tensor;
+using nav_msgs::msg::OccupancyGrid;
+using nova_msgs::msg::Egma;
+using nova_msgs::msg::GridTensor;
+
+namespace {
+
+// A cols x rows grid with cells counting up from first, stamped at sec
+OccupancyGrid make_grid(uint32_t cols, uint32_t rows, int first, int32_t sec) {
+  OccupancyGrid grid;
+  grid.header.stamp.sec = sec;
+  grid.info.width = cols;
+  grid.info.height = rows;
+  grid.info.resolution = 0.5f;
+  grid.info.origin.position.x = -10.0;
+  for(uint32_t i = 0; i < cols * rows; i++) {
+    grid.data.push_back(int8_t((first + int(i)) % 101));
+  }
+  return grid;
+}
+
+}
+
+TEST(GridTensor, HalvesRoundTripExactly) {
+  for(uint32_t half = 0; half < 0x10000; half++) {
+    const float value = half_to_float(uint16_t(half));
+    if(std::isnan(value)) {
+      EXPECT_TRUE(std::isnan(half_to_float(float_to_half(value))));
+    } else {
+      EXPECT_EQ(float_to_half(value), half) << "half " << half;
+    }
+  }
+}
+
+TEST(GridTensor, HalvesRoundToNearestEven) {
+  EXPECT_EQ(half_to_float(float_to_half(0.1f)), 0.0999755859375f);
+  // Halfway between 1 and the next half, 1 + 2^-10, goes to the even 1
+  EXPECT_EQ(float_to_half(1.0f + 1.0f / 2048.0f), float_to_half(1.0f));
+  EXPECT_EQ(float_to_half(1.0f + 3.0f / 2048.0f), float_to_half(1.0f + 2.0f / 1024.0f));
+  EXPECT_EQ(half_to_float(float_to_half(65504.0f)), 65504.0f);
+  EXPECT_TRUE(std::isinf(half_to_float(float_to_half(65520.0f))));
+  EXPECT_EQ(half_to_float(float_to_half(-1e-7f)), -1.0f / 16777216.0f * 2.0f);
+  EXPECT_EQ(float_to_half(1e-9f), 0);
+  EXPECT_TRUE(std::isnan(half_to_float(float_to_half(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST(GridTensor, RowsRoundTrip) {
+  for(uint8_t encoding : {GridTensor::ENCODING_UINT8, GridTensor::ENCODING_FLOAT16}) {
+    GridTensor tensor;
+    reshape(tensor, 3, 4, 5, encoding);
+    std::vector<float> values(5);
+    for(uint32_t layer = 0; layer < 3; layer++) {
+      for(uint32_t row = 0; row < 4; row++) {
+	for(uint32_t col = 0; col < 5; col++) {
+	  values[col] = float(layer * 20 + row * 5 + col) / 60.0f;
+	}
+	set_row(tensor, layer, row, values.data());
+      }
+    }
+
+    const GridTensorView view(tensor);
+    const float tolerance = encoding == GridTensor::ENCODING_UINT8 ? 0.5f / 255.0f + 1e-6f : 1e-3f;
+    std::vector<float> copied(5);
+    for(uint32_t layer = 0; layer < 3; layer++) {
+      for(uint32_t row = 0; row < 4; row++) {
+	view.copy_row(layer, row, copied.data());
+	for(uint32_t col = 0; col < 5; col++) {
+	  const float expected = float(layer * 20 + row * 5 + col) / 60.0f;
+	  EXPECT_NEAR(view.at(layer, row, col), expected, tolerance);
+	  EXPECT_EQ(copied[col], view.at(layer, row, col));
+	}
+      }
+    }
+  }
+}
+
+TEST(GridTensor, Uint8CellsClamp) {
+  GridTensor tensor;
+  reshape(tensor, 1, 1, 4, GridTensor::ENCODING_UINT8);
+  const float values[4] = {-1.0f, 2.0f, std::numeric_limits<float>::quiet_NaN(), 0.5f};
+  set_row(tensor, 0, 0, values);
+  EXPECT_EQ(tensor.data, std::vector<uint8_t>({0, 255, 255, 128}));
+}
+
+TEST(GridTensor, ConvertsEgmas) {
+  Egma egma;
+  egma.header.frame_id = "base_link";
+  egma.goal_point.y = 5;
+  egma.egma.push_back(make_grid(6, 2, 0, 1));
+  egma.egma.push_back(make_grid(6, 2, 50, 2));
+  egma.egma[1].data[3] = -1; // Unknown
+
+  GridTensor tensor;
+  from_egma(egma, GridTensor::ENCODING_UINT8, tensor);
+  const GridTensorView view(tensor);
+  EXPECT_EQ(tensor.header.frame_id, "base_link");
+  EXPECT_EQ(tensor.goal_point.y, 5);
+  EXPECT_EQ(tensor.resolution, 0.5f);
+  EXPECT_EQ(tensor.origin.position.x, -10.0);
+  ASSERT_EQ(view.layers(), 2u);
+  EXPECT_EQ(view.rows(), 2u);
+  EXPECT_EQ(view.cols(), 6u);
+  EXPECT_EQ(view.stamp(0).sec, 1);
+  EXPECT_EQ(view.stamp(1).sec, 2);
+  EXPECT_EQ(tensor.data.size(), 24u);
+  for(uint32_t row = 0; row < 2; row++) {
+    for(uint32_t col = 0; col < 6; col++) {
+      EXPECT_NEAR(view.at(0, row, col), float(row * 6 + col) / 100.0f, 0.5f / 255.0f);
+    }
+  }
+  EXPECT_EQ(view.at(1, 0, 3), 1.0f);
+}
+
+TEST(GridTensor, RejectsMismatchedEgmaLayers) {
+  Egma egma;
+  egma.egma.push_back(make_grid(6, 2, 0, 1));
+  egma.egma.push_back(make_grid(5, 2, 0, 2));
+  GridTensor tensor;
+  EXPECT_THROW(from_egma(egma, GridTensor::ENCODING_UINT8, tensor), std::invalid_argument);
+
+  egma.egma[1] = make_grid(6, 2, 0, 2);
+  egma.egma[1].data.pop_back();
+  EXPECT_THROW(from_egma(egma, GridTensor::ENCODING_UINT8, tensor), std::invalid_argument);
+}
+
+TEST(GridTensor, ViewRejectsShortData) {
+  GridTensor tensor;
+  reshape(tensor, 2, 3, 4, GridTensor::ENCODING_FLOAT16);
+  tensor.data.pop_back();
+  EXPECT_THROW(GridTensorView view(tensor), std::invalid_argument);
+  reshape(tensor, 2, 3, 4, GridTensor::ENCODING_FLOAT16);
+  tensor.stamps.pop_back();
+  EXPECT_THROW(GridTensorView view(tensor), std::invalid_argument);
+  tensor.encoding = 7;
+  EXPECT_THROW(GridTensorView view(tensor), std::invalid_argument);
+}
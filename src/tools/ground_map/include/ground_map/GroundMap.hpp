@@ -0,0 +1,73 @@
+/*
+ * Package:   ground_map
+ * Filename:  GroundMap.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Reading nova_msgs/GroundMap, the ground heights and cells the ground
+// segmentation works out for each scan, so that a node needing the
+// ground under a point looks it up rather than estimating it again.
+//
+// Cell (x, y) is at [x * size + y] in both arrays, and covers the square
+// from origin + (x, y) * resolution to a cell further along each axis.
+// The grid is axis aligned in the header's frame, as the segmentation
+// publishes it, so the origin's orientation is not used.
+
+#pragma once
+
+#include <cmath> // std::floor
+#include <cstddef>
+#include <cstdint>
+
+#include "nova_msgs/msg/ground_map.hpp"
+
+namespace navigator {
+namespace ground_map {
+
+// Reads a map's cells by index or by position. The map must outlive the
+// view.
+class GroundMapView {
+public:
+  // Throws std::invalid_argument if the elevation or cells don't have
+  // size * size entries, or the resolution isn't positive
+  explicit GroundMapView(const nova_msgs::msg::GroundMap & map);
+
+  uint32_t size() const { return this->map.size; }
+  float resolution() const { return this->map.resolution; }
+
+  // The cell containing a position in the header's frame. False, leaving
+  // x and y alone, if the position is off the grid.
+  bool cell_of(double px, double py, uint32_t & x, uint32_t & y) const {
+    const double fx = std::floor((px - this->map.origin.position.x) / this->map.resolution);
+    const double fy = std::floor((py - this->map.origin.position.y) / this->map.resolution);
+    if(!(fx >= 0.0 && fx < this->map.size && fy >= 0.0 && fy < this->map.size)) return false; // And NaN
+    x = uint32_t(fx);
+    y = uint32_t(fy);
+    return true;
+  }
+
+  // Unchecked
+  float elevation(uint32_t x, uint32_t y) const { return this->map.elevation[this->index(x, y)]; }
+  uint8_t cell(uint32_t x, uint32_t y) const { return this->map.cells[this->index(x, y)]; }
+
+  // The ground height under a position. False off the grid.
+  bool elevation_at(double px, double py, float & elevation) const;
+
+  // What the points around a position were, UNOBSERVED off the grid
+  uint8_t cell_at(double px, double py) const;
+
+  // How far a point is above the ground under it, negative below. False
+  // off the grid.
+  bool height_above_ground(double px, double py, double pz, float & height) const;
+
+private:
+  std::size_t index(uint32_t x, uint32_t y) const { return std::size_t(x) * this->map.size + y; }
+
+  const nova_msgs::msg::GroundMap & map;
+};
+
+}
+}
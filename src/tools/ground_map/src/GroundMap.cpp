@@ -0,0 +1,54 @@
+/*
+ * Package:   ground_map
+ * Filename:  GroundMap.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "ground_map/GroundMap.hpp"
+
+using nova_msgs::msg::GroundMap;
+
+navigator::ground_map::GroundMapView::GroundMapView(const GroundMap & map)
+  : map(map) {
+  const std::size_t cells = std::size_t(map.size) * map.size;
+  if(map.elevation.size() != cells) {
+    throw std::invalid_argument("Ground map has " + std::to_string(map.elevation.size()) + " elevations for " +
+				std::to_string(cells) + " cells");
+  }
+  if(map.cells.size() != cells) {
+    throw std::invalid_argument("Ground map has " + std::to_string(map.cells.size()) + " cell classes for " +
+				std::to_string(cells) + " cells");
+  }
+  if(!(map.resolution > 0.0f)) {
+    throw std::invalid_argument("Ground map resolution " + std::to_string(map.resolution) + " isn't positive");
+  }
+}
+
+bool navigator::ground_map::GroundMapView::elevation_at(double px, double py, float & elevation) const {
+  uint32_t x, y;
+  if(!this->cell_of(px, py, x, y)) return false;
+  elevation = this->elevation(x, y);
+  return true;
+}
+
+uint8_t navigator::ground_map::GroundMapView::cell_at(double px, double py) const {
+  uint32_t x, y;
+  if(!this->cell_of(px, py, x, y)) return GroundMap::UNOBSERVED;
+  return this->cell(x, y);
+}
+
+bool navigator::ground_map::GroundMapView::height_above_ground(double px, double py, double pz,
+							       float & height) const {
+  float elevation;
+  if(!this->elevation_at(px, py, elevation)) return false;
+  height = float(pz - elevation);
+  return true;
+}
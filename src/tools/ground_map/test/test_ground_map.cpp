@@ -0,0 +1,112 @@
+/*
+ * Package:   ground_map
+ * Filename:  test_ground_map.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "ground_map/GroundMap.hpp"
+
+using namespace navigator::ground_map;
+using nova_msgs::msg::GroundMap;
+
+namespace {
+
+// A size x size map at res meters per cell, centered on the origin as the
+// segmentation publishes it, with the ground rising 0.1 per cell along x
+// and an obstacle in cell (1, 2)
+GroundMap make_map(uint32_t size, float res) {
+  GroundMap map;
+  map.size = size;
+  map.resolution = res;
+  map.origin.position.x = -(size / 2 + 0.5) * res;
+  map.origin.position.y = map.origin.position.x;
+  for(uint32_t x = 0; x < size; x++) {
+    for(uint32_t y = 0; y < size; y++) {
+      map.elevation.push_back(0.1f * float(x));
+      map.cells.push_back(GroundMap::GROUND);
+    }
+  }
+  map.cells[1 * size + 2] = GroundMap::OBSTACLE;
+  map.cells[0] = GroundMap::UNOBSERVED;
+  return map;
+}
+
+}
+
+TEST(GroundMap, FindsCells) {
+  const GroundMap map = make_map(5, 0.5f);
+  const GroundMapView view(map);
+  EXPECT_EQ(view.size(), 5u);
+  EXPECT_EQ(view.resolution(), 0.5f);
+
+  uint32_t x = 9, y = 9;
+  // The middle cell is centered on the sensor
+  ASSERT_TRUE(view.cell_of(0.0, 0.0, x, y));
+  EXPECT_EQ(x, 2u);
+  EXPECT_EQ(y, 2u);
+  ASSERT_TRUE(view.cell_of(0.24, -0.26, x, y));
+  EXPECT_EQ(x, 2u);
+  EXPECT_EQ(y, 1u);
+  ASSERT_TRUE(view.cell_of(-1.25, 1.2, x, y));
+  EXPECT_EQ(x, 0u);
+  EXPECT_EQ(y, 4u);
+
+  EXPECT_FALSE(view.cell_of(1.25, 0.0, x, y));
+  EXPECT_FALSE(view.cell_of(0.0, -1.26, x, y));
+  EXPECT_FALSE(view.cell_of(std::numeric_limits<double>::quiet_NaN(), 0.0, x, y));
+  EXPECT_EQ(x, 0u);
+  EXPECT_EQ(y, 4u);
+}
+
+TEST(GroundMap, ReadsByPosition) {
+  const GroundMap map = make_map(5, 0.5f);
+  const GroundMapView view(map);
+
+  float elevation = 0.0f;
+  ASSERT_TRUE(view.elevation_at(0.6, 0.0, elevation));
+  EXPECT_FLOAT_EQ(elevation, 0.3f);
+  EXPECT_FALSE(view.elevation_at(0.0, 2.0, elevation));
+
+  EXPECT_EQ(view.cell_at(-0.5, 0.0), GroundMap::OBSTACLE);
+  EXPECT_EQ(view.cell_at(0.0, 0.0), GroundMap::GROUND);
+  EXPECT_EQ(view.cell_at(-1.0, -1.0), GroundMap::UNOBSERVED);
+  EXPECT_EQ(view.cell_at(5.0, 0.0), GroundMap::UNOBSERVED);
+
+  float height = 0.0f;
+  ASSERT_TRUE(view.height_above_ground(-1.0, 0.0, 1.0, height));
+  EXPECT_FLOAT_EQ(height, 1.0f);
+  ASSERT_TRUE(view.height_above_ground(1.0, 0.0, 0.0, height));
+  EXPECT_FLOAT_EQ(height, -0.4f);
+  EXPECT_FALSE(view.height_above_ground(0.0, 9.0, 0.0, height));
+}
+
+TEST(GroundMap, RejectsMismatchedMaps) {
+  GroundMap map = make_map(5, 0.5f);
+  map.elevation.pop_back();
+  EXPECT_THROW(GroundMapView view(map), std::invalid_argument);
+
+  map = make_map(5, 0.5f);
+  map.cells.push_back(GroundMap::GROUND);
+  EXPECT_THROW(GroundMapView view(map), std::invalid_argument);
+
+  map = make_map(5, 0.0f);
+  EXPECT_THROW(GroundMapView view(map), std::invalid_argument);
+
+  // Before the first scan the segmentation publishes nothing, but an
+  // empty map is still a valid one
+  GroundMap empty;
+  empty.resolution = 0.4f;
+  empty.size = 0;
+  const GroundMapView view(empty);
+  uint32_t x, y;
+  EXPECT_FALSE(view.cell_of(0.0, 0.0, x, y));
+}
@@ -0,0 +1,20 @@
+/*
+ * Package:   latency_tracker
+ * Filename:  latency_tracker_node.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <memory> // std::make_shared
+#include "rclcpp/rclcpp.hpp"
+#include "latency_tracker/LatencyTrackerNode.hpp"
+
+int main(int argc, char **argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<navigator::latency_tracker::LatencyTrackerNode>());
+  rclcpp::shutdown();
+  return 0;
+}
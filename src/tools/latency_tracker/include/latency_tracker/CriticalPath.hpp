@@ -0,0 +1,83 @@
+/*
+ * Package:   latency_tracker
+ * Filename:  CriticalPath.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Chains stage runs back to the sensor messages they started from,
+// without ROS, so that it can be tested on its own. A run's output is
+// known by its topic and stamp; an input is looked up the same way,
+// and one that no recorded run produced is taken to come straight
+// from a sensor. Times are in ns, on the clock of the stamps.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace navigator {
+namespace latency_tracker {
+
+struct StageRun {
+  std::string stage;
+  std::vector<std::pair<std::string, int64_t>> inputs; // Topic and stamp
+  std::string output_topic;
+  int64_t output_stamp = 0;
+  int64_t published = 0;
+  int64_t processing = 0;
+};
+
+// One run on a critical path. The wait is the time from the previous
+// hop's output, or from the sensor stamp on the first hop, to the
+// start of the run: transport, queueing and scheduling together.
+struct Hop {
+  std::string stage;
+  std::string output_topic;
+  int64_t wait = 0;
+  int64_t processing = 0;
+};
+
+// The chain of runs behind one output, through the input with the
+// oldest sensor stamp at every run
+struct CriticalPath {
+  std::string origin_topic;
+  int64_t origin_stamp = 0;
+  int64_t published = 0; // By the last hop
+  std::vector<Hop> hops;
+
+  int64_t latency() const {
+    return this->published - this->origin_stamp;
+  }
+};
+
+class PathTracker {
+public:
+  // Remembers the paths of the last capacity outputs
+  explicit PathTracker(std::size_t capacity);
+
+  // The critical path of the run's output. An output published twice
+  // with the same stamp keeps its first path.
+  CriticalPath add(const StageRun & run);
+
+  std::size_t size() const {
+    return this->paths.size();
+  }
+
+private:
+  typedef std::pair<std::string, int64_t> Key;
+
+  std::size_t capacity;
+  std::map<Key, CriticalPath> paths;
+  std::deque<Key> order; // Oldest first, for eviction
+};
+
+}
+}
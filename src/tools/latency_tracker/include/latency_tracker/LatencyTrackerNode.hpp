@@ -0,0 +1,68 @@
+/*
+ * Package:   latency_tracker
+ * Filename:  LatencyTrackerNode.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Reconstructs the critical path of every output from the stage runs
+// on /latency/stages, and reports on /diagnostics how old each output
+// is relative to the sensor message it started from. There is one
+// report per pair of sensor topic and output topic, e.g. from
+// /lidar/filtered to /grid/occupancy/current, with the quantiles of
+// the latency and the mean wait and processing time of every stage on
+// the way. Each report covers the period since the previous one.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "nova_msgs/msg/stage_latency.hpp"
+
+#include "latency_tracker/CriticalPath.hpp"
+#include "nova_trace/LatencyHistogram.hpp"
+
+namespace navigator {
+namespace latency_tracker {
+
+class LatencyTrackerNode : public rclcpp::Node {
+public:
+  explicit LatencyTrackerNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+private:
+  struct StageTotals {
+    int64_t wait_ns = 0;
+    int64_t processing_ns = 0;
+    uint64_t count = 0;
+  };
+
+  // Outputs of one topic that started from one sensor topic
+  struct Summary {
+    trace::LatencyHistogram latency;
+    double lifetime_max_ms = 0;
+    std::vector<std::string> stages; // Along the latest path
+    std::map<std::string, StageTotals> totals;
+  };
+
+  void stage_cb(const nova_msgs::msg::StageLatency::SharedPtr msg);
+  void report();
+
+  PathTracker paths;
+  std::map<std::string, Summary> summaries;
+  double warn_latency_ms;
+
+  rclcpp::Subscription<nova_msgs::msg::StageLatency>::SharedPtr stage_subscription;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_publisher;
+  rclcpp::TimerBase::SharedPtr report_timer;
+};
+
+}
+}
@@ -0,0 +1,72 @@
+/*
+ * Package:   latency_tracker
+ * Filename:  StageRecorder.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Reports the runs of one stage of a node to the latency tracker, on
+// /latency/stages. A run lists the stamps of the messages it used and
+// the stamp of the message it published:
+//
+//   auto run = this->recorder->start();
+//   run.input(this->cloud_subscription->get_topic_name(), msg->header.stamp);
+//   ...
+//   this->grid_publisher->publish(grid);
+//   run.finish(grid.header.stamp);
+//
+// A run that is dropped without finish() reports nothing. Outputs
+// should keep the stamp of their newest input where they have only
+// one; the tracker follows restamped outputs too, as long as both
+// stamps are recorded. Reports are best effort and can be turned off
+// with the node's "latency_records" parameter.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+#include "builtin_interfaces/msg/time.hpp"
+
+#include "nova_msgs/msg/stage_latency.hpp"
+
+namespace navigator {
+namespace latency_tracker {
+
+class StageRecorder {
+public:
+  class Run {
+  public:
+    void input(const std::string & topic, const builtin_interfaces::msg::Time & stamp);
+
+    // Report the run, once its output has been published
+    void finish(const builtin_interfaces::msg::Time & output_stamp);
+
+  private:
+    friend class StageRecorder;
+    explicit Run(StageRecorder * recorder);
+
+    StageRecorder * recorder; // Null when not recording
+    std::chrono::steady_clock::time_point start;
+    nova_msgs::msg::StageLatency record;
+  };
+
+  // output_topic should be the fully qualified name, as from the
+  // publisher's get_topic_name()
+  StageRecorder(rclcpp::Node & node, const std::string & stage, const std::string & output_topic);
+
+  Run start();
+
+private:
+  std::string stage;
+  std::string output_topic;
+  bool enabled;
+  rclcpp::Clock::SharedPtr clock;
+  rclcpp::Publisher<nova_msgs::msg::StageLatency>::SharedPtr publisher;
+};
+
+}
+}
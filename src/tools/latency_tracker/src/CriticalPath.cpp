@@ -0,0 +1,64 @@
+/*
+ * Package:   latency_tracker
+ * Filename:  CriticalPath.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm> // std::max
+#include <utility>
+
+#include "latency_tracker/CriticalPath.hpp"
+
+using navigator::latency_tracker::CriticalPath;
+using navigator::latency_tracker::Hop;
+using navigator::latency_tracker::PathTracker;
+using navigator::latency_tracker::StageRun;
+
+PathTracker::PathTracker(std::size_t capacity)
+  : capacity(std::max<std::size_t>(capacity, 1)) {}
+
+CriticalPath PathTracker::add(const StageRun & run) {
+  // The input that started oldest is the one whose latency the output
+  // inherits
+  const CriticalPath * upstream = nullptr;
+  CriticalPath origin; // For when that input comes from a sensor
+  origin.origin_topic = run.output_topic;
+  origin.origin_stamp = origin.published = run.output_stamp;
+  bool have_input = false;
+  int64_t oldest = 0;
+  for(const auto & input : run.inputs) {
+    auto known = this->paths.find(input);
+    int64_t stamp = known != this->paths.end() ? known->second.origin_stamp : input.second;
+    if(have_input && stamp >= oldest) continue;
+    have_input = true;
+    oldest = stamp;
+    upstream = known != this->paths.end() ? & known->second : nullptr;
+    if(! upstream) {
+      origin.origin_topic = input.first;
+      origin.origin_stamp = origin.published = input.second;
+    }
+  }
+
+  // Without inputs, the output is its own origin
+  CriticalPath path = upstream ? *upstream : origin;
+  Hop hop;
+  hop.stage = run.stage;
+  hop.output_topic = run.output_topic;
+  hop.processing = run.processing;
+  hop.wait = run.published - run.processing - path.published;
+  path.hops.push_back(std::move(hop));
+  path.published = run.published;
+
+  Key key(run.output_topic, run.output_stamp);
+  if(this->paths.emplace(key, path).second) {
+    this->order.push_back(key);
+    if(this->order.size() > this->capacity) {
+      this->paths.erase(this->order.front());
+      this->order.pop_front();
+    }
+  }
+  return path;
+}
@@ -0,0 +1,138 @@
+/*
+ * Package:   latency_tracker
+ * Filename:  LatencyTrackerNode.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm> // std::max, std::min
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "diagnostic_msgs/msg/diagnostic_status.hpp"
+#include "diagnostic_msgs/msg/key_value.hpp"
+#include "nova_msgs/msg/stage_latency.hpp"
+
+#include "latency_tracker/LatencyTrackerNode.hpp"
+
+using navigator::latency_tracker::LatencyTrackerNode;
+using diagnostic_msgs::msg::DiagnosticStatus;
+using diagnostic_msgs::msg::KeyValue;
+
+namespace {
+
+int64_t to_ns(const builtin_interfaces::msg::Time & time) {
+  return int64_t(time.sec) * 1000000000 + time.nanosec;
+}
+
+KeyValue key_value(const std::string & key, double value) {
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(3) << value;
+  KeyValue pair;
+  pair.key = key;
+  pair.value = text.str();
+  return pair;
+}
+
+}
+
+LatencyTrackerNode::LatencyTrackerNode(const rclcpp::NodeOptions & options)
+  : Node("latency_tracker", options),
+    paths(std::max<int64_t>(this->declare_parameter<int64_t>("path_table_size", 4096), 1)) {
+  double report_period_seconds = this->declare_parameter<double>("report_period_seconds", 1.0);
+  if(report_period_seconds <= 0) {
+    throw std::invalid_argument("report_period_seconds must be positive");
+  }
+  // Outputs older than this are reported as warnings. 0 turns it off.
+  this->warn_latency_ms = this->declare_parameter<double>("warn_latency_ms", 0.0);
+
+  this->stage_subscription = this->create_subscription<nova_msgs::msg::StageLatency>
+    ("/latency/stages", rclcpp::QoS(100).best_effort(),
+     std::bind(& LatencyTrackerNode::stage_cb, this, std::placeholders::_1));
+  this->diagnostics_publisher = this->create_publisher<diagnostic_msgs::msg::DiagnosticArray>
+    ("/diagnostics", 10);
+  this->report_timer = this->create_wall_timer
+    (std::chrono::duration_cast<std::chrono::nanoseconds>
+     (std::chrono::duration<double>(report_period_seconds)),
+     std::bind(& LatencyTrackerNode::report, this));
+}
+
+void LatencyTrackerNode::stage_cb(const nova_msgs::msg::StageLatency::SharedPtr msg) {
+  StageRun run;
+  run.stage = msg->stage;
+  std::size_t inputs = std::min(msg->input_topics.size(), msg->input_stamps.size());
+  for(std::size_t i = 0; i < inputs; i++) {
+    run.inputs.emplace_back(msg->input_topics[i], to_ns(msg->input_stamps[i]));
+  }
+  run.output_topic = msg->output_topic;
+  run.output_stamp = to_ns(msg->output_stamp);
+  run.published = to_ns(msg->published);
+  run.processing = rclcpp::Duration(msg->processing_time).nanoseconds();
+  CriticalPath path = this->paths.add(run);
+
+  Summary & summary = this->summaries[path.origin_topic + " -> " + run.output_topic];
+  summary.latency.record(std::chrono::nanoseconds(path.latency()));
+  summary.lifetime_max_ms = std::max(summary.lifetime_max_ms, path.latency() * 1e-6);
+  summary.stages.clear();
+  for(const Hop & hop : path.hops) {
+    summary.stages.push_back(hop.stage);
+    StageTotals & totals = summary.totals[hop.stage];
+    totals.wait_ns += hop.wait;
+    totals.processing_ns += hop.processing;
+    totals.count++;
+  }
+}
+
+void LatencyTrackerNode::report() {
+  diagnostic_msgs::msg::DiagnosticArray message;
+  message.header.stamp = this->now();
+  for(auto & entry : this->summaries) {
+    Summary & summary = entry.second;
+    if(summary.latency.count() == 0) continue;
+    const trace::LatencyHistogram::Snapshot latency = summary.latency.snapshot();
+
+    DiagnosticStatus status;
+    status.name = std::string(this->get_name()) + ": " + entry.first;
+    status.hardware_id = "latency";
+    const double worst = latency.max_ms();
+    if(this->warn_latency_ms > 0 && worst > this->warn_latency_ms) {
+      std::ostringstream text;
+      text << "Latency over " << this->warn_latency_ms << " ms";
+      status.level = DiagnosticStatus::WARN;
+      status.message = text.str();
+    } else {
+      status.level = DiagnosticStatus::OK;
+      status.message = "OK";
+    }
+    status.values.push_back(key_value("frames", double(latency.count)));
+    status.values.push_back(key_value("mean_ms", latency.mean_ms()));
+    status.values.push_back(key_value("p50_ms", latency.quantile_ms(0.5)));
+    status.values.push_back(key_value("p99_ms", latency.quantile_ms(0.99)));
+    status.values.push_back(key_value("max_ms", worst));
+    status.values.push_back(key_value("lifetime_max_ms", summary.lifetime_max_ms));
+    // The stages of the latest path, in order
+    for(const std::string & stage : summary.stages) {
+      const StageTotals & totals = summary.totals[stage];
+      if(totals.count == 0) continue;
+      status.values.push_back(key_value(stage + " wait_ms", totals.wait_ns * 1e-6 / totals.count));
+      status.values.push_back(key_value(stage + " processing_ms", totals.processing_ns * 1e-6 / totals.count));
+    }
+    message.status.push_back(status);
+
+    summary.latency.reset();
+    summary.totals.clear();
+  }
+  if(! message.status.empty()) this->diagnostics_publisher->publish(message);
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(navigator::latency_tracker::LatencyTrackerNode)
@@ -0,0 +1,61 @@
+/*
+ * Package:   latency_tracker
+ * Filename:  StageRecorder.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <chrono>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "nova_msgs/msg/stage_latency.hpp"
+
+#include "latency_tracker/StageRecorder.hpp"
+
+using navigator::latency_tracker::StageRecorder;
+
+StageRecorder::StageRecorder(rclcpp::Node & node, const std::string & stage,
+			     const std::string & output_topic)
+  : stage(stage), output_topic(output_topic), clock(node.get_clock()) {
+  // Nodes with several stages share the parameter
+  if(! node.has_parameter("latency_records")) {
+    node.declare_parameter<bool>("latency_records", true);
+  }
+  this->enabled = node.get_parameter("latency_records").as_bool();
+  if(this->enabled) {
+    // Best effort, so that a slow tracker never holds up a stage
+    this->publisher = node.create_publisher<nova_msgs::msg::StageLatency>
+      ("/latency/stages", rclcpp::QoS(100).best_effort());
+  }
+}
+
+StageRecorder::Run StageRecorder::start() {
+  return Run(this->enabled ? this : nullptr);
+}
+
+StageRecorder::Run::Run(StageRecorder * recorder)
+  : recorder(recorder) {
+  if(! recorder) return;
+  this->start = std::chrono::steady_clock::now();
+  this->record.stage = recorder->stage;
+  this->record.output_topic = recorder->output_topic;
+}
+
+void StageRecorder::Run::input(const std::string & topic, const builtin_interfaces::msg::Time & stamp) {
+  if(! this->recorder) return;
+  this->record.input_topics.push_back(topic);
+  this->record.input_stamps.push_back(stamp);
+}
+
+void StageRecorder::Run::finish(const builtin_interfaces::msg::Time & output_stamp) {
+  if(! this->recorder) return;
+  this->record.output_stamp = output_stamp;
+  this->record.published = this->recorder->clock->now();
+  this->record.processing_time = rclcpp::Duration(std::chrono::steady_clock::now() - this->start);
+  this->recorder->publisher->publish(this->record);
+  this->recorder = nullptr;
+}
@@ -0,0 +1,97 @@
+/*
+ * Package:   latency_tracker
+ * Filename:  test_critical_path.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "latency_tracker/CriticalPath.hpp"
+
+using namespace navigator::latency_tracker;
+
+namespace {
+
+constexpr int64_t MS = 1000000;
+
+StageRun run(const std::string & stage, std::vector<std::pair<std::string, int64_t>> inputs,
+	     const std::string & output_topic, int64_t output_stamp, int64_t published, int64_t processing) {
+  StageRun run;
+  run.stage = stage;
+  run.inputs = std::move(inputs);
+  run.output_topic = output_topic;
+  run.output_stamp = output_stamp;
+  run.published = published;
+  run.processing = processing;
+  return run;
+}
+
+}
+
+TEST(PathTracker, FollowsRestampedOutputs) {
+  PathTracker tracker(16);
+  // The lidar stamp is kept by the ground segmentation, and replaced by
+  // the occupancy grid's own
+  tracker.add(run("ground", {{"/lidar", 100 * MS}}, "/ground", 100 * MS, 130 * MS, 20 * MS));
+  CriticalPath path = tracker.add(run("occupancy", {{"/ground", 100 * MS}}, "/grid", 140 * MS, 190 * MS, 40 * MS));
+
+  EXPECT_EQ(path.origin_topic, "/lidar");
+  EXPECT_EQ(path.origin_stamp, 100 * MS);
+  EXPECT_EQ(path.latency(), 90 * MS);
+  ASSERT_EQ(path.hops.size(), 2u);
+  EXPECT_EQ(path.hops[0].stage, "ground");
+  EXPECT_EQ(path.hops[0].wait, 10 * MS);
+  EXPECT_EQ(path.hops[1].stage, "occupancy");
+  EXPECT_EQ(path.hops[1].wait, 20 * MS);
+  EXPECT_EQ(path.hops[1].processing, 40 * MS);
+
+  // A planner run on that grid inherits the whole chain
+  path = tracker.add(run("planner", {{"/grid", 140 * MS}}, "/path", 140 * MS, 250 * MS, 30 * MS));
+  EXPECT_EQ(path.origin_topic, "/lidar");
+  EXPECT_EQ(path.latency(), 150 * MS);
+  EXPECT_EQ(path.hops.size(), 3u);
+}
+
+TEST(PathTracker, TheOldestInputIsCritical) {
+  PathTracker tracker(16);
+  tracker.add(run("grid", {{"/lidar", 100 * MS}}, "/grid", 100 * MS, 150 * MS, 10 * MS));
+  // The pose is newer than the lidar behind the grid, so the grid's
+  // chain is the critical one
+  CriticalPath path = tracker.add(run("planner", {{"/pose", 140 * MS}, {"/grid", 100 * MS}},
+				      "/path", 140 * MS, 200 * MS, 10 * MS));
+  EXPECT_EQ(path.origin_topic, "/lidar");
+  EXPECT_EQ(path.hops.size(), 2u);
+
+  // And here an old pose is
+  path = tracker.add(run("planner", {{"/grid", 100 * MS}, {"/pose", 50 * MS}},
+			 "/path", 150 * MS, 200 * MS, 10 * MS));
+  EXPECT_EQ(path.origin_topic, "/pose");
+  EXPECT_EQ(path.latency(), 150 * MS);
+  EXPECT_EQ(path.hops.size(), 1u);
+}
+
+TEST(PathTracker, RunsWithoutInputsStartAtTheirOutput) {
+  PathTracker tracker(16);
+  CriticalPath path = tracker.add(run("timer", {}, "/route", 100 * MS, 120 * MS, 5 * MS));
+  EXPECT_EQ(path.origin_topic, "/route");
+  EXPECT_EQ(path.latency(), 20 * MS);
+}
+
+TEST(PathTracker, ForgetsTheOldestOutputs) {
+  PathTracker tracker(2);
+  tracker.add(run("a", {{"/in", 1}}, "/out", 1, 10, 1));
+  tracker.add(run("a", {{"/in", 2}}, "/out", 2, 10, 1));
+  tracker.add(run("a", {{"/in", 3}}, "/out", 3, 10, 1));
+  EXPECT_EQ(tracker.size(), 2u);
+  // The first output is gone, so its consumer looks like a sensor's
+  CriticalPath path = tracker.add(run("b", {{"/out", 1}}, "/next", 1, 20, 1));
+  EXPECT_EQ(path.origin_topic, "/out");
+  path = tracker.add(run("b", {{"/out", 3}}, "/next", 3, 20, 1));
+  EXPECT_EQ(path.origin_topic, "/in");
+}
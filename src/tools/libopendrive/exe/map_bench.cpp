@@ -0,0 +1,309 @@
+/*
+ * Package:   libopendrive
+ * Filename:  map_bench.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Loading a map and its main queries, each timed once with the memory it
+// kept and the process's peak so far, then route, reference line match,
+// lane match and road surface queries over random inputs.
+// Usage: map_bench <map.xodr> [queries] [seed]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "LaneMatcher.h"
+#include "OpenDriveMap.h"
+#include "RoadSurfaceBVH.h"
+#include "RoutingGraph.h"
+
+namespace
+{
+    // Resident set size now, in MB, from /proc/self/statm.
+    double residentMb()
+    {
+        std::FILE *statm = std::fopen("/proc/self/statm", "r");
+        if (!statm)
+            return 0.0;
+        long pages_total = 0, pages_resident = 0;
+        const int read = std::fscanf(statm, "%ld %ld", &pages_total, &pages_resident);
+        std::fclose(statm);
+        return read == 2 ? pages_resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1 << 20) : 0.0;
+    }
+
+    // Peak resident set size of the process so far, in MB.
+    double peakMb()
+    {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024.0; // KB on Linux
+    }
+
+    // Runs stage once and prints its wall time, how much resident memory it
+    // left behind, and the peak so far.
+    void timeStage(const char *name, const std::function<void()> &stage)
+    {
+        const double rss_before = residentMb();
+        const auto start = std::chrono::steady_clock::now();
+        stage();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-22s %9.1f ms  rss %+8.1f MB  peak %8.1f MB\n", name, ms, residentMb() - rss_before, peakMb());
+    }
+
+    struct Timings
+    {
+        std::vector<double> us;
+
+        void print(const char *name)
+        {
+            if (us.empty())
+                return;
+            std::sort(us.begin(), us.end());
+            double sum = 0.0;
+            for (double t : us)
+                sum += t;
+            std::printf("%-22s mean %8.1f us  p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", name, sum / us.size(),
+                        us[us.size() / 2], us[us.size() * 99 / 100], us.back());
+        }
+    };
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::printf("Usage: %s <map.xodr> [queries] [seed]\n", argv[0]);
+        return 1;
+    }
+    const int queries = argc > 2 ? std::atoi(argv[2]) : 1000;
+    const unsigned int seed = argc > 3 ? std::atoi(argv[3]) : 1;
+
+    // The XML alone, then the whole map, which parses it again, so the
+    // difference is what building the roads costs
+    timeStage("xml parse", [&]()
+              {
+        pugi::xml_document doc;
+        if (!doc.load_file(argv[1]))
+            std::printf("could not parse %s\n", argv[1]); });
+
+    std::unique_ptr<odr::OpenDriveMap> map;
+    timeStage("map construction", [&]()
+              { map = std::make_unique<odr::OpenDriveMap>(argv[1], false); });
+    std::printf("%zu roads, %zu lane sections\n", map->road_count(), map->lanesection_count());
+
+    // Again without keeping the DOM, for what that saves
+    {
+        odr::OpenDriveMapConfig config;
+        config.keep_xml = false;
+        std::unique_ptr<odr::OpenDriveMap> lean_map;
+        timeStage("map without xml", [&]()
+                  { lean_map = std::make_unique<odr::OpenDriveMap>(argv[1], false, config); });
+    }
+
+    std::size_t polygon_count = 0;
+    timeStage("get_lane_polygons", [&]()
+              { polygon_count = map->get_lane_polygons(1.0, false).size(); });
+
+    std::size_t vertex_count = 0;
+    timeStage("get_road_network_mesh", [&]()
+              { vertex_count = map->get_road_network_mesh(0.1).lanes_mesh.vertices.size(); });
+    std::printf("%zu lane polygons, %zu mesh vertices\n", polygon_count, vertex_count);
+
+    odr::RoutingGraph graph;
+    timeStage("get_routing_graph", [&]()
+              { graph = map->get_routing_graph(); });
+
+    std::vector<odr::LaneKey> lanes;
+    for (const auto &lane_successors : graph.lane_key_to_successors)
+        lanes.push_back(lane_successors.first);
+    std::sort(lanes.begin(), lanes.end(), std::less<odr::LaneKey>{}); // Seeded runs pick the same pairs
+    if (lanes.empty())
+    {
+        std::printf("no lanes to route between\n");
+        return 1;
+    }
+
+    std::mt19937 gen(seed);
+
+    // The first query builds the index. Time it on its own.
+    timeStage("routing index", [&]()
+              { graph.shortest_path(lanes[0], lanes[0]); });
+
+    std::uniform_int_distribution<std::size_t> pick_lane(0, lanes.size() - 1);
+    Timings routes;
+    int reachable = 0;
+    for (int q = 0; q < queries; q++)
+    {
+        const odr::LaneKey &from = lanes[pick_lane(gen)];
+        const odr::LaneKey &to = lanes[pick_lane(gen)];
+        const auto start = std::chrono::steady_clock::now();
+        reachable += !graph.shortest_path(from, to).empty();
+        routes.us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::printf("%d of %d routes found\n", reachable, queries);
+    routes.print("shortest_path");
+
+    // Points up to a lane or so either side of a random spot on a random
+    // road, matched back to that road's reference line
+    std::uniform_int_distribution<std::size_t> pick_road(0, map->road_count() - 1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0), offset(-4.0, 4.0);
+    Timings matches;
+    double worst_error = 0.0;
+    for (int q = 0; q < queries; q++)
+    {
+        const odr::RefLine &ref_line = map->road(pick_road(gen)).ref_line;
+        const double s = unit(gen) * ref_line.length;
+        const odr::Vec3D pt = ref_line.get_xyz(s);
+        const odr::Vec3D grad = ref_line.get_grad(s);
+        const double grad_len = std::hypot(grad[0], grad[1]);
+        const double t = offset(gen);
+        const double x = pt[0] - (grad_len > 0 ? t * grad[1] / grad_len : 0.0);
+        const double y = pt[1] + (grad_len > 0 ? t * grad[0] / grad_len : 0.0);
+
+        const auto start = std::chrono::steady_clock::now();
+        const double s_match = ref_line.match(x, y);
+        matches.us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        // Curves tighter than t can have a nearer point elsewhere, so this
+        // only flags gross misses
+        const odr::Vec3D pt_match = ref_line.get_xyz(s_match);
+        worst_error = std::max(worst_error, std::hypot(pt_match[0] - x, pt_match[1] - y) - std::abs(t));
+    }
+    std::printf("match lands at most %.3f m further than the sampled point\n", worst_error);
+    matches.print("RefLine::match");
+
+    std::unique_ptr<odr::LaneMatcher> matcher;
+    timeStage("LaneMatcher", [&]()
+              { matcher = std::make_unique<odr::LaneMatcher>(*map); });
+    std::printf("%zu lanes in %zu pieces over %zu cells\n", matcher->lane_count(), matcher->size(), matcher->cell_count());
+
+    // Poses in the middle of a random lane of the routing graph, heading
+    // along it, matched back to that lane
+    Timings lane_matches;
+    int lane_hits = 0;
+    double worst_s_error = 0.0;
+    for (int q = 0; q < queries; q++)
+    {
+        const odr::LaneKey &key = lanes[pick_lane(gen)];
+        const odr::Road &road = map->road(key.road_index);
+        const odr::Lane &lane = map->lane(key);
+        const double s_start = key.lanesection_s0;
+        const double s = s_start + (0.1 + 0.8 * unit(gen)) * (road.get_lanesection_end(s_start) - s_start);
+        const double t = 0.5 * (lane.inner_border.get(s) + lane.outer_border.get(s));
+        const odr::Vec3D pt = road.get_xyz(s, t, 0.0);
+        const odr::Vec3D grad = road.ref_line.get_grad(s);
+        const double heading = std::atan2(grad[1], grad[0]) + (key.lane_id > 0 ? M_PI : 0.0);
+
+        const auto start = std::chrono::steady_clock::now();
+        const odr::LaneMatch lane_match = matcher->match(pt[0], pt[1], heading);
+        lane_matches.us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        if (lane_match.matched && lane_match.key.road_index == key.road_index && lane_match.key.lanesection_index == key.lanesection_index &&
+            lane_match.key.lane_id == key.lane_id)
+        {
+            lane_hits++;
+            worst_s_error = std::max(worst_s_error, std::abs(lane_match.s - s));
+        }
+    }
+    // Overlapping lanes in junctions can take a pose from its own lane
+    std::printf("%d of %d poses matched to their lane, s off by at most %.4f m\n", lane_hits, queries, worst_s_error);
+    lane_matches.print("LaneMatcher::match");
+
+    // A particle filter's cloud: poses scattered around a point of a lane,
+    // matched in one batch. Timed per particle.
+    std::normal_distribution<double> scatter(0.0, 1.0);
+    std::vector<odr::LanePose> particles(2000);
+    std::vector<odr::LaneMatch> particle_matches(particles.size());
+    Timings batches;
+    for (int q = 0; q < std::max(1, queries / 100); q++)
+    {
+        const odr::LaneKey &key = lanes[pick_lane(gen)];
+        const odr::Road &road = map->road(key.road_index);
+        const odr::Vec3D pt = road.ref_line.get_xyz(key.lanesection_s0);
+        for (odr::LanePose &particle : particles)
+            particle = {pt[0] + scatter(gen), pt[1] + scatter(gen), 0.2 * scatter(gen)};
+        const auto start = std::chrono::steady_clock::now();
+        matcher->match(particles.data(), particles.size(), particle_matches.data());
+        batches.us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / particles.size());
+    }
+    batches.print("LaneMatcher batch");
+
+    std::unique_ptr<odr::RoadSurfaceBVH> surface;
+    timeStage("RoadSurfaceBVH", [&]()
+              { surface = std::make_unique<odr::RoadSurfaceBVH>(*map); });
+    std::printf("%zu surface triangles in %zu nodes\n", surface->size(), surface->node_count());
+
+    // Points in the middle of a random lane, their height looked up and a
+    // ray cast down at them from 2 m above, against get_surface_pt()
+    Timings heights, rays;
+    int height_hits = 0, ray_hits = 0;
+    double worst_height_error = 0.0, worst_ray_error = 0.0;
+    for (int q = 0; q < queries; q++)
+    {
+        const odr::LaneKey &key = lanes[pick_lane(gen)];
+        const odr::Road &road = map->road(key.road_index);
+        const odr::Lane &lane = map->lane(key);
+        const double s_start = key.lanesection_s0;
+        const double s = s_start + (0.1 + 0.8 * unit(gen)) * (road.get_lanesection_end(s_start) - s_start);
+        const double t = 0.5 * (lane.inner_border.get(s) + lane.outer_border.get(s));
+        const odr::Vec3D pt = road.get_surface_pt(s, t);
+
+        auto start = std::chrono::steady_clock::now();
+        const odr::SurfaceHit height = surface->height_at(pt[0], pt[1], pt[2]);
+        heights.us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        if (height.hit)
+        {
+            height_hits++;
+            worst_height_error = std::max(worst_height_error, std::abs(height.point[2] - pt[2]));
+        }
+
+        start = std::chrono::steady_clock::now();
+        const odr::SurfaceHit ray = surface->intersect({{pt[0], pt[1], pt[2] + 2.0}, {0, 0, -1}, 10.0});
+        rays.us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        if (ray.hit)
+        {
+            ray_hits++;
+            worst_ray_error = std::max(worst_ray_error, std::abs(ray.point[2] - pt[2]));
+        }
+    }
+    // An overpass less than 2 m up would take the ray
+    std::printf("%d of %d heights found, off by at most %.4f m; %d of %d rays hit, off by at most %.4f m\n", height_hits, queries,
+                worst_height_error, ray_hits, queries, worst_ray_error);
+    heights.print("height_at");
+    rays.print("intersect");
+
+    // A lidar sweep: rays from 2 m up fanned out and down around a point
+    // of a lane, cast in one batch. Timed per ray.
+    std::vector<odr::SurfaceRay> sweep(2000);
+    std::vector<odr::SurfaceHit> sweep_hits(sweep.size());
+    Timings sweeps;
+    for (int q = 0; q < std::max(1, queries / 100); q++)
+    {
+        const odr::LaneKey &key = lanes[pick_lane(gen)];
+        const odr::Vec3D pt = map->road(key.road_index).ref_line.get_xyz(key.lanesection_s0);
+        for (std::size_t i = 0; i < sweep.size(); i++)
+        {
+            const double azimuth = 2 * M_PI * i / sweep.size();
+            const double elevation = -0.05 - 0.3 * unit(gen);
+            sweep[i] = {{pt[0], pt[1], pt[2] + 2.0},
+                        {std::cos(azimuth) * std::cos(elevation), std::sin(azimuth) * std::cos(elevation), std::sin(elevation)},
+                        100.0};
+        }
+        const auto start = std::chrono::steady_clock::now();
+        surface->intersect(sweep.data(), sweep.size(), sweep_hits.data());
+        sweeps.us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / sweep.size());
+    }
+    sweeps.print("intersect batch");
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Package:   libopendrive
+ * Filename:  routing_bench.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Random route queries through RoutingGraph, by Dijkstra and by A*.
+// Usage: routing_bench <map.xodr> [queries] [seed]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "OpenDriveMap.h"
+#include "RoutingGraph.h"
+
+namespace
+{
+    // Weight of a path by the graph's edges, or -1 if it has none.
+    double pathWeight(const odr::RoutingGraph &graph, const std::vector<odr::LaneKey> &path)
+    {
+        if (path.empty())
+            return -1.0;
+        double weight = 0.0;
+        for (std::size_t i = 1; i < path.size(); i++)
+        {
+            double best = INFINITY;
+            for (const odr::WeightedLaneKey &successor : graph.lane_key_to_successors.at(path[i - 1]))
+            {
+                if (std::equal_to<odr::LaneKey>{}(successor, path[i]))
+                    best = std::min(best, successor.weight);
+            }
+            weight += best;
+        }
+        return weight;
+    }
+
+    struct Timings
+    {
+        std::vector<double> us;
+
+        void print(const char *name)
+        {
+            std::sort(us.begin(), us.end());
+            double sum = 0.0;
+            for (double t : us)
+                sum += t;
+            std::printf("%-9s mean %8.1f us  p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", name, sum / us.size(),
+                        us[us.size() / 2], us[us.size() * 99 / 100], us.back());
+        }
+    };
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::printf("Usage: %s <map.xodr> [queries] [seed]\n", argv[0]);
+        return 1;
+    }
+    const int queries = argc > 2 ? std::atoi(argv[2]) : 1000;
+    const unsigned int seed = argc > 3 ? std::atoi(argv[3]) : 1;
+
+    odr::OpenDriveMap map(argv[1], false);
+    const odr::RoutingGraph graph = map.get_routing_graph();
+
+    std::vector<odr::LaneKey> lanes;
+    for (const auto &lane_successors : graph.lane_key_to_successors)
+        lanes.push_back(lane_successors.first);
+    std::sort(lanes.begin(), lanes.end(), std::less<odr::LaneKey>{}); // Seeded runs pick the same pairs
+    std::printf("%zu lanes with successors, %zu edges, %d queries\n", lanes.size(), graph.edges.size(), queries);
+
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<std::size_t> pick(0, lanes.size() - 1);
+
+    // The first query builds the index. Time it on its own.
+    auto build_start = std::chrono::steady_clock::now();
+    graph.shortest_path(lanes[0], lanes[0]);
+    std::printf("index build %.1f ms\n", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count());
+
+    Timings dijkstra, astar;
+    int reachable = 0, mismatches = 0;
+    for (int q = 0; q < queries; q++)
+    {
+        const odr::LaneKey &from = lanes[pick(gen)];
+        const odr::LaneKey &to = lanes[pick(gen)];
+
+        auto start = std::chrono::steady_clock::now();
+        const std::vector<odr::LaneKey> path = graph.shortest_path(from, to);
+        auto mid = std::chrono::steady_clock::now();
+        const std::vector<odr::LaneKey> guided = graph.shortest_path_astar(from, to);
+        auto end = std::chrono::steady_clock::now();
+        dijkstra.us.push_back(std::chrono::duration<double, std::micro>(mid - start).count());
+        astar.us.push_back(std::chrono::duration<double, std::micro>(end - mid).count());
+
+        const double weight = pathWeight(graph, path);
+        const double guided_weight = pathWeight(graph, guided);
+        reachable += !path.empty();
+        if (std::abs(weight - guided_weight) > 1e-6 * std::max(1.0, weight))
+            mismatches++;
+    }
+
+    std::printf("%d of %d routes found, %d A* weights differ from Dijkstra\n", reachable, queries, mismatches);
+    dijkstra.print("dijkstra");
+    astar.print("astar");
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+/*
+ * Package:   libopendrive
+ * Filename:  spiral_bench.cpp
+ * Author:    Will Heitman
+ * Email:     w at heit dot mn
+ * Copyright: 2023, Nova UTD
+ * License:   MIT License
+ */
+
+// Spiral::get_xy() and get_grad() from the node table, against odrSpiral()
+// directly, over random ramp-like spirals.
+// Usage: spiral_bench [spirals] [samples per spiral] [seed]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Geometries/Spiral.h"
+
+int main(int argc, char **argv)
+{
+    const int spiral_count = argc > 1 ? std::atoi(argv[1]) : 200;
+    const int samples = argc > 2 ? std::atoi(argv[2]) : 5000;
+    const unsigned int seed = argc > 3 ? std::atoi(argv[3]) : 1;
+
+    // Entries and exits of ramps and curves: curvature from or to 1 / R,
+    // with R from 8 m to 500 m, over 10 m to 150 m.
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> radius(8.0, 500.0), length(10.0, 150.0), unit(0.0, 1.0);
+    std::vector<odr::Spiral> spirals;
+    spirals.reserve(spiral_count);
+    auto build_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < spiral_count; i++)
+    {
+        const double curv = (unit(gen) < 0.5 ? -1.0 : 1.0) / radius(gen);
+        const bool entry = unit(gen) < 0.5;
+        const double other = unit(gen) < 0.3 ? curv * unit(gen) : 0.0;
+        spirals.emplace_back(0.0, 1000 * unit(gen), 1000 * unit(gen), 2 * M_PI * unit(gen), length(gen),
+                             entry ? other : curv, entry ? curv : other);
+    }
+    const double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+
+    std::vector<std::vector<double>> s_vals(spirals.size());
+    for (std::size_t i = 0; i < spirals.size(); i++)
+    {
+        for (int k = 0; k < samples; k++)
+            s_vals[i].push_back(spirals[i].length * unit(gen));
+    }
+
+    double max_pos_err = 0.0, max_grad_err = 0.0, sink = 0.0;
+    for (std::size_t i = 0; i < spirals.size(); i++)
+    {
+        for (const double s : s_vals[i])
+        {
+            const odr::Vec2D a = spirals[i].get_xy(s), b = spirals[i].get_xy_exact(s);
+            const odr::Vec2D ga = spirals[i].get_grad(s), gb = spirals[i].get_grad_exact(s);
+            max_pos_err = std::max(max_pos_err, std::hypot(a[0] - b[0], a[1] - b[1]));
+            max_grad_err = std::max(max_grad_err, std::hypot(ga[0] - gb[0], ga[1] - gb[1]));
+        }
+    }
+
+    auto time_ns = [&](auto &&eval)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < spirals.size(); i++)
+        {
+            for (const double s : s_vals[i])
+            {
+                const odr::Vec2D pt = eval(spirals[i], s);
+                sink += pt[0] + pt[1];
+            }
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (spirals.size() * samples);
+    };
+    const double table_xy = time_ns([](const odr::Spiral &sp, double s) { return sp.get_xy(s); });
+    const double exact_xy = time_ns([](const odr::Spiral &sp, double s) { return sp.get_xy_exact(s); });
+    const double table_grad = time_ns([](const odr::Spiral &sp, double s) { return sp.get_grad(s); });
+    const double exact_grad = time_ns([](const odr::Spiral &sp, double s) { return sp.get_grad_exact(s); });
+
+    std::printf("%d spirals built in %.2f ms, %d samples each\n", spiral_count, build_ms, samples);
+    std::printf("get_xy    table %6.1f ns  odrSpiral %6.1f ns  max error %.3g m\n", table_xy, exact_xy, max_pos_err);
+    std::printf("get_grad  table %6.1f ns  odrSpiral %6.1f ns  max error %.3g\n", table_grad, exact_grad, max_grad_err);
+    std::printf("(checksum %g)\n", sink);
+    return max_pos_err < 5e-9 && max_grad_err < 5e-9 ? 0 : 1;
+}
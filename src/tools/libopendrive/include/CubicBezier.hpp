@@ -7,6 +7,7 @@
 #include <map>
 #include <set>
 #include <sstream>
+#include <vector>
 
 namespace odr
 {
@@ -23,6 +24,8 @@ struct CubicBezier
     T                          get_length() const;
     std::array<Vec<T, Dim>, 4> get_subcurve(const T t_start, const T t_end) const;
     std::set<T>                approximate_linear(const T eps) const;
+    // As above, appending the values of t to t_vals in ascending order
+    void approximate_linear(const T eps, std::vector<T>& t_vals) const;
 
     static std::array<Vec<T, Dim>, 4> get_control_points(const std::array<Vec<T, Dim>, 4>& coefficients)
     {
@@ -180,6 +183,14 @@ std::array<Vec<T, Dim>, 4> CubicBezier<T, Dim>::get_subcurve(const T t_start, co
 
 template<typename T, std::size_t Dim>
 std::set<T> CubicBezier<T, Dim>::approximate_linear(const T eps) const
+{
+    std::vector<T> t_vals;
+    this->approximate_linear(eps, t_vals);
+    return std::set<T>(t_vals.begin(), t_vals.end());
+}
+
+template<typename T, std::size_t Dim>
+void CubicBezier<T, Dim>::approximate_linear(const T eps, std::vector<T>& t_vals) const
 {
     /* approximate cubic bezier by splitting into quadratic ones */
     std::array<Vec<T, Dim>, 4> coefficients = this->get_coefficients(this->control_points);
@@ -194,7 +205,7 @@ std::set<T> CubicBezier<T, Dim>::approximate_linear(const T eps) const
     else
         seg_intervals.push_back({seg_intervals.back().at(1), T(1)});
 
-    std::vector<T> t_vals{0};
+    t_vals.push_back(0);
     for (const std::array<T, 2>& seg_intrvl : seg_intervals)
     {
         /* get sub-cubic bezier for interval */
@@ -223,8 +234,6 @@ std::set<T> CubicBezier<T, Dim>::approximate_linear(const T eps) const
         t_vals.pop_back();
     }
     t_vals.push_back(1);
-
-    return std::set<T>(t_vals.begin(), t_vals.end());
 }
 
 template<typename T, std::size_t Dim>
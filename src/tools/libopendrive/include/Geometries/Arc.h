@@ -4,6 +4,7 @@
 
 #include <memory>
 #include <set>
+#include <vector>
 
 namespace odr
 {
@@ -16,8 +17,11 @@ struct Arc : public RoadGeometry
 
     Vec2D get_xy(double s) const override;
     Vec2D get_grad(double s) const override;
+    void  get_xy(const double* s, std::size_t count, Vec2D* out) const override;
+    void  get_grad(const double* s, std::size_t count, Vec2D* out) const override;
 
     std::set<double> approximate_linear(double eps) const override;
+    void             approximate_linear(double eps, std::vector<double>& s_vals) const override;
 
     double curvature = 0;
 };
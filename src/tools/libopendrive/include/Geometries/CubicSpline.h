@@ -1,7 +1,7 @@
 #pragma once
 #include <cstddef>
-#include <map>
 #include <set>
+#include <vector>
 
 namespace odr
 {
@@ -18,6 +18,9 @@ struct Poly3
     bool   isnan() const;
 
     std::set<double> approximate_linear(double eps, double s_start, double s_end) const;
+    // As above, appending the values of s to s_vals in ascending order.
+    // Values may repeat; sort_unique() makes them a set.
+    void approximate_linear(double eps, double s_start, double s_end, std::vector<double>& s_vals) const;
 
     double a = 0;
     double b = 0;
@@ -25,14 +28,42 @@ struct Poly3
     double d = 0;
 };
 
+// Piecewise cubic, with polys kept by ascending s0 in flat arrays
 struct CubicSpline
 {
+    // Evaluates a spline at s values that mostly move in one direction, as
+    // tessellation does. Each call starts from the previous call's poly, so
+    // a sorted sweep costs O(1) per value; jumps fall back to a search. The
+    // spline must outlive the cursor and not change while it is used.
+    class Cursor
+    {
+    public:
+        explicit Cursor(const CubicSpline& spline) : spline(spline) {}
+
+        double get(double s, double default_val = 0.0, bool extend_start = true);
+        double get_grad(double s, double default_val = 0.0, bool extend_start = true);
+
+    private:
+        const Poly3* seek(double s, bool extend_start);
+
+        const CubicSpline& spline;
+        std::size_t        idx = 0;
+    };
+
     CubicSpline() = default;
 
     double get(double s, double default_val = 0.0, bool extend_start = true) const;
     double get_grad(double s, double default_val = 0.0, bool extend_start = true) const;
     double get_max(double s_start, double s_end) const;
     Poly3  get_poly(double s, bool extend_start = true) const;
+    // Evaluates count values at once, through a Cursor
+    void get(const double* s, std::size_t count, double* out, double default_val = 0.0, bool extend_start = true) const;
+
+    // Index of the poly for s: the last one starting at or before s, or
+    // the first one if s is before them all. The spline must not be empty.
+    std::size_t find_poly(double s) const;
+    // Adds a poly starting at s0, replacing any that already starts there
+    void insert(double s0, const Poly3& poly);
 
     bool        empty() const;
     std::size_t size() const;
@@ -40,8 +71,12 @@ struct CubicSpline
     CubicSpline add(const CubicSpline& other) const;
 
     std::set<double> approximate_linear(double eps, double s_start, double s_end) const;
+    // As above, appending to s_vals in ascending order. The s where two
+    // polys meet is appended by both.
+    void approximate_linear(double eps, double s_start, double s_end, std::vector<double>& s_vals) const;
 
-    std::map<double, Poly3> s0_to_poly;
+    std::vector<double> s0_vals; // Ascending
+    std::vector<Poly3>  polys;   // polys[i] starts at s0_vals[i]
 };
 
 } // namespace odr
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 #include <memory>
 #include <set>
+#include <vector>
 
 namespace odr
 {
@@ -30,8 +31,11 @@ struct ParamPoly3 : public RoadGeometry
 
     Vec2D get_xy(double s) const override;
     Vec2D get_grad(double s) const override;
+    void  get_xy(const double* s, std::size_t count, Vec2D* out) const override;
+    void  get_grad(const double* s, std::size_t count, Vec2D* out) const override;
 
     std::set<double> approximate_linear(double eps) const override;
+    void             approximate_linear(double eps, std::vector<double>& s_vals) const override;
 
     double        aU = 0, bU = 0, cU = 0, dU = 0, aV = 0, bV = 0, cV = 0, dV = 0;
     bool          pRange_normalized = true;
@@ -2,8 +2,10 @@
 #include "Math.hpp"
 #include "XmlNode.h"
 
+#include <cstddef>
 #include <memory>
 #include <set>
+#include <vector>
 
 namespace odr
 {
@@ -26,7 +28,16 @@ struct RoadGeometry : public XmlNode
     virtual Vec2D get_xy(double s) const = 0;
     virtual Vec2D get_grad(double s) const = 0;
 
+    // As above for count values of s at once, into out. Subclasses hoist
+    // what doesn't depend on s out of the loop; results match the
+    // single-point calls exactly.
+    virtual void get_xy(const double* s, std::size_t count, Vec2D* out) const;
+    virtual void get_grad(const double* s, std::size_t count, Vec2D* out) const;
+
     virtual std::set<double> approximate_linear(double eps) const = 0;
+    // As above, appending the values of s to s_vals in ascending order.
+    // Values may repeat; sort_unique() makes them a set.
+    virtual void approximate_linear(double eps, std::vector<double>& s_vals) const;
 
     double       s0 = 0;
     double       x0 = 0;
@@ -4,6 +4,7 @@
 
 #include <memory>
 #include <set>
+#include <vector>
 
 namespace odr
 {
@@ -16,8 +17,15 @@ struct Spiral : public RoadGeometry
 
     Vec2D get_xy(double s) const override;
     Vec2D get_grad(double s) const override;
+    void  get_xy(const double* s, std::size_t count, Vec2D* out) const override;
+    void  get_grad(const double* s, std::size_t count, Vec2D* out) const override;
 
     std::set<double> approximate_linear(double eps) const override;
+    void             approximate_linear(double eps, std::vector<double>& s_vals) const override;
+
+    // Straight from odrSpiral(), without the table
+    Vec2D get_xy_exact(double s) const;
+    Vec2D get_grad_exact(double s) const;
 
     double curv_start = 0;
     double curv_end = 0;
@@ -30,6 +38,25 @@ private:
     double x0_spiral = 0;
     double y0_spiral = 0;
     double a0_spiral = 0;
+
+    // get_xy() and get_grad() start from the nearest of these nodes, taken
+    // from odrSpiral() every table_step along the spiral, and integrate the
+    // clothoid's tangent from there. table_step keeps the heading change
+    // over half a step, and the quadrature error, small enough that the
+    // error stays near 1e-9 m.
+    struct Node
+    {
+        double x;
+        double y;
+        double cos_hdg;
+        double sin_hdg;
+        double curv;
+    };
+    const Node& nearest_node(double s, double& ds) const;
+
+    std::vector<Node> table;
+    double            table_step = 0;
+    double            inv_table_step = 0;
 };
 
 } // namespace odr
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "XmlNode.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
@@ -22,20 +23,34 @@ struct HeightOffset
     double outer = 0;
 };
 
+// Index of a road or lane section that OpenDriveMap hasn't numbered
+constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+// Names a lane by road id, lane section start and lane id. Once OpenDriveMap
+// has parsed a map, the keys of its lanes also carry the dense indices of
+// their road and lane section, for OpenDriveMap::lane() and friends to look
+// them up without going through the road id. Keys are hashed and compared
+// by the names alone, so a numbered key and one built by hand for the same
+// lane are the same key.
 struct LaneKey
 {
     LaneKey(std::string road_id, double lanesection_s0, int lane_id);
     std::string to_string() const;
 
+    bool is_indexed() const { return lanesection_index != NO_INDEX; }
+
     std::string road_id = "";
     double      lanesection_s0 = 0;
     int         lane_id = 0;
+    uint32_t    road_index = NO_INDEX;
+    uint32_t    lanesection_index = NO_INDEX;
 };
 
 struct Lane : public XmlNode
 {
     Lane(std::string road_id, double lanesection_s0, int id, bool level, std::string type);
 
+    // Roadmarks overlapping [s_start, s_end], clipped to it
     std::vector<RoadMark> get_roadmarks(const double s_start, const double s_end) const;
 
     LaneKey     key;
@@ -51,6 +66,9 @@ struct Lane : public XmlNode
 
     std::map<double, HeightOffset> s_to_height_offset;
     std::set<RoadMarkGroup>        roadmark_groups;
+    // roadmark_groups over the whole lane section, built once the road is
+    // parsed or loaded
+    RoadMarkTable roadmark_table;
 };
 
 } // namespace odr
@@ -71,7 +89,8 @@ struct equal_to<odr::LaneKey>
 {
     bool operator()(const odr::LaneKey& lhs, const odr::LaneKey& rhs) const
     {
-        return (lhs.road_id == rhs.road_id) && (lhs.lanesection_s0 == rhs.lanesection_s0) && (lhs.lane_id == rhs.lane_id);
+        // Cheapest first: most keys that differ differ in lane or section
+        return (lhs.lane_id == rhs.lane_id) && (lhs.lanesection_s0 == rhs.lanesection_s0) && (lhs.road_id == rhs.road_id);
     }
 };
 
@@ -0,0 +1,89 @@
+#pragma once
+#include "Lane.h"
+#include "Math.hpp"
+#include "OpenDriveMap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace odr
+{
+
+struct LanePose
+{
+    double x = 0;
+    double y = 0;
+    double heading = 0; // Counterclockwise from +x, in radians
+};
+
+// The lane a pose is in, and where in it
+struct LaneMatch
+{
+    bool    matched = false;
+    LaneKey key{"", 0.0, 0};
+    double  s = 0;
+    double  t = 0;             // From the road's reference line, left positive
+    double  heading_error = 0; // Pose heading less the lane's direction of travel, in [-pi, pi]
+};
+
+// Which lane a pose is in, and its s, t and heading error there. Every
+// lane is cut along s into quads, from its inner to its outer border, that
+// are at most max_piece_length long and stay within eps of the borders.
+// The quads are hashed into a uniform grid of cell_size cells, so a query
+// only tests the few quads of its cell, and only projects onto the
+// reference line of the one it picks. Where lanes overlap, as they do in
+// junctions, the lane whose direction is nearest the heading wins; poses
+// just outside every lane, by up to eps, go to the nearest. Lanes with
+// positive ids are taken to run against s, as in right-hand traffic.
+//
+// Only roads loaded when the matcher is built are covered. The map must
+// outlive the matcher, which may be queried from several threads at once.
+class LaneMatcher
+{
+public:
+    explicit LaneMatcher(const OpenDriveMap& map,
+                         bool                drivable_only = false,
+                         double              cell_size = 4.0,
+                         double              eps = 0.1,
+                         double              max_piece_length = 4.0);
+
+    LaneMatch match(double x, double y, double heading) const;
+    LaneMatch match(const LanePose& pose) const { return this->match(pose.x, pose.y, pose.heading); }
+    // As above for count poses, into out. Consecutive poses in the same
+    // cell, as the particles of a filter mostly are, share its lookup.
+    void                   match(const LanePose* poses, std::size_t count, LaneMatch* out) const;
+    std::vector<LaneMatch> match(const std::vector<LanePose>& poses) const;
+
+    std::size_t lane_count() const { return lanes.size(); }
+    std::size_t size() const { return pieces.size(); }
+    std::size_t cell_count() const { return cells.size(); }
+
+private:
+    struct Piece
+    {
+        uint32_t lane; // Into lanes
+        double   s_start;
+        double   s_end;
+        Vec2D    corners[4]; // Inner border at s_start, then s_end, then the outer border at s_end and s_start
+    };
+
+    // Pieces of one cell, as a range of cell_pieces
+    using CellRange = std::pair<uint32_t, uint32_t>;
+
+    uint64_t         cell_key(double x, double y) const;
+    const CellRange* find_cell(uint64_t key) const;
+    LaneMatch        match(double x, double y, double heading, const CellRange* cell) const;
+
+    const OpenDriveMap&                     map;
+    double                                  cell_size;
+    double                                  eps;
+    std::vector<LaneKey>                    lanes;
+    std::vector<Piece>                      pieces;
+    std::vector<uint32_t>                   cell_pieces; // Piece indices, grouped by cell
+    std::unordered_map<uint64_t, CellRange> cells;
+};
+
+} // namespace odr
@@ -1,5 +1,6 @@
 #pragma once
 #include "Lane.h"
+#include "MapValues.h"
 #include "XmlNode.h"
 
 #include <map>
@@ -13,13 +14,15 @@ struct LaneSection : public XmlNode
 {
     LaneSection(std::string road_id, double s0);
 
-    std::vector<Lane> get_lanes() const;
+    std::vector<Lane>    get_lanes() const;
+    MapValues<int, Lane> lanes() const; // By id, without copying
 
     int  get_lane_id(const double s, const double t) const;
     Lane get_lane(const double s, const double t) const;
 
     std::string         road_id = "";
     double              s0 = 0;
+    uint32_t            index = NO_INDEX; // Among the map's lane sections, set by OpenDriveMap
     std::map<int, Lane> id_to_lane;
 };
 
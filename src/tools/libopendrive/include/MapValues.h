@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+
+namespace odr
+{
+
+// The values of a map in key order, by const reference. Unlike
+// get_map_values() nothing is copied. Valid for as long as the map is.
+template<class K, class V>
+class MapValues
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = V;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const V*;
+        using reference = const V&;
+
+        iterator() = default;
+        explicit iterator(typename std::map<K, V>::const_iterator it) : it(it) {}
+
+        reference operator*() const { return it->second; }
+        pointer   operator->() const { return &it->second; }
+
+        iterator& operator++()
+        {
+            ++it;
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator prev = *this;
+            ++it;
+            return prev;
+        }
+        iterator& operator--()
+        {
+            --it;
+            return *this;
+        }
+        iterator operator--(int)
+        {
+            iterator next = *this;
+            --it;
+            return next;
+        }
+
+        bool operator==(const iterator& other) const { return it == other.it; }
+        bool operator!=(const iterator& other) const { return it != other.it; }
+
+    private:
+        typename std::map<K, V>::const_iterator it;
+    };
+
+    explicit MapValues(const std::map<K, V>& map) : map(&map) {}
+
+    iterator    begin() const { return iterator(map->begin()); }
+    iterator    end() const { return iterator(map->end()); }
+    std::size_t size() const { return map->size(); }
+    bool        empty() const { return map->empty(); }
+
+private:
+    const std::map<K, V>* map;
+};
+
+} // namespace odr
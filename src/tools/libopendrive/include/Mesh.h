@@ -1,7 +1,9 @@
 #pragma once
 #include "Math.hpp"
 
+#include <cstddef>
 #include <cstdint>
+#include <iosfwd>
 #include <string>
 #include <vector>
 
@@ -13,8 +15,21 @@ struct Mesh3D
     Mesh3D() = default;
 
     void        add_mesh(const Mesh3D& other);
+    // Room for this many more vertices, with normals and st coordinates,
+    // and indices
+    void        reserve_more(std::size_t num_vertices, std::size_t num_indices);
     std::string get_obj() const;
 
+    // The mesh as binary glTF (GLB), one triangle-list primitive. glTF
+    // attributes are float32, so positions are stored relative to the
+    // mesh's lower corner, which becomes the node's translation. Normals
+    // and st coordinates are included if there is one per vertex.
+    std::string get_glb() const;
+    void        write_glb(std::ostream& out) const;
+    // As above, streamed to an open file descriptor a chunk at a time.
+    // Throws std::runtime_error if a write fails.
+    void write_glb(int fd) const;
+
     std::vector<Vec3D>    vertices;
     std::vector<uint32_t> indices;
     std::vector<Vec3D>    normals;
@@ -1,13 +1,18 @@
 #pragma once
 #include "Junction.h"
+#include "MapValues.h"
 #include "Road.h"
 #include "RoadNetworkMesh.h"
 #include "RoutingGraph.h"
 
 #include <pugixml.hpp>
 
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 // Boost headers
@@ -35,42 +40,213 @@ namespace odr
         bool with_road_objects = true;
         bool center_map = false;
         bool abs_z_for_for_local_road_obj_outline = false;
+        // Threads that parse roads in the constructor and tessellate them
+        // in get_lane_polygons() and get_road_network_mesh(). 0 uses one
+        // per hardware thread, 1 does everything on the calling thread.
+        unsigned int parallelism = 0;
+        // Only read road headers and planView extents in the constructor,
+        // and parse a road when load_road() or load_roads_in() first asks
+        // for it. Until then a road has no geometry, lanes or objects, and
+        // whole-map queries (roads(), get_lane_polygons(), ...) only see
+        // the roads loaded so far.
+        bool lazy_roads = false;
+        // With lazy_roads, roads loaded beyond this many are unloaded,
+        // least recently asked for first. 0 keeps every road once loaded.
+        std::size_t max_loaded_roads = 0;
+        // Keep xml_doc, and the xml_node of everything parsed from it, for
+        // the map's lifetime. Without it, the DOM and the file or string it
+        // was parsed from are freed once the constructor has built the map,
+        // and every xml_node is null; everything the library uses has been
+        // copied out by then. Lazy maps parse roads from the DOM, so they
+        // always keep it.
+        bool keep_xml = true;
     };
 
+    // A caller's xodr for OpenDriveMap to parse in place. A type of its own,
+    // so that OpenDriveMap(path, false) can't be taken for a buffer.
+    struct InPlaceBuffer
+    {
+        char *data;
+        std::size_t size;
+    };
+
+    // A file written by OpenDriveMap::save(), for OpenDriveMap to load in
+    // place of parsing an xodr.
+    struct SavedMap
+    {
+        std::string path;
+    };
+
+    // Thread safety: once constructed, every const member may be called
+    // from several threads at once. Accessors of the parsed map (roads(),
+    // road(), lanesection(), lane(), and the roads' own queries) only
+    // read, and take no lock. get_lane_polygons(), get_road_object_centers()
+    // and the trees are built once under call_once, then read without a
+    // lock; get_lane_polygons() still locks briefly to find its cache
+    // entry. get_road_network_mesh() holds a lock while it builds or
+    // copies out its mesh. The exception is a lazy map: load_road() and
+    // load_roads_in() may unload roads, so they mustn't run alongside
+    // reads of those roads, and the caches above only see the roads
+    // loaded when they were built.
     class OpenDriveMap
     {
     public:
+        // Parses the xodr in xodr_file if from_string, else the file at
+        // that path. The file is memory-mapped and parsed in place.
         OpenDriveMap(const std::string &xodr_file, bool from_string = true, const OpenDriveMapConfig &config = OpenDriveMapConfig{});
+        // Parses the xodr in buffer in place. pugixml writes into the
+        // buffer and xml_doc points into it, so the buffer must outlive the
+        // map, or only the constructor without keep_xml. Nothing is copied.
+        OpenDriveMap(InPlaceBuffer buffer, const OpenDriveMapConfig &config = OpenDriveMapConfig{});
+        // Loads a map that save() wrote. Only config.parallelism applies:
+        // the rest was settled when the saved map was parsed, and every
+        // road is loaded. Nothing keeps an xml_node. Throws
+        // std::runtime_error if the file can't be read, is from another
+        // version, or is malformed.
+        OpenDriveMap(const SavedMap &saved, const OpenDriveMapConfig &config = OpenDriveMapConfig{});
+        ~OpenDriveMap();
 
         std::vector<Road> get_roads() const;
         std::vector<Junction> get_junctions() const;
 
+        // As above, by id, without copying
+        MapValues<std::string, Road> roads() const;
+        MapValues<std::string, Junction> junctions() const;
+
+        // Roads and lane sections by the dense indices their lanes' keys
+        // carry. Roads are numbered in id order, and lane sections in road,
+        // then s, order.
+        std::size_t road_count() const { return road_by_index_.size(); }
+        std::size_t lanesection_count() const { return lanesection_by_index_.size(); }
+        const Road &road(uint32_t index) const { return *road_by_index_.at(index); }
+        // Throws std::out_of_range if the lane section's road isn't loaded.
+        const LaneSection &lanesection(uint32_t index) const;
+        // The lane a key names. Throws std::out_of_range if there is none.
+        const Lane &lane(const LaneKey &key) const;
+
         RoutingGraph get_routing_graph() const;
 
+        // Writes the parsed map (roads with their geometries, splines,
+        // lane sections, lanes, roadmarks, objects and signals, and the
+        // junctions) to path in a versioned binary format, for
+        // OpenDriveMap(SavedMap) to load. Lazy maps only write the roads
+        // loaded so far. Throws std::runtime_error if the file can't be
+        // written.
+        void save(const std::string &path) const;
+
+        // The road with this id, parsed first if it isn't loaded. With
+        // max_loaded_roads set, this may unload others: an unloaded road
+        // is replaced by a fresh one from its header, so references to it
+        // or anything in it are left dangling. Throws std::out_of_range if
+        // there is no such road. Loading is safe to call from several
+        // threads, but not alongside reads of roads it may unload.
+        const Road &load_road(const std::string &id);
+        // The roads whose reference lines may run through region, loaded
+        // as above, by index. Lanes reach past the reference line, so pad
+        // region by the widest road's half-width.
+        std::vector<const Road *> load_roads_in(const box &region);
+        bool road_loaded(uint32_t index) const;
+
         std::string proj4 = "";
         double x_offs = 0;
         double y_offs = 0;
+        // The path, or the xodr itself if parsed from a string. Left empty
+        // for strings when the map doesn't keep_xml.
         const std::string xodr_file = "";
+        // Empty once built, unless the map keeps it (see keep_xml)
         pugi::xml_document xml_doc;
 
         std::map<std::string, Road> id_to_road;
         std::map<std::string, Junction> id_to_junction;
-        bgi::rtree<value, bgi::rstar<16, 4>> generate_mesh_tree();
-        bgi::rtree<value, bgi::rstar<16, 4>> generate_object_tree();
-        std::unique_ptr<RoadNetworkMesh> road_mesh_;
+        // Bulk-loaded trees of the bounding boxes of get_lane_polygons(1.0,
+        // false) and of get_road_object_centers(), with values indexing
+        // them. Built on first use and shared by every caller after; safe
+        // to call from several threads.
+        std::shared_ptr<const bgi::rtree<value, bgi::rstar<16, 4>>> generate_mesh_tree() const;
+        std::shared_ptr<const bgi::rtree<value, bgi::rstar<16, 4>>> generate_object_tree() const;
 
-        std::vector<ring> get_drivable_lane_polygons(float res);
-        std::vector<std::pair<Lane, ring>> get_lane_polygons(float res = 1.0, bool drivable_only = true);
-        std::vector<std::pair<RoadObject, point>> get_road_object_centers();
+        // Built once per (res, drivable_only) and kept for the map's
+        // lifetime, so the reference stays valid. Safe to call from
+        // several threads.
+        const std::vector<LanePair> &get_lane_polygons(float res = 1.0, bool drivable_only = true) const;
+        // Every object and signal, as an object, with where it stands on
+        // the road surface. Built once, like get_lane_polygons().
+        const std::vector<std::pair<RoadObject, point>> &get_road_object_centers() const;
 
-        RoadNetworkMesh get_road_network_mesh(double eps);
+        // Lane meshes of the whole map, kept until asked for at another eps.
+        // RoadNetworkMeshTiles builds them, with roadmarks and objects, a
+        // tile at a time.
+        RoadNetworkMesh get_road_network_mesh(double eps) const;
 
     private:
-        std::unique_ptr<std::vector<std::pair<Lane, ring>>> drivable_lane_polygons_;
-        std::unique_ptr<std::vector<std::pair<Lane, ring>>> lane_polygons_;
-        std::vector<std::pair<RoadObject, point>> object_centers_;
-        std::unique_ptr<std::vector<ring>> road_polygons_;
-        std::unique_ptr<bgi::rtree<value, bgi::rstar<16, 4>>> rtree_;
+        pugi::xml_parse_result load_file_inplace(const std::string &path);
+        void parse(const OpenDriveMapConfig &config);
+        // Frees xml_doc, what it was parsed from and the road nodes, once
+        // every road is parsed and nothing points into them.
+        void release_xml();
+        // Number roads, lane sections and lane keys, once parsed.
+        void index_roads();
+        // Number a road's lane sections after those already numbered.
+        void index_lanesections(Road &road);
+        // Once roads are numbered, ready the per-road state and the
+        // extent tree
+        void index_road_extents(const std::vector<value> &extents, bool loaded);
+
+        // Parses the distinct roads given that aren't loaded yet and marks
+        // them all as most recently used, then unloads the least recently
+        // used beyond max_loaded_roads. Expects roads_mutex_ held.
+        void load_roads(const std::vector<uint32_t> &indices);
+        void unload_road(uint32_t index);
+        RoadNetworkMesh build_road_network_mesh(double eps) const;
+
+        // The file xml_doc was parsed from, while mapped
+        void *mapped_file_ = nullptr;
+        std::size_t mapped_size_ = 0;
+
+        std::vector<LanePair> build_lane_polygons(float res, bool drivable_only) const;
+        void build_road_lane_polygons(const Road &road, float res, bool drivable_only, std::vector<LanePair> &out) const;
+
+        // Everything under one <road> node. Only reads the map's offsets.
+        void parse_road(Road &road, pugi::xml_node road_node, const OpenDriveMapConfig &config) const;
+
+        // Calls f(i) for every i < count, spread over parallelism_ threads.
+        template <typename F>
+        void for_each_road(std::size_t count, F &&f) const;
+        unsigned int parallelism_;
+
+        std::vector<Road *> road_by_index_;
+        // Null for the lane sections of unloaded roads
+        std::vector<LaneSection *> lanesection_by_index_;
+
+        // The <road> nodes each road is parsed from, by index
+        OpenDriveMapConfig config_;
+        std::vector<std::vector<pugi::xml_node>> road_nodes_;
+        // planView extents, by road index
+        bgi::rtree<value, bgi::rstar<16, 4>> road_extent_tree_;
+        mutable std::mutex roads_mutex_;
+        std::vector<bool> road_loaded_;
+        std::list<uint32_t> lru_roads_; // Loaded roads, most recently asked for first
+        std::vector<std::list<uint32_t>::iterator> lru_pos_;
+
+        struct LanePolygonCache
+        {
+            std::once_flag built;
+            std::vector<LanePair> polys;
+        };
+        // Entries are never erased, so each stays where it was inserted.
+        mutable std::mutex lane_polygons_mutex_;
+        mutable std::map<std::pair<float, bool>, LanePolygonCache> lane_polygons_;
+        // Shared, so a caller copying it out doesn't hold the lock while a
+        // mesh at another eps replaces it.
+        mutable std::mutex road_mesh_mutex_;
+        mutable std::shared_ptr<const RoadNetworkMesh> road_mesh_;
+        mutable double road_mesh_eps_ = 0; // What road_mesh_ was built at
+        mutable std::once_flag object_centers_built_;
+        mutable std::vector<std::pair<RoadObject, point>> object_centers_;
+        mutable std::once_flag mesh_tree_built_;
+        mutable std::shared_ptr<const bgi::rtree<value, bgi::rstar<16, 4>>> mesh_tree_;
+        mutable std::once_flag object_tree_built_;
+        mutable std::shared_ptr<const bgi::rtree<value, bgi::rstar<16, 4>>> object_tree_;
     };
 
 } // namespace odr
\ No newline at end of file
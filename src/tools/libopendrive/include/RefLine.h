@@ -3,10 +3,12 @@
 #include "Geometries/RoadGeometry.h"
 #include "Math.hpp"
 
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace odr
 {
@@ -25,9 +27,22 @@ struct RefLine
 
     Vec3D            get_xyz(const double s) const;
     Vec3D            get_grad(const double s) const;
+    // As above for count values of s, with one geometry lookup and one
+    // batched call per run of s on the same geometry
+    void             get_xyz(const double* s, std::size_t count, Vec3D* out) const;
+    void             get_grad(const double* s, std::size_t count, Vec3D* out) const;
     Line3D           get_line(const double s_start, const double s_end, const double eps) const;
+    // s of the point on the reference line nearest to (x, y), globally
+    // over the road or within [s_start, s_end]
     double           match(const double x, const double y) const;
+    double           match(const double x, const double y, const double s_start, const double s_end) const;
+    // Refine s, a guess near the nearest point, by Gauss-Newton on the
+    // geometry, staying within [s_min, s_max]
+    double           refine_match(const double x, const double y, double s, const double s_min, const double s_max) const;
     std::set<double> approximate_linear(const double eps, const double s_start, const double s_end) const;
+    // As above, appending to s_vals unsorted and with repeats. Finish with
+    // sort_unique() once everything to sample at is in.
+    void             approximate_linear(const double eps, const double s_start, const double s_end, std::vector<double>& s_vals) const;
 
     std::string road_id = "";
     double      length = 0;
@@ -0,0 +1,56 @@
+#pragma once
+#include "Math.hpp"
+#include "OpenDriveMap.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace odr
+{
+
+// A point relative to the nearest road reference line
+struct RefLineProjection
+{
+    uint32_t road_index = NO_INDEX; // Of OpenDriveMap::road(), NO_INDEX if none was in reach
+    double   s = 0;
+    double   t = 0;               // Left of the reference line is positive
+    double   distance = INFINITY; // From the reference line, in the xy plane
+};
+
+// The reference lines of every road in a map, cut into segments of at most
+// eps deviation and kept in an R-tree. Candidates come from the tree, and
+// each is refined on its road's geometry, so the nearest road is found
+// even where RefLine::match() alone would settle on the wrong part of a
+// curve. The map must outlive the index.
+class RefLineIndex
+{
+public:
+    explicit RefLineIndex(const OpenDriveMap& map, double eps = 0.1);
+
+    RefLineProjection project(double x, double y, double max_distance = INFINITY) const;
+    // As above for every point. Consecutive points that are close, like
+    // those of a trajectory, start from the previous point's answer.
+    std::vector<RefLineProjection> project(const std::vector<Vec2D>& points, double max_distance = INFINITY) const;
+
+    std::size_t size() const { return segments.size(); }
+
+private:
+    struct Segment
+    {
+        uint32_t road_index;
+        double   s_start;
+        double   s_end;
+        Vec2D    start;
+        Vec2D    end;
+    };
+
+    RefLineProjection project(double x, double y, double max_distance, const RefLineProjection* hint) const;
+
+    const OpenDriveMap&                  map;
+    double                               eps;
+    std::vector<Segment>                 segments;
+    bgi::rtree<value, bgi::rstar<16, 4>> tree;
+};
+
+} // namespace odr
@@ -1,6 +1,7 @@
 #pragma once
 #include "Geometries/CubicSpline.h"
 #include "LaneSection.h"
+#include "MapValues.h"
 #include "Math.hpp"
 #include "Mesh.h"
 #include "RefLine.h"
@@ -79,12 +80,55 @@ namespace odr
     class Road : public XmlNode
     {
     public:
+        // Evaluates the road's surface at s values that mostly move in one
+        // direction, as tessellation does. The lane section, its lanes'
+        // borders and the superelevation carry on from the previous call
+        // rather than being looked up again. The road must outlive the
+        // cursor and not change while it is used.
+        class Cursor
+        {
+        public:
+            explicit Cursor(const Road &road);
+
+            // As Road::get_surface_pt and Road::get_xyz, given the
+            // reference line's point p0 and gradient s_vec at s, which
+            // must be within the road
+            Vec3D get_surface_pt(double s, double t, const Vec3D &p0, const Vec3D &s_vec, Vec3D *vn = nullptr);
+            Vec3D get_xyz(double s, double t, double h, const Vec3D &p0, const Vec3D &s_vec, Vec3D *e_s = nullptr, Vec3D *e_t = nullptr, Vec3D *e_h = nullptr);
+
+        private:
+            void seek_lanesection(double s);
+            // Index into lanes of the lane (s, t) is in, as
+            // LaneSection::get_lane_id() finds it
+            std::size_t lane_at(double s, double t);
+
+            const Road &road;
+            CubicSpline::Cursor superelevation;
+
+            // The lane section last used, and the s it covers
+            const LaneSection *lanesec = nullptr;
+            double lanesec_s0 = 0;
+            double lanesec_next_s0 = 0; // Where the next one starts
+            double lanesec_end = 0;
+
+            std::vector<const Lane *> lanes; // By id
+            std::vector<CubicSpline::Cursor> inner_borders;
+            std::vector<CubicSpline::Cursor> outer_borders;
+            std::vector<double> outer_ts; // Reused by lane_at()
+            std::size_t center = 0;       // Index of lane 0
+        };
+
         Road(std::string id, double length, std::string junction, std::string name);
 
         std::vector<LaneSection> get_lanesections() const;
         std::vector<RoadObject> get_road_objects() const;
         std::vector<RoadSignal> get_signals() const;
 
+        // As above, in s or id order, without copying
+        MapValues<double, LaneSection> lanesections() const;
+        MapValues<std::string, RoadObject> road_objects() const;
+        MapValues<std::string, RoadSignal> signals() const;
+
         double get_lanesection_s0(const double s) const;
         LaneSection get_lanesection(const double s) const;
 
@@ -92,9 +136,15 @@ namespace odr
         double get_lanesection_end(const double lanesection_s0) const;
         double get_lanesection_length(const LaneSection &lanesection) const;
         double get_lanesection_length(const double lanesection_s0) const;
+        // Builds every lane's roadmark_table, once its lane sections and
+        // length are set
+        void build_roadmark_tables();
 
         Vec3D get_xyz(const double s, const double t, const double h, Vec3D *e_s = nullptr, Vec3D *e_t = nullptr, Vec3D *e_h = nullptr) const;
         Vec3D get_surface_pt(double s, const double t, Vec3D *vn = nullptr) const;
+        // get_surface_pt() for count (s, t) pairs, with the reference line
+        // evaluated in one batch. vn, if given, gets count normals.
+        void get_surface_pt(const double *s, const double *t, std::size_t count, Vec3D *out, Vec3D *vn = nullptr) const;
 
         Line3D get_lane_border_line(const Lane &lane, const double s_start, const double s_end, const double eps, const bool outer = true) const;
         Line3D get_lane_border_line(const Lane &lane, const double eps, const bool outer = true) const;
@@ -104,14 +154,25 @@ namespace odr
         Mesh3D get_lane_mesh(const Lane &lane, const double eps, std::vector<uint32_t> *outline_indices = nullptr) const;
 
         Mesh3D get_roadmark_mesh(const Lane &lane, const RoadMark &roadmark, const double eps) const;
+        // As above, for a mark of lane.roadmark_table cut to [s_start,
+        // s_end], appended to out
+        void append_roadmark_mesh(
+            const Lane &lane, const RoadMarkTable::Mark &mark, const double s_start, const double s_end, const double eps, Mesh3D &out) const;
         Mesh3D get_road_object_mesh(const RoadObject &road_object, const double eps) const;
 
         std::set<double>
         approximate_lane_border_linear(const Lane &lane, const double s_start, const double s_end, const double eps, const bool outer = true) const;
         std::set<double> approximate_lane_border_linear(const Lane &lane, const double eps, const bool outer = true) const;
+        // As the first above, appending to s_vals unsorted and with repeats
+        void approximate_lane_border_linear(
+            const Lane &lane, const double s_start, const double s_end, const double eps, const bool outer, std::vector<double> &s_vals) const;
+        // The s values get_lane_mesh() samples the lane at, into s_vals:
+        // sorted, and thinned out so that all but the last are over eps apart
+        void approximate_lane_mesh_linear(const Lane &lane, const double s_start, const double s_end, const double eps, std::vector<double> &s_vals) const;
 
         double length = 0;
         std::string id = "";
+        uint32_t index = NO_INDEX; // Among the map's roads, set by OpenDriveMap
         std::string junction = "";
         std::string name = "";
 
@@ -129,6 +190,10 @@ namespace odr
         std::map<double, SpeedRecord> s_to_speed;
         std::map<std::string, RoadObject> id_to_object;
         std::map<std::string, RoadSignal> id_to_signal;
+
+    private:
+        // s clamped to the road, and the reference line at each
+        void sample_ref_line(const double *s, std::size_t count, std::vector<double> &s_out, std::vector<Vec3D> &p0, std::vector<Vec3D> &s_vec) const;
     };
 
 } // namespace odr
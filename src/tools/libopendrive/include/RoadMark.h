@@ -2,9 +2,13 @@
 #include "Utils.hpp"
 #include "XmlNode.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace odr
 {
@@ -151,4 +155,54 @@ struct less<odr::RoadMarkGroup>
                                           &odr::RoadMarkGroup::lane_change);
     }
 };
-} // namespace std
\ No newline at end of file
+} // namespace std
+
+namespace odr
+{
+
+// A lane's roadmarks over its whole lane section, worked out once from its
+// roadmark groups: one mark per group without lines, and one per dash of
+// each line. Marks are sorted by s_start, with the furthest s_end reached
+// so far kept alongside, so the marks over a range are found by binary
+// search however long the marks are.
+class RoadMarkTable
+{
+public:
+    struct Mark
+    {
+        double   s_start = 0;
+        double   s_end = 0;
+        double   t_offset = 0;
+        double   width = 0;
+        double   group_s0 = 0;
+        uint32_t type = 0; // Index into types
+    };
+
+    // Marks of groups for a lane section over [s_start, s_end]. Marks of
+    // no length are left out.
+    void build(const std::set<RoadMarkGroup>& groups, double s_start, double s_end);
+
+    // Calls f(mark) for every mark overlapping [s_start, s_end), in
+    // s_start order
+    template<typename F>
+    void for_each(double s_start, double s_end, F&& f) const
+    {
+        const std::size_t first = std::upper_bound(this->reach.begin(), this->reach.end(), s_start) - this->reach.begin();
+        for (std::size_t i = first; i < this->marks.size() && this->marks[i].s_start < s_end; i++)
+        {
+            if (this->marks[i].s_end > s_start)
+                f(this->marks[i]);
+        }
+    }
+
+    const std::string& type(const Mark& mark) const { return this->types[mark.type]; }
+
+    std::vector<Mark> marks;
+    // The type of each mark: its group's type and its line's name
+    std::vector<std::string> types;
+
+private:
+    std::vector<double> reach; // Largest s_end of marks[0] to marks[i]
+};
+
+} // namespace odr
@@ -59,6 +59,12 @@ struct RoadObjectsMesh : public RoadsMesh
 struct RoadNetworkMesh
 {
     Mesh3D get_mesh() const;
+    // Appends other's meshes after ours, shifting its start indices along
+    // with its vertex indices. Where both have a start at the same vertex,
+    // other's wins.
+    void add_mesh(const RoadNetworkMesh& other);
+    // The parts appended in order, with every buffer sized once up front
+    static RoadNetworkMesh concat(const std::vector<RoadNetworkMesh>& parts);
 
     LanesMesh       lanes_mesh;
     RoadmarksMesh   roadmarks_mesh;
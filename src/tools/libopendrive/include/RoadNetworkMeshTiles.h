@@ -0,0 +1,71 @@
+#pragma once
+#include "OpenDriveMap.h"
+#include "RoadNetworkMesh.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace odr
+{
+
+// A square of a grid laid over the map, with tile (0, 0) having its lower
+// left corner at the origin
+struct MeshTile
+{
+    int x = 0;
+    int y = 0;
+};
+
+// The road network mesh of a map, cut into square tiles and built only for
+// the tiles asked for, each at the eps its distance from the viewer calls
+// for. A stretch of road belongs to the tile its reference line runs
+// through, so lanes and roadmarks may hang over a tile's edge by about a
+// road's width; objects belong to the tile of their anchor on the
+// reference line. The map must outlive the tiles.
+class RoadNetworkMeshTiles
+{
+public:
+    RoadNetworkMeshTiles(const OpenDriveMap& map, double tile_size);
+
+    MeshTile tile_at(double x, double y) const;
+    // Every tile some road runs through, by x, then y
+    std::vector<MeshTile> tiles() const;
+
+    // The tile's lanes, roadmarks and objects at eps. Built on first use
+    // and kept for the lifetime of the tiles, so the reference stays
+    // valid. Safe to call from several threads. Empty for a tile no road
+    // runs through.
+    const RoadNetworkMesh& get_mesh(const MeshTile& tile, double eps) const;
+
+    double size() const { return tile_size; }
+
+private:
+    // [s_start, s_end) of a road within one tile
+    struct RoadSpan
+    {
+        uint32_t road_index;
+        double   s_start;
+        double   s_end;
+    };
+
+    RoadNetworkMesh build_mesh(const std::vector<RoadSpan>& spans, double eps) const;
+
+    const OpenDriveMap&                                  map;
+    double                                               tile_size;
+    std::map<std::pair<int, int>, std::vector<RoadSpan>> tile_to_spans;
+
+    struct MeshCache
+    {
+        std::once_flag  built;
+        RoadNetworkMesh mesh;
+    };
+    // Entries are never erased, so each stays where it was inserted.
+    mutable std::mutex                                        meshes_mutex;
+    mutable std::map<std::tuple<int, int, double>, MeshCache> meshes;
+};
+
+} // namespace odr
@@ -0,0 +1,90 @@
+#pragma once
+#include "Lane.h"
+#include "Math.hpp"
+#include "OpenDriveMap.h"
+#include "RoadNetworkMesh.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace odr
+{
+
+// Where a query met the road surface
+struct SurfaceHit
+{
+    bool     hit = false;
+    Vec3D    point{0, 0, 0};
+    Vec3D    normal{0, 0, 1};     // Of the triangle hit, of unit length and facing up
+    double   distance = INFINITY; // Along the ray, for intersect()
+    uint32_t lane = NO_INDEX;     // Into RoadSurfaceBVH::lanes()
+};
+
+struct SurfaceRay
+{
+    Vec3D  origin{0, 0, 0};
+    Vec3D  direction{0, 0, -1}; // Of any length
+    double max_distance = INFINITY;
+};
+
+// A bounding volume hierarchy over the lane triangles of a road network
+// mesh, for the height and normal of the road surface at a point in the
+// xy plane and for rays cast at it, without an s and t to start from.
+// Triangles are split at the median of their centroids along the longest
+// axis until at most four are left in a node. The triangles are copied,
+// so the mesh needn't outlive the hierarchy. Once built it is only read,
+// and may be queried from several threads at once.
+class RoadSurfaceBVH
+{
+public:
+    explicit RoadSurfaceBVH(const LanesMesh& mesh);
+    // Over the map's lane mesh at eps, as get_road_network_mesh() gives it
+    explicit RoadSurfaceBVH(const OpenDriveMap& map, double eps = 0.1);
+
+    // The surface straight above or below (x, y). Where surfaces overlap,
+    // as on bridges, the one nearest z is taken, and the highest when z is
+    // infinite.
+    SurfaceHit height_at(double x, double y, double z = INFINITY) const;
+    // As above for count points, into out, all with the same z
+    void                    height_at(const Vec2D* points, std::size_t count, SurfaceHit* out, double z = INFINITY) const;
+    std::vector<SurfaceHit> height_at(const std::vector<Vec2D>& points, double z = INFINITY) const;
+
+    // The first surface along the ray, from either side
+    SurfaceHit              intersect(const SurfaceRay& ray) const;
+    void                    intersect(const SurfaceRay* rays, std::size_t count, SurfaceHit* out) const;
+    std::vector<SurfaceHit> intersect(const std::vector<SurfaceRay>& rays) const;
+
+    // The lanes hits refer to. Their keys aren't indexed.
+    const std::vector<LaneKey>& lanes() const { return this->lanes_; }
+
+    std::size_t size() const { return triangles.size(); }
+    std::size_t node_count() const { return nodes.size(); }
+
+private:
+    struct Triangle
+    {
+        Vec3D    corners[3];
+        uint32_t lane; // Into lanes_
+    };
+
+    // A leaf holds triangles [first, first + count); an inner node has
+    // count 0 and its children at first and first + 1
+    struct Node
+    {
+        Vec3D    min;
+        Vec3D    max;
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    void build(uint32_t node_index, uint32_t first, uint32_t count, std::vector<uint32_t>& order, const std::vector<Vec3D>& centroids);
+    void fit(Node& node, uint32_t first, uint32_t count, const std::vector<uint32_t>& order) const;
+
+    std::vector<LaneKey>  lanes_;
+    std::vector<Triangle> triangles; // In tree order
+    std::vector<Node>     nodes;     // The root first
+};
+
+} // namespace odr
@@ -1,6 +1,8 @@
 #pragma once
 #include "Lane.h"
+#include "Math.hpp"
 
+#include <array>
 #include <cstddef>
 #include <functional>
 #include <memory>
@@ -78,11 +80,28 @@ public:
 
     std::vector<LaneKey> get_lane_successors(const LaneKey& lane_key) const;
     std::vector<LaneKey> get_lane_predecessors(const LaneKey& lane_key) const;
+
+    // Lanes from `from` to `to`, both included, by Dijkstra. Empty if `to`
+    // can't be reached.
     std::vector<LaneKey> shortest_path(const LaneKey& from, const LaneKey& to) const;
+    // The same path by A*, guided by the straight-line distance between
+    // the ends in lane_key_to_ends. Lanes without ends get no guidance.
+    std::vector<LaneKey> shortest_path_astar(const LaneKey& from, const LaneKey& to) const;
 
     std::unordered_set<RoutingGraphEdge>                             edges;
     std::unordered_map<LaneKey, std::unordered_set<WeightedLaneKey>> lane_key_to_successors;
     std::unordered_map<LaneKey, std::unordered_set<WeightedLaneKey>> lane_key_to_predecessors;
+    // Centerline points at the start and end of each lane's section
+    std::unordered_map<LaneKey, std::array<Vec2D, 2>> lane_key_to_ends;
+
+private:
+    // Dense ids and CSR successors, built by the first search after the
+    // graph changes size. Shared by copies until either changes.
+    struct Index;
+    std::shared_ptr<const Index> get_index() const;
+    std::vector<LaneKey>         search(const LaneKey& from, const LaneKey& to, bool use_heuristic) const;
+
+    mutable std::shared_ptr<const Index> cached_index;
 };
 
 } // namespace odr
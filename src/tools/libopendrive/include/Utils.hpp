@@ -40,7 +40,7 @@ template<class K, class V>
 std::set<K> get_map_keys(const std::map<K, V>& input_map)
 {
     std::set<K> retval;
-    std::transform(input_map.begin(), input_map.end(), std::inserter(retval, retval.end()), [](auto pair) { return pair.first; });
+    std::transform(input_map.begin(), input_map.end(), std::inserter(retval, retval.end()), [](const auto& pair) { return pair.first; });
     return retval;
 }
 
@@ -52,6 +52,32 @@ std::vector<V> get_map_values(const std::map<K, V>& input_map)
     return retval;
 }
 
+// Sorts vals and drops repeats, leaving what a std::set of them would hold
+template<class T>
+void sort_unique(std::vector<T>& vals)
+{
+    if (!std::is_sorted(vals.begin(), vals.end()))
+        std::sort(vals.begin(), vals.end());
+    vals.erase(std::unique(vals.begin(), vals.end()), vals.end());
+}
+
+// Drops sorted vals that are within min_step of the last one kept. The
+// first and last are always kept.
+template<class T>
+void thin_out(std::vector<T>& vals, const T min_step)
+{
+    if (vals.size() < 3)
+        return;
+    std::size_t kept = 0;
+    for (std::size_t idx = 1; idx + 1 < vals.size(); idx++)
+    {
+        if (!((vals[idx] - vals[kept]) <= min_step))
+            vals[++kept] = vals[idx];
+    }
+    vals[++kept] = vals.back();
+    vals.resize(kept + 1);
+}
+
 template<class K, class V>
 V get_nearest_lower_val(const std::map<K, V>& input_map, const K& k)
 {
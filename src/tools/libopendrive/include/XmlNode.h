@@ -7,6 +7,8 @@ namespace odr
 
     struct XmlNode
     {
+        // The node this was parsed from. Null if the map was loaded from a
+        // saved map, or doesn't keep its DOM (OpenDriveMapConfig::keep_xml).
         pugi::xml_node xml_node;
     };
 
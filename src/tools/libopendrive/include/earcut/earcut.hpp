@@ -31,6 +31,12 @@ public:
     template <typename T>
     void operator()(T const * points, size_t len);
 
+    // Appends the triangles to out rather than to indices. The node blocks
+    // are kept for the next call, so an Earcut reused this way stops
+    // allocating once it has seen its largest ring.
+    template <typename T>
+    void operator()(T const * points, size_t len, std::vector<N>& out);
+
 private:
     struct Node {
         Node(N index, double x_, double y_) : i(index), x(x_), y(y_) {}
@@ -84,6 +90,7 @@ private:
     template <typename Point> Node* insertNode(std::size_t i, const Point& p, Node* last);
     void removeNode(Node* p);
 
+    std::vector<N>* out = nullptr;
     bool hashing;
     double minX, maxX;
     double minY, maxY;
@@ -102,8 +109,13 @@ private:
         template <typename... Args>
         T* construct(Args&&... args) {
             if (currentIndex >= blockSize) {
-                currentBlock = alloc_traits::allocate(alloc, blockSize);
-                allocations.emplace_back(currentBlock);
+                if (nextBlock < allocations.size()) {
+                    currentBlock = allocations[nextBlock];
+                } else {
+                    currentBlock = alloc_traits::allocate(alloc, blockSize);
+                    allocations.emplace_back(currentBlock);
+                }
+                nextBlock++;
                 currentIndex = 0;
             }
             T* object = &currentBlock[currentIndex++];
@@ -115,15 +127,28 @@ private:
                 alloc_traits::deallocate(alloc, allocation, blockSize);
             }
             allocations.clear();
+            nextBlock = 0;
             blockSize = std::max<std::size_t>(1, newBlockSize);
             currentBlock = nullptr;
             currentIndex = blockSize;
         }
         void clear() { reset(blockSize); }
+        // Hands the blocks out again from the first, without freeing them,
+        // unless they're smaller than newBlockSize. Objects are never
+        // destroyed, so T must be trivially destructible.
+        void rewind(std::size_t newBlockSize) {
+            if (newBlockSize > blockSize) {
+                reset(newBlockSize);
+                return;
+            }
+            nextBlock = 0;
+            currentIndex = blockSize;
+        }
     private:
         T* currentBlock = nullptr;
         std::size_t currentIndex = 1;
         std::size_t blockSize = 1;
+        std::size_t nextBlock = 0;
         std::vector<T*> allocations;
         Alloc alloc;
         typedef typename std::allocator_traits<Alloc> alloc_traits;
@@ -135,6 +160,14 @@ template <typename N> template <typename T>
 void Earcut<N>::operator()(T const * points, size_t len) {
     // reset
     indices.clear();
+    indices.reserve(2 * len);
+    (*this)(points, len, indices);
+    nodes.clear();
+}
+
+template <typename N> template <typename T>
+void Earcut<N>::operator()(T const * points, size_t len, std::vector<N>& out_) {
+    out = &out_;
     vertices = 0;
 
     if (len == 0) return;
@@ -143,9 +176,8 @@ void Earcut<N>::operator()(T const * points, size_t len) {
     double y;
     int threshold = 80 - static_cast<int>(len);
 
-    //estimate size of nodes and indices
-    nodes.reset(len * 3 / 2);
-    indices.reserve(2 * len);
+    //estimate size of nodes
+    nodes.rewind(len * 3 / 2);
 
     Node* outerNode = linkedList(points, len, true);
     if (!outerNode || outerNode->prev == outerNode->next) return;
@@ -172,8 +204,6 @@ void Earcut<N>::operator()(T const * points, size_t len) {
     }
 
     earcutLinked(outerNode);
-
-    nodes.clear();
 }
 
 // create a circular doubly linked list from polygon points in the specified winding order
@@ -260,9 +290,9 @@ void Earcut<N>::earcutLinked(Node* ear, int pass) {
 
         if (hashing ? isEarHashed(ear) : isEar(ear)) {
             // cut off the triangle
-            indices.emplace_back(prev->i);
-            indices.emplace_back(ear->i);
-            indices.emplace_back(next->i);
+            out->emplace_back(prev->i);
+            out->emplace_back(ear->i);
+            out->emplace_back(next->i);
 
             removeNode(ear);
 
@@ -366,9 +396,9 @@ Earcut<N>::cureLocalIntersections(Node* start) {
 
         // a self-intersection where edge (v[i-1],v[i]) intersects (v[i+1],v[i+2])
         if (!equals(a, b) && intersects(a, p, p->next, b) && locallyInside(a, b) && locallyInside(b, a)) {
-            indices.emplace_back(a->i);
-            indices.emplace_back(p->i);
-            indices.emplace_back(b->i);
+            out->emplace_back(a->i);
+            out->emplace_back(p->i);
+            out->emplace_back(b->i);
 
             // remove two nodes involved
             removeNode(p);
@@ -12,9 +12,60 @@
 
     #include <cstddef>
     #include <emscripten/bind.h>
+    #include <emscripten/val.h>
+    #include <vector>
 
 namespace odr
 {
+namespace
+{
+// Views of a mesh's buffers in the WASM heap, with nothing copied. A view
+// is only valid until the mesh changes or is deleted, and until the heap
+// grows, so copy it (new Float64Array(view)) if it must outlive either.
+emscripten::val vertices_view(const Mesh3D& mesh)
+{
+    return emscripten::val(emscripten::typed_memory_view(3 * mesh.vertices.size(), mesh.vertices.empty() ? nullptr : mesh.vertices[0].data()));
+}
+
+emscripten::val normals_view(const Mesh3D& mesh)
+{
+    return emscripten::val(emscripten::typed_memory_view(3 * mesh.normals.size(), mesh.normals.empty() ? nullptr : mesh.normals[0].data()));
+}
+
+emscripten::val st_coordinates_view(const Mesh3D& mesh)
+{
+    return emscripten::val(
+        emscripten::typed_memory_view(2 * mesh.st_coordinates.size(), mesh.st_coordinates.empty() ? nullptr : mesh.st_coordinates[0].data()));
+}
+
+emscripten::val indices_view(const Mesh3D& mesh) { return emscripten::val(emscripten::typed_memory_view(mesh.indices.size(), mesh.indices.data())); }
+
+// The vertices as a Float32Array of its own, x y z, less origin so that
+// float keeps the precision map coordinates need
+emscripten::val vertices_f32(const Mesh3D& mesh, double origin_x, double origin_y, double origin_z)
+{
+    std::vector<float> flat(3 * mesh.vertices.size());
+    for (std::size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        flat[3 * i] = static_cast<float>(mesh.vertices[i][0] - origin_x);
+        flat[3 * i + 1] = static_cast<float>(mesh.vertices[i][1] - origin_y);
+        flat[3 * i + 2] = static_cast<float>(mesh.vertices[i][2] - origin_z);
+    }
+    return emscripten::val::global("Float32Array").new_(emscripten::typed_memory_view(flat.size(), flat.data()));
+}
+
+emscripten::val normals_f32(const Mesh3D& mesh)
+{
+    std::vector<float> flat(3 * mesh.normals.size());
+    for (std::size_t i = 0; i < mesh.normals.size(); i++)
+    {
+        for (std::size_t dim = 0; dim < 3; dim++)
+            flat[3 * i + dim] = static_cast<float>(mesh.normals[i][dim]);
+    }
+    return emscripten::val::global("Float32Array").new_(emscripten::typed_memory_view(flat.size(), flat.data()));
+}
+} // namespace
+
 EMSCRIPTEN_BINDINGS(OpenDriveMap)
 {
     /* arrays */
@@ -47,6 +98,12 @@ EMSCRIPTEN_BINDINGS(OpenDriveMap)
     /* classes */
     emscripten::class_<Mesh3D>("Mesh3D")
         .function("get_obj", &Mesh3D::get_obj)
+        .function("vertices_view", &vertices_view)
+        .function("normals_view", &normals_view)
+        .function("st_coordinates_view", &st_coordinates_view)
+        .function("indices_view", &indices_view)
+        .function("vertices_f32", &vertices_f32)
+        .function("normals_f32", &normals_f32)
         .property("vertices", &Mesh3D::vertices)
         .property("indices", &Mesh3D::indices)
         .property("normals", &Mesh3D::normals)
@@ -28,16 +28,41 @@ Vec2D Arc::get_grad(double s) const
     return {{dx, dy}};
 }
 
+void Arc::get_xy(const double* s, std::size_t count, Vec2D* out) const
+{
+    const double r = 1 / curvature;
+    const double sin_hdg = std::sin(hdg0);
+    const double cos_hdg = std::cos(hdg0);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const double angle_at_s = (s[i] - s0) * curvature - M_PI / 2;
+        out[i] = Vec2D{r * (std::cos(hdg0 + angle_at_s) - sin_hdg) + x0, r * (std::sin(hdg0 + angle_at_s) + cos_hdg) + y0};
+    }
+}
+
+void Arc::get_grad(const double* s, std::size_t count, Vec2D* out) const
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const double angle = (M_PI / 2) - curvature * (s[i] - s0) - hdg0;
+        out[i] = Vec2D{std::sin(angle), std::cos(angle)};
+    }
+}
+
 std::set<double> Arc::approximate_linear(double eps) const
+{
+    std::vector<double> s_vals;
+    this->approximate_linear(eps, s_vals);
+    return std::set<double>(s_vals.begin(), s_vals.end());
+}
+
+void Arc::approximate_linear(double eps, std::vector<double>& s_vals) const
 {
     // TODO: properly implement
-    const double     s_step = 0.01 / std::abs(this->curvature); // sample at approx. every 1°
-    std::set<double> s_vals;
+    const double s_step = 0.01 / std::abs(this->curvature); // sample at approx. every 1°
     for (double s = s0; s < (s0 + length); s += s_step)
-        s_vals.insert(s);
-    s_vals.insert(s0 + length);
-
-    return s_vals;
+        s_vals.push_back(s);
+    s_vals.push_back(s0 + length);
 }
 
 } // namespace odr
@@ -1,7 +1,6 @@
 #include "Geometries/CubicSpline.h"
 #include "CubicBezier.hpp"
 #include "Math.hpp"
-#include "Utils.hpp"
 
 #include <algorithm>
 #include <array>
@@ -48,14 +47,25 @@ double Poly3::get_max(double s_start, double s_end) const
 }
 
 std::set<double> Poly3::approximate_linear(double eps, double s_start, double s_end) const
+{
+    std::vector<double> s_vals;
+    this->approximate_linear(eps, s_start, s_end, s_vals);
+    return std::set<double>(s_vals.begin(), s_vals.end());
+}
+
+void Poly3::approximate_linear(double eps, double s_start, double s_end, std::vector<double>& s_vals) const
 {
     if (s_start == s_end)
-        return {};
+        return;
 
     if (d == 0 && c == 0)
-        return {s_start, s_end};
+    {
+        s_vals.push_back(s_start);
+        s_vals.push_back(s_end);
+        return;
+    }
 
-    std::vector<double> s_vals;
+    const std::size_t first = s_vals.size();
     if (d == 0 && c != 0)
     {
         double s = s_start;
@@ -77,20 +87,18 @@ std::set<double> Poly3::approximate_linear(double eps, double s_start, double s_
         const double a_p = d * s_0 * s_0 * s_0 + c * s_0 * s_0 + b * s_0 + a;
 
         const std::array<Vec1D, 4> coefficients = {{{a_p}, {b_p}, {c_p}, {d_p}}};
-        const std::set<double>     p_vals = CubicBezier1D(CubicBezier1D::get_control_points(coefficients)).approximate_linear(eps);
 
         s_vals.push_back(s_start);
-        for (const double& p : p_vals)
-            s_vals.push_back(p * (s_end - s_start) + s_start);
+        const std::size_t p_first = s_vals.size();
+        CubicBezier1D(CubicBezier1D::get_control_points(coefficients)).approximate_linear(eps, s_vals);
+        for (std::size_t idx = p_first; idx < s_vals.size(); idx++)
+            s_vals[idx] = s_vals[idx] * (s_end - s_start) + s_start;
     }
 
-    if ((s_end - s_vals.back()) < 1e-9 && (s_vals.size() != 1))
+    if ((s_end - s_vals.back()) < 1e-9 && (s_vals.size() - first != 1))
         s_vals.back() = s_end;
     else
         s_vals.push_back(s_end);
-
-    std::set<double> s_vals_set(s_vals.begin(), s_vals.end());
-    return s_vals_set;
 }
 
 void Poly3::negate()
@@ -103,9 +111,45 @@ void Poly3::negate()
 
 bool Poly3::isnan() const { return (std::isnan(this->a) || std::isnan(this->b) || std::isnan(this->c) || std::isnan(this->d)); }
 
-bool CubicSpline::empty() const { return this->s0_to_poly.empty(); }
+bool CubicSpline::empty() const { return this->s0_vals.empty(); }
+
+std::size_t CubicSpline::size() const { return this->s0_vals.size(); }
 
-std::size_t CubicSpline::size() const { return this->s0_to_poly.size(); }
+std::size_t CubicSpline::find_poly(double s) const
+{
+    // Halves the range without branching on the comparison. !(s < s0)
+    // rather than s0 <= s puts NaN last, as std::upper_bound would.
+    const double* base = this->s0_vals.data();
+    std::size_t   n = this->s0_vals.size();
+    while (n > 1)
+    {
+        const std::size_t half = n / 2;
+        base = (s < base[half]) ? base : base + half;
+        n -= half;
+    }
+    return static_cast<std::size_t>(base - this->s0_vals.data());
+}
+
+void CubicSpline::insert(double s0, const Poly3& poly)
+{
+    // Polys are parsed in order, so this almost always appends
+    if (this->s0_vals.empty() || this->s0_vals.back() < s0)
+    {
+        this->s0_vals.push_back(s0);
+        this->polys.push_back(poly);
+        return;
+    }
+
+    const auto        s0_iter = std::lower_bound(this->s0_vals.begin(), this->s0_vals.end(), s0);
+    const std::size_t idx = static_cast<std::size_t>(s0_iter - this->s0_vals.begin());
+    if (*s0_iter == s0)
+    {
+        this->polys[idx] = poly;
+        return;
+    }
+    this->s0_vals.insert(s0_iter, s0);
+    this->polys.insert(this->polys.begin() + idx, poly);
+}
 
 double CubicSpline::get(double s, double default_val, bool extend_start) const
 {
@@ -123,34 +167,51 @@ double CubicSpline::get_grad(double s, double default_val, bool extend_start) co
     return poly.get_grad(s);
 }
 
+void CubicSpline::get(const double* s, std::size_t count, double* out, double default_val, bool extend_start) const
+{
+    Cursor cursor(*this);
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = cursor.get(s[i], default_val, extend_start);
+}
+
 CubicSpline CubicSpline::negate() const
 {
     CubicSpline negated = *this;
-    for (auto& s0_poly : negated.s0_to_poly)
-        s0_poly.second.negate();
+    for (Poly3& poly : negated.polys)
+        poly.negate();
     return negated;
 }
 
 CubicSpline CubicSpline::add(const CubicSpline& other) const
 {
-    if (other.s0_to_poly.empty())
+    if (other.empty())
         return *this;
-    if (this->s0_to_poly.empty())
+    if (this->empty())
         return other;
 
-    std::set<double> s0_vals = get_map_keys(this->s0_to_poly);
-    std::set<double> other_s0s = get_map_keys(other.s0_to_poly);
-    s0_vals.insert(other_s0s.begin(), other_s0s.end());
+    const Poly3 none(NAN, NAN, NAN, NAN, NAN);
 
+    // Merge both sets of s0s. At each, a spline's poly is the last of its
+    // own that was consumed, or none if it has not started yet.
     CubicSpline retval;
-    for (const double& s0 : s0_vals)
+    retval.s0_vals.reserve(this->size() + other.size());
+    retval.polys.reserve(this->size() + other.size());
+    std::size_t i = 0, j = 0;
+    while (i < this->size() || j < other.size())
     {
-        const Poly3& this_poly = this->get_poly(s0, false);
-        const Poly3& other_poly = other.get_poly(s0, false);
+        const bool   take_this = j == other.size() || (i < this->size() && !(other.s0_vals[j] < this->s0_vals[i]));
+        const bool   take_other = i == this->size() || (j < other.size() && !(this->s0_vals[i] < other.s0_vals[j]));
+        const double s0 = take_this ? this->s0_vals[i] : other.s0_vals[j];
+        i += take_this;
+        j += take_other;
+
+        const Poly3& this_poly = (i > 0) ? this->polys[i - 1] : none;
+        const Poly3& other_poly = (j > 0) ? other.polys[j - 1] : none;
 
+        retval.s0_vals.push_back(s0);
         if (this_poly.isnan() || other_poly.isnan()) // can't be both NAN
         {
-            retval.s0_to_poly[s0] = this_poly.isnan() ? other_poly : this_poly;
+            retval.polys.push_back(this_poly.isnan() ? other_poly : this_poly);
             continue;
         }
 
@@ -159,42 +220,37 @@ CubicSpline CubicSpline::add(const CubicSpline& other) const
         res.b = this_poly.b + other_poly.b;
         res.c = this_poly.c + other_poly.c;
         res.d = this_poly.d + other_poly.d;
-        retval.s0_to_poly[s0] = res;
+        retval.polys.push_back(res);
     }
     return retval;
 }
 
 Poly3 CubicSpline::get_poly(double s, bool extend_start) const
 {
-    if (this->s0_to_poly.empty())
+    if (this->s0_vals.empty())
         return Poly3(NAN, NAN, NAN, NAN, NAN);
 
-    if ((extend_start == false) && (s < this->s0_to_poly.begin()->first))
+    if ((extend_start == false) && (s < this->s0_vals.front()))
         return Poly3(NAN, NAN, NAN, NAN, NAN);
 
     // will return first poly if s < s_start and last poly for s > s_end
-    auto target_poly_iter = this->s0_to_poly.upper_bound(s);
-    if (target_poly_iter != this->s0_to_poly.begin())
-        target_poly_iter--;
-    return target_poly_iter->second;
+    return this->polys[this->find_poly(s)];
 }
 
 double CubicSpline::get_max(double s_start, double s_end) const
 {
-    if ((s_start == s_end) || this->s0_to_poly.empty())
+    if ((s_start == s_end) || this->s0_vals.empty())
         return 0;
 
-    auto s_end_poly_iter = this->s0_to_poly.lower_bound(s_end);
-    auto s_start_poly_iter = this->s0_to_poly.upper_bound(s_start);
-    if (s_start_poly_iter != this->s0_to_poly.begin())
-        s_start_poly_iter--;
+    const std::size_t idx_end = std::lower_bound(this->s0_vals.begin(), this->s0_vals.end(), s_end) - this->s0_vals.begin();
+    const std::size_t idx_start = this->find_poly(s_start);
 
     std::vector<double> max_poly_vals;
-    for (auto s_poly_iter = s_start_poly_iter; s_poly_iter != s_end_poly_iter; s_poly_iter++)
+    for (std::size_t idx = idx_start; idx < idx_end; idx++)
     {
-        const double s_start_poly = std::max(s_poly_iter->first, s_start);
-        const double s_end_poly = (std::next(s_poly_iter) == s_end_poly_iter) ? s_end : std::min(std::next(s_poly_iter)->first, s_end);
-        max_poly_vals.push_back(s_poly_iter->second.get_max(s_start_poly, s_end_poly));
+        const double s_start_poly = std::max(this->s0_vals[idx], s_start);
+        const double s_end_poly = (idx + 1 == idx_end) ? s_end : std::min(this->s0_vals[idx + 1], s_end);
+        max_poly_vals.push_back(this->polys[idx].get_max(s_start_poly, s_end_poly));
     }
 
     const auto   max_iter = std::max_element(max_poly_vals.begin(), max_poly_vals.end());
@@ -204,32 +260,70 @@ double CubicSpline::get_max(double s_start, double s_end) const
 
 std::set<double> CubicSpline::approximate_linear(double eps, double s_start, double s_end) const
 {
-    if ((s_start == s_end) || this->s0_to_poly.empty())
-        return {};
+    std::vector<double> s_vals;
+    this->approximate_linear(eps, s_start, s_end, s_vals);
+    return std::set<double>(s_vals.begin(), s_vals.end());
+}
 
-    auto s_end_poly_iter = this->s0_to_poly.lower_bound(s_end);
-    auto s_start_poly_iter = this->s0_to_poly.upper_bound(s_start);
-    if (s_start_poly_iter != this->s0_to_poly.begin())
-        s_start_poly_iter--;
+void CubicSpline::approximate_linear(double eps, double s_start, double s_end, std::vector<double>& s_vals) const
+{
+    if ((s_start == s_end) || this->s0_vals.empty())
+        return;
 
-    std::set<double> s_vals;
-    for (auto s_poly_iter = s_start_poly_iter; s_poly_iter != s_end_poly_iter; s_poly_iter++)
+    const std::size_t idx_end = std::lower_bound(this->s0_vals.begin(), this->s0_vals.end(), s_end) - this->s0_vals.begin();
+    const std::size_t idx_start = this->find_poly(s_start);
+
+    for (std::size_t idx = idx_start; idx < idx_end; idx++)
     {
-        const double s_start_poly = std::max(s_poly_iter->first, s_start);
-        const double s_end_poly = (std::next(s_poly_iter) == s_end_poly_iter) ? s_end : std::min(std::next(s_poly_iter)->first, s_end);
+        const double s_start_poly = std::max(this->s0_vals[idx], s_start);
+        const double s_end_poly = (idx + 1 == idx_end) ? s_end : std::min(this->s0_vals[idx + 1], s_end);
 
-        std::set<double> s_vals_poly = s_poly_iter->second.approximate_linear(eps, s_start_poly, s_end_poly);
-        if (s_vals_poly.size() < 2)
+        const std::size_t first = s_vals.size();
+        this->polys[idx].approximate_linear(eps, s_start_poly, s_end_poly, s_vals);
+        if (s_vals.size() - first < 2)
         {
-            std::string err_msg = std::string("expected at least two sample points, got ") + std::to_string(s_vals_poly.size()) +
+            std::string err_msg = std::string("expected at least two sample points, got ") + std::to_string(s_vals.size() - first) +
                                   std::string(" for [") + std::to_string(s_start_poly) + ' ' + std::to_string(s_end_poly) + ']';
             throw std::runtime_error(err_msg);
         }
-
-        s_vals.insert(s_vals_poly.begin(), s_vals_poly.end());
     }
+}
+
+const Poly3* CubicSpline::Cursor::seek(double s, bool extend_start)
+{
+    const std::vector<double>& s0 = this->spline.s0_vals;
+    const std::size_t          n = s0.size();
+    if (n == 0 || (!extend_start && s < s0.front()))
+        return nullptr;
+
+    // Still in the current poly, or stepped into a neighbour of it
+    const bool after_start = this->idx == 0 || !(s < s0[this->idx]);
+    const bool before_next = this->idx + 1 == n || s < s0[this->idx + 1];
+    if (after_start && before_next)
+        return &this->spline.polys[this->idx];
+    if (after_start && (this->idx + 2 >= n || s < s0[this->idx + 2]))
+        return &this->spline.polys[++this->idx];
+    if (before_next && (this->idx == 1 || !(s < s0[this->idx - 1])))
+        return &this->spline.polys[--this->idx];
+
+    this->idx = this->spline.find_poly(s);
+    return &this->spline.polys[this->idx];
+}
+
+double CubicSpline::Cursor::get(double s, double default_val, bool extend_start)
+{
+    const Poly3* poly = this->seek(s, extend_start);
+    if (!poly || poly->isnan())
+        return default_val;
+    return poly->get(s);
+}
 
-    return s_vals;
+double CubicSpline::Cursor::get_grad(double s, double default_val, bool extend_start)
+{
+    const Poly3* poly = this->seek(s, extend_start);
+    if (!poly || poly->isnan())
+        return default_val;
+    return poly->get_grad(s);
 }
 
 } // namespace odr
@@ -20,6 +20,27 @@ Vec2D Line::get_xy(double s) const
 
 Vec2D Line::get_grad(double s) const { return {{std::cos(hdg0), std::sin(hdg0)}}; }
 
+void Line::get_xy(const double* s, std::size_t count, Vec2D* out) const
+{
+    const double cos_hdg = std::cos(hdg0);
+    const double sin_hdg = std::sin(hdg0);
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = Vec2D{(cos_hdg * (s[i] - s0)) + x0, (sin_hdg * (s[i] - s0)) + y0};
+}
+
+void Line::get_grad(const double* s, std::size_t count, Vec2D* out) const
+{
+    const Vec2D grad{std::cos(hdg0), std::sin(hdg0)};
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = grad;
+}
+
 std::set<double> Line::approximate_linear(double eps) const { return {s0, s0 + length}; }
 
+void Line::approximate_linear(double eps, std::vector<double>& s_vals) const
+{
+    s_vals.push_back(s0);
+    s_vals.push_back(s0 + length);
+}
+
 } // namespace odr
@@ -69,15 +69,43 @@ Vec2D ParamPoly3::get_grad(double s) const
     return {{dx, dy}};
 }
 
-std::set<double> ParamPoly3::approximate_linear(double eps) const
+void ParamPoly3::get_xy(const double* s, std::size_t count, Vec2D* out) const
 {
-    std::set<double> p_vals = this->cubic_bezier.approximate_linear(eps);
+    const double cos_hdg = std::cos(hdg0);
+    const double sin_hdg = std::sin(hdg0);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const double p = this->cubic_bezier.get_t(s[i] - s0);
+        const Vec2D  pt = this->cubic_bezier.get(p);
+        out[i] = Vec2D{(cos_hdg * pt[0]) - (sin_hdg * pt[1]) + x0, (sin_hdg * pt[0]) + (cos_hdg * pt[1]) + y0};
+    }
+}
 
-    std::set<double> s_vals;
-    for (const double& p : p_vals)
-        s_vals.insert(p * length + s0);
+void ParamPoly3::get_grad(const double* s, std::size_t count, Vec2D* out) const
+{
+    const double h1 = std::cos(hdg0);
+    const double h2 = std::sin(hdg0);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const double p = this->cubic_bezier.get_t(s[i] - s0);
+        const Vec2D  dxy = this->cubic_bezier.get_grad(p);
+        out[i] = Vec2D{h1 * dxy[0] - h2 * dxy[1], h2 * dxy[0] + h1 * dxy[1]};
+    }
+}
 
-    return s_vals;
+std::set<double> ParamPoly3::approximate_linear(double eps) const
+{
+    std::vector<double> s_vals;
+    this->approximate_linear(eps, s_vals);
+    return std::set<double>(s_vals.begin(), s_vals.end());
+}
+
+void ParamPoly3::approximate_linear(double eps, std::vector<double>& s_vals) const
+{
+    const std::size_t first = s_vals.size();
+    this->cubic_bezier.approximate_linear(eps, s_vals);
+    for (std::size_t idx = first; idx < s_vals.size(); idx++)
+        s_vals[idx] = s_vals[idx] * length + s0;
 }
 
 } // namespace odr
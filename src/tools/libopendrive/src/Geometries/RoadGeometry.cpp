@@ -8,4 +8,22 @@ RoadGeometry::RoadGeometry(double s0, double x0, double y0, double hdg0, double
 {
 }
 
+void RoadGeometry::get_xy(const double* s, std::size_t count, Vec2D* out) const
+{
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = this->get_xy(s[i]);
+}
+
+void RoadGeometry::get_grad(const double* s, std::size_t count, Vec2D* out) const
+{
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = this->get_grad(s[i]);
+}
+
+void RoadGeometry::approximate_linear(double eps, std::vector<double>& s_vals) const
+{
+    const std::set<double> s_set = this->approximate_linear(eps);
+    s_vals.insert(s_vals.end(), s_set.begin(), s_set.end());
+}
+
 } // namespace odr
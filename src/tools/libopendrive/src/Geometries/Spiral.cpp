@@ -3,11 +3,41 @@
 #include "Geometries/Spiral/odrSpiral.h"
 #include "Math.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 namespace odr
 {
 
+namespace
+{
+// Largest heading change, in radians, between a table node and a point it
+// serves
+constexpr double MAX_NODE_ANGLE = 0.05;
+constexpr double MAX_HALF_STEP = 1.0;
+// Target for the leading quadrature error term, in meters
+constexpr double MAX_NODE_ERROR = 1e-9;
+
+// Leading error term of two-point Gauss-Legendre over r for a heading that
+// turns at up to curv and whose curvature changes at c_dot: r^5 / 4320
+// times a bound on the fourth derivative of (cos, sin)(phi)
+inline double gauss2_error(const double r, const double curv, const double c_dot)
+{
+    const double phi_1 = curv + c_dot * r;
+    return std::pow(r, 5) / 4320 * (std::pow(phi_1, 4) + 6 * phi_1 * phi_1 * c_dot + 3 * c_dot * c_dot);
+}
+
+// cos and sin of a, for |a| <= MAX_NODE_ANGLE, by Taylor series. The first
+// omitted terms are below 1e-11.
+inline Vec2D expi(const double a)
+{
+    const double a2 = a * a;
+    const double c = 1 + a2 * (-1.0 / 2 + a2 * (1.0 / 24 + a2 * (-1.0 / 720)));
+    const double s = a * (1 + a2 * (-1.0 / 6 + a2 * (1.0 / 120)));
+    return Vec2D{c, s};
+}
+} // namespace
+
 Spiral::Spiral(double s0, double x0, double y0, double hdg0, double length, double curv_start, double curv_end) :
     RoadGeometry(s0, x0, y0, hdg0, length, GeometryType_Spiral), curv_start(curv_start), curv_end(curv_end)
 {
@@ -16,11 +46,30 @@ Spiral::Spiral(double s0, double x0, double y0, double hdg0, double length, doub
     this->s_end = curv_end / c_dot;
     s0_spiral = curv_start / c_dot;
     odrSpiral(s0_spiral, c_dot, &x0_spiral, &y0_spiral, &a0_spiral);
+
+    // Half a step may turn the heading by curv * r + c_dot / 2 * r^2, which
+    // for r <= 1 is at most (curv + |c_dot|) * r. Steps are then shortened
+    // until the quadrature error is small enough too.
+    const double curv_max = std::max(std::abs(curv_start), std::abs(curv_end));
+    double       half_step = std::min(MAX_HALF_STEP, MAX_NODE_ANGLE / (curv_max + std::abs(c_dot)));
+    while (gauss2_error(half_step, curv_max, std::abs(c_dot)) > MAX_NODE_ERROR)
+        half_step *= 0.8;
+    const std::size_t steps = std::max<std::size_t>(1, std::size_t(std::ceil(length / (2 * half_step))));
+    this->table_step = length / steps;
+    this->inv_table_step = steps / length;
+    this->table.reserve(steps + 1);
+    for (std::size_t k = 0; k <= steps; k++)
+    {
+        const double s = s0 + k * this->table_step;
+        const Vec2D  pt = this->get_xy_exact(s);
+        const Vec2D  grad = this->get_grad_exact(s);
+        this->table.push_back({pt[0], pt[1], grad[0], grad[1], curv_start + c_dot * (s - s0)});
+    }
 }
 
 std::unique_ptr<RoadGeometry> Spiral::clone() const { return std::make_unique<Spiral>(*this); }
 
-Vec2D Spiral::get_xy(double s) const
+Vec2D Spiral::get_xy_exact(double s) const
 {
     double xs_spiral, ys_spiral, as_spiral;
     odrSpiral(s - s0 + s0_spiral, c_dot, &xs_spiral, &ys_spiral, &as_spiral);
@@ -31,7 +80,7 @@ Vec2D Spiral::get_xy(double s) const
     return Vec2D{xt, yt};
 }
 
-Vec2D Spiral::get_grad(double s) const
+Vec2D Spiral::get_grad_exact(double s) const
 {
     double xs_spiral, ys_spiral, as_spiral;
     odrSpiral(s - s0 + s0_spiral, c_dot, &xs_spiral, &ys_spiral, &as_spiral);
@@ -41,15 +90,69 @@ Vec2D Spiral::get_grad(double s) const
     return {{dx, dy}};
 }
 
+const Spiral::Node& Spiral::nearest_node(double s, double& ds) const
+{
+    const double      u = s - s0;
+    const double      k_real = u * this->inv_table_step + 0.5;
+    const std::size_t k = k_real <= 0 ? 0 : std::min(this->table.size() - 1, std::size_t(k_real));
+    ds = u - k * this->table_step;
+    return this->table[k];
+}
+
+Vec2D Spiral::get_xy(double s) const
+{
+    // From the node, the heading turns by phi(u) = curv * u + c_dot / 2 * u^2.
+    // The offset is the integral of (cos, sin)(phi) over [0, ds], by
+    // two-point Gauss-Legendre.
+    double      ds = 0;
+    const Node& node = this->nearest_node(s, ds);
+    if (std::abs(ds) > this->table_step) // Past either end
+        return this->get_xy_exact(s);
+    const double half = ds / 2;
+    const double u_a = half * (1 - 0.5773502691896258); // 1 / sqrt(3)
+    const double u_b = half * (1 + 0.5773502691896258);
+    const Vec2D  e_a = expi(u_a * (node.curv + c_dot / 2 * u_a));
+    const Vec2D  e_b = expi(u_b * (node.curv + c_dot / 2 * u_b));
+    const double re = half * (e_a[0] + e_b[0]);
+    const double im = half * (e_a[1] + e_b[1]);
+    return Vec2D{node.x + node.cos_hdg * re - node.sin_hdg * im, node.y + node.sin_hdg * re + node.cos_hdg * im};
+}
+
+Vec2D Spiral::get_grad(double s) const
+{
+    double       ds = 0;
+    const Node&  node = this->nearest_node(s, ds);
+    if (std::abs(ds) > this->table_step)
+        return this->get_grad_exact(s);
+    const Vec2D  e = expi(ds * (node.curv + c_dot / 2 * ds));
+    return Vec2D{node.cos_hdg * e[0] - node.sin_hdg * e[1], node.sin_hdg * e[0] + node.cos_hdg * e[1]};
+}
+
+void Spiral::get_xy(const double* s, std::size_t count, Vec2D* out) const
+{
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = this->get_xy(s[i]);
+}
+
+void Spiral::get_grad(const double* s, std::size_t count, Vec2D* out) const
+{
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = this->get_grad(s[i]);
+}
+
 std::set<double> Spiral::approximate_linear(double eps) const
+{
+    std::vector<double> s_vals;
+    this->approximate_linear(eps, s_vals);
+    return std::set<double>(s_vals.begin(), s_vals.end());
+}
+
+void Spiral::approximate_linear(double eps, std::vector<double>& s_vals) const
 {
     // TODO: properly implement
-    std::set<double> s_vals;
     for (double s = s0; s < (s0 + length); s += (10 * eps))
-        s_vals.insert(s);
-    s_vals.insert(s0 + length);
-
-    return s_vals;
+        s_vals.push_back(s);
+    s_vals.push_back(s0 + length);
 }
 
 } // namespace odr
@@ -23,74 +23,28 @@ std::vector<RoadMark> Lane::get_roadmarks(const double s_start, const double s_e
     if ((s_start == s_end) || this->roadmark_groups.empty())
         return {};
 
-    auto s_start_rm_iter =
-        std::upper_bound(this->roadmark_groups.begin(),
-                         this->roadmark_groups.end(),
-                         s_start,
-                         [](const double& s, const RoadMarkGroup& rmg) -> bool { return s < (rmg.lanesection_s0 + rmg.s_offset); });
-    if (s_start_rm_iter != this->roadmark_groups.begin())
-        s_start_rm_iter--;
-
-    auto s_end_rm_iter = std::lower_bound(this->roadmark_groups.begin(),
-                                          this->roadmark_groups.end(),
-                                          s_end,
-                                          [](const RoadMarkGroup& rmg, const double& s) -> bool { return (rmg.lanesection_s0 + rmg.s_offset) < s; });
+    // Lanes put together by hand have no table; work one out for the range
+    RoadMarkTable range_table;
+    const bool           has_table = !this->roadmark_table.marks.empty();
+    if (!has_table)
+        range_table.build(this->roadmark_groups, s_start, s_end);
+    const RoadMarkTable& table = has_table ? this->roadmark_table : range_table;
 
     std::vector<RoadMark> roadmarks;
-    for (auto rm_group_iter = s_start_rm_iter; rm_group_iter != s_end_rm_iter; rm_group_iter++)
-    {
-        const RoadMarkGroup& roadmark_group = *rm_group_iter;
-
-        const double roadmark_group_s0 = roadmark_group.lanesection_s0 + roadmark_group.s_offset;
-        const double s_start_roadmark_group = std::max(roadmark_group_s0, s_start);
-        const double s_end_roadmark_group = (std::next(rm_group_iter) == s_end_rm_iter)
-                                                ? s_end
-                                                : std::min(std::next(rm_group_iter)->lanesection_s0 + std::next(rm_group_iter)->s_offset, s_end);
-
-        double width = roadmark_group.weight == "bold" ? ROADMARK_WEIGHT_BOLD_WIDTH : ROADMARK_WEIGHT_STANDARD_WIDTH;
-        if (roadmark_group.roadmark_lines.empty())
-        {
-            if (roadmark_group.width > 0)
-                width = roadmark_group.width;
-
-            roadmarks.push_back(RoadMark(this->key.road_id,
-                                         this->key.lanesection_s0,
-                                         this->id,
-                                         roadmark_group_s0,
-                                         s_start_roadmark_group,
-                                         s_end_roadmark_group,
-                                         0,
-                                         width,
-                                         roadmark_group.type));
-        }
-        else
-        {
-            for (const RoadMarksLine& roadmarks_line : roadmark_group.roadmark_lines)
-            {
-                if (roadmarks_line.width > 0)
-                    width = roadmarks_line.width;
-
-                if ((roadmarks_line.length + roadmarks_line.space) == 0)
-                    continue;
-
-                const double s0_roadmarks_line = roadmarks_line.group_s0 + roadmarks_line.s_offset;
-                for (double s_start_single_roadmark = s0_roadmarks_line; s_start_single_roadmark < s_end_roadmark_group;
-                     s_start_single_roadmark += (roadmarks_line.length + roadmarks_line.space))
-                {
-                    const double s_end_single_roadmark = std::min(s_end, s_start_single_roadmark + roadmarks_line.length);
-                    roadmarks.push_back(RoadMark(this->key.road_id,
-                                                 this->key.lanesection_s0,
-                                                 this->id,
-                                                 roadmarks_line.group_s0,
-                                                 s_start_single_roadmark,
-                                                 s_end_single_roadmark,
-                                                 roadmarks_line.t_offset,
-                                                 width,
-                                                 roadmark_group.type + roadmarks_line.name));
-                }
-            }
-        }
-    }
+    table.for_each(s_start,
+                   s_end,
+                   [&](const RoadMarkTable::Mark& mark)
+                   {
+                       roadmarks.push_back(RoadMark(this->key.road_id,
+                                                    this->key.lanesection_s0,
+                                                    this->id,
+                                                    mark.group_s0,
+                                                    std::max(mark.s_start, s_start),
+                                                    std::min(mark.s_end, s_end),
+                                                    mark.t_offset,
+                                                    mark.width,
+                                                    table.type(mark)));
+                   });
 
     return roadmarks;
 }
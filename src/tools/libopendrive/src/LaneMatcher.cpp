@@ -0,0 +1,257 @@
+#include "LaneMatcher.h"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace odr
+{
+
+namespace
+{
+// Distance from p to segment ab
+double segment_distance(const Vec2D& p, const Vec2D& a, const Vec2D& b)
+{
+    const Vec2D  ab{b[0] - a[0], b[1] - a[1]};
+    const double len2 = ab[0] * ab[0] + ab[1] * ab[1];
+    double       u = len2 > 0 ? ((p[0] - a[0]) * ab[0] + (p[1] - a[1]) * ab[1]) / len2 : 0.0;
+    u = std::min(1.0, std::max(0.0, u));
+    return euclDistance(p, Vec2D{a[0] + u * ab[0], a[1] + u * ab[1]});
+}
+
+// 0 inside the quad, by the even-odd rule, else the distance to its edges
+double quad_distance(const Vec2D& p, const Vec2D (&corners)[4])
+{
+    bool inside = false;
+    for (int i = 0, j = 3; i < 4; j = i++)
+    {
+        const Vec2D& a = corners[i];
+        const Vec2D& b = corners[j];
+        if ((a[1] > p[1]) != (b[1] > p[1]) && p[0] < (b[0] - a[0]) * (p[1] - a[1]) / (b[1] - a[1]) + a[0])
+            inside = !inside;
+    }
+    if (inside)
+        return 0.0;
+    double dist = INFINITY;
+    for (int i = 0, j = 3; i < 4; j = i++)
+        dist = std::min(dist, segment_distance(p, corners[j], corners[i]));
+    return dist;
+}
+
+double wrap_angle(double angle) { return std::remainder(angle, 2 * M_PI); }
+
+// Lanes with positive ids are driven against s
+double lane_direction(const Vec2D& along_s, int lane_id)
+{
+    const double heading = std::atan2(along_s[1], along_s[0]);
+    return lane_id > 0 ? heading + M_PI : heading;
+}
+
+constexpr uint32_t NO_PIECE = std::numeric_limits<uint32_t>::max();
+} // namespace
+
+LaneMatcher::LaneMatcher(const OpenDriveMap& map, bool drivable_only, double cell_size, double eps, double max_piece_length) :
+    map(map), cell_size(cell_size), eps(eps)
+{
+    std::vector<double> s_vals, s_brdr, t_brdr;
+    std::vector<Vec3D>  pts;
+    for (uint32_t road_index = 0; road_index < map.road_count(); road_index++)
+    {
+        if (!map.road_loaded(road_index))
+            continue;
+        const Road& road = map.road(road_index);
+        for (const LaneSection& lanesection : road.lanesections())
+        {
+            const double s_start = lanesection.s0;
+            const double s_end = road.get_lanesection_end(lanesection);
+            if (!(s_end > s_start))
+                continue;
+            for (const Lane& lane : lanesection.lanes())
+            {
+                if (lane.id == 0 || (drivable_only && lane.type != "driving"))
+                    continue;
+
+                road.approximate_lane_mesh_linear(lane, s_start, s_end, this->eps, s_vals);
+                s_vals.push_back(s_start);
+                s_vals.push_back(s_end);
+                sort_unique(s_vals);
+                // Short pieces keep the refined s near the piece's guess
+                s_brdr.clear();
+                for (std::size_t k = 0; k + 1 < s_vals.size(); k++)
+                {
+                    const int steps = std::max(1, int(std::ceil((s_vals[k + 1] - s_vals[k]) / max_piece_length)));
+                    for (int step = 0; step < steps; step++)
+                        s_brdr.push_back(s_vals[k] + (s_vals[k + 1] - s_vals[k]) * step / steps);
+                }
+                s_brdr.push_back(s_vals.back());
+
+                // The inner border, then the outer, in one batch
+                const std::size_t n = s_brdr.size();
+                s_brdr.resize(2 * n);
+                std::copy(s_brdr.begin(), s_brdr.begin() + n, s_brdr.begin() + n);
+                t_brdr.resize(2 * n);
+                lane.inner_border.get(s_brdr.data(), n, t_brdr.data());
+                lane.outer_border.get(s_brdr.data() + n, n, t_brdr.data() + n);
+                pts.resize(2 * n);
+                road.get_surface_pt(s_brdr.data(), t_brdr.data(), 2 * n, pts.data());
+
+                const uint32_t lane_index = uint32_t(this->lanes.size());
+                this->lanes.push_back(lane.key);
+                for (std::size_t k = 0; k + 1 < n; k++)
+                {
+                    Piece piece{lane_index, s_brdr[k], s_brdr[k + 1], {}};
+                    piece.corners[0] = {pts[k][0], pts[k][1]};
+                    piece.corners[1] = {pts[k + 1][0], pts[k + 1][1]};
+                    piece.corners[2] = {pts[n + k + 1][0], pts[n + k + 1][1]};
+                    piece.corners[3] = {pts[n + k][0], pts[n + k][1]};
+                    this->pieces.push_back(piece);
+                }
+            }
+        }
+    }
+
+    // Every cell a piece's box, grown by eps, touches lists it
+    std::vector<std::pair<uint64_t, uint32_t>> keyed;
+    for (uint32_t i = 0; i < this->pieces.size(); i++)
+    {
+        double x_min = INFINITY, y_min = INFINITY, x_max = -INFINITY, y_max = -INFINITY;
+        for (const Vec2D& corner : this->pieces[i].corners)
+        {
+            x_min = std::min(x_min, corner[0]);
+            y_min = std::min(y_min, corner[1]);
+            x_max = std::max(x_max, corner[0]);
+            y_max = std::max(y_max, corner[1]);
+        }
+        const int64_t ix_min = int64_t(std::floor((x_min - this->eps) / this->cell_size));
+        const int64_t ix_max = int64_t(std::floor((x_max + this->eps) / this->cell_size));
+        const int64_t iy_min = int64_t(std::floor((y_min - this->eps) / this->cell_size));
+        const int64_t iy_max = int64_t(std::floor((y_max + this->eps) / this->cell_size));
+        for (int64_t ix = ix_min; ix <= ix_max; ix++)
+            for (int64_t iy = iy_min; iy <= iy_max; iy++)
+                keyed.emplace_back((uint64_t(uint32_t(ix)) << 32) | uint32_t(iy), i);
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    this->cell_pieces.reserve(keyed.size());
+    this->cells.reserve(keyed.size() / 4);
+    for (std::size_t i = 0; i < keyed.size();)
+    {
+        const uint32_t begin = uint32_t(this->cell_pieces.size());
+        const uint64_t key = keyed[i].first;
+        for (; i < keyed.size() && keyed[i].first == key; i++)
+            this->cell_pieces.push_back(keyed[i].second);
+        this->cells.emplace(key, CellRange{begin, uint32_t(this->cell_pieces.size())});
+    }
+}
+
+uint64_t LaneMatcher::cell_key(double x, double y) const
+{
+    const int64_t ix = int64_t(std::floor(x / this->cell_size));
+    const int64_t iy = int64_t(std::floor(y / this->cell_size));
+    return (uint64_t(uint32_t(ix)) << 32) | uint32_t(iy);
+}
+
+const LaneMatcher::CellRange* LaneMatcher::find_cell(uint64_t key) const
+{
+    const auto cell = this->cells.find(key);
+    return cell == this->cells.end() ? nullptr : &cell->second;
+}
+
+LaneMatch LaneMatcher::match(double x, double y, double heading) const
+{
+    if (!std::isfinite(x) || !std::isfinite(y))
+        return LaneMatch{};
+    return this->match(x, y, heading, this->find_cell(this->cell_key(x, y)));
+}
+
+void LaneMatcher::match(const LanePose* poses, std::size_t count, LaneMatch* out) const
+{
+    uint64_t         last_key = 0;
+    const CellRange* last_cell = nullptr;
+    bool             looked_up = false;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const LanePose& pose = poses[i];
+        if (!std::isfinite(pose.x) || !std::isfinite(pose.y))
+        {
+            out[i] = LaneMatch{};
+            continue;
+        }
+        const uint64_t key = this->cell_key(pose.x, pose.y);
+        if (!looked_up || key != last_key)
+        {
+            last_cell = this->find_cell(key);
+            last_key = key;
+            looked_up = true;
+        }
+        out[i] = this->match(pose.x, pose.y, pose.heading, last_cell);
+    }
+}
+
+std::vector<LaneMatch> LaneMatcher::match(const std::vector<LanePose>& poses) const
+{
+    std::vector<LaneMatch> matches(poses.size());
+    this->match(poses.data(), poses.size(), matches.data());
+    return matches;
+}
+
+LaneMatch LaneMatcher::match(double x, double y, double heading, const CellRange* cell) const
+{
+    LaneMatch lane_match;
+    if (!cell)
+        return lane_match;
+    const Vec2D p{x, y};
+
+    // Pieces are ranked by how far outside them the pose is, then by the
+    // heading error along their midline, without touching the road. Only
+    // the winner is projected onto its reference line.
+    uint32_t best = NO_PIECE;
+    double   best_dist = INFINITY;
+    double   best_error = INFINITY;
+    double   best_u = 0;
+    for (uint32_t i = cell->first; i < cell->second; i++)
+    {
+        const Piece& piece = this->pieces[this->cell_pieces[i]];
+        const double dist = quad_distance(p, piece.corners);
+        if (dist > this->eps || dist > best_dist)
+            continue;
+
+        const Vec2D  start{0.5 * (piece.corners[0][0] + piece.corners[3][0]), 0.5 * (piece.corners[0][1] + piece.corners[3][1])};
+        const Vec2D  end{0.5 * (piece.corners[1][0] + piece.corners[2][0]), 0.5 * (piece.corners[1][1] + piece.corners[2][1])};
+        const Vec2D  along{end[0] - start[0], end[1] - start[1]};
+        const double error = std::abs(wrap_angle(heading - lane_direction(along, this->lanes[piece.lane].lane_id)));
+        if (dist == best_dist && error >= best_error)
+            continue;
+
+        const double len2 = along[0] * along[0] + along[1] * along[1];
+        const double u = len2 > 0 ? ((x - start[0]) * along[0] + (y - start[1]) * along[1]) / len2 : 0.0;
+        best = this->cell_pieces[i];
+        best_dist = dist;
+        best_error = error;
+        best_u = std::min(1.0, std::max(0.0, u));
+    }
+    if (best == NO_PIECE)
+        return lane_match;
+
+    const Piece&   piece = this->pieces[best];
+    const LaneKey& key = this->lanes[piece.lane];
+    const RefLine& ref_line = this->map.road(key.road_index).ref_line;
+    const double   s_guess = piece.s_start + best_u * (piece.s_end - piece.s_start);
+    const double   s = ref_line.refine_match(x, y, s_guess, piece.s_start, piece.s_end);
+    const Vec3D    pt = ref_line.get_xyz(s);
+    const Vec3D    grad = ref_line.get_grad(s);
+    const double   grad_len = std::hypot(grad[0], grad[1]);
+
+    lane_match.matched = true;
+    lane_match.key = key;
+    lane_match.s = s;
+    if (grad_len > 0)
+    {
+        lane_match.t = ((y - pt[1]) * grad[0] - (x - pt[0]) * grad[1]) / grad_len;
+        lane_match.heading_error = wrap_angle(heading - lane_direction(Vec2D{grad[0], grad[1]}, key.lane_id));
+    }
+    return lane_match;
+}
+
+} // namespace odr
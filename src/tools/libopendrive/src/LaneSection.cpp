@@ -10,6 +10,8 @@ LaneSection::LaneSection(std::string road_id, double s0) : road_id(road_id), s0(
 
 std::vector<Lane> LaneSection::get_lanes() const { return get_map_values(this->id_to_lane); }
 
+MapValues<int, Lane> LaneSection::lanes() const { return MapValues<int, Lane>(this->id_to_lane); }
+
 int LaneSection::get_lane_id(const double s, const double t) const
 {
     if (this->id_to_lane.at(0).outer_border.get(s) == t) // exactly on lane #0
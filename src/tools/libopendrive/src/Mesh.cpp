@@ -1,9 +1,18 @@
 #include "Mesh.h"
+#include "Utils.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cerrno>
 #include <cstddef>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <ostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <unistd.h>
 
 namespace odr
 {
@@ -15,8 +24,18 @@ void Mesh3D::add_mesh(const Mesh3D& other)
     this->normals.insert(this->normals.end(), other.normals.begin(), other.normals.end());
     this->st_coordinates.insert(this->st_coordinates.end(), other.st_coordinates.begin(), other.st_coordinates.end());
 
-    for (const uint32_t& idx : other.indices)
-        this->indices.push_back(idx + idx_offset);
+    const std::size_t num_indices = this->indices.size();
+    this->indices.resize(num_indices + other.indices.size());
+    for (std::size_t i = 0; i < other.indices.size(); i++)
+        this->indices[num_indices + i] = other.indices[i] + idx_offset;
+}
+
+void Mesh3D::reserve_more(std::size_t num_vertices, std::size_t num_indices)
+{
+    this->vertices.reserve(this->vertices.size() + num_vertices);
+    this->normals.reserve(this->normals.size() + num_vertices);
+    this->st_coordinates.reserve(this->st_coordinates.size() + num_vertices);
+    this->indices.reserve(this->indices.size() + num_indices);
 }
 
 std::string Mesh3D::get_obj() const
@@ -45,4 +64,181 @@ std::string Mesh3D::get_obj() const
     return ss_obj.str();
 }
 
+namespace
+{
+using WriteFn = std::function<void(const void*, std::size_t)>;
+
+constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+constexpr uint32_t GLB_VERSION = 2;
+constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;
+constexpr uint32_t GL_ELEMENT_ARRAY_BUFFER = 34963;
+constexpr uint32_t GL_ARRAY_BUFFER = 34962;
+constexpr uint32_t GL_UNSIGNED_INT = 5125;
+constexpr uint32_t GL_FLOAT = 5126;
+constexpr std::size_t GLB_STAGING_FLOATS = 1 << 14; // Per write when converting to float
+
+void write_u32(const WriteFn& write, const uint32_t val) { write(&val, sizeof(val)); }
+
+// Converts count vectors of Dim doubles, less origin, to float32 a chunk
+// at a time
+template<std::size_t Dim>
+void write_floats(const WriteFn& write, const std::vector<Vec<double, Dim>>& vals, const Vec<double, Dim>& origin)
+{
+    std::vector<float> staging;
+    staging.reserve(GLB_STAGING_FLOATS);
+    for (const Vec<double, Dim>& val : vals)
+    {
+        for (std::size_t dim = 0; dim < Dim; dim++)
+            staging.push_back(static_cast<float>(val[dim] - origin[dim]));
+        if (staging.size() + Dim > GLB_STAGING_FLOATS)
+        {
+            write(staging.data(), staging.size() * sizeof(float));
+            staging.clear();
+        }
+    }
+    if (!staging.empty())
+        write(staging.data(), staging.size() * sizeof(float));
+}
+
+// GLB is little-endian, as is every target this library is built for, so
+// the integers and floats are written as they are in memory
+void write_glb_to(const Mesh3D& mesh, const WriteFn& write)
+{
+    const std::size_t num_vertices = mesh.vertices.size();
+    const std::size_t num_indices = mesh.indices.size();
+    const bool        has_geometry = num_vertices > 0 && num_indices > 0;
+    const bool        with_normals = has_geometry && mesh.normals.size() == num_vertices;
+    const bool        with_st = has_geometry && mesh.st_coordinates.size() == num_vertices;
+
+    Vec3D origin{0, 0, 0};
+    Vec3D pos_min{0, 0, 0};
+    Vec3D pos_max{0, 0, 0};
+    if (has_geometry)
+    {
+        origin = mesh.vertices.front();
+        for (const Vec3D& vt : mesh.vertices)
+            for (std::size_t dim = 0; dim < 3; dim++)
+                origin[dim] = std::min(origin[dim], vt[dim]);
+        // The accessor's bounds must be those of the floats as stored
+        pos_min.fill(std::numeric_limits<double>::infinity());
+        pos_max.fill(-std::numeric_limits<double>::infinity());
+        for (const Vec3D& vt : mesh.vertices)
+        {
+            for (std::size_t dim = 0; dim < 3; dim++)
+            {
+                const double pos = static_cast<float>(vt[dim] - origin[dim]);
+                pos_min[dim] = std::min(pos_min[dim], pos);
+                pos_max[dim] = std::max(pos_max[dim], pos);
+            }
+        }
+    }
+
+    const std::size_t indices_len = num_indices * sizeof(uint32_t);
+    const std::size_t positions_len = num_vertices * 3 * sizeof(float);
+    const std::size_t normals_len = with_normals ? num_vertices * 3 * sizeof(float) : 0;
+    const std::size_t st_len = with_st ? num_vertices * 2 * sizeof(float) : 0;
+    const std::size_t bin_len = has_geometry ? indices_len + positions_len + normals_len + st_len : 0;
+
+    std::string json = R"({"asset":{"version":"2.0","generator":"libOpenDRIVE"},"scene":0,)";
+    if (has_geometry)
+    {
+        json += string_format(R"("scenes":[{"nodes":[0]}],"nodes":[{"mesh":0,"translation":[%.17g,%.17g,%.17g]}],)", origin[0], origin[1], origin[2]);
+        json += R"("meshes":[{"primitives":[{"attributes":{"POSITION":1)";
+        if (with_normals)
+            json += R"(,"NORMAL":2)";
+        if (with_st)
+            json += string_format(R"(,"TEXCOORD_0":%d)", with_normals ? 3 : 2);
+        json += R"(},"indices":0,"mode":4}]}],)";
+        json += string_format(R"("buffers":[{"byteLength":%zu}],)", bin_len);
+
+        std::string views = string_format(R"({"buffer":0,"byteOffset":0,"byteLength":%zu,"target":%u})", indices_len, GL_ELEMENT_ARRAY_BUFFER);
+        std::string accessors = string_format(R"({"bufferView":0,"componentType":%u,"count":%zu,"type":"SCALAR"})", GL_UNSIGNED_INT, num_indices);
+        std::size_t offset = indices_len;
+        std::size_t num_views = 1;
+        auto        add_attribute = [&](const std::size_t len, const char* type, const std::string& bounds)
+        {
+            views += string_format(R"(,{"buffer":0,"byteOffset":%zu,"byteLength":%zu,"target":%u})", offset, len, GL_ARRAY_BUFFER);
+            accessors += string_format(
+                R"(,{"bufferView":%zu,"componentType":%u,"count":%zu,"type":"%s"%s})", num_views, GL_FLOAT, num_vertices, type, bounds.c_str());
+            offset += len;
+            num_views++;
+        };
+        add_attribute(positions_len,
+                      "VEC3",
+                      string_format(R"(,"min":[%.9g,%.9g,%.9g],"max":[%.9g,%.9g,%.9g])",
+                                    pos_min[0],
+                                    pos_min[1],
+                                    pos_min[2],
+                                    pos_max[0],
+                                    pos_max[1],
+                                    pos_max[2]));
+        if (with_normals)
+            add_attribute(normals_len, "VEC3", "");
+        if (with_st)
+            add_attribute(st_len, "VEC2", "");
+        json += R"("bufferViews":[)" + views + R"(],"accessors":[)" + accessors + "]}";
+    }
+    else
+    {
+        json += R"("scenes":[{"nodes":[]}]})";
+    }
+    json.resize((json.size() + 3) / 4 * 4, ' '); // Chunks are 4-byte aligned
+
+    const std::size_t total_len = 12 + 8 + json.size() + (has_geometry ? 8 + bin_len : 0);
+    if (total_len > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("mesh too large for GLB");
+
+    write_u32(write, GLB_MAGIC);
+    write_u32(write, GLB_VERSION);
+    write_u32(write, static_cast<uint32_t>(total_len));
+    write_u32(write, static_cast<uint32_t>(json.size()));
+    write_u32(write, GLB_CHUNK_JSON);
+    write(json.data(), json.size());
+    if (!has_geometry)
+        return;
+
+    // Every buffer's length is a multiple of 4, so none needs padding
+    write_u32(write, static_cast<uint32_t>(bin_len));
+    write_u32(write, GLB_CHUNK_BIN);
+    write(mesh.indices.data(), indices_len);
+    write_floats<3>(write, mesh.vertices, origin);
+    if (with_normals)
+        write_floats<3>(write, mesh.normals, Vec3D{0, 0, 0});
+    if (with_st)
+        write_floats<2>(write, mesh.st_coordinates, Vec2D{0, 0});
+}
+} // namespace
+
+std::string Mesh3D::get_glb() const
+{
+    std::string glb;
+    write_glb_to(*this, [&](const void* data, std::size_t len) { glb.append(static_cast<const char*>(data), len); });
+    return glb;
+}
+
+void Mesh3D::write_glb(std::ostream& out) const
+{
+    write_glb_to(*this, [&](const void* data, std::size_t len) { out.write(static_cast<const char*>(data), len); });
+}
+
+void Mesh3D::write_glb(int fd) const
+{
+    write_glb_to(*this,
+                 [&](const void* data, std::size_t len)
+                 {
+                     const char* bytes = static_cast<const char*>(data);
+                     while (len > 0)
+                     {
+                         const ssize_t written = ::write(fd, bytes, len);
+                         if (written < 0 && errno == EINTR)
+                             continue;
+                         if (written <= 0)
+                             throw std::runtime_error(std::string("GLB write failed: ") + std::strerror(errno));
+                         bytes += written;
+                         len -= static_cast<std::size_t>(written);
+                     }
+                 });
+}
+
 } // namespace odr
\ No newline at end of file
@@ -17,32 +17,169 @@
 #include "Utils.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <exception>
 #include <iterator>
 #include <memory>
 #include <set>
 #include <stdexcept>
 #include <stdio.h>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include <iostream>
-#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace odr
 {
-    OpenDriveMap::OpenDriveMap(const std::string &xodr_file, bool from_string, const OpenDriveMapConfig &config) : xodr_file(xodr_file)
+    namespace
+    {
+        // A road as its <road> attributes give it, before anything under it
+        // is parsed
+        Road make_road_header(pugi::xml_node road_node)
+        {
+            return Road(road_node.attribute("id").as_string(""),
+                        road_node.attribute("length").as_double(0.0),
+                        road_node.attribute("junction").as_string(""),
+                        road_node.attribute("name").as_string(""));
+        }
+
+        // Points an element at the node it was parsed from, if the map
+        // keeps its DOM
+        void keep_xml_node(XmlNode &element, pugi::xml_node node, const OpenDriveMapConfig &config)
+        {
+            if (config.keep_xml)
+                element.xml_node = node;
+        }
+
+        // A box holding the road's reference line: no geometry reaches
+        // further from its start than its length. False if it has none.
+        bool plan_view_extent(const std::vector<pugi::xml_node> &road_nodes, double x_offs, double y_offs, box &extent)
+        {
+            bool found = false;
+            for (pugi::xml_node road_node : road_nodes)
+            {
+                for (pugi::xml_node geometry_hdr_node : road_node.child("planView").children("geometry"))
+                {
+                    const double x0 = geometry_hdr_node.attribute("x").as_double(0.0) - x_offs;
+                    const double y0 = geometry_hdr_node.attribute("y").as_double(0.0) - y_offs;
+                    const double length = std::max(geometry_hdr_node.attribute("length").as_double(0.0), 0.0);
+                    const box geometry_extent(point(float(x0 - length), float(y0 - length)), point(float(x0 + length), float(y0 + length)));
+                    if (found)
+                        bg::expand(extent, geometry_extent);
+                    else
+                        extent = geometry_extent;
+                    found = true;
+                }
+            }
+            return found;
+        }
+    } // namespace
+
+    template <typename F>
+    void OpenDriveMap::for_each_road(std::size_t count, F &&f) const
+    {
+        unsigned int threads = this->parallelism_ != 0 ? this->parallelism_ : std::thread::hardware_concurrency();
+        threads = static_cast<unsigned int>(std::min<std::size_t>(std::max(threads, 1u), count));
+
+        // Roads vary a lot in size, so threads take the next road as they
+        // finish rather than a fixed share.
+        std::atomic<std::size_t> next{0};
+        std::exception_ptr error;
+        std::atomic<bool> failed{false};
+        auto work = [&]()
+        {
+            for (std::size_t i = next++; i < count && !failed; i = next++)
+            {
+                try
+                {
+                    f(i);
+                }
+                catch (...)
+                {
+                    if (!failed.exchange(true))
+                        error = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < threads; t++)
+            workers.emplace_back(work);
+        work();
+        for (std::thread &worker : workers)
+            worker.join();
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    OpenDriveMap::OpenDriveMap(const std::string &xodr_file, bool from_string, const OpenDriveMapConfig &config)
+        : xodr_file(from_string && !config.keep_xml && !config.lazy_roads ? std::string() : xodr_file), parallelism_(config.parallelism)
     {
         pugi::xml_parse_result result;
         if (from_string)
             result = this->xml_doc.load_string(xodr_file.c_str());
         else
-            result = this->xml_doc.load_file(xodr_file.c_str());
+            result = this->load_file_inplace(xodr_file);
+        if (!result)
+            printf("%s\n", result.description());
+
+        this->parse(config);
+    }
+
+    OpenDriveMap::OpenDriveMap(InPlaceBuffer buffer, const OpenDriveMapConfig &config) : parallelism_(config.parallelism)
+    {
+        pugi::xml_parse_result result = this->xml_doc.load_buffer_inplace(buffer.data, buffer.size);
         if (!result)
             printf("%s\n", result.description());
 
+        this->parse(config);
+    }
+
+    OpenDriveMap::~OpenDriveMap()
+    {
+        this->xml_doc.reset();
+        if (this->mapped_file_ != nullptr)
+            munmap(this->mapped_file_, this->mapped_size_);
+    }
+
+    pugi::xml_parse_result OpenDriveMap::load_file_inplace(const std::string &path)
+    {
+        // A private mapping, so pugixml's writes never reach the file.
+        // Files that can't be mapped are read as before.
+        const int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *mapping = mmap(nullptr, std::size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (mapping != MAP_FAILED)
+            {
+                this->mapped_file_ = mapping;
+                this->mapped_size_ = std::size_t(st.st_size);
+                return this->xml_doc.load_buffer_inplace(mapping, this->mapped_size_);
+            }
+        }
+        else if (fd >= 0)
+            close(fd);
+        return this->xml_doc.load_file(path.c_str());
+    }
+
+    void OpenDriveMap::parse(const OpenDriveMapConfig &map_config)
+    {
+        this->config_ = map_config;
+        if (this->config_.lazy_roads)
+            this->config_.keep_xml = true;
+        const OpenDriveMapConfig &config = this->config_;
+
         pugi::xml_node odr_node = this->xml_doc.child("OpenDRIVE");
 
         if (auto geoReference_node = odr_node.child("header").child("geoReference"))
@@ -71,7 +208,7 @@ namespace odr
 
             Junction &junction =
                 this->id_to_junction.insert({junction_id, Junction(junction_node.attribute("name").as_string(""), junction_id)}).first->second;
-            junction.xml_node = junction_node;
+            keep_xml_node(junction, junction_node, config);
 
             for (pugi::xml_node connection_node : junction_node.children("connection"))
             {
@@ -119,471 +256,650 @@ namespace odr
             }
         }
 
+        /* make roads - the road nodes of an id are parsed, in document
+           order, into the Road made from the first of them */
+        std::vector<std::pair<Road *, std::vector<pugi::xml_node>>> road_nodes;
+        std::map<std::string, std::size_t> road_id_to_idx;
         for (pugi::xml_node road_node : odr_node.children("road"))
         {
-            /* make road */
             const std::string road_id = road_node.attribute("id").as_string("");
+            auto idx = road_id_to_idx.find(road_id);
+            if (idx == road_id_to_idx.end())
+            {
+                Road &road = this->id_to_road.insert({road_id, make_road_header(road_node)}).first->second;
+                idx = road_id_to_idx.insert({road_id, road_nodes.size()}).first;
+                road_nodes.push_back({&road, {}});
+            }
+            road_nodes[idx->second].second.push_back(road_node);
+        }
+
+        // Roads are numbered before any is parsed, so lazy maps number them
+        // the same way
+        this->index_roads();
+        const std::size_t num_roads = this->road_by_index_.size();
+        std::vector<std::vector<pugi::xml_node>> nodes_by_index(num_roads);
+        for (auto &road_and_nodes : road_nodes)
+            nodes_by_index[road_and_nodes.first->index] = std::move(road_and_nodes.second);
+
+        std::vector<value> extents;
+        extents.reserve(num_roads);
+        for (uint32_t road_index = 0; road_index < num_roads; road_index++)
+        {
+            box extent;
+            if (plan_view_extent(nodes_by_index[road_index], this->x_offs, this->y_offs, extent))
+                extents.emplace_back(extent, road_index);
+        }
+        this->index_road_extents(extents, !config.lazy_roads);
+        this->road_nodes_ = std::move(nodes_by_index);
+
+        if (config.lazy_roads)
+            return;
+
+        // id_to_road doesn't change shape from here on, and each road is
+        // only touched by one thread.
+        for_each_road(num_roads, [&](std::size_t i)
+                      {
+            for (pugi::xml_node road_node : this->road_nodes_[i])
+                parse_road(*this->road_by_index_[i], road_node, config); });
+
+        this->index_roads();
+        if (!config.keep_xml)
+            this->release_xml();
+    }
 
-            Road &road = this->id_to_road
-                             .insert({road_id,
-                                      Road(road_id,
-                                           road_node.attribute("length").as_double(0.0),
-                                           road_node.attribute("junction").as_string(""),
-                                           road_node.attribute("name").as_string(""))})
-                             .first->second;
-            road.xml_node = road_node;
+    void OpenDriveMap::release_xml()
+    {
+        std::vector<std::vector<pugi::xml_node>>().swap(this->road_nodes_);
+        this->xml_doc.reset();
+        if (this->mapped_file_ != nullptr)
+        {
+            munmap(this->mapped_file_, this->mapped_size_);
+            this->mapped_file_ = nullptr;
+            this->mapped_size_ = 0;
+        }
+    }
 
-            CHECK_AND_REPAIR(road.length >= 0, "road::length < 0", road.length = 0);
+    void OpenDriveMap::index_roads()
+    {
+        this->road_by_index_.clear();
+        this->lanesection_by_index_.clear();
+        for (auto &id_road : this->id_to_road)
+        {
+            Road &road = id_road.second;
+            road.index = uint32_t(this->road_by_index_.size());
+            this->road_by_index_.push_back(&road);
+            this->index_lanesections(road);
+        }
+    }
 
-            /* parse road links */
-            for (bool is_predecessor : {true, false})
+    void OpenDriveMap::index_lanesections(Road &road)
+    {
+        for (auto &s_lanesec : road.s_to_lanesection)
+        {
+            LaneSection &lanesec = s_lanesec.second;
+            lanesec.index = uint32_t(this->lanesection_by_index_.size());
+            this->lanesection_by_index_.push_back(&lanesec);
+            for (auto &id_lane : lanesec.id_to_lane)
             {
-                pugi::xml_node road_link_node =
-                    is_predecessor ? road_node.child("link").child("predecessor") : road_node.child("link").child("successor");
-                if (road_link_node)
-                {
-                    RoadLink &link = is_predecessor ? road.predecessor : road.successor;
-                    link.id = road_link_node.attribute("elementId").as_string("");
+                id_lane.second.key.road_index = road.index;
+                id_lane.second.key.lanesection_index = lanesec.index;
+            }
+        }
+    }
 
-                    std::string type_str = road_link_node.attribute("elementType").as_string("");
-                    CHECK_AND_REPAIR(type_str == "road" || type_str == "junction",
-                                     "Road::Succ/Predecessor::Link::elementType invalid type",
-                                     type_str = "road"); // default to road
-                    link.type = (type_str == "road") ? RoadLink::Type_Road : RoadLink::Type_Junction;
+    void OpenDriveMap::index_road_extents(const std::vector<value> &extents, bool loaded)
+    {
+        const std::size_t num_roads = this->road_by_index_.size();
+        this->road_nodes_.resize(num_roads);
+        this->road_loaded_.assign(num_roads, loaded);
+        this->lru_pos_.resize(num_roads);
+        this->road_extent_tree_ = bgi::rtree<value, bgi::rstar<16, 4>>(extents);
+    }
 
-                    if (link.type == RoadLink::Type_Road)
-                    {
-                        // junction connection has no contact point
-                        std::string contact_point_str = road_link_node.attribute("contactPoint").as_string("");
-                        CHECK_AND_REPAIR(contact_point_str == "start" || contact_point_str == "end",
-                                         "Road::Succ/Predecessor::Link::contactPoint invalid type",
-                                         contact_point_str = "start"); // default to start
-                        link.contact_point = (contact_point_str == "start") ? RoadLink::ContactPoint_Start : RoadLink::ContactPoint_End;
-                    }
+    const Road &OpenDriveMap::load_road(const std::string &id)
+    {
+        const uint32_t road_index = this->id_to_road.at(id).index;
+        std::lock_guard<std::mutex> lock(this->roads_mutex_);
+        this->load_roads({road_index});
+        return *this->road_by_index_[road_index];
+    }
 
-                    link.xml_node = road_link_node;
-                }
-            }
+    std::vector<const Road *> OpenDriveMap::load_roads_in(const box &region)
+    {
+        std::vector<value> hits;
+        this->road_extent_tree_.query(bgi::intersects(region), std::back_inserter(hits));
+        std::vector<uint32_t> road_indices;
+        road_indices.reserve(hits.size());
+        for (const value &hit : hits)
+            road_indices.push_back(hit.second);
+        sort_unique(road_indices);
+
+        std::lock_guard<std::mutex> lock(this->roads_mutex_);
+        this->load_roads(road_indices);
+        std::vector<const Road *> loaded;
+        loaded.reserve(road_indices.size());
+        for (const uint32_t road_index : road_indices)
+            loaded.push_back(this->road_by_index_[road_index]);
+        return loaded;
+    }
 
-            /* parse road neighbors */
-            for (pugi::xml_node road_neighbor_node : road_node.child("link").children("neighbor"))
-            {
-                const std::string road_neighbor_id = road_neighbor_node.attribute("elementId").as_string("");
-                const std::string road_neighbor_side = road_neighbor_node.attribute("side").as_string("");
-                const std::string road_neighbor_direction = road_neighbor_node.attribute("direction").as_string("");
-                RoadNeighbor road_neighbor(road_neighbor_id, road_neighbor_side, road_neighbor_direction);
-                road_neighbor.xml_node = road_neighbor_node;
-                road.neighbors.push_back(road_neighbor);
-            }
+    bool OpenDriveMap::road_loaded(uint32_t index) const
+    {
+        std::lock_guard<std::mutex> lock(this->roads_mutex_);
+        return this->road_loaded_.at(index);
+    }
+
+    void OpenDriveMap::load_roads(const std::vector<uint32_t> &indices)
+    {
+        if (!this->config_.lazy_roads)
+            return;
+
+        std::vector<uint32_t> missing;
+        for (const uint32_t road_index : indices)
+        {
+            if (this->road_loaded_[road_index])
+                this->lru_roads_.splice(this->lru_roads_.begin(), this->lru_roads_, this->lru_pos_[road_index]);
+            else
+                missing.push_back(road_index);
+        }
+
+        // Only the missing roads are touched, each by one thread
+        for_each_road(missing.size(), [&](std::size_t i)
+                      {
+            const uint32_t road_index = missing[i];
+            for (pugi::xml_node road_node : this->road_nodes_[road_index])
+                parse_road(*this->road_by_index_[road_index], road_node, this->config_); });
+        for (const uint32_t road_index : missing)
+        {
+            this->index_lanesections(*this->road_by_index_[road_index]);
+            this->road_loaded_[road_index] = true;
+            this->lru_roads_.push_front(road_index);
+            this->lru_pos_[road_index] = this->lru_roads_.begin();
+        }
+
+        // Never the roads just asked for, however many there are
+        const std::size_t keep = std::max(this->config_.max_loaded_roads, indices.size());
+        while (this->config_.max_loaded_roads != 0 && this->lru_roads_.size() > keep)
+        {
+            const uint32_t road_index = this->lru_roads_.back();
+            this->lru_roads_.pop_back();
+            this->unload_road(road_index);
+        }
+    }
 
-            /* parse road type and speed */
-            for (pugi::xml_node road_type_node : road_node.children("type"))
+    void OpenDriveMap::unload_road(uint32_t index)
+    {
+        const Road &road = *this->road_by_index_[index];
+        for (const auto &s_lanesec : road.s_to_lanesection)
+            this->lanesection_by_index_[s_lanesec.second.index] = nullptr;
+
+        // Road can't be reassigned, so a fresh one takes its place
+        auto road_iter = this->id_to_road.find(road.id);
+        const std::string road_id = road_iter->first;
+        road_iter = this->id_to_road.erase(road_iter);
+        road_iter = this->id_to_road.emplace_hint(road_iter, road_id, make_road_header(this->road_nodes_[index].front()));
+        road_iter->second.index = index;
+        this->road_by_index_[index] = &road_iter->second;
+        this->road_loaded_[index] = false;
+    }
+
+    void OpenDriveMap::parse_road(Road &road, pugi::xml_node road_node, const OpenDriveMapConfig &config) const
+    {
+        const std::string &road_id = road.id;
+        keep_xml_node(road, road_node, config);
+
+        CHECK_AND_REPAIR(road.length >= 0, "road::length < 0", road.length = 0);
+
+        /* parse road links */
+        for (bool is_predecessor : {true, false})
+        {
+            pugi::xml_node road_link_node =
+                is_predecessor ? road_node.child("link").child("predecessor") : road_node.child("link").child("successor");
+            if (road_link_node)
             {
-                double s = road_type_node.attribute("s").as_double(0.0);
-                std::string type = road_type_node.attribute("type").as_string("");
+                RoadLink &link = is_predecessor ? road.predecessor : road.successor;
+                link.id = road_link_node.attribute("elementId").as_string("");
 
-                CHECK_AND_REPAIR(s >= 0, "road::type::s < 0", s = 0);
+                std::string type_str = road_link_node.attribute("elementType").as_string("");
+                CHECK_AND_REPAIR(type_str == "road" || type_str == "junction",
+                                 "Road::Succ/Predecessor::Link::elementType invalid type",
+                                 type_str = "road"); // default to road
+                link.type = (type_str == "road") ? RoadLink::Type_Road : RoadLink::Type_Junction;
 
-                road.s_to_type[s] = type;
-                if (pugi::xml_node node = road_type_node.child("speed"))
+                if (link.type == RoadLink::Type_Road)
                 {
-                    const std::string speed_record_max = node.attribute("max").as_string("");
-                    const std::string speed_record_unit = node.attribute("unit").as_string("");
-                    SpeedRecord speed_record(speed_record_max, speed_record_unit);
-                    speed_record.xml_node = node;
-                    road.s_to_speed.insert({s, speed_record});
+                    // junction connection has no contact point
+                    std::string contact_point_str = road_link_node.attribute("contactPoint").as_string("");
+                    CHECK_AND_REPAIR(contact_point_str == "start" || contact_point_str == "end",
+                                     "Road::Succ/Predecessor::Link::contactPoint invalid type",
+                                     contact_point_str = "start"); // default to start
+                    link.contact_point = (contact_point_str == "start") ? RoadLink::ContactPoint_Start : RoadLink::ContactPoint_End;
                 }
+
+                keep_xml_node(link, road_link_node, config);
             }
+        }
 
-            /* make ref_line - parse road geometries */
-            for (pugi::xml_node geometry_hdr_node : road_node.child("planView").children("geometry"))
+        /* parse road neighbors */
+        for (pugi::xml_node road_neighbor_node : road_node.child("link").children("neighbor"))
+        {
+            const std::string road_neighbor_id = road_neighbor_node.attribute("elementId").as_string("");
+            const std::string road_neighbor_side = road_neighbor_node.attribute("side").as_string("");
+            const std::string road_neighbor_direction = road_neighbor_node.attribute("direction").as_string("");
+            RoadNeighbor road_neighbor(road_neighbor_id, road_neighbor_side, road_neighbor_direction);
+            keep_xml_node(road_neighbor, road_neighbor_node, config);
+            road.neighbors.push_back(road_neighbor);
+        }
+
+        /* parse road type and speed */
+        for (pugi::xml_node road_type_node : road_node.children("type"))
+        {
+            double s = road_type_node.attribute("s").as_double(0.0);
+            std::string type = road_type_node.attribute("type").as_string("");
+
+            CHECK_AND_REPAIR(s >= 0, "road::type::s < 0", s = 0);
+
+            road.s_to_type[s] = type;
+            if (pugi::xml_node node = road_type_node.child("speed"))
             {
-                double s0 = geometry_hdr_node.attribute("s").as_double(0.0);
-                double x0 = geometry_hdr_node.attribute("x").as_double(0.0) - this->x_offs;
-                double y0 = geometry_hdr_node.attribute("y").as_double(0.0) - this->y_offs;
-                double hdg0 = geometry_hdr_node.attribute("hdg").as_double(0.0);
-                double length = geometry_hdr_node.attribute("length").as_double(0.0);
-
-                CHECK_AND_REPAIR(s0 >= 0, "road::planView::geometry::s < 0", s0 = 0);
-                CHECK_AND_REPAIR(length >= 0, "road::planView::geometry::length < 0", length = 0);
-
-                pugi::xml_node geometry_node = geometry_hdr_node.first_child();
-                std::string geometry_type = geometry_node.name();
-                if (geometry_type == "line")
-                {
-                    road.ref_line.s0_to_geometry[s0] = std::make_unique<Line>(s0, x0, y0, hdg0, length);
-                }
-                else if (geometry_type == "spiral")
-                {
-                    double curv_start = geometry_node.attribute("curvStart").as_double(0.0);
-                    double curv_end = geometry_node.attribute("curvEnd").as_double(0.0);
-                    road.ref_line.s0_to_geometry[s0] = std::make_unique<Spiral>(s0, x0, y0, hdg0, length, curv_start, curv_end);
-                }
-                else if (geometry_type == "arc")
-                {
-                    double curvature = geometry_node.attribute("curvature").as_double(0.0);
-                    road.ref_line.s0_to_geometry[s0] = std::make_unique<Arc>(s0, x0, y0, hdg0, length, curvature);
-                }
-                else if (geometry_type == "paramPoly3")
-                {
-                    double aU = geometry_node.attribute("aU").as_double(0.0);
-                    double bU = geometry_node.attribute("bU").as_double(0.0);
-                    double cU = geometry_node.attribute("cU").as_double(0.0);
-                    double dU = geometry_node.attribute("dU").as_double(0.0);
-                    double aV = geometry_node.attribute("aV").as_double(0.0);
-                    double bV = geometry_node.attribute("bV").as_double(0.0);
-                    double cV = geometry_node.attribute("cV").as_double(0.0);
-                    double dV = geometry_node.attribute("dV").as_double(0.0);
-
-                    bool pRange_normalized = true;
-                    if (geometry_node.attribute("pRange") || geometry_hdr_node.attribute("pRange"))
-                    {
-                        std::string pRange_str = geometry_node.attribute("pRange") ? geometry_node.attribute("pRange").as_string("")
-                                                                                   : geometry_hdr_node.attribute("pRange").as_string("");
-                        std::transform(pRange_str.begin(), pRange_str.end(), pRange_str.begin(), [](unsigned char c)
-                                       { return std::tolower(c); });
-                        if (pRange_str == "arclength")
-                            pRange_normalized = false;
-                    }
-                    road.ref_line.s0_to_geometry[s0] =
-                        std::make_unique<ParamPoly3>(s0, x0, y0, hdg0, length, aU, bU, cU, dU, aV, bV, cV, dV, pRange_normalized);
-                }
-                else
+                const std::string speed_record_max = node.attribute("max").as_string("");
+                const std::string speed_record_unit = node.attribute("unit").as_string("");
+                SpeedRecord speed_record(speed_record_max, speed_record_unit);
+                keep_xml_node(speed_record, node, config);
+                road.s_to_speed.insert({s, speed_record});
+            }
+        }
+
+        /* make ref_line - parse road geometries */
+        for (pugi::xml_node geometry_hdr_node : road_node.child("planView").children("geometry"))
+        {
+            double s0 = geometry_hdr_node.attribute("s").as_double(0.0);
+            double x0 = geometry_hdr_node.attribute("x").as_double(0.0) - this->x_offs;
+            double y0 = geometry_hdr_node.attribute("y").as_double(0.0) - this->y_offs;
+            double hdg0 = geometry_hdr_node.attribute("hdg").as_double(0.0);
+            double length = geometry_hdr_node.attribute("length").as_double(0.0);
+
+            CHECK_AND_REPAIR(s0 >= 0, "road::planView::geometry::s < 0", s0 = 0);
+            CHECK_AND_REPAIR(length >= 0, "road::planView::geometry::length < 0", length = 0);
+
+            pugi::xml_node geometry_node = geometry_hdr_node.first_child();
+            std::string geometry_type = geometry_node.name();
+            if (geometry_type == "line")
+            {
+                road.ref_line.s0_to_geometry[s0] = std::make_unique<Line>(s0, x0, y0, hdg0, length);
+            }
+            else if (geometry_type == "spiral")
+            {
+                double curv_start = geometry_node.attribute("curvStart").as_double(0.0);
+                double curv_end = geometry_node.attribute("curvEnd").as_double(0.0);
+                road.ref_line.s0_to_geometry[s0] = std::make_unique<Spiral>(s0, x0, y0, hdg0, length, curv_start, curv_end);
+            }
+            else if (geometry_type == "arc")
+            {
+                double curvature = geometry_node.attribute("curvature").as_double(0.0);
+                road.ref_line.s0_to_geometry[s0] = std::make_unique<Arc>(s0, x0, y0, hdg0, length, curvature);
+            }
+            else if (geometry_type == "paramPoly3")
+            {
+                double aU = geometry_node.attribute("aU").as_double(0.0);
+                double bU = geometry_node.attribute("bU").as_double(0.0);
+                double cU = geometry_node.attribute("cU").as_double(0.0);
+                double dU = geometry_node.attribute("dU").as_double(0.0);
+                double aV = geometry_node.attribute("aV").as_double(0.0);
+                double bV = geometry_node.attribute("bV").as_double(0.0);
+                double cV = geometry_node.attribute("cV").as_double(0.0);
+                double dV = geometry_node.attribute("dV").as_double(0.0);
+
+                bool pRange_normalized = true;
+                if (geometry_node.attribute("pRange") || geometry_hdr_node.attribute("pRange"))
                 {
-                    printf("Could not parse %s\n", geometry_type.c_str());
-                    continue;
+                    std::string pRange_str = geometry_node.attribute("pRange") ? geometry_node.attribute("pRange").as_string("")
+                                                                               : geometry_hdr_node.attribute("pRange").as_string("");
+                    std::transform(pRange_str.begin(), pRange_str.end(), pRange_str.begin(), [](unsigned char c)
+                                   { return std::tolower(c); });
+                    if (pRange_str == "arclength")
+                        pRange_normalized = false;
                 }
-
-                road.ref_line.s0_to_geometry.at(s0)->xml_node = geometry_node;
+                road.ref_line.s0_to_geometry[s0] =
+                    std::make_unique<ParamPoly3>(s0, x0, y0, hdg0, length, aU, bU, cU, dU, aV, bV, cV, dV, pRange_normalized);
+            }
+            else
+            {
+                printf("Could not parse %s\n", geometry_type.c_str());
+                continue;
             }
 
-            std::map<std::string /*x path query*/, CubicSpline &> cubic_spline_fields{{".//elevationProfile//elevation", road.ref_line.elevation_profile},
-                                                                                      {".//lanes//laneOffset", road.lane_offset}};
+            keep_xml_node(*road.ref_line.s0_to_geometry.at(s0), geometry_node, config);
+        }
+
+        std::map<std::string /*x path query*/, CubicSpline &> cubic_spline_fields{{".//elevationProfile//elevation", road.ref_line.elevation_profile},
+                                                                                  {".//lanes//laneOffset", road.lane_offset}};
 
-            if (config.with_lateralProfile)
-                cubic_spline_fields.insert({".//lateralProfile//superelevation", road.superelevation});
+        if (config.with_lateralProfile)
+            cubic_spline_fields.insert({".//lateralProfile//superelevation", road.superelevation});
 
-            /* parse elevation profiles, lane offsets, superelevation */
-            for (auto entry : cubic_spline_fields)
+        /* parse elevation profiles, lane offsets, superelevation */
+        for (const auto &entry : cubic_spline_fields)
+        {
+            pugi::xpath_node_set nodes = road_node.select_nodes(entry.first.c_str());
+            for (pugi::xpath_node node : nodes)
             {
-                pugi::xpath_node_set nodes = road_node.select_nodes(entry.first.c_str());
-                for (pugi::xpath_node node : nodes)
-                {
-                    double s0 = node.node().attribute("s").as_double(0.0);
-                    double a = node.node().attribute("a").as_double(0.0);
-                    double b = node.node().attribute("b").as_double(0.0);
-                    double c = node.node().attribute("c").as_double(0.0);
-                    double d = node.node().attribute("d").as_double(0.0);
+                double s0 = node.node().attribute("s").as_double(0.0);
+                double a = node.node().attribute("a").as_double(0.0);
+                double b = node.node().attribute("b").as_double(0.0);
+                double c = node.node().attribute("c").as_double(0.0);
+                double d = node.node().attribute("d").as_double(0.0);
 
-                    CHECK_AND_REPAIR(s0 >= 0, (entry.first + "::s < 0").c_str(), s0 = 0);
+                CHECK_AND_REPAIR(s0 >= 0, (entry.first + "::s < 0").c_str(), s0 = 0);
 
-                    entry.second.s0_to_poly[s0] = Poly3(s0, a, b, c, d);
-                }
+                entry.second.insert(s0, Poly3(s0, a, b, c, d));
             }
+        }
 
-            /* parse crossfall - has extra attribute side */
-            if (config.with_lateralProfile)
+        /* parse crossfall - has extra attribute side */
+        if (config.with_lateralProfile)
+        {
+            for (pugi::xml_node crossfall_node : road_node.child("lateralProfile").children("crossfall"))
             {
-                for (pugi::xml_node crossfall_node : road_node.child("lateralProfile").children("crossfall"))
-                {
-                    double s0 = crossfall_node.attribute("s").as_double(0.0);
-                    double a = crossfall_node.attribute("a").as_double(0.0);
-                    double b = crossfall_node.attribute("b").as_double(0.0);
-                    double c = crossfall_node.attribute("c").as_double(0.0);
-                    double d = crossfall_node.attribute("d").as_double(0.0);
+                double s0 = crossfall_node.attribute("s").as_double(0.0);
+                double a = crossfall_node.attribute("a").as_double(0.0);
+                double b = crossfall_node.attribute("b").as_double(0.0);
+                double c = crossfall_node.attribute("c").as_double(0.0);
+                double d = crossfall_node.attribute("d").as_double(0.0);
 
-                    CHECK_AND_REPAIR(s0 >= 0, "road::lateralProfile::crossfall::s < 0", s0 = 0);
+                CHECK_AND_REPAIR(s0 >= 0, "road::lateralProfile::crossfall::s < 0", s0 = 0);
 
-                    Poly3 crossfall_poly(s0, a, b, c, d);
-                    road.crossfall.s0_to_poly[s0] = crossfall_poly;
-                    if (pugi::xml_attribute side = crossfall_node.attribute("side"))
-                    {
-                        std::string side_str = side.as_string("");
-                        std::transform(side_str.begin(), side_str.end(), side_str.begin(), [](unsigned char c)
-                                       { return std::tolower(c); });
-                        if (side_str == "left")
-                            road.crossfall.sides[s0] = Crossfall::Side_Left;
-                        else if (side_str == "right")
-                            road.crossfall.sides[s0] = Crossfall::Side_Right;
-                        else
-                            road.crossfall.sides[s0] = Crossfall::Side_Both;
-                    }
+                Poly3 crossfall_poly(s0, a, b, c, d);
+                road.crossfall.insert(s0, crossfall_poly);
+                if (pugi::xml_attribute side = crossfall_node.attribute("side"))
+                {
+                    std::string side_str = side.as_string("");
+                    std::transform(side_str.begin(), side_str.end(), side_str.begin(), [](unsigned char c)
+                                   { return std::tolower(c); });
+                    if (side_str == "left")
+                        road.crossfall.sides[s0] = Crossfall::Side_Left;
+                    else if (side_str == "right")
+                        road.crossfall.sides[s0] = Crossfall::Side_Right;
+                    else
+                        road.crossfall.sides[s0] = Crossfall::Side_Both;
                 }
-
-                // /* check for lateralProfile shape - not implemented yet */
-                // for (auto road_shape_node : road_node.child("lateralProfile").children("shape"))
-                //     printf("Lateral Profile Shape not supported\n");
             }
 
-            /* parse road lane sections and lanes */
-            for (pugi::xml_node lanesection_node : road_node.child("lanes").children("laneSection"))
-            {
-                const double s0 = lanesection_node.attribute("s").as_double(0.0);
-                LaneSection &lanesection = road.s_to_lanesection.insert({s0, LaneSection(road_id, s0)}).first->second;
-                lanesection.xml_node = lanesection_node;
+            // /* check for lateralProfile shape - not implemented yet */
+            // for (auto road_shape_node : road_node.child("lateralProfile").children("shape"))
+            //     printf("Lateral Profile Shape not supported\n");
+        }
+
+        /* parse road lane sections and lanes */
+        for (pugi::xml_node lanesection_node : road_node.child("lanes").children("laneSection"))
+        {
+            const double s0 = lanesection_node.attribute("s").as_double(0.0);
+            LaneSection &lanesection = road.s_to_lanesection.insert({s0, LaneSection(road_id, s0)}).first->second;
+            keep_xml_node(lanesection, lanesection_node, config);
 
-                for (pugi::xpath_node lane_xpath_node : lanesection_node.select_nodes(".//lane"))
+            for (pugi::xpath_node lane_xpath_node : lanesection_node.select_nodes(".//lane"))
+            {
+                pugi::xml_node lane_node = lane_xpath_node.node();
+                const int lane_id = lane_node.attribute("id").as_int(0);
+
+                Lane &lane =
+                    lanesection.id_to_lane
+                        .insert({lane_id,
+                                 Lane(road_id, s0, lane_id, lane_node.attribute("level").as_bool(false), lane_node.attribute("type").as_string(""))})
+                        .first->second;
+
+                if (pugi::xml_node node = lane_node.child("link").child("predecessor"))
+                    lane.predecessor = node.attribute("id").as_int(0);
+                if (pugi::xml_node node = lane_node.child("link").child("successor"))
+                    lane.successor = node.attribute("id").as_int(0);
+                keep_xml_node(lane, lane_node, config);
+
+                for (pugi::xml_node lane_width_node : lane_node.children("width"))
                 {
-                    pugi::xml_node lane_node = lane_xpath_node.node();
-                    const int lane_id = lane_node.attribute("id").as_int(0);
-
-                    Lane &lane =
-                        lanesection.id_to_lane
-                            .insert({lane_id,
-                                     Lane(road_id, s0, lane_id, lane_node.attribute("level").as_bool(false), lane_node.attribute("type").as_string(""))})
-                            .first->second;
-
-                    if (pugi::xml_node node = lane_node.child("link").child("predecessor"))
-                        lane.predecessor = node.attribute("id").as_int(0);
-                    if (pugi::xml_node node = lane_node.child("link").child("successor"))
-                        lane.successor = node.attribute("id").as_int(0);
-                    lane.xml_node = lane_node;
-
-                    for (pugi::xml_node lane_width_node : lane_node.children("width"))
-                    {
-                        double s_offset = lane_width_node.attribute("sOffset").as_double(0.0);
-                        double a = lane_width_node.attribute("a").as_double(0.0);
-                        double b = lane_width_node.attribute("b").as_double(0.0);
-                        double c = lane_width_node.attribute("c").as_double(0.0);
-                        double d = lane_width_node.attribute("d").as_double(0.0);
-
-                        CHECK_AND_REPAIR(s_offset >= 0, "lane::width::sOffset < 0", s_offset = 0);
-                        lane.lane_width.s0_to_poly[s0 + s_offset] = Poly3(s0 + s_offset, a, b, c, d);
-                    }
+                    double s_offset = lane_width_node.attribute("sOffset").as_double(0.0);
+                    double a = lane_width_node.attribute("a").as_double(0.0);
+                    double b = lane_width_node.attribute("b").as_double(0.0);
+                    double c = lane_width_node.attribute("c").as_double(0.0);
+                    double d = lane_width_node.attribute("d").as_double(0.0);
+
+                    CHECK_AND_REPAIR(s_offset >= 0, "lane::width::sOffset < 0", s_offset = 0);
+                    lane.lane_width.insert(s0 + s_offset, Poly3(s0 + s_offset, a, b, c, d));
+                }
 
-                    if (config.with_laneHeight)
+                if (config.with_laneHeight)
+                {
+                    for (pugi::xml_node lane_height_node : lane_node.children("height"))
                     {
-                        for (pugi::xml_node lane_height_node : lane_node.children("height"))
-                        {
-                            double s_offset = lane_height_node.attribute("sOffset").as_double(0.0);
-                            double inner = lane_height_node.attribute("inner").as_double(0.0);
-                            double outer = lane_height_node.attribute("outer").as_double(0.0);
+                        double s_offset = lane_height_node.attribute("sOffset").as_double(0.0);
+                        double inner = lane_height_node.attribute("inner").as_double(0.0);
+                        double outer = lane_height_node.attribute("outer").as_double(0.0);
 
-                            CHECK_AND_REPAIR(s_offset >= 0, "lane::height::sOffset < 0", s_offset = 0);
-                            lane.s_to_height_offset.insert({s0 + s_offset, HeightOffset(inner, outer)});
-                        }
+                        CHECK_AND_REPAIR(s_offset >= 0, "lane::height::sOffset < 0", s_offset = 0);
+                        lane.s_to_height_offset.insert({s0 + s_offset, HeightOffset(inner, outer)});
                     }
+                }
 
-                    for (pugi::xml_node roadmark_node : lane_node.children("roadMark"))
+                for (pugi::xml_node roadmark_node : lane_node.children("roadMark"))
+                {
+                    RoadMarkGroup roadmark_group(road_id,
+                                                 s0,
+                                                 lane_id,
+                                                 roadmark_node.attribute("width").as_double(-1),
+                                                 roadmark_node.attribute("height").as_double(0),
+                                                 roadmark_node.attribute("sOffset").as_double(0),
+                                                 roadmark_node.attribute("type").as_string("none"),
+                                                 roadmark_node.attribute("weight").as_string("standard"),
+                                                 roadmark_node.attribute("color").as_string("standard"),
+                                                 roadmark_node.attribute("material").as_string("standard"),
+                                                 roadmark_node.attribute("laneChange").as_string("both"));
+                    keep_xml_node(roadmark_group, roadmark_node, config);
+
+                    CHECK_AND_REPAIR(roadmark_group.s_offset >= 0, "lane::roadMark::sOffset < 0", roadmark_group.s_offset = 0);
+                    const double roadmark_group_s0 = s0 + roadmark_group.s_offset;
+
+                    if (pugi::xml_node roadmark_type_node = roadmark_node.child("type"))
                     {
-                        RoadMarkGroup roadmark_group(road_id,
-                                                     s0,
-                                                     lane_id,
-                                                     roadmark_node.attribute("width").as_double(-1),
-                                                     roadmark_node.attribute("height").as_double(0),
-                                                     roadmark_node.attribute("sOffset").as_double(0),
-                                                     roadmark_node.attribute("type").as_string("none"),
-                                                     roadmark_node.attribute("weight").as_string("standard"),
-                                                     roadmark_node.attribute("color").as_string("standard"),
-                                                     roadmark_node.attribute("material").as_string("standard"),
-                                                     roadmark_node.attribute("laneChange").as_string("both"));
-                        roadmark_group.xml_node = roadmark_node;
-
-                        CHECK_AND_REPAIR(roadmark_group.s_offset >= 0, "lane::roadMark::sOffset < 0", roadmark_group.s_offset = 0);
-                        const double roadmark_group_s0 = s0 + roadmark_group.s_offset;
-
-                        if (pugi::xml_node roadmark_type_node = roadmark_node.child("type"))
+                        const std::string name = roadmark_type_node.attribute("name").as_string("");
+                        const double line_width_1 = roadmark_type_node.attribute("width").as_double(-1);
+
+                        for (pugi::xml_node roadmarks_line_node : roadmark_type_node.children("line"))
                         {
-                            const std::string name = roadmark_type_node.attribute("name").as_string("");
-                            const double line_width_1 = roadmark_type_node.attribute("width").as_double(-1);
-
-                            for (pugi::xml_node roadmarks_line_node : roadmark_type_node.children("line"))
-                            {
-                                const double line_width_0 = roadmarks_line_node.attribute("width").as_double(-1);
-                                const double roadmark_width = line_width_0 < 0 ? line_width_1 : line_width_0;
-
-                                RoadMarksLine roadmarks_line(road_id,
-                                                             s0,
-                                                             lane_id,
-                                                             roadmark_group_s0,
-                                                             roadmark_width,
-                                                             roadmarks_line_node.attribute("length").as_double(0),
-                                                             roadmarks_line_node.attribute("space").as_double(0),
-                                                             roadmarks_line_node.attribute("tOffset").as_double(0),
-                                                             roadmarks_line_node.attribute("sOffset").as_double(0),
-                                                             name,
-                                                             roadmarks_line_node.attribute("rule").as_string("none"));
-                                roadmarks_line.xml_node = roadmarks_line_node;
-
-                                CHECK_AND_REPAIR(roadmarks_line.length >= 0, "roadMark::type::line::length < 0", roadmarks_line.length = 0);
-                                CHECK_AND_REPAIR(roadmarks_line.space >= 0, "roadMark::type::line::space < 0", roadmarks_line.space = 0);
-                                CHECK_AND_REPAIR(roadmarks_line.s_offset >= 0, "roadMark::type::line::sOffset < 0", roadmarks_line.s_offset = 0);
-
-                                roadmark_group.roadmark_lines.emplace(std::move(roadmarks_line));
-                            }
+                            const double line_width_0 = roadmarks_line_node.attribute("width").as_double(-1);
+                            const double roadmark_width = line_width_0 < 0 ? line_width_1 : line_width_0;
+
+                            RoadMarksLine roadmarks_line(road_id,
+                                                         s0,
+                                                         lane_id,
+                                                         roadmark_group_s0,
+                                                         roadmark_width,
+                                                         roadmarks_line_node.attribute("length").as_double(0),
+                                                         roadmarks_line_node.attribute("space").as_double(0),
+                                                         roadmarks_line_node.attribute("tOffset").as_double(0),
+                                                         roadmarks_line_node.attribute("sOffset").as_double(0),
+                                                         name,
+                                                         roadmarks_line_node.attribute("rule").as_string("none"));
+                            keep_xml_node(roadmarks_line, roadmarks_line_node, config);
+
+                            CHECK_AND_REPAIR(roadmarks_line.length >= 0, "roadMark::type::line::length < 0", roadmarks_line.length = 0);
+                            CHECK_AND_REPAIR(roadmarks_line.space >= 0, "roadMark::type::line::space < 0", roadmarks_line.space = 0);
+                            CHECK_AND_REPAIR(roadmarks_line.s_offset >= 0, "roadMark::type::line::sOffset < 0", roadmarks_line.s_offset = 0);
+
+                            roadmark_group.roadmark_lines.emplace(std::move(roadmarks_line));
                         }
-
-                        lane.roadmark_groups.emplace(std::move(roadmark_group));
                     }
+
+                    lane.roadmark_groups.emplace(std::move(roadmark_group));
                 }
+            }
 
-                /* derive lane borders from lane widths */
-                auto id_lane_iter0 = lanesection.id_to_lane.find(0);
-                if (id_lane_iter0 == lanesection.id_to_lane.end())
-                    throw std::runtime_error("lane section does not have lane #0");
+            /* derive lane borders from lane widths */
+            auto id_lane_iter0 = lanesection.id_to_lane.find(0);
+            if (id_lane_iter0 == lanesection.id_to_lane.end())
+                throw std::runtime_error("lane section does not have lane #0");
 
-                /* iterate from id #0 towards +inf */
-                auto id_lane_iter1 = std::next(id_lane_iter0);
-                for (auto iter = id_lane_iter1; iter != lanesection.id_to_lane.end(); iter++)
+            /* iterate from id #0 towards +inf */
+            auto id_lane_iter1 = std::next(id_lane_iter0);
+            for (auto iter = id_lane_iter1; iter != lanesection.id_to_lane.end(); iter++)
+            {
+                if (iter == id_lane_iter0)
                 {
-                    if (iter == id_lane_iter0)
-                    {
-                        iter->second.outer_border = iter->second.lane_width;
-                    }
-                    else
-                    {
-                        iter->second.inner_border = std::prev(iter)->second.outer_border;
-                        iter->second.outer_border = std::prev(iter)->second.outer_border.add(iter->second.lane_width);
-                    }
+                    iter->second.outer_border = iter->second.lane_width;
                 }
-
-                /* iterate from id #0 towards -inf */
-                std::map<int, Lane>::reverse_iterator r_id_lane_iter_1(id_lane_iter0);
-                for (auto r_iter = r_id_lane_iter_1; r_iter != lanesection.id_to_lane.rend(); r_iter++)
+                else
                 {
-                    if (r_iter == r_id_lane_iter_1)
-                    {
-                        r_iter->second.outer_border = r_iter->second.lane_width.negate();
-                    }
-                    else
-                    {
-                        r_iter->second.inner_border = std::prev(r_iter)->second.outer_border;
-                        r_iter->second.outer_border = std::prev(r_iter)->second.outer_border.add(r_iter->second.lane_width.negate());
-                    }
+                    iter->second.inner_border = std::prev(iter)->second.outer_border;
+                    iter->second.outer_border = std::prev(iter)->second.outer_border.add(iter->second.lane_width);
                 }
+            }
 
-                for (auto &id_lane : lanesection.id_to_lane)
+            /* iterate from id #0 towards -inf */
+            std::map<int, Lane>::reverse_iterator r_id_lane_iter_1(id_lane_iter0);
+            for (auto r_iter = r_id_lane_iter_1; r_iter != lanesection.id_to_lane.rend(); r_iter++)
+            {
+                if (r_iter == r_id_lane_iter_1)
+                {
+                    r_iter->second.outer_border = r_iter->second.lane_width.negate();
+                }
+                else
                 {
-                    id_lane.second.inner_border = id_lane.second.inner_border.add(road.lane_offset);
-                    id_lane.second.outer_border = id_lane.second.outer_border.add(road.lane_offset);
+                    r_iter->second.inner_border = std::prev(r_iter)->second.outer_border;
+                    r_iter->second.outer_border = std::prev(r_iter)->second.outer_border.add(r_iter->second.lane_width.negate());
                 }
             }
 
-            /* parse road objects */
-            if (config.with_road_objects)
+            for (auto &id_lane : lanesection.id_to_lane)
             {
-                const RoadObjectCorner::Type default_local_outline_type =
-                    config.abs_z_for_for_local_road_obj_outline ? RoadObjectCorner::Type_Local_AbsZ : RoadObjectCorner::Type_Local_RelZ;
+                id_lane.second.inner_border = id_lane.second.inner_border.add(road.lane_offset);
+                id_lane.second.outer_border = id_lane.second.outer_border.add(road.lane_offset);
+            }
+        }
 
-                for (pugi::xml_node object_node : road_node.child("objects").children("object"))
-                {
-                    std::string road_object_id = object_node.attribute("id").as_string("");
-                    CHECK_AND_REPAIR(road.id_to_object.find(road_object_id) == road.id_to_object.end(),
-                                     (std::string("object::id already exists - ") + road_object_id).c_str(),
-                                     road_object_id = road_object_id + std::string("_dup"));
-
-                    RoadObject &road_object = road.id_to_object
-                                                  .insert({road_object_id,
-                                                           RoadObject(road_id,
-                                                                      road_object_id,
-                                                                      object_node.attribute("s").as_double(0),
-                                                                      object_node.attribute("t").as_double(0),
-                                                                      object_node.attribute("zOffset").as_double(0),
-                                                                      object_node.attribute("length").as_double(0),
-                                                                      object_node.attribute("validLength").as_double(0),
-                                                                      object_node.attribute("width").as_double(0),
-                                                                      object_node.attribute("radius").as_double(0),
-                                                                      object_node.attribute("height").as_double(0),
-                                                                      object_node.attribute("hdg").as_double(0),
-                                                                      object_node.attribute("pitch").as_double(0),
-                                                                      object_node.attribute("roll").as_double(0),
-                                                                      object_node.attribute("type").as_string(""),
-                                                                      object_node.attribute("name").as_string(""),
-                                                                      object_node.attribute("orientation").as_string(""))})
-                                                  .first->second;
-                    road_object.xml_node = object_node;
-
-                    CHECK_AND_REPAIR(road_object.s0 >= 0, "object::s < 0", road_object.s0 = 0);
-                    CHECK_AND_REPAIR(road_object.valid_length >= 0, "object::validLength < 0", road_object.valid_length = 0);
-                    CHECK_AND_REPAIR(road_object.length >= 0, "object::length < 0", road_object.length = 0);
-                    CHECK_AND_REPAIR(road_object.width >= 0, "object::width < 0", road_object.width = 0);
-                    CHECK_AND_REPAIR(road_object.radius >= 0, "object::radius < 0", road_object.radius = 0);
-
-                    for (pugi::xml_node repeat_node : object_node.children("repeat"))
-                    {
-                        RoadObjectRepeat road_object_repeat(repeat_node.attribute("s").as_double(NAN),
-                                                            repeat_node.attribute("length").as_double(0),
-                                                            repeat_node.attribute("distance").as_double(0),
-                                                            repeat_node.attribute("tStart").as_double(NAN),
-                                                            repeat_node.attribute("tEnd").as_double(NAN),
-                                                            repeat_node.attribute("widthStart").as_double(NAN),
-                                                            repeat_node.attribute("widthEnd").as_double(NAN),
-                                                            repeat_node.attribute("heightStart").as_double(NAN),
-                                                            repeat_node.attribute("heightEnd").as_double(NAN),
-                                                            repeat_node.attribute("zOffsetStart").as_double(NAN),
-                                                            repeat_node.attribute("zOffsetEnd").as_double(NAN));
-                        road_object_repeat.xml_node = repeat_node;
-
-                        CHECK_AND_REPAIR(
-                            std::isnan(road_object_repeat.s0) || road_object_repeat.s0 >= 0, "object::repeat::s < 0", road_object_repeat.s0 = 0);
-                        CHECK_AND_REPAIR(std::isnan(road_object_repeat.width_start) || road_object_repeat.width_start >= 0,
-                                         "object::repeat::widthStart < 0",
-                                         road_object_repeat.width_start = 0);
-                        CHECK_AND_REPAIR(std::isnan(road_object_repeat.width_end) || road_object_repeat.width_end >= 0,
-                                         "object::repeat::widthStart < 0",
-                                         road_object_repeat.width_end = 0);
-                        CHECK_AND_REPAIR(road_object_repeat.length >= 0, "object::repeat::length < 0", road_object_repeat.length = 0);
-                        CHECK_AND_REPAIR(road_object_repeat.distance >= 0, "object::repeat::distance < 0", road_object_repeat.distance = 0);
-
-                        road_object.repeats.push_back(road_object_repeat);
-                    }
+        road.build_roadmark_tables();
 
-                    for (pugi::xml_node corner_local_node : object_node.child("outline").children("cornerLocal"))
-                    {
-                        const Vec3D pt_local{corner_local_node.attribute("u").as_double(0),
-                                             corner_local_node.attribute("v").as_double(0),
-                                             corner_local_node.attribute("z").as_double(0)};
-
-                        RoadObjectCorner road_object_corner_local(
-                            pt_local, corner_local_node.attribute("height").as_double(0), default_local_outline_type);
-                        road_object_corner_local.xml_node = corner_local_node;
-                        road_object.outline.push_back(road_object_corner_local);
-                    }
+        /* parse road objects */
+        if (config.with_road_objects)
+        {
+            const RoadObjectCorner::Type default_local_outline_type =
+                config.abs_z_for_for_local_road_obj_outline ? RoadObjectCorner::Type_Local_AbsZ : RoadObjectCorner::Type_Local_RelZ;
 
-                    for (pugi::xml_node corner_road_node : object_node.child("outline").children("cornerRoad"))
-                    {
-                        const Vec3D pt_road{corner_road_node.attribute("s").as_double(0),
-                                            corner_road_node.attribute("t").as_double(0),
-                                            corner_road_node.attribute("dz").as_double(0)};
+            for (pugi::xml_node object_node : road_node.child("objects").children("object"))
+            {
+                std::string road_object_id = object_node.attribute("id").as_string("");
+                CHECK_AND_REPAIR(road.id_to_object.find(road_object_id) == road.id_to_object.end(),
+                                 (std::string("object::id already exists - ") + road_object_id).c_str(),
+                                 road_object_id = road_object_id + std::string("_dup"));
+
+                RoadObject &road_object = road.id_to_object
+                                              .insert({road_object_id,
+                                                       RoadObject(road_id,
+                                                                  road_object_id,
+                                                                  object_node.attribute("s").as_double(0),
+                                                                  object_node.attribute("t").as_double(0),
+                                                                  object_node.attribute("zOffset").as_double(0),
+                                                                  object_node.attribute("length").as_double(0),
+                                                                  object_node.attribute("validLength").as_double(0),
+                                                                  object_node.attribute("width").as_double(0),
+                                                                  object_node.attribute("radius").as_double(0),
+                                                                  object_node.attribute("height").as_double(0),
+                                                                  object_node.attribute("hdg").as_double(0),
+                                                                  object_node.attribute("pitch").as_double(0),
+                                                                  object_node.attribute("roll").as_double(0),
+                                                                  object_node.attribute("type").as_string(""),
+                                                                  object_node.attribute("name").as_string(""),
+                                                                  object_node.attribute("orientation").as_string(""))})
+                                              .first->second;
+                keep_xml_node(road_object, object_node, config);
+
+                CHECK_AND_REPAIR(road_object.s0 >= 0, "object::s < 0", road_object.s0 = 0);
+                CHECK_AND_REPAIR(road_object.valid_length >= 0, "object::validLength < 0", road_object.valid_length = 0);
+                CHECK_AND_REPAIR(road_object.length >= 0, "object::length < 0", road_object.length = 0);
+                CHECK_AND_REPAIR(road_object.width >= 0, "object::width < 0", road_object.width = 0);
+                CHECK_AND_REPAIR(road_object.radius >= 0, "object::radius < 0", road_object.radius = 0);
+
+                for (pugi::xml_node repeat_node : object_node.children("repeat"))
+                {
+                    RoadObjectRepeat road_object_repeat(repeat_node.attribute("s").as_double(NAN),
+                                                        repeat_node.attribute("length").as_double(0),
+                                                        repeat_node.attribute("distance").as_double(0),
+                                                        repeat_node.attribute("tStart").as_double(NAN),
+                                                        repeat_node.attribute("tEnd").as_double(NAN),
+                                                        repeat_node.attribute("widthStart").as_double(NAN),
+                                                        repeat_node.attribute("widthEnd").as_double(NAN),
+                                                        repeat_node.attribute("heightStart").as_double(NAN),
+                                                        repeat_node.attribute("heightEnd").as_double(NAN),
+                                                        repeat_node.attribute("zOffsetStart").as_double(NAN),
+                                                        repeat_node.attribute("zOffsetEnd").as_double(NAN));
+                    keep_xml_node(road_object_repeat, repeat_node, config);
+
+                    CHECK_AND_REPAIR(
+                        std::isnan(road_object_repeat.s0) || road_object_repeat.s0 >= 0, "object::repeat::s < 0", road_object_repeat.s0 = 0);
+                    CHECK_AND_REPAIR(std::isnan(road_object_repeat.width_start) || road_object_repeat.width_start >= 0,
+                                     "object::repeat::widthStart < 0",
+                                     road_object_repeat.width_start = 0);
+                    CHECK_AND_REPAIR(std::isnan(road_object_repeat.width_end) || road_object_repeat.width_end >= 0,
+                                     "object::repeat::widthStart < 0",
+                                     road_object_repeat.width_end = 0);
+                    CHECK_AND_REPAIR(road_object_repeat.length >= 0, "object::repeat::length < 0", road_object_repeat.length = 0);
+                    CHECK_AND_REPAIR(road_object_repeat.distance >= 0, "object::repeat::distance < 0", road_object_repeat.distance = 0);
+
+                    road_object.repeats.push_back(road_object_repeat);
+                }
 
-                        RoadObjectCorner road_object_corner_road(pt_road, corner_road_node.attribute("height").as_double(0), RoadObjectCorner::Type_Road);
-                        road_object_corner_road.xml_node = corner_road_node;
-                        road_object.outline.push_back(road_object_corner_road);
-                    }
+                for (pugi::xml_node corner_local_node : object_node.child("outline").children("cornerLocal"))
+                {
+                    const Vec3D pt_local{corner_local_node.attribute("u").as_double(0),
+                                         corner_local_node.attribute("v").as_double(0),
+                                         corner_local_node.attribute("z").as_double(0)};
+
+                    RoadObjectCorner road_object_corner_local(
+                        pt_local, corner_local_node.attribute("height").as_double(0), default_local_outline_type);
+                    keep_xml_node(road_object_corner_local, corner_local_node, config);
+                    road_object.outline.push_back(road_object_corner_local);
                 }
 
-                for (pugi::xml_node signal_node : road_node.child("signals").children("signal"))
+                for (pugi::xml_node corner_road_node : object_node.child("outline").children("cornerRoad"))
                 {
-                    std::string road_signal_id = signal_node.attribute("id").as_string("");
-                    CHECK_AND_REPAIR(road.id_to_signal.find(road_signal_id) == road.id_to_signal.end(),
-                                     (std::string("signal::id already exists - ") + road_signal_id).c_str(),
-                                     road_signal_id = road_signal_id + std::string("_dup"));
-
-                    RoadSignal &road_signal = road.id_to_signal
-                                                  .insert({road_signal_id,
-                                                           RoadSignal(road_id,
-                                                                      road_signal_id,
-                                                                      signal_node.attribute("s").as_double(0),
-                                                                      signal_node.attribute("t").as_double(0),
-                                                                      signal_node.attribute("zOffset").as_double(0),
-                                                                      signal_node.attribute("dynamic").as_bool(0),
-                                                                      signal_node.attribute("width").as_double(0),
-                                                                      signal_node.attribute("height").as_double(0),
-                                                                      signal_node.attribute("hdg").as_double(0),
-                                                                      signal_node.attribute("pitch").as_double(0),
-                                                                      signal_node.attribute("roll").as_double(0),
-                                                                      signal_node.attribute("type").as_string(""),
-                                                                      signal_node.attribute("subtype").as_string(""),
-                                                                      signal_node.attribute("name").as_string(""),
-                                                                      signal_node.attribute("orientation").as_string(""),
-                                                                      signal_node.attribute("country").as_string(""))})
-                                                  .first->second;
-                    road_signal.xml_node = signal_node;
-
-                    CHECK_AND_REPAIR(road_signal.s >= 0, "signal::s < 0", road_signal.s = 0);
-                    CHECK_AND_REPAIR(road_signal.width >= 0, "signal::width < 0", road_signal.width = 0);
+                    const Vec3D pt_road{corner_road_node.attribute("s").as_double(0),
+                                        corner_road_node.attribute("t").as_double(0),
+                                        corner_road_node.attribute("dz").as_double(0)};
+
+                    RoadObjectCorner road_object_corner_road(pt_road, corner_road_node.attribute("height").as_double(0), RoadObjectCorner::Type_Road);
+                    keep_xml_node(road_object_corner_road, corner_road_node, config);
+                    road_object.outline.push_back(road_object_corner_road);
                 }
             }
+
+            for (pugi::xml_node signal_node : road_node.child("signals").children("signal"))
+            {
+                std::string road_signal_id = signal_node.attribute("id").as_string("");
+                CHECK_AND_REPAIR(road.id_to_signal.find(road_signal_id) == road.id_to_signal.end(),
+                                 (std::string("signal::id already exists - ") + road_signal_id).c_str(),
+                                 road_signal_id = road_signal_id + std::string("_dup"));
+
+                RoadSignal &road_signal = road.id_to_signal
+                                              .insert({road_signal_id,
+                                                       RoadSignal(road_id,
+                                                                  road_signal_id,
+                                                                  signal_node.attribute("s").as_double(0),
+                                                                  signal_node.attribute("t").as_double(0),
+                                                                  signal_node.attribute("zOffset").as_double(0),
+                                                                  signal_node.attribute("dynamic").as_bool(0),
+                                                                  signal_node.attribute("width").as_double(0),
+                                                                  signal_node.attribute("height").as_double(0),
+                                                                  signal_node.attribute("hdg").as_double(0),
+                                                                  signal_node.attribute("pitch").as_double(0),
+                                                                  signal_node.attribute("roll").as_double(0),
+                                                                  signal_node.attribute("type").as_string(""),
+                                                                  signal_node.attribute("subtype").as_string(""),
+                                                                  signal_node.attribute("name").as_string(""),
+                                                                  signal_node.attribute("orientation").as_string(""),
+                                                                  signal_node.attribute("country").as_string(""))})
+                                              .first->second;
+                keep_xml_node(road_signal, signal_node, config);
+
+                CHECK_AND_REPAIR(road_signal.s >= 0, "signal::s < 0", road_signal.s = 0);
+                CHECK_AND_REPAIR(road_signal.width >= 0, "signal::width < 0", road_signal.width = 0);
+            }
         }
     }
 
@@ -591,10 +907,47 @@ namespace odr
 
     std::vector<Junction> OpenDriveMap::get_junctions() const { return get_map_values(this->id_to_junction); }
 
+    MapValues<std::string, Road> OpenDriveMap::roads() const { return MapValues<std::string, Road>(this->id_to_road); }
+
+    MapValues<std::string, Junction> OpenDriveMap::junctions() const { return MapValues<std::string, Junction>(this->id_to_junction); }
+
+    const LaneSection &OpenDriveMap::lanesection(uint32_t index) const
+    {
+        const LaneSection *lanesec = this->lanesection_by_index_.at(index);
+        if (lanesec == nullptr)
+            throw std::out_of_range("lane section of a road that isn't loaded");
+        return *lanesec;
+    }
+
+    const Lane &OpenDriveMap::lane(const LaneKey &key) const
+    {
+        if (key.is_indexed())
+            return this->lanesection(key.lanesection_index).id_to_lane.at(key.lane_id);
+        return this->id_to_road.at(key.road_id).s_to_lanesection.at(key.lanesection_s0).id_to_lane.at(key.lane_id);
+    }
+
     RoutingGraph OpenDriveMap::get_routing_graph() const
     {
         RoutingGraph routing_graph;
 
+        /* lane ends, for shortest_path_astar() */
+        for (const Road &road : this->roads())
+        {
+            for (const LaneSection &lanesec : road.lanesections())
+            {
+                const double s_end = road.get_lanesection_end(lanesec);
+                for (const Lane &lane : lanesec.lanes())
+                {
+                    auto center = [&](const double s)
+                    {
+                        const Vec3D pt = road.get_xyz(s, 0.5 * (lane.inner_border.get(s) + lane.outer_border.get(s)), 0.0);
+                        return Vec2D{pt[0], pt[1]};
+                    };
+                    routing_graph.lane_key_to_ends[lane.key] = {center(lanesec.s0), center(s_end)};
+                }
+            }
+        }
+
         /* find lane successors/predecessors */
         for (const bool find_successor : {true, false})
         {
@@ -617,22 +970,18 @@ namespace odr
                 {
                     const LaneSection &lanesec = s_lanesec_iter->second;
                     const LaneSection *next_lanesec = nullptr;
-                    const Road *next_lanesecs_road = nullptr;
 
                     if (find_successor && std::next(s_lanesec_iter) == road.s_to_lanesection.end())
                     {
                         next_lanesec = &next_road_contact_lanesec; // take next road to find successor
-                        next_lanesecs_road = &next_road;
                     }
                     else if (!find_successor && s_lanesec_iter == road.s_to_lanesection.begin())
                     {
                         next_lanesec = &next_road_contact_lanesec; // take prev. road to find predecessor
-                        next_lanesecs_road = &next_road;
                     }
                     else
                     {
                         next_lanesec = find_successor ? &(std::next(s_lanesec_iter)->second) : &(std::prev(s_lanesec_iter)->second);
-                        next_lanesecs_road = &road;
                     }
 
                     for (const auto &id_lane : lanesec.id_to_lane)
@@ -649,16 +998,11 @@ namespace odr
 
                         const Lane &from_lane = find_successor ? lane : next_lane;
                         const LaneSection &from_lanesection = find_successor ? lanesec : *next_lanesec;
-                        const Road &from_road = find_successor ? road : *next_lanesecs_road;
 
                         const Lane &to_lane = find_successor ? next_lane : lane;
-                        const LaneSection &to_lanesection = find_successor ? *next_lanesec : lanesec;
-                        const Road &to_road = find_successor ? *next_lanesecs_road : road;
 
-                        const LaneKey from(from_road.id, from_lanesection.s0, from_lane.id);
-                        const LaneKey to(to_road.id, to_lanesection.s0, to_lane.id);
                         const double lane_length = road.get_lanesection_length(from_lanesection);
-                        routing_graph.add_edge(RoutingGraphEdge(from, to, lane_length));
+                        routing_graph.add_edge(RoutingGraphEdge(from_lane.key, to_lane.key, lane_length));
                     }
                 }
             }
@@ -699,10 +1043,8 @@ namespace odr
                     const Lane &from_lane = from_lane_iter->second;
                     const Lane &to_lane = to_lane_iter->second;
 
-                    const LaneKey from(incoming_road.id, incoming_lanesec.s0, from_lane.id);
-                    const LaneKey to(connecting_road.id, connecting_lanesec.s0, to_lane.id);
                     const double lane_length = incoming_road.get_lanesection_length(incoming_lanesec);
-                    routing_graph.add_edge(RoutingGraphEdge(from, to, lane_length));
+                    routing_graph.add_edge(RoutingGraphEdge(from_lane.key, to_lane.key, lane_length));
                 }
             }
         }
@@ -711,206 +1053,203 @@ namespace odr
     }
 
     // https://www.boost.org/doc/libs/1_81_0/libs/geometry/doc/html/geometry/spatial_indexes/rtree_examples/index_of_polygons_stored_in_vector.html
-    bgi::rtree<value, bgi::rstar<16, 4>> OpenDriveMap::generate_mesh_tree()
+    std::shared_ptr<const bgi::rtree<value, bgi::rstar<16, 4>>> OpenDriveMap::generate_mesh_tree() const
     {
-        std::cout << "Start of generate_mesh_tree()" << std::endl;
-        bgi::rtree<value, bgi::rstar<16, 4>> rtree;
-
-        std::vector<std::pair<Lane, ring>> polys = get_lane_polygons(1.0, false);
-        std::printf("get_road_polygons returned %i shapes\n", polys.size());
-
-        // fill the spatial index
-        for (unsigned i = 0; i < polys.size(); ++i)
-        {
-            // calculate polygon bounding box
-            box b = bg::return_envelope<box>(polys[i].second);
-            // insert new value
-            rtree.insert(std::make_pair(b, i));
-            // std::printf("Inserting box (%f, %f)-(%f,%f)\n", b.min_corner().get<0>(), b.min_corner().get<1>(), b.max_corner().get<0>(), b.max_corner().get<1>());
-        }
-        // std::printf("End of generate_mesh_tree(), tree has %i shapes\n", rtree.size());
-        return rtree;
+        std::call_once(this->mesh_tree_built_, [&]()
+                       {
+            const std::vector<LanePair> &polys = get_lane_polygons(1.0, false);
+            std::vector<value> envelopes;
+            envelopes.reserve(polys.size());
+            for (unsigned i = 0; i < polys.size(); ++i)
+                envelopes.emplace_back(bg::return_envelope<box>(polys[i].second), i);
+            // The range constructor packs the tree, which is quicker than
+            // inserting one box at a time and gives a better tree.
+            this->mesh_tree_ = std::make_shared<const bgi::rtree<value, bgi::rstar<16, 4>>>(envelopes); });
+        return this->mesh_tree_;
     }
 
-    std::vector<std::pair<RoadObject, point>> OpenDriveMap::get_road_object_centers()
+    const std::vector<std::pair<RoadObject, point>> &OpenDriveMap::get_road_object_centers() const
     {
-        if (object_centers_.size() > 0)
-            return object_centers_; // No need to calculate twice.
-
-        for (Road road : get_roads())
-        {
-            for (RoadObject obj : road.get_road_objects())
-            {
-                float s = obj.s0;
-                float t = obj.t0;
-                odr::Vec3D xyz = road.get_surface_pt(s, t);
-                point pt = point(xyz[0], xyz[1]);
-                object_centers_.push_back(std::make_pair(obj, pt));
-            }
-            for (RoadSignal sig : road.get_signals())
+        std::call_once(this->object_centers_built_, [&]()
+                       {
+            for (const Road &road : roads())
             {
-                RoadObject obj(road.id, sig.id, sig.s, sig.t, sig.z0,
-                               0.0, 0.0, sig.width, 0.1, sig.height, sig.hdg, sig.pitch,
-                               sig.roll, sig.type, sig.name, sig.orientation);
-                float s = obj.s0;
-                float t = obj.t0;
-                odr::Vec3D xyz = road.get_surface_pt(s, t);
-                point pt = point(xyz[0], xyz[1]);
-                object_centers_.push_back(std::make_pair(obj, pt));
-            }
-        }
-        return object_centers_;
+                for (const RoadObject &obj : road.road_objects())
+                {
+                    float s = obj.s0;
+                    float t = obj.t0;
+                    odr::Vec3D xyz = road.get_surface_pt(s, t);
+                    point pt = point(xyz[0], xyz[1]);
+                    this->object_centers_.push_back(std::make_pair(obj, pt));
+                }
+                for (const RoadSignal &sig : road.signals())
+                {
+                    RoadObject obj(road.id, sig.id, sig.s, sig.t, sig.z0,
+                                   0.0, 0.0, sig.width, 0.1, sig.height, sig.hdg, sig.pitch,
+                                   sig.roll, sig.type, sig.name, sig.orientation);
+                    float s = obj.s0;
+                    float t = obj.t0;
+                    odr::Vec3D xyz = road.get_surface_pt(s, t);
+                    point pt = point(xyz[0], xyz[1]);
+                    this->object_centers_.push_back(std::make_pair(obj, pt));
+                }
+            } });
+        return this->object_centers_;
     }
 
-    bgi::rtree<value, bgi::rstar<16, 4>> OpenDriveMap::generate_object_tree()
+    std::shared_ptr<const bgi::rtree<value, bgi::rstar<16, 4>>> OpenDriveMap::generate_object_tree() const
     {
-        std::cout << "Start of generate_object_tree()" << std::endl;
-        bgi::rtree<value, bgi::rstar<16, 4>> rtree;
-
-        if (object_centers_.size() < 1)
-            get_road_object_centers();
-
-        std::printf("map has %i objects\n", object_centers_.size());
+        std::call_once(this->object_tree_built_, [&]()
+                       {
+            const std::vector<std::pair<RoadObject, point>> &centers = get_road_object_centers();
+            std::vector<value> envelopes;
+            envelopes.reserve(centers.size());
+            for (unsigned i = 0; i < centers.size(); ++i)
+                envelopes.emplace_back(bg::return_envelope<box>(centers[i].second), i);
+            this->object_tree_ = std::make_shared<const bgi::rtree<value, bgi::rstar<16, 4>>>(envelopes); });
+        return this->object_tree_;
+    }
 
-        // fill the spatial index
-        for (unsigned i = 0; i < object_centers_.size(); ++i)
+    RoadNetworkMesh OpenDriveMap::get_road_network_mesh(double eps) const
+    {
+        std::shared_ptr<const RoadNetworkMesh> road_mesh;
         {
-            // calculate polygon bounding box
-            box b = bg::return_envelope<box>(object_centers_[i].second);
-            // insert new value
-            rtree.insert(std::make_pair(b, i));
-            // std::printf("Inserting box (%f, %f)-(%f,%f)\n", b.min_corner().get<0>(), b.min_corner().get<1>(), b.max_corner().get<0>(), b.max_corner().get<1>());
+            // Held through the build, so callers at the same eps wait for
+            // it rather than each building their own
+            std::lock_guard<std::mutex> lock(this->road_mesh_mutex_);
+            if (this->road_mesh_ == nullptr || this->road_mesh_eps_ != eps)
+            {
+                this->road_mesh_ = std::make_shared<const RoadNetworkMesh>(this->build_road_network_mesh(eps));
+                this->road_mesh_eps_ = eps;
+            }
+            road_mesh = this->road_mesh_;
         }
-        // std::printf("End of generate_mesh_tree(), tree has %i shapes\n", rtree.size());
-        return rtree;
+        return *road_mesh;
     }
 
-    RoadNetworkMesh OpenDriveMap::get_road_network_mesh(double eps)
+    RoadNetworkMesh OpenDriveMap::build_road_network_mesh(double eps) const
     {
-        std::cout << "Start of get_road_network_mesh()" << std::endl;
-        if (this->road_mesh_ != nullptr)
-            return *this->road_mesh_;
-
-        RoadNetworkMesh out_mesh;
-        LanesMesh &lanes_mesh = out_mesh.lanes_mesh;
-
-        for (const auto &id_road : this->id_to_road)
-        {
-            const Road &road = id_road.second;
-            lanes_mesh.road_start_indices[lanes_mesh.vertices.size()] = road.id;
-
-            for (const auto &s_lanesec : road.s_to_lanesection)
+        std::vector<const Road *> road_list;
+        road_list.reserve(this->id_to_road.size());
+        for (const Road &road : this->roads())
+            road_list.push_back(&road);
+
+        // Each road is meshed on its own, with indices from 0, then the
+        // meshes are appended in id order. The result doesn't depend on
+        // the thread count.
+        std::vector<RoadNetworkMesh> road_meshes(road_list.size());
+        for_each_road(road_list.size(), [&](std::size_t i)
+                      {
+            const Road &road = *road_list[i];
+            LanesMesh &road_mesh = road_meshes[i].lanes_mesh;
+            road_mesh.road_start_indices[0] = road.id;
+
+            for (const LaneSection &lanesec : road.lanesections())
             {
-                const LaneSection &lanesec = s_lanesec.second;
-                lanes_mesh.lanesec_start_indices[lanes_mesh.vertices.size()] = lanesec.s0;
-                for (const auto &id_lane : lanesec.id_to_lane)
+                road_mesh.lanesec_start_indices[road_mesh.vertices.size()] = lanesec.s0;
+                for (const Lane &lane : lanesec.lanes())
                 {
-                    const Lane &lane = id_lane.second;
-                    const std::size_t lanes_idx_offset = lanes_mesh.vertices.size();
-                    lanes_mesh.lane_start_indices[lanes_idx_offset] = lane.id;
-                    lanes_mesh.add_mesh(road.get_lane_mesh(lane, eps));
+                    road_mesh.lane_start_indices[road_mesh.vertices.size()] = lane.id;
+                    road_mesh.add_mesh(road.get_lane_mesh(lane, eps));
                 }
-            }
-        }
-
-        this->road_mesh_ = std::make_unique<RoadNetworkMesh>(out_mesh);
+            } });
 
-        std::cout << "End of get_road_network_mesh()" << std::endl;
-        return out_mesh;
+        // Later starts at the same vertex overwrite earlier ones, as when
+        // the meshes were built in one pass.
+        return RoadNetworkMesh::concat(road_meshes);
     }
 
-    std::vector<std::pair<Lane, ring>> OpenDriveMap::get_lane_polygons(float res, bool drivable_only)
+    const std::vector<LanePair> &OpenDriveMap::get_lane_polygons(float res, bool drivable_only) const
     {
-        if (drivable_only && this->drivable_lane_polygons_ != nullptr)
-            return *this->drivable_lane_polygons_;
-        if (this->lane_polygons_ != nullptr)
-            return *this->lane_polygons_;
-
-        std::vector<std::pair<Lane, ring>> polys;
+        LanePolygonCache *cache;
+        {
+            std::lock_guard<std::mutex> lock(this->lane_polygons_mutex_);
+            cache = &this->lane_polygons_[std::make_pair(res, drivable_only)];
+        }
+        // Built outside the lock, so other keys aren't held up. Callers
+        // with this key wait in call_once until it's built.
+        std::call_once(cache->built, [&]()
+                       { cache->polys = build_lane_polygons(res, drivable_only); });
+        return cache->polys;
+    }
 
-        int idx = 0;
+    std::vector<LanePair> OpenDriveMap::build_lane_polygons(float res, bool drivable_only) const
+    {
+        std::vector<const Road *> road_list;
+        road_list.reserve(this->id_to_road.size());
+        for (const Road &road : this->roads())
+            road_list.push_back(&road);
+
+        // One buffer per road, concatenated in id order, so lane k is the
+        // same lane whatever the thread count.
+        std::vector<std::vector<LanePair>> road_polys(road_list.size());
+        for_each_road(road_list.size(), [&](std::size_t i)
+                      { build_road_lane_polygons(*road_list[i], res, drivable_only, road_polys[i]); });
+
+        std::size_t total = 0;
+        for (const std::vector<LanePair> &polys : road_polys)
+            total += polys.size();
+
+        std::vector<LanePair> polys;
+        polys.reserve(total);
+        for (std::vector<LanePair> &road : road_polys)
+            std::move(road.begin(), road.end(), std::back_inserter(polys));
+        return polys;
+    }
 
-        std::ofstream f("points2.csv");
-        for (odr::Road road : this->get_roads())
+    void OpenDriveMap::build_road_lane_polygons(const Road &road, float res, bool drivable_only, std::vector<LanePair> &out) const
+    {
+        std::vector<double> s_vals; // Reused for every lane
+        for (const LaneSection &lsec : road.lanesections())
         {
-            for (odr::LaneSection lsec : road.get_lanesections())
+            for (const Lane &lane : lsec.lanes())
             {
-                for (odr::Lane lane : lsec.get_lanes())
-                {
-                    if (drivable_only && lane.type != "driving")
-                        continue;
-                    const double s_end = road.get_lanesection_end(lane.key.lanesection_s0);
-                    const double s_start = lane.key.lanesection_s0;
-
-                    std::set<double> s_vals = road.ref_line.approximate_linear(res, s_start, s_end);
-                    std::set<double> s_vals_outer_brdr = lane.outer_border.approximate_linear(res, s_start, s_end);
-                    s_vals.insert(s_vals_outer_brdr.begin(), s_vals_outer_brdr.end());
-                    std::set<double> s_vals_inner_brdr = lane.inner_border.approximate_linear(res, s_start, s_end);
-                    s_vals.insert(s_vals_inner_brdr.begin(), s_vals_inner_brdr.end());
-                    std::set<double> s_vals_lane_offset = road.lane_offset.approximate_linear(res, s_start, s_end);
-                    s_vals.insert(s_vals_lane_offset.begin(), s_vals_lane_offset.end());
-
-                    std::set<double> s_vals_lane_height = get_map_keys(lane.s_to_height_offset);
-                    s_vals.insert(s_vals_lane_height.begin(), s_vals_lane_height.end());
-
-                    const double t_max = lane.outer_border.get_max(s_start, s_end);
-                    std::set<double> s_vals_superelev = road.superelevation.approximate_linear(std::atan(res / std::abs(t_max)), s_start, s_end);
-                    s_vals.insert(s_vals_superelev.begin(), s_vals_superelev.end());
-
-                    /* thin out s_vals array, be removing s vals closer than res to each other */
-                    for (auto s_iter = s_vals.begin(); s_iter != s_vals.end();)
-                    {
-                        if (std::next(s_iter) != s_vals.end() && std::next(s_iter, 2) != s_vals.end() && ((*std::next(s_iter)) - *s_iter) <= res)
-                            s_iter = std::prev(s_vals.erase(std::next(s_iter)));
-                        else
-                            s_iter++;
-                    }
-
-                    std::vector<odr::point> outer_pts;
-                    std::vector<odr::point> inner_pts;
+                if (drivable_only && lane.type != "driving")
+                    continue;
+                const double s_end = road.get_lanesection_end(lane.key.lanesection_s0);
+                const double s_start = lane.key.lanesection_s0;
 
-                    odr::ring lane_ring;
+                road.approximate_lane_mesh_linear(lane, s_start, s_end, res, s_vals);
 
-                    point start_pt;
-                    bool start_pt_added = false;
+                std::vector<odr::point> outer_pts;
+                std::vector<odr::point> inner_pts;
 
-                    for (const double &s : s_vals)
-                    {
-                        const double t_inner_brdr = lane.inner_border.get(s);
+                odr::ring lane_ring;
 
-                        auto inner_border_pt = road.get_surface_pt(s, t_inner_brdr);
+                point start_pt;
+                bool start_pt_added = false;
 
-                        bg::append(lane_ring, point(inner_border_pt[0], inner_border_pt[1]));
-                        if (!start_pt_added)
-                        {
-                            start_pt = point(inner_border_pt[0], inner_border_pt[1]);
-                            start_pt_added = true;
-                        }
-                    }
-                    for (const double &s : s_vals)
-                    {
-                        const double t_outer_brdr = lane.outer_border.get(s_end - s);
-                        auto outer_border_pt = road.get_surface_pt(s_end - s, t_outer_brdr);
-
-                        bg::append(lane_ring, point(outer_border_pt[0], outer_border_pt[1]));
-                    }
-                    bg::append(lane_ring, start_pt); // close the ring
-                    polys.push_back(std::pair<Lane, ring>(lane, lane_ring));
-                    idx++;
+                // Both borders in one batch: the inner one along s, then the
+                // outer one at s_end - s
+                const std::size_t n = s_vals.size();
+                std::vector<double> s_brdr(2 * n), t_brdr(2 * n);
+                std::size_t i = 0;
+                for (const double &s : s_vals)
+                {
+                    s_brdr[i] = s;
+                    s_brdr[n + i] = s_end - s;
+                    i++;
+                }
+                lane.inner_border.get(s_brdr.data(), n, t_brdr.data());
+                lane.outer_border.get(s_brdr.data() + n, n, t_brdr.data() + n);
+                std::vector<Vec3D> brdr_pts(2 * n);
+                road.get_surface_pt(s_brdr.data(), t_brdr.data(), 2 * n, brdr_pts.data());
 
-                    for (auto pt : lane_ring)
+                for (std::size_t k = 0; k < n; k++)
+                {
+                    bg::append(lane_ring, point(brdr_pts[k][0], brdr_pts[k][1]));
+                    if (!start_pt_added)
                     {
-                        f << idx << ',' << pt.get<0>() << ',' << pt.get<1>() << std::endl;
+                        start_pt = point(brdr_pts[k][0], brdr_pts[k][1]);
+                        start_pt_added = true;
                     }
                 }
+                for (std::size_t k = n; k < 2 * n; k++)
+                    bg::append(lane_ring, point(brdr_pts[k][0], brdr_pts[k][1]));
+                bg::append(lane_ring, start_pt); // close the ring
+                out.emplace_back(lane, std::move(lane_ring));
             }
         }
-
-        if (drivable_only)
-            this->drivable_lane_polygons_ = std::make_unique<std::vector<std::pair<Lane, ring>>>(polys);
-        else
-            this->lane_polygons_ = std::make_unique<std::vector<std::pair<Lane, ring>>>(polys);
-        return polys;
     }
 
 } // namespace odr
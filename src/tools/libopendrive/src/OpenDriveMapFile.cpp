@@ -0,0 +1,756 @@
+#include "Geometries/Arc.h"
+#include "Geometries/CubicSpline.h"
+#include "Geometries/Line.h"
+#include "Geometries/ParamPoly3.h"
+#include "Geometries/RoadGeometry.h"
+#include "Geometries/Spiral.h"
+#include "OpenDriveMap.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A saved map is a Header, then the map written field by field in the order
+// save() writes them: counts and string lengths as uint64, enums as int32,
+// and each spline's s0 values and polys as one block apiece, so they load
+// with a memcpy each. Integers and doubles are as they are in memory;
+// ENDIAN_CHECK turns away files from a machine of the other byte order.
+
+namespace odr
+{
+    namespace
+    {
+        constexpr char MAGIC[8] = {'O', 'D', 'R', 'M', 'A', 'P', 'B', 'N'};
+        // Bump whenever what save() writes changes.
+        constexpr uint32_t VERSION = 1;
+        constexpr uint32_t ENDIAN_CHECK = 0x01020304;
+
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t endian_check;
+            uint64_t payload_bytes;
+        };
+
+        static_assert(std::is_trivially_copyable<Poly3>::value && sizeof(Poly3) == 4 * sizeof(double), "Poly3 is saved as 4 doubles");
+
+        class MapWriter
+        {
+        public:
+            template <typename T>
+            void put(const T &value)
+            {
+                static_assert(std::is_arithmetic<T>::value, "only numbers are written as they are");
+                const char *bytes = reinterpret_cast<const char *>(&value);
+                data_.insert(data_.end(), bytes, bytes + sizeof(T));
+            }
+
+            void put_count(std::size_t count) { put(uint64_t(count)); }
+
+            void put_string(const std::string &str)
+            {
+                put_count(str.size());
+                data_.insert(data_.end(), str.begin(), str.end());
+            }
+
+            template <typename T>
+            void put_block(const std::vector<T> &items)
+            {
+                put_count(items.size());
+                const char *bytes = reinterpret_cast<const char *>(items.data());
+                data_.insert(data_.end(), bytes, bytes + items.size() * sizeof(T));
+            }
+
+            void put_spline(const CubicSpline &spline)
+            {
+                put_block(spline.s0_vals);
+                put_block(spline.polys);
+            }
+
+            const std::vector<char> &data() const { return data_; }
+
+        private:
+            std::vector<char> data_;
+        };
+
+        class MapReader
+        {
+        public:
+            MapReader(const char *data, std::size_t size) : pos_(data), end_(data + size) {}
+
+            template <typename T>
+            T get()
+            {
+                static_assert(std::is_arithmetic<T>::value, "only numbers are read as they are");
+                T value;
+                std::memcpy(&value, take(sizeof(T)), sizeof(T));
+                return value;
+            }
+
+            // A count of items at least min_item_bytes each, so a corrupt
+            // count can't ask for more than the file holds
+            std::size_t get_count(std::size_t min_item_bytes)
+            {
+                const uint64_t count = get<uint64_t>();
+                if (min_item_bytes > 0 && count > uint64_t(end_ - pos_) / min_item_bytes)
+                    throw std::runtime_error("saved map is truncated");
+                return std::size_t(count);
+            }
+
+            std::string get_string()
+            {
+                const std::size_t length = get_count(1);
+                const char *chars = take(length);
+                return std::string(chars, length);
+            }
+
+            template <typename T>
+            void get_block(std::vector<T> &items)
+            {
+                const std::size_t count = get_count(sizeof(T));
+                items.resize(count);
+                std::memcpy(items.data(), take(count * sizeof(T)), count * sizeof(T));
+            }
+
+            void get_spline(CubicSpline &spline)
+            {
+                get_block(spline.s0_vals);
+                get_block(spline.polys);
+                if (spline.s0_vals.size() != spline.polys.size() || !std::is_sorted(spline.s0_vals.begin(), spline.s0_vals.end()))
+                    throw std::runtime_error("saved map has a malformed spline");
+            }
+
+            bool done() const { return pos_ == end_; }
+
+        private:
+            const char *take(std::size_t bytes)
+            {
+                if (bytes > std::size_t(end_ - pos_))
+                    throw std::runtime_error("saved map is truncated");
+                const char *start = pos_;
+                pos_ += bytes;
+                return start;
+            }
+
+            const char *pos_;
+            const char *end_;
+        };
+
+        // The file, mapped read-only for as long as it's being read
+        class MappedFile
+        {
+        public:
+            explicit MappedFile(const std::string &path)
+            {
+                const int fd = open(path.c_str(), O_RDONLY);
+                if (fd < 0)
+                    throw std::runtime_error("can't open saved map " + path);
+                struct stat st;
+                if (fstat(fd, &st) == 0 && st.st_size > 0)
+                {
+                    size_ = std::size_t(st.st_size);
+                    data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                }
+                close(fd);
+                if (data_ == nullptr || data_ == MAP_FAILED)
+                    throw std::runtime_error("can't map saved map " + path);
+            }
+            ~MappedFile() { munmap(data_, size_); }
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            const char *data() const { return static_cast<const char *>(data_); }
+            std::size_t size() const { return size_; }
+
+        private:
+            void *data_ = nullptr;
+            std::size_t size_ = 0;
+        };
+
+        void put_geometry(MapWriter &out, const RoadGeometry &geometry)
+        {
+            out.put(int32_t(geometry.type));
+            out.put(geometry.s0);
+            out.put(geometry.x0);
+            out.put(geometry.y0);
+            out.put(geometry.hdg0);
+            out.put(geometry.length);
+            switch (geometry.type)
+            {
+            case GeometryType_Line:
+                break;
+            case GeometryType_Arc:
+                out.put(static_cast<const Arc &>(geometry).curvature);
+                break;
+            case GeometryType_Spiral:
+            {
+                const Spiral &spiral = static_cast<const Spiral &>(geometry);
+                out.put(spiral.curv_start);
+                out.put(spiral.curv_end);
+                break;
+            }
+            case GeometryType_ParamPoly3:
+            {
+                const ParamPoly3 &poly = static_cast<const ParamPoly3 &>(geometry);
+                for (const double coeff : {poly.aU, poly.bU, poly.cU, poly.dU, poly.aV, poly.bV, poly.cV, poly.dV})
+                    out.put(coeff);
+                out.put(uint8_t(poly.pRange_normalized));
+                break;
+            }
+            }
+        }
+
+        std::unique_ptr<RoadGeometry> get_geometry(MapReader &in)
+        {
+            const int32_t type = in.get<int32_t>();
+            const double s0 = in.get<double>();
+            const double x0 = in.get<double>();
+            const double y0 = in.get<double>();
+            const double hdg0 = in.get<double>();
+            const double length = in.get<double>();
+            switch (type)
+            {
+            case GeometryType_Line:
+                return std::make_unique<Line>(s0, x0, y0, hdg0, length);
+            case GeometryType_Arc:
+                return std::make_unique<Arc>(s0, x0, y0, hdg0, length, in.get<double>());
+            case GeometryType_Spiral:
+            {
+                const double curv_start = in.get<double>();
+                const double curv_end = in.get<double>();
+                return std::make_unique<Spiral>(s0, x0, y0, hdg0, length, curv_start, curv_end);
+            }
+            case GeometryType_ParamPoly3:
+            {
+                double coeffs[8];
+                for (double &coeff : coeffs)
+                    coeff = in.get<double>();
+                const bool pRange_normalized = in.get<uint8_t>() != 0;
+                return std::make_unique<ParamPoly3>(
+                    s0, x0, y0, hdg0, length, coeffs[0], coeffs[1], coeffs[2], coeffs[3], coeffs[4], coeffs[5], coeffs[6], coeffs[7], pRange_normalized);
+            }
+            default:
+                throw std::runtime_error("saved map has an unknown geometry type");
+            }
+        }
+
+        void put_road_link(MapWriter &out, const RoadLink &link)
+        {
+            out.put_string(link.id);
+            out.put(int32_t(link.type));
+            out.put(int32_t(link.contact_point));
+        }
+
+        RoadLink get_road_link(MapReader &in)
+        {
+            std::string id = in.get_string();
+            const RoadLink::Type type = RoadLink::Type(in.get<int32_t>());
+            const RoadLink::ContactPoint contact_point = RoadLink::ContactPoint(in.get<int32_t>());
+            return RoadLink(std::move(id), type, contact_point);
+        }
+
+        void put_lane(MapWriter &out, const Lane &lane)
+        {
+            out.put(int32_t(lane.id));
+            out.put(uint8_t(lane.level));
+            out.put(int32_t(lane.predecessor));
+            out.put(int32_t(lane.successor));
+            out.put_string(lane.type);
+            out.put_spline(lane.lane_width);
+            out.put_spline(lane.outer_border);
+            out.put_spline(lane.inner_border);
+
+            out.put_count(lane.s_to_height_offset.size());
+            for (const auto &s_offset : lane.s_to_height_offset)
+            {
+                out.put(s_offset.first);
+                out.put(s_offset.second.inner);
+                out.put(s_offset.second.outer);
+            }
+
+            out.put_count(lane.roadmark_groups.size());
+            for (const RoadMarkGroup &group : lane.roadmark_groups)
+            {
+                out.put(group.width);
+                out.put(group.height);
+                out.put(group.s_offset);
+                out.put_string(group.type);
+                out.put_string(group.weight);
+                out.put_string(group.color);
+                out.put_string(group.material);
+                out.put_string(group.lane_change);
+                out.put_count(group.roadmark_lines.size());
+                for (const RoadMarksLine &line : group.roadmark_lines)
+                {
+                    out.put(line.group_s0);
+                    out.put(line.width);
+                    out.put(line.length);
+                    out.put(line.space);
+                    out.put(line.t_offset);
+                    out.put(line.s_offset);
+                    out.put_string(line.name);
+                    out.put_string(line.rule);
+                }
+            }
+        }
+
+        Lane get_lane(MapReader &in, const std::string &road_id, double lanesection_s0)
+        {
+            const int id = in.get<int32_t>();
+            const bool level = in.get<uint8_t>() != 0;
+            const int predecessor = in.get<int32_t>();
+            const int successor = in.get<int32_t>();
+            Lane lane(road_id, lanesection_s0, id, level, in.get_string());
+            lane.predecessor = predecessor;
+            lane.successor = successor;
+            in.get_spline(lane.lane_width);
+            in.get_spline(lane.outer_border);
+            in.get_spline(lane.inner_border);
+
+            for (std::size_t num_offsets = in.get_count(3 * sizeof(double)); num_offsets > 0; num_offsets--)
+            {
+                const double s = in.get<double>();
+                const double inner = in.get<double>();
+                const double outer = in.get<double>();
+                lane.s_to_height_offset.insert({s, HeightOffset(inner, outer)});
+            }
+
+            for (std::size_t num_groups = in.get_count(3 * sizeof(double)); num_groups > 0; num_groups--)
+            {
+                const double width = in.get<double>();
+                const double height = in.get<double>();
+                const double s_offset = in.get<double>();
+                std::string type = in.get_string();
+                std::string weight = in.get_string();
+                std::string color = in.get_string();
+                std::string material = in.get_string();
+                std::string lane_change = in.get_string();
+                RoadMarkGroup group(road_id, lanesection_s0, id, width, height, s_offset, type, weight, color, material, lane_change);
+                for (std::size_t num_lines = in.get_count(6 * sizeof(double)); num_lines > 0; num_lines--)
+                {
+                    const double group_s0 = in.get<double>();
+                    const double line_width = in.get<double>();
+                    const double length = in.get<double>();
+                    const double space = in.get<double>();
+                    const double t_offset = in.get<double>();
+                    const double line_s_offset = in.get<double>();
+                    std::string name = in.get_string();
+                    std::string rule = in.get_string();
+                    group.roadmark_lines.emplace(road_id, lanesection_s0, id, group_s0, line_width, length, space, t_offset, line_s_offset, name, rule);
+                }
+                lane.roadmark_groups.emplace(std::move(group));
+            }
+            return lane;
+        }
+
+        void put_road_object(MapWriter &out, const RoadObject &obj)
+        {
+            out.put_string(obj.id);
+            out.put_string(obj.type);
+            out.put_string(obj.name);
+            out.put_string(obj.orientation);
+            for (const double val : {obj.s0, obj.t0, obj.z0, obj.length, obj.valid_length, obj.width, obj.radius, obj.height, obj.hdg, obj.pitch, obj.roll})
+                out.put(val);
+
+            out.put_count(obj.repeats.size());
+            for (const RoadObjectRepeat &repeat : obj.repeats)
+            {
+                for (const double val : {repeat.s0,
+                                         repeat.length,
+                                         repeat.distance,
+                                         repeat.t_start,
+                                         repeat.t_end,
+                                         repeat.width_start,
+                                         repeat.width_end,
+                                         repeat.height_start,
+                                         repeat.height_end,
+                                         repeat.z_offset_start,
+                                         repeat.z_offset_end})
+                    out.put(val);
+            }
+
+            out.put_count(obj.outline.size());
+            for (const RoadObjectCorner &corner : obj.outline)
+            {
+                for (const double val : corner.pt)
+                    out.put(val);
+                out.put(corner.height);
+                out.put(int32_t(corner.type));
+            }
+        }
+
+        RoadObject get_road_object(MapReader &in, const std::string &road_id)
+        {
+            std::string id = in.get_string();
+            std::string type = in.get_string();
+            std::string name = in.get_string();
+            std::string orientation = in.get_string();
+            double vals[11];
+            for (double &val : vals)
+                val = in.get<double>();
+            RoadObject obj(road_id, id, vals[0], vals[1], vals[2], vals[3], vals[4], vals[5], vals[6], vals[7], vals[8], vals[9], vals[10], type, name, orientation);
+
+            for (std::size_t num_repeats = in.get_count(11 * sizeof(double)); num_repeats > 0; num_repeats--)
+            {
+                double rep[11];
+                for (double &val : rep)
+                    val = in.get<double>();
+                obj.repeats.emplace_back(rep[0], rep[1], rep[2], rep[3], rep[4], rep[5], rep[6], rep[7], rep[8], rep[9], rep[10]);
+            }
+
+            for (std::size_t num_corners = in.get_count(4 * sizeof(double)); num_corners > 0; num_corners--)
+            {
+                Vec3D pt;
+                for (double &val : pt)
+                    val = in.get<double>();
+                const double height = in.get<double>();
+                obj.outline.emplace_back(pt, height, RoadObjectCorner::Type(in.get<int32_t>()));
+            }
+            return obj;
+        }
+
+        void put_signal(MapWriter &out, const RoadSignal &sig)
+        {
+            out.put_string(sig.id);
+            for (const double val : {sig.s, sig.t, sig.z0, sig.width, sig.height, sig.hdg, sig.pitch, sig.roll})
+                out.put(val);
+            out.put(uint8_t(sig.dynamic));
+            for (const std::string *str : {&sig.type, &sig.subtype, &sig.name, &sig.orientation, &sig.country})
+                out.put_string(*str);
+        }
+
+        RoadSignal get_signal(MapReader &in, const std::string &road_id)
+        {
+            std::string id = in.get_string();
+            double vals[8];
+            for (double &val : vals)
+                val = in.get<double>();
+            const bool dynamic = in.get<uint8_t>() != 0;
+            std::string strs[5];
+            for (std::string &str : strs)
+                str = in.get_string();
+            return RoadSignal(
+                road_id, id, vals[0], vals[1], vals[2], dynamic, vals[3], vals[4], vals[5], vals[6], vals[7], strs[0], strs[1], strs[2], strs[3], strs[4]);
+        }
+
+        void put_road(MapWriter &out, const Road &road)
+        {
+            out.put_string(road.id);
+            out.put(road.length);
+            out.put_string(road.junction);
+            out.put_string(road.name);
+            put_road_link(out, road.predecessor);
+            put_road_link(out, road.successor);
+            out.put_count(road.neighbors.size());
+            for (const RoadNeighbor &neighbor : road.neighbors)
+            {
+                out.put_string(neighbor.id);
+                out.put_string(neighbor.side);
+                out.put_string(neighbor.direction);
+            }
+
+            out.put_spline(road.lane_offset);
+            out.put_spline(road.superelevation);
+            out.put_spline(road.crossfall);
+            out.put_count(road.crossfall.sides.size());
+            for (const auto &s_side : road.crossfall.sides)
+            {
+                out.put(s_side.first);
+                out.put(int32_t(s_side.second));
+            }
+
+            out.put_spline(road.ref_line.elevation_profile);
+            out.put_count(road.ref_line.s0_to_geometry.size());
+            for (const auto &s0_geometry : road.ref_line.s0_to_geometry)
+            {
+                out.put(s0_geometry.first);
+                put_geometry(out, *s0_geometry.second);
+            }
+
+            out.put_count(road.s_to_lanesection.size());
+            for (const auto &s_lanesec : road.s_to_lanesection)
+            {
+                out.put(s_lanesec.first);
+                out.put_count(s_lanesec.second.id_to_lane.size());
+                for (const auto &id_lane : s_lanesec.second.id_to_lane)
+                    put_lane(out, id_lane.second);
+            }
+
+            out.put_count(road.s_to_type.size());
+            for (const auto &s_type : road.s_to_type)
+            {
+                out.put(s_type.first);
+                out.put_string(s_type.second);
+            }
+            out.put_count(road.s_to_speed.size());
+            for (const auto &s_speed : road.s_to_speed)
+            {
+                out.put(s_speed.first);
+                out.put_string(s_speed.second.max);
+                out.put_string(s_speed.second.unit);
+            }
+
+            out.put_count(road.id_to_object.size());
+            for (const auto &id_object : road.id_to_object)
+                put_road_object(out, id_object.second);
+            out.put_count(road.id_to_signal.size());
+            for (const auto &id_signal : road.id_to_signal)
+                put_signal(out, id_signal.second);
+        }
+
+        // Fills in road, made from the header written first
+        void get_road_body(MapReader &in, Road &road)
+        {
+            road.predecessor = get_road_link(in);
+            road.successor = get_road_link(in);
+            for (std::size_t num_neighbors = in.get_count(3 * sizeof(uint64_t)); num_neighbors > 0; num_neighbors--)
+            {
+                std::string id = in.get_string();
+                std::string side = in.get_string();
+                std::string direction = in.get_string();
+                road.neighbors.emplace_back(id, side, direction);
+            }
+
+            in.get_spline(road.lane_offset);
+            in.get_spline(road.superelevation);
+            in.get_spline(road.crossfall);
+            for (std::size_t num_sides = in.get_count(sizeof(double) + sizeof(int32_t)); num_sides > 0; num_sides--)
+            {
+                const double s = in.get<double>();
+                road.crossfall.sides[s] = Crossfall::Side(in.get<int32_t>());
+            }
+
+            in.get_spline(road.ref_line.elevation_profile);
+            for (std::size_t num_geometries = in.get_count(sizeof(double)); num_geometries > 0; num_geometries--)
+            {
+                const double s0 = in.get<double>();
+                road.ref_line.s0_to_geometry[s0] = get_geometry(in);
+            }
+
+            for (std::size_t num_lanesecs = in.get_count(sizeof(double)); num_lanesecs > 0; num_lanesecs--)
+            {
+                const double s0 = in.get<double>();
+                LaneSection &lanesec = road.s_to_lanesection.insert({s0, LaneSection(road.id, s0)}).first->second;
+                for (std::size_t num_lanes = in.get_count(sizeof(int32_t)); num_lanes > 0; num_lanes--)
+                {
+                    Lane lane = get_lane(in, road.id, s0);
+                    const int lane_id = lane.id;
+                    lanesec.id_to_lane.insert({lane_id, std::move(lane)});
+                }
+            }
+            road.build_roadmark_tables();
+
+            for (std::size_t num_types = in.get_count(sizeof(double)); num_types > 0; num_types--)
+            {
+                const double s = in.get<double>();
+                road.s_to_type[s] = in.get_string();
+            }
+            for (std::size_t num_speeds = in.get_count(sizeof(double)); num_speeds > 0; num_speeds--)
+            {
+                const double s = in.get<double>();
+                std::string max = in.get_string();
+                std::string unit = in.get_string();
+                road.s_to_speed.insert({s, SpeedRecord(max, unit)});
+            }
+
+            for (std::size_t num_objects = in.get_count(sizeof(uint64_t)); num_objects > 0; num_objects--)
+            {
+                RoadObject obj = get_road_object(in, road.id);
+                const std::string obj_id = obj.id;
+                road.id_to_object.insert({obj_id, std::move(obj)});
+            }
+            for (std::size_t num_signals = in.get_count(sizeof(uint64_t)); num_signals > 0; num_signals--)
+            {
+                RoadSignal sig = get_signal(in, road.id);
+                const std::string sig_id = sig.id;
+                road.id_to_signal.insert({sig_id, std::move(sig)});
+            }
+        }
+
+        void put_junction(MapWriter &out, const Junction &junction)
+        {
+            out.put_string(junction.id);
+            out.put_string(junction.name);
+            out.put_count(junction.id_to_connection.size());
+            for (const auto &id_conn : junction.id_to_connection)
+            {
+                const JunctionConnection &conn = id_conn.second;
+                out.put_string(conn.id);
+                out.put_string(conn.incoming_road);
+                out.put_string(conn.connecting_road);
+                out.put(int32_t(conn.contact_point));
+                out.put_count(conn.lane_links.size());
+                for (const JunctionLaneLink &link : conn.lane_links)
+                {
+                    out.put(int32_t(link.from));
+                    out.put(int32_t(link.to));
+                }
+            }
+            out.put_count(junction.id_to_controller.size());
+            for (const auto &id_controller : junction.id_to_controller)
+            {
+                out.put_string(id_controller.second.id);
+                out.put_string(id_controller.second.type);
+                out.put(uint32_t(id_controller.second.sequence));
+            }
+            out.put_count(junction.priorities.size());
+            for (const JunctionPriority &priority : junction.priorities)
+            {
+                out.put_string(priority.high);
+                out.put_string(priority.low);
+            }
+        }
+
+        Junction get_junction(MapReader &in)
+        {
+            std::string id = in.get_string();
+            std::string name = in.get_string();
+            Junction junction(name, id);
+            for (std::size_t num_conns = in.get_count(3 * sizeof(uint64_t)); num_conns > 0; num_conns--)
+            {
+                std::string conn_id = in.get_string();
+                std::string incoming_road = in.get_string();
+                std::string connecting_road = in.get_string();
+                const JunctionConnection::ContactPoint contact_point = JunctionConnection::ContactPoint(in.get<int32_t>());
+                JunctionConnection conn(conn_id, incoming_road, connecting_road, contact_point);
+                for (std::size_t num_links = in.get_count(2 * sizeof(int32_t)); num_links > 0; num_links--)
+                {
+                    const int from = in.get<int32_t>();
+                    conn.lane_links.insert(JunctionLaneLink(from, in.get<int32_t>()));
+                }
+                junction.id_to_connection.insert({conn_id, std::move(conn)});
+            }
+            for (std::size_t num_controllers = in.get_count(2 * sizeof(uint64_t)); num_controllers > 0; num_controllers--)
+            {
+                std::string controller_id = in.get_string();
+                std::string type = in.get_string();
+                junction.id_to_controller.insert({controller_id, JunctionController(controller_id, type, in.get<uint32_t>())});
+            }
+            for (std::size_t num_priorities = in.get_count(2 * sizeof(uint64_t)); num_priorities > 0; num_priorities--)
+            {
+                std::string high = in.get_string();
+                junction.priorities.insert(JunctionPriority(high, in.get_string()));
+            }
+            return junction;
+        }
+    } // namespace
+
+    void OpenDriveMap::save(const std::string &path) const
+    {
+        MapWriter out;
+        out.put_string(this->proj4);
+        out.put(this->x_offs);
+        out.put(this->y_offs);
+
+        out.put_count(this->id_to_junction.size());
+        for (const auto &id_junction : this->id_to_junction)
+            put_junction(out, id_junction.second);
+
+        std::vector<const Road *> loaded_roads;
+        {
+            std::lock_guard<std::mutex> lock(this->roads_mutex_);
+            for (const Road *road : this->road_by_index_)
+            {
+                if (this->road_loaded_[road->index])
+                    loaded_roads.push_back(road);
+            }
+        }
+        out.put_count(loaded_roads.size());
+        for (const Road *road : loaded_roads)
+            put_road(out, *road);
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.endian_check = ENDIAN_CHECK;
+        header.payload_bytes = out.data().size();
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(out.data().data(), std::streamsize(out.data().size()));
+        if (!file.flush())
+            throw std::runtime_error("can't write saved map " + path);
+    }
+
+    OpenDriveMap::OpenDriveMap(const SavedMap &saved, const OpenDriveMapConfig &config) : parallelism_(config.parallelism)
+    {
+        const MappedFile file(saved.path);
+        Header header;
+        if (file.size() < sizeof(header))
+            throw std::runtime_error("saved map is truncated");
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.endian_check != ENDIAN_CHECK)
+            throw std::runtime_error(saved.path + " is not a saved map");
+        if (header.version != VERSION)
+            throw std::runtime_error(saved.path + " is a saved map of another version");
+        if (header.payload_bytes != file.size() - sizeof(header))
+            throw std::runtime_error("saved map is truncated");
+
+        MapReader in(file.data() + sizeof(header), file.size() - sizeof(header));
+        this->proj4 = in.get_string();
+        this->x_offs = in.get<double>();
+        this->y_offs = in.get<double>();
+
+        for (std::size_t num_junctions = in.get_count(2 * sizeof(uint64_t)); num_junctions > 0; num_junctions--)
+        {
+            Junction junction = get_junction(in);
+            const std::string junction_id = junction.id;
+            this->id_to_junction.insert({junction_id, std::move(junction)});
+        }
+
+        for (std::size_t num_roads = in.get_count(4 * sizeof(uint64_t)); num_roads > 0; num_roads--)
+        {
+            std::string road_id = in.get_string();
+            const double length = in.get<double>();
+            std::string junction = in.get_string();
+            std::string name = in.get_string();
+            auto road_iter = this->id_to_road.insert({road_id, Road(road_id, length, junction, name)});
+            if (!road_iter.second)
+                throw std::runtime_error("saved map has road " + road_id + " twice");
+            get_road_body(in, road_iter.first->second);
+        }
+        if (!in.done())
+            throw std::runtime_error("saved map has trailing data");
+
+        // Saved roads are all loaded, so there is nothing to parse later
+        this->config_ = config;
+        this->config_.lazy_roads = false;
+        this->index_roads();
+
+        std::vector<value> extents;
+        extents.reserve(this->road_by_index_.size());
+        for (const Road *road : this->road_by_index_)
+        {
+            bool found = false;
+            box extent;
+            for (const auto &s0_geometry : road->ref_line.s0_to_geometry)
+            {
+                const RoadGeometry &geometry = *s0_geometry.second;
+                const double length = std::max(geometry.length, 0.0);
+                const box geometry_extent(point(float(geometry.x0 - length), float(geometry.y0 - length)),
+                                          point(float(geometry.x0 + length), float(geometry.y0 + length)));
+                if (found)
+                    bg::expand(extent, geometry_extent);
+                else
+                    extent = geometry_extent;
+                found = true;
+            }
+            if (found)
+                extents.emplace_back(extent, road->index);
+        }
+        this->index_road_extents(extents, true);
+    }
+
+} // namespace odr
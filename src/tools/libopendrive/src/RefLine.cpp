@@ -3,8 +3,8 @@
 #include "Math.hpp"
 #include "Utils.hpp"
 
+#include <algorithm>
 #include <cmath>
-#include <functional>
 #include <iterator>
 #include <stdexcept>
 #include <type_traits>
@@ -13,6 +13,31 @@
 
 namespace odr
 {
+
+namespace
+{
+// Calls f(geometry, first, n) for each run of s[first] to s[first + n - 1]
+// that get_geometry() puts on the same geometry
+template<typename F>
+void for_each_geometry_run(const std::map<double, std::unique_ptr<RoadGeometry>>& s0_to_geometry, const double* s, std::size_t count, F&& f)
+{
+    std::size_t first = 0;
+    while (first < count)
+    {
+        const auto next_geom_iter = s0_to_geometry.upper_bound(s[first]);
+        auto       geom_iter = next_geom_iter;
+        if (geom_iter != s0_to_geometry.begin())
+            geom_iter--;
+
+        std::size_t last = first + 1;
+        while (last < count && (next_geom_iter == s0_to_geometry.end() || s[last] < next_geom_iter->first) &&
+               (geom_iter == s0_to_geometry.begin() || s[last] >= geom_iter->first))
+            last++;
+        f(*geom_iter->second, first, last - first);
+        first = last;
+    }
+}
+} // namespace
 RefLine::RefLine(std::string road_id, double length) : road_id(road_id), length(length) {}
 
 RefLine::RefLine(const RefLine& other) : road_id(other.road_id), length(other.length), elevation_profile(other.elevation_profile)
@@ -83,40 +108,137 @@ Vec3D RefLine::get_grad(const double s) const
     return Vec3D{d_xy[0], d_xy[1], this->elevation_profile.get_grad(s)};
 }
 
-double RefLine::match(const double x, const double y) const
+void RefLine::get_xyz(const double* s, std::size_t count, Vec3D* out) const
 {
-    std::function<double(double)> f_dist = [&](const double s)
+    std::vector<Vec2D> pt_xy(count, Vec2D{0, 0});
+    if (!this->s0_to_geometry.empty())
     {
-        const Vec3D pt = this->get_xyz(s);
+        for_each_geometry_run(this->s0_to_geometry,
+                              s,
+                              count,
+                              [&](const RoadGeometry& geom, std::size_t first, std::size_t n) { geom.get_xy(s + first, n, pt_xy.data() + first); });
+    }
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = Vec3D{pt_xy[i][0], pt_xy[i][1], this->elevation_profile.get(s[i])};
+}
+
+void RefLine::get_grad(const double* s, std::size_t count, Vec3D* out) const
+{
+    std::vector<Vec2D> d_xy(count, Vec2D{0, 0});
+    if (!this->s0_to_geometry.empty())
+    {
+        for_each_geometry_run(this->s0_to_geometry,
+                              s,
+                              count,
+                              [&](const RoadGeometry& geom, std::size_t first, std::size_t n) { geom.get_grad(s + first, n, d_xy.data() + first); });
+    }
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = Vec3D{d_xy[i][0], d_xy[i][1], this->elevation_profile.get_grad(s[i])};
+}
+
+double RefLine::match(const double x, const double y) const { return this->match(x, y, 0.0, this->length); }
+
+double RefLine::match(const double x, const double y, const double s_start, const double s_end) const
+{
+    // Nearest point on a fine polyline of the reference line, then refined.
+    // A search over s alone can settle in the wrong local minimum of a
+    // curved road.
+    std::vector<double> s_vals;
+    this->approximate_linear(0.1, s_start, s_end, s_vals);
+    sort_unique(s_vals);
+    if (s_vals.size() < 2)
+        return s_start;
+
+    std::vector<Vec3D> pts(s_vals.size());
+    this->get_xyz(s_vals.data(), s_vals.size(), pts.data());
+
+    double best_s = s_start;
+    double best_dist = INFINITY;
+    for (std::size_t i = 1; i < s_vals.size(); i++)
+    {
+        const Vec3D& pt_a = pts[i - 1];
+        const Vec3D& pt_b = pts[i];
+        const Vec2D ab{pt_b[0] - pt_a[0], pt_b[1] - pt_a[1]};
+        const double len2 = ab[0] * ab[0] + ab[1] * ab[1];
+        double u = len2 > 0 ? ((x - pt_a[0]) * ab[0] + (y - pt_a[1]) * ab[1]) / len2 : 0.0;
+        u = std::min(1.0, std::max(0.0, u));
+        const double dist = euclDistance(Vec2D{pt_a[0] + u * ab[0], pt_a[1] + u * ab[1]}, {x, y});
+        if (dist < best_dist)
+        {
+            best_dist = dist;
+            best_s = s_vals[i - 1] + u * (s_vals[i] - s_vals[i - 1]);
+        }
+    }
+    return this->refine_match(x, y, best_s, s_start, s_end);
+}
+
+double RefLine::refine_match(const double x, const double y, double s, const double s_min, const double s_max) const
+{
+    auto dist_at = [&](const double s_val)
+    {
+        const Vec3D pt = this->get_xyz(s_val);
         return euclDistance(Vec2D{pt[0], pt[1]}, {x, y});
     };
-    return golden_section_search<double>(f_dist, 0.0, length, 1e-2);
+
+    double best_s = s;
+    double best_dist = dist_at(s);
+    for (int iter = 0; iter < 8; iter++)
+    {
+        const Vec3D pt = this->get_xyz(s);
+        const Vec3D grad = this->get_grad(s);
+        const double grad2 = grad[0] * grad[0] + grad[1] * grad[1];
+        if (grad2 == 0)
+            break;
+        const double ds = ((x - pt[0]) * grad[0] + (y - pt[1]) * grad[1]) / grad2;
+        s = std::min(s_max, std::max(s_min, s + ds));
+        const double dist = dist_at(s);
+        if (dist < best_dist)
+        {
+            best_dist = dist;
+            best_s = s;
+        }
+        if (std::abs(ds) < 1e-6)
+            break;
+    }
+    return best_s;
 }
 
 Line3D RefLine::get_line(const double s_start, const double s_end, const double eps) const
 {
-    std::set<double> s_vals = this->approximate_linear(eps, s_start, s_end);
+    std::vector<double> s_vals;
+    this->approximate_linear(eps, s_start, s_end, s_vals);
+    sort_unique(s_vals);
 
-    Line3D out_line;
-    for (const double& s : s_vals)
-        out_line.push_back(this->get_xyz(s));
+    Line3D out_line(s_vals.size());
+    this->get_xyz(s_vals.data(), s_vals.size(), out_line.data());
     return out_line;
 }
 
 std::set<double> RefLine::approximate_linear(const double eps, const double s_start, const double s_end) const
+{
+    std::vector<double> s_vals;
+    this->approximate_linear(eps, s_start, s_end, s_vals);
+    return std::set<double>(s_vals.begin(), s_vals.end());
+}
+
+void RefLine::approximate_linear(const double eps, const double s_start, const double s_end, std::vector<double>& s_vals) const
 {
     if ((s_start == s_end) || this->s0_to_geometry.empty())
-        return {};
+        return;
 
     auto s_end_geom_iter = this->s0_to_geometry.lower_bound(s_end);
     auto s_start_geom_iter = this->s0_to_geometry.upper_bound(s_start);
     if (s_start_geom_iter != s0_to_geometry.begin())
         s_start_geom_iter--;
 
-    std::vector<double> s_vals{s_start};
+    const std::size_t   first = s_vals.size();
+    std::vector<double> s_vals_geom;
+    s_vals.push_back(s_start);
     for (auto s0_geom_iter = s_start_geom_iter; s0_geom_iter != s_end_geom_iter; s0_geom_iter++)
     {
-        const std::set<double> s_vals_geom = s0_geom_iter->second->approximate_linear(eps);
+        s_vals_geom.clear();
+        s0_geom_iter->second->approximate_linear(eps, s_vals_geom);
+        sort_unique(s_vals_geom);
         if (s_vals_geom.size() < 2)
             throw std::runtime_error("expected at least two sample points");
         for (const double& s : s_vals_geom)
@@ -124,21 +246,16 @@ std::set<double> RefLine::approximate_linear(const double eps, const double s_st
             if (s > s_start && s < s_end)
                 s_vals.push_back(s);
         }
-        if (std::next(s0_geom_iter) != s_end_geom_iter)
+        if (std::next(s0_geom_iter) != s_end_geom_iter && s_vals.size() > first)
             s_vals.pop_back();
     }
 
-    std::set<double> s_vals_elevation = this->elevation_profile.approximate_linear(eps, s_start, s_end);
-    for (const double& s : s_vals_elevation)
-    {
-        if (s > s_start && s < s_end)
-            s_vals.push_back(s);
-    }
+    const std::size_t elevation_first = s_vals.size();
+    this->elevation_profile.approximate_linear(eps, s_start, s_end, s_vals);
+    s_vals.erase(std::remove_if(s_vals.begin() + elevation_first, s_vals.end(), [&](const double s) { return !(s > s_start && s < s_end); }),
+                 s_vals.end());
 
     s_vals.push_back(s_end);
-
-    std::set<double> s_vals_set(s_vals.begin(), s_vals.end());
-    return s_vals_set;
 }
 
 } // namespace odr
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "RefLineIndex.h"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace odr
+{
+
+namespace
+{
+// Distance from p to segment ab, and how far along it the nearest point is
+std::pair<double, double> segment_distance(const Vec2D& p, const Vec2D& a, const Vec2D& b)
+{
+    const Vec2D  ab{b[0] - a[0], b[1] - a[1]};
+    const double len2 = ab[0] * ab[0] + ab[1] * ab[1];
+    double       u = len2 > 0 ? ((p[0] - a[0]) * ab[0] + (p[1] - a[1]) * ab[1]) / len2 : 0.0;
+    u = std::min(1.0, std::max(0.0, u));
+    return {euclDistance(p, Vec2D{a[0] + u * ab[0], a[1] + u * ab[1]}), u};
+}
+
+// Beyond this, a previous answer bounds the search too loosely to help
+constexpr double HINT_REACH = 5.0;
+} // namespace
+
+RefLineIndex::RefLineIndex(const OpenDriveMap& map, double eps) : map(map), eps(eps)
+{
+    std::vector<value>  values;
+    std::vector<double> s_vals;
+    for (uint32_t road_index = 0; road_index < map.road_count(); road_index++)
+    {
+        const RefLine& ref_line = map.road(road_index).ref_line;
+        s_vals.clear();
+        ref_line.approximate_linear(eps, 0.0, ref_line.length, s_vals);
+        sort_unique(s_vals);
+        if (s_vals.size() < 2)
+            continue;
+
+        auto  s_iter = s_vals.begin();
+        Vec3D pt_start = ref_line.get_xyz(*s_iter);
+        for (auto s_next = std::next(s_iter); s_next != s_vals.end(); s_iter++, s_next++)
+        {
+            const Vec3D pt_end = ref_line.get_xyz(*s_next);
+            const point corner_min(float(std::min(pt_start[0], pt_end[0]) - eps), float(std::min(pt_start[1], pt_end[1]) - eps));
+            const point corner_max(float(std::max(pt_start[0], pt_end[0]) + eps), float(std::max(pt_start[1], pt_end[1]) + eps));
+            values.emplace_back(box(corner_min, corner_max), unsigned(this->segments.size()));
+            this->segments.push_back({road_index, *s_iter, *s_next, {pt_start[0], pt_start[1]}, {pt_end[0], pt_end[1]}});
+            pt_start = pt_end;
+        }
+    }
+    this->tree = bgi::rtree<value, bgi::rstar<16, 4>>(values.begin(), values.end());
+}
+
+RefLineProjection RefLineIndex::project(double x, double y, double max_distance) const { return this->project(x, y, max_distance, nullptr); }
+
+std::vector<RefLineProjection> RefLineIndex::project(const std::vector<Vec2D>& points, double max_distance) const
+{
+    std::vector<RefLineProjection> projections;
+    projections.reserve(points.size());
+    for (const Vec2D& pt : points)
+    {
+        const RefLineProjection* hint = !projections.empty() && projections.back().road_index != NO_INDEX ? &projections.back() : nullptr;
+        projections.push_back(this->project(pt[0], pt[1], max_distance, hint));
+    }
+    return projections;
+}
+
+RefLineProjection RefLineIndex::project(double x, double y, double max_distance, const RefLineProjection* hint) const
+{
+    RefLineProjection projection;
+    if (this->segments.empty())
+        return projection;
+    const Vec2D p{x, y};
+
+    // Any point of a reference line bounds the distance to the nearest one.
+    // The polyline is within eps of the curve, so past the bound plus eps
+    // no segment can hold a nearer point.
+    double reach = max_distance;
+    if (hint)
+    {
+        const Vec3D hint_pt = this->map.road(hint->road_index).ref_line.get_xyz(hint->s);
+        reach = std::min(reach, euclDistance(p, Vec2D{hint_pt[0], hint_pt[1]}) + this->eps);
+    }
+    if (!hint || reach > HINT_REACH)
+    {
+        std::vector<value> nearest;
+        this->tree.query(bgi::nearest(point(float(x), float(y)), 4), std::back_inserter(nearest));
+        for (const value& v : nearest)
+        {
+            const Segment& seg = this->segments[v.second];
+            reach = std::min(reach, segment_distance(p, seg.start, seg.end).first + this->eps);
+        }
+    }
+    if (!std::isfinite(reach))
+        return projection;
+
+    const double       margin = reach + this->eps;
+    std::vector<value> candidates;
+    this->tree.query(bgi::intersects(box(point(float(x - margin), float(y - margin)), point(float(x + margin), float(y + margin)))),
+                     std::back_inserter(candidates));
+
+    std::vector<std::pair<double, std::pair<const Segment*, double>>> by_distance; // Polyline distance, (segment, u)
+    by_distance.reserve(candidates.size());
+    for (const value& v : candidates)
+    {
+        const Segment& seg = this->segments[v.second];
+        const auto     dist_u = segment_distance(p, seg.start, seg.end);
+        if (dist_u.first <= margin)
+            by_distance.push_back({dist_u.first, {&seg, dist_u.second}});
+    }
+    std::sort(by_distance.begin(), by_distance.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (const auto& candidate : by_distance)
+    {
+        // Sorted, so once the polyline is further than the best point plus
+        // eps, so is every curve that follows
+        if (candidate.first - this->eps > projection.distance)
+            break;
+        const Segment& seg = *candidate.second.first;
+        const RefLine& ref_line = this->map.road(seg.road_index).ref_line;
+        const double   s_guess = seg.s_start + candidate.second.second * (seg.s_end - seg.s_start);
+        const double   s = ref_line.refine_match(x, y, s_guess, seg.s_start, seg.s_end);
+        const Vec3D    pt = ref_line.get_xyz(s);
+        const double   dist = euclDistance(p, Vec2D{pt[0], pt[1]});
+        if (dist < projection.distance)
+        {
+            projection.road_index = seg.road_index;
+            projection.s = s;
+            projection.distance = dist;
+        }
+    }
+    if (projection.road_index == NO_INDEX || projection.distance > max_distance)
+        return RefLineProjection{};
+
+    const RefLine& ref_line = this->map.road(projection.road_index).ref_line;
+    const Vec3D    pt = ref_line.get_xyz(projection.s);
+    const Vec3D    grad = ref_line.get_grad(projection.s);
+    const double   grad_len = std::hypot(grad[0], grad[1]);
+    if (grad_len > 0)
+        projection.t = ((y - pt[1]) * grad[0] - (x - pt[0]) * grad[1]) / grad_len;
+    return projection;
+}
+
+} // namespace odr
@@ -19,28 +19,25 @@
 #include <utility>
 
 #include <iostream>
-#include <fstream>
 
 namespace odr
 {
     double Crossfall::get_crossfall(const double s, const bool on_left_side) const
     {
-        if (this->s0_to_poly.size() > 0)
+        if (!this->empty())
         {
-            auto target_poly_iter = this->s0_to_poly.upper_bound(s);
-            if (target_poly_iter != this->s0_to_poly.begin())
-                target_poly_iter--;
+            const std::size_t idx = this->find_poly(s);
 
             Side side = Side_Both; // applicable side of the road
-            if (this->sides.find(target_poly_iter->first) != this->sides.end())
-                side = this->sides.at(target_poly_iter->first);
+            if (this->sides.find(this->s0_vals[idx]) != this->sides.end())
+                side = this->sides.at(this->s0_vals[idx]);
 
             if (on_left_side && side == Side_Right)
                 return 0;
             else if (!on_left_side && side == Side_Left)
                 return 0;
 
-            return target_poly_iter->second.get(s);
+            return this->polys[idx].get(s);
         }
 
         return 0;
@@ -57,6 +54,10 @@ namespace odr
     std::vector<RoadObject> Road::get_road_objects() const { return get_map_values(this->id_to_object); }
     std::vector<RoadSignal> Road::get_signals() const { return get_map_values(this->id_to_signal); }
 
+    MapValues<double, LaneSection> Road::lanesections() const { return MapValues<double, LaneSection>(this->s_to_lanesection); }
+    MapValues<std::string, RoadObject> Road::road_objects() const { return MapValues<std::string, RoadObject>(this->id_to_object); }
+    MapValues<std::string, RoadSignal> Road::signals() const { return MapValues<std::string, RoadSignal>(this->id_to_signal); }
+
     Road::Road(std::string id, double length, std::string junction, std::string name) : length(length), id(id), junction(junction), name(name), ref_line(id, length)
     {
     }
@@ -99,6 +100,16 @@ namespace odr
         return next_s0 - std::numeric_limits<double>::min(); // should be within lane section
     }
 
+    void Road::build_roadmark_tables()
+    {
+        for (auto &s_lanesec : this->s_to_lanesection)
+        {
+            const double s_end = this->get_lanesection_end(s_lanesec.second);
+            for (auto &id_lane : s_lanesec.second.id_to_lane)
+                id_lane.second.roadmark_table.build(id_lane.second.roadmark_groups, s_lanesec.first, s_end);
+        }
+    }
+
     double Road::get_lanesection_length(const LaneSection &lanesection) const
     {
         const double s_end = this->get_lanesection_end(lanesection);
@@ -111,56 +122,152 @@ namespace odr
         return s_end - lanesection_s0;
     }
 
-    Vec3D Road::get_xyz(const double s, const double t, const double h, Vec3D *_e_s, Vec3D *_e_t, Vec3D *_e_h) const
+    namespace
     {
-        const Vec3D s_vec = this->ref_line.get_grad(s);
-        const double theta = this->superelevation.get(s);
-
-        const Vec3D e_s = normalize(s_vec);
-        const Vec3D e_t = normalize(Vec3D{std::cos(theta) * -e_s[1] + std::sin(theta) * -e_s[2] * e_s[0],
-                                          std::cos(theta) * e_s[0] + std::sin(theta) * -e_s[2] * e_s[1],
-                                          std::sin(theta) * (e_s[0] * e_s[0] + e_s[1] * e_s[1])});
-        const Vec3D e_h = normalize(crossProduct(s_vec, e_t));
-        const Vec3D p0 = this->ref_line.get_xyz(s);
-        const Mat3D trans_mat{{{e_t[0], e_h[0], p0[0]}, {e_t[1], e_h[1], p0[1]}, {e_t[2], e_h[2], p0[2]}}};
-
-        const Vec3D xyz = MatVecMultiplication(trans_mat, Vec3D{t, h, 1});
-
-        if (_e_s)
-            *_e_s = e_s;
-        if (_e_t)
-            *_e_t = e_t;
-        if (_e_h)
-            *_e_h = e_h;
-
-        return xyz;
-    }
+        // The point t, h off the reference line at p0, with gradient s_vec,
+        // where the road is banked by theta
+        Vec3D get_frame_xyz(const double theta,
+                            const double t,
+                            const double h,
+                            const Vec3D &p0,
+                            const Vec3D &s_vec,
+                            Vec3D *_e_s,
+                            Vec3D *_e_t,
+                            Vec3D *_e_h)
+        {
+            const Vec3D e_s = normalize(s_vec);
+            const Vec3D e_t = normalize(Vec3D{std::cos(theta) * -e_s[1] + std::sin(theta) * -e_s[2] * e_s[0],
+                                              std::cos(theta) * e_s[0] + std::sin(theta) * -e_s[2] * e_s[1],
+                                              std::sin(theta) * (e_s[0] * e_s[0] + e_s[1] * e_s[1])});
+            const Vec3D e_h = normalize(crossProduct(s_vec, e_t));
+            const Mat3D trans_mat{{{e_t[0], e_h[0], p0[0]}, {e_t[1], e_h[1], p0[1]}, {e_t[2], e_h[2], p0[2]}}};
+
+            const Vec3D xyz = MatVecMultiplication(trans_mat, Vec3D{t, h, 1});
+
+            if (_e_s)
+                *_e_s = e_s;
+            if (_e_t)
+                *_e_t = e_t;
+            if (_e_h)
+                *_e_h = e_h;
+
+            return xyz;
+        }
 
-    Vec3D Road::get_surface_pt(double s, const double t, Vec3D *vn) const
+        constexpr std::size_t NO_LANE = std::numeric_limits<std::size_t>::max();
+
+        // Triangulates object outlines, keeping its node blocks between
+        // objects. One per thread, as meshes are built from several.
+        thread_local mapbox::detail::Earcut<uint32_t> outline_earcut;
+
+        // Sample positions and edges of roadmark meshes, likewise kept
+        // between marks
+        thread_local std::vector<double> roadmark_s_vals;
+        thread_local std::vector<double> roadmark_s_edges;
+        thread_local std::vector<double> roadmark_t_edges;
+    } // namespace
+
+    Road::Cursor::Cursor(const Road &road) : road(road), superelevation(road.superelevation) {}
+
+    void Road::Cursor::seek_lanesection(const double s)
     {
-        CHECK_AND_REPAIR(s >= 0, "s < 0", s = 0);
-        CHECK_AND_REPAIR(s <= this->length, "s > Road::length", s = this->length);
+        if (this->lanesec && !(s < this->lanesec_s0) && s < this->lanesec_next_s0 && !(s > this->lanesec_end))
+            return;
 
-        const double lanesection_s0 = this->get_lanesection_s0(s);
+        const double lanesection_s0 = this->road.get_lanesection_s0(s);
         if (std::isnan(lanesection_s0))
         {
-            throw std::runtime_error(string_format("cannot get road surface pt, no lane section for s %.3f, road length: %.3f", s, this->length));
+            throw std::runtime_error(string_format("cannot get road surface pt, no lane section for s %.3f, road length: %.3f", s, this->road.length));
+        }
+
+        const auto s_lanesec_iter = this->road.s_to_lanesection.find(lanesection_s0);
+        const auto next_iter = std::next(s_lanesec_iter);
+        this->lanesec = &s_lanesec_iter->second;
+        this->lanesec_s0 = lanesection_s0;
+        this->lanesec_next_s0 = next_iter == this->road.s_to_lanesection.end() ? std::numeric_limits<double>::infinity() : next_iter->first;
+        this->lanesec_end = this->road.get_lanesection_end(lanesection_s0);
+
+        this->lanes.clear();
+        this->inner_borders.clear();
+        this->outer_borders.clear();
+        this->center = NO_LANE;
+        for (const auto &id_lane : this->lanesec->id_to_lane)
+        {
+            if (id_lane.first == 0)
+                this->center = this->lanes.size();
+            this->lanes.push_back(&id_lane.second);
+            this->inner_borders.emplace_back(id_lane.second.inner_border);
+            this->outer_borders.emplace_back(id_lane.second.outer_border);
+        }
+        if (this->center == NO_LANE)
+        {
+            this->lanesec = nullptr;
+            throw std::out_of_range("lane section has no lane 0");
         }
+        this->outer_ts.resize(this->lanes.size());
+    }
+
+    std::size_t Road::Cursor::lane_at(const double s, const double t)
+    {
+        if (this->outer_borders[this->center].get(s) == t) // exactly on lane #0
+            return this->center;
+
+        // What a map from outer border t to lane, filled in id order, would
+        // give: the lowest border at or above t, else the highest, taking
+        // the first lane of equal borders; then for lane 0 and lanes right
+        // of it, the border below, unless t is on this one.
+        std::size_t target = NO_LANE;
+        for (std::size_t k = 0; k < this->lanes.size(); k++)
+        {
+            this->outer_ts[k] = this->outer_borders[k].get(s);
+            if (!(this->outer_ts[k] < t) && (target == NO_LANE || this->outer_ts[k] < this->outer_ts[target]))
+                target = k;
+        }
+        if (target == NO_LANE)
+        {
+            for (std::size_t k = 0; k < this->lanes.size(); k++)
+            {
+                if (target == NO_LANE || this->outer_ts[k] > this->outer_ts[target])
+                    target = k;
+            }
+        }
+
+        if (this->lanes[target]->id <= 0 && t != this->outer_ts[target])
+        {
+            std::size_t below = NO_LANE;
+            for (std::size_t k = 0; k < this->lanes.size(); k++)
+            {
+                if (this->outer_ts[k] < this->outer_ts[target] && (below == NO_LANE || this->outer_ts[k] > this->outer_ts[below]))
+                    below = k;
+            }
+            if (below != NO_LANE)
+                target = below;
+        }
+        return target;
+    }
 
-        const LaneSection &lanesection = this->s_to_lanesection.at(lanesection_s0);
-        const Lane &lane = lanesection.id_to_lane.at(lanesection.get_lane_id(s, t));
-        const double t_inner_brdr = lane.inner_border.get(s);
+    Vec3D Road::Cursor::get_xyz(const double s, const double t, const double h, const Vec3D &p0, const Vec3D &s_vec, Vec3D *e_s, Vec3D *e_t, Vec3D *e_h)
+    {
+        return get_frame_xyz(this->superelevation.get(s), t, h, p0, s_vec, e_s, e_t, e_h);
+    }
+
+    Vec3D Road::Cursor::get_surface_pt(const double s, const double t, const Vec3D &p0, const Vec3D &s_vec, Vec3D *vn)
+    {
+        this->seek_lanesection(s);
+        const std::size_t lane_idx = this->lane_at(s, t);
+        const Lane &lane = *this->lanes[lane_idx];
+        const double t_inner_brdr = this->inner_borders[lane_idx].get(s);
+        const double superelev = this->superelevation.get(s);
         double h_t = 0;
 
         if (lane.level)
         {
-            const double h_inner_brdr = -std::tan(this->crossfall.get_crossfall(s, (lane.id > 0))) * std::abs(t_inner_brdr);
-            const double superelev = this->superelevation.get(s); // cancel out superelevation
-            h_t = h_inner_brdr + std::tan(superelev) * (t - t_inner_brdr);
+            const double h_inner_brdr = -std::tan(this->road.crossfall.get_crossfall(s, (lane.id > 0))) * std::abs(t_inner_brdr);
+            h_t = h_inner_brdr + std::tan(superelev) * (t - t_inner_brdr); // cancel out superelevation
         }
         else
         {
-            h_t = -std::tan(this->crossfall.get_crossfall(s, (lane.id > 0))) * std::abs(t);
+            h_t = -std::tan(this->road.crossfall.get_crossfall(s, (lane.id > 0))) * std::abs(t);
         }
 
         if (lane.s_to_height_offset.size() > 0)
@@ -171,7 +278,7 @@ namespace odr
             if (s0_height_offs_iter != height_offs.begin())
                 s0_height_offs_iter--;
 
-            const double t_outer_brdr = lane.outer_border.get(s);
+            const double t_outer_brdr = this->outer_borders[lane_idx].get(s);
             const double inner_height = s0_height_offs_iter->second.inner;
             const double outer_height = s0_height_offs_iter->second.outer;
             const double p_t = (t_outer_brdr != t_inner_brdr) ? (t - t_inner_brdr) / (t_outer_brdr - t_inner_brdr) : 0.0;
@@ -190,26 +297,92 @@ namespace odr
             }
         }
 
-        return this->get_xyz(s, t, h_t, nullptr, nullptr, vn);
+        return get_frame_xyz(superelev, t, h_t, p0, s_vec, nullptr, nullptr, vn);
+    }
+
+    Vec3D Road::get_xyz(const double s, const double t, const double h, Vec3D *_e_s, Vec3D *_e_t, Vec3D *_e_h) const
+    {
+        return get_frame_xyz(this->superelevation.get(s), t, h, this->ref_line.get_xyz(s), this->ref_line.get_grad(s), _e_s, _e_t, _e_h);
+    }
+
+    Vec3D Road::get_surface_pt(double s, const double t, Vec3D *vn) const
+    {
+        CHECK_AND_REPAIR(s >= 0, "s < 0", s = 0);
+        CHECK_AND_REPAIR(s <= this->length, "s > Road::length", s = this->length);
+
+        return Cursor(*this).get_surface_pt(s, t, this->ref_line.get_xyz(s), this->ref_line.get_grad(s), vn);
+    }
+
+    void Road::get_surface_pt(const double *s, const double *t, std::size_t count, Vec3D *out, Vec3D *vn) const
+    {
+        std::vector<double> s_clamped;
+        std::vector<Vec3D> p0, s_vec;
+        this->sample_ref_line(s, count, s_clamped, p0, s_vec);
+        Cursor cursor(*this);
+        for (std::size_t i = 0; i < count; i++)
+            out[i] = cursor.get_surface_pt(s_clamped[i], t[i], p0[i], s_vec[i], vn ? vn + i : nullptr);
+    }
+
+    void Road::sample_ref_line(const double *s_vals, std::size_t count, std::vector<double> &s_out, std::vector<Vec3D> &p0, std::vector<Vec3D> &s_vec) const
+    {
+        s_out.clear();
+        s_out.reserve(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            double s = s_vals[i];
+            CHECK_AND_REPAIR(s >= 0, "s < 0", s = 0);
+            CHECK_AND_REPAIR(s <= this->length, "s > Road::length", s = this->length);
+            s_out.push_back(s);
+        }
+        p0.resize(s_out.size());
+        s_vec.resize(s_out.size());
+        this->ref_line.get_xyz(s_out.data(), s_out.size(), p0.data());
+        this->ref_line.get_grad(s_out.data(), s_out.size(), s_vec.data());
     }
 
     std::set<double>
     Road::approximate_lane_border_linear(const Lane &lane, const double s_start, const double s_end, const double eps, const bool outer) const
     {
-        std::set<double> s_vals = this->ref_line.approximate_linear(eps, s_start, s_end);
+        std::vector<double> s_vals;
+        this->approximate_lane_border_linear(lane, s_start, s_end, eps, outer, s_vals);
+        return std::set<double>(s_vals.begin(), s_vals.end());
+    }
+
+    void Road::approximate_lane_border_linear(
+        const Lane &lane, const double s_start, const double s_end, const double eps, const bool outer, std::vector<double> &s_vals) const
+    {
+        this->ref_line.approximate_linear(eps, s_start, s_end, s_vals);
 
         const CubicSpline &border = outer ? lane.outer_border : lane.inner_border;
-        std::set<double> s_vals_brdr = border.approximate_linear(eps, s_start, s_end);
-        s_vals.insert(s_vals_brdr.begin(), s_vals_brdr.end());
+        border.approximate_linear(eps, s_start, s_end, s_vals);
+
+        for (auto s_height_iter = lane.s_to_height_offset.lower_bound(s_start);
+             s_height_iter != lane.s_to_height_offset.end() && s_height_iter->first <= s_end;
+             s_height_iter++)
+            s_vals.push_back(s_height_iter->first);
+
+        const double t_max = lane.outer_border.get_max(s_start, s_end);
+        this->superelevation.approximate_linear(std::atan(eps / std::abs(t_max)), s_start, s_end, s_vals);
+    }
+
+    void Road::approximate_lane_mesh_linear(const Lane &lane, const double s_start, const double s_end, const double eps, std::vector<double> &s_vals) const
+    {
+        s_vals.clear();
+        this->ref_line.approximate_linear(eps, s_start, s_end, s_vals);
+        lane.outer_border.approximate_linear(eps, s_start, s_end, s_vals);
+        lane.inner_border.approximate_linear(eps, s_start, s_end, s_vals);
+        this->lane_offset.approximate_linear(eps, s_start, s_end, s_vals);
 
-        std::set<double> s_vals_lane_height = get_map_keys(lane.s_to_height_offset);
-        s_vals.insert(s_vals_lane_height.begin(), s_vals_lane_height.end());
+        for (auto s_height_iter = lane.s_to_height_offset.lower_bound(s_start);
+             s_height_iter != lane.s_to_height_offset.end() && s_height_iter->first <= s_end;
+             s_height_iter++)
+            s_vals.push_back(s_height_iter->first);
 
         const double t_max = lane.outer_border.get_max(s_start, s_end);
-        std::set<double> s_vals_superelev = this->superelevation.approximate_linear(std::atan(eps / std::abs(t_max)), s_start, s_end);
-        s_vals.insert(s_vals_superelev.begin(), s_vals_superelev.end());
+        this->superelevation.approximate_linear(std::atan(eps / std::abs(t_max)), s_start, s_end, s_vals);
 
-        return s_vals;
+        sort_unique(s_vals);
+        thin_out(s_vals, eps);
     }
 
     std::set<double> Road::approximate_lane_border_linear(const Lane &lane, const double eps, const bool outer) const
@@ -220,14 +393,15 @@ namespace odr
 
     Line3D Road::get_lane_border_line(const Lane &lane, const double s_start, const double s_end, const double eps, const bool outer) const
     {
-        std::set<double> s_vals = this->approximate_lane_border_linear(lane, s_start, s_end, eps, outer);
+        std::vector<double> s_vals;
+        this->approximate_lane_border_linear(lane, s_start, s_end, eps, outer, s_vals);
+        sort_unique(s_vals);
 
-        Line3D border_line;
-        for (const double &s : s_vals)
-        {
-            const double t = outer ? lane.outer_border.get(s) : lane.inner_border.get(s);
-            border_line.push_back(this->get_surface_pt(s, t));
-        }
+        std::vector<double> t_vals(s_vals.size());
+        (outer ? lane.outer_border : lane.inner_border).get(s_vals.data(), s_vals.size(), t_vals.data());
+
+        Line3D border_line(s_vals.size());
+        this->get_surface_pt(s_vals.data(), t_vals.data(), s_vals.size(), border_line.data());
 
         return border_line;
     }
@@ -240,49 +414,35 @@ namespace odr
 
     Mesh3D Road::get_lane_mesh(const Lane &lane, const double s_start, const double s_end, const double eps, std::vector<uint32_t> *outline_indices) const
     {
-        std::set<double> s_vals = this->ref_line.approximate_linear(eps, s_start, s_end);
-        std::set<double> s_vals_outer_brdr = lane.outer_border.approximate_linear(eps, s_start, s_end);
-        s_vals.insert(s_vals_outer_brdr.begin(), s_vals_outer_brdr.end());
-        std::set<double> s_vals_inner_brdr = lane.inner_border.approximate_linear(eps, s_start, s_end);
-        s_vals.insert(s_vals_inner_brdr.begin(), s_vals_inner_brdr.end());
-        std::set<double> s_vals_lane_offset = this->lane_offset.approximate_linear(eps, s_start, s_end);
-        s_vals.insert(s_vals_lane_offset.begin(), s_vals_lane_offset.end());
+        std::vector<double> s_list;
+        this->approximate_lane_mesh_linear(lane, s_start, s_end, eps, s_list);
 
-        std::set<double> s_vals_lane_height = get_map_keys(lane.s_to_height_offset);
-        s_vals.insert(s_vals_lane_height.begin(), s_vals_lane_height.end());
-
-        const double t_max = lane.outer_border.get_max(s_start, s_end);
-        std::set<double> s_vals_superelev = this->superelevation.approximate_linear(std::atan(eps / std::abs(t_max)), s_start, s_end);
-        s_vals.insert(s_vals_superelev.begin(), s_vals_superelev.end());
-
-        /* thin out s_vals array, be removing s vals closer than eps to each other */
-        for (auto s_iter = s_vals.begin(); s_iter != s_vals.end();)
-        {
-            if (std::next(s_iter) != s_vals.end() && std::next(s_iter, 2) != s_vals.end() && ((*std::next(s_iter)) - *s_iter) <= eps)
-                s_iter = std::prev(s_vals.erase(std::next(s_iter)));
-            else
-                s_iter++;
-        }
+        // Both borders share each s, so the reference line is evaluated once
+        std::vector<double> s_clamped;
+        std::vector<Vec3D> p0, s_vec;
+        this->sample_ref_line(s_list.data(), s_list.size(), s_clamped, p0, s_vec);
 
         Mesh3D out_mesh;
-        std::ofstream f("points3.csv");
-        for (const double &s : s_vals)
+        out_mesh.vertices.reserve(2 * s_list.size());
+        out_mesh.normals.reserve(2 * s_list.size());
+        out_mesh.st_coordinates.reserve(2 * s_list.size());
+        Cursor cursor(*this);
+        CubicSpline::Cursor inner_brdr(lane.inner_border);
+        CubicSpline::Cursor outer_brdr(lane.outer_border);
+        for (std::size_t i = 0; i < s_list.size(); i++)
         {
+            const double s = s_list[i];
             Vec3D vn_inner_brdr{0, 0, 0};
-            const double t_inner_brdr = lane.inner_border.get(s);
-            out_mesh.vertices.push_back(this->get_surface_pt(s, t_inner_brdr, &vn_inner_brdr));
+            const double t_inner_brdr = inner_brdr.get(s);
+            out_mesh.vertices.push_back(cursor.get_surface_pt(s_clamped[i], t_inner_brdr, p0[i], s_vec[i], &vn_inner_brdr));
             out_mesh.normals.push_back(vn_inner_brdr);
             out_mesh.st_coordinates.push_back({s, t_inner_brdr});
-            auto pt = this->get_surface_pt(s, t_inner_brdr, &vn_inner_brdr);
-            f << pt[0] << ',' << pt[1] << std::endl;
 
             Vec3D vn_outer_brdr{0, 0, 0};
-            const double t_outer_brdr = lane.outer_border.get(s);
-            out_mesh.vertices.push_back(this->get_surface_pt(s, t_outer_brdr, &vn_outer_brdr));
+            const double t_outer_brdr = outer_brdr.get(s);
+            out_mesh.vertices.push_back(cursor.get_surface_pt(s_clamped[i], t_outer_brdr, p0[i], s_vec[i], &vn_outer_brdr));
             out_mesh.normals.push_back(vn_outer_brdr);
             out_mesh.st_coordinates.push_back({s, t_outer_brdr});
-            pt = this->get_surface_pt(s, t_outer_brdr, &vn_outer_brdr);
-            f << pt[0] << ',' << pt[1] << std::endl;
         }
 
         const std::size_t num_pts = out_mesh.vertices.size();
@@ -313,30 +473,51 @@ namespace odr
 
     Mesh3D Road::get_roadmark_mesh(const Lane &lane, const RoadMark &roadmark, const double eps) const
     {
-        const std::set<double> s_vals = this->approximate_lane_border_linear(lane, roadmark.s_start, roadmark.s_end, eps, true);
+        RoadMarkTable::Mark mark;
+        mark.s_start = roadmark.s_start;
+        mark.s_end = roadmark.s_end;
+        mark.t_offset = roadmark.t_offset;
+        mark.width = roadmark.width;
 
         Mesh3D out_mesh;
-        for (const double &s : s_vals)
+        this->append_roadmark_mesh(lane, mark, roadmark.s_start, roadmark.s_end, eps, out_mesh);
+        return out_mesh;
+    }
+
+    void Road::append_roadmark_mesh(
+        const Lane &lane, const RoadMarkTable::Mark &mark, const double s_start, const double s_end, const double eps, Mesh3D &out) const
+    {
+        std::vector<double> &s_vals = roadmark_s_vals;
+        s_vals.clear();
+        this->approximate_lane_border_linear(lane, std::max(mark.s_start, s_start), std::min(mark.s_end, s_end), eps, true, s_vals);
+        sort_unique(s_vals);
+
+        // Both edges at each s, in one batch
+        std::vector<double> &s_edges = roadmark_s_edges;
+        std::vector<double> &t_edges = roadmark_t_edges;
+        s_edges.resize(2 * s_vals.size());
+        t_edges.resize(2 * s_vals.size());
+        CubicSpline::Cursor outer_brdr(lane.outer_border);
+        for (std::size_t i = 0; i < s_vals.size(); i++)
         {
-            Vec3D vn_edge_a{0, 0, 0};
-            const double t_edge_a = lane.outer_border.get(s) + roadmark.width * 0.5 + roadmark.t_offset;
-            out_mesh.vertices.push_back(this->get_surface_pt(s, t_edge_a, &vn_edge_a));
-            out_mesh.normals.push_back(vn_edge_a);
-
-            Vec3D vn_edge_b{0, 0, 0};
-            const double t_edge_b = t_edge_a - roadmark.width;
-            out_mesh.vertices.push_back(this->get_surface_pt(s, t_edge_b, &vn_edge_b));
-            out_mesh.normals.push_back(vn_edge_b);
+            const double t_edge_a = outer_brdr.get(s_vals[i]) + mark.width * 0.5 + mark.t_offset;
+            s_edges[2 * i] = s_vals[i];
+            s_edges[2 * i + 1] = s_vals[i];
+            t_edges[2 * i] = t_edge_a;
+            t_edges[2 * i + 1] = t_edge_a - mark.width;
         }
 
-        const std::size_t num_pts = out_mesh.vertices.size();
-        for (std::size_t idx = 3; idx < num_pts; idx += 2)
+        const std::size_t idx_offset = out.vertices.size();
+        const std::size_t num_pts = s_edges.size();
+        out.vertices.resize(idx_offset + num_pts);
+        out.normals.resize(idx_offset + num_pts, Vec3D{0, 0, 0});
+        this->get_surface_pt(s_edges.data(), t_edges.data(), num_pts, out.vertices.data() + idx_offset, out.normals.data() + idx_offset);
+
+        for (std::size_t idx = idx_offset + 3; idx < idx_offset + num_pts; idx += 2)
         {
             std::array<size_t, 6> indicies_patch = {idx - 3, idx, idx - 1, idx - 3, idx - 2, idx};
-            out_mesh.indices.insert(out_mesh.indices.end(), indicies_patch.begin(), indicies_patch.end());
+            out.indices.insert(out.indices.end(), indicies_patch.begin(), indicies_patch.end());
         }
-
-        return out_mesh;
     }
 
     Mesh3D Road::get_road_object_mesh(const RoadObject &road_object, const double eps) const
@@ -511,8 +692,7 @@ namespace odr
             }
 
             /* run 2D triangulation on top vertices */
-            const std::vector<size_t> idx_patch_top = mapbox::earcut<size_t>(outline_road_obj_mesh.vertices.data(), road_object.outline.size());
-            outline_road_obj_mesh.indices.insert(outline_road_obj_mesh.indices.end(), idx_patch_top.begin(), idx_patch_top.end());
+            outline_earcut(outline_road_obj_mesh.vertices.data(), road_object.outline.size(), outline_road_obj_mesh.indices);
 
             /* add walls */
             if (!is_flat_object)
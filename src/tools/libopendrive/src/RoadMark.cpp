@@ -1,5 +1,8 @@
 #include "RoadMark.h"
 
+#include <algorithm>
+#include <iterator>
+
 namespace odr
 {
 RoadMarksLine::RoadMarksLine(std::string road_id,
@@ -50,4 +53,61 @@ RoadMark::RoadMark(std::string road_id,
 {
 }
 
+void RoadMarkTable::build(const std::set<RoadMarkGroup>& groups, const double s_start, const double s_end)
+{
+    this->marks.clear();
+    this->types.clear();
+    this->reach.clear();
+
+    auto type_index = [&](const std::string& type) -> uint32_t
+    {
+        // A lane has a handful of types at most
+        auto type_iter = std::find(this->types.begin(), this->types.end(), type);
+        if (type_iter == this->types.end())
+            type_iter = this->types.insert(this->types.end(), type);
+        return uint32_t(type_iter - this->types.begin());
+    };
+    auto add_mark = [&](Mark mark)
+    {
+        if (mark.s_start < mark.s_end)
+            this->marks.push_back(mark);
+    };
+
+    for (auto group_iter = groups.begin(); group_iter != groups.end(); group_iter++)
+    {
+        const RoadMarkGroup& group = *group_iter;
+        const double group_s0 = group.lanesection_s0 + group.s_offset;
+        const double group_s_start = std::max(group_s0, s_start);
+        const auto next_group_iter = std::next(group_iter);
+        const double group_s_end =
+            next_group_iter == groups.end() ? s_end : std::min(next_group_iter->lanesection_s0 + next_group_iter->s_offset, s_end);
+
+        double width = group.weight == "bold" ? ROADMARK_WEIGHT_BOLD_WIDTH : ROADMARK_WEIGHT_STANDARD_WIDTH;
+        if (group.roadmark_lines.empty())
+        {
+            if (group.width > 0)
+                width = group.width;
+            add_mark(Mark{group_s_start, group_s_end, 0, width, group_s0, type_index(group.type)});
+            continue;
+        }
+
+        for (const RoadMarksLine& line : group.roadmark_lines)
+        {
+            if (line.width > 0)
+                width = line.width;
+            if ((line.length + line.space) == 0)
+                continue;
+
+            const uint32_t type = type_index(group.type + line.name);
+            for (double s_dash = line.group_s0 + line.s_offset; s_dash < group_s_end; s_dash += (line.length + line.space))
+                add_mark(Mark{s_dash, std::min(s_end, s_dash + line.length), line.t_offset, width, line.group_s0, type});
+        }
+    }
+
+    std::stable_sort(this->marks.begin(), this->marks.end(), [](const Mark& lhs, const Mark& rhs) { return lhs.s_start < rhs.s_start; });
+    this->reach.reserve(this->marks.size());
+    for (const Mark& mark : this->marks)
+        this->reach.push_back(this->reach.empty() ? mark.s_end : std::max(this->reach.back(), mark.s_end));
+}
+
 } // namespace odr
\ No newline at end of file
@@ -84,6 +84,57 @@ std::array<size_t, 2> RoadObjectsMesh::get_idx_interval_road_object(const std::s
     return get_key_interval<size_t, std::string>(this->road_object_start_indices, vert_idx, this->vertices.size());
 }
 
+template<typename T>
+void add_start_indices(std::map<size_t, T>& start_indices, const std::map<size_t, T>& other, const std::size_t offset)
+{
+    for (const auto& idx_val : other)
+        start_indices[idx_val.first + offset] = idx_val.second;
+}
+
+void RoadNetworkMesh::add_mesh(const RoadNetworkMesh& other)
+{
+    const std::size_t lanes_offset = this->lanes_mesh.vertices.size();
+    add_start_indices(this->lanes_mesh.road_start_indices, other.lanes_mesh.road_start_indices, lanes_offset);
+    add_start_indices(this->lanes_mesh.lanesec_start_indices, other.lanes_mesh.lanesec_start_indices, lanes_offset);
+    add_start_indices(this->lanes_mesh.lane_start_indices, other.lanes_mesh.lane_start_indices, lanes_offset);
+    this->lanes_mesh.add_mesh(other.lanes_mesh);
+
+    const std::size_t roadmarks_offset = this->roadmarks_mesh.vertices.size();
+    add_start_indices(this->roadmarks_mesh.road_start_indices, other.roadmarks_mesh.road_start_indices, roadmarks_offset);
+    add_start_indices(this->roadmarks_mesh.lanesec_start_indices, other.roadmarks_mesh.lanesec_start_indices, roadmarks_offset);
+    add_start_indices(this->roadmarks_mesh.lane_start_indices, other.roadmarks_mesh.lane_start_indices, roadmarks_offset);
+    add_start_indices(this->roadmarks_mesh.roadmark_type_start_indices, other.roadmarks_mesh.roadmark_type_start_indices, roadmarks_offset);
+    this->roadmarks_mesh.add_mesh(other.roadmarks_mesh);
+
+    const std::size_t objects_offset = this->road_objects_mesh.vertices.size();
+    add_start_indices(this->road_objects_mesh.road_start_indices, other.road_objects_mesh.road_start_indices, objects_offset);
+    add_start_indices(this->road_objects_mesh.road_object_start_indices, other.road_objects_mesh.road_object_start_indices, objects_offset);
+    this->road_objects_mesh.add_mesh(other.road_objects_mesh);
+}
+
+RoadNetworkMesh RoadNetworkMesh::concat(const std::vector<RoadNetworkMesh>& parts)
+{
+    std::array<std::size_t, 3> num_vertices{0, 0, 0};
+    std::array<std::size_t, 3> num_indices{0, 0, 0};
+    for (const RoadNetworkMesh& part : parts)
+    {
+        num_vertices[0] += part.lanes_mesh.vertices.size();
+        num_indices[0] += part.lanes_mesh.indices.size();
+        num_vertices[1] += part.roadmarks_mesh.vertices.size();
+        num_indices[1] += part.roadmarks_mesh.indices.size();
+        num_vertices[2] += part.road_objects_mesh.vertices.size();
+        num_indices[2] += part.road_objects_mesh.indices.size();
+    }
+
+    RoadNetworkMesh out_mesh;
+    out_mesh.lanes_mesh.reserve_more(num_vertices[0], num_indices[0]);
+    out_mesh.roadmarks_mesh.reserve_more(num_vertices[1], num_indices[1]);
+    out_mesh.road_objects_mesh.reserve_more(num_vertices[2], num_indices[2]);
+    for (const RoadNetworkMesh& part : parts)
+        out_mesh.add_mesh(part);
+    return out_mesh;
+}
+
 Mesh3D RoadNetworkMesh::get_mesh() const
 {
     Mesh3D out_mesh;
@@ -0,0 +1,150 @@
+#include "RoadNetworkMeshTiles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace odr
+{
+
+namespace
+{
+// Roads are cut into pieces this much shorter than a tile, and each piece
+// goes to the tile its midpoint is in
+constexpr double PIECES_PER_TILE = 16.0;
+} // namespace
+
+RoadNetworkMeshTiles::RoadNetworkMeshTiles(const OpenDriveMap& map, double tile_size) : map(map), tile_size(tile_size)
+{
+    if (!(tile_size > 0))
+        throw std::invalid_argument("tile size must be positive");
+
+    std::vector<double> s_mid;
+    std::vector<Vec3D>  pts;
+    for (uint32_t road_index = 0; road_index < map.road_count(); road_index++)
+    {
+        const Road& road = map.road(road_index);
+        if (!(road.length > 0))
+            continue;
+
+        const std::size_t num_pieces = static_cast<std::size_t>(std::ceil(road.length * PIECES_PER_TILE / tile_size));
+        s_mid.resize(num_pieces);
+        for (std::size_t k = 0; k < num_pieces; k++)
+            s_mid[k] = road.length * (k + 0.5) / num_pieces;
+        pts.resize(num_pieces);
+        road.ref_line.get_xyz(s_mid.data(), num_pieces, pts.data());
+
+        // Runs of pieces in the same tile become one span
+        std::size_t first = 0;
+        for (std::size_t k = 1; k <= num_pieces; k++)
+        {
+            const MeshTile tile = this->tile_at(pts[first][0], pts[first][1]);
+            if (k < num_pieces)
+            {
+                const MeshTile next = this->tile_at(pts[k][0], pts[k][1]);
+                if (next.x == tile.x && next.y == tile.y)
+                    continue;
+            }
+            const double s_start = road.length * first / num_pieces;
+            const double s_end = (k == num_pieces) ? road.length : road.length * k / num_pieces;
+            this->tile_to_spans[{tile.x, tile.y}].push_back({road_index, s_start, s_end});
+            first = k;
+        }
+    }
+}
+
+MeshTile RoadNetworkMeshTiles::tile_at(double x, double y) const
+{
+    return MeshTile{static_cast<int>(std::floor(x / this->tile_size)), static_cast<int>(std::floor(y / this->tile_size))};
+}
+
+std::vector<MeshTile> RoadNetworkMeshTiles::tiles() const
+{
+    std::vector<MeshTile> out_tiles;
+    out_tiles.reserve(this->tile_to_spans.size());
+    for (const auto& tile_spans : this->tile_to_spans)
+        out_tiles.push_back(MeshTile{tile_spans.first.first, tile_spans.first.second});
+    return out_tiles;
+}
+
+const RoadNetworkMesh& RoadNetworkMeshTiles::get_mesh(const MeshTile& tile, double eps) const
+{
+    MeshCache* cache;
+    {
+        std::lock_guard<std::mutex> lock(this->meshes_mutex);
+        cache = &this->meshes[std::make_tuple(tile.x, tile.y, eps)];
+    }
+    // Built outside the lock, so other tiles aren't held up. Callers for
+    // this tile and eps wait in call_once until it's built.
+    std::call_once(cache->built,
+                   [&]()
+                   {
+                       const auto spans_iter = this->tile_to_spans.find({tile.x, tile.y});
+                       if (spans_iter != this->tile_to_spans.end())
+                           cache->mesh = this->build_mesh(spans_iter->second, eps);
+                   });
+    return cache->mesh;
+}
+
+RoadNetworkMesh RoadNetworkMeshTiles::build_mesh(const std::vector<RoadSpan>& spans, double eps) const
+{
+    // A part per span, concatenated once all are built, so the tile's
+    // buffers are sized once
+    std::vector<RoadNetworkMesh> parts(spans.size());
+    for (std::size_t i = 0; i < spans.size(); i++)
+    {
+        const RoadSpan&  span = spans[i];
+        const Road&      road = this->map.road(span.road_index);
+        RoadNetworkMesh& part = parts[i];
+        LanesMesh&       lanes_mesh = part.lanes_mesh;
+        RoadmarksMesh&   roadmarks_mesh = part.roadmarks_mesh;
+        RoadObjectsMesh& road_objects_mesh = part.road_objects_mesh;
+
+        lanes_mesh.road_start_indices[0] = road.id;
+        roadmarks_mesh.road_start_indices[0] = road.id;
+        road_objects_mesh.road_start_indices[0] = road.id;
+
+        for (const LaneSection& lanesec : road.lanesections())
+        {
+            const double s_start = std::max(span.s_start, lanesec.s0);
+            const double s_end = std::min(span.s_end, road.get_lanesection_end(lanesec));
+            if (!(s_start < s_end))
+                continue;
+
+            lanes_mesh.lanesec_start_indices[lanes_mesh.vertices.size()] = lanesec.s0;
+            roadmarks_mesh.lanesec_start_indices[roadmarks_mesh.vertices.size()] = lanesec.s0;
+            for (const Lane& lane : lanesec.lanes())
+            {
+                lanes_mesh.lane_start_indices[lanes_mesh.vertices.size()] = lane.id;
+                lanes_mesh.add_mesh(road.get_lane_mesh(lane, s_start, s_end, eps));
+
+                roadmarks_mesh.lane_start_indices[roadmarks_mesh.vertices.size()] = lane.id;
+                // Dashes that began in the span before are cut where this
+                // one starts, so no piece is drawn twice
+                lane.roadmark_table.for_each(s_start,
+                                             s_end,
+                                             [&](const RoadMarkTable::Mark& mark)
+                                             {
+                                                 roadmarks_mesh.roadmark_type_start_indices[roadmarks_mesh.vertices.size()] =
+                                                     lane.roadmark_table.type(mark);
+                                                 road.append_roadmark_mesh(lane, mark, s_start, s_end, eps, roadmarks_mesh);
+                                             });
+            }
+        }
+
+        // Objects before the road's start or past its end go to its first
+        // or last span
+        const bool first_span = span.s_start <= 0;
+        const bool last_span = span.s_end >= road.length;
+        for (const RoadObject& road_object : road.road_objects())
+        {
+            if ((road_object.s0 < span.s_start && !first_span) || (road_object.s0 >= span.s_end && !last_span))
+                continue;
+            road_objects_mesh.road_object_start_indices[road_objects_mesh.vertices.size()] = road_object.id;
+            road_objects_mesh.add_mesh(road.get_road_object_mesh(road_object, eps));
+        }
+    }
+    return RoadNetworkMesh::concat(parts);
+}
+
+} // namespace odr
@@ -0,0 +1,307 @@
+#include "RoadSurfaceBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace odr
+{
+
+namespace
+{
+constexpr uint32_t MAX_LEAF_TRIANGLES = 4;
+// Deeper than a median split of 2^32 triangles goes
+constexpr std::size_t MAX_DEPTH = 64;
+// Points this close outside a triangle, in barycentric terms, still count,
+// so none fall through the seams between neighbours
+constexpr double EDGE_TOLERANCE = 1e-9;
+
+double dot(const Vec3D& a, const Vec3D& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+Vec3D up_normal(const Vec3D& e1, const Vec3D& e2)
+{
+    Vec3D n = crossProduct(e1, e2);
+    if (n[2] < 0)
+        n = {-n[0], -n[1], -n[2]};
+    const double len = std::sqrt(dot(n, n));
+    return len > 0 ? Vec3D{n[0] / len, n[1] / len, n[2] / len} : Vec3D{0, 0, 1};
+}
+
+// Where along the ray it enters the box, or INFINITY if it misses it
+double box_entry(const Vec3D& min, const Vec3D& max, const Vec3D& origin, const Vec3D& inv_dir, double max_t)
+{
+    double t_near = 0, t_far = max_t;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        double t1 = (min[axis] - origin[axis]) * inv_dir[axis];
+        double t2 = (max[axis] - origin[axis]) * inv_dir[axis];
+        if (t1 > t2)
+            std::swap(t1, t2);
+        // NaN, from a ray in the plane of a face, leaves the bounds as they are
+        t_near = t1 > t_near ? t1 : t_near;
+        t_far = t2 < t_far ? t2 : t_far;
+        if (t_near > t_far)
+            return INFINITY;
+    }
+    return t_near;
+}
+} // namespace
+
+RoadSurfaceBVH::RoadSurfaceBVH(const LanesMesh& mesh)
+{
+    // A lane's vertices run from its start index to the next lane's
+    std::vector<std::size_t> lane_starts;
+    for (const auto& lane_start : mesh.lane_start_indices)
+    {
+        lane_starts.push_back(lane_start.first);
+        this->lanes_.emplace_back(mesh.get_road_id(lane_start.first), mesh.get_lanesec_s0(lane_start.first), lane_start.second);
+    }
+
+    this->triangles.reserve(mesh.indices.size() / 3);
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        Triangle tri;
+        for (int c = 0; c < 3; c++)
+            tri.corners[c] = mesh.vertices.at(mesh.indices[i + c]);
+        // Lanes of zero width, like the center lane, give slivers
+        const Vec3D n = crossProduct(sub(tri.corners[1], tri.corners[0]), sub(tri.corners[2], tri.corners[0]));
+        if (dot(n, n) < 1e-18)
+            continue;
+        const auto lane = std::upper_bound(lane_starts.begin(), lane_starts.end(), std::size_t(mesh.indices[i]));
+        tri.lane = lane == lane_starts.begin() ? NO_INDEX : uint32_t(lane - lane_starts.begin() - 1);
+        this->triangles.push_back(tri);
+    }
+    if (this->triangles.empty())
+        return;
+
+    std::vector<Vec3D>    centroids(this->triangles.size());
+    std::vector<uint32_t> order(this->triangles.size());
+    for (uint32_t i = 0; i < this->triangles.size(); i++)
+    {
+        const Vec3D* c = this->triangles[i].corners;
+        centroids[i] = {(c[0][0] + c[1][0] + c[2][0]) / 3, (c[0][1] + c[1][1] + c[2][1]) / 3, (c[0][2] + c[1][2] + c[2][2]) / 3};
+        order[i] = i;
+    }
+    // A binary tree with leaves of one to four triangles has fewer than
+    // this many nodes
+    this->nodes.reserve(2 * this->triangles.size());
+    this->nodes.emplace_back();
+    this->build(0, 0, uint32_t(this->triangles.size()), order, centroids);
+
+    std::vector<Triangle> sorted;
+    sorted.reserve(order.size());
+    for (uint32_t i : order)
+        sorted.push_back(this->triangles[i]);
+    this->triangles = std::move(sorted);
+}
+
+RoadSurfaceBVH::RoadSurfaceBVH(const OpenDriveMap& map, double eps) : RoadSurfaceBVH(map.get_road_network_mesh(eps).lanes_mesh) {}
+
+void RoadSurfaceBVH::fit(Node& node, uint32_t first, uint32_t count, const std::vector<uint32_t>& order) const
+{
+    node.min = {INFINITY, INFINITY, INFINITY};
+    node.max = {-INFINITY, -INFINITY, -INFINITY};
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        for (const Vec3D& corner : this->triangles[order[i]].corners)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                node.min[axis] = std::min(node.min[axis], corner[axis]);
+                node.max[axis] = std::max(node.max[axis], corner[axis]);
+            }
+        }
+    }
+}
+
+void RoadSurfaceBVH::build(uint32_t node_index, uint32_t first, uint32_t count, std::vector<uint32_t>& order, const std::vector<Vec3D>& centroids)
+{
+    this->fit(this->nodes[node_index], first, count, order);
+    if (count <= MAX_LEAF_TRIANGLES)
+    {
+        this->nodes[node_index].first = first;
+        this->nodes[node_index].count = count;
+        return;
+    }
+
+    Vec3D lo{INFINITY, INFINITY, INFINITY}, hi{-INFINITY, -INFINITY, -INFINITY};
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            lo[axis] = std::min(lo[axis], centroids[order[i]][axis]);
+            hi[axis] = std::max(hi[axis], centroids[order[i]][axis]);
+        }
+    }
+    int axis = 0;
+    for (int a = 1; a < 3; a++)
+        if (hi[a] - lo[a] > hi[axis] - lo[axis])
+            axis = a;
+
+    const uint32_t half = count / 2;
+    std::nth_element(order.begin() + first,
+                     order.begin() + first + half,
+                     order.begin() + first + count,
+                     [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+    // Children are added as a pair, so that the right one follows the left
+    const uint32_t left = uint32_t(this->nodes.size());
+    this->nodes.emplace_back();
+    this->nodes.emplace_back();
+    this->nodes[node_index].first = left;
+    this->nodes[node_index].count = 0;
+    this->build(left, first, half, order, centroids);
+    this->build(left + 1, first + half, count - half, order, centroids);
+}
+
+SurfaceHit RoadSurfaceBVH::height_at(double x, double y, double z) const
+{
+    SurfaceHit hit;
+    if (this->nodes.empty())
+        return hit;
+    // How far a surface at height h is from z; lower is better
+    auto score = [z](double h) { return std::isinf(z) ? -h : std::abs(h - z); };
+    double best = INFINITY;
+
+    uint32_t    stack[MAX_DEPTH];
+    std::size_t depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0)
+    {
+        const Node& node = this->nodes[stack[--depth]];
+        if (x < node.min[0] || x > node.max[0] || y < node.min[1] || y > node.max[1])
+            continue;
+        // The best any surface in the node could do
+        const double bound = std::isinf(z) ? -node.max[2] : std::max({0.0, node.min[2] - z, z - node.max[2]});
+        if (bound >= best)
+            continue;
+        if (node.count == 0)
+        {
+            stack[depth++] = node.first;
+            stack[depth++] = node.first + 1;
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            const Triangle& tri = this->triangles[i];
+            const Vec3D     e1 = sub(tri.corners[1], tri.corners[0]);
+            const Vec3D     e2 = sub(tri.corners[2], tri.corners[0]);
+            const double    det = e1[0] * e2[1] - e1[1] * e2[0];
+            if (std::abs(det) < 1e-12)
+                continue; // Seen edge on from above
+            const double px = x - tri.corners[0][0];
+            const double py = y - tri.corners[0][1];
+            const double u = (px * e2[1] - py * e2[0]) / det;
+            const double v = (e1[0] * py - e1[1] * px) / det;
+            if (u < -EDGE_TOLERANCE || v < -EDGE_TOLERANCE || u + v > 1 + EDGE_TOLERANCE)
+                continue;
+            const double h = tri.corners[0][2] + u * e1[2] + v * e2[2];
+            if (score(h) >= best)
+                continue;
+            best = score(h);
+            hit.hit = true;
+            hit.point = {x, y, h};
+            hit.normal = up_normal(e1, e2);
+            hit.lane = tri.lane;
+        }
+    }
+    return hit;
+}
+
+void RoadSurfaceBVH::height_at(const Vec2D* points, std::size_t count, SurfaceHit* out, double z) const
+{
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = this->height_at(points[i][0], points[i][1], z);
+}
+
+std::vector<SurfaceHit> RoadSurfaceBVH::height_at(const std::vector<Vec2D>& points, double z) const
+{
+    std::vector<SurfaceHit> hits(points.size());
+    this->height_at(points.data(), points.size(), hits.data(), z);
+    return hits;
+}
+
+SurfaceHit RoadSurfaceBVH::intersect(const SurfaceRay& ray) const
+{
+    SurfaceHit   hit;
+    const double len = std::sqrt(dot(ray.direction, ray.direction));
+    if (this->nodes.empty() || len == 0)
+        return hit;
+    const Vec3D dir{ray.direction[0] / len, ray.direction[1] / len, ray.direction[2] / len};
+    const Vec3D inv_dir{1 / dir[0], 1 / dir[1], 1 / dir[2]};
+    double      best = ray.max_distance;
+
+    uint32_t    stack[MAX_DEPTH];
+    std::size_t depth = 0;
+    if (box_entry(this->nodes[0].min, this->nodes[0].max, ray.origin, inv_dir, best) == INFINITY)
+        return hit;
+    stack[depth++] = 0;
+    while (depth > 0)
+    {
+        const Node& node = this->nodes[stack[--depth]];
+        if (node.count == 0)
+        {
+            // Nearer child on top, so that its hits prune the other
+            const Node&  left = this->nodes[node.first];
+            const Node&  right = this->nodes[node.first + 1];
+            const double t_left = box_entry(left.min, left.max, ray.origin, inv_dir, best);
+            const double t_right = box_entry(right.min, right.max, ray.origin, inv_dir, best);
+            const bool   left_first = t_left <= t_right;
+            const double t_far = left_first ? t_right : t_left;
+            const double t_near = left_first ? t_left : t_right;
+            if (t_far != INFINITY)
+                stack[depth++] = left_first ? node.first + 1 : node.first;
+            if (t_near != INFINITY)
+                stack[depth++] = left_first ? node.first : node.first + 1;
+            continue;
+        }
+        if (box_entry(node.min, node.max, ray.origin, inv_dir, best) == INFINITY)
+            continue; // A hit since it was pushed is nearer than the box
+
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            // Möller-Trumbore
+            const Triangle& tri = this->triangles[i];
+            const Vec3D     e1 = sub(tri.corners[1], tri.corners[0]);
+            const Vec3D     e2 = sub(tri.corners[2], tri.corners[0]);
+            const Vec3D     p = crossProduct(dir, e2);
+            const double    det = dot(e1, p);
+            if (std::abs(det) < 1e-12)
+                continue; // Parallel to the triangle
+            const Vec3D  to_origin = sub(ray.origin, tri.corners[0]);
+            const double u = dot(to_origin, p) / det;
+            if (u < -EDGE_TOLERANCE || u > 1 + EDGE_TOLERANCE)
+                continue;
+            const Vec3D  q = crossProduct(to_origin, e1);
+            const double v = dot(dir, q) / det;
+            if (v < -EDGE_TOLERANCE || u + v > 1 + EDGE_TOLERANCE)
+                continue;
+            const double t = dot(e2, q) / det;
+            if (t < 0 || t >= best)
+                continue;
+            best = t;
+            hit.hit = true;
+            hit.distance = t;
+            hit.point = {ray.origin[0] + t * dir[0], ray.origin[1] + t * dir[1], ray.origin[2] + t * dir[2]};
+            hit.normal = up_normal(e1, e2);
+            hit.lane = tri.lane;
+        }
+    }
+    return hit;
+}
+
+void RoadSurfaceBVH::intersect(const SurfaceRay* rays, std::size_t count, SurfaceHit* out) const
+{
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = this->intersect(rays[i]);
+}
+
+std::vector<SurfaceHit> RoadSurfaceBVH::intersect(const std::vector<SurfaceRay>& rays) const
+{
+    std::vector<SurfaceHit> hits(rays.size());
+    this->intersect(rays.data(), rays.size(), hits.data());
+    return hits;
+}
+
+} // namespace odr
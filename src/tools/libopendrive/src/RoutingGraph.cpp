@@ -1,7 +1,11 @@
 #include "RoutingGraph.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
 #include <limits>
+#include <queue>
 #include <utility>
 
 namespace odr
@@ -37,73 +41,174 @@ std::vector<LaneKey> RoutingGraph::get_lane_predecessors(const LaneKey& lane_key
     return predecessor_lane_keys;
 }
 
-std::vector<LaneKey> RoutingGraph::shortest_path(const LaneKey& from, const LaneKey& to) const
+struct RoutingGraph::Index
 {
-    std::vector<LaneKey> path;
-    if (this->lane_key_to_successors.count(from) == 0)
-        return path;
+    std::size_t edge_count = 0; // Of the graph, when built
+    std::size_t end_count = 0;
+
+    std::vector<LaneKey>                  keys;
+    std::unordered_map<LaneKey, uint32_t> ids;
+
+    // Successors of lane i are targets[offsets[i]] to targets[offsets[i + 1]]
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<double>   weights;
+
+    std::vector<std::array<Vec2D, 2>> ends;
+    std::vector<bool>                 has_ends;
 
-    std::unordered_set<LaneKey> vertices;
+    // Largest ratio of a lane's chord (the distance between its ends) to
+    // its weight. Lanes meet end to end, so the straight-line distance
+    // between a lane and the target, divided by this, is at most the path
+    // weight between them: the heuristic never overestimates.
+    double chord_ratio = 1.0;
+};
+
+std::shared_ptr<const RoutingGraph::Index> RoutingGraph::get_index() const
+{
+    std::shared_ptr<const Index> current = std::atomic_load(&this->cached_index);
+    if (current != nullptr && current->edge_count == this->edges.size() && current->end_count == this->lane_key_to_ends.size())
+        return current;
+
+    auto built = std::make_shared<Index>();
+    built->edge_count = this->edges.size();
+    built->end_count = this->lane_key_to_ends.size();
+    auto id_of = [&](const LaneKey& key) -> uint32_t
+    {
+        auto inserted = built->ids.insert({key, static_cast<uint32_t>(built->keys.size())});
+        if (inserted.second)
+            built->keys.push_back(key);
+        return inserted.first->second;
+    };
     for (const auto& lane_key_successors : this->lane_key_to_successors)
     {
-        vertices.insert(lane_key_successors.first);
-        vertices.insert(lane_key_successors.second.begin(), lane_key_successors.second.end());
+        id_of(lane_key_successors.first);
+        for (const WeightedLaneKey& successor : lane_key_successors.second)
+            id_of(successor);
     }
 
-    if (vertices.count(to) == 0)
-        return path;
-
-    std::vector<LaneKey>                 nodes;
-    std::unordered_map<LaneKey, double>  weights;
-    std::unordered_map<LaneKey, LaneKey> previous;
+    const std::size_t n = built->keys.size();
+    built->offsets.assign(n + 1, 0);
+    for (const auto& lane_key_successors : this->lane_key_to_successors)
+        built->offsets[built->ids.at(lane_key_successors.first) + 1] = static_cast<uint32_t>(lane_key_successors.second.size());
+    for (std::size_t i = 0; i < n; i++)
+        built->offsets[i + 1] += built->offsets[i];
 
-    auto comparator = [&](const LaneKey& lhs, const LaneKey& rhs) { return weights[lhs] > weights[rhs]; };
-    for (const auto& lane_key : vertices)
+    built->targets.resize(built->offsets[n]);
+    built->weights.resize(built->offsets[n]);
+    for (const auto& lane_key_successors : this->lane_key_to_successors)
     {
-        if (std::equal_to<odr::LaneKey>{}(lane_key, from))
-            weights[lane_key] = 0;
-        else
-            weights[lane_key] = std::numeric_limits<double>::max();
-        nodes.push_back(lane_key);
-        std::push_heap(nodes.begin(), nodes.end(), comparator);
+        uint32_t edge = built->offsets[built->ids.at(lane_key_successors.first)];
+        for (const WeightedLaneKey& successor : lane_key_successors.second)
+        {
+            built->targets[edge] = built->ids.at(successor);
+            built->weights[edge] = successor.weight;
+            edge++;
+        }
     }
 
-    while (nodes.empty() == false)
+    built->ends.resize(n);
+    built->has_ends.assign(n, false);
+    for (uint32_t i = 0; i < n; i++)
     {
-        std::pop_heap(nodes.begin(), nodes.end(), comparator);
-        LaneKey smallest = nodes.back();
-        nodes.pop_back();
+        auto ends_iter = this->lane_key_to_ends.find(built->keys[i]);
+        if (ends_iter == this->lane_key_to_ends.end())
+            continue;
+        built->ends[i] = ends_iter->second;
+        built->has_ends[i] = true;
 
-        if (std::equal_to<LaneKey>{}(smallest, to))
+        const double chord = std::hypot(ends_iter->second[1][0] - ends_iter->second[0][0], ends_iter->second[1][1] - ends_iter->second[0][1]);
+        for (uint32_t edge = built->offsets[i]; edge < built->offsets[i + 1]; edge++)
         {
-            while (previous.find(smallest) != previous.end())
-            {
-                path.push_back(smallest);
-                smallest = previous.at(smallest);
-            }
-            break;
+            if (built->weights[edge] > 1e-6)
+                built->chord_ratio = std::max(built->chord_ratio, chord / built->weights[edge]);
         }
+    }
 
-        if (weights.at(smallest) == std::numeric_limits<double>::max())
-            break;
+    std::atomic_store(&this->cached_index, std::shared_ptr<const Index>(built));
+    return built;
+}
+
+std::vector<LaneKey> RoutingGraph::shortest_path(const LaneKey& from, const LaneKey& to) const { return this->search(from, to, false); }
 
-        auto smallest_succ_iter = this->lane_key_to_successors.find(smallest);
-        if (smallest_succ_iter == this->lane_key_to_successors.end())
+std::vector<LaneKey> RoutingGraph::shortest_path_astar(const LaneKey& from, const LaneKey& to) const { return this->search(from, to, true); }
+
+std::vector<LaneKey> RoutingGraph::search(const LaneKey& from, const LaneKey& to, bool use_heuristic) const
+{
+    std::vector<LaneKey> path;
+    const std::shared_ptr<const Index> index = this->get_index();
+    auto from_iter = index->ids.find(from);
+    auto to_iter = index->ids.find(to);
+    if (from_iter == index->ids.end() || to_iter == index->ids.end())
+        return path;
+    const uint32_t source = from_iter->second;
+    const uint32_t target = to_iter->second;
+
+    const std::size_t     n = index->keys.size();
+    constexpr double      unreached = std::numeric_limits<double>::infinity();
+    constexpr uint32_t    no_lane = std::numeric_limits<uint32_t>::max();
+    std::vector<double>   cost(n, unreached);
+    std::vector<uint32_t> previous(n, no_lane);
+
+    // Heuristic of each lane, computed when first needed. Zero (Dijkstra)
+    // without ends.
+    const bool          guided = use_heuristic && index->has_ends[target];
+    std::vector<double> heuristics(guided ? n : 0, -1.0);
+    auto                heuristic = [&](uint32_t lane) -> double
+    {
+        if (!guided || !index->has_ends[lane])
+            return 0.0;
+        if (heuristics[lane] < 0.0)
+        {
+            double dist = unreached;
+            for (const Vec2D& a : index->ends[lane])
+                for (const Vec2D& b : index->ends[target])
+                    dist = std::min(dist, std::hypot(a[0] - b[0], a[1] - b[1]));
+            heuristics[lane] = dist / index->chord_ratio;
+        }
+        return heuristics[lane];
+    };
+
+    // Lazy deletion: a lane is pushed again when its cost drops, and
+    // entries older than its cost are skipped when popped. The heuristic
+    // needn't be consistent, since a lane can be expanded again.
+    struct Entry
+    {
+        double   priority;
+        double   cost;
+        uint32_t lane;
+        bool     operator>(const Entry& other) const { return priority > other.priority; }
+    };
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    cost[source] = 0.0;
+    open.push({heuristic(source), 0.0, source});
+
+    while (!open.empty())
+    {
+        const Entry entry = open.top();
+        open.pop();
+        if (entry.lane == target)
+            break;
+        if (entry.cost > cost[entry.lane])
             continue;
 
-        for (const auto& successor : smallest_succ_iter->second)
+        for (uint32_t edge = index->offsets[entry.lane]; edge < index->offsets[entry.lane + 1]; edge++)
         {
-            const double alt = weights.at(smallest) + successor.weight;
-            if (alt < weights.at(successor))
+            const uint32_t successor = index->targets[edge];
+            const double   alt = entry.cost + index->weights[edge];
+            if (alt < cost[successor])
             {
-                weights[successor] = alt;
-                previous.insert({successor, smallest});
-                std::make_heap(nodes.begin(), nodes.end(), comparator);
+                cost[successor] = alt;
+                previous[successor] = entry.lane;
+                open.push({alt + heuristic(successor), alt, successor});
             }
         }
     }
 
-    path.push_back(from);
+    if (cost[target] == unreached)
+        return path;
+    for (uint32_t lane = target; lane != no_lane; lane = previous[lane])
+        path.push_back(index->keys[lane]);
     std::reverse(path.begin(), path.end());
     return path;
 }
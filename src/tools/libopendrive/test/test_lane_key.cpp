@@ -0,0 +1,76 @@
+// Test that lane keys numbered by OpenDriveMap and keys built by hand for
+// the same lane are interchangeable.
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+#include "Lane.h"
+#include "RoutingGraph.h"
+
+namespace
+{
+odr::LaneKey indexed(const char* road_id, double s0, int lane_id, uint32_t road_index, uint32_t lanesection_index)
+{
+    odr::LaneKey key(road_id, s0, lane_id);
+    key.road_index = road_index;
+    key.lanesection_index = lanesection_index;
+    return key;
+}
+} // namespace
+
+TEST(LaneKey, IndexedAndHandBuiltKeysAgree)
+{
+    const odr::LaneKey numbered = indexed("7", 12.5, -1, 3, 5);
+    const odr::LaneKey by_hand("7", 12.5, -1);
+
+    EXPECT_TRUE(std::equal_to<odr::LaneKey>{}(numbered, by_hand));
+    EXPECT_EQ(std::hash<odr::LaneKey>{}(numbered), std::hash<odr::LaneKey>{}(by_hand));
+    EXPECT_FALSE(std::less<odr::LaneKey>{}(numbered, by_hand));
+    EXPECT_FALSE(std::less<odr::LaneKey>{}(by_hand, numbered));
+
+    std::unordered_set<odr::LaneKey> keys = {numbered};
+    EXPECT_EQ(keys.count(by_hand), 1u);
+}
+
+TEST(LaneKey, OrderIsStrictAcrossKinds)
+{
+    // Numbered in (road_id, s0) order, and mixed with keys built by hand
+    const std::vector<odr::LaneKey> sorted = {
+        indexed("1", 0.0, -1, 0, 0),
+        odr::LaneKey("1", 0.0, 1),
+        indexed("1", 30.0, -1, 0, 1),
+        odr::LaneKey("2", 0.0, -2),
+        indexed("2", 0.0, -1, 1, 2),
+    };
+    const std::less<odr::LaneKey> less;
+    for (std::size_t i = 0; i < sorted.size(); i++)
+    {
+        EXPECT_FALSE(less(sorted[i], sorted[i])) << i;
+        for (std::size_t j = i + 1; j < sorted.size(); j++)
+        {
+            EXPECT_TRUE(less(sorted[i], sorted[j])) << i << " < " << j;
+            EXPECT_FALSE(less(sorted[j], sorted[i])) << j << " < " << i;
+        }
+    }
+}
+
+// get_routing_graph() builds the graph from numbered keys; callers often
+// name lanes by hand
+TEST(LaneKey, RoutingGraphFindsHandBuiltKeys)
+{
+    const odr::LaneKey a = indexed("1", 0.0, -1, 0, 0);
+    const odr::LaneKey b = indexed("2", 0.0, -1, 1, 1);
+    const odr::LaneKey c = indexed("3", 0.0, -1, 2, 2);
+    odr::RoutingGraph graph;
+    graph.add_edge(odr::RoutingGraphEdge(a, b, 10.0));
+    graph.add_edge(odr::RoutingGraphEdge(b, c, 10.0));
+
+    const std::vector<odr::LaneKey> path = graph.shortest_path(odr::LaneKey("1", 0.0, -1), odr::LaneKey("3", 0.0, -1));
+    ASSERT_EQ(path.size(), 3u);
+    EXPECT_EQ(path[1].road_id, "2");
+    EXPECT_EQ(graph.get_lane_successors(odr::LaneKey("1", 0.0, -1)).size(), 1u);
+    EXPECT_EQ(graph.get_lane_predecessors(odr::LaneKey("3", 0.0, -1)).size(), 1u);
+}
@@ -26,6 +26,14 @@ if(source_filenames) # If we have any source files
   ament_auto_add_library(${PROJECT_NAME}_lib SHARED DIRECTORY src) # Then make a library
 endif()
 
+# Register rclcpp components, if the package lists any in
+# ${PROJECT_NAME}_COMPONENTS before calling this macro. The classes must be
+# built into the library and registered with RCLCPP_COMPONENTS_REGISTER_NODE,
+# and the package must depend on rclcpp_components.
+if(source_filenames AND ${PROJECT_NAME}_COMPONENTS)
+  rclcpp_components_register_nodes(${PROJECT_NAME}_lib ${${PROJECT_NAME}_COMPONENTS})
+endif()
+
 # Build all executables
 file(GLOB_RECURSE executable_filenames "exe/*.cpp") # Get all source files in exe/
 foreach(filename ${executable_filenames}) # Iterate over them
@@ -40,6 +48,75 @@ if(BUILD_TESTING AND test_filenames) # If we have any tests to build
   ament_auto_add_gtest(tests ${test_filenames}) # And add our tests
 endif()
 
+# Build all benchmarks into one Google Benchmark executable. Packages with
+# benchmarks should test_depend on google_benchmark_vendor. Running the
+# ${PROJECT_NAME}_run_benchmarks target writes the results to
+# ${NOVA_BENCHMARK_OUTPUT_DIR}/${PROJECT_NAME}.json, one file per package
+# in the same place.
+file(GLOB bench_filenames "bench/*.cpp") # Find benchmark source files
+if(BUILD_TESTING AND bench_filenames)
+  find_package(benchmark QUIET)
+  if(NOT benchmark_FOUND)
+    message(STATUS "Google Benchmark not found, skipping benchmarks for ${PROJECT_NAME}")
+  else()
+    set(NOVA_BENCHMARK_OUTPUT_DIR "${CMAKE_BINARY_DIR}/../benchmark_results" CACHE PATH
+      "Where the run_benchmarks targets write their JSON results")
+    option(NOVA_BENCHMARK_NATIVE
+      "Build benchmarks and the libraries they measure with -O3 -march=native and LTO" OFF)
+
+    ament_auto_find_test_dependencies()
+    add_executable(benchmarks ${bench_filenames})
+    if(EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/include")
+      target_include_directories(benchmarks PUBLIC "${CMAKE_CURRENT_SOURCE_DIR}/include")
+    endif()
+    if(source_filenames)
+      target_link_libraries(benchmarks ${PROJECT_NAME}_lib)
+    endif()
+    target_link_libraries(benchmarks benchmark::benchmark_main)
+    ament_target_dependencies(benchmarks
+      ${${PROJECT_NAME}_FOUND_BUILD_DEPENDS}
+      ${${PROJECT_NAME}_FOUND_TEST_DEPENDS}
+    )
+
+    # The library is built the same way, since it holds the code being
+    # measured. Binaries built like this only run on the machine that
+    # built them, so keep the option to benchmarking builds.
+    if(NOVA_BENCHMARK_NATIVE)
+      set(_nova_benchmark_targets benchmarks)
+      if(source_filenames)
+        list(APPEND _nova_benchmark_targets ${PROJECT_NAME}_lib)
+      endif()
+      # The LTO flags are added by hand: the INTERPROCEDURAL_OPTIMIZATION
+      # property is ignored under the CMake 3.5 policies packages declare
+      cmake_policy(PUSH)
+      cmake_policy(SET CMP0069 NEW) # Needed by check_ipo_supported()
+      include(CheckIPOSupported)
+      check_ipo_supported(RESULT _nova_ipo_supported OUTPUT _nova_ipo_output)
+      cmake_policy(POP)
+      # GCC and Clang want the same LTO flags when linking
+      string(REPLACE ";" " " _nova_ipo_link_flags "${CMAKE_CXX_COMPILE_OPTIONS_IPO}")
+      foreach(_target ${_nova_benchmark_targets})
+        target_compile_options(${_target} PRIVATE -O3 -march=native)
+        if(_nova_ipo_supported)
+          target_compile_options(${_target} PRIVATE ${CMAKE_CXX_COMPILE_OPTIONS_IPO})
+          set_property(TARGET ${_target} APPEND_STRING PROPERTY LINK_FLAGS " ${_nova_ipo_link_flags}")
+        endif()
+      endforeach()
+      if(NOT _nova_ipo_supported)
+        message(STATUS "LTO is not supported for ${PROJECT_NAME} benchmarks: ${_nova_ipo_output}")
+      endif()
+    endif()
+
+    add_custom_target(${PROJECT_NAME}_run_benchmarks
+      COMMAND ${CMAKE_COMMAND} -E make_directory "${NOVA_BENCHMARK_OUTPUT_DIR}"
+      COMMAND benchmarks
+        --benchmark_out=${NOVA_BENCHMARK_OUTPUT_DIR}/${PROJECT_NAME}.json
+        --benchmark_out_format=json
+      DEPENDS benchmarks
+      COMMENT "Running ${PROJECT_NAME} benchmarks")
+  endif()
+endif()
+
 ament_auto_package()
 
 endmacro()
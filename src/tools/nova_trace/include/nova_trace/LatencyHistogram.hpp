@@ -0,0 +1,80 @@
+/*
+ * Package:   nova_trace
+ * Filename:  LatencyHistogram.hpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Histogram of durations, shared by every node that reports latencies:
+// stage profilers, the latency tracker, the CAN interface and
+// performance tests. Buckets are log-linear, four per power of two of
+// microseconds, so a quantile is off by at most 25%, from 1 us up to
+// about a minute. Recording is a few relaxed atomic adds and may go on
+// from any thread while another reads.
+//
+// This header is kept to C++14, for packages that still build with it.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace navigator {
+namespace trace {
+
+class LatencyHistogram {
+public:
+  static constexpr int BUCKETS = 4 + 4 * 24;
+
+  // Plain copy of the counters, e.g. to work out the statistics of a
+  // window as the difference of two snapshots
+  struct Snapshot {
+    std::array<uint64_t, BUCKETS> buckets {};
+    uint64_t count = 0;
+    uint64_t sum_ns = 0;
+    uint64_t max_ns = 0; // Since the histogram started or was reset
+
+    // Keeps this snapshot's max_ns, as the window's can't be told
+    Snapshot operator-(const Snapshot & earlier) const;
+
+    double mean_ms() const;
+    double max_ms() const;
+    // Upper bound of the bucket holding quantile q in [0, 1], or 0
+    // with nothing recorded
+    uint64_t quantile_us(double q) const;
+    double quantile_ms(double q) const;
+
+    // One line of count, mean, median, 99th percentile and maximum
+    std::string summary() const;
+  };
+
+  // Clocks can step, so a negative duration counts as none
+  void record(std::chrono::nanoseconds duration);
+
+  uint64_t count() const {
+    return this->total_count.load(std::memory_order_relaxed);
+  }
+  Snapshot snapshot() const;
+
+  // Start again from nothing. Only for a histogram nothing is
+  // recording into at the time.
+  void reset();
+
+  // Bucket of a duration, and the smallest duration in a bucket
+  static int bucket_of(uint64_t us);
+  static uint64_t bucket_start_us(int bucket);
+
+private:
+  std::array<std::atomic<uint64_t>, BUCKETS> buckets {};
+  std::atomic<uint64_t> total_count {0};
+  std::atomic<uint64_t> sum_ns {0};
+  std::atomic<uint64_t> max_ns {0};
+};
+
+}
+}
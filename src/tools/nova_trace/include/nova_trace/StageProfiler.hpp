@@ -0,0 +1,76 @@
+/*
+ * Package:   nova_trace
+ * Filename:  StageProfiler.hpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Latency histograms for the stages of a node's pipeline. Every timing
+// also becomes a span named "<trace_prefix>.<stage name>" while
+// tracing is enabled, so the same stages show up on the timeline.
+// Stages are fixed at construction and referred to by index, and
+// recording never locks or allocates.
+//
+// This header is kept to C++14, for packages that still build with it.
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nova_trace/LatencyHistogram.hpp"
+#include "nova_trace/Trace.hpp" // Clock
+
+namespace navigator {
+namespace trace {
+
+class StageProfiler {
+public:
+  // One name per stage, used in diagnostics and traces, and the prefix
+  // of the span names, e.g. the node's
+  StageProfiler(std::vector<std::string> stage_names, const std::string & trace_prefix);
+
+  int stage_count() const {
+    return int(this->names.size());
+  }
+  const std::string & stage_name(int stage) const {
+    return this->names[stage];
+  }
+  const LatencyHistogram & histogram(int stage) const {
+    return this->histograms[stage];
+  }
+
+  void record(int stage, Clock::time_point start, Clock::time_point end);
+
+private:
+  std::vector<std::string> names;
+  std::vector<const char *> trace_names;
+  std::unique_ptr<LatencyHistogram[]> histograms;
+};
+
+// Records the time between its construction and destruction as one run
+// of a stage
+class ScopedStageTimer {
+public:
+  ScopedStageTimer(StageProfiler & profiler, int stage)
+    : profiler(profiler), stage(stage), start(Clock::now()) {}
+
+  ~ScopedStageTimer() {
+    this->profiler.record(this->stage, this->start, Clock::now());
+  }
+
+  ScopedStageTimer(const ScopedStageTimer &) = delete;
+  ScopedStageTimer & operator=(const ScopedStageTimer &) = delete;
+
+private:
+  StageProfiler & profiler;
+  int stage;
+  Clock::time_point start;
+};
+
+}
+}
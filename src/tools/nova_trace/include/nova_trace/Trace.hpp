@@ -0,0 +1,135 @@
+/*
+ * Package:   nova_trace
+ * Filename:  Trace.hpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Spans, counters and message flows that every node can record the
+// same way. Recording is off until enable() is called, or until the
+// process starts with NOVA_TRACE_FILE set; while it is off a span
+// costs one relaxed load. While it is on, each thread appends to a
+// ring buffer of its own, without locking or allocating, and the
+// oldest events are overwritten once it is full.
+//
+// The buffers are written out in the Chrome trace event format, which
+// chrome://tracing and ui.perfetto.dev both open. With
+// NOVA_TRACE_FILE set, that happens when the process exits; a "%p" in
+// the file name is replaced by the process ID, so the nodes of one
+// launch file can share the setting. Builds with lttng-ust can emit
+// every event as an LTTng tracepoint instead, or as well, when the
+// process starts with NOVA_TRACE_LTTNG set; see README.md.
+//
+// Names must be string literals, or otherwise outlive the process:
+// only the pointer is recorded. Names made at run time can be kept
+// with intern().
+//
+// This header is kept to C++14, for packages that still build with it.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace navigator {
+namespace trace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Events kept per thread by threads that start recording after enable()
+constexpr std::size_t DEFAULT_EVENTS_PER_THREAD = 1 << 16;
+
+namespace detail {
+extern std::atomic<bool> active;
+
+void record_span(const char * name, Clock::time_point start, Clock::time_point end);
+void record_flow(const char * name, uint64_t id, Clock::time_point time);
+}
+
+// Start or stop recording into the buffers. Threads that already have
+// a buffer keep it at its old size.
+void enable(std::size_t events_per_thread = DEFAULT_EVENTS_PER_THREAD);
+void disable();
+
+inline bool enabled() {
+  return detail::active.load(std::memory_order_relaxed);
+}
+
+// The ID under which a message is followed from node to node: its
+// header stamp, which nodes pass on to the messages they derive from
+// it. Works with builtin_interfaces::msg::Time, or anything else with
+// sec and nanosec fields.
+template <typename Stamp> uint64_t flow_id(const Stamp & stamp) {
+  return (uint64_t(uint32_t(stamp.sec)) << 32) | uint32_t(stamp.nanosec);
+}
+
+// Times the scope it lives in. A span can carry any number of flows;
+// each is drawn as an arrow between the spans that carry the same ID,
+// in time order.
+class Span {
+public:
+  explicit Span(const char * name) : name(name) {
+    if(enabled()) this->start = Clock::now();
+  }
+
+  Span(const char * name, uint64_t flow) : Span(name) {
+    this->flow(flow);
+  }
+
+  ~Span() {
+    if(this->start != Clock::time_point()) detail::record_span(this->name, this->start, Clock::now());
+  }
+
+  void flow(uint64_t id) {
+    if(this->start != Clock::time_point()) detail::record_flow(this->name, id, this->start);
+  }
+
+  Span(const Span &) = delete;
+  Span & operator=(const Span &) = delete;
+
+private:
+  const char * name;
+  Clock::time_point start;
+};
+
+// Records a span that was timed some other way
+inline void span(const char * name, Clock::time_point start, Clock::time_point end) {
+  if(enabled()) detail::record_span(name, start, end);
+}
+
+// Adds a flow to whichever span on this thread encloses the current
+// time, for code that is timed by something other than a Span
+inline void flow(const char * name, uint64_t id) {
+  if(enabled()) detail::record_flow(name, id, Clock::now());
+}
+
+// Records the current value of a quantity, such as a queue length,
+// which is drawn as a graph over time
+void counter(const char * name, double value);
+
+// A copy of name that lives as long as the process, the same one for
+// equal names. Takes a lock, so call it once and keep the result.
+const char * intern(const std::string & name);
+
+// Write every event still held by the buffers, of every thread that
+// has recorded since the process started. Recording may continue while
+// this runs. The file version returns false if the file could not be
+// written.
+void write_chrome_trace(std::ostream & out);
+bool write_chrome_trace(const std::string & filename);
+
+}
+}
+
+#define NOVA_TRACE_CONCAT_(a, b) a##b
+#define NOVA_TRACE_CONCAT(a, b) NOVA_TRACE_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope, optionally with a flow ID
+#define NOVA_TRACE_SPAN(...) \
+  ::navigator::trace::Span NOVA_TRACE_CONCAT(nova_trace_span_, __LINE__)(__VA_ARGS__)
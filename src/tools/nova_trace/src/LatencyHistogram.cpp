@@ -0,0 +1,104 @@
+/*
+ * Package:   nova_trace
+ * Filename:  LatencyHistogram.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm> // std::max, std::min
+#include <bit> // std::bit_width
+#include <iomanip>
+#include <sstream>
+
+#include "nova_trace/LatencyHistogram.hpp"
+
+using navigator::trace::LatencyHistogram;
+
+int LatencyHistogram::bucket_of(uint64_t us) {
+  // 0-3 us get a bucket each; above that, four buckets per power of two
+  if(us < 4) return int(us);
+  const int octave = std::bit_width(us) - 1;
+  const int sub = int(us >> (octave - 2)) & 3;
+  return std::min(4 + (octave - 2) * 4 + sub, BUCKETS - 1);
+}
+
+uint64_t LatencyHistogram::bucket_start_us(int bucket) {
+  if(bucket < 4) return uint64_t(bucket);
+  const int octave = (bucket - 4) / 4 + 2;
+  const int sub = (bucket - 4) % 4;
+  return uint64_t(4 + sub) << (octave - 2);
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) {
+  const uint64_t ns = uint64_t(std::max<int64_t>(duration.count(), 0));
+
+  this->buckets[bucket_of(ns / 1000)].fetch_add(1, std::memory_order_relaxed);
+  this->total_count.fetch_add(1, std::memory_order_relaxed);
+  this->sum_ns.fetch_add(ns, std::memory_order_relaxed);
+
+  uint64_t max = this->max_ns.load(std::memory_order_relaxed);
+  while(ns > max && !this->max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+  Snapshot snapshot;
+  for(int b = 0; b < BUCKETS; b++) snapshot.buckets[b] = this->buckets[b].load(std::memory_order_relaxed);
+  snapshot.count = this->total_count.load(std::memory_order_relaxed);
+  snapshot.sum_ns = this->sum_ns.load(std::memory_order_relaxed);
+  snapshot.max_ns = this->max_ns.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void LatencyHistogram::reset() {
+  for(auto & bucket : this->buckets) bucket.store(0, std::memory_order_relaxed);
+  this->total_count.store(0, std::memory_order_relaxed);
+  this->sum_ns.store(0, std::memory_order_relaxed);
+  this->max_ns.store(0, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Snapshot::operator-(const Snapshot & earlier) const {
+  Snapshot difference;
+  for(int b = 0; b < BUCKETS; b++) difference.buckets[b] = this->buckets[b] - earlier.buckets[b];
+  difference.count = this->count - earlier.count;
+  difference.sum_ns = this->sum_ns - earlier.sum_ns;
+  difference.max_ns = this->max_ns;
+  return difference;
+}
+
+double LatencyHistogram::Snapshot::mean_ms() const {
+  return this->count ? double(this->sum_ns) / this->count * 1e-6 : 0.0;
+}
+
+double LatencyHistogram::Snapshot::max_ms() const {
+  return this->max_ns * 1e-6;
+}
+
+uint64_t LatencyHistogram::Snapshot::quantile_us(double q) const {
+  // The buckets, rather than count, as a snapshot taken while another
+  // thread records may not agree with itself
+  uint64_t total = 0;
+  for(uint64_t n : this->buckets) total += n;
+  if(total == 0) return 0;
+
+  const uint64_t rank = std::max<uint64_t>(1, uint64_t(q * total + 0.5));
+  uint64_t seen = 0;
+  for(int b = 0; b < BUCKETS; b++) {
+    seen += this->buckets[b];
+    if(seen >= rank) return b + 1 < BUCKETS ? bucket_start_us(b + 1) : bucket_start_us(b);
+  }
+  return bucket_start_us(BUCKETS - 1);
+}
+
+double LatencyHistogram::Snapshot::quantile_ms(double q) const {
+  return this->quantile_us(q) * 1e-3;
+}
+
+std::string LatencyHistogram::Snapshot::summary() const {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3) << this->count << " samples, mean " << this->mean_ms()
+      << " ms, p50 < " << this->quantile_ms(0.5) << " ms, p99 < " << this->quantile_ms(0.99)
+      << " ms, max " << this->max_ms() << " ms";
+  return out.str();
+}
@@ -0,0 +1,26 @@
+/*
+ * Package:   nova_trace
+ * Filename:  StageProfiler.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <utility>
+
+#include "nova_trace/StageProfiler.hpp"
+
+using navigator::trace::StageProfiler;
+
+StageProfiler::StageProfiler(std::vector<std::string> stage_names, const std::string & trace_prefix)
+  : names(std::move(stage_names)), histograms(new LatencyHistogram[this->names.size()]) {
+  for(const std::string & name : this->names) {
+    this->trace_names.push_back(intern(trace_prefix + "." + name));
+  }
+}
+
+void StageProfiler::record(int stage, Clock::time_point start, Clock::time_point end) {
+  this->histograms[stage].record(end - start);
+  span(this->trace_names[stage], start, end);
+}
@@ -0,0 +1,299 @@
+/*
+ * Package:   nova_trace
+ * Filename:  Trace.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cmath> // std::isfinite()
+#include <cstdlib> // getenv()
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef NOVA_TRACE_LTTNG
+#include "TracepointProvider.h"
+#endif
+
+#include "nova_trace/Trace.hpp"
+
+using navigator::trace::Clock;
+
+namespace navigator {
+namespace trace {
+namespace detail {
+std::atomic<bool> active {false};
+}
+}
+}
+
+namespace {
+
+enum class Kind : uint8_t { SPAN, FLOW, COUNTER };
+
+// One slot of a thread's ring buffer. The owning thread is the only
+// writer; exporters read concurrently and use the sequence number to
+// skip slots that were rewritten while they read them. It is odd while
+// a write is in progress.
+struct Event {
+  std::atomic<uint64_t> sequence {0};
+  std::atomic<const char *> name {nullptr};
+  std::atomic<int64_t> time_ns {0};
+  std::atomic<int64_t> value {0}; // Duration, flow ID or counter bits
+  std::atomic<uint8_t> kind {0};
+};
+
+struct ThreadBuffer {
+  ThreadBuffer(std::size_t capacity, long tid)
+    : events(new Event[capacity]), mask(capacity - 1), tid(tid) {}
+
+  std::unique_ptr<Event[]> events;
+  uint64_t mask; // The capacity is a power of two
+  long tid;
+  std::atomic<uint64_t> written {0};
+};
+
+// Which of the two backends are on; detail::active is set while
+// either is
+std::atomic<bool> buffering {false};
+std::atomic<bool> lttng {false};
+
+void update_active() {
+  navigator::trace::detail::active.store(buffering.load() || lttng.load(), std::memory_order_relaxed);
+}
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<ThreadBuffer *> buffers;
+  std::atomic<std::size_t> events_per_thread {navigator::trace::DEFAULT_EVENTS_PER_THREAD};
+};
+
+// Never destroyed: threads may still record while the process exits
+Registry & registry() {
+  static Registry * registry = new Registry;
+  return *registry;
+}
+
+ThreadBuffer & this_thread_buffer() {
+  thread_local ThreadBuffer * buffer = nullptr;
+  if(! buffer) {
+    Registry & r = registry();
+    std::size_t capacity = std::bit_ceil(std::max<std::size_t>(r.events_per_thread.load(), 2));
+    buffer = new ThreadBuffer(capacity, static_cast<long>(syscall(SYS_gettid)));
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.buffers.push_back(buffer);
+  }
+  return *buffer;
+}
+
+int64_t to_ns(Clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void record(Kind kind, const char * name, int64_t time_ns, int64_t value) {
+  if(! buffering.load(std::memory_order_relaxed)) return;
+  ThreadBuffer & buffer = this_thread_buffer();
+  uint64_t index = buffer.written.load(std::memory_order_relaxed);
+  Event & event = buffer.events[index & buffer.mask];
+  uint64_t sequence = event.sequence.load(std::memory_order_relaxed);
+  event.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  event.name.store(name, std::memory_order_relaxed);
+  event.time_ns.store(time_ns, std::memory_order_relaxed);
+  event.value.store(value, std::memory_order_relaxed);
+  event.kind.store(static_cast<uint8_t>(kind), std::memory_order_relaxed);
+  event.sequence.store(sequence + 2, std::memory_order_release);
+  buffer.written.store(index + 1, std::memory_order_release);
+}
+
+struct Copy {
+  Kind kind;
+  const char * name;
+  int64_t time_ns;
+  int64_t value;
+  long tid;
+};
+
+// Takes a consistent copy of every complete event in the buffers
+std::vector<Copy> collect() {
+  std::vector<ThreadBuffer *> buffers;
+  {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffers = registry().buffers;
+  }
+  std::vector<Copy> events;
+  for(ThreadBuffer * buffer : buffers) {
+    uint64_t written = buffer->written.load(std::memory_order_acquire);
+    uint64_t capacity = buffer->mask + 1;
+    uint64_t first = written > capacity ? written - capacity : 0;
+    for(uint64_t i = first; i < written; i++) {
+      const Event & event = buffer->events[i & buffer->mask];
+      uint64_t before = event.sequence.load(std::memory_order_acquire);
+      Copy copy;
+      copy.kind = static_cast<Kind>(event.kind.load(std::memory_order_relaxed));
+      copy.name = event.name.load(std::memory_order_relaxed);
+      copy.time_ns = event.time_ns.load(std::memory_order_relaxed);
+      copy.value = event.value.load(std::memory_order_relaxed);
+      copy.tid = buffer->tid;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      uint64_t after = event.sequence.load(std::memory_order_relaxed);
+      if(before == after && before % 2 == 0 && copy.name) events.push_back(copy);
+    }
+  }
+  return events;
+}
+
+void write_string(std::ostream & out, const char * text) {
+  out << '"';
+  for(const char * c = text; *c; c++) {
+    if(*c == '"' || *c == '\\') out << '\\' << *c;
+    else if(static_cast<unsigned char>(*c) < 0x20) out << ' ';
+    else out << *c;
+  }
+  out << '"';
+}
+
+// Turns the backends on as the environment asks, and writes the trace
+// at exit if NOVA_TRACE_FILE is set
+struct ExitWriter {
+  ExitWriter() {
+#ifdef NOVA_TRACE_LTTNG
+    const char * use_lttng = std::getenv("NOVA_TRACE_LTTNG");
+    if(use_lttng && *use_lttng && std::string(use_lttng) != "0") {
+      lttng.store(true);
+      update_active();
+    }
+#endif
+    const char * filename = std::getenv("NOVA_TRACE_FILE");
+    if(! filename || ! *filename) return;
+    this->filename = filename;
+    std::size_t pid = this->filename.find("%p");
+    if(pid != std::string::npos) this->filename.replace(pid, 2, std::to_string(getpid()));
+    const char * events = std::getenv("NOVA_TRACE_EVENTS_PER_THREAD");
+    navigator::trace::enable(events ? std::strtoull(events, nullptr, 10) : navigator::trace::DEFAULT_EVENTS_PER_THREAD);
+  }
+
+  ~ExitWriter() {
+    if(! this->filename.empty()) navigator::trace::write_chrome_trace(this->filename);
+  }
+
+  std::string filename;
+} exit_writer;
+
+}
+
+void navigator::trace::enable(std::size_t events_per_thread) {
+  registry().events_per_thread.store(events_per_thread);
+  buffering.store(true);
+  update_active();
+}
+
+void navigator::trace::disable() {
+  buffering.store(false);
+  update_active();
+}
+
+void navigator::trace::detail::record_span(const char * name, Clock::time_point start, Clock::time_point end) {
+  int64_t start_ns = to_ns(start);
+  int64_t duration_ns = to_ns(end) - start_ns;
+  record(Kind::SPAN, name, start_ns, duration_ns);
+#ifdef NOVA_TRACE_LTTNG
+  if(lttng.load(std::memory_order_relaxed)) tracepoint(nova_trace, span, name, start_ns, duration_ns);
+#endif
+}
+
+void navigator::trace::detail::record_flow(const char * name, uint64_t id, Clock::time_point time) {
+  record(Kind::FLOW, name, to_ns(time), static_cast<int64_t>(id));
+#ifdef NOVA_TRACE_LTTNG
+  if(lttng.load(std::memory_order_relaxed)) tracepoint(nova_trace, flow, name, id);
+#endif
+}
+
+void navigator::trace::counter(const char * name, double value) {
+  if(! enabled()) return;
+  record(Kind::COUNTER, name, to_ns(Clock::now()), std::bit_cast<int64_t>(value));
+#ifdef NOVA_TRACE_LTTNG
+  if(lttng.load(std::memory_order_relaxed)) tracepoint(nova_trace, counter, name, value);
+#endif
+}
+
+void navigator::trace::write_chrome_trace(std::ostream & out) {
+  std::vector<Copy> events = collect();
+
+  // Flow arrows start at the first span carrying an ID, pass through
+  // the ones in between and end at the last
+  std::sort(events.begin(), events.end(),
+	    [] (const Copy & a, const Copy & b) { return a.time_ns < b.time_ns; });
+  std::map<int64_t, std::size_t> last_of_flow;
+  for(std::size_t i = 0; i < events.size(); i++) {
+    if(events[i].kind == Kind::FLOW) last_of_flow[events[i].value] = i;
+  }
+  std::map<int64_t, bool> flow_started;
+
+  const std::ios::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  const int pid = getpid();
+  out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  bool first = true;
+  for(std::size_t i = 0; i < events.size(); i++) {
+    const Copy & event = events[i];
+    const char * phase = "X";
+    if(event.kind == Kind::COUNTER) {
+      phase = "C";
+    } else if(event.kind == Kind::FLOW) {
+      bool & started = flow_started[event.value];
+      if(! started && last_of_flow[event.value] == i) continue; // Nothing to connect
+      phase = ! started ? "s" : last_of_flow[event.value] == i ? "f" : "t";
+      started = true;
+    }
+
+    // Timestamps are in microseconds of the steady clock, which is
+    // shared by every process on the machine, so the traces of
+    // different nodes line up
+    out << (first ? "" : ",") << "\n{\"name\":";
+    write_string(out, event.kind == Kind::FLOW ? "message" : event.name);
+    out << ",\"ph\":\"" << phase << "\",\"pid\":" << pid << ",\"tid\":" << event.tid
+	<< ",\"ts\":" << event.time_ns / 1000.0;
+    if(event.kind == Kind::SPAN) {
+      out << ",\"dur\":" << event.value / 1000.0;
+    } else if(event.kind == Kind::FLOW) {
+      out << ",\"cat\":\"flow\",\"id\":" << static_cast<uint64_t>(event.value);
+      if(*phase == 'f') out << ",\"bp\":\"e\"";
+    } else {
+      double value = std::bit_cast<double>(event.value);
+      out << ",\"args\":{\"value\":" << (std::isfinite(value) ? value : 0.0) << "}";
+    }
+    out << "}";
+    first = false;
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  out.flags(flags);
+  out.precision(precision);
+}
+
+const char * navigator::trace::intern(const std::string & name) {
+  // Never destroyed, like the registry
+  static std::mutex * mutex = new std::mutex;
+  static std::set<std::string> * names = new std::set<std::string>;
+  std::lock_guard<std::mutex> lock(*mutex);
+  return names->insert(name).first->c_str();
+}
+
+bool navigator::trace::write_chrome_trace(const std::string & filename) {
+  std::ofstream out(filename);
+  if(! out) return false;
+  write_chrome_trace(out);
+  return bool(out);
+}
@@ -0,0 +1,16 @@
+/*
+ * Package:   nova_trace
+ * Filename:  TracepointProvider.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Instantiates the LTTng tracepoint probes, when they are built at all
+
+#ifdef NOVA_TRACE_LTTNG
+#define TRACEPOINT_CREATE_PROBES
+#define TRACEPOINT_DEFINE
+#include "TracepointProvider.h"
+#endif
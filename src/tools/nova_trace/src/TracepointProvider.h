@@ -0,0 +1,53 @@
+/*
+ * Package:   nova_trace
+ * Filename:  TracepointProvider.h
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// The LTTng-UST tracepoints behind the nova_trace API, compiled in
+// with NOVA_TRACE_LTTNG. The LTTng headers include this file again
+// by name, so it has the layout they expect rather than #pragma once.
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER nova_trace
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "TracepointProvider.h"
+
+#if ! defined(NOVA_TRACE_TRACEPOINT_PROVIDER_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define NOVA_TRACE_TRACEPOINT_PROVIDER_H
+
+#include <lttng/tracepoint.h>
+
+#include <stdint.h>
+
+// Times are those of the steady clock, in ns, like the Chrome
+// exporter's
+TRACEPOINT_EVENT(
+  nova_trace, span,
+  TP_ARGS(const char *, name, int64_t, start_ns, int64_t, duration_ns),
+  TP_FIELDS(
+    ctf_string(name, name)
+    ctf_integer(int64_t, start_ns, start_ns)
+    ctf_integer(int64_t, duration_ns, duration_ns)))
+
+TRACEPOINT_EVENT(
+  nova_trace, flow,
+  TP_ARGS(const char *, span, uint64_t, id),
+  TP_FIELDS(
+    ctf_string(span, span)
+    ctf_integer_hex(uint64_t, id, id)))
+
+TRACEPOINT_EVENT(
+  nova_trace, counter,
+  TP_ARGS(const char *, name, double, value),
+  TP_FIELDS(
+    ctf_string(name, name)
+    ctf_float(double, value, value)))
+
+#endif
+
+#include <lttng/tracepoint-event.h>
@@ -0,0 +1,78 @@
+/*
+ * Package:   nova_trace
+ * Filename:  test_latency_histogram.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "nova_trace/LatencyHistogram.hpp"
+
+using navigator::trace::LatencyHistogram;
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogram, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.snapshot().quantile_us(0.5), 0u);
+  EXPECT_EQ(histogram.snapshot().mean_ms(), 0.0);
+}
+
+TEST(LatencyHistogram, Buckets) {
+  for(int bucket = 0; bucket < LatencyHistogram::BUCKETS; bucket++) {
+    const uint64_t start = LatencyHistogram::bucket_start_us(bucket);
+    EXPECT_EQ(LatencyHistogram::bucket_of(start), bucket);
+    if(bucket > 0) {
+      EXPECT_EQ(LatencyHistogram::bucket_of(start - 1), bucket - 1);
+    }
+  }
+  // Past the last bucket, everything goes in it
+  EXPECT_EQ(LatencyHistogram::bucket_of(uint64_t(1) << 40), LatencyHistogram::BUCKETS - 1);
+}
+
+TEST(LatencyHistogram, Quantiles) {
+  LatencyHistogram histogram;
+  for(int i = 1; i <= 100; i++) histogram.record(i * 1ms);
+  const LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+  EXPECT_EQ(snapshot.count, 100u);
+  EXPECT_NEAR(snapshot.mean_ms(), 50.5, 1e-9);
+  EXPECT_DOUBLE_EQ(snapshot.max_ms(), 100.0);
+  // Each quantile is within a bucket's 25% above the exact one
+  EXPECT_GE(snapshot.quantile_ms(0.5), 50.0);
+  EXPECT_LE(snapshot.quantile_ms(0.5), 50.0 * 1.25);
+  EXPECT_GE(snapshot.quantile_ms(0.99), 99.0);
+  EXPECT_LE(snapshot.quantile_ms(0.99), 99.0 * 1.25);
+  EXPECT_NE(snapshot.summary().find("100 samples, mean 50.500 ms"), std::string::npos);
+}
+
+// A clock step can make a duration negative, which counts as none
+TEST(LatencyHistogram, Negative) {
+  LatencyHistogram histogram;
+  histogram.record(-5ms);
+  EXPECT_EQ(histogram.count(), 1u);
+  EXPECT_EQ(histogram.snapshot().quantile_us(1.0), 1u);
+  EXPECT_EQ(histogram.snapshot().max_ns, 0u);
+}
+
+TEST(LatencyHistogram, Windows) {
+  LatencyHistogram histogram;
+  histogram.record(10ms);
+  const LatencyHistogram::Snapshot first = histogram.snapshot();
+  histogram.record(1ms);
+  histogram.record(1ms);
+  const LatencyHistogram::Snapshot window = histogram.snapshot() - first;
+  EXPECT_EQ(window.count, 2u);
+  EXPECT_NEAR(window.mean_ms(), 1.0, 1e-9);
+  EXPECT_LE(window.quantile_ms(1.0), 1.25);
+  EXPECT_DOUBLE_EQ(window.max_ms(), 10.0); // The lifetime's
+
+  histogram.reset();
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.snapshot().quantile_us(0.5), 0u);
+  EXPECT_EQ(histogram.snapshot().max_ns, 0u);
+}
@@ -0,0 +1,46 @@
+/*
+ * Package:   nova_trace
+ * Filename:  test_stage_profiler.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "nova_trace/StageProfiler.hpp"
+#include "nova_trace/Trace.hpp"
+
+using namespace navigator::trace;
+using namespace std::chrono_literals;
+
+TEST(StageProfiler, RecordsEachStage) {
+  StageProfiler profiler({"cast", "update"}, "stage_profiler_test");
+  ASSERT_EQ(profiler.stage_count(), 2);
+  EXPECT_EQ(profiler.stage_name(1), "update");
+
+  const Clock::time_point start = Clock::now();
+  profiler.record(0, start, start + 2ms);
+  profiler.record(0, start, start + 4ms);
+  {
+    ScopedStageTimer timer(profiler, 1);
+  }
+  EXPECT_EQ(profiler.histogram(0).count(), 2u);
+  EXPECT_NEAR(profiler.histogram(0).snapshot().mean_ms(), 3.0, 1e-9);
+  EXPECT_EQ(profiler.histogram(1).count(), 1u);
+}
+
+TEST(StageProfiler, TracesEachStage) {
+  enable();
+  StageProfiler profiler({"traced"}, "stage_profiler_test");
+  const Clock::time_point start = Clock::now();
+  profiler.record(0, start, start + 1ms);
+  disable();
+
+  std::ostringstream out;
+  write_chrome_trace(out);
+  EXPECT_NE(out.str().find("stage_profiler_test.traced"), std::string::npos);
+}
@@ -0,0 +1,126 @@
+/*
+ * Package:   nova_trace
+ * Filename:  test_trace.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Recording is process-wide, so every test enables it, records under
+// names of its own and looks only for those in the output
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "nova_trace/Trace.hpp"
+
+using namespace navigator::trace;
+
+namespace {
+
+std::string trace() {
+  std::ostringstream out;
+  write_chrome_trace(out);
+  return out.str();
+}
+
+size_t count(const std::string & text, const std::string & pattern) {
+  size_t found = 0;
+  for(size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1)) found++;
+  return found;
+}
+
+struct Stamp {
+  int32_t sec;
+  uint32_t nanosec;
+};
+
+}
+
+TEST(Trace, NothingIsRecordedWhileDisabled) {
+  disable();
+  {
+    NOVA_TRACE_SPAN("disabled_span");
+    counter("disabled_counter", 1);
+  }
+  EXPECT_EQ(trace().find("disabled_"), std::string::npos);
+}
+
+TEST(Trace, SpansAndCounters) {
+  enable();
+  {
+    NOVA_TRACE_SPAN("outer_span");
+    NOVA_TRACE_SPAN("inner_span");
+    counter("queue_length", 3);
+  }
+  std::string output = trace();
+  EXPECT_EQ(count(output, "{\"name\":\"outer_span\",\"ph\":\"X\""), 1u);
+  EXPECT_EQ(count(output, "{\"name\":\"inner_span\",\"ph\":\"X\""), 1u);
+  EXPECT_NE(output.find("{\"name\":\"queue_length\",\"ph\":\"C\""), std::string::npos);
+  EXPECT_NE(output.find("\"args\":{\"value\":3.000}"), std::string::npos);
+}
+
+TEST(Trace, FlowsConnectSpansAcrossThreads) {
+  enable();
+  uint64_t id = flow_id(Stamp {1234, 5678});
+  EXPECT_EQ(id, (uint64_t(1234) << 32) | 5678);
+  { NOVA_TRACE_SPAN("flow_source", id); }
+  std::thread([id] { NOVA_TRACE_SPAN("flow_middle", id); }).join();
+  { NOVA_TRACE_SPAN("flow_sink", id); }
+  // A flow seen only once has nothing to connect to
+  { NOVA_TRACE_SPAN("flow_alone", id + 1); }
+
+  std::string output = trace();
+  std::string tag = "\"cat\":\"flow\",\"id\":" + std::to_string(id);
+  EXPECT_EQ(count(output, tag), 3u);
+  EXPECT_EQ(count(output, "\"cat\":\"flow\",\"id\":" + std::to_string(id + 1)), 0u);
+  size_t start = output.find("\"ph\":\"s\"");
+  size_t step = output.find("\"ph\":\"t\"");
+  size_t end = output.find("\"ph\":\"f\"");
+  ASSERT_NE(start, std::string::npos);
+  ASSERT_NE(step, std::string::npos);
+  ASSERT_NE(end, std::string::npos);
+  EXPECT_LT(start, step);
+  EXPECT_LT(step, end);
+}
+
+TEST(Trace, FullBuffersKeepTheNewestEvents) {
+  enable();
+  // A new thread, so that it gets a buffer of the requested size
+  enable(16);
+  std::thread([] {
+    for(int i = 0; i < 100; i++) {
+      NOVA_TRACE_SPAN(i < 90 ? "old_span" : "new_span");
+    }
+  }).join();
+  enable();
+  std::string output = trace();
+  EXPECT_EQ(count(output, "\"old_span\""), 6u);
+  EXPECT_EQ(count(output, "\"new_span\""), 10u);
+}
+
+TEST(Trace, InternedNamesAreShared) {
+  enable();
+  std::string name = "interned_";
+  name += "span";
+  const char * interned = intern(name);
+  EXPECT_EQ(interned, intern("interned_span"));
+  EXPECT_NE(interned, name.c_str());
+  auto now = Clock::now();
+  span(interned, now, now + std::chrono::microseconds(5));
+  EXPECT_NE(trace().find("{\"name\":\"interned_span\",\"ph\":\"X\""), std::string::npos);
+}
+
+TEST(Trace, FreeFlowsJoinTheEnclosingSpan) {
+  enable();
+  auto start = Clock::now();
+  flow("free_flow", 77);
+  { NOVA_TRACE_SPAN("free_flow_sink", 77); }
+  span("free_flow_source", start, Clock::now());
+  std::string output = trace();
+  EXPECT_EQ(count(output, "\"cat\":\"flow\",\"id\":77"), 2u);
+  EXPECT_NE(output.find("\"free_flow_source\""), std::string::npos);
+}
@@ -0,0 +1,110 @@
+/*
+ * Package:   replay_harness
+ * Filename:  replay.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Play a rosbag2 recording of the stack's inputs through ground
+// segmentation, static occupancy and map management in this process,
+// as fast as they run, and report the throughput and a digest of each
+// output. Two runs of the same build on the same recording give the
+// same digests.
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+#include "rosbag2_cpp/storage_options.hpp"
+
+#include "geometry_msgs/msg/pose_stamped.hpp"
+#include "nav_msgs/msg/occupancy_grid.hpp"
+#include "nav_msgs/msg/path.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+
+#include "map_management/MapManager.hpp"
+#include "occupancy_cpp/GroundSegmentationNode.hpp"
+#include "occupancy_cpp/StaticOccupancyNode.hpp"
+
+#include "replay_harness/ReplayHarness.hpp"
+
+using navigator::replay_harness::ReplayHarness;
+
+int main(int argc, char ** argv) {
+  rclcpp::init(argc, argv);
+  std::vector<std::string> args = rclcpp::remove_ros_arguments(argc, argv);
+  if(args.size() < 2) {
+    std::cout << "USAGE: ros2 run replay_harness replay <bag> [clock_period_ms] [--ros-args --params-file <file>]" << std::endl
+	      << "  clock_period_ms (default 10) is how often /clock ticks, for bags without one" << std::endl;
+    return 1;
+  }
+  const std::chrono::nanoseconds clock_period
+    (std::chrono::duration_cast<std::chrono::nanoseconds>
+     (std::chrono::duration<double, std::milli>(args.size() > 2 ? std::stod(args[2]) : 10.0)));
+
+  rosbag2_cpp::readers::SequentialReader reader;
+  rosbag2_cpp::StorageOptions storage_options;
+  storage_options.uri = args[1];
+  storage_options.storage_id = "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  reader.open(storage_options, converter_options);
+  bool recorded_clock = false;
+  for(const auto & topic : reader.get_all_topics_and_types()) {
+    if(topic.name == "/clock") recorded_clock = true;
+  }
+
+  // In pipeline order. Callbacks that are ready together run in this
+  // order.
+  const rclcpp::NodeOptions options = navigator::replay_harness::replay_node_options();
+  ReplayHarness harness({
+      std::make_shared<navigator::perception::GroundSegmentationNode>(options),
+      std::make_shared<navigator::perception::StaticOccupancyNode>(options),
+      std::make_shared<navigator::planning::MapManagementNode>(options),
+    });
+  harness.watch<sensor_msgs::msg::PointCloud2>("/lidar/filtered");
+  harness.watch<sensor_msgs::msg::PointCloud2>("/lidar/labeled");
+  harness.watch<nav_msgs::msg::OccupancyGrid>("/grid/occupancy/current");
+  harness.watch<nav_msgs::msg::OccupancyGrid>("/grid/drivable");
+  harness.watch<nav_msgs::msg::OccupancyGrid>("/grid/junction");
+  harness.watch<nav_msgs::msg::OccupancyGrid>("/grid/route_distance");
+  harness.watch<nav_msgs::msg::Path>("/planning/smooth_route");
+  harness.watch<geometry_msgs::msg::PoseStamped>("/planning/goal_pose");
+
+  std::size_t messages = 0;
+  rcutils_time_point_value_t first = 0, last = 0, next_tick = 0;
+  const auto start = std::chrono::steady_clock::now();
+  while(rclcpp::ok() && reader.has_next()) {
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> message = reader.read_next();
+    if(messages == 0) first = next_tick = message->time_stamp;
+    last = message->time_stamp;
+    if(! recorded_clock) {
+      for(; next_tick <= message->time_stamp; next_tick += clock_period.count()) harness.set_clock(next_tick);
+    }
+    harness.deliver(message->topic_name, * message->serialized_data, message->time_stamp);
+    messages++;
+  }
+  const double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const double recorded_seconds = (last - first) * 1e-9;
+
+  std::printf("Replayed %zu messages, %.1f s of recording, in %.1f s (%.1f times real time), %zu callbacks\n",
+	      messages, recorded_seconds, wall_seconds, wall_seconds > 0 ? recorded_seconds / wall_seconds : 0.0,
+	      harness.callbacks());
+  for(const auto & entry : harness.digests()) {
+    if(entry.second.count == 0) continue;
+    std::printf("  %s: %" PRIu64 " messages, digest %016" PRIx64 "\n",
+		entry.first.c_str(), entry.second.count, entry.second.hash);
+  }
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Package:   replay_harness
+ * Filename:  ReplayHarness.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Drives nodes in one process from recorded messages, on a simulated
+// clock and as fast as they can process them. Each recorded message is
+// handed straight to the subscriptions on its topic, without the
+// middleware, and everything it causes (messages between the nodes,
+// timers that come due) runs on the calling thread before the next one
+// is delivered. The order of callbacks then only depends on the
+// recording and on the order the nodes were given in.
+//
+// For that, the nodes need intra-process communication, so that their
+// messages to each other skip the middleware too; use_sim_time, so
+// that their clocks and timers follow the delivered /clock; and their
+// TF listeners on their own executor. replay_node_options() sets all
+// three.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rcutils/time.h"
+
+#include "rosgraph_msgs/msg/clock.hpp"
+
+#include "replay_harness/StepExecutor.hpp"
+
+namespace navigator {
+namespace replay_harness {
+
+// Options for nodes driven by a ReplayHarness. Besides the above, maps
+// are loaded on the executor thread (background_map_load is false), so
+// that the grids don't depend on how long the load took.
+rclcpp::NodeOptions replay_node_options();
+
+// Every message published on a topic, hashed in order
+struct TopicDigest {
+  uint64_t count = 0;
+  uint64_t hash = 14695981039346656037ull; // FNV-1a
+
+  void add(const rcl_serialized_message_t & message);
+};
+
+class ReplayHarness {
+public:
+  // When several callbacks are ready at once, the ones of earlier nodes
+  // run first
+  explicit ReplayHarness(const std::vector<rclcpp::Node::SharedPtr> & nodes);
+
+  // Hand a message to the nodes' subscriptions on its topic, then run
+  // callbacks until none are ready. Returns how many subscriptions
+  // received it.
+  std::size_t deliver(const std::string & topic, const rcl_serialized_message_t & message,
+		      rcutils_time_point_value_t receive_time);
+
+  // Deliver a /clock message, which moves the nodes' clocks, and run the
+  // timers that come due
+  void set_clock(rcutils_time_point_value_t time);
+
+  // Hash the messages published on a topic from now on, to compare runs
+  template<typename MessageT>
+  void watch(const std::string & topic);
+
+  const std::map<std::string, TopicDigest> & digests() const { return this->topic_digests; }
+  std::size_t callbacks() const { return this->callback_count; }
+
+private:
+  std::vector<rclcpp::Node::SharedPtr> nodes;
+  rclcpp::Node::SharedPtr node; // The harness's own, for watch()
+  StepExecutor executor;
+  std::size_t callback_count = 0;
+
+  rclcpp::Serialization<rosgraph_msgs::msg::Clock> clock_serialization;
+  std::map<std::string, TopicDigest> topic_digests;
+  std::vector<rclcpp::SubscriptionBase::SharedPtr> watches;
+};
+
+template<typename MessageT>
+void ReplayHarness::watch(const std::string & topic) {
+  TopicDigest & digest = this->topic_digests[topic]; // Map entries don't move
+  auto serialization = std::make_shared<rclcpp::Serialization<MessageT>>();
+  this->watches.push_back
+    (this->node->create_subscription<MessageT>
+     (topic, rclcpp::QoS(100),
+      [serialization, & digest](const std::shared_ptr<const MessageT> message) {
+	rclcpp::SerializedMessage serialized;
+	serialization->serialize_message(message.get(), & serialized);
+	digest.add(serialized.get_rcl_serialized_message());
+      }));
+}
+
+}
+}
@@ -0,0 +1,31 @@
+/*
+ * Package:   replay_harness
+ * Filename:  StepExecutor.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// A single-threaded executor that runs ready callbacks until there are
+// none left, including the ones that become ready while it does, and
+// then returns rather than waiting for more. spin_some() only runs the
+// callbacks that were ready when it was called.
+
+#pragma once
+
+#include <cstddef>
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace navigator {
+namespace replay_harness {
+
+class StepExecutor : public rclcpp::executors::SingleThreadedExecutor {
+public:
+  // Returns the number of callbacks run
+  std::size_t run_until_idle();
+};
+
+}
+}
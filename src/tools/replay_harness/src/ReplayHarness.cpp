@@ -0,0 +1,100 @@
+/*
+ * Package:   replay_harness
+ * Filename:  ReplayHarness.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rmw/error_handling.h"
+#include "rmw/rmw.h"
+
+#include "rosgraph_msgs/msg/clock.hpp"
+
+#include "replay_harness/ReplayHarness.hpp"
+
+using navigator::replay_harness::ReplayHarness;
+using navigator::replay_harness::TopicDigest;
+
+rclcpp::NodeOptions navigator::replay_harness::replay_node_options() {
+  rclcpp::NodeOptions options;
+  options.use_intra_process_comms(true);
+  // Overrides take precedence over parameter files
+  options.parameter_overrides({
+      rclcpp::Parameter("use_sim_time", true),
+      rclcpp::Parameter("dedicated_tf_thread", false),
+      rclcpp::Parameter("background_map_load", false),
+    });
+  return options;
+}
+
+void TopicDigest::add(const rcl_serialized_message_t & message) {
+  for(std::size_t i = 0; i < message.buffer_length; i++) {
+    this->hash = (this->hash ^ message.buffer[i]) * 1099511628211ull;
+  }
+  this->count++;
+}
+
+ReplayHarness::ReplayHarness(const std::vector<rclcpp::Node::SharedPtr> & nodes)
+  : nodes(nodes),
+    node(std::make_shared<rclcpp::Node>("replay_harness", rclcpp::NodeOptions().use_intra_process_comms(true))) {
+  for(const rclcpp::Node::SharedPtr & replayed : this->nodes) {
+    this->executor.add_node(replayed);
+  }
+  this->executor.add_node(this->node);
+}
+
+std::size_t ReplayHarness::deliver(const std::string & topic, const rcl_serialized_message_t & message,
+				   rcutils_time_point_value_t receive_time) {
+  rmw_message_info_t rmw_info = rmw_get_zero_initialized_message_info();
+  rmw_info.source_timestamp = receive_time;
+  rmw_info.received_timestamp = receive_time;
+  const rclcpp::MessageInfo info(rmw_info);
+
+  // Looked up each time, since nodes can subscribe while they run
+  std::vector<rclcpp::SubscriptionBase::SharedPtr> subscriptions;
+  for(const rclcpp::Node::SharedPtr & replayed : this->nodes) {
+    for(const auto & weak_group : replayed->get_node_base_interface()->get_callback_groups()) {
+      auto group = weak_group.lock();
+      if(! group) continue;
+      group->find_subscription_ptrs_if([& topic, & subscriptions](const rclcpp::SubscriptionBase::SharedPtr & subscription) {
+	if(topic == subscription->get_topic_name()) subscriptions.push_back(subscription);
+	return false; // Keep looking
+      });
+    }
+  }
+
+  for(const rclcpp::SubscriptionBase::SharedPtr & subscription : subscriptions) {
+    std::shared_ptr<void> copy;
+    if(subscription->is_serialized()) {
+      copy = std::make_shared<rclcpp::SerializedMessage>(message);
+    } else {
+      copy = subscription->create_message();
+      if(rmw_deserialize(& message, & subscription->get_message_type_support_handle(), copy.get()) != RMW_RET_OK) {
+	const std::string error = rmw_get_error_string().str;
+	rmw_reset_error();
+	throw std::runtime_error("Could not deserialize a message on " + topic + ": " + error);
+      }
+    }
+    subscription->handle_message(copy, info);
+  }
+
+  this->callback_count += subscriptions.size() + this->executor.run_until_idle();
+  return subscriptions.size();
+}
+
+void ReplayHarness::set_clock(rcutils_time_point_value_t time) {
+  rosgraph_msgs::msg::Clock clock;
+  clock.clock = rclcpp::Time(time);
+  rclcpp::SerializedMessage serialized;
+  this->clock_serialization.serialize_message(& clock, & serialized);
+  this->deliver("/clock", serialized.get_rcl_serialized_message(), time);
+}
@@ -0,0 +1,35 @@
+/*
+ * Package:   replay_harness
+ * Filename:  StepExecutor.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <chrono>
+#include <stdexcept>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp/scope_exit.hpp"
+
+#include "replay_harness/StepExecutor.hpp"
+
+using navigator::replay_harness::StepExecutor;
+
+std::size_t StepExecutor::run_until_idle() {
+  if(this->spinning.exchange(true)) {
+    throw std::runtime_error("run_until_idle() called while already spinning");
+  }
+  RCLCPP_SCOPE_EXIT(this->spinning.store(false););
+
+  std::size_t executed = 0;
+  while(true) {
+    // A zero timeout polls, so this returns false once nothing is ready
+    rclcpp::AnyExecutable executable;
+    if(! this->get_next_executable(executable, std::chrono::nanoseconds::zero())) break;
+    this->execute_any_executable(executable);
+    executed++;
+  }
+  return executed;
+}
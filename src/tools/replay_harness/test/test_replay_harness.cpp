@@ -0,0 +1,111 @@
+/*
+ * Package:   replay_harness
+ * Filename:  test_replay_harness.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "std_msgs/msg/int32.hpp"
+
+#include "replay_harness/ReplayHarness.hpp"
+
+using namespace navigator::replay_harness;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr rcutils_time_point_value_t MS = 1000000;
+
+// Republishes /in plus one on /out, and counts the ticks of a 100 ms timer
+class RelayNode : public rclcpp::Node {
+public:
+  RelayNode() : Node("relay", replay_node_options()) {
+    this->publisher = this->create_publisher<std_msgs::msg::Int32>("/out", 10);
+    this->subscription = this->create_subscription<std_msgs::msg::Int32>
+      ("/in", 10, [this](std_msgs::msg::Int32::SharedPtr message) {
+	message->data++;
+	this->publisher->publish(* message);
+      });
+    this->timer = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(100ms),
+				       [this]() { this->ticks++; });
+  }
+
+  int ticks = 0;
+
+private:
+  rclcpp::Publisher<std_msgs::msg::Int32>::SharedPtr publisher;
+  rclcpp::Subscription<std_msgs::msg::Int32>::SharedPtr subscription;
+  rclcpp::TimerBase::SharedPtr timer;
+};
+
+rclcpp::SerializedMessage serialize(int data) {
+  std_msgs::msg::Int32 message;
+  message.data = data;
+  rclcpp::SerializedMessage serialized;
+  rclcpp::Serialization<std_msgs::msg::Int32>().serialize_message(& message, & serialized);
+  return serialized;
+}
+
+}
+
+class TestReplayHarness : public ::testing::Test {
+protected:
+  void SetUp() override {
+    rclcpp::init(0, nullptr);
+  }
+
+  void TearDown() override {
+    rclcpp::shutdown();
+  }
+};
+
+TEST_F(TestReplayHarness, DeliversThroughTheNodesBeforeReturning) {
+  auto relay = std::make_shared<RelayNode>();
+  ReplayHarness harness({relay});
+  harness.watch<std_msgs::msg::Int32>("/out");
+
+  EXPECT_EQ(harness.deliver("/in", serialize(1).get_rcl_serialized_message(), 0), 1u);
+  EXPECT_EQ(harness.deliver("/in", serialize(2).get_rcl_serialized_message(), 0), 1u);
+  EXPECT_EQ(harness.deliver("/unused", serialize(3).get_rcl_serialized_message(), 0), 0u);
+  ASSERT_EQ(harness.digests().count("/out"), 1u);
+  EXPECT_EQ(harness.digests().at("/out").count, 2u);
+}
+
+TEST_F(TestReplayHarness, DigestsRepeat) {
+  uint64_t hashes[2];
+  for(uint64_t & hash : hashes) {
+    ReplayHarness harness({std::make_shared<RelayNode>()});
+    harness.watch<std_msgs::msg::Int32>("/out");
+    for(int i = 0; i < 10; i++) harness.deliver("/in", serialize(i).get_rcl_serialized_message(), 0);
+    hash = harness.digests().at("/out").hash;
+  }
+  EXPECT_EQ(hashes[0], hashes[1]);
+
+  TopicDigest other;
+  other.add(serialize(5).get_rcl_serialized_message());
+  EXPECT_NE(other.hash, hashes[0]);
+}
+
+TEST_F(TestReplayHarness, TimersFollowTheDeliveredClock) {
+  auto relay = std::make_shared<RelayNode>();
+  ReplayHarness harness({relay});
+  harness.set_clock(1000 * MS);
+  const int ticks = relay->ticks;
+  harness.set_clock(1050 * MS);
+  EXPECT_EQ(relay->ticks, ticks);
+  harness.set_clock(1100 * MS);
+  EXPECT_EQ(relay->ticks, ticks + 1);
+  // Missed periods are skipped, as on a live clock
+  harness.set_clock(1550 * MS);
+  EXPECT_EQ(relay->ticks, ticks + 2);
+  EXPECT_EQ(relay->get_clock()->now().nanoseconds(), 1550 * MS);
+}
@@ -0,0 +1,81 @@
+/*
+ * Package:   resource_monitor
+ * Filename:  AllocationCounter.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// libresource_monitor_allocations: replaces the global operator new
+// with a thin wrapper around malloc that bumps a thread-local counter,
+// and exports the counter for the monitor and for occupancy_cpp's
+// AllocationScope. Only one library in a process should do this.
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local std::size_t allocation_count = 0;
+
+void * allocate(std::size_t size) {
+  allocation_count++;
+  return std::malloc(size ? size : 1);
+}
+
+void * allocate_aligned(std::size_t size, std::align_val_t align) {
+  allocation_count++;
+  const std::size_t a = static_cast<std::size_t>(align);
+  // aligned_alloc wants a size that is a multiple of the alignment
+  return std::aligned_alloc(a, (size + a - 1) / a * a);
+}
+
+}
+
+extern "C" std::size_t navigator_thread_allocation_count() {
+  return allocation_count;
+}
+
+// Replacements for the global allocation functions. Every other form
+// of operator new and delete forwards to one of these.
+
+void * operator new(std::size_t size) {
+  if(void * p = allocate(size)) return p;
+  throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+
+void * operator new(std::size_t size, std::align_val_t align) {
+  if(void * p = allocate_aligned(size, align)) return p;
+  throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+  return allocate_aligned(size, align);
+}
+
+void * operator new[](std::size_t size) { return operator new(size); }
+void * operator new[](std::size_t size, const std::nothrow_t & tag) noexcept { return operator new(size, tag); }
+void * operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void * operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t & tag) noexcept {
+  return operator new(size, align, tag);
+}
+
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t) noexcept { std::free(p); }
+void operator delete(void * p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void * p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void * p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+
+void operator delete[](void * p) noexcept { std::free(p); }
+void operator delete[](void * p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void * p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void * p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void * p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void * p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
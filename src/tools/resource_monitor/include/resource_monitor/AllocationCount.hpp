@@ -0,0 +1,33 @@
+/*
+ * Package:   resource_monitor
+ * Filename:  AllocationCount.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Heap allocations made by the calling thread, for budgets on the
+// allocations of a callback. Counting them takes a replaced global
+// operator new, and only one library in a process can replace it, so
+// the monitor doesn't: it asks whichever library did, through the C
+// function navigator_thread_allocation_count(). The package's
+// libresource_monitor_allocations.so defines it, to be linked into a
+// node or loaded with LD_PRELOAD. Without it, counting is unavailable
+// and the count stays 0.
+
+#pragma once
+
+#include <cstddef>
+
+namespace navigator {
+namespace resource_monitor {
+
+// Whether a library in this process counts allocations
+bool allocation_counting();
+
+// Allocations made by the calling thread so far, or 0 without counting
+std::size_t thread_allocation_count();
+
+}
+}
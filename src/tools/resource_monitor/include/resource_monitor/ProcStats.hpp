@@ -0,0 +1,74 @@
+/*
+ * Package:   resource_monitor
+ * Filename:  ProcStats.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// What the kernel reports in /proc about the process it is read from:
+// the CPU time of each of its threads, and its resident set size. The
+// parsers are kept apart from the reads, so that they can be tested on
+// fixed text.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace navigator {
+namespace resource_monitor {
+
+struct ThreadTimes {
+  long tid = 0;
+  std::string name; // The thread's comm, at most 15 characters
+  uint64_t cpu_ticks = 0; // User and system time, in clock ticks
+};
+
+// Parses the contents of /proc/<pid>/task/<tid>/stat. False if they
+// are malformed.
+bool parse_thread_stat(const std::string & text, ThreadTimes & times);
+
+// Parses the contents of /proc/<pid>/statm into the resident set
+// size, in pages
+bool parse_statm_rss(const std::string & text, uint64_t & pages);
+
+// Every thread of this process, from /proc/self/task. Threads that
+// exit while it is read are left out.
+std::vector<ThreadTimes> read_thread_times();
+
+// The resident set size of this process, in bytes, or 0 if /proc
+// could not be read
+uint64_t read_rss_bytes();
+
+// The unit of ThreadTimes::cpu_ticks
+long ticks_per_second();
+
+struct ThreadUsage {
+  long tid;
+  std::string name;
+  double cpu_percent; // Of one core
+};
+
+// Turns successive samples of the thread times into the CPU each
+// thread used between them
+class CpuUsage {
+public:
+  // The usage of every thread since the previous update, busiest
+  // first. The first update only sets the baseline and returns
+  // nothing. Threads that started since the previous update are
+  // counted from when they started; the time of threads that exited
+  // in between is lost.
+  std::vector<ThreadUsage> update(const std::vector<ThreadTimes> & threads, double elapsed_seconds,
+				  long ticks_per_second);
+
+private:
+  std::map<long, uint64_t> previous; // Ticks by thread ID
+  bool has_baseline = false;
+};
+
+}
+}
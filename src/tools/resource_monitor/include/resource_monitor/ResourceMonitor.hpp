@@ -0,0 +1,125 @@
+/*
+ * Package:   resource_monitor
+ * Filename:  ResourceMonitor.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Watches the CPU, memory and heap allocations of the process a node
+// runs in, and reports them on /diagnostics against the limits set by
+// the node's parameters:
+//
+//   this->resource_monitor = std::make_unique<resource_monitor::ResourceMonitor>(*this);
+//   this->cloud_allocations = this->resource_monitor->callback("point_cloud");
+//   ...
+//   void OccupancyNode::pointCloudCb(...) {
+//     auto scope = this->cloud_allocations->scope();
+//
+// Every resource_monitor.period_seconds (1 s, 0 turns the monitor off)
+// it reads the CPU time of every thread from /proc/self/task and the
+// resident set size from /proc/self/statm, on the node's executor, and
+// publishes one status. The status is a warning while anything is over
+// its limit:
+//
+//   resource_monitor.max_cpu_percent           the whole process, as a
+//                                              percentage of one core
+//   resource_monitor.max_thread_cpu_percent    any one thread
+//   resource_monitor.max_rss_mb                resident memory
+//   resource_monitor.max_callback_allocations  any one run of a
+//                                              callback
+//
+// A limit of 0, the default, is off. Allocations are only counted in
+// processes that count them; see AllocationCount.hpp. The nodes of one
+// component container share a process, and report the same figures
+// for it.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+
+#include "resource_monitor/ProcStats.hpp"
+
+namespace navigator {
+namespace resource_monitor {
+
+// The allocations made by the runs of one callback
+class CallbackAllocations {
+public:
+  // Counts the allocations made on this thread while in scope, as one
+  // run of the callback
+  class Scope {
+  public:
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope & operator=(const Scope &) = delete;
+
+  private:
+    friend class CallbackAllocations;
+    explicit Scope(CallbackAllocations * callback);
+
+    CallbackAllocations * callback; // Null without allocation counting
+    std::size_t start;
+  };
+
+  explicit CallbackAllocations(const std::string & name);
+
+  Scope scope();
+
+  const std::string & name() const { return this->name_; }
+
+private:
+  friend class ResourceMonitor;
+  void record(uint64_t allocations);
+
+  std::string name_;
+  // Since the last report
+  std::atomic<uint64_t> runs {0};
+  std::atomic<uint64_t> allocations {0};
+  std::atomic<uint64_t> max_allocations {0};
+};
+
+class ResourceMonitor {
+public:
+  explicit ResourceMonitor(rclcpp::Node & node);
+
+  // A callback whose allocations are counted and held to
+  // max_callback_allocations. Kept as long as the monitor.
+  CallbackAllocations * callback(const std::string & name);
+
+private:
+  void report();
+
+  std::string node_name;
+  rclcpp::Clock::SharedPtr clock;
+  double max_cpu_percent;
+  double max_thread_cpu_percent;
+  double max_rss_mb;
+  int64_t max_callback_allocations;
+
+  CpuUsage cpu_usage;
+  long ticks_per_second;
+  std::chrono::steady_clock::time_point last_sample;
+
+  std::mutex callbacks_mutex;
+  std::vector<std::unique_ptr<CallbackAllocations>> callbacks;
+
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_publisher;
+  rclcpp::TimerBase::SharedPtr report_timer;
+};
+
+}
+}
@@ -0,0 +1,23 @@
+/*
+ * Package:   resource_monitor
+ * Filename:  AllocationCount.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <cstddef>
+
+#include "resource_monitor/AllocationCount.hpp"
+
+// Weak, so that it is null unless a library in the process defines it
+extern "C" std::size_t navigator_thread_allocation_count() __attribute__((weak));
+
+bool navigator::resource_monitor::allocation_counting() {
+  return navigator_thread_allocation_count != nullptr;
+}
+
+std::size_t navigator::resource_monitor::thread_allocation_count() {
+  return navigator_thread_allocation_count ? navigator_thread_allocation_count() : 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Package:   resource_monitor
+ * Filename:  ProcStats.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm>
+#include <cstdlib> // std::strtol()
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h> // sysconf()
+
+#include "resource_monitor/ProcStats.hpp"
+
+using namespace navigator::resource_monitor;
+
+namespace {
+
+bool read_file(const std::string & path, std::string & text) {
+  std::ifstream file(path);
+  if(! file) return false;
+  text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+}
+
+bool navigator::resource_monitor::parse_thread_stat(const std::string & text, ThreadTimes & times) {
+  // "tid (comm) state ppid ...". The comm may itself contain spaces
+  // and parentheses, so it ends at the last ')'.
+  std::size_t open = text.find('(');
+  std::size_t close = text.rfind(')');
+  if(open == std::string::npos || close == std::string::npos || close < open) return false;
+  char * end = nullptr;
+  times.tid = std::strtol(text.c_str(), & end, 10);
+  if(end == text.c_str()) return false;
+  times.name = text.substr(open + 1, close - open - 1);
+
+  // After the comm come the state (field 3), then utime and stime
+  // (fields 14 and 15)
+  std::istringstream fields(text.substr(close + 1));
+  std::string field;
+  for(int i = 0; i < 11; i++) {
+    if(! (fields >> field)) return false;
+  }
+  uint64_t utime, stime;
+  if(! (fields >> utime >> stime)) return false;
+  times.cpu_ticks = utime + stime;
+  return true;
+}
+
+bool navigator::resource_monitor::parse_statm_rss(const std::string & text, uint64_t & pages) {
+  // "size resident shared text lib data dt"
+  std::istringstream fields(text);
+  uint64_t size;
+  return static_cast<bool>(fields >> size >> pages);
+}
+
+std::vector<ThreadTimes> navigator::resource_monitor::read_thread_times() {
+  std::vector<ThreadTimes> threads;
+  std::error_code error;
+  for(const auto & entry : std::filesystem::directory_iterator("/proc/self/task", error)) {
+    std::string text;
+    ThreadTimes times;
+    if(read_file(entry.path() / "stat", text) && parse_thread_stat(text, times)) {
+      threads.push_back(times);
+    }
+  }
+  return threads;
+}
+
+uint64_t navigator::resource_monitor::read_rss_bytes() {
+  std::string text;
+  uint64_t pages;
+  if(! read_file("/proc/self/statm", text) || ! parse_statm_rss(text, pages)) return 0;
+  return pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+long navigator::resource_monitor::ticks_per_second() {
+  return sysconf(_SC_CLK_TCK);
+}
+
+std::vector<ThreadUsage> CpuUsage::update(const std::vector<ThreadTimes> & threads, double elapsed_seconds,
+					  long ticks_per_second) {
+  std::map<long, uint64_t> current;
+  for(const ThreadTimes & thread : threads) current[thread.tid] = thread.cpu_ticks;
+
+  std::vector<ThreadUsage> usage;
+  if(this->has_baseline && elapsed_seconds > 0 && ticks_per_second > 0) {
+    for(const ThreadTimes & thread : threads) {
+      auto previous = this->previous.find(thread.tid);
+      // A thread ID seen with more time than it has now was reused
+      uint64_t start = previous != this->previous.end() && previous->second <= thread.cpu_ticks
+	? previous->second : 0;
+      double seconds = double(thread.cpu_ticks - start) / ticks_per_second;
+      usage.push_back(ThreadUsage {thread.tid, thread.name, 100 * seconds / elapsed_seconds});
+    }
+    std::sort(usage.begin(), usage.end(), [](const ThreadUsage & a, const ThreadUsage & b) {
+      return a.cpu_percent > b.cpu_percent;
+    });
+  }
+  this->previous = std::move(current);
+  this->has_baseline = true;
+  return usage;
+}
@@ -0,0 +1,191 @@
+/*
+ * Package:   resource_monitor
+ * Filename:  ResourceMonitor.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "diagnostic_msgs/msg/diagnostic_status.hpp"
+#include "diagnostic_msgs/msg/key_value.hpp"
+
+#include "resource_monitor/AllocationCount.hpp"
+#include "resource_monitor/ResourceMonitor.hpp"
+
+using namespace navigator::resource_monitor;
+using diagnostic_msgs::msg::DiagnosticStatus;
+using diagnostic_msgs::msg::KeyValue;
+
+namespace {
+
+// Threads listed in each status, busiest first
+constexpr std::size_t REPORTED_THREADS = 5;
+
+KeyValue key_value(const std::string & key, double value) {
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(3) << value;
+  KeyValue pair;
+  pair.key = key;
+  pair.value = text.str();
+  return pair;
+}
+
+std::string thread_label(const ThreadUsage & thread) {
+  return "thread " + thread.name + " (" + std::to_string(thread.tid) + ")";
+}
+
+// Parameters are shared by the monitors of a node, should it have
+// several
+template <typename T> T parameter(rclcpp::Node & node, const std::string & name, T value) {
+  if(! node.has_parameter(name)) node.declare_parameter<T>(name, value);
+  return node.get_parameter(name).get_value<T>();
+}
+
+}
+
+CallbackAllocations::CallbackAllocations(const std::string & name)
+  : name_(name) {}
+
+CallbackAllocations::Scope CallbackAllocations::scope() {
+  return Scope(allocation_counting() ? this : nullptr);
+}
+
+CallbackAllocations::Scope::Scope(CallbackAllocations * callback)
+  : callback(callback), start(callback ? thread_allocation_count() : 0) {}
+
+CallbackAllocations::Scope::~Scope() {
+  if(this->callback) this->callback->record(thread_allocation_count() - this->start);
+}
+
+void CallbackAllocations::record(uint64_t allocations) {
+  this->runs.fetch_add(1, std::memory_order_relaxed);
+  this->allocations.fetch_add(allocations, std::memory_order_relaxed);
+  uint64_t max = this->max_allocations.load(std::memory_order_relaxed);
+  while(allocations > max &&
+	! this->max_allocations.compare_exchange_weak(max, allocations, std::memory_order_relaxed)) {}
+}
+
+ResourceMonitor::ResourceMonitor(rclcpp::Node & node)
+  : node_name(node.get_name()), clock(node.get_clock()),
+    ticks_per_second(navigator::resource_monitor::ticks_per_second()) {
+  double period_seconds = parameter<double>(node, "resource_monitor.period_seconds", 1.0);
+  if(period_seconds < 0) {
+    throw std::invalid_argument("resource_monitor.period_seconds must not be negative");
+  }
+  this->max_cpu_percent = parameter<double>(node, "resource_monitor.max_cpu_percent", 0.0);
+  this->max_thread_cpu_percent = parameter<double>(node, "resource_monitor.max_thread_cpu_percent", 0.0);
+  this->max_rss_mb = parameter<double>(node, "resource_monitor.max_rss_mb", 0.0);
+  this->max_callback_allocations = parameter<int64_t>(node, "resource_monitor.max_callback_allocations", 0);
+  if(period_seconds == 0) return;
+
+  // The first sample is the baseline for the first report
+  this->last_sample = std::chrono::steady_clock::now();
+  this->cpu_usage.update(read_thread_times(), 0, this->ticks_per_second);
+
+  this->diagnostics_publisher = node.create_publisher<diagnostic_msgs::msg::DiagnosticArray>
+    ("/diagnostics", 10);
+  this->report_timer = node.create_wall_timer
+    (std::chrono::duration_cast<std::chrono::nanoseconds>
+     (std::chrono::duration<double>(period_seconds)),
+     std::bind(& ResourceMonitor::report, this));
+}
+
+CallbackAllocations * ResourceMonitor::callback(const std::string & name) {
+  std::lock_guard<std::mutex> lock(this->callbacks_mutex);
+  this->callbacks.push_back(std::make_unique<CallbackAllocations>(name));
+  return this->callbacks.back().get();
+}
+
+void ResourceMonitor::report() {
+  auto now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - this->last_sample).count();
+  this->last_sample = now;
+  std::vector<ThreadUsage> threads = this->cpu_usage.update(read_thread_times(), elapsed, this->ticks_per_second);
+  double rss_mb = read_rss_bytes() / (1024.0 * 1024.0);
+
+  DiagnosticStatus status;
+  status.name = this->node_name + ": resources";
+  status.hardware_id = "resources";
+  std::vector<std::string> violations;
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(1);
+
+  double cpu_percent = 0;
+  for(const ThreadUsage & thread : threads) cpu_percent += thread.cpu_percent;
+  status.values.push_back(key_value("cpu_percent", cpu_percent));
+  status.values.push_back(key_value("rss_mb", rss_mb));
+  status.values.push_back(key_value("threads", double(threads.size())));
+  if(this->max_cpu_percent > 0 && cpu_percent > this->max_cpu_percent) {
+    text.str("");
+    text << "CPU " << cpu_percent << "% over " << this->max_cpu_percent << "%";
+    violations.push_back(text.str());
+  }
+  if(this->max_rss_mb > 0 && rss_mb > this->max_rss_mb) {
+    text.str("");
+    text << "RSS " << rss_mb << " MB over " << this->max_rss_mb << " MB";
+    violations.push_back(text.str());
+  }
+
+  for(std::size_t i = 0; i < threads.size(); i++) {
+    const ThreadUsage & thread = threads[i];
+    bool over = this->max_thread_cpu_percent > 0 && thread.cpu_percent > this->max_thread_cpu_percent;
+    if(i >= REPORTED_THREADS && ! over) break; // Sorted, so no later thread is over either
+    status.values.push_back(key_value(thread_label(thread) + " cpu_percent", thread.cpu_percent));
+    if(over) {
+      text.str("");
+      text << thread_label(thread) << " at " << thread.cpu_percent << "% over "
+	   << this->max_thread_cpu_percent << "%";
+      violations.push_back(text.str());
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->callbacks_mutex);
+    if(! this->callbacks.empty() && ! allocation_counting()) {
+      KeyValue pair;
+      pair.key = "allocations";
+      pair.value = "not counted in this process";
+      status.values.push_back(pair);
+    }
+    for(auto & callback : this->callbacks) {
+      uint64_t runs = callback->runs.exchange(0, std::memory_order_relaxed);
+      uint64_t allocations = callback->allocations.exchange(0, std::memory_order_relaxed);
+      uint64_t max = callback->max_allocations.exchange(0, std::memory_order_relaxed);
+      if(runs == 0) continue;
+      status.values.push_back(key_value(callback->name() + " runs", double(runs)));
+      status.values.push_back(key_value(callback->name() + " mean_allocations", double(allocations) / runs));
+      status.values.push_back(key_value(callback->name() + " max_allocations", double(max)));
+      if(this->max_callback_allocations > 0 && max > uint64_t(this->max_callback_allocations)) {
+	violations.push_back(callback->name() + " made " + std::to_string(max) + " allocations in one run, over "
+			     + std::to_string(this->max_callback_allocations));
+      }
+    }
+  }
+
+  if(violations.empty()) {
+    status.level = DiagnosticStatus::OK;
+    status.message = "OK";
+  } else {
+    status.level = DiagnosticStatus::WARN;
+    for(std::size_t i = 0; i < violations.size(); i++) {
+      status.message += (i ? "; " : "") + violations[i];
+    }
+  }
+
+  diagnostic_msgs::msg::DiagnosticArray message;
+  message.header.stamp = this->clock->now();
+  message.status.push_back(status);
+  this->diagnostics_publisher->publish(message);
+}
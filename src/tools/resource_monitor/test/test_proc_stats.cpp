@@ -0,0 +1,73 @@
+/*
+ * Package:   resource_monitor
+ * Filename:  test_proc_stats.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "resource_monitor/ProcStats.hpp"
+
+using namespace navigator::resource_monitor;
+
+TEST(ProcStats, ParsesThreadStat) {
+  // utime 250 and stime 50, after a comm with spaces and parentheses
+  const std::string text = "4242 (gs (worker) 2) S 4200 4200 4200 0 -1 4194624 1234 0 0 0 250 50 "
+    "0 0 20 0 12 0 987654 123456789 2048 18446744073709551615 1 1 0 0 0 0 0 4096 0 0 0 0 -1 3\n";
+  ThreadTimes times;
+  ASSERT_TRUE(parse_thread_stat(text, times));
+  EXPECT_EQ(times.tid, 4242);
+  EXPECT_EQ(times.name, "gs (worker) 2");
+  EXPECT_EQ(times.cpu_ticks, 300u);
+
+  EXPECT_FALSE(parse_thread_stat("", times));
+  EXPECT_FALSE(parse_thread_stat("4242 (cut short) S 4200 4200", times));
+}
+
+TEST(ProcStats, ParsesStatm) {
+  uint64_t pages;
+  ASSERT_TRUE(parse_statm_rss("51234 1200 800 10 0 4000 0\n", pages));
+  EXPECT_EQ(pages, 1200u);
+  EXPECT_FALSE(parse_statm_rss("51234", pages));
+}
+
+TEST(ProcStats, ReadsThisProcess) {
+  std::vector<ThreadTimes> threads = read_thread_times();
+  long tid = static_cast<long>(syscall(SYS_gettid));
+  EXPECT_TRUE(std::any_of(threads.begin(), threads.end(), [tid](const ThreadTimes & t) { return t.tid == tid; }));
+  EXPECT_GT(read_rss_bytes(), 0u);
+  EXPECT_GT(ticks_per_second(), 0);
+}
+
+TEST(CpuUsage, MeasuresEachThreadBetweenUpdates) {
+  CpuUsage usage;
+  // The first update is only the baseline
+  EXPECT_TRUE(usage.update({{1, "main", 100}, {2, "worker", 1000}}, 0, 100).empty());
+
+  // Over 2 s at 100 ticks per second: main used 0.5 s, worker 1.5 s,
+  // and a new thread 0.2 s since it started
+  std::vector<ThreadUsage> threads = usage.update({{1, "main", 150}, {2, "worker", 1150}, {3, "new", 20}}, 2, 100);
+  ASSERT_EQ(threads.size(), 3u);
+  EXPECT_EQ(threads[0].name, "worker");
+  EXPECT_DOUBLE_EQ(threads[0].cpu_percent, 75);
+  EXPECT_EQ(threads[1].name, "main");
+  EXPECT_DOUBLE_EQ(threads[1].cpu_percent, 25);
+  EXPECT_EQ(threads[2].tid, 3);
+  EXPECT_DOUBLE_EQ(threads[2].cpu_percent, 10);
+
+  // Thread 2 exited and its ID went to a thread with less time
+  threads = usage.update({{1, "main", 150}, {2, "reused", 10}}, 1, 100);
+  ASSERT_EQ(threads.size(), 2u);
+  EXPECT_EQ(threads[0].name, "reused");
+  EXPECT_DOUBLE_EQ(threads[0].cpu_percent, 10);
+  EXPECT_DOUBLE_EQ(threads[1].cpu_percent, 0);
+}
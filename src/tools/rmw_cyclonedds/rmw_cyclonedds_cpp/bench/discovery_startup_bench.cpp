@@ -0,0 +1,228 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Startup latency of a ROS graph: launches N processes at once, like main.launch.py
+   does, each with a node with E publishers and E subscriptions, and reports how long
+   it takes until each of them sees all N nodes and all N*E publishers of the shared
+   topic in its graph cache.  Run by hand, comparing e.g. different settings of
+   Discovery/SPDPInitialBurst and Discovery/SEDPBatchDelay in CYCLONEDDS_URI:
+
+     discovery_startup_bench [N [E]]
+
+   The defaults are 30 processes and 10 endpoints of each kind. */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcutils/allocator.h"
+#include "rcutils/types/string_array.h"
+#include "rmw/error_handling.h"
+#include "rmw/rmw.h"
+#include "rmw_dds_common/msg/gid.hpp"
+#include "rosidl_typesupport_cpp/message_type_support.hpp"
+
+namespace
+{
+
+using Message = rmw_dds_common::msg::Gid;
+using Clock = std::chrono::steady_clock;
+
+constexpr auto TIMEOUT = std::chrono::seconds(60);
+
+void check(rmw_ret_t ret, const char * what)
+{
+  if (ret != RMW_RET_OK) {
+    std::string msg = std::string(what) + ": " + rmw_get_error_string().str;
+    rmw_reset_error();
+    throw std::runtime_error(msg);
+  }
+}
+
+template<typename T>
+T * check(T * handle, const char * what)
+{
+  if (handle == nullptr) {
+    check(RMW_RET_ERROR, what);
+  }
+  return handle;
+}
+
+size_t count_nodes(const rmw_node_t * node, const std::string & prefix)
+{
+  rcutils_string_array_t names = rcutils_get_zero_initialized_string_array();
+  rcutils_string_array_t namespaces = rcutils_get_zero_initialized_string_array();
+  check(rmw_get_node_names(node, &names, &namespaces), "rmw_get_node_names");
+  size_t n = 0;
+  for (size_t i = 0; i < names.size; i++) {
+    if (strncmp(names.data[i], prefix.c_str(), prefix.size()) == 0) {
+      n++;
+    }
+  }
+  (void) rcutils_string_array_fini(&names);
+  (void) rcutils_string_array_fini(&namespaces);
+  return n;
+}
+
+/* Returns the time from t0 until the graph is complete, in seconds, or a negative
+   number on timeout */
+double run_participant(
+  Clock::time_point t0, const std::string & prefix, size_t index, size_t nprocs,
+  size_t nendpoints, int result_fd, int done_fd)
+{
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rmw_init_options_t options = rmw_get_zero_initialized_init_options();
+  check(rmw_init_options_init(&options, allocator), "rmw_init_options_init");
+  rmw_context_t context = rmw_get_zero_initialized_context();
+  check(rmw_init(&options, &context), "rmw_init");
+  const std::string name = prefix + std::to_string(index);
+  rmw_node_t * node = check(
+    rmw_create_node(&context, name.c_str(), "/", 0, true), "rmw_create_node");
+
+  const std::string topic = "/" + prefix + "topic";
+  auto ts = rosidl_typesupport_cpp::get_message_type_support_handle<Message>();
+  rmw_qos_profile_t qos = rmw_qos_profile_default;
+  rmw_publisher_options_t pub_options = rmw_get_default_publisher_options();
+  rmw_subscription_options_t sub_options = rmw_get_default_subscription_options();
+  std::vector<rmw_publisher_t *> pubs;
+  std::vector<rmw_subscription_t *> subs;
+  for (size_t i = 0; i < nendpoints; i++) {
+    pubs.push_back(
+      check(
+        rmw_create_publisher(node, ts, topic.c_str(), &qos, &pub_options),
+        "rmw_create_publisher"));
+    subs.push_back(
+      check(
+        rmw_create_subscription(node, ts, topic.c_str(), &qos, &sub_options),
+        "rmw_create_subscription"));
+  }
+
+  double elapsed = -1.0;
+  while (Clock::now() - t0 < TIMEOUT) {
+    size_t npubs = 0;
+    check(rmw_count_publishers(node, topic.c_str(), &npubs), "rmw_count_publishers");
+    if (npubs == nprocs * nendpoints && count_nodes(node, prefix) == nprocs) {
+      elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  /* report, then stay around until the parent closes the pipe once all others are
+     done, or leaving would make them wait forever */
+  if (write(result_fd, &elapsed, sizeof(elapsed)) != static_cast<ssize_t>(sizeof(elapsed))) {
+    elapsed = -1.0;
+  }
+  char dummy;
+  while (read(done_fd, &dummy, 1) > 0) {
+  }
+  for (auto sub : subs) {
+    (void) rmw_destroy_subscription(node, sub);
+  }
+  for (auto pub : pubs) {
+    (void) rmw_destroy_publisher(node, pub);
+  }
+  (void) rmw_destroy_node(node);
+  (void) rmw_shutdown(&context);
+  (void) rmw_context_fini(&context);
+  (void) rmw_init_options_fini(&options);
+  return elapsed;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const size_t nprocs = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 30;
+  const size_t nendpoints = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 10;
+  if (nprocs == 0) {
+    fprintf(stderr, "usage: %s [N [E]]\n", argv[0]);
+    return 2;
+  }
+
+  /* node names and topic are unique to this run so that other ROS processes on the
+     network don't interfere */
+  const std::string prefix = "startup_bench_" + std::to_string(getpid()) + "_";
+  int fds[2], done_fds[2];
+  if (pipe(fds) != 0 || pipe(done_fds) != 0) {
+    perror("pipe");
+    return 1;
+  }
+
+  /* steady_clock is CLOCK_MONOTONIC, so the children can measure from the parent's t0 */
+  const Clock::time_point t0 = Clock::now();
+  std::vector<pid_t> children;
+  for (size_t i = 0; i < nprocs; i++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      close(done_fds[1]);
+      double elapsed;
+      try {
+        elapsed = run_participant(t0, prefix, i, nprocs, nendpoints, fds[1], done_fds[0]);
+      } catch (const std::exception & e) {
+        fprintf(stderr, "participant %zu: %s\n", i, e.what());
+        elapsed = -1.0;
+        ssize_t n = write(fds[1], &elapsed, sizeof(elapsed));
+        static_cast<void>(n);
+      }
+      _exit(elapsed >= 0 ? 0 : 1);
+    } else if (pid < 0) {
+      perror("fork");
+      break;
+    }
+    children.push_back(pid);
+  }
+  close(fds[1]);
+  close(done_fds[0]);
+
+  std::vector<double> times;
+  double elapsed;
+  size_t nresults = 0;
+  while (nresults < children.size() &&
+    read(fds[0], &elapsed, sizeof(elapsed)) == static_cast<ssize_t>(sizeof(elapsed)))
+  {
+    nresults++;
+    if (elapsed >= 0) {
+      times.push_back(elapsed);
+    }
+  }
+  close(fds[0]);
+  close(done_fds[1]);
+  for (pid_t pid : children) {
+    (void) waitpid(pid, nullptr, 0);
+  }
+
+  printf("%zu participants with %zu publishers and subscriptions each\n", nprocs, nendpoints);
+  if (times.size() < nprocs) {
+    printf("%zu of them timed out or failed\n", nprocs - times.size());
+  }
+  if (!times.empty()) {
+    std::sort(times.begin(), times.end());
+    printf(
+      "graph complete after: min %.3fs median %.3fs max %.3fs\n",
+      times.front(), times[times.size() / 2], times.back());
+  }
+  return (times.size() == nprocs) ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Takes of bursts of 1 to 256 small messages, as CAN and IMU consumers do, through
+   rmw_take_sequence and, for comparison, one rmw_take per message. Only the takes are
+   timed; the publisher and subscription are in the same process, so that delivery is
+   synchronous and the messages are all there when the take starts. */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcutils/allocator.h"
+#include "rmw/error_handling.h"
+#include "rmw/message_sequence.h"
+#include "rmw/rmw.h"
+#include "rmw_dds_common/msg/gid.hpp"
+#include "rosidl_typesupport_cpp/message_type_support.hpp"
+
+namespace
+{
+
+using Message = rmw_dds_common::msg::Gid;
+
+void check(rmw_ret_t ret, const char * what)
+{
+  if (ret != RMW_RET_OK) {
+    std::string msg = std::string(what) + ": " + rmw_get_error_string().str;
+    rmw_reset_error();
+    throw std::runtime_error(msg);
+  }
+}
+
+template<typename T>
+T * check(T * handle, const char * what)
+{
+  if (handle == nullptr) {
+    check(RMW_RET_ERROR, what);
+  }
+  return handle;
+}
+
+class Fixture
+{
+public:
+  explicit Fixture(size_t depth)
+  {
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    m_options = rmw_get_zero_initialized_init_options();
+    check(rmw_init_options_init(&m_options, allocator), "rmw_init_options_init");
+    m_context = rmw_get_zero_initialized_context();
+    check(rmw_init(&m_options, &m_context), "rmw_init");
+    m_node = check(
+      rmw_create_node(&m_context, "take_sequence_bench", "/", 0, true), "rmw_create_node");
+
+    rmw_qos_profile_t qos = rmw_qos_profile_default;
+    qos.history = RMW_QOS_POLICY_HISTORY_KEEP_LAST;
+    qos.depth = depth;
+    auto ts = rosidl_typesupport_cpp::get_message_type_support_handle<Message>();
+    rmw_publisher_options_t pub_options = rmw_get_default_publisher_options();
+    m_pub = check(
+      rmw_create_publisher(m_node, ts, "/take_sequence_bench", &qos, &pub_options),
+      "rmw_create_publisher");
+    rmw_subscription_options_t sub_options = rmw_get_default_subscription_options();
+    m_sub = check(
+      rmw_create_subscription(m_node, ts, "/take_sequence_bench", &qos, &sub_options),
+      "rmw_create_subscription");
+
+    /* local matching is immediate, but don't depend on it */
+    size_t matched = 0;
+    for (int i = 0; i < 1000 && matched == 0; i++) {
+      check(
+        rmw_publisher_count_matched_subscriptions(m_pub, &matched),
+        "rmw_publisher_count_matched_subscriptions");
+      if (matched == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    if (matched == 0) {
+      throw std::runtime_error("subscription did not match");
+    }
+  }
+
+  ~Fixture()
+  {
+    (void) rmw_destroy_subscription(m_node, m_sub);
+    (void) rmw_destroy_publisher(m_node, m_pub);
+    (void) rmw_destroy_node(m_node);
+    (void) rmw_shutdown(&m_context);
+    (void) rmw_context_fini(&m_context);
+    (void) rmw_init_options_fini(&m_options);
+  }
+
+  void publish(size_t count)
+  {
+    Message msg;
+    for (size_t i = 0; i < count; i++) {
+      msg.data[0] = static_cast<char>(i);
+      check(rmw_publish(m_pub, &msg, nullptr), "rmw_publish");
+    }
+  }
+
+  const rmw_subscription_t * subscription() const {return m_sub;}
+
+private:
+  rmw_init_options_t m_options;
+  rmw_context_t m_context;
+  rmw_node_t * m_node;
+  rmw_publisher_t * m_pub;
+  rmw_subscription_t * m_sub;
+};
+
+constexpr size_t MAX_BURST = 256;
+
+void BM_TakeSequence(benchmark::State & state)
+{
+  const size_t burst = static_cast<size_t>(state.range(0));
+  Fixture fixture(MAX_BURST);
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+
+  std::vector<Message> messages(burst);
+  rmw_message_sequence_t sequence = rmw_get_zero_initialized_message_sequence();
+  check(rmw_message_sequence_init(&sequence, burst, &allocator), "rmw_message_sequence_init");
+  rmw_message_info_sequence_t infos = rmw_get_zero_initialized_message_info_sequence();
+  check(
+    rmw_message_info_sequence_init(&infos, burst, &allocator),
+    "rmw_message_info_sequence_init");
+
+  for (auto _ : state) {
+    fixture.publish(burst);
+    /* a take leaves the messages it took at the front, so hand it the same set each time */
+    for (size_t i = 0; i < burst; i++) {
+      sequence.data[i] = &messages[i];
+    }
+    size_t taken = 0;
+    auto start = std::chrono::steady_clock::now();
+    check(
+      rmw_take_sequence(fixture.subscription(), burst, &sequence, &infos, &taken, nullptr),
+      "rmw_take_sequence");
+    auto end = std::chrono::steady_clock::now();
+    if (taken != burst) {
+      state.SkipWithError("took fewer messages than were published");
+      break;
+    }
+    state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(burst));
+
+  (void) rmw_message_info_sequence_fini(&infos);
+  (void) rmw_message_sequence_fini(&sequence);
+}
+
+void BM_TakeOneByOne(benchmark::State & state)
+{
+  const size_t burst = static_cast<size_t>(state.range(0));
+  Fixture fixture(MAX_BURST);
+  Message msg;
+
+  for (auto _ : state) {
+    fixture.publish(burst);
+    size_t n = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < burst; i++) {
+      bool taken = false;
+      rmw_message_info_t info;
+      check(
+        rmw_take_with_info(fixture.subscription(), &msg, &taken, &info, nullptr),
+        "rmw_take_with_info");
+      n += taken ? 1 : 0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (n != burst) {
+      state.SkipWithError("took fewer messages than were published");
+      break;
+    }
+    state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(burst));
+}
+
+}  // namespace
+
+BENCHMARK(BM_TakeSequence)->RangeMultiplier(2)->Range(1, MAX_BURST)->UseManualTime();
+BENCHMARK(BM_TakeOneByOne)->RangeMultiplier(2)->Range(1, MAX_BURST)->UseManualTime();
@@ -0,0 +1,64 @@
+# Copyright 2026 Voltron
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+set(_rmw_cyclonedds_cpp_fast_typesupport_generator
+  "${CMAKE_CURRENT_LIST_DIR}/../scripts/generate_fast_typesupport.py")
+
+#
+# Build a shared library of generated CDR (de)serializers for the C++ messages
+# of some packages, and of the packages they use.  rmw_cyclonedds_cpp uses them
+# instead of the introspection type support in processes that load the library:
+# it loads it itself if it is named rmw_cyclonedds_fast_typesupport or listed in
+# RMW_CYCLONEDDS_FAST_TYPESUPPORT, else it must be linked into the executable.
+#
+# :param target: name of the library target to create
+# :type target: string
+# :param PACKAGES: the message packages
+# :type PACKAGES: list of strings
+#
+# @public
+#
+function(rmw_cyclonedds_cpp_generate_fast_typesupport target)
+  cmake_parse_arguments(ARG "" "" "PACKAGES" ${ARGN})
+  if(ARG_UNPARSED_ARGUMENTS)
+    message(FATAL_ERROR "rmw_cyclonedds_cpp_generate_fast_typesupport() called with "
+      "unused arguments: ${ARG_UNPARSED_ARGUMENTS}")
+  endif()
+  if(NOT ARG_PACKAGES)
+    message(FATAL_ERROR "rmw_cyclonedds_cpp_generate_fast_typesupport() called without PACKAGES")
+  endif()
+
+  set(search_paths)
+  set(msg_files)
+  foreach(pkg ${ARG_PACKAGES})
+    find_package(${pkg} REQUIRED)
+    # <prefix>/share/<pkg>/cmake
+    get_filename_component(prefix "${${pkg}_DIR}/../../.." ABSOLUTE)
+    list(APPEND search_paths "--search-path" "${prefix}")
+    file(GLOB pkg_msg_files "${prefix}/share/${pkg}/msg/*.msg")
+    list(APPEND msg_files ${pkg_msg_files})
+  endforeach()
+
+  set(output "${CMAKE_CURRENT_BINARY_DIR}/${target}.cpp")
+  add_custom_command(
+    OUTPUT "${output}"
+    COMMAND "${PYTHON_EXECUTABLE}" "${_rmw_cyclonedds_cpp_fast_typesupport_generator}"
+      --output "${output}" ${search_paths} ${ARG_PACKAGES}
+    DEPENDS "${_rmw_cyclonedds_cpp_fast_typesupport_generator}" ${msg_files}
+    COMMENT "Generating fast type support for ${ARG_PACKAGES}"
+    VERBATIM)
+
+  add_library(${target} SHARED "${output}")
+  ament_target_dependencies(${target} rmw_cyclonedds_cpp ${ARG_PACKAGES})
+endfunction()
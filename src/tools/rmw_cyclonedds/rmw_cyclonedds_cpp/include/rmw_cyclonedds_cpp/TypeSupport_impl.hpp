@@ -366,8 +366,8 @@ void deserialize_field(
     deser.deserializeA(static_cast<T *>(field), member->array_size_);
   } else {
     auto & data = *reinterpret_cast<typename GenericCSequence<T>::type *>(field);
-    int32_t dsize = 0;
-    deser >> dsize;
+    // checked against the remaining data before anything is allocated for it
+    const uint32_t dsize = deser.deserialize_len(1);
     if (!GenericCSequence<T>::init(&data, dsize)) {
       throw std::runtime_error("unable initialize generic sequence");
     }
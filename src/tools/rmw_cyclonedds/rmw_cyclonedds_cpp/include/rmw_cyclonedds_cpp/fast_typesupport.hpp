@@ -0,0 +1,193 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CYCLONEDDS_CPP__FAST_TYPESUPPORT_HPP_
+#define RMW_CYCLONEDDS_CPP__FAST_TYPESUPPORT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "rmw_cyclonedds_cpp/serdes.hpp"
+#include "rmw_cyclonedds_cpp/visibility_control.h"
+
+namespace rmw_cyclonedds_cpp
+{
+
+/// Serializer and deserializer of one C++ message type, compiled for that type.
+/**
+ * These replace walking the introspection type support of messages of the type,
+ * and must produce and accept exactly the same CDR.  They are generated by
+ * rmw_cyclonedds_cpp_generate_fast_typesupport() and registered when the
+ * library holding them is loaded.
+ *
+ * The copies let same-process subscriptions take a published message without
+ * it being serialized at all.
+ */
+struct FastTypeSupport
+{
+  /// Size of the serialized message, including the 4-byte encapsulation header
+  size_t (* serialized_size)(const void * ros_message);
+  /// Writes serialized_size(ros_message) bytes to dest
+  void (* serialize)(void * dest, const void * ros_message);
+  /// Throws DeserializationException if data is not a valid serialization
+  bool (* deserialize)(const void * data, size_t size, void * ros_message);
+  /// A new copy of ros_message, destroyed with the last reference to it
+  std::shared_ptr<void> (* make_shared_copy)(const void * ros_message);
+  /// Assigns ros_message to dest, a message of the same type
+  void (* copy)(void * dest, const void * ros_message);
+};
+
+/// Makes ts the type support of C++ messages with DDS type name type_name,
+/// e.g. "sensor_msgs::msg::dds_::PointCloud2_".  The first registration wins.
+RMW_CYCLONEDDS_CPP_PUBLIC
+void register_fast_type_support(const char * type_name, const FastTypeSupport * ts);
+
+/// The type support registered for type_name, or nullptr.  On first use this
+/// loads the libraries listed in RMW_CYCLONEDDS_FAST_TYPESUPPORT, separated by
+/// ':' and by default rmw_cyclonedds_fast_typesupport, that are installed.
+RMW_CYCLONEDDS_CPP_PUBLIC
+const FastTypeSupport * find_fast_type_support(const std::string & type_name);
+
+namespace fast_cdr
+{
+
+/* Writes CDR the way CDRWriter does: everything aligned to its own size, relative to the
+   start of the data after the encapsulation header, with zeroed padding. Without a
+   destination, it only counts. */
+class CdrStream
+{
+public:
+  explicit CdrStream(void * dest)
+  : m_dest(static_cast<unsigned char *>(dest)), m_offset(0) {}
+
+  size_t offset() const {return m_offset;}
+
+  template<typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value>::type put(const T & value)
+  {
+    align(sizeof(T));
+    put_bytes(&value, sizeof(T));
+  }
+
+  void put(const std::string & value)
+  {
+    put_count(value.size() + 1);
+    put_bytes(value.c_str(), value.size() + 1);
+  }
+
+  void put_count(size_t count)
+  {
+    put(static_cast<uint32_t>(count));
+  }
+
+  /* contiguous primitives; nothing at all, not even alignment, if there are none */
+  template<typename T>
+  void put_array(const T * values, size_t count)
+  {
+    static_assert(std::is_arithmetic<T>::value, "put_array takes primitives only");
+    if (count > 0) {
+      align(sizeof(T));
+      put_bytes(values, count * sizeof(T));
+    }
+  }
+
+  /* std::vector<bool> and the like, which aren't contiguous */
+  template<typename Container>
+  void put_bools(const Container & values)
+  {
+    if (m_dest != nullptr) {
+      for (bool b : values) {
+        m_dest[m_offset++] = b ? 1 : 0;
+      }
+    } else {
+      m_offset += values.size();
+    }
+  }
+
+private:
+  void align(size_t n)
+  {
+    size_t pad = (n - m_offset % n) % n;
+    if (pad > 0) {
+      if (m_dest != nullptr) {
+        std::memset(m_dest + m_offset, 0, pad);
+      }
+      m_offset += pad;
+    }
+  }
+
+  void put_bytes(const void * data, size_t size)
+  {
+    if (m_dest != nullptr) {
+      std::memcpy(m_dest + m_offset, data, size);
+    }
+    m_offset += size;
+  }
+
+  unsigned char * m_dest;
+  size_t m_offset;
+};
+
+/* Bounded sequences, which cycdeser doesn't know; unbounded ones go through operator>> */
+template<typename Sequence>
+void read_sequence(cycdeser & deser, Sequence & seq)
+{
+  const uint32_t count = deser.deserialize_len(1);
+  seq.resize(count);
+  deser.deserializeA(seq.data(), count);
+}
+
+template<typename Sequence>
+void read_bool_sequence(cycdeser & deser, Sequence & seq)
+{
+  const uint32_t count = deser.deserialize_len(1);
+  seq.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    bool b;
+    deser >> b;
+    seq[i] = b;
+  }
+}
+
+template<typename Sequence>
+void read_string_sequence(cycdeser & deser, Sequence & seq)
+{
+  const uint32_t count = deser.deserialize_len(1);
+  seq.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    deser >> seq[i];
+  }
+}
+
+/* Encapsulation header matching CDRWriter's: legacy CDR, native byte order */
+inline void put_header(void * dest)
+{
+  const uint16_t one = 1;
+  unsigned char little_endian;
+  std::memcpy(&little_endian, &one, 1);
+  auto header = static_cast<unsigned char *>(dest);
+  header[0] = 0;
+  header[1] = little_endian;
+  header[2] = header[3] = 0;
+}
+
+}  // namespace fast_cdr
+}  // namespace rmw_cyclonedds_cpp
+
+#endif  // RMW_CYCLONEDDS_CPP__FAST_TYPESUPPORT_HPP_
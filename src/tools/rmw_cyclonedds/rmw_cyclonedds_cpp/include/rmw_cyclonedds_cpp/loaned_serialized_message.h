@@ -0,0 +1,68 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CYCLONEDDS_CPP__LOANED_SERIALIZED_MESSAGE_H_
+#define RMW_CYCLONEDDS_CPP__LOANED_SERIALIZED_MESSAGE_H_
+
+#include "rmw/rmw.h"
+#include "rmw/types.h"
+
+#include "rmw_cyclonedds_cpp/visibility_control.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Take a serialized message without copying it out of the middleware.
+/**
+ * Like rmw_take_serialized_message_with_info, except that the buffer of the
+ * serialized message is the received sample itself rather than a copy of it.
+ * `serialized_message` must be zero initialized, e.g. by
+ * rmw_get_zero_initialized_serialized_message(); it is initialized by this
+ * function only if a message is taken.
+ *
+ * The message comes with an allocator of its own that holds a reference to the
+ * sample until the buffer is deallocated, so it is released with
+ * rmw_serialized_message_fini() like any other, and can be moved into an
+ * rclcpp::SerializedMessage.  Resizing it, or copying it, switches to a copy on
+ * the heap.
+ *
+ * The same sample may be delivered to other subscriptions in this process, so
+ * the buffer must not be written to.
+ *
+ * \param[in] subscription of this implementation
+ * \param[out] serialized_message zero initialized message to take into
+ * \param[out] taken whether a message was taken
+ * \param[out] message_info optional, may be null
+ * \return `RMW_RET_OK` if successful, whether or not a message was taken, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is null, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the subscription is not
+ *   from this implementation, or
+ * \return `RMW_RET_BAD_ALLOC` if the loan bookkeeping could not be allocated, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CYCLONEDDS_CPP_PUBLIC
+rmw_ret_t
+rmw_cyclonedds_cpp_take_loaned_serialized_message(
+  const rmw_subscription_t * subscription,
+  rmw_serialized_message_t * serialized_message,
+  bool * taken,
+  rmw_message_info_t * message_info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_CYCLONEDDS_CPP__LOANED_SERIALIZED_MESSAGE_H_
@@ -0,0 +1,72 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CYCLONEDDS_CPP__PUBLISHER_PAYLOAD_H_
+#define RMW_CYCLONEDDS_CPP__PUBLISHER_PAYLOAD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "rmw_cyclonedds_cpp/visibility_control.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Options of a publisher specific to this implementation.
+/**
+ * A pointer to one of these is passed as the `rmw_specific_publisher_payload`
+ * of the rmw_publisher_options_t given to rmw_create_publisher(), which is
+ * what an rclcpp::detail::RMWImplementationSpecificPublisherPayload sets. It
+ * is only read while the publisher is created.
+ *
+ * Start from rmw_cyclonedds_cpp_get_default_publisher_payload(), which sets
+ * the implementation identifier that tells these apart from the payloads of
+ * other implementations; payloads with another identifier are ignored.
+ */
+typedef struct rmw_cyclonedds_cpp_publisher_payload_t
+{
+  /// Identifier of this implementation, "rmw_cyclonedds_cpp"
+  const char * implementation_identifier;
+
+  /// Publish from a writer thread of the publisher's own.
+  /**
+   * rmw_publish() then only copies the message into a queue and returns; the
+   * writer thread serializes and sends it. Types without a generated copy (see
+   * rmw_cyclonedds_fast_typesupport) are serialized by rmw_publish() instead,
+   * and only sent from the writer thread.
+   *
+   * When the queue is full, the oldest message in it is dropped, and counted
+   * in the publisher's transport statistics. Errors writing a message can't be
+   * returned to the caller, and are logged instead. Serialized and loaned
+   * messages are still published as they are, on the calling thread.
+   */
+  bool async_publish;
+
+  /// Messages the queue of an asynchronous publisher holds, or 0 for the
+  /// default of RMW_CYCLONEDDS_ASYNC_PUBLISH_DEPTH, or else 4
+  size_t async_queue_depth;
+} rmw_cyclonedds_cpp_publisher_payload_t;
+
+/// A payload with the implementation identifier set, and no options.
+RMW_CYCLONEDDS_CPP_PUBLIC
+rmw_cyclonedds_cpp_publisher_payload_t
+rmw_cyclonedds_cpp_get_default_publisher_payload(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_CYCLONEDDS_CPP__PUBLISHER_PAYLOAD_H_
@@ -174,22 +174,31 @@ public:
     pos += sz * sizeof(wchar_t);
   }
 
-#define DESER8_A(T) DESER_A(T, )
+  /* One bounds check for the whole array, then either a straight copy or a loop that does
+     nothing but swap, so that the compiler can vectorise it */
+#define DESER8_A(T) inline void deserializeA(T * x, size_t cnt) { \
+    if (cnt > 0) { \
+      validate_size(cnt, sizeof(T)); \
+      memcpy(reinterpret_cast<void *>(x), reinterpret_cast<const void *>(data + pos), cnt); \
+      pos += cnt; \
+    } \
+}
 #define DESER_A(T, fn_swap) inline void deserializeA(T * x, size_t cnt) { \
     if (cnt > 0) { \
       align(sizeof(T)); \
       validate_size(cnt, sizeof(T)); \
+      const char * src = data + pos; \
       if (swap_bytes) { \
         for (size_t i = 0; i < cnt; i++) { \
-          x[i] = fn_swap(*reinterpret_cast<const T *>(data + pos)); \
-          pos += sizeof(T); \
+          T v; \
+          memcpy(&v, src + i * sizeof(T), sizeof(T)); \
+          x[i] = fn_swap(v); \
         } \
       } else { \
-        memcpy( \
-          reinterpret_cast<void *>(x), reinterpret_cast<const void *>(data + pos), \
+        memcpy(reinterpret_cast<void *>(x), reinterpret_cast<const void *>(src), \
           cnt * sizeof(T)); \
-        pos += cnt * sizeof(T); \
       } \
+      pos += cnt * sizeof(T); \
     } \
 }
   DESER8_A(char);
@@ -202,7 +211,17 @@ public:
   DESER_A(int64_t, bswap8);
   DESER_A(uint64_t, bswap8u);
 #undef DESER_A
+#undef DESER8_A
 
+  inline void deserializeA(bool * x, size_t cnt)
+  {
+    validate_size(cnt, sizeof(unsigned char));
+    const unsigned char * src = reinterpret_cast<const unsigned char *>(data + pos);
+    for (size_t i = 0; i < cnt; i++) {
+      x[i] = (src[i] != 0);
+    }
+    pos += cnt;
+  }
   inline void deserializeA(float * x, size_t cnt)
   {
     deserializeA(reinterpret_cast<uint32_t *>(x), cnt);
@@ -0,0 +1,75 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CYCLONEDDS_CPP__SUBSCRIPTION_PAYLOAD_H_
+#define RMW_CYCLONEDDS_CPP__SUBSCRIPTION_PAYLOAD_H_
+
+#include <stddef.h>
+
+#include "rmw_cyclonedds_cpp/visibility_control.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Options of a subscription specific to this implementation.
+/**
+ * A pointer to one of these is passed as the `rmw_specific_subscription_payload`
+ * of the rmw_subscription_options_t given to rmw_create_subscription(), which
+ * is what an rclcpp::detail::RMWImplementationSpecificSubscriptionPayload sets.
+ * It is only read while the subscription is created.
+ *
+ * Start from rmw_cyclonedds_cpp_get_default_subscription_payload(), which sets
+ * the implementation identifier that tells these apart from the payloads of
+ * other implementations; payloads with another identifier are ignored.
+ */
+typedef struct rmw_cyclonedds_cpp_subscription_payload_t
+{
+  /// Identifier of this implementation, "rmw_cyclonedds_cpp"
+  const char * implementation_identifier;
+
+  /// Content filter expression, or NULL to take all messages.
+  /**
+   * Only messages for which the expression holds are delivered. The filter is
+   * evaluated on the serialized message as it is received, before it is stored
+   * or deserialized, so filtered messages cost neither memory in the history
+   * nor a wakeup.
+   *
+   * Expressions compare members of the message, e.g. `identifier = %0` or
+   * `header.frame_id = 'map' AND range > 0.5`, with the operators =, <>, !=,
+   * <, <=, > and >=, combine them with AND, OR and NOT and parentheses, and
+   * compare them with literals or parameters. Members are numbers, bools and
+   * strings, possibly of nested messages, but not elements of arrays or
+   * sequences.
+   */
+  const char * content_filter_expression;
+
+  /// Values of the parameters %0, %1, ... of the expression, written as literals
+  const char * const * expression_parameters;
+
+  /// Number of expression parameters
+  size_t expression_parameters_size;
+} rmw_cyclonedds_cpp_subscription_payload_t;
+
+/// A payload with the implementation identifier set, and no options.
+RMW_CYCLONEDDS_CPP_PUBLIC
+rmw_cyclonedds_cpp_subscription_payload_t
+rmw_cyclonedds_cpp_get_default_subscription_payload(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_CYCLONEDDS_CPP__SUBSCRIPTION_PAYLOAD_H_
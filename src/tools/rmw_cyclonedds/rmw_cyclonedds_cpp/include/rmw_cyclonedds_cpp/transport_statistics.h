@@ -0,0 +1,102 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CYCLONEDDS_CPP__TRANSPORT_STATISTICS_H_
+#define RMW_CYCLONEDDS_CPP__TRANSPORT_STATISTICS_H_
+
+#include <stdint.h>
+
+#include "rmw/init.h"
+#include "rmw/types.h"
+
+#include "rmw_cyclonedds_cpp/visibility_control.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Transport statistics of one publisher or subscription.
+/**
+ * All counts are totals since the endpoint was created; rates follow from the
+ * differences between two calls.
+ */
+typedef struct rmw_cyclonedds_cpp_transport_statistics_t
+{
+  /// RMW_ENDPOINT_PUBLISHER or RMW_ENDPOINT_SUBSCRIPTION
+  rmw_endpoint_type_t endpoint_type;
+  /// ROS name of the topic, only valid during the callback
+  const char * topic_name;
+  /// Identifier of the endpoint in the ROS graph, as in rmw_topic_endpoint_info_t
+  rmw_gid_t gid;
+
+  /// Messages written by a publisher, or taken by a subscription
+  uint64_t samples;
+  /// Serialized size of those messages
+  uint64_t bytes;
+
+  /// Samples a publisher retransmitted, counting every retransmit
+  uint64_t retransmitted_samples;
+  /// Bytes a publisher queued for retransmitting
+  uint64_t retransmitted_bytes;
+  /// Acknowledgements a publisher received that asked for a retransmit
+  uint64_t nacks_received;
+  /// Bytes in a publisher's history not yet acknowledged by all reliable readers
+  uint64_t unacknowledged_bytes;
+  /// Messages an asynchronous publisher dropped from its full queue unsent
+  uint64_t dropped_samples;
+
+  /// Bytes of fragments and samples a subscription received but dropped before
+  /// they could be delivered
+  uint64_t discarded_bytes;
+  /// Samples a subscription was sent but never received, as far as it knows
+  uint64_t lost_samples;
+  /// Sum over the taken messages of the time from writing to taking them
+  /**
+   * The clocks of publisher and subscriber are compared, so across hosts this
+   * is only as good as their synchronization.
+   */
+  uint64_t total_latency_ns;
+} rmw_cyclonedds_cpp_transport_statistics_t;
+
+/// Called for each endpoint by rmw_cyclonedds_cpp_get_transport_statistics()
+typedef void (* rmw_cyclonedds_cpp_transport_statistics_callback_t)(
+  const rmw_cyclonedds_cpp_transport_statistics_t * statistics, void * arg);
+
+/// Get the transport statistics of every publisher and subscription of a context.
+/**
+ * The callback is called once for each of them, on the calling thread, before
+ * this returns. It may not create or destroy publishers or subscriptions.
+ *
+ * \param[in] context whose publishers and subscriptions to report on
+ * \param[in] callback called with the statistics of each one
+ * \param[in] arg passed on to callback
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if context or callback is null, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the context is not from
+ *   this implementation, or
+ * \return `RMW_RET_ERROR` if statistics could not be gotten
+ */
+RMW_CYCLONEDDS_CPP_PUBLIC
+rmw_ret_t
+rmw_cyclonedds_cpp_get_transport_statistics(
+  const rmw_context_t * context,
+  rmw_cyclonedds_cpp_transport_statistics_callback_t callback,
+  void * arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_CYCLONEDDS_CPP__TRANSPORT_STATISTICS_H_
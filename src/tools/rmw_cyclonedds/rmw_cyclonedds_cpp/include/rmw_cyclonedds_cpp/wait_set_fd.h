@@ -0,0 +1,68 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CYCLONEDDS_CPP__WAIT_SET_FD_H_
+#define RMW_CYCLONEDDS_CPP__WAIT_SET_FD_H_
+
+#include "rmw/types.h"
+
+#include "rmw_cyclonedds_cpp/visibility_control.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Get a file descriptor that becomes readable when a wait set has work.
+/**
+ * This lets an event loop wait for DDS in one epoll(), poll() or select()
+ * together with its own sockets and timers, instead of blocking in rmw_wait()
+ * on a thread of its own. Once the descriptor is readable, the loop calls
+ * rmw_wait() with a zero timeout and handles what it returns.
+ *
+ * The descriptor becomes readable when one of the subscriptions, services or
+ * clients passed to the last rmw_wait() on the wait set receives data, or one
+ * of its guard conditions is triggered. It also stays readable after an
+ * rmw_wait() that returned something, so that anything the caller has not
+ * taken yet is picked up by the next call. Each rmw_wait() makes it not
+ * readable again before it looks.
+ *
+ * Events do not make it readable, because Cyclone DDS would then no longer
+ * report their status. A loop that waits for events as well should also wake
+ * up now and then.
+ *
+ * The descriptor belongs to the wait set. It is created by the first call,
+ * returned again by later ones, and closed by rmw_destroy_wait_set(). Do not
+ * close it.
+ *
+ * \param[in] wait_set to get the descriptor of; rmw_wait() must not be
+ *   running on it
+ * \param[out] fd the descriptor
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if wait_set or fd is null, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the wait set is not from
+ *   this implementation, or
+ * \return `RMW_RET_UNSUPPORTED` if the platform has no eventfd, or
+ * \return `RMW_RET_ERROR` if rmw_wait() is running on the wait set or the
+ *   descriptor could not be created
+ */
+RMW_CYCLONEDDS_CPP_PUBLIC
+rmw_ret_t
+rmw_cyclonedds_cpp_get_wait_set_fd(rmw_wait_set_t * wait_set, int * fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_CYCLONEDDS_CPP__WAIT_SET_FD_H_
@@ -0,0 +1,353 @@
+#!/usr/bin/env python3
+# Copyright 2026 Voltron
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Generate CDR (de)serializers for the C++ messages of ROS packages.
+
+Writes one C++ source file that registers a rmw_cyclonedds_cpp::FastTypeSupport
+for every message of the given packages, and of the packages they use.  The
+.msg files are looked up in share/<package>/msg of the prefixes in
+AMENT_PREFIX_PATH and of --search-path.
+
+Messages that (transitively) contain wchar or wstring fields are left out, and
+keep going through the introspection type support.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+PRIMITIVES = {
+    'bool', 'byte', 'char', 'float32', 'float64', 'int8', 'uint8', 'int16', 'uint16',
+    'int32', 'uint32', 'int64', 'uint64',
+}
+UNSUPPORTED = {'wchar', 'wstring'}
+
+FIELD_RE = re.compile(
+    r'^(?P<type>[A-Za-z0-9_/]+)(?P<bound><=\d+)?(?P<array>\[(?P<size><=)?(?P<n>\d*)\])?'
+    r'\s+(?P<name>[a-z][a-z0-9_]*)(\s+.*)?$')
+
+
+class Field:
+
+    def __init__(self, name, base, array_size, is_sequence, is_bounded):
+        self.name = name
+        self.base = base              # primitive name, 'string', or (package, type)
+        self.array_size = array_size  # fixed size of an array, or None
+        self.is_sequence = is_sequence
+        self.is_bounded = is_bounded  # bounded sequence
+
+    @property
+    def is_message(self):
+        return isinstance(self.base, tuple)
+
+
+class Message:
+
+    def __init__(self, package, name, fields):
+        self.package = package
+        self.name = name
+        self.fields = fields
+
+    @property
+    def key(self):
+        return (self.package, self.name)
+
+    @property
+    def cpp_type(self):
+        return '::%s::msg::%s' % (self.package, self.name)
+
+    @property
+    def header(self):
+        return '%s/msg/%s.hpp' % (self.package, snake_case(self.name))
+
+
+def snake_case(name):
+    # the same conversion rosidl uses for header names
+    name = re.sub(r'(.)([A-Z][a-z]+)', r'\1_\2', name)
+    name = re.sub(r'([a-z0-9])([A-Z])', r'\1_\2', name)
+    return name.lower()
+
+
+def parse_msg(package, name, path):
+    fields = []
+    with open(path) as f:
+        for line in f:
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+            m = FIELD_RE.match(line)
+            if m is None:
+                if re.match(r'^\S+\s+[A-Z][A-Z0-9_]*\s*=', line):
+                    continue  # constant
+                raise ValueError('%s: cannot parse "%s"' % (path, line))
+            type_name = m.group('type')
+            if type_name in PRIMITIVES or type_name == 'string' or type_name in UNSUPPORTED:
+                base = type_name
+            elif type_name == 'Header':
+                base = ('std_msgs', 'Header')
+            elif '/' in type_name:
+                pkg, _, typ = type_name.partition('/')
+                base = (pkg, typ.split('/')[-1])
+            else:
+                base = (package, type_name)
+            array_size = None
+            is_sequence = False
+            is_bounded = False
+            if m.group('array') is not None:
+                if m.group('n') and not m.group('size'):
+                    array_size = int(m.group('n'))
+                else:
+                    is_sequence = True
+                    is_bounded = bool(m.group('size'))
+            fields.append(Field(m.group('name'), base, array_size, is_sequence, is_bounded))
+    if not fields:
+        # rosidl gives empty messages a placeholder member, which is serialized like any other
+        fields.append(Field('structure_needs_at_least_one_member', 'uint8', None, False, False))
+    return Message(package, name, fields)
+
+
+def find_msg(package, name, prefixes):
+    for prefix in prefixes:
+        path = os.path.join(prefix, 'share', package, 'msg', name + '.msg')
+        if os.path.isfile(path):
+            return path
+    return None
+
+
+def list_msgs(package, prefixes):
+    for prefix in prefixes:
+        msg_dir = os.path.join(prefix, 'share', package, 'msg')
+        if os.path.isdir(msg_dir):
+            return sorted(f[:-4] for f in os.listdir(msg_dir) if f.endswith('.msg'))
+    return None
+
+
+def load(packages, prefixes):
+    messages = {}
+    pending = []
+    for package in packages:
+        names = list_msgs(package, prefixes)
+        if names is None:
+            raise ValueError('no messages found for package %s' % package)
+        pending.extend((package, name) for name in names)
+    while pending:
+        key = pending.pop()
+        if key in messages:
+            continue
+        path = find_msg(key[0], key[1], prefixes)
+        if path is None:
+            raise ValueError('cannot find %s/%s' % key)
+        msg = parse_msg(key[0], key[1], path)
+        messages[key] = msg
+        pending.extend(f.base for f in msg.fields if f.is_message)
+    return messages
+
+
+def supported(messages):
+    """Keys of the messages that contain no unsupported field, however deeply nested."""
+    result = {}
+
+    def visit(key, stack):
+        if key in result:
+            return result[key]
+        if key in stack:
+            raise ValueError('recursive message %s/%s' % key)
+        ok = True
+        for f in messages[key].fields:
+            if f.is_message:
+                ok = visit(f.base, stack | {key}) and ok
+            elif f.base in UNSUPPORTED:
+                ok = False
+        result[key] = ok
+        return ok
+
+    for key in messages:
+        visit(key, frozenset())
+    return {key for key, ok in result.items() if ok}
+
+
+def write_statements(field):
+    m = 'm.' + field.name
+    if field.is_message:
+        if field.array_size is None and not field.is_sequence:
+            return ['write(s, %s);' % m]
+        lines = ['s.put_count(%s.size());' % m] if field.is_sequence else []
+        return lines + ['for (const auto & e : %s) {write(s, e);}' % m]
+    if field.base == 'string':
+        if field.array_size is None and not field.is_sequence:
+            return ['s.put(%s);' % m]
+        lines = ['s.put_count(%s.size());' % m] if field.is_sequence else []
+        return lines + ['for (const auto & e : %s) {s.put(e);}' % m]
+    if field.array_size is None and not field.is_sequence:
+        return ['s.put(%s);' % m]
+    if field.array_size is not None:
+        return ['s.put_array(%s.data(), %s.size());' % (m, m)]
+    if field.base == 'bool':
+        return ['s.put_count(%s.size());' % m, 's.put_bools(%s);' % m]
+    return ['s.put_count(%s.size());' % m, 's.put_array(%s.data(), %s.size());' % (m, m)]
+
+
+def read_statements(field):
+    m = 'm.' + field.name
+    if field.is_message:
+        if field.array_size is None and not field.is_sequence:
+            return ['read(d, %s);' % m]
+        lines = ['%s.resize(d.deserialize_len(1));' % m] if field.is_sequence else []
+        return lines + ['for (auto & e : %s) {read(d, e);}' % m]
+    if field.is_bounded:
+        if field.base == 'string':
+            return ['rmw_cyclonedds_cpp::fast_cdr::read_string_sequence(d, %s);' % m]
+        if field.base == 'bool':
+            return ['rmw_cyclonedds_cpp::fast_cdr::read_bool_sequence(d, %s);' % m]
+        return ['rmw_cyclonedds_cpp::fast_cdr::read_sequence(d, %s);' % m]
+    # scalars, strings, std::array and std::vector are all known to cycdeser
+    return ['d >> %s;' % m]
+
+
+def c_identifier(msg):
+    return '%s__%s' % (msg.package, msg.name)
+
+
+def generate(messages, keys):
+    ordered = [messages[k] for k in sorted(keys)]
+    out = []
+    out.append('// generated by generate_fast_typesupport.py, do not edit')
+    out.append('')
+    out.append('#include <cstddef>')
+    out.append('#include <memory>')
+    out.append('')
+    for msg in ordered:
+        out.append('#include "%s"' % msg.header)
+    out.append('')
+    out.append('#include "rmw_cyclonedds_cpp/fast_typesupport.hpp"')
+    out.append('#include "rmw_cyclonedds_cpp/serdes.hpp"')
+    out.append('')
+    out.append('namespace')
+    out.append('{')
+    out.append('')
+    out.append('using rmw_cyclonedds_cpp::fast_cdr::CdrStream;')
+    out.append('')
+    for msg in ordered:
+        out.append('void write(CdrStream & s, const %s & m);' % msg.cpp_type)
+        out.append('void read(cycdeser & d, %s & m);' % msg.cpp_type)
+    out.append('')
+    for msg in ordered:
+        out.append('void write(CdrStream & s, const %s & m)' % msg.cpp_type)
+        out.append('{')
+        for f in msg.fields:
+            out.extend('  ' + line for line in write_statements(f))
+        out.append('}')
+        out.append('')
+        out.append('void read(cycdeser & d, %s & m)' % msg.cpp_type)
+        out.append('{')
+        for f in msg.fields:
+            out.extend('  ' + line for line in read_statements(f))
+        out.append('}')
+        out.append('')
+    out.append('template<typename T>')
+    out.append('size_t serialized_size(const void * ros_message)')
+    out.append('{')
+    out.append('  CdrStream s(nullptr);')
+    out.append('  write(s, *static_cast<const T *>(ros_message));')
+    out.append('  return 4 + s.offset();')
+    out.append('}')
+    out.append('')
+    out.append('template<typename T>')
+    out.append('void serialize(void * dest, const void * ros_message)')
+    out.append('{')
+    out.append('  rmw_cyclonedds_cpp::fast_cdr::put_header(dest);')
+    out.append('  CdrStream s(static_cast<unsigned char *>(dest) + 4);')
+    out.append('  write(s, *static_cast<const T *>(ros_message));')
+    out.append('}')
+    out.append('')
+    out.append('template<typename T>')
+    out.append('bool deserialize(const void * data, size_t size, void * ros_message)')
+    out.append('{')
+    out.append('  cycdeser d(data, size);')
+    out.append('  read(d, *static_cast<T *>(ros_message));')
+    out.append('  return true;')
+    out.append('}')
+    out.append('')
+    out.append('template<typename T>')
+    out.append('std::shared_ptr<void> make_shared_copy(const void * ros_message)')
+    out.append('{')
+    out.append('  return std::make_shared<T>(*static_cast<const T *>(ros_message));')
+    out.append('}')
+    out.append('')
+    out.append('template<typename T>')
+    out.append('void copy_message(void * dest, const void * ros_message)')
+    out.append('{')
+    out.append('  *static_cast<T *>(dest) = *static_cast<const T *>(ros_message);')
+    out.append('}')
+    out.append('')
+    for msg in ordered:
+        out.append('const rmw_cyclonedds_cpp::FastTypeSupport %s = {' % c_identifier(msg))
+        out.append('  serialized_size<%s>,' % msg.cpp_type)
+        out.append('  serialize<%s>,' % msg.cpp_type)
+        out.append('  deserialize<%s>,' % msg.cpp_type)
+        out.append('  make_shared_copy<%s>,' % msg.cpp_type)
+        out.append('  copy_message<%s>' % msg.cpp_type)
+        out.append('};')
+    out.append('')
+    out.append('struct Registration')
+    out.append('{')
+    out.append('  Registration()')
+    out.append('  {')
+    for msg in ordered:
+        out.append('    rmw_cyclonedds_cpp::register_fast_type_support(')
+        out.append('      "%s::msg::dds_::%s_", &%s);' % (msg.package, msg.name, c_identifier(msg)))
+    out.append('  }')
+    out.append('} registration;')
+    out.append('')
+    out.append('}  // namespace')
+    out.append('')
+    return '\n'.join(out)
+
+
+def main(argv=sys.argv[1:]):
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('--output', required=True, help='C++ source file to write')
+    parser.add_argument(
+        '--search-path', action='append', default=[],
+        help='install prefix to look for messages in, before AMENT_PREFIX_PATH')
+    parser.add_argument('packages', nargs='+', help='packages whose messages to generate for')
+    args = parser.parse_args(argv)
+
+    prefixes = args.search_path + [
+        p for p in os.environ.get('AMENT_PREFIX_PATH', '').split(os.pathsep) if p]
+    try:
+        messages = load(args.packages, prefixes)
+        keys = supported(messages)
+    except ValueError as e:
+        print('generate_fast_typesupport: %s' % e, file=sys.stderr)
+        return 1
+    for key in sorted(set(messages) - keys):
+        print('generate_fast_typesupport: skipping %s/%s, it has wide strings' % key)
+
+    source = generate(messages, keys)
+    # leave the file alone if nothing changed, so that it isn't rebuilt
+    if os.path.exists(args.output):
+        with open(args.output) as f:
+            if f.read() == source:
+                return 0
+    with open(args.output, 'w') as f:
+        f.write(source)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
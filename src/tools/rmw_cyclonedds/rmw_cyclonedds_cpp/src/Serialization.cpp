@@ -145,16 +145,23 @@ public:
     };
   };
 
+  /// fixed_size_cache entry of a value whose serialized size depends on its contents
+  static constexpr size_t VARIABLE_SIZE = std::numeric_limits<size_t>::max();
+
   const EncodingVersion eversion;
   const size_t max_align;
   std::unique_ptr<const StructValueType> m_root_value_type;
   std::unordered_map<CacheKey, bool, CacheKey::Hash> trivially_serialized_cache;
+  /// serialized size, including leading alignment, of values with no strings or sequences,
+  /// so that computing the size of a message only walks its variable-length members
+  std::unordered_map<CacheKey, size_t, CacheKey::Hash> fixed_size_cache;
 
 public:
   explicit CDRWriter(std::unique_ptr<const StructValueType> root_value_type)
   : eversion{EncodingVersion::CDR_Legacy}, max_align{8},
     m_root_value_type{std::move(root_value_type)},
-    trivially_serialized_cache{}
+    trivially_serialized_cache{},
+    fixed_size_cache{}
   {
     assert(m_root_value_type);
     register_serializable_type(m_root_value_type.get());
@@ -169,17 +176,21 @@ public:
       }
 
       bool & result = trivially_serialized_cache[key];
+      size_t & fixed_size = fixed_size_cache[key];
+      fixed_size = VARIABLE_SIZE;
 
       switch (t->e_value_type()) {
         case EValueType::PrimitiveValueType: {
             auto tt = static_cast<const PrimitiveValueType *>(t);
             result = is_trivially_serialized(align, *tt);
+            fixed_size = compute_fixed_size(align, *tt);
           }
           break;
         case EValueType::ArrayValueType: {
             auto tt = static_cast<const ArrayValueType *>(t);
             result = compute_trivially_serialized(align, *tt);
             register_serializable_type(tt->element_value_type());
+            fixed_size = compute_fixed_size(align, *tt);
           }
           break;
         case EValueType::StructValueType: {
@@ -188,6 +199,7 @@ public:
               register_serializable_type(tt->get_member(i)->value_type);
             }
             result = is_trivially_serialized(align, *tt);
+            fixed_size = compute_fixed_size(align, *tt);
           }
           break;
         case EValueType::SpanSequenceValueType: {
@@ -273,6 +285,24 @@ public:
     }
   }
 
+  bool is_trivially_serialized() const override
+  {
+    // an empty message is serialized as a dummy byte, not as its zero-size struct
+    if (m_root_value_type->n_members() == 0) {
+      return false;
+    }
+    return lookup_trivially_serialized(
+      eversion == EncodingVersion::CDR_Legacy ? 0 : header_size(), m_root_value_type.get());
+  }
+
+  size_t header_size() const override {return 4;}
+
+  void put_header(void * dest) const override
+  {
+    DataCursor cursor(dest);
+    put_rtps_header(&cursor);
+  }
+
 protected:
   void put_rtps_header(CDRCursor * cursor) const
   {
@@ -391,6 +421,63 @@ protected:
     return trivially_serialized_cache.at(key);
   }
 
+  /// Serialized size of a value of a registered type starting at this offset, or
+  /// VARIABLE_SIZE if it has to be walked to find out
+  size_t lookup_fixed_size(size_t align, const AnyValueType * p) const
+  {
+    CacheKey key{align % max_align, p};
+    return fixed_size_cache.at(key);
+  }
+
+  size_t compute_fixed_size(size_t align, const PrimitiveValueType & v) const
+  {
+    align %= max_align;
+    size_t n_align = get_cdr_alignof_primitive(v.type_kind());
+    size_t padding = (n_align > 1 && align % n_align != 0) ? n_align - align % n_align : 0;
+    return padding + get_cdr_size_of_primitive(v.type_kind());
+  }
+
+  /// Adds the fixed sizes of count consecutive values of a registered type to offset;
+  /// false if any of them is variable
+  bool add_fixed_sizes(size_t * offset, size_t count, const AnyValueType * evt) const
+  {
+    for (size_t i = 0; i < count; i++) {
+      size_t size = lookup_fixed_size(*offset, evt);
+      if (size == VARIABLE_SIZE) {
+        return false;
+      }
+      *offset += size;
+      // from here on the alignment repeats with each element
+      if (i + 1 < count && *offset % max_align == (*offset - size) % max_align) {
+        *offset += (count - i - 1) * size;
+        return true;
+      }
+    }
+    return true;
+  }
+
+  size_t compute_fixed_size(size_t align, const ArrayValueType & v) const
+  {
+    align %= max_align;
+    size_t offset = align;
+    if (!add_fixed_sizes(&offset, v.array_size(), v.element_value_type())) {
+      return VARIABLE_SIZE;
+    }
+    return offset - align;
+  }
+
+  size_t compute_fixed_size(size_t align, const StructValueType & p) const
+  {
+    align %= max_align;
+    size_t offset = align;
+    for (size_t i = 0; i < p.n_members(); i++) {
+      if (!add_fixed_sizes(&offset, 1, p.get_member(i)->value_type)) {
+        return VARIABLE_SIZE;
+      }
+    }
+    return offset - align;
+  }
+
   /// Returns true if a memcpy is all it takes to serialize this value
   bool compute_trivially_serialized(size_t align, const AnyValueType * p) const
   {
@@ -535,30 +622,32 @@ protected:
   {
     if (lookup_trivially_serialized(cursor->offset(), value_type)) {
       cursor->put_bytes(data, value_type->sizeof_type());
-    } else {
-//      value_type->apply([&](const auto & vt) {return serialize(cursor, data, vt);});
-      if (auto s = dynamic_cast<const PrimitiveValueType *>(value_type)) {
-        return serialize(cursor, data, *s);
-      }
-      if (auto s = dynamic_cast<const U8StringValueType *>(value_type)) {
-        return serialize(cursor, data, *s);
-      }
-      if (auto s = dynamic_cast<const U16StringValueType *>(value_type)) {
-        return serialize(cursor, data, *s);
-      }
-      if (auto s = dynamic_cast<const StructValueType *>(value_type)) {
-        return serialize(cursor, data, *s);
-      }
-      if (auto s = dynamic_cast<const ArrayValueType *>(value_type)) {
-        return serialize(cursor, data, *s);
-      }
-      if (auto s = dynamic_cast<const SpanSequenceValueType *>(value_type)) {
-        return serialize(cursor, data, *s);
-      }
-      if (auto s = dynamic_cast<const BoolVectorValueType *>(value_type)) {
-        return serialize(cursor, data, *s);
+      return;
+    }
+    if (cursor->ignores_data()) {
+      size_t size = lookup_fixed_size(cursor->offset(), value_type);
+      if (size != VARIABLE_SIZE) {
+        cursor->advance(size);
+        return;
       }
-      unreachable();
+    }
+    switch (value_type->e_value_type()) {
+      case EValueType::PrimitiveValueType:
+        return serialize(cursor, data, *static_cast<const PrimitiveValueType *>(value_type));
+      case EValueType::U8StringValueType:
+        return serialize(cursor, data, *static_cast<const U8StringValueType *>(value_type));
+      case EValueType::U16StringValueType:
+        return serialize(cursor, data, *static_cast<const U16StringValueType *>(value_type));
+      case EValueType::StructValueType:
+        return serialize(cursor, data, *static_cast<const StructValueType *>(value_type));
+      case EValueType::ArrayValueType:
+        return serialize(cursor, data, *static_cast<const ArrayValueType *>(value_type));
+      case EValueType::SpanSequenceValueType:
+        return serialize(cursor, data, *static_cast<const SpanSequenceValueType *>(value_type));
+      case EValueType::BoolVectorValueType:
+        return serialize(cursor, data, *static_cast<const BoolVectorValueType *>(value_type));
+      default:
+        unreachable();
     }
   }
 
@@ -588,6 +677,11 @@ protected:
       size_t value_size = vt->sizeof_type();
       cursor->put_bytes(data, count * value_size);
       return;
+    }
+    size_t offset = cursor->offset();
+    if (cursor->ignores_data() && add_fixed_sizes(&offset, count, vt)) {
+      cursor->advance(offset - cursor->offset());
+      return;
     } else {
       for (size_t i = 0; i < count; i++) {
         auto element = byte_offset(data, i * vt->sizeof_type());
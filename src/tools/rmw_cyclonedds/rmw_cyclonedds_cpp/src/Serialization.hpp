@@ -30,6 +30,13 @@ public:
   virtual void serialize(void * dest, const void * data) const = 0;
   virtual size_t get_serialized_size(const cdds_request_wrapper_t & request) const = 0;
   virtual void serialize(void * dest, const cdds_request_wrapper_t & request) const = 0;
+
+  /// True if the message in memory is exactly its CDR body, so a message built in place
+  /// after the encoding header is already serialized.
+  virtual bool is_trivially_serialized() const = 0;
+  /// Size of the encoding header that precedes the CDR body
+  virtual size_t header_size() const = 0;
+  virtual void put_header(void * dest) const = 0;
   virtual ~BaseCDRWriter() = default;
 };
 
@@ -0,0 +1,113 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "async_publisher.hpp"
+
+#include <cstdlib>
+#include <utility>
+
+namespace rmw_cyclonedds_cpp
+{
+
+bool AsyncPublishConfig::enabled_for(const std::string & topic_name) const
+{
+  size_t start = 0;
+  while (start <= topics.size()) {
+    size_t end = topics.find(',', start);
+    if (end == std::string::npos) {
+      end = topics.size();
+    }
+    if (end > start && topics.compare(start, end - start, topic_name) == 0) {
+      return true;
+    }
+    start = end + 1;
+  }
+  return false;
+}
+
+const AsyncPublishConfig & async_publish_config()
+{
+  static const AsyncPublishConfig config = [] {
+      AsyncPublishConfig c;
+      const char * topics = std::getenv("RMW_CYCLONEDDS_ASYNC_PUBLISH");
+      c.topics = (topics != nullptr) ? topics : "";
+      c.depth = 4;
+      const char * depth = std::getenv("RMW_CYCLONEDDS_ASYNC_PUBLISH_DEPTH");
+      if (depth != nullptr && *depth != '\0') {
+        char * end;
+        unsigned long long parsed = std::strtoull(depth, &end, 10);  // NOLINT
+        if (*end == '\0' && parsed > 0) {
+          c.depth = static_cast<size_t>(parsed);
+        }
+      }
+      return c;
+    } ();
+  return config;
+}
+
+AsyncWriter::AsyncWriter(size_t depth)
+: m_depth(depth > 0 ? depth : 1), m_stop(false), m_dropped(0)
+{
+  m_thread = std::thread(&AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter()
+{
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_stop = true;
+  }
+  m_cond.notify_one();
+  m_thread.join();
+}
+
+void AsyncWriter::push(Write && write)
+{
+  Write dropped;
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_queue.size() >= m_depth) {
+      dropped = std::move(m_queue.front());
+      m_queue.pop_front();
+      m_dropped++;
+    }
+    m_queue.push_back(std::move(write));
+  }
+  m_cond.notify_one();
+  /* dropped is destroyed here, outside the lock, releasing what it held */
+}
+
+uint64_t AsyncWriter::dropped() const
+{
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_dropped;
+}
+
+void AsyncWriter::run()
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+  while (true) {
+    m_cond.wait(lock, [this] {return m_stop || !m_queue.empty();});
+    if (m_queue.empty()) {
+      return;
+    }
+    Write write = std::move(m_queue.front());
+    m_queue.pop_front();
+    lock.unlock();
+    write();
+    write = nullptr;
+    lock.lock();
+  }
+}
+
+}  // namespace rmw_cyclonedds_cpp
@@ -0,0 +1,76 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef ASYNC_PUBLISHER_HPP_
+#define ASYNC_PUBLISHER_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/* Asynchronous publishing: rmw_publish hands the message to a bounded queue and returns,
+   and a writer thread of the publisher's own serializes and sends it. A full queue drops
+   its oldest message, so a publisher whose writes fall behind sends up-to-date data rather
+   than a growing backlog, and never blocks the caller. */
+
+namespace rmw_cyclonedds_cpp
+{
+
+struct AsyncPublishConfig
+{
+  /* RMW_CYCLONEDDS_ASYNC_PUBLISH: comma-separated ROS names of the topics whose publishers
+     are asynchronous, in addition to those that ask for it in their payload */
+  std::string topics;
+  /* RMW_CYCLONEDDS_ASYNC_PUBLISH_DEPTH: default queue depth, 4 unless set */
+  size_t depth;
+
+  bool enabled_for(const std::string & topic_name) const;
+};
+
+const AsyncPublishConfig & async_publish_config();
+
+class AsyncWriter
+{
+public:
+  /* A write, run on the writer thread; a dropped one is destroyed without being run, so
+     whatever it holds must be released by its destructor */
+  using Write = std::function<void ()>;
+
+  explicit AsyncWriter(size_t depth);
+  /* Runs the writes still queued, then stops the thread */
+  ~AsyncWriter();
+
+  void push(Write && write);
+
+  uint64_t dropped() const;
+
+private:
+  void run();
+
+  const size_t m_depth;
+  mutable std::mutex m_lock;
+  std::condition_variable m_cond;
+  std::deque<Write> m_queue;
+  bool m_stop;
+  uint64_t m_dropped;
+  std::thread m_thread;
+};
+
+}  // namespace rmw_cyclonedds_cpp
+
+#endif  // ASYNC_PUBLISHER_HPP_
@@ -0,0 +1,734 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "content_filter.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bytewise.hpp"
+
+namespace rmw_cyclonedds_cpp
+{
+
+namespace
+{
+
+/* the sizes and alignments CDRWriter uses */
+size_t cdr_size_of_primitive(ROSIDL_TypeKind tk)
+{
+  switch (tk) {
+    case ROSIDL_TypeKind::BOOLEAN:
+    case ROSIDL_TypeKind::OCTET:
+    case ROSIDL_TypeKind::UINT8:
+    case ROSIDL_TypeKind::INT8:
+    case ROSIDL_TypeKind::CHAR:
+      return 1;
+    case ROSIDL_TypeKind::UINT16:
+    case ROSIDL_TypeKind::INT16:
+    case ROSIDL_TypeKind::WCHAR:
+      return 2;
+    case ROSIDL_TypeKind::UINT32:
+    case ROSIDL_TypeKind::INT32:
+    case ROSIDL_TypeKind::FLOAT:
+      return 4;
+    case ROSIDL_TypeKind::UINT64:
+    case ROSIDL_TypeKind::INT64:
+    case ROSIDL_TypeKind::DOUBLE:
+      return 8;
+    case ROSIDL_TypeKind::LONG_DOUBLE:
+      return 16;
+    default:
+      unreachable();
+  }
+}
+
+size_t cdr_align_of_primitive(ROSIDL_TypeKind tk)
+{
+  size_t size = cdr_size_of_primitive(tk);
+  return size < 8 ? size : 8;
+}
+
+std::string to_upper(std::string s)
+{
+  for (auto & c : s) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  return s;
+}
+
+}  // namespace
+
+/* Reads the serialized data after the encapsulation header. Without data, it only follows
+   the offsets as long as they don't depend on the message. */
+struct ContentFilter::Cursor
+{
+  const uint8_t * data;
+  size_t size;
+  size_t offset;
+  bool swap;
+
+  bool align(size_t n)
+  {
+    offset = (offset + n - 1) / n * n;
+    return offset <= size;
+  }
+
+  bool advance(size_t n)
+  {
+    if (n > size - offset) {
+      return false;
+    }
+    offset += n;
+    return true;
+  }
+
+  bool read(void * dest, size_t n)
+  {
+    if (data == nullptr || !align(n < 8 ? n : 8) || n > size - offset) {
+      return false;
+    }
+    memcpy(dest, data + offset, n);
+    if (swap) {
+      auto bytes = static_cast<uint8_t *>(dest);
+      for (size_t i = 0; i < n / 2; i++) {
+        std::swap(bytes[i], bytes[n - 1 - i]);
+      }
+    }
+    offset += n;
+    return true;
+  }
+
+  bool read_count(uint32_t * count)
+  {
+    /* every element takes at least a byte, which puts a bound on any count */
+    return read(count, sizeof(*count)) && *count <= size - offset;
+  }
+
+  bool skip_primitives(ROSIDL_TypeKind tk, size_t count)
+  {
+    if (count == 0) {
+      return true;
+    }
+    size_t size_of = cdr_size_of_primitive(tk);
+    return align(cdr_align_of_primitive(tk)) && count <= (size - offset) / size_of &&
+           advance(count * size_of);
+  }
+
+  bool skip_many(const AnyValueType * element, size_t count)
+  {
+    if (element->e_value_type() == EValueType::PrimitiveValueType) {
+      return skip_primitives(static_cast<const PrimitiveValueType *>(element)->type_kind(), count);
+    }
+    for (size_t i = 0; i < count; i++) {
+      if (!skip(element)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool skip(const AnyValueType * value_type)
+  {
+    uint32_t count;
+    switch (value_type->e_value_type()) {
+      case EValueType::PrimitiveValueType:
+        return skip_primitives(static_cast<const PrimitiveValueType *>(value_type)->type_kind(), 1);
+      case EValueType::U8StringValueType:
+        return read_count(&count) && advance(count);
+      case EValueType::U16StringValueType:
+        /* legacy CDR wstrings are counted in characters of sizeof(wchar_t) bytes */
+        return read_count(&count) && count <= (size - offset) / sizeof(wchar_t) &&
+               advance(count * sizeof(wchar_t));
+      case EValueType::StructValueType: {
+          auto st = static_cast<const StructValueType *>(value_type);
+          for (size_t i = 0; i < st->n_members(); i++) {
+            if (!skip(st->get_member(i)->value_type)) {
+              return false;
+            }
+          }
+          return true;
+        }
+      case EValueType::ArrayValueType: {
+          auto at = static_cast<const ArrayValueType *>(value_type);
+          return skip_many(at->element_value_type(), at->array_size());
+        }
+      case EValueType::SpanSequenceValueType:
+        return read_count(&count) &&
+               skip_many(
+          static_cast<const SpanSequenceValueType *>(value_type)->element_value_type(), count);
+      case EValueType::BoolVectorValueType:
+        return read_count(&count) && advance(count);
+      default:
+        unreachable();
+    }
+  }
+
+  /* moves to where the field is, but not past the alignment before it */
+  bool locate(const StructValueType * type, const std::vector<size_t> & steps)
+  {
+    for (size_t depth = 0; depth < steps.size(); depth++) {
+      for (size_t i = 0; i < steps[depth]; i++) {
+        if (!skip(type->get_member(i)->value_type)) {
+          return false;
+        }
+      }
+      if (depth + 1 < steps.size()) {
+        type = static_cast<const StructValueType *>(type->get_member(steps[depth])->value_type);
+      }
+    }
+    return true;
+  }
+};
+
+class ContentFilter::Parser
+{
+public:
+  Parser(ContentFilter & filter, const std::string & expression,
+    const std::vector<std::string> & parameters)
+  : m_filter(filter), m_expression(expression), m_parameters(parameters), m_pos(0)
+  {
+  }
+
+  size_t parse()
+  {
+    size_t root = parse_or();
+    skip_space();
+    if (m_pos != m_expression.size()) {
+      fail("unexpected \"" + m_expression.substr(m_pos) + "\"");
+    }
+    return root;
+  }
+
+private:
+  [[noreturn]] void fail(const std::string & what) const
+  {
+    throw std::runtime_error(
+            "invalid content filter expression \"" + m_expression + "\": " + what);
+  }
+
+  void skip_space()
+  {
+    while (m_pos < m_expression.size() &&
+      std::isspace(static_cast<unsigned char>(m_expression[m_pos])))
+    {
+      m_pos++;
+    }
+  }
+
+  static bool is_word_char(char c)
+  {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+  }
+
+  /* the next word, without consuming it */
+  std::string peek_word()
+  {
+    skip_space();
+    size_t end = m_pos;
+    while (end < m_expression.size() && is_word_char(m_expression[end])) {
+      end++;
+    }
+    return m_expression.substr(m_pos, end - m_pos);
+  }
+
+  bool accept_keyword(const char * keyword)
+  {
+    std::string word = peek_word();
+    if (to_upper(word) != keyword) {
+      return false;
+    }
+    m_pos += word.size();
+    return true;
+  }
+
+  bool accept(const char * token)
+  {
+    skip_space();
+    size_t n = strlen(token);
+    if (m_expression.compare(m_pos, n, token) != 0) {
+      return false;
+    }
+    m_pos += n;
+    return true;
+  }
+
+  size_t add_node(NodeKind kind, size_t left, size_t right)
+  {
+    Node node {};
+    node.kind = kind;
+    node.left = left;
+    node.right = right;
+    m_filter.m_nodes.push_back(node);
+    return m_filter.m_nodes.size() - 1;
+  }
+
+  size_t parse_or()
+  {
+    size_t left = parse_and();
+    while (accept_keyword("OR")) {
+      left = add_node(NodeKind::OR, left, parse_and());
+    }
+    return left;
+  }
+
+  size_t parse_and()
+  {
+    size_t left = parse_condition();
+    while (accept_keyword("AND")) {
+      left = add_node(NodeKind::AND, left, parse_condition());
+    }
+    return left;
+  }
+
+  size_t parse_condition()
+  {
+    if (accept_keyword("NOT")) {
+      return add_node(NodeKind::NOT, parse_condition(), 0);
+    }
+    if (accept("(")) {
+      size_t inner = parse_or();
+      if (!accept(")")) {
+        fail("missing \")\"");
+      }
+      return inner;
+    }
+    Operand lhs = parse_operand();
+    NodeKind kind;
+    if (accept("<>") || accept("!=")) {
+      kind = NodeKind::NE;
+    } else if (accept("<=")) {
+      kind = NodeKind::LE;
+    } else if (accept(">=")) {
+      kind = NodeKind::GE;
+    } else if (accept("=")) {
+      kind = NodeKind::EQ;
+    } else if (accept("<")) {
+      kind = NodeKind::LT;
+    } else if (accept(">")) {
+      kind = NodeKind::GT;
+    } else {
+      fail("expected a comparison at \"" + m_expression.substr(m_pos) + "\"");
+    }
+    Operand rhs = parse_operand();
+    check_comparable(lhs, rhs);
+    size_t index = add_node(kind, 0, 0);
+    m_filter.m_nodes[index].lhs = lhs;
+    m_filter.m_nodes[index].rhs = rhs;
+    return index;
+  }
+
+  Operand parse_operand()
+  {
+    skip_space();
+    if (m_pos >= m_expression.size()) {
+      fail("unexpected end");
+    }
+    char c = m_expression[m_pos];
+    if (c == '%') {
+      m_pos++;
+      size_t end = m_pos;
+      while (end < m_expression.size() &&
+        std::isdigit(static_cast<unsigned char>(m_expression[end])))
+      {
+        end++;
+      }
+      if (end == m_pos) {
+        fail("expected a parameter number after %");
+      }
+      size_t n = std::stoul(m_expression.substr(m_pos, end - m_pos));
+      m_pos = end;
+      if (n >= m_parameters.size()) {
+        fail("there is no parameter %" + std::to_string(n));
+      }
+      return literal_operand(parse_literal(m_parameters[n], "parameter %" + std::to_string(n)));
+    }
+    if (c == '\'' || c == '"') {
+      size_t end = m_expression.find(c, m_pos + 1);
+      if (end == std::string::npos) {
+        fail("unterminated string");
+      }
+      std::string text = m_expression.substr(m_pos, end + 1 - m_pos);
+      m_pos = end + 1;
+      return literal_operand(parse_literal(text, "the literal"));
+    }
+    if (c == '-' || c == '+' || std::isdigit(static_cast<unsigned char>(c))) {
+      size_t end = m_pos + 1;
+      while (end < m_expression.size() &&
+        (is_word_char(m_expression[end]) ||
+        ((m_expression[end] == '-' || m_expression[end] == '+') &&
+        (m_expression[end - 1] == 'e' || m_expression[end - 1] == 'E'))))
+      {
+        end++;
+      }
+      std::string text = m_expression.substr(m_pos, end - m_pos);
+      m_pos = end;
+      return literal_operand(parse_literal(text, "the literal"));
+    }
+    std::string word = peek_word();
+    if (word.empty()) {
+      fail("unexpected \"" + m_expression.substr(m_pos) + "\"");
+    }
+    m_pos += word.size();
+    if (to_upper(word) == "TRUE" || to_upper(word) == "FALSE") {
+      return literal_operand(parse_literal(word, "the literal"));
+    }
+    Operand operand {};
+    operand.is_field = true;
+    operand.field = add_field(word);
+    return operand;
+  }
+
+  static Operand literal_operand(const Value & value)
+  {
+    Operand operand {};
+    operand.is_field = false;
+    operand.literal = value;
+    return operand;
+  }
+
+  Value parse_literal(const std::string & text, const std::string & what)
+  {
+    Value value {};
+    size_t n = text.size();
+    if (n >= 2 && (text[0] == '\'' || text[0] == '"') && text[n - 1] == text[0]) {
+      m_filter.m_strings.push_back(text.substr(1, n - 2));
+      value.kind = ValueKind::STRING;
+      value.str = m_filter.m_strings.back().data();
+      value.len = m_filter.m_strings.back().size();
+      return value;
+    }
+    std::string upper = to_upper(text);
+    if (upper == "TRUE" || upper == "FALSE") {
+      value.kind = ValueKind::BOOL;
+      value.u = (upper == "TRUE") ? 1 : 0;
+      return value;
+    }
+    const char * begin = text.c_str();
+    char * end = nullptr;
+    bool is_float = text.find_first_of(".eE") != std::string::npos &&
+      text.compare(0, 2, "0x") != 0 && text.compare(0, 2, "0X") != 0;
+    errno = 0;
+    if (n == 0) {
+      /* not a number */
+    } else if (is_float) {
+      value.kind = ValueKind::FLOAT;
+      value.f = std::strtod(begin, &end);
+    } else if (text[0] == '-') {
+      value.kind = ValueKind::SIGNED;
+      value.i = std::strtoll(begin, &end, 0);
+    } else {
+      value.kind = ValueKind::UNSIGNED;
+      value.u = std::strtoull(begin, &end, 0);
+      if (value.u <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        value.kind = ValueKind::SIGNED;
+        value.i = static_cast<int64_t>(value.u);
+      }
+    }
+    if (n == 0 || end != begin + n || errno == ERANGE) {
+      fail(what + " is not a number, string or bool: \"" + text + "\"");
+    }
+    return value;
+  }
+
+  size_t add_field(const std::string & path)
+  {
+    Field field {};
+    const StructValueType * type = m_filter.m_type.get();
+    const AnyValueType * value_type = nullptr;
+    size_t start = 0;
+    while (true) {
+      size_t dot = path.find('.', start);
+      std::string name = path.substr(start, dot == std::string::npos ? dot : dot - start);
+      size_t i = 0;
+      while (i < type->n_members() && name != type->get_member(i)->name) {
+        i++;
+      }
+      if (i == type->n_members()) {
+        fail("the message has no member \"" + path.substr(0, dot) + "\"");
+      }
+      field.steps.push_back(i);
+      value_type = type->get_member(i)->value_type;
+      if (dot == std::string::npos) {
+        break;
+      }
+      if (value_type->e_value_type() != EValueType::StructValueType) {
+        fail("\"" + path.substr(0, dot) + "\" is not a message");
+      }
+      type = static_cast<const StructValueType *>(value_type);
+      start = dot + 1;
+    }
+    if (value_type->e_value_type() == EValueType::U8StringValueType) {
+      field.is_string = true;
+    } else if (value_type->e_value_type() == EValueType::PrimitiveValueType) {
+      field.type_kind = static_cast<const PrimitiveValueType *>(value_type)->type_kind();
+      if (field.type_kind == ROSIDL_TypeKind::LONG_DOUBLE) {
+        fail("long double members such as \"" + path + "\" are not supported");
+      }
+    } else {
+      fail("\"" + path + "\" is not a number, bool or string");
+    }
+
+    Cursor fixed {nullptr, std::numeric_limits<size_t>::max(), 0, false};
+    field.fixed_offset =
+      fixed.locate(m_filter.m_type.get(), field.steps) ? fixed.offset : NO_OFFSET;
+    m_filter.m_fields.push_back(field);
+    return m_filter.m_fields.size() - 1;
+  }
+
+  ValueKind kind_of(const Operand & operand) const
+  {
+    if (!operand.is_field) {
+      return operand.literal.kind;
+    }
+    const Field & field = m_filter.m_fields[operand.field];
+    if (field.is_string) {
+      return ValueKind::STRING;
+    }
+    switch (field.type_kind) {
+      case ROSIDL_TypeKind::FLOAT:
+      case ROSIDL_TypeKind::DOUBLE:
+        return ValueKind::FLOAT;
+      case ROSIDL_TypeKind::BOOLEAN:
+        return ValueKind::BOOL;
+      case ROSIDL_TypeKind::INT8:
+      case ROSIDL_TypeKind::INT16:
+      case ROSIDL_TypeKind::INT32:
+      case ROSIDL_TypeKind::INT64:
+        return ValueKind::SIGNED;
+      default:
+        return ValueKind::UNSIGNED;
+    }
+  }
+
+  void check_comparable(const Operand & lhs, const Operand & rhs) const
+  {
+    if (!lhs.is_field && !rhs.is_field) {
+      fail("a comparison must involve a member");
+    }
+    if ((kind_of(lhs) == ValueKind::STRING) != (kind_of(rhs) == ValueKind::STRING)) {
+      fail("strings can only be compared with strings");
+    }
+  }
+
+  ContentFilter & m_filter;
+  const std::string & m_expression;
+  const std::vector<std::string> & m_parameters;
+  size_t m_pos;
+};
+
+ContentFilter::ContentFilter(
+  std::unique_ptr<StructValueType> type, const std::string & expression,
+  const std::vector<std::string> & parameters)
+: m_type(std::move(type)), m_root(0)
+{
+  m_root = Parser(*this, expression, parameters).parse();
+}
+
+ContentFilter::~ContentFilter() = default;
+
+bool ContentFilter::read_operand(
+  const Operand & operand, const Cursor & message,
+  Value * value) const
+{
+  if (!operand.is_field) {
+    *value = operand.literal;
+    return true;
+  }
+  const Field & field = m_fields[operand.field];
+  Cursor cursor = message;
+  if (field.fixed_offset != NO_OFFSET) {
+    cursor.offset = field.fixed_offset;
+  } else if (!cursor.locate(m_type.get(), field.steps)) {
+    return false;
+  }
+
+  if (field.is_string) {
+    uint32_t count;
+    /* the count includes the terminating null character */
+    if (!cursor.read_count(&count) || count == 0 || count > cursor.size - cursor.offset) {
+      return false;
+    }
+    value->kind = ValueKind::STRING;
+    value->str = reinterpret_cast<const char *>(cursor.data + cursor.offset);
+    value->len = count - 1;
+    return true;
+  }
+
+  union
+  {
+    uint8_t u8; int8_t i8; uint16_t u16; int16_t i16; uint32_t u32; int32_t i32;
+    uint64_t u64; int64_t i64; float f; double d;
+  } raw;
+  if (!cursor.read(&raw, cdr_size_of_primitive(field.type_kind))) {
+    return false;
+  }
+  switch (field.type_kind) {
+    case ROSIDL_TypeKind::FLOAT:
+      value->kind = ValueKind::FLOAT;
+      value->f = raw.f;
+      break;
+    case ROSIDL_TypeKind::DOUBLE:
+      value->kind = ValueKind::FLOAT;
+      value->f = raw.d;
+      break;
+    case ROSIDL_TypeKind::BOOLEAN:
+      value->kind = ValueKind::BOOL;
+      value->u = raw.u8 != 0;
+      break;
+    case ROSIDL_TypeKind::INT8:
+      value->kind = ValueKind::SIGNED;
+      value->i = raw.i8;
+      break;
+    case ROSIDL_TypeKind::INT16:
+      value->kind = ValueKind::SIGNED;
+      value->i = raw.i16;
+      break;
+    case ROSIDL_TypeKind::INT32:
+      value->kind = ValueKind::SIGNED;
+      value->i = raw.i32;
+      break;
+    case ROSIDL_TypeKind::INT64:
+      value->kind = ValueKind::SIGNED;
+      value->i = raw.i64;
+      break;
+    case ROSIDL_TypeKind::UINT16:
+    case ROSIDL_TypeKind::WCHAR:
+      value->kind = ValueKind::UNSIGNED;
+      value->u = raw.u16;
+      break;
+    case ROSIDL_TypeKind::UINT32:
+      value->kind = ValueKind::UNSIGNED;
+      value->u = raw.u32;
+      break;
+    case ROSIDL_TypeKind::UINT64:
+      value->kind = ValueKind::UNSIGNED;
+      value->u = raw.u64;
+      break;
+    default:
+      value->kind = ValueKind::UNSIGNED;
+      value->u = raw.u8;
+      break;
+  }
+  return true;
+}
+
+namespace
+{
+
+/* <0, 0 or >0 like strcmp; NaN compares unequal to everything, including itself */
+int compare(const ContentFilter::Value & a, const ContentFilter::Value & b, bool * unordered)
+{
+  using Kind = ContentFilter::ValueKind;
+  *unordered = false;
+  if (a.kind == Kind::STRING) {
+    int c = memcmp(a.str, b.str, a.len < b.len ? a.len : b.len);
+    if (c != 0) {
+      return c;
+    }
+    return (a.len < b.len) ? -1 : (a.len > b.len);
+  }
+  if (a.kind == Kind::FLOAT || b.kind == Kind::FLOAT) {
+    auto as_double = [](const ContentFilter::Value & v) {
+        return v.kind == Kind::FLOAT ? v.f :
+               v.kind == Kind::SIGNED ? static_cast<double>(v.i) : static_cast<double>(v.u);
+      };
+    double x = as_double(a);
+    double y = as_double(b);
+    if (x != x || y != y) {
+      *unordered = true;
+      return 0;
+    }
+    return (x < y) ? -1 : (x > y);
+  }
+  /* integers and bools, which are unsigned */
+  if (a.kind == Kind::SIGNED && b.kind == Kind::SIGNED) {
+    return (a.i < b.i) ? -1 : (a.i > b.i);
+  }
+  if (a.kind == Kind::SIGNED && a.i < 0) {
+    return -1;
+  }
+  if (b.kind == Kind::SIGNED && b.i < 0) {
+    return 1;
+  }
+  uint64_t x = (a.kind == Kind::SIGNED) ? static_cast<uint64_t>(a.i) : a.u;
+  uint64_t y = (b.kind == Kind::SIGNED) ? static_cast<uint64_t>(b.i) : b.u;
+  return (x < y) ? -1 : (x > y);
+}
+
+}  // namespace
+
+bool ContentFilter::evaluate(const Node & node, const Cursor & message, bool * malformed) const
+{
+  switch (node.kind) {
+    case NodeKind::AND:
+      return evaluate(m_nodes[node.left], message, malformed) &&
+             evaluate(m_nodes[node.right], message, malformed);
+    case NodeKind::OR:
+      return evaluate(m_nodes[node.left], message, malformed) ||
+             evaluate(m_nodes[node.right], message, malformed);
+    case NodeKind::NOT:
+      return !evaluate(m_nodes[node.left], message, malformed);
+    default:
+      break;
+  }
+
+  Value lhs, rhs;
+  if (!read_operand(node.lhs, message, &lhs) || !read_operand(node.rhs, message, &rhs)) {
+    *malformed = true;
+    return false;
+  }
+  bool unordered;
+  int c = compare(lhs, rhs, &unordered);
+  switch (node.kind) {
+    case NodeKind::EQ:
+      return !unordered && c == 0;
+    case NodeKind::NE:
+      return unordered || c != 0;
+    case NodeKind::LT:
+      return !unordered && c < 0;
+    case NodeKind::LE:
+      return !unordered && c <= 0;
+    case NodeKind::GT:
+      return !unordered && c > 0;
+    case NodeKind::GE:
+      return !unordered && c >= 0;
+    default:
+      unreachable();
+  }
+}
+
+bool ContentFilter::accepts(const void * data, size_t size) const
+{
+  if (size < 4) {
+    return false;
+  }
+  auto header = static_cast<const uint8_t *>(data);
+  /* the second byte of the encapsulation identifier is 1 for little-endian CDR */
+  bool little_endian = (header[1] & 1) != 0;
+  Cursor message {
+    header + 4, size - 4, 0, little_endian != (native_endian() == endian::little)};
+  bool malformed = false;
+  bool accepted = evaluate(m_nodes[m_root], message, &malformed);
+  return accepted && !malformed;
+}
+
+}  // namespace rmw_cyclonedds_cpp
@@ -0,0 +1,123 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef CONTENT_FILTER_HPP_
+#define CONTENT_FILTER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TypeSupport2.hpp"
+
+namespace rmw_cyclonedds_cpp
+{
+
+/* A content filter expression compiled for one message type. It is evaluated on the CDR
+   serialization of a message, reading only the members it refers to, so that Cyclone can
+   drop samples before they are deserialized or even stored in the reader.
+
+   The expressions are the simple part of the DDS content filter grammar:
+
+     expression := condition, with AND binding more tightly than OR
+                 | expression AND expression
+                 | expression OR expression
+     condition  := operand op operand | NOT condition | '(' expression ')'
+     op         := '=' | '<>' | '!=' | '<' | '<=' | '>' | '>='
+     operand    := member | %n | integer | float | 'string' | TRUE | FALSE
+
+   A member is a field name, or a path through nested messages like "header.frame_id",
+   and must be a number, a bool or a string outside of any array or sequence. At least one
+   operand of a comparison must be a member. A parameter %n is replaced by the n-th
+   parameter, written like a literal. */
+class ContentFilter
+{
+public:
+  /* throws std::runtime_error with what is wrong with the expression */
+  ContentFilter(
+    std::unique_ptr<StructValueType> type, const std::string & expression,
+    const std::vector<std::string> & parameters);
+  ~ContentFilter();
+
+  /* data is a serialized message, including its encapsulation header; malformed ones are
+     not accepted */
+  bool accepts(const void * data, size_t size) const;
+
+  enum class ValueKind {SIGNED, UNSIGNED, FLOAT, BOOL, STRING};
+
+  struct Value
+  {
+    ValueKind kind;
+    int64_t i;
+    uint64_t u;
+    double f;
+    /* strings are not null-terminated */
+    const char * str;
+    size_t len;
+  };
+
+  /* a member an expression refers to */
+  struct Field
+  {
+    /* indices of the members on the way to it, starting from the message */
+    std::vector<size_t> steps;
+    ROSIDL_TypeKind type_kind;
+    bool is_string;
+    /* where it is in the serialized data, if that is the same for all messages, else
+       NO_OFFSET */
+    size_t fixed_offset;
+  };
+
+  struct Operand
+  {
+    bool is_field;
+    size_t field;
+    Value literal;
+  };
+
+  enum class NodeKind {AND, OR, NOT, EQ, NE, LT, LE, GT, GE};
+
+  struct Node
+  {
+    NodeKind kind;
+    /* the children of AND, OR and NOT */
+    size_t left;
+    size_t right;
+    /* the operands of a comparison */
+    Operand lhs;
+    Operand rhs;
+  };
+
+  static constexpr size_t NO_OFFSET = SIZE_MAX;
+
+private:
+  class Parser;
+  struct Cursor;
+
+  bool evaluate(const Node & node, const Cursor & message, bool * malformed) const;
+  bool read_operand(const Operand & operand, const Cursor & message, Value * value) const;
+
+  std::unique_ptr<StructValueType> m_type;
+  std::vector<Field> m_fields;
+  std::vector<Node> m_nodes;
+  /* storage of the string literals the nodes point into */
+  std::deque<std::string> m_strings;
+  size_t m_root;
+};
+
+}  // namespace rmw_cyclonedds_cpp
+
+#endif  // CONTENT_FILTER_HPP_
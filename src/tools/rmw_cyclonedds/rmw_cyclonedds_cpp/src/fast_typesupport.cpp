@@ -0,0 +1,96 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "rmw_cyclonedds_cpp/fast_typesupport.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#define RMW_CYCLONEDDS_HAS_DLOPEN 1
+#else
+#define RMW_CYCLONEDDS_HAS_DLOPEN 0
+#endif
+
+#include "rcutils/logging_macros.h"
+
+namespace rmw_cyclonedds_cpp
+{
+
+namespace
+{
+
+struct Registry
+{
+  std::mutex lock;
+  std::map<std::string, const FastTypeSupport *> types;
+};
+
+Registry & registry()
+{
+  /* registrations run from static initializers, so this must not depend on the order in
+     which those run */
+  static Registry r;
+  return r;
+}
+
+void load_libraries()
+{
+#if RMW_CYCLONEDDS_HAS_DLOPEN
+  const char * env = std::getenv("RMW_CYCLONEDDS_FAST_TYPESUPPORT");
+  std::istringstream names(env != nullptr ? env : "rmw_cyclonedds_fast_typesupport");
+  std::string name;
+  while (std::getline(names, name, ':')) {
+    if (name.empty()) {
+      continue;
+    }
+#ifdef __APPLE__
+    std::string file = "lib" + name + ".dylib";
+#else
+    std::string file = "lib" + name + ".so";
+#endif
+    /* never closed: the registrations point into it */
+    if (dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL) == nullptr) {
+      RCUTILS_LOG_DEBUG_NAMED(
+        "rmw_cyclonedds_cpp", "fast type support library %s not loaded: %s",
+        file.c_str(), dlerror());
+    }
+  }
+#endif
+}
+
+}  // namespace
+
+void register_fast_type_support(const char * type_name, const FastTypeSupport * ts)
+{
+  Registry & r = registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  r.types.emplace(type_name, ts);
+}
+
+const FastTypeSupport * find_fast_type_support(const std::string & type_name)
+{
+  static std::once_flag loaded;
+  std::call_once(loaded, load_libraries);
+
+  Registry & r = registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  auto it = r.types.find(type_name);
+  return (it != r.types.end()) ? it->second : nullptr;
+}
+
+}  // namespace rmw_cyclonedds_cpp
@@ -0,0 +1,273 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "graph_index.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+#include "rcutils/strdup.h"
+#include "rcutils/types/string_array.h"
+#include "rmw/error_handling.h"
+#include "rmw/topic_endpoint_info.h"
+
+namespace rmw_cyclonedds_cpp
+{
+
+namespace
+{
+
+/* The list into names_and_types, which must be zero initialized, as GraphCache fills it:
+   left empty if there are no topics */
+template<typename NamesAndTypes>
+rmw_ret_t copy_names_and_types(
+  const NamesAndTypes & list, rcutils_allocator_t * allocator,
+  rmw_names_and_types_t * names_and_types)
+{
+  if (list.empty()) {
+    return RMW_RET_OK;
+  }
+  rmw_ret_t ret = rmw_names_and_types_init(names_and_types, list.size(), allocator);
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+  auto fail = [names_and_types]() {
+      static_cast<void>(rmw_names_and_types_fini(names_and_types));
+      RMW_SET_ERROR_MSG("failed to copy topic names and types");
+      return RMW_RET_BAD_ALLOC;
+    };
+  for (size_t i = 0; i < list.size(); i++) {
+    const auto & name_and_types = list[i];
+    names_and_types->names.data[i] = rcutils_strdup(name_and_types.first.c_str(), *allocator);
+    if (names_and_types->names.data[i] == nullptr) {
+      return fail();
+    }
+    rcutils_string_array_t & types = names_and_types->types[i];
+    if (rcutils_string_array_init(&types, name_and_types.second.size(), allocator) !=
+      RCUTILS_RET_OK)
+    {
+      return fail();
+    }
+    for (size_t j = 0; j < name_and_types.second.size(); j++) {
+      types.data[j] = rcutils_strdup(name_and_types.second[j].c_str(), *allocator);
+      if (types.data[j] == nullptr) {
+        return fail();
+      }
+    }
+  }
+  return RMW_RET_OK;
+}
+
+}  // namespace
+
+GraphIndex::GidKey GraphIndex::key_of(const rmw_gid_t & gid)
+{
+  GidKey key;
+  std::copy_n(gid.data, key.size(), key.begin());
+  return key;
+}
+
+void GraphIndex::add_entity(
+  const rmw_gid_t & gid, const std::string & topic_name, const std::string & type_name,
+  bool is_reader)
+{
+  std::unique_lock<std::shared_timed_mutex> lock(m_lock);
+  auto & endpoints = is_reader ? m_readers : m_writers;
+  if (!endpoints.emplace(key_of(gid), Endpoint{topic_name, type_name}).second) {
+    return;
+  }
+  Topic & topic = m_topics[topic_name];
+  (is_reader ? topic.readers : topic.writers)++;
+  if (topic.types[type_name]++ == 0) {
+    m_topics_generation.fetch_add(1, std::memory_order_release);
+  }
+}
+
+void GraphIndex::remove_entity(const rmw_gid_t & gid, bool is_reader)
+{
+  std::unique_lock<std::shared_timed_mutex> lock(m_lock);
+  auto & endpoints = is_reader ? m_readers : m_writers;
+  auto endpoint = endpoints.find(key_of(gid));
+  if (endpoint == endpoints.end()) {
+    return;
+  }
+  auto topic = m_topics.find(endpoint->second.topic_name);
+  (is_reader ? topic->second.readers : topic->second.writers)--;
+  auto type = topic->second.types.find(endpoint->second.type_name);
+  if (--type->second == 0) {
+    topic->second.types.erase(type);
+    if (topic->second.types.empty()) {
+      m_topics.erase(topic);
+    }
+    m_topics_generation.fetch_add(1, std::memory_order_release);
+  }
+  endpoints.erase(endpoint);
+}
+
+size_t GraphIndex::reader_count(const std::string & topic_name) const
+{
+  std::shared_lock<std::shared_timed_mutex> lock(m_lock);
+  auto topic = m_topics.find(topic_name);
+  return topic == m_topics.end() ? 0 : topic->second.readers;
+}
+
+size_t GraphIndex::writer_count(const std::string & topic_name) const
+{
+  std::shared_lock<std::shared_timed_mutex> lock(m_lock);
+  auto topic = m_topics.find(topic_name);
+  return topic == m_topics.end() ? 0 : topic->second.writers;
+}
+
+std::shared_ptr<const GraphIndex::NamesAndTypes> GraphIndex::names_and_types(
+  DemangleFunction demangle_topic, DemangleFunction demangle_type) const
+{
+  const uint64_t generation = m_topics_generation.load(std::memory_order_acquire);
+  {
+    std::lock_guard<std::mutex> lock(m_snapshots_lock);
+    for (const auto & snapshot : m_names_and_types) {
+      if (snapshot.demangle_topic == demangle_topic && snapshot.demangle_type == demangle_type &&
+        snapshot.generation == generation)
+      {
+        return snapshot.names_and_types;
+      }
+    }
+  }
+
+  /* sorted and without duplicates, as the graph cache gives them */
+  std::map<std::string, std::set<std::string>> topics;
+  uint64_t built_generation;
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(m_lock);
+    built_generation = m_topics_generation.load(std::memory_order_relaxed);
+    for (const auto & topic : m_topics) {
+      std::string name = demangle_topic(topic.first);
+      if (name.empty()) {
+        continue;
+      }
+      auto & types = topics[name];
+      for (const auto & type : topic.second.types) {
+        types.insert(demangle_type(type.first));
+      }
+    }
+  }
+  auto list = std::make_shared<NamesAndTypes>();
+  list->reserve(topics.size());
+  for (auto & topic : topics) {
+    list->emplace_back(topic.first, std::vector<std::string>(topic.second.begin(),
+      topic.second.end()));
+  }
+
+  std::lock_guard<std::mutex> lock(m_snapshots_lock);
+  auto snapshot = std::find_if(
+    m_names_and_types.begin(), m_names_and_types.end(),
+    [&](const NamesAndTypesSnapshot & s) {
+      return s.demangle_topic == demangle_topic && s.demangle_type == demangle_type;
+    });
+  if (snapshot == m_names_and_types.end()) {
+    m_names_and_types.push_back({demangle_topic, demangle_type, built_generation, list});
+  } else if (snapshot->generation <= built_generation) {
+    snapshot->generation = built_generation;
+    snapshot->names_and_types = list;
+  }
+  return list;
+}
+
+rmw_ret_t GraphIndex::get_names_and_types(
+  DemangleFunction demangle_topic, DemangleFunction demangle_type,
+  rcutils_allocator_t * allocator, rmw_names_and_types_t * names_and_types) const
+{
+  std::shared_ptr<const NamesAndTypes> list = this->names_and_types(demangle_topic, demangle_type);
+  return copy_names_and_types(*list, allocator, names_and_types);
+}
+
+rmw_ret_t GraphIndex::get_info_by_topic(
+  const std::string & topic_name, bool is_reader, DemangleFunction demangle_type,
+  rcutils_allocator_t * allocator, rmw_topic_endpoint_info_array_t * info,
+  const InfoQuery & query) const
+{
+  /* read before querying, so that a change during the query leaves the result stale
+     rather than labelled as current */
+  const uint64_t generation = m_graph_generation.load(std::memory_order_acquire);
+  std::shared_ptr<const std::vector<EndpointInfo>> cached;
+  {
+    std::lock_guard<std::mutex> lock(m_snapshots_lock);
+    for (const auto & snapshot : m_info) {
+      if (snapshot.generation == generation && snapshot.is_reader == is_reader &&
+        snapshot.demangle_type == demangle_type && snapshot.topic_name == topic_name)
+      {
+        cached = snapshot.info;
+        break;
+      }
+    }
+  }
+
+  if (!cached) {
+    rmw_ret_t ret = query(allocator, info);
+    if (ret != RMW_RET_OK) {
+      return ret;
+    }
+    auto copy = std::make_shared<std::vector<EndpointInfo>>(info->size);
+    for (size_t i = 0; i < info->size; i++) {
+      const rmw_topic_endpoint_info_t & src = info->info_array[i];
+      EndpointInfo & dst = (*copy)[i];
+      dst.node_name = src.node_name ? src.node_name : "";
+      dst.node_namespace = src.node_namespace ? src.node_namespace : "";
+      dst.topic_type = src.topic_type ? src.topic_type : "";
+      dst.endpoint_type = src.endpoint_type;
+      std::memcpy(dst.endpoint_gid, src.endpoint_gid, sizeof(dst.endpoint_gid));
+      dst.qos_profile = src.qos_profile;
+    }
+    std::lock_guard<std::mutex> lock(m_snapshots_lock);
+    /* only the topics queried since the last change are kept */
+    m_info.erase(
+      std::remove_if(
+        m_info.begin(), m_info.end(),
+        [&](const InfoSnapshot & s) {
+          return s.generation != generation || (s.is_reader == is_reader &&
+          s.demangle_type == demangle_type && s.topic_name == topic_name);
+        }), m_info.end());
+    m_info.push_back({topic_name, is_reader, demangle_type, generation, std::move(copy)});
+    return RMW_RET_OK;
+  }
+
+  if (cached->empty()) {
+    return RMW_RET_OK;
+  }
+  rmw_ret_t ret = rmw_topic_endpoint_info_array_init_with_size(info, cached->size(), allocator);
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+  for (size_t i = 0; i < cached->size(); i++) {
+    const EndpointInfo & src = (*cached)[i];
+    rmw_topic_endpoint_info_t & dst = info->info_array[i];
+    dst = rmw_get_zero_initialized_topic_endpoint_info();
+    if ((ret = rmw_topic_endpoint_info_set_node_name(&dst, src.node_name.c_str(), allocator)) !=
+      RMW_RET_OK ||
+      (ret = rmw_topic_endpoint_info_set_node_namespace(
+        &dst, src.node_namespace.c_str(), allocator)) != RMW_RET_OK ||
+      (ret = rmw_topic_endpoint_info_set_topic_type(&dst, src.topic_type.c_str(), allocator)) !=
+      RMW_RET_OK ||
+      (ret = rmw_topic_endpoint_info_set_endpoint_type(&dst, src.endpoint_type)) != RMW_RET_OK ||
+      (ret = rmw_topic_endpoint_info_set_gid(&dst, src.endpoint_gid, RMW_GID_STORAGE_SIZE)) !=
+      RMW_RET_OK ||
+      (ret = rmw_topic_endpoint_info_set_qos_profile(&dst, &src.qos_profile)) != RMW_RET_OK)
+    {
+      static_cast<void>(rmw_topic_endpoint_info_array_fini(info, allocator));
+      return ret;
+    }
+  }
+  return RMW_RET_OK;
+}
+
+}  // namespace rmw_cyclonedds_cpp
@@ -0,0 +1,153 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef GRAPH_INDEX_HPP_
+#define GRAPH_INDEX_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rcutils/allocator.h"
+#include "rmw/names_and_types.h"
+#include "rmw/topic_endpoint_info_array.h"
+#include "rmw/types.h"
+
+#include "demangle.hpp"
+
+namespace rmw_cyclonedds_cpp
+{
+
+/* The graph queries introspection tools make all the time, answered without walking the
+   graph cache. rmw_dds_common's GraphCache keeps every entity in one map under one mutex,
+   so counting a topic's publishers or listing the topics visits all of them, and holds
+   up the discovery thread while it does. This index follows the same endpoints per topic
+   as the discovery thread adds and removes them, so counts are a lookup, and keeps the
+   lists of topic names and types, and each queried topic's endpoint info, built once per
+   change and copied out from then on. Safe to use from any thread. */
+class GraphIndex
+{
+public:
+  GraphIndex() = default;
+  GraphIndex(const GraphIndex &) = delete;
+  GraphIndex & operator=(const GraphIndex &) = delete;
+
+  /* To be called alongside GraphCache::add_entity and remove_entity, with the same
+     arguments, so that the index has the same endpoints. Adding an endpoint that is
+     already there, or removing one that isn't, does nothing, as in the graph cache. */
+  void add_entity(
+    const rmw_gid_t & gid, const std::string & topic_name, const std::string & type_name,
+    bool is_reader);
+  void remove_entity(const rmw_gid_t & gid, bool is_reader);
+
+  /* To be called on every change of the graph cache (its on_change callback), to
+     invalidate the endpoint info kept by get_info_by_topic */
+  void graph_changed() {m_graph_generation.fetch_add(1, std::memory_order_acq_rel);}
+
+  /* As GraphCache::get_reader_count and get_writer_count, for a mangled topic name */
+  size_t reader_count(const std::string & topic_name) const;
+  size_t writer_count(const std::string & topic_name) const;
+
+  /* As GraphCache::get_names_and_types. A list is built on the first query with a pair
+     of demangling functions after a topic or type appears or disappears. */
+  rmw_ret_t get_names_and_types(
+    DemangleFunction demangle_topic, DemangleFunction demangle_type,
+    rcutils_allocator_t * allocator, rmw_names_and_types_t * names_and_types) const;
+
+  /* The topic's readers' or writers' info as query, one of GraphCache's
+     get_readers_info_by_topic and get_writers_info_by_topic, gives it, queried only once
+     between changes of the graph for the same topic, kind and demangle_type */
+  using InfoQuery = std::function<rmw_ret_t(rcutils_allocator_t *,
+      rmw_topic_endpoint_info_array_t *)>;
+  rmw_ret_t get_info_by_topic(
+    const std::string & topic_name, bool is_reader, DemangleFunction demangle_type,
+    rcutils_allocator_t * allocator, rmw_topic_endpoint_info_array_t * info,
+    const InfoQuery & query) const;
+
+private:
+  using GidKey = std::array<uint8_t, RMW_GID_STORAGE_SIZE>;
+  using NamesAndTypes = std::vector<std::pair<std::string, std::vector<std::string>>>;
+
+  struct Endpoint
+  {
+    std::string topic_name;
+    std::string type_name;
+  };
+
+  struct Topic
+  {
+    size_t readers = 0;
+    size_t writers = 0;
+    /* endpoints of each type, readers and writers both */
+    std::map<std::string, size_t> types;
+  };
+
+  struct NamesAndTypesSnapshot
+  {
+    DemangleFunction demangle_topic;
+    DemangleFunction demangle_type;
+    uint64_t generation;
+    std::shared_ptr<const NamesAndTypes> names_and_types;
+  };
+
+  struct EndpointInfo
+  {
+    std::string node_name;
+    std::string node_namespace;
+    std::string topic_type;
+    rmw_endpoint_type_t endpoint_type;
+    uint8_t endpoint_gid[RMW_GID_STORAGE_SIZE];
+    rmw_qos_profile_t qos_profile;
+  };
+
+  struct InfoSnapshot
+  {
+    std::string topic_name;
+    bool is_reader;
+    DemangleFunction demangle_type;
+    uint64_t generation;
+    std::shared_ptr<const std::vector<EndpointInfo>> info;
+  };
+
+  static GidKey key_of(const rmw_gid_t & gid);
+  std::shared_ptr<const NamesAndTypes> names_and_types(
+    DemangleFunction demangle_topic, DemangleFunction demangle_type) const;
+
+  mutable std::shared_timed_mutex m_lock;
+  std::map<GidKey, Endpoint> m_readers;
+  std::map<GidKey, Endpoint> m_writers;
+  std::unordered_map<std::string, Topic> m_topics;
+  /* bumped when a topic or one of its types appears or disappears, under m_lock */
+  std::atomic<uint64_t> m_topics_generation{0};
+
+  std::atomic<uint64_t> m_graph_generation{0};
+
+  /* the snapshots, taken under m_snapshots_lock and copied out after releasing it */
+  mutable std::mutex m_snapshots_lock;
+  mutable std::vector<NamesAndTypesSnapshot> m_names_and_types;
+  mutable std::vector<InfoSnapshot> m_info;
+};
+
+}  // namespace rmw_cyclonedds_cpp
+
+#endif  // GRAPH_INDEX_HPP_
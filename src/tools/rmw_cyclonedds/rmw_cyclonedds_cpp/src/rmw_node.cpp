@@ -13,8 +13,11 @@
 // limitations under the License.
 
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <mutex>
+#include <new>
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
@@ -61,6 +64,11 @@
 #include "TypeSupport2.hpp"
 
 #include "rmw_cyclonedds_cpp/rmw_version_test.hpp"
+#include "rmw_cyclonedds_cpp/loaned_serialized_message.h"
+#include "rmw_cyclonedds_cpp/publisher_payload.h"
+#include "rmw_cyclonedds_cpp/subscription_payload.h"
+#include "rmw_cyclonedds_cpp/transport_statistics.h"
+#include "rmw_cyclonedds_cpp/wait_set_fd.h"
 #include "rmw_cyclonedds_cpp/MessageTypeSupport.hpp"
 #include "rmw_cyclonedds_cpp/ServiceTypeSupport.hpp"
 
@@ -77,10 +85,16 @@
 #include "namespace_prefix.hpp"
 
 #include "dds/dds.h"
+#include "dds/ddsc/dds_statistics.h"
 #include "dds/ddsi/ddsi_sertopic.h"
 #include "rmw_cyclonedds_cpp/serdes.hpp"
 #include "serdata.hpp"
+#include "shm_transport.hpp"
+#include "async_publisher.hpp"
+#include "content_filter.hpp"
 #include "demangle.hpp"
+#include "graph_index.hpp"
+#include "wait_set_fd.hpp"
 
 using namespace std::literals::chrono_literals;
 
@@ -274,6 +288,19 @@ struct rmw_context_impl_t
      (protected by initialization_mutex) */
   uint32_t client_service_id;
 
+  /* the ROS publishers and subscriptions, for rmw_cyclonedds_cpp_get_transport_statistics */
+  std::mutex endpoints_lock;
+  std::unordered_set<const rmw_publisher_t *> publishers;
+  std::unordered_set<const rmw_subscription_t *> subscriptions;
+
+  /* the last ros_discovery_info applied to the graph cache for each remote participant
+     (only accessed by the discovery thread) */
+  std::map<decltype(rmw_dds_common::msg::Gid::data), ParticipantEntitiesInfo> remote_entities_info;
+
+  /* the graph cache's endpoints per topic, for counting them and listing the topics
+     without walking the graph cache */
+  rmw_cyclonedds_cpp::GraphIndex graph_index;
+
   rmw_context_impl_t()
   : common(), domain_id(UINT32_MAX), ppant(0), client_service_id(0)
   {
@@ -317,14 +344,68 @@ struct CddsPublisher : CddsEntity
   dds_instance_handle_t pubiid;
   rmw_gid_t gid;
   struct ddsi_sertopic * sertopic;
+
+  /* introspection type support of the messages, if they can be loaned: trivially serialized
+     ones are built in place in a serdata, others are held by one as they are, and either
+     way they are written without serializing them */
+  const rosidl_message_type_support_t * loan_type_support;
+  std::mutex loans_lock;
+  std::unordered_map<void *, serdata_rmw *> loans;
+
+  /* ring for same-host readers, if the data path is enabled for this publisher; it is only
+     used while every matched reader can take from it, see shm_readers_are_local */
+  std::unique_ptr<rmw_cyclonedds_cpp::ShmWriter> shm;
+
+  /* writer thread, if the publisher is asynchronous; it refers to the writer, so it must be
+     stopped before that is deleted */
+  std::unique_ptr<rmw_cyclonedds_cpp::AsyncWriter> async;
+  std::atomic<bool> async_write_failed{false};
+
+  /* what the matched readers have in common, see check_matched_readers */
+  std::mutex matches_lock;
+  bool matches_checked;
+  bool readers_shm_local;
+  bool readers_in_process;
 };
 
+static bool shm_readers_are_local(CddsPublisher * pub);
+static bool readers_are_in_process(CddsPublisher * pub);
+
 struct CddsSubscription : CddsEntity
 {
   rmw_gid_t gid;
   dds_entity_t rdcondh;
+
+  /* scratch space of rmw_take_sequence, grown to the largest count it has been asked for,
+     so that burst takes don't allocate */
+  std::mutex take_seq_lock;
+  std::vector<struct ddsi_serdata *> take_seq_samples;
+  std::vector<dds_sample_info_t> take_seq_infos;
+
+  /* evaluated by Cyclone on the received samples for as long as the reader exists */
+  std::unique_ptr<rmw_cyclonedds_cpp::ContentFilter> content_filter;
+
+  /* what has been taken, for rmw_cyclonedds_cpp_get_transport_statistics */
+  std::atomic<uint64_t> taken_samples{0};
+  std::atomic<uint64_t> taken_bytes{0};
+  std::atomic<uint64_t> taken_latency_ns{0};
+
+  /* event fds of the wait sets the reader is attached to, signalled by a data available
+     listener set when it is first attached to one (see watch_reader) */
+  rmw_cyclonedds_cpp::ReadyFds ready_fds;
+  std::once_flag ready_listener_once;
 };
 
+static void count_taken(CddsSubscription * sub, size_t size, const dds_sample_info_t & info)
+{
+  dds_time_t latency = dds_time() - info.source_timestamp;
+  sub->taken_samples.fetch_add(1, std::memory_order_relaxed);
+  sub->taken_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (latency > 0) {
+    sub->taken_latency_ns.fetch_add(static_cast<uint64_t>(latency), std::memory_order_relaxed);
+  }
+}
+
 struct client_service_id_t
 {
   // strangely, the writer_guid in an rmw_request_id_t is smaller than the identifier in
@@ -358,6 +439,10 @@ struct CddsService
 struct CddsGuardCondition
 {
   dds_entity_t gcondh;
+
+  /* event fds of the wait sets the guard condition is attached to, signalled when it is
+     triggered */
+  rmw_cyclonedds_cpp::ReadyFds ready_fds;
 };
 
 struct CddsEvent : CddsEntity
@@ -379,9 +464,13 @@ struct CddsWaitset
   std::vector<CddsClient *> cls;
   std::vector<CddsService *> srvs;
   std::vector<CddsEvent> evs;
+
+  /* from rmw_cyclonedds_cpp_get_wait_set_fd, or -1; only changed while not in use */
+  int event_fd;
 };
 
 static void clean_waitset_caches();
+static void waitset_detach(CddsWaitset * ws);
 #if REPORT_BLOCKED_REQUESTS
 static void check_for_blocked_requests(CddsClient & client);
 #endif
@@ -551,11 +640,25 @@ static void handle_ParticipantEntitiesInfo(dds_entity_t reader, void * arg)
 {
   static_cast<void>(reader);
   rmw_context_impl_t * impl = static_cast<rmw_context_impl_t *>(arg);
+  // Every message holds the complete set of entities of its participant, so of all
+  // the messages from a participant waiting here only the latest matters.  When many
+  // nodes start at once, there are lots of them, and each update of the graph cache
+  // wakes up all graph listeners, so apply them only once and only if they change
+  // something.
+  std::map<decltype(rmw_dds_common::msg::Gid::data), ParticipantEntitiesInfo> latest;
   ParticipantEntitiesInfo msg;
   bool taken;
   while (rmw_take(impl->common.sub, &msg, &taken, nullptr) == RMW_RET_OK && taken) {
     // locally published data is filtered because of the subscription QoS
-    impl->common.graph_cache.update_participant_entities(msg);
+    latest[msg.gid.data] = std::move(msg);
+  }
+  for (auto & kv : latest) {
+    auto applied = impl->remote_entities_info.find(kv.first);
+    if (applied != impl->remote_entities_info.end() && applied->second == kv.second) {
+      continue;
+    }
+    impl->common.graph_cache.update_participant_entities(kv.second);
+    impl->remote_entities_info[kv.first] = std::move(kv.second);
   }
 }
 
@@ -572,6 +675,9 @@ static void handle_DCPSParticipant(dds_entity_t reader, void * arg)
       // ignore the local participant
     } else if (si.instance_state != DDS_ALIVE_INSTANCE_STATE) {
       impl->common.graph_cache.remove_participant(gid);
+      decltype(rmw_dds_common::msg::Gid::data) key;
+      std::copy_n(gid.data, key.size(), key.begin());
+      impl->remote_entities_info.erase(key);
     } else if (si.valid_data) {
       std::string enclave;
       if (get_user_data_key(s->qos, "enclave", enclave)) {
@@ -594,15 +700,19 @@ static void handle_builtintopic_endpoint(
     convert_guid_to_gid(s->key, gid);
     if (si.instance_state != DDS_ALIVE_INSTANCE_STATE) {
       impl->common.graph_cache.remove_entity(gid, is_reader);
+      impl->graph_index.remove_entity(gid, is_reader);
     } else if (si.valid_data && strncmp(s->topic_name, "DCPS", 4) != 0) {
       rmw_qos_profile_t qos_profile = rmw_qos_profile_unknown;
       rmw_gid_t ppgid;
       dds_qos_to_rmw_qos(s->qos, &qos_profile);
       convert_guid_to_gid(s->participant_key, ppgid);
+      std::string topic_name(s->topic_name);
+      std::string type_name(s->type_name);
+      impl->graph_index.add_entity(gid, topic_name, type_name, is_reader);
       impl->common.graph_cache.add_entity(
         gid,
-        std::string(s->topic_name),
-        std::string(s->type_name),
+        topic_name,
+        type_name,
         ppgid,
         qos_profile,
         is_reader);
@@ -1058,7 +1168,8 @@ rmw_context_impl_t::init(rmw_init_options_t * options)
   }
 
   this->common.graph_cache.set_on_change_callback(
-    [guard_condition = this->common.graph_guard_condition]() {
+    [guard_condition = this->common.graph_guard_condition, index = &this->graph_index]() {
+      index->graph_changed();
       rmw_ret_t ret = rmw_trigger_guard_condition(guard_condition);
       if (ret != RMW_RET_OK) {
         RMW_SET_ERROR_MSG("graph cache on_change_callback failed to trigger guard condition");
@@ -1528,6 +1639,119 @@ void set_error_message_from_create_topic(dds_entity_t topic, const std::string &
 ///////////                                                                   ///////////
 /////////////////////////////////////////////////////////////////////////////////////////
 
+/* Serializes the message into the publisher's ring and writes a reference to it instead,
+   if the data path is enabled and it is worth it; returns false if the message is to be
+   written the usual way. */
+static bool publish_via_shm(CddsPublisher * pub, const void * ros_message, dds_return_t * ret)
+{
+  if (!pub->shm || !shm_readers_are_local(pub)) {
+    return false;
+  }
+  try {
+    auto topic = static_cast<const sertopic_rmw *>(pub->sertopic);
+    size_t size = get_serialized_size(topic, ros_message);
+    if (size < rmw_cyclonedds_cpp::shm_config().threshold) {
+      return false;
+    }
+    rmw_cyclonedds_cpp::ShmReference ref;
+    void * dest = pub->shm->reserve(size, &ref);
+    if (dest == nullptr) {
+      return false;
+    }
+    serialize_message(topic, dest, ros_message);
+    *ret = dds_writecdr(pub->enth, serdata_rmw_from_shm_reference(pub->sertopic, ref));
+    return true;
+  } catch (std::exception & e) {
+    RMW_SET_ERROR_MSG(e.what());
+    *ret = DDS_RETCODE_ERROR;
+    return true;
+  }
+}
+
+/* Writes a copy of the message instead of its serialized form if all matched readers are
+   in this process and the type has a generated copy, so that the readers with the same
+   sertopic get the copy without anything being serialized; returns false if the message is
+   to be written the usual way. */
+static bool publish_shared_copy(CddsPublisher * pub, const void * ros_message, dds_return_t * ret)
+{
+  auto topic = static_cast<const sertopic_rmw *>(pub->sertopic);
+  if (topic->fast_type_support == nullptr || !readers_are_in_process(pub)) {
+    return false;
+  }
+  struct ddsi_serdata * d = nullptr;
+  try {
+    d = serdata_rmw_from_message(
+      pub->sertopic, topic->fast_type_support->make_shared_copy(ros_message));
+  } catch (std::exception & e) {
+    RMW_SET_ERROR_MSG(e.what());
+  }
+  *ret = (d != nullptr) ? dds_writecdr(pub->enth, d) : DDS_RETCODE_ERROR;
+  return true;
+}
+
+/* Errors on a writer thread have no caller left to be returned to, so the first one of each
+   publisher is logged */
+static void report_async_write(CddsPublisher * pub, dds_return_t ret)
+{
+  if (ret < 0 && !pub->async_write_failed.exchange(true)) {
+    RCUTILS_LOG_ERROR_NAMED(
+      "rmw_cyclonedds_cpp", "failed to publish data asynchronously: %s "
+      "(later failures of this publisher are not logged)", dds_strretcode(ret));
+  }
+}
+
+/* Writes the copy rmw_publish made of a message, on the writer thread: the same way
+   rmw_publish writes the original, except that readers in this process can be given the
+   copy itself */
+static void write_async_copy(CddsPublisher * pub, const std::shared_ptr<void> & message)
+{
+  dds_return_t ret;
+  try {
+    if (readers_are_in_process(pub)) {
+      struct ddsi_serdata * d = serdata_rmw_from_message(pub->sertopic, message);
+      ret = (d != nullptr) ? dds_writecdr(pub->enth, d) : DDS_RETCODE_ERROR;
+    } else if (!publish_via_shm(pub, message.get(), &ret)) {
+      ret = dds_write(pub->enth, message.get());
+    }
+  } catch (std::exception &) {
+    ret = DDS_RETCODE_ERROR;
+  }
+  report_async_write(pub, ret);
+}
+
+/* Queues the message for the publisher's writer thread. A type with a generated copy is
+   copied, which costs little next to serializing it; any other is serialized here, or
+   written through shared memory if it goes that way, and only sent from the thread. */
+static rmw_ret_t publish_async(CddsPublisher * pub, const void * ros_message)
+{
+  auto topic = static_cast<const sertopic_rmw *>(pub->sertopic);
+  try {
+    if (topic->fast_type_support != nullptr) {
+      std::shared_ptr<void> copy = topic->fast_type_support->make_shared_copy(ros_message);
+      pub->async->push([pub, copy]() {write_async_copy(pub, copy);});
+      return RMW_RET_OK;
+    }
+    dds_return_t ret;
+    if (publish_via_shm(pub, ros_message, &ret)) {
+      return (ret >= 0) ? RMW_RET_OK : RMW_RET_ERROR;
+    }
+    struct ddsi_serdata * d = ddsi_serdata_from_sample(pub->sertopic, SDK_DATA, ros_message);
+    if (d == nullptr) {
+      RMW_SET_ERROR_MSG("failed to serialize message");
+      return RMW_RET_ERROR;
+    }
+    std::shared_ptr<struct ddsi_serdata> sample(d, ddsi_serdata_unref);
+    pub->async->push(
+      [pub, sample]() {
+        report_async_write(pub, dds_writecdr(pub->enth, ddsi_serdata_ref(sample.get())));
+      });
+    return RMW_RET_OK;
+  } catch (std::exception & e) {
+    RMW_SET_ERROR_MSG(e.what());
+    return RMW_RET_ERROR;
+  }
+}
+
 extern "C" rmw_ret_t rmw_publish(
   const rmw_publisher_t * publisher, const void * ros_message,
   rmw_publisher_allocation_t * allocation)
@@ -1544,7 +1768,16 @@ extern "C" rmw_ret_t rmw_publish(
     return RMW_RET_INVALID_ARGUMENT);
   auto pub = static_cast<CddsPublisher *>(publisher->data);
   assert(pub);
-  if (dds_write(pub->enth, ros_message) >= 0) {
+  if (pub->async) {
+    return publish_async(pub, ros_message);
+  }
+  dds_return_t ret;
+  if (!publish_shared_copy(pub, ros_message, &ret) &&
+    !publish_via_shm(pub, ros_message, &ret))
+  {
+    ret = dds_write(pub->enth, ros_message);
+  }
+  if (ret >= 0) {
     return RMW_RET_OK;
   } else {
     RMW_SET_ERROR_MSG("failed to publish data");
@@ -1567,23 +1800,76 @@ extern "C" rmw_ret_t rmw_publish_serialized_message(
     serialized_message, "serialized message handle is null",
     return RMW_RET_INVALID_ARGUMENT);
   auto pub = static_cast<CddsPublisher *>(publisher->data);
-  struct ddsi_serdata * d = serdata_rmw_from_serialized_message(
-    pub->sertopic, serialized_message->buffer, serialized_message->buffer_length);
+  struct ddsi_serdata * d = nullptr;
+  if (pub->shm && serialized_message->buffer_length >= rmw_cyclonedds_cpp::shm_config().threshold &&
+    shm_readers_are_local(pub))
+  {
+    rmw_cyclonedds_cpp::ShmReference ref;
+    void * dest = pub->shm->reserve(serialized_message->buffer_length, &ref);
+    if (dest != nullptr) {
+      memcpy(dest, serialized_message->buffer, serialized_message->buffer_length);
+      d = serdata_rmw_from_shm_reference(pub->sertopic, ref);
+    }
+  }
+  if (d == nullptr) {
+    d = serdata_rmw_from_serialized_message(
+      pub->sertopic, serialized_message->buffer, serialized_message->buffer_length);
+  }
   const bool ok = (dds_writecdr(pub->enth, d) >= 0);
   return ok ? RMW_RET_OK : RMW_RET_ERROR;
 }
 
+static serdata_rmw * take_loan(CddsPublisher * pub, void * ros_message)
+{
+  std::lock_guard<std::mutex> lock(pub->loans_lock);
+  auto it = pub->loans.find(ros_message);
+  if (it == pub->loans.end()) {
+    return nullptr;
+  }
+  serdata_rmw * d = it->second;
+  pub->loans.erase(it);
+  return d;
+}
+
 extern "C" rmw_ret_t rmw_publish_loaned_message(
   const rmw_publisher_t * publisher,
   void * ros_message,
   rmw_publisher_allocation_t * allocation)
 {
-  (void) publisher;
-  (void) ros_message;
-  (void) allocation;
-
-  RMW_SET_ERROR_MSG("rmw_publish_loaned_message not implemented for rmw_cyclonedds_cpp");
-  return RMW_RET_UNSUPPORTED;
+  static_cast<void>(allocation);
+  RMW_CHECK_FOR_NULL_WITH_MSG(
+    publisher, "publisher handle is null",
+    return RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher, publisher->implementation_identifier, eclipse_cyclonedds_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_FOR_NULL_WITH_MSG(
+    ros_message, "ros message handle is null",
+    return RMW_RET_INVALID_ARGUMENT);
+  if (!publisher->can_loan_messages) {
+    RMW_SET_ERROR_MSG("rmw_publish_loaned_message: publisher cannot loan messages");
+    return RMW_RET_UNSUPPORTED;
+  }
+  auto pub = static_cast<CddsPublisher *>(publisher->data);
+  serdata_rmw * d = take_loan(pub, ros_message);
+  if (d == nullptr) {
+    RMW_SET_ERROR_MSG("rmw_publish_loaned_message: message was not loaned by this publisher");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  /* the message is its own serialized form, or is held by the serdata, so there is nothing
+     left to do but hand the serdata to the writer, which drops the reference when it is done
+     with it; trivially serialized types have nothing for fini to release */
+  if (d->message()) {
+    try {
+      d->freeze_message();
+    } catch (std::exception & e) {
+      ddsi_serdata_unref(d);
+      RMW_SET_ERROR_MSG(e.what());
+      return RMW_RET_ERROR;
+    }
+  }
+  const bool ok = (dds_writecdr(pub->enth, d) >= 0);
+  return ok ? RMW_RET_OK : RMW_RET_ERROR;
 }
 
 static const rosidl_message_type_support_t * get_typesupport(
@@ -1915,6 +2201,35 @@ static CddsPublisher * create_cdds_publisher(
   }
   get_entity_gid(pub->enth, pub->gid);
   pub->sertopic = stact;
+  {
+    auto topic = static_cast<const sertopic_rmw *>(stact);
+    pub->loan_type_support =
+      (!topic->is_request_header &&
+      (topic->cdr_writer->is_trivially_serialized() || topic->fast_type_support != nullptr)) ?
+      type_support : nullptr;
+
+    /* late-joining readers are sent historical data, which the ring may long since have
+       overwritten, so transient-local publishers stay off it */
+    const auto & shm_config = rmw_cyclonedds_cpp::shm_config();
+    if (shm_config.enabled && !topic->is_request_header &&
+      qos_policies->durability != RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL)
+    {
+      std::ostringstream segment;
+      segment << "/rmw_cdds_" << std::hex << std::setfill('0');
+      for (size_t i = 0; i < sizeof(dds_guid_t); i++) {
+        segment << std::setw(2) << static_cast<unsigned>(pub->gid.data[i]);
+      }
+      pub->shm = rmw_cyclonedds_cpp::ShmWriter::create(segment.str(), shm_config.capacity);
+      if (!pub->shm) {
+        RCUTILS_LOG_WARN_NAMED(
+          "rmw_cyclonedds_cpp", "failed to create shared memory segment %s for topic %s",
+          segment.str().c_str(), topic_name);
+      }
+    }
+    pub->matches_checked = false;
+    pub->readers_shm_local = false;
+    pub->readers_in_process = false;
+  }
   dds_delete_qos(qos);
   dds_delete(topic);
   return pub;
@@ -1988,7 +2303,23 @@ static rmw_publisher_t * create_publisher(
   RET_ALLOC_X(rmw_publisher->topic_name, return nullptr);
   memcpy(const_cast<char *>(rmw_publisher->topic_name), topic_name, strlen(topic_name) + 1);
   rmw_publisher->options = *publisher_options;
-  rmw_publisher->can_loan_messages = false;
+  rmw_publisher->can_loan_messages = (pub->loan_type_support != nullptr);
+
+  {
+    const auto & async_config = rmw_cyclonedds_cpp::async_publish_config();
+    auto payload = static_cast<const rmw_cyclonedds_cpp_publisher_payload_t *>(
+      publisher_options->rmw_specific_publisher_payload);
+    if (payload != nullptr && (payload->implementation_identifier == nullptr ||
+      strcmp(payload->implementation_identifier, eclipse_cyclonedds_identifier) != 0))
+    {
+      payload = nullptr;
+    }
+    if ((payload != nullptr && payload->async_publish) || async_config.enabled_for(topic_name)) {
+      size_t depth = (payload != nullptr && payload->async_queue_depth > 0) ?
+        payload->async_queue_depth : async_config.depth;
+      pub->async = std::make_unique<rmw_cyclonedds_cpp::AsyncWriter>(depth);
+    }
+  }
 
   cleanup_rmw_publisher.cancel();
   cleanup_cdds_publisher.cancel();
@@ -2061,6 +2392,10 @@ extern "C" rmw_publisher_t * rmw_create_publisher(
     }
   }
 
+  {
+    std::lock_guard<std::mutex> guard(node->context->impl->endpoints_lock);
+    node->context->impl->publishers.insert(pub);
+  }
   cleanup_publisher.cancel();
   return pub;
 }
@@ -2154,27 +2489,143 @@ rmw_ret_t rmw_publisher_get_actual_qos(const rmw_publisher_t * publisher, rmw_qo
   return RMW_RET_ERROR;
 }
 
+/* loan_type_support is always one of the two introspection type supports get_typesupport
+   accepts */
+static void init_loaned_message(const rosidl_message_type_support_t * ts, void * ros_message)
+{
+  if (ts->typesupport_identifier == rosidl_typesupport_introspection_c__identifier) {
+    auto members =
+      static_cast<const rosidl_typesupport_introspection_c__MessageMembers *>(ts->data);
+    members->init_function(ros_message, ROSIDL_RUNTIME_C_MSG_INIT_ALL);
+  } else {
+    auto members =
+      static_cast<const rosidl_typesupport_introspection_cpp::MessageMembers *>(ts->data);
+    members->init_function(ros_message, rosidl_runtime_cpp::MessageInitialization::ALL);
+  }
+}
+
+static void fini_loaned_message(const rosidl_message_type_support_t * ts, void * ros_message);
+
+static size_t sizeof_loaned_message(const rosidl_message_type_support_t * ts)
+{
+  if (ts->typesupport_identifier == rosidl_typesupport_introspection_c__identifier) {
+    return static_cast<const rosidl_typesupport_introspection_c__MessageMembers *>(
+      ts->data)->size_of_;
+  } else {
+    return static_cast<const rosidl_typesupport_introspection_cpp::MessageMembers *>(
+      ts->data)->size_of_;
+  }
+}
+
+static void fini_loaned_message(const rosidl_message_type_support_t * ts, void * ros_message)
+{
+  if (ts->typesupport_identifier == rosidl_typesupport_introspection_c__identifier) {
+    auto members =
+      static_cast<const rosidl_typesupport_introspection_c__MessageMembers *>(ts->data);
+    members->fini_function(ros_message);
+  } else {
+    auto members =
+      static_cast<const rosidl_typesupport_introspection_cpp::MessageMembers *>(ts->data);
+    members->fini_function(ros_message);
+  }
+}
+
+/* a message of the type of ts, finalized and freed with the last reference to it */
+static std::shared_ptr<void> make_loaned_message(const rosidl_message_type_support_t * ts)
+{
+  void * message = rmw_allocate(sizeof_loaned_message(ts));
+  if (message == nullptr) {
+    throw std::bad_alloc();
+  }
+  try {
+    init_loaned_message(ts, message);
+  } catch (...) {
+    rmw_free(message);
+    throw;
+  }
+  return std::shared_ptr<void>(
+    message, [ts](void * m) {
+      fini_loaned_message(ts, m);
+      rmw_free(m);
+    });
+}
+
 extern "C" rmw_ret_t rmw_borrow_loaned_message(
   const rmw_publisher_t * publisher,
   const rosidl_message_type_support_t * type_support,
   void ** ros_message)
 {
-  (void) publisher;
-  (void) type_support;
-  (void) ros_message;
-  RMW_SET_ERROR_MSG("rmw_borrow_loaned_message not implemented for rmw_cyclonedds_cpp");
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_FOR_NULL_WITH_MSG(
+    publisher, "publisher handle is null",
+    return RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher, publisher->implementation_identifier, eclipse_cyclonedds_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(type_support, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(ros_message, RMW_RET_INVALID_ARGUMENT);
+  if (*ros_message != nullptr) {
+    RMW_SET_ERROR_MSG("rmw_borrow_loaned_message: ros message must be null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (!publisher->can_loan_messages) {
+    RMW_SET_ERROR_MSG("rmw_borrow_loaned_message: publisher cannot loan messages");
+    return RMW_RET_UNSUPPORTED;
+  }
+  auto pub = static_cast<CddsPublisher *>(publisher->data);
+  const rosidl_message_type_support_t * ts = pub->loan_type_support;
+  auto topic = static_cast<const sertopic_rmw *>(pub->sertopic);
+
+  auto d = serdata_rmw::create(pub->sertopic, SDK_DATA);
+  void * message;
+  if (topic->cdr_writer->is_trivially_serialized()) {
+    message = d->resize_for_loan(topic->cdr_writer->header_size(), sizeof_loaned_message(ts));
+    topic->cdr_writer->put_header(d->data());
+    init_loaned_message(ts, message);
+  } else {
+    try {
+      d->hold_message(make_loaned_message(ts));
+    } catch (std::exception & e) {
+      ddsi_serdata_unref(d);
+      RMW_SET_ERROR_MSG(e.what());
+      return RMW_RET_BAD_ALLOC;
+    }
+    message = d->message().get();
+  }
+
+  std::lock_guard<std::mutex> lock(pub->loans_lock);
+  pub->loans.emplace(message, d);
+  *ros_message = message;
+  return RMW_RET_OK;
 }
 
 extern "C" rmw_ret_t rmw_return_loaned_message_from_publisher(
   const rmw_publisher_t * publisher,
   void * loaned_message)
 {
-  (void) publisher;
-  (void) loaned_message;
-  RMW_SET_ERROR_MSG(
-    "rmw_return_loaned_message_from_publisher not implemented for rmw_cyclonedds_cpp");
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_FOR_NULL_WITH_MSG(
+    publisher, "publisher handle is null",
+    return RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher, publisher->implementation_identifier, eclipse_cyclonedds_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  if (!publisher->can_loan_messages) {
+    RMW_SET_ERROR_MSG("rmw_return_loaned_message_from_publisher: publisher cannot loan messages");
+    return RMW_RET_UNSUPPORTED;
+  }
+  auto pub = static_cast<CddsPublisher *>(publisher->data);
+  serdata_rmw * d = take_loan(pub, loaned_message);
+  if (d == nullptr) {
+    RMW_SET_ERROR_MSG(
+      "rmw_return_loaned_message_from_publisher: message was not loaned by this publisher");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  /* a held message is finalized with the serdata */
+  if (!d->message()) {
+    fini_loaned_message(pub->loan_type_support, loaned_message);
+  }
+  ddsi_serdata_unref(d);
+  return RMW_RET_OK;
 }
 
 static rmw_ret_t destroy_publisher(rmw_publisher_t * publisher)
@@ -2182,10 +2633,16 @@ static rmw_ret_t destroy_publisher(rmw_publisher_t * publisher)
   rmw_ret_t ret = RMW_RET_OK;
   auto pub = static_cast<CddsPublisher *>(publisher->data);
   if (pub != nullptr) {
+    /* sends what is still queued */
+    pub->async.reset();
     if (dds_delete(pub->enth) < 0) {
       RMW_SET_ERROR_MSG("failed to delete writer");
       ret = RMW_RET_ERROR;
     }
+    /* loans that were never published or returned */
+    for (auto & loan : pub->loans) {
+      ddsi_serdata_unref(loan.second);
+    }
     delete pub;
   }
   rmw_free(const_cast<char *>(publisher->topic_name));
@@ -2227,6 +2684,10 @@ extern "C" rmw_ret_t rmw_destroy_publisher(rmw_node_t * node, rmw_publisher_t *
     }
   }
 
+  {
+    std::lock_guard<std::mutex> guard(node->context->impl->endpoints_lock);
+    node->context->impl->publishers.erase(publisher);
+  }
   rmw_ret_t inner_ret = destroy_publisher(publisher);
   if (RMW_RET_OK != inner_ret) {
     if (RMW_RET_OK != ret) {
@@ -2253,16 +2714,78 @@ extern "C" rmw_ret_t rmw_destroy_publisher(rmw_node_t * node, rmw_publisher_t *
 ///////////                                                                   ///////////
 /////////////////////////////////////////////////////////////////////////////////////////
 
+#if DDS_HAS_TOPIC_SERDATA_FILTER
+static bool content_filter_accepts(const struct ddsi_serdata * dcmn, void * arg)
+{
+  auto filter = static_cast<const rmw_cyclonedds_cpp::ContentFilter *>(arg);
+  auto d = static_cast<const serdata_rmw *>(dcmn);
+  rmw_cyclonedds_cpp::ShmReference ref;
+  if (serdata_rmw_get_shm_reference(d, &ref)) {
+    bool accepted = false;
+    bool ok = rmw_cyclonedds_cpp::shm_read(
+      ref, [filter, &accepted](const void * data, size_t size) {
+        accepted = filter->accepts(data, size);
+        return true;
+      });
+    return ok && accepted;
+  }
+  return filter->accepts(d->data(), d->size());
+}
+#endif
+
+/* the content filter of the rmw-specific payload of the subscription options, if any */
+static bool make_content_filter(
+  const rosidl_message_type_support_t * type_supports,
+  const rmw_subscription_options_t * subscription_options,
+  std::unique_ptr<rmw_cyclonedds_cpp::ContentFilter> & filter)
+{
+  auto payload = static_cast<const rmw_cyclonedds_cpp_subscription_payload_t *>(
+    subscription_options->rmw_specific_subscription_payload);
+  if (payload == nullptr || payload->implementation_identifier == nullptr ||
+    strcmp(payload->implementation_identifier, eclipse_cyclonedds_identifier) != 0 ||
+    payload->content_filter_expression == nullptr)
+  {
+    return true;
+  }
+  if (payload->expression_parameters_size > 0 && payload->expression_parameters == nullptr) {
+    RMW_SET_ERROR_MSG("content filter expression parameters are null");
+    return false;
+  }
+#if DDS_HAS_TOPIC_SERDATA_FILTER
+  std::vector<std::string> parameters;
+  for (size_t i = 0; i < payload->expression_parameters_size; i++) {
+    RET_NULL_X(payload->expression_parameters[i], return false);
+    parameters.emplace_back(payload->expression_parameters[i]);
+  }
+  try {
+    filter = std::make_unique<rmw_cyclonedds_cpp::ContentFilter>(
+      rmw_cyclonedds_cpp::make_message_value_type(type_supports),
+      payload->content_filter_expression, parameters);
+  } catch (const std::runtime_error & e) {
+    RMW_SET_ERROR_MSG(e.what());
+    return false;
+  }
+  return true;
+#else
+  static_cast<void>(type_supports);
+  static_cast<void>(filter);
+  RMW_SET_ERROR_MSG("content filters require a Cyclone DDS with serialized sample filters");
+  return false;
+#endif
+}
+
 static CddsSubscription * create_cdds_subscription(
   dds_entity_t dds_ppant, dds_entity_t dds_sub,
   const rosidl_message_type_support_t * type_supports, const char * topic_name,
-  const rmw_qos_profile_t * qos_policies, bool ignore_local_publications)
+  const rmw_qos_profile_t * qos_policies, bool ignore_local_publications,
+  std::unique_ptr<rmw_cyclonedds_cpp::ContentFilter> content_filter)
 {
   RET_NULL_OR_EMPTYSTR_X(topic_name, return nullptr);
   RET_NULL_X(qos_policies, return nullptr);
   const rosidl_message_type_support_t * type_support = get_typesupport(type_supports);
   RET_NULL_X(type_support, return nullptr);
   CddsSubscription * sub = new CddsSubscription();
+  sub->content_filter = std::move(content_filter);
   dds_entity_t topic;
   dds_qos_t * qos;
 
@@ -2280,6 +2803,22 @@ static CddsSubscription * create_cdds_subscription(
   if ((qos = create_readwrite_qos(qos_policies, ignore_local_publications)) == nullptr) {
     goto fail_qos;
   }
+  if (rmw_cyclonedds_cpp::shm_config().enabled) {
+    // tells same-host publishers they can refer this reader to their shared memory
+    std::string user_data =
+      std::string("shmhost=") + rmw_cyclonedds_cpp::shm_host_id() + std::string(";");
+    dds_qset_userdata(qos, user_data.c_str(), user_data.size());
+  }
+#if DDS_HAS_TOPIC_SERDATA_FILTER
+  /* the filter is taken from the topic when the reader is created; the topic entity is this
+     subscription's own, so it affects no other reader */
+  if (sub->content_filter &&
+    dds_set_topic_serdata_filter(topic, content_filter_accepts, sub->content_filter.get()) < 0)
+  {
+    RMW_SET_ERROR_MSG("failed to set content filter");
+    goto fail_reader;
+  }
+#endif
   if ((sub->enth = dds_create_reader(dds_sub, topic, qos, nullptr)) < 0) {
     RMW_SET_ERROR_MSG("failed to create reader");
     goto fail_reader;
@@ -2305,6 +2844,27 @@ fail_topic:
   return nullptr;
 }
 
+extern "C" rmw_cyclonedds_cpp_publisher_payload_t
+rmw_cyclonedds_cpp_get_default_publisher_payload(void)
+{
+  rmw_cyclonedds_cpp_publisher_payload_t payload;
+  payload.implementation_identifier = eclipse_cyclonedds_identifier;
+  payload.async_publish = false;
+  payload.async_queue_depth = 0;
+  return payload;
+}
+
+extern "C" rmw_cyclonedds_cpp_subscription_payload_t
+rmw_cyclonedds_cpp_get_default_subscription_payload(void)
+{
+  rmw_cyclonedds_cpp_subscription_payload_t payload;
+  payload.implementation_identifier = eclipse_cyclonedds_identifier;
+  payload.content_filter_expression = nullptr;
+  payload.expression_parameters = nullptr;
+  payload.expression_parameters_size = 0;
+  return payload;
+}
+
 extern "C" rmw_ret_t rmw_init_subscription_allocation(
   const rosidl_message_type_support_t * type_support,
   const rosidl_runtime_c__Sequence__bound * message_bounds,
@@ -2332,10 +2892,14 @@ static rmw_subscription_t * create_subscription(
 {
   CddsSubscription * sub;
   rmw_subscription_t * rmw_subscription;
+  std::unique_ptr<rmw_cyclonedds_cpp::ContentFilter> content_filter;
+  if (!make_content_filter(type_supports, subscription_options, content_filter)) {
+    return nullptr;
+  }
   if (
     (sub = create_cdds_subscription(
       dds_ppant, dds_sub, type_supports, topic_name, qos_policies,
-      subscription_options->ignore_local_publications)) == nullptr)
+      subscription_options->ignore_local_publications, std::move(content_filter))) == nullptr)
   {
     return nullptr;
   }
@@ -2441,6 +3005,10 @@ extern "C" rmw_subscription_t * rmw_create_subscription(
     return nullptr;
   }
 
+  {
+    std::lock_guard<std::mutex> guard(node->context->impl->endpoints_lock);
+    node->context->impl->subscriptions.insert(sub);
+  }
   cleanup_subscription.cancel();
   return sub;
 }
@@ -2542,6 +3110,10 @@ extern "C" rmw_ret_t rmw_destroy_subscription(rmw_node_t * node, rmw_subscriptio
     }
   }
 
+  {
+    std::lock_guard<std::mutex> guard(node->context->impl->endpoints_lock);
+    node->context->impl->subscriptions.erase(subscription);
+  }
   rmw_ret_t local_ret = destroy_subscription(subscription);
   if (RMW_RET_OK != local_ret) {
     if (RMW_RET_OK != ret) {
@@ -2556,6 +3128,86 @@ extern "C" rmw_ret_t rmw_destroy_subscription(rmw_node_t * node, rmw_subscriptio
   return ret;
 }
 
+static uint64_t get_statistic(const struct dds_statistics * stat, const char * name)
+{
+  const struct dds_stat_keyvalue * kv = dds_lookup_statistic(stat, name);
+  if (kv == nullptr) {
+    return 0;
+  }
+  switch (kv->kind) {
+    case DDS_STAT_KIND_UINT32:
+      return kv->u.u32;
+    case DDS_STAT_KIND_UINT64:
+      return kv->u.u64;
+    case DDS_STAT_KIND_LENGTHTIME:
+      return kv->u.lengthtime;
+  }
+  return 0;
+}
+
+extern "C" rmw_ret_t rmw_cyclonedds_cpp_get_transport_statistics(
+  const rmw_context_t * context,
+  rmw_cyclonedds_cpp_transport_statistics_callback_t callback,
+  void * arg)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(context, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    context,
+    context->implementation_identifier,
+    eclipse_cyclonedds_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(context->impl, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(callback, RMW_RET_INVALID_ARGUMENT);
+
+  /* held throughout, so that the endpoints can't be destroyed while they are looked at */
+  std::lock_guard<std::mutex> guard(context->impl->endpoints_lock);
+  for (const rmw_publisher_t * publisher : context->impl->publishers) {
+    auto pub = static_cast<const CddsPublisher *>(publisher->data);
+    struct dds_statistics * stat = dds_create_statistics(pub->enth);
+    if (stat == nullptr) {
+      RMW_SET_ERROR_MSG("failed to get writer statistics");
+      return RMW_RET_ERROR;
+    }
+    rmw_cyclonedds_cpp_transport_statistics_t st;
+    memset(&st, 0, sizeof(st));
+    st.endpoint_type = RMW_ENDPOINT_PUBLISHER;
+    st.topic_name = publisher->topic_name;
+    st.gid = pub->gid;
+    st.samples = get_statistic(stat, "write_samples");
+    st.bytes = get_statistic(stat, "write_bytes");
+    st.retransmitted_samples = get_statistic(stat, "rexmit_count");
+    st.retransmitted_bytes = get_statistic(stat, "rexmit_bytes");
+    st.nacks_received = get_statistic(stat, "nacks_received");
+    st.unacknowledged_bytes = get_statistic(stat, "whc_unacked_bytes");
+    st.dropped_samples = pub->async ? pub->async->dropped() : 0;
+    dds_delete_statistics(stat);
+    callback(&st, arg);
+  }
+  for (const rmw_subscription_t * subscription : context->impl->subscriptions) {
+    auto sub = static_cast<const CddsSubscription *>(subscription->data);
+    struct dds_statistics * stat = dds_create_statistics(sub->enth);
+    dds_sample_lost_status_t lost;
+    if (stat == nullptr || dds_get_sample_lost_status(sub->enth, &lost) < 0) {
+      dds_delete_statistics(stat);
+      RMW_SET_ERROR_MSG("failed to get reader statistics");
+      return RMW_RET_ERROR;
+    }
+    rmw_cyclonedds_cpp_transport_statistics_t st;
+    memset(&st, 0, sizeof(st));
+    st.endpoint_type = RMW_ENDPOINT_SUBSCRIPTION;
+    st.topic_name = subscription->topic_name;
+    st.gid = sub->gid;
+    st.samples = sub->taken_samples.load(std::memory_order_relaxed);
+    st.bytes = sub->taken_bytes.load(std::memory_order_relaxed);
+    st.discarded_bytes = get_statistic(stat, "discarded_bytes");
+    st.lost_samples = lost.total_count;
+    st.total_latency_ns = sub->taken_latency_ns.load(std::memory_order_relaxed);
+    dds_delete_statistics(stat);
+    callback(&st, arg);
+  }
+  return RMW_RET_OK;
+}
+
 static rmw_ret_t rmw_take_int(
   const rmw_subscription_t * subscription, void * ros_message,
   bool * taken, rmw_message_info_t * message_info)
@@ -2576,8 +3228,25 @@ static rmw_ret_t rmw_take_int(
   CddsSubscription * sub = static_cast<CddsSubscription *>(subscription->data);
   RET_NULL(sub);
   dds_sample_info_t info;
-  while (dds_take(sub->enth, &ros_message, &info, 1, 1) == 1) {
+  struct ddsi_serdata * dcmn;
+  /* taking the serdata rather than the sample, to learn whether it could be deserialized:
+     a reference to shared memory that has since been overwritten is skipped as lost */
+  while (dds_takecdr(sub->enth, &dcmn, 1, &info, DDS_ANY_STATE) == 1) {
     if (info.valid_data) {
+      rmw_cyclonedds_cpp::ShmReference ref;
+      bool shm = serdata_rmw_get_shm_reference(static_cast<serdata_rmw *>(dcmn), &ref);
+      bool ok = ddsi_serdata_to_sample(dcmn, ros_message, nullptr, nullptr);
+      if (ok) {
+        count_taken(sub, ddsi_serdata_size(dcmn), info);
+      }
+      ddsi_serdata_unref(dcmn);
+      if (!ok) {
+        if (shm) {
+          continue;
+        }
+        *taken = false;
+        return RMW_RET_ERROR;
+      }
       *taken = true;
       if (message_info) {
         message_info->publisher_gid.implementation_identifier = eclipse_cyclonedds_identifier;
@@ -2599,6 +3268,7 @@ static rmw_ret_t rmw_take_int(
 #endif
       return RMW_RET_OK;
     }
+    ddsi_serdata_unref(dcmn);
   }
   *taken = false;
   return RMW_RET_OK;
@@ -2654,48 +3324,54 @@ static rmw_ret_t rmw_take_seq(
   CddsSubscription * sub = static_cast<CddsSubscription *>(subscription->data);
   RET_NULL(sub);
 
-  std::vector<dds_sample_info_t> infos(count);
+  /* the lock is only ever contended if the same subscription is taken from on several
+     threads at once, which needs a reentrant callback group */
+  std::lock_guard<std::mutex> guard(sub->take_seq_lock);
+  if (sub->take_seq_samples.size() < count) {
+    sub->take_seq_samples.resize(count);
+    sub->take_seq_infos.resize(count);
+  }
+  struct ddsi_serdata ** samples = sub->take_seq_samples.data();
+  dds_sample_info_t * infos = sub->take_seq_infos.data();
   auto maxsamples = static_cast<uint32_t>(count);
-  auto ret = dds_take(sub->enth, message_sequence->data, infos.data(), count, maxsamples);
+  auto ret = dds_takecdr(sub->enth, samples, maxsamples, infos, DDS_ANY_STATE);
 
   // Returning 0 should not be an error, as it just indicates that no messages were available.
   if (ret < 0) {
     return RMW_RET_ERROR;
   }
 
-  // Keep track of taken/not taken to reorder sequence with valid messages at the front
-  std::vector<void *> taken_msg;
-  std::vector<void *> not_taken_msg;
   *taken = 0u;
 
   for (int ii = 0; ii < ret; ++ii) {
     const dds_sample_info_t & info = infos[ii];
 
-    void * message = &message_sequence->data[ii];
-    rmw_message_info_t * message_info = &message_info_sequence->data[*taken];
-
-    if (info.valid_data) {
-      taken_msg.push_back(message);
-      (*taken)++;
-      if (message_info) {
-        message_info->publisher_gid.implementation_identifier = eclipse_cyclonedds_identifier;
-        memset(message_info->publisher_gid.data, 0, sizeof(message_info->publisher_gid.data));
-        assert(sizeof(info.publication_handle) <= sizeof(message_info->publisher_gid.data));
-        memcpy(
-          message_info->publisher_gid.data, &info.publication_handle,
-          sizeof(info.publication_handle));
-      }
-    } else {
-      not_taken_msg.push_back(message);
+    /* as in rmw_take_int, a sample that can't be deserialized, such as one that was
+       overwritten in shared memory, is not taken */
+    bool valid = info.valid_data &&
+      ddsi_serdata_to_sample(samples[ii], message_sequence->data[ii], nullptr, nullptr);
+    if (valid) {
+      count_taken(sub, ddsi_serdata_size(samples[ii]), info);
     }
-  }
+    ddsi_serdata_unref(samples[ii]);
 
-  for (size_t ii = 0; ii < taken_msg.size(); ++ii) {
-    message_sequence->data[ii] = taken_msg[ii];
-  }
+    if (!valid) {
+      continue;
+    }
 
-  for (size_t ii = 0; ii < not_taken_msg.size(); ++ii) {
-    message_sequence->data[ii + taken_msg.size()] = not_taken_msg[ii];
+    /* compact in place: swapping keeps every message of the caller in the sequence, with
+       the taken ones at the front in the order they were taken */
+    if (static_cast<size_t>(ii) != *taken) {
+      std::swap(message_sequence->data[*taken], message_sequence->data[ii]);
+    }
+    rmw_message_info_t * message_info = &message_info_sequence->data[*taken];
+    message_info->publisher_gid.implementation_identifier = eclipse_cyclonedds_identifier;
+    memset(message_info->publisher_gid.data, 0, sizeof(message_info->publisher_gid.data));
+    assert(sizeof(info.publication_handle) <= sizeof(message_info->publisher_gid.data));
+    memcpy(
+      message_info->publisher_gid.data, &info.publication_handle,
+      sizeof(info.publication_handle));
+    (*taken)++;
   }
 
   message_sequence->size = *taken;
@@ -2734,6 +3410,33 @@ static rmw_ret_t rmw_take_ser_int(
           sizeof(info.publication_handle));
       }
       auto d = static_cast<serdata_rmw *>(dcmn);
+      rmw_cyclonedds_cpp::ShmReference ref;
+      if (serdata_rmw_get_shm_reference(d, &ref)) {
+        bool resized = true;
+        bool ok = rmw_cyclonedds_cpp::shm_read(
+          ref, [serialized_message, &resized](const void * data, size_t size) {
+            if (rmw_serialized_message_resize(serialized_message, size) != RMW_RET_OK) {
+              resized = false;
+              return false;
+            }
+            memcpy(serialized_message->buffer, data, size);
+            serialized_message->buffer_length = size;
+            return true;
+          });
+        if (ok) {
+          count_taken(sub, serialized_message->buffer_length, info);
+        }
+        ddsi_serdata_unref(dcmn);
+        if (!resized) {
+          *taken = false;
+          return RMW_RET_ERROR;
+        }
+        if (!ok) {
+          continue;
+        }
+        *taken = true;
+        return RMW_RET_OK;
+      }
       /* FIXME: what about the header - should be included or not? */
       if (rmw_serialized_message_resize(serialized_message, d->size()) != RMW_RET_OK) {
         ddsi_serdata_unref(dcmn);
@@ -2742,6 +3445,7 @@ static rmw_ret_t rmw_take_ser_int(
       }
       memcpy(serialized_message->buffer, d->data(), d->size());
       serialized_message->buffer_length = d->size();
+      count_taken(sub, d->size(), info);
       ddsi_serdata_unref(dcmn);
       *taken = true;
       return RMW_RET_OK;
@@ -2752,6 +3456,178 @@ static rmw_ret_t rmw_take_ser_int(
   return RMW_RET_OK;
 }
 
+/* State of the allocator of a serialized message that is loaned from a serdata: it counts
+   the buffers allocated through it, the first being the serdata's own payload, so that it
+   outlives copies of the message made with the same allocator */
+struct SerializedMessageLoan
+{
+  std::atomic<uint32_t> refc;
+  /* reference to the serdata, until the payload is deallocated or reallocated */
+  struct ddsi_serdata * serdata;
+  void * payload;
+  size_t payload_size;
+};
+
+static void unref_serialized_message_loan(SerializedMessageLoan * loan)
+{
+  if (loan->refc.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete loan;
+  }
+}
+
+static void * loan_allocate(size_t size, void * state)
+{
+  auto loan = static_cast<SerializedMessageLoan *>(state);
+  void * ptr = malloc(size);
+  if (ptr != nullptr) {
+    loan->refc.fetch_add(1, std::memory_order_relaxed);
+  }
+  return ptr;
+}
+
+static void * loan_zero_allocate(size_t nmemb, size_t size, void * state)
+{
+  auto loan = static_cast<SerializedMessageLoan *>(state);
+  void * ptr = calloc(nmemb, size);
+  if (ptr != nullptr) {
+    loan->refc.fetch_add(1, std::memory_order_relaxed);
+  }
+  return ptr;
+}
+
+static void loan_deallocate(void * ptr, void * state)
+{
+  auto loan = static_cast<SerializedMessageLoan *>(state);
+  if (ptr == nullptr) {
+    return;
+  }
+  if (loan->serdata != nullptr && ptr == loan->payload) {
+    ddsi_serdata_unref(loan->serdata);
+    loan->serdata = nullptr;
+  } else {
+    free(ptr);
+  }
+  unref_serialized_message_loan(loan);
+}
+
+static void * loan_reallocate(void * ptr, size_t size, void * state)
+{
+  auto loan = static_cast<SerializedMessageLoan *>(state);
+  if (ptr == nullptr) {
+    return loan_allocate(size, state);
+  }
+  if (loan->serdata != nullptr && ptr == loan->payload) {
+    /* the serdata can't grow, and is not ours to modify: continue with a copy */
+    void * copy = malloc(size);
+    if (copy == nullptr) {
+      return nullptr;
+    }
+    memcpy(copy, loan->payload, std::min(size, loan->payload_size));
+    ddsi_serdata_unref(loan->serdata);
+    loan->serdata = nullptr;
+    return copy;
+  }
+  return realloc(ptr, size);
+}
+
+extern "C" rmw_ret_t rmw_cyclonedds_cpp_take_loaned_serialized_message(
+  const rmw_subscription_t * subscription,
+  rmw_serialized_message_t * serialized_message,
+  bool * taken,
+  rmw_message_info_t * message_info)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(
+    subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(
+    serialized_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(
+    taken, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    subscription handle,
+    subscription->implementation_identifier, eclipse_cyclonedds_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+  if (serialized_message->buffer != nullptr) {
+    RMW_SET_ERROR_MSG("serialized message must be zero initialized");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  CddsSubscription * sub = static_cast<CddsSubscription *>(subscription->data);
+  RET_NULL(sub);
+  dds_sample_info_t info;
+  struct ddsi_serdata * dcmn;
+  while (dds_takecdr(sub->enth, &dcmn, 1, &info, DDS_ANY_STATE) == 1) {
+    if (!info.valid_data) {
+      ddsi_serdata_unref(dcmn);
+      continue;
+    }
+    auto d = static_cast<serdata_rmw *>(dcmn);
+    rmw_cyclonedds_cpp::ShmReference ref;
+    if (serdata_rmw_get_shm_reference(d, &ref)) {
+      /* the ring is overwritten as the publisher goes on, so this has to be copied out */
+      ddsi_serdata_unref(dcmn);
+      rcutils_allocator_t allocator = rcutils_get_default_allocator();
+      if (rmw_serialized_message_init(serialized_message, 0, &allocator) != RMW_RET_OK) {
+        *taken = false;
+        return RMW_RET_BAD_ALLOC;
+      }
+      bool resized = true;
+      bool ok = rmw_cyclonedds_cpp::shm_read(
+        ref, [serialized_message, &resized](const void * data, size_t size) {
+          if (rmw_serialized_message_resize(serialized_message, size) != RMW_RET_OK) {
+            resized = false;
+            return false;
+          }
+          memcpy(serialized_message->buffer, data, size);
+          serialized_message->buffer_length = size;
+          return true;
+        });
+      if (!ok) {
+        rmw_ret_t fini_ret = rmw_serialized_message_fini(serialized_message);
+        static_cast<void>(fini_ret);
+        *serialized_message = rmw_get_zero_initialized_serialized_message();
+        if (!resized) {
+          *taken = false;
+          return RMW_RET_BAD_ALLOC;
+        }
+        continue;
+      }
+    } else {
+      auto loan = new (std::nothrow) SerializedMessageLoan;
+      if (loan == nullptr) {
+        ddsi_serdata_unref(dcmn);
+        *taken = false;
+        RMW_SET_ERROR_MSG("failed to allocate serialized message loan");
+        return RMW_RET_BAD_ALLOC;
+      }
+      /* the loan takes over the reference from dds_takecdr */
+      loan->refc.store(1, std::memory_order_relaxed);
+      loan->serdata = dcmn;
+      loan->payload = d->data();
+      loan->payload_size = d->size();
+      serialized_message->buffer = static_cast<uint8_t *>(d->data());
+      serialized_message->buffer_length = d->size();
+      serialized_message->buffer_capacity = d->size();
+      serialized_message->allocator.allocate = loan_allocate;
+      serialized_message->allocator.deallocate = loan_deallocate;
+      serialized_message->allocator.reallocate = loan_reallocate;
+      serialized_message->allocator.zero_allocate = loan_zero_allocate;
+      serialized_message->allocator.state = loan;
+    }
+    count_taken(sub, serialized_message->buffer_length, info);
+    if (message_info) {
+      message_info->publisher_gid.implementation_identifier = eclipse_cyclonedds_identifier;
+      memset(message_info->publisher_gid.data, 0, sizeof(message_info->publisher_gid.data));
+      assert(sizeof(info.publication_handle) <= sizeof(message_info->publisher_gid.data));
+      memcpy(
+        message_info->publisher_gid.data, &info.publication_handle,
+        sizeof(info.publication_handle));
+    }
+    *taken = true;
+    return RMW_RET_OK;
+  }
+  *taken = false;
+  return RMW_RET_OK;
+}
+
 extern "C" rmw_ret_t rmw_take(
   const rmw_subscription_t * subscription, void * ros_message,
   bool * taken, rmw_subscription_allocation_t * allocation)
@@ -3080,6 +3956,7 @@ extern "C" rmw_ret_t rmw_trigger_guard_condition(
   RET_WRONG_IMPLID(guard_condition_handle);
   auto * gcond_impl = static_cast<CddsGuardCondition *>(guard_condition_handle->data);
   dds_set_guardcondition(gcond_impl->gcondh, true);
+  gcond_impl->ready_fds.signal();
   return RMW_RET_OK;
 }
 
@@ -3103,6 +3980,7 @@ extern "C" rmw_wait_set_t * rmw_create_wait_set(rmw_context_t * context, size_t
   }
   ws->inuse = false;
   ws->nelems = 0;
+  ws->event_fd = -1;
 
   if ((ws->waitseth = dds_create_waitset(DDS_CYCLONEDDS_HANDLE)) < 0) {
     RMW_SET_ERROR_MSG("failed to create waitset");
@@ -3150,6 +4028,11 @@ extern "C" rmw_ret_t rmw_destroy_wait_set(rmw_wait_set_t * wait_set)
   auto result = RMW_RET_OK;
   auto ws = static_cast<CddsWaitset *>(wait_set->data);
   RET_NULL(ws);
+  if (ws->event_fd >= 0) {
+    // the attached entities must forget the fd before it is closed
+    waitset_detach(ws);
+    rmw_cyclonedds_cpp::close_event_fd(ws->event_fd);
+  }
   dds_delete(ws->waitseth);
   {
     std::lock_guard<std::mutex> lock(gcdds.lock);
@@ -3200,19 +4083,76 @@ static bool require_reattach(
   }
 }
 
+static void on_data_available_signal(dds_entity_t reader, void * arg)
+{
+  static_cast<void>(reader);
+  static_cast<const rmw_cyclonedds_cpp::ReadyFds *>(arg)->signal();
+}
+
+/* Has a reader signal a wait set's event fd when data arrives, setting its data available
+   listener the first time. With the listener, Cyclone no longer sets the DATA_AVAILABLE
+   status, so that status no longer triggers the reader's status condition (attached for
+   events), but it has to be enabled for the listener to be called. */
+static void watch_reader(CddsSubscription * sub, int fd)
+{
+  sub->ready_fds.add(fd);
+  std::call_once(
+    sub->ready_listener_once, [sub]() {
+      dds_listener_t * listener = dds_create_listener(&sub->ready_fds);
+      dds_lset_data_available(listener, on_data_available_signal);
+      uint32_t mask;
+      if (dds_set_listener(sub->enth, listener) < 0 ||
+        dds_get_status_mask(sub->enth, &mask) < 0 ||
+        dds_set_status_mask(sub->enth, mask | DDS_DATA_AVAILABLE_STATUS) < 0)
+      {
+        RCUTILS_LOG_ERROR_NAMED(
+          "rmw_cyclonedds_cpp", "failed to set the data available listener of a reader");
+      }
+      dds_delete_listener(listener);
+      // set before there was a listener, and now nothing would reset it
+      uint32_t status;
+      static_cast<void>(dds_take_status(sub->enth, &status, DDS_DATA_AVAILABLE_STATUS));
+    });
+}
+
+/* Whether watch_reader set the listener of an entity */
+static bool has_ready_listener(dds_entity_t entity)
+{
+  dds_listener_t * listener = dds_create_listener(nullptr);
+  dds_on_data_available_fn on_data_available = nullptr;
+  if (dds_get_listener(entity, listener) == DDS_RETCODE_OK) {
+    dds_lget_data_available(listener, &on_data_available);
+  }
+  dds_delete_listener(listener);
+  return on_data_available == on_data_available_signal;
+}
+
 static void waitset_detach(CddsWaitset * ws)
 {
+  const int fd = ws->event_fd;
   for (auto && x : ws->subs) {
     dds_waitset_detach(ws->waitseth, x->rdcondh);
+    if (fd >= 0) {
+      x->ready_fds.remove(fd);
+    }
   }
   for (auto && x : ws->gcs) {
     dds_waitset_detach(ws->waitseth, x->gcondh);
+    if (fd >= 0) {
+      x->ready_fds.remove(fd);
+    }
   }
   for (auto && x : ws->srvs) {
     dds_waitset_detach(ws->waitseth, x->service.sub->rdcondh);
+    if (fd >= 0) {
+      x->service.sub->ready_fds.remove(fd);
+    }
   }
   for (auto && x : ws->cls) {
     dds_waitset_detach(ws->waitseth, x->client.sub->rdcondh);
+    if (fd >= 0) {
+      x->client.sub->ready_fds.remove(fd);
+    }
   }
   ws->subs.resize(0);
   ws->gcs.resize(0);
@@ -3260,8 +4200,10 @@ static rmw_ret_t gather_event_entities(
     }
   }
   for (auto & pair : status_mask_map) {
-    // set the status condition's mask with the supported type
-    dds_set_status_mask(pair.first, pair.second);
+    // set the status condition's mask with the supported type, keeping DATA_AVAILABLE
+    // for the listener of watch_reader
+    const uint32_t data_available = has_ready_listener(pair.first) ? DDS_DATA_AVAILABLE_STATUS : 0;
+    dds_set_status_mask(pair.first, pair.second | data_available);
     entities.insert(pair.first);
   }
 
@@ -3310,6 +4252,11 @@ extern "C" rmw_ret_t rmw_wait(
     ws->inuse = true;
   }
 
+  // anything becoming ready from here on signals it again
+  if (ws->event_fd >= 0) {
+    rmw_cyclonedds_cpp::clear_event_fd(ws->event_fd);
+  }
+
   if (require_reattach(
       ws->subs, subs ? subs->subscriber_count : 0,
       subs ? subs->subscribers : nullptr) ||
@@ -3341,6 +4288,21 @@ extern "C" rmw_ret_t rmw_wait(
     ATTACH(CddsClient, cls, client, client.sub->rdcondh);
 #undef ATTACH
 
+    if (ws->event_fd >= 0) {
+      for (auto && x : ws->subs) {
+        watch_reader(x, ws->event_fd);
+      }
+      for (auto && x : ws->gcs) {
+        x->ready_fds.add(ws->event_fd);
+      }
+      for (auto && x : ws->srvs) {
+        watch_reader(x->service.sub, ws->event_fd);
+      }
+      for (auto && x : ws->cls) {
+        watch_reader(x->client.sub, ws->event_fd);
+      }
+    }
+
     ws->evs.resize(0);
     if (evs) {
       std::unordered_set<dds_entity_t> event_entities;
@@ -3412,6 +4374,11 @@ extern "C" rmw_ret_t rmw_wait(
   }
 #endif
 
+  // what the caller doesn't take now would not signal it again
+  if (ws->event_fd >= 0 && ws->trigs.size() > 1) {
+    rmw_cyclonedds_cpp::signal_event_fd(ws->event_fd);
+  }
+
   {
     std::lock_guard<std::mutex> lock(ws->lock);
     ws->inuse = false;
@@ -3420,6 +4387,37 @@ extern "C" rmw_ret_t rmw_wait(
   return (ws->trigs.size() == 1) ? RMW_RET_TIMEOUT : RMW_RET_OK;
 }
 
+extern "C" rmw_ret_t rmw_cyclonedds_cpp_get_wait_set_fd(rmw_wait_set_t * wait_set, int * fd)
+{
+  RET_NULL_X(wait_set, return RMW_RET_INVALID_ARGUMENT);
+  RET_WRONG_IMPLID(wait_set);
+  RET_NULL_X(fd, return RMW_RET_INVALID_ARGUMENT);
+  CddsWaitset * ws = static_cast<CddsWaitset *>(wait_set->data);
+  RET_NULL(ws);
+
+  std::lock_guard<std::mutex> lock(ws->lock);
+  if (ws->event_fd < 0) {
+    if (ws->inuse) {
+      RMW_SET_ERROR_MSG("rmw_cyclonedds_cpp_get_wait_set_fd: rmw_wait is running on the wait set");
+      return RMW_RET_ERROR;
+    }
+    const int event_fd = rmw_cyclonedds_cpp::create_event_fd();
+    if (event_fd < 0) {
+      if (errno == ENOSYS) {
+        RMW_SET_ERROR_MSG("rmw_cyclonedds_cpp_get_wait_set_fd: no eventfd on this platform");
+        return RMW_RET_UNSUPPORTED;
+      }
+      RMW_SET_ERROR_MSG("rmw_cyclonedds_cpp_get_wait_set_fd: failed to create an eventfd");
+      return RMW_RET_ERROR;
+    }
+    // the next rmw_wait attaches everything again, this time signalling the fd
+    waitset_detach(ws);
+    ws->event_fd = event_fd;
+  }
+  *fd = ws->event_fd;
+  return RMW_RET_OK;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////
 ///////////                                                                   ///////////
 ///////////    CLIENTS AND SERVERS                                            ///////////
@@ -3475,6 +4473,68 @@ static BuiltinTopicEndpoint get_matched_publication_data(
   return ep;
 }
 
+/* Looks up what the publisher's matched readers have in common again if the matches
+   changed, and returns how many there are; matches_lock must be held. Getting the status
+   resets the changes, so this is the only place that does. */
+static int32_t check_matched_readers(CddsPublisher * pub)
+{
+  dds_publication_matched_status_t status;
+  if (dds_get_publication_matched_status(pub->enth, &status) < 0) {
+    return 0;
+  }
+  if (!pub->matches_checked || status.total_count_change != 0 ||
+    status.current_count_change != 0)
+  {
+    std::vector<dds_instance_handle_t> rds;
+    dds_guid_t wrguid;
+    bool ok = get_matched_endpoints(pub->enth, dds_get_matched_subscriptions, rds) == RMW_RET_OK &&
+      dds_get_guid(pub->enth, &wrguid) >= 0;
+    bool shm_local = ok;
+    bool in_process = ok;
+    for (const auto & rdih : rds) {
+      auto rd = get_matched_subscription_data(pub->enth, rdih);
+      std::string host;
+      if (!rd) {
+        shm_local = in_process = false;
+        break;
+      }
+      if (!get_user_data_key(rd->qos, "shmhost", host) ||
+        host != rmw_cyclonedds_cpp::shm_host_id())
+      {
+        shm_local = false;
+      }
+      /* entities have the GUID prefix of their participant, which is that of the context */
+      if (memcmp(rd->key.v, wrguid.v, 12) != 0) {
+        in_process = false;
+      }
+    }
+    pub->readers_shm_local = shm_local;
+    pub->readers_in_process = in_process;
+    pub->matches_checked = true;
+  }
+  return status.current_count;
+}
+
+/* True if the publisher has matched readers and all of them advertised that they take
+   messages from shared memory on this host. Looked up again whenever the matches change.
+
+   A reader matched after the check may still be sent a reference or two before the next
+   one notices it; if it can't map the ring, it drops them as lost. */
+static bool shm_readers_are_local(CddsPublisher * pub)
+{
+  std::lock_guard<std::mutex> lock(pub->matches_lock);
+  return check_matched_readers(pub) > 0 && pub->readers_shm_local;
+}
+
+/* True if the publisher has matched readers and all of them belong to the same context.
+   A reader matched after the check still gets the messages, only serialized when it
+   needs them rather than up front. */
+static bool readers_are_in_process(CddsPublisher * pub)
+{
+  std::lock_guard<std::mutex> lock(pub->matches_lock);
+  return check_matched_readers(pub) > 0 && pub->readers_in_process;
+}
+
 static const std::string csid_to_string(const client_service_id_t & id)
 {
   std::ostringstream os;
@@ -4236,8 +5296,7 @@ extern "C" rmw_ret_t rmw_get_topic_names_and_types(
     demangle_topic = _identity_demangle;
     demangle_type = _identity_demangle;
   }
-  auto common_context = &node->context->impl->common;
-  return common_context->graph_cache.get_names_and_types(
+  return node->context->impl->graph_index.get_names_and_types(
     demangle_topic,
     demangle_type,
     allocator,
@@ -4261,8 +5320,7 @@ extern "C" rmw_ret_t rmw_get_service_names_and_types(
     return RMW_RET_INVALID_ARGUMENT;
   }
 
-  auto common_context = &node->context->impl->common;
-  return common_context->graph_cache.get_names_and_types(
+  return node->context->impl->graph_index.get_names_and_types(
     _demangle_service_from_topic,
     _demangle_service_type_only,
     allocator,
@@ -4342,7 +5400,7 @@ extern "C" rmw_ret_t rmw_service_server_is_available(
   *is_available = false;
 
   auto info = static_cast<CddsClient *>(client->data);
-  auto common_context = &node->context->impl->common;
+  auto & graph_index = node->context->impl->graph_index;
 
   std::string sub_topic_name, pub_topic_name;
   if (get_topic_name(info->client.pub->enth, pub_topic_name) < 0 ||
@@ -4352,17 +5410,10 @@ extern "C" rmw_ret_t rmw_service_server_is_available(
     return RMW_RET_ERROR;
   }
 
-  size_t number_of_request_subscribers = 0;
-  rmw_ret_t ret =
-    common_context->graph_cache.get_reader_count(pub_topic_name, &number_of_request_subscribers);
-  if (ret != RMW_RET_OK || 0 == number_of_request_subscribers) {
-    return ret;
-  }
-  size_t number_of_response_publishers = 0;
-  ret =
-    common_context->graph_cache.get_writer_count(sub_topic_name, &number_of_response_publishers);
-  if (ret != RMW_RET_OK || 0 == number_of_response_publishers) {
-    return ret;
+  if (0 == graph_index.reader_count(pub_topic_name) ||
+    0 == graph_index.writer_count(sub_topic_name))
+  {
+    return RMW_RET_OK;
   }
   return check_for_service_reader_writer(info->client, is_available);
 }
@@ -4390,9 +5441,9 @@ extern "C" rmw_ret_t rmw_count_publishers(
   }
   RMW_CHECK_ARGUMENT_FOR_NULL(count, RMW_RET_INVALID_ARGUMENT);
 
-  auto common_context = &node->context->impl->common;
   const std::string mangled_topic_name = make_fqtopic(ROS_TOPIC_PREFIX, topic_name, "", false);
-  return common_context->graph_cache.get_writer_count(mangled_topic_name, count);
+  *count = node->context->impl->graph_index.writer_count(mangled_topic_name);
+  return RMW_RET_OK;
 }
 
 extern "C" rmw_ret_t rmw_count_subscribers(
@@ -4418,9 +5469,9 @@ extern "C" rmw_ret_t rmw_count_subscribers(
   }
   RMW_CHECK_ARGUMENT_FOR_NULL(count, RMW_RET_INVALID_ARGUMENT);
 
-  auto common_context = &node->context->impl->common;
   const std::string mangled_topic_name = make_fqtopic(ROS_TOPIC_PREFIX, topic_name, "", false);
-  return common_context->graph_cache.get_reader_count(mangled_topic_name, count);
+  *count = node->context->impl->graph_index.reader_count(mangled_topic_name);
+  return RMW_RET_OK;
 }
 
 using GetNamesAndTypesByNodeFunction = rmw_ret_t (*)(
@@ -4620,11 +5671,12 @@ extern "C" rmw_ret_t rmw_get_publishers_info_by_topic(
     mangled_topic_name = make_fqtopic(ROS_TOPIC_PREFIX, topic_name, "", false);
     demangle_type = _demangle_if_ros_type;
   }
-  return common_context->graph_cache.get_writers_info_by_topic(
-    mangled_topic_name,
-    demangle_type,
-    allocator,
-    publishers_info);
+  return node->context->impl->graph_index.get_info_by_topic(
+    mangled_topic_name, false, demangle_type, allocator, publishers_info,
+    [&](rcutils_allocator_t * query_allocator, rmw_topic_endpoint_info_array_t * info) {
+      return common_context->graph_cache.get_writers_info_by_topic(
+        mangled_topic_name, demangle_type, query_allocator, info);
+    });
 }
 
 extern "C" rmw_ret_t rmw_get_subscriptions_info_by_topic(
@@ -4654,9 +5706,10 @@ extern "C" rmw_ret_t rmw_get_subscriptions_info_by_topic(
     mangled_topic_name = make_fqtopic(ROS_TOPIC_PREFIX, topic_name, "", false);
     demangle_type = _demangle_if_ros_type;
   }
-  return common_context->graph_cache.get_readers_info_by_topic(
-    mangled_topic_name,
-    demangle_type,
-    allocator,
-    subscriptions_info);
+  return node->context->impl->graph_index.get_info_by_topic(
+    mangled_topic_name, true, demangle_type, allocator, subscriptions_info,
+    [&](rcutils_allocator_t * query_allocator, rmw_topic_endpoint_info_array_t * info) {
+      return common_context->graph_cache.get_readers_info_by_topic(
+        mangled_topic_name, demangle_type, query_allocator, info);
+    });
 }
@@ -15,8 +15,12 @@
 
 #include <rmw/allocators.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <cinttypes>
 #include <cstring>
 #include <memory>
+#include <new>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -26,9 +30,12 @@
 #include "TypeSupport2.hpp"
 #include "bytewise.hpp"
 #include "dds/ddsi/q_radmin.h"
+#include "shm_transport.hpp"
+#include "rcutils/logging_macros.h"
 #include "rmw/error_handling.h"
 #include "rmw_cyclonedds_cpp/MessageTypeSupport.hpp"
 #include "rmw_cyclonedds_cpp/ServiceTypeSupport.hpp"
+#include "rmw_cyclonedds_cpp/fast_typesupport.hpp"
 #include "rmw_cyclonedds_cpp/serdes.hpp"
 
 /* Cyclone's nn_keyhash got renamed to ddsi_keyhash and shuffled around in the header
@@ -131,19 +138,35 @@ static uint32_t serdata_rmw_size(const struct ddsi_serdata * dcmn)
 
 static void serdata_rmw_free(struct ddsi_serdata * dcmn)
 {
-  auto * d = static_cast<const serdata_rmw *>(dcmn);
-  delete d;
+  serdata_rmw::destroy(static_cast<serdata_rmw *>(dcmn));
 }
 
+namespace
+{
+struct serdata_rmw_deleter
+{
+  void operator()(serdata_rmw * d) const {serdata_rmw::destroy(d);}
+};
+using serdata_rmw_ptr = std::unique_ptr<serdata_rmw, serdata_rmw_deleter>;
+}  // namespace
+
 static struct ddsi_serdata * serdata_rmw_from_ser(
   const struct ddsi_sertopic * topic,
   enum ddsi_serdata_kind kind,
   const struct nn_rdata * fragchain, size_t size)
 {
-  auto d = std::make_unique<serdata_rmw>(topic, kind);
+  auto d = serdata_rmw_ptr(serdata_rmw::create(topic, kind));
   uint32_t off = 0;
   assert(fragchain->min == 0);
   assert(fragchain->maxp1 >= off);    /* CDR header must be in first fragment */
+#if NN_RADMIN_HAS_CONTIGUOUS_FRAGCHAIN
+  /* large samples may have been reassembled in a buffer we can simply keep */
+  struct nn_rmsg * rmsg;
+  if (auto payload = nn_fragchain_ref_contiguous(fragchain, &rmsg)) {
+    d->hold_received(rmsg, payload, size);
+    return d.release();
+  }
+#endif
   d->resize(size);
 
   auto cursor = d->data();
@@ -171,7 +194,7 @@ static struct ddsi_serdata * serdata_rmw_from_ser_iov(
   ddsrt_msg_iovlen_t niov, const ddsrt_iovec_t * iov,
   size_t size)
 {
-  auto d = std::make_unique<serdata_rmw>(topic, kind);
+  auto d = serdata_rmw_ptr(serdata_rmw::create(topic, kind));
   d->resize(size);
 
   auto cursor = d->data();
@@ -189,7 +212,7 @@ static struct ddsi_serdata * serdata_rmw_from_keyhash(
 {
   static_cast<void>(keyhash);    // unused
   /* there is no key field, so from_keyhash is trivial */
-  return new serdata_rmw(topic, SDK_KEY);
+  return serdata_rmw::create(topic, SDK_KEY);
 }
 
 static struct ddsi_serdata * serdata_rmw_from_sample(
@@ -199,13 +222,13 @@ static struct ddsi_serdata * serdata_rmw_from_sample(
 {
   try {
     const struct sertopic_rmw * topic = static_cast<const struct sertopic_rmw *>(topiccmn);
-    auto d = std::make_unique<serdata_rmw>(topic, kind);
+    auto d = serdata_rmw_ptr(serdata_rmw::create(topic, kind));
     if (kind != SDK_DATA) {
       /* ROS2 doesn't do keys, so SDK_KEY is trivial */
     } else if (!topic->is_request_header) {
-      size_t sz = topic->cdr_writer->get_serialized_size(sample);
+      size_t sz = get_serialized_size(topic, sample);
       d->resize(sz);
-      topic->cdr_writer->serialize(d->data(), sample);
+      serialize_message(topic, d->data(), sample);
     } else {
       /* inject the service invocation header data into the CDR stream --
        * I haven't checked how it is done in the official RMW implementations, so it is
@@ -222,21 +245,86 @@ static struct ddsi_serdata * serdata_rmw_from_sample(
   }
 }
 
+size_t get_serialized_size(const struct sertopic_rmw * topic, const void * ros_message)
+{
+  if (topic->fast_type_support != nullptr) {
+    return topic->fast_type_support->serialized_size(ros_message);
+  }
+  return topic->cdr_writer->get_serialized_size(ros_message);
+}
+
+void serialize_message(const struct sertopic_rmw * topic, void * dest, const void * ros_message)
+{
+  if (topic->fast_type_support != nullptr) {
+    topic->fast_type_support->serialize(dest, ros_message);
+  } else {
+    topic->cdr_writer->serialize(dest, ros_message);
+  }
+}
+
 struct ddsi_serdata * serdata_rmw_from_serialized_message(
   const struct ddsi_sertopic * topiccmn,
   const void * raw, size_t size)
 {
   const struct sertopic_rmw * topic = static_cast<const struct sertopic_rmw *>(topiccmn);
-  auto d = new serdata_rmw(topic, SDK_DATA);
+  auto d = serdata_rmw::create(topic, SDK_DATA);
   d->resize(size);
   memcpy(d->data(), raw, size);
   return d;
 }
 
+struct ddsi_serdata * serdata_rmw_from_message(
+  const struct ddsi_sertopic * topiccmn,
+  std::shared_ptr<void> message)
+{
+  try {
+    auto d = serdata_rmw_ptr(serdata_rmw::create(topiccmn, SDK_DATA));
+    d->hold_message(std::move(message));
+    d->freeze_message();
+    return d.release();
+  } catch (std::exception & e) {
+    RMW_SET_ERROR_MSG(e.what());
+    return nullptr;
+  }
+}
+
+struct ddsi_serdata * serdata_rmw_from_shm_reference(
+  const struct ddsi_sertopic * topiccmn,
+  const rmw_cyclonedds_cpp::ShmReference & ref)
+{
+  const struct sertopic_rmw * topic = static_cast<const struct sertopic_rmw *>(topiccmn);
+  auto d = serdata_rmw::create(topic, SDK_DATA);
+  d->resize(4 + sizeof(ref));
+  auto header = static_cast<unsigned char *>(d->data());
+  header[0] = rmw_cyclonedds_cpp::SHM_REFERENCE_ENCODING[0];
+  header[1] = rmw_cyclonedds_cpp::SHM_REFERENCE_ENCODING[1];
+  header[2] = header[3] = 0;
+  memcpy(byte_offset(d->data(), 4), &ref, sizeof(ref));
+  return d;
+}
+
+bool serdata_rmw_get_shm_reference(
+  const serdata_rmw * d,
+  rmw_cyclonedds_cpp::ShmReference * ref)
+{
+  /* checking the header of a held message would serialize it */
+  if (d->message() != nullptr || d->size() < 4 + sizeof(*ref)) {
+    return false;
+  }
+  auto header = static_cast<const unsigned char *>(d->data());
+  if (header[0] != rmw_cyclonedds_cpp::SHM_REFERENCE_ENCODING[0] ||
+    header[1] != rmw_cyclonedds_cpp::SHM_REFERENCE_ENCODING[1])
+  {
+    return false;
+  }
+  memcpy(ref, byte_offset(d->data(), 4), sizeof(*ref));
+  return true;
+}
+
 static struct ddsi_serdata * serdata_rmw_to_topicless(const struct ddsi_serdata * dcmn)
 {
   auto d = static_cast<const serdata_rmw *>(dcmn);
-  auto d1 = new serdata_rmw(d->topic, SDK_KEY);
+  auto d1 = serdata_rmw::create(d->topic, SDK_KEY);
   d1->topic = nullptr;
   return d1;
 }
@@ -263,6 +351,25 @@ static void serdata_rmw_to_ser_unref(struct ddsi_serdata * dcmn, const ddsrt_iov
   ddsi_serdata_unref(static_cast<serdata_rmw *>(dcmn));
 }
 
+static bool deserialize_message(
+  const struct sertopic_rmw * topic, const void * data, size_t size, void * sample)
+{
+  if (topic->fast_type_support != nullptr) {
+    return topic->fast_type_support->deserialize(data, size, sample);
+  }
+  cycdeser sd(data, size);
+  if (using_introspection_c_typesupport(topic->type_support.typesupport_identifier_)) {
+    auto typed_typesupport =
+      static_cast<MessageTypeSupport_c *>(topic->type_support.type_support_);
+    return typed_typesupport->deserializeROSmessage(sd, sample);
+  } else if (using_introspection_cpp_typesupport(topic->type_support.typesupport_identifier_)) {
+    auto typed_typesupport =
+      static_cast<MessageTypeSupport_cpp *>(topic->type_support.type_support_);
+    return typed_typesupport->deserializeROSmessage(sd, sample);
+  }
+  return false;
+}
+
 static bool serdata_rmw_to_sample(
   const struct ddsi_serdata * dcmn, void * sample, void ** bufptr,
   void * buflim)
@@ -277,16 +384,28 @@ static bool serdata_rmw_to_sample(
     if (d->kind != SDK_DATA) {
       /* ROS2 doesn't do keys in a meaningful way yet */
     } else if (!topic->is_request_header) {
-      cycdeser sd(d->data(), d->size());
-      if (using_introspection_c_typesupport(topic->type_support.typesupport_identifier_)) {
-        auto typed_typesupport =
-          static_cast<MessageTypeSupport_c *>(topic->type_support.type_support_);
-        return typed_typesupport->deserializeROSmessage(sd, sample);
-      } else if (using_introspection_cpp_typesupport(topic->type_support.typesupport_identifier_)) {
-        auto typed_typesupport =
-          static_cast<MessageTypeSupport_cpp *>(topic->type_support.type_support_);
-        return typed_typesupport->deserializeROSmessage(sd, sample);
+      if (d->message() && topic->fast_type_support != nullptr) {
+        /* published within this process, by a publisher of the same sertopic */
+        topic->fast_type_support->copy(sample, d->message().get());
+        return true;
+      }
+      rmw_cyclonedds_cpp::ShmReference ref;
+      if (serdata_rmw_get_shm_reference(d, &ref)) {
+        /* the publisher may overwrite the data while it is being deserialized, which then
+           fails in any way a corrupt message would, or has to be discarded afterwards:
+           either way it is lost like a sample dropped on the network */
+        return rmw_cyclonedds_cpp::shm_read(
+          ref, [topic, sample](const void * data, size_t size) {
+            try {
+              return size >= 4 && deserialize_message(topic, data, size, sample);
+            } catch (rmw_cyclonedds_cpp::Exception &) {
+              return false;
+            } catch (std::runtime_error &) {
+              return false;
+            }
+          });
       }
+      return deserialize_message(topic, d->data(), d->size(), sample);
     } else {
       /* The "prefix" lambda is there to inject the service invocation header data into the CDR
         stream -- I haven't checked how it is done in the official RMW implementations, so it is
@@ -429,6 +548,10 @@ static const struct ddsi_serdata_ops serdata_rmw_ops = {
 static void sertopic_rmw_free(struct ddsi_sertopic * tpcmn)
 {
   struct sertopic_rmw * tp = static_cast<struct sertopic_rmw *>(tpcmn);
+  rmw_cyclonedds_cpp::SerdataPoolStats stats = tp->pool->stats();
+  RCUTILS_LOG_DEBUG_NAMED(
+    "rmw_cyclonedds_cpp", "serdata pool of topic %s: %" PRIu64 " hits, %" PRIu64 " misses",
+    tp->name, stats.hits, stats.misses);
 #if DDSI_SERTOPIC_HAS_TOPICKIND_NO_KEY
   ddsi_sertopic_fini(tpcmn);
 #endif
@@ -576,25 +699,144 @@ struct sertopic_rmw * create_sertopic(
   st->type_support.type_support_ = type_support;
   st->is_request_header = is_request_header;
   st->cdr_writer = rmw_cyclonedds_cpp::make_cdr_writer(std::move(message_type));
+  if (!is_request_header && using_introspection_cpp_typesupport(type_support_identifier)) {
+    st->fast_type_support = rmw_cyclonedds_cpp::find_fast_type_support(
+      get_type_name(type_support_identifier, type_support));
+  }
+  st->pool = std::make_shared<rmw_cyclonedds_cpp::SerdataPool>(sizeof(serdata_rmw));
   return st;
 }
 
+serdata_rmw * serdata_rmw::create(const ddsi_sertopic * topic, ddsi_serdata_kind kind)
+{
+  auto pool = static_cast<const sertopic_rmw *>(topic)->pool;
+  void * storage = pool->allocate_serdata();
+  try {
+    auto d = new (storage) serdata_rmw(topic, kind);
+    d->m_pool = std::move(pool);
+    return d;
+  } catch (...) {
+    pool->release_serdata(storage);
+    throw;
+  }
+}
+
+void serdata_rmw::destroy(serdata_rmw * d)
+{
+  /* the last serdata may be all that keeps the pool alive */
+  auto pool = d->m_pool;
+  d->~serdata_rmw();
+  pool->release_serdata(d);
+}
+
+serdata_rmw::~serdata_rmw()
+{
+  release_data();
+}
+
+void serdata_rmw::release_data()
+{
+#if NN_RADMIN_HAS_CONTIGUOUS_FRAGCHAIN
+  if (m_rmsg != nullptr) {
+    nn_rmsg_unref_contiguous(m_rmsg);
+    m_rmsg = nullptr;
+  } else {
+    m_pool->release_buffer(m_data, m_capacity);
+  }
+#else
+  m_pool->release_buffer(m_data, m_capacity);
+#endif
+  m_data = nullptr;
+  m_capacity = 0;
+}
+
+void serdata_rmw::reserve(size_t capacity)
+{
+  if (capacity > m_capacity) {
+    release_data();
+    m_data = m_pool->allocate_buffer(capacity, &m_capacity);
+  }
+}
+
 void serdata_rmw::resize(size_t requested_size)
 {
+  m_offset = 0;
   if (!requested_size) {
     m_size = 0;
-    m_data.reset();
     return;
   }
 
   /* FIXME: CDR padding in DDSI makes me do this to avoid reading beyond the bounds
   when copying data to network.  Should fix Cyclone to handle that more elegantly.  */
   size_t n_pad_bytes = (0 - requested_size) % 4;
-  m_data.reset(new byte[requested_size + n_pad_bytes]);
+  reserve(requested_size + n_pad_bytes);
   m_size = requested_size + n_pad_bytes;
 
   // zero the very end. The caller isn't necessarily going to overwrite it.
-  std::memset(byte_offset(m_data.get(), requested_size), '\0', n_pad_bytes);
+  std::memset(byte_offset(m_data, requested_size), '\0', n_pad_bytes);
+}
+
+void * serdata_rmw::resize_for_loan(size_t header_size, size_t payload_size)
+{
+  const size_t align = alignof(std::max_align_t);
+  size_t requested_size = header_size + payload_size;
+  size_t n_pad_bytes = (0 - requested_size) % 4;
+  reserve(requested_size + n_pad_bytes + align);
+  m_size = requested_size + n_pad_bytes;
+
+  auto payload_address = reinterpret_cast<uintptr_t>(m_data) + header_size;
+  m_offset = (0 - payload_address) % align;
+
+  std::memset(byte_offset(data(), requested_size), '\0', n_pad_bytes);
+  return byte_offset(data(), header_size);
+}
+
+void serdata_rmw::hold_received(struct nn_rmsg * rmsg, const void * data, size_t size)
+{
+  release_data();
+  m_rmsg = rmsg;
+  /* never written to: serdatas are immutable once constructed */
+  m_data = static_cast<byte *>(const_cast<void *>(data));
+  m_offset = 0;
+  m_size = size + (0 - size) % 4;
+}
+
+void serdata_rmw::hold_message(std::shared_ptr<void> message)
+{
+  release_data();
+  m_message = std::move(message);
+  m_offset = 0;
+  m_size = 0;
+}
+
+void serdata_rmw::freeze_message()
+{
+  auto topic = static_cast<const sertopic_rmw *>(this->topic);
+  size_t size = get_serialized_size(topic, m_message.get());
+  m_size = size + (0 - size) % 4;
+}
+
+void serdata_rmw::serialize_held_message() const
+{
+  /* the serdata is immutable as far as Cyclone is concerned, but this may happen in any
+     thread that needs the serialized form, e.g., a retransmit on the event thread while
+     the application thread sends it to another reader */
+  std::call_once(
+    m_serialize_once, [this]() {
+      auto self = const_cast<serdata_rmw *>(this);
+      auto topic = static_cast<const sertopic_rmw *>(this->topic);
+      self->reserve(m_size);
+      std::memset(byte_offset(m_data, m_size - 4), '\0', 4);
+      try {
+        serialize_message(topic, m_data, m_message.get());
+      } catch (std::exception & e) {
+        /* sizing the message in freeze_message normally fails first, but if not, readers
+           get garbage rather than a crash */
+        RCUTILS_LOG_ERROR_NAMED(
+          "rmw_cyclonedds_cpp", "failed to serialize message of topic %s: %s",
+          topic->name, e.what());
+      }
+    });
 }
 
 serdata_rmw::serdata_rmw(const ddsi_sertopic * topic, ddsi_serdata_kind kind)
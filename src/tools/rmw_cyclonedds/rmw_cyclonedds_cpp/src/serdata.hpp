@@ -15,18 +15,24 @@
 #define SERDATA_HPP_
 
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "TypeSupport2.hpp"
 #include "bytewise.hpp"
+#include "serdata_pool.hpp"
 #include "dds/ddsi/ddsi_serdata.h"
 #include "dds/ddsi/ddsi_sertopic.h"
 
 namespace rmw_cyclonedds_cpp
 {
 class BaseCDRWriter;
+struct FastTypeSupport;
+struct ShmReference;
 }
 
+struct nn_rmsg;
+
 struct CddsTypeSupport
 {
   void * type_support_;
@@ -43,6 +49,11 @@ struct sertopic_rmw : ddsi_sertopic
   std::string cpp_name_type_name;
 #endif
   std::unique_ptr<const rmw_cyclonedds_cpp::BaseCDRWriter> cdr_writer;
+  /* generated (de)serializer for the type, used instead of the introspection type support
+     where there is one */
+  const rmw_cyclonedds_cpp::FastTypeSupport * fast_type_support {nullptr};
+  /* shared with the serdatas allocated from it, which may outlive the topic */
+  std::shared_ptr<rmw_cyclonedds_cpp::SerdataPool> pool;
 };
 
 class serdata_rmw : public ddsi_serdata
@@ -51,13 +62,54 @@ protected:
   size_t m_size {0};
   /* first two bytes of data is CDR encoding
      second two bytes are encoding options */
-  std::unique_ptr<byte[]> m_data {nullptr};
+  byte * m_data {nullptr};
+  /* allocated size of m_data, which is kept when the serdata is resized to fit */
+  size_t m_capacity {0};
+  /* where the serialized data starts in m_data, non-zero only for loans */
+  size_t m_offset {0};
+  std::shared_ptr<rmw_cyclonedds_cpp::SerdataPool> m_pool;
+  /* received message m_data points into instead of a buffer from the pool, if any */
+  struct nn_rmsg * m_rmsg {nullptr};
+  /* message of the serdata's topic type it was published from without serializing it, if
+     any; readers with the same sertopic copy it, and m_data only gets filled in by the
+     first use of data(), e.g., for a remote reader or a local one of another type support */
+  std::shared_ptr<void> m_message;
+  mutable std::once_flag m_serialize_once;
 
-public:
   serdata_rmw(const ddsi_sertopic * topic, ddsi_serdata_kind kind);
+  ~serdata_rmw();
+  void reserve(size_t capacity);
+  void release_data();
+  void serialize_held_message() const;
+
+public:
+  /* serdatas live in their topic's pool, so they are created and destroyed only by these */
+  static serdata_rmw * create(const ddsi_sertopic * topic, ddsi_serdata_kind kind);
+  static void destroy(serdata_rmw * d);
+
   void resize(size_t requested_size);
+  /* sizes the buffer for a header_size-byte header followed by a payload_size-byte
+     message that is built in place, and returns where the message goes; that is
+     aligned for any type of member */
+  void * resize_for_loan(size_t header_size, size_t payload_size);
+  /* uses the received data of a sample Cyclone reassembled contiguously, which
+     must be followed by zero padding to a multiple of 4 bytes, without copying
+     it; the reference to rmsg is released with the serdata */
+  void hold_received(struct nn_rmsg * rmsg, const void * data, size_t size);
+  /* makes the serdata own message, a ros message of its topic's type, instead of its
+     serialized form; once the message has been filled in, freeze_message computes the
+     serialized size, after which neither may change */
+  void hold_message(std::shared_ptr<void> message);
+  void freeze_message();
+  const std::shared_ptr<void> & message() const {return m_message;}
   size_t size() const {return m_size;}
-  void * data() const {return m_data.get();}
+  void * data() const
+  {
+    if (m_message) {
+      serialize_held_message();
+    }
+    return m_data + m_offset;
+  }
 };
 
 typedef struct cdds_request_header
@@ -87,8 +139,29 @@ struct sertopic_rmw * create_sertopic(
   void * type_support, bool is_request_header,
   std::unique_ptr<rmw_cyclonedds_cpp::StructValueType> message_type_support);
 
+/* serialized size and serialization of a message of a topic without request header, by the
+   fast type support if the topic has one and by its CDRWriter otherwise */
+size_t get_serialized_size(const struct sertopic_rmw * topic, const void * ros_message);
+void serialize_message(const struct sertopic_rmw * topic, void * dest, const void * ros_message);
+
 struct ddsi_serdata * serdata_rmw_from_serialized_message(
   const struct ddsi_sertopic * topiccmn,
   const void * raw, size_t size);
 
+/* a sample holding message, a ros message of the topic's type that must no longer change,
+   instead of its serialized form, see serdata_rmw::hold_message */
+struct ddsi_serdata * serdata_rmw_from_message(
+  const struct ddsi_sertopic * topiccmn,
+  std::shared_ptr<void> message);
+
+/* a sample referring readers to a same-host publisher's shared memory, see shm_transport.hpp */
+struct ddsi_serdata * serdata_rmw_from_shm_reference(
+  const struct ddsi_sertopic * topiccmn,
+  const rmw_cyclonedds_cpp::ShmReference & ref);
+
+/* true if d is a shared memory reference, which is then copied to ref */
+bool serdata_rmw_get_shm_reference(
+  const serdata_rmw * d,
+  rmw_cyclonedds_cpp::ShmReference * ref);
+
 #endif  // SERDATA_HPP_
@@ -0,0 +1,157 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "serdata_pool.hpp"
+
+#include <algorithm>
+#include <new>
+
+namespace rmw_cyclonedds_cpp
+{
+
+namespace
+{
+
+constexpr size_t SERDATA_SLOTS = 64;
+
+/* Keeps up to about this many bytes of free buffers in each size class, but never fewer
+   than MIN_BUFFER_SLOTS buffers, so that a writer and a reader of large samples can each
+   have one in flight without going to the heap */
+constexpr size_t BUFFER_BYTES_PER_CLASS = 16 * 1024 * 1024;
+constexpr size_t MIN_BUFFER_SLOTS = 2;
+constexpr size_t MAX_BUFFER_SLOTS = 32;
+
+}  // namespace
+
+FreeSlots::FreeSlots(size_t n_slots)
+: m_slots(new std::atomic<void *>[n_slots]), m_n_slots(n_slots)
+{
+  for (size_t i = 0; i < n_slots; i++) {
+    m_slots[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+void * FreeSlots::take()
+{
+  for (size_t i = 0; i < m_n_slots; i++) {
+    /* the load keeps threads from bouncing the cache lines of empty slots between them */
+    if (m_slots[i].load(std::memory_order_relaxed) != nullptr) {
+      if (void * block = m_slots[i].exchange(nullptr, std::memory_order_acquire)) {
+        return block;
+      }
+    }
+  }
+  return nullptr;
+}
+
+bool FreeSlots::put(void * block)
+{
+  for (size_t i = 0; i < m_n_slots; i++) {
+    void * expected = nullptr;
+    if (m_slots[i].load(std::memory_order_relaxed) == nullptr &&
+      m_slots[i].compare_exchange_strong(
+        expected, block, std::memory_order_release, std::memory_order_relaxed))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+SerdataPool::SerdataPool(size_t serdata_size)
+: m_serdata_size(serdata_size), m_serdatas(SERDATA_SLOTS)
+{
+  for (size_t c = 0; c < N_CLASSES; c++) {
+    size_t class_size = size_t(1) << (MIN_CLASS_SHIFT + c);
+    size_t n_slots = std::min(
+      MAX_BUFFER_SLOTS, std::max(MIN_BUFFER_SLOTS, BUFFER_BYTES_PER_CLASS / class_size));
+    m_buffers[c].reset(new FreeSlots(n_slots));
+  }
+}
+
+SerdataPool::~SerdataPool()
+{
+  m_serdatas.drain([](void * storage) {::operator delete(storage);});
+  for (auto & buffers : m_buffers) {
+    buffers->drain([](void * buffer) {delete[] static_cast<byte *>(buffer);});
+  }
+}
+
+size_t SerdataPool::class_of(size_t size)
+{
+  size_t shift = MIN_CLASS_SHIFT;
+  while (shift < MAX_CLASS_SHIFT && (size_t(1) << shift) < size) {
+    shift++;
+  }
+  return shift - MIN_CLASS_SHIFT;
+}
+
+void * SerdataPool::allocate_serdata()
+{
+  if (void * storage = m_serdatas.take()) {
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+    return storage;
+  }
+  m_misses.fetch_add(1, std::memory_order_relaxed);
+  return ::operator new(m_serdata_size);
+}
+
+void SerdataPool::release_serdata(void * storage)
+{
+  if (!m_serdatas.put(storage)) {
+    ::operator delete(storage);
+  }
+}
+
+byte * SerdataPool::allocate_buffer(size_t size, size_t * capacity)
+{
+  if (size > (size_t(1) << MAX_CLASS_SHIFT)) {
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    *capacity = size;
+    return new byte[size];
+  }
+  size_t c = class_of(size);
+  *capacity = size_t(1) << (MIN_CLASS_SHIFT + c);
+  if (void * buffer = m_buffers[c]->take()) {
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<byte *>(buffer);
+  }
+  m_misses.fetch_add(1, std::memory_order_relaxed);
+  return new byte[*capacity];
+}
+
+void SerdataPool::release_buffer(byte * buffer, size_t capacity)
+{
+  if (buffer == nullptr) {
+    return;
+  }
+  /* only buffers of exactly a class size came from a class: the unpooled large ones may
+     happen to be a power of two, but are larger than any class */
+  if (capacity <= (size_t(1) << MAX_CLASS_SHIFT)) {
+    size_t c = class_of(capacity);
+    if ((size_t(1) << (MIN_CLASS_SHIFT + c)) == capacity && m_buffers[c]->put(buffer)) {
+      return;
+    }
+  }
+  delete[] buffer;
+}
+
+SerdataPoolStats SerdataPool::stats() const
+{
+  SerdataPoolStats s;
+  s.hits = m_hits.load(std::memory_order_relaxed);
+  s.misses = m_misses.load(std::memory_order_relaxed);
+  return s;
+}
+
+}  // namespace rmw_cyclonedds_cpp
@@ -0,0 +1,102 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef SERDATA_POOL_HPP_
+#define SERDATA_POOL_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "bytewise.hpp"
+
+namespace rmw_cyclonedds_cpp
+{
+
+/* A fixed number of slots, each holding a free block or nothing. Taking and returning a
+   block is a single atomic exchange on one slot, so unlike a linked free list there is no
+   ABA problem to guard against, and the number of blocks kept is bounded. */
+class FreeSlots
+{
+public:
+  explicit FreeSlots(size_t n_slots);
+  FreeSlots(const FreeSlots &) = delete;
+  FreeSlots & operator=(const FreeSlots &) = delete;
+
+  /* nullptr if all slots are empty */
+  void * take();
+  /* false if all slots are full, in which case the caller keeps block */
+  bool put(void * block);
+  /* empties all slots, for when nobody else can be using them any more */
+  template<typename F>
+  void drain(F && free_block)
+  {
+    for (size_t i = 0; i < m_n_slots; i++) {
+      if (void * block = m_slots[i].exchange(nullptr, std::memory_order_acquire)) {
+        free_block(block);
+      }
+    }
+  }
+
+private:
+  std::unique_ptr<std::atomic<void *>[]> m_slots;
+  size_t m_n_slots;
+};
+
+struct SerdataPoolStats
+{
+  uint64_t hits;    // allocations served from the pool
+  uint64_t misses;  // allocations that had to go to the heap
+};
+
+/* Serdata objects and payload buffers of one topic, so that publishing and receiving a
+   sample does not cost two trips through the allocator. Buffers come in power-of-two size
+   classes; those larger than the largest class are not pooled. Safe to use from any
+   thread. */
+class SerdataPool
+{
+public:
+  explicit SerdataPool(size_t serdata_size);
+  ~SerdataPool();
+  SerdataPool(const SerdataPool &) = delete;
+  SerdataPool & operator=(const SerdataPool &) = delete;
+
+  /* Storage for a serdata object, of the size given at construction */
+  void * allocate_serdata();
+  void release_serdata(void * storage);
+
+  /* A buffer of at least size bytes; capacity is set to its actual size, which must be
+     passed back to release_buffer */
+  byte * allocate_buffer(size_t size, size_t * capacity);
+  void release_buffer(byte * buffer, size_t capacity);
+
+  SerdataPoolStats stats() const;
+
+private:
+  static constexpr size_t MIN_CLASS_SHIFT = 6;    // 64 bytes
+  static constexpr size_t MAX_CLASS_SHIFT = 23;   // 8MiB
+  static constexpr size_t N_CLASSES = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+
+  static size_t class_of(size_t size);
+
+  size_t m_serdata_size;
+  FreeSlots m_serdatas;
+  std::unique_ptr<FreeSlots> m_buffers[N_CLASSES];
+  std::atomic<uint64_t> m_hits {0};
+  std::atomic<uint64_t> m_misses {0};
+};
+
+}  // namespace rmw_cyclonedds_cpp
+
+#endif  // SERDATA_POOL_HPP_
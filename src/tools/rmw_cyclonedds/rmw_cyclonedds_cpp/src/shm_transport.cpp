@@ -0,0 +1,289 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "shm_transport.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <new>
+#include <string>
+
+#if RMW_CYCLONEDDS_HAS_SHM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rmw_cyclonedds_cpp
+{
+
+namespace
+{
+
+/* Start of every segment; the data region follows at DATA_OFFSET */
+struct ShmSegmentHeader
+{
+  /* bytes reserved so far: advanced before a message is written, so a reader that sees
+     it more than capacity past the position it read, knows it read overwritten data */
+  std::atomic<uint64_t> head;
+  /* set by the writer as it removes the segment, so readers can let go of it */
+  std::atomic<uint32_t> closed;
+  uint64_t capacity;
+};
+
+constexpr size_t DATA_OFFSET = 64;
+static_assert(sizeof(ShmSegmentHeader) <= DATA_OFFSET, "segment header overlaps data");
+
+/* start of each message, so that the serializer writes to aligned memory */
+constexpr size_t MESSAGE_ALIGN = 8;
+
+size_t size_from_env(const char * name, size_t default_value)
+{
+  const char * value = std::getenv(name);
+  if (value == nullptr || *value == '\0') {
+    return default_value;
+  }
+  char * end;
+  unsigned long long parsed = std::strtoull(value, &end, 10);  // NOLINT
+  return (*end == '\0') ? static_cast<size_t>(parsed) : default_value;
+}
+
+ShmSegmentHeader * header_of(void * base)
+{
+  return static_cast<ShmSegmentHeader *>(base);
+}
+
+unsigned char * data_of(void * base)
+{
+  return static_cast<unsigned char *>(base) + DATA_OFFSET;
+}
+
+#if RMW_CYCLONEDDS_HAS_SHM
+struct ShmMapping
+{
+  void * base;
+  size_t mapped_size;
+
+  ShmMapping(void * base, size_t mapped_size)
+  : base(base), mapped_size(mapped_size) {}
+  ~ShmMapping() {munmap(base, mapped_size);}
+};
+
+/* Rings mapped by the readers of this process, by segment name. A ring stays mapped until
+   its writer has closed it and the last reader using it is done. */
+class ShmReaderMappings
+{
+public:
+  std::shared_ptr<const ShmMapping> find(const std::string & segment)
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto it = m_mappings.find(segment);
+    if (it != m_mappings.end()) {
+      return it->second;
+    }
+    release_closed();
+    int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+      return nullptr;
+    }
+    struct stat st;
+    void * base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) > DATA_OFFSET) {
+      base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+      return nullptr;
+    }
+    auto mapping = std::make_shared<const ShmMapping>(base, static_cast<size_t>(st.st_size));
+    if (header_of(base)->capacity > mapping->mapped_size - DATA_OFFSET) {
+      return nullptr;
+    }
+    m_mappings.emplace(segment, mapping);
+    return mapping;
+  }
+
+private:
+  void release_closed()
+  {
+    for (auto it = m_mappings.begin(); it != m_mappings.end(); ) {
+      if (header_of(it->second->base)->closed.load(std::memory_order_acquire)) {
+        it = m_mappings.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  std::mutex m_lock;
+  std::map<std::string, std::shared_ptr<const ShmMapping>> m_mappings;
+};
+#endif
+
+}  // namespace
+
+const ShmConfig & shm_config()
+{
+  static const ShmConfig config = [] {
+      ShmConfig c;
+      c.threshold = size_from_env("RMW_CYCLONEDDS_SHM_THRESHOLD", 0);
+      c.enabled = RMW_CYCLONEDDS_HAS_SHM && c.threshold > 0;
+      c.capacity = size_from_env("RMW_CYCLONEDDS_SHM_CAPACITY", 32 * 1024 * 1024);
+      return c;
+    } ();
+  return config;
+}
+
+const std::string & shm_host_id()
+{
+  static const std::string host_id = [] {
+      std::string id;
+      std::ifstream machine_id("/etc/machine-id");
+      if (machine_id) {
+        std::getline(machine_id, id);
+      }
+#if RMW_CYCLONEDDS_HAS_SHM
+      if (id.empty()) {
+        char name[256] = {0};
+        if (gethostname(name, sizeof(name) - 1) == 0) {
+          id = name;
+        }
+      }
+#endif
+      return id;
+    } ();
+  return host_id;
+}
+
+#if RMW_CYCLONEDDS_HAS_SHM
+
+std::unique_ptr<ShmWriter> ShmWriter::create(const std::string & segment, size_t capacity)
+{
+  if (segment.size() >= sizeof(ShmReference::segment) || capacity == 0) {
+    return nullptr;
+  }
+  capacity = (capacity + MESSAGE_ALIGN - 1) / MESSAGE_ALIGN * MESSAGE_ALIGN;
+  size_t mapped_size = DATA_OFFSET + capacity;
+
+  int fd = shm_open(segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0) {
+    return nullptr;
+  }
+  void * base = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(mapped_size)) == 0) {
+    base = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(segment.c_str());
+    return nullptr;
+  }
+
+  auto header = new (base) ShmSegmentHeader;
+  header->head.store(0, std::memory_order_relaxed);
+  header->closed.store(0, std::memory_order_relaxed);
+  header->capacity = capacity;
+  return std::unique_ptr<ShmWriter>(new ShmWriter(segment, base, mapped_size));
+}
+
+ShmWriter::ShmWriter(const std::string & segment, void * base, size_t mapped_size)
+: m_segment(segment), m_base(base), m_mapped_size(mapped_size)
+{
+}
+
+ShmWriter::~ShmWriter()
+{
+  header_of(m_base)->closed.store(1, std::memory_order_release);
+  munmap(m_base, m_mapped_size);
+  shm_unlink(m_segment.c_str());
+}
+
+void * ShmWriter::reserve(size_t size, ShmReference * ref)
+{
+  ShmSegmentHeader * header = header_of(m_base);
+  const uint64_t capacity = header->capacity;
+  if (size == 0 || size > capacity) {
+    return nullptr;
+  }
+
+  uint64_t position;
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    position = header->head.load(std::memory_order_relaxed);
+    if (position % capacity + size > capacity) {
+      // messages are contiguous, so one that doesn't fit before the end starts over
+      position += capacity - position % capacity;
+    }
+    uint64_t next = position + (size + MESSAGE_ALIGN - 1) / MESSAGE_ALIGN * MESSAGE_ALIGN;
+    header->head.store(next, std::memory_order_relaxed);
+    // the new head must be visible before anything overwrites the data readers may be reading
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  std::memset(ref->segment, 0, sizeof(ref->segment));
+  std::memcpy(ref->segment, m_segment.c_str(), m_segment.size());
+  ref->position = position;
+  ref->size = size;
+  return data_of(m_base) + position % capacity;
+}
+
+bool shm_read(const ShmReference & ref, const std::function<bool(const void *, size_t)> & read)
+{
+  static ShmReaderMappings mappings;
+
+  std::string segment(ref.segment, strnlen(ref.segment, sizeof(ref.segment)));
+  auto mapping = mappings.find(segment);
+  if (!mapping) {
+    return false;
+  }
+  ShmSegmentHeader * header = header_of(mapping->base);
+  const uint64_t capacity = header->capacity;
+  if (ref.size > capacity || ref.position % capacity + ref.size > capacity) {
+    return false;
+  }
+  if (header->head.load(std::memory_order_acquire) > ref.position + capacity) {
+    return false;
+  }
+  bool ok = read(data_of(mapping->base) + ref.position % capacity, ref.size);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return ok && header->head.load(std::memory_order_relaxed) <= ref.position + capacity;
+}
+
+#else
+
+std::unique_ptr<ShmWriter> ShmWriter::create(const std::string &, size_t)
+{
+  return nullptr;
+}
+
+ShmWriter::~ShmWriter()
+{
+}
+
+void * ShmWriter::reserve(size_t, ShmReference *)
+{
+  return nullptr;
+}
+
+bool shm_read(const ShmReference &, const std::function<bool(const void *, size_t)> &)
+{
+  return false;
+}
+
+#endif
+
+}  // namespace rmw_cyclonedds_cpp
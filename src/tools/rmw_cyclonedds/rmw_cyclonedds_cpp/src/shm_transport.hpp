@@ -0,0 +1,98 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef SHM_TRANSPORT_HPP_
+#define SHM_TRANSPORT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/* Same-host data path: a publisher serializes large messages into a shared memory ring of
+   its own and writes only a ShmReference through DDSI, which readers on the same host
+   resolve by mapping the ring. Discovery, QoS matching and everything else still go through
+   DDSI.
+
+   A ring never blocks the writer: it wraps around over the oldest data, and a reader that
+   finds the data it was referred to has been overwritten drops the sample, as if it had
+   been lost on the network. */
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RMW_CYCLONEDDS_HAS_SHM 1
+#else
+#define RMW_CYCLONEDDS_HAS_SHM 0
+#endif
+
+namespace rmw_cyclonedds_cpp
+{
+
+/* Encapsulation identifier, from the vendor-specific range, in the first two bytes of a
+   serdata carrying a ShmReference instead of CDR */
+constexpr uint8_t SHM_REFERENCE_ENCODING[2] = {0x80, 0x01};
+
+/* Only ever exchanged between processes on one host, so it is in native byte order */
+struct ShmReference
+{
+  char segment[48];
+  uint64_t position;  // bytes written to the ring before this message
+  uint64_t size;
+};
+
+struct ShmConfig
+{
+  /* RMW_CYCLONEDDS_SHM_THRESHOLD: messages that serialize to at least this many bytes
+     go through shared memory; unset disables the data path in this process altogether */
+  bool enabled;
+  size_t threshold;
+  /* RMW_CYCLONEDDS_SHM_CAPACITY: size of each publisher's ring, 32MiB by default */
+  size_t capacity;
+};
+
+const ShmConfig & shm_config();
+
+/* Identifies this host to publishers, which only refer readers that advertise the same id
+   to their ring: the machine id, or the host name where there is none */
+const std::string & shm_host_id();
+
+class ShmWriter
+{
+public:
+  /* Returns nullptr if the segment cannot be created */
+  static std::unique_ptr<ShmWriter> create(const std::string & segment, size_t capacity);
+  ~ShmWriter();
+
+  /* Reserves size contiguous bytes for a message and describes them in ref, or returns
+     nullptr if the message is too large for the ring. The bytes must be filled in before
+     ref is published. Safe to call from several threads at once. */
+  void * reserve(size_t size, ShmReference * ref);
+
+private:
+  ShmWriter(const std::string & segment, void * base, size_t mapped_size);
+
+  std::string m_segment;
+  void * m_base;
+  size_t m_mapped_size;
+  std::mutex m_lock;
+};
+
+/* Runs read on the bytes ref refers to, mapping the writer's ring on first use. Returns
+   false if the ring can't be mapped, read fails, or the writer overwrote the bytes while,
+   or before, they were read -- in which case whatever read produced must be discarded. */
+bool shm_read(const ShmReference & ref, const std::function<bool(const void *, size_t)> & read);
+
+}  // namespace rmw_cyclonedds_cpp
+
+#endif  // SHM_TRANSPORT_HPP_
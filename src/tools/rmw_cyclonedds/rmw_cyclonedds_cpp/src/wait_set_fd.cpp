@@ -0,0 +1,108 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "wait_set_fd.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace rmw_cyclonedds_cpp
+{
+
+#if defined(__linux__)
+
+int create_event_fd()
+{
+  return eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+void close_event_fd(int fd)
+{
+  close(fd);
+}
+
+void signal_event_fd(int fd)
+{
+  /* only fails if the counter is about to overflow, when it is readable already */
+  const uint64_t one = 1;
+  ssize_t n;
+  do {
+    n = write(fd, &one, sizeof(one));
+  } while (n < 0 && errno == EINTR);
+}
+
+void clear_event_fd(int fd)
+{
+  /* reading resets the counter, or fails with EAGAIN if it is 0 already */
+  uint64_t count;
+  ssize_t n;
+  do {
+    n = read(fd, &count, sizeof(count));
+  } while (n < 0 && errno == EINTR);
+}
+
+#else
+
+int create_event_fd()
+{
+  errno = ENOSYS;
+  return -1;
+}
+
+void close_event_fd(int fd)
+{
+  static_cast<void>(fd);
+}
+
+void signal_event_fd(int fd)
+{
+  static_cast<void>(fd);
+}
+
+void clear_event_fd(int fd)
+{
+  static_cast<void>(fd);
+}
+
+#endif
+
+void ReadyFds::add(int fd)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_fds.push_back(fd);
+}
+
+void ReadyFds::remove(int fd)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  auto it = std::find(m_fds.begin(), m_fds.end(), fd);
+  if (it != m_fds.end()) {
+    m_fds.erase(it);
+  }
+}
+
+void ReadyFds::signal() const
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  for (int fd : m_fds) {
+    signal_event_fd(fd);
+  }
+}
+
+}  // namespace rmw_cyclonedds_cpp
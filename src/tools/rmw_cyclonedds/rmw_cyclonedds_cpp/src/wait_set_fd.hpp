@@ -0,0 +1,51 @@
+// Copyright 2026 Voltron
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef WAIT_SET_FD_HPP_
+#define WAIT_SET_FD_HPP_
+
+#include <mutex>
+#include <vector>
+
+namespace rmw_cyclonedds_cpp
+{
+
+/* Event fds of wait sets, for rmw_cyclonedds_cpp_get_wait_set_fd. An fd is readable while
+   its counter is non-zero. */
+
+/* A non-blocking eventfd, or -1 with errno set (ENOSYS where there are none) */
+int create_event_fd();
+void close_event_fd(int fd);
+/* Makes it readable; safe to call from any thread, e.g. a DDS listener */
+void signal_event_fd(int fd);
+/* Makes it not readable */
+void clear_event_fd(int fd);
+
+/* The event fds of the wait sets an entity is attached to, all signalled when it becomes
+   ready. Wait sets add their fd when they attach the entity and remove it when they detach
+   it, so an entity attached to none costs a check of an empty list. */
+class ReadyFds
+{
+public:
+  void add(int fd);
+  void remove(int fd);
+  void signal() const;
+
+private:
+  mutable std::mutex m_lock;
+  std::vector<int> m_fds;
+};
+
+}  // namespace rmw_cyclonedds_cpp
+
+#endif  // WAIT_SET_FD_HPP_
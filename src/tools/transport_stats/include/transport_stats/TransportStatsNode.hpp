@@ -0,0 +1,61 @@
+/*
+ * Package:   transport_stats
+ * Filename:  TransportStatsNode.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// Reports how much every publisher and subscription in this process
+// sends and takes, how often it retransmits or drops data, and how far
+// behind its subscribers are. The statistics come from
+// rmw_cyclonedds_cpp, which only knows the endpoints of its own
+// process, so this is loaded into the component container of the nodes
+// it should watch. Each report covers the period since the previous
+// one.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rmw/types.h"
+
+#include "nova_msgs/msg/transport_statistics.hpp"
+
+namespace navigator {
+namespace transport_stats {
+
+class TransportStatsNode : public rclcpp::Node {
+public:
+  explicit TransportStatsNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+private:
+  // Totals of one endpoint at the previous report, to subtract from
+  struct Totals {
+    uint64_t samples = 0;
+    uint64_t bytes = 0;
+    uint64_t retransmitted_samples = 0;
+    uint64_t retransmitted_bytes = 0;
+    uint64_t nacks_received = 0;
+    uint64_t discarded_bytes = 0;
+    uint64_t lost_samples = 0;
+    uint64_t total_latency_ns = 0;
+  };
+  typedef std::array<uint8_t, RMW_GID_STORAGE_SIZE> Gid;
+
+  void report();
+
+  std::map<Gid, Totals> previous;
+  std::chrono::steady_clock::time_point previous_time;
+
+  rclcpp::Publisher<nova_msgs::msg::TransportStatistics>::SharedPtr statistics_publisher;
+  rclcpp::TimerBase::SharedPtr report_timer;
+};
+
+}
+}
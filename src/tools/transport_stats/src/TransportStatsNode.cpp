@@ -0,0 +1,117 @@
+/*
+ * Package:   transport_stats
+ * Filename:  TransportStatsNode.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <algorithm> // std::copy
+#include <chrono>
+#include <cstring> // strcmp()
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rcl/context.h"
+#include "rmw/error_handling.h"
+#include "rmw/rmw.h"
+#include "rmw_cyclonedds_cpp/transport_statistics.h"
+
+#include "nova_msgs/msg/endpoint_statistics.hpp"
+#include "nova_msgs/msg/transport_statistics.hpp"
+
+#include "transport_stats/TransportStatsNode.hpp"
+
+using navigator::transport_stats::TransportStatsNode;
+using nova_msgs::msg::EndpointStatistics;
+
+TransportStatsNode::TransportStatsNode(const rclcpp::NodeOptions & options)
+  : Node("transport_stats", options) {
+  // The statistics are an extension of this one implementation
+  if(strcmp(rmw_get_implementation_identifier(), "rmw_cyclonedds_cpp") != 0) {
+    throw std::runtime_error(std::string("transport_stats needs rmw_cyclonedds_cpp, not ") +
+			     rmw_get_implementation_identifier());
+  }
+
+  double report_period_seconds = this->declare_parameter<double>("report_period_seconds", 1.0);
+  if(report_period_seconds <= 0) {
+    throw std::invalid_argument("report_period_seconds must be positive");
+  }
+  this->statistics_publisher = this->create_publisher<nova_msgs::msg::TransportStatistics>
+    ("transport_statistics", 8);
+  this->previous_time = std::chrono::steady_clock::now();
+  this->report_timer = this->create_wall_timer
+    (std::chrono::duration_cast<std::chrono::nanoseconds>
+     (std::chrono::duration<double>(report_period_seconds)),
+     std::bind(& TransportStatsNode::report, this));
+}
+
+void TransportStatsNode::report() {
+  auto now = std::chrono::steady_clock::now();
+  nova_msgs::msg::TransportStatistics message;
+  message.header.stamp = this->now();
+  message.period = rclcpp::Duration(now - this->previous_time);
+
+  // Endpoints created since the previous report are counted from zero,
+  // and those destroyed since are forgotten
+  struct Collector {
+    const std::map<Gid, Totals> & previous;
+    std::map<Gid, Totals> current;
+    nova_msgs::msg::TransportStatistics & message;
+  } collector {this->previous, {}, message};
+
+  auto collect = [] (const rmw_cyclonedds_cpp_transport_statistics_t * statistics, void * arg) {
+    Collector & collector = *static_cast<Collector *>(arg);
+    Gid gid;
+    std::copy(statistics->gid.data, statistics->gid.data + gid.size(), gid.begin());
+    Totals totals;
+    totals.samples = statistics->samples;
+    totals.bytes = statistics->bytes;
+    totals.retransmitted_samples = statistics->retransmitted_samples;
+    totals.retransmitted_bytes = statistics->retransmitted_bytes;
+    totals.nacks_received = statistics->nacks_received;
+    totals.discarded_bytes = statistics->discarded_bytes;
+    totals.lost_samples = statistics->lost_samples;
+    totals.total_latency_ns = statistics->total_latency_ns;
+    auto found = collector.previous.find(gid);
+    Totals before = found == collector.previous.end() ? Totals() : found->second;
+    collector.current[gid] = totals;
+
+    EndpointStatistics endpoint;
+    endpoint.endpoint_type = statistics->endpoint_type == RMW_ENDPOINT_PUBLISHER ?
+      EndpointStatistics::PUBLISHER : EndpointStatistics::SUBSCRIPTION;
+    endpoint.topic_name = statistics->topic_name;
+    std::copy(gid.begin(), gid.end(), endpoint.gid.begin());
+    endpoint.samples = totals.samples - before.samples;
+    endpoint.bytes = totals.bytes - before.bytes;
+    endpoint.retransmitted_samples = totals.retransmitted_samples - before.retransmitted_samples;
+    endpoint.retransmitted_bytes = totals.retransmitted_bytes - before.retransmitted_bytes;
+    endpoint.nacks_received = totals.nacks_received - before.nacks_received;
+    endpoint.unacknowledged_bytes = statistics->unacknowledged_bytes;
+    endpoint.discarded_bytes = totals.discarded_bytes - before.discarded_bytes;
+    endpoint.lost_samples = totals.lost_samples - before.lost_samples;
+    if(endpoint.endpoint_type == EndpointStatistics::SUBSCRIPTION && endpoint.samples > 0) {
+      endpoint.mean_latency = static_cast<double>(totals.total_latency_ns - before.total_latency_ns)
+	/ 1e9 / static_cast<double>(endpoint.samples);
+    }
+    collector.message.endpoints.push_back(endpoint);
+  };
+
+  rmw_context_t * context = rcl_context_get_rmw_context
+    (this->get_node_base_interface()->get_context()->get_rcl_context().get());
+  if(rmw_cyclonedds_cpp_get_transport_statistics(context, collect, &collector) != RMW_RET_OK) {
+    RCLCPP_WARN(this->get_logger(), "Could not get transport statistics: %s",
+		rmw_get_error_string().str);
+    rmw_reset_error();
+    return;
+  }
+  this->previous.swap(collector.current);
+  this->previous_time = now;
+  this->statistics_publisher->publish(message);
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(navigator::transport_stats::TransportStatsNode)
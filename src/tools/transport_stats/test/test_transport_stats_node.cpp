@@ -0,0 +1,123 @@
+/*
+ * Package:   transport_stats
+ * Filename:  test_transport_stats_node.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// The node reports on the endpoints of its own process, so the test
+// publisher and subscriber are watched here too. Needs
+// rmw_cyclonedds_cpp, and is skipped with any other implementation.
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rmw/rmw.h"
+#include "std_msgs/msg/float32.hpp"
+
+#include "voltron_test_utils/TestPublisher.hpp"
+#include "voltron_test_utils/TestSubscriber.hpp"
+#include "nova_msgs/msg/transport_statistics.hpp"
+
+#include "transport_stats/TransportStatsNode.hpp"
+
+using namespace std::chrono_literals;
+using namespace Voltron::TestUtils;
+using navigator::transport_stats::TransportStatsNode;
+using nova_msgs::msg::EndpointStatistics;
+using nova_msgs::msg::TransportStatistics;
+
+class TestTransportStatsNode : public ::testing::Test {
+protected:
+  void SetUp() override {
+    rclcpp::init(0, nullptr);
+    if(strcmp(rmw_get_implementation_identifier(), "rmw_cyclonedds_cpp") != 0) {
+      GTEST_SKIP() << "needs rmw_cyclonedds_cpp";
+    }
+    rclcpp::NodeOptions options;
+    options.append_parameter_override("report_period_seconds", 0.05);
+    stats_node = std::make_shared<TransportStatsNode>(options);
+    publisher = std::make_unique<TestPublisher<std_msgs::msg::Float32>>("transport_stats_test");
+    subscriber = std::make_unique<TestSubscriber<std_msgs::msg::Float32>>("transport_stats_test");
+    reports = std::make_unique<TestSubscriber<TransportStatistics>>("transport_statistics");
+  }
+
+  void TearDown() override {
+    reports.reset();
+    subscriber.reset();
+    publisher.reset();
+    stats_node.reset();
+    rclcpp::shutdown();
+  }
+
+  // The test topic's endpoints in the reports that arrive until the
+  // timeout
+  std::vector<EndpointStatistics> collect_reports(std::chrono::nanoseconds timeout) {
+    std::vector<EndpointStatistics> endpoints;
+    auto end = std::chrono::steady_clock::now() + timeout;
+    while(std::chrono::steady_clock::now() < end) {
+      rclcpp::spin_some(stats_node);
+      while(reports->has_message_ready()) {
+	for(const EndpointStatistics & endpoint : reports->get_message()->endpoints) {
+	  if(endpoint.topic_name == "/transport_stats_test") endpoints.push_back(endpoint);
+	}
+      }
+    }
+    return endpoints;
+  }
+
+  static EndpointStatistics sum(const std::vector<EndpointStatistics> & endpoints,
+				uint8_t endpoint_type) {
+    EndpointStatistics sum;
+    for(const EndpointStatistics & endpoint : endpoints) {
+      if(endpoint.endpoint_type != endpoint_type) continue;
+      sum.samples += endpoint.samples;
+      sum.bytes += endpoint.bytes;
+      sum.mean_latency = std::max(sum.mean_latency, endpoint.mean_latency);
+    }
+    return sum;
+  }
+
+  std::shared_ptr<TransportStatsNode> stats_node;
+  std::unique_ptr<TestPublisher<std_msgs::msg::Float32>> publisher;
+  std::unique_ptr<TestSubscriber<std_msgs::msg::Float32>> subscriber;
+  std::unique_ptr<TestSubscriber<TransportStatistics>> reports;
+};
+
+TEST_F(TestTransportStatsNode, test_counts_published_and_taken) {
+  std_msgs::msg::Float32 message;
+  for(int i = 0; i < 10; i++) {
+    message.data = i;
+    publisher->send_message(message);
+  }
+  ASSERT_TRUE(subscriber->wait_for_messages(10, 1s));
+
+  auto endpoints = collect_reports(300ms);
+  EndpointStatistics published = sum(endpoints, EndpointStatistics::PUBLISHER);
+  EXPECT_EQ(published.samples, 10u);
+  // At least the 4-byte header and the float of each message
+  EXPECT_GE(published.bytes, 80u);
+
+  EndpointStatistics taken = sum(endpoints, EndpointStatistics::SUBSCRIPTION);
+  EXPECT_EQ(taken.samples, 10u);
+  EXPECT_GE(taken.bytes, 80u);
+  EXPECT_GT(taken.mean_latency, 0.0);
+}
+
+TEST_F(TestTransportStatsNode, test_reports_period) {
+  rclcpp::spin_some(stats_node);
+  auto end = std::chrono::steady_clock::now() + 1s;
+  while(!reports->has_message_ready() && std::chrono::steady_clock::now() < end) {
+    rclcpp::spin_some(stats_node);
+  }
+  auto report = reports->get_received_message(0s).message;
+  ASSERT_TRUE(report);
+  EXPECT_GT(rclcpp::Duration(report->period).nanoseconds(), 0);
+}
@@ -0,0 +1,48 @@
+/*
+ * Package:   voltron_test_utils
+ * Filename:  BackgroundSpinner.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include "rclcpp/rclcpp.hpp"
+#include <thread>
+
+namespace Voltron {
+namespace TestUtils {
+
+// Spins one node on its own executor and thread, so that the test
+// utilities receive messages as they arrive rather than when polled.
+// Callbacks run on that thread.
+class BackgroundSpinner {
+public:
+  BackgroundSpinner(rclcpp::Node::SharedPtr node) : running(true) {
+    this->executor.add_node(node);
+    this->thread = std::thread([this] () {
+      // spin_once() rather than spin(), which would miss a cancel() made
+      // before it started
+      while(this->running && rclcpp::ok()) {
+	this->executor.spin_once(std::chrono::milliseconds(10));
+      }
+    });
+  }
+
+  virtual ~BackgroundSpinner() {
+    this->running = false;
+    this->thread.join();
+  }
+
+private:
+  rclcpp::executors::SingleThreadedExecutor executor;
+  std::atomic<bool> running;
+  std::thread thread;
+};
+
+}
+}
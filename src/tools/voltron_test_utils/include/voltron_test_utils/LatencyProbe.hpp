@@ -0,0 +1,100 @@
+/*
+ * Package:   voltron_test_utils
+ * Filename:  LatencyProbe.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include "rclcpp/rclcpp.hpp"
+#include <string>
+#include "nova_trace/LatencyHistogram.hpp"
+#include "voltron_test_utils/TestSubscriber.hpp"
+
+namespace Voltron {
+namespace TestUtils {
+
+// Measures end-to-end latency through a node under test: messages are
+// sent on its input topic, and each output is timed against the input
+// it answers. By default the nth output answers the nth input; nodes
+// that may drop or reorder messages need match_by_sequence().
+template <typename InType, typename OutType = InType> class LatencyProbe {
+public:
+  typedef std::chrono::steady_clock Clock;
+  typedef std::function<void(InType &, uint64_t)> StampFunction;
+  typedef std::function<uint64_t(const OutType &)> ReadStampFunction;
+
+  LatencyProbe(std::string input_topic, std::string output_topic)
+    : receiver(output_topic) {
+    this->node = std::make_shared<rclcpp::Node>("latency_probe_node_" + input_topic);
+    this->publisher = this->node->template create_publisher<InType>(input_topic, 64);
+  }
+
+  // stamp writes a sequence number into each outgoing message and read
+  // recovers it from the node's output
+  void match_by_sequence(StampFunction stamp, ReadStampFunction read) {
+    this->stamp = stamp;
+    this->read_stamp = read;
+  }
+
+  void send(InType message) {
+    uint64_t sequence = this->sent++;
+    if(this->stamp) this->stamp(message, sequence);
+    this->send_times[sequence] = Clock::now();
+    this->publisher->publish(message);
+  }
+
+  bool wait_for_outputs(size_t count, std::chrono::nanoseconds timeout) {
+    return this->receiver.wait_for_messages(count, timeout);
+  }
+
+  // Latencies of every output received so far
+  navigator::trace::LatencyHistogram & histogram() {
+    while(true) {
+      auto received = this->receiver.get_received_message(std::chrono::nanoseconds(0));
+      if(! received.message) break;
+      uint64_t sequence = this->read_stamp ? this->read_stamp(*received.message) : this->outputs;
+      this->outputs++;
+      auto sent_at = this->send_times.find(sequence);
+      if(sent_at == this->send_times.end()) {
+	this->unmatched++;
+	continue;
+      }
+      this->latencies.record(received.received - sent_at->second);
+      this->send_times.erase(sent_at);
+    }
+    return this->latencies;
+  }
+
+  uint64_t sent_count() const {
+    return this->sent;
+  }
+
+  // Outputs that answered no input we know of
+  uint64_t unmatched_count() const {
+    return this->unmatched;
+  }
+
+private:
+  std::shared_ptr<rclcpp::Node> node;
+  typename rclcpp::Publisher<InType>::SharedPtr publisher;
+  TestSubscriber<OutType> receiver;
+  StampFunction stamp;
+  ReadStampFunction read_stamp;
+  std::map<uint64_t, Clock::time_point> send_times; // Not yet answered
+  navigator::trace::LatencyHistogram latencies;
+  uint64_t sent = 0;
+  uint64_t outputs = 0;
+  uint64_t unmatched = 0;
+};
+
+}
+}
@@ -10,11 +10,13 @@
 #pragma once
 
 #include <chrono>
+#include <condition_variable>
 #include <future>
 #include <memory>
+#include <mutex>
 #include "rclcpp/rclcpp.hpp"
 #include <string>
-#include <unistd.h>
+#include "voltron_test_utils/BackgroundSpinner.hpp"
 
 using namespace std::chrono_literals;
 
@@ -25,47 +27,84 @@ template <typename ServiceType> class TestClient {
 public:
   typedef typename ServiceType::Request RequestType;
   typedef typename ServiceType::Response ResponseType;
+  typedef std::chrono::steady_clock Clock;
 
   TestClient(std::string topic) {
     this->node = std::make_shared<TestClientNode>(topic);
+    this->spinner = std::make_unique<BackgroundSpinner>(this->node);
+  }
+
+  virtual ~TestClient() {
+    this->spinner.reset();
   }
 
   void send_request(RequestType request) {
-    this->current_response = this->node->send_request(request);
-    rclcpp::spin_some(this->node);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->completed = false;
+    this->request_sent = Clock::now();
+    this->current_response = this->node->send_request(request,
+      [this] (typename ClientType::SharedFuture) { this->complete_request(); });
   }
 
-  bool request_complete() {
+  // Blocks until the response to the last request arrives or the
+  // timeout passes, and returns whether it arrived
+  bool wait_for_response(std::chrono::nanoseconds timeout = 1s) {
+    std::unique_lock<std::mutex> lock(this->mutex);
     if(! this->current_response.valid()) return false;
-    usleep(1000);
-    rclcpp::spin_some(this->node);
-    return this->current_response.wait_for(0s) == std::future_status::ready;
+    return this->response_received.wait_for(lock, timeout, [this] () { return this->completed; });
+  }
+
+  // Allows a millisecond for a response in flight, as this always has
+  bool request_complete() {
+    return this->wait_for_response(1ms);
   }
 
   ResponseType get_response() {
-    rclcpp::spin_until_future_complete(this->node, this->current_response);
+    this->wait_for_response(5s);
     return *(this->current_response.get());
   }
 
+  // Time from sending the last request to its response arriving
+  std::chrono::nanoseconds response_latency() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->response_time - this->request_sent;
+  }
+
 private:
   typedef rclcpp::Client<ServiceType> ClientType;
-  
+
   class TestClientNode : public rclcpp::Node {
   public:
     TestClientNode(std::string topic) : Node("test_client_node_" + topic) {
       this->client = this->create_client<ServiceType>(topic);
     }
 
-    typename ClientType::SharedFuture send_request(RequestType request) {
-      return this->client->async_send_request(std::make_shared<RequestType>(request));
+    template <typename CallbackType>
+    typename ClientType::SharedFuture send_request(RequestType request, CallbackType callback) {
+      return this->client->async_send_request(std::make_shared<RequestType>(request), callback);
     }
 
   private:
     std::shared_ptr<ClientType> client;
   };
 
+  void complete_request() {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->response_time = Clock::now();
+      this->completed = true;
+    }
+    this->response_received.notify_all();
+  }
+
+  std::mutex mutex;
+  std::condition_variable response_received;
+  bool completed = false;
+  Clock::time_point request_sent;
+  Clock::time_point response_time;
   typename ClientType::SharedFuture current_response;
   std::shared_ptr<TestClientNode> node;
+  std::unique_ptr<BackgroundSpinner> spinner;
 };
 
 }
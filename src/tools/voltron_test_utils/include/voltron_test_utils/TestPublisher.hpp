@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include "rclcpp/rclcpp.hpp" // For the ROS node
 #include <string>
@@ -25,10 +26,13 @@ public:
 
   virtual ~TestPublisher() {}
 
-  void send_message(MsgType message) {
+  // Returns when the message was published, to measure latency from
+  std::chrono::steady_clock::time_point send_message(MsgType message) {
+    std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
     this->node->send_message(message);
     rclcpp::spin_some(this->node);
     usleep(1000);
+    return sent;
   }
 
 private:
@@ -9,11 +9,14 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include "rclcpp/rclcpp.hpp"
 #include <string>
-#include <unistd.h>
+#include "voltron_test_utils/BackgroundSpinner.hpp"
 
 namespace Voltron {
 namespace TestUtils {
@@ -24,53 +27,51 @@ public:
   typedef typename ServiceType::Response ResponseType;
 
   TestServer(std::string topic, ResponseType default_response) {
-    this->node = std::make_shared<TestServerNode>(topic, default_response);
+    this->default_response = default_response;
+    this->node = std::make_shared<rclcpp::Node>("test_server_node_" + topic);
+    this->server = this->node->template create_service<ServiceType>(topic,
+      [this] (const std::shared_ptr<RequestType> request, std::shared_ptr<ResponseType> response) {
+	this->handle_request(request, response);
+      }
+    );
+    this->spinner = std::make_unique<BackgroundSpinner>(this->node);
+  }
+
+  virtual ~TestServer() {
+    this->spinner.reset();
   }
 
   void enqueue_response(ResponseType response) {
-    this->node->enqueue_response(response);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->enqueued_responses.push(response);
   }
 
+  // Blocks until a request has been received or the timeout passes, and
+  // returns whether one was
+  bool wait_for_request(std::chrono::nanoseconds timeout = std::chrono::seconds(1)) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return this->request_received.wait_for(lock, timeout, [this] () {
+      return ! this->received_requests.empty();
+    });
+  }
+
+  // Allows a millisecond for a request in flight, as this always has
   bool has_received_request() {
-    usleep(1000);
-    rclcpp::spin_some(this->node);
-    return this->node->has_received_request();
+    return this->wait_for_request(std::chrono::milliseconds(1));
   }
 
   RequestType get_received_request() {
-    usleep(1000);
-    rclcpp::spin_some(this->node);
-    return this->node->get_received_request();
+    this->wait_for_request();
+    std::lock_guard<std::mutex> lock(this->mutex);
+    RequestType value = this->received_requests.front();
+    this->received_requests.pop();
+    return value;
   }
 
 private:
-  class TestServerNode : public rclcpp::Node {
-  public:
-    TestServerNode(std::string topic, ResponseType default_response) : Node("test_server_node_" + topic) {
-      this->server = this->create_service<ServiceType>(topic,
-	[&] (const std::shared_ptr<RequestType> request, std::shared_ptr<ResponseType> response) {
-	  this->handle_request(request, response);
-        }
-      );
-      this->default_response = default_response;
-    }
-
-    void enqueue_response(ResponseType response) {
-      this->enqueued_responses.push(response);
-    }
-
-    bool has_received_request() {
-      return ! this->received_requests.empty();
-    }
-
-    RequestType get_received_request() {
-      RequestType value  = this->received_requests.front();
-      this->received_requests.pop();
-      return value;
-    }
-
-  private:
-    void handle_request(const std::shared_ptr<RequestType> request, std::shared_ptr<ResponseType> response) {
+  void handle_request(const std::shared_ptr<RequestType> request, std::shared_ptr<ResponseType> response) {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
       this->received_requests.push(*request);
       if(this->enqueued_responses.empty()) {
 	*response = default_response;
@@ -79,14 +80,17 @@ private:
 	enqueued_responses.pop();
       }
     }
+    this->request_received.notify_all();
+  }
 
-    std::queue<RequestType> received_requests;
-    std::queue<ResponseType> enqueued_responses;
-    std::shared_ptr<rclcpp::Service<ServiceType>> server;
-    ResponseType default_response;
-  };
-
-  std::shared_ptr<TestServerNode> node;
+  std::mutex mutex;
+  std::condition_variable request_received;
+  std::queue<RequestType> received_requests;
+  std::queue<ResponseType> enqueued_responses;
+  ResponseType default_response;
+  std::shared_ptr<rclcpp::Node> node;
+  std::shared_ptr<rclcpp::Service<ServiceType>> server;
+  std::unique_ptr<BackgroundSpinner> spinner;
 };
   
 }
@@ -9,66 +9,90 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include "rclcpp/rclcpp.hpp" // Because this is a ROS node
 #include <queue>
 #include <string>
-#include <unistd.h> // usleep
+#include "voltron_test_utils/BackgroundSpinner.hpp"
 
 namespace Voltron {
 namespace TestUtils {
 
 template <typename MsgType> class TestSubscriber {
 public:
+  typedef std::chrono::steady_clock Clock;
+
+  // A message along with when it arrived, to measure latency against
+  struct ReceivedMessage {
+    std::shared_ptr<MsgType> message;
+    Clock::time_point received;
+  };
+
   TestSubscriber(std::string topic) {
-    this->node = std::make_shared<TestSubscriberNode>(topic);
+    this->node = std::make_shared<rclcpp::Node>("test_subscriber_node_" + topic);
+    this->subscription = this->node->template create_subscription<MsgType>(topic, 64, std::bind(
+      & TestSubscriber::receive_message, this, std::placeholders::_1));
+    this->spinner = std::make_unique<BackgroundSpinner>(this->node);
   }
 
-  virtual ~TestSubscriber() {}
-
-  bool has_message_ready() {
-    usleep(1000);
-    rclcpp::spin_some(this->node);
-    return this->node->has_message_ready();
+  virtual ~TestSubscriber() {
+    this->spinner.reset(); // No callbacks may run once we start tearing down
   }
 
-  std::shared_ptr<MsgType> get_message() {
-    usleep(1000);
-    rclcpp::spin_some(this->node);
-    return this->node->get_message();
+  // Blocks until count messages are queued or the timeout passes, and
+  // returns whether they arrived
+  bool wait_for_messages(size_t count, std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return this->message_received.wait_for(lock, timeout, [this, count] () {
+      return this->received_messages.size() >= count;
+    });
   }
 
-private:
-  class TestSubscriberNode : public rclcpp::Node {
-  public:
-    TestSubscriberNode(std::string topic) : Node("test_subscriber_node_" + topic) {
-      this->received_messages = std::make_unique<std::queue<std::shared_ptr<MsgType>>>();
-      this->subscription = this->create_subscription<MsgType>(topic, 64, std::bind(
-	& TestSubscriberNode::receive_message, this, std::placeholders::_1));
-    }
+  bool wait_for_message(std::chrono::nanoseconds timeout = std::chrono::seconds(1)) {
+    return this->wait_for_messages(1, timeout);
+  }
 
-    virtual ~TestSubscriberNode() {}
+  // Allows a millisecond for a message in flight, as this always has
+  bool has_message_ready() {
+    return this->wait_for_message(std::chrono::milliseconds(1));
+  }
 
-    bool has_message_ready() {
-      return ! received_messages->empty();
-    }
+  // Waits up to the timeout for a message and pops it. The message is
+  // null if none arrived.
+  ReceivedMessage get_received_message(std::chrono::nanoseconds timeout = std::chrono::seconds(1)) {
+    ReceivedMessage received;
+    if(! this->wait_for_message(timeout)) return received;
+    std::lock_guard<std::mutex> lock(this->mutex);
+    received = this->received_messages.front();
+    this->received_messages.pop();
+    return received;
+  }
 
-    std::shared_ptr<MsgType> get_message() {
-      std::shared_ptr<MsgType> message = received_messages->front();
-      received_messages->pop();
-      return message;
-    }
+  std::shared_ptr<MsgType> get_message() {
+    return this->get_received_message().message;
+  }
 
-  private:
-    void receive_message(const std::shared_ptr<MsgType> message) {
-      received_messages->push(message);
+private:
+  void receive_message(const std::shared_ptr<MsgType> message) {
+    ReceivedMessage received;
+    received.message = message;
+    received.received = Clock::now();
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->received_messages.push(received);
     }
+    this->message_received.notify_all();
+  }
 
-    std::unique_ptr<std::queue<std::shared_ptr<MsgType>>> received_messages;
-    typename rclcpp::Subscription<MsgType>::SharedPtr subscription;
-  };
-
-  std::shared_ptr<TestSubscriberNode> node;
+  std::mutex mutex;
+  std::condition_variable message_received;
+  std::queue<ReceivedMessage> received_messages;
+  std::shared_ptr<rclcpp::Node> node;
+  typename rclcpp::Subscription<MsgType>::SharedPtr subscription;
+  std::unique_ptr<BackgroundSpinner> spinner;
 };
 
 }
@@ -0,0 +1,89 @@
+/*
+ * Package:   voltron_test_utils
+ * Filename:  ThroughputRunner.hpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include "rclcpp/rclcpp.hpp"
+#include <string>
+#include <thread>
+#include "voltron_test_utils/BackgroundSpinner.hpp"
+
+namespace Voltron {
+namespace TestUtils {
+
+struct ThroughputResult {
+  size_t sent;
+  size_t received;
+  double offered_rate; // Messages per second actually sent
+  double sustained_rate; // Outputs per second over the same time
+
+  size_t dropped() const {
+    return this->sent > this->received ? this->sent - this->received : 0;
+  }
+};
+
+// Drives a node under test at a fixed rate and counts its outputs, so a
+// test can find the rate it keeps up with. Assumes one output per input.
+template <typename InType, typename OutType = InType> class ThroughputRunner {
+public:
+  typedef std::chrono::steady_clock Clock;
+  typedef std::function<InType(size_t)> MessageFunction;
+
+  ThroughputRunner(std::string input_topic, std::string output_topic) : received(0) {
+    this->node = std::make_shared<rclcpp::Node>("throughput_runner_node_" + input_topic);
+    this->publisher = this->node->template create_publisher<InType>(input_topic, 64);
+    this->subscription = this->node->template create_subscription<OutType>(output_topic, 64,
+      [this] (const std::shared_ptr<OutType>) { this->received++; });
+    this->spinner = std::make_unique<BackgroundSpinner>(this->node);
+  }
+
+  virtual ~ThroughputRunner() {
+    this->spinner.reset();
+  }
+
+  // Publishes make_message(0), make_message(1), ... at rate per second
+  // for duration, then allows settle for the last outputs to arrive
+  ThroughputResult run(MessageFunction make_message, double rate, std::chrono::nanoseconds duration,
+		       std::chrono::nanoseconds settle = std::chrono::milliseconds(100)) {
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    this->received = 0;
+    ThroughputResult result;
+    result.sent = 0;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point next = start;
+    while(next - start < duration) {
+      this->publisher->publish(make_message(result.sent));
+      result.sent++;
+      next += period;
+      std::this_thread::sleep_until(next);
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::this_thread::sleep_for(settle);
+
+    result.received = this->received;
+    result.offered_rate = result.sent / elapsed;
+    result.sustained_rate = result.received / elapsed;
+    return result;
+  }
+
+private:
+  std::atomic<size_t> received;
+  std::shared_ptr<rclcpp::Node> node;
+  typename rclcpp::Publisher<InType>::SharedPtr publisher;
+  typename rclcpp::Subscription<OutType>::SharedPtr subscription;
+  std::unique_ptr<BackgroundSpinner> spinner;
+};
+
+}
+}
@@ -0,0 +1,65 @@
+/*
+ * Package:   voltron_test_utils
+ * Filename:  test_performance_helpers.cpp
+ * Author:    Joshua Williams
+ * Email:     joshmackwilliams@protonmail.com
+ * Copyright: 2021, Nova UTD
+ * License:   MIT License
+ */
+
+// The probe and runner publish and subscribe on the same topic here,
+// which stands in for a node that passes every message straight on.
+
+#include <gtest/gtest.h> // Testing framework
+#include "rclcpp/rclcpp.hpp" // For init() and shutdown()
+#include "std_msgs/msg/int64.hpp" // A test message to use
+#include "voltron_test_utils/LatencyProbe.hpp"
+#include "voltron_test_utils/ThroughputRunner.hpp"
+#include <unistd.h> // usleep
+
+using namespace Voltron::TestUtils;
+
+class TestPerformanceHelpers : public ::testing::Test {
+protected:
+  void SetUp() override {
+    rclcpp::init(0, nullptr);
+  }
+
+  void TearDown() override {
+    rclcpp::shutdown();
+  }
+};
+
+TEST_F(TestPerformanceHelpers, test_latency_probe) {
+  LatencyProbe<std_msgs::msg::Int64> probe("probe_topic", "probe_topic");
+  probe.match_by_sequence(
+    [] (std_msgs::msg::Int64 & message, uint64_t sequence) { message.data = sequence; },
+    [] (const std_msgs::msg::Int64 & message) { return static_cast<uint64_t>(message.data); });
+  usleep(100000); // Let discovery finish before timing anything
+  for(int i = 0; i < 20; i++) {
+    probe.send(std_msgs::msg::Int64());
+    usleep(1000);
+  }
+  ASSERT_TRUE(probe.wait_for_outputs(20, std::chrono::seconds(2)));
+  auto & histogram = probe.histogram();
+  ASSERT_EQ(histogram.count(), 20u);
+  ASSERT_EQ(probe.unmatched_count(), 0u);
+  auto latencies = histogram.snapshot();
+  ASSERT_GT(latencies.max_ns, 0u);
+  ASSERT_GT(latencies.quantile_us(0.5), 0u);
+  ASSERT_LE(latencies.quantile_us(0.5), latencies.quantile_us(1.0));
+}
+
+TEST_F(TestPerformanceHelpers, test_throughput_runner) {
+  ThroughputRunner<std_msgs::msg::Int64> runner("throughput_topic", "throughput_topic");
+  usleep(100000);
+  auto result = runner.run([] (size_t i) {
+    std_msgs::msg::Int64 message;
+    message.data = i;
+    return message;
+  }, 100.0, std::chrono::milliseconds(200));
+  ASSERT_GE(result.sent, 19u);
+  ASSERT_LE(result.sent, 21u);
+  ASSERT_EQ(result.dropped(), 0u);
+  ASSERT_NEAR(result.sustained_rate, result.offered_rate, 1.0);
+}
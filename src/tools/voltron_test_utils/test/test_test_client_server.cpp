@@ -58,3 +58,15 @@ TEST_F(TestTestClientServer, test_simple_request) {
   std_srvs::srv::SetBool::Response received_response = this->test_client->get_response();
   ASSERT_EQ(received_response.success, true);
 }
+
+TEST_F(TestTestClientServer, test_wait_for_response) {
+  ASSERT_FALSE(this->test_client->wait_for_response(10ms));
+  std_srvs::srv::SetBool::Request request_to_send;
+  request_to_send.data = true;
+  this->test_client->send_request(request_to_send);
+  ASSERT_TRUE(this->test_server->wait_for_request());
+  ASSERT_EQ(this->test_server->get_received_request().data, true);
+  ASSERT_TRUE(this->test_client->wait_for_response());
+  ASSERT_EQ(this->test_client->get_response().message, "Default response");
+  ASSERT_GT(this->test_client->response_latency().count(), 0);
+}
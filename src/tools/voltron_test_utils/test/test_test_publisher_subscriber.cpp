@@ -50,3 +50,28 @@ TEST_F(TestTestPublisherSubscriber, test_simple_communication) {
   ASSERT_EQ(received_message->data, 123456);
   ASSERT_FALSE(this->test_subscriber->has_message_ready());
 }
+
+TEST_F(TestTestPublisherSubscriber, test_wait_for_messages) {
+  ASSERT_FALSE(this->test_subscriber->wait_for_message(std::chrono::milliseconds(10)));
+  auto message_to_send = std_msgs::msg::Int64();
+  std::chrono::steady_clock::time_point sent;
+  for(int i = 0; i < 3; i++) {
+    message_to_send.data = i;
+    sent = this->test_publisher->send_message(message_to_send);
+  }
+  ASSERT_TRUE(this->test_subscriber->wait_for_messages(3, std::chrono::seconds(1)));
+  for(int i = 0; i < 3; i++) {
+    auto received = this->test_subscriber->get_received_message();
+    ASSERT_EQ(received.message->data, i);
+  }
+  auto received = this->test_subscriber->get_received_message(std::chrono::milliseconds(10));
+  ASSERT_EQ(received.message, nullptr);
+}
+
+TEST_F(TestTestPublisherSubscriber, test_records_receive_time) {
+  auto message_to_send = std_msgs::msg::Int64();
+  auto sent = this->test_publisher->send_message(message_to_send);
+  auto received = this->test_subscriber->get_received_message();
+  ASSERT_NE(received.message, nullptr);
+  ASSERT_GE(received.received, sent);
+}
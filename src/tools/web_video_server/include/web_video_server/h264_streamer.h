@@ -12,21 +12,22 @@ namespace web_video_server
 class H264Streamer : public LibavStreamer
 {
 public:
-  H264Streamer(const async_web_server_cpp::HttpRequest& request, async_web_server_cpp::HttpConnectionPtr connection,
-              rclcpp::Node::SharedPtr nh);
+  H264Streamer(const async_web_server_cpp::HttpRequest& request, rclcpp::Node::SharedPtr nh,
+              const HardwareEncoderConfig &hardware);
   ~H264Streamer();
 protected:
   virtual void initializeEncoder();
+  void initializeX264();
   std::string preset_;
 };
 
 class H264StreamerType : public LibavStreamerType
 {
 public:
-  H264StreamerType();
-  virtual boost::shared_ptr<ImageStreamer> create_streamer(const async_web_server_cpp::HttpRequest& request,
-                                                           async_web_server_cpp::HttpConnectionPtr connection,
-                                                           rclcpp::Node::SharedPtr nh);
+  H264StreamerType(const HardwareEncoderConfig &hardware = HardwareEncoderConfig());
+protected:
+  virtual boost::shared_ptr<SharedEncoder> create_encoder(const async_web_server_cpp::HttpRequest& request,
+                                                          rclcpp::Node::SharedPtr nh);
 };
 
 }
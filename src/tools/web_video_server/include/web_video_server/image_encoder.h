@@ -0,0 +1,134 @@
+#ifndef IMAGE_ENCODER_H_
+#define IMAGE_ENCODER_H_
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <cv_bridge/cv_bridge.h>
+#include "web_video_server/shared_encoder.h"
+#include "web_video_server/stream_stats.h"
+
+namespace web_video_server
+{
+
+class BufferPool;
+
+/**
+ * Encodes images to JPEG or PNG for one stream. Output goes into buffers
+ * that come back to the encoder once every connection has written them, so
+ * a stream running steadily stops allocating. JPEG goes through TurboJPEG
+ * and PNG through libspng when the server is built with them, and through
+ * cv::imencode otherwise, or for images that aren't 8-bit BGR.
+ *
+ * Not thread-safe; a stream encodes one image at a time.
+ */
+class ImageEncoder
+{
+public:
+  enum Format
+  {
+    JPEG,
+    PNG
+  };
+
+  /**
+   * quality is the JPEG quality, 0 to 100, or the PNG compression level, 0
+   * to 9
+   */
+  ImageEncoder(Format format, int quality);
+  ~ImageEncoder();
+
+  EncodedBuffer encode(const cv::Mat &img);
+
+  const char *contentType() const;
+
+private:
+  ImageEncoder(const ImageEncoder &);
+  ImageEncoder &operator=(const ImageEncoder &);
+
+  bool encodeTurboJpeg(const cv::Mat &img, std::vector<uint8_t> &output);
+  bool encodeSpng(const cv::Mat &img, std::vector<uint8_t> &output);
+
+  Format format_;
+  int quality_;
+  std::shared_ptr<BufferPool> pool_;
+  void *turbojpeg_;  // tjhandle, made on first use
+  cv::Mat rgb_;      // libspng takes RGB
+};
+
+/**
+ * The threads every stream's images are encoded on, so that neither the
+ * image_transport callbacks nor one busy stream hold up the others.
+ */
+class EncodeWorkers
+{
+public:
+  /**
+   * Sets the number of threads; 0 picks half the cores. Only takes effect
+   * before the first image is encoded.
+   */
+  static void configure(int threads);
+
+  static void post(const std::function<void()> &job);
+
+private:
+  EncodeWorkers(int threads);
+  ~EncodeWorkers();
+
+  static EncodeWorkers &instance();
+  void run();
+
+  boost::mutex mutex_;
+  boost::condition_variable condition_;
+  std::deque<std::function<void()> > jobs_;
+  bool stopping_;
+  boost::thread_group threads_;
+};
+
+/**
+ * Hands a stream's images to the EncodeWorkers and its encoded frames back
+ * on the worker thread, in order. An image that arrives while the previous
+ * one is still being encoded waits; if a newer one arrives first, the
+ * waiting one is dropped, so a stream whose encoding falls behind shows the
+ * latest image instead of a growing backlog.
+ */
+class EncodeStage
+{
+public:
+  typedef std::function<void(const EncodedFrame &frame, StreamStats::Clock::time_point received)> Handler;
+
+  EncodeStage(ImageEncoder::Format format, int quality, const Handler &handler);
+  ~EncodeStage();
+
+  /**
+   * source, if set, owns the pixels img points into and is kept until the
+   * image is encoded. received is passed on to the handler; leave it at the
+   * epoch for images that weren't just received, e.g. restreamed ones.
+   */
+  void submit(const cv::Mat &img, const cv_bridge::CvImageConstPtr &source, const rclcpp::Time &time,
+              StreamStats::Clock::time_point received);
+
+  /**
+   * Drops any waiting image and waits for the one being encoded; the handler
+   * isn't called again after this returns. Streams call it first thing in
+   * their destructor.
+   */
+  void stop();
+
+  const char *contentType() const;
+
+private:
+  struct State;
+  static void run(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+};
+
+}
+
+#endif
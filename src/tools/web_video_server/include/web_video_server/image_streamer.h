@@ -5,12 +5,16 @@
 #include <image_transport/image_transport.hpp>
 #include <image_transport/transport_hints.hpp>
 #include <opencv2/opencv.hpp>
+#include <cv_bridge/cv_bridge.h>
+#include "web_video_server/stream_stats.h"
 #include "async_web_server_cpp/http_server.hpp"
 #include "async_web_server_cpp/http_request.hpp"
 
 namespace web_video_server
 {
 
+class Mosaic;
+
 class ImageStreamer
 {
 public:
@@ -21,7 +25,7 @@ public:
   virtual void start() = 0;
   virtual ~ImageStreamer();
 
-  bool isInactive()
+  virtual bool isInactive()
   {
     return inactive_;
   }
@@ -37,6 +41,28 @@ public:
     return topic_;
   }
   ;
+
+  const async_web_server_cpp::HttpRequest &getRequest()
+  {
+    return request_;
+  }
+
+  /**
+   * Input rate, encoding rate and latency of the encoder behind this stream.
+   * Streams that share an encoder return the same object.
+   */
+  virtual StreamStats &encoderStats()
+  {
+    return stats_;
+  }
+
+  /**
+   * Bytes sent and frames dropped on this connection alone.
+   */
+  StreamStats &connectionStats()
+  {
+    return stats_;
+  }
 protected:
   async_web_server_cpp::HttpConnectionPtr connection_;
   async_web_server_cpp::HttpRequest request_;
@@ -44,6 +70,7 @@ protected:
   bool inactive_;
   image_transport::Subscriber image_sub_;
   std::string topic_;
+  StreamStats stats_;
 };
 
 
@@ -61,6 +88,11 @@ protected:
   virtual void restreamFrame(double max_age);
   virtual void initialize(const cv::Mat &);
 
+  /**
+   * Lets a subclass skip an image before any work is done on it.
+   */
+  virtual bool skipFrame() { return false; }
+
   image_transport::Subscriber image_sub_;
   int output_width_;
   int output_height_;
@@ -69,13 +101,30 @@ protected:
 
   rclcpp::Time last_frame;
   cv::Mat output_size_image;
+  // Message output_size_image may still point into, kept for restreaming
+  cv_bridge::CvImageConstPtr output_image_source_;
   boost::mutex send_mutex_;
 
+  // When the image in sendImage() was received, or the epoch if it is being
+  // restreamed
+  StreamStats::Clock::time_point image_received_;
+  // Set by streams that encode off the image callback and record each
+  // encode in stats_ themselves once it is done
+  bool encodes_in_background_;
+
 private:
   image_transport::ImageTransport it_;
   bool initialized_;
+  boost::shared_ptr<Mosaic> mosaic_; // set when streaming several topics tiled together
 
   void imageCallback(const sensor_msgs::msg::Image::ConstSharedPtr &msg);
+  void mosaicCallback(const cv::Mat &img);
+
+  /**
+   * Resizes, inverts and sends an image once it has been converted to BGR.
+   * source is kept while the image may still point into it.
+   */
+  void processImage(cv::Mat img, const cv_bridge::CvImageConstPtr &source, StreamStats::Clock::time_point received);
 };
 
 class ImageStreamerType
@@ -86,6 +135,13 @@ public:
                                                            rclcpp::Node::SharedPtr nh) = 0;
 
   virtual std::string create_viewer(const async_web_server_cpp::HttpRequest &request) = 0;
+
+  /**
+   * Called periodically after inactive streams have been removed.
+   */
+  virtual void cleanup()
+  {
+  }
 };
 
 }
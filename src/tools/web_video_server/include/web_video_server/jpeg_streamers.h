@@ -6,44 +6,52 @@
 #include "async_web_server_cpp/http_request.hpp"
 #include "async_web_server_cpp/http_connection.hpp"
 #include "web_video_server/multipart_stream.h"
+#include "web_video_server/shared_encoder.h"
+#include "web_video_server/image_encoder.h"
 
 namespace web_video_server
 {
 
-class MjpegStreamer : public ImageTransportImageStreamer
+/**
+ * Encodes on the EncodeWorkers, so sendImage() only hands the image over.
+ */
+class MjpegStreamer : public SharedEncoder
 {
 public:
-  MjpegStreamer(const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
-                rclcpp::Node::SharedPtr nh);
+  MjpegStreamer(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh);
   ~MjpegStreamer();
 protected:
   virtual void sendImage(const cv::Mat &, const rclcpp::Time &time);
 
 private:
-  MultipartStream stream_;
-  int quality_;
+  void onEncoded(const EncodedFrame &frame, StreamStats::Clock::time_point received);
+
+  EncodeStage stage_;
 };
 
-class MjpegStreamerType : public ImageStreamerType
+class MjpegClient : public SharedStreamClient
 {
 public:
-  boost::shared_ptr<ImageStreamer> create_streamer(const async_web_server_cpp::HttpRequest &request,
-                                                   async_web_server_cpp::HttpConnectionPtr connection,
-                                                   rclcpp::Node::SharedPtr nh);
-  std::string create_viewer(const async_web_server_cpp::HttpRequest &request);
+  MjpegClient(const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
+              rclcpp::Node::SharedPtr nh, boost::shared_ptr<SharedEncoder> encoder);
+  virtual void sendFrame(const EncodedFrame &frame);
+
+private:
+  MultipartStream stream_;
 };
 
-class JpegSnapshotStreamer : public ImageTransportImageStreamer
+class MjpegStreamerType : public SharedStreamerType
 {
 public:
-  JpegSnapshotStreamer(const async_web_server_cpp::HttpRequest &request,
-                       async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh);
-  ~JpegSnapshotStreamer();
-protected:
-  virtual void sendImage(const cv::Mat &, const rclcpp::Time &time);
+  std::string create_viewer(const async_web_server_cpp::HttpRequest &request);
 
-private:
-  int quality_;
+protected:
+  boost::shared_ptr<SharedEncoder> create_encoder(const async_web_server_cpp::HttpRequest &request,
+                                                  rclcpp::Node::SharedPtr nh);
+  boost::shared_ptr<SharedStreamClient> create_client(const async_web_server_cpp::HttpRequest &request,
+                                                      async_web_server_cpp::HttpConnectionPtr connection,
+                                                      rclcpp::Node::SharedPtr nh,
+                                                      boost::shared_ptr<SharedEncoder> encoder);
 };
 
 }
@@ -3,6 +3,7 @@
 
 #include <image_transport/image_transport.hpp>
 #include "web_video_server/image_streamer.h"
+#include "web_video_server/shared_encoder.h"
 #include "async_web_server_cpp/http_request.hpp"
 #include "async_web_server_cpp/http_connection.hpp"
 
@@ -18,15 +19,36 @@ extern "C"
 #include <libavutil/imgutils.h>
 }
 
+// Hardware device and frame contexts for encoders
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 64, 100)
+extern "C"
+{
+#include <libavutil/hwcontext.h>
+}
+#define WEB_VIDEO_SERVER_HW_ENCODING
+#endif
+
 namespace web_video_server
 {
 
-class LibavStreamer : public ImageTransportImageStreamer
+/**
+ * Which hardware encoder a stream type tries before falling back to its
+ * software codec.
+ */
+struct HardwareEncoderConfig
+{
+  HardwareEncoderConfig() : accel("none") {}
+
+  std::string accel;   // "none", "auto", "nvenc", "vaapi" or "v4l2m2m"
+  std::string device;  // VAAPI render node; empty for the default one
+};
+
+class LibavStreamer : public SharedEncoder
 {
 public:
-  LibavStreamer(const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
-                rclcpp::Node::SharedPtr nh, const std::string &format_name, const std::string &codec_name,
-                const std::string &content_type);
+  LibavStreamer(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh,
+                const std::string &format_name, const std::string &codec_name,
+                const HardwareEncoderConfig &hardware = HardwareEncoderConfig());
 
   ~LibavStreamer();
 
@@ -41,35 +63,82 @@ protected:
   AVStream* video_stream_;
 
   AVDictionary* opt_;   // container format options
+  std::string accel_;   // hardware encoder in use, empty for software
+
 
 private:
+  EncodedBuffer takeOutput();
+
+  /**
+   * (accel, encoder name) pairs to try, in order, for this stream's codec.
+   */
+  std::vector<std::pair<std::string, std::string> > hardwareEncoders();
+
+  /**
+   * Configures and opens codec_context_ with the given encoder. Returns
+   * false, with nothing left allocated, if it can't be opened.
+   */
+  bool openCodec(AVCodec* codec, const std::string &accel);
+#ifdef WEB_VIDEO_SERVER_HW_ENCODING
+  bool initializeVaapi();
+  void releaseHardware();
+#endif
+
   AVFrame* frame_;
+  AVFrame* hw_frame_;  // GPU surface frame_ is uploaded to, for VAAPI
+  AVBufferRef* hw_device_context_;
+  AVBufferRef* hw_frames_context_;
+  AVPixelFormat frame_format_;  // what frame_ holds after colour conversion
   struct SwsContext* sws_context_;
   rclcpp::Time first_image_timestamp_;
   boost::mutex encode_mutex_;
 
   std::string format_name_;
   std::string codec_name_;
-  std::string content_type_;
+  HardwareEncoderConfig hardware_;
   int bitrate_;
   int qmin_;
   int qmax_;
   int gop_;
 
   uint8_t* io_buffer_;  // custom IO buffer
+  std::vector<uint8_t> output_;  // muxer output not yet published
 };
 
-class LibavStreamerType : public ImageStreamerType
+class LibavClient : public SharedStreamClient
 {
 public:
-  LibavStreamerType(const std::string &format_name, const std::string &codec_name, const std::string &content_type);
+  LibavClient(const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
+              rclcpp::Node::SharedPtr nh, boost::shared_ptr<SharedEncoder> encoder,
+              const std::string &content_type);
+
+  virtual void sendHeader(const EncodedBuffer &header);
+  virtual void sendFrame(const EncodedFrame &frame);
 
-  boost::shared_ptr<ImageStreamer> create_streamer(const async_web_server_cpp::HttpRequest &request,
-                                                   async_web_server_cpp::HttpConnectionPtr connection,
-                                                   rclcpp::Node::SharedPtr nh);
+private:
+  std::string content_type_;
+  bool header_sent_;
+  bool waiting_for_keyframe_;
+};
+
+class LibavStreamerType : public SharedStreamerType
+{
+public:
+  LibavStreamerType(const std::string &format_name, const std::string &codec_name, const std::string &content_type,
+                    const HardwareEncoderConfig &hardware = HardwareEncoderConfig());
 
   std::string create_viewer(const async_web_server_cpp::HttpRequest &request);
 
+protected:
+  virtual boost::shared_ptr<SharedEncoder> create_encoder(const async_web_server_cpp::HttpRequest &request,
+                                                          rclcpp::Node::SharedPtr nh);
+  boost::shared_ptr<SharedStreamClient> create_client(const async_web_server_cpp::HttpRequest &request,
+                                                      async_web_server_cpp::HttpConnectionPtr connection,
+                                                      rclcpp::Node::SharedPtr nh,
+                                                      boost::shared_ptr<SharedEncoder> encoder);
+
+  const HardwareEncoderConfig hardware_;
+
 private:
   const std::string format_name_;
   const std::string codec_name_;
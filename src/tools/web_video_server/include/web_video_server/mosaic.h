@@ -0,0 +1,59 @@
+#ifndef MOSAIC_H_
+#define MOSAIC_H_
+
+#include <rclcpp/rclcpp.hpp>
+#include <image_transport/image_transport.hpp>
+#include <opencv2/opencv.hpp>
+#include <boost/thread/mutex.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace web_video_server
+{
+
+/**
+ * Subscribes to several image topics and tiles the latest image from each
+ * into one frame, handed on at a fixed rate.
+ */
+class Mosaic
+{
+public:
+  typedef std::function<void(const cv::Mat &)> FrameCallback;
+
+  /**
+   * Tiles are laid out left to right, top to bottom, columns to a row, and
+   * each camera is scaled to fit its tile.
+   */
+  Mosaic(rclcpp::Node::SharedPtr nh, const std::vector<std::string> &topics, int columns,
+         int width, int height, double rate, const std::string &default_transport, FrameCallback callback);
+
+  void start();
+
+  /**
+   * Splits a comma-separated topic list, as given in a mosaic request.
+   */
+  static std::vector<std::string> parseTopics(const std::string &topics);
+
+private:
+  void imageCallback(size_t tile, const sensor_msgs::msg::Image::ConstSharedPtr &msg);
+  void compose();
+
+  rclcpp::Node::SharedPtr nh_;
+  image_transport::ImageTransport it_;
+  std::vector<std::string> topics_;
+  std::vector<image_transport::Subscriber> subscribers_;
+  rclcpp::TimerBase::SharedPtr timer_;
+  double rate_;
+  std::string default_transport_;
+  FrameCallback callback_;
+
+  boost::mutex canvas_mutex_;
+  cv::Mat canvas_; // each image is scaled straight into its tile
+  std::vector<cv::Rect> tiles_;
+  bool updated_;
+};
+
+}
+
+#endif
@@ -24,8 +24,10 @@ public:
   void sendInitialHeader();
   void sendPartHeader(const rclcpp::Time &time, const std::string& type, size_t payload_size);
   void sendPartFooter(const rclcpp::Time &time);
-  void sendPartAndClear(const rclcpp::Time &time, const std::string& type, std::vector<unsigned char> &data);
-  void sendPart(const rclcpp::Time &time, const std::string& type, const boost::asio::const_buffer &buffer,
+  // The send functions return false when the part was dropped because the
+  // connection still had max_queue_size parts in flight
+  bool sendPartAndClear(const rclcpp::Time &time, const std::string& type, std::vector<unsigned char> &data);
+  bool sendPart(const rclcpp::Time &time, const std::string& type, const boost::asio::const_buffer &buffer,
 		async_web_server_cpp::HttpConnection::ResourcePtr resource);
 
 private:
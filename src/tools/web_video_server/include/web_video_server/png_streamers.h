@@ -6,31 +6,52 @@
 #include "async_web_server_cpp/http_request.hpp"
 #include "async_web_server_cpp/http_connection.hpp"
 #include "web_video_server/multipart_stream.h"
+#include "web_video_server/shared_encoder.h"
+#include "web_video_server/image_encoder.h"
 
 namespace web_video_server
 {
 
-class PngStreamer : public ImageTransportImageStreamer
+/**
+ * Encodes on the EncodeWorkers, so sendImage() only hands the image over.
+ */
+class PngStreamer : public SharedEncoder
 {
 public:
-  PngStreamer(const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
-              rclcpp::Node::SharedPtr nh);
+  PngStreamer(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh);
   ~PngStreamer();
 protected:
   virtual void sendImage(const cv::Mat &, const rclcpp::Time &time);
 
+private:
+  void onEncoded(const EncodedFrame &frame, StreamStats::Clock::time_point received);
+
+  EncodeStage stage_;
+};
+
+class PngClient : public SharedStreamClient
+{
+public:
+  PngClient(const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
+            rclcpp::Node::SharedPtr nh, boost::shared_ptr<SharedEncoder> encoder);
+  virtual void sendFrame(const EncodedFrame &frame);
+
 private:
   MultipartStream stream_;
-  int quality_;
 };
 
-class PngStreamerType : public ImageStreamerType
+class PngStreamerType : public SharedStreamerType
 {
 public:
-  boost::shared_ptr<ImageStreamer> create_streamer(const async_web_server_cpp::HttpRequest &request,
-                                                   async_web_server_cpp::HttpConnectionPtr connection,
-                                                   rclcpp::Node::SharedPtr nh);
   std::string create_viewer(const async_web_server_cpp::HttpRequest &request);
+
+protected:
+  boost::shared_ptr<SharedEncoder> create_encoder(const async_web_server_cpp::HttpRequest &request,
+                                                  rclcpp::Node::SharedPtr nh);
+  boost::shared_ptr<SharedStreamClient> create_client(const async_web_server_cpp::HttpRequest &request,
+                                                      async_web_server_cpp::HttpConnectionPtr connection,
+                                                      rclcpp::Node::SharedPtr nh,
+                                                      boost::shared_ptr<SharedEncoder> encoder);
 };
 
 class PngSnapshotStreamer : public ImageTransportImageStreamer
@@ -43,7 +64,7 @@ protected:
   virtual void sendImage(const cv::Mat &, const rclcpp::Time &time);
 
 private:
-  int quality_;
+  ImageEncoder encoder_;
 };
 
 }
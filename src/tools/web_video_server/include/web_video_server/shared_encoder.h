@@ -0,0 +1,208 @@
+#ifndef SHARED_ENCODER_H_
+#define SHARED_ENCODER_H_
+
+#include <rclcpp/rclcpp.hpp>
+#include <boost/weak_ptr.hpp>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <queue>
+#include <vector>
+#include "web_video_server/image_streamer.h"
+#include "async_web_server_cpp/http_request.hpp"
+#include "async_web_server_cpp/http_connection.hpp"
+
+namespace web_video_server
+{
+
+/**
+ * Encoded bytes shared by every connection they are written to. Connections
+ * hold a reference until their write completes, so the buffer is freed
+ * after the slowest client is done with it.
+ */
+typedef std::shared_ptr<const std::vector<uint8_t> > EncodedBuffer;
+
+struct EncodedFrame
+{
+  rclcpp::Time time;
+  EncodedBuffer data;
+  bool keyframe; // a client can start decoding with this frame
+};
+
+class SharedEncoder;
+
+struct PendingWrite {
+  rclcpp::Time timestamp;
+  std::weak_ptr<const void> contents;
+  std::size_t size;
+};
+
+/**
+ * How fast a client has drained its writes since it was last asked.
+ */
+struct SendReport {
+  double bytes_per_second;
+  bool fell_behind; // the client dropped a frame because its queue was full
+};
+
+/**
+ * One HTTP connection attached to a SharedEncoder. Each client decides for
+ * itself which frames it is too slow to take.
+ */
+class SharedStreamClient : public ImageStreamer
+{
+public:
+  SharedStreamClient(const async_web_server_cpp::HttpRequest &request,
+                     async_web_server_cpp::HttpConnectionPtr connection,
+                     rclcpp::Node::SharedPtr nh, boost::shared_ptr<SharedEncoder> encoder,
+                     std::size_t default_max_queue_size);
+  virtual ~SharedStreamClient();
+
+  /**
+   * The encoder is started when it is created, so there is nothing left to
+   * do here.
+   */
+  virtual void start();
+
+  virtual bool isInactive();
+
+  virtual StreamStats &encoderStats();
+
+  /**
+   * Forwarded to the encoder, which re-encodes once for all of its clients.
+   */
+  virtual void restreamFrame(double max_age);
+
+  /**
+   * Called once with the stream header, before any frame, by encoders that
+   * produce one.
+   */
+  virtual void sendHeader(const EncodedBuffer &header);
+
+  virtual void sendFrame(const EncodedFrame &frame) = 0;
+
+  /**
+   * Run by the encoder; a client whose connection fails is marked inactive
+   * without disturbing the others.
+   */
+  void deliverHeader(const EncodedBuffer &header);
+  void deliverFrame(const EncodedFrame &frame);
+
+  SendReport takeSendReport(double elapsed);
+
+protected:
+  /**
+   * True while the connection still has max_queue_size writes in flight.
+   * Completed writes are counted towards the send rate as they are found.
+   */
+  bool isBusy();
+
+  /**
+   * Returns the resource to hand to the connection along with frame's
+   * buffer; the write counts as queued until the connection releases it.
+   */
+  async_web_server_cpp::HttpConnection::ResourcePtr trackWrite(const EncodedFrame &frame);
+
+  /**
+   * Records a frame skipped because the connection was busy.
+   */
+  void dropFrame();
+
+  boost::shared_ptr<SharedEncoder> encoder_;
+
+private:
+  std::size_t max_queue_size_;
+  std::queue<PendingWrite> pending_writes_;
+  std::size_t completed_bytes_;
+  bool fell_behind_;
+};
+
+/**
+ * Subscribes to a topic and encodes each image once for every client that
+ * asked for the same topic, format, size and quality.
+ */
+class SharedEncoder : public ImageTransportImageStreamer
+{
+public:
+  SharedEncoder(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh);
+  virtual ~SharedEncoder();
+
+  void addClient(const boost::shared_ptr<SharedStreamClient> &client);
+  bool hasClients();
+
+  /**
+   * Every client forwards the server's restream tick; only the first in each
+   * period re-encodes.
+   */
+  virtual void restreamFrame(double max_age);
+
+  /**
+   * Asks for the next frame to be encoded as a keyframe, for a client that
+   * has just joined or has dropped frames.
+   */
+  void requestKeyframe();
+
+protected:
+  /**
+   * Skips images while every client is falling behind, so that no more is
+   * encoded than the fastest of them can take.
+   */
+  virtual bool skipFrame();
+
+  void publishHeader(const EncodedBuffer &header);
+  void publishFrame(const EncodedFrame &frame);
+  bool takeKeyframeRequest();
+
+private:
+  void adaptFrameRate(double elapsed);
+
+  boost::mutex clients_mutex_;
+  std::vector<boost::weak_ptr<SharedStreamClient> > clients_;
+  EncodedBuffer header_;
+
+  // Share of incoming images that is encoded, set once a second from the
+  // clients' send rates
+  double frame_fraction_;
+  double frame_credit_;
+  rclcpp::Time rate_window_start_;
+  std::size_t produced_bytes_;
+
+  boost::mutex restream_mutex_;
+  rclcpp::Time last_restream_;
+
+  std::atomic<bool> keyframe_requested_;
+};
+
+/**
+ * Stream type whose connections share one encoder per distinct request.
+ */
+class SharedStreamerType : public ImageStreamerType
+{
+public:
+  boost::shared_ptr<ImageStreamer> create_streamer(const async_web_server_cpp::HttpRequest &request,
+                                                   async_web_server_cpp::HttpConnectionPtr connection,
+                                                   rclcpp::Node::SharedPtr nh);
+
+  /**
+   * Drops encoders that no client uses any more. This runs on the cleanup
+   * timer, never from inside an encoder's own image callback.
+   */
+  virtual void cleanup();
+
+protected:
+  virtual boost::shared_ptr<SharedEncoder> create_encoder(const async_web_server_cpp::HttpRequest &request,
+                                                          rclcpp::Node::SharedPtr nh) = 0;
+
+  virtual boost::shared_ptr<SharedStreamClient> create_client(const async_web_server_cpp::HttpRequest &request,
+                                                              async_web_server_cpp::HttpConnectionPtr connection,
+                                                              rclcpp::Node::SharedPtr nh,
+                                                              boost::shared_ptr<SharedEncoder> encoder) = 0;
+
+private:
+  boost::mutex encoders_mutex_;
+  std::map<std::string, boost::shared_ptr<SharedEncoder> > encoders_;
+};
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef SNAPSHOT_CACHE_H_
+#define SNAPSHOT_CACHE_H_
+
+#include <rclcpp/rclcpp.hpp>
+#include <map>
+#include <vector>
+#include "web_video_server/image_streamer.h"
+#include "web_video_server/shared_encoder.h"
+#include "web_video_server/image_encoder.h"
+#include "async_web_server_cpp/http_request.hpp"
+#include "async_web_server_cpp/http_connection.hpp"
+
+namespace web_video_server
+{
+
+struct PendingSnapshot
+{
+  async_web_server_cpp::HttpConnectionPtr connection;
+  rclcpp::Time requested;
+};
+
+/**
+ * Stays subscribed to one topic and keeps its latest image, to answer
+ * snapshot requests with a JPEG from memory. Each image is encoded at most
+ * once, and only when a request asks for it.
+ */
+class SnapshotEncoder : public ImageTransportImageStreamer
+{
+public:
+  SnapshotEncoder(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh);
+  ~SnapshotEncoder();
+
+  /**
+   * Replies with the latest image if it is at most max_age seconds old, or
+   * else with the next one to arrive.
+   */
+  void serve(async_web_server_cpp::HttpConnectionPtr connection, double max_age);
+
+  /**
+   * Answers requests that have waited more than timeout seconds for an image
+   * with an error. Returns true once no request has come in for that long.
+   */
+  bool expire(double timeout);
+
+protected:
+  virtual void sendImage(const cv::Mat &, const rclcpp::Time &time);
+
+private:
+  // Both run with send_mutex_ held
+  const EncodedFrame &encodeLatest();
+  void reply(async_web_server_cpp::HttpConnectionPtr connection, const EncodedFrame &frame);
+
+  ImageEncoder encoder_;
+  EncodedFrame cached_; // the JPEG for last_frame, once someone asked for it
+  std::vector<PendingSnapshot> pending_;
+  rclcpp::Time last_request_;
+};
+
+/**
+ * Snapshot encoders by request, so that clients polling the same topic at
+ * the same size and quality share one subscription.
+ */
+class SnapshotCache
+{
+public:
+  SnapshotCache(rclcpp::Node::SharedPtr nh, double max_age, double timeout);
+
+  void serve(const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
+             const char* begin, const char* end);
+
+  /**
+   * Unsubscribes from topics nobody has asked for recently.
+   */
+  void cleanup();
+
+  std::vector<boost::shared_ptr<ImageStreamer> > streamers();
+
+private:
+  rclcpp::Node::SharedPtr nh_;
+  double max_age_;
+  double timeout_;
+  boost::mutex encoders_mutex_;
+  std::map<std::string, boost::shared_ptr<SnapshotEncoder> > encoders_;
+};
+
+}
+
+#endif
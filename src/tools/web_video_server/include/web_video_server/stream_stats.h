@@ -0,0 +1,56 @@
+#ifndef STREAM_STATS_H_
+#define STREAM_STATS_H_
+
+#include <boost/thread/mutex.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+namespace web_video_server
+{
+
+struct StreamStatsReport
+{
+  double input_fps;
+  double encoded_fps;
+  double latency_p50; // seconds from receiving an image to handing it on
+  double latency_p99;
+  uint64_t bytes_sent;
+  uint64_t dropped_frames;
+};
+
+/**
+ * Counters for one stream, safe to update from the image callbacks while the
+ * server reads them. Rates and latencies cover the last few seconds; bytes
+ * and drops are totals.
+ */
+class StreamStats
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  StreamStats();
+
+  void recordInput();
+  void recordEncoded(Clock::time_point received);
+  void recordSent(std::size_t bytes);
+  void recordDropped();
+
+  StreamStatsReport report();
+
+private:
+  void trim(Clock::time_point now);
+  double window(Clock::time_point now) const;
+
+  boost::mutex mutex_;
+  Clock::time_point created_;
+  std::deque<Clock::time_point> inputs_;
+  std::deque<Clock::time_point> encodes_;
+  std::deque<double> latencies_; // matches encodes_
+  uint64_t bytes_sent_;
+  uint64_t dropped_frames_;
+};
+
+}
+
+#endif
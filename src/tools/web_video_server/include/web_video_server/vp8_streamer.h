@@ -48,8 +48,8 @@ namespace web_video_server
 class Vp8Streamer : public LibavStreamer
 {
 public:
-  Vp8Streamer(const async_web_server_cpp::HttpRequest& request, async_web_server_cpp::HttpConnectionPtr connection,
-              rclcpp::Node::SharedPtr nh);
+  Vp8Streamer(const async_web_server_cpp::HttpRequest& request, rclcpp::Node::SharedPtr nh,
+              const HardwareEncoderConfig &hardware);
   ~Vp8Streamer();
 protected:
   virtual void initializeEncoder();
@@ -60,10 +60,10 @@ private:
 class Vp8StreamerType : public LibavStreamerType
 {
 public:
-  Vp8StreamerType();
-  virtual boost::shared_ptr<ImageStreamer> create_streamer(const async_web_server_cpp::HttpRequest& request,
-                                                           async_web_server_cpp::HttpConnectionPtr connection,
-                                                           rclcpp::Node::SharedPtr nh);
+  Vp8StreamerType(const HardwareEncoderConfig &hardware = HardwareEncoderConfig());
+protected:
+  virtual boost::shared_ptr<SharedEncoder> create_encoder(const async_web_server_cpp::HttpRequest& request,
+                                                          rclcpp::Node::SharedPtr nh);
 };
 
 }
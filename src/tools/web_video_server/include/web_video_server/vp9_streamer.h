@@ -12,8 +12,8 @@ namespace web_video_server
 class Vp9Streamer : public LibavStreamer
 {
 public:
-  Vp9Streamer(const async_web_server_cpp::HttpRequest& request, async_web_server_cpp::HttpConnectionPtr connection,
-              rclcpp::Node::SharedPtr nh);
+  Vp9Streamer(const async_web_server_cpp::HttpRequest& request, rclcpp::Node::SharedPtr nh,
+              const HardwareEncoderConfig &hardware);
   ~Vp9Streamer();
 protected:
   virtual void initializeEncoder();
@@ -22,10 +22,10 @@ protected:
 class Vp9StreamerType : public LibavStreamerType
 {
 public:
-  Vp9StreamerType();
-  virtual boost::shared_ptr<ImageStreamer> create_streamer(const async_web_server_cpp::HttpRequest& request,
-                                                           async_web_server_cpp::HttpConnectionPtr connection,
-                                                           rclcpp::Node::SharedPtr nh);
+  Vp9StreamerType(const HardwareEncoderConfig &hardware = HardwareEncoderConfig());
+protected:
+  virtual boost::shared_ptr<SharedEncoder> create_encoder(const async_web_server_cpp::HttpRequest& request,
+                                                          rclcpp::Node::SharedPtr nh);
 };
 
 }
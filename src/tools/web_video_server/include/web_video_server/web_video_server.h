@@ -3,8 +3,10 @@
 
 #include <rclcpp/rclcpp.hpp>
 #include <cv_bridge/cv_bridge.h>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
 #include <vector>
 #include "web_video_server/image_streamer.h"
+#include "web_video_server/snapshot_cache.h"
 #include "async_web_server_cpp/http_server.hpp"
 #include "async_web_server_cpp/http_request.hpp"
 #include "async_web_server_cpp/http_connection.hpp"
@@ -12,6 +14,18 @@
 namespace web_video_server
 {
 
+/**
+ * Stats for one encoder and the connections it currently serves. Bytes and
+ * drops are summed over those connections only.
+ */
+struct StreamSummary
+{
+  std::string topic;
+  std::string type;
+  int clients;
+  StreamStatsReport stats;
+};
+
 /**
  * @class WebVideoServer
  * @brief
@@ -43,19 +57,30 @@ public:
   bool handle_stream_viewer(const async_web_server_cpp::HttpRequest &request,
                             async_web_server_cpp::HttpConnectionPtr connection, const char* begin, const char* end);
 
+  bool handle_mosaic(const async_web_server_cpp::HttpRequest &request,
+                     async_web_server_cpp::HttpConnectionPtr connection, const char* begin, const char* end);
+
   bool handle_snapshot(const async_web_server_cpp::HttpRequest &request,
                        async_web_server_cpp::HttpConnectionPtr connection, const char* begin, const char* end);
 
   bool handle_list_streams(const async_web_server_cpp::HttpRequest &request,
                            async_web_server_cpp::HttpConnectionPtr connection, const char* begin, const char* end);
 
+  bool handle_stats(const async_web_server_cpp::HttpRequest &request,
+                    async_web_server_cpp::HttpConnectionPtr connection, const char* begin, const char* end);
+
 private:
   void restreamFrames(double max_age);
   void cleanup_inactive_streams();
+  std::vector<StreamSummary> collect_stats();
+  void publish_diagnostics();
 
   rclcpp::Node::SharedPtr nh_;
   rclcpp::WallTimer<rclcpp::VoidCallbackType>::SharedPtr cleanup_timer_;
+  rclcpp::WallTimer<rclcpp::VoidCallbackType>::SharedPtr diagnostics_timer_;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub_;
   int ros_threads_;
+  int server_threads_;
   double publish_rate_;
   int port_;
   std::string address_;
@@ -63,6 +88,7 @@ private:
   async_web_server_cpp::HttpRequestHandlerGroup handler_group_;
 
   std::vector<boost::shared_ptr<ImageStreamer> > image_subscribers_;
+  boost::shared_ptr<SnapshotCache> snapshot_cache_;
   std::map<std::string, boost::shared_ptr<ImageStreamerType> > stream_types_;
   boost::mutex subscriber_mutex_;
 };
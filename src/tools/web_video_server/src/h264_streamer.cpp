@@ -3,9 +3,9 @@
 namespace web_video_server
 {
 
-H264Streamer::H264Streamer(const async_web_server_cpp::HttpRequest& request,
-                         async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh) :
-    LibavStreamer(request, connection, nh, "mp4", "libx264", "video/mp4")
+H264Streamer::H264Streamer(const async_web_server_cpp::HttpRequest& request, rclcpp::Node::SharedPtr nh,
+                         const HardwareEncoderConfig &hardware) :
+    LibavStreamer(request, nh, "mp4", "libx264", hardware)
 {
   /* possible quality presets:
    * ultrafast, superfast, veryfast, faster, fast, medium, slow, slower, veryslow, placebo
@@ -20,12 +20,11 @@ H264Streamer::~H264Streamer()
 
 void H264Streamer::initializeEncoder()
 {
-  av_opt_set(codec_context_->priv_data, "preset", preset_.c_str(), 0);
-  av_opt_set(codec_context_->priv_data, "tune", "zerolatency", 0);
-  av_opt_set_int(codec_context_->priv_data, "crf", 20, 0);
-  av_opt_set_int(codec_context_->priv_data, "bufsize", 100, 0);
-  av_opt_set_int(codec_context_->priv_data, "keyint", 30, 0);
-  av_opt_set_int(codec_context_->priv_data, "g", 1, 0);
+  // The x264 tuning below means nothing to hardware encoders
+  if (accel_.empty())
+  {
+    initializeX264();
+  }
 
   // container format options
   if (!strcmp(format_context_->oformat->name, "mp4")) {
@@ -34,16 +33,25 @@ void H264Streamer::initializeEncoder()
   }
 }
 
-H264StreamerType::H264StreamerType() :
-    LibavStreamerType("mp4", "libx264", "video/mp4")
+void H264Streamer::initializeX264()
+{
+  av_opt_set(codec_context_->priv_data, "preset", preset_.c_str(), 0);
+  av_opt_set(codec_context_->priv_data, "tune", "zerolatency", 0);
+  av_opt_set_int(codec_context_->priv_data, "crf", 20, 0);
+  av_opt_set_int(codec_context_->priv_data, "bufsize", 100, 0);
+  av_opt_set_int(codec_context_->priv_data, "keyint", 30, 0);
+  av_opt_set_int(codec_context_->priv_data, "g", 1, 0);
+}
+
+H264StreamerType::H264StreamerType(const HardwareEncoderConfig &hardware) :
+    LibavStreamerType("mp4", "libx264", "video/mp4", hardware)
 {
 }
 
-boost::shared_ptr<ImageStreamer> H264StreamerType::create_streamer(const async_web_server_cpp::HttpRequest& request,
-                                                                  async_web_server_cpp::HttpConnectionPtr connection,
-                                                                  rclcpp::Node::SharedPtr nh)
+boost::shared_ptr<SharedEncoder> H264StreamerType::create_encoder(const async_web_server_cpp::HttpRequest& request,
+                                                                 rclcpp::Node::SharedPtr nh)
 {
-  return boost::shared_ptr<ImageStreamer>(new H264Streamer(request, connection, nh));
+  return boost::shared_ptr<SharedEncoder>(new H264Streamer(request, nh, hardware_));
 }
 
 }
@@ -0,0 +1,377 @@
+#include "web_video_server/image_encoder.h"
+#include "nova_trace/Trace.hpp"
+#include <algorithm>
+#include <cstring>
+#ifdef WEB_VIDEO_SERVER_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+#ifdef WEB_VIDEO_SERVER_SPNG
+#include <spng.h>
+#endif
+
+namespace web_video_server
+{
+
+/**
+ * Output buffers an encoder is done with. A buffer comes back when the last
+ * connection writing it lets go, which may be after the encoder is gone.
+ */
+class BufferPool
+{
+public:
+  ~BufferPool()
+  {
+    for (size_t i = 0; i < free_.size(); ++i)
+      delete free_[i];
+  }
+
+  std::vector<uint8_t> *take()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    if (free_.empty())
+      return new std::vector<uint8_t>();
+    std::vector<uint8_t> *buffer = free_.back();
+    free_.pop_back();
+    return buffer;
+  }
+
+  static void recycle(const std::weak_ptr<BufferPool> &weak_pool, const std::vector<uint8_t> *buffer)
+  {
+    std::vector<uint8_t> *writable = const_cast<std::vector<uint8_t> *>(buffer);
+    std::shared_ptr<BufferPool> pool = weak_pool.lock();
+    if (pool)
+    {
+      boost::mutex::scoped_lock lock(pool->mutex_);
+      // A few frames are in flight at once on a steady stream; more than
+      // that are left over from a burst and not worth keeping
+      if (pool->free_.size() < 4)
+      {
+        pool->free_.push_back(writable);
+        return;
+      }
+    }
+    delete writable;
+  }
+
+private:
+  boost::mutex mutex_;
+  std::vector<std::vector<uint8_t> *> free_;
+};
+
+namespace
+{
+
+#ifdef WEB_VIDEO_SERVER_SPNG
+int appendToBuffer(spng_ctx *, void *user, void *data, size_t length)
+{
+  std::vector<uint8_t> *output = static_cast<std::vector<uint8_t> *>(user);
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  output->insert(output->end(), bytes, bytes + length);
+  return 0;
+}
+#endif
+
+}
+
+ImageEncoder::ImageEncoder(Format format, int quality) :
+    format_(format), quality_(quality), pool_(new BufferPool()), turbojpeg_(NULL)
+{
+}
+
+ImageEncoder::~ImageEncoder()
+{
+#ifdef WEB_VIDEO_SERVER_TURBOJPEG
+  if (turbojpeg_)
+    tjDestroy(turbojpeg_);
+#endif
+}
+
+EncodedBuffer ImageEncoder::encode(const cv::Mat &img)
+{
+  std::vector<uint8_t> *output = pool_->take();
+  // The vector keeps its capacity, so once the buffers have grown to the
+  // stream's frame size nothing below allocates
+  output->clear();
+  EncodedBuffer buffer(output, std::bind(&BufferPool::recycle, std::weak_ptr<BufferPool>(pool_),
+                                         std::placeholders::_1));
+  if (format_ == JPEG)
+  {
+    NOVA_TRACE_SPAN("web_video_server.jpeg_encode");
+    if (!encodeTurboJpeg(img, *output))
+    {
+      std::vector<int> encode_params;
+      encode_params.push_back(cv::IMWRITE_JPEG_QUALITY);
+      encode_params.push_back(quality_);
+      cv::imencode(".jpeg", img, *output, encode_params);
+    }
+  }
+  else
+  {
+    NOVA_TRACE_SPAN("web_video_server.png_encode");
+    if (!encodeSpng(img, *output))
+    {
+      std::vector<int> encode_params;
+      encode_params.push_back(cv::IMWRITE_PNG_COMPRESSION);
+      encode_params.push_back(quality_);
+      cv::imencode(".png", img, *output, encode_params);
+    }
+  }
+  return buffer;
+}
+
+const char *ImageEncoder::contentType() const
+{
+  return format_ == JPEG ? "image/jpeg" : "image/png";
+}
+
+bool ImageEncoder::encodeTurboJpeg(const cv::Mat &img, std::vector<uint8_t> &output)
+{
+#ifdef WEB_VIDEO_SERVER_TURBOJPEG
+  if (img.type() != CV_8UC3)
+    return false;
+  if (!turbojpeg_)
+  {
+    turbojpeg_ = tjInitCompress();
+    if (!turbojpeg_)
+      return false;
+  }
+  // Compress straight into the pooled vector, sized for the worst case so
+  // that TurboJPEG never has to reallocate it
+  output.resize(tjBufSize(img.cols, img.rows, TJSAMP_420));
+  unsigned char *data = output.data();
+  unsigned long size = output.size();
+  if (tjCompress2(turbojpeg_, img.data, img.cols, img.step, img.rows, TJPF_BGR, &data, &size, TJSAMP_420,
+                  quality_, TJFLAG_NOREALLOC | TJFLAG_FASTDCT) != 0)
+  {
+    output.clear();
+    return false;
+  }
+  output.resize(size);
+  return true;
+#else
+  (void)img;
+  (void)output;
+  return false;
+#endif
+}
+
+bool ImageEncoder::encodeSpng(const cv::Mat &img, std::vector<uint8_t> &output)
+{
+#ifdef WEB_VIDEO_SERVER_SPNG
+  if (img.type() != CV_8UC3)
+    return false;
+  cv::cvtColor(img, rgb_, cv::COLOR_BGR2RGB);
+
+  spng_ctx *ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+  if (!ctx)
+    return false;
+  spng_ihdr ihdr;
+  std::memset(&ihdr, 0, sizeof(ihdr));
+  ihdr.width = rgb_.cols;
+  ihdr.height = rgb_.rows;
+  ihdr.bit_depth = 8;
+  ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR;
+  int error = spng_set_png_stream(ctx, appendToBuffer, &output);
+  if (!error)
+    error = spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, std::min(std::max(quality_, 0), 9));
+  if (!error)
+    error = spng_set_ihdr(ctx, &ihdr);
+  if (!error)
+    error = spng_encode_image(ctx, rgb_.data, rgb_.total() * rgb_.elemSize(), SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
+  spng_ctx_free(ctx);
+  if (error)
+  {
+    output.clear();
+    return false;
+  }
+  return true;
+#else
+  (void)img;
+  (void)output;
+  return false;
+#endif
+}
+
+namespace
+{
+
+int configured_threads = 0;
+
+}
+
+void EncodeWorkers::configure(int threads)
+{
+  configured_threads = threads;
+}
+
+void EncodeWorkers::post(const std::function<void()> &job)
+{
+  EncodeWorkers &workers = instance();
+  {
+    boost::mutex::scoped_lock lock(workers.mutex_);
+    workers.jobs_.push_back(job);
+  }
+  workers.condition_.notify_one();
+}
+
+EncodeWorkers &EncodeWorkers::instance()
+{
+  static EncodeWorkers workers(configured_threads);
+  return workers;
+}
+
+EncodeWorkers::EncodeWorkers(int threads) :
+    stopping_(false)
+{
+  if (threads <= 0)
+    threads = std::max(1u, boost::thread::hardware_concurrency() / 2);
+  for (int i = 0; i < threads; ++i)
+    threads_.create_thread(std::bind(&EncodeWorkers::run, this));
+}
+
+EncodeWorkers::~EncodeWorkers()
+{
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  threads_.join_all();
+}
+
+void EncodeWorkers::run()
+{
+  while (true)
+  {
+    std::function<void()> job;
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      while (jobs_.empty() && !stopping_)
+        condition_.wait(lock);
+      if (stopping_)
+        return;
+      job = jobs_.front();
+      jobs_.pop_front();
+    }
+    job();
+  }
+}
+
+struct EncodeStage::State
+{
+  State(ImageEncoder::Format format, int quality, const Handler &handler) :
+      encoder(format, quality), handler(handler), running(false), stopped(false), has_pending(false)
+  {
+  }
+
+  ImageEncoder encoder;
+  Handler handler;
+
+  boost::mutex mutex;
+  boost::condition_variable idle;
+  bool running; // a worker is encoding for this stage
+  boost::thread::id runner;
+  bool stopped;
+
+  bool has_pending;
+  cv::Mat image;
+  cv_bridge::CvImageConstPtr source;
+  rclcpp::Time time;
+  StreamStats::Clock::time_point received;
+};
+
+EncodeStage::EncodeStage(ImageEncoder::Format format, int quality, const Handler &handler) :
+    state_(new State(format, quality, handler))
+{
+}
+
+EncodeStage::~EncodeStage()
+{
+  stop();
+}
+
+void EncodeStage::submit(const cv::Mat &img, const cv_bridge::CvImageConstPtr &source, const rclcpp::Time &time,
+                         StreamStats::Clock::time_point received)
+{
+  boost::mutex::scoped_lock lock(state_->mutex);
+  if (state_->stopped)
+    return;
+  state_->has_pending = true;
+  state_->image = img;
+  state_->source = source;
+  state_->time = time;
+  state_->received = received;
+  if (!state_->running)
+  {
+    state_->running = true;
+    EncodeWorkers::post(std::bind(&EncodeStage::run, state_));
+  }
+}
+
+void EncodeStage::stop()
+{
+  boost::mutex::scoped_lock lock(state_->mutex);
+  state_->stopped = true;
+  state_->has_pending = false;
+  state_->image = cv::Mat();
+  state_->source.reset();
+  // The last reference to a stream can be dropped by its own handler, when
+  // a client disconnects mid-frame; the worker sees stopped and leaves
+  if (state_->running && state_->runner == boost::this_thread::get_id())
+    return;
+  while (state_->running)
+    state_->idle.wait(lock);
+}
+
+const char *EncodeStage::contentType() const
+{
+  return state_->encoder.contentType();
+}
+
+void EncodeStage::run(std::shared_ptr<State> state)
+{
+  boost::mutex::scoped_lock lock(state->mutex);
+  state->runner = boost::this_thread::get_id();
+  // Keep going while images arrive faster than they are encoded, so that a
+  // stream holds on to its worker instead of queueing behind the others
+  while (state->has_pending && !state->stopped)
+  {
+    cv::Mat image = state->image;
+    cv_bridge::CvImageConstPtr source = state->source;
+    rclcpp::Time time = state->time;
+    StreamStats::Clock::time_point received = state->received;
+    state->has_pending = false;
+    state->image = cv::Mat();
+    state->source.reset();
+    lock.unlock();
+
+    EncodedFrame frame;
+    frame.time = time;
+    frame.keyframe = true;
+    try
+    {
+      frame.data = state->encoder.encode(image);
+    }
+    catch (cv::Exception &)
+    {
+      // An image the encoder can't take is skipped; the next one may do
+      frame.data.reset();
+    }
+    // The source goes before the handler, which may drop the stream
+    image = cv::Mat();
+    source.reset();
+
+    lock.lock();
+    if (frame.data && !state->stopped)
+    {
+      lock.unlock();
+      state->handler(frame, received);
+      lock.lock();
+    }
+  }
+  state->running = false;
+  state->runner = boost::thread::id();
+  state->idle.notify_all();
+}
+
+}
@@ -1,5 +1,8 @@
 #include "web_video_server/image_streamer.h"
+#include "web_video_server/mosaic.h"
+#include "nova_trace/Trace.hpp"
 #include <cv_bridge/cv_bridge.h>
+#include <cmath>
 #include <iostream>
 
 namespace web_video_server
@@ -18,12 +21,31 @@ ImageStreamer::~ImageStreamer()
 
 ImageTransportImageStreamer::ImageTransportImageStreamer(const async_web_server_cpp::HttpRequest &request,
                              async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh) :
-  ImageStreamer(request, connection, nh), it_(nh), initialized_(false)
+  ImageStreamer(request, connection, nh), encodes_in_background_(false), it_(nh), initialized_(false)
 {
   output_width_ = request.get_query_param_value_or_default<int>("width", -1);
   output_height_ = request.get_query_param_value_or_default<int>("height", -1);
   invert_ = request.has_query_param("invert");
   default_transport_ = request.get_query_param_value_or_default("default_transport", "raw");
+
+  // A list of topics makes this a mosaic of all of them instead
+  std::vector<std::string> topics = Mosaic::parseTopics(request.get_query_param_value_or_default("topics", ""));
+  if (!topics.empty())
+  {
+    int columns = request.get_query_param_value_or_default<int>("cols", 0);
+    if (columns <= 0)
+      columns = std::ceil(std::sqrt(static_cast<double>(topics.size())));
+    int rows = (topics.size() + columns - 1) / columns;
+    // Tiles are 320x240 unless the whole mosaic is given a size
+    if (output_width_ == -1)
+      output_width_ = columns * 320;
+    if (output_height_ == -1)
+      output_height_ = rows * 240;
+    double rate = request.get_query_param_value_or_default<double>("rate", 10.0);
+    topic_ = request.get_query_param_value_or_default("topics", "");
+    mosaic_.reset(new Mosaic(nh, topics, columns, output_width_, output_height_, rate, default_transport_,
+                             std::bind(&ImageTransportImageStreamer::mosaicCallback, this, std::placeholders::_1)));
+  }
 }
 
 ImageTransportImageStreamer::~ImageTransportImageStreamer()
@@ -32,6 +54,12 @@ ImageTransportImageStreamer::~ImageTransportImageStreamer()
 
 void ImageTransportImageStreamer::start()
 {
+  if (mosaic_)
+  {
+    mosaic_->start();
+    return;
+  }
+
   image_transport::TransportHints hints(nh_.get(), default_transport_);
   auto tnat = nh_->get_topic_names_and_types();
   inactive_ = true;
@@ -60,6 +88,7 @@ void ImageTransportImageStreamer::restreamFrame(double max_age)
   try {
     if ( last_frame + rclcpp::Duration::from_seconds(max_age) < nh_->now() ) {
       boost::mutex::scoped_lock lock(send_mutex_);
+      image_received_ = StreamStats::Clock::time_point();
       sendImage(output_size_image, nh_->now() ); // don't update last_frame, it may remain an old value.
     }
   }
@@ -88,10 +117,16 @@ void ImageTransportImageStreamer::restreamFrame(double max_age)
 
 void ImageTransportImageStreamer::imageCallback(const sensor_msgs::msg::Image::ConstSharedPtr &msg)
 {
+  StreamStats::Clock::time_point received = StreamStats::Clock::now();
   if (inactive_)
     return;
+  NOVA_TRACE_SPAN("web_video_server.image", navigator::trace::flow_id(msg->header.stamp));
+  stats_.recordInput();
+  if (skipFrame())
+    return;
 
   cv::Mat img;
+  cv_bridge::CvImageConstPtr shared_image;
   try
   {
     if (msg->encoding.find("F") != std::string::npos)
@@ -110,10 +145,47 @@ void ImageTransportImageStreamer::imageCallback(const sensor_msgs::msg::Image::C
     }
     else
     {
-      // Convert to OpenCV native BGR color
-      img = cv_bridge::toCvCopy(msg, "bgr8")->image;
+      // Convert to OpenCV native BGR color. A bgr8 message is used in place
+      // rather than copied, so img must not be written to
+      shared_image = cv_bridge::toCvShare(msg, "bgr8");
+      img = shared_image->image;
     }
+  }
+  catch (cv_bridge::Exception &e)
+  {
+    // TODO THROTTLE with 30
+    RCLCPP_ERROR(nh_->get_logger(), "cv_bridge exception: %s", e.what());
+    inactive_ = true;
+    return;
+  }
+  catch (cv::Exception &e)
+  {
+    // TODO THROTTLE with 30
+    RCLCPP_ERROR(nh_->get_logger(), "cv_bridge exception: %s", e.what());
+    inactive_ = true;
+    return;
+  }
+
+  processImage(img, shared_image, received);
+}
+
+void ImageTransportImageStreamer::mosaicCallback(const cv::Mat &img)
+{
+  StreamStats::Clock::time_point received = StreamStats::Clock::now();
+  if (inactive_)
+    return;
+  stats_.recordInput();
+  if (skipFrame())
+    return;
+  processImage(img, cv_bridge::CvImageConstPtr(), received);
+}
 
+void ImageTransportImageStreamer::processImage(cv::Mat img, const cv_bridge::CvImageConstPtr &source,
+                                               StreamStats::Clock::time_point received)
+{
+  NOVA_TRACE_SPAN("web_video_server.process_image");
+  try
+  {
     int input_width = img.cols;
     int input_height = img.rows;
 
@@ -124,9 +196,9 @@ void ImageTransportImageStreamer::imageCallback(const sensor_msgs::msg::Image::C
 
     if (invert_)
     {
-      // Rotate 180 degrees
-      cv::flip(img, img, false);
-      cv::flip(img, img, true);
+      cv::Mat img_rotated;
+      cv::rotate(img, img_rotated, cv::ROTATE_180);
+      img = img_rotated;
     }
 
     boost::mutex::scoped_lock lock(send_mutex_); // protects output_size_image
@@ -141,6 +213,7 @@ void ImageTransportImageStreamer::imageCallback(const sensor_msgs::msg::Image::C
     {
       output_size_image = img;
     }
+    output_image_source_ = source;
 
     if (!initialized_)
     {
@@ -149,16 +222,12 @@ void ImageTransportImageStreamer::imageCallback(const sensor_msgs::msg::Image::C
     }
 
     last_frame = nh_->now();
+    image_received_ = received;
     sendImage(output_size_image, last_frame );
+    if (!encodes_in_background_)
+      stats_.recordEncoded(received);
 
   }
-  catch (cv_bridge::Exception &e)
-  {
-    // TODO THROTTLE with 30
-    RCLCPP_ERROR(nh_->get_logger(), "cv_bridge exception: %s", e.what());
-    inactive_ = true;
-    return;
-  }
   catch (cv::Exception &e)
   {
     // TODO THROTTLE with 30
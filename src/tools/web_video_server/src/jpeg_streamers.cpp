@@ -4,88 +4,74 @@
 namespace web_video_server
 {
 
-MjpegStreamer::MjpegStreamer(const async_web_server_cpp::HttpRequest &request,
-                             async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh) :
-  ImageTransportImageStreamer(request, connection, nh), stream_(std::bind(&rclcpp::Node::now, nh), connection)
+MjpegStreamer::MjpegStreamer(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh) :
+  SharedEncoder(request, nh),
+  stage_(ImageEncoder::JPEG, request.get_query_param_value_or_default<int>("quality", 95),
+         std::bind(&MjpegStreamer::onEncoded, this, std::placeholders::_1, std::placeholders::_2))
 {
-  quality_ = request.get_query_param_value_or_default<int>("quality", 95);
-  stream_.sendInitialHeader();
+  encodes_in_background_ = true;
 }
 
 MjpegStreamer::~MjpegStreamer()
 {
+  stage_.stop();
   this->inactive_ = true;
   boost::mutex::scoped_lock lock(send_mutex_); // protects sendImage.
 }
 
 void MjpegStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
 {
-  std::vector<int> encode_params;
-  encode_params.push_back(cv::IMWRITE_JPEG_QUALITY);
-  encode_params.push_back(quality_);
-
-  std::vector<uchar> encoded_buffer;
-  cv::imencode(".jpeg", img, encoded_buffer, encode_params);
-
-  stream_.sendPartAndClear(time, "image/jpeg", encoded_buffer);
+  stage_.submit(img, output_image_source_, time, image_received_);
 }
 
-boost::shared_ptr<ImageStreamer> MjpegStreamerType::create_streamer(const async_web_server_cpp::HttpRequest &request,
-                                                                    async_web_server_cpp::HttpConnectionPtr connection,
-                                                                    rclcpp::Node::SharedPtr nh)
+void MjpegStreamer::onEncoded(const EncodedFrame &frame, StreamStats::Clock::time_point received)
 {
-  return boost::shared_ptr<ImageStreamer>(new MjpegStreamer(request, connection, nh));
+  if (received != StreamStats::Clock::time_point())
+    stats_.recordEncoded(received);
+  publishFrame(frame);
 }
 
-std::string MjpegStreamerType::create_viewer(const async_web_server_cpp::HttpRequest &request)
+MjpegClient::MjpegClient(const async_web_server_cpp::HttpRequest &request,
+                         async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh,
+                         boost::shared_ptr<SharedEncoder> encoder) :
+  SharedStreamClient(request, connection, nh, encoder, 1),
+  stream_(std::bind(&rclcpp::Node::now, nh), connection, "boundarydonotcross", 0)
 {
-  std::stringstream ss;
-  ss << "<img src=\"/stream?";
-  ss << request.query;
-  ss << "\"></img>";
-  return ss.str();
+  stream_.sendInitialHeader();
 }
 
-JpegSnapshotStreamer::JpegSnapshotStreamer(const async_web_server_cpp::HttpRequest &request,
-                                           async_web_server_cpp::HttpConnectionPtr connection,
-                                           rclcpp::Node::SharedPtr nh) :
-    ImageTransportImageStreamer(request, connection, nh)
+void MjpegClient::sendFrame(const EncodedFrame &frame)
 {
-  quality_ = request.get_query_param_value_or_default<int>("quality", 95);
+  // Each part is written straight from the shared buffer, unless this
+  // connection still has earlier parts queued
+  if (isBusy())
+  {
+    dropFrame();
+    return;
+  }
+  stream_.sendPart(frame.time, "image/jpeg", boost::asio::buffer(*frame.data), trackWrite(frame));
 }
 
-JpegSnapshotStreamer::~JpegSnapshotStreamer()
+boost::shared_ptr<SharedEncoder> MjpegStreamerType::create_encoder(const async_web_server_cpp::HttpRequest &request,
+                                                                   rclcpp::Node::SharedPtr nh)
 {
-  this->inactive_ = true;
-  boost::mutex::scoped_lock lock(send_mutex_); // protects sendImage.
+  return boost::shared_ptr<SharedEncoder>(new MjpegStreamer(request, nh));
 }
 
-void JpegSnapshotStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
+boost::shared_ptr<SharedStreamClient> MjpegStreamerType::create_client(
+    const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
+    rclcpp::Node::SharedPtr nh, boost::shared_ptr<SharedEncoder> encoder)
 {
-  std::vector<int> encode_params;
-  encode_params.push_back(cv::IMWRITE_JPEG_QUALITY);
-  encode_params.push_back(quality_);
-
-  std::vector<uchar> encoded_buffer;
-  cv::imencode(".jpeg", img, encoded_buffer, encode_params);
+  return boost::shared_ptr<SharedStreamClient>(new MjpegClient(request, connection, nh, encoder));
+}
 
-  char stamp[20];
-  sprintf(stamp, "%.06lf", time.seconds());
-  async_web_server_cpp::HttpReply::builder(async_web_server_cpp::HttpReply::ok)
-      .header("Connection", "close")
-      .header("Server", "web_video_server")
-      .header("Cache-Control",
-              "no-cache, no-store, must-revalidate, pre-check=0, post-check=0, "
-              "max-age=0")
-      .header("X-Timestamp", stamp)
-      .header("Pragma", "no-cache")
-      .header("Content-type", "image/jpeg")
-      .header("Access-Control-Allow-Origin", "*")
-      .header("Content-Length",
-              boost::lexical_cast<std::string>(encoded_buffer.size()))
-      .write(connection_);
-  connection_->write_and_clear(encoded_buffer);
-  inactive_ = true;
+std::string MjpegStreamerType::create_viewer(const async_web_server_cpp::HttpRequest &request)
+{
+  std::stringstream ss;
+  ss << "<img src=\"/stream?";
+  ss << request.query;
+  ss << "\"></img>";
+  return ss.str();
 }
 
 }
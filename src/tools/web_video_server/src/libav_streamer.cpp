@@ -1,5 +1,6 @@
 #include "web_video_server/libav_streamer.h"
 #include "async_web_server_cpp/http_reply.hpp"
+#include "nova_trace/Trace.hpp"
 
 /*https://stackoverflow.com/questions/46884682/error-in-building-opencv-with-ffmpeg*/
 #define AV_CODEC_FLAG_GLOBAL_HEADER (1 << 22)
@@ -48,13 +49,13 @@ static int ffmpeg_boost_mutex_lock_manager(void **mutex, enum AVLockOp op)
   return 0;
 }
 
-LibavStreamer::LibavStreamer(const async_web_server_cpp::HttpRequest &request,
-                             async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh,
+LibavStreamer::LibavStreamer(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh,
                              const std::string &format_name, const std::string &codec_name,
-                             const std::string &content_type) :
-    ImageTransportImageStreamer(request, connection, nh), output_format_(0), format_context_(0), codec_(0), codec_context_(0), video_stream_(
-        0), frame_(0), sws_context_(0), first_image_timestamp_(0), format_name_(
-        format_name), codec_name_(codec_name), content_type_(content_type), opt_(0), io_buffer_(0)
+                             const HardwareEncoderConfig &hardware) :
+    SharedEncoder(request, nh), output_format_(0), format_context_(0), codec_(0), codec_context_(0), video_stream_(
+        0), frame_(0), hw_frame_(0), hw_device_context_(0), hw_frames_context_(0), frame_format_(AV_PIX_FMT_YUV420P),
+        sws_context_(0), first_image_timestamp_(0), format_name_(format_name), codec_name_(codec_name),
+        hardware_(hardware), opt_(0), io_buffer_(0)
 {
 
   bitrate_ = request.get_query_param_value_or_default<int>("bitrate", 100000);
@@ -79,6 +80,11 @@ LibavStreamer::~LibavStreamer()
     av_frame_free(&frame_);
 #endif
   }
+#ifdef WEB_VIDEO_SERVER_HW_ENCODING
+  if (hw_frame_)
+    av_frame_free(&hw_frame_);
+  releaseHardware();
+#endif
   if (io_buffer_)
     delete io_buffer_;
   if (format_context_) {
@@ -90,14 +96,22 @@ LibavStreamer::~LibavStreamer()
     sws_freeContext(sws_context_);
 }
 
-// output callback for ffmpeg IO context
+// output callback for ffmpeg IO context; collects the muxer output until
+// it is published to the clients
 static int dispatch_output_packet(void* opaque, uint8_t* buffer, int buffer_size)
 {
-  async_web_server_cpp::HttpConnectionPtr connection = *((async_web_server_cpp::HttpConnectionPtr*) opaque);
-  std::vector<uint8_t> encoded_frame;
-  encoded_frame.assign(buffer, buffer + buffer_size);
-  connection->write_and_clear(encoded_frame);
-  return 0; // TODO: can this fail?
+  std::vector<uint8_t>* output = static_cast<std::vector<uint8_t>*>(opaque);
+  output->insert(output->end(), buffer, buffer + buffer_size);
+  return 0;
+}
+
+EncodedBuffer LibavStreamer::takeOutput()
+{
+  avio_flush(format_context_->pb);
+  std::shared_ptr<std::vector<uint8_t> > buffer(new std::vector<uint8_t>());
+  buffer->swap(output_);
+  output_.reserve(buffer->size());
+  return buffer;
 }
 
 void LibavStreamer::initialize(const cv::Mat &img)
@@ -106,17 +120,11 @@ void LibavStreamer::initialize(const cv::Mat &img)
   format_context_ = avformat_alloc_context();
   if (!format_context_)
   {
-    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::internal_server_error)(request_,
-                                                                                                         connection_,
-                                                                                                         NULL, NULL);
     throw std::runtime_error("Error allocating ffmpeg format context");
   }
   output_format_ = av_guess_format(format_name_.c_str(), NULL, NULL);
   if (!output_format_)
   {
-    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::internal_server_error)(request_,
-                                                                                                         connection_,
-                                                                                                         NULL, NULL);
     throw std::runtime_error("Error looking up output format");
   }
   format_context_->oformat = output_format_;
@@ -124,12 +132,9 @@ void LibavStreamer::initialize(const cv::Mat &img)
   // Set up custom IO callback.
   size_t io_buffer_size = 3 * 1024;    // 3M seen elsewhere and adjudged good
   io_buffer_ = new unsigned char[io_buffer_size];
-  AVIOContext* io_ctx = avio_alloc_context(io_buffer_, io_buffer_size, AVIO_FLAG_WRITE, &connection_, NULL, dispatch_output_packet, NULL);
+  AVIOContext* io_ctx = avio_alloc_context(io_buffer_, io_buffer_size, AVIO_FLAG_WRITE, &output_, NULL, dispatch_output_packet, NULL);
   if (!io_ctx)
   {
-    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::internal_server_error)(request_,
-                                                                                                         connection_,
-                                                                                                         NULL, NULL);
     throw std::runtime_error("Error setting up IO context");
   }
   io_ctx->seekable = 0;                       // no seeking, it's a stream
@@ -144,25 +149,87 @@ void LibavStreamer::initialize(const cv::Mat &img)
     codec_ = avcodec_find_encoder_by_name(codec_name_.c_str());
   if (!codec_)
   {
-    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::internal_server_error)(request_,
-                                                                                                         connection_,
-                                                                                                         NULL, NULL);
     throw std::runtime_error("Error looking up codec");
   }
   video_stream_ = avformat_new_stream(format_context_, codec_);
   if (!video_stream_)
   {
-    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::internal_server_error)(request_,
-                                                                                                         connection_,
-                                                                                                         NULL, NULL);
     throw std::runtime_error("Error creating video stream");
   }
   codec_context_ = video_stream_->codec;
 
+  // Try the hardware encoders for this codec before the software one
+  std::vector<std::pair<std::string, std::string> > encoders = hardwareEncoders();
+  bool opened = false;
+  for (size_t i = 0; i < encoders.size() && !opened; ++i)
+  {
+    AVCodec* hw_codec = avcodec_find_encoder_by_name(encoders[i].second.c_str());
+    if (!hw_codec)
+      continue;
+    opened = openCodec(hw_codec, encoders[i].first);
+    if (opened)
+      RCLCPP_INFO(nh_->get_logger(), "Encoding %s with %s", topic_.c_str(), hw_codec->name);
+    else
+      RCLCPP_WARN(nh_->get_logger(), "Could not open %s, trying the next encoder", hw_codec->name);
+  }
+  if (!opened && !openCodec(codec_, ""))
+  {
+    throw std::runtime_error("Could not open video codec");
+  }
+
+  // Allocate frame buffers
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(55,28,1)
+  frame_ = avcodec_alloc_frame();
+#else
+  frame_ = av_frame_alloc();
+#endif
+  av_image_alloc(frame_->data, frame_->linesize, output_width_, output_height_,
+          frame_format_, 1);
+
+  frame_->width = output_width_;
+  frame_->height = output_height_;
+  frame_->format = frame_format_;
+  output_format_->flags |= AVFMT_NOFILE;
+
+  // define meta data
+  av_dict_set(&format_context_->metadata, "author", "ROS web_video_server", 0);
+  av_dict_set(&format_context_->metadata, "title", topic_.c_str(), 0);
+
+  // Generate video stream header; every client gets a copy when it joins
+  if (avformat_write_header(format_context_, &opt_) < 0)
+  {
+    throw std::runtime_error("Error openning dynamic buffer");
+  }
+  publishHeader(takeOutput());
+}
+
+std::vector<std::pair<std::string, std::string> > LibavStreamer::hardwareEncoders()
+{
+  std::vector<std::string> accels;
+  if (hardware_.accel == "auto")
+  {
+    accels.push_back("nvenc");
+    accels.push_back("vaapi");
+    accels.push_back("v4l2m2m");
+  }
+  else if (!hardware_.accel.empty() && hardware_.accel != "none")
+  {
+    accels.push_back(hardware_.accel);
+  }
+
+  // Hardware encoders are named after the codec, e.g. h264_nvenc or vp8_vaapi
+  std::vector<std::pair<std::string, std::string> > encoders;
+  for (size_t i = 0; i < accels.size(); ++i)
+    encoders.push_back(std::make_pair(accels[i], std::string(avcodec_get_name(codec_->id)) + "_" + accels[i]));
+  return encoders;
+}
+
+bool LibavStreamer::openCodec(AVCodec* codec, const std::string &accel)
+{
   // Set options
-  avcodec_get_context_defaults3(codec_context_, codec_);
+  avcodec_get_context_defaults3(codec_context_, codec);
 
-  codec_context_->codec_id = codec_->id;
+  codec_context_->codec_id = codec->id;
   codec_context_->bit_rate = bitrate_;
 
   codec_context_->width = output_width_;
@@ -177,6 +244,31 @@ void LibavStreamer::initialize(const cv::Mat &img)
   codec_context_->gop_size = gop_;
   codec_context_->pix_fmt = AV_PIX_FMT_YUV420P;
   codec_context_->max_b_frames = 0;
+  frame_format_ = AV_PIX_FMT_YUV420P;
+  accel_ = accel;
+
+#ifdef WEB_VIDEO_SERVER_HW_ENCODING
+  if (accel == "nvenc")
+  {
+    // NVENC takes packed BGR and converts it to YUV on the GPU, so the CPU
+    // only has to pad each pixel to 32 bits
+    codec_context_->pix_fmt = AV_PIX_FMT_BGR0;
+    frame_format_ = AV_PIX_FMT_BGR0;
+  }
+  else if (accel == "vaapi")
+  {
+    // VAAPI encodes from surfaces on the GPU; frames are converted to NV12
+    // and uploaded
+    if (!initializeVaapi())
+    {
+      releaseHardware();
+      return false;
+    }
+    codec_context_->pix_fmt = AV_PIX_FMT_VAAPI;
+    codec_context_->hw_frames_ctx = av_buffer_ref(hw_frames_context_);
+    frame_format_ = AV_PIX_FMT_NV12;
+  }
+#endif
 
   // Quality settings
   codec_context_->qmin = qmin_;
@@ -189,52 +281,48 @@ void LibavStreamer::initialize(const cv::Mat &img)
     codec_context_->flags |= CODEC_FLAG_GLOBAL_HEADER;
 
   // Open Codec
-  if (avcodec_open2(codec_context_, codec_, NULL) < 0)
+  if (avcodec_open2(codec_context_, codec, NULL) < 0)
   {
-    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::internal_server_error)(request_,
-                                                                                                         connection_,
-                                                                                                         NULL, NULL);
-    throw std::runtime_error("Could not open video codec");
-  }
-
-  // Allocate frame buffers
-#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(55,28,1)
-  frame_ = avcodec_alloc_frame();
-#else
-  frame_ = av_frame_alloc();
+#ifdef WEB_VIDEO_SERVER_HW_ENCODING
+    releaseHardware();
 #endif
-  av_image_alloc(frame_->data, frame_->linesize, output_width_, output_height_,
-          codec_context_->pix_fmt, 1);
-
-  frame_->width = output_width_;
-  frame_->height = output_height_;
-  frame_->format = codec_context_->pix_fmt;
-  output_format_->flags |= AVFMT_NOFILE;
-
-  // Generate header
-  std::vector<uint8_t> header_buffer;
-  std::size_t header_size;
-  uint8_t *header_raw_buffer;
-  // define meta data
-  av_dict_set(&format_context_->metadata, "author", "ROS web_video_server", 0);
-  av_dict_set(&format_context_->metadata, "title", topic_.c_str(), 0);
+    return false;
+  }
+  codec_ = codec;
+  return true;
+}
 
-  // Send response headers
-  async_web_server_cpp::HttpReply::builder(async_web_server_cpp::HttpReply::ok).header("Connection", "close").header(
-      "Server", "web_video_server").header("Cache-Control",
-                                           "no-cache, no-store, must-revalidate, pre-check=0, post-check=0, max-age=0").header(
-      "Pragma", "no-cache").header("Expires", "0").header("Max-Age", "0").header("Trailer", "Expires").header(
-      "Content-type", content_type_).header("Access-Control-Allow-Origin", "*").write(connection_);
+#ifdef WEB_VIDEO_SERVER_HW_ENCODING
+bool LibavStreamer::initializeVaapi()
+{
+  const char* device = hardware_.device.empty() ? NULL : hardware_.device.c_str();
+  if (av_hwdevice_ctx_create(&hw_device_context_, AV_HWDEVICE_TYPE_VAAPI, device, NULL, 0) < 0)
+    return false;
+
+  hw_frames_context_ = av_hwframe_ctx_alloc(hw_device_context_);
+  if (!hw_frames_context_)
+    return false;
+  AVHWFramesContext* frames = (AVHWFramesContext*) hw_frames_context_->data;
+  frames->format = AV_PIX_FMT_VAAPI;
+  frames->sw_format = AV_PIX_FMT_NV12;
+  frames->width = output_width_;
+  frames->height = output_height_;
+  frames->initial_pool_size = 20;
+  if (av_hwframe_ctx_init(hw_frames_context_) < 0)
+    return false;
+
+  hw_frame_ = av_frame_alloc();
+  return hw_frame_ != NULL;
+}
 
-  // Send video stream header
-  if (avformat_write_header(format_context_, &opt_) < 0)
-  {
-    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::internal_server_error)(request_,
-                                                                                                         connection_,
-                                                                                                         NULL, NULL);
-    throw std::runtime_error("Error openning dynamic buffer");
-  }
+void LibavStreamer::releaseHardware()
+{
+  if (codec_context_)
+    av_buffer_unref(&codec_context_->hw_frames_ctx);
+  av_buffer_unref(&hw_frames_context_);
+  av_buffer_unref(&hw_device_context_);
 }
+#endif
 
 void LibavStreamer::initializeEncoder()
 {
@@ -242,12 +330,12 @@ void LibavStreamer::initializeEncoder()
 
 void LibavStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
 {
+  NOVA_TRACE_SPAN("web_video_server.libav_encode");
   boost::mutex::scoped_lock lock(encode_mutex_);
   if (0 == first_image_timestamp_.nanoseconds())
   {
     first_image_timestamp_ = time;
   }
-  std::vector<uint8_t> encoded_frame;
 #if (LIBAVUTIL_VERSION_MAJOR < 53)
   PixelFormat input_coding_format = PIX_FMT_BGR24;
 #else
@@ -262,6 +350,8 @@ void LibavStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
   av_image_fill_arrays(raw_frame->data, raw_frame->linesize,
                        img.data, input_coding_format, output_width_, output_height_, 1);
 #endif
+  // img may be the received message itself, whose rows can be padded
+  raw_frame->linesize[0] = img.step[0];
 
 
 
@@ -270,7 +360,7 @@ void LibavStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
   {
     static int sws_flags = SWS_BICUBIC;
     sws_context_ = sws_getContext(output_width_, output_height_, input_coding_format, output_width_, output_height_,
-                                  codec_context_->pix_fmt, sws_flags, NULL, NULL, NULL);
+                                  frame_format_, sws_flags, NULL, NULL, NULL);
     if (!sws_context_)
     {
       throw std::runtime_error("Could not initialize the conversion context");
@@ -288,6 +378,25 @@ void LibavStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
   av_frame_free(&raw_frame);
 #endif
 
+  // A client that has just joined or dropped frames needs a keyframe to
+  // start decoding from
+  frame_->pict_type = takeKeyframeRequest() ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+
+  AVFrame* encoder_frame = frame_;
+#ifdef WEB_VIDEO_SERVER_HW_ENCODING
+  if (hw_frames_context_)
+  {
+    // Upload to a GPU surface for VAAPI
+    if (av_hwframe_get_buffer(hw_frames_context_, hw_frame_, 0) < 0 ||
+        av_hwframe_transfer_data(hw_frame_, frame_, 0) < 0)
+    {
+      throw std::runtime_error("Error uploading frame to the GPU");
+    }
+    hw_frame_->pict_type = frame_->pict_type;
+    encoder_frame = hw_frame_;
+  }
+#endif
+
   // Encode the frame
   AVPacket pkt;
   int got_packet;
@@ -296,19 +405,24 @@ void LibavStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
 #if (LIBAVCODEC_VERSION_MAJOR < 54)
   int buf_size = 6 * output_width_ * output_height_;
   pkt.data = (uint8_t*)av_malloc(buf_size);
-  pkt.size = avcodec_encode_video(codec_context_, pkt.data, buf_size, frame_);
+  pkt.size = avcodec_encode_video(codec_context_, pkt.data, buf_size, encoder_frame);
   got_packet = pkt.size > 0;
 #elif (LIBAVCODEC_VERSION_MAJOR < 57)
   pkt.data = NULL; // packet data will be allocated by the encoder
   pkt.size = 0;
-  if (avcodec_encode_video2(codec_context_, &pkt, frame_, &got_packet) < 0)
+  if (avcodec_encode_video2(codec_context_, &pkt, encoder_frame, &got_packet) < 0)
   {
      throw std::runtime_error("Error encoding video frame");
   }
 #else
   pkt.data = NULL; // packet data will be allocated by the encoder
   pkt.size = 0;
-  if (avcodec_send_frame(codec_context_, frame_) < 0)
+  int sent = avcodec_send_frame(codec_context_, encoder_frame);
+#ifdef WEB_VIDEO_SERVER_HW_ENCODING
+  if (encoder_frame == hw_frame_)
+    av_frame_unref(hw_frame_);
+#endif
+  if (sent < 0)
   {
     throw std::runtime_error("Error encoding video frame");
   }
@@ -316,6 +430,7 @@ void LibavStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
   {
     throw std::runtime_error("Error retrieving encoded packet");
   }
+  got_packet = 1;
 #endif
 
   if (got_packet)
@@ -339,10 +454,19 @@ void LibavStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
     {
       throw std::runtime_error("Error when writing frame");
     }
-  }
-  else
-  {
-    encoded_frame.clear();
+
+    // The mp4 and webm muxers hold each fragment back until the next
+    // keyframe closes it, so what comes out while a keyframe is written
+    // begins with the fragment's own keyframe and a client can join there
+    EncodedBuffer output = takeOutput();
+    if (!output->empty())
+    {
+      EncodedFrame frame;
+      frame.time = time;
+      frame.data = output;
+      frame.keyframe = pkt.flags & AV_PKT_FLAG_KEY;
+      publishFrame(frame);
+    }
   }
 #if LIBAVCODEC_VERSION_INT < 54
   av_free(pkt.data);
@@ -353,22 +477,74 @@ void LibavStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
 #else
   av_packet_unref(&pkt);
 #endif
+}
 
-  connection_->write_and_clear(encoded_frame);
+LibavClient::LibavClient(const async_web_server_cpp::HttpRequest &request,
+                         async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh,
+                         boost::shared_ptr<SharedEncoder> encoder, const std::string &content_type) :
+    SharedStreamClient(request, connection, nh, encoder, 2), content_type_(content_type), header_sent_(false),
+    waiting_for_keyframe_(true)
+{
+}
+
+void LibavClient::sendHeader(const EncodedBuffer &header)
+{
+  // Send response headers
+  async_web_server_cpp::HttpReply::builder(async_web_server_cpp::HttpReply::ok).header("Connection", "close").header(
+      "Server", "web_video_server").header("Cache-Control",
+                                           "no-cache, no-store, must-revalidate, pre-check=0, post-check=0, max-age=0").header(
+      "Pragma", "no-cache").header("Expires", "0").header("Max-Age", "0").header("Trailer", "Expires").header(
+      "Content-type", content_type_).header("Access-Control-Allow-Origin", "*").write(connection_);
+
+  // Send video stream header
+  connection_->write(boost::asio::buffer(*header), header);
+  header_sent_ = true;
+}
+
+void LibavClient::sendFrame(const EncodedFrame &frame)
+{
+  if (!header_sent_)
+    return;
+
+  // A frame can't be decoded without the ones before it, so a client that
+  // falls behind skips ahead to the next keyframe
+  if (isBusy())
+  {
+    dropFrame();
+    if (!waiting_for_keyframe_)
+    {
+      waiting_for_keyframe_ = true;
+      encoder_->requestKeyframe();
+    }
+    return;
+  }
+  if (waiting_for_keyframe_)
+  {
+    if (!frame.keyframe)
+      return;
+    waiting_for_keyframe_ = false;
+  }
+
+  connection_->write(boost::asio::buffer(*frame.data), trackWrite(frame));
 }
 
 LibavStreamerType::LibavStreamerType(const std::string &format_name, const std::string &codec_name,
-                                     const std::string &content_type) :
-    format_name_(format_name), codec_name_(codec_name), content_type_(content_type)
+                                     const std::string &content_type, const HardwareEncoderConfig &hardware) :
+    hardware_(hardware), format_name_(format_name), codec_name_(codec_name), content_type_(content_type)
+{
+}
+
+boost::shared_ptr<SharedEncoder> LibavStreamerType::create_encoder(const async_web_server_cpp::HttpRequest &request,
+                                                                   rclcpp::Node::SharedPtr nh)
 {
+  return boost::shared_ptr<SharedEncoder>(new LibavStreamer(request, nh, format_name_, codec_name_, hardware_));
 }
 
-boost::shared_ptr<ImageStreamer> LibavStreamerType::create_streamer(const async_web_server_cpp::HttpRequest &request,
-                                                                    async_web_server_cpp::HttpConnectionPtr connection,
-                                                                    rclcpp::Node::SharedPtr nh)
+boost::shared_ptr<SharedStreamClient> LibavStreamerType::create_client(
+    const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
+    rclcpp::Node::SharedPtr nh, boost::shared_ptr<SharedEncoder> encoder)
 {
-  return boost::shared_ptr<ImageStreamer>(
-      new LibavStreamer(request, connection, nh, format_name_, codec_name_, content_type_));
+  return boost::shared_ptr<SharedStreamClient>(new LibavClient(request, connection, nh, encoder, content_type_));
 }
 
 std::string LibavStreamerType::create_viewer(const async_web_server_cpp::HttpRequest &request)
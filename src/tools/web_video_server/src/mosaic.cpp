@@ -0,0 +1,100 @@
+#include "web_video_server/mosaic.h"
+#include "nova_trace/Trace.hpp"
+#include <cv_bridge/cv_bridge.h>
+#include <boost/algorithm/string.hpp>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace web_video_server
+{
+
+Mosaic::Mosaic(rclcpp::Node::SharedPtr nh, const std::vector<std::string> &topics, int columns,
+               int width, int height, double rate, const std::string &default_transport, FrameCallback callback) :
+    nh_(nh), it_(nh), topics_(topics), rate_(rate), default_transport_(default_transport), callback_(callback),
+    updated_(false)
+{
+  if (topics_.empty())
+    throw std::invalid_argument("A mosaic needs at least one topic");
+  if (columns <= 0)
+    columns = std::ceil(std::sqrt(static_cast<double>(topics_.size())));
+  int rows = (topics_.size() + columns - 1) / columns;
+
+  int tile_width = width / columns;
+  int tile_height = height / rows;
+  if (tile_width <= 0 || tile_height <= 0)
+    throw std::invalid_argument("Mosaic is too small for its tiles");
+
+  canvas_ = cv::Mat::zeros(height, width, CV_8UC3);
+  for (size_t i = 0; i < topics_.size(); ++i)
+  {
+    int column = i % columns;
+    int row = i / columns;
+    tiles_.push_back(cv::Rect(column * tile_width, row * tile_height, tile_width, tile_height));
+  }
+}
+
+std::vector<std::string> Mosaic::parseTopics(const std::string &topics)
+{
+  std::vector<std::string> parts;
+  boost::split(parts, topics, boost::is_any_of(","));
+  std::vector<std::string> result;
+  for (size_t i = 0; i < parts.size(); ++i)
+  {
+    boost::trim(parts[i]);
+    if (!parts[i].empty())
+      result.push_back(parts[i]);
+  }
+  return result;
+}
+
+void Mosaic::start()
+{
+  image_transport::TransportHints hints(nh_.get(), default_transport_);
+  for (size_t i = 0; i < topics_.size(); ++i)
+  {
+    std::function<void(const sensor_msgs::msg::Image::ConstSharedPtr &)> callback =
+        std::bind(&Mosaic::imageCallback, this, i, std::placeholders::_1);
+    subscribers_.push_back(it_.subscribe(topics_[i], 1, callback, nullptr, &hints));
+  }
+  timer_ = nh_->create_wall_timer(std::chrono::duration<double>(1.0 / rate_), std::bind(&Mosaic::compose, this));
+}
+
+void Mosaic::imageCallback(size_t tile, const sensor_msgs::msg::Image::ConstSharedPtr &msg)
+{
+  NOVA_TRACE_SPAN("web_video_server.mosaic_tile", navigator::trace::flow_id(msg->header.stamp));
+  try
+  {
+    cv_bridge::CvImageConstPtr image = cv_bridge::toCvShare(msg, "bgr8");
+    boost::mutex::scoped_lock lock(canvas_mutex_);
+    cv::Mat target = canvas_(tiles_[tile]);
+    cv::resize(image->image, target, target.size());
+    updated_ = true;
+  }
+  catch (cv_bridge::Exception &e)
+  {
+    // TODO THROTTLE with 30
+    RCLCPP_ERROR(nh_->get_logger(), "cv_bridge exception on %s: %s", topics_[tile].c_str(), e.what());
+  }
+  catch (cv::Exception &e)
+  {
+    // TODO THROTTLE with 30
+    RCLCPP_ERROR(nh_->get_logger(), "cv exception on %s: %s", topics_[tile].c_str(), e.what());
+  }
+}
+
+void Mosaic::compose()
+{
+  cv::Mat frame;
+  {
+    boost::mutex::scoped_lock lock(canvas_mutex_);
+    if (!updated_)
+      return;
+    // Tiles keep being drawn into the canvas while the copy is encoded
+    frame = canvas_.clone();
+    updated_ = false;
+  }
+  callback_(frame);
+}
+
+}
@@ -42,17 +42,19 @@ void MultipartStream::sendPartFooter(const rclcpp::Time &time) {
   if (max_queue_size_ > 0) pending_footers_.push(pf);
 }
 
-void MultipartStream::sendPartAndClear(const rclcpp::Time &time, const std::string& type,
+bool MultipartStream::sendPartAndClear(const rclcpp::Time &time, const std::string& type,
 				       std::vector<unsigned char> &data) {
   if (!isBusy())
   {
     sendPartHeader(time, type, data.size());
     connection_->write_and_clear(data);
     sendPartFooter(time);
+    return true;
   }
+  return false;
 }
 
-void MultipartStream::sendPart(const rclcpp::Time &time, const std::string& type,
+bool MultipartStream::sendPart(const rclcpp::Time &time, const std::string& type,
 			       const boost::asio::const_buffer &buffer,
 			       async_web_server_cpp::HttpConnection::ResourcePtr resource) {
   if (!isBusy())
@@ -60,7 +62,9 @@ void MultipartStream::sendPart(const rclcpp::Time &time, const std::string& type
     sendPartHeader(time, type, boost::asio::buffer_size(buffer));
     connection_->write(buffer, resource);
     sendPartFooter(time);
+    return true;
   }
+  return false;
 }
 
 bool MultipartStream::isBusy() {
@@ -4,37 +4,63 @@
 namespace web_video_server
 {
 
-PngStreamer::PngStreamer(const async_web_server_cpp::HttpRequest &request,
-                         async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh) :
-  ImageTransportImageStreamer(request, connection, nh), stream_(std::bind(&rclcpp::Node::now, nh), connection)
+PngStreamer::PngStreamer(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh) :
+  SharedEncoder(request, nh),
+  stage_(ImageEncoder::PNG, request.get_query_param_value_or_default<int>("quality", 3),
+         std::bind(&PngStreamer::onEncoded, this, std::placeholders::_1, std::placeholders::_2))
 {
-  quality_ = request.get_query_param_value_or_default<int>("quality", 3);
-  stream_.sendInitialHeader();
+  encodes_in_background_ = true;
 }
 
 PngStreamer::~PngStreamer()
 {
+  stage_.stop();
   this->inactive_ = true;
   boost::mutex::scoped_lock lock(send_mutex_); // protects sendImage.
 }
 
 void PngStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
 {
-  std::vector<int> encode_params;
-  encode_params.push_back(cv::IMWRITE_PNG_COMPRESSION);
-  encode_params.push_back(quality_);
+  stage_.submit(img, output_image_source_, time, image_received_);
+}
 
-  std::vector<uchar> encoded_buffer;
-  cv::imencode(".png", img, encoded_buffer, encode_params);
+void PngStreamer::onEncoded(const EncodedFrame &frame, StreamStats::Clock::time_point received)
+{
+  if (received != StreamStats::Clock::time_point())
+    stats_.recordEncoded(received);
+  publishFrame(frame);
+}
 
-  stream_.sendPartAndClear(time, "image/png", encoded_buffer);
+PngClient::PngClient(const async_web_server_cpp::HttpRequest &request,
+                     async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh,
+                     boost::shared_ptr<SharedEncoder> encoder) :
+  SharedStreamClient(request, connection, nh, encoder, 1),
+  stream_(std::bind(&rclcpp::Node::now, nh), connection, "boundarydonotcross", 0)
+{
+  stream_.sendInitialHeader();
 }
 
-boost::shared_ptr<ImageStreamer> PngStreamerType::create_streamer(const async_web_server_cpp::HttpRequest &request,
-                                                                  async_web_server_cpp::HttpConnectionPtr connection,
-                                                                  rclcpp::Node::SharedPtr nh)
+void PngClient::sendFrame(const EncodedFrame &frame)
 {
-  return boost::shared_ptr<ImageStreamer>(new PngStreamer(request, connection, nh));
+  if (isBusy())
+  {
+    dropFrame();
+    return;
+  }
+  stream_.sendPart(frame.time, "image/png", boost::asio::buffer(*frame.data), trackWrite(frame));
+}
+
+boost::shared_ptr<SharedEncoder> PngStreamerType::create_encoder(const async_web_server_cpp::HttpRequest &request,
+                                                                 rclcpp::Node::SharedPtr nh)
+{
+  return boost::shared_ptr<SharedEncoder>(new PngStreamer(request, nh));
+}
+
+boost::shared_ptr<SharedStreamClient> PngStreamerType::create_client(
+    const async_web_server_cpp::HttpRequest &request, async_web_server_cpp::HttpConnectionPtr connection,
+    rclcpp::Node::SharedPtr nh, boost::shared_ptr<SharedEncoder> encoder)
+{
+  return boost::shared_ptr<SharedStreamClient>(new PngClient(request, connection, nh, encoder));
 }
 
 std::string PngStreamerType::create_viewer(const async_web_server_cpp::HttpRequest &request)
@@ -49,9 +75,9 @@ std::string PngStreamerType::create_viewer(const async_web_server_cpp::HttpReque
 PngSnapshotStreamer::PngSnapshotStreamer(const async_web_server_cpp::HttpRequest &request,
                                          async_web_server_cpp::HttpConnectionPtr connection,
                                          rclcpp::Node::SharedPtr nh) :
-    ImageTransportImageStreamer(request, connection, nh)
+    ImageTransportImageStreamer(request, connection, nh),
+    encoder_(ImageEncoder::PNG, request.get_query_param_value_or_default<int>("quality", 3))
 {
-  quality_ = request.get_query_param_value_or_default<int>("quality", 3);
 }
 
 PngSnapshotStreamer::~PngSnapshotStreamer()
@@ -62,12 +88,7 @@ PngSnapshotStreamer::~PngSnapshotStreamer()
 
 void PngSnapshotStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time)
 {
-  std::vector<int> encode_params;
-  encode_params.push_back(cv::IMWRITE_PNG_COMPRESSION);
-  encode_params.push_back(quality_);
-
-  std::vector<uchar> encoded_buffer;
-  cv::imencode(".png", img, encoded_buffer, encode_params);
+  EncodedBuffer encoded_buffer = encoder_.encode(img);
 
   char stamp[20];
   sprintf(stamp, "%.06lf", time.seconds());
@@ -82,9 +103,9 @@ void PngSnapshotStreamer::sendImage(const cv::Mat &img, const rclcpp::Time &time
       .header("Content-type", "image/png")
       .header("Access-Control-Allow-Origin", "*")
       .header("Content-Length",
-              boost::lexical_cast<std::string>(encoded_buffer.size()))
+              boost::lexical_cast<std::string>(encoded_buffer->size()))
       .write(connection_);
-  connection_->write_and_clear(encoded_buffer);
+  connection_->write(boost::asio::buffer(*encoded_buffer), encoded_buffer);
   inactive_ = true;
 }
 
@@ -1,4 +1,5 @@
 #include "web_video_server/ros_compressed_streamer.h"
+#include "nova_trace/Trace.hpp"
 
 namespace web_video_server
 {
@@ -48,7 +49,10 @@ void RosCompressedStreamer::sendImage(const sensor_msgs::msg::CompressedImage::C
       return;
     }
 
-    stream_.sendPart(time, content_type, boost::asio::buffer(msg->data), msg);
+    if (stream_.sendPart(time, content_type, boost::asio::buffer(msg->data), msg))
+      stats_.recordSent(msg->data.size());
+    else
+      stats_.recordDropped();
   }
   catch (boost::system::system_error &e)
   {
@@ -75,10 +79,14 @@ void RosCompressedStreamer::sendImage(const sensor_msgs::msg::CompressedImage::C
 
 
 void RosCompressedStreamer::imageCallback(const sensor_msgs::msg::CompressedImage::ConstSharedPtr msg) {
+  StreamStats::Clock::time_point received = StreamStats::Clock::now();
+  NOVA_TRACE_SPAN("web_video_server.compressed_image", navigator::trace::flow_id(msg->header.stamp));
+  stats_.recordInput();
   boost::mutex::scoped_lock lock(send_mutex_); // protects last_msg and last_frame
   last_msg = msg;
   last_frame = rclcpp::Time(msg->header.stamp);
   sendImage(last_msg, last_frame);
+  stats_.recordEncoded(received); // passed through as it is
 }
 
 
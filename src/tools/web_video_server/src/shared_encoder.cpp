@@ -0,0 +1,312 @@
+#include "web_video_server/shared_encoder.h"
+#include <algorithm>
+#include <sstream>
+
+namespace web_video_server
+{
+
+SharedStreamClient::SharedStreamClient(const async_web_server_cpp::HttpRequest &request,
+                                       async_web_server_cpp::HttpConnectionPtr connection,
+                                       rclcpp::Node::SharedPtr nh, boost::shared_ptr<SharedEncoder> encoder,
+                                       std::size_t default_max_queue_size) :
+    ImageStreamer(request, connection, nh), encoder_(encoder), completed_bytes_(0), fell_behind_(false)
+{
+  max_queue_size_ = request.get_query_param_value_or_default<int>("max_queue_size", default_max_queue_size);
+}
+
+SharedStreamClient::~SharedStreamClient()
+{
+}
+
+void SharedStreamClient::start()
+{
+}
+
+bool SharedStreamClient::isInactive()
+{
+  return inactive_ || encoder_->isInactive();
+}
+
+StreamStats &SharedStreamClient::encoderStats()
+{
+  return encoder_->encoderStats();
+}
+
+void SharedStreamClient::restreamFrame(double max_age)
+{
+  encoder_->restreamFrame(max_age);
+}
+
+void SharedStreamClient::sendHeader(const EncodedBuffer &)
+{
+}
+
+void SharedStreamClient::deliverHeader(const EncodedBuffer &header)
+{
+  if (inactive_)
+    return;
+  try
+  {
+    sendHeader(header);
+  }
+  catch (boost::system::system_error &e)
+  {
+    // happens when client disconnects
+    RCLCPP_DEBUG(nh_->get_logger(), "system_error exception: %s", e.what());
+    inactive_ = true;
+  }
+  catch (std::exception &e)
+  {
+    RCLCPP_ERROR(nh_->get_logger(), "exception: %s", e.what());
+    inactive_ = true;
+  }
+}
+
+void SharedStreamClient::deliverFrame(const EncodedFrame &frame)
+{
+  if (inactive_)
+    return;
+  try
+  {
+    sendFrame(frame);
+  }
+  catch (boost::system::system_error &e)
+  {
+    // happens when client disconnects
+    RCLCPP_DEBUG(nh_->get_logger(), "system_error exception: %s", e.what());
+    inactive_ = true;
+  }
+  catch (std::exception &e)
+  {
+    RCLCPP_ERROR(nh_->get_logger(), "exception: %s", e.what());
+    inactive_ = true;
+  }
+}
+
+bool SharedStreamClient::isBusy()
+{
+  rclcpp::Time currentTime = nh_->now();
+  while (!pending_writes_.empty())
+  {
+    if (pending_writes_.front().contents.expired()) {
+      completed_bytes_ += pending_writes_.front().size;
+      pending_writes_.pop();
+    } else {
+      rclcpp::Time writeTime = pending_writes_.front().timestamp;
+      if ((currentTime - writeTime).seconds() > 0.5) {
+        pending_writes_.pop();
+      } else {
+        break;
+      }
+    }
+  }
+  return !(max_queue_size_ == 0 || pending_writes_.size() < max_queue_size_);
+}
+
+async_web_server_cpp::HttpConnection::ResourcePtr SharedStreamClient::trackWrite(const EncodedFrame &frame)
+{
+  // Tracked separately from the shared buffer, which other clients may
+  // still hold once this connection is done with it
+  std::shared_ptr<EncodedBuffer> write(new EncodedBuffer(frame.data));
+
+  PendingWrite pending;
+  pending.timestamp = nh_->now();
+  pending.contents = write;
+  pending.size = frame.data->size();
+  pending_writes_.push(pending);
+  stats_.recordSent(pending.size);
+  return write;
+}
+
+void SharedStreamClient::dropFrame()
+{
+  fell_behind_ = true;
+  stats_.recordDropped();
+}
+
+SendReport SharedStreamClient::takeSendReport(double elapsed)
+{
+  isBusy(); // collect the writes that have completed since the last frame
+
+  SendReport report;
+  report.bytes_per_second = completed_bytes_ / elapsed;
+  report.fell_behind = fell_behind_;
+  completed_bytes_ = 0;
+  fell_behind_ = false;
+  return report;
+}
+
+SharedEncoder::SharedEncoder(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh) :
+    ImageTransportImageStreamer(request, async_web_server_cpp::HttpConnectionPtr(), nh),
+    frame_fraction_(1.0), frame_credit_(0.0), rate_window_start_(nh->now()), produced_bytes_(0),
+    last_restream_(nh->now()), keyframe_requested_(false)
+{
+}
+
+SharedEncoder::~SharedEncoder()
+{
+}
+
+void SharedEncoder::addClient(const boost::shared_ptr<SharedStreamClient> &client)
+{
+  boost::mutex::scoped_lock lock(clients_mutex_);
+  clients_.push_back(client);
+  if (header_)
+    client->deliverHeader(header_);
+  requestKeyframe();
+}
+
+bool SharedEncoder::hasClients()
+{
+  boost::mutex::scoped_lock lock(clients_mutex_);
+  for (size_t i = 0; i < clients_.size(); ++i)
+  {
+    if (!clients_[i].expired())
+      return true;
+  }
+  return false;
+}
+
+void SharedEncoder::restreamFrame(double max_age)
+{
+  {
+    boost::mutex::scoped_lock lock(restream_mutex_);
+    rclcpp::Time now = nh_->now();
+    if ((now - last_restream_).seconds() < max_age / 2)
+      return;
+    last_restream_ = now;
+  }
+  ImageTransportImageStreamer::restreamFrame(max_age);
+}
+
+bool SharedEncoder::skipFrame()
+{
+  boost::mutex::scoped_lock lock(clients_mutex_);
+  frame_credit_ += frame_fraction_;
+  if (frame_credit_ < 1.0)
+    return true;
+  frame_credit_ -= 1.0;
+  return false;
+}
+
+void SharedEncoder::adaptFrameRate(double elapsed)
+{
+  // Clients that fall behind already drop frames on their own, so there is
+  // only any point encoding less while all of them are. Then the fastest of
+  // them sets the rate; the others keep dropping as before.
+  bool keeping_up = false;
+  bool any_clients = false;
+  double best_rate = 0;
+  for (size_t i = 0; i < clients_.size(); ++i)
+  {
+    boost::shared_ptr<SharedStreamClient> client = clients_[i].lock();
+    if (!client)
+      continue;
+    any_clients = true;
+    SendReport report = client->takeSendReport(elapsed);
+    if (!report.fell_behind)
+      keeping_up = true;
+    else
+      best_rate = std::max(best_rate, report.bytes_per_second);
+  }
+
+  double produced_rate = produced_bytes_ / elapsed;
+  if (keeping_up || !any_clients)
+  {
+    frame_fraction_ = std::min(1.0, frame_fraction_ * 1.25);
+  }
+  else if (produced_rate > 0)
+  {
+    // Aim a little under what got through, to let the queues drain
+    frame_fraction_ = std::max(0.05, std::min(1.0, frame_fraction_ * 0.9 * best_rate / produced_rate));
+  }
+}
+
+void SharedEncoder::requestKeyframe()
+{
+  keyframe_requested_ = true;
+}
+
+bool SharedEncoder::takeKeyframeRequest()
+{
+  return keyframe_requested_.exchange(false);
+}
+
+void SharedEncoder::publishHeader(const EncodedBuffer &header)
+{
+  boost::mutex::scoped_lock lock(clients_mutex_);
+  header_ = header;
+  for (size_t i = 0; i < clients_.size(); ++i)
+  {
+    boost::shared_ptr<SharedStreamClient> client = clients_[i].lock();
+    if (client)
+      client->deliverHeader(header_);
+  }
+}
+
+void SharedEncoder::publishFrame(const EncodedFrame &frame)
+{
+  boost::mutex::scoped_lock lock(clients_mutex_);
+  produced_bytes_ += frame.data->size();
+  double elapsed = (frame.time - rate_window_start_).seconds();
+  if (elapsed >= 1.0)
+  {
+    adaptFrameRate(elapsed);
+    rate_window_start_ = frame.time;
+    produced_bytes_ = 0;
+  }
+
+  std::vector<boost::weak_ptr<SharedStreamClient> >::iterator itr = clients_.begin();
+  while (itr != clients_.end())
+  {
+    boost::shared_ptr<SharedStreamClient> client = itr->lock();
+    if (!client)
+    {
+      itr = clients_.erase(itr);
+      continue;
+    }
+    client->deliverFrame(frame);
+    ++itr;
+  }
+}
+
+boost::shared_ptr<ImageStreamer> SharedStreamerType::create_streamer(const async_web_server_cpp::HttpRequest &request,
+                                                                     async_web_server_cpp::HttpConnectionPtr connection,
+                                                                     rclcpp::Node::SharedPtr nh)
+{
+  // Every query parameter can change what is encoded, so requests share an
+  // encoder only when all of them match
+  std::stringstream key;
+  for (std::map<std::string, std::string>::const_iterator itr = request.query_params.begin();
+       itr != request.query_params.end(); ++itr)
+  {
+    key << itr->first << '=' << itr->second << '&';
+  }
+
+  boost::mutex::scoped_lock lock(encoders_mutex_);
+  boost::shared_ptr<SharedEncoder> &encoder = encoders_[key.str()];
+  if (!encoder || encoder->isInactive())
+  {
+    encoder = create_encoder(request, nh);
+    encoder->start();
+  }
+
+  boost::shared_ptr<SharedStreamClient> client = create_client(request, connection, nh, encoder);
+  encoder->addClient(client);
+  return client;
+}
+
+void SharedStreamerType::cleanup()
+{
+  boost::mutex::scoped_lock lock(encoders_mutex_);
+  std::map<std::string, boost::shared_ptr<SharedEncoder> >::iterator itr = encoders_.begin();
+  while (itr != encoders_.end())
+  {
+    if (!itr->second->hasClients())
+      encoders_.erase(itr++);
+    else
+      ++itr;
+  }
+}
+
+}
@@ -0,0 +1,183 @@
+#include "web_video_server/snapshot_cache.h"
+#include "async_web_server_cpp/http_reply.hpp"
+#include <sstream>
+
+namespace web_video_server
+{
+
+SnapshotEncoder::SnapshotEncoder(const async_web_server_cpp::HttpRequest &request, rclcpp::Node::SharedPtr nh) :
+    ImageTransportImageStreamer(request, async_web_server_cpp::HttpConnectionPtr(), nh),
+    encoder_(ImageEncoder::JPEG, request.get_query_param_value_or_default<int>("quality", 95)),
+    last_request_(nh->now())
+{
+}
+
+SnapshotEncoder::~SnapshotEncoder()
+{
+  this->inactive_ = true;
+  boost::mutex::scoped_lock lock(send_mutex_); // protects sendImage.
+}
+
+void SnapshotEncoder::serve(async_web_server_cpp::HttpConnectionPtr connection, double max_age)
+{
+  boost::mutex::scoped_lock lock(send_mutex_);
+  rclcpp::Time now = nh_->now();
+  last_request_ = now;
+  if (!output_size_image.empty() && (now - last_frame).seconds() <= max_age)
+  {
+    reply(connection, encodeLatest());
+    return;
+  }
+
+  PendingSnapshot pending;
+  pending.connection = connection;
+  pending.requested = now;
+  pending_.push_back(pending);
+}
+
+bool SnapshotEncoder::expire(double timeout)
+{
+  boost::mutex::scoped_lock lock(send_mutex_);
+  rclcpp::Time now = nh_->now();
+  std::vector<PendingSnapshot>::iterator itr = pending_.begin();
+  while (itr != pending_.end())
+  {
+    if ((now - itr->requested).seconds() <= timeout)
+    {
+      ++itr;
+      continue;
+    }
+    try
+    {
+      async_web_server_cpp::HttpReply::builder(async_web_server_cpp::HttpReply::service_unavailable)
+          .header("Connection", "close")
+          .header("Server", "web_video_server")
+          .header("Content-Length", "0")
+          .write(itr->connection);
+    }
+    catch (boost::system::system_error &e)
+    {
+      RCLCPP_DEBUG(nh_->get_logger(), "system_error exception: %s", e.what());
+    }
+    itr = pending_.erase(itr);
+  }
+  return pending_.empty() && (now - last_request_).seconds() > timeout;
+}
+
+void SnapshotEncoder::sendImage(const cv::Mat &, const rclcpp::Time &)
+{
+  // The image stays in output_size_image; it is only encoded once wanted
+  if (pending_.empty())
+    return;
+  const EncodedFrame &frame = encodeLatest();
+  for (size_t i = 0; i < pending_.size(); ++i)
+    reply(pending_[i].connection, frame);
+  pending_.clear();
+}
+
+const EncodedFrame &SnapshotEncoder::encodeLatest()
+{
+  if (!cached_.data || cached_.time != last_frame)
+  {
+    cached_.time = last_frame;
+    cached_.data = encoder_.encode(output_size_image);
+    cached_.keyframe = true;
+  }
+  return cached_;
+}
+
+void SnapshotEncoder::reply(async_web_server_cpp::HttpConnectionPtr connection, const EncodedFrame &frame)
+{
+  try
+  {
+    char stamp[20];
+    sprintf(stamp, "%.06lf", frame.time.seconds());
+    async_web_server_cpp::HttpReply::builder(async_web_server_cpp::HttpReply::ok)
+        .header("Connection", "close")
+        .header("Server", "web_video_server")
+        .header("Cache-Control",
+                "no-cache, no-store, must-revalidate, pre-check=0, post-check=0, "
+                "max-age=0")
+        .header("X-Timestamp", stamp)
+        .header("Pragma", "no-cache")
+        .header("Content-type", "image/jpeg")
+        .header("Access-Control-Allow-Origin", "*")
+        .header("Content-Length",
+                boost::lexical_cast<std::string>(frame.data->size()))
+        .write(connection);
+    // The connection keeps the cached buffer alive until it is written
+    connection->write(boost::asio::buffer(*frame.data), frame.data);
+    stats_.recordSent(frame.data->size());
+  }
+  catch (boost::system::system_error &e)
+  {
+    // happens when client disconnects; the other requests are still served
+    RCLCPP_DEBUG(nh_->get_logger(), "system_error exception: %s", e.what());
+  }
+}
+
+SnapshotCache::SnapshotCache(rclcpp::Node::SharedPtr nh, double max_age, double timeout) :
+    nh_(nh), max_age_(max_age), timeout_(timeout)
+{
+}
+
+void SnapshotCache::serve(const async_web_server_cpp::HttpRequest &request,
+                          async_web_server_cpp::HttpConnectionPtr connection, const char* begin, const char* end)
+{
+  // Requests differing only in how stale an image they accept share an entry
+  std::stringstream key;
+  for (std::map<std::string, std::string>::const_iterator itr = request.query_params.begin();
+       itr != request.query_params.end(); ++itr)
+  {
+    if (itr->first != "max_age")
+      key << itr->first << '=' << itr->second << '&';
+  }
+  double max_age = request.get_query_param_value_or_default<double>("max_age", max_age_);
+
+  boost::shared_ptr<SnapshotEncoder> encoder;
+  {
+    boost::mutex::scoped_lock lock(encoders_mutex_);
+    boost::shared_ptr<SnapshotEncoder> &entry = encoders_[key.str()];
+    if (!entry || entry->isInactive())
+    {
+      entry.reset(new SnapshotEncoder(request, nh_));
+      entry->start();
+    }
+    encoder = entry;
+    if (encoder->isInactive())
+      encoders_.erase(key.str());
+  }
+
+  if (encoder->isInactive())
+  {
+    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::not_found)(request, connection, begin,
+                                                                                             end);
+    return;
+  }
+  encoder->serve(connection, max_age);
+}
+
+void SnapshotCache::cleanup()
+{
+  boost::mutex::scoped_lock lock(encoders_mutex_);
+  std::map<std::string, boost::shared_ptr<SnapshotEncoder> >::iterator itr = encoders_.begin();
+  while (itr != encoders_.end())
+  {
+    if (itr->second->expire(timeout_))
+      encoders_.erase(itr++);
+    else
+      ++itr;
+  }
+}
+
+std::vector<boost::shared_ptr<ImageStreamer> > SnapshotCache::streamers()
+{
+  std::vector<boost::shared_ptr<ImageStreamer> > result;
+  boost::mutex::scoped_lock lock(encoders_mutex_);
+  std::map<std::string, boost::shared_ptr<SnapshotEncoder> >::iterator itr = encoders_.begin();
+  for (; itr != encoders_.end(); ++itr)
+    result.push_back(itr->second);
+  return result;
+}
+
+}
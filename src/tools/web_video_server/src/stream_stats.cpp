@@ -0,0 +1,88 @@
+#include "web_video_server/stream_stats.h"
+#include <algorithm>
+#include <vector>
+
+namespace web_video_server
+{
+
+static const std::chrono::seconds kStatsWindow(5);
+
+static double percentile(std::vector<double> &samples, double fraction)
+{
+  if (samples.empty())
+    return 0.0;
+  std::size_t index = std::min(samples.size() - 1, static_cast<std::size_t>(fraction * samples.size()));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+StreamStats::StreamStats() :
+    created_(Clock::now()), bytes_sent_(0), dropped_frames_(0)
+{
+}
+
+void StreamStats::recordInput()
+{
+  Clock::time_point now = Clock::now();
+  boost::mutex::scoped_lock lock(mutex_);
+  inputs_.push_back(now);
+  trim(now);
+}
+
+void StreamStats::recordEncoded(Clock::time_point received)
+{
+  Clock::time_point now = Clock::now();
+  boost::mutex::scoped_lock lock(mutex_);
+  encodes_.push_back(now);
+  latencies_.push_back(std::chrono::duration<double>(now - received).count());
+  trim(now);
+}
+
+void StreamStats::recordSent(std::size_t bytes)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  bytes_sent_ += bytes;
+}
+
+void StreamStats::recordDropped()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  ++dropped_frames_;
+}
+
+StreamStatsReport StreamStats::report()
+{
+  Clock::time_point now = Clock::now();
+  boost::mutex::scoped_lock lock(mutex_);
+  trim(now);
+
+  StreamStatsReport report;
+  double seconds = window(now);
+  report.input_fps = seconds > 0 ? inputs_.size() / seconds : 0.0;
+  report.encoded_fps = seconds > 0 ? encodes_.size() / seconds : 0.0;
+  std::vector<double> latencies(latencies_.begin(), latencies_.end());
+  report.latency_p50 = percentile(latencies, 0.5);
+  report.latency_p99 = percentile(latencies, 0.99);
+  report.bytes_sent = bytes_sent_;
+  report.dropped_frames = dropped_frames_;
+  return report;
+}
+
+void StreamStats::trim(Clock::time_point now)
+{
+  while (!inputs_.empty() && now - inputs_.front() > kStatsWindow)
+    inputs_.pop_front();
+  while (!encodes_.empty() && now - encodes_.front() > kStatsWindow)
+  {
+    encodes_.pop_front();
+    latencies_.pop_front();
+  }
+}
+
+double StreamStats::window(Clock::time_point now) const
+{
+  // A stream younger than the window is rated over its own age
+  return std::chrono::duration<double>(std::min<Clock::duration>(now - created_, kStatsWindow)).count();
+}
+
+}
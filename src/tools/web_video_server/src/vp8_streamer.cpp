@@ -39,9 +39,9 @@
 namespace web_video_server
 {
 
-Vp8Streamer::Vp8Streamer(const async_web_server_cpp::HttpRequest& request,
-                         async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh) :
-    LibavStreamer(request, connection, nh, "webm", "libvpx", "video/webm")
+Vp8Streamer::Vp8Streamer(const async_web_server_cpp::HttpRequest& request, rclcpp::Node::SharedPtr nh,
+                         const HardwareEncoderConfig &hardware) :
+    LibavStreamer(request, nh, "webm", "libvpx", hardware)
 {
   quality_ = request.get_query_param_value_or_default("quality", "realtime");
 }
@@ -51,6 +51,10 @@ Vp8Streamer::~Vp8Streamer()
 
 void Vp8Streamer::initializeEncoder()
 {
+  // These are libvpx options; hardware encoders keep their own defaults
+  if (!accel_.empty())
+    return;
+
   typedef std::map<std::string, std::string> AvOptMap;
   AvOptMap av_opt_map;
   av_opt_map["quality"] = quality_;
@@ -76,16 +80,15 @@ void Vp8Streamer::initializeEncoder()
   av_opt_set_int(codec_context_->priv_data, "skip_threshold", 10, 0);
 }
 
-Vp8StreamerType::Vp8StreamerType() :
-    LibavStreamerType("webm", "libvpx", "video/webm")
+Vp8StreamerType::Vp8StreamerType(const HardwareEncoderConfig &hardware) :
+    LibavStreamerType("webm", "libvpx", "video/webm", hardware)
 {
 }
 
-boost::shared_ptr<ImageStreamer> Vp8StreamerType::create_streamer(const async_web_server_cpp::HttpRequest& request,
-                                                                  async_web_server_cpp::HttpConnectionPtr connection,
-                                                                  rclcpp::Node::SharedPtr nh)
+boost::shared_ptr<SharedEncoder> Vp8StreamerType::create_encoder(const async_web_server_cpp::HttpRequest& request,
+                                                                 rclcpp::Node::SharedPtr nh)
 {
-  return boost::shared_ptr<ImageStreamer>(new Vp8Streamer(request, connection, nh));
+  return boost::shared_ptr<SharedEncoder>(new Vp8Streamer(request, nh, hardware_));
 }
 
 }
@@ -3,9 +3,9 @@
 namespace web_video_server
 {
 
-Vp9Streamer::Vp9Streamer(const async_web_server_cpp::HttpRequest& request,
-                         async_web_server_cpp::HttpConnectionPtr connection, rclcpp::Node::SharedPtr nh) :
-    LibavStreamer(request, connection, nh, "webm", "libvpx-vp9", "video/webm")
+Vp9Streamer::Vp9Streamer(const async_web_server_cpp::HttpRequest& request, rclcpp::Node::SharedPtr nh,
+                         const HardwareEncoderConfig &hardware) :
+    LibavStreamer(request, nh, "webm", "libvpx-vp9", hardware)
 {
 }
 Vp9Streamer::~Vp9Streamer()
@@ -14,6 +14,9 @@ Vp9Streamer::~Vp9Streamer()
 
 void Vp9Streamer::initializeEncoder()
 {
+  // These are libvpx options; hardware encoders keep their own defaults
+  if (!accel_.empty())
+    return;
 
   // codec options set up to provide somehow reasonable performance in cost of poor quality
   // should be updated as soon as VP9 encoding matures
@@ -23,16 +26,15 @@ void Vp9Streamer::initializeEncoder()
   av_opt_set_int(codec_context_->priv_data, "crf", 20, 0);      // 0..63 (higher is lower quality)
 }
 
-Vp9StreamerType::Vp9StreamerType() :
-    LibavStreamerType("webm", "libvpx-vp9", "video/webm")
+Vp9StreamerType::Vp9StreamerType(const HardwareEncoderConfig &hardware) :
+    LibavStreamerType("webm", "libvpx-vp9", "video/webm", hardware)
 {
 }
 
-boost::shared_ptr<ImageStreamer> Vp9StreamerType::create_streamer(const async_web_server_cpp::HttpRequest& request,
-                                                                  async_web_server_cpp::HttpConnectionPtr connection,
-                                                                  rclcpp::Node::SharedPtr nh)
+boost::shared_ptr<SharedEncoder> Vp9StreamerType::create_encoder(const async_web_server_cpp::HttpRequest& request,
+                                                                 rclcpp::Node::SharedPtr nh)
 {
-  return boost::shared_ptr<ImageStreamer>(new Vp9Streamer(request, connection, nh));
+  return boost::shared_ptr<SharedEncoder>(new Vp9Streamer(request, nh, hardware_));
 }
 
 }
@@ -2,6 +2,8 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <chrono>
+#include <iomanip>
+#include <stdexcept>
 #include <vector>
 #include <sensor_msgs/image_encodings.hpp>
 #include <opencv2/opencv.hpp>
@@ -10,9 +12,11 @@
 #include "web_video_server/ros_compressed_streamer.h"
 #include "web_video_server/jpeg_streamers.h"
 #include "web_video_server/png_streamers.h"
+#include "web_video_server/image_encoder.h"
 #include "web_video_server/vp8_streamer.h"
 #include "web_video_server/h264_streamer.h"
 #include "web_video_server/vp9_streamer.h"
+#include "web_video_server/mosaic.h"
 #include "async_web_server_cpp/http_reply.hpp"
 
 using namespace std::chrono_literals;
@@ -71,11 +75,10 @@ WebVideoServer::WebVideoServer(rclcpp::Node::SharedPtr &nh, rclcpp::Node::Shared
     address_ = "0.0.0.0";
   }
 
-  int server_threads;
   if (private_nh->get_parameter("server_threads", parameter)) {
-    server_threads = parameter.as_int();
+    server_threads_ = parameter.as_int();
   } else {
-    server_threads = 1;
+    server_threads_ = 1;
   }
 
   if (private_nh->get_parameter("ros_threads", parameter)) {
@@ -83,6 +86,12 @@ WebVideoServer::WebVideoServer(rclcpp::Node::SharedPtr &nh, rclcpp::Node::Shared
   } else {
     ros_threads_ = 2;
   }
+
+  // JPEG and PNG streams are encoded on their own threads, shared by every
+  // stream; 0 uses half the cores
+  if (private_nh->get_parameter("encoder_threads", parameter)) {
+    EncodeWorkers::configure(parameter.as_int());
+  }
   if (private_nh->get_parameter("publish_rate", parameter)) {
     publish_rate_ = parameter.as_double();
   } else {
@@ -95,25 +104,76 @@ WebVideoServer::WebVideoServer(rclcpp::Node::SharedPtr &nh, rclcpp::Node::Shared
     __default_stream_type = "mjpeg";
   }
 
+  // Snapshots are answered from the latest image while it is at most
+  // snapshot_max_age seconds old; topics nobody has asked for in
+  // snapshot_timeout seconds are unsubscribed
+  double snapshot_max_age, snapshot_timeout;
+  if (private_nh->get_parameter("snapshot_max_age", parameter)) {
+    snapshot_max_age = parameter.as_double();
+  } else {
+    snapshot_max_age = 1.0;
+  }
+  if (private_nh->get_parameter("snapshot_timeout", parameter)) {
+    snapshot_timeout = parameter.as_double();
+  } else {
+    snapshot_timeout = 10.0;
+  }
+  snapshot_cache_.reset(new SnapshotCache(nh_, snapshot_max_age, snapshot_timeout));
+
+  // Hardware encoders are tried first for each video stream type; "none"
+  // keeps it on the software codec
+  HardwareEncoderConfig h264_hardware, vp8_hardware, vp9_hardware;
+  std::string hw_device;
+  if (private_nh->get_parameter("hw_device", parameter)) {
+    hw_device = parameter.as_string();
+  }
+  h264_hardware.device = vp8_hardware.device = vp9_hardware.device = hw_device;
+  if (private_nh->get_parameter("h264_hw_accel", parameter)) {
+    h264_hardware.accel = parameter.as_string();
+  } else {
+    h264_hardware.accel = "auto";
+  }
+  if (private_nh->get_parameter("vp8_hw_accel", parameter)) {
+    vp8_hardware.accel = parameter.as_string();
+  } else {
+    vp8_hardware.accel = "auto";
+  }
+  if (private_nh->get_parameter("vp9_hw_accel", parameter)) {
+    vp9_hardware.accel = parameter.as_string();
+  } else {
+    vp9_hardware.accel = "auto";
+  }
+
   stream_types_["mjpeg"] = boost::shared_ptr<ImageStreamerType>(new MjpegStreamerType());
   stream_types_["png"] = boost::shared_ptr<ImageStreamerType>(new PngStreamerType());
   stream_types_["ros_compressed"] = boost::shared_ptr<ImageStreamerType>(new RosCompressedStreamerType());
-  stream_types_["vp8"] = boost::shared_ptr<ImageStreamerType>(new Vp8StreamerType());
-  stream_types_["h264"] = boost::shared_ptr<ImageStreamerType>(new H264StreamerType());
-  stream_types_["vp9"] = boost::shared_ptr<ImageStreamerType>(new Vp9StreamerType());
+  stream_types_["vp8"] = boost::shared_ptr<ImageStreamerType>(new Vp8StreamerType(vp8_hardware));
+  stream_types_["h264"] = boost::shared_ptr<ImageStreamerType>(new H264StreamerType(h264_hardware));
+  stream_types_["vp9"] = boost::shared_ptr<ImageStreamerType>(new Vp9StreamerType(vp9_hardware));
 
   handler_group_.addHandlerForPath("/", boost::bind(&WebVideoServer::handle_list_streams, this, _1, _2, _3, _4));
   handler_group_.addHandlerForPath("/stream", boost::bind(&WebVideoServer::handle_stream, this, _1, _2, _3, _4));
   handler_group_.addHandlerForPath("/stream_viewer",
                                    boost::bind(&WebVideoServer::handle_stream_viewer, this, _1, _2, _3, _4));
+  handler_group_.addHandlerForPath("/mosaic", boost::bind(&WebVideoServer::handle_mosaic, this, _1, _2, _3, _4));
   handler_group_.addHandlerForPath("/snapshot", boost::bind(&WebVideoServer::handle_snapshot, this, _1, _2, _3, _4));
+  handler_group_.addHandlerForPath("/stats", boost::bind(&WebVideoServer::handle_stats, this, _1, _2, _3, _4));
+
+  bool publish_diagnostics = false;
+  if (private_nh->get_parameter("publish_diagnostics", parameter)) {
+    publish_diagnostics = parameter.as_bool();
+  }
+  if (publish_diagnostics) {
+    diagnostics_pub_ = nh_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+    diagnostics_timer_ = nh_->create_wall_timer(1s, std::bind(&WebVideoServer::publish_diagnostics, this));
+  }
 
   try
   {
     server_.reset(
         new async_web_server_cpp::HttpServer(address_, boost::lexical_cast<std::string>(port_),
                                              boost::bind(ros_connection_logger, handler_group_, _1, _2, _3, _4),
-                                             server_threads));
+                                             server_threads_));
   }
   catch(boost::exception& e)
   {
@@ -173,7 +233,89 @@ void WebVideoServer::cleanup_inactive_streams()
       }
     }
     image_subscribers_.erase(new_end, image_subscribers_.end());
+
+    typedef std::map<std::string, boost::shared_ptr<ImageStreamerType> >::iterator type_itr_type;
+    for (type_itr_type itr = stream_types_.begin(); itr != stream_types_.end(); ++itr)
+    {
+      itr->second->cleanup();
+    }
+    snapshot_cache_->cleanup();
+  }
+}
+
+std::vector<StreamSummary> WebVideoServer::collect_stats()
+{
+  // Connections sharing an encoder are reported together under it
+  std::vector<StreamSummary> summaries;
+  std::map<StreamStats *, std::size_t> index;
+  std::vector<boost::shared_ptr<ImageStreamer> > streamers = snapshot_cache_->streamers();
+  {
+    boost::mutex::scoped_lock lock(subscriber_mutex_);
+    streamers.insert(streamers.end(), image_subscribers_.begin(), image_subscribers_.end());
+  }
+  for (std::size_t i = 0; i < streamers.size(); ++i)
+  {
+    boost::shared_ptr<ImageStreamer> &streamer = streamers[i];
+    StreamStats *encoder = &streamer->encoderStats();
+    std::map<StreamStats *, std::size_t>::iterator found = index.find(encoder);
+    if (found == index.end())
+    {
+      StreamSummary summary;
+      summary.topic = streamer->getTopic();
+      const async_web_server_cpp::HttpRequest &request = streamer->getRequest();
+      summary.type = request.path == "/snapshot" ? "snapshot"
+                                                 : request.get_query_param_value_or_default("type", __default_stream_type);
+      summary.clients = 0;
+      summary.stats = encoder->report();
+      summary.stats.bytes_sent = 0;
+      summary.stats.dropped_frames = 0;
+      found = index.insert(std::make_pair(encoder, summaries.size())).first;
+      summaries.push_back(summary);
+    }
+
+    StreamSummary &summary = summaries[found->second];
+    StreamStatsReport connection = streamer->connectionStats().report();
+    summary.clients += 1;
+    summary.stats.bytes_sent += connection.bytes_sent;
+    summary.stats.dropped_frames += connection.dropped_frames;
   }
+  return summaries;
+}
+
+void WebVideoServer::publish_diagnostics()
+{
+  std::vector<StreamSummary> summaries = collect_stats();
+  diagnostic_msgs::msg::DiagnosticArray array;
+  array.header.stamp = nh_->now();
+  for (std::size_t i = 0; i < summaries.size(); ++i)
+  {
+    const StreamSummary &summary = summaries[i];
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.name = "web_video_server: " + summary.topic + " (" + summary.type + ")";
+    status.hardware_id = summary.topic;
+    status.message = boost::lexical_cast<std::string>(summary.clients) + " clients";
+
+    const char *keys[] = {"input_fps", "encoded_fps", "encode_latency_p50_ms", "encode_latency_p99_ms",
+                          "bytes_sent", "dropped_frames", "clients"};
+    std::string values[] = {
+        boost::lexical_cast<std::string>(summary.stats.input_fps),
+        boost::lexical_cast<std::string>(summary.stats.encoded_fps),
+        boost::lexical_cast<std::string>(summary.stats.latency_p50 * 1000.0),
+        boost::lexical_cast<std::string>(summary.stats.latency_p99 * 1000.0),
+        boost::lexical_cast<std::string>(summary.stats.bytes_sent),
+        boost::lexical_cast<std::string>(summary.stats.dropped_frames),
+        boost::lexical_cast<std::string>(summary.clients)};
+    for (std::size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); ++k)
+    {
+      diagnostic_msgs::msg::KeyValue value;
+      value.key = keys[k];
+      value.value = values[k];
+      status.values.push_back(value);
+    }
+    array.status.push_back(status);
+  }
+  diagnostics_pub_->publish(array);
 }
 
 bool WebVideoServer::handle_stream(const async_web_server_cpp::HttpRequest &request,
@@ -220,18 +362,47 @@ bool WebVideoServer::handle_stream(const async_web_server_cpp::HttpRequest &requ
   return true;
 }
 
-bool WebVideoServer::handle_snapshot(const async_web_server_cpp::HttpRequest &request,
-                                     async_web_server_cpp::HttpConnectionPtr connection, const char* begin,
-                                     const char* end)
+bool WebVideoServer::handle_mosaic(const async_web_server_cpp::HttpRequest &request,
+                                   async_web_server_cpp::HttpConnectionPtr connection, const char* begin,
+                                   const char* end)
 {
-  boost::shared_ptr<ImageStreamer> streamer(new JpegSnapshotStreamer(request, connection, nh_));
-  streamer->start();
+  // Tiles every topic in the comma-separated "topics" list into one stream.
+  // ros_compressed passes the camera's own packets through, so it can't.
+  std::string type = request.get_query_param_value_or_default("type", __default_stream_type);
+  std::vector<std::string> topics = Mosaic::parseTopics(request.get_query_param_value_or_default("topics", ""));
+  if (stream_types_.find(type) == stream_types_.end() || type == "ros_compressed" || topics.empty())
+  {
+    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::bad_request)(request, connection,
+                                                                                               begin, end);
+    return true;
+  }
 
+  boost::shared_ptr<ImageStreamer> streamer;
+  try
+  {
+    streamer = stream_types_[type]->create_streamer(request, connection, nh_);
+  }
+  catch (std::invalid_argument &e)
+  {
+    RCLCPP_WARN(nh_->get_logger(), "Rejected mosaic request: %s", e.what());
+    async_web_server_cpp::HttpReply::stock_reply(async_web_server_cpp::HttpReply::bad_request)(request, connection,
+                                                                                               begin, end);
+    return true;
+  }
+  streamer->start();
   boost::mutex::scoped_lock lock(subscriber_mutex_);
   image_subscribers_.push_back(streamer);
   return true;
 }
 
+bool WebVideoServer::handle_snapshot(const async_web_server_cpp::HttpRequest &request,
+                                     async_web_server_cpp::HttpConnectionPtr connection, const char* begin,
+                                     const char* end)
+{
+  snapshot_cache_->serve(request, connection, begin, end);
+  return true;
+}
+
 bool WebVideoServer::handle_stream_viewer(const async_web_server_cpp::HttpRequest &request,
                                           async_web_server_cpp::HttpConnectionPtr connection, const char* begin,
                                           const char* end)
@@ -283,6 +454,39 @@ bool WebVideoServer::handle_stream_viewer(const async_web_server_cpp::HttpReques
   return true;
 }
 
+bool WebVideoServer::handle_stats(const async_web_server_cpp::HttpRequest &request,
+                                  async_web_server_cpp::HttpConnectionPtr connection, const char* begin,
+                                  const char* end)
+{
+  std::vector<StreamSummary> summaries = collect_stats();
+
+  // Topic names can't hold quotes or backslashes, so nothing needs escaping
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(2);
+  ss << "{\"server_threads\": " << server_threads_ << ", \"ros_threads\": " << ros_threads_ << ", \"streams\": [";
+  for (std::size_t i = 0; i < summaries.size(); ++i)
+  {
+    const StreamSummary &summary = summaries[i];
+    if (i > 0)
+      ss << ", ";
+    ss << "{\"topic\": \"" << summary.topic << "\", \"type\": \"" << summary.type << "\""
+       << ", \"clients\": " << summary.clients
+       << ", \"input_fps\": " << summary.stats.input_fps
+       << ", \"encoded_fps\": " << summary.stats.encoded_fps
+       << ", \"encode_latency_p50_ms\": " << summary.stats.latency_p50 * 1000.0
+       << ", \"encode_latency_p99_ms\": " << summary.stats.latency_p99 * 1000.0
+       << ", \"bytes_sent\": " << summary.stats.bytes_sent
+       << ", \"dropped_frames\": " << summary.stats.dropped_frames << "}";
+  }
+  ss << "]}\n";
+
+  async_web_server_cpp::HttpReply::builder(async_web_server_cpp::HttpReply::ok).header("Connection", "close").header(
+      "Server", "web_video_server").header("Cache-Control", "no-cache, no-store, must-revalidate, max-age=0").header(
+      "Content-type", "application/json").header("Access-Control-Allow-Origin", "*").write(connection);
+  connection->write(ss.str());
+  return true;
+}
+
 bool WebVideoServer::handle_list_streams(const async_web_server_cpp::HttpRequest &request,
                                          async_web_server_cpp::HttpConnectionPtr connection, const char* begin,
                                          const char* end)
@@ -0,0 +1,63 @@
+/*
+ * Package:   worker_pool
+ * Filename:  WorkerPool.hpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+// A small, persistent pool of threads for splitting one call's work
+// into independent tasks, such as the sectors of a ray cast or the row
+// tiles of a map grid. run() hands out task indices to the workers and
+// the calling thread alike, and returns once every task has finished.
+// Threads are created once, so there is no per-call start-up cost.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace navigator {
+namespace worker_pool {
+
+class WorkerPool {
+public:
+  // Total threads working on a run(), including the caller, so 1 runs
+  // everything inline
+  explicit WorkerPool(int threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool & operator=(const WorkerPool &) = delete;
+
+  int size() const { return int(this->workers.size()) + 1; }
+
+  // Calls task(i) for every i in [0, tasks) and waits for all of them.
+  // Which thread runs which task is unspecified. One run at a time.
+  void run(int tasks, const std::function<void(int)> & task);
+
+private:
+  void worker_loop();
+  void drain();
+
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  bool stopping = false;
+  unsigned long generation = 0;
+  int busy = 0;
+
+  const std::function<void(int)> * task = nullptr;
+  int task_count = 0;
+  std::atomic<int> next_task {0};
+};
+
+}
+}
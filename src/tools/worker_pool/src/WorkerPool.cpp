@@ -0,0 +1,86 @@
+/*
+ * Package:   worker_pool
+ * Filename:  WorkerPool.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include "worker_pool/WorkerPool.hpp"
+
+using navigator::worker_pool::WorkerPool;
+
+WorkerPool::WorkerPool(int threads) {
+  for(int i = 1; i < threads; i++) {
+    this->workers.emplace_back(&WorkerPool::worker_loop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = true;
+  }
+  this->wake.notify_all();
+
+  for(std::thread & worker : this->workers) {
+    worker.join();
+  }
+}
+
+void WorkerPool::run(int tasks, const std::function<void(int)> & task) {
+  if(this->workers.empty() || tasks <= 1) {
+    for(int i = 0; i < tasks; i++) {
+      task(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->task = &task;
+    this->task_count = tasks;
+    this->next_task.store(0, std::memory_order_relaxed);
+    this->busy = int(this->workers.size());
+    this->generation++;
+  }
+  this->wake.notify_all();
+
+  // The caller works too, then waits for the stragglers
+  this->drain();
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->done.wait(lock, [this]() { return this->busy == 0; });
+  this->task = nullptr;
+}
+
+void WorkerPool::worker_loop() {
+  unsigned long seen = 0;
+
+  while(true) {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->wake.wait(lock, [&]() { return this->stopping || this->generation != seen; });
+      if(this->stopping) {
+        return;
+      }
+      seen = this->generation;
+    }
+
+    this->drain();
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->busy--;
+    }
+    this->done.notify_one();
+  }
+}
+
+void WorkerPool::drain() {
+  for(int i = this->next_task.fetch_add(1, std::memory_order_relaxed); i < this->task_count;
+      i = this->next_task.fetch_add(1, std::memory_order_relaxed)) {
+    (*this->task)(i);
+  }
+}
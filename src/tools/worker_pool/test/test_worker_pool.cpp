@@ -0,0 +1,65 @@
+/*
+ * Package:   worker_pool
+ * Filename:  test_worker_pool.cpp
+ * Author:    Will Heitman
+ * Email:     project.nova@utdallas.edu
+ * Copyright: 2026, Nova UTD
+ * License:   MIT License
+ */
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "worker_pool/WorkerPool.hpp"
+
+using navigator::worker_pool::WorkerPool;
+
+TEST(TestWorkerPool, test_every_task_runs_once) {
+  WorkerPool pool(4);
+  ASSERT_EQ(pool.size(), 4);
+  std::vector<int> runs(1000, 0);
+  // Over and over, so each run starts while workers may still be
+  // going back to sleep from the last
+  for(int repeat = 0; repeat < 50; repeat++) {
+    pool.run(int(runs.size()), [&](int i) { runs[i]++; });
+  }
+  for(int count : runs) {
+    ASSERT_EQ(count, 50);
+  }
+}
+
+TEST(TestWorkerPool, test_one_thread_runs_inline) {
+  WorkerPool pool(1);
+  ASSERT_EQ(pool.size(), 1);
+  const std::thread::id caller = std::this_thread::get_id();
+  int count = 0;
+  pool.run(10, [&](int) {
+    ASSERT_EQ(std::this_thread::get_id(), caller);
+    count++;
+  });
+  ASSERT_EQ(count, 10);
+  pool.run(0, [&](int) { count++; });
+  ASSERT_EQ(count, 10);
+}
+
+TEST(TestWorkerPool, test_tasks_share_the_threads) {
+  WorkerPool pool(3);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::atomic<int> waiting {0};
+  // Each task holds its thread until all three are in, so they can't
+  // all be on the caller
+  pool.run(3, [&](int) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      threads.insert(std::this_thread::get_id());
+    }
+    waiting++;
+    while(waiting.load() < 3) std::this_thread::yield();
+  });
+  ASSERT_EQ(threads.size(), 3u);
+}